@@ -0,0 +1,33 @@
+#ifndef FILEVAULT_BENCHMARKS_BENCH_COMMON_HPP
+#define FILEVAULT_BENCHMARKS_BENCH_COMMON_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace filevault {
+namespace bench {
+
+/**
+ * @brief Deterministic, moderately compressible test data
+ */
+inline std::vector<uint8_t> patterned_data(size_t size) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<uint8_t>((i % 256) ^ ((i / 256) % 256));
+    }
+    return data;
+}
+
+/**
+ * @brief Register one benchmark per available cipher (bench_crypto.cpp)
+ *
+ * The algorithm list comes from the engine at run time, so these are
+ * registered from main() rather than with the BENCHMARK macro.
+ */
+void register_cipher_benchmarks();
+
+} // namespace bench
+} // namespace filevault
+
+#endif // FILEVAULT_BENCHMARKS_BENCH_COMMON_HPP
@@ -0,0 +1,72 @@
+/**
+ * @file bench_compression.cpp
+ * @brief One-shot compress/decompress for every ICompressor
+ */
+
+#include "bench_common.hpp"
+#include "filevault/compression/compressor.hpp"
+#include <benchmark/benchmark.h>
+
+using namespace filevault;
+using filevault::bench::patterned_data;
+
+namespace {
+
+// Args: {CompressionType, level, input bytes}
+void apply_compression_args(benchmark::internal::Benchmark* b) {
+    for (auto type : {core::CompressionType::ZLIB, core::CompressionType::BZIP2, core::CompressionType::LZMA,
+                      core::CompressionType::ZSTD, core::CompressionType::LZ4}) {
+        for (int level : {1, 6}) {
+            b->Args({static_cast<int64_t>(type), level, 1 << 20});
+        }
+    }
+    b->ArgNames({"type", "level", "bytes"});
+}
+
+void BM_Compress(benchmark::State& state) {
+    auto type = static_cast<core::CompressionType>(state.range(0));
+    auto compressor = compression::CompressionService::create(type);
+    if (!compressor) {
+        state.SkipWithError("compressor unavailable");
+        return;
+    }
+    int level = static_cast<int>(state.range(1));
+    auto input = patterned_data(static_cast<size_t>(state.range(2)));
+    state.SetLabel(compressor->name());
+    
+    size_t compressed_size = 0;
+    for (auto _ : state) {
+        auto result = compressor->compress(input, level);
+        compressed_size = result.data.size();
+        benchmark::DoNotOptimize(result.data.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+    state.counters["ratio"] = compressed_size ? static_cast<double>(input.size()) / compressed_size : 0.0;
+}
+
+void BM_Decompress(benchmark::State& state) {
+    auto type = static_cast<core::CompressionType>(state.range(0));
+    auto compressor = compression::CompressionService::create(type);
+    if (!compressor) {
+        state.SkipWithError("compressor unavailable");
+        return;
+    }
+    auto input = patterned_data(static_cast<size_t>(state.range(2)));
+    auto compressed = compressor->compress(input, static_cast<int>(state.range(1)));
+    if (!compressed.success) {
+        state.SkipWithError("compression failed");
+        return;
+    }
+    state.SetLabel(compressor->name());
+    
+    for (auto _ : state) {
+        auto result = compressor->decompress(compressed.data);
+        benchmark::DoNotOptimize(result.data.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+}
+
+} // anonymous namespace
+
+BENCHMARK(BM_Compress)->Apply(apply_compression_args);
+BENCHMARK(BM_Decompress)->Apply(apply_compression_args);
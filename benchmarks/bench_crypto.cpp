@@ -0,0 +1,162 @@
+/**
+ * @file bench_crypto.cpp
+ * @brief Session and one-shot calls for every symmetric and classical ICryptoAlgorithm
+ */
+
+#include "bench_common.hpp"
+#include "filevault/core/crypto_engine.hpp"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+
+using namespace filevault;
+using filevault::bench::patterned_data;
+
+namespace {
+
+// The engine owns the algorithms; it lives as long as the registered benchmarks
+core::CryptoEngine& engine() {
+    static auto instance = [] {
+        auto created = std::make_unique<core::CryptoEngine>();
+        created->initialize();
+        return created;
+    }();
+    return *instance;
+}
+
+/**
+ * @brief Key, session and a reference message for one algorithm and size
+ */
+struct CipherFixture {
+    core::ICryptoAlgorithm* algo = nullptr;
+    std::vector<uint8_t> key;
+    std::unique_ptr<core::ICipherSession> session;
+    std::vector<uint8_t> plaintext;
+    std::vector<uint8_t> ciphertext;
+    core::EncryptionConfig config;      // Nonce of the reference message
+    core::EncryptionConfig dec_config;  // Plus its tag
+    
+    bool setup(core::AlgorithmType type, size_t size) {
+        algo = engine().get_algorithm(type);
+        if (!algo) {
+            return false;
+        }
+        key.resize(algo->key_size());
+        for (size_t i = 0; i < key.size(); ++i) {
+            key[i] = static_cast<uint8_t>(i * 97 + 13);
+        }
+        session = algo->create_session(key);
+        if (!session) {
+            return false;
+        }
+        
+        plaintext = patterned_data(size);
+        ciphertext = plaintext;
+        ciphertext.reserve(size + 64);
+        auto sealed = session->encrypt_in_place(ciphertext, config);
+        if (!sealed.success) {
+            return false;
+        }
+        // A fixed nonce: only throughput is measured, nothing is kept
+        config.nonce = sealed.nonce;
+        dec_config = config;
+        dec_config.tag = sealed.tag;
+        return true;
+    }
+};
+
+// Re-encrypting the previous ciphertext costs the same; resize() drops any padding
+void BM_SessionEncrypt(benchmark::State& state, core::AlgorithmType type) {
+    CipherFixture fixture;
+    if (!fixture.setup(type, static_cast<size_t>(state.range(0)))) {
+        state.SkipWithError("algorithm unavailable");
+        return;
+    }
+    std::vector<uint8_t> buffer = fixture.plaintext;
+    buffer.reserve(buffer.size() + 64);
+    for (auto _ : state) {
+        buffer.resize(fixture.plaintext.size());
+        benchmark::DoNotOptimize(fixture.session->encrypt_in_place(buffer, fixture.config));
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * fixture.plaintext.size()));
+}
+
+// Includes copying the reference ciphertext into the buffer
+void BM_SessionDecrypt(benchmark::State& state, core::AlgorithmType type) {
+    CipherFixture fixture;
+    if (!fixture.setup(type, static_cast<size_t>(state.range(0)))) {
+        state.SkipWithError("algorithm unavailable");
+        return;
+    }
+    std::vector<uint8_t> buffer;
+    buffer.reserve(fixture.ciphertext.size() + 64);
+    for (auto _ : state) {
+        buffer.assign(fixture.ciphertext.begin(), fixture.ciphertext.end());
+        auto opened = fixture.session->decrypt_in_place(buffer, fixture.dec_config);
+        if (!opened.success) {
+            state.SkipWithError("decryption failed");
+            break;
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * fixture.plaintext.size()));
+}
+
+// Key schedule, result allocation and copies on every call
+void BM_OneShotEncrypt(benchmark::State& state, core::AlgorithmType type) {
+    CipherFixture fixture;
+    if (!fixture.setup(type, static_cast<size_t>(state.range(0)))) {
+        state.SkipWithError("algorithm unavailable");
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fixture.algo->encrypt(fixture.plaintext, fixture.key, fixture.config));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * fixture.plaintext.size()));
+}
+
+} // anonymous namespace
+
+namespace filevault {
+namespace bench {
+
+void register_cipher_benchmarks() {
+    auto first = static_cast<int>(core::AlgorithmType::AES_128_GCM);
+    auto last_symmetric = static_cast<int>(core::AlgorithmType::TRIPLE_DES_CBC);
+    auto first_classical = static_cast<int>(core::AlgorithmType::CAESAR);
+    auto last_classical = static_cast<int>(core::AlgorithmType::HILL);
+    // AEAD modes appended after the PQC entries
+    auto first_late_aead = static_cast<int>(core::AlgorithmType::AEGIS_256);
+    auto last_late_aead = static_cast<int>(core::AlgorithmType::AES_256_SIV);
+    
+    auto add = [](core::AlgorithmType type, bool classical) {
+        auto* algo = engine().get_algorithm(type);
+        if (!algo) {
+            return;
+        }
+        std::string name = algo->name();
+        for (auto* bench : {
+                 benchmark::RegisterBenchmark(("BM_SessionEncrypt/" + name).c_str(), BM_SessionEncrypt, type),
+                 benchmark::RegisterBenchmark(("BM_SessionDecrypt/" + name).c_str(), BM_SessionDecrypt, type),
+                 benchmark::RegisterBenchmark(("BM_OneShotEncrypt/" + name).c_str(), BM_OneShotEncrypt, type)}) {
+            bench->Arg(64)->Arg(4096);
+            if (!classical) {
+                bench->Arg(1 << 20);
+            }
+        }
+    };
+    
+    for (int t = first; t <= last_symmetric; ++t) {
+        add(static_cast<core::AlgorithmType>(t), false);
+    }
+    for (int t = first_late_aead; t <= last_late_aead; ++t) {
+        add(static_cast<core::AlgorithmType>(t), false);
+    }
+    for (int t = first_classical; t <= last_classical; ++t) {
+        add(static_cast<core::AlgorithmType>(t), true);
+    }
+}
+
+} // namespace bench
+} // namespace filevault
@@ -0,0 +1,113 @@
+/**
+ * @file bench_formats.cpp
+ * @brief FVAULT01 header and archive entry (de)serialization
+ */
+
+#include "bench_common.hpp"
+#include "filevault/archive/archive_format.hpp"
+#include "filevault/core/file_format.hpp"
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <sstream>
+
+using namespace filevault;
+
+namespace {
+
+core::FileHeader make_header() {
+    core::FileHeader header;
+    std::memcpy(header.magic, core::FILE_FORMAT_MAGIC, 8);
+    header.version_major = core::FILE_FORMAT_VERSION_MAJOR;
+    header.version_minor = core::FILE_FORMAT_VERSION_MINOR;
+    header.algorithm = core::AlgorithmID::AES_256_GCM;
+    header.kdf = core::KDFID::ARGON2ID;
+    header.compression = core::CompressionID::ZSTD;
+    std::memset(header.reserved, 0, 3);
+    header.salt.assign(32, 0x11);
+    header.kdf_params = core::Argon2Params{}.serialize();
+    header.nonce.assign(12, 0x22);
+    header.compressed = true;
+    return header;
+}
+
+archive::FileEntry make_entry(size_t index) {
+    archive::FileEntry entry;
+    entry.filename = "src/module_" + std::to_string(index) + "/source_file.cpp";
+    entry.file_size = 4096 + index;
+    entry.offset = index * 4096;
+    entry.modified_time = 1700000000 + index;
+    entry.permissions = 0644;
+    entry.content_hash.fill(static_cast<uint8_t>(index));
+    return entry;
+}
+
+void BM_HeaderSerialize(benchmark::State& state) {
+    auto header = make_header();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(header.serialize());
+    }
+}
+
+void BM_HeaderWriteTo(benchmark::State& state) {
+    auto header = make_header();
+    std::ostringstream out;
+    for (auto _ : state) {
+        out.seekp(0);
+        benchmark::DoNotOptimize(header.write_to(out));
+    }
+}
+
+void BM_HeaderDeserialize(benchmark::State& state) {
+    auto bytes = make_header().serialize();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(core::FileHeader::deserialize(bytes));
+    }
+}
+
+void BM_HeaderParseView(benchmark::State& state) {
+    auto bytes = make_header().serialize();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(core::FileHeaderView::parse(bytes));
+    }
+}
+
+// Arg: entries in the table
+void BM_EntryTableSerialize(benchmark::State& state) {
+    std::vector<archive::FileEntry> entries;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        entries.push_back(make_entry(static_cast<size_t>(i)));
+    }
+    for (auto _ : state) {
+        std::vector<uint8_t> table;
+        for (const auto& entry : entries) {
+            auto bytes = entry.serialize();
+            table.insert(table.end(), bytes.begin(), bytes.end());
+        }
+        benchmark::DoNotOptimize(table.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_EntryTableDeserialize(benchmark::State& state) {
+    std::vector<uint8_t> table;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        auto bytes = make_entry(static_cast<size_t>(i)).serialize();
+        table.insert(table.end(), bytes.begin(), bytes.end());
+    }
+    for (auto _ : state) {
+        size_t offset = 0;
+        for (int64_t i = 0; i < state.range(0); ++i) {
+            benchmark::DoNotOptimize(archive::FileEntry::deserialize(table, offset));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+} // anonymous namespace
+
+BENCHMARK(BM_HeaderSerialize);
+BENCHMARK(BM_HeaderWriteTo);
+BENCHMARK(BM_HeaderDeserialize);
+BENCHMARK(BM_HeaderParseView);
+BENCHMARK(BM_EntryTableSerialize)->Arg(1)->Arg(1000);
+BENCHMARK(BM_EntryTableDeserialize)->Arg(1)->Arg(1000);
@@ -0,0 +1,45 @@
+/**
+ * @file bench_kdf.cpp
+ * @brief CryptoEngine::derive_key for each KDF and security level
+ */
+
+#include "bench_common.hpp"
+#include "filevault/core/crypto_engine.hpp"
+#include "filevault/core/key_cache.hpp"
+#include <benchmark/benchmark.h>
+#include <chrono>
+
+using namespace filevault;
+
+namespace {
+
+// Args: {KDFType, SecurityLevel}
+void BM_DeriveKey(benchmark::State& state) {
+    // Cached keys would turn the timings into cache lookups
+    core::KeyCache::instance().configure(0, std::chrono::seconds(0));
+    
+    core::CryptoEngine engine;
+    engine.initialize();
+    core::EncryptionConfig config;
+    config.kdf = static_cast<core::KDFType>(state.range(0));
+    config.level = static_cast<core::SecurityLevel>(state.range(1));
+    config.apply_security_level();
+    state.SetLabel(core::CryptoEngine::kdf_name(config.kdf) + "/" +
+                   core::CryptoEngine::security_level_name(config.level));
+    
+    auto salt = core::CryptoEngine::generate_salt(32);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(engine.derive_key("benchmark password", salt, config));
+    }
+}
+
+} // anonymous namespace
+
+BENCHMARK(BM_DeriveKey)
+    ->ArgsProduct({{static_cast<int64_t>(core::KDFType::ARGON2ID),
+                    static_cast<int64_t>(core::KDFType::SCRYPT),
+                    static_cast<int64_t>(core::KDFType::PBKDF2_SHA256)},
+                   {static_cast<int64_t>(core::SecurityLevel::WEAK),
+                    static_cast<int64_t>(core::SecurityLevel::MEDIUM)}})
+    ->ArgNames({"kdf", "level"})
+    ->Unit(benchmark::kMillisecond);
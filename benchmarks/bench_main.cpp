@@ -0,0 +1,65 @@
+/**
+ * @file bench_main.cpp
+ * @brief Entry point of the filevault_bench micro-benchmarks
+ *
+ * Usage: filevault_bench [--benchmark_filter=regex] [--benchmark_format=json]
+ */
+
+#include "bench_common.hpp"
+#include "filevault/utils/alloc_stats.hpp"
+#include <benchmark/benchmark.h>
+#include <spdlog/spdlog.h>
+
+namespace {
+
+using filevault::utils::AllocCounters;
+using filevault::utils::AllocStats;
+
+/**
+ * @brief Heap use per benchmark from the counting allocator (ENABLE_ALLOC_STATS)
+ *
+ * Google Benchmark runs each benchmark once more between Start() and
+ * Stop() and reports the result as allocs_per_iter and max_bytes_used.
+ */
+class AllocMemoryManager : public benchmark::MemoryManager {
+public:
+    void Start() override {
+        AllocStats::reset_peak();
+        live_start_ = AllocStats::live_bytes();
+        start_ = AllocStats::totals();
+    }
+
+    void Stop(Result& result) override {
+        auto end = AllocStats::totals();
+        result.num_allocs = static_cast<int64_t>(end.allocations - start_.allocations);
+        result.total_allocated_bytes = static_cast<int64_t>(end.bytes - start_.bytes);
+        result.max_bytes_used = static_cast<int64_t>(AllocStats::peak_bytes() - live_start_);
+        result.net_heap_growth = static_cast<int64_t>(AllocStats::live_bytes()) -
+                                 static_cast<int64_t>(live_start_);
+    }
+
+private:
+    AllocCounters start_;
+    uint64_t live_start_ = 0;
+};
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    // Per-call debug logging inside the algorithms is not what is measured
+    spdlog::set_level(spdlog::level::warn);
+    
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    filevault::bench::register_cipher_benchmarks();
+    AllocMemoryManager memory_manager;
+    if (AllocStats::enabled()) {
+        benchmark::RegisterMemoryManager(&memory_manager);
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::RegisterMemoryManager(nullptr);
+    benchmark::Shutdown();
+    return 0;
+}
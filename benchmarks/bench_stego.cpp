@@ -0,0 +1,92 @@
+/**
+ * @file bench_stego.cpp
+ * @brief LSB embed/extract and RS steganalysis kernels for every instruction set the CPU has
+ */
+
+#include "bench_common.hpp"
+#include "filevault/steganography/lsb_kernels.hpp"
+#include <benchmark/benchmark.h>
+
+namespace kernels = filevault::steganography::kernels;
+using filevault::bench::patterned_data;
+
+namespace {
+
+constexpr kernels::Isa ALL_ISAS[] = {
+    kernels::Isa::Scalar, kernels::Isa::SSE2, kernels::Isa::SSSE3,
+    kernels::Isa::AVX2, kernels::Isa::NEON
+};
+
+// Args: {isa, bits per channel, payload bytes}; SSE2 handles 3 bits in the scalar loop
+void apply_kernel_args(benchmark::internal::Benchmark* b) {
+    for (auto isa : ALL_ISAS) {
+        if (!kernels::is_supported(isa)) {
+            continue;
+        }
+        for (int bits : {1, 2, 3, 4}) {
+            b->Args({static_cast<int64_t>(isa), bits, 64 * 1024});
+        }
+    }
+    b->ArgNames({"isa", "bits", "bytes"});
+}
+
+size_t channels_for(size_t bytes, int bits) {
+    return bytes * ((8 + bits - 1) / bits);
+}
+
+void BM_LsbEmbed(benchmark::State& state) {
+    auto isa = static_cast<kernels::Isa>(state.range(0));
+    int bits = static_cast<int>(state.range(1));
+    auto payload = patterned_data(static_cast<size_t>(state.range(2)));
+    auto channels = patterned_data(channels_for(payload.size(), bits));
+    state.SetLabel(kernels::isa_name(isa));
+    
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kernels::embed(channels, 0, payload, bits, isa));
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * payload.size()));
+}
+
+void BM_LsbExtract(benchmark::State& state) {
+    auto isa = static_cast<kernels::Isa>(state.range(0));
+    int bits = static_cast<int>(state.range(1));
+    std::vector<uint8_t> payload(static_cast<size_t>(state.range(2)));
+    auto channels = patterned_data(channels_for(payload.size(), bits));
+    state.SetLabel(kernels::isa_name(isa));
+    
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(kernels::extract(channels, 0, payload, bits, isa));
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * payload.size()));
+}
+
+// Args: {isa}; 1 MB of one channel plane
+void apply_rs_args(benchmark::internal::Benchmark* b) {
+    for (auto isa : ALL_ISAS) {
+        if (kernels::is_supported(isa)) {
+            b->Args({static_cast<int64_t>(isa)});
+        }
+    }
+    b->ArgNames({"isa"});
+}
+
+void BM_RsCount(benchmark::State& state) {
+    auto isa = static_cast<kernels::Isa>(state.range(0));
+    auto plane = patterned_data(1024 * 1024);
+    state.SetLabel(kernels::isa_name(isa));
+    
+    for (auto _ : state) {
+        kernels::RsCounts counts;
+        kernels::rs_count(plane, counts, isa);
+        benchmark::DoNotOptimize(counts);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * plane.size()));
+}
+
+} // anonymous namespace
+
+BENCHMARK(BM_LsbEmbed)->Apply(apply_kernel_args);
+BENCHMARK(BM_LsbExtract)->Apply(apply_kernel_args);
+BENCHMARK(BM_RsCount)->Apply(apply_rs_args);
@@ -0,0 +1,524 @@
+/**
+ * @file scale_main.cpp
+ * @brief filevault_scale: streaming, hash, archive and batch paths at scale
+ *
+ * The unit tests and filevault_bench use inputs of a few megabytes. This
+ * runs the same code paths on multi-GB inputs, more than 4 GB of
+ * streaming output, 100k archive members and a long batch on the worker
+ * pool, and writes throughput and peak RSS per scenario as JSON so
+ * scaling regressions show up in a diff of two runs.
+ *
+ * Usage: filevault_scale [--dir DIR] [--only NAME]... [--stream-gb N]
+ *                        [--members N] [--batch-files N] [--threads N]
+ *                        [--output FILE] [--keep]
+ *
+ * Inputs are synthesized under DIR (default: the temp directory): sparse
+ * files where the path handles holes, generated data where it does not.
+ * Scenarios that need more free space than DIR has are skipped.
+ */
+
+#include "bench_common.hpp"
+#include "filevault/archive/archive_format.hpp"
+#include "filevault/archive/directory_walker.hpp"
+#include "filevault/core/streaming.hpp"
+#include "filevault/core/tree_hash.hpp"
+#include "filevault/core/tree_runner.hpp"
+#include "filevault/utils/bench_stats.hpp"
+#include "filevault/utils/file_io.hpp"
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <fmt/format.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace filevault;
+
+namespace {
+
+constexpr uint64_t MiB = 1024 * 1024;
+constexpr uint64_t GiB = 1024 * MiB;
+constexpr char PASSWORD[] = "filevault-scale";
+
+struct Options {
+    fs::path dir = fs::temp_directory_path() / "filevault_scale";
+    std::vector<std::string> only;
+    uint64_t stream_bytes = 6 * GiB;        // Past 4 GB, where 32-bit sizes and offsets wrap
+    size_t members = 100000;
+    size_t batch_files = 20000;
+    uint64_t batch_file_bytes = 256 * 1024;
+    size_t threads = 0;
+    std::string output;
+    bool keep = false;
+};
+
+/**
+ * @brief One scenario's measurements
+ */
+struct Scenario {
+    std::string name;
+    bool ok = true;
+    bool skipped = false;
+    std::string error;
+    uint64_t bytes = 0;         // Input bytes processed
+    uint64_t bytes_out = 0;     // Bytes written, where the scenario writes
+    uint64_t items = 0;         // Files, members or chunks, as named by the scenario
+    double seconds = 0;
+    size_t peak_rss = 0;
+
+    nlohmann::json to_json() const {
+        nlohmann::json json = {
+            {"name", name},
+            {"ok", ok},
+            {"bytes", bytes},
+            {"bytes_out", bytes_out},
+            {"items", items},
+            {"seconds", seconds},
+            {"throughput_mbps", seconds > 0 ? static_cast<double>(bytes) / MiB / seconds : 0.0},
+            {"items_per_second", seconds > 0 ? static_cast<double>(items) / seconds : 0.0},
+            {"peak_rss", peak_rss}
+        };
+        if (skipped) {
+            json["skipped"] = true;
+        }
+        if (!error.empty()) {
+            json["error"] = error;
+        }
+        return json;
+    }
+};
+
+/**
+ * @brief Endless patterned bytes up to a size, without holding them
+ */
+class PatternSource : public std::streambuf {
+public:
+    explicit PatternSource(uint64_t size)
+        : remaining_(size), block_(bench::patterned_data(MiB)) {}
+
+protected:
+    int_type underflow() override {
+        if (remaining_ == 0) {
+            return traits_type::eof();
+        }
+        size_t count = static_cast<size_t>(std::min<uint64_t>(block_.size(), remaining_));
+        remaining_ -= count;
+        char* base = reinterpret_cast<char*>(block_.data());
+        setg(base, base, base + count);
+        return traits_type::to_int_type(*gptr());
+    }
+
+private:
+    uint64_t remaining_;
+    std::vector<uint8_t> block_;
+};
+
+core::StreamingConfig stream_config(const Options& options) {
+    core::StreamingConfig config;
+    config.kdf = core::KDFType::PBKDF2_SHA256;    // Measure the data path, not the KDF
+    config.level = core::SecurityLevel::WEAK;
+    config.chunk_size = 4 * MiB;
+    config.worker_threads = options.threads;
+    return config;
+}
+
+/**
+ * @brief Sparse file of size bytes with 1 MiB of data at every GiB
+ */
+bool make_sparse(const fs::path& path, uint64_t size) {
+    {
+        std::ofstream create(path, std::ios::binary | std::ios::trunc);
+        if (!create) {
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::resize_file(path, size, ec);
+    if (ec) {
+        return false;
+    }
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    auto block = bench::patterned_data(MiB);
+    for (uint64_t offset = 0; offset + block.size() <= size; offset += GiB) {
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.write(reinterpret_cast<const char*>(block.data()), static_cast<std::streamsize>(block.size()));
+    }
+    return static_cast<bool>(file);
+}
+
+bool make_files(const fs::path& dir, size_t count, uint64_t size) {
+    std::vector<uint8_t> data = bench::patterned_data(size + 256);
+    for (size_t i = 0; i < count; ++i) {
+        // 1000 files per directory, as a real tree would spread them
+        fs::path path = dir / fmt::format("d{:04}", i / 1000) / fmt::format("f{:06}.bin", i);
+        if (i % 1000 == 0) {
+            fs::create_directories(path.parent_path());
+        }
+        std::ofstream file(path, std::ios::binary);
+        // Offset by the index so members differ and are not deduplicated
+        file.write(reinterpret_cast<const char*>(data.data() + i % 256), static_cast<std::streamsize>(size));
+        if (!file) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t free_space(const fs::path& dir) {
+    std::error_code ec;
+    auto space = fs::space(dir, ec);
+    return ec ? 0 : space.available;
+}
+
+bool selected(const Options& options, const std::string& name) {
+    return options.only.empty() ||
+           std::find(options.only.begin(), options.only.end(), name) != options.only.end();
+}
+
+/**
+ * @brief Run one scenario with a fresh peak RSS and time it
+ */
+Scenario measure(const std::string& name, const std::function<void(Scenario&)>& body) {
+    Scenario scenario;
+    scenario.name = name;
+    fmt::print(stderr, "[scale] {}...\n", name);
+    utils::reset_peak_rss();
+    auto start = std::chrono::steady_clock::now();
+    try {
+        body(scenario);
+    } catch (const std::exception& e) {
+        scenario.ok = false;
+        scenario.error = e.what();
+    }
+    scenario.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    scenario.peak_rss = utils::peak_rss_bytes();
+    fmt::print(stderr, "[scale] {}: {} in {:.1f} s, peak RSS {} MiB\n", name,
+               scenario.skipped ? "skipped" : scenario.ok ? "ok" : scenario.error,
+               scenario.seconds, scenario.peak_rss / MiB);
+    return scenario;
+}
+
+void skip(Scenario& scenario, std::string reason) {
+    scenario.skipped = true;
+    scenario.error = std::move(reason);
+}
+
+void fail(Scenario& scenario, std::string error) {
+    scenario.ok = false;
+    scenario.error = std::move(error);
+}
+
+/**
+ * @brief encrypt_file() and decrypt_file() of a sparse multi-GB file
+ *
+ * Holes become zero extents, so this covers 64-bit sizes, offsets and
+ * chunk counts without writing gigabytes.
+ */
+std::vector<Scenario> run_stream_sparse(const Options& options) {
+    fs::path input = options.dir / "sparse.bin";
+    fs::path encrypted = options.dir / "sparse.bin.fvlt";
+    fs::path decrypted = options.dir / "sparse.out";
+    std::vector<Scenario> results;
+
+    results.push_back(measure("stream_sparse_encrypt", [&](Scenario& s) {
+        if (!make_sparse(input, options.stream_bytes)) {
+            return fail(s, "Cannot create sparse input " + input.string());
+        }
+        auto result = core::StreamingCrypto::encrypt_file(input.string(), encrypted.string(), PASSWORD,
+                                                          stream_config(options));
+        if (!result.success) {
+            return fail(s, result.error_message);
+        }
+        s.bytes = result.bytes_processed;
+        s.bytes_out = result.bytes_written;
+        s.items = result.chunks_processed;
+    }));
+    if (!results.back().ok) {
+        return results;
+    }
+
+    results.push_back(measure("stream_sparse_decrypt", [&](Scenario& s) {
+        auto result = core::StreamingCrypto::decrypt_file(encrypted.string(), decrypted.string(), PASSWORD,
+                                                          nullptr, options.threads);
+        if (!result.success) {
+            return fail(s, result.error_message);
+        }
+        if (fs::file_size(decrypted) != options.stream_bytes) {
+            return fail(s, "Decrypted size differs from the input");
+        }
+        s.bytes = result.bytes_processed;
+        s.bytes_out = result.bytes_written;
+        s.items = result.chunks_processed;
+    }));
+
+    std::error_code ec;
+    fs::remove(decrypted, ec);
+    fs::remove(encrypted, ec);
+    return results;
+}
+
+/**
+ * @brief encrypt_stream() of generated data into a file larger than 4 GB
+ */
+Scenario run_stream_dense(const Options& options) {
+    return measure("stream_dense", [&](Scenario& s) {
+        if (free_space(options.dir) < options.stream_bytes + GiB) {
+            return skip(s, fmt::format("Needs {} GiB free in {}", options.stream_bytes / GiB + 1,
+                                       options.dir.string()));
+        }
+        fs::path output_path = options.dir / "dense.fvlt";
+        PatternSource source(options.stream_bytes);
+        std::istream input(&source);
+        std::ofstream output(output_path, std::ios::binary);
+        auto result = core::StreamingCrypto::encrypt_stream(input, output, PASSWORD, stream_config(options));
+        output.close();
+        if (!result.success) {
+            return fail(s, result.error_message);
+        }
+        s.bytes = result.bytes_processed;
+        s.bytes_out = fs::file_size(output_path);
+        s.items = result.chunks_processed;
+        std::error_code ec;
+        fs::remove(output_path, ec);
+    });
+}
+
+/**
+ * @brief TreeHash of a mapped multi-GB file on every core
+ */
+Scenario run_hash(const Options& options) {
+    return measure("tree_hash", [&](Scenario& s) {
+        fs::path input = options.dir / "sparse.bin";
+        if (!fs::exists(input) && !make_sparse(input, options.stream_bytes)) {
+            return fail(s, "Cannot create sparse input " + input.string());
+        }
+        auto mapped = utils::FileIO::map_file(input.string());
+        if (!mapped) {
+            return fail(s, mapped.error_message);
+        }
+        core::TreeHash tree("BLAKE2b(256)");
+        auto digest = tree.hash(mapped.value.span(), options.threads);
+        if (digest.empty()) {
+            return fail(s, "Empty digest");
+        }
+        s.bytes = mapped.value.size();
+        s.items = (s.bytes + tree.leaf_size() - 1) / tree.leaf_size();
+    });
+}
+
+/**
+ * @brief Encrypted archive of many small members, then its index read back
+ */
+std::vector<Scenario> run_archive(const Options& options) {
+    fs::path tree = options.dir / "members";
+    fs::path archive_path = options.dir / "members.fvar";
+    std::vector<Scenario> results;
+
+    results.push_back(measure("archive_create", [&](Scenario& s) {
+        if (!make_files(tree, options.members, 1024)) {
+            return fail(s, "Cannot create members under " + tree.string());
+        }
+        archive::WalkOptions walk_options;
+        walk_options.threads = options.threads;
+        auto walk = archive::DirectoryWalker::walk({tree}, walk_options);
+        if (walk.members.size() != options.members) {
+            return fail(s, fmt::format("Walk found {} of {} members", walk.members.size(), options.members));
+        }
+        archive::ArchiveSource source(std::move(walk.members));
+        std::istream archive_stream(&source);
+        std::ofstream output(archive_path, std::ios::binary);
+        auto result = core::StreamingCrypto::encrypt_stream(archive_stream, output, PASSWORD, source.size(),
+                                                            stream_config(options));
+        output.close();
+        if (!result.success) {
+            return fail(s, source.error().empty() ? result.error_message : source.error());
+        }
+        s.bytes = source.size();
+        s.bytes_out = fs::file_size(archive_path);
+        s.items = source.entries().size();
+    }));
+
+    if (results.back().ok) {
+        results.push_back(measure("archive_index", [&](Scenario& s) {
+            archive::ArchiveReader reader;
+            auto result = reader.open(archive_path.string(), PASSWORD);
+            if (!result.success) {
+                return fail(s, result.error_message);
+            }
+            if (reader.entries().size() != options.members) {
+                return fail(s, fmt::format("Index lists {} of {} members", reader.entries().size(),
+                                           options.members));
+            }
+            s.bytes = fs::file_size(archive_path);
+            s.items = reader.entries().size();
+        }));
+    }
+
+    std::error_code ec;
+    fs::remove(archive_path, ec);
+    if (!options.keep) {
+        fs::remove_all(tree, ec);
+    }
+    return results;
+}
+
+/**
+ * @brief One encrypt_file() per file of a tree on the TreeRunner pool
+ */
+Scenario run_batch(const Options& options) {
+    return measure("batch_encrypt", [&](Scenario& s) {
+        fs::path tree = options.dir / "batch";
+        if (!make_files(tree, options.batch_files, options.batch_file_bytes)) {
+            return fail(s, "Cannot create files under " + tree.string());
+        }
+
+        std::vector<core::TreeFile> files;
+        files.reserve(options.batch_files);
+        for (const auto& entry : fs::recursive_directory_iterator(tree)) {
+            if (entry.is_regular_file()) {
+                core::TreeFile file;
+                file.source = entry.path();
+                file.target = options.dir / "batch_out" / fs::relative(entry.path(), tree);
+                file.target += ".fvlt";
+                file.size = entry.file_size();
+                files.push_back(std::move(file));
+            }
+        }
+
+        // One salt for the whole batch, so KeyCache derives the key once
+        core::StreamingConfig config = stream_config(options);
+        config.salt.assign(16, 0x5A);
+        core::TreeRunOptions run_options;
+        run_options.workers = options.threads;
+        auto run = core::TreeRunner::run(files, [&](const core::TreeFile& file, size_t threads,
+                                                    const core::TreeRunner::Advance&) {
+            core::StreamingConfig file_config = config;
+            file_config.worker_threads = threads;
+            auto result = core::StreamingCrypto::encrypt_file(file.source.string(), file.target.string(),
+                                                              PASSWORD, file_config);
+            return result.success ? std::string() : result.error_message;
+        }, run_options);
+
+        if (!run.errors.empty()) {
+            return fail(s, fmt::format("{} file(s) failed, first: {}", run.errors.size(), run.errors.front()));
+        }
+        s.bytes = run.bytes;
+        s.items = run.succeeded;
+        std::error_code ec;
+        fs::remove_all(options.dir / "batch_out", ec);
+        if (!options.keep) {
+            fs::remove_all(tree, ec);
+        }
+    });
+}
+
+bool parse_args(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument(arg + " needs a value");
+            }
+            return argv[++i];
+        };
+        if (arg == "--dir") {
+            options.dir = value();
+        } else if (arg == "--only") {
+            options.only.push_back(value());
+        } else if (arg == "--stream-gb") {
+            options.stream_bytes = std::stoull(value()) * GiB;
+        } else if (arg == "--members") {
+            options.members = std::stoull(value());
+        } else if (arg == "--batch-files") {
+            options.batch_files = std::stoull(value());
+        } else if (arg == "--threads") {
+            options.threads = std::stoull(value());
+        } else if (arg == "--output") {
+            options.output = value();
+        } else if (arg == "--keep") {
+            options.keep = true;
+        } else {
+            std::cerr << "Unknown option " << arg << "\n"
+                      << "Usage: filevault_scale [--dir DIR] [--only stream|hash|archive|batch]... "
+                         "[--stream-gb N] [--members N] [--batch-files N] [--threads N] "
+                         "[--output FILE] [--keep]\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    spdlog::set_level(spdlog::level::warn);
+
+    Options options;
+    try {
+        if (!parse_args(argc, argv, options)) {
+            return 2;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 2;
+    }
+    fs::create_directories(options.dir);
+
+    bool rss_resettable = utils::reset_peak_rss();
+    std::vector<Scenario> scenarios;
+    auto add = [&](std::vector<Scenario> results) {
+        scenarios.insert(scenarios.end(), results.begin(), results.end());
+    };
+    if (selected(options, "stream")) {
+        add(run_stream_sparse(options));
+        scenarios.push_back(run_stream_dense(options));
+    }
+    if (selected(options, "hash")) {
+        scenarios.push_back(run_hash(options));
+    }
+    if (selected(options, "archive")) {
+        add(run_archive(options));
+    }
+    if (selected(options, "batch")) {
+        scenarios.push_back(run_batch(options));
+    }
+    if (!options.keep) {
+        std::error_code ec;
+        fs::remove(options.dir / "sparse.bin", ec);
+    }
+
+    nlohmann::json report = {
+        {"threads", options.threads == 0 ? std::thread::hardware_concurrency() : options.threads},
+        {"stream_bytes", options.stream_bytes},
+        {"members", options.members},
+        {"batch_files", options.batch_files},
+        {"peak_rss_resettable", rss_resettable},
+        {"scenarios", nlohmann::json::array()}
+    };
+    bool ok = true;
+    for (const auto& scenario : scenarios) {
+        report["scenarios"].push_back(scenario.to_json());
+        ok = ok && scenario.ok;
+    }
+
+    if (options.output.empty()) {
+        std::cout << report.dump(2) << "\n";
+    } else {
+        std::ofstream out(options.output);
+        out << report.dump(2) << "\n";
+        if (!out) {
+            std::cerr << "Cannot write " << options.output << "\n";
+            return 1;
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -1,7 +1,10 @@
-use std::process::{Command, Stdio};
+use std::io::{BufRead, BufReader, Write};
+use std::process::{Child, ChildStdin, ChildStdout, Command, Stdio};
 use std::path::PathBuf;
+use std::sync::Mutex;
 use serde::{Deserialize, Serialize};
-use tauri::Manager;
+use serde_json::{json, Value};
+use tauri::{Emitter, Manager};
 use regex::Regex;
 
 #[derive(Debug, Serialize, Deserialize)]
@@ -56,10 +59,112 @@ fn get_filevault_exe_path(app_handle: &tauri::AppHandle) -> Result<PathBuf, Stri
     }
 }
 
+/// `filevault serve --stdio` child kept alive across commands, so each
+/// action skips process start and engine setup
+struct Daemon {
+    child: Child,
+    stdin: ChildStdin,
+    stdout: BufReader<ChildStdout>,
+    next_id: u64,
+}
+
+#[derive(Default)]
+struct DaemonState(Mutex<Option<Daemon>>);
+
+impl Drop for Daemon {
+    fn drop(&mut self) {
+        let _ = writeln!(self.stdin, r#"{{"jsonrpc":"2.0","id":0,"method":"shutdown"}}"#);
+        let _ = self.child.wait();
+    }
+}
+
+fn hidden_command(exe_path: &PathBuf) -> Command {
+    #[allow(unused_mut)]
+    let mut command = Command::new(exe_path);
+    #[cfg(windows)]
+    {
+        use std::os::windows::process::CommandExt;
+        const CREATE_NO_WINDOW: u32 = 0x08000000;
+        command.creation_flags(CREATE_NO_WINDOW);  // Hide console window
+    }
+    command
+}
+
+fn start_daemon(exe_path: &PathBuf) -> Result<Daemon, String> {
+    let mut child = hidden_command(exe_path)
+        .args(["serve", "--stdio"])
+        .stdin(Stdio::piped())
+        .stdout(Stdio::piped())
+        .stderr(Stdio::null())
+        .spawn()
+        .map_err(|e| format!("Failed to start daemon: {}", e))?;
+    let stdin = child.stdin.take().ok_or("Daemon stdin unavailable")?;
+    let stdout = BufReader::new(child.stdout.take().ok_or("Daemon stdout unavailable")?);
+    Ok(Daemon { child, stdin, stdout, next_id: 1 })
+}
+
+/// Run one command line through the daemon; progress notifications are
+/// forwarded to the frontend as "filevault-progress" events
+fn run_in_daemon(
+    daemon: &mut Daemon,
+    app_handle: &tauri::AppHandle,
+    args: &[String],
+) -> Result<(String, String, i32), String> {
+    let id = daemon.next_id;
+    daemon.next_id += 1;
+
+    let request = json!({"jsonrpc": "2.0", "id": id, "method": "run", "params": {"args": args}});
+    writeln!(daemon.stdin, "{}", request).map_err(|e| format!("Daemon write failed: {}", e))?;
+    daemon.stdin.flush().map_err(|e| format!("Daemon write failed: {}", e))?;
+
+    let mut line = String::new();
+    loop {
+        line.clear();
+        let n = daemon.stdout.read_line(&mut line).map_err(|e| format!("Daemon read failed: {}", e))?;
+        if n == 0 {
+            return Err("Daemon exited".to_string());
+        }
+        let message: Value = serde_json::from_str(&line).map_err(|e| format!("Bad daemon reply: {}", e))?;
+
+        if message["method"] == "progress" {
+            let _ = app_handle.emit("filevault-progress", message["params"].clone());
+            continue;
+        }
+        if message["id"] != id {
+            continue;
+        }
+        if let Some(error) = message.get("error") {
+            return Err(error["message"].as_str().unwrap_or("Daemon error").to_string());
+        }
+        let result = &message["result"];
+        return Ok((
+            result["stdout"].as_str().unwrap_or_default().to_string(),
+            result["stderr"].as_str().unwrap_or_default().to_string(),
+            result["exit_code"].as_i64().unwrap_or(-1) as i32,
+        ));
+    }
+}
+
+/// Run one command line in a new process (fallback when the daemon fails)
+fn run_once(exe_path: &PathBuf, args: &[String]) -> Result<(String, String, i32), String> {
+    let output = hidden_command(exe_path)
+        .args(args)
+        .stdout(Stdio::piped())
+        .stderr(Stdio::piped())
+        .output()
+        .map_err(|e| format!("Failed to execute command: {}", e))?;
+    Ok((
+        String::from_utf8_lossy(&output.stdout).to_string(),
+        String::from_utf8_lossy(&output.stderr).to_string(),
+        output.status.code().unwrap_or(-1),
+    ))
+}
+
 /// Execute FileVault CLI command
 #[tauri::command]
 async fn run_filevault_command(
     app_handle: tauri::AppHandle,
+    state: tauri::State<'_, DaemonState>,
     args: Vec<String>,
 ) -> Result<CommandResult, String> {
     // Get the filevault.exe path
@@ -72,30 +177,27 @@ async fn run_filevault_command(
         println!("  Arg[{}]: {:?}", i, arg);
     }
 
-    // Execute the command
-    #[cfg(windows)]
+    // Execute the command, starting the daemon on first use
     let output = {
-        use std::os::windows::process::CommandExt;
-        const CREATE_NO_WINDOW: u32 = 0x08000000;
-        
-        Command::new(&exe_path)
-            .args(&args)
-            .stdout(Stdio::piped())
-            .stderr(Stdio::piped())
-            .creation_flags(CREATE_NO_WINDOW)  // Hide console window
-            .output()
-            .map_err(|e| format!("Failed to execute command: {}", e))?
+        let mut daemon = state.0.lock().map_err(|_| "Daemon lock poisoned".to_string())?;
+        if daemon.is_none() {
+            *daemon = start_daemon(&exe_path).ok();
+        }
+        match daemon.as_mut().map(|d| run_in_daemon(d, &app_handle, &args)) {
+            Some(Ok(output)) => output,
+            other => {
+                if let Some(Err(e)) = other {
+                    println!("Daemon failed ({}), running command directly", e);
+                }
+                // A dead daemon is restarted on the next command
+                *daemon = None;
+                run_once(&exe_path, &args)?
+            }
+        }
     };
-    
-    #[cfg(not(windows))]
-    let output = Command::new(&exe_path)
-        .args(&args)
-        .stdout(Stdio::piped())
-        .stderr(Stdio::piped())
-        .output()
-        .map_err(|e| format!("Failed to execute command: {}", e))?;
-    
-    println!("Exit code: {:?}", output.status.code());
+    let (raw_stdout, raw_stderr, exit_code) = output;
+
+    println!("Exit code: {:?}", exit_code);
 
     // Strip ANSI escape codes and Unicode formatting from output
     let strip_ansi = |s: &str| -> String {
@@ -109,15 +211,14 @@ async fn run_filevault_command(
             .collect()
     };
 
-    let mut stdout = String::from_utf8_lossy(&output.stdout).to_string();
-    let mut stderr = String::from_utf8_lossy(&output.stderr).to_string();
+    let mut stdout = raw_stdout;
+    let mut stderr = raw_stderr;
     
     // Strip ANSI codes from both outputs
     stdout = strip_ansi(&stdout);
     stderr = strip_ansi(&stderr);
     
-    let exit_code = output.status.code().unwrap_or(-1);
-    let status_success = output.status.success();
+    let status_success = exit_code == 0;
 
     // CRITICAL FIX: CLI has bug where exit code is 0 even on failure
     // Check for error indicators in output
@@ -166,6 +267,7 @@ pub fn run() {
         .plugin(tauri_plugin_shell::init())
         .plugin(tauri_plugin_dialog::init())
         .plugin(tauri_plugin_opener::init())
+        .manage(DaemonState::default())
         .invoke_handler(tauri::generate_handler![run_filevault_command])
         .run(tauri::generate_context!())
         .expect("error while running tauri application");
@@ -1,4 +1,5 @@
 import { invoke } from '@tauri-apps/api/core';
+import { listen, type UnlistenFn } from '@tauri-apps/api/event';
 import type {
   EncryptOptions,
   DecryptOptions,
@@ -13,6 +14,7 @@ import type {
   CompressOptions,
   DecompressOptions,
   CommandResult,
+  CommandProgress,
 } from '../types';
 
 /**
@@ -33,6 +35,13 @@ async function executeCommand(args: string[]): Promise<CommandResult> {
   }
 }
 
+/**
+ * Subscribe to progress bars of running commands; returns the unsubscribe function
+ */
+export function onCommandProgress(callback: (progress: CommandProgress) => void): Promise<UnlistenFn> {
+  return listen<CommandProgress>('filevault-progress', (event) => callback(event.payload));
+}
+
 /**
  * Encrypt a file
  */
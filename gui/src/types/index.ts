@@ -110,6 +110,14 @@ export interface CommandResult {
   error?: string;
 }
 
+// Progress event of a running command (from `filevault serve`)
+export interface CommandProgress {
+  id: number;
+  label: string;
+  progress: number;
+  total: number;
+}
+
 // Log Entry
 export interface LogEntry {
   timestamp: Date;
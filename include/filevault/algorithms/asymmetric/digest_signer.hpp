@@ -0,0 +1,92 @@
+/**
+ * @file digest_signer.hpp
+ * @brief Detached signatures over SHA-256 file digests
+ */
+
+#ifndef FILEVAULT_ALGORITHMS_ASYMMETRIC_DIGEST_SIGNER_HPP
+#define FILEVAULT_ALGORITHMS_ASYMMETRIC_DIGEST_SIGNER_HPP
+
+#include "filevault/algorithms/asymmetric/loaded_key.hpp"
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace filevault {
+namespace algorithms {
+namespace asymmetric {
+
+/**
+ * @brief Signature schemes usable for file signing
+ */
+enum class SignatureScheme {
+    RSA_PSS,    // RSA-PSS with SHA-256
+    ECDSA,      // ECDSA over SHA-256, P1363 (r || s) encoding
+    ED25519     // Ed25519 over the SHA-256 digest
+};
+
+/**
+ * @brief Signs and verifies the SHA-256 digest of a file
+ *
+ * Files are hashed in one streaming pass and only the 32-byte digest is
+ * signed, so signing cost is the same for every file size and hashing can
+ * run on other threads. RSA-PSS and ECDSA use the raw-digest form of their
+ * padding, so the signatures are exactly those of PSS(SHA-256) and
+ * ECDSA/SHA-256 over the whole file, and verify against RSA::sign output.
+ * Ed25519 has no standard SHA-256 prehash; it signs the digest bytes with
+ * pure Ed25519, so only verifiers that hash first will accept it.
+ *
+ * Thread-safe: the key's operation objects are per thread.
+ */
+class DigestSigner {
+public:
+    static constexpr size_t DIGEST_SIZE = 32;
+
+    /**
+     * @throws std::invalid_argument for keys that cannot sign (ECDH, Kyber, ...)
+     */
+    explicit DigestSigner(LoadedKey key);
+
+    /**
+     * @brief Scheme for a key, from its algorithm
+     */
+    static std::optional<SignatureScheme> scheme_for(const LoadedKey& key);
+
+    static std::string scheme_name(SignatureScheme scheme);
+
+    /**
+     * @brief Scheme from a command-line name: rsa, ecc (or ecdsa), ed25519
+     */
+    static std::optional<SignatureScheme> parse_scheme(const std::string& name);
+
+    static std::vector<uint8_t> digest(std::span<const uint8_t> data);
+
+    /**
+     * @brief SHA-256 of a file, read in 1 MB blocks
+     * @throws std::runtime_error if the file cannot be read
+     */
+    static std::vector<uint8_t> digest_file(const std::string& path);
+
+    SignatureScheme scheme() const { return scheme_; }
+    const LoadedKey& key() const { return key_; }
+
+    /**
+     * @brief Sign a DIGEST_SIZE digest
+     * @throws std::runtime_error for a public key, Botan::Exception on failure
+     */
+    std::vector<uint8_t> sign(std::span<const uint8_t> digest) const;
+
+    bool verify(std::span<const uint8_t> digest, std::span<const uint8_t> signature) const;
+
+private:
+    std::string padding() const;
+
+    LoadedKey key_;
+    SignatureScheme scheme_;
+};
+
+} // namespace asymmetric
+} // namespace algorithms
+} // namespace filevault
+
+#endif
@@ -9,10 +9,12 @@
 #ifndef FILEVAULT_ALGORITHMS_ASYMMETRIC_ECC_HPP
 #define FILEVAULT_ALGORITHMS_ASYMMETRIC_ECC_HPP
 
+#include "filevault/algorithms/asymmetric/loaded_key.hpp"
 #include "filevault/core/crypto_algorithm.hpp"
 #include <botan/ecdh.h>
 #include <botan/ecdsa.h>
 #include <botan/ec_group.h>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -20,6 +22,8 @@ namespace filevault {
 namespace algorithms {
 namespace asymmetric {
 
+class EphemeralKeyPool;
+
 /**
  * @brief Supported elliptic curves
  */
@@ -27,7 +31,8 @@ enum class ECCurve {
     SECP256R1,  // P-256, 128-bit security
     SECP384R1,  // P-384, 192-bit security
     SECP521R1,  // P-521, 256-bit security
-    X25519      // Curve25519, 128-bit security (for ECDH only)
+    X25519,     // Curve25519, 128-bit security (ECDH and ECCHybrid)
+    ED25519     // Edwards25519, 128-bit security (for signatures only)
 };
 
 /**
@@ -91,6 +96,11 @@ class ECDH {
         std::span<const uint8_t> peer_public_key
     );
     
+    /**
+     * @brief Derive shared secret from already parsed keys
+     */
+    ECDHResult derive_shared_secret(const LoadedKey& own_private_key, const LoadedKey& peer_public_key);
+    
     std::string name() const;
     std::string curve_name() const;
     size_t key_size() const;  // In bytes
@@ -131,6 +141,11 @@ class ECDSA {
         std::span<const uint8_t> private_key
     );
     
+    /**
+     * @brief Sign with an already parsed private key
+     */
+    ECDSASignResult sign(std::span<const uint8_t> data, const LoadedKey& private_key);
+    
     /**
      * @brief Verify signature with public key
      * @param data Original data
@@ -144,6 +159,21 @@ class ECDSA {
         std::span<const uint8_t> public_key
     );
     
+    /**
+     * @brief Verify with an already parsed public key
+     */
+    bool verify(std::span<const uint8_t> data, std::span<const uint8_t> signature, const LoadedKey& public_key);
+    
+    /**
+     * @brief Sign a file in constant memory; same signature as sign() over its contents
+     */
+    ECDSASignResult sign_file(const std::string& path, const LoadedKey& private_key);
+    
+    /**
+     * @brief Verify a signature over a file in constant memory
+     */
+    bool verify_file(const std::string& path, std::span<const uint8_t> signature, const LoadedKey& public_key);
+    
     std::string name() const;
     std::string curve_name() const;
     size_t key_size() const;
@@ -154,6 +184,60 @@ class ECDSA {
     std::string botan_curve_name_;
 };
 
+/**
+ * @brief Ed25519 digital signatures (RFC 8032)
+ * 
+ * Deterministic 64-byte signatures; signing is much faster than RSA,
+ * which suits bulk signing. Keys are PKCS#8 / X.509 DER, as for ECDSA.
+ */
+class Ed25519 {
+public:
+    /**
+     * @brief Generate a new Ed25519 key pair
+     */
+    ECCKeyPair generate_key_pair();
+    
+    /**
+     * @brief Sign data (pure Ed25519, the message is not prehashed)
+     */
+    ECDSASignResult sign(std::span<const uint8_t> data, const LoadedKey& private_key);
+    
+    /**
+     * @brief Verify signature with public key
+     */
+    bool verify(std::span<const uint8_t> data, std::span<const uint8_t> signature, const LoadedKey& public_key);
+    
+    /**
+     * @brief Sign many messages with one parsed key, in parallel
+     * @param threads Workers (0 = one per core)
+     * @return Signatures in input order
+     * @throws std::exception on failure
+     */
+    std::vector<std::vector<uint8_t>> sign_batch(
+        const LoadedKey& private_key,
+        const std::vector<std::vector<uint8_t>>& messages,
+        size_t threads = 0
+    ) const;
+    
+    /**
+     * @brief Verify many (message, signature) pairs against one public key
+     *
+     * Each signature is checked on its own, so one forgery cannot hide among
+     * valid ones and the result says which entries failed.
+     * @return One result per pair, in input order
+     */
+    std::vector<bool> verify_batch(
+        const LoadedKey& public_key,
+        const std::vector<std::vector<uint8_t>>& messages,
+        const std::vector<std::vector<uint8_t>>& signatures,
+        size_t threads = 0
+    ) const;
+    
+    std::string name() const { return "Ed25519"; }
+    size_t key_size() const { return 32; }
+    size_t signature_size() const { return 64; }
+};
+
 /**
  * @brief Hybrid encryption using ECDH + AES-GCM
  * 
@@ -209,6 +293,15 @@ class ECCHybrid : public core::ICryptoAlgorithm {
      */
     ECCKeyPair generate_key_pair();
     
+    /**
+     * @brief Take ephemeral key pairs from a pregenerated pool
+     *
+     * Moves key generation off the encrypt path; the output format is
+     * unchanged. Pass nullptr to generate inline again.
+     * @throws std::invalid_argument if the pool is for another curve
+     */
+    void set_ephemeral_pool(std::shared_ptr<EphemeralKeyPool> pool);
+    
     size_t key_size() const override;
     bool is_suitable_for(core::SecurityLevel level) const override;
     
@@ -217,6 +310,7 @@ class ECCHybrid : public core::ICryptoAlgorithm {
     std::string botan_curve_name_;
     core::AlgorithmType type_;
     ECDH ecdh_;
+    std::shared_ptr<EphemeralKeyPool> ephemeral_pool_;
 };
 
 } // namespace asymmetric
@@ -0,0 +1,103 @@
+/**
+ * @file ephemeral_pool.hpp
+ * @brief Background pool of pregenerated ephemeral ECDH key pairs
+ */
+
+#ifndef FILEVAULT_ALGORITHMS_ASYMMETRIC_EPHEMERAL_POOL_HPP
+#define FILEVAULT_ALGORITHMS_ASYMMETRIC_EPHEMERAL_POOL_HPP
+
+#include "filevault/algorithms/asymmetric/ecc.hpp"
+#include "filevault/algorithms/asymmetric/loaded_key.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace filevault {
+namespace algorithms {
+namespace asymmetric {
+
+/**
+ * @brief Ephemeral ECDH key pairs generated ahead of time on an idle thread
+ *
+ * Key generation is most of the cost of an ECCHybrid encryption. The pool
+ * keeps up to `capacity` pairs ready, already parsed, and refills in the
+ * background once it drops below half. Each pair is handed out exactly
+ * once and then forgotten: a reused ephemeral key would let two messages
+ * to the same recipient share an AES key.
+ *
+ * take() never waits on the worker; an empty pool generates inline.
+ * All members are thread-safe.
+ */
+class EphemeralKeyPool {
+public:
+    /**
+     * @brief A single-use ephemeral key pair
+     */
+    struct Entry {
+        std::vector<uint8_t> public_key;   // DER, as written into the ciphertext
+        LoadedKey private_key;
+    };
+
+    /**
+     * @brief Start the pool and its refill thread
+     * @param curve Curve of the recipients' keys
+     * @param capacity Pairs kept ready (at least 1)
+     */
+    explicit EphemeralKeyPool(ECCurve curve, size_t capacity = 32);
+
+    /**
+     * @brief Stop the refill thread; pairs still queued are destroyed
+     */
+    ~EphemeralKeyPool();
+
+    EphemeralKeyPool(const EphemeralKeyPool&) = delete;
+    EphemeralKeyPool& operator=(const EphemeralKeyPool&) = delete;
+
+    /**
+     * @brief Remove and return one key pair
+     * @throws std::runtime_error if inline generation fails
+     */
+    Entry take();
+
+    ECCurve curve() const { return curve_; }
+    size_t capacity() const { return capacity_; }
+
+    /**
+     * @brief Pairs ready right now
+     */
+    size_t available() const;
+
+    /**
+     * @brief take() calls served from the pool / generated inline
+     */
+    uint64_t hits() const { return hits_.load(); }
+    uint64_t misses() const { return misses_.load(); }
+
+private:
+    Entry generate();
+    void refill_loop();
+
+    ECCurve curve_;
+    size_t capacity_;
+    ECDH ecdh_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable refill_cv_;
+    std::deque<Entry> ready_;
+    bool stopping_ = false;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+
+    std::thread worker_;   // Last: starts once everything above exists
+};
+
+} // namespace asymmetric
+} // namespace algorithms
+} // namespace filevault
+
+#endif // FILEVAULT_ALGORITHMS_ASYMMETRIC_EPHEMERAL_POOL_HPP
@@ -0,0 +1,145 @@
+/**
+ * @file loaded_key.hpp
+ * @brief Parsed asymmetric key handle for repeated operations
+ */
+
+#ifndef FILEVAULT_ALGORITHMS_ASYMMETRIC_LOADED_KEY_HPP
+#define FILEVAULT_ALGORITHMS_ASYMMETRIC_LOADED_KEY_HPP
+
+#include "filevault/core/result.hpp"
+#include <botan/pk_keys.h>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace filevault {
+namespace algorithms {
+namespace asymmetric {
+
+/**
+ * @brief Result of a KEM encapsulation
+ */
+struct Encapsulation {
+    std::vector<uint8_t> encapsulated_key;   // Sent to the key holder
+    Botan::secure_vector<uint8_t> shared_key;
+};
+
+/**
+ * @brief A parsed public or private key, ready for repeated use
+ *
+ * Parsing is the expensive part of a one-shot RSA or ECC operation: PEM
+ * decoding, a full ASN.1 parse and, for RSA private keys, the CRT and
+ * blinding precomputation. LoadedKey parses once. Signers, verifiers, KEMs,
+ * decryptors and key agreements are built the first time each thread uses
+ * them with a given padding, and reused after that. Botan's operation
+ * objects are reusable but not thread-safe, so each thread gets its own.
+ *
+ * Copies are cheap and share the parsed key and its operation objects.
+ * All operations are thread-safe.
+ */
+class LoadedKey {
+public:
+    LoadedKey() = default;
+
+    /**
+     * @brief Parse a PKCS#8 private key or an X.509 public key
+     * @param encoded PEM or DER; private keys must be unencrypted
+     */
+    static core::Result<LoadedKey> load(std::span<const uint8_t> encoded);
+
+    /**
+     * @brief Read and parse a key file
+     */
+    static core::Result<LoadedKey> load_file(const std::string& path);
+
+    /**
+     * @brief Adopt an already-built key, for formats load() does not parse
+     *        (raw Kyber and Dilithium keys)
+     */
+    static LoadedKey from_private_key(std::unique_ptr<Botan::Private_Key> key);
+    static LoadedKey from_public_key(std::unique_ptr<Botan::Public_Key> key);
+
+    bool valid() const { return state_ != nullptr; }
+    bool is_private() const;
+
+    /**
+     * @brief Public half (the key itself for public keys)
+     */
+    const Botan::Public_Key& public_key() const;
+
+    /**
+     * @throws std::runtime_error if only the public key was loaded
+     */
+    const Botan::Private_Key& private_key() const;
+
+    std::string algorithm() const { return public_key().algo_name(); }
+    size_t key_bits() const { return public_key().key_length(); }
+
+    /**
+     * @brief Sign a message; padding as for Botan::PK_Signer
+     * @throws std::runtime_error for public keys, Botan::Exception on failure
+     */
+    std::vector<uint8_t> sign(std::span<const uint8_t> message, std::string_view padding,
+                              bool der_signature = false) const;
+
+    /**
+     * @brief Check a signature; false for a bad signature
+     */
+    bool verify(std::span<const uint8_t> message, std::span<const uint8_t> signature,
+                std::string_view padding, bool der_signature = false) const;
+
+    /**
+     * @brief Sign a file, fed to the signer in 1 MB blocks
+     *
+     * Memory use is constant for any file size. Not for paddings that
+     * buffer the whole message (Ed25519 "Pure").
+     * @throws std::runtime_error if the file cannot be read
+     */
+    std::vector<uint8_t> sign_file(const std::string& path, std::string_view padding,
+                                   bool der_signature = false) const;
+
+    /**
+     * @brief Check a signature over a file, streamed like sign_file()
+     * @throws std::runtime_error if the file cannot be read
+     */
+    bool verify_file(const std::string& path, std::span<const uint8_t> signature,
+                     std::string_view padding, bool der_signature = false) const;
+
+    std::vector<uint8_t> encrypt(std::span<const uint8_t> plaintext, std::string_view padding) const;
+
+    /**
+     * @throws Botan::Decoding_Error for a wrong key or damaged ciphertext
+     */
+    Botan::secure_vector<uint8_t> decrypt(std::span<const uint8_t> ciphertext, std::string_view padding) const;
+
+    /**
+     * @brief Key agreement with a peer's public value (ECDH, X25519)
+     * @param kdf Botan KDF name, "Raw" for the bare shared secret
+     */
+    Botan::secure_vector<uint8_t> agree(std::span<const uint8_t> peer_public_value, size_t length,
+                                        std::string_view kdf) const;
+
+    /**
+     * @brief KEM encapsulation to this public key (Kyber / ML-KEM)
+     * @param kdf Botan KDF name, "Raw" for the bare shared secret
+     */
+    Encapsulation encapsulate(size_t length, std::string_view kdf) const;
+
+    /**
+     * @brief Recover the shared key from an encapsulation
+     */
+    Botan::secure_vector<uint8_t> decapsulate(std::span<const uint8_t> encapsulated_key, size_t length,
+                                              std::string_view kdf) const;
+
+private:
+    struct State;
+    std::shared_ptr<State> state_;
+};
+
+} // namespace asymmetric
+} // namespace algorithms
+} // namespace filevault
+
+#endif
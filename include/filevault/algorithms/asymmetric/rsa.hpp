@@ -9,6 +9,7 @@
 #ifndef FILEVAULT_ALGORITHMS_ASYMMETRIC_RSA_HPP
 #define FILEVAULT_ALGORITHMS_ASYMMETRIC_RSA_HPP
 
+#include "filevault/algorithms/asymmetric/loaded_key.hpp"
 #include "filevault/core/crypto_algorithm.hpp"
 #include <botan/rsa.h>
 #include <botan/pubkey.h>
@@ -37,6 +38,9 @@ struct RSAKeyPair {
  * 
  * Note: RSA encrypts limited data (key_size - padding overhead).
  * For large data, use hybrid encryption (RSA + symmetric cipher).
+ *
+ * The overloads taking encoded key bytes parse the key on every call;
+ * for repeated operations with one key, load it once as a LoadedKey.
  */
 class RSA : public core::ICryptoAlgorithm {
 public:
@@ -75,6 +79,16 @@ class RSA : public core::ICryptoAlgorithm {
         const core::EncryptionConfig& config
     ) override;
     
+    /**
+     * @brief Encrypt with an already parsed public (or private) key
+     */
+    core::CryptoResult encrypt(std::span<const uint8_t> plaintext, const LoadedKey& key);
+    
+    /**
+     * @brief Decrypt with an already parsed private key
+     */
+    core::CryptoResult decrypt(std::span<const uint8_t> ciphertext, const LoadedKey& key);
+    
     /**
      * @brief Generate a new RSA key pair
      * @return RSAKeyPair containing public and private keys
@@ -92,6 +106,11 @@ class RSA : public core::ICryptoAlgorithm {
         std::span<const uint8_t> private_key
     );
     
+    /**
+     * @brief Sign with an already parsed private key (RSA-PSS, SHA-256)
+     */
+    std::vector<uint8_t> sign(std::span<const uint8_t> data, const LoadedKey& private_key);
+    
     /**
      * @brief Verify signature with public key
      * @param data Original data
@@ -105,6 +124,22 @@ class RSA : public core::ICryptoAlgorithm {
         std::span<const uint8_t> public_key
     );
     
+    /**
+     * @brief Verify with an already parsed public key
+     */
+    bool verify(std::span<const uint8_t> data, std::span<const uint8_t> signature, const LoadedKey& public_key);
+    
+    /**
+     * @brief Sign a file in 1 MB blocks; same signature as sign() over its contents
+     * @throws std::runtime_error if the file cannot be read
+     */
+    std::vector<uint8_t> sign_file(const std::string& path, const LoadedKey& private_key);
+    
+    /**
+     * @brief Verify a signature over a file in constant memory
+     */
+    bool verify_file(const std::string& path, std::span<const uint8_t> signature, const LoadedKey& public_key);
+    
     size_t key_size() const override { return key_bits_ / 8; }
     
     /**
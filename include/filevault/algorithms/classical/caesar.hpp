@@ -36,6 +36,19 @@ class Caesar : public core::ICryptoAlgorithm {
         std::span<const uint8_t> key,
         const core::EncryptionConfig& config) override;
     
+    /**
+     * @brief Shift @p buffer in place; result.data is left empty
+     */
+    core::CryptoResult encrypt_in_place(
+        std::vector<uint8_t>& buffer,
+        std::span<const uint8_t> key,
+        const core::EncryptionConfig& config) override;
+    
+    core::CryptoResult decrypt_in_place(
+        std::vector<uint8_t>& buffer,
+        std::span<const uint8_t> key,
+        const core::EncryptionConfig& config) override;
+    
     bool is_suitable_for(core::SecurityLevel level) const override {
         (void)level; // Educational only - not for real security
         return false;
@@ -51,7 +64,8 @@ class Caesar : public core::ICryptoAlgorithm {
 private:
     int shift_;
     
-    char shift_char(char ch, int shift) const;
+    core::CryptoResult apply(std::span<const uint8_t> input, std::span<uint8_t> output,
+                             std::span<const uint8_t> key, bool decrypt) const;
 };
 
 } // namespace classical
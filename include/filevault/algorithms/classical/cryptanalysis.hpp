@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace filevault {
+namespace algorithms {
+namespace classical {
+
+/**
+ * @brief Log10 probabilities of English letter n-grams
+ *
+ * Scores candidate plaintexts: the higher the sum over a text's n-grams,
+ * the more it reads like the training text. Non-letters are dropped and
+ * case is folded, so "an ox" scores the bigrams AN, NO and OX.
+ */
+class NgramModel {
+public:
+    /**
+     * @brief Built-in bigram model trained on public-domain English prose
+     */
+    static const NgramModel& english_bigrams();
+
+    /**
+     * @brief Build a model from a sample of the expected language
+     * @param order n-gram length, 2-4
+     * @throws std::invalid_argument for a bad order or too little text
+     */
+    static NgramModel train(std::span<const uint8_t> text, int order);
+
+    int order() const { return order_; }
+
+    /**
+     * @brief log10 P of the n-gram with letter indices packed base 26
+     */
+    float log_prob(size_t index) const { return table_[index]; }
+
+    /**
+     * @brief Sum of log10 P over every n-gram of @p letters (0-25 each)
+     */
+    double score(std::span<const uint8_t> letters) const;
+
+private:
+    NgramModel(int order, std::vector<float> table) : order_(order), table_(std::move(table)) {}
+
+    int order_;
+    std::vector<float> table_;      // 26^order entries
+};
+
+/**
+ * @brief Settings for ClassicalCracker
+ */
+struct CrackOptions {
+    size_t threads = 0;                     // Workers (0 = one per core)
+    size_t max_key_length = 20;             // Longest Vigenère keyword tried
+    size_t restarts = 0;                    // Substitution hill-climbs (0 = 4 per worker)
+    size_t sample_letters = 20000;          // Letters scored per candidate by n-gram refinement
+    uint32_t seed = 1;                      // Substitution restarts are reproducible per seed
+    const NgramModel* model = nullptr;      // nullptr = NgramModel::english_bigrams()
+};
+
+/**
+ * @brief Key and plaintext recovered by ClassicalCracker
+ */
+struct CrackResult {
+    bool success = false;
+    std::string error_message;
+    std::vector<uint8_t> key;               // Key bytes for the cipher's decrypt(); empty for substitution
+    std::string key_text;                   // Shift, keyword, or cipher letters for plain A-Z
+    std::vector<uint8_t> plaintext;
+    double chi_squared = 0.0;               // Plaintext letter frequencies against English
+    double score = 0.0;                     // n-gram log10 probability per letter
+    uint64_t keys_tried = 0;
+    double seconds = 0.0;
+    size_t threads = 0;
+
+    double keys_per_second() const { return seconds > 0.0 ? keys_tried / seconds : 0.0; }
+};
+
+/**
+ * @brief Ciphertext-only attacks on the classical ciphers
+ *
+ * Caesar tries all 26 shifts through Caesar::decrypt and ranks them by
+ * chi-squared. Vigenère picks a keyword per length from per-column
+ * chi-squared, refines it column by column with the n-gram model and
+ * keeps the best length; the final text comes from Vigenere::decrypt.
+ * Substitution hill-climbs over key swaps from several starts, scoring
+ * with the n-gram model (a 26x26 count matrix makes each bigram score
+ * independent of the text length).
+ *
+ * Work items (shifts, key lengths, restarts) sit behind a shared counter
+ * that workers pull from until none are left, so no thread idles while
+ * another still has a queue of its own.
+ */
+class ClassicalCracker {
+public:
+    static CrackResult crack_caesar(std::span<const uint8_t> ciphertext, const CrackOptions& options = {});
+    static CrackResult crack_vigenere(std::span<const uint8_t> ciphertext, const CrackOptions& options = {});
+    static CrackResult crack_substitution(std::span<const uint8_t> ciphertext, const CrackOptions& options = {});
+
+    /**
+     * @brief Chi-squared distance of letter counts from English frequencies
+     */
+    static double chi_squared(const std::array<uint64_t, 26>& counts);
+};
+
+} // namespace classical
+} // namespace algorithms
+} // namespace filevault
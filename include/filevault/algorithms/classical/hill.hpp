@@ -14,6 +14,9 @@ namespace classical {
  * 
  * Educational cipher using matrix multiplication
  * Key: 4 integers forming invertible 2x2 matrix mod 26
+ * 
+ * The key matrix, its inverse and a 26x26 digraph table per direction
+ * are cached and rebuilt only when the key changes.
  */
 class HillCipher : public core::ICryptoAlgorithm {
 public:
@@ -54,6 +57,26 @@ class HillCipher : public core::ICryptoAlgorithm {
     
     std::string encrypt_block(const std::string& block, const Matrix2x2& key_matrix);
     std::string decrypt_block(const std::string& block, const Matrix2x2& inv_matrix);
+    
+    /**
+     * @brief Parse @p key and rebuild the cached tables if it changed
+     * @return false if the key matrix is not invertible
+     */
+    bool prepare(std::span<const uint8_t> key);
+    
+    /**
+     * @brief Apply @p matrix to every pair of @p text, 64 digraphs per batch
+     */
+    void transform_pairs(std::span<const uint8_t> text, const Matrix2x2& matrix,
+                         const std::array<uint16_t, 676>& pairs, std::vector<uint8_t>& out);
+    
+    std::vector<uint8_t> cached_key_;
+    bool cache_ready_ = false;
+    bool key_valid_ = false;
+    Matrix2x2 key_matrix_{};
+    Matrix2x2 inverse_matrix_{};
+    std::array<uint16_t, 676> encrypt_pairs_{};   // Letter pair -> output letters (low, high)
+    std::array<uint16_t, 676> decrypt_pairs_{};
 };
 
 } // namespace classical
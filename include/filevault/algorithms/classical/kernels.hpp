@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace filevault {
+namespace algorithms {
+namespace classical {
+namespace kernels {
+
+/**
+ * @brief Bulk letter-shift kernels shared by the classical ciphers
+ *
+ * Process 16 bytes per step with SSE2/SSSE3 (x86) or NEON (ARM64) and
+ * fall back to scalar code for the tail or when no SIMD unit is present.
+ * Every path is branch-free and table-lookup-free on the data, so timing
+ * does not depend on the text, and all paths produce the same bytes as
+ * the original per-character loops. Only ASCII letters are transformed;
+ * every other byte is copied unchanged.
+ *
+ * @p out must be at least as long as @p in; in-place use is allowed.
+ */
+
+/**
+ * @brief Shift every letter by @p shift positions (negative shifts back)
+ */
+void caesar(std::span<const uint8_t> in, std::span<uint8_t> out, int shift);
+
+/**
+ * @brief Per-position shifts for vigenere(), built once per keyword
+ *
+ * Keyword bytes are used as-is (after toupper), including bytes outside
+ * A-Z from binary keys; wrap_below reproduces the negative remainders the
+ * reference formula yields for those.
+ */
+struct ShiftSchedule {
+    std::vector<uint8_t> shift;       // Shift mod 26, padded by 16 for SIMD loads
+    std::vector<uint8_t> wrap_below;  // Letter offsets below this come out 26 lower
+    size_t length = 0;                // Keyword length
+
+    /**
+     * @brief Build the schedule for an uppercased keyword
+     * @param decrypt true to build the inverse shifts
+     */
+    static ShiftSchedule from_keyword(const std::string& keyword, bool decrypt);
+};
+
+/**
+ * @brief Vigenère-shift letters, advancing the key only on letters
+ * @param key_index Key position of the first letter
+ * @return Key position after the last letter (mod keyword length)
+ */
+size_t vigenere(std::span<const uint8_t> in, std::span<uint8_t> out,
+                const ShiftSchedule& schedule, size_t key_index = 0);
+
+/**
+ * @brief Replace each letter through a 26-entry uppercase alphabet
+ *
+ * Case is preserved: lowercase input yields the lowercase map letter.
+ * Every map entry must be in 'A'..'Z'.
+ */
+void substitute(std::span<const uint8_t> in, std::span<uint8_t> out,
+                const std::array<char, 26>& map);
+
+/**
+ * @brief Add the number of times each letter occurs in @p in to @p counts
+ *
+ * Case-folded, so counts[0] covers 'A' and 'a'. SIMD paths keep 8-bit
+ * lane counters per letter and flush them before they can overflow.
+ */
+void letter_histogram(std::span<const uint8_t> in, std::array<uint64_t, 26>& counts);
+
+} // namespace kernels
+} // namespace classical
+} // namespace algorithms
+} // namespace filevault
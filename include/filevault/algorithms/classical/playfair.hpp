@@ -1,8 +1,9 @@
 #pragma once
 
 #include "filevault/core/crypto_algorithm.hpp"
+#include <array>
 #include <string>
-#include <utility>
+#include <vector>
 
 namespace filevault {
 namespace algorithms {
@@ -17,6 +18,10 @@ namespace classical {
  * Security: BROKEN - 600 possible digraphs still analyzable
  * Purpose: Educational - shows digraph cryptanalysis
  * 
+ * Letters are looked up through a 26-entry letter-to-cell table and the
+ * grid itself, and every digraph through a precomputed 25x25 table per
+ * direction, rebuilt only when the keyword changes.
+ * 
  * @see https://en.wikipedia.org/wiki/Playfair_cipher
  */
 class Playfair : public core::ICryptoAlgorithm {
@@ -43,10 +48,20 @@ class Playfair : public core::ICryptoAlgorithm {
     }
     
 private:
-    char matrix_[5][5];
+    std::string keyword_;                       // Keyword the tables were built for
+    std::array<char, 25> grid_;                 // Row-major 5x5 matrix (cell -> letter)
+    std::array<uint8_t, 26> cell_;              // Letter -> cell; J shares I's cell
+    std::array<uint16_t, 625> encrypt_pairs_;   // Cell pair -> output letters (low, high)
+    std::array<uint16_t, 625> decrypt_pairs_;
     
     void build_matrix(const std::string& keyword);
-    std::pair<int, int> find_position(char ch) const;
+    uint8_t cell_of(uint8_t byte) const;
+    
+    /**
+     * @brief Map cell pairs through @p pairs, 64 digraphs per batch
+     */
+    static void transform_pairs(const std::vector<uint8_t>& cells, const std::array<uint16_t, 625>& pairs,
+                                std::vector<uint8_t>& out);
 };
 
 } // namespace classical
@@ -3,7 +3,10 @@
 
 #include "filevault/core/crypto_algorithm.hpp"
 #include <array>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 namespace filevault {
 namespace algorithms {
@@ -35,6 +38,21 @@ class SubstitutionCipher : public core::ICryptoAlgorithm {
         const core::EncryptionConfig& config
     ) override;
     
+    /**
+     * @brief Substitute @p buffer in place; result.data is left empty
+     */
+    core::CryptoResult encrypt_in_place(
+        std::vector<uint8_t>& buffer,
+        std::span<const uint8_t> key,
+        const core::EncryptionConfig& config
+    ) override;
+    
+    core::CryptoResult decrypt_in_place(
+        std::vector<uint8_t>& buffer,
+        std::span<const uint8_t> key,
+        const core::EncryptionConfig& config
+    ) override;
+    
     size_t key_size() const override { return 26; }  // 26-letter alphabet
     
     bool is_suitable_for(core::SecurityLevel level) const override {
@@ -46,11 +64,31 @@ class SubstitutionCipher : public core::ICryptoAlgorithm {
 private:
     using SubstitutionMap = std::array<char, 26>;
     
+    struct Maps {
+        std::vector<uint8_t> key;       // Key bytes as passed in
+        SubstitutionMap forward;
+        SubstitutionMap reverse;
+        bool valid = false;
+    };
+    
     SubstitutionMap parse_key(std::span<const uint8_t> key);
     SubstitutionMap create_reverse_map(const SubstitutionMap& forward_map);
     bool is_valid_key(const SubstitutionMap& map);
     
-    std::string apply_substitution(const std::string& text, const SubstitutionMap& map);
+    /**
+     * @brief Parsed maps for @p key, reused while the key bytes repeat
+     */
+    std::shared_ptr<const Maps> maps_for(std::span<const uint8_t> key);
+    
+    core::CryptoResult apply(
+        std::span<const uint8_t> input,
+        std::span<uint8_t> output,
+        std::span<const uint8_t> key,
+        bool decrypt
+    );
+    
+    std::mutex cache_mutex_;
+    std::shared_ptr<const Maps> cached_;
 };
 
 } // namespace classical
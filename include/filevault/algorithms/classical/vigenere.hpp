@@ -1,6 +1,9 @@
 #pragma once
 
 #include "filevault/core/crypto_algorithm.hpp"
+#include "filevault/algorithms/classical/kernels.hpp"
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -37,13 +40,44 @@ class Vigenere : public core::ICryptoAlgorithm {
         std::span<const uint8_t> key,
         const core::EncryptionConfig& config) override;
     
+    /**
+     * @brief Shift @p buffer in place; result.data is left empty
+     */
+    core::CryptoResult encrypt_in_place(
+        std::vector<uint8_t>& buffer,
+        std::span<const uint8_t> key,
+        const core::EncryptionConfig& config) override;
+    
+    core::CryptoResult decrypt_in_place(
+        std::vector<uint8_t>& buffer,
+        std::span<const uint8_t> key,
+        const core::EncryptionConfig& config) override;
+    
     bool is_suitable_for(core::SecurityLevel level) const override {
         (void)level;
         return false;
     }
     
 private:
+    struct Schedules {
+        std::vector<uint8_t> key;              // Key bytes as passed in
+        kernels::ShiftSchedule encrypt;
+        kernels::ShiftSchedule decrypt;
+    };
+    
     std::string keyword_;
+    std::shared_ptr<const Schedules> default_;  // Built once for keyword_
+    mutable std::mutex cache_mutex_;
+    mutable std::shared_ptr<const Schedules> cached_;  // Last non-empty key
+    
+    static std::shared_ptr<const Schedules> build(std::span<const uint8_t> key);
+    std::shared_ptr<const Schedules> schedules_for(std::span<const uint8_t> key) const;
+    
+    core::CryptoResult apply(
+        std::span<const uint8_t> input,
+        std::span<uint8_t> output,
+        std::span<const uint8_t> key,
+        bool decrypt) const;
 };
 
 } // namespace classical
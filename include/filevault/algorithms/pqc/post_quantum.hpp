@@ -1,7 +1,9 @@
 #ifndef FILEVAULT_ALGORITHMS_POST_QUANTUM_HPP
 #define FILEVAULT_ALGORITHMS_POST_QUANTUM_HPP
 
+#include "filevault/algorithms/asymmetric/loaded_key.hpp"
 #include "filevault/core/crypto_algorithm.hpp"
+#include "filevault/core/result.hpp"
 #include <string>
 #include <vector>
 
@@ -107,6 +109,38 @@ class Kyber : public core::ICryptoAlgorithm {
      * @brief Get shared secret size (always 32 bytes)
      */
     size_t shared_secret_size() const { return 32; }
+    
+    /**
+     * @brief Parse a raw Kyber key once for batch operations
+     */
+    core::Result<asymmetric::LoadedKey> load_public_key(std::span<const uint8_t> public_key) const;
+    core::Result<asymmetric::LoadedKey> load_private_key(std::span<const uint8_t> private_key) const;
+    
+    /**
+     * @brief Encapsulate `count` fresh shared secrets to one public key
+     * 
+     * Work is split across `threads` workers (0 = one per core); each
+     * reuses its own KEM operation and its thread's RNG.
+     * @throws std::exception on failure
+     */
+    std::vector<asymmetric::Encapsulation> encapsulate_batch(
+        const asymmetric::LoadedKey& public_key,
+        size_t count,
+        size_t threads = 0
+    ) const;
+    
+    /**
+     * @brief Decapsulate many ciphertexts with one private key
+     * 
+     * ML-KEM uses implicit rejection: a damaged ciphertext yields an
+     * unrelated secret rather than an error.
+     * @return Shared secrets in input order
+     */
+    std::vector<Botan::secure_vector<uint8_t>> decapsulate_batch(
+        const asymmetric::LoadedKey& private_key,
+        const std::vector<std::vector<uint8_t>>& ciphertexts,
+        size_t threads = 0
+    ) const;
 
 private:
     Variant variant_;
@@ -170,6 +204,35 @@ class Dilithium {
         std::span<const uint8_t> public_key
     );
     
+    /**
+     * @brief Parse a raw Dilithium key once for batch operations
+     */
+    core::Result<asymmetric::LoadedKey> load_public_key(std::span<const uint8_t> public_key) const;
+    core::Result<asymmetric::LoadedKey> load_private_key(std::span<const uint8_t> private_key) const;
+    
+    /**
+     * @brief Sign many messages with one parsed key, in parallel
+     * @param threads Workers (0 = one per core)
+     * @return Signatures in input order
+     * @throws std::exception on failure
+     */
+    std::vector<std::vector<uint8_t>> sign_batch(
+        const asymmetric::LoadedKey& private_key,
+        const std::vector<std::vector<uint8_t>>& messages,
+        size_t threads = 0
+    ) const;
+    
+    /**
+     * @brief Verify many (message, signature) pairs against one public key
+     * @return One result per pair, in input order
+     */
+    std::vector<bool> verify_batch(
+        const asymmetric::LoadedKey& public_key,
+        const std::vector<std::vector<uint8_t>>& messages,
+        const std::vector<std::vector<uint8_t>>& signatures,
+        size_t threads = 0
+    ) const;
+    
     /**
      * @brief Get public key size for this variant
      */
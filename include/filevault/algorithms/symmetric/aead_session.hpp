@@ -0,0 +1,119 @@
+#ifndef FILEVAULT_ALGORITHMS_SYMMETRIC_AEAD_SESSION_HPP
+#define FILEVAULT_ALGORITHMS_SYMMETRIC_AEAD_SESSION_HPP
+
+#include "filevault/core/crypto_algorithm.hpp"
+#include "filevault/core/random.hpp"
+#include "filevault/core/secure_arena.hpp"
+#include <botan/aead.h>
+#include <memory>
+#include <string>
+
+namespace filevault {
+namespace algorithms {
+namespace symmetric {
+
+/**
+ * @brief Keyed session shared by the Botan-backed AEAD ciphers
+ *
+ * Holds one Botan::AEAD_Mode per direction with the key already set, so
+ * each message only costs start(nonce) + finish(). Modes are created on
+ * first use, so a decrypt-only session never builds an encryptor.
+ *
+ * SIV puts its tag (the synthetic IV) in front of the ciphertext; with
+ * tag_first the session moves it so callers always see ciphertext, tag.
+ * SIV needs the whole message before it can emit anything, so such
+ * sessions decline the incremental API.
+ */
+class AeadSession : public core::ICipherSession {
+public:
+    /**
+     * @param botan_name Botan mode name (e.g. "AES-256/GCM")
+     * @param type Algorithm reported in results
+     * @param key Key, already validated by the owning algorithm
+     * @param nonce_size Nonce length in bytes
+     * @param tag_size Tag length in bytes
+     * @param tag_first Botan emits tag || ciphertext (SIV)
+     */
+    AeadSession(
+        std::string botan_name,
+        core::AlgorithmType type,
+        std::span<const uint8_t> key,
+        size_t nonce_size,
+        size_t tag_size,
+        bool tag_first = false
+    );
+    ~AeadSession() override = default;
+    
+    core::CryptoResult encrypt_in_place(
+        std::vector<uint8_t>& buffer,
+        const core::EncryptionConfig& config
+    ) override;
+    
+    core::CryptoResult decrypt_in_place(
+        std::vector<uint8_t>& buffer,
+        const core::EncryptionConfig& config
+    ) override;
+    
+    /**
+     * @brief Seal every message directly in the arena
+     *
+     * Nonces come from a per-session CounterNonce and the arena is
+     * reserved once per batch; associated data is set once per batch.
+     */
+    core::BatchResult encrypt_batch(
+        std::span<const std::span<const uint8_t>> messages,
+        const core::EncryptionConfig& config,
+        std::vector<uint8_t>& arena
+    ) override;
+    
+    core::BatchResult decrypt_batch(
+        std::span<const uint8_t> arena,
+        std::span<const core::BatchRecord> records,
+        const core::EncryptionConfig& config,
+        std::vector<uint8_t>& output
+    ) override;
+
+    /**
+     * @brief Incremental encryption with the session's encryptor
+     *
+     * Botan's update() runs on each piece; finish() on the last one
+     * produces the tag, which is split off into the result.
+     */
+    bool encrypt_begin(const core::EncryptionConfig& config) override;
+    size_t encrypt_update(std::span<uint8_t> buffer) override;
+    core::CryptoResult encrypt_finish(std::vector<uint8_t>& buffer) override;
+    size_t encrypt_granularity() const override;
+
+    /**
+     * @brief Incremental decryption with the session's decryptor
+     *
+     * Botan's update() runs on each piece; the tag given to
+     * decrypt_begin() is appended for the final finish().
+     */
+    bool decrypt_begin(const core::EncryptionConfig& config) override;
+    size_t decrypt_update(std::span<uint8_t> buffer) override;
+    core::CryptoResult decrypt_finish(std::vector<uint8_t>& buffer) override;
+    size_t decrypt_granularity() const override;
+
+private:
+    Botan::AEAD_Mode& mode(std::unique_ptr<Botan::AEAD_Mode>& slot, Botan::Cipher_Dir direction);
+    static void set_associated_data(Botan::AEAD_Mode& cipher, const core::EncryptionConfig& config);
+    
+    std::string botan_name_;
+    core::AlgorithmType type_;
+    core::SecureBytes key_;
+    size_t nonce_size_;
+    size_t tag_size_;
+    bool tag_first_;
+    std::unique_ptr<Botan::AEAD_Mode> encryptor_;
+    std::unique_ptr<Botan::AEAD_Mode> decryptor_;
+    std::unique_ptr<core::CounterNonce> nonce_counter_;
+    core::ShortBytes pending_nonce_;        // Nonce of the message being encrypted incrementally
+    core::ShortBytes pending_tag_;          // Tag of the message being decrypted incrementally
+};
+
+} // namespace symmetric
+} // namespace algorithms
+} // namespace filevault
+
+#endif // FILEVAULT_ALGORITHMS_SYMMETRIC_AEAD_SESSION_HPP
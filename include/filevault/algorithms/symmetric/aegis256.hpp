@@ -0,0 +1,64 @@
+/**
+ * @file aegis256.hpp
+ * @brief AEGIS-256 AEAD encryption algorithm
+ *
+ * AEGIS-256 (draft-irtf-cfrg-aegis-aead) builds its state update from the
+ * AES round function, so with AES-NI or VAES it outruns AES-GCM by a wide
+ * margin. The 256-bit nonce makes random nonces safe for any number of
+ * messages. Needs Botan 3.4 or newer.
+ */
+
+#ifndef FILEVAULT_ALGORITHMS_SYMMETRIC_AEGIS256_HPP
+#define FILEVAULT_ALGORITHMS_SYMMETRIC_AEGIS256_HPP
+
+#include "filevault/core/crypto_algorithm.hpp"
+#include <memory>
+
+namespace filevault {
+namespace algorithms {
+namespace symmetric {
+
+/**
+ * @brief AEGIS-256 AEAD encryption
+ *
+ * 256-bit key, 256-bit nonce, 128-bit tag.
+ */
+class AEGIS_256 : public core::ICryptoAlgorithm {
+public:
+    AEGIS_256() = default;
+    virtual ~AEGIS_256() = default;
+    
+    std::string name() const override { return "AEGIS-256"; }
+    core::AlgorithmType type() const override { return core::AlgorithmType::AEGIS_256; }
+    
+    core::CryptoResult encrypt(
+        std::span<const uint8_t> plaintext,
+        std::span<const uint8_t> key,
+        const core::EncryptionConfig& config
+    ) override;
+    
+    core::CryptoResult decrypt(
+        std::span<const uint8_t> ciphertext,
+        std::span<const uint8_t> key,
+        const core::EncryptionConfig& config
+    ) override;
+    
+    size_t key_size() const override { return 32; }  // 256 bits
+    size_t nonce_size() const { return 32; }  // 256-bit nonce
+    size_t tag_size() const { return 16; }    // 128-bit tag
+    
+    std::unique_ptr<core::ICipherSession> create_session(std::span<const uint8_t> key) override;
+    
+    bool is_suitable_for(core::SecurityLevel level) const override;
+    
+    /**
+     * @brief Whether the linked Botan provides this mode
+     */
+    static bool is_available();
+};
+
+} // namespace symmetric
+} // namespace algorithms
+} // namespace filevault
+
+#endif // FILEVAULT_ALGORITHMS_SYMMETRIC_AEGIS256_HPP
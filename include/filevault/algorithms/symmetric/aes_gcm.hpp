@@ -32,10 +32,24 @@ class AES_GCM : public core::ICryptoAlgorithm {
         const core::EncryptionConfig& config
     ) override;
     
+    core::CryptoResult encrypt_in_place(
+        std::vector<uint8_t>& buffer,
+        std::span<const uint8_t> key,
+        const core::EncryptionConfig& config
+    ) override;
+    
+    core::CryptoResult decrypt_in_place(
+        std::vector<uint8_t>& buffer,
+        std::span<const uint8_t> key,
+        const core::EncryptionConfig& config
+    ) override;
+    
     size_t key_size() const override { return key_bits_ / 8; }
     size_t nonce_size() const { return 12; } // GCM standard
     size_t tag_size() const { return 16; }    // 128-bit tag
     
+    std::unique_ptr<core::ICipherSession> create_session(std::span<const uint8_t> key) override;
+    
     bool is_suitable_for(core::SecurityLevel level) const override;
 
 private:
@@ -0,0 +1,63 @@
+/**
+ * @file aes_ocb.hpp
+ * @brief AES-256-OCB AEAD encryption algorithm
+ *
+ * OCB (RFC 7253) authenticates and encrypts in a single pass of
+ * independent block cipher calls, so it pipelines as well as CTR and
+ * needs no GHASH. The patents on OCB have been released.
+ */
+
+#ifndef FILEVAULT_ALGORITHMS_SYMMETRIC_AES_OCB_HPP
+#define FILEVAULT_ALGORITHMS_SYMMETRIC_AES_OCB_HPP
+
+#include "filevault/core/crypto_algorithm.hpp"
+#include <memory>
+
+namespace filevault {
+namespace algorithms {
+namespace symmetric {
+
+/**
+ * @brief AES-256-OCB AEAD encryption
+ *
+ * 256-bit key, 96-bit nonce, 128-bit tag.
+ */
+class AES_OCB : public core::ICryptoAlgorithm {
+public:
+    AES_OCB() = default;
+    virtual ~AES_OCB() = default;
+    
+    std::string name() const override { return "AES-256-OCB"; }
+    core::AlgorithmType type() const override { return core::AlgorithmType::AES_256_OCB; }
+    
+    core::CryptoResult encrypt(
+        std::span<const uint8_t> plaintext,
+        std::span<const uint8_t> key,
+        const core::EncryptionConfig& config
+    ) override;
+    
+    core::CryptoResult decrypt(
+        std::span<const uint8_t> ciphertext,
+        std::span<const uint8_t> key,
+        const core::EncryptionConfig& config
+    ) override;
+    
+    size_t key_size() const override { return 32; }  // 256 bits
+    size_t nonce_size() const { return 12; }  // 96-bit nonce
+    size_t tag_size() const { return 16; }    // 128-bit tag
+    
+    std::unique_ptr<core::ICipherSession> create_session(std::span<const uint8_t> key) override;
+    
+    bool is_suitable_for(core::SecurityLevel level) const override;
+    
+    /**
+     * @brief Whether the linked Botan provides this mode
+     */
+    static bool is_available();
+};
+
+} // namespace symmetric
+} // namespace algorithms
+} // namespace filevault
+
+#endif // FILEVAULT_ALGORITHMS_SYMMETRIC_AES_OCB_HPP
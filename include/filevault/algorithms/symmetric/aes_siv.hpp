@@ -0,0 +1,64 @@
+/**
+ * @file aes_siv.hpp
+ * @brief AES-256-SIV AEAD encryption algorithm
+ *
+ * SIV (RFC 5297) derives the IV from the key, nonce, associated data and
+ * plaintext. A repeated nonce only reveals that two messages were equal,
+ * instead of breaking confidentiality and authenticity as it does for GCM.
+ * The price is two passes over the data, so it cannot stream a message.
+ */
+
+#ifndef FILEVAULT_ALGORITHMS_SYMMETRIC_AES_SIV_HPP
+#define FILEVAULT_ALGORITHMS_SYMMETRIC_AES_SIV_HPP
+
+#include "filevault/core/crypto_algorithm.hpp"
+#include <memory>
+
+namespace filevault {
+namespace algorithms {
+namespace symmetric {
+
+/**
+ * @brief AES-256-SIV AEAD encryption
+ *
+ * 512-bit key (S2V and CTR halves), 96-bit nonce, 128-bit tag.
+ */
+class AES_SIV : public core::ICryptoAlgorithm {
+public:
+    AES_SIV() = default;
+    virtual ~AES_SIV() = default;
+    
+    std::string name() const override { return "AES-256-SIV"; }
+    core::AlgorithmType type() const override { return core::AlgorithmType::AES_256_SIV; }
+    
+    core::CryptoResult encrypt(
+        std::span<const uint8_t> plaintext,
+        std::span<const uint8_t> key,
+        const core::EncryptionConfig& config
+    ) override;
+    
+    core::CryptoResult decrypt(
+        std::span<const uint8_t> ciphertext,
+        std::span<const uint8_t> key,
+        const core::EncryptionConfig& config
+    ) override;
+    
+    size_t key_size() const override { return 64; }  // 512 bits (two AES-256 keys)
+    size_t nonce_size() const { return 12; }  // 96-bit nonce
+    size_t tag_size() const { return 16; }    // 128-bit tag
+    
+    std::unique_ptr<core::ICipherSession> create_session(std::span<const uint8_t> key) override;
+    
+    bool is_suitable_for(core::SecurityLevel level) const override;
+    
+    /**
+     * @brief Whether the linked Botan provides this mode
+     */
+    static bool is_available();
+};
+
+} // namespace symmetric
+} // namespace algorithms
+} // namespace filevault
+
+#endif // FILEVAULT_ALGORITHMS_SYMMETRIC_AES_SIV_HPP
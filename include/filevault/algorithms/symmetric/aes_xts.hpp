@@ -9,10 +9,18 @@
 #ifndef FILEVAULT_ALGORITHMS_SYMMETRIC_AES_XTS_HPP
 #define FILEVAULT_ALGORITHMS_SYMMETRIC_AES_XTS_HPP
 
+#include "filevault/core/checkout_cache.hpp"
 #include "filevault/core/crypto_algorithm.hpp"
+#include "filevault/core/secure_arena.hpp"
 #include <botan/cipher_mode.h>
+#include <array>
+#include <memory>
 
 namespace filevault {
+namespace core {
+class ThreadPool;
+} // namespace core
+
 namespace algorithms {
 namespace symmetric {
 
@@ -67,6 +75,67 @@ class AES_XTS : public core::ICryptoAlgorithm {
     std::string botan_name_;
 };
 
+/**
+ * @brief AES-XTS over fixed-size sectors, as a block device uses it
+ *
+ * Every sector is its own XTS data unit, with the IEEE 1619 tweak: the
+ * sector number as a 16-byte little-endian integer (dm-crypt "plain64").
+ * Any run of sectors can be encrypted or decrypted on its own, in any
+ * order. AES_XTS::encrypt() with that tweak gives the same result for a
+ * single sector.
+ *
+ * The key schedule is built once per worker and kept between calls.
+ * Runs of many sectors are split across a thread pool.
+ */
+class XtsSectorCipher {
+public:
+    static constexpr size_t MIN_SECTOR_SIZE = 512;
+    static constexpr size_t MAX_SECTOR_SIZE = 64 * 1024;
+    
+    /**
+     * @param key Both XTS keys: 32 bytes for AES-128-XTS, 64 for AES-256-XTS
+     * @param sector_size Data unit size: a power of two from 512 to 64 KiB
+     * @throws std::invalid_argument on a bad key or sector size
+     */
+    explicit XtsSectorCipher(std::span<const uint8_t> key, size_t sector_size = 4096);
+    
+    XtsSectorCipher(const XtsSectorCipher&) = delete;
+    XtsSectorCipher& operator=(const XtsSectorCipher&) = delete;
+    
+    /**
+     * @brief Encrypt whole sectors in place
+     * @param first_sector Number of the sector at the start of data
+     * @param data A multiple of sector_size() bytes
+     * @param pool Workers for large runs; nullptr to stay on this thread
+     * @throws std::invalid_argument if data is not whole sectors
+     */
+    void encrypt(uint64_t first_sector, std::span<uint8_t> data, core::ThreadPool* pool = nullptr);
+    
+    /**
+     * @brief Decrypt whole sectors in place (see encrypt())
+     */
+    void decrypt(uint64_t first_sector, std::span<uint8_t> data, core::ThreadPool* pool = nullptr);
+    
+    size_t sector_size() const { return sector_size_; }
+    size_t key_size() const { return key_.size(); }
+    
+    /**
+     * @brief The tweak of a sector: its number, little-endian
+     */
+    static std::array<uint8_t, 16> tweak(uint64_t sector);
+    
+private:
+    void process(core::CheckoutCache<Botan::Cipher_Mode>& modes, uint64_t first_sector,
+                 std::span<uint8_t> data, core::ThreadPool* pool);
+    std::unique_ptr<Botan::Cipher_Mode> create_mode(Botan::Cipher_Dir direction) const;
+    
+    std::string botan_name_;
+    core::SecureBytes key_;
+    size_t sector_size_;
+    core::CheckoutCache<Botan::Cipher_Mode> encryptors_;    // Keyed modes, one per concurrent worker
+    core::CheckoutCache<Botan::Cipher_Mode> decryptors_;
+};
+
 } // namespace symmetric
 } // namespace algorithms
 } // namespace filevault
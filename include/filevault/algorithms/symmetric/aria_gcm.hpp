@@ -52,6 +52,8 @@ class ARIA_GCM : public core::ICryptoAlgorithm {
     size_t nonce_size() const { return 12; }  // GCM standard
     size_t tag_size() const { return 16; }    // 128-bit tag
     
+    std::unique_ptr<core::ICipherSession> create_session(std::span<const uint8_t> key) override;
+    
     bool is_suitable_for(core::SecurityLevel level) const override;
 
 private:
@@ -48,10 +48,24 @@ class ChaCha20Poly1305 : public core::ICryptoAlgorithm {
         const core::EncryptionConfig& config
     ) override;
     
+    core::CryptoResult encrypt_in_place(
+        std::vector<uint8_t>& buffer,
+        std::span<const uint8_t> key,
+        const core::EncryptionConfig& config
+    ) override;
+    
+    core::CryptoResult decrypt_in_place(
+        std::vector<uint8_t>& buffer,
+        std::span<const uint8_t> key,
+        const core::EncryptionConfig& config
+    ) override;
+    
     size_t key_size() const override { return 32; }  // 256 bits
     size_t nonce_size() const { return 12; }         // 96 bits (RFC 8439)
     size_t tag_size() const { return 16; }           // 128 bits
     
+    std::unique_ptr<core::ICipherSession> create_session(std::span<const uint8_t> key) override;
+    
     bool is_suitable_for(core::SecurityLevel level) const override;
 };
 
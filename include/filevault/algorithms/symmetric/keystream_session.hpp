@@ -0,0 +1,150 @@
+#ifndef FILEVAULT_ALGORITHMS_SYMMETRIC_KEYSTREAM_SESSION_HPP
+#define FILEVAULT_ALGORITHMS_SYMMETRIC_KEYSTREAM_SESSION_HPP
+
+#include "filevault/core/crypto_algorithm.hpp"
+#include "filevault/core/random.hpp"
+#include "filevault/core/secure_arena.hpp"
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Botan {
+class MessageAuthenticationCode;
+class StreamCipher;
+}
+
+namespace filevault {
+namespace algorithms {
+namespace symmetric {
+
+struct KeystreamSessionOptions {
+    size_t message_size = 256;      // Keystream bytes per ring entry
+    size_t depth = 64;              // Ring entries
+};
+
+struct KeystreamSessionStats {
+    uint64_t precomputed = 0;       // Messages sealed from the ring
+    uint64_t computed_inline = 0;   // Too long, or the ring was empty
+};
+
+/**
+ * @brief ChaCha20-Poly1305 / AES-CTR session with keystream computed ahead of time
+ *
+ * For latency-critical small messages. A background thread fills a
+ * bounded ring with the keystream of the session's next nonces, so
+ * sealing a message that fits an entry is an XOR, plus Poly1305 for
+ * ChaCha20-Poly1305. The output is the cipher's standard one: any
+ * session of the same algorithm and key decrypts it.
+ *
+ * The session issues every nonce itself from a CounterNonce (for AES-CTR
+ * followed by a zero 32-bit block counter, so messages never share
+ * counter blocks) and scrubs each ring entry as it is used, so no
+ * keystream serves twice; a caller-supplied nonce is refused, and so is
+ * the incremental API, which takes one. A message longer than
+ * message_size, or one that finds the ring empty, is encrypted inline
+ * under the next nonce. Decryption goes to the algorithm's own session.
+ *
+ * Unused keystream decrypts the messages it is for, so the ring is kept
+ * in SecureBytes and is as sensitive as the key. Like other sessions it
+ * is used from one thread at a time; the filler thread is internal.
+ */
+class KeystreamSession : public core::ICipherSession {
+public:
+    /**
+     * @brief True for the stream modes: AES-CTR and ChaCha20-Poly1305
+     */
+    static bool supports(core::AlgorithmType type);
+
+    /**
+     * @brief Bind algorithm to key and start filling the ring
+     * @return nullptr if the algorithm is not a stream mode, the key size
+     *         is wrong or options.depth is 0
+     */
+    static std::unique_ptr<KeystreamSession> create(
+        core::ICryptoAlgorithm& algorithm,
+        std::span<const uint8_t> key,
+        KeystreamSessionOptions options = {}
+    );
+
+    KeystreamSession(
+        core::AlgorithmType type,
+        std::span<const uint8_t> key,
+        KeystreamSessionOptions options,
+        std::unique_ptr<core::ICipherSession> regular
+    );
+    ~KeystreamSession() override;
+
+    KeystreamSession(const KeystreamSession&) = delete;
+    KeystreamSession& operator=(const KeystreamSession&) = delete;
+
+    /**
+     * @brief Seal with the next ring entry; config.nonce must be unset
+     */
+    core::CryptoResult encrypt_in_place(
+        std::vector<uint8_t>& buffer,
+        const core::EncryptionConfig& config
+    ) override;
+
+    core::CryptoResult decrypt_in_place(
+        std::vector<uint8_t>& buffer,
+        const core::EncryptionConfig& config
+    ) override;
+
+    core::BatchResult decrypt_batch(
+        std::span<const uint8_t> arena,
+        std::span<const core::BatchRecord> records,
+        const core::EncryptionConfig& config,
+        std::vector<uint8_t>& output
+    ) override;
+
+    bool decrypt_begin(const core::EncryptionConfig& config) override;
+    size_t decrypt_update(std::span<uint8_t> buffer) override;
+    core::CryptoResult decrypt_finish(std::vector<uint8_t>& buffer) override;
+    size_t decrypt_granularity() const override;
+
+    /**
+     * @brief Block until the ring holds an entry (or filling has stopped)
+     *
+     * For benchmarks, to model messages that arrive with idle time
+     * between them.
+     */
+    void wait_ready();
+
+    KeystreamSessionStats stats() const;
+
+private:
+    size_t nonce_size() const;
+    void next_nonce(std::array<uint8_t, 16>& nonce);
+    void fill();
+
+    core::AlgorithmType type_;
+    bool chacha_;
+    KeystreamSessionOptions options_;
+    size_t stride_;                                     // Ring bytes per entry
+    std::unique_ptr<core::ICipherSession> regular_;
+    core::CounterNonce nonces_;
+    std::unique_ptr<Botan::StreamCipher> cipher_;       // Inline messages (caller's thread)
+    std::unique_ptr<Botan::StreamCipher> fill_cipher_;  // Ring entries (filler thread)
+    std::unique_ptr<Botan::MessageAuthenticationCode> poly1305_;
+
+    core::SecureBytes ring_;
+    std::vector<std::array<uint8_t, 16>> ring_nonces_;
+    size_t head_ = 0;
+    size_t count_ = 0;                                  // Includes the entry being consumed
+    bool stopping_ = false;
+    KeystreamSessionStats stats_;
+    mutable std::mutex mutex_;
+    std::condition_variable filled_;
+    std::condition_variable drained_;
+    std::thread filler_;
+};
+
+} // namespace symmetric
+} // namespace algorithms
+} // namespace filevault
+
+#endif // FILEVAULT_ALGORITHMS_SYMMETRIC_KEYSTREAM_SESSION_HPP
@@ -0,0 +1,99 @@
+#ifndef FILEVAULT_ALGORITHMS_SYMMETRIC_OFFLOAD_SESSION_HPP
+#define FILEVAULT_ALGORITHMS_SYMMETRIC_OFFLOAD_SESSION_HPP
+
+#include "filevault/core/crypto_algorithm.hpp"
+#include "filevault/core/offload.hpp"
+#include "filevault/core/secure_arena.hpp"
+#include <memory>
+
+namespace filevault {
+namespace algorithms {
+namespace symmetric {
+
+/**
+ * @brief AES-GCM / ChaCha20-Poly1305 session with the keystream on an offload device
+ *
+ * Large single messages (encrypt_in_place/decrypt_in_place of at least
+ * Offload::min_bytes()) have their keystream XORed on the device while
+ * the CPU computes GHASH or Poly1305, giving the same bytes and tag as
+ * the CPU session. Everything else, including batches, the incremental
+ * API and messages that find the device busy, goes to the wrapped CPU
+ * session. If the device fails, it is disabled and the message is
+ * redone on the CPU.
+ */
+class OffloadSession : public core::ICipherSession {
+public:
+    /**
+     * @brief Wrap cpu if an offload device is active and type can use it
+     * @return cpu itself otherwise
+     */
+    static std::unique_ptr<core::ICipherSession> wrap(
+        core::AlgorithmType type,
+        std::span<const uint8_t> key,
+        size_t nonce_size,
+        size_t tag_size,
+        std::unique_ptr<core::ICipherSession> cpu
+    );
+
+    OffloadSession(
+        core::AlgorithmType type,
+        std::span<const uint8_t> key,
+        size_t tag_size,
+        std::unique_ptr<core::ICipherSession> cpu
+    );
+    ~OffloadSession() override = default;
+
+    core::CryptoResult encrypt_in_place(
+        std::vector<uint8_t>& buffer,
+        const core::EncryptionConfig& config
+    ) override;
+
+    core::CryptoResult decrypt_in_place(
+        std::vector<uint8_t>& buffer,
+        const core::EncryptionConfig& config
+    ) override;
+
+    core::BatchResult encrypt_batch(
+        std::span<const std::span<const uint8_t>> messages,
+        const core::EncryptionConfig& config,
+        std::vector<uint8_t>& arena
+    ) override;
+
+    core::BatchResult decrypt_batch(
+        std::span<const uint8_t> arena,
+        std::span<const core::BatchRecord> records,
+        const core::EncryptionConfig& config,
+        std::vector<uint8_t>& output
+    ) override;
+
+    bool encrypt_begin(const core::EncryptionConfig& config) override;
+    size_t encrypt_update(std::span<uint8_t> buffer) override;
+    core::CryptoResult encrypt_finish(std::vector<uint8_t>& buffer) override;
+    size_t encrypt_granularity() const override;
+
+    bool decrypt_begin(const core::EncryptionConfig& config) override;
+    size_t decrypt_update(std::span<uint8_t> buffer) override;
+    core::CryptoResult decrypt_finish(std::vector<uint8_t>& buffer) override;
+    size_t decrypt_granularity() const override;
+
+private:
+    bool is_gcm() const;
+    bool worth_offloading(size_t size) const;
+    core::OffloadStatus apply_keystream(std::span<const uint8_t> nonce, std::span<uint8_t> data);
+    core::ShortBytes compute_tag(
+        std::span<const uint8_t> nonce,
+        const core::EncryptionConfig& config,
+        std::span<const uint8_t> ciphertext
+    );
+
+    core::AlgorithmType type_;
+    core::SecureBytes key_;
+    size_t tag_size_;
+    std::unique_ptr<core::ICipherSession> cpu_;
+};
+
+} // namespace symmetric
+} // namespace algorithms
+} // namespace filevault
+
+#endif // FILEVAULT_ALGORITHMS_SYMMETRIC_OFFLOAD_SESSION_HPP
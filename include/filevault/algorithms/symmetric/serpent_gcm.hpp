@@ -83,6 +83,11 @@ class Serpent_GCM : public core::ICryptoAlgorithm {
      */
     size_t key_size() const override;
     
+    /**
+     * @brief Bind a key to a reusable Botan mode (see core::ICipherSession)
+     */
+    std::unique_ptr<core::ICipherSession> create_session(std::span<const uint8_t> key) override;
+    
     /**
      * @brief Check if algorithm is suitable for security level
      */
@@ -111,6 +111,11 @@ class Twofish_GCM : public core::ICryptoAlgorithm {
      */
     size_t tag_size() const { return 16; }
     
+    /**
+     * @brief Bind a key to a reusable Botan mode (see core::ICipherSession)
+     */
+    std::unique_ptr<core::ICipherSession> create_session(std::span<const uint8_t> key) override;
+    
     /**
      * @brief Check if algorithm is suitable for security level
      */
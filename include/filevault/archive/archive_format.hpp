@@ -3,24 +3,102 @@
 
 #include <vector>
 #include <string>
+#include <array>
 #include <cstdint>
 #include <span>
 #include <filesystem>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <streambuf>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include "filevault/core/streaming.hpp"
+
+namespace Botan {
+class HashFunction;
+} // namespace Botan
+
+namespace filevault::core {
+class ThreadPool;
+} // namespace filevault::core
 
 namespace filevault::archive {
 
+class MemberFile;
+
+/**
+ * @brief BLAKE2b-256 digest of a member's contents or of an archive index
+ */
+using ContentHash = std::array<uint8_t, 32>;
+
 /**
  * @brief Archive file entry metadata
  */
 struct FileEntry {
     std::string filename;
-    uint64_t file_size;
-    uint64_t offset;           // Offset in data section
-    uint64_t modified_time;    // Unix timestamp
-    uint32_t permissions;      // File permissions
+    uint64_t file_size = 0;
+    uint64_t offset = 0;           // Offset in data section
+    uint64_t modified_time = 0;    // Unix timestamp
+    uint32_t permissions = 0;      // File permissions
+    ContentHash content_hash{};    // All zero when not recorded (version 1)
+    bool in_base = false;          // Unchanged: contents live in the base archive
+    bool shared = false;           // Duplicate: offset points at an earlier member's data
+    bool digest_after = false;     // Hash stored after the segment's data, not in the table
+    
+    /**
+     * @brief Bytes this entry occupies in the data section
+     */
+    uint64_t stored_size() const { return in_base || shared ? 0 : file_size; }
+    
+    bool has_hash() const { return content_hash != ContentHash{}; }
     
+    /**
+     * @brief Serialize in the current (or the given) format version
+     */
     std::vector<uint8_t> serialize() const;
+    std::vector<uint8_t> serialize(uint8_t version) const;
     static FileEntry deserialize(std::span<const uint8_t> data, size_t& offset);
+    static FileEntry deserialize(std::span<const uint8_t> data, size_t& offset, uint8_t version);
+    
+    /**
+     * @brief Size of the fields after the name in a format version
+     */
+    static size_t fixed_size(uint8_t version);
+};
+
+/**
+ * @brief Archive preamble: everything before the first entry
+ */
+struct ArchiveHeader {
+    uint8_t version = 0;
+    uint32_t entry_count = 0;
+    ContentHash base_id{};         // Index of the base archive; all zero for full archives
+    size_t size = 0;               // Preamble bytes
+    
+    bool is_delta() const { return base_id != ContentHash{}; }
+};
+
+/**
+ * @brief A file to archive: where to read it and its entry
+ *
+ * entry.offset is assigned by ArchiveSource from the member order.
+ */
+struct ArchiveMember {
+    std::filesystem::path source;
+    FileEntry entry;
+};
+
+/**
+ * @brief How extracted members are written
+ */
+struct ExtractOptions {
+    size_t threads = 1;          // Workers writing members (1 = inline, 0 = one per core)
+    bool preallocate = false;    // Reserve each file's full size before writing (fallocate)
+    bool verify = false;         // Check members against their recorded content hashes
+    bool check_only = false;     // Parse (and verify) without writing any files
 };
 
 /**
@@ -28,13 +106,38 @@ struct FileEntry {
  * 
  * Format:
  * [Magic: "FVARCH"] [Version: 1 byte] [Entry count: 4 bytes]
+ * [Base index ID: 32 bytes, version 2]
  * [Entry1 metadata] [Entry2 metadata] ...
  * [File1 data] [File2 data] ...
+ *
+ * Version 2 entries add a flags byte and the BLAKE2b-256 of the contents.
+ * A delta archive names its base by the hash of the base's entry table;
+ * its entries flagged in_base have no data here and are copied from the
+ * base on extraction. Version 1 archives are still read.
+ *
+ * Members with identical contents are stored once: later copies are
+ * flagged shared and their offset points back at the first copy's data
+ * in the same segment. Readers predating the flag reject such archives
+ * (the offset is out of order) rather than extract them wrongly.
+ *
+ * The table precedes the data, so a hash only known once the member has
+ * been read cannot go there. Such entries are flagged digest_after, and
+ * their hashes follow the segment's data as 32-byte digests in table
+ * order. Readers predating the flag stop at the unexpected bytes.
+ *
+ * A version 3 archive is a version 2 one padded with zeros to a multiple
+ * of the stream's chunk size, after which another such archive (a
+ * segment) may follow. Appending members therefore only encrypts a new
+ * segment after the existing chunks; readers concatenate the segments'
+ * entries, later names overriding earlier ones.
  */
 class ArchiveFormat {
 public:
     static constexpr char MAGIC[7] = "FVARCH";
-    static constexpr uint8_t VERSION = 1;
+    static constexpr uint8_t VERSION = 2;
+    static constexpr uint8_t MIN_VERSION = 1;
+    static constexpr uint8_t APPENDABLE_VERSION = 3;
+    static constexpr char CONTENT_HASH[] = "BLAKE2b(256)";   // Botan name of member content hashes
     
     /**
      * @brief Create archive from multiple files
@@ -45,10 +148,15 @@ class ArchiveFormat {
     
     /**
      * @brief Extract files from archive
+     *
+     * Directories are created first and timestamps/permissions applied
+     * after every file is written; with options.threads != 1 the files
+     * themselves are written from a worker pool.
      */
     static bool extract_archive(
         std::span<const uint8_t> archive_data,
-        const std::filesystem::path& output_dir
+        const std::filesystem::path& output_dir,
+        const ExtractOptions& options = {}
     );
     
     /**
@@ -58,6 +166,72 @@ class ArchiveFormat {
         std::span<const uint8_t> archive_data
     );
     
+    /**
+     * @brief Metadata entry for a file about to be archived
+     * @param offset Offset of its data in the data section
+     */
+    static FileEntry make_entry(const std::filesystem::path& file, uint64_t offset);
+    
+    /**
+     * @brief Fill an entry's size, modification time and permissions
+     *
+     * One stat call (following symlinks).
+     * @return false if the path is not a readable regular file
+     */
+    static bool stat_entry(const std::filesystem::path& file, FileEntry& entry);
+    
+    /**
+     * @brief Whether a member name stays inside the extraction directory
+     *
+     * Names are relative paths with '/' separators; absolute paths and
+     * ".." components are rejected on extraction.
+     */
+    static bool is_safe_name(const std::string& name);
+    
+    /**
+     * @brief BLAKE2b-256 of a file's contents
+     * @return false if the file cannot be read
+     */
+    static bool hash_file(const std::filesystem::path& file, ContentHash& hash);
+    static ContentHash hash_bytes(std::span<const uint8_t> data);
+    
+    /**
+     * @brief Parse the preamble of an archive
+     * @return false if more bytes are needed or, with error set, if the
+     *         data is not an archive of a supported version
+     */
+    static bool parse_header(std::span<const uint8_t> data, ArchiveHeader& header, std::string& error);
+    
+    /**
+     * @brief Preamble and entry table of an archive (or of one segment)
+     */
+    static std::vector<uint8_t> serialize_table(const std::vector<FileEntry>& entries,
+                                                const ContentHash& base_id = {}, uint8_t version = VERSION);
+    
+    /**
+     * @brief Apply an entry's modification time and permissions to a file
+     */
+    static void restore_metadata(const std::filesystem::path& path, const FileEntry& entry);
+    
+    /**
+     * @brief Deserialize the entries of a table that may not have fully arrived
+     * @param offset Position of the next entry; advanced past parsed ones
+     * @return true once count entries are parsed; false if more bytes are
+     *         needed or, with error set, if the table is malformed
+     */
+    static bool parse_entries(std::span<const uint8_t> table, size_t& offset, const ArchiveHeader& header,
+                              std::vector<FileEntry>& entries, std::string& error);
+    
+    /**
+     * @brief Bytes of the digests following these entries' data
+     */
+    static uint64_t digest_block_size(const std::vector<FileEntry>& entries);
+    
+    /**
+     * @brief Fill the digest_after entries' hashes from a digest block
+     */
+    static void apply_digests(std::span<const uint8_t> block, std::span<FileEntry> entries);
+    
 private:
     static void write_uint32(std::vector<uint8_t>& buffer, uint32_t value);
     static void write_uint64(std::vector<uint8_t>& buffer, uint64_t value);
@@ -66,6 +240,311 @@ class ArchiveFormat {
     static std::string read_string(std::span<const uint8_t> data, size_t& offset);
 };
 
+/**
+ * @brief Archive bytes produced on demand from the member files
+ *
+ * The entry table is built from file metadata when constructed, so the
+ * archive size is known before any data is read; member contents are read
+ * from disk only as the stream is consumed. Memory stays at the entry
+ * table plus one read buffer regardless of archive size, which lets
+ * archives be fed straight into StreamingCrypto. Seeking is supported.
+ *
+ * A member that changed size since construction makes the read fail
+ * (badbit on the istream); error() says which file.
+ *
+ * Members that arrive without a content hash are hashed as their data is
+ * read, so archiving costs one pass over the files; the hashes follow
+ * the data (digest_after) and are in entries() once the stream is read.
+ * A member whose data was not read in order is hashed again on its own.
+ */
+class ArchiveSource : public std::streambuf {
+public:
+    /**
+     * @throws std::runtime_error if a file does not exist or cannot be
+     *         read (members of equal size are hashed up front to find
+     *         duplicates)
+     */
+    explicit ArchiveSource(const std::vector<std::filesystem::path>& files);
+    
+    /**
+     * @brief Archive already-stat'ed members (e.g. from DirectoryWalker)
+     *
+     * Entry names are kept as given; offsets are assigned in order.
+     * Members flagged in_base are listed but not read; base_id then names
+     * the archive holding them (see IncrementalPlanner). A member whose
+     * content hash and size match an earlier one is stored as shared, so
+     * its contents are read, compressed and encrypted only once.
+     */
+    explicit ArchiveSource(std::vector<ArchiveMember> members, const ContentHash& base_id = {});
+    ~ArchiveSource() override;
+    
+    /**
+     * @brief Members that need a hash before construction to be deduplicated
+     *
+     * Identical contents have identical sizes, so only members without a
+     * hash that share their size with another stored member qualify.
+     */
+    static std::vector<size_t> duplicate_candidates(const std::vector<ArchiveMember>& members);
+    
+    /**
+     * @brief Write an appendable (version 3) segment
+     *
+     * Zeros after the data pad the size to a multiple of @p alignment,
+     * the chunk size of the stream it is encrypted into. Call before
+     * reading; index_id() changes with the version byte.
+     */
+    void pad_to(uint64_t alignment);
+    
+    /**
+     * @brief Total archive size in bytes
+     */
+    uint64_t size() const { return table_.size() + data_size_ + digests_size_ + padding_; }
+    
+    const std::vector<FileEntry>& entries() const { return entries_; }
+    const std::vector<std::filesystem::path>& sources() const { return files_; }
+    const std::string& error() const { return error_; }
+    
+    /**
+     * @brief Members stored as shared, and the bytes that saved
+     */
+    size_t shared_count() const { return shared_count_; }
+    uint64_t shared_bytes() const { return shared_bytes_; }
+    
+    /**
+     * @brief ID under which a delta archive can reference this one
+     */
+    ContentHash index_id() const { return ArchiveFormat::hash_bytes(table_); }
+
+protected:
+    int_type underflow() override;
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+
+private:
+    void digest(size_t index, uint64_t within, const char* data, size_t size);
+    void finish_digests();
+    
+    std::vector<std::filesystem::path> files_;
+    std::vector<FileEntry> entries_;
+    std::vector<size_t> stored_;     // Members with data here, in offset order
+    std::vector<uint8_t> table_;     // Magic, version, count and entry table
+    uint64_t data_size_ = 0;
+    size_t shared_count_ = 0;
+    uint64_t shared_bytes_ = 0;
+    uint64_t digests_size_ = 0;      // Hashes of digest_after members, after the data
+    std::vector<uint8_t> digests_;   // Built once the data has been read
+    std::unique_ptr<Botan::HashFunction> hasher_;
+    size_t digesting_ = SIZE_MAX;    // Member hasher_ has consumed a prefix of
+    uint64_t digested_ = 0;          // Length of that prefix
+    uint64_t padding_ = 0;           // Zeros after the digests (pad_to)
+    uint64_t position_ = 0;          // Archive offset of the end of the get area
+    size_t member_ = SIZE_MAX;       // Member open in file_
+    uint64_t member_offset_ = 0;     // Read position within that member
+    std::ifstream file_;
+    std::vector<char> buffer_;
+    std::string error_;
+};
+
+/**
+ * @brief Extracts an archive as its bytes are written, without buffering it
+ *
+ * Counterpart of ArchiveSource: pass it (via std::ostream) as the output
+ * of StreamingCrypto decryption. The entry table is parsed as it arrives,
+ * then each member is written to the output directory in turn. A write
+ * fails (badbit) on malformed data or when a file cannot be created.
+ *
+ * With options.threads != 1, small members are collected in memory and
+ * written by a worker pool (bounded in bytes and files in flight), so
+ * per-file open/close latency overlaps with decryption. Large members are
+ * still streamed by the calling thread. Timestamps and permissions are
+ * applied in one pass by finish().
+ *
+ * Segments of an appendable archive are extracted in turn; header()
+ * is the first segment's. A shared member is copied from the file its
+ * data was extracted to.
+ *
+ * With options.verify, each written member is hashed and compared with
+ * its recorded hash; digest_after members are checked once the digests
+ * following their segment's data arrive.
+ */
+class ArchiveSink : public std::streambuf {
+public:
+    explicit ArchiveSink(std::filesystem::path output_dir, ExtractOptions options = {});
+    ~ArchiveSink() override;
+    
+    /**
+     * @brief Close the last member and check that the archive was complete
+     *
+     * Members stored in a base archive are skipped; the caller copies
+     * them from the base (ArchiveReader) after this returns.
+     */
+    bool finish();
+    
+    /**
+     * @brief Members whose contents were checked against a hash (options.verify)
+     */
+    size_t verified() const { return verified_; }
+    
+    const std::vector<FileEntry>& entries() const { return entries_; }
+    const ArchiveHeader& header() const { return header_; }
+    const std::string& error() const { return error_; }
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* data, std::streamsize count) override;
+
+private:
+    struct PendingWrite {
+        std::future<std::string> error;     // Empty on success
+        size_t bytes;
+    };
+    
+    bool parse_table();
+    bool open_member();
+    bool close_member();
+    bool copy_shared();
+    bool check_digests();
+    bool submit_member();
+    bool wait_oldest();
+    bool wait_all();
+    bool fail(std::string message);
+    
+    std::filesystem::path output_dir_;
+    ExtractOptions options_;
+    std::vector<uint8_t> table_;     // Table bytes received so far
+    size_t table_offset_ = 0;        // Parsed up to here
+    bool table_done_ = false;
+    ArchiveHeader header_;
+    ArchiveHeader segment_;          // Header of the segment being read
+    std::vector<FileEntry> segment_entries_;
+    size_t segments_ = 0;            // Segments whose table is parsed
+    size_t segment_start_ = 0;       // Index in entries_ of the segment's first member
+    std::vector<uint8_t> digests_;   // Digest block of the segment, as it arrives
+    uint64_t digests_left_ = 0;      // Bytes of it still to come
+    std::vector<FileEntry> entries_;
+    std::unordered_map<uint64_t, size_t> stored_at_;   // Segment data offset -> member stored there
+    std::unordered_map<std::string, size_t> written_;  // Name -> last member extracted to it
+    size_t member_ = 0;              // Next or current member
+    uint64_t member_written_ = 0;
+    bool member_open_ = false;
+    bool member_buffered_ = false;   // Collected in buffer_ for the pool
+    std::unique_ptr<Botan::HashFunction> hasher_;   // Contents of the open member (options.verify)
+    std::unordered_map<size_t, ContentHash> computed_;   // Member -> hash awaiting the digest block
+    size_t verified_ = 0;
+    std::unique_ptr<MemberFile> file_;
+    std::vector<uint8_t> buffer_;
+    std::unique_ptr<core::ThreadPool> pool_;
+    std::deque<PendingWrite> pending_;
+    size_t pending_bytes_ = 0;
+    std::unordered_set<std::string> submitted_;   // Names queued since the last drain
+    std::string error_;
+};
+
+/**
+ * @brief Lists and extracts members of an encrypted archive in place
+ *
+ * The entry table leads the archive's plaintext, so it doubles as the
+ * archive's central index: open() decrypts only the chunks that hold it,
+ * and extract() only the chunks a member overlaps. Listing or pulling one
+ * file out of a huge archive therefore costs a few chunks, not a pass
+ * over the whole file.
+ *
+ * The tables of an appendable archive's segments are read in turn, one
+ * range read each; entry offsets are rebased onto data_start(). Hashes
+ * stored after a segment's data (digest_after) are left for
+ * load_digests(), so listing still decrypts only the index chunks.
+ */
+class ArchiveReader {
+public:
+    /**
+     * @brief Open an archive in the streaming format and read its index
+     */
+    core::StreamingResult open(const std::string& archive_path, const std::string& password);
+    
+    const std::vector<FileEntry>& entries() const { return entries_; }
+    const ArchiveHeader& header() const { return header_; }
+    
+    /**
+     * @brief Hash of the entry tables, which delta archives use as base ID
+     *
+     * Appending a segment changes it: deltas made before no longer match.
+     */
+    const ContentHash& index_id() const { return index_id_; }
+    
+    /**
+     * @brief Whether members can be appended (the last segment is padded)
+     */
+    bool appendable() const { return appendable_; }
+    
+    /**
+     * @brief Segments read by open(); 1 for archives never appended to
+     */
+    size_t segments() const { return segments_; }
+    
+    /**
+     * @brief Entry with this name (the last one if repeated), or nullptr
+     */
+    const FileEntry* find(const std::string& filename) const;
+    
+    /**
+     * @brief Read the hashes stored after each segment's data into entries()
+     *
+     * One range read per segment that has them; later calls do nothing.
+     */
+    core::StreamingResult load_digests();
+    
+    /**
+     * @brief Stream chunks [first, last] holding a member's data
+     *
+     * For a shared member, the chunks of the copy it points at.
+     * @return first > last for empty members
+     */
+    std::pair<size_t, size_t> chunk_range(const FileEntry& entry) const;
+    
+    /**
+     * @brief Decrypt one member into output_dir
+     * @param error Set on failure, including for members stored in the base
+     * @param verify Check the contents against the member's content hash
+     *               (loading the digests if it follows the data)
+     */
+    bool extract(const FileEntry& entry, const std::filesystem::path& output_dir, std::string& error,
+                 bool verify = false);
+    
+    /**
+     * @brief Chunks authenticated since open(), index included
+     */
+    size_t chunks_decrypted() const { return stream_.chunks_decrypted(); }
+    
+    /**
+     * @brief The decrypted stream; member data starts at data_start()
+     *
+     * Stays open after a failed open() of a stream that is not an archive.
+     */
+    core::StreamReader& stream() { return stream_; }
+    uint64_t data_start() const { return data_start_; }
+
+private:
+    /**
+     * @brief Hashes following a segment's data, for entries [first, end)
+     */
+    struct DigestBlock {
+        uint64_t offset;
+        uint64_t size;
+        size_t first;
+        size_t end;
+    };
+    
+    core::StreamReader stream_;
+    ArchiveHeader header_;
+    std::vector<FileEntry> entries_;
+    std::vector<DigestBlock> digest_blocks_;   // Not yet read (load_digests)
+    std::unordered_map<std::string, size_t> index_;   // Name -> last entry with it
+    ContentHash index_id_{};
+    uint64_t data_start_ = 0;        // Plaintext offset of the data section
+    size_t segments_ = 0;
+    bool appendable_ = false;
+};
+
 } // namespace filevault::archive
 
 #endif // FILEVAULT_ARCHIVE_FORMAT_HPP
@@ -0,0 +1,90 @@
+#ifndef FILEVAULT_ARCHIVE_ARCHIVE_MOUNT_HPP
+#define FILEVAULT_ARCHIVE_ARCHIVE_MOUNT_HPP
+
+#include "filevault/archive/archive_format.hpp"
+#include "filevault/core/result.hpp"
+#include "filevault/core/stream_cache.hpp"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace filevault::archive {
+
+/**
+ * @brief Directory tree of the files a read-only mount exposes
+ *
+ * Built from archive entries, whose names use '/' separators; a name
+ * given twice resolves to its last entry, as on extraction. Members kept
+ * in a delta archive's base have no data here and are left out.
+ */
+class MountTree {
+public:
+    struct Node {
+        std::string name;
+        bool directory = true;
+        uint64_t data_offset = 0;       // Plaintext offset of the contents
+        uint64_t size = 0;
+        uint64_t modified_time = 0;
+        uint32_t permissions = 0;
+        std::map<std::string, size_t> children;
+    };
+
+    /**
+     * @param data_start Plaintext offset of the archive's data section
+     */
+    static MountTree from_archive(const std::vector<FileEntry>& entries, uint64_t data_start);
+
+    /**
+     * @brief A tree holding one file: the whole decrypted stream
+     */
+    static MountTree single_file(const std::string& name, uint64_t size, uint64_t modified_time);
+
+    /**
+     * @brief Node at an absolute path ("/", "/dir/file"), or nullptr
+     */
+    const Node* lookup(const std::string& path) const;
+
+    const Node& root() const { return nodes_.front(); }
+    const Node& node(size_t index) const { return nodes_[index]; }
+    size_t file_count() const { return files_; }
+    size_t skipped() const { return skipped_; }
+
+private:
+    MountTree();
+    size_t child(size_t parent, const std::string& name, bool directory);
+
+    std::vector<Node> nodes_;
+    size_t files_ = 0;
+    size_t skipped_ = 0;
+};
+
+/**
+ * @brief Read-only mount settings
+ */
+struct MountOptions {
+    size_t cache_chunks = core::CachedStreamReader::DEFAULT_CACHE_CHUNKS;
+    size_t readahead_chunks = core::CachedStreamReader::DEFAULT_READAHEAD_CHUNKS;
+    bool allow_other = false;           // Let other users see the mount
+};
+
+/**
+ * @brief Whether this build can mount (built with ENABLE_FUSE)
+ */
+bool fuse_available();
+
+/**
+ * @brief Serve a tree read-only through FUSE until unmounted
+ *
+ * File contents are decrypted (and decompressed) a chunk at a time as
+ * they are read, through a CachedStreamReader over reader. Blocks in
+ * the foreground; unmount with `fusermount3 -u <mountpoint>`.
+ *
+ * @param stats Cache counters at unmount, if not null
+ */
+core::Result<void> mount_read_only(const MountTree& tree, core::StreamReader& reader,
+                                   const std::string& mountpoint, const MountOptions& options,
+                                   core::StreamCacheStats* stats = nullptr);
+
+} // namespace filevault::archive
+
+#endif // FILEVAULT_ARCHIVE_ARCHIVE_MOUNT_HPP
@@ -0,0 +1,80 @@
+#ifndef FILEVAULT_ARCHIVE_DIRECTORY_WALKER_HPP
+#define FILEVAULT_ARCHIVE_DIRECTORY_WALKER_HPP
+
+#include "filevault/archive/archive_format.hpp"
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace filevault::archive {
+
+/**
+ * @brief Which files a walk collects
+ *
+ * Globs support '*' and '?' (not crossing '/'), '**' (any depth) and
+ * [a-z] / [!x] classes. A glob without '/' is matched against the file
+ * or directory name, one with '/' against the whole member name.
+ */
+struct WalkOptions {
+    std::vector<std::string> include;   // A file must match one (empty = all files)
+    std::vector<std::string> exclude;   // Skips matching files and whole directories
+    size_t threads = 0;                 // Directories listed in parallel (0 = one per core)
+};
+
+/**
+ * @brief Files found by a walk, ready for ArchiveSource
+ */
+struct WalkResult {
+    std::vector<ArchiveMember> members;   // Sorted by member name
+    std::vector<std::string> errors;      // Unreadable paths, skipped
+};
+
+/**
+ * @brief Files named by command-line inputs
+ */
+struct InputExpansion {
+    std::vector<std::string> files;       // Input order, each directory sorted
+    std::vector<std::string> missing;     // "<input>: ..." for inputs that matched nothing
+    std::vector<std::string> errors;      // Unreadable paths, skipped
+};
+
+/**
+ * @brief Expands archive inputs into members with relative names
+ *
+ * A file argument becomes a member named after the file; a directory
+ * argument "dir" contributes "dir/sub/file" for everything under it (the
+ * contents only for "." or ".."). Each directory level is listed on a
+ * thread pool and every file is stat'ed exactly once, so the entry table
+ * of a large tree is ready long before a serial walk would be.
+ * Symlinks to files are followed; symlinks to directories are not.
+ */
+class DirectoryWalker {
+public:
+    static WalkResult walk(const std::vector<std::filesystem::path>& inputs,
+                           const WalkOptions& options = {});
+
+    /**
+     * @brief Match a whole name against one glob
+     */
+    static bool glob_match(std::string_view pattern, std::string_view name);
+
+    /**
+     * @brief Whether any glob matches a member name (see WalkOptions)
+     */
+    static bool matches_any(const std::vector<std::string>& globs, std::string_view name);
+
+    /**
+     * @brief Expand files, directories (recursively) and quoted globs
+     *        the shell did not expand into file paths
+     *
+     * A glob is matched from its last plain directory, so a pattern in
+     * keys/ walks keys/ only. Used by the commands that take many inputs.
+     */
+    static InputExpansion expand_inputs(const std::vector<std::string>& inputs,
+                                        const WalkOptions& options = {});
+};
+
+} // namespace filevault::archive
+
+#endif // FILEVAULT_ARCHIVE_DIRECTORY_WALKER_HPP
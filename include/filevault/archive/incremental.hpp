@@ -0,0 +1,82 @@
+#ifndef FILEVAULT_ARCHIVE_INCREMENTAL_HPP
+#define FILEVAULT_ARCHIVE_INCREMENTAL_HPP
+
+#include "filevault/archive/archive_format.hpp"
+#include "filevault/utils/hash_cache.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace filevault::archive {
+
+/**
+ * @brief What a comparison against a base archive found
+ */
+struct DeltaSummary {
+    size_t unchanged = 0;       // Left in the base
+    size_t modified = 0;
+    size_t added = 0;
+    size_t removed = 0;         // In the base only; absent from the delta
+    uint64_t packed_bytes = 0;  // Member data the delta has to carry
+    std::vector<std::string> errors;   // Files that could not be hashed
+};
+
+/**
+ * @brief Decides which members a delta archive has to carry
+ *
+ * Delta archives are differential: they always reference a full archive,
+ * and their entry table is a complete snapshot, so extracting one needs
+ * only the delta and that base. A member keeps its data in the base
+ * when its size and mtime match the base entry, or when only the mtime
+ * changed and the contents still hash the same. Everything else is
+ * packed, so nightly work scales with what changed rather than with the
+ * size of the tree.
+ *
+ * With a utils::HashCache, content hashes of files whose identity is
+ * unchanged are taken from the cache, and an XXH3-128 checksum is kept
+ * next to each one. A file that was touched but kept its size is then
+ * checksummed at memory speed; if that matches, its old BLAKE2b is
+ * reused. The labels are those of 'filevault hash -a blake2b-256
+ * --prefilter xxh3-128', so the two commands share entries.
+ */
+class IncrementalPlanner {
+public:
+    /**
+     * @brief Record every member's content hash (files read in parallel)
+     * @param threads 0 = one per core
+     * @param cache Optional digest cache, consulted and updated
+     * @return Files that could not be read
+     */
+    static std::vector<std::string> hash_members(std::vector<ArchiveMember>& members, size_t threads = 0,
+                                                 utils::HashCache* cache = nullptr);
+
+    /**
+     * @brief Record only the hashes deduplication needs before archiving
+     *
+     * Members the cache has a current hash for take it; of the rest, only
+     * ArchiveSource::duplicate_candidates() are read. ArchiveSource hashes
+     * everything else as it archives it, so most files are read once.
+     * @return Files that could not be read
+     */
+    static std::vector<std::string> hash_candidates(std::vector<ArchiveMember>& members, size_t threads = 0,
+                                                    utils::HashCache* cache = nullptr);
+
+    /**
+     * @brief Store the hashes an archived source computed in the cache
+     */
+    static void remember(const ArchiveSource& source, utils::HashCache& cache);
+
+    /**
+     * @brief Mark members unchanged since the base as in_base
+     *
+     * Mtime-only candidates are hashed; unchanged members take the
+     * base's hash. Added and modified members are left to
+     * hash_candidates().
+     */
+    static DeltaSummary plan(std::vector<ArchiveMember>& members, const std::vector<FileEntry>& base,
+                             size_t threads = 0, utils::HashCache* cache = nullptr);
+};
+
+} // namespace filevault::archive
+
+#endif // FILEVAULT_ARCHIVE_INCREMENTAL_HPP
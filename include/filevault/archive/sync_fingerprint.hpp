@@ -0,0 +1,57 @@
+#ifndef FILEVAULT_ARCHIVE_SYNC_FINGERPRINT_HPP
+#define FILEVAULT_ARCHIVE_SYNC_FINGERPRINT_HPP
+
+#include "filevault/core/tree_runner.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace filevault::archive {
+
+/**
+ * @brief Source fingerprints kept in FVAULT02 headers for incremental sync
+ *
+ * A fingerprint is the source size and mtime (8 bytes each,
+ * little-endian), then for password trees a 16-byte HMAC of the
+ * contents' BLAKE2b-256. Headers are readable without a key, so a plain
+ * hash would let anyone confirm that an output holds some known file;
+ * the HMAC key is derived from the password key instead.
+ *
+ * Written by 'encrypt -r --sync' and 'watch', so either one picks up
+ * where the other left off.
+ */
+class SyncFingerprint {
+public:
+    static constexpr size_t META_SIZE = 16;
+    static constexpr size_t DIGEST_SIZE = 16;
+
+    /**
+     * @brief Digest key of a password tree, from its derived password key
+     */
+    static std::vector<uint8_t> derive_key(std::span<const uint8_t> password_key);
+
+    /**
+     * @brief Fingerprint of a source from its size and modified_time
+     * @param key Digest key, or empty for size and mtime only
+     * @return nullopt if the contents could not be read
+     */
+    static std::optional<std::vector<uint8_t>> make(const core::TreeFile& file, std::span<const uint8_t> key);
+
+    /**
+     * @brief True if the target's header says its source has not changed
+     *
+     * Matching size and mtime are enough. A source that kept its size but
+     * was touched is hashed when the target carries a digest made with
+     * the same key (same tree batch salt), and counts as unchanged if it
+     * matches.
+     * @param salt The tree's batch salt
+     */
+    static bool is_current(const core::TreeFile& file, const std::vector<uint8_t>& salt,
+                           std::span<const uint8_t> key);
+};
+
+} // namespace filevault::archive
+
+#endif // FILEVAULT_ARCHIVE_SYNC_FINGERPRINT_HPP
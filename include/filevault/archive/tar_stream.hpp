@@ -0,0 +1,145 @@
+#ifndef FILEVAULT_ARCHIVE_TAR_STREAM_HPP
+#define FILEVAULT_ARCHIVE_TAR_STREAM_HPP
+
+#include "filevault/archive/archive_format.hpp"
+#include <istream>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace filevault::archive {
+
+/**
+ * @brief Archive bytes translated on the fly from a tar stream
+ *
+ * The counterpart of ArchiveSource for input that is already a tar
+ * (ustar, pax or GNU), read once from a pipe. An archive's entry table
+ * must precede its data, but a tar announces each member only right
+ * before its contents, so members are gathered into batches of up to
+ * batch_bytes and each batch becomes one appendable segment (version 3,
+ * padded to the chunk size of the stream it is encrypted into). A member
+ * that does not fit a batch gets a segment of its own and is streamed
+ * through without being held in memory; its content hash is computed on
+ * the way and follows its contents (digest_after).
+ *
+ * Regular files become members; directories are implied by the names.
+ * A hard link to a file in the same batch becomes a shared member of it;
+ * other links, devices and FIFOs are skipped (see skipped()). The total
+ * size is unknown until the tar ends, so the stream is encrypted as one
+ * of unknown length. Seeking is not supported. A malformed tar makes the
+ * read fail (badbit on the istream); error() says why.
+ */
+class TarSource : public std::streambuf {
+public:
+    static constexpr size_t DEFAULT_BATCH_BYTES = 64 * 1024 * 1024;
+
+    /**
+     * @param alignment Chunk size of the stream the archive goes into
+     */
+    TarSource(std::istream& tar, uint64_t alignment, size_t batch_bytes = DEFAULT_BATCH_BYTES);
+    ~TarSource() override;
+
+    size_t member_count() const { return member_count_; }
+    uint64_t member_bytes() const { return member_bytes_; }
+    size_t segments() const { return segments_; }
+    const std::vector<std::string>& skipped() const { return skipped_; }
+    const std::string& error() const { return error_; }
+
+protected:
+    int_type underflow() override;
+
+private:
+    /**
+     * @brief A regular file whose header is read but not its contents
+     */
+    struct PendingMember {
+        FileEntry entry;
+        uint64_t padding = 0;        // Zeros after the contents up to a 512-byte block
+        std::string link;            // Hard link target; no contents of its own
+    };
+
+    bool next_member();
+    bool next_segment();
+    void read_exact(char* data, size_t size, const char* what);
+    void skip(uint64_t size);
+    [[noreturn]] void fail(const std::string& message);
+
+    std::istream& tar_;
+    uint64_t alignment_;
+    size_t batch_bytes_;
+    std::optional<PendingMember> pending_;
+    bool tar_done_ = false;
+    std::vector<uint8_t> table_;     // Entry table of the current segment
+    std::vector<char> batch_;        // Its batched contents
+    size_t served_ = 0;              // Bytes of table_ and batch_ handed out
+    uint64_t stream_left_ = 0;       // Contents of a streamed member still to pass through
+    uint64_t stream_padding_ = 0;    // Its tar padding, skipped afterwards
+    std::unique_ptr<Botan::HashFunction> hasher_;   // Its contents so far
+    std::vector<uint8_t> digest_;    // Its hash, served after the contents
+    uint64_t padding_left_ = 0;      // Zeros closing the segment
+    uint64_t produced_ = 0;          // Archive bytes so far, for the padding
+    size_t segments_ = 0;
+    size_t member_count_ = 0;
+    uint64_t member_bytes_ = 0;
+    std::vector<char> buffer_;
+    std::vector<std::string> skipped_;
+    std::string error_;
+};
+
+/**
+ * @brief Writes an archive out as a tar stream while its bytes arrive
+ *
+ * The counterpart of ArchiveSink: pass it (via std::ostream) as the
+ * output of StreamingCrypto decryption and each member becomes a ustar
+ * entry, with pax headers for names longer than ustar holds; shared
+ * members become hard links to their stored copy. Segments of
+ * appendable archives are exported in turn, so a replaced member appears
+ * twice and, as with tar itself, the later copy wins on extraction.
+ * Delta archives are refused: their unchanged members are in the base.
+ */
+class TarSink : public std::streambuf {
+public:
+    explicit TarSink(std::ostream& tar);
+
+    /**
+     * @brief Check that the archive was complete and write the end-of-archive blocks
+     */
+    bool finish();
+
+    const std::vector<FileEntry>& entries() const { return entries_; }
+    const std::string& error() const { return error_; }
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* data, std::streamsize count) override;
+
+private:
+    bool parse_table();
+    bool begin_member();
+    bool end_member();
+    bool fail(std::string message);
+
+    std::ostream& tar_;
+    std::vector<uint8_t> table_;     // Table bytes received so far
+    size_t table_offset_ = 0;
+    bool table_done_ = false;
+    ArchiveHeader segment_;
+    std::vector<FileEntry> segment_entries_;
+    std::vector<FileEntry> entries_;  // Every segment's, in order
+    size_t segment_start_ = 0;       // Index in entries_ of the segment's first member
+    std::unordered_map<uint64_t, size_t> stored_at_;   // Segment data offset -> member stored there
+    std::unordered_map<std::string, size_t> written_;  // Name -> last member written under it
+    size_t member_ = 0;              // Next or current member of the segment
+    uint64_t member_written_ = 0;
+    bool member_open_ = false;
+    uint64_t digests_left_ = 0;      // Hashes after the segment's data, skipped
+    std::string error_;
+};
+
+} // namespace filevault::archive
+
+#endif // FILEVAULT_ARCHIVE_TAR_STREAM_HPP
@@ -1,7 +1,11 @@
 #ifndef FILEVAULT_CLI_APP_HPP
 #define FILEVAULT_CLI_APP_HPP
 
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 #include <CLI/CLI.hpp>
 #include "command.hpp"
@@ -19,7 +23,9 @@ class Application {
     ~Application();
     
     /**
-     * @brief Initialize application and register commands
+     * @brief Initialize logging, configuration and global options
+     *
+     * Commands are registered by run() once argv is known.
      */
     void initialize();
     
@@ -27,17 +33,69 @@ class Application {
      * @brief Run application with command line arguments
      */
     int run(int argc, char** argv);
+    
+    /**
+     * @brief Run one command line (without the program name) in this process
+     *
+     * Used by 'serve': the command gets a fresh parser but shares the
+     * engine, key cache and loaded state of earlier runs. Global options
+     * are not accepted, and 'serve' itself cannot be nested.
+     * @return The exit code the command would have returned from main()
+     */
+    int run_command(const std::vector<std::string>& args);
 
 private:
-    void register_commands();
+    using CommandFactory = std::function<std::unique_ptr<ICommand>()>;
+    
+    std::vector<std::pair<std::string, CommandFactory>> command_factories();
+    
+    /**
+     * @brief Register commands; only the selected one if a name is given
+     *
+     * Help and unknown command names need the full set so CLI11 can list
+     * them, so an empty name registers everything.
+     */
+    void register_commands(const std::string& selected);
     void setup_logging();
     
+    /**
+     * @brief Engine shared by the commands, created on first request
+     */
+    core::CryptoEngine& engine();
+    
+    /**
+     * @brief Record the time since the previous phase for --profile-startup
+     */
+    void mark_phase(const std::string& phase);
+    void print_startup_profile() const;
+    
+    /**
+     * @brief Print the --stats json line for the finished command
+     */
+    void print_run_stats(int exit_code) const;
+    
+    /**
+     * @brief Stop tracing and write --trace output, if requested
+     */
+    void write_trace() const;
+    
     CLI::App app_;
     std::unique_ptr<core::CryptoEngine> engine_;
     std::vector<std::unique_ptr<ICommand>> commands_;
     
+    // Startup profiling
+    std::chrono::steady_clock::time_point phase_start_;
+    std::vector<std::pair<std::string, double>> phases_;
+    
     // Global options
     bool verbose_ = false;
+    bool profile_startup_ = false;
+    std::string trace_file_;
+    std::string stats_format_;
+    bool numa_ = false;
+    bool background_ = false;
+    std::string command_name_;
+    std::chrono::steady_clock::time_point run_start_;
     std::string log_level_ = "info";
 };
 
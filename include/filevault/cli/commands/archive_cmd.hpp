@@ -6,12 +6,21 @@
 #include <string>
 #include <vector>
 
+namespace filevault::archive {
+class ArchiveReader;
+struct FileEntry;
+} // namespace filevault::archive
+
 namespace filevault::cli::commands {
 
 /**
  * @brief Archive command - compress and encrypt multiple files
  * 
- * Creates an archive from multiple files, compresses it, then encrypts.
+ * Creates an archive from multiple files and encrypts it as a streaming
+ * (FVST) file, compressing chunk by chunk. Member data is read as it is
+ * encrypted, so memory use does not depend on the archive size. Chunks
+ * (a run of small members, or a slice of a large one) are sealed
+ * independently on a thread pool and written in order.
  * Format: [metadata][file1_data][file2_data]...
  */
 class ArchiveCommand : public cli::ICommand {
@@ -30,21 +39,60 @@ class ArchiveCommand : public cli::ICommand {
     
 private:
     int do_create();
+    int do_create_from_tar();
+    int do_append();
     int do_extract();
+    int do_extract_streaming(const std::string& archive_file);
+    int do_export_tar(const std::string& archive_file);
+    int extract_members(const std::string& archive_file);
+    int do_verify();
+    int do_list();
+    
+    /**
+     * @brief Decrypt and decompress an archive in the pre-streaming format
+     */
+    int decrypt_legacy(const std::string& archive_file, std::vector<uint8_t>& archive_data);
+    
+    /**
+     * @brief Open base_archive_'s index; it must be a full archive
+     */
+    int open_base(archive::ArchiveReader& base);
+    
+    /**
+     * @brief Copy a delta's unchanged members out of its base
+     */
+    int extract_from_base(archive::ArchiveReader& base, const std::vector<const archive::FileEntry*>& entries);
     
     core::CryptoEngine& engine_;
     
     // Options
     std::vector<std::string> input_files_;
+    std::vector<std::string> include_;   // Globs for archive create
+    std::vector<std::string> exclude_;
+    std::string base_archive_;           // Full archive a delta is made against / restored from
+    std::string from_tar_;               // Tar stream to archive instead of files ("-" = stdin)
+    std::string to_tar_;                 // Extract as a tar stream instead ("-" = stdout)
     std::string output_file_;
     std::string password_;
     std::string algorithm_ = "aes-256-gcm";
     std::string compression_ = "zlib";
+    double compression_target_mbps_ = 0;    // Throughput floor for "-c auto" (0 = from the profile)
     std::string kdf_ = "argon2id";
+    uint32_t kdf_parallelism_ = 0;  // 0 = security level default
     std::string security_level_ = "medium";
+    size_t threads_ = 0;            // Chunk worker threads (0 = all cores)
+    bool cache_ = false;            // Content hashes through the hash cache
+    bool appendable_ = false;       // Pad so that "archive append" can add members
+    bool append_ = false;
     bool extract_ = false;
+    bool list_ = false;
     bool verbose_ = false;
+    std::string list_format_ = "auto";   // auto, table, tsv, jsonl
+    bool preallocate_ = false;      // fallocate extracted files up front
+    bool verify_ = false;           // Check extracted members against their content hashes
+    bool verify_only_ = false;      // "archive verify": check without extracting
     std::string extract_dir_ = ".";
+    std::vector<std::string> members_;   // Extract only these (streaming archives)
 };
 
 } // namespace filevault::cli::commands
@@ -2,19 +2,26 @@
 #define FILEVAULT_CLI_COMMANDS_BENCHMARK_CMD_HPP
 
 #include "filevault/cli/command.hpp"
+#include "filevault/algorithms/asymmetric/ecc.hpp"
 #include "filevault/core/crypto_engine.hpp"
+#include "filevault/core/streaming.hpp"
+#include "filevault/utils/bench_stats.hpp"
 #include <nlohmann/json.hpp>
 #include <botan/hash.h>
+#include <optional>
+#include <vector>
 
 namespace filevault {
 namespace cli {
 
 struct BenchmarkResult {
     std::string algorithm;
-    double encrypt_ms = 0;
+    double encrypt_ms = 0;      // Median
     double decrypt_ms = 0;
     double encrypt_mbps = 0;
     double decrypt_mbps = 0;
+    utils::SampleStats encrypt_stats;
+    utils::SampleStats decrypt_stats;
     bool success = false;
 };
 
@@ -39,7 +46,54 @@ struct SignatureBenchmarkResult {
     double keygen_ms = 0;
     double sign_ms = 0;
     double verify_ms = 0;
+    double batch_verify_ms = 0;   // Per signature, on all cores; 0 = no batch API
+    bool success = false;
+};
+
+struct ThroughputBenchmarkResult {
+    std::string algorithm;
+    std::string operation;
+    size_t threads = 1;
+    double ops_per_sec = 0;
+    double p50_us = 0;
+    double p99_us = 0;
+    double scaling = 1.0;   // ops_per_sec relative to the first thread count
+};
+
+struct ScalingBenchmarkResult {
+    std::string algorithm;
+    std::string category;       // "symmetric", "kdf" or "compression"
+    size_t threads = 1;
+    size_t operations = 0;      // Completed across all threads
+    double seconds = 0;
+    double ops_per_sec = 0;
+    double mbps = 0;            // Aggregate; 0 for KDFs
+    double efficiency = 1.0;    // Per-thread rate relative to the first thread count
+};
+
+struct E2EBenchmarkResult {
+    std::string pipeline;
+    bool cold_cache = false;
+    double total_ms = 0;        // Including fsync
+    double fsync_ms = 0;
+    std::optional<core::StageTimes> stages;  // Direct StreamingCrypto runs only
+    size_t peak_rss = 0;        // Bytes
+    double mbps = 0;
+    bool success = false;
+    std::string error_message;
+};
+
+struct StreamingSweepResult {
+    size_t chunk_size = 0;
+    size_t workers = 1;
+    size_t depth = 0;           // StreamingConfig::io_buffers
+    double encrypt_mbps = 0;    // KDF excluded
+    double decrypt_mbps = 0;
+    double round_trip_mbps = 0; // Input bytes over encrypt + decrypt time, twice
+    double first_byte_ms = 0;   // Encrypt call to first chunk written, KDF excluded
+    size_t peak_rss = 0;        // Bytes
     bool success = false;
+    std::string error_message;
 };
 
 class BenchmarkCommand : public ICommand {
@@ -60,6 +114,12 @@ class BenchmarkCommand : public ICommand {
     void benchmark_kdf(nlohmann::json& json_results);
     void benchmark_compression(nlohmann::json& json_results);
     void benchmark_hash(nlohmann::json& json_results);
+    void benchmark_pqc_throughput(nlohmann::json& json_results);
+    void benchmark_scaling(nlohmann::json& json_results);
+    void benchmark_sweep(nlohmann::json& json_results);
+    void benchmark_e2e(nlohmann::json& json_results);
+    void benchmark_streaming(nlohmann::json& json_results);
+    void benchmark_offload(nlohmann::json& json_results);
     
     // Algorithm-specific benchmarks
     BenchmarkResult benchmark_algorithm(core::AlgorithmType algo_type);
@@ -67,8 +127,15 @@ class BenchmarkCommand : public ICommand {
     PQCBenchmarkResult benchmark_pqc_algorithm(core::AlgorithmType algo_type);
     BenchmarkResult benchmark_hybrid_algorithm(core::AlgorithmType algo_type);
     SignatureBenchmarkResult benchmark_signature_algorithm(core::AlgorithmType algo_type);
+    SignatureBenchmarkResult benchmark_ecc_signature(algorithms::asymmetric::ECCurve curve);
     
     // Helpers
+    utils::SamplingPolicy sampling_policy() const;
+    std::vector<size_t> scaling_thread_counts() const;
+    bool load_file_data();
+    void recommend_compression(nlohmann::json& json_results);
+    size_t compare_baseline(const nlohmann::json& baseline, nlohmann::json& json_results);
+    void print_sample_stats(const std::vector<std::pair<std::string, utils::SampleStats>>& rows);
     std::string get_platform_info();
     void save_json_output(const nlohmann::json& results);
     void save_log_output(const std::string& log_content);
@@ -77,7 +144,15 @@ class BenchmarkCommand : public ICommand {
     std::string algorithm_;
     std::string output_file_;
     size_t data_size_ = 1048576;  // 1MB default
-    int iterations_ = 5;
+    int iterations_ = 5;            // Minimum timed samples per measurement
+    size_t warmup_ = 3;
+    size_t max_iterations_ = 200;
+    double target_ci_ = 2.0;        // Stop once the 95% interval is within +/- this percent
+    double max_time_ = 1.0;         // Seconds of timed work per measurement
+    bool show_stats_ = false;
+    bool counters_ = false;
+    bool energy_ = false;
+    std::string huge_pages_;        // "on"/"off" overrides memory.huge_pages
     bool all_ = false;
     bool json_output_ = false;
     bool pqc_only_ = false;
@@ -86,6 +161,26 @@ class BenchmarkCommand : public ICommand {
     bool hash_only_ = false;
     bool kdf_only_ = false;
     bool compression_only_ = false;
+    bool pqc_throughput_ = false;
+    size_t throughput_ops_ = 2000;
+    std::vector<size_t> thread_counts_;
+    bool pin_threads_ = false;
+    bool sweep_ = false;
+    size_t sweep_max_ = size_t(1) << 30;  // Largest message in the --sweep series
+    bool e2e_ = false;
+    std::string e2e_file_;                  // Existing input instead of a generated one
+    size_t e2e_size_ = size_t(64) << 20;
+    int entropy_bits_ = 4;                  // Per byte of the generated input (0-8)
+    int e2e_runs_ = 3;                      // Warm-cache runs after the cold one
+    bool streaming_ = false;
+    std::vector<size_t> chunk_sizes_;       // --streaming grid (empty = 64 KB, 256 KB, ... 256 MB)
+    std::vector<size_t> pipeline_depths_;   // --streaming grid (empty = 0, 2, 8)
+    bool offload_ = false;
+    std::string baseline_file_;
+    std::string file_;                      // --file: real data for the throughput suites
+    size_t sample_size_ = size_t(256) << 20;
+    std::vector<uint8_t> file_data_;        // All of file_, or evenly spaced windows of it
+    double regression_threshold_ = 5.0;     // Percent slower that fails --baseline
 };
 
 } // namespace cli
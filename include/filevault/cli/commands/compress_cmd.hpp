@@ -1,6 +1,7 @@
 #ifndef FILEVAULT_CLI_COMMANDS_COMPRESS_CMD_HPP
 #define FILEVAULT_CLI_COMMANDS_COMPRESS_CMD_HPP
 
+#include <cstdint>
 #include <string>
 #include "filevault/cli/command.hpp"
 
@@ -34,10 +35,13 @@ class CompressCommand : public ICommand {
     // Compression options
     std::string algorithm_ = "zlib";     // zlib, bzip2, lzma
     int level_ = 6;                       // 1-9
+    size_t threads_ = 0;                  // Compression threads (0 = all cores)
     bool decompress_ = false;             // Decompress mode
     bool verbose_ = false;
     bool benchmark_ = false;              // Show timing info
     bool auto_detect_ = false;            // Auto-detect algorithm
+    bool seekable_ = false;               // Independent frames plus a seek table
+    uint64_t frame_size_ = 4 * 1024 * 1024;   // Uncompressed bytes per seekable frame
     
     // Helper methods
     int do_compress();
@@ -24,6 +24,9 @@ class ConfigCommand : public ICommand {
     int show_config();
     int set_value();
     int reset_config();
+    int list_profiles();
+    int show_profile();
+    int use_profile();
     
     std::string subcommand_;
     std::string key_;
@@ -2,6 +2,8 @@
 #define FILEVAULT_CLI_COMMANDS_DECOMPRESS_CMD_HPP
 
 #include "filevault/cli/command.hpp"
+#include <cstdint>
+#include <string>
 
 namespace filevault::cli {
 
@@ -19,6 +21,7 @@ class DecompressCommand : public ICommand {
     int execute() override;
 
 private:
+    bool parse_range(uint64_t& offset, uint64_t& length) const;
     std::string detect_algorithm(const std::string& path);
     std::string generate_output_path(const std::string& input);
     
@@ -26,6 +29,8 @@ class DecompressCommand : public ICommand {
     std::string input_file_;
     std::string output_file_;
     std::string algorithm_;
+    std::string range_;                   // OFFSET:LENGTH of the original data (seekable files)
+    size_t threads_ = 0;                  // Decompression threads (0 = all cores)
     bool auto_detect_ = true;  // Auto-detect by default for decompress
     bool verbose_ = false;
     bool benchmark_ = false;
@@ -3,6 +3,9 @@
 
 #include "filevault/cli/command.hpp"
 #include "filevault/core/crypto_engine.hpp"
+#include "filevault/core/streaming.hpp"
+#include <optional>
+#include <span>
 
 namespace filevault {
 namespace cli {
@@ -18,10 +21,75 @@ class DecryptCommand : public ICommand {
     int execute() override;
 
 private:
+    /**
+     * @brief Decrypt a chunked (FVAULT02 or FVST) file, handling "-" for stdin/stdout
+     *
+     * With --private-key the input is an envelope (public-key) file.
+     */
+    int execute_streaming();
+    
+    /**
+     * @brief Decrypt every .fvlt file under a directory into a mirrored tree (-r)
+     *
+     * Chunked files only, several at once; files sharing a salt (as
+     * 'encrypt -r' writes them) derive the key once.
+     */
+    int execute_recursive();
+    
+    /**
+     * @brief Authenticate the input file, or every .fvlt file under it with
+     *        -r, without writing anything (--verify-only)
+     *
+     * Files run on TreeRunner's pool and large chunked files on every
+     * worker; plaintext goes to a NullOutput. Files sharing a salt derive
+     * the key once. Prints a pass/fail report with throughput.
+     */
+    int execute_verify();
+    
+    /**
+     * @brief Check the tag of a single-tag payload (FVAULT01, FVLT) file
+     * @param plain_bytes Receives the payload size
+     * @return Error message, empty if the file authenticates
+     */
+    std::string verify_payload(const std::string& path, uint64_t& plain_bytes) const;
+    
+    /**
+     * @brief Decrypt a single-tag payload (FVAULT01, FVLT) piece by piece
+     * @return Exit code, or nullopt to fall back to decrypting in memory
+     *         (cipher without incremental decryption, or a payload the
+     *         streaming decompressor rejected)
+     *
+     * Plaintext goes to a temp file beside the output, renamed into place
+     * only once the tag has been verified, so memory stays flat for any
+     * file size and a tampered file never leaves partial output.
+     */
+    std::optional<int> decrypt_incremental(
+        core::ICryptoAlgorithm& algorithm,
+        std::span<const uint8_t> key,
+        const core::EncryptionConfig& config,
+        std::span<const uint8_t> ciphertext,
+        bool compressed,
+        uint32_t dictionary_id,
+        std::optional<uint64_t> original_size
+    );
+    
+    /**
+     * @brief Print the outcome of a streaming decryption; returns the exit code
+     */
+    int report_streaming(const core::StreamingResult& result);
+    
     core::CryptoEngine& engine_;
     std::string input_file_;
     std::string output_file_;
     std::string password_;
+    std::string private_key_path_;  // Envelope files: recipient's private key
+    size_t checkpoint_interval_ = 16;  // Chunks between checkpoints (0 = none)
+    bool resume_ = false;
+    bool direct_io_ = false;        // Keep input and output out of the page cache
+    bool recursive_ = false;        // Input is a directory, output a directory
+    bool verify_only_ = false;      // Authenticate only; write no output
+    size_t threads_ = 0;            // Files (or chunks of a large file) at once with -r (0 = one per core)
+    uint64_t kdf_memory_ = 1024ull * 1024 * 1024;  // Key derivation memory in use at once with -r
     bool verbose_ = false;
     bool no_progress_ = false;
 };
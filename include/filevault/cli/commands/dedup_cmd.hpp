@@ -0,0 +1,58 @@
+#ifndef FILEVAULT_CLI_COMMANDS_DEDUP_CMD_HPP
+#define FILEVAULT_CLI_COMMANDS_DEDUP_CMD_HPP
+
+#include "filevault/cli/command.hpp"
+#include <cstdint>
+#include <string>
+
+namespace filevault {
+namespace cli {
+
+/**
+ * @brief Dedup command - deduplicated encrypted backups
+ *
+ * Backups go into a chunk store: files are split into content-defined
+ * chunks and only chunks the store has not seen are encrypted and
+ * written. Each backup produces a small manifest that lists its chunks.
+ *
+ * Examples:
+ *   filevault dedup init ~/backups/store
+ *   filevault dedup backup disk.img --store ~/backups/store -o disk-mon.fvdm
+ *   filevault dedup restore disk-mon.fvdm --store ~/backups/store -o disk.img
+ */
+class DedupCommand : public ICommand {
+public:
+    DedupCommand() = default;
+    
+    std::string name() const override { return "dedup"; }
+    std::string description() const override { return "Deduplicated encrypted backups in a chunk store"; }
+    
+    void setup(CLI::App& app) override;
+    int execute() override;
+
+private:
+    void run();
+    int init();
+    int backup();
+    int restore();
+    int stats();
+    bool read_password(bool confirm);
+    
+    std::string subcommand_;
+    std::string store_dir_;
+    std::string input_file_;
+    std::string output_file_;
+    std::string password_;
+    std::string algorithm_ = "aes-256-gcm";
+    std::string kdf_ = "argon2id";
+    std::string security_level_ = "medium";
+    std::string compression_ = "zstd";
+    int compression_level_ = 3;
+    uint32_t avg_chunk_kb_ = 1024;      // Min and max chunk sizes are 1/4 and 4x this
+    size_t threads_ = 0;                // Chunk workers (0 = one per core)
+};
+
+} // namespace cli
+} // namespace filevault
+
+#endif // FILEVAULT_CLI_COMMANDS_DEDUP_CMD_HPP
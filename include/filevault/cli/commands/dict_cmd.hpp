@@ -0,0 +1,48 @@
+#ifndef FILEVAULT_CLI_COMMANDS_DICT_CMD_HPP
+#define FILEVAULT_CLI_COMMANDS_DICT_CMD_HPP
+
+#include "filevault/cli/command.hpp"
+#include <string>
+#include <vector>
+
+namespace filevault {
+namespace cli {
+
+/**
+ * @brief Dict command - train and manage compression dictionaries
+ *
+ * Dictionaries make zlib/zstd effective on small files (configs, JSON
+ * records) that compress poorly on their own. They are kept in
+ * ~/.filevault/dictionaries and referenced by ID from encrypted files.
+ *
+ * Examples:
+ *   filevault dict train configs/ --size 64
+ *   filevault encrypt app.json --compression zstd --dictionary 1a2b3c4d
+ */
+class DictCommand : public ICommand {
+public:
+    DictCommand() = default;
+    
+    std::string name() const override { return "dict"; }
+    std::string description() const override { return "Train and manage compression dictionaries"; }
+    
+    void setup(CLI::App& app) override;
+    int execute() override;
+
+private:
+    void run();
+    int train();
+    int list();
+    int import_file();
+    
+    std::string subcommand_;
+    std::vector<std::string> samples_;  // Sample files or directories
+    size_t size_kb_ = 110;              // Dictionary size limit
+    std::string output_file_;           // Also write the dictionary here
+    std::string input_file_;            // Dictionary to import
+};
+
+} // namespace cli
+} // namespace filevault
+
+#endif // FILEVAULT_CLI_COMMANDS_DICT_CMD_HPP
@@ -2,7 +2,10 @@
 #define FILEVAULT_CLI_COMMANDS_DUMP_CMD_HPP
 
 #include "../command.hpp"
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <vector>
 
 namespace filevault {
 namespace cli {
@@ -22,14 +25,28 @@ class DumpCommand : public ICommand {
     int execute() override;
     
 private:
+    /**
+     * @brief Dump one file's content, or the range picked by --offset/--chunk
+     */
+    int dump_file(const std::string& path);
+    
+    /**
+     * @brief Header summary per file, from the first bytes only, in parallel
+     */
+    int summarize_files();
+    
     std::string name_ = "dump";
     std::string description_ = "View file content in hex, binary, or base64 format";
     
-    std::string file_path_;
+    std::vector<std::string> file_paths_;
     std::string format_ = "hex";  // Default format
     size_t max_bytes_ = 0;  // 0 = show all
+    uint64_t offset_ = 0;   // First byte shown
+    std::optional<size_t> chunk_;  // Frame of a streaming file to show instead
     bool show_offset_ = true;
     bool show_ascii_ = true;
+    bool json_ = false;
+    size_t threads_ = 0;
 };
 
 } // namespace commands
@@ -3,6 +3,15 @@
 
 #include "filevault/cli/command.hpp"
 #include "filevault/core/crypto_engine.hpp"
+#include "filevault/core/streaming.hpp"
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace filevault::compression {
+class ICompressor;
+} // namespace filevault::compression
 
 namespace filevault {
 namespace cli {
@@ -21,18 +30,111 @@ class EncryptCommand : public ICommand {
     int execute() override;
 
 private:
+    /**
+     * @brief Encrypt with the chunked streaming engine (FVAULT02 format)
+     *
+     * Handles "-" for stdin/stdout; memory use is bounded by the chunk size.
+     * With --public-key the stream key is random and wrapped for each
+     * recipient key (envelope format) instead of derived from a password.
+     */
+    int execute_streaming();
+    
+    /**
+     * @brief Encrypt every file under a directory into a mirrored tree (-r)
+     *
+     * Files are encrypted concurrently in the v2 format with one shared
+     * salt, so the key is derived once for the whole tree. With --sync,
+     * each output's header records a fingerprint of its source, and
+     * outputs whose fingerprint still matches are left alone.
+     */
+    int execute_recursive();
+    
+    /**
+     * @brief One step of encrypting a file from several hosts (--shard)
+     *
+     * "init" writes the header and lays out the output, "R/N" encrypts
+     * rank R's share of the chunks in place, and "stitch" checks that all
+     * ranks are done and writes the frame index; see
+     * StreamingCrypto::init_shards().
+     */
+    int execute_shard();
+    
+    /**
+     * @brief Write a single-tag FVAULT01 file piece by piece
+     * @param config Settings with the nonce already chosen
+     * @param compressor Set up with the dictionary, or nullptr for none
+     * @return Exit code, or nullopt to fall back to encrypting in memory
+     *         (cipher without incremental encryption)
+     *
+     * Plaintext is compressed and encrypted in slices straight from the
+     * mapped input to a temp file beside the output; the tag is appended
+     * once the last slice is sealed. Memory stays flat for any file size.
+     */
+    std::optional<int> encrypt_incremental(
+        core::ICryptoAlgorithm& algorithm,
+        std::span<const uint8_t> key,
+        core::EncryptionConfig config,
+        std::span<const uint8_t> salt,
+        std::span<const uint8_t> plaintext,
+        compression::ICompressor* compressor,
+        core::CompressionType compression,
+        uint32_t dictionary_id
+    );
+    
+    /**
+     * @brief Streaming settings from the command options
+     * @return false (after reporting why) if the options are invalid
+     */
+    bool make_streaming_config(core::StreamingConfig& config);
+    
+    /**
+     * @brief Read the --public-key recipients
+     */
+    bool load_public_keys(std::vector<std::vector<uint8_t>>& public_keys);
+    
+    /**
+     * @brief Replace the KDF parameters with the calibrated ones
+     *
+     * Uses the result cached in the user config, calibrating on first use.
+     * @return false if the KDF cannot be calibrated
+     */
+    bool apply_kdf_calibration(core::EncryptionConfig& config);
+    
+    /**
+     * @brief Replace "--compression auto" with the algorithm and level a
+     *        sample of the input favours
+     */
+    bool resolve_auto_compression(bool pipe_mode);
+    
     core::CryptoEngine& engine_;
     
     // Command options
     std::string input_file_;
     std::string output_file_;
     std::string password_;
+    std::vector<std::string> public_key_paths_;  // Envelope recipients instead of a password
     std::string mode_;  // Mode preset: basic/standard/advanced
-    std::string algorithm_ = "aes-256-gcm";
+    std::string algorithm_;  // Empty = preset, config, or CPU-preferred AEAD
     std::string security_level_ = "medium";
     std::string kdf_ = "argon2id";
+    uint32_t kdf_parallelism_ = 0;  // 0 = security level default
+    uint32_t kdf_target_ms_ = 0;    // 0 = no calibration
+    bool kdf_recalibrate_ = false;
     std::string compression_type_ = "none";
     int compression_level_ = 6;
+    std::string adaptive_level_;    // "MIN-MAX": v2 level follows output backpressure (empty = fixed)
+    double compression_target_mbps_ = 0;    // Throughput floor for "--compression auto" (0 = from the profile)
+    std::string dictionary_;        // Dictionary ID or file (zlib/zstd)
+    std::string format_ = "auto";   // auto, v1 (FVAULT01, in memory) or v2 (FVAULT02, chunked)
+    size_t threads_ = 0;            // Compression/chunk threads (0 = all cores)
+    size_t checkpoint_interval_ = 16;  // Chunks between checkpoints (0 = none)
+    bool resume_ = false;
+    bool direct_io_ = false;        // Keep input and output out of the page cache
+    bool recursive_ = false;        // Input is a directory, output a directory
+    bool sync_ = false;             // With -r: skip outputs whose source is unchanged
+    bool armor_ = false;            // Base64 text between marker lines (v2 only)
+    uint64_t split_size_ = 0;       // Write numbered part files of this size (0 = one file)
+    std::string shard_;             // "init", "R/N" or "stitch" (empty = not sharded)
     bool verbose_ = false;
     bool no_progress_ = false;
     bool force_weak_password_ = false;
@@ -3,8 +3,14 @@
 
 #include "filevault/cli/command.hpp"
 #include "filevault/core/crypto_engine.hpp"
+#include "filevault/utils/hash_cache.hpp"
+#include "filevault/utils/multi_hash.hpp"
+#include <atomic>
+#include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace filevault {
 namespace cli {
@@ -13,12 +19,21 @@ namespace cli {
  * @brief Hash command - Calculate cryptographic hashes
  * 
  * Supports: MD5, SHA1, SHA2 family (224/256/384/512), 
- * SHA3 family (224/256/384/512), BLAKE2 (b/s variants)
+ * SHA3 family (224/256/384/512), BLAKE2 (b/s variants), and the
+ * non-cryptographic XXH3-128 and CRC32C (utils/checksum.hpp)
  * 
  * Features:
  * - HMAC mode with key
- * - Hash verification
- * - Batch processing
+ * - Hash verification, of one file or of a whole checksum manifest
+ * - Batch processing: files, directories and globs hashed concurrently,
+ *   printed in input order in sha256sum format (or JSON lines), written
+ *   through utils::RowWriter in blocks
+ * - Several digests in one pass over a memory-mapped file
+ * - Small files hashed together in SIMD lanes (utils::multihash) for
+ *   SHA-256 and BLAKE2s
+ * - Parallel Merkle-tree digests (core::TreeHash) for very large files
+ * - Optional digest cache (utils::HashCache) for files that did not change,
+ *   with a checksum pre-filter for files that were only touched
  * - Performance benchmarking
  */
 class HashCommand : public ICommand {
@@ -32,38 +47,124 @@ class HashCommand : public ICommand {
     
     void setup(CLI::App& app) override;
     int execute() override;
+    
+    /**
+     * @brief Botan name for a CLI algorithm name ("sha256" -> "SHA-256")
+     */
+    static std::string get_botan_algorithm_name(const std::string& algo);
 
 private:
     core::CryptoEngine& engine_;
     
     // Options
-    std::string input_file_;
+    std::vector<std::string> inputs_;   // Files, directories and globs
     std::string output_file_;
-    std::string algorithm_ = "sha256";
+    std::string algorithm_ = "sha256";  // Comma-separated for several digests
     std::string output_format_ = "hex";
     std::string verify_hash_;
+    std::string check_file_;            // Manifest to verify (sha256sum or tagged format)
+    size_t io_depth_ = 0;               // Files read at once in check mode (0 = threads)
     std::string hmac_key_;
     bool uppercase_ = false;
     bool no_filename_ = false;
+    bool jsonl_ = false;                // One JSON object per digest
     bool verbose_ = false;
     bool benchmark_ = false;
+    size_t threads_ = 0;                // Files hashed at once (0 = one per core)
+    bool parallel_digests_ = false;     // One thread per digest of a file
+    bool tree_ = false;                 // Merkle-tree digests, leaves hashed in parallel
+    size_t leaf_size_kb_ = 1024;
+    bool cache_ = false;                // Reuse digests of unchanged files
+    std::string prefilter_;             // Checksum that revalidates touched files
+    std::vector<std::string> algorithms_;         // Parsed from algorithm_
+    std::vector<std::string> botan_algorithms_;   // Botan names, same order
+    std::vector<std::string> labels_;             // Output and cache labels, same order
+    std::string prefilter_botan_;                 // Empty without --prefilter
+    std::string prefilter_label_;
+    std::atomic<size_t> prefilter_saves_{0};      // Files revalidated by the checksum
+    std::vector<uint8_t> hmac_key_bytes_;
+    std::unique_ptr<utils::HashCache> hash_cache_;
+    std::optional<utils::multihash::Algorithm> multi_buffer_;  // Set when small files share lanes
+    
+    /**
+     * @brief Formatted digests of one file of a batch, or why it has none
+     */
+    struct FileDigests {
+        std::vector<std::string> digests;
+        std::string error;
+    };
     
     // Helper methods
-    std::string get_botan_algorithm_name(const std::string& algo);
     bool is_secure_algorithm(const std::string& algo);
     
-    std::string calculate_file_hash(
-        const std::string& filepath,
-        const std::string& algorithm
-    );
+    /**
+     * @brief Expand inputs into files, in input order (directories sorted)
+     * @param failures Incremented for every input that matched nothing
+     */
+    std::vector<std::string> expand_inputs(int& failures);
+    
+    /**
+     * @brief Hash or HMAC one file with every algorithm, formatted
+     *
+     * With the cache enabled, a file whose identity is unchanged is not
+     * read at all if every digest is cached. With --prefilter, a file
+     * whose timestamps changed but whose size did not is checksummed
+     * first; if the checksum matches the cached one, the cached digests
+     * are kept and the expensive hashes are skipped.
+     */
+    std::vector<std::string> hash_file(const std::string& filepath, bool show_progress);
     
-    std::string calculate_file_hmac(
+    /**
+     * @brief Hash a batch of small files in one multi-buffer call
+     *
+     * Files with every digest cached are not read; the others are read
+     * whole and hashed one per lane, then cached as hash_file() does. A
+     * file that cannot be read fails alone.
+     */
+    std::vector<FileDigests> hash_small_files(const std::vector<std::string>& files);
+    
+    /**
+     * @brief Raw hex digests of every label from the cache, or empty
+     */
+    std::vector<std::string> cached_digests(const utils::FileIdentity& identity);
+    
+    /**
+     * @brief Cache raw hex digests (labels_, then the pre-filter checksum)
+     */
+    void store_digests(const utils::FileIdentity& identity, const std::vector<std::string>& digests);
+    
+    std::string format_hash(const std::string& hex_hash) const;
+    
+    /**
+     * @brief Compute hex digests of one file in a single pass
+     * @param algorithms Botan hash names
+     * @param hmac_key HMAC key; empty for plain hashes
+     *
+     * The file is memory-mapped and fed to every digest in 1 MB slices, so
+     * each slice is read from memory once while still in cache. With
+     * parallel_digests_, each digest runs on its own thread over the
+     * mapping instead. In tree mode each digest is a core::TreeHash root
+     * with its leaves spread over threads_ workers. HMACs reuse one keyed
+     * state per thread and algorithm, so the key schedule runs once per
+     * worker rather than once per file.
+     */
+    std::vector<std::string> calculate_file_digests(
         const std::string& filepath,
-        const std::string& hash_algorithm,
-        const std::string& key
+        const std::vector<std::string>& algorithms,
+        const std::vector<uint8_t>& hmac_key,
+        bool show_progress
     );
     
-    int verify_mode(const std::string& calculated_hash);
+    int verify_mode(const std::string& calculated_hash, const std::string& filepath);
+    
+    /**
+     * @brief Verify every entry of check_file_ on a thread pool
+     *
+     * The manifest is parsed up front; untagged lines use the first -a
+     * algorithm. Mismatches are printed as soon as they are found, OK lines
+     * only with --verbose. No more than io_depth_ files are read at once.
+     */
+    int check_mode();
 };
 
 } // namespace cli
@@ -33,6 +33,7 @@ class InfoCommand : public ICommand {
     core::CryptoEngine& engine_;
     std::string input_file_;
     bool verbose_ = false;
+    bool show_cpu_ = false;
     
     /**
      * @brief Parse encrypted file header
@@ -52,10 +53,23 @@ class InfoCommand : public ICommand {
         std::string kdf;
         std::string compression;
         bool compressed = false;
+        
+        // Chunked (FVAULT02/FVST) format fields; chunk_size is 0 otherwise
+        std::string security;
+        size_t chunk_size = 0;
+        size_t chunk_count = 0;
+        bool authenticated_header = false;
+        bool wrapped_key = false;
+        uint16_t key_generation = 0;
     };
     
     FileInfo parse_file(const std::string& path);
     void display_info(const FileInfo& info);
+    
+    /**
+     * @brief Print detected CPU features and the default AEAD they select
+     */
+    void display_cpu_info();
 };
 
 } // namespace cli
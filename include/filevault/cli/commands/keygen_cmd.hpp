@@ -9,6 +9,7 @@
 #include "filevault/cli/command.hpp"
 #include "filevault/core/crypto_engine.hpp"
 #include <CLI/CLI.hpp>
+#include <string>
 
 namespace filevault {
 namespace cli {
@@ -29,9 +30,17 @@ class KeygenCommand : public ICommand {
     int execute() override;
     
 private:
+    /**
+     * @brief Generate count_ key pairs in parallel, into files or a JSON bundle
+     */
+    int execute_batch(const std::string& algo);
+    
     core::CryptoEngine& engine_;
     std::string algorithm_ = "rsa-2048";
     std::string output_prefix_ = "filevault_key";
+    std::string bundle_path_;
+    size_t count_ = 1;
+    size_t threads_ = 0;
     bool force_ = false;
     bool verbose_ = false;
 };
@@ -4,6 +4,7 @@
 #include "../command.hpp"
 #include "filevault/core/crypto_engine.hpp"
 #include <string>
+#include <vector>
 
 namespace filevault {
 namespace cli {
@@ -23,11 +24,24 @@ class KeyInfoCommand : public ICommand {
     int execute() override;
     
 private:
+    /**
+     * @brief Full report for one key, with --public and --check-pair
+     */
+    int inspect_key(const std::string& key_path);
+    
+    /**
+     * @brief One row (or JSON object) per key, parsed in parallel, written in blocks
+     */
+    int inspect_keys();
+    
     std::string name_ = "keyinfo";
     std::string description_ = "Display information about cryptographic keys";
     
     core::CryptoEngine& engine_;
-    std::string key_path_;
+    std::vector<std::string> key_paths_;
+    bool json_ = false;
+    std::string format_ = "auto";       // auto, table, tsv, jsonl (--json = jsonl)
+    size_t threads_ = 0;
     bool show_public_ = false;
     bool check_pair_ = false;
     std::string pair_key_path_;
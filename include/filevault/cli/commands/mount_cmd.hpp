@@ -0,0 +1,45 @@
+#ifndef FILEVAULT_CLI_COMMANDS_MOUNT_CMD_HPP
+#define FILEVAULT_CLI_COMMANDS_MOUNT_CMD_HPP
+
+#include "filevault/cli/command.hpp"
+#include <string>
+
+namespace filevault {
+namespace cli {
+
+/**
+ * @brief Mount command - browse an encrypted archive without extracting it
+ *
+ * Serves an archive (or any file in the streaming format, as a single
+ * file) read-only through FUSE. Chunks are decrypted and decompressed as
+ * files are read and kept in a cache; sequential reads are prefetched.
+ *
+ * Examples:
+ *   filevault mount photos.fva ~/mnt/photos
+ *   filevault mount db-dump.sql.fvlt ~/mnt/dump
+ */
+class MountCommand : public ICommand {
+public:
+    MountCommand() = default;
+
+    std::string name() const override { return "mount"; }
+    std::string description() const override { return "Mount an encrypted archive read-only (FUSE)"; }
+
+    void setup(CLI::App& app) override;
+    int execute() override;
+
+private:
+    void run();
+
+    std::string input_file_;
+    std::string mountpoint_;
+    std::string password_;
+    size_t cache_mb_ = 0;               // Decrypted chunk cache (0 = 32 chunks)
+    size_t readahead_ = 2;              // Chunks prefetched ahead of sequential reads
+    bool allow_other_ = false;
+};
+
+} // namespace cli
+} // namespace filevault
+
+#endif // FILEVAULT_CLI_COMMANDS_MOUNT_CMD_HPP
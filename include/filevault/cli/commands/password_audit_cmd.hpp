@@ -0,0 +1,52 @@
+#ifndef FILEVAULT_CLI_COMMANDS_PASSWORD_AUDIT_CMD_HPP
+#define FILEVAULT_CLI_COMMANDS_PASSWORD_AUDIT_CMD_HPP
+
+#include "filevault/cli/command.hpp"
+#include <string>
+
+namespace filevault {
+namespace cli {
+
+/**
+ * @brief Password-audit command - screen passwords in bulk
+ *
+ * "build" turns a breached-password corpus (such as the HIBP SHA-1
+ * download) into a compact Bloom filter; "check" looks a list of
+ * passwords up in it in parallel. Once installed in ~/.filevault, the
+ * filter also backs the strength meter shown when encrypting. "score"
+ * rates a list with the strength meter's rules and writes JSON lines.
+ *
+ * Examples:
+ *   filevault password-audit build pwned-passwords-sha1.txt
+ *   filevault password-audit check candidates.txt
+ *   filevault password-audit score candidates.txt --below 40 > weak.jsonl
+ */
+class PasswordAuditCommand : public ICommand {
+public:
+    PasswordAuditCommand() = default;
+
+    std::string name() const override { return "password-audit"; }
+    std::string description() const override { return "Screen passwords for breaches and strength"; }
+
+    void setup(CLI::App& app) override;
+    int execute() override;
+
+private:
+    void run();
+    int build();
+    int check();
+    int score();
+
+    std::string subcommand_;
+    std::string input_file_ = "-";      // Corpus (build) or passwords (check, "-" = stdin)
+    std::string filter_file_;           // Default: Config::get_breach_filter_path()
+    double false_positive_rate_ = 0.001;
+    size_t threads_ = 0;                // Lookup workers (0 = profile, then one per core)
+    bool show_matches_ = false;         // Print matching passwords, not just line numbers
+    int below_score_ = 101;             // score: report only passwords scoring under this
+};
+
+} // namespace cli
+} // namespace filevault
+
+#endif // FILEVAULT_CLI_COMMANDS_PASSWORD_AUDIT_CMD_HPP
@@ -0,0 +1,48 @@
+#ifndef FILEVAULT_CLI_COMMANDS_REKEY_CMD_HPP
+#define FILEVAULT_CLI_COMMANDS_REKEY_CMD_HPP
+
+#include "../command.hpp"
+#include "filevault/core/crypto_engine.hpp"
+#include <string>
+#include <vector>
+
+namespace filevault {
+namespace cli {
+namespace commands {
+
+/**
+ * @brief Command to change the password of encrypted files
+ * 
+ * Rewrites only the header of each FVAULT02 file: the random file key is
+ * unwrapped with the old password and wrapped under the new one, so the
+ * cost is two KDF runs per tree rather than a pass over the data.
+ */
+class RekeyCommand : public ICommand {
+public:
+    explicit RekeyCommand(core::CryptoEngine& engine);
+    
+    std::string name() const override { return name_; }
+    std::string description() const override { return description_; }
+    
+    void setup(CLI::App& app) override;
+    int execute() override;
+    
+private:
+    std::string name_ = "rekey";
+    std::string description_ = "Change the password of encrypted files without re-encrypting them";
+    
+    core::CryptoEngine& engine_;
+    std::vector<std::string> files_;
+    bool recursive_ = false;
+    std::string password_;
+    std::string new_password_;
+    std::string kdf_;                   // Empty = keep each file's
+    std::string security_level_;        // Empty = keep each file's
+    size_t threads_ = 0;                // 0 = one per core
+};
+
+} // namespace commands
+} // namespace cli
+} // namespace filevault
+
+#endif // FILEVAULT_CLI_COMMANDS_REKEY_CMD_HPP
@@ -0,0 +1,69 @@
+#ifndef FILEVAULT_CLI_COMMANDS_SERVE_CMD_HPP
+#define FILEVAULT_CLI_COMMANDS_SERVE_CMD_HPP
+
+#include "filevault/cli/command.hpp"
+#include "filevault/core/crypto_engine.hpp"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace filevault {
+namespace cli {
+
+/**
+ * @brief Serve command - long-running JSON-RPC daemon for the GUI and editor
+ *
+ * Keeps one initialized engine and the derived-key cache alive and runs
+ * command lines sent as newline-delimited JSON-RPC 2.0, so a frontend
+ * pays process start and engine setup once instead of per action.
+ * Requests are read from stdin (--stdio) or a Unix domain socket.
+ *
+ * Methods:
+ *   ping                              -> {"pid", "uptime_ms", "requests", "key_cache_entries"}
+ *   run {"args": ["encrypt", ...]}    -> {"exit_code", "stdout", "stderr", "duration_ms"}
+ *   metrics {"format": "json"}        -> run latency quantiles, counters, queue, executor,
+ *                                        key cache and buffer pool figures
+ *   metrics {"format": "prometheus"}  -> {"text"} in the Prometheus exposition format
+ *   shutdown                          -> true, then the daemon exits
+ * While a run is in progress, "progress" notifications carry
+ * {"id", "label", "progress", "total"} for each progress bar update.
+ *
+ * With --metrics-port the Prometheus text is also served over HTTP at
+ * http://127.0.0.1:PORT/metrics.
+ *
+ * Examples:
+ *   filevault serve --stdio
+ *   filevault serve --socket /run/user/1000/filevault.sock
+ *   filevault serve --stdio --metrics-port 9464
+ */
+class ServeCommand : public ICommand {
+public:
+    /**
+     * @brief Runs one command line in-process and returns its exit code
+     */
+    using Runner = std::function<int(const std::vector<std::string>&)>;
+
+    ServeCommand(core::CryptoEngine& engine, Runner runner);
+
+    std::string name() const override { return "serve"; }
+    std::string description() const override { return "Run as a JSON-RPC daemon for the GUI and editor extension"; }
+
+    void setup(CLI::App& app) override;
+    int execute() override;
+
+private:
+    int serve_stdio();
+    int serve_socket();
+
+    core::CryptoEngine& engine_;
+    Runner runner_;
+
+    std::string socket_path_;   // Empty = default per-user path
+    bool stdio_ = false;
+    int metrics_port_ = 0;      // 0 = no HTTP endpoint
+};
+
+} // namespace cli
+} // namespace filevault
+
+#endif // FILEVAULT_CLI_COMMANDS_SERVE_CMD_HPP
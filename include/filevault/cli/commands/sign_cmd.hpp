@@ -2,15 +2,22 @@
 #define FILEVAULT_CLI_COMMANDS_SIGN_CMD_HPP
 
 #include "../command.hpp"
+#include "filevault/algorithms/asymmetric/digest_signer.hpp"
 #include "filevault/core/crypto_engine.hpp"
 #include <string>
+#include <vector>
 
 namespace filevault {
 namespace cli {
 namespace commands {
 
 /**
- * @brief Command to create digital signature for a file
+ * @brief Command to create digital signatures for files
+ * 
+ * Each file's SHA-256 digest is computed in a streaming pass and signed
+ * (see algorithms::asymmetric::DigestSigner), on a thread pool with one
+ * parsed key. Writes a detached .sig per file, or one sha256sum-style
+ * manifest plus a detached signature of the manifest.
  */
 class SignCommand : public ICommand {
 public:
@@ -24,13 +31,18 @@ class SignCommand : public ICommand {
     
 private:
     std::string name_ = "sign";
-    std::string description_ = "Create digital signature for a file";
+    std::string description_ = "Create digital signatures for files";
     
     core::CryptoEngine& engine_;
-    std::string file_path_;
+    std::vector<std::string> files_;    // Legacy form: <file> <private-key>
     std::string private_key_path_;
     std::string output_path_;
-    std::string algorithm_ = "rsa";  // rsa, ecc, ed25519
+    std::string manifest_path_;         // One signed manifest instead of .sig files
+    std::string algorithm_;             // rsa, ecc, ed25519; empty = from the key
+    size_t threads_ = 0;                // 0 = one per core
+    
+    int sign_files(const algorithms::asymmetric::DigestSigner& signer);
+    int sign_manifest(const algorithms::asymmetric::DigestSigner& signer);
 };
 
 } // namespace commands
@@ -3,6 +3,7 @@
 
 #include "filevault/cli/command.hpp"
 #include <string>
+#include <vector>
 
 namespace filevault::cli::commands {
 
@@ -17,6 +18,9 @@ namespace filevault::cli::commands {
  * - Extract hidden data from stego images
  * - Calculate embedding capacity
  * - Configurable bits per channel (1-4)
+ * - Shard one payload over many covers in parallel (embed-batch), with a
+ *   JSON manifest that extract-batch uses to reassemble it
+ * - Scan image sets for LSB payloads (chi-square and RS steganalysis)
  */
 class StegoCommand : public ICommand {
 public:
@@ -33,6 +37,9 @@ class StegoCommand : public ICommand {
     int do_embed();
     int do_extract();
     int do_capacity();
+    int do_embed_batch();
+    int do_extract_batch();
+    int do_scan();
     
     // Options
     std::string operation_;           // "embed", "extract", or "capacity"
@@ -40,6 +47,15 @@ class StegoCommand : public ICommand {
     std::string cover_image_;         // Cover image (for embed)
     std::string output_file_;         // Output path
     int bits_per_channel_ = 1;        // 1-4 bits per channel
+    int png_level_ = 6;               // zlib level of PNG output (0-9)
+    std::string png_filter_ = "adaptive"; // PNG row filter
+    std::vector<std::string> covers_; // Cover images or directories (embed-batch)
+    std::string output_dir_;          // Stego images (embed-batch)
+    std::string manifest_path_;       // Default: <output_dir>/manifest.json
+    size_t threads_ = 0;              // Covers processed in parallel (0 = one per core)
+    std::vector<std::string> scan_inputs_; // Images or directories (scan)
+    double threshold_ = 0.5;          // Score from which scan flags an image
+    bool json_ = false;               // scan: one JSON object per image
     bool verbose_ = false;
 };
 
@@ -0,0 +1,59 @@
+#ifndef FILEVAULT_CLI_COMMANDS_STORE_CMD_HPP
+#define FILEVAULT_CLI_COMMANDS_STORE_CMD_HPP
+
+#include "filevault/cli/command.hpp"
+#include <cstdint>
+#include <string>
+
+namespace filevault {
+namespace cli {
+
+/**
+ * @brief Store command - encrypted key-value store
+ *
+ * A store is a directory of append-only segment files holding
+ * AES-256-GCM sealed records under one data key; see store::BlobStore.
+ *
+ * Examples:
+ *   filevault store create secrets.fvs
+ *   filevault store put secrets.fvs api-token --file token.txt
+ *   filevault store get secrets.fvs api-token
+ */
+class StoreCommand : public ICommand {
+public:
+    StoreCommand() = default;
+
+    std::string name() const override { return "store"; }
+    std::string description() const override { return "Encrypted key-value store (append-only segments)"; }
+
+    void setup(CLI::App& app) override;
+    int execute() override;
+
+private:
+    void run();
+    int create();
+    int info();
+    int put();
+    int get();
+    int remove();
+    int list();
+    int compact();
+    int passwd();
+    bool read_password(const std::string& prompt, bool confirm, std::string& password);
+
+    std::string subcommand_;
+    std::string store_dir_;
+    std::string key_;
+    std::string value_;                 // put: literal value
+    std::string data_file_;             // put: input ("-" = stdin), get: output ("-" = stdout)
+    std::string password_;
+    std::string new_password_;
+    std::string kdf_ = "argon2id";
+    std::string security_level_ = "medium";
+    uint64_t segment_bytes_ = 64 * 1024 * 1024;
+};
+
+} // namespace cli
+} // namespace filevault
+
+#endif // FILEVAULT_CLI_COMMANDS_STORE_CMD_HPP
@@ -2,15 +2,20 @@
 #define FILEVAULT_CLI_COMMANDS_VERIFY_CMD_HPP
 
 #include "../command.hpp"
+#include "filevault/algorithms/asymmetric/digest_signer.hpp"
 #include "filevault/core/crypto_engine.hpp"
 #include <string>
+#include <vector>
 
 namespace filevault {
 namespace cli {
 namespace commands {
 
 /**
- * @brief Command to verify digital signature of a file
+ * @brief Command to verify digital signatures of files
+ * 
+ * Verifies detached signatures of one or many files on a thread pool, or
+ * a signed manifest written by sign -m and then every file it lists.
  */
 class VerifyCommand : public ICommand {
 public:
@@ -24,13 +29,18 @@ class VerifyCommand : public ICommand {
     
 private:
     std::string name_ = "verify";
-    std::string description_ = "Verify digital signature of a file";
+    std::string description_ = "Verify digital signatures of files";
     
     core::CryptoEngine& engine_;
-    std::string file_path_;
+    std::vector<std::string> files_;    // Legacy form: <file> <signature> <public-key>
     std::string signature_path_;
     std::string public_key_path_;
-    std::string algorithm_ = "rsa";
+    std::string manifest_path_;
+    std::string algorithm_;             // rsa, ecc, ed25519; empty = from the key
+    size_t threads_ = 0;                // 0 = one per core
+    
+    int verify_files(const algorithms::asymmetric::DigestSigner& verifier);
+    int verify_manifest(const algorithms::asymmetric::DigestSigner& verifier);
 };
 
 } // namespace commands
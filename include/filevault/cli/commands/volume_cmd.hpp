@@ -0,0 +1,64 @@
+#ifndef FILEVAULT_CLI_COMMANDS_VOLUME_CMD_HPP
+#define FILEVAULT_CLI_COMMANDS_VOLUME_CMD_HPP
+
+#include "filevault/cli/command.hpp"
+#include <cstdint>
+#include <string>
+
+namespace filevault {
+namespace cli {
+
+/**
+ * @brief Volume command - encrypted containers with random access
+ *
+ * A volume is a fixed-size file whose sectors are encrypted one by one
+ * with AES-256-XTS, so any part of it can be read or rewritten without
+ * touching the rest. With FUSE, "mount" exposes the decrypted contents
+ * as a single file to put a filesystem on.
+ *
+ * Examples:
+ *   filevault volume create secret.fvv --size 1G
+ *   filevault volume write secret.fvv disk.img --offset 0
+ *   filevault volume mount secret.fvv ~/mnt
+ */
+class VolumeCommand : public ICommand {
+public:
+    VolumeCommand() = default;
+
+    std::string name() const override { return "volume"; }
+    std::string description() const override { return "Encrypted containers with random access (AES-XTS)"; }
+
+    void setup(CLI::App& app) override;
+    int execute() override;
+
+private:
+    void run();
+    int create();
+    int info();
+    int read();
+    int write();
+    int passwd();
+    int mount();
+    bool read_password(const std::string& prompt, bool confirm, std::string& password);
+
+    std::string subcommand_;
+    std::string volume_file_;
+    std::string data_file_;             // read: output ("-" = stdout), write: input
+    std::string mountpoint_;
+    std::string password_;
+    std::string new_password_;
+    std::string kdf_ = "argon2id";
+    std::string security_level_ = "medium";
+    uint64_t size_ = 0;                 // create: bytes, rounded up to whole sectors
+    size_t sector_size_ = 4096;
+    uint64_t offset_ = 0;
+    uint64_t length_ = 0;               // read: bytes (0 = to the end)
+    size_t threads_ = 0;                // XTS workers (0 = profile, then one per core)
+    bool read_only_ = false;
+    bool allow_other_ = false;
+};
+
+} // namespace cli
+} // namespace filevault
+
+#endif // FILEVAULT_CLI_COMMANDS_VOLUME_CMD_HPP
@@ -0,0 +1,97 @@
+#ifndef FILEVAULT_CLI_COMMANDS_WATCH_CMD_HPP
+#define FILEVAULT_CLI_COMMANDS_WATCH_CMD_HPP
+
+#include "filevault/cli/command.hpp"
+#include "filevault/core/crypto_engine.hpp"
+#include "filevault/core/streaming.hpp"
+#include "filevault/core/tree_runner.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace filevault {
+namespace cli {
+
+/**
+ * @brief Watch command - keep an encrypted mirror of a directory current
+ *
+ * Catches up once (like 'encrypt -r --sync'), then waits for change
+ * notifications (inotify on Linux, polling elsewhere). Bursts of writes
+ * to a file are coalesced until it has been quiet for --quiet-ms, and
+ * the files that settle together are encrypted as one batch on the
+ * worker pool. The tree has one batch salt, so the password is stretched
+ * once and every batch finds the master key in KeyCache; each file's key
+ * is derived from it by HKDF (CryptoEngine::batch_file_salt()).
+ *
+ * A small state file in the output directory keeps the batch salt, when the
+ * last session started watching and the files still to do, so a restart
+ * only looks at files modified since then.
+ *
+ * Examples:
+ *   filevault watch ~/Documents -o /backup/Documents.fvlt
+ *   filevault watch src/ -o enc/ --once        # catch up and exit
+ */
+class WatchCommand : public ICommand {
+public:
+    explicit WatchCommand(core::CryptoEngine& engine);
+
+    std::string name() const override { return "watch"; }
+    std::string description() const override { return "Encrypt files of a directory as they change"; }
+
+    void setup(CLI::App& app) override;
+    int execute() override;
+
+private:
+    /**
+     * @brief Outcome of one batch
+     */
+    struct BatchResult {
+        size_t encrypted = 0;
+        size_t unchanged = 0;           // Fingerprint still matched
+        uint64_t bytes = 0;
+        double seconds = 0.0;
+        std::vector<std::string> failed;    // Sources, relative to the input
+    };
+
+    /**
+     * @brief Encrypt the sources whose outputs are out of date
+     */
+    BatchResult run_batch(std::vector<core::TreeFile> files, const core::StreamingConfig& base,
+                          const std::vector<uint8_t>& sync_key);
+
+    /**
+     * @brief Source and target of one input file, or false if it is gone
+     *        or not a regular file
+     */
+    bool make_tree_file(const std::filesystem::path& source, core::TreeFile& file) const;
+
+    bool load_state(std::vector<uint8_t>& salt, int64_t& scanned, std::set<std::string>& pending) const;
+    bool save_state(const std::vector<uint8_t>& salt, int64_t scanned, const std::set<std::string>& pending) const;
+
+    core::CryptoEngine& engine_;
+
+    std::string input_dir_;
+    std::string output_dir_;            // Empty = <input>.fvlt
+    std::string state_file_;            // Empty = <output>/.filevault-watch
+    std::string password_;
+    std::string algorithm_;             // Empty = config default or CPU-preferred AEAD
+    std::string kdf_ = "argon2id";
+    std::string security_level_ = "medium";
+    std::string compression_type_ = "none";
+    int compression_level_ = 6;
+    size_t threads_ = 0;                // 0 = one per core
+    size_t quiet_ms_ = 2000;            // A file is encrypted once unchanged this long
+    size_t max_delay_ms_ = 60000;       // ...or at the latest this long after its first change
+    size_t poll_ms_ = 2000;             // Without kernel notifications
+    bool once_ = false;                 // Catch up and exit
+
+    std::filesystem::path root_;
+    std::filesystem::path out_root_;
+};
+
+} // namespace cli
+} // namespace filevault
+
+#endif // FILEVAULT_CLI_COMMANDS_WATCH_CMD_HPP
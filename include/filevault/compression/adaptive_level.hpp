@@ -0,0 +1,60 @@
+#ifndef FILEVAULT_COMPRESSION_ADAPTIVE_LEVEL_HPP
+#define FILEVAULT_COMPRESSION_ADAPTIVE_LEVEL_HPP
+
+#include <atomic>
+#include <cstddef>
+
+namespace filevault {
+namespace compression {
+
+/**
+ * @brief Compression level steered by backpressure between compress and write
+ *
+ * Before writing each chunk, the writer reports how many of the chunks in
+ * flight are already compressed and waiting for it. A full queue means
+ * the sink (disk, network, pipe) is the bottleneck and compression has
+ * time to spare, so the level goes up; an empty one means the writer is
+ * waiting on the compressor, so it goes down. The occupancy is smoothed,
+ * and after a change the controller waits for a queue's worth of chunks,
+ * compressed at the old level, to drain before judging the new one.
+ *
+ * level() may be read from any thread; observe() is called by the writer.
+ */
+class AdaptiveLevel {
+public:
+    static constexpr double RAISE_ABOVE = 0.75;    // Smoothed share of ready chunks
+    static constexpr double LOWER_BELOW = 0.25;
+
+    /**
+     * @param start Clamped to [min_level, max_level]
+     */
+    AdaptiveLevel(int min_level, int max_level, int start);
+
+    /**
+     * @brief Level for the next chunk to be compressed
+     */
+    int level() const { return level_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Record the queue seen by the writer before it writes a chunk
+     * @param ready Chunks in flight that are compressed and waiting
+     * @param in_flight Chunks in flight, including the one about to be written
+     * @return The level after this observation
+     */
+    int observe(size_t ready, size_t in_flight);
+
+    int min_level() const { return min_level_; }
+    int max_level() const { return max_level_; }
+
+private:
+    int min_level_;
+    int max_level_;
+    std::atomic<int> level_;
+    double occupancy_ = 0.5;
+    size_t since_change_ = 0;
+};
+
+} // namespace compression
+} // namespace filevault
+
+#endif // FILEVAULT_COMPRESSION_ADAPTIVE_LEVEL_HPP
@@ -3,9 +3,11 @@
 
 #include "filevault/core/types.hpp"
 #include "filevault/core/result.hpp"
-#include <vector>
-#include <span>
+#include <cstdint>
 #include <memory>
+#include <optional>
+#include <span>
+#include <vector>
 
 namespace filevault {
 namespace compression {
@@ -23,8 +25,29 @@ struct CompressionResult {
     double processing_time_ms = 0.0;
 };
 
+/**
+ * @brief Direction of an incremental (streaming) operation
+ */
+enum class StreamMode {
+    COMPRESS,
+    DECOMPRESS
+};
+
 /**
  * @brief Interface for compression algorithms
+ *
+ * Besides the one-shot compress()/decompress(), every compressor offers a
+ * push-style stream: begin(), any number of update() calls and finish().
+ * Output produced so far is appended to the caller's vector, which can be
+ * written out and cleared between calls, so memory stays bounded by the
+ * chunk size rather than the input size. The stream produces the same
+ * format as the one-shot calls, and each can decode the other's output.
+ *
+ * Compression can be spread over several threads with set_threads(). The
+ * input is then split into independent blocks, but the output is still a
+ * single standard stream that serial decoders (and zlib/xz/bzip3 tools)
+ * read unchanged. bzip3 and xz also decompress in parallel, a block per
+ * thread, for any multi-block input; the other formats decompress serially.
  */
 class ICompressor {
 public:
@@ -54,6 +77,90 @@ class ICompressor {
     virtual CompressionResult decompress(
         std::span<const uint8_t> input
     ) = 0;
+    
+    /**
+     * @brief Decompress data whose decompressed size is known
+     * @param input Compressed data
+     * @param expected_size Exact decompressed size (e.g. from a file header)
+     * @return Decompressed data; fails unless exactly expected_size bytes result
+     *
+     * Decompresses once into an exact-size buffer instead of guessing and
+     * growing it.
+     */
+    virtual CompressionResult decompress(
+        std::span<const uint8_t> input,
+        size_t expected_size
+    ) = 0;
+    
+    /**
+     * @brief Start an incremental compression or decompression
+     * @param mode Direction of the stream
+     * @param level Compression level (ignored when decompressing)
+     * @param input_size Total input size, if known (required by bzip3 to compress)
+     * @return false on failure; see stream_error()
+     *
+     * Discards any stream already in progress.
+     */
+    virtual bool begin(
+        StreamMode mode,
+        int level = 6,
+        std::optional<uint64_t> input_size = std::nullopt
+    ) = 0;
+    
+    /**
+     * @brief Feed the next piece of input
+     * @param input Next input bytes (may be empty)
+     * @param output Receives any output produced (appended)
+     * @return false on failure; see stream_error()
+     */
+    virtual bool update(
+        std::span<const uint8_t> input,
+        std::vector<uint8_t>& output
+    ) = 0;
+    
+    /**
+     * @brief Flush the remaining output and end the stream
+     * @param output Receives the final output (appended)
+     * @return false on failure (e.g. truncated compressed input)
+     */
+    virtual bool finish(std::vector<uint8_t>& output) = 0;
+    
+    /**
+     * @brief Reason the last begin/update/finish call failed
+     */
+    const std::string& stream_error() const { return stream_error_; }
+    
+    /**
+     * @brief Set the number of compression and decompression threads
+     * @param threads 1 = serial (default), 0 = one per hardware thread
+     *
+     * Takes effect with the next compress(), decompress() or begin().
+     * Inputs of a single block are processed serially either way.
+     */
+    void set_threads(size_t threads) { threads_ = threads; }
+    size_t threads() const { return threads_; }
+    
+    /**
+     * @brief Prime compression and decompression with a preset dictionary
+     * @param dictionary Trained dictionary (see train_dictionary()); empty to clear
+     * @return false if this algorithm does not support dictionaries
+     *
+     * Takes effect with the next compress(), decompress() or begin(). Data
+     * compressed with a dictionary can only be decompressed with the same
+     * one set.
+     */
+    virtual bool set_dictionary(std::span<const uint8_t> dictionary) { return dictionary.empty(); }
+    const std::vector<uint8_t>& dictionary() const { return dictionary_; }
+
+protected:
+    /**
+     * @brief Thread count with 0 resolved to the hardware concurrency
+     */
+    size_t worker_count() const;
+    
+    std::string stream_error_;
+    size_t threads_ = 1;
+    std::vector<uint8_t> dictionary_;
 };
 
 /**
@@ -75,14 +182,87 @@ class CompressionService {
      * @brief Parse algorithm from string
      */
     static core::CompressionType parse_algorithm(const std::string& name);
+    
+    /**
+     * @brief Identify compressed data by its magic bytes
+     * @return nullopt if no supported format matches
+     */
+    static std::optional<core::CompressionType> detect(std::span<const uint8_t> data);
+    
+    /**
+     * @brief Order-0 byte entropy (bits per byte) of a sample of data
+     *
+     * Looks at up to 16 evenly spaced 4 KB windows, so the cost does not
+     * grow with the input.
+     */
+    static double sample_entropy(std::span<const uint8_t> data);
+    
+    /**
+     * @brief Cheap prediction that compressing data would not pay off
+     *
+     * True when the sampled entropy is within 0.1 bit/byte of random, as
+     * for JPEG, MP4, zip or encrypted data. Inputs under 1 KB are never
+     * predicted incompressible.
+     */
+    static bool likely_incompressible(std::span<const uint8_t> data);
+    
+    /**
+     * @brief Train a compression dictionary from sample files
+     * @param samples Typical inputs, e.g. a few hundred small JSON files
+     * @param max_size Dictionary size limit (zstd's default is 110 KB)
+     *
+     * Produces a zstd dictionary, which zlib can use as well: deflate
+     * primes its window with the last 32 KB, where the most common
+     * content is placed. Fails if the samples are too few or too small.
+     */
+    static core::Result<std::vector<uint8_t>> train_dictionary(
+        const std::vector<std::vector<uint8_t>>& samples,
+        size_t max_size = 112640
+    );
+    
+    /**
+     * @brief ID recorded in a trained dictionary (0 if it is not one)
+     */
+    static uint32_t dictionary_id(std::span<const uint8_t> dictionary);
+    
+    /**
+     * @brief Stream a file through a compressor in fixed-size chunks
+     * @param level Compression level (ignored when decompressing)
+     * @return Bytes written to output_path; on failure the output is removed
+     *
+     * Memory use is bounded by the chunk size, not the file size.
+     */
+    static core::Result<uint64_t> process_file(
+        ICompressor& compressor,
+        StreamMode mode,
+        const std::string& input_path,
+        const std::string& output_path,
+        int level = 6
+    );
 };
 
 /**
  * @brief ZLIB compressor (fast, good compression)
+ *
+ * Keeps its deflate/inflate streams between calls and resets them instead
+ * of re-initialising, so one instance should be reused for many buffers.
+ * The one-shot calls share those streams with begin()/update()/finish(),
+ * so they end any stream in progress.
+ * With several threads, 1 MB blocks are deflated in parallel (each primed
+ * with the preceding 32 KB as a dictionary) and joined pigz-style into
+ * one zlib stream.
+ * A preset dictionary is set with deflateSetDictionary(); zlib records
+ * its Adler-32 in the stream header, so inflate rejects the wrong one.
+ * Compression with a dictionary is serial.
+ * Not thread-safe: use one instance per thread.
  */
 class ZlibCompressor : public ICompressor {
 public:
+    ZlibCompressor();
+    ~ZlibCompressor() override;
+    
     std::string name() const override { return "zlib"; }
+    bool set_dictionary(std::span<const uint8_t> dictionary) override;
     
     CompressionResult compress(
         std::span<const uint8_t> input,
@@ -92,13 +272,39 @@ class ZlibCompressor : public ICompressor {
     CompressionResult decompress(
         std::span<const uint8_t> input
     ) override;
+    
+    CompressionResult decompress(
+        std::span<const uint8_t> input,
+        size_t expected_size
+    ) override;
+    
+    bool begin(StreamMode mode, int level = 6,
+               std::optional<uint64_t> input_size = std::nullopt) override;
+    bool update(std::span<const uint8_t> input, std::vector<uint8_t>& output) override;
+    bool finish(std::vector<uint8_t>& output) override;
+
+private:
+    bool update_parallel(std::span<const uint8_t> input, std::vector<uint8_t>& output, bool last);
+    
+    struct Streams;
+    std::unique_ptr<Streams> streams_;
 };
 
 /**
  * @brief BZIP2 compressor (better ratio, slower)
+ *
+ * Uses bzip3, whose frame header stores the block count up front, so a
+ * compression stream must be given the total input size in begin().
+ * Streams buffer one block (1-8 MB depending on level), or one block per
+ * thread when working in parallel; bzip3 blocks are independent, so
+ * they are simply encoded (or decoded) concurrently and kept in order.
+ * Parallel one-shot decoding needs the size-taking decompress().
  */
 class Bzip2Compressor : public ICompressor {
 public:
+    Bzip2Compressor();
+    ~Bzip2Compressor() override;
+    
     std::string name() const override { return "bzip2"; }
     
     CompressionResult compress(
@@ -109,13 +315,40 @@ class Bzip2Compressor : public ICompressor {
     CompressionResult decompress(
         std::span<const uint8_t> input
     ) override;
+    
+    CompressionResult decompress(
+        std::span<const uint8_t> input,
+        size_t expected_size
+    ) override;
+    
+    bool begin(StreamMode mode, int level = 6,
+               std::optional<uint64_t> input_size = std::nullopt) override;
+    bool update(std::span<const uint8_t> input, std::vector<uint8_t>& output) override;
+    bool finish(std::vector<uint8_t>& output) override;
+
+private:
+    struct Streams;
+    std::unique_ptr<Streams> streams_;
 };
 
 /**
  * @brief LZMA compressor (maximum compression, slowest)
+ *
+ * Keeps its encoder/decoder between calls; liblzma reuses the dictionary
+ * and match-finder allocations when re-initialised with the same settings.
+ * The one-shot calls share them with begin()/update()/finish().
+ * With several threads liblzma's multithreaded encoder is used, which
+ * writes a standard multi-block .xz stream; the thread count is lowered
+ * if its memory use would exceed a quarter of physical RAM (as xz -T0).
+ * Decoding uses the threaded decoder of liblzma 5.4 and later, which
+ * spreads the blocks of such streams over the threads.
+ * Not thread-safe: use one instance per thread.
  */
 class LzmaCompressor : public ICompressor {
 public:
+    LzmaCompressor();
+    ~LzmaCompressor() override;
+    
     std::string name() const override { return "lzma"; }
     
     CompressionResult compress(
@@ -126,6 +359,104 @@ class LzmaCompressor : public ICompressor {
     CompressionResult decompress(
         std::span<const uint8_t> input
     ) override;
+    
+    CompressionResult decompress(
+        std::span<const uint8_t> input,
+        size_t expected_size
+    ) override;
+    
+    bool begin(StreamMode mode, int level = 6,
+               std::optional<uint64_t> input_size = std::nullopt) override;
+    bool update(std::span<const uint8_t> input, std::vector<uint8_t>& output) override;
+    bool finish(std::vector<uint8_t>& output) override;
+
+private:
+    struct Streams;
+    std::unique_ptr<Streams> streams_;
+};
+
+/**
+ * @brief Zstandard compressor (fast, zlib-or-better ratio)
+ *
+ * Levels 1-6 are zstd levels 1-6; 7-9 step up to 9, 15 and 19 and turn on
+ * long-distance matching over a 128 MB window, which the zstd tool still
+ * decodes with its default limits. Worker threads use zstd's own
+ * multithreading (serial if libzstd was built without it).
+ * Output is standard .zst frames with a content checksum.
+ * A dictionary is digested once per level and reused for every frame,
+ * which is what makes it pay off for many small inputs.
+ * Not thread-safe: use one instance per thread.
+ */
+class ZstdCompressor : public ICompressor {
+public:
+    ZstdCompressor();
+    ~ZstdCompressor() override;
+    
+    std::string name() const override { return "zstd"; }
+    bool set_dictionary(std::span<const uint8_t> dictionary) override;
+    
+    CompressionResult compress(
+        std::span<const uint8_t> input,
+        int level = 6
+    ) override;
+    
+    CompressionResult decompress(
+        std::span<const uint8_t> input
+    ) override;
+    
+    CompressionResult decompress(
+        std::span<const uint8_t> input,
+        size_t expected_size
+    ) override;
+    
+    bool begin(StreamMode mode, int level = 6,
+               std::optional<uint64_t> input_size = std::nullopt) override;
+    bool update(std::span<const uint8_t> input, std::vector<uint8_t>& output) override;
+    bool finish(std::vector<uint8_t>& output) override;
+
+private:
+    struct Streams;
+    std::unique_ptr<Streams> streams_;
+};
+
+/**
+ * @brief LZ4 compressor (fastest, lowest ratio)
+ *
+ * Writes the standard LZ4 frame format (.lz4) with 4 MB linked blocks and
+ * a content checksum. Levels 1-3 use the fast compressor, 4-9 LZ4HC
+ * levels 7-12. Compression is always serial: it already runs well ahead
+ * of the AEAD ciphers.
+ * Not thread-safe: use one instance per thread.
+ */
+class Lz4Compressor : public ICompressor {
+public:
+    Lz4Compressor();
+    ~Lz4Compressor() override;
+    
+    std::string name() const override { return "lz4"; }
+    
+    CompressionResult compress(
+        std::span<const uint8_t> input,
+        int level = 6
+    ) override;
+    
+    CompressionResult decompress(
+        std::span<const uint8_t> input
+    ) override;
+    
+    CompressionResult decompress(
+        std::span<const uint8_t> input,
+        size_t expected_size
+    ) override;
+    
+    bool begin(StreamMode mode, int level = 6,
+               std::optional<uint64_t> input_size = std::nullopt) override;
+    bool update(std::span<const uint8_t> input, std::vector<uint8_t>& output) override;
+    bool finish(std::vector<uint8_t>& output) override;
+
+private:
+    struct Streams;
+    std::unique_ptr<Streams> streams_;
 };
 
 } // namespace compression
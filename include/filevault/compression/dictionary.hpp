@@ -0,0 +1,69 @@
+#ifndef FILEVAULT_COMPRESSION_DICTIONARY_HPP
+#define FILEVAULT_COMPRESSION_DICTIONARY_HPP
+
+#include "filevault/core/result.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace filevault {
+namespace compression {
+
+/**
+ * @brief Directory of trained compression dictionaries, keyed by ID
+ *
+ * Each dictionary is stored once as <dir>/<id>.dict, with the ID (as 8
+ * hex digits) taken from the dictionary itself. Encrypted files only
+ * record the ID, so the same store must be available to decrypt them.
+ */
+class DictionaryStore {
+public:
+    /**
+     * @param directory Store location (created on first save)
+     */
+    explicit DictionaryStore(std::filesystem::path directory);
+    
+    /**
+     * @brief Add a trained dictionary
+     * @return Its ID; saving one that is already stored is a no-op
+     */
+    core::Result<uint32_t> save(std::span<const uint8_t> dictionary);
+    
+    /**
+     * @brief Load a dictionary by ID
+     */
+    core::Result<std::vector<uint8_t>> load(uint32_t id) const;
+    
+    /**
+     * @brief IDs of all stored dictionaries, in ascending order
+     */
+    std::vector<uint32_t> list() const;
+    
+    /**
+     * @brief File a dictionary ID is stored in
+     */
+    std::filesystem::path path_for(uint32_t id) const;
+    
+    /**
+     * @brief Format an ID as 8 hex digits
+     */
+    static std::string format_id(uint32_t id);
+    
+    /**
+     * @brief Parse an ID written by format_id() (with or without "0x")
+     * @return 0 if text is not a valid ID
+     */
+    static uint32_t parse_id(const std::string& text);
+    
+    const std::filesystem::path& directory() const { return directory_; }
+
+private:
+    std::filesystem::path directory_;
+};
+
+} // namespace compression
+} // namespace filevault
+
+#endif // FILEVAULT_COMPRESSION_DICTIONARY_HPP
@@ -0,0 +1,105 @@
+#ifndef FILEVAULT_COMPRESSION_SEEKABLE_HPP
+#define FILEVAULT_COMPRESSION_SEEKABLE_HPP
+
+#include "filevault/core/result.hpp"
+#include "filevault/core/types.hpp"
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace filevault {
+namespace compression {
+
+/**
+ * @brief One independently compressed frame of a seekable file
+ */
+struct SeekableFrame {
+    uint64_t compressed_offset = 0;     // Start in the compressed file
+    uint64_t decompressed_offset = 0;   // Start in the original data
+    uint32_t compressed_size = 0;
+    uint32_t decompressed_size = 0;
+};
+
+/**
+ * @brief Compressed files that can be read from the middle
+ *
+ * The input is cut into frames of a fixed size, each compressed on its
+ * own, and a seek table is appended in the zstd seekable format:
+ *
+ *   [frame 0]...[frame N-1]
+ *   [0x184D2A5E][table size][N x (compressed u32, decompressed u32)]
+ *   [N u32][descriptor u8][0x8F92EAB1]            (all little-endian)
+ *
+ * The table is a skippable frame, so with zstd the file is a standard
+ * seekable .zst that the zstd tool decompresses whole and its seekable
+ * library reads by range; lz4 skips the same frames. For zlib, bzip3 and
+ * xz the frames are streams of that format followed by the table, which
+ * only FileVault reads. Tables written elsewhere with per-frame checksums
+ * are accepted; the checksums are not verified, as each frame already
+ * carries its format's own.
+ *
+ * Frames are compressed and decompressed in parallel, a frame per
+ * thread, and reading a range only touches the frames that cover it.
+ */
+class SeekableCompression {
+public:
+    static constexpr uint32_t SKIPPABLE_MAGIC = 0x184D2A5E;
+    static constexpr uint32_t SEEKABLE_MAGIC = 0x8F92EAB1;
+    static constexpr size_t FOOTER_SIZE = 9;
+    static constexpr uint64_t DEFAULT_FRAME_SIZE = 4ull * 1024 * 1024;
+    static constexpr uint64_t MAX_FRAME_SIZE = 1ull << 30;      // Sizes are stored as u32
+    static constexpr uint64_t TO_END = std::numeric_limits<uint64_t>::max();
+
+    /**
+     * @brief Compress a file into seekable frames
+     * @param frame_size Uncompressed bytes per frame (1 to MAX_FRAME_SIZE)
+     * @param threads Frames compressed at once (0 = one per core)
+     * @return Bytes written to output_path; on failure the output is removed
+     *
+     * Memory use is about threads x frame_size.
+     */
+    static core::Result<uint64_t> compress_file(
+        core::CompressionType type,
+        const std::string& input_path,
+        const std::string& output_path,
+        int level = 6,
+        uint64_t frame_size = DEFAULT_FRAME_SIZE,
+        size_t threads = 0
+    );
+
+    /**
+     * @brief Read the seek table at the end of a file
+     * @return Frames in order; fails if the file has no valid table
+     */
+    static core::Result<std::vector<SeekableFrame>> read_index(const std::string& path);
+
+    /**
+     * @brief Whether a file ends with a seek table
+     */
+    static bool is_seekable(const std::string& path);
+
+    /**
+     * @brief Decompress a byte range of the original data
+     * @param offset First byte of the original data
+     * @param length Bytes to produce (TO_END = up to the end)
+     * @param threads Frames decompressed at once (0 = one per core)
+     * @return Bytes written to output_path; on failure the output is removed
+     *
+     * Only the frames overlapping the range are read. A range reaching
+     * past the end is cut short; one starting past it is an error.
+     */
+    static core::Result<uint64_t> decompress_file(
+        core::CompressionType type,
+        const std::string& input_path,
+        const std::string& output_path,
+        uint64_t offset = 0,
+        uint64_t length = TO_END,
+        size_t threads = 0
+    );
+};
+
+} // namespace compression
+} // namespace filevault
+
+#endif // FILEVAULT_COMPRESSION_SEEKABLE_HPP
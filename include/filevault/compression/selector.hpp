@@ -0,0 +1,80 @@
+#ifndef FILEVAULT_COMPRESSION_SELECTOR_HPP
+#define FILEVAULT_COMPRESSION_SELECTOR_HPP
+
+#include "filevault/compression/compressor.hpp"
+#include "filevault/core/result.hpp"
+#include "filevault/core/types.hpp"
+#include <cstdint>
+#include <istream>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace filevault {
+namespace compression {
+
+/**
+ * @brief Algorithm and level picked for an input, with what the sample showed
+ */
+struct CompressionChoice {
+    core::CompressionType type = core::CompressionType::NONE;
+    int level = 0;
+    double ratio = 1.0;             // Sample size / compressed size
+    double compress_mbps = 0.0;     // Single-thread throughput on the sample
+};
+
+/**
+ * @brief Picks a compressor by trial-compressing a sample of the input
+ *
+ * Used for "--compression auto". A few evenly spaced blocks (256 KB in
+ * total) are compressed with every algorithm at levels 1 and 6, and the
+ * best ratio among those that sustain the throughput target wins. Level 6
+ * is skipped once level 1 of the same algorithm misses the target, so the
+ * slow codecs are only tried when the target allows them; selection takes
+ * a few milliseconds at the default target.
+ */
+class CompressionSelector {
+public:
+    static constexpr double DEFAULT_MIN_MBPS = 200.0;
+    
+    /**
+     * @brief Evenly spaced blocks of data (all of it if small)
+     */
+    static std::vector<uint8_t> sample(std::span<const uint8_t> data);
+    
+    /**
+     * @brief Same as sample(), reading only the sampled blocks of a file
+     */
+    static core::Result<std::vector<uint8_t>> sample_file(const std::string& path);
+    
+    /**
+     * @brief Same as sample(), reading from a seekable stream of known size
+     *
+     * The stream position is left unspecified; seek before reusing it.
+     */
+    static core::Result<std::vector<uint8_t>> sample_stream(std::istream& input, uint64_t size);
+    
+    /**
+     * @brief Choose the best-compressing candidate at or above min_mbps
+     * @return NONE if the sample looks incompressible, no candidate saves
+     *         at least 2%, or none is fast enough
+     */
+    static CompressionChoice select(std::span<const uint8_t> sample, double min_mbps = DEFAULT_MIN_MBPS);
+    
+    /**
+     * @brief Average time of runs compressions of data, in milliseconds
+     * @param last Receives the result of the final run, if not null
+     */
+    static double time_compression(ICompressor& compressor, std::span<const uint8_t> data,
+                                   int level, int runs = 1, CompressionResult* last = nullptr);
+    
+    /**
+     * @brief Average time of runs decompressions of data, in milliseconds
+     */
+    static double time_decompression(ICompressor& compressor, std::span<const uint8_t> data, int runs = 1);
+};
+
+} // namespace compression
+} // namespace filevault
+
+#endif // FILEVAULT_COMPRESSION_SELECTOR_HPP
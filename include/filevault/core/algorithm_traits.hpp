@@ -0,0 +1,216 @@
+#ifndef FILEVAULT_CORE_ALGORITHM_TRAITS_HPP
+#define FILEVAULT_CORE_ALGORITHM_TRAITS_HPP
+
+#include "filevault/core/file_format.hpp"
+#include "filevault/core/types.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace filevault {
+namespace core {
+
+/**
+ * @brief Broad class of an algorithm, deciding how a file is keyed and sealed
+ */
+enum class AlgorithmFamily : uint8_t {
+    AEAD,           // Authenticated symmetric cipher, tag after the ciphertext
+    CIPHER,         // Unauthenticated symmetric mode (CBC, CTR, XTS, ...)
+    ASYMMETRIC,     // RSA / ECC hybrid, needs a public key
+    PQC_HYBRID,     // Kyber + X25519 hybrid, needs a public key
+    KEM,            // Bare key encapsulation, not a file cipher
+    SIGNATURE,      // Signature scheme, not a file cipher
+    CLASSICAL       // Educational ciphers
+};
+
+/**
+ * @brief Static properties of one AlgorithmType
+ *
+ * Sizes are in bytes. nonce_size is the IV/nonce the mode consumes (0 when
+ * it takes none); tag_size is what follows the ciphertext on disk.
+ * `aliases` is a space-separated list of lowercase names parse_algorithm()
+ * accepts, the first being the canonical one.
+ */
+struct AlgorithmTraits {
+    AlgorithmType type;
+    std::string_view name;
+    std::string_view aliases;
+    AlgorithmID id;
+    AlgorithmFamily family;
+    uint16_t key_size;
+    uint8_t nonce_size;
+    uint8_t tag_size;
+    bool streaming;         // Usable with StreamingCrypto (per-chunk tags)
+
+    constexpr bool is_aead() const { return family == AlgorithmFamily::AEAD; }
+
+    constexpr bool needs_public_key() const {
+        return family == AlgorithmFamily::ASYMMETRIC || family == AlgorithmFamily::PQC_HYBRID;
+    }
+
+    constexpr bool is_file_cipher() const {
+        return family != AlgorithmFamily::KEM && family != AlgorithmFamily::SIGNATURE;
+    }
+};
+
+constexpr size_t ALGORITHM_COUNT = static_cast<size_t>(AlgorithmType::ECC_X25519) + 1;
+
+namespace detail {
+
+using T = AlgorithmType;
+using I = AlgorithmID;
+using F = AlgorithmFamily;
+
+// Rows follow the declaration order of AlgorithmType (checked below)
+inline constexpr std::array<AlgorithmTraits, ALGORITHM_COUNT> ALGORITHM_TABLE = {{
+    // type                  name                 aliases                                        id                    family        key nonce tag streaming
+    {T::AES_128_GCM,       "AES-128-GCM",       "aes-128-gcm aes128gcm",                       I::AES_128_GCM,       F::AEAD,        16, 12, 16, true},
+    {T::AES_192_GCM,       "AES-192-GCM",       "aes-192-gcm aes192gcm",                       I::AES_192_GCM,       F::AEAD,        24, 12, 16, true},
+    {T::AES_256_GCM,       "AES-256-GCM",       "aes-256-gcm aes256gcm aes aes256",            I::AES_256_GCM,       F::AEAD,        32, 12, 16, true},
+    {T::CHACHA20_POLY1305, "ChaCha20-Poly1305", "chacha20-poly1305 chacha20 chacha",           I::CHACHA20_POLY1305, F::AEAD,        32, 12, 16, true},
+    {T::SERPENT_256_GCM,   "Serpent-256-GCM",   "serpent-256-gcm serpent serpent256",          I::SERPENT_256_GCM,   F::AEAD,        32, 12, 16, true},
+    {T::TWOFISH_128_GCM,   "Twofish-128-GCM",   "twofish-128-gcm twofish128",                  I::TWOFISH_128_GCM,   F::AEAD,        16, 12, 16, true},
+    {T::TWOFISH_192_GCM,   "Twofish-192-GCM",   "twofish-192-gcm twofish192",                  I::TWOFISH_192_GCM,   F::AEAD,        24, 12, 16, true},
+    {T::TWOFISH_256_GCM,   "Twofish-256-GCM",   "twofish-256-gcm twofish twofish256",          I::TWOFISH_256_GCM,   F::AEAD,        32, 12, 16, true},
+    {T::CAMELLIA_128_GCM,  "Camellia-128-GCM",  "camellia-128-gcm camellia128",                I::CAMELLIA_128_GCM,  F::AEAD,        16, 12, 16, true},
+    {T::CAMELLIA_192_GCM,  "Camellia-192-GCM",  "camellia-192-gcm camellia192",                I::CAMELLIA_192_GCM,  F::AEAD,        24, 12, 16, true},
+    {T::CAMELLIA_256_GCM,  "Camellia-256-GCM",  "camellia-256-gcm camellia camellia256",       I::CAMELLIA_256_GCM,  F::AEAD,        32, 12, 16, true},
+    {T::ARIA_128_GCM,      "ARIA-128-GCM",      "aria-128-gcm aria128",                        I::ARIA_128_GCM,      F::AEAD,        16, 12, 16, true},
+    {T::ARIA_192_GCM,      "ARIA-192-GCM",      "aria-192-gcm aria192",                        I::ARIA_192_GCM,      F::AEAD,        24, 12, 16, true},
+    {T::ARIA_256_GCM,      "ARIA-256-GCM",      "aria-256-gcm aria aria256",                   I::ARIA_256_GCM,      F::AEAD,        32, 12, 16, true},
+    {T::SM4_GCM,           "SM4-GCM",           "sm4-gcm sm4",                                 I::SM4_GCM,           F::AEAD,        16, 12, 16, true},
+    {T::AES_128_CBC,       "AES-128-CBC",       "aes-128-cbc aes128cbc",                       I::AES_128_CBC,       F::CIPHER,      16, 16,  0, false},
+    {T::AES_192_CBC,       "AES-192-CBC",       "aes-192-cbc aes192cbc",                       I::AES_192_CBC,       F::CIPHER,      24, 16,  0, false},
+    {T::AES_256_CBC,       "AES-256-CBC",       "aes-256-cbc aes256cbc",                       I::AES_256_CBC,       F::CIPHER,      32, 16,  0, false},
+    {T::AES_128_CTR,       "AES-128-CTR",       "aes-128-ctr aes128ctr",                       I::AES_128_CTR,       F::CIPHER,      16, 16,  0, false},
+    {T::AES_192_CTR,       "AES-192-CTR",       "aes-192-ctr aes192ctr",                       I::AES_192_CTR,       F::CIPHER,      24, 16,  0, false},
+    {T::AES_256_CTR,       "AES-256-CTR",       "aes-256-ctr aes256ctr",                       I::AES_256_CTR,       F::CIPHER,      32, 16,  0, false},
+    {T::AES_128_CFB,       "AES-128-CFB",       "aes-128-cfb aes128cfb",                       I::AES_128_CFB,       F::CIPHER,      16, 16,  0, false},
+    {T::AES_192_CFB,       "AES-192-CFB",       "aes-192-cfb aes192cfb",                       I::AES_192_CFB,       F::CIPHER,      24, 16,  0, false},
+    {T::AES_256_CFB,       "AES-256-CFB",       "aes-256-cfb aes256cfb",                       I::AES_256_CFB,       F::CIPHER,      32, 16,  0, false},
+    {T::AES_128_OFB,       "AES-128-OFB",       "aes-128-ofb aes128ofb",                       I::AES_128_OFB,       F::CIPHER,      16, 16,  0, false},
+    {T::AES_192_OFB,       "AES-192-OFB",       "aes-192-ofb aes192ofb",                       I::AES_192_OFB,       F::CIPHER,      24, 16,  0, false},
+    {T::AES_256_OFB,       "AES-256-OFB",       "aes-256-ofb aes256ofb",                       I::AES_256_OFB,       F::CIPHER,      32, 16,  0, false},
+    {T::AES_128_ECB,       "AES-128-ECB",       "aes-128-ecb aes128ecb",                       I::AES_128_ECB,       F::CIPHER,      16,  0,  0, false},
+    {T::AES_192_ECB,       "AES-192-ECB",       "aes-192-ecb aes192ecb",                       I::AES_192_ECB,       F::CIPHER,      24,  0,  0, false},
+    {T::AES_256_ECB,       "AES-256-ECB",       "aes-256-ecb aes256ecb",                       I::AES_256_ECB,       F::CIPHER,      32,  0,  0, false},
+    {T::AES_128_XTS,       "AES-128-XTS",       "aes-128-xts aes128xts",                       I::AES_128_XTS,       F::CIPHER,      32, 16,  0, false},
+    {T::AES_256_XTS,       "AES-256-XTS",       "aes-256-xts aes256xts xts",                   I::AES_256_XTS,       F::CIPHER,      64, 16,  0, false},
+    {T::TRIPLE_DES_CBC,    "3DES-CBC",          "3des 3des-cbc tripledes triple-des",          I::TRIPLE_DES_CBC,    F::CIPHER,      24,  8,  0, false},
+    {T::RSA_2048,          "RSA-2048",          "rsa-2048 rsa2048",                            I::RSA_2048,          F::ASYMMETRIC, 256,  0,  0, false},
+    {T::RSA_3072,          "RSA-3072",          "rsa-3072 rsa3072",                            I::RSA_3072,          F::ASYMMETRIC, 384,  0,  0, false},
+    {T::RSA_4096,          "RSA-4096",          "rsa-4096 rsa4096 rsa",                        I::RSA_4096,          F::ASYMMETRIC, 512,  0,  0, false},
+    {T::ECC_P256,          "ECC-P256",          "ecc-p256 eccp256 p256 secp256r1",             I::ECC_P256,          F::ASYMMETRIC,  32,  0,  0, false},
+    {T::ECC_P384,          "ECC-P384",          "ecc-p384 eccp384 p384 secp384r1",             I::ECC_P384,          F::ASYMMETRIC,  48,  0,  0, false},
+    {T::ECC_P521,          "ECC-P521",          "ecc-p521 eccp521 p521 secp521r1 ecc",         I::ECC_P521,          F::ASYMMETRIC,  66,  0,  0, false},
+    {T::CAESAR,            "Caesar",            "caesar",                                      I::CAESAR,            F::CLASSICAL,    4,  0,  0, false},
+    {T::VIGENERE,          "Vigenère",          "vigenere vigenère",                           I::VIGENERE,          F::CLASSICAL,   32,  0,  0, false},
+    {T::PLAYFAIR,          "Playfair",          "playfair",                                    I::PLAYFAIR,          F::CLASSICAL,   32,  0,  0, false},
+    {T::SUBSTITUTION,      "Substitution",      "substitution sub",                            I::SUBSTITUTION,      F::CLASSICAL,   26,  0,  0, false},
+    {T::HILL,              "Hill",              "hill",                                        I::HILL,              F::CLASSICAL,    4,  0,  0, false},
+    {T::KYBER_512,         "Kyber-512",         "kyber-512 kyber512",                          I::UNKNOWN,           F::KEM,         32,  0,  0, false},
+    {T::KYBER_768,         "Kyber-768",         "kyber-768 kyber768",                          I::UNKNOWN,           F::KEM,         32,  0,  0, false},
+    {T::KYBER_1024,        "Kyber-1024",        "kyber-1024 kyber1024 kyber",                  I::UNKNOWN,           F::KEM,         32,  0,  0, false},
+    {T::DILITHIUM_2,       "Dilithium-2",       "dilithium-2 dilithium2",                      I::UNKNOWN,           F::SIGNATURE,    0,  0,  0, false},
+    {T::DILITHIUM_3,       "Dilithium-3",       "dilithium-3 dilithium3",                      I::UNKNOWN,           F::SIGNATURE,    0,  0,  0, false},
+    {T::DILITHIUM_5,       "Dilithium-5",       "dilithium-5 dilithium5 dilithium",            I::UNKNOWN,           F::SIGNATURE,    0,  0,  0, false},
+    {T::KYBER_512_HYBRID,  "Kyber-512-Hybrid",  "kyber-512-hybrid kyber512hybrid",             I::UNKNOWN,           F::PQC_HYBRID,  32,  0,  0, false},
+    {T::KYBER_768_HYBRID,  "Kyber-768-Hybrid",  "kyber-768-hybrid kyber768hybrid",             I::UNKNOWN,           F::PQC_HYBRID,  32,  0,  0, false},
+    {T::KYBER_1024_HYBRID, "Kyber-1024-Hybrid", "kyber-1024-hybrid kyber1024hybrid kyber-hybrid", I::UNKNOWN,        F::PQC_HYBRID,  32,  0,  0, false},
+    {T::AEGIS_256,         "AEGIS-256",         "aegis-256 aegis256 aegis",                    I::AEGIS_256,         F::AEAD,        32, 32, 16, true},
+    {T::AES_256_OCB,       "AES-256-OCB",       "aes-256-ocb aes256ocb ocb",                   I::AES_256_OCB,       F::AEAD,        32, 12, 16, true},
+    {T::AES_256_SIV,       "AES-256-SIV",       "aes-256-siv aes256siv siv",                   I::AES_256_SIV,       F::AEAD,        64, 12, 16, true},
+    {T::ECC_X25519,        "ECC-X25519",        "ecc-x25519 eccx25519 x25519 curve25519",      I::ECC_X25519,        F::ASYMMETRIC,  32,  0,  0, false},
+}};
+
+constexpr bool table_in_enum_order() {
+    for (size_t i = 0; i < ALGORITHM_TABLE.size(); ++i) {
+        if (static_cast<size_t>(ALGORITHM_TABLE[i].type) != i) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(table_in_enum_order(), "ALGORITHM_TABLE rows must follow AlgorithmType order");
+
+// AlgorithmID byte -> table row, ALGORITHM_COUNT where no type uses the ID
+constexpr std::array<uint8_t, 256> build_id_index() {
+    std::array<uint8_t, 256> index{};
+    for (auto& slot : index) {
+        slot = static_cast<uint8_t>(ALGORITHM_COUNT);
+    }
+    for (size_t i = 0; i < ALGORITHM_TABLE.size(); ++i) {
+        if (ALGORITHM_TABLE[i].id != AlgorithmID::UNKNOWN) {
+            index[static_cast<uint8_t>(ALGORITHM_TABLE[i].id)] = static_cast<uint8_t>(i);
+        }
+    }
+    return index;
+}
+static_assert(ALGORITHM_COUNT < 256, "ID index stores rows in one byte");
+
+inline constexpr std::array<uint8_t, 256> ALGORITHM_ID_INDEX = build_id_index();
+
+} // namespace detail
+
+/**
+ * @brief Traits of an algorithm: one indexed load
+ */
+constexpr const AlgorithmTraits& algorithm_traits(AlgorithmType type) {
+    return detail::ALGORITHM_TABLE[static_cast<size_t>(type)];
+}
+
+/**
+ * @brief Traits as a compile-time constant, for per-cipher template paths
+ */
+template<AlgorithmType Type>
+inline constexpr const AlgorithmTraits& algorithm_traits_v = detail::ALGORITHM_TABLE[static_cast<size_t>(Type)];
+
+/**
+ * @brief Traits of the algorithm stored under an on-disk ID
+ * @return nullptr for UNKNOWN or IDs no algorithm uses
+ */
+constexpr const AlgorithmTraits* find_algorithm(AlgorithmID id) {
+    auto row = detail::ALGORITHM_ID_INDEX[static_cast<uint8_t>(id)];
+    return row < ALGORITHM_COUNT ? &detail::ALGORITHM_TABLE[row] : nullptr;
+}
+
+/**
+ * @brief Traits of the algorithm with a given alias
+ * @param lower Name already folded to lowercase
+ */
+constexpr const AlgorithmTraits* find_algorithm(std::string_view lower) {
+    for (const auto& traits : detail::ALGORITHM_TABLE) {
+        std::string_view aliases = traits.aliases;
+        while (!aliases.empty()) {
+            auto end = aliases.find(' ');
+            if (aliases.substr(0, end) == lower) {
+                return &traits;
+            }
+            if (end == std::string_view::npos) {
+                break;
+            }
+            aliases.remove_prefix(end + 1);
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief All algorithms, in AlgorithmType order
+ */
+constexpr const std::array<AlgorithmTraits, ALGORITHM_COUNT>& all_algorithms() {
+    return detail::ALGORITHM_TABLE;
+}
+
+static_assert(algorithm_traits_v<AlgorithmType::AES_256_GCM>.is_aead());
+static_assert(find_algorithm(AlgorithmID::SM4_GCM)->type == AlgorithmType::SM4_GCM);
+static_assert(find_algorithm("aes")->type == AlgorithmType::AES_256_GCM);
+static_assert(find_algorithm(AlgorithmID::AES_256_SIV)->type == AlgorithmType::AES_256_SIV);
+static_assert(find_algorithm("x25519")->type == AlgorithmType::ECC_X25519);
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_ALGORITHM_TRAITS_HPP
@@ -0,0 +1,208 @@
+#ifndef FILEVAULT_CORE_ASYNC_HPP
+#define FILEVAULT_CORE_ASYNC_HPP
+
+#include "filevault/compression/compressor.hpp"
+#include "filevault/core/crypto_algorithm.hpp"
+#include "filevault/core/executor.hpp"
+#include "filevault/core/result.hpp"
+#include "filevault/core/streaming.hpp"
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace filevault {
+namespace core {
+
+/**
+ * @brief Where an asynchronous operation runs and how it reports back
+ */
+struct AsyncOptions {
+    Executor* executor = nullptr;               // nullptr = Executor::shared()
+    TaskPriority priority = TaskPriority::NORMAL;
+
+    /**
+     * Cancels the operation if it has not started; streaming operations
+     * also stop between chunks. Either way the result is TaskCancelled.
+     */
+    CancellationToken token;
+
+    /**
+     * Runs the completion (the resumed coroutine or the start() handler)
+     * and progress events, e.g. on the caller's event loop:
+     *   [&io](std::function<void()> job) { asio::post(io, std::move(job)); }
+     * Unset, they run on the executor worker that produced them.
+     */
+    std::function<void(std::function<void()>)> dispatch;
+
+    /**
+     * Per-chunk progress of streaming operations, through dispatch
+     */
+    std::function<void(const ChunkInfo&)> on_progress;
+};
+
+/**
+ * @brief Blocking work run on an Executor, awaitable from a coroutine
+ *
+ * Nothing runs until the operation is awaited or start()ed:
+ *
+ *   StreamingResult result = co_await AsyncCrypto::encrypt_file(in, out, password);
+ *
+ * The awaiting coroutine is suspended without holding a thread and is
+ * resumed through options.dispatch (or on the worker) when the work is
+ * done; exceptions from the work, including TaskCancelled, are rethrown
+ * from the co_await. Coroutine frameworks that only await their own
+ * types (asio::awaitable) use start() instead, whose handler has the
+ * (std::exception_ptr, T) shape that asio::async_initiate adapts.
+ *
+ * The work itself is synchronous: each running operation occupies one
+ * worker, and operations beyond the executor's size wait in its queue
+ * without a thread of their own. Give long file operations an executor of
+ * their own (options.executor) to keep them from crowding out the chunk
+ * tasks that Executor::shared() runs for every caller. T must be
+ * default-constructible.
+ */
+template<typename T>
+class AsyncOperation {
+public:
+    using Handler = std::function<void(std::exception_ptr, T)>;
+
+    AsyncOperation(std::function<T()> work, AsyncOptions options)
+        : state_(std::make_shared<State>()) {
+        state_->work = std::move(work);
+        state_->options = std::move(options);
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        launch(state_, [handle]() { handle.resume(); });
+    }
+
+    T await_resume() {
+        if (state_->error) {
+            std::rethrow_exception(state_->error);
+        }
+        return std::move(state_->value);
+    }
+
+    /**
+     * @brief Run with a completion handler instead of co_await
+     */
+    void start(Handler handler) {
+        auto state = state_;
+        launch(state, [state, handler = std::move(handler)]() {
+            handler(state->error, std::move(state->value));
+        });
+    }
+
+private:
+    struct State {
+        std::function<T()> work;
+        AsyncOptions options;
+        T value{};
+        std::exception_ptr error;
+    };
+
+    // Shared with the queued task: the awaiter may be gone once resumed
+    static void launch(std::shared_ptr<State> state, std::function<void()> complete) {
+        auto& executor = state->options.executor ? *state->options.executor : Executor::shared();
+        auto priority = state->options.priority;
+        executor.post([state, complete = std::move(complete)]() {
+            if (state->options.token.cancelled()) {
+                state->error = std::make_exception_ptr(TaskCancelled());
+            } else {
+                try {
+                    state->value = state->work();
+                } catch (...) {
+                    state->error = std::current_exception();
+                }
+            }
+            state->work = nullptr;
+            if (state->options.dispatch) {
+                state->options.dispatch(complete);
+            } else {
+                complete();
+            }
+        }, priority);
+    }
+
+    std::shared_ptr<State> state_;
+};
+
+/**
+ * @brief Run any blocking call as an AsyncOperation
+ */
+template<typename F>
+auto run_async(F&& work, AsyncOptions options = {}) -> AsyncOperation<std::invoke_result_t<std::decay_t<F>>> {
+    using R = std::invoke_result_t<std::decay_t<F>>;
+    static_assert(!std::is_void_v<R>, "run_async needs a result to hand back");
+    return AsyncOperation<R>(std::function<R()>(std::forward<F>(work)), std::move(options));
+}
+
+/**
+ * @brief Awaitable forms of the blocking library calls
+ *
+ * Buffers are taken by value and kept alive by the operation; references
+ * (an algorithm) must outlive it.
+ */
+class AsyncCrypto {
+public:
+    /**
+     * @brief StreamingCrypto::encrypt_file() with progress events and mid-stream cancellation
+     */
+    static AsyncOperation<StreamingResult> encrypt_file(std::string input_path, std::string output_path,
+                                                        std::string password, StreamingConfig config = {},
+                                                        AsyncOptions options = {});
+
+    /**
+     * @brief StreamingCrypto::decrypt_file() with progress events and mid-stream cancellation
+     */
+    static AsyncOperation<StreamingResult> decrypt_file(std::string input_path, std::string output_path,
+                                                        std::string password, size_t worker_threads = 1,
+                                                        AsyncOptions options = {});
+
+    /**
+     * @brief ICryptoAlgorithm::encrypt() on a buffer
+     */
+    static AsyncOperation<CryptoResult> encrypt(ICryptoAlgorithm& algorithm, std::vector<uint8_t> plaintext,
+                                                std::vector<uint8_t> key, EncryptionConfig config,
+                                                AsyncOptions options = {});
+
+    /**
+     * @brief ICryptoAlgorithm::decrypt() on a buffer
+     */
+    static AsyncOperation<CryptoResult> decrypt(ICryptoAlgorithm& algorithm, std::vector<uint8_t> ciphertext,
+                                                std::vector<uint8_t> key, EncryptionConfig config,
+                                                AsyncOptions options = {});
+
+    /**
+     * @brief One-shot compression with a CompressionService compressor
+     */
+    static AsyncOperation<compression::CompressionResult> compress(CompressionType type, std::vector<uint8_t> data,
+                                                                   int level = 6, AsyncOptions options = {});
+
+    static AsyncOperation<compression::CompressionResult> decompress(CompressionType type,
+                                                                     std::vector<uint8_t> data,
+                                                                     AsyncOptions options = {});
+
+    /**
+     * @brief FileIO::read_file()
+     */
+    static AsyncOperation<Result<std::vector<uint8_t>>> read_file(std::string path, AsyncOptions options = {});
+
+    /**
+     * @brief FileIO::write_file() (atomic replace)
+     */
+    static AsyncOperation<Result<void>> write_file(std::string path, std::vector<uint8_t> data,
+                                                   AsyncOptions options = {});
+};
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_ASYNC_HPP
@@ -0,0 +1,88 @@
+#ifndef FILEVAULT_CORE_BOUNDED_QUEUE_HPP
+#define FILEVAULT_CORE_BOUNDED_QUEUE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace filevault {
+namespace core {
+
+/**
+ * @brief Blocking FIFO with a fixed capacity
+ *
+ * Used to hand buffers between pipeline stages (e.g. a reader thread and
+ * the crypto loop) without letting the producer run arbitrarily far ahead.
+ * close() wakes all waiters: push() then fails and pop() drains what is
+ * left before returning std::nullopt.
+ */
+template<typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity)
+        : capacity_(capacity > 0 ? capacity : 1) {}
+
+    // Prevent copying
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * @brief Append an item, blocking while the queue is full
+     * @return false if the queue was closed
+     */
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this]() { return closed_ || items_.size() < capacity_; });
+        if (closed_) {
+            return false;
+        }
+        items_.push_back(std::move(item));
+        lock.unlock();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Remove the oldest item, blocking while the queue is empty
+     * @return Item, or std::nullopt once closed and drained
+     */
+    std::optional<T> pop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this]() { return closed_ || !items_.empty(); });
+        if (items_.empty()) {
+            return std::nullopt;
+        }
+        T item = std::move(items_.front());
+        items_.pop_front();
+        lock.unlock();
+        not_full_.notify_one();
+        return item;
+    }
+
+    /**
+     * @brief Stop accepting items and wake all waiters
+     */
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+private:
+    size_t capacity_;
+    std::deque<T> items_;
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    bool closed_ = false;
+};
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_BOUNDED_QUEUE_HPP
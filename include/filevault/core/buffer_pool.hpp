@@ -0,0 +1,115 @@
+#ifndef FILEVAULT_CORE_BUFFER_POOL_HPP
+#define FILEVAULT_CORE_BUFFER_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace filevault {
+namespace core {
+
+/**
+ * @brief Thread-safe cache of byte buffers keyed by capacity
+ *
+ * Streaming processes the same chunk sizes over and over; recycling the
+ * chunk, compression and ciphertext buffers avoids a malloc/free (and the
+ * page faults of a fresh 64-256MB allocation) per chunk.
+ *
+ * Buffers that held plaintext are scrubbed on release unless the caller
+ * says otherwise.
+ *
+ * With NUMA placement on (Numa::set_enabled), buffers are cached per node
+ * and a thread is handed memory on its own node; fresh allocations are
+ * placed there before first touch.
+ *
+ * With huge pages on, fresh buffers of HUGE_PAGE_SIZE or more are marked
+ * for transparent huge pages (MADV_HUGEPAGE): a 256MB chunk then needs
+ * 128 TLB entries instead of 65536. The kernel falls back to normal
+ * pages when it has no huge page free, or when THP is disabled.
+ */
+class BufferPool {
+public:
+    /**
+     * @brief Create pool
+     * @param max_cached_bytes Upper bound on total capacity kept for reuse
+     */
+    explicit BufferPool(size_t max_cached_bytes = DEFAULT_MAX_CACHED_BYTES);
+
+    // Prevent copying
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /**
+     * @brief Get an empty buffer with at least min_capacity reserved
+     *
+     * Reuses a cached buffer whose capacity is within 2x of the request,
+     * otherwise allocates a new one.
+     */
+    std::vector<uint8_t> acquire(size_t min_capacity);
+
+    /**
+     * @brief Return a buffer for reuse
+     * @param buffer Buffer to recycle (left empty)
+     * @param scrub Securely wipe contents first (set false for ciphertext)
+     */
+    void release(std::vector<uint8_t>&& buffer, bool scrub = true);
+
+    /**
+     * @brief Drop all cached buffers
+     */
+    void clear();
+
+    /**
+     * @brief Change the budget, dropping cached buffers that no longer fit
+     */
+    void set_max_cached_bytes(size_t max_cached_bytes);
+
+    /**
+     * @brief Mark fresh large buffers for transparent huge pages
+     */
+    void set_huge_pages(bool enabled);
+    bool huge_pages() const;
+
+    /**
+     * @brief Ask for huge pages on the 2MB-aligned part of [data, data + size)
+     * @return false if unsupported or nothing was aligned
+     */
+    static bool advise_huge_pages(void* data, size_t size);
+
+    /**
+     * @brief System THP mode: "always", "madvise", "never", or "" if not supported
+     */
+    static std::string transparent_huge_page_mode();
+
+    /**
+     * @brief Total capacity currently cached
+     */
+    size_t cached_bytes() const;
+    size_t max_cached_bytes() const;
+
+    /**
+     * @brief Process-wide pool shared by streaming, compression and ciphers
+     */
+    static BufferPool& shared();
+
+    // Buffers smaller than this are not worth caching
+    static constexpr size_t MIN_POOLED_CAPACITY = 4 * 1024;
+    static constexpr size_t DEFAULT_MAX_CACHED_BYTES = size_t(1024) * 1024 * 1024;  // 1GB
+    static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+private:
+    mutable std::mutex mutex_;
+    // Per NUMA node (a single entry without placement): capacity -> buffer
+    std::vector<std::multimap<size_t, std::vector<uint8_t>>> buffers_;
+    size_t cached_bytes_ = 0;
+    size_t max_cached_bytes_;
+    bool huge_pages_ = false;
+};
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_BUFFER_POOL_HPP
@@ -0,0 +1,53 @@
+#ifndef FILEVAULT_CORE_CHECKOUT_CACHE_HPP
+#define FILEVAULT_CORE_CHECKOUT_CACHE_HPP
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace filevault {
+namespace core {
+
+/**
+ * @brief Checkout pool of stateful workers
+ *
+ * Compressors and cipher sessions keep their setup (codec state, key
+ * schedule) between calls but are not thread-safe. Each task borrows one
+ * for a chunk and hands it back, so a run creates at most one per
+ * concurrently running task and pays the setup once instead of once per
+ * chunk.
+ */
+template<typename T>
+class CheckoutCache {
+public:
+    explicit CheckoutCache(std::function<std::unique_ptr<T>()> factory)
+        : factory_(std::move(factory)) {}
+    
+    std::unique_ptr<T> acquire() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!idle_.empty()) {
+                auto item = std::move(idle_.back());
+                idle_.pop_back();
+                return item;
+            }
+        }
+        return factory_();
+    }
+    
+    void release(std::unique_ptr<T> item) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_.push_back(std::move(item));
+    }
+
+private:
+    std::function<std::unique_ptr<T>()> factory_;
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<T>> idle_;
+};
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_CHECKOUT_CACHE_HPP
@@ -0,0 +1,92 @@
+#ifndef FILEVAULT_CORE_CHECKPOINT_HPP
+#define FILEVAULT_CORE_CHECKPOINT_HPP
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+
+namespace filevault {
+namespace core {
+
+/**
+ * @brief Progress of an interrupted streaming job, kept beside its output
+ *
+ * Written to "<output>.fvckpt" after the output has been flushed to disk,
+ * so everything it describes is durable. The input is identified by size
+ * and modification time; the committed output by its length and a digest
+ * chained over the tags of the committed chunk frames, which a resume
+ * recomputes from the file without any decryption.
+ *
+ * Sidecar layout (little-endian):
+ * [Magic "FVCP":4][Version:1][Operation:1][Reserved:2]
+ * [InputSize:8][InputMTime:8][ChunkSize:8][ChunksCommitted:8]
+ * [InputOffset:8][OutputOffset:8][BytesCommitted:8][TagDigest:32]
+ */
+struct Checkpoint {
+    enum class Operation : uint8_t {
+        ENCRYPT = 1,
+        DECRYPT = 2
+    };
+
+    Operation operation = Operation::ENCRYPT;
+    uint64_t input_size = 0;
+    int64_t input_mtime = 0;            // Filesystem clock ticks
+    uint64_t chunk_size = 0;
+    uint64_t chunks_committed = 0;
+    uint64_t input_offset = 0;          // Where reading continues
+    uint64_t output_offset = 0;         // Output length covered by the checkpoint
+    uint64_t bytes_committed = 0;       // Plaintext bytes in the committed chunks
+    std::array<uint8_t, 32> tag_digest{};
+
+    /**
+     * @brief Sidecar path of a job writing to output_path
+     */
+    static std::string path_for(const std::string& output_path) { return output_path + ".fvckpt"; }
+
+    /**
+     * @brief Fold one committed frame's tag into tag_digest
+     *
+     * tag_digest = SHA-256(tag_digest || tag), starting from all zeros.
+     */
+    void add_tag(std::span<const uint8_t> tag);
+
+    /**
+     * @brief Record the size and modification time of the job's input
+     * @return false if the file cannot be examined
+     */
+    bool stamp_input(const std::string& input_path);
+
+    /**
+     * @brief True if input_path still has the recorded size and time
+     */
+    bool matches_input(const std::string& input_path) const;
+
+    /**
+     * @brief Atomically replace the sidecar (temporary file, sync, rename)
+     */
+    bool save(const std::string& path) const;
+
+    /**
+     * @brief Read a sidecar; std::nullopt if missing or malformed
+     */
+    static std::optional<Checkpoint> load(const std::string& path);
+
+    /**
+     * @brief Delete the sidecar of a finished or abandoned job
+     */
+    static void remove(const std::string& path);
+};
+
+/**
+ * @brief Flush a file's data to stable storage (fsync / FlushFileBuffers)
+ *
+ * Streams must be flushed first; this only pushes what the OS holds.
+ */
+bool sync_file(const std::string& path);
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_CHECKPOINT_HPP
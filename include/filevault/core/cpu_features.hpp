@@ -0,0 +1,76 @@
+#ifndef FILEVAULT_CORE_CPU_FEATURES_HPP
+#define FILEVAULT_CORE_CPU_FEATURES_HPP
+
+#include <string>
+#include <vector>
+#include "types.hpp"
+
+namespace filevault {
+namespace core {
+
+/**
+ * @brief Instruction-set extensions relevant to the crypto backends
+ *
+ * Probed once per process. Feature names follow Botan's, so any name
+ * listed in the BOTAN_CLEAR_CPUID environment variable (which Botan uses
+ * to disable its own code paths) is also reported as absent here. The
+ * config key cpu.disabled_features sets that variable at startup.
+ */
+struct CpuFeatures {
+    std::string architecture;   // "x86_64", "aarch64", ...
+    
+    // x86
+    bool sse2 = false;
+    bool ssse3 = false;
+    bool sse42 = false;         // CRC32 instruction (CRC32C)
+    bool avx2 = false;
+    bool avx512 = false;        // AVX-512F with OS support for ZMM state
+    bool aesni = false;
+    bool clmul = false;         // PCLMULQDQ (GHASH)
+    bool vaes = false;          // Vector AES (AVX2/AVX-512 wide)
+    bool vpclmulqdq = false;
+    bool sha = false;           // SHA-NI
+    
+    // ARM
+    bool neon = false;
+    bool armv8aes = false;
+    bool armv8pmull = false;
+    bool armv8sha2 = false;
+    bool armv8crc32 = false;
+    
+    /**
+     * @brief Detected features with BOTAN_CLEAR_CPUID applied (cached)
+     */
+    static const CpuFeatures& detect();
+    
+    /**
+     * @brief True if AES and carry-less multiply (for GCM) run in hardware
+     */
+    bool hardware_aes() const;
+    
+    /**
+     * @brief Default AEAD for this host
+     *
+     * AES-256-GCM with hardware AES, otherwise ChaCha20-Poly1305, which
+     * is faster and constant-time in software.
+     */
+    AlgorithmType preferred_aead() const;
+    
+    /**
+     * @brief Names of the features present, in Botan's spelling
+     */
+    std::vector<std::string> names() const;
+    
+    /**
+     * @brief Apply a comma-separated feature list to BOTAN_CLEAR_CPUID
+     *
+     * Must run before the first Botan call; an already set environment
+     * variable wins so ad-hoc A/B runs can override the config.
+     */
+    static void disable_features(const std::string& features);
+};
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_CPU_FEATURES_HPP
@@ -1,14 +1,142 @@
 #ifndef FILEVAULT_CORE_CRYPTO_ALGORITHM_HPP
 #define FILEVAULT_CORE_CRYPTO_ALGORITHM_HPP
 
+#include <algorithm>
+#include <memory>
 #include <string>
 #include <span>
+#include <vector>
 #include "types.hpp"
 #include "result.hpp"
 
 namespace filevault {
 namespace core {
 
+/**
+ * @brief Cipher bound to one key, reused across many messages
+ *
+ * Created by ICryptoAlgorithm::create_session(). The key schedule is set
+ * up once; each call only starts a new message with its nonce. Calls do
+ * no timing or logging. A session is not thread-safe: use one per thread.
+ */
+class ICipherSession {
+public:
+    virtual ~ICipherSession() = default;
+    
+    /**
+     * @brief Encrypt a caller-owned buffer in place
+     * @param buffer Plaintext on input, ciphertext (without tag) on output
+     * @param config Nonce (generated if absent) and associated data
+     * @return Metadata (tag, nonce, sizes); result.data is left empty
+     */
+    virtual CryptoResult encrypt_in_place(
+        std::vector<uint8_t>& buffer,
+        const EncryptionConfig& config
+    ) = 0;
+    
+    /**
+     * @brief Decrypt a caller-owned buffer in place
+     * @param buffer Ciphertext (without tag) on input, plaintext on output
+     * @param config Nonce, tag and associated data
+     * @return Status and metadata; result.data is left empty
+     */
+    virtual CryptoResult decrypt_in_place(
+        std::vector<uint8_t>& buffer,
+        const EncryptionConfig& config
+    ) = 0;
+    
+    /**
+     * @brief Encrypt many messages into one arena
+     * @param messages Plaintexts
+     * @param config Associated data (shared by all messages); config.nonce
+     *               is ignored, every message gets a fresh nonce
+     * @param arena Sealed records are appended as [nonce][ciphertext][tag]
+     * @return One record per message; on failure the arena is restored
+     *
+     * Reuse the arena across batches to keep its capacity.
+     */
+    virtual BatchResult encrypt_batch(
+        std::span<const std::span<const uint8_t>> messages,
+        const EncryptionConfig& config,
+        std::vector<uint8_t>& arena
+    );
+    
+    /**
+     * @brief Decrypt records produced by encrypt_batch()
+     * @param arena Sealed records (must not alias output)
+     * @param records Records to open
+     * @param config Associated data used at encryption
+     * @param output Plaintexts are appended back to back
+     * @return One plaintext record per message; on failure output is restored
+     */
+    virtual BatchResult decrypt_batch(
+        std::span<const uint8_t> arena,
+        std::span<const BatchRecord> records,
+        const EncryptionConfig& config,
+        std::vector<uint8_t>& output
+    );
+    
+    /**
+     * @brief Start encrypting one message piece by piece
+     * @param config Nonce (required, of the cipher's nonce size) and associated data
+     * @return false if this session cannot encrypt incrementally
+     *
+     * For messages too large to hold in memory: the ciphertext is the
+     * same as encrypt_in_place() would produce for the whole message.
+     */
+    virtual bool encrypt_begin(const EncryptionConfig& config);
+    
+    /**
+     * @brief Encrypt the next piece in place
+     * @param buffer Plaintext; a multiple of encrypt_granularity() bytes
+     * @return Ciphertext bytes at the start of buffer
+     */
+    virtual size_t encrypt_update(std::span<uint8_t> buffer);
+    
+    /**
+     * @brief Encrypt the last piece and produce the tag
+     * @param buffer Remaining plaintext (any size) on input, ciphertext (without tag) on output
+     * @return Metadata with the tag and nonce; result.data is left empty
+     */
+    virtual CryptoResult encrypt_finish(std::vector<uint8_t>& buffer);
+    
+    /**
+     * @brief Piece size encrypt_update() works best with (after encrypt_begin())
+     */
+    virtual size_t encrypt_granularity() const { return 1; }
+    
+    /**
+     * @brief Start decrypting one message piece by piece
+     * @param config Nonce, tag and associated data, as for decrypt_in_place()
+     * @return false if this session cannot decrypt incrementally
+     *
+     * For messages too large to hold in memory. decrypt_update() hands
+     * back plaintext before the tag is checked: callers must keep it
+     * away from its final destination and discard it unless
+     * decrypt_finish() succeeds.
+     */
+    virtual bool decrypt_begin(const EncryptionConfig& config);
+    
+    /**
+     * @brief Decrypt the next piece in place
+     * @param buffer Ciphertext; a multiple of decrypt_granularity() bytes
+     * @return Plaintext bytes at the start of buffer
+     */
+    virtual size_t decrypt_update(std::span<uint8_t> buffer);
+    
+    /**
+     * @brief Decrypt the last piece and verify the tag
+     * @param buffer Remaining ciphertext (any size) on input, plaintext on output
+     * @return Failure on a bad tag, with buffer cleared
+     */
+    virtual CryptoResult decrypt_finish(std::vector<uint8_t>& buffer);
+    
+    /**
+     * @brief Piece size decrypt_update() works best with (after decrypt_begin())
+     */
+    virtual size_t decrypt_granularity() const { return 1; }
+};
+
 /**
  * @brief Interface for cryptographic algorithms
  */
@@ -52,6 +180,86 @@ class ICryptoAlgorithm {
         const EncryptionConfig& config
     ) = 0;
     
+    /**
+     * @brief Encrypt a caller-owned buffer in place
+     * @param buffer Plaintext on input, ciphertext (without tag) on output
+     * @param key Encryption key (derived from password)
+     * @param config Encryption configuration
+     * @return Metadata (tag, nonce, sizes); result.data is left empty
+     *
+     * The default implementation goes through encrypt() and moves the
+     * output back into the buffer. AEAD ciphers override it to work on the
+     * buffer directly; reserve tag-size spare capacity to avoid a realloc.
+     */
+    virtual CryptoResult encrypt_in_place(
+        std::vector<uint8_t>& buffer,
+        std::span<const uint8_t> key,
+        const EncryptionConfig& config
+    ) {
+        auto result = encrypt(buffer, key, config);
+        if (result.success) {
+            buffer = std::move(result.data);
+            result.data.clear();
+        }
+        return result;
+    }
+    
+    /**
+     * @brief Decrypt a caller-owned buffer in place
+     * @param buffer Ciphertext (without tag) on input, plaintext on output
+     * @param key Decryption key (derived from password)
+     * @param config Decryption configuration (nonce and tag as for decrypt())
+     * @return Status and metadata; result.data is left empty
+     */
+    virtual CryptoResult decrypt_in_place(
+        std::vector<uint8_t>& buffer,
+        std::span<const uint8_t> key,
+        const EncryptionConfig& config
+    ) {
+        auto result = decrypt(buffer, key, config);
+        if (result.success) {
+            buffer = std::move(result.data);
+            result.data.clear();
+        }
+        return result;
+    }
+    
+    /**
+     * @brief Bind a key for repeated use
+     * @param key Encryption key (derived from password)
+     * @return Session, or nullptr if the key size is invalid
+     *
+     * The default session keeps a copy of the key and forwards to
+     * encrypt_in_place()/decrypt_in_place(). AEAD ciphers override it to
+     * hold a prepared Botan mode, so the key schedule is built once.
+     * The session must not outlive the algorithm.
+     */
+    virtual std::unique_ptr<ICipherSession> create_session(std::span<const uint8_t> key);
+    
+    /**
+     * @brief Encrypt many small messages under one key
+     *
+     * Sets the key up once and skips the per-message timing and logging
+     * of encrypt(). See ICipherSession::encrypt_batch().
+     */
+    BatchResult encrypt_batch(
+        std::span<const std::span<const uint8_t>> messages,
+        std::span<const uint8_t> key,
+        const EncryptionConfig& config,
+        std::vector<uint8_t>& arena
+    );
+    
+    /**
+     * @brief Decrypt records produced by encrypt_batch()
+     */
+    BatchResult decrypt_batch(
+        std::span<const uint8_t> arena,
+        std::span<const BatchRecord> records,
+        std::span<const uint8_t> key,
+        const EncryptionConfig& config,
+        std::vector<uint8_t>& output
+    );
+    
     /**
      * @brief Get recommended key size in bytes
      */
@@ -63,6 +271,31 @@ class ICryptoAlgorithm {
     virtual bool is_suitable_for(SecurityLevel level) const = 0;
 };
 
+/**
+ * @brief Fallback session for algorithms without a native one
+ */
+class KeyedCipherSession : public ICipherSession {
+public:
+    KeyedCipherSession(ICryptoAlgorithm& algorithm, std::span<const uint8_t> key)
+        : algorithm_(algorithm), key_(key.begin(), key.end()) {}
+    
+    ~KeyedCipherSession() override {
+        std::fill(key_.begin(), key_.end(), 0);
+    }
+    
+    CryptoResult encrypt_in_place(std::vector<uint8_t>& buffer, const EncryptionConfig& config) override {
+        return algorithm_.encrypt_in_place(buffer, key_, config);
+    }
+    
+    CryptoResult decrypt_in_place(std::vector<uint8_t>& buffer, const EncryptionConfig& config) override {
+        return algorithm_.decrypt_in_place(buffer, key_, config);
+    }
+
+private:
+    ICryptoAlgorithm& algorithm_;
+    std::vector<uint8_t> key_;
+};
+
 } // namespace core
 } // namespace filevault
 
@@ -1,9 +1,12 @@
 #ifndef FILEVAULT_CORE_CRYPTO_ENGINE_HPP
 #define FILEVAULT_CORE_CRYPTO_ENGINE_HPP
 
+#include <array>
+#include <atomic>
 #include <memory>
-#include <map>
+#include <mutex>
 #include <optional>
+#include <span>
 #include "crypto_algorithm.hpp"
 #include "types.hpp"
 #include "result.hpp"
@@ -14,6 +17,9 @@ namespace core {
 /**
  * @brief Main cryptographic engine
  * Manages algorithms and provides key derivation
+ *
+ * Algorithms are constructed on first use and kept in a table indexed by
+ * AlgorithmType, so a short command only pays for the cipher it touches.
  */
 class CryptoEngine {
 public:
@@ -26,16 +32,22 @@ class CryptoEngine {
     
     /**
      * @brief Initialize engine with default algorithms
+     *
+     * The built-in algorithms are created lazily by get_algorithm(), so
+     * this no longer constructs anything; kept for API compatibility.
      */
     void initialize();
     
     /**
      * @brief Register a custom algorithm
+     * Replaces the built-in implementation for its type
      */
     void register_algorithm(std::unique_ptr<ICryptoAlgorithm> algorithm);
     
     /**
-     * @brief Get algorithm by type
+     * @brief Get algorithm by type, constructing it on first use
+     * @return nullptr if no implementation exists for the type
+     * Thread-safe; the pointer stays valid for the engine's lifetime
      */
     ICryptoAlgorithm* get_algorithm(AlgorithmType type);
     
@@ -45,6 +57,10 @@ class CryptoEngine {
      * @param salt Random salt (MUST be unique per file)
      * @param config Configuration containing KDF parameters
      * @return Derived key
+     *
+     * A salt from batch_file_salt() stretches the password with its batch
+     * salt (a KeyCache hit for every file after the first) and returns
+     * HKDF-SHA256 of that master key over the file's own salt.
      */
     std::vector<uint8_t> derive_key(
         const std::string& password,
@@ -57,6 +73,29 @@ class CryptoEngine {
      */
     static std::vector<uint8_t> generate_salt(size_t length = 32);
     
+    static constexpr size_t BATCH_SALT_SIZE = 32;
+    static constexpr size_t BATCH_FILE_SALT_SIZE = 4 + BATCH_SALT_SIZE + 16;
+    
+    /**
+     * @brief Salt for one file of a batch that shares a password KDF run
+     * @param batch_salt The batch's salt (BATCH_SALT_SIZE bytes)
+     *
+     * "FVBK", the batch salt and 16 random bytes of the file's own. Files
+     * of a batch pay for one KDF yet get keys of their own; their headers
+     * still show that they share a password, as a shared salt did.
+     */
+    static std::vector<uint8_t> batch_file_salt(std::span<const uint8_t> batch_salt);
+    
+    /**
+     * @brief Whether a salt came from batch_file_salt()
+     */
+    static bool is_batch_file_salt(std::span<const uint8_t> salt);
+    
+    /**
+     * @brief The batch salt a batch file salt refers to; any other salt itself
+     */
+    static std::span<const uint8_t> batch_salt_of(std::span<const uint8_t> salt);
+    
     /**
      * @brief Generate random nonce/IV
      * @param length Nonce length (12 for GCM, 16 for CBC)
@@ -94,7 +133,17 @@ class CryptoEngine {
     static std::optional<SecurityLevel> parse_security_level(const std::string& name);
 
 private:
-    std::map<AlgorithmType, std::unique_ptr<ICryptoAlgorithm>> algorithms_;
+    static constexpr size_t ALGORITHM_SLOTS =
+        static_cast<size_t>(AlgorithmType::ECC_X25519) + 1;
+    
+    /**
+     * @brief Construct the built-in implementation of a type
+     */
+    static std::unique_ptr<ICryptoAlgorithm> create_algorithm(AlgorithmType type);
+    
+    std::array<std::unique_ptr<ICryptoAlgorithm>, ALGORITHM_SLOTS> algorithms_;
+    std::array<std::atomic<ICryptoAlgorithm*>, ALGORITHM_SLOTS> lookup_{};  // Lock-free fast path
+    std::mutex algorithms_mutex_;
 };
 
 } // namespace core
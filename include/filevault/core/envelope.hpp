@@ -0,0 +1,142 @@
+#ifndef FILEVAULT_CORE_ENVELOPE_HPP
+#define FILEVAULT_CORE_ENVELOPE_HPP
+
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+#include "streaming.hpp"
+#include "types.hpp"
+
+namespace filevault {
+namespace core {
+
+/**
+ * @brief Public-key (envelope) encryption for files of any size
+ *
+ * The payload is encrypted once by the streaming engine under a random
+ * data key; the asymmetric algorithm (RSA-OAEP, ECCHybrid or KyberHybrid)
+ * only wraps that 32-byte key. The public-key cost is paid once per file
+ * and bulk throughput is that of password-based streaming, with parallel
+ * chunks and a frame index. Each extra recipient adds one wrap of the
+ * data key, never another pass over the payload; recipients may mix
+ * RSA, ECC and Kyber keys.
+ *
+ * File format:
+ * ["FVEN"][1 byte: version][2 bytes: recipient count]
+ * per recipient: [1 byte: wrap AlgorithmType][4 bytes: size][wrapped data key]
+ * followed by a FVAULT02 stream encrypted with the data key (empty salt).
+ *
+ * The recipient list is not authenticated on its own: each wrapped key
+ * is an AEAD or OAEP ciphertext, and every chunk of the stream is
+ * authenticated under the data key it yields.
+ */
+class EnvelopeCrypto {
+public:
+    /**
+     * @brief Wrapping algorithm for a key file's contents (public or private)
+     *
+     * RSA and ECDH keys (PEM/DER, from keygen rsa-* / ecc-*) are told apart
+     * by algorithm and size, raw Kyber keys by their length.
+     * @return std::nullopt for keys that cannot wrap (ECDSA, Ed25519, ...)
+     */
+    static std::optional<AlgorithmType> key_algorithm(std::span<const uint8_t> key);
+
+    /**
+     * @brief Encrypt a file to a public key
+     * @param config Streaming configuration; algorithm must be an AEAD,
+     *               kdf and level are unused
+     */
+    static StreamingResult encrypt_file(
+        const std::string& input_path,
+        const std::string& output_path,
+        std::span<const uint8_t> public_key,
+        const StreamingConfig& config = {}
+    );
+
+    /**
+     * @brief Encrypt a file once for several recipients
+     */
+    static StreamingResult encrypt_file(
+        const std::string& input_path,
+        const std::string& output_path,
+        const std::vector<std::vector<uint8_t>>& public_keys,
+        const StreamingConfig& config = {}
+    );
+
+    /**
+     * @brief Encrypt a stream to a public key
+     * @param input_size Input length, or std::nullopt to read until EOF (pipes)
+     */
+    static StreamingResult encrypt_stream(
+        std::istream& input,
+        std::ostream& output,
+        std::span<const uint8_t> public_key,
+        std::optional<size_t> input_size,
+        const StreamingConfig& config = {}
+    );
+
+    /**
+     * @brief Encrypt a stream once; the data key is wrapped for every key
+     * @param public_keys At most 1024 keys; duplicates are wrapped once
+     */
+    static StreamingResult encrypt_stream(
+        std::istream& input,
+        std::ostream& output,
+        const std::vector<std::vector<uint8_t>>& public_keys,
+        std::optional<size_t> input_size,
+        const StreamingConfig& config = {}
+    );
+
+    /**
+     * @brief Decrypt an envelope file with a recipient's private key
+     * @param bypass_cache Keep input and output out of the page cache
+     */
+    static StreamingResult decrypt_file(
+        const std::string& input_path,
+        const std::string& output_path,
+        std::span<const uint8_t> private_key,
+        StreamProgressCallback progress_callback = nullptr,
+        size_t worker_threads = 1,
+        bool bypass_cache = false
+    );
+
+    /**
+     * @brief Decrypt an envelope stream; reads sequentially, stdin works
+     *
+     * Tries the recipient slots of the key's algorithm in turn; a slot
+     * wrapped for another key fails authentication and is skipped.
+     */
+    static StreamingResult decrypt_stream(
+        std::istream& input,
+        std::ostream& output,
+        std::span<const uint8_t> private_key,
+        StreamProgressCallback progress_callback = nullptr,
+        size_t worker_threads = 1
+    );
+
+    /**
+     * @brief Check if a file starts with the FVEN magic bytes
+     */
+    static bool is_envelope_file(const std::string& file_path);
+
+private:
+    /**
+     * @brief One wrapped copy of the data key
+     */
+    struct WrappedKey {
+        AlgorithmType algorithm;
+        std::vector<uint8_t> data;
+    };
+
+    static bool write_header(std::ostream& output, const std::vector<WrappedKey>& recipients);
+    static bool read_header(std::istream& input, std::vector<WrappedKey>& recipients, std::string& error);
+};
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_ENVELOPE_HPP
@@ -0,0 +1,313 @@
+#ifndef FILEVAULT_CORE_EXECUTOR_HPP
+#define FILEVAULT_CORE_EXECUTOR_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace filevault {
+namespace core {
+
+/**
+ * @brief Scheduling class of a task; higher classes are picked first
+ */
+enum class TaskPriority : uint8_t {
+    HIGH = 0,       // Latency-sensitive (e.g. interactive reads)
+    NORMAL = 1,
+    LOW = 2         // Background work (prefetch, verification)
+};
+
+/**
+ * @brief Thrown from the future of a task cancelled before it started
+ */
+class TaskCancelled : public std::runtime_error {
+public:
+    TaskCancelled() : std::runtime_error("Task cancelled") {}
+};
+
+/**
+ * @brief Shared flag telling queued tasks not to start
+ *
+ * Copies share the flag. A default-constructed token is never cancelled;
+ * tasks already running are not interrupted, but may poll cancelled().
+ */
+class CancellationToken {
+public:
+    CancellationToken() = default;
+
+    /**
+     * @brief A token that can be cancelled
+     */
+    static CancellationToken create() {
+        CancellationToken token;
+        token.flag_ = std::make_shared<std::atomic<bool>>(false);
+        return token;
+    }
+
+    void cancel() const {
+        if (flag_) {
+            flag_->store(true, std::memory_order_relaxed);
+        }
+    }
+
+    bool cancelled() const { return flag_ && flag_->load(std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> flag_;
+};
+
+/**
+ * @brief Work-stealing worker pool shared by the parallel code paths
+ *
+ * Each worker owns a deque per priority: tasks submitted from a worker go
+ * to the back of its own deque and are taken from there (newest first,
+ * while the data is still in cache); other threads submit to a shared
+ * injection queue. An idle worker takes, for each priority in turn, from
+ * its own deque, then the injection queue, then the front of another
+ * worker's deque. shared() is one pool sized to the machine, so nested
+ * or concurrent jobs (batch entries, archive chunks, hashing) divide the
+ * cores instead of each starting its own threads.
+ *
+ * With NUMA placement on (Numa::set_enabled), workers are spread
+ * round-robin over the nodes and pinned there, and steal from workers of
+ * their own node before crossing to another.
+ *
+ * With max_queued > 0, submitting from outside the pool blocks while that
+ * many tasks are waiting (backpressure on producers). Workers never block
+ * on submit, so tasks may always spawn tasks.
+ *
+ * The destructor runs every queued task before joining the workers.
+ */
+class Executor {
+public:
+    /**
+     * @param thread_count Workers (0 = ThreadPool::default_thread_count())
+     * @param max_queued Waiting tasks before outside submitters block (0 = unbounded)
+     */
+    explicit Executor(size_t thread_count = 0, size_t max_queued = 0);
+    ~Executor();
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    /**
+     * @brief Process-wide executor with one worker per core
+     */
+    static Executor& shared();
+
+    /**
+     * @brief Queue a task
+     * @param token Skips the task (TaskCancelled in the future) if cancelled before it starts
+     */
+    template<typename F>
+    auto submit(F&& task, TaskPriority priority = TaskPriority::NORMAL, CancellationToken token = {})
+        -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        auto packaged = package(std::forward<F>(task), std::move(token));
+        post(std::move(packaged.first), priority);
+        return std::move(packaged.second);
+    }
+
+    /**
+     * @brief Queue a task unless the queue is full
+     * @return false (and task dropped) when max_queued tasks are waiting
+     */
+    bool try_post(std::function<void()> task, TaskPriority priority = TaskPriority::NORMAL);
+
+    /**
+     * @brief Queue a task with no result (blocks when full, see class notes)
+     */
+    void post(std::function<void()> task, TaskPriority priority = TaskPriority::NORMAL);
+
+    /**
+     * @brief Run one waiting task on the calling thread
+     * @return false if nothing was waiting
+     */
+    bool run_one();
+
+    /**
+     * @brief Wait for a future, running other tasks meanwhile on a worker
+     *
+     * A worker that blocks on a task still in the queue could otherwise
+     * wait forever with every worker blocked the same way.
+     */
+    template<typename T>
+    T wait(std::future<T>& future) {
+        if (current() == this) {
+            while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                if (!run_one()) {
+                    future.wait_for(std::chrono::microseconds(200));
+                }
+            }
+        }
+        return future.get();
+    }
+
+    size_t size() const { return workers_.size(); }
+
+    /**
+     * @brief Tasks queued and not yet started
+     */
+    size_t pending() const { return queued_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Time workers have spent running tasks, summed over workers
+     */
+    uint64_t busy_ns() const { return busy_ns_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Executor whose worker is the calling thread, or nullptr
+     */
+    static Executor* current();
+
+    /**
+     * @brief Wrap a callable so its result or exception lands in a future
+     */
+    template<typename F>
+    static auto package(F&& task, CancellationToken token = {}) {
+        using Fn = std::decay_t<F>;
+        using R = std::invoke_result_t<Fn>;
+        // Shared so move-only callables fit in a (copyable) std::function
+        struct State {
+            std::promise<R> promise;
+            Fn fn;
+        };
+        auto state = std::shared_ptr<State>(new State{std::promise<R>(), Fn(std::forward<F>(task))});
+        auto future = state->promise.get_future();
+        std::function<void()> job = [state, token = std::move(token)]() {
+            if (token.cancelled()) {
+                state->promise.set_exception(std::make_exception_ptr(TaskCancelled()));
+                return;
+            }
+            try {
+                if constexpr (std::is_void_v<R>) {
+                    state->fn();
+                    state->promise.set_value();
+                } else {
+                    state->promise.set_value(state->fn());
+                }
+            } catch (...) {
+                state->promise.set_exception(std::current_exception());
+            }
+        };
+        return std::make_pair(std::move(job), std::move(future));
+    }
+
+private:
+    static constexpr size_t PRIORITIES = 3;
+
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> lanes[PRIORITIES];
+    };
+
+    bool enqueue(std::function<void()> task, TaskPriority priority, bool wait_for_room);
+    bool take(size_t self, std::function<void()>& task);
+    void worker_loop(size_t index);
+
+    std::vector<std::unique_ptr<TaskQueue>> locals_;   // One per worker
+    std::vector<size_t> worker_node_;                 // NUMA node of each worker
+    TaskQueue injection_;                             // Submissions from other threads
+    std::atomic<size_t> queued_{0};
+    std::atomic<uint64_t> busy_ns_{0};
+    size_t max_queued_;
+
+    std::mutex sleep_mutex_;
+    std::condition_variable work_cv_;                 // Workers wait for tasks
+    std::condition_variable room_cv_;                 // Submitters wait for queue space
+    size_t sleeping_ = 0;
+    bool stopping_ = false;
+
+    std::vector<std::thread> workers_;
+};
+
+/**
+ * @brief Tasks of one job on an Executor, with their own concurrency cap
+ *
+ * Has the submit()/size() shape of ThreadPool, so a job that used to start
+ * its own pool of N threads can run on the shared executor with at most N
+ * of its tasks running at once; the rest wait in the group, in order.
+ * The destructor waits for every task of the group (tasks may reference
+ * the caller's locals, as with ThreadPool), and cancel() drops the ones
+ * that have not started.
+ */
+class TaskGroup {
+public:
+    /**
+     * @param max_concurrency Tasks of this group running at once (0 = executor size)
+     */
+    explicit TaskGroup(Executor& executor, size_t max_concurrency = 0,
+                       TaskPriority priority = TaskPriority::NORMAL);
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    template<typename F>
+    auto submit(F&& task) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        auto packaged = Executor::package(std::forward<F>(task), token_);
+        add(std::move(packaged.first));
+        return std::move(packaged.second);
+    }
+
+    /**
+     * @brief Wait for one of this group's futures
+     *
+     * Runs the group's not-yet-started tasks on the calling thread while
+     * waiting, and other executor tasks when called from a worker.
+     */
+    template<typename T>
+    T wait(std::future<T>& future) {
+        while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            if (!run_waiting() && !(Executor::current() == &executor_ && executor_.run_one())) {
+                future.wait_for(std::chrono::microseconds(200));
+            }
+        }
+        return future.get();
+    }
+
+    /**
+     * @brief Skip tasks not started yet; their futures throw TaskCancelled
+     */
+    void cancel() { token_.cancel(); }
+    const CancellationToken& token() const { return token_; }
+
+    /**
+     * @brief Concurrency cap
+     */
+    size_t size() const { return limit_; }
+
+    Executor& executor() { return executor_; }
+
+private:
+    void add(std::function<void()> job);
+    void dispatch(std::function<void()> job);
+    void finished();
+    bool run_waiting();
+
+    Executor& executor_;
+    size_t limit_;
+    TaskPriority priority_;
+    CancellationToken token_ = CancellationToken::create();
+
+    std::mutex mutex_;
+    std::condition_variable idle_cv_;
+    std::deque<std::function<void()>> waiting_;     // Over the cap, not yet dispatched
+    size_t running_ = 0;                            // Dispatched to the executor
+    size_t inline_ = 0;                             // Run by waiting threads
+};
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_EXECUTOR_HPP
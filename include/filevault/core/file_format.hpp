@@ -2,9 +2,11 @@
 #define FILEVAULT_CORE_FILE_FORMAT_HPP
 
 #include "filevault/core/types.hpp"
+#include "filevault/core/result.hpp"
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <ostream>
 #include <span>
 
 namespace filevault {
@@ -16,6 +18,7 @@ namespace core {
  * Format structure:
  * [Magic:8][Version:2][AlgoID:1][KDFID:1][CompID:1][Reserved:3]
  * [Salt:32][KDF_Params:Variable][NonceSize:1][Nonce:Variable][Compressed_Flag:1]
+ * [Dictionary_ID:4 (if flagged)][Key_Check:8 (if flagged)]
  * [Ciphertext][Auth_Tag:16 (AEAD only)]
  * 
  * Magic: "FVAULT01" (8 bytes)
@@ -28,7 +31,10 @@ namespace core {
  * KDF_Params: Variable-length KDF parameters
  * NonceSize: Size of nonce/IV in bytes (1 byte)
  * Nonce: Random nonce/IV (variable, e.g. 12 for GCM, 16 for CBC/CTR)
- * Compressed_Flag: 0x00=No, 0x01=Yes (1 byte)
+ * Compressed_Flag: 0x01=Compressed, 0x02=Dictionary ID follows,
+ *                  0x04=Key check follows (1 byte of flag bits)
+ * Dictionary_ID: ID of the compression dictionary (version 1.1)
+ * Key_Check: Verifier derived from the key, checked before decrypting (version 1.2)
  * Ciphertext: Encrypted data
  * Auth_Tag: GCM authentication tag (16 bytes, only for AEAD)
  */
@@ -37,6 +43,17 @@ constexpr uint8_t FILE_FORMAT_MAGIC[8] = {'F', 'V', 'A', 'U', 'L', 'T', '0', '1'
 constexpr uint8_t FILE_FORMAT_VERSION_MAJOR = 1;
 constexpr uint8_t FILE_FORMAT_VERSION_MINOR = 0;
 
+// Minor version of files that reference a compression dictionary
+constexpr uint8_t FILE_FORMAT_VERSION_MINOR_DICTIONARY = 1;
+
+// Minor version of files that carry a key check value
+constexpr uint8_t FILE_FORMAT_VERSION_MINOR_KEY_CHECK = 2;
+constexpr size_t KEY_CHECK_SIZE = 8;
+
+// Format version 2.0: fixed-size blocks, each with its own tag, behind an
+// authenticated header. Written and read by StreamingCrypto (streaming.hpp).
+constexpr uint8_t FILE_FORMAT_MAGIC_V2[8] = {'F', 'V', 'A', 'U', 'L', 'T', '0', '2'};
+
 /**
  * @brief Algorithm identifiers
  */
@@ -96,7 +113,12 @@ enum class AlgorithmID : uint8_t {
     // Asymmetric (ECC)
     ECC_P256 = 0x60,
     ECC_P384 = 0x61,
-    ECC_P521 = 0x62
+    ECC_P521 = 0x62,
+    ECC_X25519 = 0x63,
+    // AEAD beyond GCM
+    AEGIS_256 = 0x70,
+    AES_256_OCB = 0x71,
+    AES_256_SIV = 0x72
 };
 
 /**
@@ -118,7 +140,9 @@ enum class CompressionID : uint8_t {
     NONE = 0x00,
     ZLIB = 0x01,
     BZIP2 = 0x02,
-    LZMA = 0x03
+    LZMA = 0x03,
+    ZSTD = 0x04,
+    LZ4 = 0x05
 };
 
 /**
@@ -127,7 +151,7 @@ enum class CompressionID : uint8_t {
 struct Argon2Params {
     uint32_t memory_kb = 65536;     // 64 MB default
     uint32_t iterations = 3;
-    uint32_t parallelism = 4;
+    uint32_t parallelism = 4;       // Lanes, hashed on parallel threads
     
     std::vector<uint8_t> serialize() const;
     static Argon2Params deserialize(std::span<const uint8_t> data);
@@ -155,6 +179,32 @@ struct ScryptParams {
     static ScryptParams deserialize(std::span<const uint8_t> data);
 };
 
+/**
+ * @brief FVAULT01 header fields as views into the buffer they were parsed from
+ *
+ * Parsing copies nothing; the spans are valid as long as that buffer.
+ */
+struct FileHeaderView {
+    uint8_t version_major = 0;
+    uint8_t version_minor = 0;
+    AlgorithmID algorithm = AlgorithmID::UNKNOWN;
+    KDFID kdf = KDFID::NONE;
+    CompressionID compression = CompressionID::NONE;
+    std::span<const uint8_t> reserved;
+    std::span<const uint8_t> salt;
+    std::span<const uint8_t> kdf_params;
+    std::span<const uint8_t> nonce;
+    bool compressed = false;
+    uint32_t dictionary_id = 0;
+    std::span<const uint8_t> key_check;   // Empty before version 1.2
+    size_t size = 0;                // Header bytes consumed
+    
+    /**
+     * @throws std::runtime_error on bad magic bytes or truncated data
+     */
+    static FileHeaderView parse(std::span<const uint8_t> data);
+};
+
 /**
  * @brief File format header
  */
@@ -170,6 +220,40 @@ struct FileHeader {
     std::vector<uint8_t> kdf_params;
     std::vector<uint8_t> nonce;
     bool compressed;
+    uint32_t dictionary_id = 0;     // 0 = compressed without a dictionary
+    std::vector<uint8_t> key_check; // KEY_CHECK_SIZE bytes, or empty
+    
+    /**
+     * @brief Record the dictionary the payload was compressed with
+     *
+     * Bumps the minor version, since 1.0 readers cannot decompress it.
+     */
+    void set_dictionary_id(uint32_t id);
+    
+    /**
+     * @brief Store the check value of the key the payload is encrypted with
+     *
+     * Lets decryption reject a wrong password right after the KDF instead
+     * of after authenticating the whole payload. Bumps the minor version.
+     */
+    void set_key_check(std::span<const uint8_t> key);
+    
+    /**
+     * @brief Whether key can be the file's key
+     *
+     * True when the header has no check value (before version 1.2). The
+     * AEAD tag remains the real check: a match is not proof of a right key.
+     */
+    bool matches_key(std::span<const uint8_t> key) const;
+    
+    /**
+     * @brief The first KEY_CHECK_SIZE bytes of HKDF-SHA256(key, "FileVault key check")
+     *
+     * One-way and domain-separated from the cipher, so it reveals nothing
+     * the ciphertext does not: anyone with the file can already test a
+     * guessed password against the tag.
+     */
+    static std::vector<uint8_t> compute_key_check(std::span<const uint8_t> key);
     
     /**
      * @brief Check if magic bytes are valid
@@ -186,11 +270,76 @@ struct FileHeader {
      */
     std::vector<uint8_t> serialize() const;
     
+    /**
+     * @brief Serialize into a stack buffer and write it with one call
+     * @return false if the stream fails or the fields exceed the format's limits
+     */
+    bool write_to(std::ostream& out) const;
+    
     /**
      * @brief Deserialize header from bytes
      * @return Header and number of bytes consumed
      */
     static std::pair<FileHeader, size_t> deserialize(std::span<const uint8_t> data);
+    
+    /**
+     * @brief Copy the fields of a parsed view into an owning header
+     */
+    static FileHeader from_view(const FileHeaderView& view);
+};
+
+/**
+ * @brief Header of the oldest ("FVLT") files, as views into the parsed buffer
+ *
+ * Format structure (all integers little-endian):
+ * [Magic "FVLT":4][Version:2][Algorithm:1][KDF:1][SecurityLevel:1]
+ * [SaltLen:2][Salt][NonceLen:2][Nonce][TagLen:2][Tag]
+ * [OriginalSize:8][EncryptedSize:8][Timestamp:8][Flags:4][Reserved:16]
+ * [Ciphertext]
+ *
+ * Only read, for decrypting old files; the IDs are AlgorithmType,
+ * KDFType and SecurityLevel values.
+ */
+struct LegacyHeaderView {
+    static constexpr uint32_t FLAG_COMPRESSED = 0x00000001;
+    
+    AlgorithmType algorithm = AlgorithmType::AES_256_GCM;
+    KDFType kdf = KDFType::ARGON2ID;
+    SecurityLevel security_level = SecurityLevel::MEDIUM;
+    std::span<const uint8_t> salt;
+    std::span<const uint8_t> nonce;
+    std::span<const uint8_t> tag;
+    uint64_t original_size = 0;
+    uint64_t encrypted_size = 0;
+    uint64_t timestamp = 0;
+    uint32_t flags = 0;
+    size_t size = 0;                // Header bytes consumed
+    
+    bool is_compressed() const { return (flags & FLAG_COMPRESSED) != 0; }
+    
+    /**
+     * @brief Check salt, nonce and tag sizes are plausible
+     */
+    bool validate() const;
+    
+    static Result<LegacyHeaderView> parse(std::span<const uint8_t> data);
+};
+
+/**
+ * @brief Parsed header of an encrypted file and where its payload lies
+ *
+ * From FileFormatHandler::read_header(); the ciphertext can then be
+ * streamed or mapped from ciphertext_offset without reading it all.
+ */
+struct FileLayout {
+    FileHeader header;
+    size_t header_size = 0;
+    uint64_t file_size = 0;
+    uint64_t ciphertext_offset = 0;   // == header_size
+    uint64_t ciphertext_size = 0;
+    size_t tag_size = 0;              // 16 for AEAD algorithms, stored after the ciphertext
+    
+    uint64_t tag_offset() const { return ciphertext_offset + ciphertext_size; }
 };
 
 /**
@@ -212,6 +361,9 @@ class FileFormatHandler {
     
     /**
      * @brief Write encrypted file with header
+     *
+     * Atomic: written to a temp file beside path and renamed into place
+     * after one fsync (see utils::OutputFile).
      */
     static bool write_file(
         const std::string& path,
@@ -227,6 +379,20 @@ class FileFormatHandler {
         const std::string& path
     );
     
+    /**
+     * @brief Read and parse only the header, via positional reads
+     *
+     * Costs the same for a 1 KB and a 10 GB file: a 512-byte read, and a
+     * second one only for unusually long KDF parameters.
+     * @throws std::runtime_error if the file cannot be read or has no valid header
+     */
+    static FileLayout read_header(const std::string& path);
+    
+    /**
+     * @brief Whether files of this algorithm carry a 16-byte auth tag
+     */
+    static bool has_auth_tag(AlgorithmID id);
+    
     /**
      * @brief Convert AlgorithmType to AlgorithmID
      */
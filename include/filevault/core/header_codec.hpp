@@ -0,0 +1,133 @@
+#ifndef FILEVAULT_CORE_HEADER_CODEC_HPP
+#define FILEVAULT_CORE_HEADER_CODEC_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+namespace filevault {
+namespace core {
+
+/**
+ * @brief Little-endian field writer over a fixed-size stack buffer
+ *
+ * File headers are assembled field by field here and reach the stream
+ * with a single write_to(), instead of one small write per field.
+ * Writing past Capacity sets overflow() and drops the field.
+ */
+template<size_t Capacity>
+class HeaderWriter {
+public:
+    void u8(uint8_t value) { put(&value, 1); }
+    void u16(uint16_t value) { put_le(value, 2); }
+    void u32(uint32_t value) { put_le(value, 4); }
+    void u64(uint64_t value) { put_le(value, 8); }
+
+    void bytes(std::span<const uint8_t> data) { put(data.data(), data.size()); }
+
+    void zeros(size_t count) {
+        if (!reserve(count)) return;
+        std::memset(buffer_.data() + size_, 0, count);
+        size_ += count;
+    }
+
+    bool overflow() const { return overflow_; }
+    size_t size() const { return size_; }
+    std::span<const uint8_t> data() const { return {buffer_.data(), size_}; }
+
+    /**
+     * @brief Write everything in one call
+     * @return false on overflow or a stream error
+     */
+    bool write_to(std::ostream& out) const {
+        if (overflow_) return false;
+        out.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(size_));
+        return out.good();
+    }
+
+private:
+    bool reserve(size_t count) {
+        if (overflow_ || count > Capacity - size_) {
+            overflow_ = true;
+            return false;
+        }
+        return true;
+    }
+
+    void put(const void* data, size_t count) {
+        if (count == 0 || !reserve(count)) return;
+        std::memcpy(buffer_.data() + size_, data, count);
+        size_ += count;
+    }
+
+    void put_le(uint64_t value, size_t count) {
+        if (!reserve(count)) return;
+        for (size_t i = 0; i < count; ++i) {
+            buffer_[size_ + i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+        size_ += count;
+    }
+
+    std::array<uint8_t, Capacity> buffer_{};
+    size_t size_ = 0;
+    bool overflow_ = false;
+};
+
+/**
+ * @brief Bounds-checked little-endian field reader over a byte span
+ *
+ * bytes() returns views into the parsed buffer, so variable-length
+ * fields are never copied. Reading past the end throws
+ * std::runtime_error("File too small for <field>").
+ */
+class HeaderReader {
+public:
+    explicit HeaderReader(std::span<const uint8_t> data) : data_(data) {}
+
+    uint8_t u8(const char* field) { return static_cast<uint8_t>(get_le(1, field)); }
+    uint16_t u16(const char* field) { return static_cast<uint16_t>(get_le(2, field)); }
+    uint32_t u32(const char* field) { return static_cast<uint32_t>(get_le(4, field)); }
+    uint64_t u64(const char* field) { return get_le(8, field); }
+
+    std::span<const uint8_t> bytes(size_t count, const char* field) {
+        require(count, field);
+        auto view = data_.subspan(offset_, count);
+        offset_ += count;
+        return view;
+    }
+
+    void skip(size_t count, const char* field) { bytes(count, field); }
+
+    size_t offset() const { return offset_; }
+    size_t remaining() const { return data_.size() - offset_; }
+
+private:
+    void require(size_t count, const char* field) const {
+        if (count > data_.size() - offset_) {
+            throw std::runtime_error(std::string("File too small for ") + field);
+        }
+    }
+
+    uint64_t get_le(size_t count, const char* field) {
+        require(count, field);
+        uint64_t value = 0;
+        for (size_t i = 0; i < count; ++i) {
+            value |= static_cast<uint64_t>(data_[offset_ + i]) << (8 * i);
+        }
+        offset_ += count;
+        return value;
+    }
+
+    std::span<const uint8_t> data_;
+    size_t offset_ = 0;
+};
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_HEADER_CODEC_HPP
@@ -0,0 +1,121 @@
+#ifndef FILEVAULT_CORE_INLINE_BYTES_HPP
+#define FILEVAULT_CORE_INLINE_BYTES_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace filevault {
+namespace core {
+
+/**
+ * @brief Byte string of at most N bytes stored inline (no heap allocation)
+ *
+ * Holds the small per-message values (nonce, IV, tag, salt) that used to
+ * be std::vector<uint8_t>, with the same data()/size()/begin()/end()/
+ * operator[] shape. It converts from a vector or span and back to a
+ * vector, and compares equal to a vector with the same bytes, so code
+ * written against the vector fields keeps working. Storing more than N
+ * bytes throws std::length_error.
+ */
+template<size_t N>
+class InlineBytes {
+    static_assert(N > 0 && N <= 255, "InlineBytes length is stored in one byte");
+
+public:
+    using value_type = uint8_t;
+    using size_type = size_t;
+    using iterator = uint8_t*;
+    using const_iterator = const uint8_t*;
+
+    InlineBytes() = default;
+
+    InlineBytes(std::span<const uint8_t> bytes) { assign(bytes.begin(), bytes.end()); }
+    InlineBytes(const std::vector<uint8_t>& bytes) { assign(bytes.begin(), bytes.end()); }
+    InlineBytes(std::initializer_list<uint8_t> bytes) { assign(bytes.begin(), bytes.end()); }
+
+    template<std::input_iterator It>
+    InlineBytes(It first, It last) { assign(first, last); }
+
+    explicit InlineBytes(size_t count, uint8_t value = 0) { assign(count, value); }
+
+    static constexpr size_t capacity() { return N; }
+
+    uint8_t* data() { return bytes_.data(); }
+    const uint8_t* data() const { return bytes_.data(); }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    iterator begin() { return bytes_.data(); }
+    iterator end() { return bytes_.data() + size_; }
+    const_iterator begin() const { return bytes_.data(); }
+    const_iterator end() const { return bytes_.data() + size_; }
+
+    uint8_t& operator[](size_t i) { return bytes_[i]; }
+    const uint8_t& operator[](size_t i) const { return bytes_[i]; }
+
+    template<std::input_iterator It>
+    void assign(It first, It last) {
+        size_t count = static_cast<size_t>(std::distance(first, last));
+        check(count);
+        std::copy(first, last, bytes_.begin());
+        size_ = static_cast<uint8_t>(count);
+    }
+
+    void assign(size_t count, uint8_t value) {
+        check(count);
+        std::fill_n(bytes_.begin(), count, value);
+        size_ = static_cast<uint8_t>(count);
+    }
+
+    void resize(size_t count, uint8_t value = 0) {
+        check(count);
+        if (count > size_) {
+            std::fill(bytes_.begin() + size_, bytes_.begin() + count, value);
+        }
+        size_ = static_cast<uint8_t>(count);
+    }
+
+    void clear() { size_ = 0; }
+
+    /**
+     * @brief Copy into a vector (allocates; for APIs that still take one)
+     */
+    operator std::vector<uint8_t>() const { return std::vector<uint8_t>(begin(), end()); }
+
+    friend bool operator==(const InlineBytes& a, const InlineBytes& b) {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end());
+    }
+
+    friend bool operator==(const InlineBytes& a, const std::vector<uint8_t>& b) {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end());
+    }
+
+private:
+    static void check(size_t count) {
+        if (count > N) {
+            throw std::length_error("Value of " + std::to_string(count) +
+                                    " bytes exceeds inline capacity of " + std::to_string(N));
+        }
+    }
+
+    std::array<uint8_t, N> bytes_{};
+    uint8_t size_ = 0;
+};
+
+/**
+ * @brief Nonce, IV, tag or salt (the largest in use is a 32-byte salt)
+ */
+using ShortBytes = InlineBytes<32>;
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_INLINE_BYTES_HPP
@@ -0,0 +1,78 @@
+#ifndef FILEVAULT_CORE_KDF_CALIBRATION_HPP
+#define FILEVAULT_CORE_KDF_CALIBRATION_HPP
+
+#include <cstdint>
+#include <string>
+#include "types.hpp"
+
+namespace filevault {
+namespace core {
+
+class CryptoEngine;
+
+/**
+ * @brief KDF parameters chosen for one host
+ */
+struct KdfProfile {
+    KDFType kdf = KDFType::ARGON2ID;
+    uint32_t iterations = 0;
+    uint32_t memory_kb = 0;         // Argon2 only
+    uint32_t parallelism = 1;       // Argon2 only
+    double measured_ms = 0.0;       // Derivation time with these parameters
+
+    /**
+     * @brief Copy the parameters into an encryption config
+     *
+     * They end up in the file header's kdf_params, so decryption on any
+     * host uses the same values.
+     */
+    void apply(EncryptionConfig& config) const;
+};
+
+/**
+ * @brief Picks KDF parameters that fit a wall-clock and memory budget
+ *
+ * Fixed security-level parameters are far too slow on small ARM boards
+ * and needlessly weak on servers. Calibration times real derivations on
+ * this host and returns the strongest parameters within the budget:
+ * for Argon2 the largest memory that fits, then as many passes as the
+ * time allows; for PBKDF2 the iteration count is scaled from a probe.
+ * Scrypt is not supported because its header parameters are not read
+ * back on decryption.
+ */
+class KdfCalibrator {
+public:
+    /**
+     * @brief Whether calibrate() can handle this KDF
+     */
+    static bool supports(KDFType kdf);
+
+    /**
+     * @brief Benchmark the KDF and return the strongest fitting parameters
+     * @param target_ms Wall-clock budget for one derivation
+     * @param max_memory_mb Memory budget (Argon2)
+     *
+     * If even the cheapest parameters exceed the target, those are
+     * returned and measured_ms reports the actual cost.
+     */
+    static KdfProfile calibrate(CryptoEngine& engine, KDFType kdf,
+                                uint32_t target_ms, uint32_t max_memory_mb);
+
+    /**
+     * @brief Average time of runs derivations, each with a fresh salt
+     */
+    static double time_derivation(CryptoEngine& engine, const EncryptionConfig& config, int runs = 1);
+
+    /**
+     * @brief Key under which a calibration is cached in the user config
+     *
+     * Includes the CPU description so a config copied to another machine
+     * triggers a new calibration.
+     */
+    static std::string cache_key(KDFType kdf, uint32_t target_ms, uint32_t max_memory_mb);
+};
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_KDF_CALIBRATION_HPP
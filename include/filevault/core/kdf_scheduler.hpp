@@ -0,0 +1,125 @@
+#ifndef FILEVAULT_CORE_KDF_SCHEDULER_HPP
+#define FILEVAULT_CORE_KDF_SCHEDULER_HPP
+
+#include "filevault/core/crypto_engine.hpp"
+#include "filevault/core/key_cache.hpp"
+#include "filevault/core/secure_arena.hpp"
+#include "filevault/core/types.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace filevault {
+namespace core {
+
+/**
+ * @brief Limits of a KdfScheduler
+ */
+struct KdfSchedulerOptions {
+    uint64_t memory_budget = 1024ull * 1024 * 1024;    // KDF memory in use at once
+    size_t max_parallel = 0;                            // Derivations at once (0 = one per core)
+};
+
+/**
+ * @brief Counters of a KdfScheduler
+ */
+struct KdfSchedulerStats {
+    size_t derived = 0;
+    size_t failed = 0;
+    size_t peak_parallel = 0;       // Most derivations running at once
+    uint64_t peak_memory = 0;       // Most KDF memory in use at once
+};
+
+/**
+ * @brief Derives one password's keys for many salts in parallel, within a memory budget
+ *
+ * Files encrypted separately have their own salts, so a batch decrypt
+ * pays one KDF per file; Argon2 at 16-128 MB each is too slow one at a
+ * time and runs out of memory all at once. Derivations are started in
+ * submission order on the scheduler's own threads, as many at once as
+ * their memory_cost() fits the budget (one larger than the budget runs
+ * alone), ahead of the workers that need the keys.
+ *
+ * A worker calls wait() with its ticket before decrypting: the ticket is
+ * moved to the front if it has not started, and once derived the key is
+ * handed to KeyCache, from which the decryption's own
+ * CryptoEngine::derive_key() call is served. Waiting out of submission
+ * order is fine; tickets that are never waited for just hold their key
+ * until the scheduler is destroyed.
+ */
+class KdfScheduler {
+public:
+    explicit KdfScheduler(std::string password, KdfSchedulerOptions options = {});
+    ~KdfScheduler();
+
+    KdfScheduler(const KdfScheduler&) = delete;
+    KdfScheduler& operator=(const KdfScheduler&) = delete;
+
+    /**
+     * @brief Queue a derivation; submit in the order the keys will be needed
+     * @param config Algorithm (key size), KDF and its parameters
+     * @return Ticket for wait()
+     *
+     * A batch file salt queues its batch's master key, which the file's
+     * own derive_key() turns into its key with one HKDF. Salts already
+     * queued with the same settings get the earlier ticket, so a batch
+     * is derived once however many of its files are submitted.
+     */
+    size_t submit(std::vector<uint8_t> salt, const EncryptionConfig& config);
+
+    /**
+     * @brief Block until the ticket's key is derived and in KeyCache
+     * @return false if the derivation failed (the caller's own derivation
+     *         will then fail the same way and report it)
+     */
+    bool wait(size_t ticket);
+
+    KdfSchedulerStats stats() const;
+
+    /**
+     * @brief Bytes a derivation with these settings holds while it runs
+     */
+    static uint64_t memory_cost(const EncryptionConfig& config);
+
+private:
+    enum class State { QUEUED, RUNNING, DONE, FAILED, TAKEN };
+
+    struct Job {
+        std::vector<uint8_t> salt;
+        EncryptionConfig config;
+        uint64_t cost = 0;
+        State state = State::QUEUED;
+        SecureBytes key;
+    };
+
+    void work();
+    bool next_job(size_t& index);       // Requires mutex_
+
+    std::string password_;
+    KdfSchedulerOptions options_;
+    CryptoEngine engine_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    std::deque<Job> jobs_;              // Stable references while others are appended
+    std::deque<size_t> demanded_;       // Waited for before they started
+    std::map<KeyCache::Id, size_t> submitted_;  // Ticket of each queued salt and settings
+    size_t next_ = 0;                   // No QUEUED job before this index, other than demanded ones
+    size_t running_ = 0;
+    uint64_t in_use_ = 0;
+    bool stopping_ = false;
+    KdfSchedulerStats stats_;
+    std::vector<std::thread> threads_;
+};
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_KDF_SCHEDULER_HPP
@@ -0,0 +1,109 @@
+#ifndef FILEVAULT_CORE_KEY_CACHE_HPP
+#define FILEVAULT_CORE_KEY_CACHE_HPP
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+#include "secure_arena.hpp"
+#include "types.hpp"
+
+namespace filevault {
+namespace core {
+
+/**
+ * @brief Key cache counters
+ */
+struct KeyCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+};
+
+/**
+ * @brief Bounded in-process cache of password-derived keys
+ *
+ * Lets repeated derivations of the same password + salt + KDF parameters
+ * (archive listing then extraction, ranged reads of one streaming file,
+ * batch jobs) pay for the KDF once. Entries are identified by an HMAC
+ * under a random per-process key, so neither the password nor an
+ * offline-guessable hash of it is held; keys live in the SecureArena
+ * and expire after the TTL. Least recently
+ * used entries are evicted once the capacity is reached.
+ */
+class KeyCache {
+public:
+    using Id = std::array<uint8_t, 32>;
+
+    static constexpr size_t DEFAULT_CAPACITY = 32;
+    static constexpr std::chrono::seconds DEFAULT_TTL{300};
+
+    /**
+     * @brief Process-wide instance used by CryptoEngine::derive_key
+     */
+    static KeyCache& instance();
+
+    // Prevent copying
+    KeyCache(const KeyCache&) = delete;
+    KeyCache& operator=(const KeyCache&) = delete;
+
+    /**
+     * @brief Identifier for a derivation (every input that affects the key)
+     */
+    Id make_id(const std::string& password,
+               std::span<const uint8_t> salt,
+               const EncryptionConfig& config,
+               size_t key_size) const;
+
+    /**
+     * @brief Copy a live entry into key
+     * @return false if absent or expired (key is left untouched)
+     */
+    bool lookup(const Id& id, std::vector<uint8_t>& key);
+
+    /**
+     * @brief Insert or refresh an entry, evicting the least recently used
+     */
+    void store(const Id& id, std::span<const uint8_t> key);
+
+    /**
+     * @brief Drop and wipe all entries
+     */
+    void clear();
+
+    /**
+     * @brief Change the limits; 0 for either disables caching
+     */
+    void configure(size_t capacity, std::chrono::seconds ttl);
+
+    bool enabled() const;
+    size_t size() const;
+    KeyCacheStats stats() const;
+
+private:
+    KeyCache();
+
+    struct Entry {
+        Id id{};
+        SecureBytes key;
+        std::chrono::steady_clock::time_point expires;
+        uint64_t last_used = 0;
+    };
+
+    void evict_expired(std::chrono::steady_clock::time_point now);
+
+    mutable std::mutex mutex_;
+    SecureBytes id_key_;
+    std::vector<Entry> entries_;
+    size_t capacity_ = DEFAULT_CAPACITY;
+    std::chrono::seconds ttl_ = DEFAULT_TTL;
+    uint64_t clock_ = 0;
+    KeyCacheStats stats_;
+};
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_KEY_CACHE_HPP
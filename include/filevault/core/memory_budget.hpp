@@ -0,0 +1,134 @@
+#ifndef FILEVAULT_CORE_MEMORY_BUDGET_HPP
+#define FILEVAULT_CORE_MEMORY_BUDGET_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace filevault {
+namespace core {
+
+/**
+ * @brief One memory limit for the whole process (--max-memory, memory.max_mb)
+ *
+ * Whatever holds a lot of memory for a while leases it here: a stream
+ * its chunk buffers for as long as it runs, a key derivation its KDF
+ * memory. A lease waits while the budget is spent, so files and
+ * derivations running in parallel are throttled against each other
+ * instead of each assuming the machine is theirs. A lease larger than
+ * the whole budget is granted once nothing else is leased, so it still
+ * runs (alone). A thread holds at most one lease at a time, which keeps
+ * the waits free of deadlock.
+ *
+ * Sizes that are chosen rather than needed are fitted to fixed shares
+ * up front: a stream's chunk size and pipeline depth to stream_bytes(),
+ * key derivations running ahead to kdf_bytes(), the buffer pool's cache
+ * and the largest file processed in memory to a share each.
+ *
+ * Without a limit (the default) leases are free and nothing is fitted.
+ */
+class MemoryBudget {
+public:
+    /**
+     * @brief Leased bytes; returned to the budget on destruction
+     */
+    class Lease {
+    public:
+        Lease() = default;
+        ~Lease();
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        uint64_t bytes() const { return bytes_; }
+        void release();
+
+    private:
+        friend class MemoryBudget;
+        Lease(MemoryBudget* budget, uint64_t bytes) : budget_(budget), bytes_(bytes) {}
+
+        MemoryBudget* budget_ = nullptr;
+        uint64_t bytes_ = 0;
+    };
+
+    /**
+     * @brief Chunk geometry of one stream
+     */
+    struct StreamShape {
+        size_t chunk_size = 0;
+        size_t workers = 1;         // Chunks in crypto at once
+        size_t io_buffers = 0;      // Chunks read ahead
+    };
+
+    // Floor for a chunk size shrunk to fit the budget
+    static constexpr size_t MIN_CHUNK_SIZE = 64 * 1024;
+
+    explicit MemoryBudget(uint64_t limit = 0);
+
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    /**
+     * @brief The process-wide budget
+     */
+    static MemoryBudget& shared();
+
+    /**
+     * @brief Change the limit (0 = none); waiting leases are re-checked
+     */
+    void set_limit(uint64_t bytes);
+    uint64_t limit() const;
+    bool limited() const { return limit() > 0; }
+
+    /**
+     * @brief Wait until bytes fit next to the other leases, then hold them
+     */
+    Lease lease(uint64_t bytes);
+
+    /**
+     * @brief Hold bytes only if they fit right away
+     * @return Empty lease (bytes() == 0) if not
+     */
+    Lease try_lease(uint64_t bytes);
+
+    uint64_t in_use() const;
+    uint64_t peak() const;
+
+    // Shares of the limit; the fallback is returned when there is none
+    uint64_t stream_bytes(uint64_t fallback) const;     // Chunk buffers of all streams at once (1/2)
+    uint64_t kdf_bytes(uint64_t fallback) const;        // Key derivations at once (1/4)
+    uint64_t pool_bytes(uint64_t fallback) const;       // Buffer pool cache (1/8)
+    uint64_t in_memory_bytes(uint64_t fallback) const;  // Largest file read whole (1/8)
+
+    /**
+     * @brief Shrink a stream until its buffers fit stream_bytes()
+     * @param fixed_chunk The chunk size is set by an existing file
+     *
+     * Read-ahead goes first, then workers (down to one), then the chunk
+     * size (down to MIN_CHUNK_SIZE). The result may still exceed the
+     * share when the chunk size is fixed; its lease then runs alone.
+     */
+    StreamShape fit_stream(StreamShape shape, bool fixed_chunk) const;
+
+    /**
+     * @brief Bytes a stream holds: plaintext and ciphertext per buffered chunk
+     * @param chunks Chunks in the file, if known (a small file needs fewer buffers)
+     */
+    static uint64_t stream_cost(const StreamShape& shape, uint64_t chunks = 0);
+
+private:
+    void give_back(uint64_t bytes);
+
+    mutable std::mutex mutex_;
+    std::condition_variable freed_;
+    uint64_t limit_ = 0;
+    uint64_t in_use_ = 0;
+    uint64_t peak_ = 0;
+};
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_MEMORY_BUDGET_HPP
@@ -0,0 +1,83 @@
+#ifndef FILEVAULT_CORE_NUMA_HPP
+#define FILEVAULT_CORE_NUMA_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace filevault {
+namespace core {
+
+/**
+ * @brief NUMA topology and placement helpers
+ *
+ * The topology is read once from /sys/devices/system/node (Linux); other
+ * systems, and machines with a single node, report one node holding
+ * every CPU and the placement calls do nothing.
+ *
+ * Placement is off until set_enabled(true) (the global --numa option).
+ * When on, Executor::shared() pins its workers round-robin to nodes and
+ * steals from workers of the same node first, and BufferPool::shared()
+ * keeps buffers per node and hands back memory local to the caller.
+ */
+class Numa {
+public:
+    /**
+     * @brief Number of nodes (1 without NUMA)
+     */
+    static size_t node_count();
+
+    /**
+     * @brief CPUs of a node
+     */
+    static const std::vector<size_t>& node_cpus(size_t node);
+
+    /**
+     * @brief Node of a CPU (0 if unknown)
+     */
+    static size_t node_of_cpu(size_t cpu);
+
+    /**
+     * @brief Node the calling thread is running on
+     */
+    static size_t current_node();
+
+    /**
+     * @brief Restrict the calling thread to the CPUs of a node
+     * @return false if unsupported or refused
+     */
+    static bool pin_current_thread(size_t node);
+
+    /**
+     * @brief Prefer a node for the pages of [data, data + size) not yet touched
+     *
+     * Only whole pages inside the range are affected. Pages already
+     * faulted in stay where they are.
+     */
+    static bool prefer_node(void* data, size_t size, size_t node);
+
+    /**
+     * @brief Node holding the page at data (the caller's node if unknown)
+     */
+    static size_t node_of_memory(const void* data);
+
+    /**
+     * @brief Turn NUMA-aware placement on or off (before first use of the shared pools)
+     */
+    static void set_enabled(bool enabled);
+
+    /**
+     * @brief Whether placement is on and there is more than one node
+     */
+    static bool enabled();
+
+    /**
+     * @brief Parse a kernel CPU list such as "0-3,8,10-11"
+     */
+    static std::vector<size_t> parse_cpu_list(const std::string& list);
+};
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_NUMA_HPP
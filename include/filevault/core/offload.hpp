@@ -0,0 +1,164 @@
+#ifndef FILEVAULT_CORE_OFFLOAD_HPP
+#define FILEVAULT_CORE_OFFLOAD_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+
+namespace filevault {
+namespace core {
+
+/**
+ * @brief What a keystream device call did
+ */
+enum class OffloadStatus {
+    DONE,       // data holds the result
+    BUSY,       // Another thread has the device; data untouched, do it on the CPU
+    FAILED      // Device error; data untouched
+};
+
+/**
+ * @brief Accelerator that XORs a counter-mode keystream into a buffer
+ *
+ * Only the keystream is offloaded: it does not depend on the data, so
+ * the device works through a buffer in independent blocks while the
+ * authenticator (GHASH, Poly1305) stays on the CPU. Calls from several
+ * threads are safe; a device serves one at a time and answers BUSY to
+ * the others, which then use their own CPU instead of queueing.
+ */
+class IKeystreamDevice {
+public:
+    virtual ~IKeystreamDevice() = default;
+
+    virtual std::string name() const = 0;
+
+    /**
+     * @brief AES in CTR mode, 128-bit big-endian counter
+     * @param key 16, 24 or 32 bytes
+     * @param counter Counter block of the first block of data
+     */
+    virtual OffloadStatus aes_ctr(std::span<const uint8_t> key, std::span<const uint8_t, 16> counter,
+                                  std::span<uint8_t> data) = 0;
+
+    /**
+     * @brief ChaCha20 (RFC 8439: 96-bit nonce, 32-bit block counter)
+     */
+    virtual OffloadStatus chacha20(std::span<const uint8_t, 32> key, std::span<const uint8_t, 12> nonce,
+                                   uint32_t counter, std::span<uint8_t> data) = 0;
+};
+
+enum class OffloadMode {
+    OFF,        // Everything on the CPU (default)
+    AUTO,       // A GPU or accelerator if one is found
+    OPENCL      // OpenCL, warning when no device is found
+};
+
+/**
+ * @brief Process-wide keystream device selection (--offload, crypto.offload)
+ *
+ * The device is probed on first use. Messages smaller than min_bytes()
+ * stay on the CPU: below a few MB the PCIe round trip costs more than
+ * the CPU needs. A device that fails is dropped for the rest of the
+ * run, and the failed message is redone on the CPU.
+ */
+class Offload {
+public:
+    static constexpr size_t DEFAULT_MIN_BYTES = 4 * 1024 * 1024;
+
+    static std::optional<OffloadMode> parse_mode(const std::string& text);
+
+    static void configure(OffloadMode mode, size_t min_bytes = DEFAULT_MIN_BYTES);
+
+    /**
+     * @brief The selected device, or nullptr for CPU only
+     */
+    static IKeystreamDevice* device();
+
+    static size_t min_bytes();
+
+    /**
+     * @brief Change the size threshold, keeping the device
+     */
+    static void set_min_bytes(size_t min_bytes);
+
+    /**
+     * @brief Stop using the device (after a failure)
+     */
+    static void disable(const std::string& reason);
+
+    /**
+     * @brief Known-answer check of both kernels against Botan
+     *
+     * device() runs it on every device it opens and stays on the CPU when
+     * it fails.
+     *
+     * @param detail Which kernel disagreed
+     */
+    static bool self_test(IKeystreamDevice& device, std::string& detail);
+
+    /**
+     * @brief Use this device instead of probing (tests, benchmarks)
+     */
+    static void install(std::unique_ptr<IKeystreamDevice> device, size_t min_bytes = DEFAULT_MIN_BYTES);
+};
+
+/**
+ * @brief First OpenCL GPU or accelerator, through the system's OpenCL loader
+ *
+ * The loader is opened at run time, so builds need no OpenCL SDK and
+ * hosts without one simply have no device.
+ *
+ * @param detail Device name, or why none is available
+ */
+std::unique_ptr<IKeystreamDevice> open_opencl_device(std::string& detail);
+
+/**
+ * @brief Portable versions of the device kernels
+ *
+ * The same arithmetic as the OpenCL kernels, block for block: devices
+ * hand buffer tails shorter than a block to these, and the tests check
+ * them against the FIPS-197, SP 800-38A and RFC 8439 vectors.
+ */
+namespace keystream {
+
+constexpr size_t AES_MAX_ROUND_WORDS = 60;
+
+struct AesTables {
+    std::array<uint8_t, 256> sbox;
+    std::array<uint32_t, 256> te0;      // Te1..Te3 are byte rotations of it
+};
+
+const AesTables& aes_tables();
+
+/**
+ * @brief FIPS-197 key expansion into big-endian round key words
+ * @return Number of rounds (10, 12 or 14), 0 for a bad key size
+ */
+int aes_expand_key(std::span<const uint8_t> key, std::array<uint32_t, AES_MAX_ROUND_WORDS>& round_keys);
+
+void aes_encrypt_block(const std::array<uint32_t, AES_MAX_ROUND_WORDS>& round_keys, int rounds,
+                       const uint8_t in[16], uint8_t out[16]);
+
+/**
+ * @brief Add blocks to a big-endian 128-bit counter block
+ */
+void add_counter(std::span<uint8_t, 16> counter, uint64_t blocks);
+
+void aes_ctr_xor(std::span<const uint8_t> key, std::span<const uint8_t, 16> counter, std::span<uint8_t> data);
+
+void chacha20_block(std::span<const uint8_t, 32> key, std::span<const uint8_t, 12> nonce, uint32_t counter,
+                    uint8_t out[64]);
+
+void chacha20_xor(std::span<const uint8_t, 32> key, std::span<const uint8_t, 12> nonce, uint32_t counter,
+                  std::span<uint8_t> data);
+
+} // namespace keystream
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_OFFLOAD_HPP
@@ -0,0 +1,85 @@
+#ifndef FILEVAULT_CORE_RANDOM_HPP
+#define FILEVAULT_CORE_RANDOM_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <botan/rng.h>
+
+namespace filevault {
+namespace core {
+
+/**
+ * @brief Process-wide source of cryptographic randomness
+ *
+ * Each thread lazily gets its own Botan::AutoSeeded_RNG (HMAC_DRBG),
+ * seeded once from the operating system and reseeded automatically by
+ * Botan after a fixed number of requests or a fork(). This replaces
+ * constructing, and therefore seeding, a new RNG on every call.
+ */
+class RandomService {
+public:
+    /**
+     * @brief Calling thread's generator, for Botan APIs that take an RNG
+     */
+    static Botan::RandomNumberGenerator& rng();
+    
+    /**
+     * @brief Fill a buffer with random bytes
+     */
+    static void fill(std::span<uint8_t> output);
+    
+    /**
+     * @brief Return length random bytes
+     */
+    static std::vector<uint8_t> bytes(size_t length);
+};
+
+/**
+ * @brief Nonce sequence: fixed random prefix + 64-bit big-endian counter
+ *
+ * For paths that encrypt many messages under one key and only need
+ * uniqueness, not unpredictability. The prefix and the counter start are
+ * random, so independent generators for the same key collide with
+ * negligible probability. next() is thread-safe.
+ */
+class CounterNonce {
+public:
+    /**
+     * @param nonce_size Nonce length in bytes (at least 8)
+     */
+    explicit CounterNonce(size_t nonce_size = 12);
+    
+    // Prevent copying (a copy would repeat nonces)
+    CounterNonce(const CounterNonce&) = delete;
+    CounterNonce& operator=(const CounterNonce&) = delete;
+    
+    /**
+     * @brief Write the next nonce into output (output.size() == nonce_size())
+     */
+    void next(std::span<uint8_t> output);
+    
+    /**
+     * @brief Return the next nonce
+     */
+    std::vector<uint8_t> next();
+    
+    /**
+     * @brief Reserve count consecutive nonces, written back to back
+     */
+    void next_n(std::span<uint8_t> output, size_t count);
+    
+    size_t nonce_size() const { return prefix_.size() + sizeof(uint64_t); }
+
+private:
+    static void write_nonce(std::span<uint8_t> output, std::span<const uint8_t> prefix, uint64_t counter);
+    
+    std::vector<uint8_t> prefix_;
+    std::atomic<uint64_t> counter_;
+};
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_RANDOM_HPP
@@ -5,12 +5,25 @@
 #include <vector>
 #include <cstdint>
 #include <optional>
+#include <span>
 #include <stdexcept>
 #include "types.hpp"
 
 namespace filevault {
 namespace core {
 
+/**
+ * @brief Nonce, ciphertext and tag of one message, pointing into storage owned elsewhere
+ *
+ * Valid while that storage (a CryptoResult, a caller buffer or a batch
+ * arena) is alive and unchanged.
+ */
+struct MessageView {
+    std::span<const uint8_t> nonce;
+    std::span<const uint8_t> data;
+    std::span<const uint8_t> tag;
+};
+
 /**
  * @brief Result of cryptographic operations
  */
@@ -25,10 +38,61 @@ struct CryptoResult {
     size_t final_size = 0;
     double processing_time_ms = 0.0;
     
-    // Additional info
-    std::optional<std::vector<uint8_t>> salt;
-    std::optional<std::vector<uint8_t>> nonce;
-    std::optional<std::vector<uint8_t>> tag;
+    // Additional info (inline, so in-place calls allocate nothing)
+    std::optional<ShortBytes> salt;
+    std::optional<ShortBytes> nonce;
+    std::optional<ShortBytes> tag;
+    
+    /**
+     * @brief View of a sealed message whose ciphertext is in a caller buffer
+     * @param output Ciphertext (e.g. the buffer passed to encrypt_in_place())
+     */
+    MessageView view(std::span<const uint8_t> output) const {
+        MessageView v;
+        v.data = output;
+        if (nonce) {
+            v.nonce = std::span<const uint8_t>(nonce->data(), nonce->size());
+        }
+        if (tag) {
+            v.tag = std::span<const uint8_t>(tag->data(), tag->size());
+        }
+        return v;
+    }
+};
+
+/**
+ * @brief Location of one message inside a batch arena
+ *
+ * Sealed messages are stored contiguously as [nonce][ciphertext][tag];
+ * decrypted ones have no nonce or tag.
+ */
+struct BatchRecord {
+    size_t offset = 0;
+    size_t nonce_size = 0;
+    size_t data_size = 0;
+    size_t tag_size = 0;
+    
+    size_t data_offset() const { return offset + nonce_size; }
+    size_t tag_offset() const { return data_offset() + data_size; }
+    size_t total_size() const { return nonce_size + data_size + tag_size; }
+    
+    /**
+     * @brief The message inside the arena it was written to
+     */
+    MessageView view(std::span<const uint8_t> arena) const {
+        return {arena.subspan(offset, nonce_size), arena.subspan(data_offset(), data_size),
+                arena.subspan(tag_offset(), tag_size)};
+    }
+};
+
+/**
+ * @brief Result of a batch operation
+ */
+struct BatchResult {
+    bool success = false;
+    std::string error_message;
+    size_t failed_index = 0;            // First message that failed
+    std::vector<BatchRecord> records;   // One per message, empty on failure
 };
 
 /**
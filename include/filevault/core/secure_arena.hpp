@@ -0,0 +1,125 @@
+#ifndef FILEVAULT_CORE_SECURE_ARENA_HPP
+#define FILEVAULT_CORE_SECURE_ARENA_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace filevault {
+namespace core {
+
+/**
+ * @brief Secure arena counters
+ */
+struct SecureArenaStats {
+    size_t capacity = 0;            // Bytes in the region
+    size_t in_use = 0;              // Bytes handed out from the region (rounded to size classes)
+    size_t peak = 0;
+    uint64_t fallbacks = 0;         // Allocations served from the ordinary heap
+    bool locked = false;            // The region is pinned in RAM
+};
+
+/**
+ * @brief Locked memory for keys, nonces and KDF outputs
+ *
+ * One region is mapped when the arena is created: pinned in RAM (mlock,
+ * VirtualLock), left out of core dumps (MADV_DONTDUMP) and not passed on
+ * to forked children (MADV_WIPEONFORK). Allocations come from size
+ * classes of 32 bytes to 4 KB with a free list each, so handing out and
+ * returning a key costs no system call; a returned block is zeroed at
+ * once. The region is wiped as a whole when the arena goes away.
+ *
+ * Requests larger than a size class, or made once the region is full,
+ * fall back to the ordinary heap (still zeroed on release) and are
+ * counted in stats().fallbacks. If the OS refuses to lock the region
+ * (RLIMIT_MEMLOCK), it is used unlocked and stats().locked is false.
+ */
+class SecureArena {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+    static constexpr size_t MIN_CLASS = 32;
+    static constexpr size_t MAX_CLASS = 4096;
+
+    /**
+     * @brief Process-wide arena used by SecureAllocator
+     */
+    static SecureArena& shared();
+
+    explicit SecureArena(size_t capacity = DEFAULT_CAPACITY);
+    ~SecureArena();
+
+    // Prevent copying
+    SecureArena(const SecureArena&) = delete;
+    SecureArena& operator=(const SecureArena&) = delete;
+
+    /**
+     * @brief Get size bytes (zero-filled), never nullptr
+     * @throws std::bad_alloc if the heap fallback fails
+     */
+    void* allocate(size_t size);
+
+    /**
+     * @brief Zero and return a block from allocate(size)
+     */
+    void deallocate(void* data, size_t size) noexcept;
+
+    /**
+     * @brief Whether data lies in the locked region
+     */
+    bool owns(const void* data) const;
+
+    SecureArenaStats stats() const;
+
+private:
+    static constexpr size_t CLASSES = 8;   // 32, 64, ... 4096
+
+    static size_t class_index(size_t size);
+
+    uint8_t* region_ = nullptr;
+    size_t capacity_ = 0;
+    bool locked_ = false;
+
+    mutable std::mutex mutex_;
+    size_t used_ = 0;                       // Bump offset into the region
+    std::array<void*, CLASSES> free_{};     // Free blocks, linked through their first bytes
+    size_t in_use_ = 0;
+    size_t peak_ = 0;
+    uint64_t fallbacks_ = 0;
+};
+
+/**
+ * @brief Standard allocator over SecureArena::shared()
+ */
+template<typename T>
+class SecureAllocator {
+public:
+    using value_type = T;
+
+    SecureAllocator() noexcept = default;
+
+    template<typename U>
+    SecureAllocator(const SecureAllocator<U>&) noexcept {}
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(SecureArena::shared().allocate(count * sizeof(T)));
+    }
+
+    void deallocate(T* data, size_t count) noexcept {
+        SecureArena::shared().deallocate(data, count * sizeof(T));
+    }
+
+    template<typename U>
+    bool operator==(const SecureAllocator<U>&) const noexcept { return true; }
+};
+
+/**
+ * @brief Byte vector in the secure arena (keys, derived secrets)
+ */
+using SecureBytes = std::vector<uint8_t, SecureAllocator<uint8_t>>;
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_SECURE_ARENA_HPP
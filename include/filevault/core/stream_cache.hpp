@@ -0,0 +1,97 @@
+#ifndef FILEVAULT_CORE_STREAM_CACHE_HPP
+#define FILEVAULT_CORE_STREAM_CACHE_HPP
+
+#include "filevault/core/streaming.hpp"
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace filevault {
+namespace core {
+
+class ThreadPool;
+
+/**
+ * @brief Chunk cache counters
+ */
+struct StreamCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t prefetched = 0;        // Chunks decrypted ahead of a sequential reader
+};
+
+/**
+ * @brief Thread-safe random access to a StreamReader with a chunk cache
+ *
+ * StreamReader keeps only the last chunk it opened, so readers jumping
+ * between files of a mounted archive would decrypt the same chunks over
+ * and over. This keeps the most recently used decrypted chunks in an LRU
+ * cache and, once reads run sequentially, decrypts the next chunks on a
+ * background thread before they are asked for.
+ *
+ * The StreamReader must stay open for the lifetime of this object and
+ * must not be used directly meanwhile.
+ */
+class CachedStreamReader {
+public:
+    static constexpr size_t DEFAULT_CACHE_CHUNKS = 32;
+    static constexpr size_t DEFAULT_READAHEAD_CHUNKS = 2;
+
+    /**
+     * @param cache_chunks Decrypted chunks kept (at least 1)
+     * @param readahead_chunks Chunks prefetched past a sequential read (0 = none)
+     */
+    explicit CachedStreamReader(StreamReader& reader,
+                                size_t cache_chunks = DEFAULT_CACHE_CHUNKS,
+                                size_t readahead_chunks = DEFAULT_READAHEAD_CHUNKS);
+    ~CachedStreamReader();
+
+    CachedStreamReader(const CachedStreamReader&) = delete;
+    CachedStreamReader& operator=(const CachedStreamReader&) = delete;
+
+    /**
+     * @brief Plaintext bytes [offset, offset + length), clamped to the end
+     * @return Error message, empty on success
+     */
+    std::string read(uint64_t offset, size_t length, std::vector<uint8_t>& output);
+
+    uint64_t size() const { return size_; }
+    size_t chunk_size() const { return chunk_size_; }
+    StreamCacheStats stats() const;
+
+private:
+    using Chunk = std::shared_ptr<const std::vector<uint8_t>>;
+
+    Chunk find(size_t index);
+    Chunk load(size_t index, std::string& error);
+    void insert(size_t index, Chunk chunk);
+    void prefetch(size_t first, size_t last);
+
+    StreamReader& reader_;
+    uint64_t size_ = 0;
+    size_t chunk_size_ = 0;
+    size_t chunk_count_ = 0;
+    size_t capacity_;
+    size_t readahead_;
+
+    std::mutex reader_mutex_;                       // Held while decrypting
+    mutable std::mutex cache_mutex_;
+    std::list<std::pair<size_t, Chunk>> lru_;       // Most recently used first
+    std::unordered_map<size_t, std::list<std::pair<size_t, Chunk>>::iterator> index_;
+    std::unordered_set<size_t> queued_;             // Prefetches not yet run
+    size_t next_sequential_ = SIZE_MAX;             // Chunk after the last read
+    StreamCacheStats stats_;
+
+    std::atomic<bool> stopping_{false};
+    std::unique_ptr<ThreadPool> prefetcher_;        // Declared last: joined first
+};
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_STREAM_CACHE_HPP
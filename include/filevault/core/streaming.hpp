@@ -6,10 +6,20 @@
 #include <string>
 #include <functional>
 #include <fstream>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <span>
 #include "types.hpp"
 #include "result.hpp"
 
 namespace filevault {
+namespace utils {
+class CommitGroup;
+struct FileExtent;
+}
+
 namespace core {
 
 /**
@@ -18,9 +28,9 @@ namespace core {
 struct ChunkInfo {
     size_t chunk_index;
     size_t chunk_size;
-    size_t total_chunks;
+    size_t total_chunks;     // 0 when the input length is unknown (pipes)
     size_t bytes_processed;
-    size_t total_bytes;
+    size_t total_bytes;      // 0 when the input length is unknown (pipes)
 };
 
 /**
@@ -30,6 +40,20 @@ struct ChunkInfo {
  */
 using StreamProgressCallback = std::function<bool(const ChunkInfo& info)>;
 
+/**
+ * @brief Checkpointing of encrypt_file() / decrypt_file() jobs
+ *
+ * Every interval chunks the output is flushed to disk and a Checkpoint
+ * sidecar ("<output>.fvckpt") records what is durable. After a crash the
+ * same call with resume = true checks the sidecar against the input and
+ * the existing output, then continues after the last committed chunk.
+ * The sidecar is deleted once the job completes.
+ */
+struct CheckpointOptions {
+    size_t interval = 0;    // Chunks between checkpoints (0 = none)
+    bool resume = false;    // Continue from an existing checkpoint
+};
+
 /**
  * @brief Configuration for streaming encryption
  */
@@ -41,6 +65,119 @@ struct StreamingConfig {
     CompressionType compression = CompressionType::NONE;
     int compression_level = 6;
     StreamProgressCallback progress_callback = nullptr;
+    
+    /**
+     * Worker threads for chunk compression/encryption.
+     * 1 = serial (default), 0 = one per hardware thread. Chunks run on
+     * Executor::shared(), at most this many at once.
+     * Chunks are always written in order, so the output is identical
+     * in layout regardless of this setting.
+     */
+    size_t worker_threads = 1;
+    
+    /**
+     * Read-ahead depth in chunks. With a non-zero value a background thread
+     * keeps this many chunks buffered and crypto runs off the writer thread,
+     * so disk I/O overlaps with compression/encryption. 0 = fully synchronous.
+     */
+    size_t io_buffers = 2;
+    
+    /**
+     * Pick chunk_size by timing read + compress + encrypt on a sample of the
+     * input for several candidate sizes (64KB..64MB) and keeping the fastest.
+     * The chosen size is stored in the header; chunk_size is the fallback
+     * for inputs too small to calibrate.
+     */
+    bool adaptive_chunk_size = false;
+    
+    /**
+     * Store chunks raw, without trying the compressor, when a sampled
+     * entropy estimate predicts no gain (already-compressed media).
+     * Whether each chunk is compressed is recorded in its frame either way.
+     */
+    bool skip_incompressible = true;
+    
+    /**
+     * Let the compression level follow backpressure, between
+     * min_compression_level and max_compression_level starting from
+     * compression_level: raised while compressed chunks queue up for the
+     * writer, lowered while the writer waits for them (see
+     * compression::AdaptiveLevel). Needs the worker pool, so it has no
+     * effect with worker_threads = 1 and io_buffers = 0. Decoders need no
+     * level, so the file format is unchanged; StreamingResult::frame_levels
+     * reports the level of each frame.
+     */
+    bool adaptive_compression_level = false;
+    int min_compression_level = 1;
+    int max_compression_level = 9;
+    
+    /**
+     * Memory cap for all chunk buffers alive at once in adaptive mode.
+     * 0 = allow get_recommended_chunk_size() per buffer.
+     */
+    size_t max_chunk_memory = 0;
+    
+    /**
+     * Salt for the password KDF instead of a fresh random one. Files of
+     * a batch are given CryptoEngine::batch_file_salt() of one batch salt:
+     * they pay for one KDF through KeyCache, but each has its own key.
+     * Either way, a shared (batch) salt reveals a shared password.
+     */
+    std::vector<uint8_t> salt;
+    
+    /**
+     * Checkpoints for encrypt_file(). A resumed job takes the algorithm,
+     * KDF, compression and chunk size from the existing output's header.
+     */
+    CheckpointOptions checkpoint;
+    
+    /**
+     * Keep encrypt_file() out of the page cache: the input is read with
+     * O_DIRECT (or evicted as it is consumed) and the output is written
+     * back and evicted every few megabytes. For bulk jobs on hosts whose
+     * other workloads depend on a warm cache.
+     */
+    bool bypass_cache = false;
+    
+    /**
+     * Without checkpoints encrypt_file() writes a temp file and renames
+     * it into place after one fsync. With a group the sync and rename
+     * are deferred so that many outputs are synced together.
+     */
+    utils::CommitGroup* commit_group = nullptr;
+    
+    /**
+     * Write 8-byte frame sizes and chunk count (FVAULT02 flag 0x02).
+     * Chosen automatically when a chunk or a known chunk count does not
+     * fit in 4 bytes (streams of unknown length count chunks in their
+     * 8-byte trailer). Files without it stay readable by releases that
+     * predate wide frames.
+     */
+    bool wide_frames = false;
+    
+    /**
+     * Opaque bytes (at most 255) describing the source, stored in the
+     * header (FVAULT02 flag 0x04) and covered by its tag. read_info()
+     * returns them without a key, so 'encrypt -r --sync' can tell which
+     * outputs are current from their headers alone. Must not reveal the
+     * contents: anyone can read it.
+     */
+    std::vector<uint8_t> fingerprint;
+};
+
+/**
+ * @brief Time spent in each pipeline stage of one streaming run
+ *
+ * Compression and cipher work runs on the worker pool, so those figures
+ * are summed over workers and together can exceed processing_time_ms.
+ * Writes are buffered; durability (fsync) is the caller's to time.
+ */
+struct StageTimes {
+    double read_ms = 0.0;
+    double kdf_ms = 0.0;
+    double compress_ms = 0.0;   // Decompression when decrypting
+    double cipher_ms = 0.0;
+    double write_ms = 0.0;
 };
 
 /**
@@ -51,8 +188,68 @@ struct StreamingResult {
     std::string error_message;
     size_t bytes_processed = 0;
     size_t chunks_processed = 0;
+    size_t chunk_size = 0;  // Chunk size used (chosen or read from header)
+    size_t chunks_compressed = 0;   // Encryption: chunks stored compressed
+    size_t chunks_skipped = 0;      // Encryption: predicted incompressible, not tried
+    size_t chunks_sparse = 0;       // Encryption: inside holes of the input, stored as zero extents
+    double skip_rate = 0.0;         // chunks_skipped / chunks_processed
+    size_t chunks_resumed = 0;      // Chunks kept from an interrupted run (included above)
+    std::vector<int> frame_levels;  // Adaptive encryption: level of each frame written (0 = stored)
+    uint64_t bytes_written = 0;     // encrypt_file/decrypt_file: size of the output file
     double processing_time_ms = 0.0;
     double throughput_mbps = 0.0;
+    StageTimes stages;
+};
+
+class ICryptoAlgorithm;
+
+/**
+ * @brief Header fields of a streaming file, for inspection without a key
+ */
+struct StreamInfo {
+    uint8_t version = 0;                    // 1-2 for FVST streams, 3-4 for FVAULT02 (4: wide frames)
+    AlgorithmType algorithm = AlgorithmType::AES_256_GCM;
+    KDFType kdf = KDFType::ARGON2ID;
+    SecurityLevel level = SecurityLevel::STRONG;
+    CompressionType compression = CompressionType::NONE;
+    size_t chunk_size = 0;
+    std::optional<uint64_t> original_size;  // Unset for streams of unknown length
+    std::optional<size_t> chunk_count;
+    size_t salt_size = 0;
+    std::vector<uint8_t> salt;              // KDF salt (public, stored in the header)
+    size_t nonce_size = 0;
+    size_t header_size = 0;                 // Including the header tag
+    bool authenticated_header = false;      // FVAULT02 header tag present
+    bool wrapped_key = false;               // Random file key wrapped by the password (rekey works)
+    uint16_t key_generation = 0;            // Header rewrites so far (password changes, appends)
+    bool wide_frames = false;               // 8-byte frame sizes and chunk count
+    std::vector<uint8_t> fingerprint;       // StreamingConfig::fingerprint; empty when none
+};
+
+/**
+ * @brief What StreamingCrypto::rekey_file() changes besides the password
+ */
+struct RekeyOptions {
+    std::optional<KDFType> kdf;             // Unset keeps the file's KDF
+    std::optional<SecurityLevel> level;     // Unset keeps the file's security level
+    
+    /**
+     * New KDF salt, as long as the file's; random when empty. Files given
+     * the same password and salt (a tree) share one KDF through KeyCache.
+     * A file with a batch file salt takes a 32-byte batch salt instead and
+     * gets a new file salt in that batch.
+     */
+    std::vector<uint8_t> salt;
+};
+
+/**
+ * @brief Where one chunk frame lies in a streaming file, found without a key
+ */
+struct FrameLocation {
+    uint64_t offset = 0;                    // Of the size prefix (4 bytes, 8 if wide)
+    uint64_t size = 0;                      // Prefix, ciphertext and tag
+    bool compressed = false;
+    bool zero_extent = false;               // Stands for a chunk of zeros
 };
 
 /**
@@ -65,8 +262,48 @@ struct StreamingResult {
  * File format for streaming:
  * [Header][Chunk1][Chunk2]...[ChunkN][Footer]
  * 
+ * Header (FVAULT02, format version 2.0):
+ * [Magic "FVAULT02":8][AlgoID:1][KDFID:1][CompID:1][Level:1][Flags:1]
+ * [KeyGeneration:2][Reserved:1]
+ * [ChunkSize:8][TotalSize:8][ChunkCount:4 or 8][SaltLen:1][Salt][NonceLen:1][Nonce]
+ * [WrappedLen:1][WrappedKey] (flag 0x01 only)
+ * [HeaderTag:16]
+ * With flag 0x01 the file key is random and WrappedKey is that key
+ * encrypted (AEAD, tag appended) under the key the KDF derives from the
+ * password. Changing the password then rewrites only the header
+ * (rekey_file); KeyGeneration counts such rewrites, appends included
+ * (append_stream). Without the flag
+ * (files written before wrapping) the KDF output is the file key.
+ * Flag 0x02 (wide frames) makes ChunkCount and every frame size prefix
+ * 8 bytes, for chunks of 2 GB and more or counts of 2^32 - 1 and more.
+ * Readers refuse flag bits they do not know.
+ * HeaderTag is the AEAD tag of an empty message with the preceding header
+ * bytes as associated data, under the file key and a nonce no chunk uses
+ * (nor any earlier generation's header). It is checked before any chunk
+ * is opened, so a wrong password or an edited chunk size, count or
+ * algorithm fails up front. Older "FVST"
+ * streams (versions 1 and 2) have a 4-byte magic, a version byte, no
+ * security level and no header tag; they remain readable.
+ * 
  * Each chunk:
- * [4 bytes: chunk_size][12 bytes: nonce][encrypted_data][16 bytes: tag]
+ * [4 bytes (8 if wide): encrypted_size][encrypted_data][16 bytes: tag]
+ * The top bit of encrypted_size flags a compressed chunk; the flag is
+ * also the chunk's associated data, so it is authenticated by the tag.
+ * (Version 1 streams have no flag: a chunk is raw iff its frame holds
+ * exactly the plaintext size.)
+ * A chunk that lies entirely in a hole of a sparse input is a zero
+ * extent: the flag with a size of 0 and only the tag, with associated
+ * data 2. It decrypts to chunk-size zeros, written back as a hole.
+ * 
+ * Footer (frame index for random access):
+ * [8 bytes: offset of Chunk1]...[8 bytes: offset of ChunkN]
+ * [8 bytes: offset of the footer]["FVIX"]
+ * Files without a footer are still readable; frames are then located by
+ * walking the chunk size prefixes.
+ * 
+ * Streams of unknown length (encrypt_stream) store all-ones size and chunk
+ * count in the header and end with an authenticated trailer instead:
+ * [4 bytes: 0xFFFFFFFF (8 if wide)][16 bytes: encrypted total size + chunk count][16 bytes: tag]
  */
 class StreamingCrypto {
 public:
@@ -85,21 +322,243 @@ class StreamingCrypto {
         const StreamingConfig& config = {}
     );
     
+    /**
+     * @brief Encrypt from a non-seekable stream (e.g. stdin) until EOF
+     * @param input Source stream, opened in binary mode
+     * @param output Destination stream
+     * @param password Encryption password
+     * @param config Streaming configuration (adaptive sizing is ignored)
+     * @return Result of the operation
+     *
+     * The input length is not needed up front; the stream ends with an
+     * authenticated trailer so truncation is detected on decryption.
+     */
+    static StreamingResult encrypt_stream(
+        std::istream& input,
+        std::ostream& output,
+        const std::string& password,
+        const StreamingConfig& config = {}
+    );
+    
+    /**
+     * @brief Encrypt a stream whose length is known up front
+     * @param input Source stream; must yield exactly input_size bytes
+     * @param output Destination stream
+     * @param password Encryption password
+     * @param input_size Number of bytes to encrypt
+     * @param config Streaming configuration
+     * @return Result of the operation
+     *
+     * Same layout as encrypt_file (frame index, adaptive chunk sizing),
+     * for sources that are not a single file, such as an archive built on
+     * the fly. Adaptive sizing seeks the input back to its start.
+     */
+    static StreamingResult encrypt_stream(
+        std::istream& input,
+        std::ostream& output,
+        const std::string& password,
+        size_t input_size,
+        const StreamingConfig& config = {}
+    );
+    
+    /**
+     * @brief Encrypt with a ready data key instead of a password
+     * @param data_key Key of config.algorithm's size, used as is
+     * @param input_size Input length, or std::nullopt to read until EOF
+     *
+     * No KDF runs and the header carries an empty salt. For envelope
+     * encryption, where the data key is random and wrapped separately.
+     */
+    static StreamingResult encrypt_stream_with_key(
+        std::istream& input,
+        std::ostream& output,
+        std::span<const uint8_t> data_key,
+        std::optional<size_t> input_size,
+        const StreamingConfig& config = {}
+    );
+    
     /**
      * @brief Decrypt a large file using streaming
      * @param input_path Path to encrypted file
      * @param output_path Path to output file
      * @param password Decryption password
      * @param progress_callback Optional progress callback
+     * @param worker_threads Workers for decrypt/decompress (1 = serial, 0 = auto)
+     * @param checkpoint Checkpoint interval, or resume an interrupted run
+     * @param bypass_cache Keep input and output out of the page cache
+     *                     (see StreamingConfig::bypass_cache)
+     * @param commit_group Defer the final sync (see StreamingConfig::commit_group)
      * @return Result of the operation
+     *
+     * Chunks are written in order; the first authentication failure
+     * cancels all chunks still queued. A resume revalidates the
+     * committed frames of the input, but not the plaintext written so far.
      */
     static StreamingResult decrypt_file(
         const std::string& input_path,
         const std::string& output_path,
         const std::string& password,
+        StreamProgressCallback progress_callback = nullptr,
+        size_t worker_threads = 1,
+        const CheckpointOptions& checkpoint = {},
+        bool bypass_cache = false,
+        utils::CommitGroup* commit_group = nullptr
+    );
+    
+    /**
+     * @brief Decrypt streaming data from a non-seekable stream (e.g. stdin)
+     * @param input Source stream, opened in binary mode
+     * @param output Destination stream
+     * @param password Decryption password
+     * @param progress_callback Optional progress callback
+     * @param worker_threads Workers for decrypt/decompress (1 = serial, 0 = auto)
+     * @return Result of the operation
+     *
+     * Accepts both regular and unknown-length streams. Chunks are
+     * authenticated before being written, but truncation of an
+     * unknown-length stream is only detected at the trailer, after
+     * earlier chunks were already written.
+     */
+    static StreamingResult decrypt_stream(
+        std::istream& input,
+        std::ostream& output,
+        const std::string& password,
+        StreamProgressCallback progress_callback = nullptr,
+        size_t worker_threads = 1
+    );
+    
+    /**
+     * @brief Decrypt a stream written by encrypt_stream_with_key()
+     */
+    static StreamingResult decrypt_stream_with_key(
+        std::istream& input,
+        std::ostream& output,
+        std::span<const uint8_t> data_key,
+        StreamProgressCallback progress_callback = nullptr,
+        size_t worker_threads = 1
+    );
+    
+    /**
+     * @brief Decrypt a byte range of a streaming file without a full pass
+     * @param input_path Path to encrypted file
+     * @param password Decryption password
+     * @param offset Offset into the original plaintext
+     * @param length Number of bytes to return (clamped to end of file)
+     * @param output Receives the decrypted range (empty on failure)
+     * @return Result of the operation
+     *
+     * Only the chunks overlapping the range are read and authenticated.
+     */
+    static StreamingResult decrypt_range(
+        const std::string& input_path,
+        const std::string& password,
+        uint64_t offset,
+        size_t length,
+        std::vector<uint8_t>& output
+    );
+    
+    /**
+     * @brief Change the password of a FVAULT02 file in place
+     * @param password Current password
+     * @param new_password Password to wrap the file key under from now on
+     * @return stages.kdf_ms covers both derivations; bytes_written is the header size
+     *
+     * One KDF for each password and a rewrite of the header (a few hundred
+     * bytes, one sector at offset 0, synced); the chunks are not read.
+     * The file key does not change: anyone who kept it, or a copy of the
+     * file from before the change, can still decrypt the payload. Files
+     * written before key wrapping must be re-encrypted once.
+     */
+    static StreamingResult rekey_file(
+        const std::string& path,
+        const std::string& password,
+        const std::string& new_password,
+        const RekeyOptions& options = {}
+    );
+    
+    /**
+     * @brief Add data to the end of a FVAULT02 file in place
+     * @param path File of known length that ends on a chunk boundary
+     * @param input Source stream; must yield exactly input_size bytes
+     * @param worker_threads Workers for compress/encrypt (1 = serial, 0 = auto)
+     * @return bytes_processed and chunks_processed cover the whole file,
+     *         chunks_resumed the chunks that were already there
+     *
+     * New chunks continue the chunk numbering (and so the nonces) after
+     * the last one and overwrite the frame index; a new index follows
+     * them. Nothing before the old index is rewritten except the header,
+     * which is written last, once the new frames are synced, with the new
+     * size and chunk count and the next key generation (a fresh header
+     * nonce). Until then the file reads as it was. A file whose data does
+     * not end exactly in its index, as one left by an interrupted append,
+     * is refused: its spare frames have used the nonces new chunks would
+     * get. Compression is the file's, at the default level.
+     */
+    static StreamingResult append_stream(
+        const std::string& path,
+        const std::string& password,
+        std::istream& input,
+        size_t input_size,
+        size_t worker_threads = 1
+    );
+    
+    /**
+     * @brief Lay out a file that several independent workers encrypt together
+     * @param config Algorithm, KDF, level and chunk size (the chunk grid);
+     *               compression must be NONE
+     * @return bytes_written is the size output_path was extended to
+     *
+     * For inputs too large for one host, on a file system every worker
+     * mounts. Writes the header, with a random file key wrapped under the
+     * password, and extends the output to its final size: uncompressed
+     * frames all hold a whole chunk (the last one excepted), so where each
+     * lands is known before any is written. Each worker then runs
+     * encrypt_shard() for its rank, without talking to the others, and
+     * stitch_shards() writes the frame index once every rank has finished.
+     */
+    static StreamingResult init_shards(
+        const std::string& input_path,
+        const std::string& output_path,
+        const std::string& password,
+        const StreamingConfig& config = {}
+    );
+    
+    /**
+     * @brief Encrypt one rank's share of a file laid out by init_shards()
+     * @param rank This worker, 0 to ranks - 1
+     * @param ranks Number of workers
+     * @param worker_threads Workers for encryption on this host (1 = serial, 0 = auto)
+     * @return bytes_processed and chunks_processed cover this rank's share
+     *
+     * Rank r encrypts chunks [n * r / ranks, n * (r + 1) / ranks) of the n
+     * in the header and writes their frames in place; nothing else in the
+     * file is touched, so ranks may run in any order or be re-run. Chunk
+     * nonces come from the chunk index as in every stream, so no two ranks
+     * use the same one. Each rank derives the password key itself and
+     * syncs its frames before returning.
+     */
+    static StreamingResult encrypt_shard(
+        const std::string& input_path,
+        const std::string& output_path,
+        const std::string& password,
+        size_t rank,
+        size_t ranks,
+        size_t worker_threads = 1,
         StreamProgressCallback progress_callback = nullptr
     );
     
+    /**
+     * @brief Check that every frame of a sharded file is written, then add the frame index
+     * @return chunks_processed is the number of frames checked; the error
+     *         names the first chunk still missing
+     *
+     * Needs no key. A frame counts as written when its size prefix is that
+     * of its chunk and its tag, written last, is not all zeros. Run once
+     * every rank has succeeded; the file is then an ordinary FVAULT02
+     * file. Until then it does not decrypt.
+     */
+    static StreamingResult stitch_shards(const std::string& output_path);
+    
     /**
      * @brief Check if a file should use streaming (based on size)
      * @param file_path Path to file
@@ -111,6 +570,35 @@ class StreamingCrypto {
         size_t threshold = 100 * 1024 * 1024
     );
     
+    /**
+     * @brief Check if a file is in the chunked format
+     * @param file_path Path to file
+     * @return true if the file starts with the FVAULT02 or FVST magic bytes
+     */
+    static bool is_streaming_file(const std::string& file_path);
+    
+    /**
+     * @brief Parse the header of a chunked file without deriving a key
+     * @return std::nullopt if the file is not a readable streaming file
+     */
+    static std::optional<StreamInfo> read_info(const std::string& file_path);
+    
+    /**
+     * @brief Locate chunk @p chunk of a streaming file without a key
+     *
+     * Reads one footer entry when the frame index is present; otherwise
+     * walks the size prefixes up to the chunk, so only the headers of the
+     * frames before it are read.
+     * @return std::nullopt if the file is unreadable or has fewer chunks
+     */
+    static std::optional<FrameLocation> locate_frame(const std::string& file_path, size_t chunk);
+    
+    /**
+     * @brief Check if an algorithm can be used for streaming
+     * @return true for the AEAD ciphers (16-byte tag per chunk)
+     */
+    static bool supports_algorithm(AlgorithmType algorithm);
+    
     /**
      * @brief Get recommended chunk size based on available memory
      * @return Recommended chunk size in bytes
@@ -118,37 +606,236 @@ class StreamingCrypto {
     static size_t get_recommended_chunk_size();
 
 private:
+    friend class StreamReader;
+    
+    /**
+     * @brief Checkpoint bookkeeping of a file-to-file job
+     */
+    struct ResumeState;
+    
+    /**
+     * @brief Shared encryption pipeline
+     * @param data_key Used instead of deriving a key from password when non-empty
+     * @param input_size Input length, or std::nullopt to read until EOF
+     * @param resume Checkpoint state, or nullptr for streams
+     * @param extents Data ranges of a sparse input of known size; chunks
+     *                outside them are not read and become zero extents
+     */
+    static StreamingResult encrypt_impl(
+        std::istream& input,
+        std::ostream& output,
+        const std::string& password,
+        std::span<const uint8_t> data_key,
+        const StreamingConfig& config,
+        std::optional<size_t> input_size,
+        ResumeState* resume = nullptr,
+        const std::vector<utils::FileExtent>* extents = nullptr
+    );
+    
+    /**
+     * @brief Shared decryption pipeline
+     * @param data_key Used instead of deriving a key from password when non-empty
+     * @param resume Checkpoint state, or nullptr for streams
+     */
+    static StreamingResult decrypt_impl(
+        std::istream& input,
+        std::ostream& output,
+        const std::string& password,
+        std::span<const uint8_t> data_key,
+        StreamProgressCallback progress_callback,
+        size_t worker_threads,
+        ResumeState* resume = nullptr
+    );
+    
     /**
      * @brief Derive chunk-specific nonce from base nonce and chunk index
+     *
+     * The full 64-bit index is used, so no two chunks of a stream share a
+     * nonce however many there are.
      */
-    static std::vector<uint8_t> derive_chunk_nonce(
+    static ShortBytes derive_chunk_nonce(
         const std::vector<uint8_t>& base_nonce,
         size_t chunk_index
     );
     
     /**
-     * @brief Write streaming file header
+     * @brief Derive the nonce of the end-of-stream trailer
+     */
+    static ShortBytes derive_trailer_nonce(
+        const std::vector<uint8_t>& base_nonce
+    );
+    
+    /**
+     * @brief Derive the nonce of the FVAULT02 header tag
+     * @param generation Key generation of the header being tagged
+     */
+    static ShortBytes derive_header_nonce(
+        const std::vector<uint8_t>& base_nonce,
+        uint16_t generation = 0
+    );
+    
+    /**
+     * @brief Derive the nonce that wraps the file key under the password key
+     */
+    static ShortBytes derive_wrap_nonce(
+        const std::vector<uint8_t>& base_nonce
+    );
+    
+    /**
+     * @brief Encrypt the file key under the password key
+     * @return Ciphertext and tag, empty on failure
+     */
+    static std::vector<uint8_t> wrap_data_key(
+        ICryptoAlgorithm& algo,
+        std::span<const uint8_t> password_key,
+        const EncryptionConfig& enc_config,
+        const std::vector<uint8_t>& base_nonce,
+        std::span<const uint8_t> data_key
+    );
+    
+    /**
+     * @brief Decrypt a key wrapped by wrap_data_key()
+     * @return false for a wrong password or a damaged wrapped key
+     */
+    static bool unwrap_data_key(
+        ICryptoAlgorithm& algo,
+        std::span<const uint8_t> password_key,
+        const EncryptionConfig& enc_config,
+        const std::vector<uint8_t>& base_nonce,
+        const std::vector<uint8_t>& wrapped_key,
+        std::vector<uint8_t>& data_key
+    );
+    
+    /**
+     * @brief Write a FVAULT02 header and its tag in one write
+     * @param key File key, which tags the header
+     * @param enc_config Algorithm and KDF settings the key was derived with
+     * @param wrapped_key File key wrapped under the password key, or empty
+     *                    if key is the password key (or a caller's data key)
+     * @param generation Password changes so far
      */
     static bool write_stream_header(
-        std::ofstream& file,
+        std::ostream& file,
         const StreamingConfig& config,
         const std::vector<uint8_t>& salt,
         const std::vector<uint8_t>& base_nonce,
         size_t total_size,
-        size_t chunk_count
+        size_t chunk_count,
+        ICryptoAlgorithm& algo,
+        std::span<const uint8_t> key,
+        const EncryptionConfig& enc_config,
+        std::span<const uint8_t> wrapped_key = {},
+        uint16_t generation = 0
     );
     
     /**
-     * @brief Read streaming file header
+     * @brief Read a FVAULT02 or FVST header
+     * @param header_bytes Receives the bytes covered by the header tag
+     * @param header_tag Receives the header tag (empty for FVST streams)
+     * @param wrapped_key Receives the wrapped file key (empty if none)
      */
     static bool read_stream_header(
-        std::ifstream& file,
+        std::istream& file,
         StreamingConfig& config,
         std::vector<uint8_t>& salt,
         std::vector<uint8_t>& base_nonce,
         size_t& original_size,
-        size_t& chunk_count
+        size_t& chunk_count,
+        uint8_t& version,
+        std::vector<uint8_t>& header_bytes,
+        std::vector<uint8_t>& header_tag,
+        std::vector<uint8_t>& wrapped_key
     );
+    
+    /**
+     * @brief Check a header tag read by read_stream_header()
+     * @return true if the tag is authentic, or for FVST streams which have none
+     */
+    static bool verify_stream_header(
+        ICryptoAlgorithm& algo,
+        std::span<const uint8_t> key,
+        const EncryptionConfig& enc_config,
+        const std::vector<uint8_t>& base_nonce,
+        const std::vector<uint8_t>& header_bytes,
+        const std::vector<uint8_t>& header_tag
+    );
+    
+    /**
+     * @brief Write the frame index footer
+     */
+    static bool write_frame_index(
+        std::ostream& file,
+        const std::vector<uint64_t>& frame_offsets,
+        uint64_t index_offset
+    );
+    
+    /**
+     * @brief Locate chunk frames from the footer, or by scanning if absent
+     * @param data_start Offset of the first frame (end of header)
+     * @param last_chunk Highest chunk index needed when scanning
+     * @param version Format version from read_stream_header (prefix width)
+     */
+    static bool read_frame_index(
+        std::istream& file,
+        uint64_t data_start,
+        size_t chunk_count,
+        size_t last_chunk,
+        uint8_t version,
+        std::vector<uint64_t>& frame_offsets
+    );
+};
+
+/**
+ * @brief Random-access reader for a streaming file of known length
+ *
+ * open() reads the header and frame index and derives the key once; each
+ * read() then authenticates only the chunks its range overlaps. The last
+ * chunk opened is kept, so a run of small reads within one chunk (say,
+ * archive members) decrypts it only once. Not thread-safe.
+ */
+class StreamReader {
+public:
+    StreamReader();
+    ~StreamReader();
+    
+    StreamReader(const StreamReader&) = delete;
+    StreamReader& operator=(const StreamReader&) = delete;
+    
+    /**
+     * @brief Open a streaming file and derive its key
+     * @return Failure for unreadable files and streams of unknown length,
+     *         and for a wrong password on FVAULT02 files (FVST streams
+     *         only detect it at the first read())
+     */
+    StreamingResult open(const std::string& input_path, const std::string& password);
+    
+    /**
+     * @brief Open a streaming file read through a seekable stream
+     *
+     * For sources other than local files (ObjectInput); the reader seeks
+     * to each frame it needs.
+     */
+    StreamingResult open(std::unique_ptr<std::istream> input, const std::string& password);
+    
+    /**
+     * @brief Decrypt the plaintext bytes [offset, offset + length)
+     * @param length Clamped to the end of the plaintext
+     * @param output Receives the range (empty on failure)
+     * @return chunks_processed counts chunks decrypted by this call
+     */
+    StreamingResult read(uint64_t offset, size_t length, std::vector<uint8_t>& output);
+    
+    bool is_open() const { return state_ != nullptr; }
+    uint64_t size() const;              // Plaintext size
+    size_t chunk_size() const;
+    size_t chunks_decrypted() const;    // Chunks authenticated since open()
+
+private:
+    struct State;
+    
+    bool load_chunk(size_t index, std::string& error);
+    
+    std::unique_ptr<State> state_;
 };
 
 } // namespace core
@@ -0,0 +1,83 @@
+#ifndef FILEVAULT_CORE_SYSTEM_RESOURCES_HPP
+#define FILEVAULT_CORE_SYSTEM_RESOURCES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+namespace filevault {
+namespace core {
+
+/**
+ * @brief CPUs and memory this process may actually use
+ *
+ * hardware_concurrency() and the free RAM of the host are what a
+ * container sees by default, not what it is allowed: a pod limited to
+ * 2 CPUs and 1 GB on a 64-core host would start 64 workers and size
+ * 256 MB chunks, and be throttled or OOM-killed. Every automatic
+ * choice of thread count or memory size goes through this probe.
+ *
+ * On Linux the CPU count is the affinity mask, further bounded by the
+ * cgroup CPU quota (v2 cpu.max, v1 cpu.cfs_quota_us / cpu.cfs_period_us,
+ * rounded up), and the memory limit is the lowest memory.max (v1
+ * memory.limit_in_bytes) from the process's cgroup up to the root. On
+ * Windows the limits of the job object the process runs in apply (CPU
+ * rate hard cap, process and job memory limits).
+ */
+struct SystemResources {
+    size_t host_cpus = 1;                   // Logical CPUs of the machine
+    size_t cpus = 1;                        // CPUs this process may use (at least 1)
+    uint64_t physical_memory = 0;           // RAM of the machine (0 = unknown)
+    uint64_t memory_limit = 0;              // Container/job limit (0 = none)
+    std::string limited_by;                 // "cgroup v2", "cgroup v1", "job object" or empty
+    std::filesystem::path memory_usage;     // cgroup file with the memory in use, if limited by one
+
+    /**
+     * @brief Probed once per process
+     */
+    static const SystemResources& detect();
+
+    /**
+     * @brief Memory that can be allocated right now
+     *
+     * The host's available memory, and under a container limit no more
+     * than the limit minus the cgroup's current usage. Read afresh on
+     * every call. 0 if unknown.
+     */
+    static uint64_t available_memory();
+
+    /**
+     * @brief The memory limit, or physical memory without one (0 = unknown)
+     */
+    uint64_t effective_memory() const;
+
+    bool cpu_limited() const { return cpus < host_cpus; }
+
+    /**
+     * @brief Apply the cgroup limits found under a cgroup filesystem root
+     * @param cgroup_root Usually /sys/fs/cgroup
+     * @param proc_cgroup Contents of /proc/self/cgroup
+     * @return true if any limit was found
+     */
+    bool apply_cgroup(const std::filesystem::path& cgroup_root, const std::string& proc_cgroup);
+
+    /**
+     * @brief CPUs allowed by a v2 cpu.max line ("200000 100000" = 2); nullopt for "max"
+     */
+    static std::optional<double> parse_cpu_max(const std::string& text);
+
+    /**
+     * @brief Bytes in a memory.max / memory.limit_in_bytes file; nullopt for no limit
+     *
+     * v2 writes "max"; v1 writes a page-rounded LONG_MAX, so anything
+     * from 2^60 up counts as no limit.
+     */
+    static std::optional<uint64_t> parse_memory_max(const std::string& text);
+};
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_SYSTEM_RESOURCES_HPP
@@ -0,0 +1,125 @@
+#ifndef FILEVAULT_CORE_THREAD_POOL_HPP
+#define FILEVAULT_CORE_THREAD_POOL_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace filevault {
+namespace core {
+
+/**
+ * @brief Fixed-size worker pool for CPU-bound tasks
+ *
+ * Tasks are executed in FIFO order by a fixed set of worker threads.
+ * submit() returns a std::future so callers can collect results in
+ * submission order (e.g. for ordered chunk output in StreamingCrypto).
+ *
+ * The destructor finishes all queued tasks before joining the workers.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Create pool
+     * @param thread_count Number of workers (0 = default_thread_count())
+     */
+    explicit ThreadPool(size_t thread_count = 0);
+    ~ThreadPool();
+
+    // Prevent copying
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Queue a task for execution
+     * @return Future holding the task result (or its exception)
+     */
+    template<typename F>
+    auto submit(F&& task) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using R = std::invoke_result_t<std::decay_t<F>>;
+        auto packaged = std::make_shared<std::packaged_task<R()>>(std::forward<F>(task));
+        auto future = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.emplace([packaged]() { (*packaged)(); });
+        }
+        cv_.notify_one();
+        return future;
+    }
+
+    /**
+     * @brief Number of worker threads
+     */
+    size_t size() const { return workers_.size(); }
+
+    /**
+     * @brief Default worker count (hardware concurrency, at least 1)
+     */
+    static size_t default_thread_count();
+
+    /**
+     * @brief Bind the calling thread to one logical CPU (taken modulo the count)
+     * @return false where affinity is unsupported or refused
+     */
+    static bool pin_current_thread(size_t cpu);
+
+private:
+    void worker_loop();
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+};
+
+/**
+ * @brief Run op(i) for i in [0, count), in contiguous ranges on a thread pool
+ *
+ * One task per worker rather than per item, so a batch of 50k small
+ * operations does not pay for 50k queue round trips. op must only write
+ * to slot i of its output.
+ * @param threads Workers (0 = default_thread_count())
+ */
+template<typename Op>
+void parallel_for(size_t count, size_t threads, Op op) {
+    if (count == 0) {
+        return;
+    }
+    size_t workers = threads == 0 ? ThreadPool::default_thread_count() : threads;
+    workers = std::min(workers, count);
+    if (workers <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            op(i);
+        }
+        return;
+    }
+    
+    ThreadPool pool(workers);
+    std::vector<std::future<void>> tasks;
+    size_t per_worker = (count + workers - 1) / workers;
+    for (size_t begin = 0; begin < count; begin += per_worker) {
+        size_t end = std::min(count, begin + per_worker);
+        tasks.push_back(pool.submit([&op, begin, end]() {
+            for (size_t i = begin; i < end; ++i) {
+                op(i);
+            }
+        }));
+    }
+    for (auto& task : tasks) {
+        task.get();   // Rethrows the first failure
+    }
+}
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_THREAD_POOL_HPP
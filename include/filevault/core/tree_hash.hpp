@@ -0,0 +1,75 @@
+#ifndef FILEVAULT_CORE_TREE_HASH_HPP
+#define FILEVAULT_CORE_TREE_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace filevault {
+namespace core {
+
+/**
+ * @brief Parallel Merkle-tree hash over any Botan hash function
+ *
+ * The input is cut into fixed-size leaves; leaves are hashed
+ * independently on a thread pool and combined pairwise up to a root, so
+ * a single large file is hashed by every core instead of one. Leaf and
+ * node hashes are domain-separated as in RFC 6962 (0x00 / 0x01 prefix);
+ * an odd node at the end of a level is carried up unchanged.
+ *
+ * The root depends on the algorithm and the leaf size, and is not the
+ * plain hash of the data: compare tree digests only with tree digests of
+ * the same parameters. Leaf hashes double as per-range checksums, so a
+ * verifier can tell which leaf of a damaged file changed.
+ */
+class TreeHash {
+public:
+    static constexpr size_t DEFAULT_LEAF_SIZE = 1024 * 1024;
+    
+    /**
+     * @param algorithm Botan hash name (e.g. "SHA-256", "BLAKE2b(512)")
+     * @param leaf_size Bytes per leaf (> 0)
+     * @throws std::invalid_argument for an unknown algorithm or zero leaf size
+     */
+    explicit TreeHash(std::string algorithm, size_t leaf_size = DEFAULT_LEAF_SIZE);
+    
+    /**
+     * @brief Root of the tree over data
+     * @param threads Leaf workers (0 = one per core)
+     */
+    std::vector<uint8_t> hash(std::span<const uint8_t> data, size_t threads = 0) const;
+    
+    /**
+     * @brief Hashes of each leaf of data, in order (one for empty data)
+     */
+    std::vector<std::vector<uint8_t>> leaf_hashes(std::span<const uint8_t> data, size_t threads = 0) const;
+    
+    /**
+     * @brief Hash of one leaf: H(0x00 || leaf)
+     */
+    std::vector<uint8_t> leaf(std::span<const uint8_t> data) const;
+    
+    /**
+     * @brief Hash of an inner node: H(0x01 || left || right)
+     */
+    std::vector<uint8_t> node(std::span<const uint8_t> left, std::span<const uint8_t> right) const;
+    
+    /**
+     * @brief Combine leaf hashes into the root
+     */
+    std::vector<uint8_t> root(std::vector<std::vector<uint8_t>> level) const;
+    
+    const std::string& algorithm() const { return algorithm_; }
+    size_t leaf_size() const { return leaf_size_; }
+
+private:
+    std::string algorithm_;
+    size_t leaf_size_;
+};
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_TREE_HASH_HPP
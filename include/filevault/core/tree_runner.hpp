@@ -0,0 +1,103 @@
+#ifndef FILEVAULT_CORE_TREE_RUNNER_HPP
+#define FILEVAULT_CORE_TREE_RUNNER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace filevault {
+namespace core {
+
+/**
+ * @brief One file of a directory tree job and where its result goes
+ */
+struct TreeFile {
+    std::filesystem::path source;
+    std::filesystem::path target;
+    uint64_t size = 0;              // Source bytes, for grouping and progress
+    uint64_t modified_time = 0;     // Source mtime (Unix seconds), for jobs that record it
+};
+
+/**
+ * @brief How the files of a tree are spread over workers
+ */
+struct TreeRunOptions {
+    size_t workers = 0;                                 // Pool threads (0 = one per core)
+    uint64_t small_file_bytes = 1024 * 1024;            // Smaller files are grouped onto one task
+    uint64_t group_bytes = 16 * 1024 * 1024;            // Bytes of small files per task
+    uint64_t large_file_bytes = 256ull * 1024 * 1024;   // Larger files run alone on every worker (0 = never)
+
+    /**
+     * Called with source bytes just finished, concurrently from the
+     * workers and without a lock (e.g. ProgressAggregator::add). A failed
+     * file counts as finished so the sum always reaches the tree's size.
+     */
+    std::function<void(uint64_t bytes)> on_advance;
+};
+
+/**
+ * @brief Outcome of a tree run
+ */
+struct TreeRunResult {
+    size_t succeeded = 0;
+    uint64_t bytes = 0;                 // Source bytes of the files that succeeded
+    std::vector<std::string> errors;    // "<source>: <message>", sorted
+    double seconds = 0.0;
+};
+
+/**
+ * @brief Order in which a tree's files are processed
+ */
+struct TreePlan {
+    std::vector<std::vector<size_t>> tasks;     // Pool tasks as file indices, largest first
+    std::vector<size_t> large;                  // Run after the pool, one at a time
+};
+
+/**
+ * @brief Runs one job per file of a directory tree on a worker pool
+ *
+ * Small files are grouped so a task carries enough bytes to outweigh
+ * its scheduling cost, and tasks are queued largest first so the pool
+ * drains evenly. Files of at least large_file_bytes are kept out of the
+ * pool and run one after another with every worker, for jobs that
+ * parallelize within a file (the chunked streaming engine).
+ *
+ * The smallest file runs on the calling thread before the pool starts,
+ * so a key it derives is in KeyCache before workers would all miss it.
+ * The parent directory of each target is created before its job runs;
+ * jobs that write nothing (verification) leave the target empty.
+ */
+class TreeRunner {
+public:
+    /**
+     * @brief Reports source bytes done so far within the current file
+     */
+    using Advance = std::function<void(uint64_t bytes)>;
+
+    /**
+     * @brief Processes one file; returns an error message ("" = success)
+     * @param threads Worker threads the job may use (1 inside the pool)
+     */
+    using Job = std::function<std::string(const TreeFile& file, size_t threads, const Advance& advance)>;
+
+    static TreePlan plan(const std::vector<TreeFile>& files, const TreeRunOptions& options);
+
+    /**
+     * @brief File indices in the order run() starts them
+     *
+     * For work prepared ahead of the jobs (e.g. KdfScheduler); pool
+     * tasks overlap, so jobs start roughly, not exactly, in this order.
+     */
+    static std::vector<size_t> schedule(const std::vector<TreeFile>& files, const TreeRunOptions& options);
+
+    static TreeRunResult run(const std::vector<TreeFile>& files, const Job& job,
+                             const TreeRunOptions& options = {});
+};
+
+} // namespace core
+} // namespace filevault
+
+#endif // FILEVAULT_CORE_TREE_RUNNER_HPP
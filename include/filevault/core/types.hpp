@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 #include <optional>
+#include "inline_bytes.hpp"
 
 namespace filevault {
 namespace core {
@@ -98,7 +99,15 @@ enum class AlgorithmType {
     // Hybrid Post-Quantum (Classic + PQC for transition period)
     KYBER_512_HYBRID,   // Kyber-512 + X25519
     KYBER_768_HYBRID,   // Kyber-768 + X25519
-    KYBER_1024_HYBRID   // Kyber-1024 + X25519
+    KYBER_1024_HYBRID,  // Kyber-1024 + X25519
+    
+    // AEAD beyond GCM. Appended: stream and chunk store headers record
+    // the enum value, so existing entries keep their numbers.
+    AEGIS_256,      // AES round function, fastest with AES-NI/VAES
+    AES_256_OCB,    // Single pass, parallel (RFC 7253)
+    AES_256_SIV,    // Nonce-misuse resistant (RFC 5297)
+    
+    ECC_X25519      // X25519 ECDH + AES-GCM, 128-bit security (RFC 7748)
 };
 
 /**
@@ -126,7 +135,11 @@ enum class HashType {
     BLAKE2B_256,
     BLAKE2B_384,
     BLAKE2B_512,
-    BLAKE2S_256
+    BLAKE2S_256,
+    
+    // Checksums (NOT cryptographic - change detection only)
+    XXH3_128,
+    CRC32C
 };
 
 /**
@@ -136,7 +149,9 @@ enum class CompressionType {
     NONE,
     ZLIB,
     BZIP2,
-    LZMA
+    LZMA,
+    ZSTD,
+    LZ4
 };
 
 /**
@@ -183,10 +198,11 @@ struct EncryptionConfig {
     uint32_t kdf_memory_kb = 65536;  // 64MB default
     uint32_t kdf_parallelism = 4;
     
-    // Encryption parameters (generated automatically or provided)
+    // Encryption parameters (generated automatically or provided).
+    // Nonce and tag are stored inline: setting them per message allocates nothing.
     std::vector<uint8_t> salt;
-    std::optional<std::vector<uint8_t>> nonce;
-    std::optional<std::vector<uint8_t>> tag;
+    std::optional<ShortBytes> nonce;
+    std::optional<ShortBytes> tag;
     std::optional<std::vector<uint8_t>> associated_data;
     
     // Compression
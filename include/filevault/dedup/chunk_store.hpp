@@ -0,0 +1,189 @@
+#ifndef FILEVAULT_DEDUP_CHUNK_STORE_HPP
+#define FILEVAULT_DEDUP_CHUNK_STORE_HPP
+
+#include "filevault/core/result.hpp"
+#include "filevault/core/types.hpp"
+#include "filevault/dedup/chunker.hpp"
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace filevault {
+namespace dedup {
+
+/**
+ * @brief Chunk address: HMAC-SHA-256 of the plaintext under the store's ID key
+ *
+ * Keyed, so the store does not reveal which well-known files it holds.
+ */
+using ChunkId = std::array<uint8_t, 32>;
+
+/**
+ * @brief Settings fixed when a store is created
+ */
+struct StoreConfig {
+    core::AlgorithmType algorithm = core::AlgorithmType::AES_256_GCM;
+    core::KDFType kdf = core::KDFType::ARGON2ID;
+    core::SecurityLevel level = core::SecurityLevel::MEDIUM;
+    core::CompressionType compression = core::CompressionType::ZSTD;
+    int compression_level = 3;
+    ChunkerParams chunking;
+};
+
+/**
+ * @brief One chunk of a backed-up file
+ */
+struct ChunkRef {
+    ChunkId id{};
+    uint32_t size = 0;      // Plaintext bytes
+};
+
+/**
+ * @brief Everything needed to rebuild one file from the store
+ */
+struct Manifest {
+    uint64_t original_size = 0;
+    std::vector<ChunkRef> chunks;
+};
+
+/**
+ * @brief What a backup added to the store
+ */
+struct BackupStats {
+    size_t chunks = 0;
+    size_t new_chunks = 0;
+    uint64_t bytes = 0;         // Input size
+    uint64_t new_bytes = 0;     // Plaintext of the chunks that were not stored yet
+    uint64_t stored_bytes = 0;  // What those took on disk
+};
+
+/**
+ * @brief Size of a store on disk
+ */
+struct StoreUsage {
+    size_t chunks = 0;
+    uint64_t bytes = 0;
+};
+
+/**
+ * @brief Encrypted, content-addressed chunk store for deduplicated backups
+ *
+ * Files are cut into content-defined chunks (ContentChunker); each chunk
+ * is stored once as <dir>/chunks/<xx>/<id>, compressed and sealed with the
+ * store's AEAD key under a fresh nonce, with its ID as associated data.
+ * A backup writes only the chunks the store does not have yet, so nightly
+ * backups of mostly unchanged data cost little more than reading it.
+ * Restores check every chunk against its ID.
+ *
+ * The password-derived master key gives three independent subkeys (chunk
+ * IDs, chunk encryption, manifest MACs); <dir>/store.fvcs holds the salt,
+ * the settings and a key check, never key material. Chunks are compressed
+ * and sealed on a thread pool with one cipher session per worker.
+ *
+ * Random 96-bit nonces under one key limit a store to about 2^32 chunks.
+ */
+class ChunkStore {
+public:
+    /**
+     * @param directory Store location (created by create())
+     */
+    explicit ChunkStore(std::filesystem::path directory);
+    ~ChunkStore();
+    
+    ChunkStore(const ChunkStore&) = delete;
+    ChunkStore& operator=(const ChunkStore&) = delete;
+    
+    /**
+     * @brief Initialize a new store and unlock it
+     * @return Error if the directory already holds a store
+     */
+    core::Result<void> create(const std::string& password, const StoreConfig& config);
+    
+    /**
+     * @brief Read an existing store's settings (no password needed)
+     */
+    core::Result<void> open();
+    
+    /**
+     * @brief Open an existing store for backup and restore
+     * @return Error for a missing store or a wrong password
+     */
+    core::Result<void> unlock(const std::string& password);
+    
+    /**
+     * @brief Chunk, deduplicate and store a stream
+     * @param threads Workers sealing chunks (0 = one per core)
+     */
+    core::Result<Manifest> backup(std::istream& input, BackupStats& stats, size_t threads = 0);
+    
+    /**
+     * @brief Rebuild a backed-up stream
+     * @param threads Workers opening chunks (0 = one per core)
+     */
+    core::Result<void> restore(const Manifest& manifest, std::ostream& output, size_t threads = 0);
+    
+    /**
+     * @brief Encode a manifest with a MAC under the store's manifest key
+     */
+    std::vector<uint8_t> serialize_manifest(const Manifest& manifest) const;
+    
+    /**
+     * @brief Decode and authenticate a manifest written by this store
+     */
+    core::Result<Manifest> parse_manifest(std::span<const uint8_t> data) const;
+    
+    /**
+     * @brief A chunk's ID
+     */
+    ChunkId chunk_id(std::span<const uint8_t> chunk) const;
+    
+    bool contains(const ChunkId& id) const;
+    
+    /**
+     * @brief Count stored chunks and their size
+     */
+    StoreUsage usage() const;
+    
+    /**
+     * @brief File a chunk is stored in
+     */
+    std::filesystem::path path_for(const ChunkId& id) const;
+    
+    /**
+     * @brief Whether a directory holds a store
+     */
+    static bool exists(const std::filesystem::path& directory);
+    
+    /**
+     * @brief Format an ID as 64 hex digits
+     */
+    static std::string format_id(const ChunkId& id);
+    
+    const StoreConfig& config() const { return config_; }
+    const std::filesystem::path& directory() const { return directory_; }
+    bool unlocked() const { return !id_key_.empty(); }
+
+private:
+    /**
+     * @brief Derive the subkeys from password and salt
+     * @return Key check value stored with the config (empty if the algorithm is unavailable)
+     */
+    std::vector<uint8_t> derive_keys(const std::string& password, const std::vector<uint8_t>& salt);
+    
+    std::filesystem::path directory_;
+    StoreConfig config_;
+    std::vector<uint8_t> salt_;
+    std::vector<uint8_t> key_check_;
+    std::vector<uint8_t> id_key_;
+    std::vector<uint8_t> chunk_key_;
+    std::vector<uint8_t> manifest_key_;
+};
+
+} // namespace dedup
+} // namespace filevault
+
+#endif // FILEVAULT_DEDUP_CHUNK_STORE_HPP
@@ -0,0 +1,68 @@
+#ifndef FILEVAULT_DEDUP_CHUNKER_HPP
+#define FILEVAULT_DEDUP_CHUNKER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace filevault {
+namespace dedup {
+
+/**
+ * @brief Chunk size bounds for content-defined chunking
+ *
+ * avg_size is rounded down to a power of two; boundaries fall near it on
+ * typical data and never outside [min_size, max_size].
+ */
+struct ChunkerParams {
+    uint32_t min_size = 256 * 1024;
+    uint32_t avg_size = 1024 * 1024;
+    uint32_t max_size = 4 * 1024 * 1024;
+    
+    /**
+     * @brief Check 64 B <= min < avg < max <= 64 MB
+     */
+    bool valid() const;
+};
+
+/**
+ * @brief FastCDC content-defined chunker
+ *
+ * Boundaries are placed where a gear rolling hash of the last 64 bytes
+ * matches a mask, so they depend on the data around them rather than on
+ * the offset: inserting or deleting bytes only changes the chunks next to
+ * the edit, and the rest of a file deduplicates against its previous
+ * version. Normalized chunking (a stricter mask before avg_size, a looser
+ * one after) keeps sizes close to the average, and the first min_size
+ * bytes of a chunk are skipped without hashing.
+ */
+class ContentChunker {
+public:
+    explicit ContentChunker(const ChunkerParams& params = {});
+    
+    /**
+     * @brief Length of the chunk starting at data[0]
+     * @param data At least max_size bytes, or everything left of the input
+     * @return Cut point in [1, data.size()] (0 only for empty data)
+     */
+    size_t next_boundary(std::span<const uint8_t> data) const;
+    
+    /**
+     * @brief Split a whole buffer
+     * @return Chunk lengths, in order, summing to data.size()
+     */
+    std::vector<size_t> split(std::span<const uint8_t> data) const;
+    
+    const ChunkerParams& params() const { return params_; }
+
+private:
+    ChunkerParams params_;
+    uint64_t mask_small_;   // Before avg_size: one bit more than the average needs
+    uint64_t mask_large_;   // After avg_size: one bit fewer
+};
+
+} // namespace dedup
+} // namespace filevault
+
+#endif // FILEVAULT_DEDUP_CHUNKER_HPP
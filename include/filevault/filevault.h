@@ -0,0 +1,222 @@
+/**
+ * @file filevault.h
+ * @brief Stable C API of libfilevault, for embedding through FFI
+ *
+ * Everything is reached through opaque handles and plain C types, so the
+ * ABI does not change with the C++ internals: algorithms, KDFs and
+ * options are named by strings (the CLI's names), never by enum values.
+ * New functions may be added; existing ones keep their signatures while
+ * FV_API_VERSION stays the same.
+ *
+ * Errors: functions return fv_status; the message of the last failure on
+ * the calling thread is available from fv_last_error(). No C++
+ * exception crosses the API.
+ *
+ * Threads: an fv_engine may be shared between threads. Sessions, options
+ * and streams are not thread-safe: use one per thread.
+ */
+
+#ifndef FILEVAULT_FILEVAULT_H
+#define FILEVAULT_FILEVAULT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(FILEVAULT_C_STATIC)
+#  define FV_API
+#elif defined(_WIN32)
+#  if defined(FILEVAULT_C_BUILD)
+#    define FV_API __declspec(dllexport)
+#  else
+#    define FV_API __declspec(dllimport)
+#  endif
+#else
+#  define FV_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FV_API_VERSION 1
+
+typedef enum fv_status {
+    FV_OK = 0,
+    FV_ERR_INVALID_ARGUMENT = 1,    /* Null handle, unknown name, bad size */
+    FV_ERR_UNSUPPORTED = 2,         /* Algorithm cannot be used this way */
+    FV_ERR_AUTHENTICATION = 3,      /* Wrong key or tampered data */
+    FV_ERR_BUFFER_TOO_SMALL = 4,    /* *out_len holds the size needed */
+    FV_ERR_CANCELLED = 5,           /* A progress callback returned 0 */
+    FV_ERR_FAILED = 6,              /* Operation failed, see fv_last_error() */
+    FV_ERR_INTERNAL = 7             /* Unexpected error (e.g. out of memory) */
+} fv_status;
+
+typedef struct fv_engine fv_engine;
+typedef struct fv_session fv_session;
+typedef struct fv_options fv_options;
+typedef struct fv_stream fv_stream;
+
+/**
+ * @brief Progress of a file or stream operation
+ * @param bytes_total 0 when the length is not known (streams)
+ * @return Non-zero to continue, 0 to cancel (the call returns FV_ERR_CANCELLED)
+ *
+ * Called on the thread that runs the operation.
+ */
+typedef int (*fv_progress_fn)(void* user_data, uint64_t bytes_done, uint64_t bytes_total);
+
+/**
+ * @brief Stream source: fill buffer with up to size bytes
+ * @return Bytes read, 0 at end of input, negative on error
+ */
+typedef int64_t (*fv_read_fn)(void* context, uint8_t* buffer, size_t size);
+
+/**
+ * @brief Stream sink: take all size bytes
+ * @return 0 on success, non-zero on error
+ */
+typedef int (*fv_write_fn)(void* context, const uint8_t* data, size_t size);
+
+/* ---- Library ---------------------------------------------------------- */
+
+/** @brief FV_API_VERSION the library was built with */
+FV_API uint32_t fv_api_version(void);
+
+/** @brief Library version, e.g. "1.1.0" */
+FV_API const char* fv_version(void);
+
+/** @brief Message of the last failed call on this thread ("" if none) */
+FV_API const char* fv_last_error(void);
+
+/** @brief Short name of a status code */
+FV_API const char* fv_status_string(fv_status status);
+
+/** @brief Fill buffer with random bytes from the system generator */
+FV_API fv_status fv_random(uint8_t* buffer, size_t size);
+
+/**
+ * @brief Sizes of an algorithm, by name (e.g. "aes-256-gcm")
+ *
+ * Any pointer may be NULL. nonce and tag sizes are 0 for modes without one.
+ */
+FV_API fv_status fv_algorithm_sizes(const char* algorithm, size_t* key_size, size_t* nonce_size, size_t* tag_size);
+
+/* ---- Engine ----------------------------------------------------------- */
+
+/**
+ * @brief Create an engine: the algorithm registry and key derivation
+ *
+ * Create one and keep it; algorithm objects are built on first use and
+ * reused by every session created from the engine.
+ */
+FV_API fv_status fv_engine_create(fv_engine** engine);
+
+/** @brief Destroy an engine; its sessions must be destroyed first */
+FV_API void fv_engine_destroy(fv_engine* engine);
+
+/**
+ * @brief Derive a key from a password
+ * @param options Algorithm (key size), kdf and level; NULL for defaults
+ * @param key_size Must equal the algorithm's key size
+ */
+FV_API fv_status fv_derive_key(fv_engine* engine, const char* password, const uint8_t* salt, size_t salt_size,
+                               const fv_options* options, uint8_t* key, size_t key_size);
+
+/* ---- Sessions --------------------------------------------------------- */
+
+/**
+ * @brief Bind an AEAD algorithm to a key for many messages
+ *
+ * The key schedule is computed once. Only authenticated algorithms are
+ * accepted (FV_ERR_UNSUPPORTED otherwise).
+ */
+FV_API fv_status fv_session_create(fv_engine* engine, const char* algorithm, const uint8_t* key, size_t key_size,
+                                   fv_session** session);
+
+FV_API void fv_session_destroy(fv_session* session);
+
+/** @brief Bytes seal() adds to a message: nonce + tag */
+FV_API size_t fv_session_overhead(const fv_session* session);
+
+/**
+ * @brief Encrypt one message under a fresh random nonce
+ * @param associated_data Authenticated but not encrypted; may be NULL
+ * @param output Receives [nonce][ciphertext][tag], size + overhead bytes
+ * @param out_len Bytes written, or needed on FV_ERR_BUFFER_TOO_SMALL
+ */
+FV_API fv_status fv_session_seal(fv_session* session, const uint8_t* plaintext, size_t size,
+                                 const uint8_t* associated_data, size_t associated_size,
+                                 uint8_t* output, size_t output_capacity, size_t* out_len);
+
+/**
+ * @brief Decrypt a message produced by fv_session_seal()
+ * @return FV_ERR_AUTHENTICATION if the key, data or associated data do not match
+ */
+FV_API fv_status fv_session_open(fv_session* session, const uint8_t* sealed, size_t size,
+                                 const uint8_t* associated_data, size_t associated_size,
+                                 uint8_t* output, size_t output_capacity, size_t* out_len);
+
+/* ---- Options ---------------------------------------------------------- */
+
+/** @brief Options with the CLI's defaults (aes-256-gcm, argon2id, medium) */
+FV_API fv_status fv_options_create(fv_options** options);
+
+FV_API void fv_options_destroy(fv_options* options);
+
+/**
+ * @brief Set an option by name
+ *
+ * Keys: "algorithm", "kdf", "level" (weak..paranoid), "compression"
+ * (none, zlib, bzip2, lzma, zstd, lz4), "compression-level",
+ * "chunk-size" (bytes), "threads" (0 = one per core).
+ */
+FV_API fv_status fv_options_set(fv_options* options, const char* key, const char* value);
+
+/* ---- Files and streams ------------------------------------------------ */
+
+/**
+ * @brief Encrypt a file to the streaming format (as `filevault encrypt`)
+ * @param options NULL for defaults
+ * @param progress May be NULL
+ */
+FV_API fv_status fv_encrypt_file(const char* input_path, const char* output_path, const char* password,
+                                 const fv_options* options, fv_progress_fn progress, void* user_data);
+
+/**
+ * @brief Decrypt a streaming-format file
+ *
+ * Settings come from the file's header; only "threads" is read from options.
+ */
+FV_API fv_status fv_decrypt_file(const char* input_path, const char* output_path, const char* password,
+                                 const fv_options* options, fv_progress_fn progress, void* user_data);
+
+/**
+ * @brief A source and a sink of bytes, e.g. over a pipe or a socket
+ */
+FV_API fv_status fv_stream_create(fv_read_fn read, fv_write_fn write, void* context, fv_stream** stream);
+
+FV_API void fv_stream_destroy(fv_stream* stream);
+
+/**
+ * @brief Encrypt everything read from the stream to its sink
+ *
+ * The length need not be known; the output ends with an authenticated
+ * trailer, as `filevault encrypt -` writes.
+ */
+FV_API fv_status fv_encrypt_stream(fv_stream* stream, const char* password, const fv_options* options,
+                                   fv_progress_fn progress, void* user_data);
+
+/**
+ * @brief Decrypt a streaming-format input to the sink
+ *
+ * Chunks reach the sink as they are authenticated; on failure, discard
+ * what was written.
+ */
+FV_API fv_status fv_decrypt_stream(fv_stream* stream, const char* password, const fv_options* options,
+                                   fv_progress_fn progress, void* user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FILEVAULT_FILEVAULT_H */
@@ -0,0 +1,103 @@
+#ifndef FILEVAULT_STEGANOGRAPHY_IMAGE_ROWS_HPP
+#define FILEVAULT_STEGANOGRAPHY_IMAGE_ROWS_HPP
+
+#include "filevault/steganography/png_stream.hpp"
+#include "filevault/utils/file_io.hpp"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace filevault::steganography {
+
+/**
+ * @brief Rows of an uncompressed BMP, read straight from a mapping
+ *
+ * Handles the layouts stbi_write_bmp produces: 24-bit BI_RGB and 32-bit
+ * BI_BITFIELDS with BGRA masks. Rows come out top-down in stb's RGB(A)
+ * order, and only the rows asked for are paged in.
+ */
+class BmpRowReader {
+public:
+    /**
+     * @brief Map and check the file; std::nullopt if stb has to decode it
+     */
+    static std::optional<BmpRowReader> open(const std::string& path);
+
+    uint32_t width() const { return width_; }
+    uint32_t height() const { return height_; }
+    int channels() const { return channels_; }
+    uint64_t channel_count() const { return static_cast<uint64_t>(width_) * channels_ * height_; }
+
+    /**
+     * @brief The next row (valid until the next call), or an empty span after the last
+     */
+    std::span<const uint8_t> next_row();
+
+    /**
+     * @brief Whether a row read so far had non-zero alpha
+     *
+     * stb replaces an alpha channel that is zero throughout the image with
+     * 255; until a non-zero alpha turns up, rows read here may differ.
+     */
+    bool alpha_seen() const { return channels_ != 4 || alpha_seen_; }
+
+private:
+    BmpRowReader() = default;
+
+    utils::MappedFile file_;
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+    int channels_ = 0;
+    bool bottom_up_ = true;
+    uint64_t pixel_offset_ = 0;
+    uint64_t stride_ = 0;           // Row size padded to 4 bytes
+    uint32_t rows_read_ = 0;
+    bool alpha_seen_ = false;
+    std::vector<uint8_t> row_;
+};
+
+/**
+ * @brief Top-down rows of any image LSBSteganography reads
+ *
+ * Streams PNGs PngRowReader accepts, reads BMPs BmpRowReader accepts in
+ * place, and decodes anything else whole with stb. Rows have stb's
+ * channel layout either way, so pixel statistics match what extract()
+ * sees.
+ */
+class ImageRows {
+public:
+    /**
+     * @throws std::runtime_error if the image cannot be read
+     */
+    explicit ImageRows(const std::string& path);
+    ~ImageRows();
+
+    ImageRows(const ImageRows&) = delete;
+    ImageRows& operator=(const ImageRows&) = delete;
+
+    uint32_t width() const { return width_; }
+    uint32_t height() const { return height_; }
+    int channels() const { return channels_; }
+
+    /**
+     * @brief The next row (valid until the next call), or an empty span after the last
+     * @throws std::runtime_error on truncated or corrupt PNG data
+     */
+    std::span<const uint8_t> next_row();
+
+private:
+    std::unique_ptr<PngRowReader> png_;
+    std::optional<BmpRowReader> bmp_;
+    uint8_t* decoded_ = nullptr;    // stbi_load result
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+    int channels_ = 0;
+    uint32_t rows_read_ = 0;
+};
+
+} // namespace filevault::steganography
+
+#endif // FILEVAULT_STEGANOGRAPHY_IMAGE_ROWS_HPP
@@ -5,6 +5,8 @@
 #include <string>
 #include <cstdint>
 #include <span>
+#include <functional>
+#include "filevault/steganography/png_stream.hpp"
 
 namespace filevault::steganography {
 
@@ -16,6 +18,10 @@ namespace filevault::steganography {
  * 
  * Capacity: For RGB images, ~3 bits per pixel (if using 1 bit per channel)
  *           For an 800x600 image: (800 * 600 * 3) / 8 = 180,000 bytes max
+ *           Each byte takes ceil(8 / bits) whole channels: at 3 bits,
+ *           3 channels per byte
+ *
+ * Bits are spread over the channels by the SIMD kernels in lsb_kernels.hpp.
  */
 class LSBSteganography {
 public:
@@ -26,18 +32,25 @@ class LSBSteganography {
      * @param secret_data Data to hide
      * @param output_path Path for output stego image
      * @param bits_per_channel Number of LSBs to use per color channel (1-4, default 1)
+     * @param png_options zlib level and row filter for PNG output
      * @return true if successful, false otherwise
      */
     static bool embed(
         const std::string& cover_image_path,
         std::span<const uint8_t> secret_data,
         const std::string& output_path,
-        int bits_per_channel = 1
+        int bits_per_channel = 1,
+        const PngWriteOptions& png_options = {}
     );
     
     /**
      * @brief Extract hidden data from stego image
      * 
+     * Reads only as many rows as the embedded length needs: streamable
+     * PNGs are decoded row by row (extract_streaming()), uncompressed
+     * 24/32-bit BMPs are mapped and read at the row offsets. Other
+     * images are decoded whole with stb.
+     * 
      * @param stego_image_path Path to stego image
      * @param bits_per_channel Number of LSBs used per color channel (must match embed)
      * @return Extracted secret data, or empty vector on failure
@@ -47,6 +60,38 @@ class LSBSteganography {
         int bits_per_channel = 1
     );
     
+    /**
+     * @brief Embed row by row, without decoding the whole cover
+     * 
+     * Writes the same pixels as embed() while holding only a few rows, so
+     * capacity is not limited by RAM. The cover must be an 8-bit,
+     * non-interlaced gray/RGB(A) PNG (see PngRowReader::probe); the output
+     * is always PNG and may replace the cover. embed() takes this path by
+     * itself for covers of STREAMING_THRESHOLD channel bytes or more.
+     * 
+     * @return true if successful, false otherwise
+     */
+    static bool embed_streaming(
+        const std::string& cover_image_path,
+        std::span<const uint8_t> secret_data,
+        const std::string& output_path,
+        int bits_per_channel = 1,
+        const PngWriteOptions& png_options = {}
+    );
+    
+    /**
+     * @brief Extract row by row, stopping after the last payload row
+     * 
+     * @return Extracted secret data, or empty vector on failure
+     */
+    static std::vector<uint8_t> extract_streaming(
+        const std::string& stego_image_path,
+        int bits_per_channel = 1
+    );
+    
+    // Decoded size (width * height * channels) from which PNGs are streamed
+    static constexpr uint64_t STREAMING_THRESHOLD = 64ull * 1024 * 1024;
+    
     /**
      * @brief Calculate maximum capacity for given image
      * 
@@ -63,20 +108,15 @@ class LSBSteganography {
     // Embed length header (4 bytes) at the beginning
     static constexpr size_t LENGTH_HEADER_SIZE = 4;
     
-    // Helper to embed one byte into image data
-    static void embed_byte(
-        uint8_t* pixel_data,
-        size_t pixel_count,
-        size_t& bit_index,
-        uint8_t byte,
-        int bits_per_channel
-    );
-    
-    // Helper to extract one byte from image data
-    static uint8_t extract_byte(
-        const uint8_t* pixel_data,
-        size_t pixel_count,
-        size_t& bit_index,
+    /**
+     * @brief Extract from rows fetched top to bottom on demand
+     * 
+     * next_row returns an empty span after the last row; it is not called
+     * again once the payload is complete.
+     */
+    static std::vector<uint8_t> extract_rows(
+        const std::function<std::span<const uint8_t>()>& next_row,
+        uint64_t channel_count,
         int bits_per_channel
     );
 };
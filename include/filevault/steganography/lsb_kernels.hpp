@@ -0,0 +1,93 @@
+#ifndef FILEVAULT_STEGANOGRAPHY_LSB_KERNELS_HPP
+#define FILEVAULT_STEGANOGRAPHY_LSB_KERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace filevault::steganography::kernels {
+
+/**
+ * @brief Bit-plane kernels that spread bytes over channel LSBs and back
+ *
+ * A byte takes ceil(8 / bits) consecutive channels, low bits first; the
+ * last channel of a 3-bit byte carries only bits 6-7 and its third LSB is
+ * cleared. SIMD paths handle 16 payload bytes per step (16 * 8 channels
+ * at 1 bit) and produce the same channels and bytes as the scalar loop,
+ * which also handles the tail and running out of channels part-way
+ * through a byte.
+ */
+
+/**
+ * @brief Instruction sets with a kernel; see is_supported()
+ */
+enum class Isa {
+    Scalar,
+    SSE2,       // 1, 2 and 4 bits
+    SSSE3,      // Byte shuffles; adds 3 bits
+    AVX2,       // 32 channels per step for 1, 2 and 4 bits
+    NEON
+};
+
+/**
+ * @brief Best kernel for this CPU (BOTAN_CLEAR_CPUID applies, see CpuFeatures)
+ */
+Isa best_isa();
+
+/**
+ * @brief True if @p isa is built in and the CPU has it
+ */
+bool is_supported(Isa isa);
+
+/**
+ * @brief Lower-case name, for benchmarks and logs
+ */
+const char* isa_name(Isa isa);
+
+/**
+ * @brief Write @p bytes into the low @p bits of @p channels from @p index on
+ * @param bits Bits per channel, 1-4
+ * @return Index of the next free channel; stops at the end of @p channels
+ * @throws std::invalid_argument for bad @p bits or an unsupported @p isa
+ */
+size_t embed(std::span<uint8_t> channels, size_t index, std::span<const uint8_t> bytes,
+             int bits, Isa isa = best_isa());
+
+/**
+ * @brief Read @p bytes back from the low @p bits of @p channels
+ *
+ * Bytes past the end of @p channels come out partial, then zero.
+ * @return Index of the channel after the last one read
+ * @throws std::invalid_argument for bad @p bits or an unsupported @p isa
+ */
+size_t extract(std::span<const uint8_t> channels, size_t index, std::span<uint8_t> bytes,
+               int bits, Isa isa = best_isa());
+
+/**
+ * @brief RS steganalysis counts (Fridrich, Goljan and Du)
+ *
+ * Groups are 4 consecutive values of one channel, flipped under the mask
+ * [0, 1, 1, 0]. A group is regular when the flip makes it less smooth
+ * (larger sum of neighbour differences) and singular when it makes it
+ * smoother. Counts are kept for the flip F1 (x ^ 1) and the shifted flip
+ * F-1 (odd x + 1, even x - 1), each on the group as read and with all its
+ * LSBs inverted first: index inverted * 2 + shifted.
+ */
+struct RsCounts {
+    uint64_t groups = 0;
+    uint64_t regular[4] = {};
+    uint64_t singular[4] = {};
+};
+
+/**
+ * @brief Add the groups of one channel plane to @p counts
+ *
+ * Values past the last whole group are skipped. SSE2 and AVX2 classify 2
+ * and 4 groups per step; other ISAs use the scalar loop.
+ * @throws std::invalid_argument for an unsupported @p isa
+ */
+void rs_count(std::span<const uint8_t> plane, RsCounts& counts, Isa isa = best_isa());
+
+} // namespace filevault::steganography::kernels
+
+#endif // FILEVAULT_STEGANOGRAPHY_LSB_KERNELS_HPP
@@ -0,0 +1,69 @@
+#ifndef FILEVAULT_STEGANOGRAPHY_STEGANALYSIS_HPP
+#define FILEVAULT_STEGANOGRAPHY_STEGANALYSIS_HPP
+
+#include "filevault/steganography/lsb_kernels.hpp"
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace filevault::steganography {
+
+/**
+ * @brief Steganalysis result for one image
+ */
+struct ScanReport {
+    std::string path;
+    std::string error;              // Set if the image could not be read
+    uint32_t width = 0;
+    uint32_t height = 0;
+    int channels = 0;
+    double chi_square = 0;          // Chi-square p over the first 1/CHECKPOINTS of the rows
+    double payload_extent = 0;      // Leading fraction of the rows where that p stays >= 0.5
+    double rs_rate = 0;             // Share of LSB capacity RS analysis estimates is used
+    double score = 0;               // max(chi_square, rs_rate), 0-1
+};
+
+/**
+ * @brief Detect LSB payloads in images
+ *
+ * Two classic attacks over the LSB plane of the colour channels (alpha
+ * is skipped):
+ *
+ * - Chi-square (Westfeld and Pfitzmann): embedding evens out the counts
+ *   of each value pair 2i, 2i+1. The p-value is taken over growing
+ *   leading parts of the image, which is where LSBSteganography puts
+ *   the payload, so short messages show up too.
+ * - RS (Fridrich, Goljan and Du): compares how flipping and shifted
+ *   flipping of LSBs change local smoothness, and estimates the embedding
+ *   rate of randomly spread payloads as well; see kernels::rs_count().
+ *
+ * Images are read row by row through ImageRows, so memory stays at a few
+ * rows for streamable PNGs and BMPs.
+ */
+class Steganalysis {
+public:
+    static constexpr double DEFAULT_THRESHOLD = 0.5;
+    static constexpr uint32_t CHECKPOINTS = 32;
+
+    /**
+     * @brief Analyse one image; failures are reported in ScanReport::error
+     */
+    static ScanReport scan(const std::string& path, kernels::Isa isa = kernels::best_isa());
+
+    /**
+     * @brief Probability that value pairs were evened out by embedding
+     *
+     * Pairs expecting fewer than 5 values are left out; 0 if fewer than two
+     * pairs remain.
+     */
+    static double chi_square_p(const std::array<uint64_t, 256>& histogram);
+
+    /**
+     * @brief Embedding rate (0-1) estimated from RS counts
+     */
+    static double rs_rate(const kernels::RsCounts& counts);
+};
+
+} // namespace filevault::steganography
+
+#endif // FILEVAULT_STEGANOGRAPHY_STEGANALYSIS_HPP
@@ -0,0 +1,251 @@
+#ifndef FILEVAULT_STORE_BLOB_STORE_HPP
+#define FILEVAULT_STORE_BLOB_STORE_HPP
+
+#include "filevault/core/crypto_algorithm.hpp"
+#include "filevault/core/random.hpp"
+#include "filevault/core/result.hpp"
+#include "filevault/core/secure_arena.hpp"
+#include "filevault/core/types.hpp"
+#include "filevault/utils/file_io.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace filevault {
+namespace core {
+class CryptoEngine;
+} // namespace core
+
+namespace store {
+
+/**
+ * @brief Settings fixed when a store is created
+ */
+struct BlobStoreConfig {
+    core::KDFType kdf = core::KDFType::ARGON2ID;
+    core::SecurityLevel level = core::SecurityLevel::MEDIUM;
+    uint64_t segment_bytes = 64 * 1024 * 1024;   // A segment is sealed once it grows past this
+};
+
+/**
+ * @brief Size of a store's contents and of the files holding them
+ */
+struct BlobStoreStats {
+    size_t keys = 0;
+    size_t segments = 0;
+    uint64_t live_bytes = 0;     // Records the index points at
+    uint64_t disk_bytes = 0;     // Segment files, including overwritten and deleted records
+};
+
+/**
+ * @brief Encrypted key-value store kept as append-only segment files
+ *
+ * Layout: a directory with a header file (settings, KDF salt and the
+ * data key sealed under the password, as in a Volume key slot) and
+ * numbered segment files. Every put or delete appends one record,
+ * sealed with AES-256-GCM under the data key:
+ *
+ *   u32 body size | u8 type | nonce[12] | body | tag[16]
+ *
+ * where the body is the key and value (just the key for a delete). The
+ * segment id, the record's offset and its first five bytes are the
+ * associated data, so a record cannot be moved or retyped. Nonces are a
+ * random per-session prefix and a counter.
+ *
+ * The index (key -> record) lives in memory. When a segment reaches
+ * segment_bytes, or the store is closed, it is sealed: an encrypted
+ * footer listing its latest record per key is appended, and unlock()
+ * rebuilds the index from the footers alone. A segment without one (the
+ * last store session crashed) is scanned record by record instead; when
+ * unlocked for writing, a torn or unauthenticated tail is cut off and the
+ * segment is sealed. New records always go to a new segment.
+ *
+ * Records are buffered in memory and written in large appends; flush()
+ * writes and syncs them. Overwritten and deleted records stay on disk
+ * until compact() rewrites the live ones into fresh segments. All calls
+ * are serialized by an internal mutex; a store must not be opened by two
+ * processes at once.
+ */
+class BlobStore {
+public:
+    static constexpr size_t MAX_KEY_SIZE = 1024;
+    static constexpr size_t MAX_VALUE_SIZE = 256 * 1024 * 1024;
+    static constexpr size_t WRITE_BUFFER_BYTES = 1024 * 1024;
+
+    /**
+     * @param directory Store directory (created by create())
+     */
+    explicit BlobStore(std::filesystem::path directory);
+    ~BlobStore();
+
+    BlobStore(const BlobStore&) = delete;
+    BlobStore& operator=(const BlobStore&) = delete;
+
+    /**
+     * @brief Create an empty store and unlock it
+     * @return Error if the directory exists and is not empty
+     */
+    core::Result<void> create(const std::string& password, const BlobStoreConfig& config);
+
+    /**
+     * @brief Read an existing store's settings (no password needed)
+     */
+    core::Result<void> open();
+
+    /**
+     * @brief Open the data key and rebuild the index
+     * @return Error for a missing store, a wrong password or a corrupt sealed segment
+     */
+    core::Result<void> unlock(const std::string& password, bool read_only = false);
+
+    /**
+     * @brief Re-seal the data key under a new password
+     *
+     * Segments are untouched; only the header file is replaced.
+     */
+    core::Result<void> change_password(const std::string& new_password);
+
+    /**
+     * @brief Store value under key, replacing any previous value
+     */
+    core::Result<void> put(std::string_view key, std::span<const uint8_t> value);
+
+    /**
+     * @brief Look up a key
+     * @param value Receives the value (its capacity is reused)
+     * @return false if the key is not in the store
+     */
+    core::Result<bool> get(std::string_view key, std::vector<uint8_t>& value);
+
+    /**
+     * @brief Delete a key
+     * @return false if the key was not in the store
+     */
+    core::Result<bool> remove(std::string_view key);
+
+    bool contains(std::string_view key) const;
+
+    /**
+     * @brief Every key, sorted
+     */
+    std::vector<std::string> keys() const;
+
+    /**
+     * @brief Write buffered records and sync the current segment
+     */
+    core::Result<void> flush();
+
+    /**
+     * @brief Rewrite the live records into new segments and delete the old ones
+     *
+     * Old segments are deleted oldest first once the new ones are synced,
+     * so a crash at any point reopens to the same contents.
+     */
+    core::Result<void> compact();
+
+    /**
+     * @brief Seal the current segment and lock the store
+     */
+    core::Result<void> close();
+
+    /**
+     * @brief Whether a directory holds a store header
+     */
+    static bool is_store(const std::filesystem::path& directory);
+
+    const BlobStoreConfig& config() const { return config_; }
+    const std::filesystem::path& directory() const { return directory_; }
+    bool unlocked() const { return session_ != nullptr; }
+    bool read_only() const { return read_only_; }
+    BlobStoreStats stats() const;
+
+private:
+    struct Location {
+        uint64_t segment = 0;
+        uint64_t offset = 0;
+        uint32_t size = 0;       // Whole record
+    };
+
+    struct FooterEntry {
+        uint8_t type = 0;
+        uint64_t offset = 0;
+        uint32_t size = 0;
+    };
+
+    struct Segment {
+        utils::RandomAccessFile file;
+        uint64_t size = 0;       // Bytes on disk
+    };
+
+    struct KeyHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+    };
+    using Index = std::unordered_map<std::string, Location, KeyHash, std::equal_to<>>;
+    using EntryMap = std::unordered_map<std::string, FooterEntry, KeyHash, std::equal_to<>>;
+
+    std::filesystem::path header_path() const;
+    std::filesystem::path segment_path(uint64_t id) const;
+    std::vector<uint8_t> header_prefix(const std::vector<uint8_t>& salt) const;
+    core::Result<std::vector<uint8_t>> seal_header(const std::string& password,
+                                                   const std::vector<uint8_t>& salt) const;
+    std::vector<uint8_t> derive_slot_key(const std::string& password, const std::vector<uint8_t>& salt) const;
+    core::Result<void> start_session();
+
+    core::Result<void> check_writable() const;
+    core::Result<void> load_segment(uint64_t id);
+    /**
+     * @return false if the segment was never sealed; error if its footer does not authenticate
+     */
+    core::Result<bool> read_footer(uint64_t id, Segment& segment, EntryMap& entries);
+    uint64_t scan_segment(uint64_t id, Segment& segment, EntryMap& entries);
+    void apply(const std::string& key, const FooterEntry& entry, uint64_t segment);
+
+    /**
+     * @brief Seal body_ as a record of the active segment (started if there is none)
+     */
+    core::Result<Location> append(uint8_t type);
+    core::Result<void> start_segment();
+    core::Result<void> write_buffer();
+    core::Result<void> seal_active();
+    core::Result<void> read_record(const Location& location, std::vector<uint8_t>& record);
+    bool open_record(uint64_t segment, uint64_t offset, std::vector<uint8_t>& record, uint8_t& type,
+                     std::vector<uint8_t>& body);
+    void set_associated_data(uint64_t segment, uint64_t offset, const uint8_t* head);
+
+    std::filesystem::path directory_;
+    BlobStoreConfig config_;
+    std::vector<uint8_t> salt_;
+    std::vector<uint8_t> key_slot_;             // [nonce][sealed data key][tag]
+    core::SecureBytes data_key_;
+    std::unique_ptr<core::CryptoEngine> engine_;   // Owns the algorithm behind session_
+    std::unique_ptr<core::ICipherSession> session_;
+    std::unique_ptr<core::CounterNonce> nonces_;
+    core::EncryptionConfig record_config_;      // Reused for every record
+    bool read_only_ = false;
+
+    mutable std::mutex mutex_;
+    Index index_;
+    std::map<uint64_t, Segment> segments_;
+    uint64_t next_segment_ = 1;
+    uint64_t active_ = 0;                       // Segment taking appends (0 = none yet)
+    uint64_t active_size_ = 0;                  // Its size including buffered records
+    EntryMap active_entries_;                   // Its footer to be
+    std::vector<uint8_t> buffer_;               // Records not yet written to it
+    uint64_t live_bytes_ = 0;
+    std::vector<uint8_t> body_;                 // Scratch for one record body
+    std::vector<uint8_t> record_;               // Scratch for one sealed record
+};
+
+} // namespace store
+} // namespace filevault
+
+#endif // FILEVAULT_STORE_BLOB_STORE_HPP
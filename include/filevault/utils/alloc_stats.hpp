@@ -0,0 +1,61 @@
+#ifndef FILEVAULT_UTILS_ALLOC_STATS_HPP
+#define FILEVAULT_UTILS_ALLOC_STATS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace filevault {
+namespace utils {
+
+/**
+ * @brief Heap allocation totals
+ */
+struct AllocCounters {
+    uint64_t allocations = 0;       // malloc, calloc, realloc and aligned calls (new included)
+    uint64_t bytes = 0;             // Bytes requested by them
+};
+
+/**
+ * @brief Heap allocation counters, fed by the counting allocator
+ *
+ * Builds configured with ENABLE_ALLOC_STATS link src/utils/alloc_hooks.cpp
+ * into the executables. It replaces malloc and friends (glibc only) with
+ * wrappers that forward to glibc and report here, so operator new,
+ * Botan's secure_vector and third-party libraries are all counted. Other
+ * builds never call on_alloc()/on_free(), enabled() is false and the
+ * counters stay at zero.
+ *
+ * Totals are process-wide; thread() counts the calling thread only, which
+ * is how trace spans attribute allocations to a pipeline stage. Live
+ * bytes are malloc_usable_size() bytes, so they include allocator
+ * rounding but balance exactly between allocation and free.
+ */
+class AllocStats {
+public:
+    static bool enabled();
+
+    static AllocCounters totals();
+    static AllocCounters thread();
+
+    static uint64_t live_bytes();
+
+    /**
+     * @brief Most live bytes since the last reset_peak()
+     */
+    static uint64_t peak_bytes();
+
+    /**
+     * @brief Restart peak_bytes() from the current live bytes
+     */
+    static void reset_peak();
+
+    // Called by the counting allocator; must not allocate
+    static void set_enabled() noexcept;
+    static void on_alloc(size_t requested, size_t usable) noexcept;
+    static void on_free(size_t usable) noexcept;
+};
+
+} // namespace utils
+} // namespace filevault
+
+#endif // FILEVAULT_UTILS_ALLOC_STATS_HPP
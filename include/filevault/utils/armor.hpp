@@ -0,0 +1,83 @@
+#ifndef FILEVAULT_UTILS_ARMOR_HPP
+#define FILEVAULT_UTILS_ARMOR_HPP
+
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace filevault {
+namespace utils {
+
+/**
+ * @brief ASCII armor: base64 in 64-column lines between marker lines
+ *
+ *   -----BEGIN FILEVAULT MESSAGE-----
+ *   RlZBVUxUMDIBAAM...
+ *   -----END FILEVAULT MESSAGE-----
+ *
+ * Wraps the chunked (v2) stream, which is written front to back, so armor
+ * is produced and removed on the fly with the SIMD base64 codec.
+ */
+constexpr std::string_view ARMOR_BEGIN = "-----BEGIN FILEVAULT MESSAGE-----";
+constexpr std::string_view ARMOR_END = "-----END FILEVAULT MESSAGE-----";
+
+/**
+ * @brief Whether a file starts with the armor BEGIN line
+ */
+bool is_armored_file(const std::string& path);
+
+/**
+ * @brief Output stream that armors everything written to it into @p sink
+ *
+ * The BEGIN line is written up front; finish() encodes the last partial
+ * line and writes the END line. Destroying the stream without finish()
+ * leaves the armor unterminated, which readers reject. The stream cannot
+ * seek; tellp() reports bytes accepted.
+ */
+class ArmorOutput : public std::ostream {
+public:
+    explicit ArmorOutput(std::ostream& sink);
+    ~ArmorOutput() override;
+
+    ArmorOutput(const ArmorOutput&) = delete;
+    ArmorOutput& operator=(const ArmorOutput&) = delete;
+
+    /**
+     * @brief Write the tail and the END line and flush the sink
+     * @return false if the sink failed
+     */
+    bool finish();
+
+private:
+    class Buffer;
+    std::unique_ptr<Buffer> buffer_;
+};
+
+/**
+ * @brief Input stream that reads the bytes armored in @p source
+ *
+ * Line breaks (LF or CRLF) are ignored. A missing BEGIN or END line or a
+ * bad character ends the stream early once it is reached; error() is then
+ * non-empty and says why, so check it after reading to the end.
+ */
+class ArmorInput : public std::istream {
+public:
+    explicit ArmorInput(std::istream& source);
+    ~ArmorInput() override;
+
+    ArmorInput(const ArmorInput&) = delete;
+    ArmorInput& operator=(const ArmorInput&) = delete;
+
+    const std::string& error() const;
+
+private:
+    class Buffer;
+    std::unique_ptr<Buffer> buffer_;
+};
+
+} // namespace utils
+} // namespace filevault
+
+#endif // FILEVAULT_UTILS_ARMOR_HPP
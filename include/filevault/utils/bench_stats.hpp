@@ -0,0 +1,381 @@
+#ifndef FILEVAULT_UTILS_BENCH_STATS_HPP
+#define FILEVAULT_UTILS_BENCH_STATS_HPP
+
+#include "filevault/utils/alloc_stats.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace filevault {
+namespace utils {
+
+/**
+ * @brief Per-thread CPU cycle counter for benchmarks
+ *
+ * Uses perf_event core cycles on Linux when the kernel allows it, else
+ * the x86 time-stamp counter (reference cycles at the nominal clock),
+ * else nothing. source() says which, since the two differ under
+ * frequency scaling.
+ */
+class CycleCounter {
+public:
+    CycleCounter();
+    ~CycleCounter();
+
+    CycleCounter(const CycleCounter&) = delete;
+    CycleCounter& operator=(const CycleCounter&) = delete;
+
+    bool available() const { return source_ != Source::NONE; }
+
+    /**
+     * @brief "perf_event", "rdtsc" or "none"
+     */
+    const char* source() const;
+
+    uint64_t read() const;
+
+private:
+    enum class Source { NONE, PERF_EVENT, RDTSC };
+
+    Source source_ = Source::NONE;
+    int perf_fd_ = -1;
+};
+
+/**
+ * @brief Hardware event totals of one measured region
+ *
+ * Negative values mark events the CPU or kernel did not provide.
+ */
+struct CounterValues {
+    double cycles = -1;
+    double instructions = -1;
+    double l1d_misses = -1;         // L1 data cache read misses
+    double llc_misses = -1;         // Last-level cache misses
+    double branch_misses = -1;
+    double dtlb_misses = -1;        // Data TLB read misses (page walks)
+
+    double ipc() const { return cycles > 0 && instructions >= 0 ? instructions / cycles : 0.0; }
+};
+
+/**
+ * @brief perf_event counter group read around measured regions (Linux)
+ *
+ * One group of user-space counters for the calling thread, enabled and
+ * disabled together so every event covers exactly the same code. Events
+ * the PMU lacks (common in VMs) are left out rather than failing the
+ * group; available() is false when not even cycles could be opened,
+ * e.g. under perf_event_paranoid 3 or a container seccomp profile.
+ */
+class PerfCounters {
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const { return !fds_.empty(); }
+
+    void start();
+    CounterValues stop();
+
+private:
+    std::vector<int> fds_;          // Leader first
+    std::vector<int> slots_;        // CounterValues field of each fd
+};
+
+/**
+ * @brief Energy of one measured operation
+ */
+struct EnergyValues {
+    double joules = 0;              // Mean per call
+    double watts = 0;               // All joules over all timed seconds
+
+    double joules_per_gb(size_t bytes) const { return bytes > 0 ? joules * 1e9 / bytes : 0.0; }
+};
+
+/**
+ * @brief Package energy read from RAPL around measured regions (Linux)
+ *
+ * Uses the powercap package domains (intel-rapl:N, which the kernel
+ * also provides for AMD Zen), summed over sockets. The figure is the
+ * whole package: other cores, uncore and idle draw are included. RAPL
+ * updates about once a millisecond, so energy per call is an average
+ * that needs many samples, or calls well above a millisecond, to mean
+ * anything. energy_uj is readable by root only on kernels since 5.10;
+ * available() is false when no package domain could be opened.
+ */
+class EnergyMeter {
+public:
+    EnergyMeter();
+    ~EnergyMeter();
+
+    EnergyMeter(const EnergyMeter&) = delete;
+    EnergyMeter& operator=(const EnergyMeter&) = delete;
+
+    bool available() const { return !domains_.empty(); }
+
+    void start();
+
+    /**
+     * @brief Joules used since start(), over counter wraparound
+     */
+    double stop();
+
+private:
+    struct Domain {
+        int fd = -1;
+        uint64_t max_range_uj = 0;  // Counter wraps back to 0 here
+        uint64_t start_uj = 0;
+    };
+
+    std::vector<Domain> domains_;
+};
+
+/**
+ * @brief Heap use of one measured operation (ENABLE_ALLOC_STATS builds)
+ */
+struct AllocValues {
+    double allocations = 0;         // Mean per call
+    double bytes = 0;               // Mean bytes requested per call
+    uint64_t peak_bytes = 0;        // Most bytes live at once above the start, over all samples
+};
+
+/**
+ * @brief When a measurement has enough samples
+ *
+ * After warmup runs, samples are taken until the 95% confidence interval
+ * of the mean is within target_ci of the mean, with at least
+ * min_samples and at most max_samples or max_seconds of timed work.
+ */
+struct SamplingPolicy {
+    size_t warmup = 3;
+    size_t min_samples = 5;
+    size_t max_samples = 200;
+    double target_ci = 0.02;        // Relative half-width, 0.02 = +/-2%
+    double max_seconds = 1.0;
+    bool hardware_counters = false; // Read PerfCounters around every sample
+    bool energy = false;            // Read EnergyMeter around every sample
+};
+
+/**
+ * @brief Summary of one measured operation
+ *
+ * Order statistics cover every sample. Mean, stddev and the confidence
+ * interval leave out high outliers (above Q3 + 1.5 IQR), which are
+ * almost always preemption or page faults rather than the code measured.
+ */
+struct SampleStats {
+    size_t samples = 0;
+    size_t outliers = 0;
+    double min_ms = 0;
+    double median_ms = 0;
+    double mean_ms = 0;
+    double p95_ms = 0;
+    double p99_ms = 0;
+    double max_ms = 0;
+    double stddev_ms = 0;
+    double ci95_ms = 0;             // Half-width of the 95% interval of the mean
+    double cycles_per_byte = 0;     // Median; 0 without a cycle counter or size
+    bool converged = false;         // target_ci reached before a limit
+    std::vector<double> times_ms;   // Raw samples in measurement order
+    std::optional<CounterValues> counters;  // Mean per sample, with hardware_counters
+    std::optional<AllocValues> allocations; // With the counting allocator linked in
+    std::optional<EnergyValues> energy;     // With SamplingPolicy::energy and RAPL access
+
+    /**
+     * @brief Throughput at the median time
+     */
+    double mbps(size_t bytes) const;
+
+    /**
+     * @brief ci95_ms relative to the mean
+     */
+    double relative_ci() const { return mean_ms > 0 ? ci95_ms / mean_ms : 0.0; }
+
+    /**
+     * @brief Summarize raw samples (times in ms, cycles per sample or empty)
+     */
+    static SampleStats summarize(std::vector<double> times_ms, std::vector<double> cycles, size_t bytes);
+};
+
+/**
+ * @brief Straight-line fit y = intercept + slope * x
+ *
+ * Used for cost against message size: the intercept is the fixed
+ * per-call overhead and 1/slope the asymptotic throughput. Points are
+ * weighted by 1/y^2, so each contributes its relative error and the
+ * small sizes that determine the intercept are not swamped by the
+ * largest ones.
+ */
+struct LinearFit {
+    double intercept = 0;
+    double slope = 0;
+    double r_squared = 0;           // Of the weighted fit
+
+    static LinearFit fit(const std::vector<double>& x, const std::vector<double>& y);
+};
+
+/**
+ * @brief Two-sided Mann-Whitney U test of two sets of samples
+ *
+ * Rank-based, so it makes no normality assumption and one slow outlier
+ * cannot decide it; this suits timings, which are skewed to the right.
+ * The p-value uses the normal approximation with tie and continuity
+ * corrections, which is rough below about eight samples per side.
+ */
+struct MannWhitney {
+    double u = 0;                   // U statistic of the first sample
+    double z = 0;                   // Positive when the first sample ranks higher
+    double p_value = 1.0;
+
+    static MannWhitney test(const std::vector<double>& a, const std::vector<double>& b);
+};
+
+/**
+ * @brief Adaptive sampling with warmup, timed with steady_clock and cycles
+ *
+ * measure() runs prepare() untimed before each sample, so buffer copies
+ * and resets are not part of the result.
+ */
+class Sampler {
+public:
+    explicit Sampler(SamplingPolicy policy = {});
+
+    const SamplingPolicy& policy() const { return policy_; }
+    const CycleCounter& cycles() const { return cycles_; }
+    bool counters_available() const { return counters_ && counters_->available(); }
+    bool energy_available() const { return energy_ && energy_->available(); }
+
+    /**
+     * @param bytes Bytes processed per call, for cycles/byte (0 = none)
+     */
+    template<typename Prepare, typename Op>
+    SampleStats measure(size_t bytes, Prepare&& prepare, Op&& op) {
+        for (size_t i = 0; i < policy_.warmup; ++i) {
+            prepare();
+            op();
+        }
+
+        std::vector<double> times;
+        std::vector<double> cycle_counts;
+        std::vector<CounterValues> counter_samples;
+        bool counting = counters_available();
+        bool metering = energy_available();
+        double joules = 0.0;
+        bool counting_allocs = AllocStats::enabled();
+        AllocValues allocs;
+        // Welford running mean/variance for the stopping rule
+        double mean = 0.0, m2 = 0.0, total_seconds = 0.0;
+        bool converged = false;
+
+        while (times.size() < policy_.max_samples) {
+            prepare();
+            if (metering) {
+                energy_->start();
+            }
+            if (counting) {
+                counters_->start();
+            }
+            AllocCounters allocs_start;
+            uint64_t live_start = 0;
+            if (counting_allocs) {
+                AllocStats::reset_peak();
+                live_start = AllocStats::live_bytes();
+                allocs_start = AllocStats::totals();
+            }
+            uint64_t cycles_start = cycles_.available() ? cycles_.read() : 0;
+            auto start = std::chrono::steady_clock::now();
+            op();
+            auto end = std::chrono::steady_clock::now();
+            uint64_t cycles_end = cycles_.available() ? cycles_.read() : 0;
+            if (counting_allocs) {
+                auto allocs_end = AllocStats::totals();
+                allocs.allocations += static_cast<double>(allocs_end.allocations - allocs_start.allocations);
+                allocs.bytes += static_cast<double>(allocs_end.bytes - allocs_start.bytes);
+                allocs.peak_bytes = std::max(allocs.peak_bytes, AllocStats::peak_bytes() - live_start);
+            }
+            if (counting) {
+                counter_samples.push_back(counters_->stop());
+            }
+            if (metering) {
+                joules += energy_->stop();
+            }
+
+            double ms = std::chrono::duration<double, std::milli>(end - start).count();
+            times.push_back(ms);
+            if (cycles_.available()) {
+                cycle_counts.push_back(static_cast<double>(cycles_end - cycles_start));
+            }
+            total_seconds += ms / 1000.0;
+
+            double delta = ms - mean;
+            mean += delta / static_cast<double>(times.size());
+            m2 += delta * (ms - mean);
+
+            if (times.size() >= policy_.min_samples && times.size() >= 2) {
+                if (within_target(mean, m2, times.size())) {
+                    converged = true;
+                    break;
+                }
+                if (total_seconds >= policy_.max_seconds) {
+                    break;
+                }
+            }
+        }
+
+        auto stats = SampleStats::summarize(std::move(times), std::move(cycle_counts), bytes);
+        stats.converged = converged;
+        if (counting) {
+            stats.counters = mean_counters(counter_samples);
+        }
+        if (metering && stats.samples > 0) {
+            EnergyValues energy;
+            energy.joules = joules / static_cast<double>(stats.samples);
+            energy.watts = total_seconds > 0 ? joules / total_seconds : 0.0;
+            stats.energy = energy;
+        }
+        if (counting_allocs && stats.samples > 0) {
+            allocs.allocations /= static_cast<double>(stats.samples);
+            allocs.bytes /= static_cast<double>(stats.samples);
+            stats.allocations = allocs;
+        }
+        return stats;
+    }
+
+    template<typename Op>
+    SampleStats measure(size_t bytes, Op&& op) {
+        return measure(bytes, [] {}, std::forward<Op>(op));
+    }
+
+private:
+    bool within_target(double mean, double m2, size_t count) const;
+    static CounterValues mean_counters(const std::vector<CounterValues>& samples);
+
+    SamplingPolicy policy_;
+    CycleCounter cycles_;
+    std::unique_ptr<PerfCounters> counters_;
+    std::unique_ptr<EnergyMeter> energy_;
+};
+
+/**
+ * @brief Peak resident set size of this process in bytes (0 if unknown)
+ */
+size_t peak_rss_bytes();
+
+/**
+ * @brief Restart peak_rss_bytes() from the current size
+ * @return false where the peak cannot be reset (it then covers the whole process)
+ */
+bool reset_peak_rss();
+
+} // namespace utils
+} // namespace filevault
+
+#endif // FILEVAULT_UTILS_BENCH_STATS_HPP
@@ -0,0 +1,99 @@
+#ifndef FILEVAULT_UTILS_CHECKSUM_HPP
+#define FILEVAULT_UTILS_CHECKSUM_HPP
+
+#include <botan/hash.h>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+
+struct XXH3_state_s;
+
+namespace filevault {
+namespace utils {
+
+/**
+ * @brief Non-cryptographic checksums behind Botan's HashFunction interface
+ *
+ * CRC32C (Castagnoli) runs on the SSE4.2 or ARMv8 CRC32 instruction, three
+ * streams interleaved, and falls back to slicing-by-8 tables. XXH3-128
+ * comes from xxHash. Both catch accidental changes (bit rot, truncation,
+ * a copy gone wrong) at memory speed, but anyone who can write the data
+ * can also make it match: use them to skip work, never to authenticate.
+ */
+
+/**
+ * @brief CRC32C of @p data, continuing from @p crc (0 to start)
+ */
+uint32_t crc32c(std::span<const uint8_t> data, uint32_t crc = 0);
+
+/**
+ * @brief Table-driven CRC32C, whatever the CPU has
+ */
+uint32_t crc32c_portable(std::span<const uint8_t> data, uint32_t crc = 0);
+
+/**
+ * @brief True if crc32c() uses a CRC32 instruction (BOTAN_CLEAR_CPUID applies)
+ */
+bool crc32c_hardware();
+
+/**
+ * @brief CRC32C as a 4-byte big-endian digest ("CRC32C")
+ */
+class Crc32c final : public Botan::HashFunction {
+public:
+    std::string name() const override { return "CRC32C"; }
+    size_t output_length() const override { return 4; }
+    std::unique_ptr<Botan::HashFunction> new_object() const override;
+    std::unique_ptr<Botan::HashFunction> copy_state() const override;
+    void clear() override { crc_ = 0; }
+
+private:
+    void add_data(std::span<const uint8_t> input) override;
+    void final_result(std::span<uint8_t> output) override;
+
+    uint32_t crc_ = 0;
+};
+
+/**
+ * @brief XXH3 128-bit in xxHash's canonical (big-endian) form ("XXH3-128")
+ */
+class Xxh3_128 final : public Botan::HashFunction {
+public:
+    Xxh3_128();
+    ~Xxh3_128() override;
+
+    std::string name() const override { return "XXH3-128"; }
+    size_t output_length() const override { return 16; }
+    size_t hash_block_size() const override { return 64; }
+    std::unique_ptr<Botan::HashFunction> new_object() const override;
+    std::unique_ptr<Botan::HashFunction> copy_state() const override;
+    void clear() override;
+
+private:
+    void add_data(std::span<const uint8_t> input) override;
+    void final_result(std::span<uint8_t> output) override;
+
+    XXH3_state_s* state_;
+};
+
+/**
+ * @brief True for the names of the checksums above
+ */
+bool is_checksum(const std::string& name);
+
+/**
+ * @brief A checksum by name, otherwise Botan::HashFunction::create(name)
+ * @return nullptr if neither knows the name
+ */
+std::unique_ptr<Botan::HashFunction> create_hash(const std::string& name);
+
+/**
+ * @brief create_hash(), throwing Botan::Lookup_Error for unknown names
+ */
+std::unique_ptr<Botan::HashFunction> create_hash_or_throw(const std::string& name);
+
+} // namespace utils
+} // namespace filevault
+
+#endif // FILEVAULT_UTILS_CHECKSUM_HPP
@@ -0,0 +1,86 @@
+#ifndef FILEVAULT_UTILS_CODEC_KERNELS_HPP
+#define FILEVAULT_UTILS_CODEC_KERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace filevault::utils::codec {
+
+/**
+ * @brief Hex and base64 (RFC 4648, padded) kernels writing into caller buffers
+ *
+ * SIMD paths convert 16 bytes (hex) or 12 bytes (base64) per SSSE3 step,
+ * twice that with AVX2, and 48 bytes per NEON step; the scalar loop
+ * handles tails and produces the same text. Decoders reject whitespace
+ * and any character outside the alphabet, and accept both hex cases.
+ */
+
+/**
+ * @brief Instruction sets with a kernel; see is_supported()
+ */
+enum class Isa {
+    Scalar,
+    SSSE3,
+    AVX2,
+    NEON
+};
+
+/**
+ * @brief Best kernel for this CPU (BOTAN_CLEAR_CPUID applies, see CpuFeatures)
+ */
+Isa best_isa();
+
+/**
+ * @brief True if @p isa is built in and the CPU has it
+ */
+bool is_supported(Isa isa);
+
+/**
+ * @brief Lower-case name, for benchmarks and logs
+ */
+const char* isa_name(Isa isa);
+
+constexpr size_t hex_encoded_size(size_t bytes) { return 2 * bytes; }
+constexpr size_t base64_encoded_size(size_t bytes) { return (bytes + 2) / 3 * 4; }
+
+/**
+ * @brief Upper bound on the bytes base64_decode() writes for @p chars
+ */
+constexpr size_t base64_decoded_capacity(size_t chars) { return chars / 4 * 3; }
+
+/**
+ * @brief Write 2 * bytes.size() hex digits to @p out
+ * @throws std::invalid_argument if @p out is too small or @p isa unsupported
+ */
+void hex_encode(std::span<const uint8_t> bytes, std::span<char> out,
+                bool uppercase = false, Isa isa = best_isa());
+
+/**
+ * @brief Decode hex.size() / 2 bytes into @p out
+ * @return false for an odd length or a non-hex character (out is then unspecified)
+ * @throws std::invalid_argument if @p out is too small or @p isa unsupported
+ */
+bool hex_decode(std::string_view hex, std::span<uint8_t> out, Isa isa = best_isa());
+
+/**
+ * @brief Write base64_encoded_size(bytes.size()) characters to @p out
+ * @return Characters written
+ * @throws std::invalid_argument if @p out is too small or @p isa unsupported
+ */
+size_t base64_encode(std::span<const uint8_t> bytes, std::span<char> out, Isa isa = best_isa());
+
+/**
+ * @brief Decode padded base64 into @p out
+ * @return Bytes written, or nullopt if the length is not a multiple of 4,
+ *         a character is outside the alphabet or padding is misplaced
+ * @throws std::invalid_argument if @p out is smaller than
+ *         base64_decoded_capacity(text.size()) or @p isa unsupported
+ */
+std::optional<size_t> base64_decode(std::string_view text, std::span<uint8_t> out, Isa isa = best_isa());
+
+} // namespace filevault::utils::codec
+
+#endif // FILEVAULT_UTILS_CODEC_KERNELS_HPP
@@ -2,18 +2,64 @@
 #define FILEVAULT_UTILS_CONFIG_HPP
 
 #include "filevault/core/types.hpp"
+#include "filevault/core/kdf_calibration.hpp"
 #include <nlohmann/json.hpp>
+#include <map>
 #include <string>
 #include <optional>
+#include <vector>
 #include <filesystem>
 
 namespace filevault {
 namespace utils {
 
+/**
+ * @brief Named set of performance settings
+ *
+ * Unset knobs fall through to the plain config value (or the built-in
+ * default for knobs that only profiles set).
+ */
+struct PerformanceProfile {
+    std::optional<size_t> threads;                  // Worker threads (0 = one per core)
+    std::optional<size_t> streaming_chunk_mb;
+    std::optional<size_t> streaming_threshold_mb;
+    std::optional<size_t> streaming_io_buffers;     // Chunks read ahead while encrypting
+    std::optional<std::string> io_backend;
+    std::optional<bool> direct_io;                  // Keep bulk I/O out of the page cache
+    std::optional<size_t> buffer_pool_mb;           // Memory kept for buffer reuse
+    std::optional<bool> huge_pages;                 // Large buffers on transparent huge pages
+    std::optional<size_t> max_memory_mb;            // Memory limit for the whole run (0 = none)
+    std::optional<uint32_t> kdf_max_memory_mb;      // Budget for KDF calibration
+    std::optional<double> compression_target_mbps;  // Throughput floor for "--compression auto"
+    std::optional<std::string> crypto_offload;      // Keystream device: off, auto, opencl
+    
+    /**
+     * @brief Set one knob from text ("threads", "streaming.chunk_mb", ...)
+     * @return false for unknown knobs and invalid values
+     */
+    bool set(const std::string& knob, const std::string& value);
+    
+    /**
+     * @brief Knobs set in other replace the ones here
+     */
+    void overlay(const PerformanceProfile& other);
+    
+    nlohmann::json to_json() const;
+    static PerformanceProfile from_json(const nlohmann::json& j);
+    
+    /**
+     * @brief Profiles shipped with FileVault: throughput, low-memory, laptop
+     */
+    static const std::map<std::string, PerformanceProfile>& builtin();
+};
+
 /**
  * @brief Configuration manager for FileVault
  * 
- * Manages user preferences stored in ~/.filevault/config.json
+ * Manages user preferences stored in ~/.filevault/config.json. The
+ * active performance profile ("profile", or FILEVAULT_PROFILE) is
+ * resolved when the config is loaded, so the getters below already
+ * return its values.
  */
 class Config {
 public:
@@ -22,6 +68,14 @@ class Config {
      */
     static Config load();
     
+    /**
+     * @brief The configuration as loaded once for this process
+     *
+     * For commands that only read settings; saves made later in the
+     * process are not seen.
+     */
+    static const Config& current();
+    
     /**
      * @brief Save configuration to file
      */
@@ -32,6 +86,21 @@ class Config {
      */
     static std::filesystem::path get_config_path();
     
+    /**
+     * @brief Get the compression dictionary store (~/.filevault/dictionaries)
+     */
+    static std::filesystem::path get_dictionary_dir();
+    
+    /**
+     * @brief Get the hash result cache file (~/.filevault/hash_cache.bin)
+     */
+    static std::filesystem::path get_hash_cache_path();
+    
+    /**
+     * @brief Get the breached-password filter (~/.filevault/breached.bloom)
+     */
+    static std::filesystem::path get_breach_filter_path();
+    
     /**
      * @brief Get default config
      */
@@ -50,6 +119,36 @@ class Config {
     int get_compression_level() const { return compression_level_; }
     bool get_show_progress() const { return show_progress_; }
     bool get_verbose() const { return verbose_; }
+    size_t get_streaming_threshold_mb() const { return active_.streaming_threshold_mb.value_or(streaming_threshold_mb_); }
+    size_t get_streaming_chunk_mb() const { return active_.streaming_chunk_mb.value_or(streaming_chunk_mb_); }
+    std::string get_cpu_disabled_features() const { return cpu_disabled_features_; }
+    uint32_t get_kdf_max_memory_mb() const { return active_.kdf_max_memory_mb.value_or(kdf_max_memory_mb_); }
+    std::string get_io_backend() const { return active_.io_backend.value_or(io_backend_); }
+    
+    // Set by performance profiles only
+    size_t get_threads() const { return active_.threads.value_or(0); }
+    bool get_direct_io() const { return active_.direct_io.value_or(false); }
+    size_t get_buffer_pool_mb() const { return active_.buffer_pool_mb.value_or(1024); }
+    bool get_huge_pages() const { return active_.huge_pages.value_or(false); }
+    size_t get_max_memory_mb() const { return active_.max_memory_mb.value_or(0); }
+    size_t get_streaming_io_buffers() const { return active_.streaming_io_buffers.value_or(2); }
+    double get_compression_target_mbps() const { return active_.compression_target_mbps.value_or(200.0); }
+    std::string get_crypto_offload() const { return active_.crypto_offload.value_or("off"); }
+    
+    /**
+     * @brief Name of the active performance profile (empty = none)
+     */
+    const std::string& get_profile() const { return active_name_; }
+    
+    /**
+     * @brief A built-in or user profile; user knobs override built-in ones
+     */
+    std::optional<PerformanceProfile> find_profile(const std::string& name) const;
+    
+    /**
+     * @brief Every profile name, built-in and user-defined
+     */
+    std::vector<std::string> profile_names() const;
     
     // Setters
     void set_default_mode(const std::string& mode) { default_mode_ = mode; }
@@ -59,9 +158,23 @@ class Config {
     void set_compression_level(int level) { compression_level_ = level; }
     void set_show_progress(bool show) { show_progress_ = show; }
     void set_verbose(bool verbose) { verbose_ = verbose; }
+    void set_streaming_threshold_mb(size_t mb) { streaming_threshold_mb_ = mb; }
+    void set_streaming_chunk_mb(size_t mb) { streaming_chunk_mb_ = mb; }
+    void set_cpu_disabled_features(const std::string& features) { cpu_disabled_features_ = features; }
+    void set_kdf_max_memory_mb(uint32_t mb) { kdf_max_memory_mb_ = mb; }
+    void set_io_backend(const std::string& backend) { io_backend_ = backend; }
+    
+    /**
+     * @brief Cached KDF calibration, keyed by KdfCalibrator::cache_key()
+     */
+    std::optional<core::KdfProfile> get_kdf_calibration(const std::string& key) const;
+    void set_kdf_calibration(const std::string& key, const core::KdfProfile& profile);
     
     /**
      * @brief Get value by key path (e.g., "default.mode")
+     *
+     * "profile" selects the active profile ("none" clears it);
+     * "profiles.<name>.<knob>" edits or creates a user profile.
      */
     std::optional<std::string> get(const std::string& key) const;
     
@@ -83,7 +196,7 @@ class Config {
 private:
     // Default settings
     std::string default_mode_ = "standard";
-    std::string default_algorithm_ = "aes-256-gcm";
+    std::string default_algorithm_ = "auto";  // "auto" = pick from CPU features
     std::string default_kdf_ = "argon2id";
     std::string default_compression_ = "none";
     int compression_level_ = 6;
@@ -91,6 +204,33 @@ class Config {
     // UI preferences
     bool show_progress_ = true;
     bool verbose_ = false;
+    
+    // Streaming: files above the threshold are encrypted chunk by chunk
+    // (0 = never stream); chunk size bounds the memory per buffer
+    size_t streaming_threshold_mb_ = 100;
+    size_t streaming_chunk_mb_ = 4;
+    
+    // Comma-separated Botan CPU features to disable (e.g. "aesni,avx2"),
+    // exported as BOTAN_CLEAR_CPUID for A/B performance runs
+    std::string cpu_disabled_features_;
+    
+    // File read backend: auto (io_uring, IOCP or dispatch I/O where available),
+    // uring, iocp, dispatch or portable
+    std::string io_backend_ = "auto";
+    
+    // KDF calibration: memory budget and results from previous runs on
+    // this machine, so --kdf-target-ms only benchmarks once
+    uint32_t kdf_max_memory_mb_ = 256;
+    std::map<std::string, core::KdfProfile> kdf_calibrations_;
+    
+    // Performance profiles: the saved choice, user definitions, and the
+    // profile in effect (FILEVAULT_PROFILE overrides the saved choice)
+    std::string profile_;
+    std::map<std::string, PerformanceProfile> profiles_;
+    std::string active_name_;
+    PerformanceProfile active_;
+    
+    void resolve_profile();
 };
 
 } // namespace utils
@@ -1,6 +1,7 @@
 #ifndef FILEVAULT_UTILS_CONSOLE_HPP
 #define FILEVAULT_UTILS_CONSOLE_HPP
 
+#include <cstdio>
 #include <string>
 #include <fmt/core.h>
 #include <fmt/color.h>
@@ -21,6 +22,11 @@ class Console {
     
     static void separator(char ch = '=', size_t width = 80);
     static void header(const std::string& title);
+    
+    /**
+     * @brief Redirect all console output (e.g. to stderr in pipe mode)
+     */
+    static void set_stream(std::FILE* stream);
 };
 
 } // namespace utils
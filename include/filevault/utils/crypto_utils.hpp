@@ -5,6 +5,7 @@
 #include <vector>
 #include <cstdint>
 #include <span>
+#include <string_view>
 
 namespace filevault {
 namespace utils {
@@ -15,15 +16,27 @@ namespace utils {
 class CryptoUtils {
 public:
     /**
-     * @brief Encode bytes to hexadecimal string
+     * @brief Encode bytes to hexadecimal string (SIMD, see codec_kernels.hpp)
      */
-    static std::string hex_encode(std::span<const uint8_t> data);
+    static std::string hex_encode(std::span<const uint8_t> data, bool uppercase = true);
     
     /**
-     * @brief Decode hexadecimal string to bytes
+     * @brief Decode hexadecimal string to bytes; whitespace is skipped
+     * @throws std::invalid_argument on an odd digit count or a non-hex character
      */
     static std::vector<uint8_t> hex_decode(const std::string& hex);
     
+    /**
+     * @brief Encode bytes to padded base64 (no line breaks)
+     */
+    static std::string base64_encode(std::span<const uint8_t> data);
+    
+    /**
+     * @brief Decode padded base64; whitespace is skipped
+     * @throws std::invalid_argument on malformed input
+     */
+    static std::vector<uint8_t> base64_decode(std::string_view text);
+    
     /**
      * @brief Format bytes as human-readable size
      */
@@ -0,0 +1,128 @@
+#ifndef FILEVAULT_UTILS_DIR_WATCHER_HPP
+#define FILEVAULT_UTILS_DIR_WATCHER_HPP
+
+#include "filevault/core/result.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace filevault {
+namespace utils {
+
+/**
+ * @brief Coalesces bursts of change notifications per path
+ *
+ * A path is ready once it has been quiet for the quiet period, or once
+ * the maximum delay has passed since the first notification of its
+ * burst, so a file that is rewritten continuously (a log) is still
+ * picked up. Time is passed in rather than read, which keeps the class
+ * deterministic. Not thread-safe.
+ */
+class ChangeDebouncer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    ChangeDebouncer(Clock::duration quiet_period, Clock::duration max_delay);
+
+    void touch(const std::filesystem::path& path, Clock::time_point now);
+
+    /**
+     * @brief Remove and return the paths that are ready, in path order
+     */
+    std::vector<std::filesystem::path> take_ready(Clock::time_point now);
+
+    /**
+     * @brief Remove and return every pending path (on shutdown)
+     */
+    std::vector<std::filesystem::path> take_all();
+
+    /**
+     * @brief When the next path becomes ready; nullopt if none is pending
+     */
+    std::optional<Clock::time_point> next_deadline() const;
+
+    size_t pending() const { return bursts_.size(); }
+
+private:
+    struct Burst {
+        Clock::time_point first;
+        Clock::time_point last;
+    };
+
+    Clock::time_point ready_at(const Burst& burst) const;
+
+    Clock::duration quiet_period_;
+    Clock::duration max_delay_;
+    std::map<std::filesystem::path, Burst> bursts_;
+};
+
+/**
+ * @brief What one DirectoryWatcher::wait() saw
+ */
+struct WatchEvents {
+    std::vector<std::filesystem::path> changed;     // Files written, created or moved in
+    bool overflow = false;                          // Events were lost: rescan the tree
+};
+
+/**
+ * @brief Reports files changed under a directory tree
+ *
+ * On Linux this is inotify with one watch per directory, added as
+ * directories appear (files already inside a new directory are reported
+ * too). A file counts as changed when it is written, closed after
+ * writing or moved in; deletions are not reported. Elsewhere the tree is
+ * polled: each poll interval it is walked and sizes and mtimes are
+ * compared, at the cost of a stat per file.
+ */
+class DirectoryWatcher {
+public:
+    explicit DirectoryWatcher(std::filesystem::path root,
+                              std::chrono::milliseconds poll_interval = std::chrono::seconds(2));
+    ~DirectoryWatcher();
+
+    DirectoryWatcher(const DirectoryWatcher&) = delete;
+    DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+    /**
+     * @brief Start watching; changes from here on are reported
+     */
+    core::Result<void> start();
+
+    /**
+     * @brief Wait until something changes, the timeout passes or stop is set
+     * @param timeout Negative = no timeout
+     *
+     * A signal handler that sets stop ends the wait within a second.
+     * Paths are absolute or relative as root was given.
+     */
+    WatchEvents wait(std::chrono::milliseconds timeout, const std::atomic<bool>& stop);
+
+    /**
+     * @brief True for kernel notifications, false when polling
+     */
+    bool native() const;
+
+private:
+    using Snapshot = std::unordered_map<std::string, std::pair<uint64_t, int64_t>>;
+
+    void add_tree(const std::filesystem::path& dir, WatchEvents* found);
+    Snapshot scan() const;
+
+    std::filesystem::path root_;
+    std::chrono::milliseconds poll_interval_;
+    int fd_ = -1;                                           // inotify descriptor
+    std::unordered_map<int, std::filesystem::path> dirs_;   // Watch descriptor -> directory
+    Snapshot snapshot_;                                     // Polling: sizes and mtimes last seen
+    std::chrono::steady_clock::time_point next_poll_{};
+};
+
+} // namespace utils
+} // namespace filevault
+
+#endif // FILEVAULT_UTILS_DIR_WATCHER_HPP
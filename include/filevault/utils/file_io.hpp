@@ -10,6 +10,110 @@
 namespace filevault {
 namespace utils {
 
+/**
+ * @brief Read-only view of a whole file, memory-mapped where possible
+ *
+ * Move-only; the mapping is released on destruction. Files that cannot be
+ * mapped (pipes, special files) are read into an owned buffer instead, so
+ * callers always get a contiguous span.
+ *
+ * The file must not be truncated by another process while mapped.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    
+    // Prevent copying
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    std::span<const uint8_t> span() const { return {data_, size_}; }
+    
+    /**
+     * @brief True if backed by an OS mapping rather than a heap copy
+     */
+    bool is_mapped() const { return mapped_; }
+
+private:
+    friend class FileIO;
+    void unmap();
+    
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<uint8_t> owned_;  // Fallback storage when mapping fails
+#ifdef _WIN32
+    void* mapping_handle_ = nullptr;
+#endif
+};
+
+/**
+ * @brief File opened for positional reads and writes (pread/pwrite)
+ *
+ * Move-only; closed on destruction. Reads and writes take an offset
+ * instead of using the file position, so concurrent callers need no
+ * locking. For fixed-layout files updated in place, such as volumes.
+ */
+class RandomAccessFile {
+public:
+    RandomAccessFile() = default;
+    ~RandomAccessFile();
+    
+    RandomAccessFile(RandomAccessFile&& other) noexcept;
+    RandomAccessFile& operator=(RandomAccessFile&& other) noexcept;
+    
+    RandomAccessFile(const RandomAccessFile&) = delete;
+    RandomAccessFile& operator=(const RandomAccessFile&) = delete;
+    
+    /**
+     * @brief Open an existing file
+     */
+    static core::Result<RandomAccessFile> open(const std::string& path, bool writable);
+    
+    /**
+     * @brief Create a new file of size bytes (sparse where supported)
+     * @return Error if path already exists
+     */
+    static core::Result<RandomAccessFile> create(const std::string& path, uint64_t size);
+    
+    /**
+     * @brief Read exactly data.size() bytes at offset
+     * @return Error on failure or end of file
+     */
+    core::Result<void> read_at(uint64_t offset, std::span<uint8_t> data) const;
+    
+    /**
+     * @brief Write all of data at offset
+     */
+    core::Result<void> write_at(uint64_t offset, std::span<const uint8_t> data);
+    
+    /**
+     * @brief Flush written data to disk (fdatasync / FlushFileBuffers)
+     */
+    core::Result<void> sync();
+    
+    uint64_t size() const;
+    bool is_open() const;
+    const std::string& path() const { return path_; }
+
+private:
+    void close();
+    
+#ifdef _WIN32
+    void* handle_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+    std::string path_;
+};
+
 /**
  * @brief File I/O utilities
  */
@@ -17,13 +121,37 @@ class FileIO {
 public:
     /**
      * @brief Read entire file into memory
+     * @param bypass_cache Evict the file from the page cache afterwards
+     */
+    static core::Result<std::vector<uint8_t>> read_file(const std::string& path, bool bypass_cache = false);
+    
+    /**
+     * @brief Map entire file read-only (mmap / MapViewOfFile)
+     *
+     * Avoids copying large inputs onto the heap; pages are faulted in on
+     * access with sequential read-ahead hinted to the kernel.
+     */
+    static core::Result<MappedFile> map_file(const std::string& path);
+    
+    /**
+     * @brief Read up to length bytes at offset (pread / overlapped ReadFile)
+     *
+     * For headers and other small pieces of large files; the file
+     * position is not used, so concurrent callers need no locking.
+     * @return Fewer bytes than asked for at end of file
      */
-    static core::Result<std::vector<uint8_t>> read_file(const std::string& path);
+    static core::Result<std::vector<uint8_t>> read_range(const std::string& path, uint64_t offset, size_t length);
     
     /**
-     * @brief Write data to file
+     * @brief Write data to file atomically
+     * @param bypass_cache Write the file back and evict it from the page cache
+     *
+     * The data goes to a preallocated temp file beside path, which is
+     * synced once and renamed over path; a crash never leaves a partial
+     * file under the final name.
      */
-    static core::Result<void> write_file(const std::string& path, std::span<const uint8_t> data);
+    static core::Result<void> write_file(const std::string& path, std::span<const uint8_t> data,
+                                         bool bypass_cache = false);
     
     /**
      * @brief Check if file exists
@@ -34,6 +162,37 @@ class FileIO {
      * @brief Get file size
      */
     static size_t file_size(const std::string& path);
+    
+    /**
+     * @brief Switch stdin/stdout to binary mode for pipe I/O (no-op on POSIX)
+     */
+    static void set_binary_stdio();
+    
+    /**
+     * @brief Write back a file and evict it from the page cache
+     * @return false where eviction is unsupported (only Linux/POSIX fadvise)
+     *
+     * For cold-cache measurements; needs no privileges, unlike drop_caches.
+     */
+    static bool drop_cache(const std::string& path);
+    
+    /**
+     * @brief Bytes prefetch() reads by default: the first chunk or two of a file
+     */
+    static constexpr uint64_t PREFETCH_SIZE = 64ull * 1024 * 1024;
+    
+    /**
+     * @brief Read the start of a file into the page cache
+     * @param bypass_cache The job keeps out of the page cache (--direct-io):
+     *                     nothing is read
+     * @return Bytes read (0 if the file cannot be opened or bypass_cache)
+     *
+     * Advises read-ahead (POSIX fadvise WILLNEED), then reads the range
+     * anyway, since network and FUSE file systems may ignore the advice.
+     * For idle time before the data is needed, such as a password prompt.
+     */
+    static uint64_t prefetch(const std::string& path, uint64_t length = PREFETCH_SIZE,
+                             bool bypass_cache = false);
 };
 
 } // namespace utils
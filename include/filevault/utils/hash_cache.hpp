@@ -0,0 +1,113 @@
+#ifndef FILEVAULT_UTILS_HASH_CACHE_HPP
+#define FILEVAULT_UTILS_HASH_CACHE_HPP
+
+#include "filevault/core/result.hpp"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace filevault {
+namespace utils {
+
+/**
+ * @brief What identifies one version of a file on disk
+ *
+ * Taken from stat() before the file is read. A file whose identity is
+ * unchanged is assumed to have unchanged contents, as make and git do.
+ */
+struct FileIdentity {
+    uint64_t device = 0;
+    uint64_t inode = 0;
+    uint64_t size = 0;
+    int64_t mtime_ns = 0;
+    int64_t ctime_ns = 0;   // Status change; catches mtime reset with touch -d
+
+    bool operator==(const FileIdentity&) const = default;
+};
+
+/**
+ * @brief Persistent digest cache keyed by file identity and algorithm
+ *
+ * Entries map (device, inode, algorithm) to the identity seen when the
+ * digest was computed; a lookup hits only if size, mtime and ctime still
+ * match. Files modified within the last two seconds are not stored, since
+ * a write in the same timestamp tick would go unnoticed.
+ *
+ * The file is a flat binary table loaded whole and rewritten atomically
+ * (temporary file, then rename). Lookups and stores are thread-safe.
+ * Concurrent processes do not merge: the last one to save wins, which only
+ * costs cache hits. Keyed digests (HMAC) must not be stored.
+ */
+class HashCache {
+public:
+    static constexpr size_t MAX_ENTRIES = 1 << 20;
+
+    explicit HashCache(std::filesystem::path path);
+
+    /**
+     * @brief Load entries from disk
+     * @return false if the file is missing or unreadable (the cache starts empty)
+     */
+    bool load();
+
+    /**
+     * @brief Write the cache back if anything was stored
+     *
+     * Past MAX_ENTRIES, only entries used or stored in this run are kept.
+     */
+    core::Result<void> save();
+
+    /**
+     * @brief Identity of a regular file, or nullopt if it cannot be stat'ed
+     */
+    static std::optional<FileIdentity> identify(const std::filesystem::path& path);
+
+    /**
+     * @brief Cached digest (raw bytes) for this file version and algorithm
+     */
+    std::optional<std::string> lookup(const FileIdentity& identity, const std::string& algorithm);
+
+    /**
+     * @brief Digest cached for an older version of this file with the same size
+     *
+     * For pre-filtering: if a cheap checksum of the file still matches its
+     * own stale entry, the stale digests can be stored again under the new
+     * identity instead of being recomputed. Not counted as a hit or miss.
+     */
+    std::optional<std::string> stale(const FileIdentity& identity, const std::string& algorithm);
+
+    /**
+     * @brief Remember a digest (raw bytes); ignored for recently modified files
+     */
+    void store(const FileIdentity& identity, const std::string& algorithm, std::string digest);
+
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+    size_t size() const;
+    const std::filesystem::path& path() const { return path_; }
+
+private:
+    struct Entry {
+        FileIdentity identity;
+        std::string digest;
+        bool used = false;   // Looked up or stored since load()
+    };
+
+    static std::string make_key(const FileIdentity& identity, const std::string& algorithm);
+
+    std::filesystem::path path_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    bool dirty_ = false;
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> misses_{0};
+};
+
+} // namespace utils
+} // namespace filevault
+
+#endif // FILEVAULT_UTILS_HASH_CACHE_HPP
@@ -0,0 +1,306 @@
+#ifndef FILEVAULT_UTILS_IO_BACKEND_HPP
+#define FILEVAULT_UTILS_IO_BACKEND_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace filevault {
+namespace utils {
+
+/**
+ * @brief Which implementation serves file reads
+ */
+enum class IoBackendType {
+    AUTO,       // The platform's async backend where available, portable otherwise
+    URING,      // Linux io_uring (batched submissions, registered buffers)
+    IOCP,       // Windows overlapped reads completed through an I/O completion port
+    DISPATCH,   // macOS dispatch I/O channel
+    PORTABLE    // Blocking std::ifstream reads
+};
+
+/**
+ * @brief Positional reads from one file into caller-owned slot buffers
+ *
+ * A read is queued per slot, handed to the kernel by submit() and
+ * collected by wait(). The io_uring backend sends every queued read in
+ * one system call and reads straight into registered buffers; the IOCP
+ * backend issues an overlapped ReadFile per slot and the dispatch backend
+ * a dispatch_io_read, both running while the caller works on earlier
+ * slots. The portable backend performs each read inside wait().
+ */
+class IoBackend {
+public:
+    virtual ~IoBackend() = default;
+
+    virtual const char* name() const = 0;
+
+    /**
+     * @brief Open path for reading
+     * @param direct Bypass the page cache (O_DIRECT, FILE_FLAG_NO_BUFFERING,
+     *               F_NOCACHE) where supported; slot buffers and offsets
+     *               must then be 4096-aligned
+     */
+    virtual bool open(const std::string& path, bool direct) = 0;
+
+    virtual uint64_t size() const = 0;
+
+    /**
+     * @brief Buffers that reads go into, one per slot (kept until destruction)
+     */
+    virtual bool set_buffers(std::span<const std::span<uint8_t>> buffers) = 0;
+
+    /**
+     * @brief Queue a read filling slot's buffer from offset
+     */
+    virtual void queue_read(size_t slot, uint64_t offset) = 0;
+
+    /**
+     * @brief Hand all queued reads to the kernel
+     */
+    virtual bool submit() = 0;
+
+    /**
+     * @brief Wait for slot's read
+     * @return Bytes read (short only at end of file) or -errno
+     */
+    virtual int64_t wait(size_t slot) = 0;
+
+    /**
+     * @brief Backend of the given type (AUTO = the default, see set_default())
+     */
+    static std::unique_ptr<IoBackend> create(IoBackendType type = IoBackendType::AUTO);
+
+    /**
+     * @brief Concrete type AUTO stands for on this machine
+     */
+    static IoBackendType resolve(IoBackendType type);
+
+    /**
+     * @brief Whether this build and kernel support io_uring (probed once)
+     */
+    static bool uring_available();
+
+    /**
+     * @brief Type used for AUTO (the io.backend config key)
+     */
+    static void set_default(IoBackendType type);
+
+    static std::optional<IoBackendType> parse(std::string_view name);
+    static const char* type_name(IoBackendType type);
+};
+
+/**
+ * @brief Byte range of a file
+ */
+struct FileExtent {
+    uint64_t offset = 0;
+    uint64_t length = 0;
+};
+
+/**
+ * @brief Ranges of a file that hold data, in order; the rest are holes
+ *
+ * Asks the filesystem (SEEK_DATA/SEEK_HOLE, FSCTL_QUERY_ALLOCATED_RANGES
+ * on Windows) instead of reading, so a mostly empty disk image costs a
+ * few system calls per extent. A file without holes yields one extent.
+ * @return std::nullopt if holes cannot be detected (treat it all as data)
+ */
+std::optional<std::vector<FileExtent>> data_extents(const std::string& path);
+
+/**
+ * @brief How an InputFile reads ahead
+ */
+struct InputFileOptions {
+    IoBackendType backend = IoBackendType::AUTO;
+    size_t depth = 8;                   // Blocks in flight
+    size_t block_size = 1024 * 1024;    // Multiple of 4096
+    bool direct = false;                // Bypass the page cache: O_DIRECT where the
+                                        // filesystem allows it, else evict read blocks
+};
+
+/**
+ * @brief Sequential input stream that keeps several block reads in flight
+ *
+ * A drop-in for std::ifstream in the streaming engine: while one block is
+ * consumed the next depth - 1 are already being read by the backend.
+ * Seeking (used for frame indexes and resumes) drains the queue and
+ * restarts it at the new position. Read errors set badbit.
+ */
+class InputFile : public std::istream {
+public:
+    InputFile();
+    explicit InputFile(const std::string& path, const InputFileOptions& options = {});
+    ~InputFile() override;
+
+    InputFile(const InputFile&) = delete;
+    InputFile& operator=(const InputFile&) = delete;
+
+    bool open(const std::string& path, const InputFileOptions& options = {});
+    bool is_open() const;
+    uint64_t size() const;
+    const char* backend_name() const;
+
+private:
+    class Buffer;
+    std::unique_ptr<Buffer> buffer_;
+};
+
+/**
+ * @brief How an OutputFile writes
+ */
+struct OutputFileOptions {
+    bool truncate = true;               // false = keep existing contents (resume)
+    bool bypass_cache = false;          // Write back and evict written data as it goes
+    size_t buffer_size = 1024 * 1024;   // Bytes gathered per write call
+    bool atomic = false;                // Write a temp file beside path; commit() moves it into place
+    uint64_t preallocate = 0;           // Expected size, reserved up front (fallocate, Linux)
+};
+
+/**
+ * @brief Makes many atomic outputs durable together
+ *
+ * OutputFile::commit(group) closes its temp file and hands it to the
+ * group instead of syncing it alone. Every limit files, and on flush(),
+ * the group starts write-back of all of them before waiting on any,
+ * renames them into place and syncs each directory once, so a batch of
+ * small files shares journal commits instead of paying one per file.
+ * A file appears under its final name only once its group is flushed.
+ * Safe to use from several threads.
+ */
+class CommitGroup {
+public:
+    explicit CommitGroup(size_t limit = 64);
+    ~CommitGroup();
+
+    CommitGroup(const CommitGroup&) = delete;
+    CommitGroup& operator=(const CommitGroup&) = delete;
+
+    /**
+     * @brief Queue a written temp file to be renamed to path
+     */
+    void add(const std::string& temp_path, const std::string& path);
+
+    /**
+     * @brief Commit every queued file
+     * @return false if any file could not be synced or renamed
+     */
+    bool flush();
+
+    /**
+     * @brief Files that could not be committed so far (each is logged)
+     */
+    size_t failed() const;
+
+private:
+    struct Pending {
+        std::string temp_path;
+        std::string path;
+    };
+
+    bool commit(std::vector<Pending> files);
+
+    size_t limit_;
+    mutable std::mutex mutex_;
+    std::vector<Pending> pending_;
+    size_t failed_ = 0;
+};
+
+/**
+ * @brief Output stream writing straight to a file descriptor
+ *
+ * A drop-in for std::ofstream in the streaming engine. With bypass_cache
+ * every few megabytes written are pushed to disk and dropped from the
+ * page cache (sync_file_range + POSIX_FADV_DONTNEED), so a bulk job does
+ * not evict other programs' working sets; write-back of one window
+ * overlaps with filling the next. Where eviction is unsupported the
+ * option is ignored. Write errors set badbit.
+ *
+ * An atomic file is written under a temporary name in the same
+ * directory. commit() syncs it once and renames it over path, so a
+ * crash leaves either the old file or the complete new one; closing
+ * without commit() deletes the temp file.
+ */
+class OutputFile : public std::ostream {
+public:
+    OutputFile();
+    explicit OutputFile(const std::string& path, const OutputFileOptions& options = {});
+    ~OutputFile() override;
+
+    OutputFile(const OutputFile&) = delete;
+    OutputFile& operator=(const OutputFile&) = delete;
+
+    bool open(const std::string& path, const OutputFileOptions& options = {});
+    bool is_open() const;
+
+    /**
+     * @brief Write out buffered data, finish eviction and close
+     * @return false if any write failed
+     *
+     * An atomic file is discarded; use commit() to keep it.
+     */
+    bool close();
+
+    /**
+     * @brief Close with the data on disk: fsync, then for an atomic file
+     *        rename into place and sync the directory
+     * @param group Defer the sync and rename of an atomic file to group
+     * @return false if a write, the sync or the rename failed (an atomic
+     *         file is then discarded and path left untouched)
+     */
+    bool commit(CommitGroup* group = nullptr);
+
+    /**
+     * @brief Advance by length zero bytes, leaving a hole where possible
+     *
+     * The range is deallocated (fallocate PUNCH_HOLE, FSCTL_SET_ZERO_DATA)
+     * and the file is extended to cover it, so it reads back as zeros
+     * without taking disk space. Where holes cannot be made, zeros are
+     * written over whatever the range already held.
+     * @return false if the range could not be zeroed
+     */
+    bool write_zeros(uint64_t length);
+
+private:
+    class Buffer;
+    std::unique_ptr<Buffer> buffer_;
+};
+
+/**
+ * @brief Output stream that discards everything and counts the bytes
+ *
+ * For running a decoder for its checks alone (decrypt --verify-only):
+ * the pipeline is the same, but no plaintext is written or kept.
+ */
+class NullOutput : public std::ostream {
+public:
+    NullOutput();
+    ~NullOutput() override;
+
+    NullOutput(const NullOutput&) = delete;
+    NullOutput& operator=(const NullOutput&) = delete;
+
+    /**
+     * @brief Count length zero bytes without producing them
+     */
+    void write_zeros(uint64_t length);
+
+    uint64_t bytes() const;             // Discarded so far
+
+private:
+    class Buffer;
+    std::unique_ptr<Buffer> buffer_;
+};
+
+} // namespace utils
+} // namespace filevault
+
+#endif // FILEVAULT_UTILS_IO_BACKEND_HPP
@@ -0,0 +1,76 @@
+#ifndef FILEVAULT_UTILS_JSON_RPC_HPP
+#define FILEVAULT_UTILS_JSON_RPC_HPP
+
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <nlohmann/json.hpp>
+
+namespace filevault {
+namespace utils {
+
+/**
+ * @brief Error a handler throws to answer with a JSON-RPC error object
+ */
+class RpcError : public std::runtime_error {
+public:
+    RpcError(int code, const std::string& message)
+        : std::runtime_error(message), code_(code) {}
+
+    int code() const { return code_; }
+
+private:
+    int code_;
+};
+
+/**
+ * @brief JSON-RPC 2.0 over newline-delimited messages
+ *
+ * One request per line, one response line per request that has an id.
+ * Requests without an id are notifications and get no response, as the
+ * spec requires. Transport is left to the caller, so the same dispatcher
+ * serves stdio and sockets.
+ */
+class JsonRpcDispatcher {
+public:
+    static constexpr int PARSE_ERROR = -32700;
+    static constexpr int INVALID_REQUEST = -32600;
+    static constexpr int METHOD_NOT_FOUND = -32601;
+    static constexpr int INVALID_PARAMS = -32602;
+    static constexpr int INTERNAL_ERROR = -32603;
+
+    /**
+     * @brief Sends a notification (method, params) to the client
+     */
+    using Notify = std::function<void(const std::string&, const nlohmann::json&)>;
+
+    /**
+     * @brief Returns the result; throws RpcError for an error response
+     *
+     * Notifications sent through notify carry the request id in
+     * params["id"], so clients can tell concurrent requests apart.
+     */
+    using Handler = std::function<nlohmann::json(const nlohmann::json& params, const Notify& notify)>;
+
+    void add(const std::string& method, Handler handler);
+
+    /**
+     * @brief Handle one request line
+     * @return Response line without the newline; empty for notifications
+     */
+    std::string handle(const std::string& line, const Notify& notify) const;
+
+    /**
+     * @brief Notification line without the newline
+     */
+    static std::string notification(const std::string& method, const nlohmann::json& params);
+
+private:
+    std::map<std::string, Handler> handlers_;
+};
+
+} // namespace utils
+} // namespace filevault
+
+#endif // FILEVAULT_UTILS_JSON_RPC_HPP
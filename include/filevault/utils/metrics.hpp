@@ -0,0 +1,183 @@
+#ifndef FILEVAULT_UTILS_METRICS_HPP
+#define FILEVAULT_UTILS_METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace filevault {
+namespace utils {
+
+/**
+ * @brief Log-linear (HDR-style) histogram written by a single thread
+ *
+ * Values below 64 get a bucket each; above that every power of two is
+ * split into 32 buckets, so a quantile read back is within 1/32 (about
+ * 3%) of the recorded value. Values above MAX_VALUE are clamped.
+ *
+ * Only the owning thread calls record(), which is a load and a store per
+ * counter with no read-modify-write; other threads may read at any time
+ * and see each counter whole, if not all of them from the same instant.
+ */
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BITS = 5;
+    static constexpr uint64_t SUB_BUCKETS = uint64_t(1) << SUB_BITS;
+    static constexpr unsigned MAX_BITS = 40;        // About 12 days in microseconds
+    static constexpr uint64_t MAX_VALUE = (uint64_t(1) << MAX_BITS) - 1;
+    static constexpr size_t BUCKETS = SUB_BUCKETS * (MAX_BITS - SUB_BITS + 1);
+
+    void record(uint64_t value);
+
+    uint64_t count(size_t bucket) const { return counts_[bucket].load(std::memory_order_relaxed); }
+    uint64_t total() const { return total_.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+    static size_t bucket_of(uint64_t value);
+
+    /**
+     * @brief Highest value that lands in a bucket
+     */
+    static uint64_t bucket_limit(size_t bucket);
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKETS> counts_{};
+    std::atomic<uint64_t> total_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+/**
+ * @brief Histograms of several threads added together
+ */
+struct HistogramSnapshot {
+    std::vector<uint64_t> counts;       // Per bucket; empty until something is merged
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+
+    void merge(const LatencyHistogram& histogram);
+
+    /**
+     * @brief Value at quantile q (0..1), as the highest value of its bucket
+     * @return 0 when empty; never more than max
+     */
+    uint64_t quantile(double q) const;
+};
+
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+/**
+ * @brief Process-wide counters and latency histograms for serve mode
+ *
+ * Recording never takes a lock shared with other threads: each thread
+ * writes its own shard (one counter slot and one lazily created
+ * LatencyHistogram per series), and a scrape adds the shards together.
+ * Shards of exited threads are handed to new threads with their counts
+ * intact, so a daemon that starts a thread per connection keeps a
+ * bounded number of them.
+ *
+ * A series is a name plus labels, resolved to an Id once per thread and
+ * kept in a thread-local table. At most MAX_SERIES exist; past that,
+ * counter() and histogram() return INVALID, which add() and observe()
+ * ignore.
+ */
+class Metrics {
+public:
+    using Id = size_t;
+    static constexpr Id INVALID = static_cast<Id>(-1);
+    static constexpr size_t MAX_SERIES = 1024;
+
+    static Metrics& instance();
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    Id counter(const std::string& name, const MetricLabels& labels = {});
+    Id histogram(const std::string& name, const MetricLabels& labels = {});
+
+    void add(Id id, uint64_t delta = 1);
+    void observe(Id id, uint64_t value);
+
+    /**
+     * @brief Help text and export scale of a metric family
+     * @param scale Applied to histogram values on export, e.g. 1e-6 for
+     *              microseconds recorded under a _seconds name
+     */
+    void describe(const std::string& name, const std::string& help, double scale = 1.0);
+
+    struct CounterValue {
+        std::string name;
+        MetricLabels labels;
+        uint64_t value;
+    };
+
+    struct HistogramValue {
+        std::string name;
+        MetricLabels labels;
+        HistogramSnapshot snapshot;
+        double scale;
+    };
+
+    std::vector<CounterValue> counters() const;
+    std::vector<HistogramValue> histograms() const;
+
+    /**
+     * @brief Append every series in Prometheus text format (0.0.4)
+     *
+     * Counters are exported as counters; histograms as summaries with
+     * the 0.5, 0.99 and 0.999 quantiles, _sum and _count.
+     */
+    void write_prometheus(std::string& out) const;
+
+    /**
+     * @brief Append one unlabelled sample with its HELP and TYPE lines
+     */
+    static void write_sample(std::string& out, const std::string& name, const std::string& help,
+                             const char* type, double value);
+
+private:
+    Metrics() = default;
+
+    enum class Kind { COUNTER, HISTOGRAM };
+
+    struct Series {
+        std::string name;
+        MetricLabels labels;
+        Kind kind;
+    };
+
+    struct Family {
+        std::string help;
+        double scale = 1.0;
+    };
+
+    struct Shard {
+        std::array<std::atomic<uint64_t>, MAX_SERIES> counters{};
+        std::array<std::atomic<LatencyHistogram*>, MAX_SERIES> histograms{};
+        std::vector<std::unique_ptr<LatencyHistogram>> owned;   // Touched by the owning thread only
+        std::atomic<bool> in_use{true};
+    };
+
+    Id resolve(Kind kind, const std::string& name, const MetricLabels& labels);
+    Shard& local_shard();
+
+    mutable std::mutex mutex_;
+    std::vector<Series> series_;
+    std::unordered_map<std::string, Id> index_;
+    std::unordered_map<std::string, Family> families_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+} // namespace utils
+} // namespace filevault
+
+#endif // FILEVAULT_UTILS_METRICS_HPP
@@ -0,0 +1,89 @@
+#ifndef FILEVAULT_UTILS_MULTI_HASH_HPP
+#define FILEVAULT_UTILS_MULTI_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace filevault::utils::multihash {
+
+/**
+ * @brief Multi-buffer SHA-256 and BLAKE2s-256 over many short messages
+ *
+ * A single message leaves most of a SIMD register idle: each compression
+ * depends on the one before it. These kernels instead put one message in
+ * each 32-bit lane and compress a block of every lane at once, 4 lanes
+ * with SSE2, 8 with AVX2 and 16 with AVX-512. When a lane's message ends
+ * its digest is taken and the next message moves in, so messages of
+ * different lengths keep every lane busy. Digests are the standard ones.
+ *
+ * Worth it for messages up to a few KB, where one-at-a-time hashing is
+ * dominated by setup and a short dependency chain; a long message is
+ * faster through Botan (SHA-NI, ARMv8 SHA2), which hashes it alone.
+ */
+
+/**
+ * @brief Instruction sets with a kernel; see is_supported()
+ */
+enum class Isa {
+    Scalar,     // One lane, for reference and other compilers
+    SSE2,       // 4 lanes
+    AVX2,       // 8 lanes
+    AVX512      // 16 lanes
+};
+
+enum class Algorithm {
+    SHA256,
+    BLAKE2S_256
+};
+
+constexpr size_t DIGEST_SIZE = 32;
+
+/**
+ * @brief Widest kernel for this CPU (BOTAN_CLEAR_CPUID applies, see CpuFeatures)
+ */
+Isa best_isa();
+
+/**
+ * @brief True if @p isa is built in and the CPU has it
+ */
+bool is_supported(Isa isa);
+
+/**
+ * @brief Lower-case name, for benchmarks and logs
+ */
+const char* isa_name(Isa isa);
+
+/**
+ * @brief Messages hashed at once by @p isa
+ */
+size_t lanes(Isa isa);
+
+/**
+ * @brief True if hash() beats hashing short messages one at a time here
+ *
+ * Needs at least 4 lanes. For SHA-256 with SHA-NI it also needs AVX-512:
+ * one SHA-NI lane keeps up with 8 AVX2 lanes once messages reach about
+ * 1 KB.
+ */
+bool preferred(Algorithm algorithm);
+
+/**
+ * @brief Algorithm for a Botan hash name ("SHA-256", "Blake2s(256)")
+ * @return nullopt for hashes without a multi-buffer kernel
+ */
+std::optional<Algorithm> algorithm_for(std::string_view botan_name);
+
+/**
+ * @brief Hash every message, writing DIGEST_SIZE bytes per message to @p digests
+ * @throws std::invalid_argument if @p digests is smaller than
+ *         messages.size() * DIGEST_SIZE or @p isa is unsupported
+ */
+void hash(Algorithm algorithm, std::span<const std::span<const uint8_t>> messages,
+          std::span<uint8_t> digests, Isa isa = best_isa());
+
+} // namespace filevault::utils::multihash
+
+#endif // FILEVAULT_UTILS_MULTI_HASH_HPP
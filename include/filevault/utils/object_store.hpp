@@ -0,0 +1,176 @@
+#ifndef FILEVAULT_UTILS_OBJECT_STORE_HPP
+#define FILEVAULT_UTILS_OBJECT_STORE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "filevault/core/result.hpp"
+
+namespace filevault {
+namespace utils {
+
+/**
+ * @brief Bucket and key named by an "s3://bucket/key" URL
+ */
+struct ObjectUrl {
+    std::string bucket;
+    std::string key;
+
+    /**
+     * @brief Split an s3:// URL; std::nullopt for anything else
+     */
+    static std::optional<ObjectUrl> parse(std::string_view url);
+
+    /**
+     * @brief Whether a path argument names an object rather than a file
+     */
+    static bool is_object_url(std::string_view text);
+};
+
+/**
+ * @brief Multipart uploads and ranged reads against an object store
+ *
+ * Keys are relative to the store's bucket. Calls may come from several
+ * threads at once. Errors are returned, not thrown.
+ */
+class ObjectStore {
+public:
+    virtual ~ObjectStore() = default;
+
+    /**
+     * @brief Size of an existing object
+     */
+    virtual core::Result<uint64_t> size(const std::string& key) = 0;
+
+    /**
+     * @brief Bytes [offset, offset + length) of an object (short at its end)
+     */
+    virtual core::Result<std::vector<uint8_t>> read(const std::string& key, uint64_t offset, size_t length) = 0;
+
+    /**
+     * @brief Start a multipart upload
+     * @return Upload ID
+     */
+    virtual core::Result<std::string> begin_upload(const std::string& key) = 0;
+
+    /**
+     * @brief Upload part part_number (1-based) of an upload
+     * @return The part's ETag, needed to complete the upload
+     */
+    virtual core::Result<std::string> upload_part(const std::string& key, const std::string& upload_id,
+                                                  int part_number, std::span<const uint8_t> data) = 0;
+
+    /**
+     * @brief Assemble the parts, in order, into the object
+     */
+    virtual core::Result<void> complete_upload(const std::string& key, const std::string& upload_id,
+                                               const std::vector<std::string>& etags) = 0;
+
+    /**
+     * @brief Drop an upload and the parts stored so far
+     */
+    virtual void abort_upload(const std::string& key, const std::string& upload_id) = 0;
+};
+
+/**
+ * @brief How an ObjectOutput uploads
+ */
+struct ObjectOutputOptions {
+    size_t part_size = 16 * 1024 * 1024;    // Bytes per part (S3: at least 5 MiB but the last)
+    size_t max_in_flight = 4;               // Parts uploading at once
+};
+
+/**
+ * @brief Output stream that uploads an object in parts as it is written
+ *
+ * Every part_size bytes written become one part, uploaded on a thread of
+ * its own while the next part fills. At most max_in_flight parts are
+ * uploading; a write that would start one more waits for the oldest, so
+ * memory stays at (max_in_flight + 1) * part_size. tellp() reports bytes
+ * written; the stream cannot seek.
+ *
+ * The object appears only when finish() completes the upload. Destroying
+ * the stream without finish() aborts the upload. A failed part sets
+ * badbit; error() says why.
+ */
+class ObjectOutput : public std::ostream {
+public:
+    ObjectOutput(ObjectStore& store, std::string key, const ObjectOutputOptions& options = {});
+    ~ObjectOutput() override;
+
+    ObjectOutput(const ObjectOutput&) = delete;
+    ObjectOutput& operator=(const ObjectOutput&) = delete;
+
+    /**
+     * @brief Whether the multipart upload was started
+     */
+    bool is_open() const;
+
+    /**
+     * @brief Upload the last part and complete the upload
+     * @return false if any part or the completion failed (the upload is aborted)
+     */
+    bool finish();
+
+    const std::string& error() const;
+
+private:
+    class Buffer;
+    std::unique_ptr<Buffer> buffer_;
+};
+
+/**
+ * @brief How an ObjectInput reads
+ */
+struct ObjectInputOptions {
+    size_t block_size = 8 * 1024 * 1024;    // Bytes per ranged read
+    size_t read_ahead = 2;                  // Blocks fetched ahead on sequential reads
+};
+
+/**
+ * @brief Seekable input stream over an object, read in ranges
+ *
+ * Each block is fetched with one ranged read when first needed. Reads of
+ * at least a block fetch exactly the bytes asked for. Once two blocks are
+ * read back to back, the next read_ahead blocks are fetched in the
+ * background. Seeking is cheap, so a reader that jumps between frames
+ * (StreamReader) only ever fetches the ranges it uses. A failed read
+ * sets badbit; error() says why.
+ */
+class ObjectInput : public std::istream {
+public:
+    ObjectInput(ObjectStore& store, std::string key, const ObjectInputOptions& options = {});
+    ~ObjectInput() override;
+
+    ObjectInput(const ObjectInput&) = delete;
+    ObjectInput& operator=(const ObjectInput&) = delete;
+
+    /**
+     * @brief Whether the object exists and its size is known
+     */
+    bool is_open() const;
+    uint64_t size() const;
+
+    /**
+     * @brief Bytes fetched from the store so far
+     */
+    uint64_t bytes_fetched() const;
+
+    const std::string& error() const;
+
+private:
+    class Buffer;
+    std::unique_ptr<Buffer> buffer_;
+};
+
+} // namespace utils
+} // namespace filevault
+
+#endif // FILEVAULT_UTILS_OBJECT_STORE_HPP
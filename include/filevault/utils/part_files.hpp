@@ -0,0 +1,136 @@
+#ifndef FILEVAULT_UTILS_PART_FILES_HPP
+#define FILEVAULT_UTILS_PART_FILES_HPP
+
+#include "filevault/core/result.hpp"
+#include "filevault/utils/io_backend.hpp"
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace filevault {
+namespace utils {
+
+/**
+ * @brief One stream stored as numbered part files (--split-size)
+ *
+ *   backup.fvlt.part001  backup.fvlt.part002  ...  backup.fvlt.parts
+ *
+ * The stream's bytes are cut at fixed offsets, so every part but the last
+ * holds exactly part_size bytes, which is what multipart uploads want.
+ * Each part starts with a 44-byte header (little-endian):
+ *
+ *   "FVPT" | version u8 | flags u8 (1 = last) | reserved u16 |
+ *   number u32 (from 1) | stream id [16] | offset u64 | length u64
+ *
+ * so a part identifies itself: which stream, which piece of it, and
+ * whether it is complete, without the others. The manifest (JSON) lists
+ * the parts for uploaders; readers can also start from the first part
+ * alone and follow the numbers up to the part marked last.
+ */
+constexpr size_t PART_HEADER_SIZE = 44;
+
+struct PartInfo {
+    std::string path;
+    uint64_t offset = 0;        // Position of the part's first byte in the stream
+    uint64_t length = 0;        // Stream bytes in the part (file size minus the header)
+};
+
+struct PartSet {
+    std::array<uint8_t, 16> stream_id{};
+    uint64_t part_size = 0;
+    uint64_t total_size = 0;
+    std::vector<PartInfo> parts;
+
+    /**
+     * @brief File name of part number (from 1) of the stream written to base
+     */
+    static std::string part_path(const std::string& base, size_t number);
+
+    /**
+     * @brief Manifest written beside the parts of base
+     */
+    static std::string manifest_path(const std::string& base);
+
+    /**
+     * @brief Whether path names a manifest or a part file
+     */
+    static bool is_part_set(const std::string& path);
+
+    /**
+     * @brief Load a set from its manifest, or by walking the headers from its first part
+     *
+     * Part paths in a manifest are relative to the manifest's directory.
+     * Only the headers are read; PartInput checks them against the set.
+     */
+    static core::Result<PartSet> load(const std::string& path);
+
+    core::Result<void> save_manifest(const std::string& path) const;
+};
+
+/**
+ * @brief Output stream that writes its bytes into part files of part_size bytes
+ *
+ * Each part is an atomic OutputFile: it appears under its final name once
+ * it is full, so an uploader watching the directory can send part 1 while
+ * part 2 is being written. finish() marks the last part and writes the
+ * manifest. tellp() reports stream bytes written; the stream cannot seek.
+ */
+class PartOutput : public std::ostream {
+public:
+    /**
+     * @param base Path the unsplit stream would have had
+     * @param part_size Stream bytes per part (> 0)
+     * @param options Applied to every part (atomic is always set)
+     */
+    PartOutput(const std::string& base, uint64_t part_size, const OutputFileOptions& options = {});
+    ~PartOutput() override;
+
+    PartOutput(const PartOutput&) = delete;
+    PartOutput& operator=(const PartOutput&) = delete;
+
+    /**
+     * @brief Commit the last part and write the manifest
+     * @return false if any part could not be written (error() says which)
+     */
+    bool finish();
+
+    const PartSet& parts() const;
+    const std::string& error() const;
+
+private:
+    class Buffer;
+    std::unique_ptr<Buffer> buffer_;
+};
+
+/**
+ * @brief Input stream over the parts of a PartSet, in order
+ *
+ * While one part is read, the next is opened, its header checked and its
+ * first block read on another thread, so part boundaries cost no wait
+ * (which matters most on network and FUSE mounts). A missing, truncated
+ * or foreign part ends the stream early with error() set, so check it
+ * after reading to the end. Seeks by absolute position are supported.
+ */
+class PartInput : public std::istream {
+public:
+    explicit PartInput(PartSet set, const InputFileOptions& options = {});
+    ~PartInput() override;
+
+    PartInput(const PartInput&) = delete;
+    PartInput& operator=(const PartInput&) = delete;
+
+    const std::string& error() const;
+
+private:
+    class Buffer;
+    std::unique_ptr<Buffer> buffer_;
+};
+
+} // namespace utils
+} // namespace filevault
+
+#endif // FILEVAULT_UTILS_PART_FILES_HPP
@@ -2,12 +2,35 @@
 #define FILEVAULT_UTILS_PASSWORD_HPP
 
 #include "filevault/core/types.hpp"
+#include <cstdint>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace filevault {
+namespace core { class ThreadPool; }
 namespace utils {
 
+/**
+ * @brief Score of one password without warnings or crack-time text
+ *
+ * The part of core::PasswordAnalysis that bulk screening needs; computed
+ * in one pass over the password with no heap allocation.
+ */
+struct PasswordScore {
+    int score = 0;                  // 0-100
+    core::PasswordStrength strength = core::PasswordStrength::VERY_WEAK;
+    double entropy_bits = 0.0;
+    uint32_t length = 0;
+    bool has_lowercase = false;
+    bool has_uppercase = false;
+    bool has_digits = false;
+    bool has_special = false;
+    bool has_repeated_chars = false;
+    bool is_common_password = false;
+};
+
 /**
  * @brief Password utilities for secure input and strength analysis
  */
@@ -29,6 +52,18 @@ class Password {
      */
     static core::PasswordAnalysis analyze_strength(const std::string& password);
     
+    /**
+     * @brief Score a password (analyze_strength() without the messages)
+     */
+    static PasswordScore score(std::string_view password);
+    
+    /**
+     * @brief Score many passwords on a thread pool
+     * @param results Same size as passwords; results[i] scores passwords[i]
+     */
+    static void score_batch(std::span<const std::string> passwords, std::span<PasswordScore> results,
+                            core::ThreadPool& pool);
+    
     /**
      * @brief Get strength color for display
      */
@@ -57,13 +92,11 @@ class Password {
     
     /**
      * @brief Check if password is in common password list
+     *
+     * Also consults the breached-password filter when one is installed
+     * (see PasswordFilter::shared()).
      */
-    static bool is_common_password(const std::string& password);
-    
-    /**
-     * @brief Calculate password entropy
-     */
-    static double calculate_entropy(const std::string& password);
+    static bool is_common_password(std::string_view password);
     
     /**
      * @brief Estimate crack time
@@ -0,0 +1,82 @@
+#ifndef FILEVAULT_UTILS_PASSWORD_FILTER_HPP
+#define FILEVAULT_UTILS_PASSWORD_FILTER_HPP
+
+#include "filevault/core/result.hpp"
+#include "filevault/utils/file_io.hpp"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace filevault {
+namespace utils {
+
+/**
+ * @brief Memory-mapped Bloom filter over a breached-password corpus
+ *
+ * Built once from a corpus (plain passwords or HIBP "SHA1:count" lines)
+ * and mapped read-only afterwards. The filter is blocked: all probes for
+ * one password land in a single 64-byte block, so a lookup is one SHA-1
+ * and one cache line, and only the blocks actually touched become
+ * resident. False positives happen at the rate chosen at build time;
+ * false negatives never do.
+ */
+class PasswordFilter {
+public:
+    static constexpr size_t BLOCK_BYTES = 64;
+    static constexpr size_t HEADER_BYTES = 64;      // Keeps blocks cache-line aligned
+    static constexpr double DEFAULT_FALSE_POSITIVE_RATE = 0.001;
+
+    using Digest = std::array<uint8_t, 20>;
+
+    PasswordFilter() = default;
+
+    /**
+     * @brief Map a filter file
+     */
+    static core::Result<PasswordFilter> open(const std::string& path);
+
+    /**
+     * @brief Build a filter file from a corpus, one entry per line
+     *
+     * Lines of 40 hex digits, optionally followed by ":count", are taken
+     * as SHA-1 digests (the HIBP download format); anything else is a
+     * password and hashed as is. Empty lines are skipped.
+     * @return Number of entries added
+     */
+    static core::Result<uint64_t> build(const std::string& corpus_path, const std::string& output_path,
+                                        double false_positive_rate = DEFAULT_FALSE_POSITIVE_RATE);
+
+    /**
+     * @brief The filter at Config::get_breach_filter_path(), mapped on first use
+     * @return nullptr if there is no usable filter
+     *
+     * Thread-safe; an unreadable or corrupt file is reported once and
+     * treated as missing.
+     */
+    static const PasswordFilter* shared();
+
+    /**
+     * @brief SHA-1 of a password, as HIBP lists them
+     */
+    static Digest digest(std::string_view password);
+
+    bool contains(std::string_view password) const { return contains_digest(digest(password)); }
+    bool contains_digest(const Digest& digest) const;
+
+    bool is_open() const { return block_count_ > 0; }
+    uint64_t entry_count() const { return entry_count_; }
+    uint32_t hash_count() const { return hash_count_; }
+    uint64_t size_bytes() const { return block_count_ * BLOCK_BYTES; }
+
+private:
+    MappedFile file_;
+    uint64_t block_count_ = 0;
+    uint64_t entry_count_ = 0;
+    uint32_t hash_count_ = 0;
+};
+
+} // namespace utils
+} // namespace filevault
+
+#endif // FILEVAULT_UTILS_PASSWORD_FILTER_HPP
@@ -1,11 +1,17 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <functional>
 #include <indicators/progress_bar.hpp>
 #include <indicators/block_progress_bar.hpp>
 #include <indicators/cursor_control.hpp>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace filevault {
@@ -16,6 +22,11 @@ namespace utils {
  */
 class ProgressBar {
 public:
+    /**
+     * @brief Receives (prefix, progress, max) instead of a drawn bar
+     */
+    using Observer = std::function<void(const std::string&, size_t, size_t)>;
+    
     ProgressBar(const std::string& prefix, size_t max_progress = 100);
     ~ProgressBar();
     
@@ -27,8 +38,19 @@ class ProgressBar {
     void hide();
     void show();
     
+    /**
+     * @brief Route bars created from now on to observer (empty = draw again)
+     *
+     * Used by 'serve' to turn progress into protocol events.
+     */
+    static void set_observer(Observer observer);
+    
 private:
+    void notify() const;
+    
     std::unique_ptr<indicators::ProgressBar> bar_;
+    Observer observer_;
+    std::string prefix_;
     size_t current_progress_;
     size_t max_progress_;
 };
@@ -48,6 +70,67 @@ class BlockProgressBar {
     std::unique_ptr<indicators::BlockProgressBar> bar_;
 };
 
+/**
+ * @brief One progress bar fed by many concurrent workers
+ *
+ * Workers only bump atomic byte counters; they never take a lock or draw.
+ * A render thread samples the counters at a fixed interval and redraws
+ * the bar with throughput and ETA, so the cost of reporting does not grow
+ * with the number of chunks or threads.
+ */
+class ProgressAggregator {
+public:
+    /**
+     * @param total_bytes Expected bytes (0 = unknown until set_total())
+     */
+    ProgressAggregator(const std::string& prefix, uint64_t total_bytes,
+                       std::chrono::milliseconds interval = std::chrono::milliseconds(100));
+    ~ProgressAggregator();
+    
+    ProgressAggregator(const ProgressAggregator&) = delete;
+    ProgressAggregator& operator=(const ProgressAggregator&) = delete;
+    
+    /**
+     * @brief Count bytes just finished (safe from any thread)
+     */
+    void add(uint64_t bytes) noexcept { done_.fetch_add(bytes, std::memory_order_relaxed); }
+    
+    /**
+     * @brief Set the bytes done so far, for a single cumulative source
+     */
+    void update(uint64_t done) noexcept { done_.store(done, std::memory_order_relaxed); }
+    
+    void set_total(uint64_t total) noexcept { total_.store(total, std::memory_order_relaxed); }
+    
+    uint64_t done() const noexcept { return done_.load(std::memory_order_relaxed); }
+    uint64_t total() const noexcept { return total_.load(std::memory_order_relaxed); }
+    
+    /**
+     * @brief Stop the render thread and draw the bar complete
+     */
+    void finish();
+    
+    /**
+     * @brief "<rate> MB/s, ETA m:ss" for a postfix (no ETA if total is 0)
+     */
+    static std::string format_rate(uint64_t done, uint64_t total, double seconds);
+    
+private:
+    void stop();
+    void render_loop();
+    void render();
+    
+    ProgressBar bar_;                       // Only touched by the render thread until finish()
+    std::atomic<uint64_t> done_{0};
+    std::atomic<uint64_t> total_;
+    std::chrono::milliseconds interval_;
+    std::chrono::steady_clock::time_point start_;
+    std::mutex mutex_;                      // Guards stopping_ for the render thread's wait
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
 // MultiProgress removed - not compatible with indicators API
 
 // Spinner removed - use ProgressBar instead
@@ -0,0 +1,104 @@
+#ifndef FILEVAULT_UTILS_ROW_WRITER_HPP
+#define FILEVAULT_UTILS_ROW_WRITER_HPP
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace filevault {
+namespace utils {
+
+/**
+ * @brief How a RowWriter prints its rows
+ */
+enum class RowFormat {
+    TABLE,      // Fixed-width columns for a terminal
+    TSV,        // Tab-separated, one header line
+    JSONL       // One JSON object per row
+};
+
+/**
+ * @brief One column of a RowWriter
+ */
+struct RowColumn {
+    std::string name;           // Header and JSON key
+    size_t width = 0;           // TABLE: minimum width; longer cells are not cut
+    bool right = false;         // TABLE: right-aligned
+    bool literal = false;       // JSONL: a number or true/false, written unquoted
+};
+
+/**
+ * @brief Streaming renderer for long listings
+ *
+ * TableFormatter keeps the whole table to size its columns, which is fine
+ * for a dozen algorithms but not for a million archive members. A
+ * RowWriter has a fixed column layout instead: each row is formatted into
+ * one buffer as it arrives, and the buffer goes out in a single write
+ * every flush_rows rows (on a terminal, after every row, so slow listings
+ * still show progress). Nothing is kept per row and nothing is colored.
+ *
+ * RowFormat is chosen by the caller, usually through parse_format():
+ * "auto" is TABLE on a terminal and TSV otherwise. TSV cells escape tab,
+ * newline, carriage return and backslash as \t, \n, \r and \\.
+ */
+class RowWriter {
+public:
+    static constexpr size_t DEFAULT_FLUSH_ROWS = 4096;
+
+    RowWriter(std::vector<RowColumn> columns, RowFormat format, std::FILE* out = stdout,
+              size_t flush_rows = DEFAULT_FLUSH_ROWS);
+    ~RowWriter();
+
+    RowWriter(const RowWriter&) = delete;
+    RowWriter& operator=(const RowWriter&) = delete;
+
+    /**
+     * @brief "auto", "table", "tsv" or "jsonl"; false for anything else
+     */
+    static bool parse_format(const std::string& name, std::FILE* out, RowFormat& format);
+
+    static bool is_terminal(std::FILE* out);
+
+    /**
+     * @brief Column names (TABLE and TSV); JSONL has none
+     */
+    void header();
+
+    /**
+     * @brief One row; missing trailing cells are empty
+     */
+    void row(const std::vector<std::string_view>& cells);
+
+    /**
+     * @brief A line formatted by the caller, kept in order with the rows
+     */
+    void line(std::string_view text);
+
+    /**
+     * @brief Write out buffered rows
+     * @return false once a write has failed (e.g. a closed pipe)
+     */
+    bool flush();
+
+    RowFormat format() const { return format_; }
+    size_t rows() const { return rows_; }
+
+private:
+    void row_done();
+
+    std::vector<RowColumn> columns_;
+    RowFormat format_;
+    std::FILE* out_;
+    size_t flush_rows_;
+    std::string buffer_;
+    size_t pending_ = 0;
+    size_t rows_ = 0;
+    bool failed_ = false;
+};
+
+} // namespace utils
+} // namespace filevault
+
+#endif // FILEVAULT_UTILS_ROW_WRITER_HPP
@@ -0,0 +1,63 @@
+#ifndef FILEVAULT_UTILS_RUN_STATS_HPP
+#define FILEVAULT_UTILS_RUN_STATS_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace filevault {
+namespace utils {
+
+/**
+ * @brief Totals of one CLI run for --stats json
+ *
+ * Commands add the bytes, files and chunks they processed; stage
+ * durations come from the tracing spans of the run, so only Tracer has
+ * to be running. Stage times are summed over threads and can exceed the
+ * wall time of a parallel run.
+ */
+class RunStats {
+public:
+    static RunStats& instance();
+
+    void add_bytes(uint64_t bytes_in, uint64_t bytes_out);
+    void add_files(uint64_t files);
+    void add_chunks(uint64_t chunks);
+
+    /**
+     * @brief Cipher of the run, as named by CryptoEngine::algorithm_name
+     *
+     * Set when a key is derived for it; the last one wins in a run that
+     * mixes algorithms. Empty when the run derived no key.
+     */
+    void set_algorithm(const std::string& algorithm);
+    std::string algorithm() const;
+
+    uint64_t bytes_in() const { return bytes_in_.load(std::memory_order_relaxed); }
+    uint64_t bytes_out() const { return bytes_out_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief One-line JSON object with the totals, stages and peak RSS
+     * @param wall_ms Duration of the command
+     */
+    std::string to_json(const std::string& command, int exit_code, double wall_ms) const;
+
+    void reset();
+
+private:
+    RunStats() = default;
+
+    std::atomic<uint64_t> bytes_in_{0};
+    std::atomic<uint64_t> bytes_out_{0};
+    std::atomic<uint64_t> files_{0};
+    std::atomic<uint64_t> chunks_{0};
+
+    mutable std::mutex algorithm_mutex_;
+    std::string algorithm_;
+};
+
+} // namespace utils
+} // namespace filevault
+
+#endif // FILEVAULT_UTILS_RUN_STATS_HPP
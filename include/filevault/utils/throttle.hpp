@@ -0,0 +1,87 @@
+#ifndef FILEVAULT_UTILS_THROTTLE_HPP
+#define FILEVAULT_UTILS_THROTTLE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace filevault {
+namespace utils {
+
+/**
+ * @brief Token bucket limiting bytes per second (--rate-limit)
+ *
+ * A caller takes its bytes before the I/O and sleeps off whatever the
+ * bucket does not hold, so the tokens may go negative: a 16 MB chunk
+ * against a 2 MB bucket simply waits longer, and concurrent callers
+ * queue up behind each other's debt instead of all waking at once.
+ * The bucket holds a tenth of a second of tokens (at least 64 KiB),
+ * which bounds the burst after an idle period.
+ *
+ * With no rate set acquire() is one relaxed atomic load. Thread-safe.
+ */
+class RateLimiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @param bytes_per_second 0 = unlimited
+     */
+    explicit RateLimiter(uint64_t bytes_per_second = 0);
+
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+
+    /**
+     * @brief Read and write stages of the streaming pipeline, each limited separately
+     */
+    static RateLimiter& reads();
+    static RateLimiter& writes();
+
+    void set_rate(uint64_t bytes_per_second);
+    uint64_t rate() const { return rate_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Wait until bytes may go through
+     */
+    void acquire(uint64_t bytes);
+
+    /**
+     * @brief Take bytes at time now; returns how long the caller must wait
+     */
+    Clock::duration reserve(uint64_t bytes, Clock::time_point now);
+
+    /**
+     * @brief Total time callers were told to wait
+     */
+    Clock::duration throttled() const;
+
+private:
+    std::atomic<uint64_t> rate_{0};
+    mutable std::mutex mutex_;
+    double tokens_ = 0.0;           // May be negative: bytes granted ahead of the rate
+    double capacity_ = 0.0;
+    Clock::time_point last_{};
+    Clock::duration throttled_{0};
+};
+
+/**
+ * @brief Lower this process's CPU and I/O priority (--background)
+ *
+ * Linux: nice 19 and the idle I/O class (ioprio_set), which only the
+ * BFQ and CFQ schedulers honour. macOS: the Darwin background band.
+ * Windows: PROCESS_MODE_BACKGROUND_BEGIN (CPU, I/O and memory priority).
+ * On Linux both settings are per thread and inherited by threads created
+ * afterwards, so this runs at startup, before any worker exists.
+ *
+ * @param detail Set to what was applied, or why not
+ * @return false if nothing could be lowered
+ */
+bool enter_background_mode(std::string& detail);
+
+} // namespace utils
+} // namespace filevault
+
+#endif // FILEVAULT_UTILS_THROTTLE_HPP
@@ -0,0 +1,124 @@
+#ifndef FILEVAULT_UTILS_TRACE_HPP
+#define FILEVAULT_UTILS_TRACE_HPP
+
+#include "filevault/utils/alloc_stats.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace filevault {
+namespace utils {
+
+/**
+ * @brief Process-wide collector of timed spans for --trace
+ *
+ * Spans are kept in memory while tracing is on and written as Chrome
+ * trace-event JSON, which chrome://tracing and ui.perfetto.dev open.
+ * While tracing is off a span costs one relaxed atomic load; building
+ * with FILEVAULT_NO_TRACING removes even that.
+ */
+class Tracer {
+public:
+    struct Span {
+        const char* name;
+        const char* category;
+        uint32_t thread;
+        int64_t start_us;               // Since start()
+        int64_t duration_us;
+        uint64_t bytes;                 // 0 = not recorded
+        AllocCounters allocs;           // Heap use on the span's thread (ENABLE_ALLOC_STATS)
+    };
+
+    static Tracer& instance();
+
+    static bool enabled() {
+#ifdef FILEVAULT_NO_TRACING
+        return false;
+#else
+        return enabled_.load(std::memory_order_relaxed);
+#endif
+    }
+
+    /**
+     * @brief Discard earlier spans and start recording
+     */
+    void start();
+    void stop();
+
+    void record(const char* name, const char* category,
+                std::chrono::steady_clock::time_point start,
+                std::chrono::steady_clock::time_point end, uint64_t bytes,
+                AllocCounters allocs = {});
+
+    std::vector<Span> spans() const;
+
+    /**
+     * @brief Write the recorded spans as {"traceEvents": [...]}
+     * @return false if the file cannot be written
+     */
+    bool write(const std::string& path) const;
+
+private:
+    Tracer() = default;
+
+    static inline std::atomic<bool> enabled_{false};
+
+    mutable std::mutex mutex_;
+    std::vector<Span> spans_;
+    std::chrono::steady_clock::time_point epoch_;
+};
+
+/**
+ * @brief RAII span from construction to destruction
+ *
+ * name and category must outlive the tracer (string literals). bytes is
+ * shown as an argument of the span, e.g. the size of a chunk. With the
+ * counting allocator, the allocations the thread made inside the span
+ * are recorded too.
+ */
+class ScopedSpan {
+public:
+    ScopedSpan(const char* name, const char* category, uint64_t bytes = 0) {
+        if (Tracer::enabled()) {
+            name_ = name;
+            category_ = category;
+            bytes_ = bytes;
+            allocs_ = AllocStats::thread();
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~ScopedSpan() {
+        if (name_) {
+            auto end = std::chrono::steady_clock::now();
+            AllocCounters allocs = AllocStats::thread();
+            allocs.allocations -= allocs_.allocations;
+            allocs.bytes -= allocs_.bytes;
+            Tracer::instance().record(name_, category_, start_, end, bytes_, allocs);
+        }
+    }
+
+    ScopedSpan(const ScopedSpan&) = delete;
+    ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+    /**
+     * @brief Set the size once it is known (e.g. after a read)
+     */
+    void set_bytes(uint64_t bytes) { bytes_ = bytes; }
+
+private:
+    const char* name_ = nullptr;        // Null while tracing is off
+    const char* category_ = nullptr;
+    uint64_t bytes_ = 0;
+    AllocCounters allocs_;              // Thread totals at the start
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace utils
+} // namespace filevault
+
+#endif // FILEVAULT_UTILS_TRACE_HPP
@@ -0,0 +1,32 @@
+#ifndef FILEVAULT_VOLUME_FUSE_MOUNT_HPP
+#define FILEVAULT_VOLUME_FUSE_MOUNT_HPP
+
+#include "filevault/core/result.hpp"
+#include <string>
+
+namespace filevault {
+namespace volume {
+
+class Volume;
+
+/**
+ * @brief Whether this build can mount volumes (built with ENABLE_FUSE)
+ */
+bool fuse_available();
+
+/**
+ * @brief Serve an unlocked volume through FUSE until unmounted
+ *
+ * The mount point holds a single file, "volume", with the decrypted
+ * contents. Put a filesystem on it and loop-mount it, e.g.
+ * `mkfs.ext4 mnt/volume && sudo mount -o loop mnt/volume /mnt/secret`.
+ * Blocks in the foreground; unmount with `fusermount3 -u <mountpoint>`.
+ *
+ * @return Error if FUSE is unavailable or the mount fails
+ */
+core::Result<void> mount_fuse(Volume& volume, const std::string& mountpoint, bool allow_other = false);
+
+} // namespace volume
+} // namespace filevault
+
+#endif // FILEVAULT_VOLUME_FUSE_MOUNT_HPP
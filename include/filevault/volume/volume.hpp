@@ -0,0 +1,215 @@
+#ifndef FILEVAULT_VOLUME_VOLUME_HPP
+#define FILEVAULT_VOLUME_VOLUME_HPP
+
+#include "filevault/algorithms/symmetric/aes_xts.hpp"
+#include "filevault/core/result.hpp"
+#include "filevault/core/secure_arena.hpp"
+#include "filevault/core/types.hpp"
+#include "filevault/utils/file_io.hpp"
+#include <botan/secmem.h>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace filevault {
+namespace core {
+class ThreadPool;
+} // namespace core
+
+namespace volume {
+
+/**
+ * @brief Settings fixed when a volume is created
+ */
+struct VolumeConfig {
+    core::KDFType kdf = core::KDFType::ARGON2ID;
+    core::SecurityLevel level = core::SecurityLevel::MEDIUM;
+    size_t sector_size = 4096;
+};
+
+/**
+ * @brief Sector cache counters since the volume was unlocked
+ */
+struct CacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t sectors_written = 0;   // Sectors encrypted and written to the container
+};
+
+/**
+ * @brief Fixed-size encrypted container with random access to its sectors
+ *
+ * Layout: a header sector, then the sectors, each encrypted on its own
+ * with AES-256-XTS (XtsSectorCipher) under a random master key. The
+ * header holds the settings, the KDF salt and the master key sealed with
+ * AES-256-GCM under the password-derived key, with the settings as
+ * associated data (a LUKS-style key slot). A wrong password or an edited
+ * header fails the tag check. Changing the password only rewrites the
+ * key slot.
+ *
+ * XTS is not authenticated: a tampered sector decrypts to garbage, not
+ * to an error. Sectors never written read back as pseudo-random data
+ * (the container is created sparse, and zeros do not decrypt to zeros).
+ *
+ * Recently used sectors are kept decrypted in an LRU cache; writes
+ * smaller than a few sectors collect there and are encrypted and written
+ * back in sorted, contiguous runs on flush() or eviction. Large reads
+ * and writes bypass the cache and are spread over a thread pool.
+ * All calls are serialized by an internal mutex.
+ */
+class Volume {
+public:
+    static constexpr size_t HEADER_SIZE = 4096;
+    static constexpr size_t DEFAULT_CACHE_BYTES = 16 * 1024 * 1024;
+
+    /**
+     * @param path Container file (created by create())
+     */
+    explicit Volume(std::filesystem::path path);
+    ~Volume();
+
+    Volume(const Volume&) = delete;
+    Volume& operator=(const Volume&) = delete;
+
+    /**
+     * @brief Create a new container of size bytes and unlock it
+     * @param size Rounded up to whole sectors
+     * @return Error if the file already exists
+     */
+    core::Result<void> create(const std::string& password, uint64_t size, const VolumeConfig& config);
+
+    /**
+     * @brief Read an existing container's settings (no password needed)
+     */
+    core::Result<void> open();
+
+    /**
+     * @brief Open an existing container for reading and writing sectors
+     * @return Error for a missing container or a wrong password
+     */
+    core::Result<void> unlock(const std::string& password, bool read_only = false);
+
+    /**
+     * @brief Re-seal the master key under a new password
+     *
+     * The sectors are untouched; the header is rewritten in place and synced.
+     */
+    core::Result<void> change_password(const std::string& new_password);
+
+    /**
+     * @brief Read whole sectors
+     * @param data A multiple of sector_size() bytes
+     */
+    core::Result<void> read_sectors(uint64_t first_sector, std::span<uint8_t> data);
+
+    /**
+     * @brief Write whole sectors (see read_sectors())
+     */
+    core::Result<void> write_sectors(uint64_t first_sector, std::span<const uint8_t> data);
+
+    /**
+     * @brief Read any byte range of the volume
+     */
+    core::Result<void> read(uint64_t offset, std::span<uint8_t> data);
+
+    /**
+     * @brief Write any byte range of the volume
+     *
+     * Partly covered sectors are read, patched and written back.
+     */
+    core::Result<void> write(uint64_t offset, std::span<const uint8_t> data);
+
+    /**
+     * @brief Write back cached sectors and sync the container
+     */
+    core::Result<void> flush();
+
+    /**
+     * @brief Bound the sector cache (takes effect on the next access)
+     */
+    void set_cache_bytes(size_t bytes);
+
+    /**
+     * @brief Workers for large reads and writes (0 = one per core)
+     */
+    void set_threads(size_t threads);
+
+    /**
+     * @brief Whether a file starts with a volume header
+     */
+    static bool is_volume(const std::filesystem::path& path);
+
+    const VolumeConfig& config() const { return config_; }
+    size_t sector_size() const { return config_.sector_size; }
+    uint64_t sector_count() const { return sector_count_; }
+    uint64_t size() const { return sector_count_ * config_.sector_size; }
+    uint64_t data_offset() const { return data_offset_; }
+    const std::filesystem::path& path() const { return path_; }
+    bool unlocked() const { return cipher_ != nullptr; }
+    bool read_only() const { return read_only_; }
+    CacheStats cache_stats() const;
+
+private:
+    struct CachedSector {
+        uint64_t sector = 0;
+        Botan::secure_vector<uint8_t> data;
+        bool dirty = false;
+    };
+    using CacheList = std::list<CachedSector>;
+
+    /**
+     * @brief Settings and salt as stored in the header; associated data of the key slot
+     */
+    std::vector<uint8_t> header_prefix(const std::vector<uint8_t>& salt) const;
+
+    /**
+     * @brief Seal master_key_ under password into a full header sector
+     */
+    core::Result<std::vector<uint8_t>> seal_header(const std::string& password,
+                                                   const std::vector<uint8_t>& salt) const;
+
+    std::vector<uint8_t> derive_slot_key(const std::string& password, const std::vector<uint8_t>& salt) const;
+
+    core::Result<void> check_range(uint64_t offset, size_t bytes, bool writing) const;
+    core::Result<void> read_direct(uint64_t first_sector, std::span<uint8_t> data);
+    core::Result<void> write_direct(uint64_t first_sector, std::span<const uint8_t> data);
+    core::Result<void> read_locked(uint64_t first_sector, std::span<uint8_t> data);
+    core::Result<void> write_locked(uint64_t first_sector, std::span<const uint8_t> data);
+    core::Result<CacheList::iterator> load(uint64_t sector);
+    core::Result<void> insert(uint64_t sector, std::span<const uint8_t> data, bool dirty);
+    core::Result<void> make_room();
+    size_t cache_capacity() const;
+    core::Result<void> write_back();
+    core::ThreadPool* pool();
+
+    std::filesystem::path path_;
+    VolumeConfig config_;
+    uint64_t sector_count_ = 0;
+    uint64_t data_offset_ = 0;
+    std::vector<uint8_t> salt_;
+    std::vector<uint8_t> key_slot_;             // [nonce][sealed master key][tag]
+    core::SecureBytes master_key_;
+    std::unique_ptr<algorithms::symmetric::XtsSectorCipher> cipher_;
+    utils::RandomAccessFile file_;
+    bool read_only_ = false;
+
+    mutable std::mutex mutex_;
+    CacheList lru_;                             // Most recently used first
+    std::unordered_map<uint64_t, CacheList::iterator> index_;
+    size_t cache_bytes_ = DEFAULT_CACHE_BYTES;
+    size_t threads_ = 0;
+    std::unique_ptr<core::ThreadPool> pool_;    // Created on first large run
+    std::vector<uint8_t> scratch_;              // Ciphertext staging for writes
+    CacheStats stats_;
+};
+
+} // namespace volume
+} // namespace filevault
+
+#endif // FILEVAULT_VOLUME_VOLUME_HPP
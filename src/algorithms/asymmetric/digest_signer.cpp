@@ -0,0 +1,117 @@
+/**
+ * @file digest_signer.cpp
+ * @brief Detached signatures over SHA-256 file digests
+ */
+
+#include "filevault/algorithms/asymmetric/digest_signer.hpp"
+#include <botan/hash.h>
+#include <fstream>
+#include <stdexcept>
+
+namespace filevault {
+namespace algorithms {
+namespace asymmetric {
+
+namespace {
+
+constexpr size_t READ_BLOCK = 1024 * 1024;
+
+} // anonymous namespace
+
+DigestSigner::DigestSigner(LoadedKey key) : key_(std::move(key)) {
+    auto scheme = key_.valid() ? scheme_for(key_) : std::nullopt;
+    if (!scheme) {
+        throw std::invalid_argument(key_.valid()
+            ? key_.algorithm() + " keys cannot sign; use an RSA, ECDSA or Ed25519 key"
+            : "No key loaded");
+    }
+    scheme_ = *scheme;
+}
+
+std::optional<SignatureScheme> DigestSigner::scheme_for(const LoadedKey& key) {
+    auto algorithm = key.algorithm();
+    if (algorithm == "RSA") {
+        return SignatureScheme::RSA_PSS;
+    }
+    if (algorithm == "ECDSA") {
+        return SignatureScheme::ECDSA;
+    }
+    if (algorithm == "Ed25519") {
+        return SignatureScheme::ED25519;
+    }
+    return std::nullopt;
+}
+
+std::string DigestSigner::scheme_name(SignatureScheme scheme) {
+    switch (scheme) {
+        case SignatureScheme::RSA_PSS: return "RSA-PSS (SHA-256)";
+        case SignatureScheme::ECDSA:   return "ECDSA (SHA-256)";
+        case SignatureScheme::ED25519: return "Ed25519 (SHA-256 digest)";
+    }
+    return "unknown";
+}
+
+std::optional<SignatureScheme> DigestSigner::parse_scheme(const std::string& name) {
+    if (name == "rsa") {
+        return SignatureScheme::RSA_PSS;
+    }
+    if (name == "ecc" || name == "ecdsa") {
+        return SignatureScheme::ECDSA;
+    }
+    if (name == "ed25519") {
+        return SignatureScheme::ED25519;
+    }
+    return std::nullopt;
+}
+
+std::string DigestSigner::padding() const {
+    switch (scheme_) {
+        case SignatureScheme::RSA_PSS: return "PSSR_Raw(SHA-256)";   // Same salt length as EMSA-PSS(SHA-256)
+        case SignatureScheme::ECDSA:   return "Raw";
+        case SignatureScheme::ED25519: return "Pure";
+    }
+    return "";
+}
+
+std::vector<uint8_t> DigestSigner::digest(std::span<const uint8_t> data) {
+    auto hash = Botan::HashFunction::create_or_throw("SHA-256");
+    hash->update(data.data(), data.size());
+    auto result = hash->final();
+    return {result.begin(), result.end()};
+}
+
+std::vector<uint8_t> DigestSigner::digest_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    auto hash = Botan::HashFunction::create_or_throw("SHA-256");
+    std::vector<char> block(READ_BLOCK);
+    while (file) {
+        file.read(block.data(), static_cast<std::streamsize>(block.size()));
+        hash->update(reinterpret_cast<const uint8_t*>(block.data()), static_cast<size_t>(file.gcount()));
+    }
+    if (file.bad()) {
+        throw std::runtime_error("Read error in " + path);
+    }
+    auto result = hash->final();
+    return {result.begin(), result.end()};
+}
+
+std::vector<uint8_t> DigestSigner::sign(std::span<const uint8_t> digest) const {
+    if (digest.size() != DIGEST_SIZE) {
+        throw std::invalid_argument("Expected a SHA-256 digest");
+    }
+    return key_.sign(digest, padding());
+}
+
+bool DigestSigner::verify(std::span<const uint8_t> digest, std::span<const uint8_t> signature) const {
+    if (digest.size() != DIGEST_SIZE) {
+        return false;
+    }
+    return key_.verify(digest, signature, padding());
+}
+
+} // namespace asymmetric
+} // namespace algorithms
+} // namespace filevault
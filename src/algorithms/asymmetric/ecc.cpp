@@ -4,10 +4,14 @@
  */
 
 #include "filevault/algorithms/asymmetric/ecc.hpp"
-#include <botan/auto_rng.h>
+#include "filevault/algorithms/asymmetric/ephemeral_pool.hpp"
+#include "filevault/core/random.hpp"
+#include "filevault/core/thread_pool.hpp"
 #include <botan/pkcs8.h>
 #include <botan/x509_key.h>
 #include <botan/pubkey.h>
+#include <botan/ed25519.h>
+#include <botan/x25519.h>
 #include <botan/kdf.h>
 #include <botan/cipher_mode.h>
 #include <botan/hex.h>
@@ -25,7 +29,8 @@ static std::string get_botan_curve_name(ECCurve curve) {
         case ECCurve::SECP256R1: return "secp256r1";
         case ECCurve::SECP384R1: return "secp384r1";
         case ECCurve::SECP521R1: return "secp521r1";
-        case ECCurve::X25519:    return "curve25519";
+        case ECCurve::X25519:    return "x25519";
+        case ECCurve::ED25519:   return "Ed25519";
         default: return "secp256r1";
     }
 }
@@ -36,6 +41,7 @@ static size_t get_curve_key_size(ECCurve curve) {
         case ECCurve::SECP384R1: return 48;
         case ECCurve::SECP521R1: return 66;
         case ECCurve::X25519:    return 32;
+        case ECCurve::ED25519:   return 32;
         default: return 32;
     }
 }
@@ -46,7 +52,10 @@ static size_t get_curve_key_size(ECCurve curve) {
 
 ECDH::ECDH(ECCurve curve) 
     : curve_(curve), botan_curve_name_(get_botan_curve_name(curve)) {
-    spdlog::debug("Created ECDH with curve {}", botan_curve_name_);
+    if (curve == ECCurve::ED25519) {
+        throw std::invalid_argument("Ed25519 is a signature curve, use X25519 for key exchange");
+    }
+    SPDLOG_DEBUG("Created ECDH with curve {}", botan_curve_name_);
 }
 
 std::string ECDH::name() const {
@@ -67,12 +76,16 @@ ECCKeyPair ECDH::generate_key_pair() {
     result.curve_name = botan_curve_name_;
     
     try {
-        Botan::AutoSeeded_RNG rng;
+        auto& rng = core::RandomService::rng();
         
         if (curve_ == ECCurve::X25519) {
-            // X25519 uses different key type - use PrivateKey interface
-            // Not implemented in this version - skip X25519 for now
-            throw std::runtime_error("X25519 not implemented yet");
+            Botan::X25519_PrivateKey private_key(rng);
+            
+            auto priv_encoded = Botan::PKCS8::BER_encode(private_key);
+            result.private_key.assign(priv_encoded.begin(), priv_encoded.end());
+            
+            auto pub_encoded = Botan::X509::BER_encode(private_key);
+            result.public_key.assign(pub_encoded.begin(), pub_encoded.end());
         } else {
             Botan::EC_Group group = Botan::EC_Group::from_name(botan_curve_name_);
             Botan::ECDH_PrivateKey private_key(rng, group);
@@ -84,7 +97,7 @@ ECCKeyPair ECDH::generate_key_pair() {
             result.public_key.assign(pub_encoded.begin(), pub_encoded.end());
         }
         
-        spdlog::debug("Generated ECDH key pair for curve {}", botan_curve_name_);
+        SPDLOG_DEBUG("Generated ECDH key pair for curve {}", botan_curve_name_);
     } catch (const std::exception& e) {
         spdlog::error("Failed to generate ECDH key pair: {}", e.what());
         throw;
@@ -97,38 +110,43 @@ ECDHResult ECDH::derive_shared_secret(
     std::span<const uint8_t> own_private_key,
     std::span<const uint8_t> peer_public_key
 ) {
+    auto own = LoadedKey::load(own_private_key);
+    auto peer = LoadedKey::load(peer_public_key);
+    if (!own || !peer) {
+        ECDHResult result;
+        result.success = false;
+        result.error_message = "ECDH error: " + (own ? peer.error_message : own.error_message);
+        return result;
+    }
+    return derive_shared_secret(own.value, peer.value);
+}
+
+ECDHResult ECDH::derive_shared_secret(const LoadedKey& own_private_key, const LoadedKey& peer_public_key) {
     ECDHResult result;
     result.success = false;
     
     try {
-        Botan::AutoSeeded_RNG rng;
-        
-        // Load private key
-        auto priv_key = Botan::PKCS8::load_key(
-            std::vector<uint8_t>(own_private_key.begin(), own_private_key.end())
-        );
-        
-        // Load public key
-        auto pub_key = Botan::X509::load_key(
-            std::vector<uint8_t>(peer_public_key.begin(), peer_public_key.end())
-        );
-        
-        // Create key agreement
-        Botan::PK_Key_Agreement ka(*priv_key, rng, "Raw");
-        
-        // Get peer's public value
-        auto peer_ecdh = dynamic_cast<Botan::ECDH_PublicKey*>(pub_key.get());
-        if (!peer_ecdh) {
+        // Get peer's public value (EC point or 32-byte u-coordinate)
+        std::vector<uint8_t> peer_value;
+        if (auto peer_ecdh = dynamic_cast<const Botan::ECDH_PublicKey*>(&peer_public_key.public_key())) {
+            peer_value = peer_ecdh->public_value();
+        } else if (auto peer_x25519 = dynamic_cast<const Botan::X25519_PublicKey*>(&peer_public_key.public_key())) {
+            peer_value = peer_x25519->public_value();
+        } else {
             result.error_message = "Invalid peer public key type";
             return result;
         }
+        if ((curve_ == ECCurve::X25519) != (peer_value.size() == 32)) {
+            result.error_message = "Peer public key is for a different curve";
+            return result;
+        }
         
         // Derive shared secret
-        auto secret = ka.derive_key(key_size(), peer_ecdh->public_value()).bits_of();
+        auto secret = own_private_key.agree(peer_value, key_size(), "Raw");
         result.shared_secret.assign(secret.begin(), secret.end());
         result.success = true;
         
-        spdlog::debug("Derived ECDH shared secret ({} bytes)", result.shared_secret.size());
+        SPDLOG_DEBUG("Derived ECDH shared secret ({} bytes)", result.shared_secret.size());
         
     } catch (const std::exception& e) {
         result.error_message = std::string("ECDH error: ") + e.what();
@@ -144,10 +162,10 @@ ECDHResult ECDH::derive_shared_secret(
 
 ECDSA::ECDSA(ECCurve curve) 
     : curve_(curve), botan_curve_name_(get_botan_curve_name(curve)) {
-    if (curve == ECCurve::X25519) {
-        throw std::invalid_argument("X25519 is not supported for ECDSA, use Ed25519 instead");
+    if (curve == ECCurve::X25519 || curve == ECCurve::ED25519) {
+        throw std::invalid_argument("Curve25519 is not supported for ECDSA, use the Ed25519 class instead");
     }
-    spdlog::debug("Created ECDSA with curve {}", botan_curve_name_);
+    SPDLOG_DEBUG("Created ECDSA with curve {}", botan_curve_name_);
 }
 
 std::string ECDSA::name() const {
@@ -173,7 +191,7 @@ ECCKeyPair ECDSA::generate_key_pair() {
     result.curve_name = botan_curve_name_;
     
     try {
-        Botan::AutoSeeded_RNG rng;
+        auto& rng = core::RandomService::rng();
         Botan::EC_Group group = Botan::EC_Group::from_name(botan_curve_name_);
         Botan::ECDSA_PrivateKey private_key(rng, group);
         
@@ -183,7 +201,7 @@ ECCKeyPair ECDSA::generate_key_pair() {
         auto pub_encoded = Botan::X509::BER_encode(private_key);
         result.public_key.assign(pub_encoded.begin(), pub_encoded.end());
         
-        spdlog::debug("Generated ECDSA key pair for curve {}", botan_curve_name_);
+        SPDLOG_DEBUG("Generated ECDSA key pair for curve {}", botan_curve_name_);
     } catch (const std::exception& e) {
         spdlog::error("Failed to generate ECDSA key pair: {}", e.what());
         throw;
@@ -196,26 +214,26 @@ ECDSASignResult ECDSA::sign(
     std::span<const uint8_t> data,
     std::span<const uint8_t> private_key
 ) {
+    auto loaded = LoadedKey::load(private_key);
+    if (!loaded) {
+        ECDSASignResult result;
+        result.success = false;
+        result.error_message = "ECDSA sign error: " + loaded.error_message;
+        return result;
+    }
+    return sign(data, loaded.value);
+}
+
+ECDSASignResult ECDSA::sign(std::span<const uint8_t> data, const LoadedKey& private_key) {
     ECDSASignResult result;
     result.success = false;
     
     try {
-        Botan::AutoSeeded_RNG rng;
-        
-        // Load private key
-        auto priv_key = Botan::PKCS8::load_key(
-            std::vector<uint8_t>(private_key.begin(), private_key.end())
-        );
-        
-        // Create signer
-        Botan::PK_Signer signer(*priv_key, rng, "SHA-256");
-        
-        // Sign
-        auto sig = signer.sign_message(data.data(), data.size(), rng);
+        auto sig = private_key.sign(data, "SHA-256");
         result.signature.assign(sig.begin(), sig.end());
         result.success = true;
         
-        spdlog::debug("ECDSA signed {} bytes, signature {} bytes", 
+        SPDLOG_DEBUG("ECDSA signed {} bytes, signature {} bytes", 
                       data.size(), result.signature.size());
         
     } catch (const std::exception& e) {
@@ -231,30 +249,131 @@ bool ECDSA::verify(
     std::span<const uint8_t> signature,
     std::span<const uint8_t> public_key
 ) {
+    auto loaded = LoadedKey::load(public_key);
+    if (!loaded) {
+        spdlog::error("ECDSA verify failed: {}", loaded.error_message);
+        return false;
+    }
+    return verify(data, signature, loaded.value);
+}
+
+bool ECDSA::verify(std::span<const uint8_t> data, std::span<const uint8_t> signature, const LoadedKey& public_key) {
     try {
-        // Load public key
-        auto pub_key = Botan::X509::load_key(
-            std::vector<uint8_t>(public_key.begin(), public_key.end())
-        );
+        bool valid = public_key.verify(data, signature, "SHA-256");
+        SPDLOG_DEBUG("ECDSA verification: {}", valid ? "valid" : "invalid");
+        return valid;
         
-        // Create verifier
-        Botan::PK_Verifier verifier(*pub_key, "SHA-256");
+    } catch (const std::exception& e) {
+        spdlog::error("ECDSA verify failed: {}", e.what());
+        return false;
+    }
+}
+
+ECDSASignResult ECDSA::sign_file(const std::string& path, const LoadedKey& private_key) {
+    ECDSASignResult result;
+    result.success = false;
+    
+    try {
+        result.signature = private_key.sign_file(path, "SHA-256");
+        result.success = true;
+    } catch (const std::exception& e) {
+        result.error_message = std::string("ECDSA sign error: ") + e.what();
+        spdlog::error("ECDSA sign failed: {}", e.what());
+    }
+    
+    return result;
+}
+
+bool ECDSA::verify_file(const std::string& path, std::span<const uint8_t> signature, const LoadedKey& public_key) {
+    try {
+        return public_key.verify_file(path, signature, "SHA-256");
+    } catch (const std::exception& e) {
+        spdlog::error("ECDSA verify failed: {}", e.what());
+        return false;
+    }
+}
+
+// ============================================================================
+// Ed25519 Implementation
+// ============================================================================
+
+ECCKeyPair Ed25519::generate_key_pair() {
+    ECCKeyPair result;
+    result.curve = ECCurve::ED25519;
+    result.curve_name = name();
+    
+    try {
+        Botan::Ed25519_PrivateKey private_key(core::RandomService::rng());
         
-        // Verify
-        bool valid = verifier.verify_message(
-            data.data(), data.size(),
-            signature.data(), signature.size()
-        );
+        auto priv_encoded = Botan::PKCS8::BER_encode(private_key);
+        result.private_key.assign(priv_encoded.begin(), priv_encoded.end());
         
-        spdlog::debug("ECDSA verification: {}", valid ? "valid" : "invalid");
-        return valid;
+        auto pub_encoded = Botan::X509::BER_encode(private_key);
+        result.public_key.assign(pub_encoded.begin(), pub_encoded.end());
         
+        SPDLOG_DEBUG("Generated Ed25519 key pair");
     } catch (const std::exception& e) {
-        spdlog::error("ECDSA verify failed: {}", e.what());
+        spdlog::error("Failed to generate Ed25519 key pair: {}", e.what());
+        throw;
+    }
+    
+    return result;
+}
+
+ECDSASignResult Ed25519::sign(std::span<const uint8_t> data, const LoadedKey& private_key) {
+    ECDSASignResult result;
+    result.success = false;
+    
+    try {
+        auto sig = private_key.sign(data, "Pure");
+        result.signature.assign(sig.begin(), sig.end());
+        result.success = true;
+    } catch (const std::exception& e) {
+        result.error_message = std::string("Ed25519 sign error: ") + e.what();
+        spdlog::error("Ed25519 sign failed: {}", e.what());
+    }
+    
+    return result;
+}
+
+bool Ed25519::verify(std::span<const uint8_t> data, std::span<const uint8_t> signature, const LoadedKey& public_key) {
+    try {
+        return public_key.verify(data, signature, "Pure");
+    } catch (const std::exception& e) {
+        spdlog::error("Ed25519 verify failed: {}", e.what());
         return false;
     }
 }
 
+std::vector<std::vector<uint8_t>> Ed25519::sign_batch(
+    const LoadedKey& private_key,
+    const std::vector<std::vector<uint8_t>>& messages,
+    size_t threads
+) const {
+    std::vector<std::vector<uint8_t>> signatures(messages.size());
+    core::parallel_for(messages.size(), threads, [&](size_t i) {
+        signatures[i] = private_key.sign(messages[i], "Pure");
+    });
+    return signatures;
+}
+
+std::vector<bool> Ed25519::verify_batch(
+    const LoadedKey& public_key,
+    const std::vector<std::vector<uint8_t>>& messages,
+    const std::vector<std::vector<uint8_t>>& signatures,
+    size_t threads
+) const {
+    if (messages.size() != signatures.size()) {
+        throw std::invalid_argument("verify_batch needs one signature per message");
+    }
+    // Bytes, not vector<bool>: workers write neighbouring slots concurrently
+    std::vector<uint8_t> valid(messages.size(), 0);
+    core::parallel_for(messages.size(), threads, [&](size_t i) {
+        valid[i] = public_key.verify(messages[i], signatures[i], "Pure") ? 1 : 0;
+    });
+    return std::vector<bool>(valid.begin(), valid.end());
+}
+
 // ============================================================================
 // ECCHybrid Implementation (ECDH + AES-GCM)
 // ============================================================================
@@ -274,11 +393,14 @@ ECCHybrid::ECCHybrid(ECCurve curve)
         case ECCurve::SECP521R1:
             type_ = core::AlgorithmType::ECC_P521;
             break;
+        case ECCurve::X25519:
+            type_ = core::AlgorithmType::ECC_X25519;
+            break;
         default:
             type_ = core::AlgorithmType::ECC_P256;
     }
     
-    spdlog::debug("Created ECCHybrid with curve {}", botan_curve_name_);
+    SPDLOG_DEBUG("Created ECCHybrid with curve {}", botan_curve_name_);
 }
 
 std::string ECCHybrid::name() const {
@@ -297,6 +419,13 @@ ECCKeyPair ECCHybrid::generate_key_pair() {
     return ecdh_.generate_key_pair();
 }
 
+void ECCHybrid::set_ephemeral_pool(std::shared_ptr<EphemeralKeyPool> pool) {
+    if (pool && pool->curve() != curve_) {
+        throw std::invalid_argument("Ephemeral key pool is for a different curve");
+    }
+    ephemeral_pool_ = std::move(pool);
+}
+
 core::CryptoResult ECCHybrid::encrypt(
     std::span<const uint8_t> plaintext,
     std::span<const uint8_t> key,  // Recipient's public key
@@ -306,13 +435,26 @@ core::CryptoResult ECCHybrid::encrypt(
     core::CryptoResult result;
     
     try {
-        Botan::AutoSeeded_RNG rng;
-        
-        // Generate ephemeral key pair
-        auto ephemeral = ecdh_.generate_key_pair();
-        
-        // Derive shared secret with recipient's public key
-        auto dh_result = ecdh_.derive_shared_secret(ephemeral.private_key, key);
+        auto& rng = core::RandomService::rng();
+        
+        // Ephemeral key pair: pregenerated if a pool is set, single use either way
+        std::vector<uint8_t> ephemeral_public;
+        ECDHResult dh_result;
+        if (ephemeral_pool_) {
+            auto ephemeral = ephemeral_pool_->take();
+            auto recipient = LoadedKey::load(key);
+            if (!recipient) {
+                result.success = false;
+                result.error_message = "Failed to derive shared secret: " + recipient.error_message;
+                return result;
+            }
+            dh_result = ecdh_.derive_shared_secret(ephemeral.private_key, recipient.value);
+            ephemeral_public = std::move(ephemeral.public_key);
+        } else {
+            auto ephemeral = ecdh_.generate_key_pair();
+            dh_result = ecdh_.derive_shared_secret(ephemeral.private_key, key);
+            ephemeral_public = std::move(ephemeral.public_key);
+        }
         if (!dh_result.success) {
             result.success = false;
             result.error_message = "Failed to derive shared secret: " + dh_result.error_message;
@@ -340,7 +482,7 @@ core::CryptoResult ECCHybrid::encrypt(
         cipher->finish(buffer);
         
         // Output format: ephemeral_public_key || nonce || ciphertext+tag
-        size_t pub_key_len = ephemeral.public_key.size();
+        size_t pub_key_len = ephemeral_public.size();
         result.data.reserve(2 + pub_key_len + nonce.size() + buffer.size());
         
         // Store public key length (2 bytes, big-endian)
@@ -349,7 +491,7 @@ core::CryptoResult ECCHybrid::encrypt(
         
         // Store ephemeral public key
         result.data.insert(result.data.end(), 
-                          ephemeral.public_key.begin(), ephemeral.public_key.end());
+                          ephemeral_public.begin(), ephemeral_public.end());
         
         // Store nonce
         result.data.insert(result.data.end(), nonce.begin(), nonce.end());
@@ -366,7 +508,7 @@ core::CryptoResult ECCHybrid::encrypt(
         auto end = std::chrono::high_resolution_clock::now();
         result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
         
-        spdlog::debug("ECCHybrid encryption: {} bytes -> {} bytes in {:.2f}ms",
+        SPDLOG_DEBUG("ECCHybrid encryption: {} bytes -> {} bytes in {:.2f}ms",
                       plaintext.size(), result.data.size(), result.processing_time_ms);
         
     } catch (const std::exception& e) {
@@ -453,7 +595,7 @@ core::CryptoResult ECCHybrid::decrypt(
         auto end = std::chrono::high_resolution_clock::now();
         result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
         
-        spdlog::debug("ECCHybrid decryption: {} bytes -> {} bytes in {:.2f}ms",
+        SPDLOG_DEBUG("ECCHybrid decryption: {} bytes -> {} bytes in {:.2f}ms",
                       ciphertext.size(), result.data.size(), result.processing_time_ms);
         
     } catch (const Botan::Invalid_Authentication_Tag& e) {
@@ -0,0 +1,96 @@
+/**
+ * @file ephemeral_pool.cpp
+ * @brief Background pool of pregenerated ephemeral ECDH key pairs
+ */
+
+#include "filevault/algorithms/asymmetric/ephemeral_pool.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace filevault {
+namespace algorithms {
+namespace asymmetric {
+
+EphemeralKeyPool::EphemeralKeyPool(ECCurve curve, size_t capacity)
+    : curve_(curve),
+      capacity_(std::max<size_t>(capacity, 1)),
+      ecdh_(curve) {
+    if (curve == ECCurve::ED25519) {
+        throw std::invalid_argument("Ephemeral key pool needs a key-agreement curve");
+    }
+    worker_ = std::thread(&EphemeralKeyPool::refill_loop, this);
+}
+
+EphemeralKeyPool::~EphemeralKeyPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    refill_cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    SPDLOG_DEBUG("Ephemeral key pool: {} pooled, {} inline", hits(), misses());
+}
+
+EphemeralKeyPool::Entry EphemeralKeyPool::generate() {
+    auto pair = ecdh_.generate_key_pair();
+    auto loaded = LoadedKey::load(pair.private_key);
+    if (!loaded) {
+        throw std::runtime_error("Ephemeral key pool: " + loaded.error_message);
+    }
+    return Entry{std::move(pair.public_key), std::move(loaded.value)};
+}
+
+EphemeralKeyPool::Entry EphemeralKeyPool::take() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!ready_.empty()) {
+            Entry entry = std::move(ready_.front());
+            ready_.pop_front();
+            if (ready_.size() < (capacity_ + 1) / 2) {
+                refill_cv_.notify_one();
+            }
+            hits_++;
+            return entry;
+        }
+    }
+    refill_cv_.notify_one();
+    misses_++;
+    return generate();
+}
+
+size_t EphemeralKeyPool::available() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ready_.size();
+}
+
+void EphemeralKeyPool::refill_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        if (ready_.size() >= capacity_) {
+            // Full: sleep until take() drains below the low watermark
+            refill_cv_.wait(lock, [this] {
+                return stopping_ || ready_.size() < (capacity_ + 1) / 2;
+            });
+            continue;
+        }
+
+        // Generate outside the lock so take() is never held up
+        lock.unlock();
+        try {
+            Entry entry = generate();
+            lock.lock();
+            ready_.push_back(std::move(entry));
+        } catch (const std::exception& e) {
+            spdlog::error("Ephemeral key pool refill failed: {}", e.what());
+            lock.lock();
+            stopping_ = true;   // take() still works, inline
+        }
+    }
+}
+
+} // namespace asymmetric
+} // namespace algorithms
+} // namespace filevault
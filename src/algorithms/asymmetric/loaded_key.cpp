@@ -0,0 +1,269 @@
+/**
+ * @file loaded_key.cpp
+ * @brief Parsed asymmetric key handle implementation
+ */
+
+#include "filevault/algorithms/asymmetric/loaded_key.hpp"
+#include "filevault/core/random.hpp"
+#include <botan/data_src.h>
+#include <botan/pkcs8.h>
+#include <botan/pubkey.h>
+#include <botan/x509_key.h>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace filevault {
+namespace algorithms {
+namespace asymmetric {
+
+namespace {
+
+// Operation objects are per thread and per padding (or KDF) string
+using OpKey = std::pair<std::thread::id, std::string>;
+
+template<typename Op>
+using OpMap = std::map<OpKey, std::unique_ptr<Op>>;
+
+constexpr size_t STREAM_BLOCK = 1024 * 1024;
+
+/**
+ * @brief Feed a file to a signer or verifier block by block
+ *
+ * Plain sequential reads, so the kernel's read-ahead fetches the next
+ * block while the current one is hashed.
+ */
+template<typename Op>
+void stream_file(const std::string& path, Op& op) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    std::vector<char> block(STREAM_BLOCK);
+    while (file) {
+        file.read(block.data(), static_cast<std::streamsize>(block.size()));
+        op.update(reinterpret_cast<const uint8_t*>(block.data()), static_cast<size_t>(file.gcount()));
+    }
+    if (file.bad()) {
+        throw std::runtime_error("Read error in " + path);
+    }
+}
+
+} // anonymous namespace
+
+struct LoadedKey::State {
+    std::unique_ptr<Botan::Private_Key> private_key;
+    std::unique_ptr<Botan::Public_Key> public_key;   // Only for public keys
+
+    std::mutex mutex;
+    OpMap<Botan::PK_Signer> signers;
+    OpMap<Botan::PK_Verifier> verifiers;
+    OpMap<Botan::PK_Encryptor_EME> encryptors;
+    OpMap<Botan::PK_Decryptor_EME> decryptors;
+    OpMap<Botan::PK_Key_Agreement> agreements;
+    OpMap<Botan::PK_KEM_Encryptor> kem_encryptors;
+    OpMap<Botan::PK_KEM_Decryptor> kem_decryptors;
+
+    const Botan::Public_Key& pub() const {
+        return private_key ? static_cast<const Botan::Public_Key&>(*private_key) : *public_key;
+    }
+
+    const Botan::Private_Key& priv() const {
+        if (!private_key) {
+            throw std::runtime_error("Operation needs a private key, got a public key");
+        }
+        return *private_key;
+    }
+
+    /**
+     * @brief Calling thread's operation object, created on first use
+     *
+     * Construction happens under the lock; it runs once per thread and
+     * padding, while the operation itself runs unlocked.
+     */
+    template<typename Op, typename Factory>
+    Op& get(OpMap<Op>& ops, std::string_view parameter, Factory make) {
+        OpKey key{std::this_thread::get_id(), std::string(parameter)};
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& slot = ops[key];
+        if (!slot) {
+            slot = make();
+        }
+        return *slot;
+    }
+};
+
+core::Result<LoadedKey> LoadedKey::load(std::span<const uint8_t> encoded) {
+    auto state = std::make_shared<State>();
+
+    // Private keys first: a PKCS#8 blob never parses as a public key
+    try {
+        Botan::DataSource_Memory source(encoded);
+        state->private_key = Botan::PKCS8::load_key(source);
+    } catch (const std::exception&) {
+        // Not a private key, try public
+    }
+
+    if (!state->private_key) {
+        try {
+            Botan::DataSource_Memory source(encoded);
+            state->public_key = Botan::X509::load_key(source);
+        } catch (const std::exception& e) {
+            return core::Result<LoadedKey>::error(std::string("Failed to load key: ") + e.what());
+        }
+        if (!state->public_key) {
+            return core::Result<LoadedKey>::error("Failed to load key");
+        }
+    }
+
+    LoadedKey key;
+    key.state_ = std::move(state);
+    return core::Result<LoadedKey>::ok(std::move(key));
+}
+
+core::Result<LoadedKey> LoadedKey::load_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return core::Result<LoadedKey>::error("Failed to open key file: " + path);
+    }
+    std::vector<uint8_t> encoded((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return load(encoded);
+}
+
+LoadedKey LoadedKey::from_private_key(std::unique_ptr<Botan::Private_Key> key) {
+    LoadedKey loaded;
+    if (key) {
+        loaded.state_ = std::make_shared<State>();
+        loaded.state_->private_key = std::move(key);
+    }
+    return loaded;
+}
+
+LoadedKey LoadedKey::from_public_key(std::unique_ptr<Botan::Public_Key> key) {
+    LoadedKey loaded;
+    if (key) {
+        loaded.state_ = std::make_shared<State>();
+        loaded.state_->public_key = std::move(key);
+    }
+    return loaded;
+}
+
+bool LoadedKey::is_private() const {
+    return state_ && state_->private_key != nullptr;
+}
+
+const Botan::Public_Key& LoadedKey::public_key() const {
+    if (!state_) {
+        throw std::logic_error("LoadedKey is empty");
+    }
+    return state_->pub();
+}
+
+const Botan::Private_Key& LoadedKey::private_key() const {
+    if (!state_) {
+        throw std::logic_error("LoadedKey is empty");
+    }
+    return state_->priv();
+}
+
+std::vector<uint8_t> LoadedKey::sign(std::span<const uint8_t> message, std::string_view padding,
+                                     bool der_signature) const {
+    const auto& key = private_key();
+    auto format = der_signature ? Botan::Signature_Format::DerSequence : Botan::Signature_Format::Standard;
+    auto& signer = state_->get(state_->signers, std::string(padding) + (der_signature ? "/der" : ""), [&]() {
+        return std::make_unique<Botan::PK_Signer>(key, core::RandomService::rng(), padding, format);
+    });
+    return signer.sign_message(message.data(), message.size(), core::RandomService::rng());
+}
+
+bool LoadedKey::verify(std::span<const uint8_t> message, std::span<const uint8_t> signature,
+                       std::string_view padding, bool der_signature) const {
+    const auto& key = public_key();
+    auto format = der_signature ? Botan::Signature_Format::DerSequence : Botan::Signature_Format::Standard;
+    auto& verifier = state_->get(state_->verifiers, std::string(padding) + (der_signature ? "/der" : ""), [&]() {
+        return std::make_unique<Botan::PK_Verifier>(key, padding, format);
+    });
+    try {
+        return verifier.verify_message(message.data(), message.size(), signature.data(), signature.size());
+    } catch (const Botan::Decoding_Error&) {
+        return false;   // Malformed signature encoding
+    }
+}
+
+// Streamed operations get their own signer: a read error part way through
+// must not leave half a message in the cached per-thread one
+std::vector<uint8_t> LoadedKey::sign_file(const std::string& path, std::string_view padding,
+                                          bool der_signature) const {
+    auto format = der_signature ? Botan::Signature_Format::DerSequence : Botan::Signature_Format::Standard;
+    Botan::PK_Signer signer(private_key(), core::RandomService::rng(), padding, format);
+    stream_file(path, signer);
+    return signer.signature(core::RandomService::rng());
+}
+
+bool LoadedKey::verify_file(const std::string& path, std::span<const uint8_t> signature,
+                            std::string_view padding, bool der_signature) const {
+    auto format = der_signature ? Botan::Signature_Format::DerSequence : Botan::Signature_Format::Standard;
+    Botan::PK_Verifier verifier(public_key(), padding, format);
+    stream_file(path, verifier);
+    try {
+        return verifier.check_signature(signature.data(), signature.size());
+    } catch (const Botan::Decoding_Error&) {
+        return false;   // Malformed signature encoding
+    }
+}
+
+std::vector<uint8_t> LoadedKey::encrypt(std::span<const uint8_t> plaintext, std::string_view padding) const {
+    const auto& key = public_key();
+    auto& encryptor = state_->get(state_->encryptors, padding, [&]() {
+        return std::make_unique<Botan::PK_Encryptor_EME>(key, core::RandomService::rng(), padding);
+    });
+    return encryptor.encrypt(plaintext.data(), plaintext.size(), core::RandomService::rng());
+}
+
+Botan::secure_vector<uint8_t> LoadedKey::decrypt(std::span<const uint8_t> ciphertext,
+                                                 std::string_view padding) const {
+    const auto& key = private_key();
+    auto& decryptor = state_->get(state_->decryptors, padding, [&]() {
+        return std::make_unique<Botan::PK_Decryptor_EME>(key, core::RandomService::rng(), padding);
+    });
+    return decryptor.decrypt(ciphertext.data(), ciphertext.size());
+}
+
+Botan::secure_vector<uint8_t> LoadedKey::agree(std::span<const uint8_t> peer_public_value, size_t length,
+                                               std::string_view kdf) const {
+    const auto& key = private_key();
+    auto& agreement = state_->get(state_->agreements, kdf, [&]() {
+        return std::make_unique<Botan::PK_Key_Agreement>(key, core::RandomService::rng(), kdf);
+    });
+    return agreement.derive_key(length, peer_public_value).bits_of();
+}
+
+Encapsulation LoadedKey::encapsulate(size_t length, std::string_view kdf) const {
+    const auto& key = public_key();
+    auto& encryptor = state_->get(state_->kem_encryptors, kdf, [&]() {
+        return std::make_unique<Botan::PK_KEM_Encryptor>(key, kdf);
+    });
+    auto kem = encryptor.encrypt(core::RandomService::rng(), length);
+    const auto& encapsulated = kem.encapsulated_shared_key();
+    const auto& shared = kem.shared_key();
+    return Encapsulation{std::vector<uint8_t>(encapsulated.begin(), encapsulated.end()),
+                         Botan::secure_vector<uint8_t>(shared.begin(), shared.end())};
+}
+
+Botan::secure_vector<uint8_t> LoadedKey::decapsulate(std::span<const uint8_t> encapsulated_key, size_t length,
+                                                     std::string_view kdf) const {
+    const auto& key = private_key();
+    auto& decryptor = state_->get(state_->kem_decryptors, kdf, [&]() {
+        return std::make_unique<Botan::PK_KEM_Decryptor>(key, core::RandomService::rng(), kdf);
+    });
+    return decryptor.decrypt(encapsulated_key, length);
+}
+
+} // namespace asymmetric
+} // namespace algorithms
+} // namespace filevault
@@ -4,12 +4,11 @@
  */
 
 #include "filevault/algorithms/asymmetric/rsa.hpp"
-#include <botan/auto_rng.h>
+#include "filevault/core/random.hpp"
 #include <botan/rsa.h>
 #include <botan/pubkey.h>
 #include <botan/pkcs8.h>
 #include <botan/x509_key.h>
-#include <botan/data_src.h>
 #include <spdlog/spdlog.h>
 #include <chrono>
 
@@ -35,7 +34,7 @@ RSA::RSA(size_t key_bits) : key_bits_(key_bits) {
             break;
     }
     
-    spdlog::debug("Created RSA-{} algorithm", key_bits);
+    SPDLOG_DEBUG("Created RSA-{} algorithm", key_bits);
 }
 
 std::string RSA::name() const {
@@ -51,7 +50,7 @@ RSAKeyPair RSA::generate_key_pair() {
     key_pair.bits = key_bits_;
     
     try {
-        Botan::AutoSeeded_RNG rng;
+        auto& rng = core::RandomService::rng();
         Botan::RSA_PrivateKey private_key(rng, key_bits_);
         
         // Export private key as PKCS#8 PEM
@@ -62,7 +61,7 @@ RSAKeyPair RSA::generate_key_pair() {
         auto public_pem = Botan::X509::PEM_encode(private_key);
         key_pair.public_key.assign(public_pem.begin(), public_pem.end());
         
-        spdlog::debug("Generated RSA-{} key pair", key_bits_);
+        SPDLOG_DEBUG("Generated RSA-{} key pair", key_bits_);
         
     } catch (const std::exception& e) {
         spdlog::error("Failed to generate RSA key pair: {}", e.what());
@@ -77,6 +76,17 @@ core::CryptoResult RSA::encrypt(
     std::span<const uint8_t> key,
     [[maybe_unused]] const core::EncryptionConfig& config
 ) {
+    auto loaded = LoadedKey::load(key);
+    if (!loaded) {
+        core::CryptoResult result;
+        result.success = false;
+        result.error_message = "Failed to load RSA public key";
+        return result;
+    }
+    return encrypt(plaintext, loaded.value);
+}
+
+core::CryptoResult RSA::encrypt(std::span<const uint8_t> plaintext, const LoadedKey& key) {
     auto start = std::chrono::high_resolution_clock::now();
     core::CryptoResult result;
     
@@ -90,23 +100,8 @@ core::CryptoResult RSA::encrypt(
             return result;
         }
         
-        // Load public key
-        std::string key_pem(key.begin(), key.end());
-        Botan::DataSource_Memory key_source(key_pem);
-        auto public_key = Botan::X509::load_key(key_source);
-        
-        if (!public_key) {
-            result.success = false;
-            result.error_message = "Failed to load RSA public key";
-            return result;
-        }
-        
-        // Create encryptor with OAEP padding (SHA-256)
-        Botan::AutoSeeded_RNG rng;
-        Botan::PK_Encryptor_EME encryptor(*public_key, rng, "EME-OAEP(SHA-256)");
-        
-        // Encrypt
-        auto ciphertext = encryptor.encrypt(plaintext.data(), plaintext.size(), rng);
+        // OAEP padding (SHA-256)
+        auto ciphertext = key.encrypt(plaintext, "EME-OAEP(SHA-256)");
         
         result.data.assign(ciphertext.begin(), ciphertext.end());
         result.success = true;
@@ -117,7 +112,7 @@ core::CryptoResult RSA::encrypt(
         auto end = std::chrono::high_resolution_clock::now();
         result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
         
-        spdlog::debug("RSA encryption: {} bytes -> {} bytes", plaintext.size(), result.data.size());
+        SPDLOG_DEBUG("RSA encryption: {} bytes -> {} bytes", plaintext.size(), result.data.size());
         
     } catch (const std::exception& e) {
         result.success = false;
@@ -133,27 +128,23 @@ core::CryptoResult RSA::decrypt(
     std::span<const uint8_t> key,
     [[maybe_unused]] const core::EncryptionConfig& config
 ) {
+    auto loaded = LoadedKey::load(key);
+    if (!loaded || !loaded.value.is_private()) {
+        core::CryptoResult result;
+        result.success = false;
+        result.error_message = "Failed to load RSA private key";
+        return result;
+    }
+    return decrypt(ciphertext, loaded.value);
+}
+
+core::CryptoResult RSA::decrypt(std::span<const uint8_t> ciphertext, const LoadedKey& key) {
     auto start = std::chrono::high_resolution_clock::now();
     core::CryptoResult result;
     
     try {
-        // Load private key
-        std::string key_pem(key.begin(), key.end());
-        Botan::DataSource_Memory key_source(key_pem);
-        auto private_key = Botan::PKCS8::load_key(key_source);
-        
-        if (!private_key) {
-            result.success = false;
-            result.error_message = "Failed to load RSA private key";
-            return result;
-        }
-        
-        // Create decryptor with OAEP padding (SHA-256)
-        Botan::AutoSeeded_RNG rng;
-        Botan::PK_Decryptor_EME decryptor(*private_key, rng, "EME-OAEP(SHA-256)");
-        
-        // Decrypt
-        auto plaintext = decryptor.decrypt(ciphertext.data(), ciphertext.size());
+        // OAEP padding (SHA-256)
+        auto plaintext = key.decrypt(ciphertext, "EME-OAEP(SHA-256)");
         
         result.data.assign(plaintext.begin(), plaintext.end());
         result.success = true;
@@ -164,7 +155,7 @@ core::CryptoResult RSA::decrypt(
         auto end = std::chrono::high_resolution_clock::now();
         result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
         
-        spdlog::debug("RSA decryption: {} bytes -> {} bytes", ciphertext.size(), result.data.size());
+        SPDLOG_DEBUG("RSA decryption: {} bytes -> {} bytes", ciphertext.size(), result.data.size());
         
     } catch (const Botan::Decoding_Error& e) {
         result.success = false;
@@ -183,23 +174,17 @@ std::vector<uint8_t> RSA::sign(
     std::span<const uint8_t> data,
     std::span<const uint8_t> private_key
 ) {
+    auto loaded = LoadedKey::load(private_key);
+    if (!loaded || !loaded.value.is_private()) {
+        spdlog::error("RSA signing failed: cannot load private key");
+        throw std::runtime_error("Failed to load private key");
+    }
+    return sign(data, loaded.value);
+}
+
+std::vector<uint8_t> RSA::sign(std::span<const uint8_t> data, const LoadedKey& private_key) {
     try {
-        std::string key_pem(private_key.begin(), private_key.end());
-        Botan::DataSource_Memory key_source(key_pem);
-        auto priv_key = Botan::PKCS8::load_key(key_source);
-        
-        if (!priv_key) {
-            throw std::runtime_error("Failed to load private key");
-        }
-        
-        Botan::AutoSeeded_RNG rng;
-        Botan::PK_Signer signer(*priv_key, rng, "EMSA-PSS(SHA-256)");
-        
-        signer.update(data.data(), data.size());
-        auto signature = signer.signature(rng);
-        
-        return std::vector<uint8_t>(signature.begin(), signature.end());
-        
+        return private_key.sign(data, "EMSA-PSS(SHA-256)");
     } catch (const std::exception& e) {
         spdlog::error("RSA signing failed: {}", e.what());
         throw;
@@ -211,20 +196,34 @@ bool RSA::verify(
     std::span<const uint8_t> signature,
     std::span<const uint8_t> public_key
 ) {
+    auto loaded = LoadedKey::load(public_key);
+    if (!loaded) {
+        return false;
+    }
+    return verify(data, signature, loaded.value);
+}
+
+bool RSA::verify(std::span<const uint8_t> data, std::span<const uint8_t> signature, const LoadedKey& public_key) {
     try {
-        std::string key_pem(public_key.begin(), public_key.end());
-        Botan::DataSource_Memory key_source(key_pem);
-        auto pub_key = Botan::X509::load_key(key_source);
-        
-        if (!pub_key) {
-            return false;
-        }
-        
-        Botan::PK_Verifier verifier(*pub_key, "EMSA-PSS(SHA-256)");
-        verifier.update(data.data(), data.size());
-        
-        return verifier.check_signature(signature.data(), signature.size());
-        
+        return public_key.verify(data, signature, "EMSA-PSS(SHA-256)");
+    } catch (const std::exception& e) {
+        spdlog::warn("RSA verification failed: {}", e.what());
+        return false;
+    }
+}
+
+std::vector<uint8_t> RSA::sign_file(const std::string& path, const LoadedKey& private_key) {
+    try {
+        return private_key.sign_file(path, "EMSA-PSS(SHA-256)");
+    } catch (const std::exception& e) {
+        spdlog::error("RSA signing failed: {}", e.what());
+        throw;
+    }
+}
+
+bool RSA::verify_file(const std::string& path, std::span<const uint8_t> signature, const LoadedKey& public_key) {
+    try {
+        return public_key.verify_file(path, signature, "EMSA-PSS(SHA-256)");
     } catch (const std::exception& e) {
         spdlog::warn("RSA verification failed: {}", e.what());
         return false;
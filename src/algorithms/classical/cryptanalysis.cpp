@@ -0,0 +1,482 @@
+/**
+ * @file cryptanalysis.cpp
+ * @brief Parallel ciphertext-only attacks on Caesar, Vigenère and substitution
+ */
+
+#include "filevault/algorithms/classical/cryptanalysis.hpp"
+#include "filevault/algorithms/classical/caesar.hpp"
+#include "filevault/algorithms/classical/kernels.hpp"
+#include "filevault/algorithms/classical/vigenere.hpp"
+#include "filevault/core/thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+namespace filevault {
+namespace algorithms {
+namespace classical {
+
+namespace {
+
+// Letter frequencies of English text, percent
+constexpr std::array<double, 26> ENGLISH_FREQUENCY = {
+    8.167, 1.492, 2.782, 4.253, 12.702, 2.228, 2.015, 6.094, 6.966, 0.153, 0.772, 4.025, 2.406,
+    6.749, 7.507, 1.929, 0.095, 5.987, 6.327, 9.056, 2.758, 0.978, 2.360, 0.150, 1.974, 0.074
+};
+
+// Letters from most to least frequent, the substitution starting guess
+constexpr const char* FREQUENCY_ORDER = "ETAOINSHRDLCUMWFGYPBVKJXQZ";
+
+// 100 * log10 P(second | first) of letter pairs, row = first letter;
+// counted over Newton's Opticks and the GPL/Apache/MPL license texts
+constexpr int16_t ENGLISH_BIGRAMS[26 * 26] = {
+    -412, -281, -233, -267, -497, -313, -286, -410, -276, -442, -302, -217, -266, -176, -411, -267, -401, -208, -218, -198, -327, -300, -334, -376, -256, -497,  // A
+    -348, -378, -392, -421, -225, -497, -505, -444, -318, -346, -601, -258, -469, -497, -270, -483, -553, -307, -310, -397, -283, -505, -483, -473, -247, -601,  // B
+    -269, -410, -322, -422, -224, -449, -497, -237, -269, -489, -298, -288, -483, -458, -210, -427, -442, -315, -412, -234, -286, -553, -465, -553, -435, -601,  // C
+    -253, -268, -317, -304, -225, -307, -336, -346, -216, -439, -465, -303, -320, -335, -260, -311, -427, -308, -273, -234, -313, -342, -292, -505, -331, -531,  // D
+    -203, -259, -216, -200, -237, -219, -273, -308, -228, -446, -344, -237, -242, -196, -234, -240, -308, -169, -182, -206, -332, -281, -259, -271, -275, -483,  // E
+    -257, -371, -344, -403, -283, -305, -354, -403, -250, -516, -497, -279, -374, -394, -240, -377, -469, -235, -331, -211, -344, -394, -343, -601, -353, -553,  // F
+    -294, -365, -386, -399, -257, -373, -376, -247, -287, -601, -516, -277, -357, -340, -304, -367, -478, -262, -305, -284, -327, -432, -367, -516, -442, -601,  // G
+    -210, -354, -349, -359, -150, -368, -408, -404, -216, -497, -516, -389, -356, -376, -249, -346, -473, -303, -342, -237, -350, -418, -337, -601, -368, -516,  // H
+    -301, -282, -226, -262, -271, -262, -247, -374, -374, -601, -341, -256, -269, -174, -219, -341, -345, -242, -208, -204, -342, -291, -422, -322, -553, -393,  // I
+    -430, -531, -553, -516, -342, -601, -601, -601, -553, -601, -516, -601, -601, -601, -435, -531, -601, -601, -531, -497, -424, -601, -601, -601, -601, -601,  // J
+    -354, -413, -388, -446, -290, -425, -452, -461, -324, -601, -489, -390, -427, -321, -387, -410, -497, -410, -339, -373, -437, -483, -417, -516, -458, -601,  // K
+    -236, -319, -354, -295, -211, -335, -395, -414, -222, -531, -449, -228, -347, -391, -238, -328, -483, -353, -295, -282, -275, -350, -364, -553, -257, -601,  // L
+    -236, -314, -389, -382, -225, -386, -437, -416, -259, -553, -516, -417, -340, -382, -251, -294, -483, -407, -302, -283, -310, -435, -356, -531, -376, -601,  // M
+    -247, -315, -236, -189, -225, -306, -213, -380, -255, -469, -407, -322, -342, -325, -230, -328, -421, -363, -224, -193, -312, -327, -317, -531, -287, -553,  // N
+    -292, -267, -305, -276, -346, -191, -310, -378, -299, -497, -343, -240, -235, -190, -292, -261, -473, -202, -250, -219, -212, -294, -257, -465, -399, -478,  // O
+    -241, -461, -516, -425, -238, -489, -483, -335, -313, -553, -531, -278, -478, -478, -249, -288, -444, -247, -382, -310, -320, -446, -409, -458, -351, -601,  // P
+    -442, -483, -469, -531, -505, -478, -531, -601, -483, -601, -516, -505, -531, -489, -531, -531, -553, -418, -461, -458, -279, -601, -531, -601, -553, -601,  // Q
+    -204, -304, -270, -268, -176, -296, -313, -363, -218, -465, -308, -322, -275, -320, -219, -292, -465, -302, -236, -223, -313, -305, -299, -516, -283, -601,  // R
+    -225, -279, -280, -316, -205, -299, -354, -273, -219, -489, -398, -295, -263, -318, -210, -259, -374, -320, -233, -200, -252, -362, -269, -489, -342, -601,  // S
+    -225, -288, -310, -332, -204, -312, -356, -139, -196, -483, -439, -283, -311, -349, -203, -307, -392, -246, -242, -230, -288, -383, -257, -424, -291, -497,  // T
+    -290, -310, -280, -343, -292, -370, -303, -435, -318, -601, -516, -275, -272, -265, -365, -293, -601, -233, -260, -249, -418, -516, -424, -497, -531, -553,  // U
+    -297, -516, -601, -469, -229, -531, -601, -553, -283, -601, -601, -601, -553, -516, -385, -489, -601, -531, -516, -439, -458, -601, -497, -489, -483, -601,  // V
+    -256, -404, -417, -380, -273, -404, -416, -233, -249, -601, -601, -405, -398, -349, -280, -455, -553, -397, -355, -351, -505, -444, -388, -553, -505, -601,  // W
+    -394, -483, -357, -383, -390, -427, -469, -389, -321, -601, -601, -497, -497, -601, -435, -317, -601, -483, -465, -325, -553, -449, -458, -516, -419, -601,  // X
+    -281, -308, -314, -336, -289, -337, -381, -371, -306, -516, -444, -351, -332, -363, -268, -333, -531, -307, -263, -261, -380, -385, -312, -516, -428, -478,  // Y
+    -449, -601, -531, -516, -427, -531, -601, -601, -452, -601, -601, -531, -553, -601, -446, -601, -601, -553, -516, -489, -531, -601, -531, -601, -553, -601,  // Z
+};
+
+// Shortest Vigenère column worth scoring
+constexpr size_t MIN_COLUMN_LETTERS = 8;
+
+std::vector<uint8_t> letter_indices(std::span<const uint8_t> text) {
+    std::vector<uint8_t> letters;
+    letters.reserve(text.size());
+    for (uint8_t byte : text) {
+        uint8_t off = static_cast<uint8_t>((byte | 0x20) - 'a');
+        if (off < 26) {
+            letters.push_back(off);
+        }
+    }
+    return letters;
+}
+
+double score_per_letter(const NgramModel& model, std::span<const uint8_t> letters) {
+    size_t grams = letters.size() >= static_cast<size_t>(model.order())
+        ? letters.size() - model.order() + 1 : 0;
+    return grams ? model.score(letters) / grams : 0.0;
+}
+
+/**
+ * @brief Run work(i) for i in [0, items) on every pool thread
+ *
+ * Items are claimed from one counter, so uneven items (long Vigenère
+ * keys, slow restarts) still keep every worker busy to the end.
+ */
+template <typename Work>
+void run_workers(core::ThreadPool& pool, size_t items, Work&& work) {
+    std::atomic<size_t> next{0};
+    std::vector<std::future<void>> workers;
+    for (size_t t = 0; t < std::min(pool.size(), items); ++t) {
+        workers.push_back(pool.submit([&]() {
+            for (size_t i = next.fetch_add(1); i < items; i = next.fetch_add(1)) {
+                work(i);
+            }
+        }));
+    }
+    for (auto& worker : workers) {
+        worker.get();
+    }
+}
+
+double elapsed_seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Fill chi_squared and score from the recovered plaintext
+ */
+void finish(CrackResult& result, const NgramModel& model, std::chrono::steady_clock::time_point start,
+            size_t threads) {
+    std::array<uint64_t, 26> counts{};
+    kernels::letter_histogram(result.plaintext, counts);
+    result.chi_squared = ClassicalCracker::chi_squared(counts);
+    result.score = score_per_letter(model, letter_indices(result.plaintext));
+    result.seconds = elapsed_seconds(start);
+    result.threads = threads;
+    result.success = true;
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// NgramModel
+// ============================================================================
+
+const NgramModel& NgramModel::english_bigrams() {
+    static const NgramModel model = [] {
+        std::vector<float> table(26 * 26);
+        for (size_t i = 0; i < table.size(); ++i) {
+            table[i] = ENGLISH_BIGRAMS[i] / 100.0f;
+        }
+        return NgramModel(2, std::move(table));
+    }();
+    return model;
+}
+
+NgramModel NgramModel::train(std::span<const uint8_t> text, int order) {
+    if (order < 2 || order > 4) {
+        throw std::invalid_argument("n-gram order must be 2, 3 or 4");
+    }
+    size_t entries = 1;
+    for (int i = 0; i < order; ++i) {
+        entries *= 26;
+    }
+    
+    auto letters = letter_indices(text);
+    if (letters.size() < 1000) {
+        throw std::invalid_argument("Training text needs at least 1000 letters");
+    }
+    
+    std::vector<uint32_t> counts(entries, 0);
+    size_t index = 0;
+    for (size_t i = 0; i < letters.size(); ++i) {
+        index = (index * 26 + letters[i]) % entries;
+        if (i + 1 >= static_cast<size_t>(order)) {
+            counts[index]++;
+        }
+    }
+    
+    // Unseen n-grams get a hundredth of one occurrence
+    double total = static_cast<double>(letters.size() - order + 1);
+    std::vector<float> table(entries);
+    for (size_t i = 0; i < entries; ++i) {
+        table[i] = static_cast<float>(std::log10((counts[i] ? counts[i] : 0.01) / total));
+    }
+    return NgramModel(order, std::move(table));
+}
+
+double NgramModel::score(std::span<const uint8_t> letters) const {
+    const size_t n = static_cast<size_t>(order_);
+    if (letters.size() < n) {
+        return 0.0;
+    }
+    size_t entries = table_.size();
+    size_t index = 0;
+    for (size_t i = 0; i + 1 < n; ++i) {
+        index = index * 26 + letters[i];
+    }
+    double total = 0.0;
+    for (size_t i = n - 1; i < letters.size(); ++i) {
+        index = (index * 26 + letters[i]) % entries;
+        total += table_[index];
+    }
+    return total;
+}
+
+// ============================================================================
+// ClassicalCracker
+// ============================================================================
+
+double ClassicalCracker::chi_squared(const std::array<uint64_t, 26>& counts) {
+    double total = static_cast<double>(std::accumulate(counts.begin(), counts.end(), uint64_t{0}));
+    if (total == 0.0) {
+        return 0.0;
+    }
+    double chi = 0.0;
+    for (size_t i = 0; i < 26; ++i) {
+        double expected = total * ENGLISH_FREQUENCY[i] / 100.0;
+        double diff = static_cast<double>(counts[i]) - expected;
+        chi += diff * diff / expected;
+    }
+    return chi;
+}
+
+CrackResult ClassicalCracker::crack_caesar(std::span<const uint8_t> ciphertext, const CrackOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+    CrackResult result;
+    const NgramModel& model = options.model ? *options.model : NgramModel::english_bigrams();
+    
+    std::array<uint64_t, 26> cipher_counts{};
+    kernels::letter_histogram(ciphertext, cipher_counts);
+    if (std::accumulate(cipher_counts.begin(), cipher_counts.end(), uint64_t{0}) == 0) {
+        result.error_message = "Ciphertext has no letters";
+        return result;
+    }
+    
+    // Every shift through the cipher's own decrypt
+    core::ThreadPool pool(options.threads);
+    std::array<double, 26> chi{};
+    run_workers(pool, 26, [&](size_t shift) {
+        Caesar caesar;
+        uint8_t key = static_cast<uint8_t>(shift);
+        auto decrypted = caesar.decrypt(ciphertext, std::span<const uint8_t>(&key, 1), {});
+        std::array<uint64_t, 26> counts{};
+        kernels::letter_histogram(decrypted.data, counts);
+        chi[shift] = chi_squared(counts);
+    });
+    
+    size_t best = static_cast<size_t>(std::min_element(chi.begin(), chi.end()) - chi.begin());
+    result.key = {static_cast<uint8_t>(best)};
+    result.key_text = std::to_string(best);
+    result.plaintext = Caesar().decrypt(ciphertext, result.key, {}).data;
+    result.keys_tried = 26;
+    finish(result, model, start, pool.size());
+    return result;
+}
+
+CrackResult ClassicalCracker::crack_vigenere(std::span<const uint8_t> ciphertext, const CrackOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+    CrackResult result;
+    const NgramModel& model = options.model ? *options.model : NgramModel::english_bigrams();
+    
+    auto letters = letter_indices(ciphertext);
+    if (letters.size() < MIN_COLUMN_LETTERS) {
+        result.error_message = "Ciphertext is too short to attack";
+        return result;
+    }
+    size_t max_length = std::clamp<size_t>(letters.size() / MIN_COLUMN_LETTERS, 1, std::max<size_t>(options.max_key_length, 1));
+    std::span<const uint8_t> sample(letters.data(), std::min(letters.size(), std::max<size_t>(options.sample_letters, 1)));
+    
+    struct Candidate {
+        std::vector<uint8_t> shifts;
+        double score = -INFINITY;
+    };
+    std::vector<Candidate> candidates(max_length);
+    std::atomic<uint64_t> tried{0};
+    
+    core::ThreadPool pool(options.threads);
+    run_workers(pool, max_length, [&](size_t item) {
+        const size_t length = item + 1;
+        
+        // Per-column chi-squared picks a first shift for each key letter
+        std::vector<std::array<uint64_t, 26>> columns(length, std::array<uint64_t, 26>{});
+        for (size_t i = 0; i < letters.size(); ++i) {
+            columns[i % length][letters[i]]++;
+        }
+        std::vector<uint8_t> shifts(length);
+        for (size_t c = 0; c < length; ++c) {
+            double best_chi = INFINITY;
+            for (uint8_t s = 0; s < 26; ++s) {
+                std::array<uint64_t, 26> rotated;
+                for (size_t p = 0; p < 26; ++p) {
+                    rotated[p] = columns[c][(p + s) % 26];
+                }
+                double chi = chi_squared(rotated);
+                if (chi < best_chi) {
+                    best_chi = chi;
+                    shifts[c] = s;
+                }
+            }
+        }
+        uint64_t local_tried = 26 * length;
+        
+        // Then n-gram refinement, one column at a time, on the sample
+        std::vector<uint8_t> plain(sample.size());
+        for (size_t i = 0; i < sample.size(); ++i) {
+            plain[i] = static_cast<uint8_t>((sample[i] + 26 - shifts[i % length]) % 26);
+        }
+        double best_score = model.score(plain);
+        for (int pass = 0; pass < 3; ++pass) {
+            bool improved = false;
+            for (size_t c = 0; c < length; ++c) {
+                uint8_t kept = shifts[c];
+                for (uint8_t s = 0; s < 26; ++s) {
+                    if (s == kept) {
+                        continue;
+                    }
+                    for (size_t i = c; i < sample.size(); i += length) {
+                        plain[i] = static_cast<uint8_t>((sample[i] + 26 - s) % 26);
+                    }
+                    double score = model.score(plain);
+                    local_tried++;
+                    if (score > best_score) {
+                        best_score = score;
+                        shifts[c] = s;
+                        improved = true;
+                    }
+                }
+                for (size_t i = c; i < sample.size(); i += length) {
+                    plain[i] = static_cast<uint8_t>((sample[i] + 26 - shifts[c]) % 26);
+                }
+            }
+            if (!improved) {
+                break;
+            }
+        }
+        
+        tried += local_tried;
+        candidates[item].shifts = std::move(shifts);
+        candidates[item].score = best_score;
+    });
+    
+    // Multiples of the key length fit at least as well; take the shortest
+    // length within 1% of the best score
+    double best = -INFINITY;
+    for (const auto& candidate : candidates) {
+        best = std::max(best, candidate.score);
+    }
+    const Candidate* chosen = &candidates.back();
+    for (const auto& candidate : candidates) {
+        if (candidate.score >= best - 0.01 * std::abs(best)) {
+            chosen = &candidate;
+            break;
+        }
+    }
+    
+    // A keyword that repeats itself is its shortest period
+    std::vector<uint8_t> shifts = chosen->shifts;
+    for (size_t period = 1; period < shifts.size(); ++period) {
+        if (shifts.size() % period == 0 &&
+            std::equal(shifts.begin() + period, shifts.end(), shifts.begin())) {
+            shifts.resize(period);
+            break;
+        }
+    }
+    
+    for (uint8_t s : shifts) {
+        result.key.push_back(static_cast<uint8_t>('A' + s));
+    }
+    result.key_text.assign(result.key.begin(), result.key.end());
+    auto decrypted = Vigenere().decrypt(ciphertext, result.key, {});
+    if (!decrypted.success) {
+        result.error_message = decrypted.error_message;
+        return result;
+    }
+    result.plaintext = std::move(decrypted.data);
+    result.keys_tried = tried;
+    finish(result, model, start, pool.size());
+    return result;
+}
+
+CrackResult ClassicalCracker::crack_substitution(std::span<const uint8_t> ciphertext, const CrackOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+    CrackResult result;
+    const NgramModel& model = options.model ? *options.model : NgramModel::english_bigrams();
+    
+    auto letters = letter_indices(ciphertext);
+    if (letters.size() < static_cast<size_t>(model.order())) {
+        result.error_message = "Ciphertext is too short to attack";
+        return result;
+    }
+    std::span<const uint8_t> sample(letters.data(), std::min(letters.size(), std::max<size_t>(options.sample_letters, 1)));
+    
+    // Bigram models score a key from the ciphertext's pair counts alone
+    std::vector<uint32_t> pair_counts;
+    if (model.order() == 2) {
+        pair_counts.assign(26 * 26, 0);
+        for (size_t i = 1; i < letters.size(); ++i) {
+            pair_counts[letters[i - 1] * 26 + letters[i]]++;
+        }
+    }
+    
+    using Key = std::array<uint8_t, 26>;     // Cipher letter -> plain letter
+    auto make_scorer = [&]() {
+        return [&, plain = std::vector<uint8_t>(pair_counts.empty() ? sample.size() : 0)](const Key& key) mutable {
+            if (!pair_counts.empty()) {
+                double total = 0.0;
+                for (size_t a = 0; a < 26; ++a) {
+                    const uint32_t* row = pair_counts.data() + a * 26;
+                    size_t base = static_cast<size_t>(key[a]) * 26;
+                    for (size_t b = 0; b < 26; ++b) {
+                        total += row[b] * model.log_prob(base + key[b]);
+                    }
+                }
+                return total;
+            }
+            for (size_t i = 0; i < sample.size(); ++i) {
+                plain[i] = key[sample[i]];
+            }
+            return model.score(plain);
+        };
+    };
+    
+    // First start: match letters by frequency rank
+    std::array<uint64_t, 26> counts{};
+    kernels::letter_histogram(ciphertext, counts);
+    std::array<uint8_t, 26> by_frequency;
+    std::iota(by_frequency.begin(), by_frequency.end(), 0);
+    std::stable_sort(by_frequency.begin(), by_frequency.end(),
+                     [&](uint8_t a, uint8_t b) { return counts[a] > counts[b]; });
+    Key frequency_key;
+    for (size_t rank = 0; rank < 26; ++rank) {
+        frequency_key[by_frequency[rank]] = static_cast<uint8_t>(FREQUENCY_ORDER[rank] - 'A');
+    }
+    
+    core::ThreadPool pool(options.threads);
+    size_t restarts = options.restarts ? options.restarts : 4 * pool.size();
+    std::mutex best_mutex;
+    Key best_key = frequency_key;
+    double best_score = -INFINITY;
+    std::atomic<uint64_t> tried{0};
+    
+    run_workers(pool, restarts, [&](size_t restart) {
+        Key key = frequency_key;
+        if (restart > 0) {
+            std::mt19937 gen(options.seed + static_cast<uint32_t>(restart));
+            std::shuffle(key.begin(), key.end(), gen);
+        }
+        auto score_key = make_scorer();
+        
+        // Swap pairs of plain letters while any swap helps
+        double score = score_key(key);
+        uint64_t local_tried = 1;
+        for (bool improved = true; improved;) {
+            improved = false;
+            for (size_t i = 0; i < 26; ++i) {
+                for (size_t j = i + 1; j < 26; ++j) {
+                    std::swap(key[i], key[j]);
+                    double candidate = score_key(key);
+                    local_tried++;
+                    if (candidate > score) {
+                        score = candidate;
+                        improved = true;
+                    } else {
+                        std::swap(key[i], key[j]);
+                    }
+                }
+            }
+        }
+        
+        tried += local_tried;
+        std::lock_guard<std::mutex> lock(best_mutex);
+        if (score > best_score || (score == best_score && key < best_key)) {
+            best_score = score;
+            best_key = key;
+        }
+    });
+    
+    std::array<char, 26> map;
+    result.key_text.assign(26, '?');
+    for (size_t c = 0; c < 26; ++c) {
+        map[c] = static_cast<char>('A' + best_key[c]);
+        result.key_text[best_key[c]] = static_cast<char>('A' + c);
+    }
+    result.plaintext.resize(ciphertext.size());
+    kernels::substitute(ciphertext, result.plaintext, map);
+    result.keys_tried = tried;
+    finish(result, model, start, pool.size());
+    return result;
+}
+
+} // namespace classical
+} // namespace algorithms
+} // namespace filevault
@@ -1,6 +1,5 @@
 #include "filevault/algorithms/classical/hill.hpp"
 #include <algorithm>
-#include <sstream>
 #include <chrono>
 
 namespace filevault {
@@ -98,6 +97,70 @@ std::string HillCipher::decrypt_block(const std::string& block, const Matrix2x2&
     return encrypt_block(block, inv_matrix);  // Same operation with inverse matrix
 }
 
+bool HillCipher::prepare(std::span<const uint8_t> key) {
+    if (cache_ready_ && std::equal(key.begin(), key.end(), cached_key_.begin(), cached_key_.end())) {
+        return key_valid_;
+    }
+    
+    cached_key_.assign(key.begin(), key.end());
+    cache_ready_ = true;
+    key_matrix_ = parse_key(key);
+    key_valid_ = is_valid_key(key_matrix_);
+    if (!key_valid_) {
+        return false;
+    }
+    inverse_matrix_ = invert_matrix(key_matrix_);
+    
+    auto fill = [](const Matrix2x2& m, std::array<uint16_t, 676>& pairs) {
+        for (int p0 = 0; p0 < 26; ++p0) {
+            for (int p1 = 0; p1 < 26; ++p1) {
+                int c0 = (m[0] * p0 + m[1] * p1) % 26;
+                int c1 = (m[2] * p0 + m[3] * p1) % 26;
+                pairs[p0 * 26 + p1] = static_cast<uint16_t>(('A' + c0) | ('A' + c1) << 8);
+            }
+        }
+    };
+    fill(key_matrix_, encrypt_pairs_);
+    fill(inverse_matrix_, decrypt_pairs_);
+    return true;
+}
+
+void HillCipher::transform_pairs(std::span<const uint8_t> text, const Matrix2x2& matrix,
+                                 const std::array<uint16_t, 676>& pairs, std::vector<uint8_t>& out) {
+    constexpr size_t BATCH = 64;
+    const size_t digraphs = text.size() / 2;
+    out.resize(digraphs * 2);
+    
+    uint16_t index[BATCH];
+    for (size_t first = 0; first < digraphs; first += BATCH) {
+        size_t n = std::min(BATCH, digraphs - first);
+        const uint8_t* in = text.data() + first * 2;
+        uint8_t* dst = out.data() + first * 2;
+        
+        // Letter offsets; anything outside A-Z/a-z takes the arithmetic path
+        bool letters = true;
+        for (size_t i = 0; i < n; ++i) {
+            unsigned p0 = static_cast<uint8_t>((in[2 * i] | 0x20) - 'a');
+            unsigned p1 = static_cast<uint8_t>((in[2 * i + 1] | 0x20) - 'a');
+            letters &= (p0 < 26) & (p1 < 26);
+            index[i] = static_cast<uint16_t>(p0 * 26 + p1);
+        }
+        if (letters) {
+            for (size_t i = 0; i < n; ++i) {
+                uint16_t pair = pairs[index[i]];
+                dst[2 * i] = static_cast<uint8_t>(pair);
+                dst[2 * i + 1] = static_cast<uint8_t>(pair >> 8);
+            }
+            continue;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            std::string block = encrypt_block(std::string(reinterpret_cast<const char*>(in + 2 * i), 2), matrix);
+            dst[2 * i] = static_cast<uint8_t>(block[0]);
+            dst[2 * i + 1] = static_cast<uint8_t>(block[1]);
+        }
+    }
+}
+
 core::CryptoResult HillCipher::encrypt(
     std::span<const uint8_t> plaintext,
     std::span<const uint8_t> key,
@@ -108,41 +171,32 @@ core::CryptoResult HillCipher::encrypt(
     auto start = std::chrono::high_resolution_clock::now();
     
     try {
-        auto key_matrix = parse_key(key);
-        
-        if (!is_valid_key(key_matrix)) {
+        if (!prepare(key)) {
             result.success = false;
             result.error_message = "Invalid key: matrix not invertible (determinant not coprime with 26)";
             return result;
         }
         
-        std::string text(plaintext.begin(), plaintext.end());
-        std::string ciphertext;
-        
-        // Remove non-alphabetic characters
-        std::string cleaned;
-        for (char c : text) {
-            if (isalpha(c)) {
-                cleaned += toupper(c);
+        // Keep the letters, uppercased
+        std::vector<uint8_t> cleaned;
+        cleaned.reserve(plaintext.size() + 1);
+        for (uint8_t c : plaintext) {
+            if (static_cast<uint8_t>((c | 0x20) - 'a') < 26) {
+                cleaned.push_back(static_cast<uint8_t>(c & ~0x20));
             }
         }
         
         // Pad to even length
-        if (cleaned.length() % 2 != 0) {
-            cleaned += 'X';
+        if (cleaned.size() % 2 != 0) {
+            cleaned.push_back('X');
         }
         
-        // Encrypt in 2-character blocks
-        for (size_t i = 0; i < cleaned.length(); i += 2) {
-            std::string block = cleaned.substr(i, 2);
-            ciphertext += encrypt_block(block, key_matrix);
-        }
+        transform_pairs(cleaned, key_matrix_, encrypt_pairs_, result.data);
         
         result.success = true;
-        result.data.assign(ciphertext.begin(), ciphertext.end());
         result.algorithm_used = type();
         result.original_size = plaintext.size();
-        result.final_size = ciphertext.length();
+        result.final_size = result.data.size();
         
     } catch (const std::exception& e) {
         result.success = false;
@@ -165,32 +219,19 @@ core::CryptoResult HillCipher::decrypt(
     auto start = std::chrono::high_resolution_clock::now();
     
     try {
-        auto key_matrix = parse_key(key);
-        
-        if (!is_valid_key(key_matrix)) {
+        if (!prepare(key)) {
             result.success = false;
             result.error_message = "Invalid key: matrix not invertible";
             return result;
         }
         
-        auto inv_matrix = invert_matrix(key_matrix);
-        
-        std::string text(ciphertext.begin(), ciphertext.end());
-        std::string plaintext;
-        
-        // Decrypt in 2-character blocks
-        for (size_t i = 0; i < text.length(); i += 2) {
-            if (i + 1 < text.length()) {
-                std::string block = text.substr(i, 2);
-                plaintext += decrypt_block(block, inv_matrix);
-            }
-        }
+        // Decrypt in 2-character blocks; an odd last byte is dropped
+        transform_pairs(ciphertext, inverse_matrix_, decrypt_pairs_, result.data);
         
         result.success = true;
-        result.data.assign(plaintext.begin(), plaintext.end());
         result.algorithm_used = type();
         result.original_size = ciphertext.size();
-        result.final_size = plaintext.length();
+        result.final_size = result.data.size();
         
     } catch (const std::exception& e) {
         result.success = false;
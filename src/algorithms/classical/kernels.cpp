@@ -0,0 +1,400 @@
+/**
+ * @file kernels.cpp
+ * @brief SIMD letter-shift and histogram kernels for the classical ciphers
+ */
+
+#include "filevault/algorithms/classical/kernels.hpp"
+#include "filevault/core/cpu_features.hpp"
+#include <algorithm>
+#include <bit>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define FILEVAULT_CLASSICAL_SSE2 1
+    #include <emmintrin.h>
+    #include <tmmintrin.h>
+    #if defined(__GNUC__) || defined(__clang__)
+        #define FILEVAULT_TARGET_SSSE3 __attribute__((target("ssse3")))
+    #else
+        #define FILEVAULT_TARGET_SSSE3
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define FILEVAULT_CLASSICAL_NEON 1
+    #include <arm_neon.h>
+#endif
+
+namespace filevault {
+namespace algorithms {
+namespace classical {
+namespace kernels {
+
+namespace {
+
+constexpr size_t kBlock = 16;
+
+// All-ones if x is an ASCII letter; off = position in the alphabet
+inline uint8_t letter_mask(uint8_t x, uint8_t& off) {
+    off = static_cast<uint8_t>((x | 0x20) - 'a');
+    return static_cast<uint8_t>(0u - static_cast<unsigned>(off < 26));
+}
+
+// Shift one byte by s (mod 26), minus 26 when off < wrap_below and the
+// result is non-zero, matching C's truncated remainder for negative sums
+inline uint8_t shift_byte(uint8_t x, unsigned s, unsigned wrap_below) {
+    uint8_t off;
+    uint8_t mask = letter_mask(x, off);
+    unsigned y = off + s;
+    y -= 26u & (0u - static_cast<unsigned>(y >= 26));
+    y -= 26u & (0u - static_cast<unsigned>((off < wrap_below) & (y != 0)));
+    return static_cast<uint8_t>(x + (static_cast<uint8_t>(y - off) & mask));
+}
+
+inline uint8_t substitute_byte(uint8_t x, const std::array<char, 26>& map) {
+    uint8_t off;
+    uint8_t mask = letter_mask(x, off);
+    // Scan the whole map so the access pattern does not depend on x
+    uint8_t r = 0;
+    for (unsigned i = 0; i < 26; ++i) {
+        r |= static_cast<uint8_t>(map[i]) & static_cast<uint8_t>(0u - static_cast<unsigned>(off == i));
+    }
+    r |= x & 0x20;
+    return static_cast<uint8_t>(x ^ ((x ^ r) & mask));
+}
+
+inline unsigned normalize_shift(int shift) {
+    return static_cast<unsigned>(((shift % 26) + 26) % 26);
+}
+
+size_t vigenere_scalar(const uint8_t* in, uint8_t* out, size_t n,
+                       const ShiftSchedule& schedule, size_t k) {
+    for (size_t i = 0; i < n; ++i) {
+        uint8_t off;
+        size_t is_letter = letter_mask(in[i], off) & 1u;
+        out[i] = shift_byte(in[i], schedule.shift[k], schedule.wrap_below[k]);
+        k += is_letter;
+        k -= schedule.length & (0 - static_cast<size_t>(k == schedule.length));
+    }
+    return k;
+}
+
+#if defined(FILEVAULT_CLASSICAL_SSE2)
+
+inline __m128i letter_offsets(__m128i x) {
+    return _mm_sub_epi8(_mm_or_si128(x, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+}
+
+inline __m128i letter_mask(__m128i off) {
+    return _mm_cmpeq_epi8(_mm_min_epu8(off, _mm_set1_epi8(25)), off);
+}
+
+// Reduce off + s (both 0..25) mod 26 and return the per-lane delta
+inline __m128i shift_delta(__m128i off, __m128i s) {
+    __m128i y = _mm_add_epi8(off, s);
+    __m128i ge = _mm_cmpgt_epi8(y, _mm_set1_epi8(25));
+    return _mm_sub_epi8(y, _mm_and_si128(ge, _mm_set1_epi8(26)));
+}
+
+void caesar_sse2(const uint8_t* in, uint8_t* out, size_t blocks, unsigned s) {
+    const __m128i shift = _mm_set1_epi8(static_cast<char>(s));
+    for (size_t b = 0; b < blocks; ++b) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + b * kBlock));
+        __m128i off = letter_offsets(x);
+        __m128i mask = letter_mask(off);
+        __m128i delta = _mm_sub_epi8(shift_delta(off, shift), off);
+        x = _mm_add_epi8(x, _mm_and_si128(delta, mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + b * kBlock), x);
+    }
+}
+
+FILEVAULT_TARGET_SSSE3
+size_t vigenere_ssse3(const uint8_t* in, uint8_t* out, size_t blocks,
+                      const ShiftSchedule& schedule, size_t k) {
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i twenty_six = _mm_set1_epi8(26);
+    for (size_t b = 0; b < blocks; ++b) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + b * kBlock));
+        __m128i off = letter_offsets(x);
+        __m128i mask = letter_mask(off);
+
+        // Exclusive prefix count of letters = key offset of each lane
+        __m128i ones = _mm_and_si128(mask, one);
+        __m128i prefix = _mm_add_epi8(ones, _mm_slli_si128(ones, 1));
+        prefix = _mm_add_epi8(prefix, _mm_slli_si128(prefix, 2));
+        prefix = _mm_add_epi8(prefix, _mm_slli_si128(prefix, 4));
+        prefix = _mm_add_epi8(prefix, _mm_slli_si128(prefix, 8));
+        __m128i lane_key = _mm_sub_epi8(prefix, ones);
+
+        __m128i s = _mm_shuffle_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(schedule.shift.data() + k)), lane_key);
+        __m128i wrap = _mm_shuffle_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(schedule.wrap_below.data() + k)), lane_key);
+
+        __m128i y = shift_delta(off, s);
+        __m128i negative = _mm_andnot_si128(_mm_cmpeq_epi8(y, _mm_setzero_si128()),
+                                            _mm_cmpgt_epi8(wrap, off));
+        y = _mm_sub_epi8(y, _mm_and_si128(negative, twenty_six));
+
+        __m128i delta = _mm_sub_epi8(y, off);
+        x = _mm_add_epi8(x, _mm_and_si128(delta, mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + b * kBlock), x);
+
+        k = (k + static_cast<size_t>(std::popcount(static_cast<unsigned>(_mm_movemask_epi8(mask)))))
+            % schedule.length;
+    }
+    return k;
+}
+
+inline __m128i finish_substitution(__m128i x, __m128i r, __m128i mask) {
+    r = _mm_or_si128(r, _mm_and_si128(x, _mm_set1_epi8(0x20)));
+    return _mm_xor_si128(x, _mm_and_si128(_mm_xor_si128(x, r), mask));
+}
+
+FILEVAULT_TARGET_SSSE3
+void substitute_ssse3(const uint8_t* in, uint8_t* out, size_t blocks,
+                      const std::array<char, 26>& map) {
+    alignas(16) uint8_t high[kBlock] = {};
+    std::copy(map.begin() + 16, map.end(), high);
+    const __m128i table_lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(map.data()));
+    const __m128i table_hi = _mm_load_si128(reinterpret_cast<const __m128i*>(high));
+    const __m128i sixteen = _mm_set1_epi8(16);
+
+    for (size_t b = 0; b < blocks; ++b) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + b * kBlock));
+        __m128i off = letter_offsets(x);
+        __m128i mask = letter_mask(off);
+        __m128i is_lo = _mm_cmpgt_epi8(sixteen, off);
+        __m128i r = _mm_or_si128(
+            _mm_and_si128(is_lo, _mm_shuffle_epi8(table_lo, off)),
+            _mm_andnot_si128(is_lo, _mm_shuffle_epi8(table_hi, _mm_sub_epi8(off, sixteen))));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + b * kBlock),
+                         finish_substitution(x, r, mask));
+    }
+}
+
+void substitute_sse2(const uint8_t* in, uint8_t* out, size_t blocks,
+                     const std::array<char, 26>& map) {
+    for (size_t b = 0; b < blocks; ++b) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + b * kBlock));
+        __m128i off = letter_offsets(x);
+        __m128i mask = letter_mask(off);
+        __m128i r = _mm_setzero_si128();
+        for (int i = 0; i < 26; ++i) {
+            r = _mm_or_si128(r, _mm_and_si128(_mm_cmpeq_epi8(off, _mm_set1_epi8(static_cast<char>(i))),
+                                              _mm_set1_epi8(map[i])));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + b * kBlock),
+                         finish_substitution(x, r, mask));
+    }
+}
+
+// Lane counters are 8-bit: flush after at most 255 blocks
+constexpr size_t kHistogramFlush = 255;
+
+void histogram_sse2(const uint8_t* in, size_t blocks, std::array<uint64_t, 26>& counts) {
+    for (size_t first = 0; first < blocks; first += kHistogramFlush) {
+        size_t n = std::min(kHistogramFlush, blocks - first);
+        __m128i lanes[26];
+        for (auto& lane : lanes) {
+            lane = _mm_setzero_si128();
+        }
+        for (size_t b = first; b < first + n; ++b) {
+            __m128i off = letter_offsets(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + b * kBlock)));
+            for (int i = 0; i < 26; ++i) {
+                // cmpeq gives -1 per match
+                lanes[i] = _mm_sub_epi8(lanes[i], _mm_cmpeq_epi8(off, _mm_set1_epi8(static_cast<char>(i))));
+            }
+        }
+        for (int i = 0; i < 26; ++i) {
+            __m128i sums = _mm_sad_epu8(lanes[i], _mm_setzero_si128());
+            counts[i] += static_cast<uint64_t>(_mm_cvtsi128_si32(sums)) +
+                         static_cast<uint64_t>(_mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+        }
+    }
+}
+
+#elif defined(FILEVAULT_CLASSICAL_NEON)
+
+inline uint8x16_t letter_offsets(uint8x16_t x) {
+    return vsubq_u8(vorrq_u8(x, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+}
+
+inline uint8x16_t shift_delta(uint8x16_t off, uint8x16_t s) {
+    const uint8x16_t twenty_six = vdupq_n_u8(26);
+    uint8x16_t y = vaddq_u8(off, s);
+    return vsubq_u8(y, vandq_u8(vcgeq_u8(y, twenty_six), twenty_six));
+}
+
+void caesar_neon(const uint8_t* in, uint8_t* out, size_t blocks, unsigned s) {
+    const uint8x16_t shift = vdupq_n_u8(static_cast<uint8_t>(s));
+    for (size_t b = 0; b < blocks; ++b) {
+        uint8x16_t x = vld1q_u8(in + b * kBlock);
+        uint8x16_t off = letter_offsets(x);
+        uint8x16_t mask = vcltq_u8(off, vdupq_n_u8(26));
+        uint8x16_t delta = vsubq_u8(shift_delta(off, shift), off);
+        vst1q_u8(out + b * kBlock, vaddq_u8(x, vandq_u8(delta, mask)));
+    }
+}
+
+size_t vigenere_neon(const uint8_t* in, uint8_t* out, size_t blocks,
+                     const ShiftSchedule& schedule, size_t k) {
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const uint8x16_t twenty_six = vdupq_n_u8(26);
+    for (size_t b = 0; b < blocks; ++b) {
+        uint8x16_t x = vld1q_u8(in + b * kBlock);
+        uint8x16_t off = letter_offsets(x);
+        uint8x16_t mask = vcltq_u8(off, twenty_six);
+
+        // Exclusive prefix count of letters = key offset of each lane
+        uint8x16_t ones = vandq_u8(mask, vdupq_n_u8(1));
+        uint8x16_t prefix = vaddq_u8(ones, vextq_u8(zero, ones, 15));
+        prefix = vaddq_u8(prefix, vextq_u8(zero, prefix, 14));
+        prefix = vaddq_u8(prefix, vextq_u8(zero, prefix, 12));
+        prefix = vaddq_u8(prefix, vextq_u8(zero, prefix, 8));
+        uint8x16_t lane_key = vsubq_u8(prefix, ones);
+
+        uint8x16_t s = vqtbl1q_u8(vld1q_u8(schedule.shift.data() + k), lane_key);
+        uint8x16_t wrap = vqtbl1q_u8(vld1q_u8(schedule.wrap_below.data() + k), lane_key);
+
+        uint8x16_t y = shift_delta(off, s);
+        uint8x16_t negative = vandq_u8(vcgtq_u8(wrap, off), vmvnq_u8(vceqq_u8(y, zero)));
+        y = vsubq_u8(y, vandq_u8(negative, twenty_six));
+
+        uint8x16_t delta = vsubq_u8(y, off);
+        vst1q_u8(out + b * kBlock, vaddq_u8(x, vandq_u8(delta, mask)));
+
+        k = (k + vaddvq_u8(ones)) % schedule.length;
+    }
+    return k;
+}
+
+void substitute_neon(const uint8_t* in, uint8_t* out, size_t blocks,
+                     const std::array<char, 26>& map) {
+    uint8_t padded[2 * kBlock] = {};
+    std::copy(map.begin(), map.end(), padded);
+    const uint8x16x2_t table = {{vld1q_u8(padded), vld1q_u8(padded + kBlock)}};
+    for (size_t b = 0; b < blocks; ++b) {
+        uint8x16_t x = vld1q_u8(in + b * kBlock);
+        uint8x16_t off = letter_offsets(x);
+        uint8x16_t mask = vcltq_u8(off, vdupq_n_u8(26));
+        uint8x16_t r = vorrq_u8(vqtbl2q_u8(table, off), vandq_u8(x, vdupq_n_u8(0x20)));
+        vst1q_u8(out + b * kBlock, vbslq_u8(mask, r, x));
+    }
+}
+
+constexpr size_t kHistogramFlush = 255;
+
+void histogram_neon(const uint8_t* in, size_t blocks, std::array<uint64_t, 26>& counts) {
+    for (size_t first = 0; first < blocks; first += kHistogramFlush) {
+        size_t n = std::min(kHistogramFlush, blocks - first);
+        uint8x16_t lanes[26];
+        for (auto& lane : lanes) {
+            lane = vdupq_n_u8(0);
+        }
+        for (size_t b = first; b < first + n; ++b) {
+            uint8x16_t off = letter_offsets(vld1q_u8(in + b * kBlock));
+            for (int i = 0; i < 26; ++i) {
+                lanes[i] = vsubq_u8(lanes[i], vceqq_u8(off, vdupq_n_u8(static_cast<uint8_t>(i))));
+            }
+        }
+        for (int i = 0; i < 26; ++i) {
+            counts[i] += vaddlvq_u8(lanes[i]);
+        }
+    }
+}
+
+#endif
+
+} // anonymous namespace
+
+void caesar(std::span<const uint8_t> in, std::span<uint8_t> out, int shift) {
+    const unsigned s = normalize_shift(shift);
+    size_t done = 0;
+#if defined(FILEVAULT_CLASSICAL_SSE2)
+    caesar_sse2(in.data(), out.data(), in.size() / kBlock, s);
+    done = in.size() - in.size() % kBlock;
+#elif defined(FILEVAULT_CLASSICAL_NEON)
+    caesar_neon(in.data(), out.data(), in.size() / kBlock, s);
+    done = in.size() - in.size() % kBlock;
+#endif
+    for (size_t i = done; i < in.size(); ++i) {
+        out[i] = shift_byte(in[i], s, 0);
+    }
+}
+
+ShiftSchedule ShiftSchedule::from_keyword(const std::string& keyword, bool decrypt) {
+    ShiftSchedule schedule;
+    schedule.length = keyword.size();
+    schedule.shift.resize(keyword.size() + kBlock);
+    schedule.wrap_below.resize(keyword.size() + kBlock);
+
+    for (size_t i = 0; i < schedule.shift.size() && !keyword.empty(); ++i) {
+        // Same arithmetic as the reference loops: (off + v) % 26 for
+        // encryption and (off - v + 26) % 26 for decryption
+        int v = keyword[i % keyword.size()] - 'A';
+        int w = decrypt ? 26 - v : v;
+        schedule.shift[i] = static_cast<uint8_t>(normalize_shift(w));
+        schedule.wrap_below[i] = static_cast<uint8_t>(std::clamp(-w, 0, 26));
+    }
+    return schedule;
+}
+
+size_t vigenere(std::span<const uint8_t> in, std::span<uint8_t> out,
+                const ShiftSchedule& schedule, size_t key_index) {
+    if (schedule.length == 0) {
+        std::copy(in.begin(), in.end(), out.begin());
+        return 0;
+    }
+
+    size_t k = key_index % schedule.length;
+    size_t done = 0;
+#if defined(FILEVAULT_CLASSICAL_SSE2)
+    if (core::CpuFeatures::detect().ssse3) {
+        k = vigenere_ssse3(in.data(), out.data(), in.size() / kBlock, schedule, k);
+        done = in.size() - in.size() % kBlock;
+    }
+#elif defined(FILEVAULT_CLASSICAL_NEON)
+    k = vigenere_neon(in.data(), out.data(), in.size() / kBlock, schedule, k);
+    done = in.size() - in.size() % kBlock;
+#endif
+    return vigenere_scalar(in.data() + done, out.data() + done, in.size() - done, schedule, k);
+}
+
+void substitute(std::span<const uint8_t> in, std::span<uint8_t> out,
+                const std::array<char, 26>& map) {
+    size_t done = 0;
+#if defined(FILEVAULT_CLASSICAL_SSE2)
+    if (core::CpuFeatures::detect().ssse3) {
+        substitute_ssse3(in.data(), out.data(), in.size() / kBlock, map);
+    } else {
+        substitute_sse2(in.data(), out.data(), in.size() / kBlock, map);
+    }
+    done = in.size() - in.size() % kBlock;
+#elif defined(FILEVAULT_CLASSICAL_NEON)
+    substitute_neon(in.data(), out.data(), in.size() / kBlock, map);
+    done = in.size() - in.size() % kBlock;
+#endif
+    for (size_t i = done; i < in.size(); ++i) {
+        out[i] = substitute_byte(in[i], map);
+    }
+}
+
+void letter_histogram(std::span<const uint8_t> in, std::array<uint64_t, 26>& counts) {
+    size_t done = 0;
+#if defined(FILEVAULT_CLASSICAL_SSE2)
+    histogram_sse2(in.data(), in.size() / kBlock, counts);
+    done = in.size() - in.size() % kBlock;
+#elif defined(FILEVAULT_CLASSICAL_NEON)
+    histogram_neon(in.data(), in.size() / kBlock, counts);
+    done = in.size() - in.size() % kBlock;
+#endif
+    for (size_t i = done; i < in.size(); ++i) {
+        uint8_t off;
+        if (letter_mask(in[i], off)) {
+            counts[off]++;
+        }
+    }
+}
+
+} // namespace kernels
+} // namespace classical
+} // namespace algorithms
+} // namespace filevault
@@ -1,18 +1,25 @@
 #include "filevault/algorithms/classical/playfair.hpp"
 #include <algorithm>
 #include <cctype>
-#include <unordered_map>
 #include <chrono>
 
 namespace filevault {
 namespace algorithms {
 namespace classical {
 
+namespace {
+
+constexpr size_t PAIR_BATCH = 64;
+
+} // anonymous namespace
+
 Playfair::Playfair(const std::string& keyword) {
     build_matrix(keyword);
 }
 
 void Playfair::build_matrix(const std::string& keyword) {
+    keyword_ = keyword;
+    
     std::string key = keyword;
     std::transform(key.begin(), key.end(), key.begin(), ::toupper);
     
@@ -24,34 +31,70 @@ void Playfair::build_matrix(const std::string& keyword) {
     key += alphabet;
     
     // Remove duplicates
-    std::string unique_key;
-    std::unordered_map<char, bool> seen;
-    
+    uint32_t seen = 0;
+    size_t count = 0;
     for (char ch : key) {
-        if (!seen[ch] && std::isalpha(ch)) {
-            unique_key += ch;
-            seen[ch] = true;
+        if (ch >= 'A' && ch <= 'Z' && !(seen & (1u << (ch - 'A')))) {
+            seen |= 1u << (ch - 'A');
+            grid_[count++] = ch;
         }
     }
     
-    // Fill matrix
-    for (int i = 0; i < 25; ++i) {
-        matrix_[i / 5][i % 5] = unique_key[i];
+    for (size_t i = 0; i < 25; ++i) {
+        cell_[grid_[i] - 'A'] = static_cast<uint8_t>(i);
+    }
+    cell_['J' - 'A'] = cell_['I' - 'A'];
+    
+    // Every digraph, both directions
+    auto pack = [this](int row1, int col1, int row2, int col2) {
+        return static_cast<uint16_t>(static_cast<uint8_t>(grid_[row1 * 5 + col1]) |
+                                     static_cast<uint8_t>(grid_[row2 * 5 + col2]) << 8);
+    };
+    for (int a = 0; a < 25; ++a) {
+        for (int b = 0; b < 25; ++b) {
+            int r1 = a / 5, c1 = a % 5, r2 = b / 5, c2 = b % 5;
+            size_t pair = static_cast<size_t>(a * 25 + b);
+            if (r1 == r2) {
+                // Same row: shift right / left
+                encrypt_pairs_[pair] = pack(r1, (c1 + 1) % 5, r2, (c2 + 1) % 5);
+                decrypt_pairs_[pair] = pack(r1, (c1 + 4) % 5, r2, (c2 + 4) % 5);
+            } else if (c1 == c2) {
+                // Same column: shift down / up
+                encrypt_pairs_[pair] = pack((r1 + 1) % 5, c1, (r2 + 1) % 5, c2);
+                decrypt_pairs_[pair] = pack((r1 + 4) % 5, c1, (r2 + 4) % 5, c2);
+            } else {
+                // Rectangle: swap columns
+                encrypt_pairs_[pair] = decrypt_pairs_[pair] = pack(r1, c2, r2, c1);
+            }
+        }
     }
 }
 
-std::pair<int, int> Playfair::find_position(char ch) const {
-    ch = std::toupper(ch);
-    if (ch == 'J') ch = 'I';
-    
-    for (int i = 0; i < 5; ++i) {
-        for (int j = 0; j < 5; ++j) {
-            if (matrix_[i][j] == ch) {
-                return {i, j};
-            }
+uint8_t Playfair::cell_of(uint8_t byte) const {
+    // Letters outside the grid land on the first cell
+    uint8_t letter = static_cast<uint8_t>((byte | 0x20) - 'a');
+    return letter < 26 ? cell_[letter] : 0;
+}
+
+void Playfair::transform_pairs(const std::vector<uint8_t>& cells, const std::array<uint16_t, 625>& pairs,
+                               std::vector<uint8_t>& out) {
+    const size_t digraphs = cells.size() / 2;
+    out.resize(digraphs * 2);
+    
+    uint16_t index[PAIR_BATCH];
+    for (size_t first = 0; first < digraphs; first += PAIR_BATCH) {
+        size_t n = std::min(PAIR_BATCH, digraphs - first);
+        const uint8_t* in = cells.data() + first * 2;
+        uint8_t* dst = out.data() + first * 2;
+        for (size_t i = 0; i < n; ++i) {
+            index[i] = static_cast<uint16_t>(in[2 * i] * 25 + in[2 * i + 1]);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            uint16_t letters = pairs[index[i]];
+            dst[2 * i] = static_cast<uint8_t>(letters);
+            dst[2 * i + 1] = static_cast<uint8_t>(letters >> 8);
         }
     }
-    return {0, 0};
 }
 
 core::CryptoResult Playfair::encrypt(
@@ -64,60 +107,39 @@ core::CryptoResult Playfair::encrypt(
     
     if (!key.empty()) {
         std::string keyword(key.begin(), key.end());
-        build_matrix(keyword);
+        if (keyword != keyword_) {
+            build_matrix(keyword);
+        }
     }
     
-    // Prepare plaintext: pairs of letters
-    std::string text;
+    // Prepare plaintext: cells of the letters, J folded into I
+    std::vector<uint8_t> cells;
+    cells.reserve(plaintext.size() + 1);
     for (uint8_t byte : plaintext) {
-        char ch = std::toupper(static_cast<char>(byte));
-        if (std::isalpha(ch)) {
-            if (ch == 'J') ch = 'I';
-            text += ch;
+        uint8_t letter = static_cast<uint8_t>((byte | 0x20) - 'a');
+        if (letter < 26) {
+            cells.push_back(cell_[letter]);
         }
     }
+    size_t letters = cells.size();
     
     // Add padding X if odd length
-    if (text.length() % 2 != 0) {
-        text += 'X';
+    if (cells.size() % 2 != 0) {
+        cells.push_back(cell_['X' - 'A']);
     }
     
     std::vector<uint8_t> result;
-    
-    // Encrypt pairs
-    for (size_t i = 0; i < text.length(); i += 2) {
-        auto [r1, c1] = find_position(text[i]);
-        auto [r2, c2] = find_position(text[i + 1]);
-        
-        char ch1, ch2;
-        
-        if (r1 == r2) {
-            // Same row: shift right
-            ch1 = matrix_[r1][(c1 + 1) % 5];
-            ch2 = matrix_[r2][(c2 + 1) % 5];
-        } else if (c1 == c2) {
-            // Same column: shift down
-            ch1 = matrix_[(r1 + 1) % 5][c1];
-            ch2 = matrix_[(r2 + 1) % 5][c2];
-        } else {
-            // Rectangle: swap columns
-            ch1 = matrix_[r1][c2];
-            ch2 = matrix_[r2][c1];
-        }
-        
-        result.push_back(static_cast<uint8_t>(ch1));
-        result.push_back(static_cast<uint8_t>(ch2));
-    }
+    transform_pairs(cells, encrypt_pairs_, result);
     
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
     
     core::CryptoResult crypto_result;
     crypto_result.success = true;
+    crypto_result.original_size = letters + letters % 2;
+    crypto_result.final_size = result.size();
     crypto_result.data = std::move(result);
     crypto_result.algorithm_used = core::AlgorithmType::PLAYFAIR;
-    crypto_result.original_size = text.length();
-    crypto_result.final_size = result.size();
     crypto_result.processing_time_ms = duration.count() / 1000.0;
     return crypto_result;
 }
@@ -132,46 +154,29 @@ core::CryptoResult Playfair::decrypt(
     
     if (!key.empty()) {
         std::string keyword(key.begin(), key.end());
-        build_matrix(keyword);
+        if (keyword != keyword_) {
+            build_matrix(keyword);
+        }
     }
     
-    std::string text(ciphertext.begin(), ciphertext.end());
-    std::vector<uint8_t> result;
-    
-    // Decrypt pairs
-    for (size_t i = 0; i < text.length(); i += 2) {
-        auto [r1, c1] = find_position(text[i]);
-        auto [r2, c2] = find_position(text[i + 1]);
-        
-        char ch1, ch2;
-        
-        if (r1 == r2) {
-            // Same row: shift left
-            ch1 = matrix_[r1][(c1 + 4) % 5];
-            ch2 = matrix_[r2][(c2 + 4) % 5];
-        } else if (c1 == c2) {
-            // Same column: shift up
-            ch1 = matrix_[(r1 + 4) % 5][c1];
-            ch2 = matrix_[(r2 + 4) % 5][c2];
-        } else {
-            // Rectangle: swap columns
-            ch1 = matrix_[r1][c2];
-            ch2 = matrix_[r2][c1];
-        }
-        
-        result.push_back(static_cast<uint8_t>(ch1));
-        result.push_back(static_cast<uint8_t>(ch2));
+    // An odd last byte pairs with the first cell
+    std::vector<uint8_t> cells(ciphertext.size() + ciphertext.size() % 2, 0);
+    for (size_t i = 0; i < ciphertext.size(); ++i) {
+        cells[i] = cell_of(ciphertext[i]);
     }
     
+    std::vector<uint8_t> result;
+    transform_pairs(cells, decrypt_pairs_, result);
+    
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
     
     core::CryptoResult crypto_result;
     crypto_result.success = true;
-    crypto_result.data = std::move(result);
-    crypto_result.algorithm_used = core::AlgorithmType::PLAYFAIR;
     crypto_result.original_size = ciphertext.size();
     crypto_result.final_size = result.size();
+    crypto_result.data = std::move(result);
+    crypto_result.algorithm_used = core::AlgorithmType::PLAYFAIR;
     crypto_result.processing_time_ms = duration.count() / 1000.0;
     return crypto_result;
 }
@@ -1,6 +1,6 @@
 #include "filevault/algorithms/classical/substitution.hpp"
+#include "filevault/algorithms/classical/kernels.hpp"
 #include <algorithm>
-#include <set>
 #include <chrono>
 
 namespace filevault {
@@ -37,13 +37,13 @@ SubstitutionCipher::SubstitutionMap SubstitutionCipher::parse_key(std::span<cons
 
 bool SubstitutionCipher::is_valid_key(const SubstitutionMap& map) {
     // Check that all 26 letters are present (it's a valid permutation)
-    std::set<char> letters;
+    uint32_t letters = 0;
     for (char c : map) {
         if (c < 'A' || c > 'Z') return false;
-        letters.insert(c);
+        letters |= 1u << (c - 'A');
     }
     
-    return letters.size() == 26;
+    return letters == (1u << 26) - 1;
 }
 
 SubstitutionCipher::SubstitutionMap SubstitutionCipher::create_reverse_map(const SubstitutionMap& forward_map) {
@@ -60,56 +60,51 @@ SubstitutionCipher::SubstitutionMap SubstitutionCipher::create_reverse_map(const
     return reverse_map;
 }
 
-std::string SubstitutionCipher::apply_substitution(const std::string& text, const SubstitutionMap& map) {
-    std::string result;
-    result.reserve(text.length());
-    
-    for (char c : text) {
-        if (isalpha(c)) {
-            bool is_upper = isupper(c);
-            char upper_c = toupper(c);
-            int index = upper_c - 'A';
-            
-            if (index >= 0 && index < 26) {
-                char substituted = map[index];
-                result += is_upper ? substituted : tolower(substituted);
-            } else {
-                result += c;
-            }
-        } else {
-            result += c;  // Keep non-alphabetic characters
+std::shared_ptr<const SubstitutionCipher::Maps> SubstitutionCipher::maps_for(std::span<const uint8_t> key) {
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        if (cached_ && std::equal(key.begin(), key.end(), cached_->key.begin(), cached_->key.end())) {
+            return cached_;
         }
     }
     
-    return result;
+    auto maps = std::make_shared<Maps>();
+    maps->key.assign(key.begin(), key.end());
+    maps->forward = parse_key(key);
+    maps->valid = is_valid_key(maps->forward);
+    if (maps->valid) {
+        maps->reverse = create_reverse_map(maps->forward);
+    }
+    
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    cached_ = maps;
+    return maps;
 }
 
-core::CryptoResult SubstitutionCipher::encrypt(
-    std::span<const uint8_t> plaintext,
+core::CryptoResult SubstitutionCipher::apply(
+    std::span<const uint8_t> input,
+    std::span<uint8_t> output,
     std::span<const uint8_t> key,
-    const core::EncryptionConfig& config
+    bool decrypt
 ) {
-    (void)config;
     core::CryptoResult result;
     auto start = std::chrono::high_resolution_clock::now();
     
     try {
-        auto substitution_map = parse_key(key);
+        auto maps = maps_for(key);
         
-        if (!is_valid_key(substitution_map)) {
+        if (!maps->valid) {
             result.success = false;
             result.error_message = "Invalid key: must be a valid 26-letter permutation";
             return result;
         }
         
-        std::string text(plaintext.begin(), plaintext.end());
-        std::string ciphertext = apply_substitution(text, substitution_map);
+        kernels::substitute(input, output, decrypt ? maps->reverse : maps->forward);
         
         result.success = true;
-        result.data.assign(ciphertext.begin(), ciphertext.end());
         result.algorithm_used = type();
-        result.original_size = plaintext.size();
-        result.final_size = ciphertext.length();
+        result.original_size = input.size();
+        result.final_size = output.size();
         
     } catch (const std::exception& e) {
         result.success = false;
@@ -122,47 +117,52 @@ core::CryptoResult SubstitutionCipher::encrypt(
     return result;
 }
 
+core::CryptoResult SubstitutionCipher::encrypt(
+    std::span<const uint8_t> plaintext,
+    std::span<const uint8_t> key,
+    const core::EncryptionConfig& config
+) {
+    (void)config;
+    std::vector<uint8_t> output(plaintext.size());
+    auto result = apply(plaintext, output, key, false);
+    if (result.success) {
+        result.data = std::move(output);
+    }
+    return result;
+}
+
 core::CryptoResult SubstitutionCipher::decrypt(
     std::span<const uint8_t> ciphertext,
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config
 ) {
     (void)config;
-    core::CryptoResult result;
-    auto start = std::chrono::high_resolution_clock::now();
-    
-    try {
-        auto substitution_map = parse_key(key);
-        
-        if (!is_valid_key(substitution_map)) {
-            result.success = false;
-            result.error_message = "Invalid key: must be a valid 26-letter permutation";
-            return result;
-        }
-        
-        // Create reverse mapping for decryption
-        auto reverse_map = create_reverse_map(substitution_map);
-        
-        std::string text(ciphertext.begin(), ciphertext.end());
-        std::string plaintext = apply_substitution(text, reverse_map);
-        
-        result.success = true;
-        result.data.assign(plaintext.begin(), plaintext.end());
-        result.algorithm_used = type();
-        result.original_size = ciphertext.size();
-        result.final_size = plaintext.length();
-        
-    } catch (const std::exception& e) {
-        result.success = false;
-        result.error_message = e.what();
+    std::vector<uint8_t> output(ciphertext.size());
+    auto result = apply(ciphertext, output, key, true);
+    if (result.success) {
+        result.data = std::move(output);
     }
-    
-    auto end = std::chrono::high_resolution_clock::now();
-    result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
-    
     return result;
 }
 
+core::CryptoResult SubstitutionCipher::encrypt_in_place(
+    std::vector<uint8_t>& buffer,
+    std::span<const uint8_t> key,
+    const core::EncryptionConfig& config
+) {
+    (void)config;
+    return apply(buffer, buffer, key, false);
+}
+
+core::CryptoResult SubstitutionCipher::decrypt_in_place(
+    std::vector<uint8_t>& buffer,
+    std::span<const uint8_t> key,
+    const core::EncryptionConfig& config
+) {
+    (void)config;
+    return apply(buffer, buffer, key, true);
+}
+
 } // namespace classical
 } // namespace algorithms
 } // namespace filevault
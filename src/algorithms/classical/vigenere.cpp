@@ -1,6 +1,5 @@
 #include "filevault/algorithms/classical/vigenere.hpp"
 #include <algorithm>
-#include <cctype>
 #include <chrono>
 
 namespace filevault {
@@ -9,96 +8,115 @@ namespace classical {
 
 Vigenere::Vigenere(const std::string& keyword) : keyword_(keyword) {
     std::transform(keyword_.begin(), keyword_.end(), keyword_.begin(), ::toupper);
+    default_ = build(std::span(reinterpret_cast<const uint8_t*>(keyword_.data()), keyword_.size()));
 }
 
-core::CryptoResult Vigenere::encrypt(
-    std::span<const uint8_t> plaintext,
+std::shared_ptr<const Vigenere::Schedules> Vigenere::build(std::span<const uint8_t> key) {
+    std::string keyword(key.begin(), key.end());
+    std::transform(keyword.begin(), keyword.end(), keyword.begin(), ::toupper);
+    
+    auto schedules = std::make_shared<Schedules>();
+    schedules->key.assign(key.begin(), key.end());
+    schedules->encrypt = kernels::ShiftSchedule::from_keyword(keyword, false);
+    schedules->decrypt = kernels::ShiftSchedule::from_keyword(keyword, true);
+    return schedules;
+}
+
+std::shared_ptr<const Vigenere::Schedules> Vigenere::schedules_for(std::span<const uint8_t> key) const {
+    if (key.empty()) {
+        return default_;
+    }
+    
+    // Runs over many buffers reuse one key, so keep the last one
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        if (cached_ && std::equal(key.begin(), key.end(), cached_->key.begin(), cached_->key.end())) {
+            return cached_;
+        }
+    }
+    auto schedules = build(key);
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    cached_ = schedules;
+    return schedules;
+}
+
+core::CryptoResult Vigenere::apply(
+    std::span<const uint8_t> input,
+    std::span<uint8_t> output,
     std::span<const uint8_t> key,
-    const core::EncryptionConfig& config)
+    bool decrypt) const
 {
-    (void)config;
     auto start = std::chrono::high_resolution_clock::now();
     
-    std::string keyword = keyword_;
-    if (!key.empty()) {
-        keyword = std::string(key.begin(), key.end());
-        std::transform(keyword.begin(), keyword.end(), keyword.begin(), ::toupper);
-    }
-    
-    std::vector<uint8_t> result;
-    result.reserve(plaintext.size());
+    auto schedules = schedules_for(key);
+    const kernels::ShiftSchedule& schedule = decrypt ? schedules->decrypt : schedules->encrypt;
     
-    size_t key_index = 0;
-    for (uint8_t byte : plaintext) {
-        char ch = static_cast<char>(byte);
-        
-        if (std::isalpha(ch)) {
-            char base = std::isupper(ch) ? 'A' : 'a';
-            int shift = keyword[key_index % keyword.size()] - 'A';
-            ch = base + (ch - base + shift) % 26;
-            key_index++;
-        }
-        
-        result.push_back(static_cast<uint8_t>(ch));
+    core::CryptoResult crypto_result;
+    if (schedule.length == 0) {
+        crypto_result.success = false;
+        crypto_result.error_message = "Vigenère keyword must not be empty";
+        return crypto_result;
     }
     
+    kernels::vigenere(input, output, schedule);
+    
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
     
-    core::CryptoResult crypto_result;
     crypto_result.success = true;
-    crypto_result.data = std::move(result);
     crypto_result.algorithm_used = core::AlgorithmType::VIGENERE;
-    crypto_result.original_size = plaintext.size();
-    crypto_result.final_size = result.size();
+    crypto_result.original_size = input.size();
+    crypto_result.final_size = output.size();
     crypto_result.processing_time_ms = duration.count() / 1000.0;
     return crypto_result;
 }
 
+core::CryptoResult Vigenere::encrypt(
+    std::span<const uint8_t> plaintext,
+    std::span<const uint8_t> key,
+    const core::EncryptionConfig& config)
+{
+    (void)config;
+    std::vector<uint8_t> result(plaintext.size());
+    auto crypto_result = apply(plaintext, result, key, false);
+    if (crypto_result.success) {
+        crypto_result.data = std::move(result);
+    }
+    return crypto_result;
+}
+
 core::CryptoResult Vigenere::decrypt(
     std::span<const uint8_t> ciphertext,
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config)
 {
     (void)config;
-    auto start = std::chrono::high_resolution_clock::now();
-    
-    std::string keyword = keyword_;
-    if (!key.empty()) {
-        keyword = std::string(key.begin(), key.end());
-        std::transform(keyword.begin(), keyword.end(), keyword.begin(), ::toupper);
-    }
-    
-    std::vector<uint8_t> result;
-    result.reserve(ciphertext.size());
-    
-    size_t key_index = 0;
-    for (uint8_t byte : ciphertext) {
-        char ch = static_cast<char>(byte);
-        
-        if (std::isalpha(ch)) {
-            char base = std::isupper(ch) ? 'A' : 'a';
-            int shift = keyword[key_index % keyword.size()] - 'A';
-            ch = base + (ch - base - shift + 26) % 26;
-            key_index++;
-        }
-        
-        result.push_back(static_cast<uint8_t>(ch));
+    std::vector<uint8_t> result(ciphertext.size());
+    auto crypto_result = apply(ciphertext, result, key, true);
+    if (crypto_result.success) {
+        crypto_result.data = std::move(result);
     }
-    
-    auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-    
-    core::CryptoResult crypto_result;
-    crypto_result.success = true;
-    crypto_result.data = std::move(result);
-    crypto_result.algorithm_used = core::AlgorithmType::VIGENERE;
-    crypto_result.original_size = ciphertext.size();
-    crypto_result.final_size = result.size();
-    crypto_result.processing_time_ms = duration.count() / 1000.0;
     return crypto_result;
 }
 
+core::CryptoResult Vigenere::encrypt_in_place(
+    std::vector<uint8_t>& buffer,
+    std::span<const uint8_t> key,
+    const core::EncryptionConfig& config)
+{
+    (void)config;
+    return apply(buffer, buffer, key, false);
+}
+
+core::CryptoResult Vigenere::decrypt_in_place(
+    std::vector<uint8_t>& buffer,
+    std::span<const uint8_t> key,
+    const core::EncryptionConfig& config)
+{
+    (void)config;
+    return apply(buffer, buffer, key, true);
+}
+
 } // namespace classical
 } // namespace algorithms
 } // namespace filevault
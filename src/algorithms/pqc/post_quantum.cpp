@@ -7,14 +7,18 @@
 
 #include "filevault/algorithms/pqc/post_quantum.hpp"
 #include "filevault/algorithms/symmetric/aes_gcm.hpp"
-#include <botan/auto_rng.h>
+#include "filevault/core/random.hpp"
+#include "filevault/core/thread_pool.hpp"
 #include <botan/pubkey.h>
 #include <botan/pk_keys.h>
 #include <botan/kyber.h>
 #include <botan/dilithium.h>
 #include <botan/secmem.h>
 #include <spdlog/spdlog.h>
+#include <algorithm>
 #include <chrono>
+#include <future>
+#include <stdexcept>
 
 namespace filevault {
 namespace algorithms {
@@ -64,7 +68,7 @@ Kyber::Kyber(Variant variant) : variant_(variant) {
             type_ = core::AlgorithmType::KYBER_1024;
             break;
     }
-    spdlog::debug("Created Kyber-{} algorithm", 
+    SPDLOG_DEBUG("Created Kyber-{} algorithm", 
         variant == Variant::Kyber512 ? "512" : 
         variant == Variant::Kyber768 ? "768" : "1024");
 }
@@ -132,7 +136,7 @@ PQKeyPair Kyber::generate_keypair() {
     result.algorithm = name();
     
     try {
-        Botan::AutoSeeded_RNG rng;
+        auto& rng = core::RandomService::rng();
         Botan::KyberMode mode = get_kyber_mode(variant_);
         
         Botan::Kyber_PrivateKey private_key(rng, mode);
@@ -142,7 +146,7 @@ PQKeyPair Kyber::generate_keypair() {
         result.private_key.assign(priv_bits.begin(), priv_bits.end());
         result.public_key.assign(pub_bits.begin(), pub_bits.end());
         
-        spdlog::debug("Generated {} key pair: public={} bytes, private={} bytes",
+        SPDLOG_DEBUG("Generated {} key pair: public={} bytes, private={} bytes",
                       name(), result.public_key.size(), result.private_key.size());
         
     } catch (const std::exception& e) {
@@ -162,7 +166,7 @@ core::CryptoResult Kyber::encrypt(
     core::CryptoResult result;
     
     try {
-        Botan::AutoSeeded_RNG rng;
+        auto& rng = core::RandomService::rng();
         Botan::KyberMode mode = get_kyber_mode(variant_);
         
         // Load public key
@@ -181,7 +185,7 @@ core::CryptoResult Kyber::encrypt(
         
         // Store shared secret in nonce field (repurposed for KEM)
         const auto& shared = kem_result.shared_key();
-        result.nonce = std::vector<uint8_t>(shared.begin(), shared.end());
+        result.nonce = core::ShortBytes(shared.begin(), shared.end());
         
         result.success = true;
         result.algorithm_used = type_;
@@ -191,7 +195,7 @@ core::CryptoResult Kyber::encrypt(
         auto end = std::chrono::high_resolution_clock::now();
         result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
         
-        spdlog::debug("Kyber encapsulation: ciphertext={} bytes, shared_secret=32 bytes",
+        SPDLOG_DEBUG("Kyber encapsulation: ciphertext={} bytes, shared_secret=32 bytes",
                       result.data.size());
         
     } catch (const std::exception& e) {
@@ -212,7 +216,7 @@ core::CryptoResult Kyber::decrypt(
     core::CryptoResult result;
     
     try {
-        Botan::AutoSeeded_RNG rng;
+        auto& rng = core::RandomService::rng();
         Botan::KyberMode mode = get_kyber_mode(variant_);
         
         // Load private key
@@ -236,7 +240,7 @@ core::CryptoResult Kyber::decrypt(
         auto end = std::chrono::high_resolution_clock::now();
         result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
         
-        spdlog::debug("Kyber decapsulation: shared_secret={} bytes", result.data.size());
+        SPDLOG_DEBUG("Kyber decapsulation: shared_secret={} bytes", result.data.size());
         
     } catch (const std::exception& e) {
         result.success = false;
@@ -247,6 +251,62 @@ core::CryptoResult Kyber::decrypt(
     return result;
 }
 
+core::Result<asymmetric::LoadedKey> Kyber::load_public_key(std::span<const uint8_t> public_key) const {
+    if (public_key.size() != public_key_size()) {
+        return core::Result<asymmetric::LoadedKey>::error(
+            fmt::format("Invalid {} public key size: {} bytes", name(), public_key.size()));
+    }
+    try {
+        return core::Result<asymmetric::LoadedKey>::ok(asymmetric::LoadedKey::from_public_key(
+            std::make_unique<Botan::Kyber_PublicKey>(public_key, get_kyber_mode(variant_))));
+    } catch (const std::exception& e) {
+        return core::Result<asymmetric::LoadedKey>::error(std::string("Failed to load Kyber key: ") + e.what());
+    }
+}
+
+core::Result<asymmetric::LoadedKey> Kyber::load_private_key(std::span<const uint8_t> private_key) const {
+    if (private_key.size() != private_key_size()) {
+        return core::Result<asymmetric::LoadedKey>::error(
+            fmt::format("Invalid {} private key size: {} bytes", name(), private_key.size()));
+    }
+    try {
+        return core::Result<asymmetric::LoadedKey>::ok(asymmetric::LoadedKey::from_private_key(
+            std::make_unique<Botan::Kyber_PrivateKey>(private_key, get_kyber_mode(variant_))));
+    } catch (const std::exception& e) {
+        return core::Result<asymmetric::LoadedKey>::error(std::string("Failed to load Kyber key: ") + e.what());
+    }
+}
+
+std::vector<asymmetric::Encapsulation> Kyber::encapsulate_batch(
+    const asymmetric::LoadedKey& public_key,
+    size_t count,
+    size_t threads
+) const {
+    std::vector<asymmetric::Encapsulation> results(count);
+    core::parallel_for(count, threads, [&](size_t i) {
+        results[i] = public_key.encapsulate(shared_secret_size(), "Raw");
+    });
+    return results;
+}
+
+std::vector<Botan::secure_vector<uint8_t>> Kyber::decapsulate_batch(
+    const asymmetric::LoadedKey& private_key,
+    const std::vector<std::vector<uint8_t>>& ciphertexts,
+    size_t threads
+) const {
+    for (const auto& ciphertext : ciphertexts) {
+        if (ciphertext.size() != ciphertext_size()) {
+            throw std::invalid_argument(fmt::format("Invalid {} ciphertext size: {} bytes",
+                                                    name(), ciphertext.size()));
+        }
+    }
+    std::vector<Botan::secure_vector<uint8_t>> results(ciphertexts.size());
+    core::parallel_for(ciphertexts.size(), threads, [&](size_t i) {
+        results[i] = private_key.decapsulate(ciphertexts[i], shared_secret_size(), "Raw");
+    });
+    return results;
+}
+
 // ============================================================================
 // Dilithium Implementation
 // ============================================================================
@@ -264,7 +324,7 @@ Dilithium::Dilithium(Variant variant) : variant_(variant) {
             break;
     }
     
-    spdlog::debug("Created {} signature algorithm", botan_name_);
+    SPDLOG_DEBUG("Created {} signature algorithm", botan_name_);
 }
 
 std::string Dilithium::name() const {
@@ -308,7 +368,7 @@ PQKeyPair Dilithium::generate_keypair() {
     result.algorithm = name();
     
     try {
-        Botan::AutoSeeded_RNG rng;
+        auto& rng = core::RandomService::rng();
         Botan::DilithiumMode mode = get_dilithium_mode(variant_);
         
         Botan::Dilithium_PrivateKey private_key(rng, mode);
@@ -318,7 +378,7 @@ PQKeyPair Dilithium::generate_keypair() {
         result.private_key.assign(priv_bits.begin(), priv_bits.end());
         result.public_key.assign(pub_bits.begin(), pub_bits.end());
         
-        spdlog::debug("Generated {} key pair: public={} bytes, private={} bytes",
+        SPDLOG_DEBUG("Generated {} key pair: public={} bytes, private={} bytes",
                       name(), result.public_key.size(), result.private_key.size());
         
     } catch (const std::exception& e) {
@@ -334,7 +394,7 @@ std::vector<uint8_t> Dilithium::sign(
     std::span<const uint8_t> private_key
 ) {
     try {
-        Botan::AutoSeeded_RNG rng;
+        auto& rng = core::RandomService::rng();
         Botan::DilithiumMode mode = get_dilithium_mode(variant_);
         
         // Load private key
@@ -347,7 +407,7 @@ std::vector<uint8_t> Dilithium::sign(
         // Sign message
         auto signature = signer.sign_message(message.data(), message.size(), rng);
         
-        spdlog::debug("Signed message: {} bytes -> signature {} bytes",
+        SPDLOG_DEBUG("Signed message: {} bytes -> signature {} bytes",
                       message.size(), signature.size());
         
         return signature;
@@ -379,7 +439,7 @@ bool Dilithium::verify(
             signature.data(), signature.size()
         );
         
-        spdlog::debug("Signature verification: {}", valid ? "VALID" : "INVALID");
+        SPDLOG_DEBUG("Signature verification: {}", valid ? "VALID" : "INVALID");
         
         return valid;
         
@@ -389,12 +449,67 @@ bool Dilithium::verify(
     }
 }
 
+core::Result<asymmetric::LoadedKey> Dilithium::load_public_key(std::span<const uint8_t> public_key) const {
+    if (public_key.size() != public_key_size()) {
+        return core::Result<asymmetric::LoadedKey>::error(
+            fmt::format("Invalid {} public key size: {} bytes", name(), public_key.size()));
+    }
+    try {
+        return core::Result<asymmetric::LoadedKey>::ok(asymmetric::LoadedKey::from_public_key(
+            std::make_unique<Botan::Dilithium_PublicKey>(public_key, get_dilithium_mode(variant_))));
+    } catch (const std::exception& e) {
+        return core::Result<asymmetric::LoadedKey>::error(std::string("Failed to load Dilithium key: ") + e.what());
+    }
+}
+
+core::Result<asymmetric::LoadedKey> Dilithium::load_private_key(std::span<const uint8_t> private_key) const {
+    if (private_key.size() != private_key_size()) {
+        return core::Result<asymmetric::LoadedKey>::error(
+            fmt::format("Invalid {} private key size: {} bytes", name(), private_key.size()));
+    }
+    try {
+        return core::Result<asymmetric::LoadedKey>::ok(asymmetric::LoadedKey::from_private_key(
+            std::make_unique<Botan::Dilithium_PrivateKey>(private_key, get_dilithium_mode(variant_))));
+    } catch (const std::exception& e) {
+        return core::Result<asymmetric::LoadedKey>::error(std::string("Failed to load Dilithium key: ") + e.what());
+    }
+}
+
+std::vector<std::vector<uint8_t>> Dilithium::sign_batch(
+    const asymmetric::LoadedKey& private_key,
+    const std::vector<std::vector<uint8_t>>& messages,
+    size_t threads
+) const {
+    std::vector<std::vector<uint8_t>> signatures(messages.size());
+    core::parallel_for(messages.size(), threads, [&](size_t i) {
+        signatures[i] = private_key.sign(messages[i], "");
+    });
+    return signatures;
+}
+
+std::vector<bool> Dilithium::verify_batch(
+    const asymmetric::LoadedKey& public_key,
+    const std::vector<std::vector<uint8_t>>& messages,
+    const std::vector<std::vector<uint8_t>>& signatures,
+    size_t threads
+) const {
+    if (messages.size() != signatures.size()) {
+        throw std::invalid_argument("verify_batch needs one signature per message");
+    }
+    // Bytes, not vector<bool>: workers write neighbouring slots concurrently
+    std::vector<uint8_t> valid(messages.size(), 0);
+    core::parallel_for(messages.size(), threads, [&](size_t i) {
+        valid[i] = public_key.verify(messages[i], signatures[i], "") ? 1 : 0;
+    });
+    return std::vector<bool>(valid.begin(), valid.end());
+}
+
 // ============================================================================
 // KyberHybrid Implementation (Kyber + AES-256-GCM)
 // ============================================================================
 
 KyberHybrid::KyberHybrid(Kyber::Variant variant) : kyber_(variant) {
-    spdlog::debug("Created KyberHybrid with {}", kyber_.name());
+    SPDLOG_DEBUG("Created KyberHybrid with {}", kyber_.name());
 }
 
 std::string KyberHybrid::name() const {
@@ -516,7 +631,7 @@ core::CryptoResult KyberHybrid::encrypt(
         auto end = std::chrono::high_resolution_clock::now();
         result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
         
-        spdlog::debug("KyberHybrid encrypt: {} bytes -> {} bytes",
+        SPDLOG_DEBUG("KyberHybrid encrypt: {} bytes -> {} bytes",
                       plaintext.size(), result.data.size());
         
     } catch (const std::exception& e) {
@@ -592,8 +707,8 @@ core::CryptoResult KyberHybrid::decrypt(
         
         core::EncryptionConfig aes_config = config;
         aes_config.algorithm = core::AlgorithmType::AES_256_GCM;
-        aes_config.nonce = std::vector<uint8_t>(aes_nonce.begin(), aes_nonce.end());
-        aes_config.tag = std::vector<uint8_t>(aes_tag.begin(), aes_tag.end());
+        aes_config.nonce = core::ShortBytes(aes_nonce.begin(), aes_nonce.end());
+        aes_config.tag = core::ShortBytes(aes_tag.begin(), aes_tag.end());
         
         auto aes_result = aes.decrypt(aes_ct, kem_result.data, aes_config);
         
@@ -612,7 +727,7 @@ core::CryptoResult KyberHybrid::decrypt(
         auto end = std::chrono::high_resolution_clock::now();
         result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
         
-        spdlog::debug("KyberHybrid decrypt: {} bytes -> {} bytes",
+        SPDLOG_DEBUG("KyberHybrid decrypt: {} bytes -> {} bytes",
                       ciphertext.size(), result.data.size());
         
     } catch (const std::exception& e) {
@@ -0,0 +1,432 @@
+/**
+ * @file aead_session.cpp
+ * @brief Keyed AEAD session implementation
+ */
+
+#include "filevault/algorithms/symmetric/aead_session.hpp"
+#include "filevault/core/random.hpp"
+#include "filevault/utils/trace.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace filevault {
+namespace algorithms {
+namespace symmetric {
+
+AeadSession::AeadSession(
+    std::string botan_name,
+    core::AlgorithmType type,
+    std::span<const uint8_t> key,
+    size_t nonce_size,
+    size_t tag_size,
+    bool tag_first)
+    : botan_name_(std::move(botan_name)),
+      type_(type),
+      key_(key.begin(), key.end()),
+      nonce_size_(nonce_size),
+      tag_size_(tag_size),
+      tag_first_(tag_first) {}
+
+Botan::AEAD_Mode& AeadSession::mode(std::unique_ptr<Botan::AEAD_Mode>& slot, Botan::Cipher_Dir direction) {
+    if (!slot) {
+        slot = Botan::AEAD_Mode::create_or_throw(botan_name_, direction);
+        slot->set_key(key_);
+    }
+    return *slot;
+}
+
+void AeadSession::set_associated_data(Botan::AEAD_Mode& cipher, const core::EncryptionConfig& config) {
+    // Associated data persists between messages in Botan, so always set it
+    if (config.associated_data.has_value()) {
+        const auto& ad = config.associated_data.value();
+        cipher.set_associated_data(ad.data(), ad.size());
+    } else {
+        cipher.set_associated_data(nullptr, 0);
+    }
+}
+
+core::CryptoResult AeadSession::encrypt_in_place(
+    std::vector<uint8_t>& buffer,
+    const core::EncryptionConfig& config) {
+    utils::ScopedSpan trace_span("AeadSession::encrypt_in_place", "cipher", buffer.size());
+    
+    core::CryptoResult result;
+    size_t plaintext_len = buffer.size();
+    
+    try {
+        // Same nonce rules as ICryptoAlgorithm::encrypt()
+        core::ShortBytes nonce;
+        if (config.nonce.has_value() && config.nonce.value().size() == nonce_size_) {
+            nonce = config.nonce.value();
+        } else {
+            auto& rng = core::RandomService::rng();
+            nonce.resize(nonce_size_);
+            rng.randomize(nonce.data(), nonce.size());
+        }
+        
+        auto& cipher = mode(encryptor_, Botan::Cipher_Dir::Encryption);
+        set_associated_data(cipher, config);
+        
+        cipher.start(nonce.data(), nonce.size());
+        cipher.finish(buffer);
+        
+        if (buffer.size() != plaintext_len + tag_size_) {
+            result.success = false;
+            result.error_message = "Invalid ciphertext size";
+            return result;
+        }
+        
+        // Split off the tag, leaving only ciphertext in the buffer
+        if (tag_first_) {
+            result.tag = core::ShortBytes(buffer.begin(), buffer.begin() + tag_size_);
+            buffer.erase(buffer.begin(), buffer.begin() + tag_size_);
+        } else {
+            result.tag = core::ShortBytes(buffer.end() - tag_size_, buffer.end());
+            buffer.resize(plaintext_len);
+        }
+        
+        result.nonce = nonce;
+        result.success = true;
+        result.algorithm_used = type_;
+        result.original_size = plaintext_len;
+        result.final_size = buffer.size();
+        return result;
+        
+    } catch (const std::exception& e) {
+        // Drop the mode so a half-finished message can't leak into the next one
+        encryptor_.reset();
+        result.success = false;
+        result.error_message = std::string("Encryption failed: ") + e.what();
+        return result;
+    }
+}
+
+core::CryptoResult AeadSession::decrypt_in_place(
+    std::vector<uint8_t>& buffer,
+    const core::EncryptionConfig& config) {
+    utils::ScopedSpan trace_span("AeadSession::decrypt_in_place", "cipher", buffer.size());
+    
+    core::CryptoResult result;
+    size_t ciphertext_len = buffer.size();
+    
+    if (!config.nonce.has_value() || !config.tag.has_value()) {
+        result.success = false;
+        result.error_message = "Nonce and tag must be provided in config";
+        return result;
+    }
+    
+    const auto& nonce = config.nonce.value();
+    const auto& tag = config.tag.value();
+    
+    if (nonce.size() != nonce_size_ || tag.size() != tag_size_) {
+        result.success = false;
+        result.error_message = "Invalid nonce or tag size";
+        return result;
+    }
+    
+    try {
+        auto& cipher = mode(decryptor_, Botan::Cipher_Dir::Decryption);
+        set_associated_data(cipher, config);
+        
+        cipher.start(nonce.data(), nonce.size());
+        
+        // Add the tag and decrypt + verify in the caller's buffer
+        buffer.insert(tag_first_ ? buffer.begin() : buffer.end(), tag.begin(), tag.end());
+        cipher.finish(buffer);
+        
+        result.success = true;
+        result.algorithm_used = type_;
+        result.original_size = ciphertext_len;
+        result.final_size = buffer.size();
+        return result;
+        
+    } catch (const Botan::Invalid_Authentication_Tag&) {
+        // Never hand back unauthenticated plaintext
+        std::fill(buffer.begin(), buffer.end(), 0);
+        buffer.clear();
+        result.success = false;
+        result.error_message = "Authentication failed: Invalid tag (data may be corrupted or tampered)";
+        return result;
+    } catch (const std::exception& e) {
+        decryptor_.reset();
+        std::fill(buffer.begin(), buffer.end(), 0);
+        buffer.clear();
+        result.success = false;
+        result.error_message = std::string("Decryption failed: ") + e.what();
+        return result;
+    }
+}
+
+core::BatchResult AeadSession::encrypt_batch(
+    std::span<const std::span<const uint8_t>> messages,
+    const core::EncryptionConfig& config,
+    std::vector<uint8_t>& arena) {
+    
+    core::BatchResult result;
+    size_t arena_start = arena.size();
+    size_t index = 0;
+    
+    try {
+        size_t total = 0;
+        for (const auto& message : messages) {
+            total += nonce_size_ + message.size() + tag_size_;
+        }
+        arena.reserve(arena_start + total);
+        result.records.reserve(messages.size());
+        
+        // Batch nonces only need to be unique: take a range from the counter
+        if (!nonce_counter_) {
+            nonce_counter_ = std::make_unique<core::CounterNonce>(nonce_size_);
+        }
+        std::vector<uint8_t> nonces(messages.size() * nonce_size_);
+        nonce_counter_->next_n(nonces, messages.size());
+        
+        auto& cipher = mode(encryptor_, Botan::Cipher_Dir::Encryption);
+        set_associated_data(cipher, config);
+        
+        for (; index < messages.size(); ++index) {
+            const auto& message = messages[index];
+            const uint8_t* nonce = nonces.data() + index * nonce_size_;
+            
+            core::BatchRecord record;
+            record.offset = arena.size();
+            record.nonce_size = nonce_size_;
+            record.data_size = message.size();
+            record.tag_size = tag_size_;
+            
+            // Botan encrypts from data_offset() to the end and appends the tag
+            arena.insert(arena.end(), nonce, nonce + nonce_size_);
+            arena.insert(arena.end(), message.begin(), message.end());
+            cipher.start(nonce, nonce_size_);
+            cipher.finish(arena, record.data_offset());
+            
+            if (arena.size() != record.offset + record.total_size()) {
+                throw std::runtime_error("Invalid ciphertext size");
+            }
+            if (tag_first_) {
+                auto data = arena.begin() + record.data_offset();
+                std::rotate(data, data + tag_size_, arena.end());
+            }
+            result.records.push_back(record);
+        }
+        
+        result.success = true;
+        return result;
+        
+    } catch (const std::exception& e) {
+        encryptor_.reset();
+        arena.resize(arena_start);
+        result.records.clear();
+        result.failed_index = index;
+        result.error_message = std::string("Encryption failed: ") + e.what();
+        return result;
+    }
+}
+
+core::BatchResult AeadSession::decrypt_batch(
+    std::span<const uint8_t> arena,
+    std::span<const core::BatchRecord> records,
+    const core::EncryptionConfig& config,
+    std::vector<uint8_t>& output) {
+    
+    core::BatchResult result;
+    size_t output_start = output.size();
+    size_t index = 0;
+    
+    auto fail = [&](std::string message) {
+        std::fill(output.begin() + output_start, output.end(), 0);
+        output.resize(output_start);
+        result.records.clear();
+        result.failed_index = index;
+        result.error_message = std::move(message);
+        return result;
+    };
+    
+    // Validate the whole batch before touching the output
+    size_t total = 0;
+    for (; index < records.size(); ++index) {
+        const auto& record = records[index];
+        if (record.nonce_size != nonce_size_ || record.tag_size != tag_size_) {
+            return fail("Invalid nonce or tag size");
+        }
+        if (record.offset > arena.size() || record.total_size() > arena.size() - record.offset) {
+            return fail("Record out of bounds");
+        }
+        total += record.data_size + tag_size_;
+    }
+    
+    index = 0;
+    try {
+        output.reserve(output_start + total);
+        result.records.reserve(records.size());
+        
+        auto& cipher = mode(decryptor_, Botan::Cipher_Dir::Decryption);
+        set_associated_data(cipher, config);
+        
+        for (; index < records.size(); ++index) {
+            const auto& record = records[index];
+            
+            // Ciphertext and tag are adjacent, so copy both and open in place
+            core::BatchRecord plain;
+            plain.offset = output.size();
+            plain.data_size = record.data_size;
+            
+            auto sealed = arena.subspan(record.data_offset(), record.data_size + tag_size_);
+            output.insert(output.end(), sealed.begin(), sealed.end());
+            if (tag_first_) {
+                auto data = output.begin() + plain.offset;
+                std::rotate(data, output.end() - tag_size_, output.end());
+            }
+            cipher.start(arena.data() + record.offset, nonce_size_);
+            cipher.finish(output, plain.offset);
+            result.records.push_back(plain);
+        }
+        
+        result.success = true;
+        return result;
+        
+    } catch (const Botan::Invalid_Authentication_Tag&) {
+        // Never hand back unauthenticated plaintext
+        return fail("Authentication failed: Invalid tag (data may be corrupted or tampered)");
+    } catch (const std::exception& e) {
+        decryptor_.reset();
+        return fail(std::string("Decryption failed: ") + e.what());
+    }
+}
+
+bool AeadSession::encrypt_begin(const core::EncryptionConfig& config) {
+    if (tag_first_ || !config.nonce.has_value() || config.nonce.value().size() != nonce_size_) {
+        return false;
+    }
+    
+    try {
+        auto& cipher = mode(encryptor_, Botan::Cipher_Dir::Encryption);
+        set_associated_data(cipher, config);
+        cipher.start(config.nonce.value().data(), nonce_size_);
+        pending_nonce_ = config.nonce.value();
+        return true;
+    } catch (const std::exception&) {
+        encryptor_.reset();
+        return false;
+    }
+}
+
+size_t AeadSession::encrypt_update(std::span<uint8_t> buffer) {
+    utils::ScopedSpan trace_span("AeadSession::encrypt_update", "cipher", buffer.size());
+    if (!encryptor_ || pending_nonce_.empty()) {
+        throw std::logic_error("encrypt_update() without encrypt_begin()");
+    }
+    return encryptor_->process(buffer.data(), buffer.size());
+}
+
+core::CryptoResult AeadSession::encrypt_finish(std::vector<uint8_t>& buffer) {
+    core::CryptoResult result;
+    if (!encryptor_ || pending_nonce_.empty()) {
+        buffer.clear();
+        result.success = false;
+        result.error_message = "encrypt_finish() without encrypt_begin()";
+        return result;
+    }
+    
+    try {
+        size_t plaintext_len = buffer.size();
+        encryptor_->finish(buffer);
+        if (buffer.size() != plaintext_len + tag_size_) {
+            encryptor_.reset();
+            pending_nonce_.clear();
+            buffer.clear();
+            result.success = false;
+            result.error_message = "Invalid ciphertext size";
+            return result;
+        }
+        
+        result.tag = core::ShortBytes(buffer.end() - tag_size_, buffer.end());
+        buffer.resize(plaintext_len);
+        result.nonce = pending_nonce_;
+        pending_nonce_.clear();
+        result.success = true;
+        result.algorithm_used = type_;
+        result.final_size = buffer.size();
+        return result;
+        
+    } catch (const std::exception& e) {
+        encryptor_.reset();
+        pending_nonce_.clear();
+        buffer.clear();
+        result.success = false;
+        result.error_message = std::string("Encryption failed: ") + e.what();
+        return result;
+    }
+}
+
+size_t AeadSession::encrypt_granularity() const {
+    return encryptor_ ? std::max<size_t>(1, encryptor_->ideal_granularity()) : 1;
+}
+
+bool AeadSession::decrypt_begin(const core::EncryptionConfig& config) {
+    if (tag_first_ || !config.nonce.has_value() || !config.tag.has_value() ||
+        config.nonce.value().size() != nonce_size_ || config.tag.value().size() != tag_size_) {
+        return false;
+    }
+    
+    try {
+        auto& cipher = mode(decryptor_, Botan::Cipher_Dir::Decryption);
+        set_associated_data(cipher, config);
+        cipher.start(config.nonce.value().data(), nonce_size_);
+        pending_tag_ = config.tag.value();
+        return true;
+    } catch (const std::exception&) {
+        decryptor_.reset();
+        return false;
+    }
+}
+
+size_t AeadSession::decrypt_update(std::span<uint8_t> buffer) {
+    utils::ScopedSpan trace_span("AeadSession::decrypt_update", "cipher", buffer.size());
+    if (!decryptor_ || pending_tag_.empty()) {
+        throw std::logic_error("decrypt_update() without decrypt_begin()");
+    }
+    return decryptor_->process(buffer.data(), buffer.size());
+}
+
+core::CryptoResult AeadSession::decrypt_finish(std::vector<uint8_t>& buffer) {
+    core::CryptoResult result;
+    if (!decryptor_ || pending_tag_.empty()) {
+        buffer.clear();
+        result.success = false;
+        result.error_message = "decrypt_finish() without decrypt_begin()";
+        return result;
+    }
+    
+    try {
+        buffer.insert(buffer.end(), pending_tag_.begin(), pending_tag_.end());
+        pending_tag_.clear();
+        decryptor_->finish(buffer);
+        result.success = true;
+        result.algorithm_used = type_;
+        result.final_size = buffer.size();
+        return result;
+        
+    } catch (const Botan::Invalid_Authentication_Tag&) {
+        std::fill(buffer.begin(), buffer.end(), 0);
+        buffer.clear();
+        result.success = false;
+        result.error_message = "Authentication failed: Invalid tag (data may be corrupted or tampered)";
+        return result;
+    } catch (const std::exception& e) {
+        decryptor_.reset();
+        std::fill(buffer.begin(), buffer.end(), 0);
+        buffer.clear();
+        result.success = false;
+        result.error_message = std::string("Decryption failed: ") + e.what();
+        return result;
+    }
+}
+
+size_t AeadSession::decrypt_granularity() const {
+    return decryptor_ ? std::max<size_t>(1, decryptor_->ideal_granularity()) : 1;
+}
+
+} // namespace symmetric
+} // namespace algorithms
+} // namespace filevault
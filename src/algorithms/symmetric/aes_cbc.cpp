@@ -4,7 +4,8 @@
  */
 
 #include "filevault/algorithms/symmetric/aes_cbc.hpp"
-#include <botan/auto_rng.h>
+#include "filevault/core/random.hpp"
+#include "filevault/utils/trace.hpp"
 #include <botan/hex.h>
 #include <spdlog/spdlog.h>
 #include <chrono>
@@ -34,7 +35,7 @@ AES_CBC::AES_CBC(size_t key_bits) : key_bits_(key_bits) {
             break;
     }
     
-    spdlog::debug("Created AES-{}-CBC algorithm", key_bits);
+    SPDLOG_DEBUG("Created AES-{}-CBC algorithm", key_bits);
 }
 
 std::string AES_CBC::name() const {
@@ -50,6 +51,7 @@ core::CryptoResult AES_CBC::encrypt(
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config
 ) {
+    utils::ScopedSpan trace_span("AES_CBC::encrypt", "cipher", plaintext.size());
     auto start = std::chrono::high_resolution_clock::now();
     core::CryptoResult result;
     
@@ -67,12 +69,12 @@ core::CryptoResult AES_CBC::encrypt(
         std::vector<uint8_t> iv;
         if (config.nonce.has_value() && config.nonce.value().size() == iv_size()) {
             iv = config.nonce.value();
-            spdlog::debug("AES-CBC: Using provided IV");
+            SPDLOG_DEBUG("AES-CBC: Using provided IV");
         } else {
-            Botan::AutoSeeded_RNG rng;
+            auto& rng = core::RandomService::rng();
             iv.resize(iv_size());
             rng.randomize(iv.data(), iv.size());
-            spdlog::debug("AES-CBC: Generated new IV ({} bytes)", iv.size());
+            SPDLOG_DEBUG("AES-CBC: Generated new IV ({} bytes)", iv.size());
         }
         
         // Create cipher
@@ -102,7 +104,7 @@ core::CryptoResult AES_CBC::encrypt(
         auto end = std::chrono::high_resolution_clock::now();
         result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
         
-        spdlog::debug("AES-{}-CBC encryption: {} bytes -> {} bytes in {:.2f}ms",
+        SPDLOG_DEBUG("AES-{}-CBC encryption: {} bytes -> {} bytes in {:.2f}ms",
                       key_bits_, plaintext.size(), result.data.size(), 
                       result.processing_time_ms);
         
@@ -124,6 +126,7 @@ core::CryptoResult AES_CBC::decrypt(
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config
 ) {
+    utils::ScopedSpan trace_span("AES_CBC::decrypt", "cipher", ciphertext.size());
     auto start = std::chrono::high_resolution_clock::now();
     core::CryptoResult result;
     
@@ -179,7 +182,7 @@ core::CryptoResult AES_CBC::decrypt(
         auto end = std::chrono::high_resolution_clock::now();
         result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
         
-        spdlog::debug("AES-{}-CBC decryption: {} bytes -> {} bytes in {:.2f}ms",
+        SPDLOG_DEBUG("AES-{}-CBC decryption: {} bytes -> {} bytes in {:.2f}ms",
                       key_bits_, ciphertext.size(), result.data.size(), 
                       result.processing_time_ms);
         
@@ -4,7 +4,8 @@
  */
 
 #include "filevault/algorithms/symmetric/aes_cfb.hpp"
-#include <botan/auto_rng.h>
+#include "filevault/core/random.hpp"
+#include "filevault/utils/trace.hpp"
 #include <botan/hex.h>
 #include <spdlog/spdlog.h>
 #include <chrono>
@@ -34,7 +35,7 @@ AES_CFB::AES_CFB(size_t key_bits) : key_bits_(key_bits) {
             break;
     }
     
-    spdlog::debug("Created AES-{}-CFB algorithm", key_bits);
+    SPDLOG_DEBUG("Created AES-{}-CFB algorithm", key_bits);
 }
 
 std::string AES_CFB::name() const {
@@ -50,6 +51,7 @@ core::CryptoResult AES_CFB::encrypt(
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config
 ) {
+    utils::ScopedSpan trace_span("AES_CFB::encrypt", "cipher", plaintext.size());
     auto start = std::chrono::high_resolution_clock::now();
     core::CryptoResult result;
     
@@ -67,7 +69,7 @@ core::CryptoResult AES_CFB::encrypt(
         if (config.nonce.has_value() && config.nonce.value().size() == iv_size()) {
             iv = config.nonce.value();
         } else {
-            Botan::AutoSeeded_RNG rng;
+            auto& rng = core::RandomService::rng();
             iv.resize(iv_size());
             rng.randomize(iv.data(), iv.size());
         }
@@ -110,6 +112,7 @@ core::CryptoResult AES_CFB::decrypt(
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config
 ) {
+    utils::ScopedSpan trace_span("AES_CFB::decrypt", "cipher", ciphertext.size());
     auto start = std::chrono::high_resolution_clock::now();
     core::CryptoResult result;
     
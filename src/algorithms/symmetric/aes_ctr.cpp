@@ -4,7 +4,9 @@
  */
 
 #include "filevault/algorithms/symmetric/aes_ctr.hpp"
-#include <botan/auto_rng.h>
+#include "filevault/core/offload.hpp"
+#include "filevault/core/random.hpp"
+#include "filevault/utils/trace.hpp"
 #include <botan/hex.h>
 #include <spdlog/spdlog.h>
 #include <chrono>
@@ -13,6 +15,26 @@ namespace filevault {
 namespace algorithms {
 namespace symmetric {
 
+namespace {
+
+/**
+ * @brief XOR the keystream on the offload device, if one is active and data is large
+ * @return false if the caller must do it on the CPU (data is unchanged)
+ */
+bool offload_keystream(std::span<const uint8_t> key, std::span<const uint8_t> nonce, std::vector<uint8_t>& data) {
+    auto* device = core::Offload::device();
+    if (!device || data.size() < core::Offload::min_bytes() || nonce.size() != 16) {
+        return false;
+    }
+    auto status = device->aes_ctr(key, std::span<const uint8_t, 16>(nonce.data(), 16), data);
+    if (status == core::OffloadStatus::FAILED) {
+        core::Offload::disable("keystream call failed");
+    }
+    return status == core::OffloadStatus::DONE;
+}
+
+} // anonymous namespace
+
 AES_CTR::AES_CTR(size_t key_bits) : key_bits_(key_bits) {
     if (key_bits != 128 && key_bits != 192 && key_bits != 256) {
         throw std::invalid_argument("AES-CTR key size must be 128, 192, or 256 bits");
@@ -34,7 +56,7 @@ AES_CTR::AES_CTR(size_t key_bits) : key_bits_(key_bits) {
             break;
     }
     
-    spdlog::debug("Created AES-{}-CTR algorithm", key_bits);
+    SPDLOG_DEBUG("Created AES-{}-CTR algorithm", key_bits);
 }
 
 std::string AES_CTR::name() const {
@@ -50,6 +72,7 @@ core::CryptoResult AES_CTR::encrypt(
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config
 ) {
+    utils::ScopedSpan trace_span("AES_CTR::encrypt", "cipher", plaintext.size());
     auto start = std::chrono::high_resolution_clock::now();
     core::CryptoResult result;
     
@@ -67,32 +90,35 @@ core::CryptoResult AES_CTR::encrypt(
         std::vector<uint8_t> nonce;
         if (config.nonce.has_value() && config.nonce.value().size() == nonce_size()) {
             nonce = config.nonce.value();
-            spdlog::debug("AES-CTR: Using provided nonce");
+            SPDLOG_DEBUG("AES-CTR: Using provided nonce");
         } else {
-            Botan::AutoSeeded_RNG rng;
+            auto& rng = core::RandomService::rng();
             nonce.resize(nonce_size());
             rng.randomize(nonce.data(), nonce.size());
-            spdlog::debug("AES-CTR: Generated new nonce ({} bytes)", nonce.size());
+            SPDLOG_DEBUG("AES-CTR: Generated new nonce ({} bytes)", nonce.size());
         }
         
-        // Create cipher
-        auto cipher = Botan::Cipher_Mode::create(botan_name_, Botan::Cipher_Dir::Encryption);
-        if (!cipher) {
-            result.success = false;
-            result.error_message = "Failed to create AES-CTR cipher";
-            return result;
+        // Large inputs go to the offload device when there is one
+        result.data.assign(plaintext.begin(), plaintext.end());
+        if (!offload_keystream(key, nonce, result.data)) {
+            auto cipher = Botan::Cipher_Mode::create(botan_name_, Botan::Cipher_Dir::Encryption);
+            if (!cipher) {
+                result.success = false;
+                result.error_message = "Failed to create AES-CTR cipher";
+                return result;
+            }
+            
+            // Set key and nonce
+            cipher->set_key(key.data(), key.size());
+            cipher->start(nonce);
+            
+            // Encrypt (no padding in CTR mode)
+            Botan::secure_vector<uint8_t> buffer(plaintext.begin(), plaintext.end());
+            cipher->finish(buffer);
+            result.data.assign(buffer.begin(), buffer.end());
         }
         
-        // Set key and nonce
-        cipher->set_key(key.data(), key.size());
-        cipher->start(nonce);
-        
-        // Encrypt (no padding in CTR mode)
-        Botan::secure_vector<uint8_t> buffer(plaintext.begin(), plaintext.end());
-        cipher->finish(buffer);
-        
         // Store result
-        result.data.assign(buffer.begin(), buffer.end());
         result.nonce = std::move(nonce);
         result.success = true;
         result.algorithm_used = type_;
@@ -102,7 +128,7 @@ core::CryptoResult AES_CTR::encrypt(
         auto end = std::chrono::high_resolution_clock::now();
         result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
         
-        spdlog::debug("AES-{}-CTR encryption: {} bytes -> {} bytes in {:.2f}ms",
+        SPDLOG_DEBUG("AES-{}-CTR encryption: {} bytes -> {} bytes in {:.2f}ms",
                       key_bits_, plaintext.size(), result.data.size(), 
                       result.processing_time_ms);
         
@@ -124,6 +150,7 @@ core::CryptoResult AES_CTR::decrypt(
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config
 ) {
+    utils::ScopedSpan trace_span("AES_CTR::decrypt", "cipher", ciphertext.size());
     auto start = std::chrono::high_resolution_clock::now();
     core::CryptoResult result;
     
@@ -146,24 +173,27 @@ core::CryptoResult AES_CTR::decrypt(
         
         auto& nonce = config.nonce.value();
         
-        // Create cipher (CTR encryption and decryption are the same)
-        auto cipher = Botan::Cipher_Mode::create(botan_name_, Botan::Cipher_Dir::Encryption);
-        if (!cipher) {
-            result.success = false;
-            result.error_message = "Failed to create AES-CTR cipher";
-            return result;
+        result.data.assign(ciphertext.begin(), ciphertext.end());
+        if (!offload_keystream(key, nonce, result.data)) {
+            // Create cipher (CTR encryption and decryption are the same)
+            auto cipher = Botan::Cipher_Mode::create(botan_name_, Botan::Cipher_Dir::Encryption);
+            if (!cipher) {
+                result.success = false;
+                result.error_message = "Failed to create AES-CTR cipher";
+                return result;
+            }
+            
+            // Set key and nonce
+            cipher->set_key(key.data(), key.size());
+            cipher->start(nonce);
+            
+            // Decrypt
+            Botan::secure_vector<uint8_t> buffer(ciphertext.begin(), ciphertext.end());
+            cipher->finish(buffer);
+            result.data.assign(buffer.begin(), buffer.end());
         }
         
-        // Set key and nonce
-        cipher->set_key(key.data(), key.size());
-        cipher->start(nonce);
-        
-        // Decrypt
-        Botan::secure_vector<uint8_t> buffer(ciphertext.begin(), ciphertext.end());
-        cipher->finish(buffer);
-        
         // Store result
-        result.data.assign(buffer.begin(), buffer.end());
         result.success = true;
         result.algorithm_used = type_;
         result.original_size = ciphertext.size();
@@ -172,7 +202,7 @@ core::CryptoResult AES_CTR::decrypt(
         auto end = std::chrono::high_resolution_clock::now();
         result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
         
-        spdlog::debug("AES-{}-CTR decryption: {} bytes -> {} bytes in {:.2f}ms",
+        SPDLOG_DEBUG("AES-{}-CTR decryption: {} bytes -> {} bytes in {:.2f}ms",
                       key_bits_, ciphertext.size(), result.data.size(), 
                       result.processing_time_ms);
         
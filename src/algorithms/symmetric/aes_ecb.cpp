@@ -9,6 +9,7 @@
  */
 
 #include "filevault/algorithms/symmetric/aes_ecb.hpp"
+#include "filevault/utils/trace.hpp"
 #include <botan/block_cipher.h>
 #include <botan/auto_rng.h>
 #include <botan/hex.h>
@@ -41,7 +42,7 @@ AES_ECB::AES_ECB(size_t key_bits) : key_bits_(key_bits) {
     }
     
     // Use debug level - ECB warning will only show when user enables verbose
-    spdlog::debug("Created AES-{}-ECB algorithm - ECB mode is insecure!", key_bits);
+    SPDLOG_DEBUG("Created AES-{}-ECB algorithm - ECB mode is insecure!", key_bits);
 }
 
 // PKCS7 padding
@@ -82,6 +83,7 @@ core::CryptoResult AES_ECB::encrypt(
     std::span<const uint8_t> key,
     [[maybe_unused]] const core::EncryptionConfig& config
 ) {
+    utils::ScopedSpan trace_span("AES_ECB::encrypt", "cipher", plaintext.size());
     auto start = std::chrono::high_resolution_clock::now();
     core::CryptoResult result;
     
@@ -94,7 +96,7 @@ core::CryptoResult AES_ECB::encrypt(
             return result;
         }
         
-        spdlog::debug("Using ECB mode - this is insecure for most applications!");
+        SPDLOG_DEBUG("Using ECB mode - this is insecure for most applications!");
         
         // Create block cipher (not Cipher_Mode - ECB not exposed in Botan 3)
         auto cipher = Botan::BlockCipher::create(botan_name_);
@@ -117,7 +119,7 @@ core::CryptoResult AES_ECB::encrypt(
         
         result.data = std::move(ciphertext);
         // ECB doesn't use nonce/IV - set empty to indicate this
-        result.nonce = std::vector<uint8_t>();
+        result.nonce = core::ShortBytes();
         result.success = true;
         result.algorithm_used = type_;
         result.original_size = plaintext.size();
@@ -140,6 +142,7 @@ core::CryptoResult AES_ECB::decrypt(
     std::span<const uint8_t> key,
     [[maybe_unused]] const core::EncryptionConfig& config
 ) {
+    utils::ScopedSpan trace_span("AES_ECB::decrypt", "cipher", ciphertext.size());
     auto start = std::chrono::high_resolution_clock::now();
     core::CryptoResult result;
     
@@ -1,6 +1,10 @@
 #include "filevault/algorithms/symmetric/aes_gcm.hpp"
-#include <botan/auto_rng.h>
+#include "filevault/algorithms/symmetric/aead_session.hpp"
+#include "filevault/algorithms/symmetric/offload_session.hpp"
+#include "filevault/core/random.hpp"
+#include "filevault/utils/trace.hpp"
 #include <spdlog/spdlog.h>
+#include <algorithm>
 #include <chrono>
 
 namespace filevault {
@@ -28,7 +32,7 @@ AES_GCM::AES_GCM(size_t key_bits)
             throw std::invalid_argument("Invalid AES key size. Must be 128, 192, or 256 bits");
     }
     
-    spdlog::debug("Created {} cipher", name());
+    SPDLOG_DEBUG("Created {} cipher", name());
 }
 
 std::string AES_GCM::name() const {
@@ -43,6 +47,7 @@ core::CryptoResult AES_GCM::encrypt(
     std::span<const uint8_t> plaintext,
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config) {
+    utils::ScopedSpan trace_span("AES_GCM::encrypt", "cipher", plaintext.size());
     
     auto start = std::chrono::high_resolution_clock::now();
     core::CryptoResult result;
@@ -60,13 +65,13 @@ core::CryptoResult AES_GCM::encrypt(
         if (config.nonce.has_value() && config.nonce.value().size() == nonce_size()) {
             // Allow override for testing only
             nonce = config.nonce.value();
-            spdlog::debug("Using provided nonce (testing mode)");
+            SPDLOG_DEBUG("Using provided nonce (testing mode)");
         } else {
             // CRITICAL: Generate NEW unique nonce for THIS encryption
-            Botan::AutoSeeded_RNG rng;
+            auto& rng = core::RandomService::rng();
             nonce.resize(nonce_size());
             rng.randomize(nonce.data(), nonce.size());
-            spdlog::debug("Generated new unique nonce ({} bytes)", nonce.size());
+            SPDLOG_DEBUG("Generated new unique nonce ({} bytes)", nonce.size());
         }
         
         // Create AEAD cipher
@@ -106,13 +111,13 @@ core::CryptoResult AES_GCM::encrypt(
         result.data.assign(buffer.begin(), buffer.begin() + ciphertext_len);
         
         // Store tag separately
-        result.tag = std::vector<uint8_t>(
+        result.tag = core::ShortBytes(
             buffer.begin() + ciphertext_len,
             buffer.end()
         );
         
         // Store nonce
-        result.nonce = std::vector<uint8_t>(nonce.begin(), nonce.end());
+        result.nonce = core::ShortBytes(nonce.begin(), nonce.end());
         
         // Fill metadata
         result.success = true;
@@ -123,7 +128,7 @@ core::CryptoResult AES_GCM::encrypt(
         auto end = std::chrono::high_resolution_clock::now();
         result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
         
-        spdlog::debug("Encrypted {} bytes -> {} bytes + {} byte tag in {:.2f}ms",
+        SPDLOG_DEBUG("Encrypted {} bytes -> {} bytes + {} byte tag in {:.2f}ms",
                      plaintext.size(), result.data.size(), tag_size(), result.processing_time_ms);
         
         return result;
@@ -139,6 +144,7 @@ core::CryptoResult AES_GCM::decrypt(
     std::span<const uint8_t> ciphertext,
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config) {
+    utils::ScopedSpan trace_span("AES_GCM::decrypt", "cipher", ciphertext.size());
     
     auto start = std::chrono::high_resolution_clock::now();
     core::CryptoResult result;
@@ -214,7 +220,7 @@ core::CryptoResult AES_GCM::decrypt(
         auto end = std::chrono::high_resolution_clock::now();
         result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
         
-        spdlog::debug("Decrypted {} bytes -> {} bytes in {:.2f}ms",
+        SPDLOG_DEBUG("Decrypted {} bytes -> {} bytes in {:.2f}ms",
                      ciphertext.size(), result.data.size(), result.processing_time_ms);
         
         return result;
@@ -230,6 +236,176 @@ core::CryptoResult AES_GCM::decrypt(
     }
 }
 
+core::CryptoResult AES_GCM::encrypt_in_place(
+    std::vector<uint8_t>& buffer,
+    std::span<const uint8_t> key,
+    const core::EncryptionConfig& config) {
+    utils::ScopedSpan trace_span("AES_GCM::encrypt_in_place", "cipher", buffer.size());
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    core::CryptoResult result;
+    size_t plaintext_len = buffer.size();
+    
+    try {
+        // Validate inputs
+        if (key.size() != key_size()) {
+            result.success = false;
+            result.error_message = "Invalid key size";
+            return result;
+        }
+        
+        // Generate or use provided nonce (same rules as encrypt())
+        std::vector<uint8_t> nonce;
+        if (config.nonce.has_value() && config.nonce.value().size() == nonce_size()) {
+            nonce = config.nonce.value();
+        } else {
+            auto& rng = core::RandomService::rng();
+            nonce.resize(nonce_size());
+            rng.randomize(nonce.data(), nonce.size());
+            SPDLOG_DEBUG("Generated new unique nonce ({} bytes)", nonce.size());
+        }
+        
+        // Create AEAD cipher
+        auto cipher = Botan::AEAD_Mode::create(botan_name_, Botan::Cipher_Dir::Encryption);
+        if (!cipher) {
+            result.success = false;
+            result.error_message = "Failed to create AEAD cipher";
+            return result;
+        }
+        
+        cipher->set_key(key.data(), key.size());
+        
+        if (config.associated_data.has_value() && !config.associated_data.value().empty()) {
+            const auto& ad = config.associated_data.value();
+            cipher->set_associated_data(ad.data(), ad.size());
+        }
+        
+        cipher->start(nonce.data(), nonce.size());
+        
+        // Encrypt directly in the caller's buffer; Botan appends the tag
+        cipher->finish(buffer);
+        
+        if (buffer.size() != plaintext_len + tag_size()) {
+            result.success = false;
+            result.error_message = "Invalid ciphertext size";
+            return result;
+        }
+        
+        // Split off the tag, leaving only ciphertext in the buffer
+        result.tag = core::ShortBytes(buffer.end() - tag_size(), buffer.end());
+        buffer.resize(plaintext_len);
+        
+        result.nonce = std::move(nonce);
+        result.success = true;
+        result.algorithm_used = type_;
+        result.original_size = plaintext_len;
+        result.final_size = buffer.size();
+        
+        auto end = std::chrono::high_resolution_clock::now();
+        result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        
+        SPDLOG_DEBUG("Encrypted {} bytes in place in {:.2f}ms", plaintext_len, result.processing_time_ms);
+        
+        return result;
+        
+    } catch (const std::exception& e) {
+        result.success = false;
+        result.error_message = std::string("Encryption failed: ") + e.what();
+        return result;
+    }
+}
+
+core::CryptoResult AES_GCM::decrypt_in_place(
+    std::vector<uint8_t>& buffer,
+    std::span<const uint8_t> key,
+    const core::EncryptionConfig& config) {
+    utils::ScopedSpan trace_span("AES_GCM::decrypt_in_place", "cipher", buffer.size());
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    core::CryptoResult result;
+    size_t ciphertext_len = buffer.size();
+    
+    try {
+        // Validate inputs
+        if (key.size() != key_size()) {
+            result.success = false;
+            result.error_message = "Invalid key size";
+            return result;
+        }
+        
+        // Get nonce and tag from config
+        if (!config.nonce.has_value() || !config.tag.has_value()) {
+            result.success = false;
+            result.error_message = "Nonce and tag must be provided in config";
+            return result;
+        }
+        
+        auto& nonce = config.nonce.value();
+        auto& tag = config.tag.value();
+        
+        if (nonce.size() != nonce_size() || tag.size() != tag_size()) {
+            result.success = false;
+            result.error_message = "Invalid nonce or tag size";
+            return result;
+        }
+        
+        // Create AEAD cipher
+        auto cipher = Botan::AEAD_Mode::create(botan_name_, Botan::Cipher_Dir::Decryption);
+        if (!cipher) {
+            result.success = false;
+            result.error_message = "Failed to create AEAD cipher";
+            return result;
+        }
+        
+        cipher->set_key(key.data(), key.size());
+        
+        if (config.associated_data.has_value() && !config.associated_data.value().empty()) {
+            const auto& ad = config.associated_data.value();
+            cipher->set_associated_data(ad.data(), ad.size());
+        }
+        
+        cipher->start(nonce.data(), nonce.size());
+        
+        // Append tag and decrypt + verify in the caller's buffer
+        buffer.insert(buffer.end(), tag.begin(), tag.end());
+        cipher->finish(buffer);
+        
+        result.success = true;
+        result.algorithm_used = type_;
+        result.original_size = ciphertext_len;
+        result.final_size = buffer.size();
+        
+        auto end = std::chrono::high_resolution_clock::now();
+        result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        
+        SPDLOG_DEBUG("Decrypted {} bytes in place in {:.2f}ms", ciphertext_len, result.processing_time_ms);
+        
+        return result;
+        
+    } catch (const Botan::Invalid_Authentication_Tag&) {
+        // Never hand back unauthenticated plaintext
+        std::fill(buffer.begin(), buffer.end(), 0);
+        buffer.clear();
+        result.success = false;
+        result.error_message = "Authentication failed: Invalid tag (data may be corrupted or tampered)";
+        return result;
+    } catch (const std::exception& e) {
+        std::fill(buffer.begin(), buffer.end(), 0);
+        buffer.clear();
+        result.success = false;
+        result.error_message = std::string("Decryption failed: ") + e.what();
+        return result;
+    }
+}
+
+std::unique_ptr<core::ICipherSession> AES_GCM::create_session(std::span<const uint8_t> key) {
+    if (key.size() != key_size()) {
+        return nullptr;
+    }
+    return OffloadSession::wrap(type_, key, nonce_size(), tag_size(),
+        std::make_unique<AeadSession>(botan_name_, type_, key, nonce_size(), tag_size()));
+}
+
 bool AES_GCM::is_suitable_for(core::SecurityLevel level) const {
     // AES-GCM is suitable for all security levels
     // The security comes from key length and KDF parameters
@@ -0,0 +1,90 @@
+/**
+ * @file aes_ocb.cpp
+ * @brief Implementation of AES-256-OCB AEAD encryption
+ */
+
+#include "filevault/algorithms/symmetric/aes_ocb.hpp"
+#include "filevault/algorithms/symmetric/aead_session.hpp"
+#include "filevault/utils/trace.hpp"
+#include <botan/aead.h>
+
+namespace filevault {
+namespace algorithms {
+namespace symmetric {
+
+namespace {
+
+constexpr const char* BOTAN_NAME = "AES-256/OCB";
+
+} // anonymous namespace
+
+core::CryptoResult AES_OCB::encrypt(
+    std::span<const uint8_t> plaintext,
+    std::span<const uint8_t> key,
+    const core::EncryptionConfig& config
+) {
+    utils::ScopedSpan trace_span("AES_OCB::encrypt", "cipher", plaintext.size());
+    
+    auto session = create_session(key);
+    if (!session) {
+        core::CryptoResult result;
+        result.success = false;
+        result.error_message = "Invalid key size. Expected " +
+            std::to_string(key_size()) + " bytes, got " +
+            std::to_string(key.size());
+        return result;
+    }
+    
+    std::vector<uint8_t> buffer(plaintext.begin(), plaintext.end());
+    auto result = session->encrypt_in_place(buffer, config);
+    if (result.success) {
+        result.data = std::move(buffer);
+    }
+    return result;
+}
+
+core::CryptoResult AES_OCB::decrypt(
+    std::span<const uint8_t> ciphertext,
+    std::span<const uint8_t> key,
+    const core::EncryptionConfig& config
+) {
+    utils::ScopedSpan trace_span("AES_OCB::decrypt", "cipher", ciphertext.size());
+    
+    auto session = create_session(key);
+    if (!session) {
+        core::CryptoResult result;
+        result.success = false;
+        result.error_message = "Invalid key size. Expected " +
+            std::to_string(key_size()) + " bytes, got " +
+            std::to_string(key.size());
+        return result;
+    }
+    
+    std::vector<uint8_t> buffer(ciphertext.begin(), ciphertext.end());
+    auto result = session->decrypt_in_place(buffer, config);
+    if (result.success) {
+        result.data = std::move(buffer);
+    }
+    return result;
+}
+
+std::unique_ptr<core::ICipherSession> AES_OCB::create_session(std::span<const uint8_t> key) {
+    if (key.size() != key_size()) {
+        return nullptr;
+    }
+    return std::make_unique<AeadSession>(BOTAN_NAME, type(), key, nonce_size(), tag_size());
+}
+
+bool AES_OCB::is_suitable_for(core::SecurityLevel level) const {
+    // AES-256 with a full-length tag: suitable for every level
+    (void)level;
+    return true;
+}
+
+bool AES_OCB::is_available() {
+    return Botan::AEAD_Mode::create(BOTAN_NAME, Botan::Cipher_Dir::Encryption) != nullptr;
+}
+
+} // namespace symmetric
+} // namespace algorithms
+} // namespace filevault
@@ -4,10 +4,15 @@
  */
 
 #include "filevault/algorithms/symmetric/aes_xts.hpp"
-#include <botan/auto_rng.h>
+#include "filevault/core/random.hpp"
+#include "filevault/core/thread_pool.hpp"
+#include "filevault/utils/trace.hpp"
 #include <botan/hex.h>
 #include <spdlog/spdlog.h>
+#include <algorithm>
 #include <chrono>
+#include <future>
+#include <stdexcept>
 
 namespace filevault {
 namespace algorithms {
@@ -30,7 +35,7 @@ AES_XTS::AES_XTS(size_t key_bits) : key_bits_(key_bits) {
             break;
     }
     
-    spdlog::debug("Created AES-{}-XTS algorithm (total key: {} bits)", 
+    SPDLOG_DEBUG("Created AES-{}-XTS algorithm (total key: {} bits)", 
                   key_bits, key_bits * 2);
 }
 
@@ -47,6 +52,7 @@ core::CryptoResult AES_XTS::encrypt(
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config
 ) {
+    utils::ScopedSpan trace_span("AES_XTS::encrypt", "cipher", plaintext.size());
     auto start = std::chrono::high_resolution_clock::now();
     core::CryptoResult result;
     
@@ -72,7 +78,7 @@ core::CryptoResult AES_XTS::encrypt(
         if (config.nonce.has_value() && config.nonce.value().size() == tweak_size()) {
             tweak = config.nonce.value();
         } else {
-            Botan::AutoSeeded_RNG rng;
+            auto& rng = core::RandomService::rng();
             tweak.resize(tweak_size());
             rng.randomize(tweak.data(), tweak.size());
         }
@@ -114,6 +120,7 @@ core::CryptoResult AES_XTS::decrypt(
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config
 ) {
+    utils::ScopedSpan trace_span("AES_XTS::decrypt", "cipher", ciphertext.size());
     auto start = std::chrono::high_resolution_clock::now();
     core::CryptoResult result;
     
@@ -183,6 +190,105 @@ bool AES_XTS::is_suitable_for(core::SecurityLevel level) const {
     }
 }
 
+// Below this much data per task, a thread handoff costs more than it saves
+static constexpr size_t MIN_PARALLEL_BYTES = 256 * 1024;
+
+XtsSectorCipher::XtsSectorCipher(std::span<const uint8_t> key, size_t sector_size)
+    : key_(key.begin(), key.end()),
+      sector_size_(sector_size),
+      encryptors_([this]() { return create_mode(Botan::Cipher_Dir::Encryption); }),
+      decryptors_([this]() { return create_mode(Botan::Cipher_Dir::Decryption); }) {
+    if (key.size() == 32) {
+        botan_name_ = "AES-128/XTS";
+    } else if (key.size() == 64) {
+        botan_name_ = "AES-256/XTS";
+    } else {
+        throw std::invalid_argument("AES-XTS key must be 32 or 64 bytes");
+    }
+    if (sector_size < MIN_SECTOR_SIZE || sector_size > MAX_SECTOR_SIZE ||
+        (sector_size & (sector_size - 1)) != 0) {
+        throw std::invalid_argument("XTS sector size must be a power of two from 512 to 65536 bytes");
+    }
+    
+    // Build the first pair now, so a rejected key fails here
+    encryptors_.release(create_mode(Botan::Cipher_Dir::Encryption));
+    decryptors_.release(create_mode(Botan::Cipher_Dir::Decryption));
+}
+
+std::unique_ptr<Botan::Cipher_Mode> XtsSectorCipher::create_mode(Botan::Cipher_Dir direction) const {
+    auto mode = Botan::Cipher_Mode::create_or_throw(botan_name_, direction);
+    mode->set_key(key_);
+    return mode;
+}
+
+std::array<uint8_t, 16> XtsSectorCipher::tweak(uint64_t sector) {
+    std::array<uint8_t, 16> result{};
+    for (size_t i = 0; i < 8; ++i) {
+        result[i] = static_cast<uint8_t>(sector >> (8 * i));
+    }
+    return result;
+}
+
+void XtsSectorCipher::encrypt(uint64_t first_sector, std::span<uint8_t> data, core::ThreadPool* pool) {
+    utils::ScopedSpan trace_span("XtsSectorCipher::encrypt", "cipher", data.size());
+    process(encryptors_, first_sector, data, pool);
+}
+
+void XtsSectorCipher::decrypt(uint64_t first_sector, std::span<uint8_t> data, core::ThreadPool* pool) {
+    utils::ScopedSpan trace_span("XtsSectorCipher::decrypt", "cipher", data.size());
+    process(decryptors_, first_sector, data, pool);
+}
+
+void XtsSectorCipher::process(core::CheckoutCache<Botan::Cipher_Mode>& modes, uint64_t first_sector,
+                              std::span<uint8_t> data, core::ThreadPool* pool) {
+    if (data.size() % sector_size_ != 0) {
+        throw std::invalid_argument("XTS data must be a whole number of sectors");
+    }
+    
+    // Sectors are whole blocks, so no ciphertext stealing: process() covers
+    // each one and start() with the next tweak begins a fresh data unit
+    auto run = [this, &modes](uint64_t sector, std::span<uint8_t> range) {
+        auto mode = modes.acquire();
+        for (size_t offset = 0; offset < range.size(); offset += sector_size_, ++sector) {
+            auto sector_tweak = tweak(sector);
+            mode->start(sector_tweak.data(), sector_tweak.size());
+            mode->process(range.data() + offset, sector_size_);
+        }
+        modes.release(std::move(mode));
+    };
+    
+    size_t sectors = data.size() / sector_size_;
+    size_t tasks = pool ? std::min(pool->size(), data.size() / MIN_PARALLEL_BYTES) : 0;
+    if (tasks < 2) {
+        run(first_sector, data);
+        return;
+    }
+    
+    size_t per_task = (sectors + tasks - 1) / tasks;
+    std::vector<std::future<void>> pending;
+    pending.reserve(tasks);
+    for (size_t begin = 0; begin < sectors; begin += per_task) {
+        size_t count = std::min(per_task, sectors - begin);
+        pending.push_back(pool->submit([&run, first_sector, begin, count, data, this]() {
+            run(first_sector + begin, data.subspan(begin * sector_size_, count * sector_size_));
+        }));
+    }
+    // Wait for every task before any exception escapes, as they use data
+    std::exception_ptr failure;
+    for (auto& task : pending) {
+        try {
+            task.get();
+        } catch (...) {
+            if (!failure) {
+                failure = std::current_exception();
+            }
+        }
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
 } // namespace symmetric
 } // namespace algorithms
 } // namespace filevault
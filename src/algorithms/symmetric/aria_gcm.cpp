@@ -4,7 +4,9 @@
  */
 
 #include "filevault/algorithms/symmetric/aria_gcm.hpp"
-#include <botan/auto_rng.h>
+#include "filevault/algorithms/symmetric/aead_session.hpp"
+#include "filevault/core/random.hpp"
+#include "filevault/utils/trace.hpp"
 #include <botan/hex.h>
 #include <spdlog/spdlog.h>
 #include <stdexcept>
@@ -33,7 +35,7 @@ ARIA_GCM::ARIA_GCM(size_t key_bits) : key_bits_(key_bits) {
             break;
     }
     
-    spdlog::debug("Created ARIA-{}-GCM algorithm", key_bits);
+    SPDLOG_DEBUG("Created ARIA-{}-GCM algorithm", key_bits);
 }
 
 std::string ARIA_GCM::name() const {
@@ -49,6 +51,7 @@ core::CryptoResult ARIA_GCM::encrypt(
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config
 ) {
+    utils::ScopedSpan trace_span("ARIA_GCM::encrypt", "cipher", plaintext.size());
     core::CryptoResult result;
     
     try {
@@ -70,7 +73,7 @@ core::CryptoResult ARIA_GCM::encrypt(
         }
         
         // Generate nonce
-        Botan::AutoSeeded_RNG rng;
+        auto& rng = core::RandomService::rng();
         std::vector<uint8_t> nonce(nonce_size());
         if (config.nonce && !config.nonce->empty()) {
             nonce = *config.nonce;
@@ -104,17 +107,17 @@ core::CryptoResult ARIA_GCM::encrypt(
         result.data.assign(buffer.begin(), buffer.begin() + ciphertext_len);
         
         // Store tag separately
-        result.tag = std::vector<uint8_t>(
+        result.tag = core::ShortBytes(
             buffer.begin() + ciphertext_len,
             buffer.end()
         );
         
         // Store nonce
-        result.nonce = std::vector<uint8_t>(nonce.begin(), nonce.end());
+        result.nonce = core::ShortBytes(nonce.begin(), nonce.end());
         
         result.success = true;
         
-        spdlog::debug("ARIA-{}-GCM encryption successful: {} bytes -> {} bytes + {} byte tag",
+        SPDLOG_DEBUG("ARIA-{}-GCM encryption successful: {} bytes -> {} bytes + {} byte tag",
                       key_bits_, plaintext.size(), result.data.size(), tag_size());
         
     } catch (const Botan::Exception& e) {
@@ -135,6 +138,7 @@ core::CryptoResult ARIA_GCM::decrypt(
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config
 ) {
+    utils::ScopedSpan trace_span("ARIA_GCM::decrypt", "cipher", ciphertext.size());
     core::CryptoResult result;
     
     try {
@@ -198,7 +202,7 @@ core::CryptoResult ARIA_GCM::decrypt(
         result.data.assign(buffer.begin(), buffer.end());
         result.success = true;
         
-        spdlog::debug("ARIA-{}-GCM decryption successful: {} bytes -> {} bytes",
+        SPDLOG_DEBUG("ARIA-{}-GCM decryption successful: {} bytes -> {} bytes",
                       key_bits_, ciphertext.size(), result.data.size());
         
     } catch (const Botan::Invalid_Authentication_Tag& e) {
@@ -218,6 +222,13 @@ core::CryptoResult ARIA_GCM::decrypt(
     return result;
 }
 
+std::unique_ptr<core::ICipherSession> ARIA_GCM::create_session(std::span<const uint8_t> key) {
+    if (key.size() != key_size()) {
+        return nullptr;
+    }
+    return std::make_unique<AeadSession>(botan_name_, type_, key, nonce_size(), tag_size());
+}
+
 bool ARIA_GCM::is_suitable_for(core::SecurityLevel level) const {
     // ARIA is cryptographically strong, suitable for all levels
     // 256-bit is recommended for STRONG and PARANOID
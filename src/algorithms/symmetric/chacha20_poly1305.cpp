@@ -1,6 +1,10 @@
 #include "filevault/algorithms/symmetric/chacha20_poly1305.hpp"
-#include <botan/auto_rng.h>
+#include "filevault/algorithms/symmetric/aead_session.hpp"
+#include "filevault/algorithms/symmetric/offload_session.hpp"
+#include "filevault/core/random.hpp"
+#include "filevault/utils/trace.hpp"
 #include <spdlog/spdlog.h>
+#include <algorithm>
 #include <chrono>
 
 namespace filevault {
@@ -8,7 +12,7 @@ namespace algorithms {
 namespace symmetric {
 
 ChaCha20Poly1305::ChaCha20Poly1305() {
-    spdlog::debug("Created ChaCha20-Poly1305 cipher");
+    SPDLOG_DEBUG("Created ChaCha20-Poly1305 cipher");
 }
 
 std::string ChaCha20Poly1305::name() const {
@@ -23,6 +27,7 @@ core::CryptoResult ChaCha20Poly1305::encrypt(
     std::span<const uint8_t> plaintext,
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config) {
+    utils::ScopedSpan trace_span("ChaCha20Poly1305::encrypt", "cipher", plaintext.size());
     
     auto start = std::chrono::high_resolution_clock::now();
     core::CryptoResult result;
@@ -40,13 +45,13 @@ core::CryptoResult ChaCha20Poly1305::encrypt(
         if (config.nonce.has_value() && config.nonce.value().size() == nonce_size()) {
             // Allow override for testing only
             nonce = config.nonce.value();
-            spdlog::debug("Using provided nonce (testing mode)");
+            SPDLOG_DEBUG("Using provided nonce (testing mode)");
         } else {
             // CRITICAL: Generate NEW unique nonce for THIS encryption
-            Botan::AutoSeeded_RNG rng;
+            auto& rng = core::RandomService::rng();
             nonce.resize(nonce_size());
             rng.randomize(nonce.data(), nonce.size());
-            spdlog::debug("Generated new unique nonce ({} bytes)", nonce.size());
+            SPDLOG_DEBUG("Generated new unique nonce ({} bytes)", nonce.size());
         }
         
         // Create AEAD cipher
@@ -87,13 +92,13 @@ core::CryptoResult ChaCha20Poly1305::encrypt(
         result.data.assign(buffer.begin(), buffer.begin() + ciphertext_len);
         
         // Store tag separately
-        result.tag = std::vector<uint8_t>(
+        result.tag = core::ShortBytes(
             buffer.begin() + ciphertext_len,
             buffer.end()
         );
         
         // Store nonce
-        result.nonce = std::vector<uint8_t>(nonce.begin(), nonce.end());
+        result.nonce = core::ShortBytes(nonce.begin(), nonce.end());
         
         // Fill metadata
         result.success = true;
@@ -104,7 +109,7 @@ core::CryptoResult ChaCha20Poly1305::encrypt(
         auto end = std::chrono::high_resolution_clock::now();
         result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
         
-        spdlog::debug("Encrypted {} bytes -> {} bytes + {} byte tag in {:.2f}ms using ChaCha20-Poly1305",
+        SPDLOG_DEBUG("Encrypted {} bytes -> {} bytes + {} byte tag in {:.2f}ms using ChaCha20-Poly1305",
                      plaintext.size(), result.data.size(), tag_size(), result.processing_time_ms);
         
         return result;
@@ -120,6 +125,7 @@ core::CryptoResult ChaCha20Poly1305::decrypt(
     std::span<const uint8_t> ciphertext,
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config) {
+    utils::ScopedSpan trace_span("ChaCha20Poly1305::decrypt", "cipher", ciphertext.size());
     
     auto start = std::chrono::high_resolution_clock::now();
     core::CryptoResult result;
@@ -195,7 +201,7 @@ core::CryptoResult ChaCha20Poly1305::decrypt(
         auto end = std::chrono::high_resolution_clock::now();
         result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
         
-        spdlog::debug("Decrypted {} bytes -> {} bytes in {:.2f}ms using ChaCha20-Poly1305",
+        SPDLOG_DEBUG("Decrypted {} bytes -> {} bytes in {:.2f}ms using ChaCha20-Poly1305",
                      ciphertext.size(), result.data.size(), result.processing_time_ms);
         
         return result;
@@ -211,6 +217,176 @@ core::CryptoResult ChaCha20Poly1305::decrypt(
     }
 }
 
+core::CryptoResult ChaCha20Poly1305::encrypt_in_place(
+    std::vector<uint8_t>& buffer,
+    std::span<const uint8_t> key,
+    const core::EncryptionConfig& config) {
+    utils::ScopedSpan trace_span("ChaCha20Poly1305::encrypt_in_place", "cipher", buffer.size());
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    core::CryptoResult result;
+    size_t plaintext_len = buffer.size();
+    
+    try {
+        // Validate inputs
+        if (key.size() != key_size()) {
+            result.success = false;
+            result.error_message = "Invalid key size (must be 32 bytes for ChaCha20)";
+            return result;
+        }
+        
+        // Generate or use provided nonce (same rules as encrypt())
+        std::vector<uint8_t> nonce;
+        if (config.nonce.has_value() && config.nonce.value().size() == nonce_size()) {
+            nonce = config.nonce.value();
+        } else {
+            auto& rng = core::RandomService::rng();
+            nonce.resize(nonce_size());
+            rng.randomize(nonce.data(), nonce.size());
+            SPDLOG_DEBUG("Generated new unique nonce ({} bytes)", nonce.size());
+        }
+        
+        // Create AEAD cipher
+        auto cipher = Botan::AEAD_Mode::create("ChaCha20Poly1305", Botan::Cipher_Dir::Encryption);
+        if (!cipher) {
+            result.success = false;
+            result.error_message = "Failed to create ChaCha20-Poly1305 cipher";
+            return result;
+        }
+        
+        cipher->set_key(key.data(), key.size());
+        
+        if (config.associated_data.has_value() && !config.associated_data.value().empty()) {
+            const auto& ad = config.associated_data.value();
+            cipher->set_associated_data(ad.data(), ad.size());
+        }
+        
+        cipher->start(nonce.data(), nonce.size());
+        
+        // Encrypt directly in the caller's buffer; Botan appends the tag
+        cipher->finish(buffer);
+        
+        if (buffer.size() != plaintext_len + tag_size()) {
+            result.success = false;
+            result.error_message = "Invalid ciphertext size";
+            return result;
+        }
+        
+        // Split off the tag, leaving only ciphertext in the buffer
+        result.tag = core::ShortBytes(buffer.end() - tag_size(), buffer.end());
+        buffer.resize(plaintext_len);
+        
+        result.nonce = std::move(nonce);
+        result.success = true;
+        result.algorithm_used = type();
+        result.original_size = plaintext_len;
+        result.final_size = buffer.size();
+        
+        auto end = std::chrono::high_resolution_clock::now();
+        result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        
+        SPDLOG_DEBUG("Encrypted {} bytes in place in {:.2f}ms", plaintext_len, result.processing_time_ms);
+        
+        return result;
+        
+    } catch (const std::exception& e) {
+        result.success = false;
+        result.error_message = std::string("ChaCha20-Poly1305 encryption failed: ") + e.what();
+        return result;
+    }
+}
+
+core::CryptoResult ChaCha20Poly1305::decrypt_in_place(
+    std::vector<uint8_t>& buffer,
+    std::span<const uint8_t> key,
+    const core::EncryptionConfig& config) {
+    utils::ScopedSpan trace_span("ChaCha20Poly1305::decrypt_in_place", "cipher", buffer.size());
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    core::CryptoResult result;
+    size_t ciphertext_len = buffer.size();
+    
+    try {
+        // Validate inputs
+        if (key.size() != key_size()) {
+            result.success = false;
+            result.error_message = "Invalid key size (must be 32 bytes for ChaCha20)";
+            return result;
+        }
+        
+        // Get nonce and tag from config
+        if (!config.nonce.has_value() || !config.tag.has_value()) {
+            result.success = false;
+            result.error_message = "Nonce and tag must be provided in config";
+            return result;
+        }
+        
+        auto& nonce = config.nonce.value();
+        auto& tag = config.tag.value();
+        
+        if (nonce.size() != nonce_size() || tag.size() != tag_size()) {
+            result.success = false;
+            result.error_message = "Invalid nonce or tag size";
+            return result;
+        }
+        
+        // Create AEAD cipher
+        auto cipher = Botan::AEAD_Mode::create("ChaCha20Poly1305", Botan::Cipher_Dir::Decryption);
+        if (!cipher) {
+            result.success = false;
+            result.error_message = "Failed to create ChaCha20-Poly1305 cipher";
+            return result;
+        }
+        
+        cipher->set_key(key.data(), key.size());
+        
+        if (config.associated_data.has_value() && !config.associated_data.value().empty()) {
+            const auto& ad = config.associated_data.value();
+            cipher->set_associated_data(ad.data(), ad.size());
+        }
+        
+        cipher->start(nonce.data(), nonce.size());
+        
+        // Append tag and decrypt + verify in the caller's buffer
+        buffer.insert(buffer.end(), tag.begin(), tag.end());
+        cipher->finish(buffer);
+        
+        result.success = true;
+        result.algorithm_used = type();
+        result.original_size = ciphertext_len;
+        result.final_size = buffer.size();
+        
+        auto end = std::chrono::high_resolution_clock::now();
+        result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        
+        SPDLOG_DEBUG("Decrypted {} bytes in place in {:.2f}ms", ciphertext_len, result.processing_time_ms);
+        
+        return result;
+        
+    } catch (const Botan::Invalid_Authentication_Tag&) {
+        // Never hand back unauthenticated plaintext
+        std::fill(buffer.begin(), buffer.end(), 0);
+        buffer.clear();
+        result.success = false;
+        result.error_message = "Authentication failed: Invalid tag (data may be corrupted or tampered)";
+        return result;
+    } catch (const std::exception& e) {
+        std::fill(buffer.begin(), buffer.end(), 0);
+        buffer.clear();
+        result.success = false;
+        result.error_message = std::string("ChaCha20-Poly1305 decryption failed: ") + e.what();
+        return result;
+    }
+}
+
+std::unique_ptr<core::ICipherSession> ChaCha20Poly1305::create_session(std::span<const uint8_t> key) {
+    if (key.size() != key_size()) {
+        return nullptr;
+    }
+    return OffloadSession::wrap(type(), key, nonce_size(), tag_size(),
+        std::make_unique<AeadSession>("ChaCha20Poly1305", type(), key, nonce_size(), tag_size()));
+}
+
 bool ChaCha20Poly1305::is_suitable_for(core::SecurityLevel level) const {
     // ChaCha20-Poly1305 is suitable for all security levels
     // It's a modern, secure AEAD cipher recommended by IETF
@@ -0,0 +1,282 @@
+/**
+ * @file keystream_session.cpp
+ * @brief Stream-cipher session sealing small messages from precomputed keystream
+ */
+
+#include "filevault/algorithms/symmetric/keystream_session.hpp"
+#include "filevault/utils/trace.hpp"
+#include <botan/mac.h>
+#include <botan/mem_ops.h>
+#include <botan/stream_cipher.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+namespace filevault {
+namespace algorithms {
+namespace symmetric {
+
+namespace {
+
+constexpr size_t CHACHA_NONCE_SIZE = 12;
+constexpr size_t CHACHA_BLOCK_SIZE = 64;        // Keystream block 0 holds the Poly1305 key
+constexpr size_t POLY1305_KEY_SIZE = 32;
+constexpr size_t CTR_NONCE_SIZE = 16;
+
+// ChaCha20 counts blocks in 32 bits from 1; the CTR nonce leaves 32 bits for blocks
+constexpr uint64_t CHACHA_MAX_BYTES = ((uint64_t{1} << 32) - 1) * 64;
+constexpr uint64_t CTR_MAX_BYTES = (uint64_t{1} << 32) * 16;
+
+void store_le64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) {
+        p[i] = static_cast<uint8_t>(v);
+        v >>= 8;
+    }
+}
+
+size_t pad16(size_t size) {
+    return (16 - size % 16) % 16;
+}
+
+std::span<const uint8_t> associated_data(const core::EncryptionConfig& config) {
+    if (config.associated_data.has_value()) {
+        return config.associated_data.value();
+    }
+    return {};
+}
+
+std::unique_ptr<Botan::StreamCipher> keyed_cipher(core::AlgorithmType type, std::span<const uint8_t> key) {
+    std::string name = type == core::AlgorithmType::CHACHA20_POLY1305
+        ? "ChaCha(20)"
+        : "CTR-BE(AES-" + std::to_string(key.size() * 8) + ")";
+    auto cipher = Botan::StreamCipher::create_or_throw(name);
+    cipher->set_key(key.data(), key.size());
+    return cipher;
+}
+
+} // anonymous namespace
+
+bool KeystreamSession::supports(core::AlgorithmType type) {
+    return type == core::AlgorithmType::CHACHA20_POLY1305 ||
+           type == core::AlgorithmType::AES_128_CTR ||
+           type == core::AlgorithmType::AES_192_CTR ||
+           type == core::AlgorithmType::AES_256_CTR;
+}
+
+std::unique_ptr<KeystreamSession> KeystreamSession::create(
+    core::ICryptoAlgorithm& algorithm,
+    std::span<const uint8_t> key,
+    KeystreamSessionOptions options) {
+    if (!supports(algorithm.type()) || key.size() != algorithm.key_size() || options.depth == 0) {
+        return nullptr;
+    }
+    auto regular = algorithm.create_session(key);
+    if (!regular) {
+        return nullptr;
+    }
+    return std::make_unique<KeystreamSession>(algorithm.type(), key, options, std::move(regular));
+}
+
+KeystreamSession::KeystreamSession(
+    core::AlgorithmType type,
+    std::span<const uint8_t> key,
+    KeystreamSessionOptions options,
+    std::unique_ptr<core::ICipherSession> regular)
+    : type_(type),
+      chacha_(type == core::AlgorithmType::CHACHA20_POLY1305),
+      options_(options),
+      stride_((chacha_ ? CHACHA_BLOCK_SIZE : 0) + options.message_size),
+      regular_(std::move(regular)),
+      nonces_(CHACHA_NONCE_SIZE),
+      cipher_(keyed_cipher(type, key)),
+      fill_cipher_(keyed_cipher(type, key)),
+      ring_(options.depth * stride_),
+      ring_nonces_(options.depth) {
+    if (chacha_) {
+        poly1305_ = Botan::MessageAuthenticationCode::create_or_throw("Poly1305");
+    }
+    filler_ = std::thread([this] { fill(); });
+}
+
+KeystreamSession::~KeystreamSession() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    drained_.notify_all();
+    if (filler_.joinable()) {
+        filler_.join();
+    }
+}
+
+size_t KeystreamSession::nonce_size() const {
+    return chacha_ ? CHACHA_NONCE_SIZE : CTR_NONCE_SIZE;
+}
+
+void KeystreamSession::next_nonce(std::array<uint8_t, 16>& nonce) {
+    // [4-byte prefix][64-bit counter], then for CTR the message's block counter from 0
+    nonce.fill(0);
+    nonces_.next(std::span<uint8_t>(nonce.data(), CHACHA_NONCE_SIZE));
+}
+
+void KeystreamSession::fill() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        drained_.wait(lock, [this] { return stopping_ || count_ < options_.depth; });
+        if (stopping_) {
+            return;
+        }
+        // The slot after the last ready entry; the consumer never touches it
+        // until count_ covers it, and head_ + count_ does not move meanwhile
+        size_t slot = (head_ + count_) % options_.depth;
+        lock.unlock();
+        try {
+            auto& nonce = ring_nonces_[slot];
+            auto entry = std::span<uint8_t>(ring_.data() + slot * stride_, stride_);
+            next_nonce(nonce);
+            std::fill(entry.begin(), entry.end(), 0);
+            fill_cipher_->set_iv(nonce.data(), nonce_size());
+            fill_cipher_->cipher1(entry.data(), entry.size());
+        } catch (const std::exception& e) {
+            spdlog::warn("Keystream precomputation stopped: {}", e.what());
+            lock.lock();
+            stopping_ = true;
+            filled_.notify_all();
+            return;
+        }
+        lock.lock();
+        ++count_;
+        filled_.notify_all();
+    }
+}
+
+void KeystreamSession::wait_ready() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    filled_.wait(lock, [this] { return stopping_ || count_ > 0; });
+}
+
+KeystreamSessionStats KeystreamSession::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+core::CryptoResult KeystreamSession::encrypt_in_place(
+    std::vector<uint8_t>& buffer,
+    const core::EncryptionConfig& config) {
+    utils::ScopedSpan trace_span("KeystreamSession::encrypt_in_place", "cipher", buffer.size());
+    core::CryptoResult result;
+    if (config.nonce.has_value()) {
+        result.error_message = "Keystream sessions choose their own nonces";
+        return result;
+    }
+    if (buffer.size() > (chacha_ ? CHACHA_MAX_BYTES : CTR_MAX_BYTES)) {
+        result.error_message = "Message too long for one nonce";
+        return result;
+    }
+
+    try {
+        std::array<uint8_t, 16> nonce{};
+        uint8_t poly_key[CHACHA_BLOCK_SIZE] = {};
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (count_ > 0 && buffer.size() <= options_.message_size) {
+            size_t slot = head_;
+            ++stats_.precomputed;
+            lock.unlock();
+
+            nonce = ring_nonces_[slot];
+            uint8_t* entry = ring_.data() + slot * stride_;
+            const uint8_t* keystream = entry + (chacha_ ? CHACHA_BLOCK_SIZE : 0);
+            for (size_t i = 0; i < buffer.size(); ++i) {
+                buffer[i] ^= keystream[i];
+            }
+            if (chacha_) {
+                std::copy(entry, entry + POLY1305_KEY_SIZE, poly_key);
+            }
+            Botan::secure_scrub_memory(entry, stride_);
+
+            lock.lock();
+            head_ = (head_ + 1) % options_.depth;
+            --count_;
+            lock.unlock();
+            drained_.notify_one();
+        } else {
+            ++stats_.computed_inline;
+            lock.unlock();
+
+            next_nonce(nonce);
+            cipher_->set_iv(nonce.data(), nonce_size());
+            if (chacha_) {
+                cipher_->cipher1(poly_key, sizeof(poly_key));       // Block 0; the message starts at block 1
+            }
+            cipher_->cipher1(buffer.data(), buffer.size());
+        }
+
+        if (chacha_) {
+            // RFC 8439 tag over pad16(AD) || pad16(C) || le64(|AD|) || le64(|C|)
+            static const uint8_t zeros[16] = {};
+            auto ad = associated_data(config);
+            uint8_t lengths[16];
+            store_le64(lengths, ad.size());
+            store_le64(lengths + 8, buffer.size());
+
+            uint8_t tag[16];
+            poly1305_->set_key(poly_key, POLY1305_KEY_SIZE);
+            Botan::secure_scrub_memory(poly_key, sizeof(poly_key));
+            poly1305_->update(ad.data(), ad.size());
+            poly1305_->update(zeros, pad16(ad.size()));
+            poly1305_->update(buffer.data(), buffer.size());
+            poly1305_->update(zeros, pad16(buffer.size()));
+            poly1305_->update(lengths, sizeof(lengths));
+            poly1305_->final(tag);
+            result.tag = core::ShortBytes(tag, tag + sizeof(tag));
+        }
+
+        result.nonce = core::ShortBytes(nonce.data(), nonce.data() + nonce_size());
+        result.success = true;
+        result.algorithm_used = type_;
+        result.original_size = buffer.size();
+        result.final_size = buffer.size();
+        return result;
+
+    } catch (const std::exception& e) {
+        std::fill(buffer.begin(), buffer.end(), 0);
+        buffer.clear();
+        result.success = false;
+        result.error_message = std::string("Encryption failed: ") + e.what();
+        return result;
+    }
+}
+
+core::CryptoResult KeystreamSession::decrypt_in_place(
+    std::vector<uint8_t>& buffer,
+    const core::EncryptionConfig& config) {
+    return regular_->decrypt_in_place(buffer, config);
+}
+
+core::BatchResult KeystreamSession::decrypt_batch(
+    std::span<const uint8_t> arena,
+    std::span<const core::BatchRecord> records,
+    const core::EncryptionConfig& config,
+    std::vector<uint8_t>& output) {
+    return regular_->decrypt_batch(arena, records, config, output);
+}
+
+bool KeystreamSession::decrypt_begin(const core::EncryptionConfig& config) {
+    return regular_->decrypt_begin(config);
+}
+
+size_t KeystreamSession::decrypt_update(std::span<uint8_t> buffer) {
+    return regular_->decrypt_update(buffer);
+}
+
+core::CryptoResult KeystreamSession::decrypt_finish(std::vector<uint8_t>& buffer) {
+    return regular_->decrypt_finish(buffer);
+}
+
+size_t KeystreamSession::decrypt_granularity() const {
+    return regular_->decrypt_granularity();
+}
+
+} // namespace symmetric
+} // namespace algorithms
+} // namespace filevault
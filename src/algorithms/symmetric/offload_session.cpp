@@ -0,0 +1,331 @@
+/**
+ * @file offload_session.cpp
+ * @brief AEAD session with the keystream offloaded to an accelerator
+ */
+
+#include "filevault/algorithms/symmetric/offload_session.hpp"
+#include "filevault/core/random.hpp"
+#include "filevault/utils/trace.hpp"
+#include <botan/block_cipher.h>
+#include <botan/mac.h>
+#include <botan/mem_ops.h>
+#include <algorithm>
+
+namespace filevault {
+namespace algorithms {
+namespace symmetric {
+
+namespace {
+
+constexpr size_t NONCE_SIZE = 12;
+
+// GCM counts blocks in the low 32 bits from 2; ChaCha20 from 1
+constexpr uint64_t GCM_MAX_BYTES = ((uint64_t{1} << 32) - 2) * 16;
+constexpr uint64_t CHACHA_MAX_BYTES = ((uint64_t{1} << 32) - 1) * 64;
+
+void store_be64(uint8_t* p, uint64_t v) {
+    for (int i = 7; i >= 0; --i) {
+        p[i] = static_cast<uint8_t>(v);
+        v >>= 8;
+    }
+}
+
+void store_le64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) {
+        p[i] = static_cast<uint8_t>(v);
+        v >>= 8;
+    }
+}
+
+/**
+ * @brief x = x * h in GF(2^128) with GCM's bit order, without branching on secrets
+ */
+void gf128_multiply(uint8_t x[16], const uint8_t h[16]) {
+    uint64_t v_hi = 0;
+    uint64_t v_lo = 0;
+    for (int i = 0; i < 8; ++i) {
+        v_hi = (v_hi << 8) | h[i];
+        v_lo = (v_lo << 8) | h[8 + i];
+    }
+    uint64_t z_hi = 0;
+    uint64_t z_lo = 0;
+    for (int i = 0; i < 128; ++i) {
+        uint64_t bit = (x[i / 8] >> (7 - i % 8)) & 1;
+        uint64_t mask = 0 - bit;
+        z_hi ^= v_hi & mask;
+        z_lo ^= v_lo & mask;
+        uint64_t carry = 0 - (v_lo & 1);
+        v_lo = (v_lo >> 1) | (v_hi << 63);
+        v_hi = (v_hi >> 1) ^ (carry & 0xE100000000000000ULL);
+    }
+    store_be64(x, z_hi);
+    store_be64(x + 8, z_lo);
+}
+
+size_t pad16(size_t size) {
+    return (16 - size % 16) % 16;
+}
+
+std::span<const uint8_t> associated_data(const core::EncryptionConfig& config) {
+    if (config.associated_data.has_value()) {
+        return config.associated_data.value();
+    }
+    return {};
+}
+
+} // anonymous namespace
+
+std::unique_ptr<core::ICipherSession> OffloadSession::wrap(
+    core::AlgorithmType type,
+    std::span<const uint8_t> key,
+    size_t nonce_size,
+    size_t tag_size,
+    std::unique_ptr<core::ICipherSession> cpu) {
+    bool supported = type == core::AlgorithmType::AES_128_GCM ||
+                     type == core::AlgorithmType::AES_192_GCM ||
+                     type == core::AlgorithmType::AES_256_GCM ||
+                     type == core::AlgorithmType::CHACHA20_POLY1305;
+    if (!cpu || !supported || nonce_size != NONCE_SIZE || tag_size > 16 || !core::Offload::device()) {
+        return cpu;
+    }
+    return std::make_unique<OffloadSession>(type, key, tag_size, std::move(cpu));
+}
+
+OffloadSession::OffloadSession(
+    core::AlgorithmType type,
+    std::span<const uint8_t> key,
+    size_t tag_size,
+    std::unique_ptr<core::ICipherSession> cpu)
+    : type_(type),
+      key_(key.begin(), key.end()),
+      tag_size_(tag_size),
+      cpu_(std::move(cpu)) {}
+
+bool OffloadSession::is_gcm() const {
+    return type_ != core::AlgorithmType::CHACHA20_POLY1305;
+}
+
+bool OffloadSession::worth_offloading(size_t size) const {
+    if (size < core::Offload::min_bytes()) {
+        return false;
+    }
+    return size <= (is_gcm() ? GCM_MAX_BYTES : CHACHA_MAX_BYTES);
+}
+
+core::OffloadStatus OffloadSession::apply_keystream(std::span<const uint8_t> nonce, std::span<uint8_t> data) {
+    auto* device = core::Offload::device();
+    if (!device) {
+        return core::OffloadStatus::BUSY;
+    }
+    std::span<const uint8_t, NONCE_SIZE> fixed_nonce(nonce.data(), NONCE_SIZE);
+    core::OffloadStatus status;
+    if (is_gcm()) {
+        // inc32(J0): the first counter block of the message
+        std::array<uint8_t, 16> counter{};
+        std::copy(nonce.begin(), nonce.end(), counter.begin());
+        counter[15] = 2;
+        status = device->aes_ctr(key_, counter, data);
+    } else {
+        status = device->chacha20(std::span<const uint8_t, 32>(key_.data(), 32), fixed_nonce, 1, data);
+    }
+    if (status == core::OffloadStatus::FAILED) {
+        core::Offload::disable("keystream call failed");
+    }
+    return status;
+}
+
+core::ShortBytes OffloadSession::compute_tag(
+    std::span<const uint8_t> nonce,
+    const core::EncryptionConfig& config,
+    std::span<const uint8_t> ciphertext) {
+    auto ad = associated_data(config);
+    static const uint8_t zeros[16] = {};
+    uint8_t tag[16];
+
+    if (is_gcm()) {
+        // GMAC over pad16(A) || C is GHASH over the same blocks, except that
+        // its length block is L' = [8 * |pad16(A) || C|, 0] instead of
+        // L = [8 * |A|, 8 * |C|]. The last GHASH step multiplies (X ^ L) by
+        // H, so the GCM tag is the GMAC tag ^ (L ^ L') * H.
+        std::string cipher_name = "AES-" + std::to_string(key_.size() * 8);
+        auto mac = Botan::MessageAuthenticationCode::create_or_throw("GMAC(" + cipher_name + ")");
+        mac->set_key(key_);
+        mac->start(nonce.data(), nonce.size());
+        mac->update(ad.data(), ad.size());
+        mac->update(zeros, pad16(ad.size()));
+        mac->update(ciphertext.data(), ciphertext.size());
+        mac->final(tag);
+
+        uint8_t h[16] = {};
+        auto block = Botan::BlockCipher::create_or_throw(cipher_name);
+        block->set_key(key_);
+        block->encrypt(h);
+
+        uint8_t delta[16];
+        uint64_t gmac_bits = 8 * static_cast<uint64_t>(ad.size() + pad16(ad.size()) + ciphertext.size());
+        store_be64(delta, (8 * static_cast<uint64_t>(ad.size())) ^ gmac_bits);
+        store_be64(delta + 8, 8 * static_cast<uint64_t>(ciphertext.size()));
+        gf128_multiply(delta, h);
+        for (size_t i = 0; i < 16; ++i) {
+            tag[i] ^= delta[i];
+        }
+        Botan::secure_scrub_memory(h, sizeof(h));
+    } else {
+        // RFC 8439: the Poly1305 key is the start of keystream block 0
+        uint8_t block0[64];
+        core::keystream::chacha20_block(std::span<const uint8_t, 32>(key_.data(), 32),
+                                        std::span<const uint8_t, NONCE_SIZE>(nonce.data(), NONCE_SIZE), 0, block0);
+        auto mac = Botan::MessageAuthenticationCode::create_or_throw("Poly1305");
+        mac->set_key(block0, 32);
+        Botan::secure_scrub_memory(block0, sizeof(block0));
+
+        uint8_t lengths[16];
+        store_le64(lengths, ad.size());
+        store_le64(lengths + 8, ciphertext.size());
+        mac->update(ad.data(), ad.size());
+        mac->update(zeros, pad16(ad.size()));
+        mac->update(ciphertext.data(), ciphertext.size());
+        mac->update(zeros, pad16(ciphertext.size()));
+        mac->update(lengths, sizeof(lengths));
+        mac->final(tag);
+    }
+    return core::ShortBytes(tag, tag + tag_size_);
+}
+
+core::CryptoResult OffloadSession::encrypt_in_place(
+    std::vector<uint8_t>& buffer,
+    const core::EncryptionConfig& config) {
+    if (!worth_offloading(buffer.size())) {
+        return cpu_->encrypt_in_place(buffer, config);
+    }
+    utils::ScopedSpan trace_span("OffloadSession::encrypt_in_place", "cipher", buffer.size());
+
+    core::CryptoResult result;
+    try {
+        core::ShortBytes nonce;
+        if (config.nonce.has_value() && config.nonce.value().size() == NONCE_SIZE) {
+            nonce = config.nonce.value();
+        } else {
+            nonce.resize(NONCE_SIZE);
+            core::RandomService::rng().randomize(nonce.data(), nonce.size());
+        }
+
+        auto status = apply_keystream(nonce, buffer);
+        if (status != core::OffloadStatus::DONE) {
+            // Busy or failed: the buffer still holds the plaintext
+            core::EncryptionConfig cpu_config = config;
+            cpu_config.nonce = nonce;
+            return cpu_->encrypt_in_place(buffer, cpu_config);
+        }
+
+        result.tag = compute_tag(nonce, config, buffer);
+        result.nonce = nonce;
+        result.success = true;
+        result.algorithm_used = type_;
+        result.original_size = buffer.size();
+        result.final_size = buffer.size();
+        return result;
+
+    } catch (const std::exception& e) {
+        std::fill(buffer.begin(), buffer.end(), 0);
+        buffer.clear();
+        result.success = false;
+        result.error_message = std::string("Encryption failed: ") + e.what();
+        return result;
+    }
+}
+
+core::CryptoResult OffloadSession::decrypt_in_place(
+    std::vector<uint8_t>& buffer,
+    const core::EncryptionConfig& config) {
+    if (!worth_offloading(buffer.size()) || !config.nonce.has_value() || !config.tag.has_value() ||
+        config.nonce.value().size() != NONCE_SIZE || config.tag.value().size() != tag_size_) {
+        return cpu_->decrypt_in_place(buffer, config);
+    }
+    utils::ScopedSpan trace_span("OffloadSession::decrypt_in_place", "cipher", buffer.size());
+
+    core::CryptoResult result;
+    size_t ciphertext_len = buffer.size();
+    try {
+        const auto& nonce = config.nonce.value();
+        const auto& tag = config.tag.value();
+
+        // Authenticate before any plaintext exists
+        auto expected = compute_tag(nonce, config, buffer);
+        if (!Botan::constant_time_compare(expected.data(), tag.data(), tag_size_)) {
+            std::fill(buffer.begin(), buffer.end(), 0);
+            buffer.clear();
+            result.success = false;
+            result.error_message = "Authentication failed: Invalid tag (data may be corrupted or tampered)";
+            return result;
+        }
+
+        if (apply_keystream(nonce, buffer) != core::OffloadStatus::DONE) {
+            return cpu_->decrypt_in_place(buffer, config);
+        }
+
+        result.success = true;
+        result.algorithm_used = type_;
+        result.original_size = ciphertext_len;
+        result.final_size = buffer.size();
+        return result;
+
+    } catch (const std::exception& e) {
+        std::fill(buffer.begin(), buffer.end(), 0);
+        buffer.clear();
+        result.success = false;
+        result.error_message = std::string("Decryption failed: ") + e.what();
+        return result;
+    }
+}
+
+core::BatchResult OffloadSession::encrypt_batch(
+    std::span<const std::span<const uint8_t>> messages,
+    const core::EncryptionConfig& config,
+    std::vector<uint8_t>& arena) {
+    return cpu_->encrypt_batch(messages, config, arena);
+}
+
+core::BatchResult OffloadSession::decrypt_batch(
+    std::span<const uint8_t> arena,
+    std::span<const core::BatchRecord> records,
+    const core::EncryptionConfig& config,
+    std::vector<uint8_t>& output) {
+    return cpu_->decrypt_batch(arena, records, config, output);
+}
+
+bool OffloadSession::encrypt_begin(const core::EncryptionConfig& config) {
+    return cpu_->encrypt_begin(config);
+}
+
+size_t OffloadSession::encrypt_update(std::span<uint8_t> buffer) {
+    return cpu_->encrypt_update(buffer);
+}
+
+core::CryptoResult OffloadSession::encrypt_finish(std::vector<uint8_t>& buffer) {
+    return cpu_->encrypt_finish(buffer);
+}
+
+size_t OffloadSession::encrypt_granularity() const {
+    return cpu_->encrypt_granularity();
+}
+
+bool OffloadSession::decrypt_begin(const core::EncryptionConfig& config) {
+    return cpu_->decrypt_begin(config);
+}
+
+size_t OffloadSession::decrypt_update(std::span<uint8_t> buffer) {
+    return cpu_->decrypt_update(buffer);
+}
+
+core::CryptoResult OffloadSession::decrypt_finish(std::vector<uint8_t>& buffer) {
+    return cpu_->decrypt_finish(buffer);
+}
+
+size_t OffloadSession::decrypt_granularity() const {
+    return cpu_->decrypt_granularity();
+}
+
+} // namespace symmetric
+} // namespace algorithms
+} // namespace filevault
@@ -1,7 +1,9 @@
 #include "filevault/algorithms/symmetric/serpent_gcm.hpp"
+#include "filevault/algorithms/symmetric/aead_session.hpp"
+#include "filevault/core/random.hpp"
+#include "filevault/utils/trace.hpp"
 #include <botan/cipher_mode.h>
 #include <botan/hex.h>
-#include <botan/auto_rng.h>
 #include <spdlog/spdlog.h>
 #include <stdexcept>
 #include <chrono>
@@ -11,7 +13,7 @@ namespace algorithms {
 namespace symmetric {
 
 Serpent_GCM::Serpent_GCM() {
-    spdlog::debug("Serpent_GCM initialized");
+    SPDLOG_DEBUG("Serpent_GCM initialized");
 }
 
 std::string Serpent_GCM::name() const {
@@ -26,6 +28,13 @@ size_t Serpent_GCM::key_size() const {
     return 32;  // 256 bits
 }
 
+std::unique_ptr<core::ICipherSession> Serpent_GCM::create_session(std::span<const uint8_t> key) {
+    if (key.size() != key_size()) {
+        return nullptr;
+    }
+    return std::make_unique<AeadSession>("Serpent/GCM", type(), key, 12, 16);
+}
+
 bool Serpent_GCM::is_suitable_for(core::SecurityLevel level) const {
     // Serpent is recommended for high security levels
     return level >= core::SecurityLevel::MEDIUM;
@@ -36,6 +45,7 @@ core::CryptoResult Serpent_GCM::encrypt(
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config
 ) {
+    utils::ScopedSpan trace_span("Serpent_GCM::encrypt", "cipher", plaintext.size());
     try {
         // Validate inputs
         if (key.size() != key_size()) {
@@ -57,13 +67,13 @@ core::CryptoResult Serpent_GCM::encrypt(
         std::vector<uint8_t> nonce;
         if (config.nonce.has_value() && config.nonce.value().size() == 12) {
             nonce = config.nonce.value();
-            spdlog::debug("Serpent-GCM: Using provided nonce (testing mode)");
+            SPDLOG_DEBUG("Serpent-GCM: Using provided nonce (testing mode)");
         } else {
             // CRITICAL: Generate NEW unique nonce for THIS encryption
-            Botan::AutoSeeded_RNG rng;
+            auto& rng = core::RandomService::rng();
             nonce.resize(12);  // GCM requires 12-byte nonce
             rng.randomize(nonce.data(), nonce.size());
-            spdlog::debug("Serpent-GCM: Generated new unique nonce ({} bytes)", nonce.size());
+            SPDLOG_DEBUG("Serpent-GCM: Generated new unique nonce ({} bytes)", nonce.size());
         }
         
         // Note: GCM mode allows empty plaintext (authentication-only mode)
@@ -142,6 +152,7 @@ core::CryptoResult Serpent_GCM::decrypt(
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config
 ) {
+    utils::ScopedSpan trace_span("Serpent_GCM::decrypt", "cipher", ciphertext.size());
     try {
         // Validate inputs
         if (key.size() != key_size()) {
@@ -207,7 +218,7 @@ core::CryptoResult Serpent_GCM::decrypt(
         auto end = std::chrono::high_resolution_clock::now();
         double time_ms = std::chrono::duration<double, std::milli>(end - start).count();
         
-        spdlog::debug("Serpent-256-GCM decrypted {} bytes -> {} bytes in {:.2f}ms",
+        SPDLOG_DEBUG("Serpent-256-GCM decrypted {} bytes -> {} bytes in {:.2f}ms",
                      ciphertext.size(), plaintext.size(), time_ms);
         
         return core::CryptoResult{
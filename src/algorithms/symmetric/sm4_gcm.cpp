@@ -4,7 +4,9 @@
  */
 
 #include "filevault/algorithms/symmetric/sm4_gcm.hpp"
-#include <botan/auto_rng.h>
+#include "filevault/algorithms/symmetric/aead_session.hpp"
+#include "filevault/core/random.hpp"
+#include "filevault/utils/trace.hpp"
 #include <botan/hex.h>
 #include <spdlog/spdlog.h>
 #include <stdexcept>
@@ -14,7 +16,7 @@ namespace algorithms {
 namespace symmetric {
 
 SM4_GCM::SM4_GCM() {
-    spdlog::debug("Created SM4-GCM algorithm");
+    SPDLOG_DEBUG("Created SM4-GCM algorithm");
 }
 
 std::string SM4_GCM::name() const {
@@ -30,6 +32,7 @@ core::CryptoResult SM4_GCM::encrypt(
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config
 ) {
+    utils::ScopedSpan trace_span("SM4_GCM::encrypt", "cipher", plaintext.size());
     core::CryptoResult result;
     
     try {
@@ -50,7 +53,7 @@ core::CryptoResult SM4_GCM::encrypt(
         }
         
         // Generate nonce
-        Botan::AutoSeeded_RNG rng;
+        auto& rng = core::RandomService::rng();
         std::vector<uint8_t> nonce(nonce_size());
         if (config.nonce && !config.nonce->empty()) {
             nonce = *config.nonce;
@@ -84,17 +87,17 @@ core::CryptoResult SM4_GCM::encrypt(
         result.data.assign(buffer.begin(), buffer.begin() + ciphertext_len);
         
         // Store tag separately
-        result.tag = std::vector<uint8_t>(
+        result.tag = core::ShortBytes(
             buffer.begin() + ciphertext_len,
             buffer.end()
         );
         
         // Store nonce
-        result.nonce = std::vector<uint8_t>(nonce.begin(), nonce.end());
+        result.nonce = core::ShortBytes(nonce.begin(), nonce.end());
         
         result.success = true;
         
-        spdlog::debug("SM4-GCM encryption successful: {} bytes -> {} bytes + {} byte tag",
+        SPDLOG_DEBUG("SM4-GCM encryption successful: {} bytes -> {} bytes + {} byte tag",
                       plaintext.size(), result.data.size(), tag_size());
         
     } catch (const Botan::Exception& e) {
@@ -115,6 +118,7 @@ core::CryptoResult SM4_GCM::decrypt(
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config
 ) {
+    utils::ScopedSpan trace_span("SM4_GCM::decrypt", "cipher", ciphertext.size());
     core::CryptoResult result;
     
     try {
@@ -177,7 +181,7 @@ core::CryptoResult SM4_GCM::decrypt(
         result.data.assign(buffer.begin(), buffer.end());
         result.success = true;
         
-        spdlog::debug("SM4-GCM decryption successful: {} bytes -> {} bytes",
+        SPDLOG_DEBUG("SM4-GCM decryption successful: {} bytes -> {} bytes",
                       ciphertext.size(), result.data.size());
         
     } catch (const Botan::Invalid_Authentication_Tag& e) {
@@ -197,6 +201,13 @@ core::CryptoResult SM4_GCM::decrypt(
     return result;
 }
 
+std::unique_ptr<core::ICipherSession> SM4_GCM::create_session(std::span<const uint8_t> key) {
+    if (key.size() != key_size()) {
+        return nullptr;
+    }
+    return std::make_unique<AeadSession>("SM4/GCM", type(), key, nonce_size(), tag_size());
+}
+
 bool SM4_GCM::is_suitable_for(core::SecurityLevel level) const {
     // SM4 only has 128-bit key, suitable for WEAK and MEDIUM
     // For STRONG/PARANOID, prefer 256-bit algorithms
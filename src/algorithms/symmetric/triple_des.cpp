@@ -4,7 +4,8 @@
  */
 
 #include "filevault/algorithms/symmetric/triple_des.hpp"
-#include <botan/auto_rng.h>
+#include "filevault/core/random.hpp"
+#include "filevault/utils/trace.hpp"
 #include <botan/hex.h>
 #include <spdlog/spdlog.h>
 #include <chrono>
@@ -14,8 +15,8 @@ namespace algorithms {
 namespace symmetric {
 
 TripleDES::TripleDES() {
-    spdlog::debug("Created Triple-DES algorithm");
-    spdlog::debug("Triple-DES is a legacy algorithm. Consider using AES instead.");
+    SPDLOG_DEBUG("Created Triple-DES algorithm");
+    SPDLOG_DEBUG("Triple-DES is a legacy algorithm. Consider using AES instead.");
 }
 
 core::CryptoResult TripleDES::encrypt(
@@ -23,6 +24,7 @@ core::CryptoResult TripleDES::encrypt(
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config
 ) {
+    utils::ScopedSpan trace_span("TripleDES::encrypt", "cipher", plaintext.size());
     auto start = std::chrono::high_resolution_clock::now();
     core::CryptoResult result;
     
@@ -39,12 +41,12 @@ core::CryptoResult TripleDES::encrypt(
         std::vector<uint8_t> iv;
         if (config.nonce.has_value() && config.nonce.value().size() == iv_size()) {
             iv = config.nonce.value();
-            spdlog::debug("3DES: Using provided IV");
+            SPDLOG_DEBUG("3DES: Using provided IV");
         } else {
-            Botan::AutoSeeded_RNG rng;
+            auto& rng = core::RandomService::rng();
             iv.resize(iv_size());
             rng.randomize(iv.data(), iv.size());
-            spdlog::debug("3DES: Generated new IV ({} bytes)", iv.size());
+            SPDLOG_DEBUG("3DES: Generated new IV ({} bytes)", iv.size());
         }
         
         // Create cipher
@@ -74,7 +76,7 @@ core::CryptoResult TripleDES::encrypt(
         auto end = std::chrono::high_resolution_clock::now();
         result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
         
-        spdlog::debug("3DES encryption: {} bytes -> {} bytes in {:.2f}ms",
+        SPDLOG_DEBUG("3DES encryption: {} bytes -> {} bytes in {:.2f}ms",
                       plaintext.size(), result.data.size(), result.processing_time_ms);
         
     } catch (const Botan::Exception& e) {
@@ -95,6 +97,7 @@ core::CryptoResult TripleDES::decrypt(
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config
 ) {
+    utils::ScopedSpan trace_span("TripleDES::decrypt", "cipher", ciphertext.size());
     auto start = std::chrono::high_resolution_clock::now();
     core::CryptoResult result;
     
@@ -149,7 +152,7 @@ core::CryptoResult TripleDES::decrypt(
         auto end = std::chrono::high_resolution_clock::now();
         result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
         
-        spdlog::debug("3DES decryption: {} bytes -> {} bytes in {:.2f}ms",
+        SPDLOG_DEBUG("3DES decryption: {} bytes -> {} bytes in {:.2f}ms",
                       ciphertext.size(), result.data.size(), result.processing_time_ms);
         
     } catch (const Botan::Decoding_Error&) {
@@ -9,9 +9,11 @@
  */
 
 #include "filevault/algorithms/symmetric/twofish_gcm.hpp"
+#include "filevault/algorithms/symmetric/aead_session.hpp"
+#include "filevault/core/random.hpp"
+#include "filevault/utils/trace.hpp"
 #include <botan/cipher_mode.h>
 #include <botan/hex.h>
-#include <botan/auto_rng.h>
 #include <spdlog/spdlog.h>
 #include <stdexcept>
 #include <chrono>
@@ -44,7 +46,7 @@ Twofish_GCM::Twofish_GCM(size_t key_bits) : key_bits_(key_bits) {
     // Botan uses "Twofish/GCM" for all key sizes
     botan_name_ = "Twofish/GCM";
     
-    spdlog::debug("Twofish_GCM initialized with {} bit key", key_bits_);
+    SPDLOG_DEBUG("Twofish_GCM initialized with {} bit key", key_bits_);
 }
 
 std::string Twofish_GCM::name() const {
@@ -59,6 +61,13 @@ size_t Twofish_GCM::key_size() const {
     return key_bits_ / 8;
 }
 
+std::unique_ptr<core::ICipherSession> Twofish_GCM::create_session(std::span<const uint8_t> key) {
+    if (key.size() != key_size()) {
+        return nullptr;
+    }
+    return std::make_unique<AeadSession>(botan_name_, type_, key, nonce_size(), tag_size());
+}
+
 bool Twofish_GCM::is_suitable_for(core::SecurityLevel level) const {
     // Twofish-256 is suitable for all security levels
     // Twofish-128 is suitable for MEDIUM and below
@@ -79,6 +88,7 @@ core::CryptoResult Twofish_GCM::encrypt(
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config
 ) {
+    utils::ScopedSpan trace_span("Twofish_GCM::encrypt", "cipher", plaintext.size());
     try {
         // Validate key size
         if (key.size() != key_size()) {
@@ -100,13 +110,13 @@ core::CryptoResult Twofish_GCM::encrypt(
         std::vector<uint8_t> nonce;
         if (config.nonce.has_value() && config.nonce.value().size() == nonce_size()) {
             nonce = config.nonce.value();
-            spdlog::debug("Twofish-GCM: Using provided nonce (testing mode)");
+            SPDLOG_DEBUG("Twofish-GCM: Using provided nonce (testing mode)");
         } else {
             // Generate NEW unique nonce for THIS encryption
-            Botan::AutoSeeded_RNG rng;
+            auto& rng = core::RandomService::rng();
             nonce.resize(nonce_size());
             rng.randomize(nonce.data(), nonce.size());
-            spdlog::debug("Twofish-GCM: Generated new unique nonce ({} bytes)", nonce.size());
+            SPDLOG_DEBUG("Twofish-GCM: Generated new unique nonce ({} bytes)", nonce.size());
         }
         
         auto start = std::chrono::high_resolution_clock::now();
@@ -149,7 +159,7 @@ core::CryptoResult Twofish_GCM::encrypt(
             ciphertext_with_tag.end()
         );
         
-        spdlog::debug("Twofish-{}-GCM encrypted {} bytes -> {} bytes in {:.2f}ms",
+        SPDLOG_DEBUG("Twofish-{}-GCM encrypted {} bytes -> {} bytes in {:.2f}ms",
                      key_bits_, plaintext.size(), ciphertext_only.size(), time_ms);
         
         return core::CryptoResult{
@@ -186,6 +196,7 @@ core::CryptoResult Twofish_GCM::decrypt(
     std::span<const uint8_t> key,
     const core::EncryptionConfig& config
 ) {
+    utils::ScopedSpan trace_span("Twofish_GCM::decrypt", "cipher", ciphertext.size());
     try {
         // Validate key size
         if (key.size() != key_size()) {
@@ -249,7 +260,7 @@ core::CryptoResult Twofish_GCM::decrypt(
         auto end = std::chrono::high_resolution_clock::now();
         double time_ms = std::chrono::duration<double, std::milli>(end - start).count();
         
-        spdlog::debug("Twofish-{}-GCM decrypted {} bytes -> {} bytes in {:.2f}ms",
+        SPDLOG_DEBUG("Twofish-{}-GCM decrypted {} bytes -> {} bytes in {:.2f}ms",
                      key_bits_, ciphertext.size(), plaintext.size(), time_ms);
         
         return core::CryptoResult{
@@ -1,21 +1,190 @@
 #include "filevault/archive/archive_format.hpp"
+#include "filevault/core/thread_pool.hpp"
+#include "filevault/utils/io_backend.hpp"
+#include <botan/hash.h>
 #include <fstream>
 #include <cstring>
 #include <chrono>
 #include <stdexcept>
+#include <algorithm>
+#include <istream>
+#include <map>
 
 #ifdef _WIN32
 #include <sys/stat.h>
 #else
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
 #endif
 
 namespace filevault::archive {
 
 namespace fs = std::filesystem;
 
+namespace {
+
+constexpr uint64_t MAX_POOLED_MEMBER = 1024 * 1024;        // Larger members are streamed inline
+constexpr size_t MAX_PENDING_BYTES = 64 * 1024 * 1024;     // Buffered member data in flight
+constexpr size_t MAX_PENDING_FILES = 256;
+
+/**
+ * @brief Create every parent directory of the entries once, up front
+ */
+std::string create_parent_directories(const fs::path& output_dir, const std::vector<FileEntry>& entries) {
+    std::unordered_set<std::string> created;
+    std::error_code ec;
+    fs::create_directories(output_dir, ec);
+    if (ec) {
+        return "Cannot create " + output_dir.string() + ": " + ec.message();
+    }
+    for (const auto& entry : entries) {
+        auto parent = (output_dir / entry.filename).parent_path();
+        if (!created.insert(parent.string()).second) {
+            continue;
+        }
+        fs::create_directories(parent, ec);
+        if (ec) {
+            return "Cannot create " + parent.string() + ": " + ec.message();
+        }
+    }
+    return {};
+}
+
+/**
+ * @brief End of the data stored for these entries (shared ones point back)
+ */
+uint64_t data_end(const std::vector<FileEntry>& entries) {
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        if (!it->shared) {
+            return it->offset + it->stored_size();
+        }
+    }
+    return 0;
+}
+
+} // anonymous namespace
+
+/**
+ * @brief Output file for one extracted member
+ *
+ * A raw descriptor on POSIX so the file can be preallocated with
+ * posix_fallocate and written without stream buffering (members arrive
+ * in large blocks already).
+ */
+class MemberFile {
+public:
+    MemberFile() = default;
+    MemberFile(const MemberFile&) = delete;
+    MemberFile& operator=(const MemberFile&) = delete;
+    ~MemberFile() { close(); }
+    
+    bool open(const fs::path& path, uint64_t size, bool preallocate) {
+#ifdef _WIN32
+        (void)size;
+        (void)preallocate;
+        out_.open(path, std::ios::binary | std::ios::trunc);
+        return static_cast<bool>(out_);
+#else
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            return false;
+        }
+#if defined(__linux__)
+        if (preallocate && size > 0) {
+            // Best effort: filesystems without support just skip it
+            (void)::posix_fallocate(fd_, 0, static_cast<off_t>(size));
+        }
+#else
+        (void)size;
+        (void)preallocate;
+#endif
+        return true;
+#endif
+    }
+    
+    bool write(const uint8_t* data, size_t size) {
+#ifdef _WIN32
+        out_.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+        ok_ = ok_ && static_cast<bool>(out_);
+#else
+        while (ok_ && size > 0) {
+            ssize_t n = ::write(fd_, data, size);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                ok_ = false;
+                break;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+#endif
+        return ok_;
+    }
+    
+    bool close() {
+#ifdef _WIN32
+        if (out_.is_open()) {
+            out_.close();
+            ok_ = ok_ && static_cast<bool>(out_);
+        }
+#else
+        if (fd_ >= 0) {
+            ok_ = (::close(fd_) == 0) && ok_;
+            fd_ = -1;
+        }
+#endif
+        return ok_;
+    }
+
+private:
+#ifdef _WIN32
+    std::ofstream out_;
+#else
+    int fd_ = -1;
+#endif
+    bool ok_ = true;
+};
+
+namespace {
+
+/**
+ * @brief Write one member in full
+ * @return Empty on success, otherwise an error message
+ */
+std::string write_member(const fs::path& path, const uint8_t* data, size_t size, bool preallocate) {
+    MemberFile file;
+    if (!file.open(path, size, preallocate)) {
+        return "Cannot create " + path.string();
+    }
+    if (!file.write(data, size) || !file.close()) {
+        return "Failed to write " + path.string();
+    }
+    return {};
+}
+
+} // anonymous namespace
+
 // FileEntry serialization
+namespace {
+constexpr uint8_t ENTRY_IN_BASE = 0x01;
+constexpr uint8_t ENTRY_SHARED = 0x02;
+constexpr uint8_t ENTRY_DIGEST_AFTER = 0x04;
+} // anonymous namespace
+
+size_t FileEntry::fixed_size(uint8_t version) {
+    // Size, offset, mtime, permissions; then flags and content hash
+    return version >= 2 ? 28 + 1 + sizeof(ContentHash) : 28;
+}
+
 std::vector<uint8_t> FileEntry::serialize() const {
+    return serialize(ArchiveFormat::VERSION);
+}
+
+std::vector<uint8_t> FileEntry::serialize(uint8_t version) const {
     std::vector<uint8_t> buffer;
     
     // Filename length + filename
@@ -40,10 +209,20 @@ std::vector<uint8_t> FileEntry::serialize() const {
     const uint8_t* perm_bytes = reinterpret_cast<const uint8_t*>(&permissions);
     buffer.insert(buffer.end(), perm_bytes, perm_bytes + 4);
     
+    if (version >= 2) {
+        buffer.push_back(static_cast<uint8_t>((in_base ? ENTRY_IN_BASE : 0) | (shared ? ENTRY_SHARED : 0) |
+                                              (digest_after ? ENTRY_DIGEST_AFTER : 0)));
+        buffer.insert(buffer.end(), content_hash.begin(), content_hash.end());
+    }
+    
     return buffer;
 }
 
 FileEntry FileEntry::deserialize(std::span<const uint8_t> data, size_t& offset) {
+    return deserialize(data, offset, ArchiveFormat::VERSION);
+}
+
+FileEntry FileEntry::deserialize(std::span<const uint8_t> data, size_t& offset, uint8_t version) {
     FileEntry entry;
     
     // Bounds check for filename length
@@ -62,8 +241,8 @@ FileEntry FileEntry::deserialize(std::span<const uint8_t> data, size_t& offset)
     entry.filename = std::string(reinterpret_cast<const char*>(&data[offset]), name_len);
     offset += name_len;
     
-    // Bounds check for remaining fixed-size fields (8+8+8+4 = 28 bytes)
-    if (offset + 28 > data.size()) {
+    // Bounds check for remaining fixed-size fields
+    if (offset + fixed_size(version) > data.size()) {
         throw std::runtime_error("Truncated archive: cannot read file entry metadata");
     }
     
@@ -83,77 +262,90 @@ FileEntry FileEntry::deserialize(std::span<const uint8_t> data, size_t& offset)
     entry.permissions = *reinterpret_cast<const uint32_t*>(&data[offset]);
     offset += 4;
     
+    if (version >= 2) {
+        entry.in_base = (data[offset] & ENTRY_IN_BASE) != 0;
+        entry.shared = (data[offset] & ENTRY_SHARED) != 0;
+        entry.digest_after = (data[offset++] & ENTRY_DIGEST_AFTER) != 0;
+        std::memcpy(entry.content_hash.data(), &data[offset], entry.content_hash.size());
+        offset += entry.content_hash.size();
+    }
+    
     return entry;
 }
 
-// Archive creation
-std::vector<uint8_t> ArchiveFormat::create_archive(const std::vector<fs::path>& files) {
-    std::vector<uint8_t> archive;
-    std::vector<FileEntry> entries;
-    
-    // Write header: magic + version + entry count
-    archive.insert(archive.end(), MAGIC, MAGIC + 6);
-    archive.push_back(VERSION);
-    
-    write_uint32(archive, static_cast<uint32_t>(files.size()));
-    
-    // Calculate offsets and create entries
-    uint64_t current_offset = 0;
-    for (const auto& file_path : files) {
-        if (!fs::exists(file_path)) {
-            throw std::runtime_error("File not found: " + file_path.string());
-        }
-        
-        FileEntry entry;
-        entry.filename = file_path.filename().string();
-        entry.file_size = fs::file_size(file_path);
-        entry.offset = current_offset;
-        
-        // Get modification time
-        auto ftime = fs::last_write_time(file_path);
-        auto sctp = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
-            ftime - fs::file_time_type::clock::now() + std::chrono::system_clock::now()
-        );
-        entry.modified_time = std::chrono::system_clock::to_time_t(sctp);
-        
-        // Get permissions
+// Entry metadata
+FileEntry ArchiveFormat::make_entry(const fs::path& file_path, uint64_t offset) {
+    FileEntry entry;
+    if (!stat_entry(file_path, entry)) {
+        throw std::runtime_error("File not found: " + file_path.string());
+    }
+    entry.filename = file_path.filename().string();
+    entry.offset = offset;
+    return entry;
+}
+
+bool ArchiveFormat::stat_entry(const fs::path& file_path, FileEntry& entry) {
 #ifdef _WIN32
-        struct _stat64 st;
-        if (_stat64(file_path.string().c_str(), &st) == 0) {
-            entry.permissions = st.st_mode;
-        } else {
-            entry.permissions = 0644;  // Default
-        }
+    struct _stat64 st;
+    if (_wstat64(file_path.c_str(), &st) != 0 || (st.st_mode & _S_IFMT) != _S_IFREG) {
+        return false;
+    }
+    entry.permissions = st.st_mode;
 #else
-        struct stat st;
-        if (stat(file_path.c_str(), &st) == 0) {
-            entry.permissions = st.st_mode & 0777;
-        } else {
-            entry.permissions = 0644;
-        }
+    struct stat st;
+    if (stat(file_path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    entry.permissions = st.st_mode & 0777;
 #endif
-        
-        entries.push_back(entry);
-        current_offset += entry.file_size;
+    entry.file_size = static_cast<uint64_t>(st.st_size);
+    entry.modified_time = static_cast<uint64_t>(st.st_mtime);
+    return true;
+}
+
+bool ArchiveFormat::is_safe_name(const std::string& name) {
+    if (name.empty() || name.front() == '/' || name.front() == '\\' ||
+        (name.size() >= 2 && name[1] == ':')) {
+        return false;
     }
-    
-    // Write all entry metadata
-    for (const auto& entry : entries) {
-        auto entry_data = entry.serialize();
-        archive.insert(archive.end(), entry_data.begin(), entry_data.end());
+    size_t start = 0;
+    while (start <= name.size()) {
+        size_t end = name.find_first_of("/\\", start);
+        if (end == std::string::npos) {
+            end = name.size();
+        }
+        if (end - start == 2 && name.compare(start, 2, "..") == 0) {
+            return false;
+        }
+        start = end + 1;
     }
+    return true;
+}
+
+void ArchiveFormat::restore_metadata(const fs::path& path, const FileEntry& entry) {
+    // Restore modification time
+    auto ftime = fs::file_time_type::clock::now() + 
+        std::chrono::seconds(entry.modified_time) -
+        std::chrono::seconds(std::chrono::system_clock::to_time_t(
+            std::chrono::system_clock::now()
+        ));
+    fs::last_write_time(path, ftime);
     
-    // Write file data
-    for (size_t i = 0; i < files.size(); ++i) {
-        std::ifstream file(files[i], std::ios::binary);
-        if (!file) {
-            throw std::runtime_error("Failed to open: " + files[i].string());
-        }
-        
-        std::vector<uint8_t> file_data(entries[i].file_size);
-        file.read(reinterpret_cast<char*>(file_data.data()), entries[i].file_size);
-        
-        archive.insert(archive.end(), file_data.begin(), file_data.end());
+    // Restore permissions on Unix
+#ifndef _WIN32
+    chmod(path.c_str(), entry.permissions);
+#endif
+}
+
+// Archive creation
+std::vector<uint8_t> ArchiveFormat::create_archive(const std::vector<fs::path>& files) {
+    ArchiveSource source(files);
+    std::vector<uint8_t> archive(source.size());
+    
+    std::istream input(&source);
+    input.read(reinterpret_cast<char*>(archive.data()), static_cast<std::streamsize>(archive.size()));
+    if (!input) {
+        throw std::runtime_error(source.error().empty() ? "Failed to read archive members" : source.error());
     }
     
     return archive;
@@ -162,69 +354,105 @@ std::vector<uint8_t> ArchiveFormat::create_archive(const std::vector<fs::path>&
 // Archive extraction
 bool ArchiveFormat::extract_archive(
     std::span<const uint8_t> archive_data,
-    const fs::path& output_dir
+    const fs::path& output_dir,
+    const ExtractOptions& options
 ) {
-    size_t offset = 0;
-    
-    // Verify magic
-    if (archive_data.size() < 11 || 
-        std::memcmp(archive_data.data(), MAGIC, 6) != 0) {
+    ArchiveHeader header;
+    std::string error;
+    if (!parse_header(archive_data, header, error)) {
         return false;
     }
-    offset += 6;
-    
-    // Verify version
-    uint8_t version = archive_data[offset++];
-    if (version != VERSION) {
-        return false;
-    }
-    
-    // Read entry count
-    uint32_t entry_count = read_uint32(archive_data, offset);
+    size_t offset = header.size;
     
     // Read all entries
     std::vector<FileEntry> entries;
-    for (uint32_t i = 0; i < entry_count; ++i) {
-        entries.push_back(FileEntry::deserialize(archive_data, offset));
+    for (uint32_t i = 0; i < header.entry_count; ++i) {
+        entries.push_back(FileEntry::deserialize(archive_data, offset, header.version));
     }
     
     // Data section starts here
     size_t data_section_offset = offset;
     
-    // Create output directory
-    if (!fs::exists(output_dir)) {
-        fs::create_directories(output_dir);
+    if (data_section_offset > archive_data.size()) {
+        return false;
+    }
+    for (const auto& entry : entries) {
+        // Members of a base archive cannot be resolved from a buffer
+        if (!is_safe_name(entry.filename) || entry.in_base) {
+            return false;
+        }
+        if (entry.offset > archive_data.size() - data_section_offset ||
+            entry.file_size > archive_data.size() - data_section_offset - entry.offset) {
+            return false;
+        }
+    }
+    
+    // Hashes computed while archiving follow the data
+    uint64_t digests = data_section_offset + data_end(entries);
+    if (digest_block_size(entries) > archive_data.size() - digests) {
+        return false;
+    }
+    apply_digests(archive_data.subspan(static_cast<size_t>(digests)), entries);
+    
+    auto member_data = [&](const FileEntry& entry) {
+        return archive_data.data() + data_section_offset + entry.offset;
+    };
+    if (options.verify) {
+        for (const auto& entry : entries) {
+            if (entry.has_hash() && hash_bytes({member_data(entry), static_cast<size_t>(entry.file_size)}) !=
+                                        entry.content_hash) {
+                return false;
+            }
+        }
+    }
+    if (options.check_only) {
+        return true;
+    }
+    
+    if (!create_parent_directories(output_dir, entries).empty()) {
+        return false;
     }
     
     // Extract files
-    for (const auto& entry : entries) {
-        fs::path output_path = output_dir / entry.filename;
+    if (options.threads == 1) {
+        for (const auto& entry : entries) {
+            if (!write_member(output_dir / entry.filename, member_data(entry),
+                              static_cast<size_t>(entry.file_size), options.preallocate).empty()) {
+                return false;
+            }
+        }
+    } else {
+        // Files with the same name must be written in archive order, so
+        // only the last occurrence of each is written
+        std::unordered_set<std::string> seen;
+        std::vector<const FileEntry*> unique;
+        for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+            if (seen.insert(it->filename).second) {
+                unique.push_back(&*it);
+            }
+        }
         
-        std::ofstream out_file(output_path, std::ios::binary);
-        if (!out_file) {
+        core::ThreadPool pool(options.threads);
+        std::vector<std::future<std::string>> writes;
+        writes.reserve(unique.size());
+        for (const FileEntry* entry : unique) {
+            writes.push_back(pool.submit([&, entry]() {
+                return write_member(output_dir / entry->filename, member_data(*entry),
+                                    static_cast<size_t>(entry->file_size), options.preallocate);
+            }));
+        }
+        bool ok = true;
+        for (auto& write : writes) {
+            ok = write.get().empty() && ok;
+        }
+        if (!ok) {
             return false;
         }
-        
-        size_t file_offset = data_section_offset + entry.offset;
-        out_file.write(
-            reinterpret_cast<const char*>(&archive_data[file_offset]),
-            entry.file_size
-        );
-        
-        out_file.close();
-        
-        // Restore modification time
-        auto ftime = fs::file_time_type::clock::now() + 
-            std::chrono::seconds(entry.modified_time) -
-            std::chrono::seconds(std::chrono::system_clock::to_time_t(
-                std::chrono::system_clock::now()
-            ));
-        fs::last_write_time(output_path, ftime);
-        
-        // Restore permissions on Unix
-#ifndef _WIN32
-        chmod(output_path.c_str(), entry.permissions);
-#endif
+    }
+    
+    // Metadata last, once nothing will touch the files again
+    for (const auto& entry : entries) {
+        restore_metadata(output_dir / entry.filename, entry);
     }
     
     return true;
@@ -233,29 +461,23 @@ bool ArchiveFormat::extract_archive(
 // List files
 std::vector<FileEntry> ArchiveFormat::list_files(std::span<const uint8_t> archive_data) {
     std::vector<FileEntry> entries;
-    size_t offset = 0;
-    
-    // Verify magic
-    if (archive_data.size() < 11 || 
-        std::memcmp(archive_data.data(), MAGIC, 6) != 0) {
-        return entries;
-    }
-    offset += 6;
-    
-    // Verify version
-    uint8_t version = archive_data[offset++];
-    if (version != VERSION) {
+    ArchiveHeader header;
+    std::string error;
+    if (!parse_header(archive_data, header, error)) {
         return entries;
     }
-    
-    // Read entry count
-    uint32_t entry_count = read_uint32(archive_data, offset);
+    size_t offset = header.size;
     
     // Read all entries
-    for (uint32_t i = 0; i < entry_count; ++i) {
-        entries.push_back(FileEntry::deserialize(archive_data, offset));
+    for (uint32_t i = 0; i < header.entry_count; ++i) {
+        entries.push_back(FileEntry::deserialize(archive_data, offset, header.version));
     }
     
+    // Then the hashes stored after the data
+    uint64_t digests = offset + data_end(entries);
+    if (digests <= archive_data.size()) {
+        apply_digests(archive_data.subspan(static_cast<size_t>(digests)), entries);
+    }
     return entries;
 }
 
@@ -289,4 +511,927 @@ std::string ArchiveFormat::read_string(std::span<const uint8_t> data, size_t& of
     return str;
 }
 
+namespace {
+constexpr size_t SOURCE_BUFFER_SIZE = 1024 * 1024;
+constexpr uint32_t MAX_FILENAME_LENGTH = 4096;
+constexpr size_t ARCHIVE_PREAMBLE_SIZE = 11;   // Magic(6) + Version(1) + Count(4)
+constexpr size_t INDEX_READ_SIZE = 64 * 1024;  // Table bytes fetched per range read
+} // anonymous namespace
+
+// Content hashes
+bool ArchiveFormat::hash_file(const fs::path& file_path, ContentHash& hash) {
+    // Reads ahead through the platform's async backend while hashing
+    utils::InputFileOptions options;
+    options.depth = 4;
+    options.block_size = SOURCE_BUFFER_SIZE;
+    utils::InputFile file(file_path.string(), options);
+    if (!file.is_open()) {
+        return false;
+    }
+    auto hasher = Botan::HashFunction::create_or_throw(CONTENT_HASH);
+    std::vector<char> buffer(SOURCE_BUFFER_SIZE);
+    while (file) {
+        file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        hasher->update(reinterpret_cast<const uint8_t*>(buffer.data()), static_cast<size_t>(file.gcount()));
+    }
+    if (file.bad()) {
+        return false;
+    }
+    hasher->final(hash.data());
+    return true;
+}
+
+ContentHash ArchiveFormat::hash_bytes(std::span<const uint8_t> data) {
+    auto hasher = Botan::HashFunction::create_or_throw(CONTENT_HASH);
+    hasher->update(data.data(), data.size());
+    ContentHash hash;
+    hasher->final(hash.data());
+    return hash;
+}
+
+bool ArchiveFormat::parse_header(std::span<const uint8_t> data, ArchiveHeader& header, std::string& error) {
+    if (data.size() < ARCHIVE_PREAMBLE_SIZE) {
+        return false;
+    }
+    if (std::memcmp(data.data(), MAGIC, 6) != 0) {
+        error = "Not a FileVault archive";
+        return false;
+    }
+    if (data[6] < MIN_VERSION || data[6] > APPENDABLE_VERSION) {
+        error = "Unsupported archive version " + std::to_string(data[6]);
+        return false;
+    }
+    
+    header.version = data[6];
+    std::memcpy(&header.entry_count, &data[7], 4);
+    header.size = ARCHIVE_PREAMBLE_SIZE;
+    if (header.version >= 2) {
+        if (data.size() < ARCHIVE_PREAMBLE_SIZE + sizeof(ContentHash)) {
+            return false;
+        }
+        std::memcpy(header.base_id.data(), &data[ARCHIVE_PREAMBLE_SIZE], sizeof(ContentHash));
+        header.size += sizeof(ContentHash);
+    }
+    return true;
+}
+
+std::vector<uint8_t> ArchiveFormat::serialize_table(const std::vector<FileEntry>& entries,
+                                                   const ContentHash& base_id, uint8_t version) {
+    std::vector<uint8_t> table(MAGIC, MAGIC + 6);
+    table.push_back(version);
+    uint32_t count = static_cast<uint32_t>(entries.size());
+    const uint8_t* count_bytes = reinterpret_cast<const uint8_t*>(&count);
+    table.insert(table.end(), count_bytes, count_bytes + 4);
+    if (version >= 2) {
+        table.insert(table.end(), base_id.begin(), base_id.end());
+    }
+    for (const auto& entry : entries) {
+        auto entry_data = entry.serialize(version);
+        table.insert(table.end(), entry_data.begin(), entry_data.end());
+    }
+    return table;
+}
+
+bool ArchiveFormat::parse_entries(std::span<const uint8_t> table, size_t& offset, const ArchiveHeader& header,
+                                  std::vector<FileEntry>& entries, std::string& error) {
+    // Only deserialize entries that have fully arrived
+    uint64_t expected_offset = data_end(entries);
+    size_t fixed_size = FileEntry::fixed_size(header.version);
+    while (entries.size() < header.entry_count) {
+        if (offset + 4 > table.size()) {
+            return false;
+        }
+        uint32_t name_len;
+        std::memcpy(&name_len, &table[offset], 4);
+        if (name_len > MAX_FILENAME_LENGTH) {
+            error = "Corrupt archive entry table";
+            return false;
+        }
+        if (offset + 4 + name_len + fixed_size > table.size()) {
+            return false;
+        }
+        entries.push_back(FileEntry::deserialize(table, offset, header.version));
+        if (!is_safe_name(entries.back().filename)) {
+            error = "Unsafe member name: " + entries.back().filename;
+            return false;
+        }
+        const auto& entry = entries.back();
+        if (entry.digest_after && entry.stored_size() == 0) {
+            error = "Corrupt archive entry table";
+            return false;
+        }
+        if (entry.shared) {
+            // Points back into data already stored in this segment
+            if (entry.in_base || entry.offset > expected_offset || entry.file_size > expected_offset - entry.offset) {
+                error = "Shared member refers past the stored data: " + entry.filename;
+                return false;
+            }
+        } else if (entry.offset != expected_offset) {
+            error = "Archive members are not stored in order";
+            return false;
+        }
+        expected_offset += entries.back().stored_size();
+    }
+    return true;
+}
+
+uint64_t ArchiveFormat::digest_block_size(const std::vector<FileEntry>& entries) {
+    auto count = std::count_if(entries.begin(), entries.end(),
+                               [](const FileEntry& entry) { return entry.digest_after; });
+    return static_cast<uint64_t>(count) * sizeof(ContentHash);
+}
+
+void ArchiveFormat::apply_digests(std::span<const uint8_t> block, std::span<FileEntry> entries) {
+    size_t offset = 0;
+    for (auto& entry : entries) {
+        if (entry.digest_after && offset + sizeof(ContentHash) <= block.size()) {
+            std::memcpy(entry.content_hash.data(), &block[offset], sizeof(ContentHash));
+            offset += sizeof(ContentHash);
+        }
+    }
+}
+
+// Streaming archive creation
+namespace {
+
+std::vector<ArchiveMember> stat_members(const std::vector<fs::path>& files) {
+    std::vector<ArchiveMember> members;
+    members.reserve(files.size());
+    for (const auto& file_path : files) {
+        members.push_back({file_path, ArchiveFormat::make_entry(file_path, 0)});
+    }
+    for (size_t i : ArchiveSource::duplicate_candidates(members)) {
+        if (!ArchiveFormat::hash_file(members[i].source, members[i].entry.content_hash)) {
+            throw std::runtime_error("Cannot read " + members[i].source.string());
+        }
+    }
+    return members;
+}
+
+} // anonymous namespace
+
+ArchiveSource::ArchiveSource(const std::vector<fs::path>& files)
+    : ArchiveSource(stat_members(files)) {
+}
+
+ArchiveSource::ArchiveSource(std::vector<ArchiveMember> members, const ContentHash& base_id) {
+    files_.reserve(members.size());
+    entries_.reserve(members.size());
+    std::map<ContentHash, size_t> first_copy;   // Content hash -> member storing it
+    const ContentHash empty_hash = ArchiveFormat::hash_bytes({});
+    for (auto& member : members) {
+        auto& entry = member.entry;
+        entry.offset = data_size_;
+        entry.shared = false;
+        entry.digest_after = false;
+        if (!entry.in_base && !entry.has_hash()) {
+            // Hashed as it is read; nothing to read for an empty file
+            if (entry.file_size == 0) {
+                entry.content_hash = empty_hash;
+            } else {
+                entry.digest_after = true;
+                digests_size_ += sizeof(ContentHash);
+            }
+        }
+        if (!entry.in_base && entry.file_size > 0 && entry.has_hash()) {
+            auto [it, inserted] = first_copy.try_emplace(entry.content_hash, entries_.size());
+            if (!inserted && entries_[it->second].file_size == entry.file_size) {
+                entry.offset = entries_[it->second].offset;
+                entry.shared = true;
+                shared_count_++;
+                shared_bytes_ += entry.file_size;
+            }
+        }
+        if (entry.stored_size() > 0) {
+            stored_.push_back(entries_.size());
+        }
+        data_size_ += entry.stored_size();
+        files_.push_back(std::move(member.source));
+        entries_.push_back(std::move(entry));
+    }
+    table_ = ArchiveFormat::serialize_table(entries_, base_id);
+}
+
+ArchiveSource::~ArchiveSource() = default;
+
+std::vector<size_t> ArchiveSource::duplicate_candidates(const std::vector<ArchiveMember>& members) {
+    std::unordered_map<uint64_t, size_t> sizes;   // File size -> stored members of that size
+    for (const auto& member : members) {
+        if (!member.entry.in_base && member.entry.file_size > 0) {
+            sizes[member.entry.file_size]++;
+        }
+    }
+    std::vector<size_t> candidates;
+    for (size_t i = 0; i < members.size(); ++i) {
+        const auto& entry = members[i].entry;
+        if (!entry.in_base && entry.file_size > 0 && !entry.has_hash() && sizes[entry.file_size] > 1) {
+            candidates.push_back(i);
+        }
+    }
+    return candidates;
+}
+
+void ArchiveSource::pad_to(uint64_t alignment) {
+    table_[6] = ArchiveFormat::APPENDABLE_VERSION;
+    uint64_t unpadded = table_.size() + data_size_ + digests_size_;
+    padding_ = alignment == 0 ? 0 : (alignment - unpadded % alignment) % alignment;
+}
+
+ArchiveSource::int_type ArchiveSource::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+    if (position_ >= size()) {
+        return traits_type::eof();
+    }
+    
+    // The entry table is served straight from memory
+    if (position_ < table_.size()) {
+        char* begin = reinterpret_cast<char*>(table_.data());
+        setg(begin, begin + position_, begin + table_.size());
+        position_ = table_.size();
+        return traits_type::to_int_type(*gptr());
+    }
+    
+    if (buffer_.empty()) {
+        buffer_.resize(SOURCE_BUFFER_SIZE);
+    }
+    
+    // Then the digests of members hashed on the way, then padding
+    uint64_t data_offset = position_ - table_.size();
+    if (data_offset >= data_size_ && data_offset < data_size_ + digests_size_) {
+        finish_digests();
+        size_t within = static_cast<size_t>(data_offset - data_size_);
+        char* begin = reinterpret_cast<char*>(digests_.data());
+        setg(begin, begin + within, begin + digests_.size());
+        position_ += digests_.size() - within;
+        return traits_type::to_int_type(*gptr());
+    }
+    if (data_offset >= data_size_) {
+        size_t want = static_cast<size_t>(std::min<uint64_t>(buffer_.size(), size() - position_));
+        std::fill_n(buffer_.data(), want, '\0');
+        member_ = SIZE_MAX;
+        position_ += want;
+        setg(buffer_.data(), buffer_.data(), buffer_.data() + want);
+        return traits_type::to_int_type(*gptr());
+    }
+    
+    // Members with data are laid out in order, so the last one starting
+    // at or before the offset holds it
+    auto next = std::upper_bound(stored_.begin(), stored_.end(), data_offset,
+        [this](uint64_t offset, size_t index) { return offset < entries_[index].offset; });
+    size_t index = *(next - 1);
+    auto& entry = entries_[index];
+    uint64_t within = data_offset - entry.offset;
+    
+    if (member_ != index) {
+        file_.close();
+        file_.clear();
+        file_.open(files_[index], std::ios::binary);
+        member_ = index;
+        member_offset_ = 0;
+    }
+    if (member_offset_ != within) {
+        file_.clear();
+        file_.seekg(static_cast<std::streamoff>(within));
+        member_offset_ = within;
+    }
+    
+    size_t want = static_cast<size_t>(std::min<uint64_t>(buffer_.size(), entry.stored_size() - within));
+    file_.read(buffer_.data(), static_cast<std::streamsize>(want));
+    if (static_cast<size_t>(file_.gcount()) != want) {
+        // The entry table already promised this many bytes
+        error_ = "File changed or became unreadable while archiving: " + files_[index].string();
+        throw std::runtime_error(error_);
+    }
+    if (entry.digest_after && !entry.has_hash()) {
+        digest(index, within, buffer_.data(), want);
+    }
+    
+    member_offset_ += want;
+    position_ += want;
+    setg(buffer_.data(), buffer_.data(), buffer_.data() + want);
+    return traits_type::to_int_type(*gptr());
+}
+
+void ArchiveSource::digest(size_t index, uint64_t within, const char* data, size_t size) {
+    // Only an unbroken read from the start gives the member's hash
+    if (within == 0) {
+        if (!hasher_) {
+            hasher_ = Botan::HashFunction::create_or_throw(ArchiveFormat::CONTENT_HASH);
+        }
+        hasher_->clear();
+        digesting_ = index;
+        digested_ = 0;
+    }
+    if (digesting_ != index || digested_ != within) {
+        return;
+    }
+    hasher_->update(reinterpret_cast<const uint8_t*>(data), size);
+    digested_ += size;
+    if (digested_ == entries_[index].file_size) {
+        hasher_->final(entries_[index].content_hash.data());
+        digesting_ = SIZE_MAX;
+    }
+}
+
+void ArchiveSource::finish_digests() {
+    if (!digests_.empty()) {
+        return;
+    }
+    digests_.reserve(static_cast<size_t>(digests_size_));
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        auto& entry = entries_[i];
+        if (!entry.digest_after) {
+            continue;
+        }
+        // Skipped by a seek: read it again just for the hash
+        if (!entry.has_hash() && !ArchiveFormat::hash_file(files_[i], entry.content_hash)) {
+            error_ = "File changed or became unreadable while archiving: " + files_[i].string();
+            throw std::runtime_error(error_);
+        }
+        digests_.insert(digests_.end(), entry.content_hash.begin(), entry.content_hash.end());
+    }
+}
+
+ArchiveSource::pos_type ArchiveSource::seekoff(
+    off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which
+) {
+    off_type current = static_cast<off_type>(position_) - (egptr() - gptr());
+    if (dir == std::ios_base::cur && off == 0) {
+        return pos_type(current);  // tellg(): keep the buffer
+    }
+    off_type base = dir == std::ios_base::beg ? 0
+                  : dir == std::ios_base::cur ? current
+                  : static_cast<off_type>(size());
+    return seekpos(pos_type(base + off), which);
+}
+
+ArchiveSource::pos_type ArchiveSource::seekpos(pos_type pos, std::ios_base::openmode which) {
+    off_type target = off_type(pos);
+    if (!(which & std::ios_base::in) || target < 0 || static_cast<uint64_t>(target) > size()) {
+        return pos_type(off_type(-1));
+    }
+    position_ = static_cast<uint64_t>(target);
+    setg(nullptr, nullptr, nullptr);
+    return pos;
+}
+
+// Streaming archive extraction
+ArchiveSink::ArchiveSink(fs::path output_dir, ExtractOptions options)
+    : output_dir_(std::move(output_dir)), options_(options) {
+    if (options_.threads != 1) {
+        pool_ = std::make_unique<core::ThreadPool>(options_.threads);
+    }
+}
+
+ArchiveSink::~ArchiveSink() {
+    // Queued writes own their data; just let them finish before the pool goes
+    for (auto& write : pending_) {
+        write.error.wait();
+    }
+}
+
+bool ArchiveSink::parse_table() {
+    std::string error;
+    if (table_offset_ == 0) {
+        if (!ArchiveFormat::parse_header(table_, segment_, error)) {
+            return error.empty() ? false : fail(error);
+        }
+        if (segments_ > 0 && segment_.is_delta()) {
+            return fail("Appended segment refers to a base archive");
+        }
+        table_offset_ = segment_.size;
+        segment_entries_.clear();
+    }
+    
+    if (!ArchiveFormat::parse_entries(table_, table_offset_, segment_, segment_entries_, error)) {
+        return error.empty() ? false : fail(error);
+    }
+    
+    table_done_ = true;
+    if (segments_++ == 0) {
+        header_ = segment_;
+    }
+    auto dir_error = options_.check_only ? std::string() : create_parent_directories(output_dir_, segment_entries_);
+    segment_start_ = entries_.size();
+    digests_.clear();
+    digests_left_ = ArchiveFormat::digest_block_size(segment_entries_);
+    stored_at_.clear();
+    for (size_t i = 0; i < segment_entries_.size(); ++i) {
+        if (segment_entries_[i].stored_size() > 0) {
+            stored_at_[segment_entries_[i].offset] = entries_.size() + i;
+        }
+    }
+    entries_.insert(entries_.end(), std::make_move_iterator(segment_entries_.begin()),
+                    std::make_move_iterator(segment_entries_.end()));
+    segment_entries_.clear();
+    return dir_error.empty() ? true : fail(dir_error);
+}
+
+bool ArchiveSink::open_member() {
+    const auto& entry = entries_[member_];
+    
+    // A later member may overwrite an earlier one still queued
+    if (submitted_.count(entry.filename) && !wait_all()) {
+        return false;
+    }
+    
+    member_open_ = true;
+    member_written_ = 0;
+    written_[entry.filename] = member_;
+    if (options_.verify) {
+        if (!hasher_) {
+            hasher_ = Botan::HashFunction::create_or_throw(ArchiveFormat::CONTENT_HASH);
+        }
+        hasher_->clear();
+    }
+    if (options_.check_only) {
+        member_buffered_ = false;
+        return true;
+    }
+    member_buffered_ = pool_ && entry.file_size <= MAX_POOLED_MEMBER;
+    if (member_buffered_) {
+        buffer_.clear();
+        buffer_.reserve(static_cast<size_t>(entry.file_size));
+        return true;
+    }
+    
+    auto path = output_dir_ / entry.filename;
+    file_ = std::make_unique<MemberFile>();
+    if (!file_->open(path, entry.file_size, options_.preallocate)) {
+        return fail("Cannot create " + path.string());
+    }
+    return true;
+}
+
+bool ArchiveSink::close_member() {
+    member_open_ = false;
+    if (options_.verify) {
+        const auto& entry = entries_[member_];
+        ContentHash hash;
+        hasher_->final(hash.data());
+        if (entry.digest_after) {
+            computed_[member_] = hash;
+        } else if (entry.has_hash()) {
+            if (hash != entry.content_hash) {
+                return fail("Member does not match its content hash: " + entry.filename);
+            }
+            verified_++;
+        }
+    }
+    if (options_.check_only) {
+        // Nothing written
+    } else if (member_buffered_) {
+        if (!submit_member()) {
+            return false;
+        }
+    } else {
+        bool ok = file_->close();
+        file_.reset();
+        if (!ok) {
+            return fail("Failed to write " + entries_[member_].filename);
+        }
+    }
+    member_++;
+    return true;
+}
+
+bool ArchiveSink::copy_shared() {
+    const auto& entry = entries_[member_];
+    auto stored = stored_at_.find(entry.offset);
+    if (stored == stored_at_.end() || entries_[stored->second].file_size != entry.file_size) {
+        return fail("Shared member does not match a stored one: " + entry.filename);
+    }
+    const auto& source = entries_[stored->second];
+    auto written = written_.find(source.filename);
+    if (written == written_.end() || written->second != stored->second) {
+        return fail("Shared member's copy was overwritten before it: " + entry.filename);
+    }
+    
+    // The copy may still be queued, and so may an earlier file of this name
+    if ((submitted_.count(source.filename) || submitted_.count(entry.filename)) && !wait_all()) {
+        return false;
+    }
+    written_[entry.filename] = member_;
+    if (entry.filename == source.filename || options_.check_only) {
+        return true;
+    }
+    std::error_code ec;
+    fs::copy_file(output_dir_ / source.filename, output_dir_ / entry.filename,
+                  fs::copy_options::overwrite_existing, ec);
+    return ec ? fail("Cannot create " + (output_dir_ / entry.filename).string() + ": " + ec.message()) : true;
+}
+
+bool ArchiveSink::check_digests() {
+    auto segment = std::span<FileEntry>(entries_).subspan(segment_start_);
+    ArchiveFormat::apply_digests(digests_, segment);
+    for (size_t i = segment_start_; i < entries_.size(); ++i) {
+        auto computed = computed_.find(i);
+        if (computed == computed_.end()) {
+            continue;
+        }
+        if (computed->second != entries_[i].content_hash) {
+            return fail("Member does not match its content hash: " + entries_[i].filename);
+        }
+        verified_++;
+    }
+    computed_.clear();
+    digests_ = {};
+    return true;
+}
+
+bool ArchiveSink::submit_member() {
+    // Bound what is held in memory for the workers
+    while (!pending_.empty() &&
+           (pending_.size() >= MAX_PENDING_FILES || pending_bytes_ + buffer_.size() > MAX_PENDING_BYTES)) {
+        if (!wait_oldest()) {
+            return false;
+        }
+    }
+    
+    const auto& entry = entries_[member_];
+    size_t bytes = buffer_.size();
+    bool preallocate = options_.preallocate;
+    auto write = pool_->submit([path = output_dir_ / entry.filename, data = std::move(buffer_), preallocate]() {
+        return write_member(path, data.data(), data.size(), preallocate);
+    });
+    buffer_ = {};
+    pending_.push_back({std::move(write), bytes});
+    pending_bytes_ += bytes;
+    submitted_.insert(entry.filename);
+    return true;
+}
+
+bool ArchiveSink::wait_oldest() {
+    auto write = std::move(pending_.front());
+    pending_.pop_front();
+    pending_bytes_ -= write.bytes;
+    auto error = write.error.get();
+    return error.empty() ? true : fail(error);
+}
+
+bool ArchiveSink::wait_all() {
+    bool ok = true;
+    while (!pending_.empty()) {
+        ok = wait_oldest() && ok;
+    }
+    submitted_.clear();
+    return ok;
+}
+
+bool ArchiveSink::fail(std::string message) {
+    if (error_.empty()) {
+        error_ = std::move(message);
+    }
+    return false;
+}
+
+ArchiveSink::int_type ArchiveSink::overflow(int_type ch) {
+    if (traits_type::eq_int_type(ch, traits_type::eof())) {
+        return traits_type::not_eof(ch);
+    }
+    char c = traits_type::to_char_type(ch);
+    return xsputn(&c, 1) == 1 ? ch : traits_type::eof();
+}
+
+std::streamsize ArchiveSink::xsputn(const char* data, std::streamsize count) {
+    if (!error_.empty()) {
+        return 0;
+    }
+    
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    size_t remaining = static_cast<size_t>(count);
+    
+    while (remaining > 0) {
+        if (!table_done_) {
+            table_.insert(table_.end(), bytes, bytes + remaining);
+            if (!parse_table()) {
+                return error_.empty() ? count : 0;  // Wait for more of the table
+            }
+            // Whatever arrived past the table is member data
+            size_t extra = table_.size() - table_offset_;
+            bytes += remaining - extra;
+            remaining = extra;
+            table_ = {};
+            continue;
+        }
+        
+        // Empty and shared members take no bytes; create them on the way past
+        while (!member_open_ && member_ < entries_.size()) {
+            if (entries_[member_].in_base) {
+                member_++;
+                continue;
+            }
+            if (entries_[member_].shared) {
+                if (!copy_shared()) {
+                    return 0;
+                }
+                member_++;
+                continue;
+            }
+            if (!open_member() || (entries_[member_].file_size == 0 && !close_member())) {
+                return 0;
+            }
+        }
+        
+        // Past the last member: the segment's digests, if any
+        if (!member_open_ && digests_left_ > 0) {
+            size_t n = static_cast<size_t>(std::min<uint64_t>(remaining, digests_left_));
+            digests_.insert(digests_.end(), bytes, bytes + n);
+            digests_left_ -= n;
+            bytes += n;
+            remaining -= n;
+            if (digests_left_ == 0 && !check_digests()) {
+                return 0;
+            }
+            continue;
+        }
+        
+        // Then a padded segment may be followed by another
+        if (!member_open_) {
+            if (segment_.version < ArchiveFormat::APPENDABLE_VERSION) {
+                fail("Data past the end of the archive");
+                return 0;
+            }
+            auto* next = std::find_if(bytes, bytes + remaining, [](uint8_t byte) { return byte != 0; });
+            remaining -= static_cast<size_t>(next - bytes);
+            bytes = next;
+            if (remaining > 0) {
+                table_done_ = false;
+                table_offset_ = 0;
+            }
+            continue;
+        }
+        
+        size_t n = static_cast<size_t>(std::min<uint64_t>(
+            remaining, entries_[member_].file_size - member_written_));
+        if (options_.verify) {
+            hasher_->update(bytes, n);
+        }
+        if (options_.check_only) {
+            // Hashed only
+        } else if (member_buffered_) {
+            buffer_.insert(buffer_.end(), bytes, bytes + n);
+        } else if (!file_->write(bytes, n)) {
+            fail("Failed to write " + entries_[member_].filename);
+            return 0;
+        }
+        member_written_ += n;
+        bytes += n;
+        remaining -= n;
+        
+        if (member_written_ == entries_[member_].file_size && !close_member()) {
+            return 0;
+        }
+    }
+    
+    return count;
+}
+
+bool ArchiveSink::finish() {
+    if (!error_.empty()) {
+        return false;
+    }
+    if (!table_done_ || member_open_) {
+        return fail("Truncated archive");
+    }
+    
+    // Empty and shared members after the last data have not been created yet
+    while (member_ < entries_.size()) {
+        if (entries_[member_].in_base) {
+            member_++;
+            continue;
+        }
+        if (entries_[member_].shared) {
+            if (!copy_shared()) {
+                return false;
+            }
+            member_++;
+            continue;
+        }
+        if (entries_[member_].file_size > 0) {
+            return fail("Truncated archive");
+        }
+        if (!open_member() || !close_member()) {
+            return false;
+        }
+    }
+    if (digests_left_ > 0) {
+        return fail("Truncated archive");
+    }
+    
+    if (!wait_all()) {
+        return false;
+    }
+    if (options_.check_only) {
+        return true;
+    }
+    
+    // Metadata last, in one pass over the finished files
+    for (const auto& entry : entries_) {
+        if (entry.in_base) {
+            continue;
+        }
+        try {
+            ArchiveFormat::restore_metadata(output_dir_ / entry.filename, entry);
+        } catch (const std::exception&) {
+            // Contents are intact; timestamps are best effort
+        }
+    }
+    return true;
+}
+
+// Random-access reading
+core::StreamingResult ArchiveReader::open(const std::string& archive_path, const std::string& password) {
+    entries_.clear();
+    index_.clear();
+    digest_blocks_.clear();
+    header_ = {};
+    segments_ = 0;
+    appendable_ = false;
+    auto result = stream_.open(archive_path, password);
+    if (!result.success) {
+        return result;
+    }
+    
+    std::vector<uint8_t> tables;     // Every segment's table, for the index ID
+    std::vector<uint8_t> block;
+    size_t chunk_size = stream_.chunk_size();
+    uint64_t start = 0;              // Plaintext offset of the segment
+    while (true) {
+        // Fetch the table a block at a time until every entry has arrived,
+        // never reading past the chunk holding its end
+        std::vector<uint8_t> table;
+        ArchiveHeader segment;
+        std::vector<FileEntry> entries;
+        size_t offset = 0;
+        while (true) {
+            uint64_t pos = start + table.size();
+            size_t to_chunk_end = static_cast<size_t>(chunk_size - pos % chunk_size);
+            result = stream_.read(pos, (std::min)(INDEX_READ_SIZE, to_chunk_end), block);
+            if (!result.success) {
+                return result;
+            }
+            table.insert(table.end(), block.begin(), block.end());
+            
+            std::string error;
+            if (offset == 0 && ArchiveFormat::parse_header(table, segment, error)) {
+                offset = segment.size;
+            }
+            if (offset != 0 && ArchiveFormat::parse_entries(table, offset, segment, entries, error)) {
+                break;
+            }
+            if (!error.empty() || block.empty()) {
+                result.success = false;
+                result.error_message = error.empty() ? "Truncated archive index" : error;
+                return result;
+            }
+        }
+        
+        if (segments_ == 0) {
+            header_ = segment;
+            data_start_ = offset;
+        } else if (segment.is_delta()) {
+            result.success = false;
+            result.error_message = "Appended segment refers to a base archive";
+            return result;
+        }
+        
+        uint64_t data = start + offset;
+        uint64_t end = data + data_end(entries);
+        
+        // Hashes computed while the segment was written follow its data;
+        // they are read only when asked for (load_digests)
+        uint64_t digest_bytes = ArchiveFormat::digest_block_size(entries);
+        if (digest_bytes > 0) {
+            digest_blocks_.push_back({end, digest_bytes, entries_.size(), entries_.size() + entries.size()});
+            end += digest_bytes;
+        }
+        for (auto& entry : entries) {
+            entry.offset += data - data_start_;
+            entries_.push_back(std::move(entry));
+        }
+        tables.insert(tables.end(), table.begin(), table.begin() + static_cast<std::ptrdiff_t>(offset));
+        segments_++;
+        
+        // A padded segment ends on a chunk boundary, where the next may start
+        appendable_ = segment.version >= ArchiveFormat::APPENDABLE_VERSION;
+        uint64_t next = (end + chunk_size - 1) / chunk_size * chunk_size;
+        if (!appendable_ || next >= stream_.size()) {
+            break;
+        }
+        start = next;
+    }
+    
+    index_id_ = ArchiveFormat::hash_bytes(tables);
+    index_.reserve(entries_.size());
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        index_[entries_[i].filename] = i;
+    }
+    result.chunks_processed = stream_.chunks_decrypted();
+    return result;
+}
+
+core::StreamingResult ArchiveReader::load_digests() {
+    core::StreamingResult result;
+    result.success = true;
+    std::vector<uint8_t> block;
+    for (const auto& digests : digest_blocks_) {
+        result = stream_.read(digests.offset, static_cast<size_t>(digests.size), block);
+        if (!result.success || block.size() != digests.size) {
+            result.success = false;
+            if (result.error_message.empty()) {
+                result.error_message = "Truncated archive";
+            }
+            return result;
+        }
+        ArchiveFormat::apply_digests(block, std::span<FileEntry>(entries_).subspan(
+            digests.first, digests.end - digests.first));
+    }
+    digest_blocks_.clear();
+    return result;
+}
+
+const FileEntry* ArchiveReader::find(const std::string& filename) const {
+    auto it = index_.find(filename);
+    return it == index_.end() ? nullptr : &entries_[it->second];
+}
+
+std::pair<size_t, size_t> ArchiveReader::chunk_range(const FileEntry& entry) const {
+    size_t chunk_size = stream_.chunk_size();
+    uint64_t start = data_start_ + entry.offset;
+    if (entry.in_base || entry.file_size == 0 || chunk_size == 0) {
+        return {1, 0};
+    }
+    return {static_cast<size_t>(start / chunk_size),
+            static_cast<size_t>((start + entry.file_size - 1) / chunk_size)};
+}
+
+bool ArchiveReader::extract(const FileEntry& entry, const fs::path& output_dir, std::string& error,
+                            bool verify) {
+    if (entry.in_base) {
+        error = "Stored in the base archive";
+        return false;
+    }
+    
+    fs::path output_path = output_dir / entry.filename;
+    std::error_code ec;
+    fs::create_directories(output_path.parent_path(), ec);
+    std::ofstream out_file(output_path, std::ios::binary | std::ios::trunc);
+    if (!out_file) {
+        error = "Cannot create " + output_path.string();
+        return false;
+    }
+    
+    // One chunk per read keeps memory at a chunk and decrypts each only once
+    size_t chunk_size = stream_.chunk_size();
+    uint64_t pos = data_start_ + entry.offset;
+    uint64_t end = pos + entry.file_size;
+    std::vector<uint8_t> piece;
+    if (verify && entry.digest_after && !entry.has_hash()) {
+        auto loaded = load_digests();
+        if (!loaded.success) {
+            error = loaded.error_message;
+            return false;
+        }
+    }
+    auto hasher = verify && entry.has_hash() ? Botan::HashFunction::create_or_throw(ArchiveFormat::CONTENT_HASH)
+                                             : nullptr;
+    while (pos < end) {
+        uint64_t piece_end = (std::min)(end, (pos / chunk_size + 1) * chunk_size);
+        auto result = stream_.read(pos, static_cast<size_t>(piece_end - pos), piece);
+        if (!result.success || piece.size() != piece_end - pos) {
+            error = result.success ? "Truncated archive" : result.error_message;
+            return false;
+        }
+        out_file.write(reinterpret_cast<const char*>(piece.data()), static_cast<std::streamsize>(piece.size()));
+        if (hasher) {
+            hasher->update(piece.data(), piece.size());
+        }
+        pos = piece_end;
+    }
+    if (hasher) {
+        ContentHash hash;
+        hasher->final(hash.data());
+        if (hash != entry.content_hash) {
+            error = "Does not match its content hash";
+            return false;
+        }
+    }
+    
+    out_file.close();
+    if (!out_file) {
+        error = "Failed to write " + output_path.string();
+        return false;
+    }
+    
+    try {
+        ArchiveFormat::restore_metadata(output_path, entry);
+    } catch (const std::exception&) {
+        // Contents are intact; timestamps are best effort
+    }
+    return true;
+}
+
 } // namespace filevault::archive
@@ -0,0 +1,262 @@
+/**
+ * @file archive_mount.cpp
+ * @brief Read-only FUSE 3 view of encrypted archives and streams
+ */
+
+#include "filevault/archive/archive_mount.hpp"
+
+#ifdef FILEVAULT_HAVE_FUSE
+#define FUSE_USE_VERSION 31
+#include <fuse.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+#include <algorithm>
+
+namespace filevault::archive {
+
+MountTree::MountTree() {
+    nodes_.emplace_back();
+    nodes_.front().permissions = 0555;
+}
+
+size_t MountTree::child(size_t parent, const std::string& name, bool directory) {
+    auto found = nodes_[parent].children.find(name);
+    if (found != nodes_[parent].children.end()) {
+        return found->second;
+    }
+    Node node;
+    node.name = name;
+    node.directory = directory;
+    node.permissions = directory ? 0555 : 0444;
+    nodes_.push_back(std::move(node));
+    nodes_[parent].children[name] = nodes_.size() - 1;
+    return nodes_.size() - 1;
+}
+
+MountTree MountTree::from_archive(const std::vector<FileEntry>& entries, uint64_t data_start) {
+    MountTree tree;
+    for (const auto& entry : entries) {
+        if (entry.in_base) {
+            ++tree.skipped_;
+            continue;
+        }
+
+        size_t parent = 0;
+        size_t start = 0;
+        bool valid = true;
+        while (true) {
+            size_t slash = entry.filename.find('/', start);
+            std::string part = entry.filename.substr(start, slash == std::string::npos ? slash : slash - start);
+            if (part.empty() || part == "." || part == "..") {
+                valid = false;
+                break;
+            }
+            if (slash == std::string::npos) {
+                size_t index = tree.child(parent, part, false);
+                Node& file = tree.nodes_[index];
+                if (file.directory) {
+                    valid = false;          // A directory of that name exists
+                    break;
+                }
+                file.data_offset = data_start + entry.offset;
+                file.size = entry.file_size;
+                file.modified_time = entry.modified_time;
+                // Read-only view: keep the read bits of the stored mode
+                file.permissions = entry.permissions != 0 ? (entry.permissions & 0444) : 0444;
+                break;
+            }
+            parent = tree.child(parent, part, true);
+            if (!tree.nodes_[parent].directory) {
+                valid = false;
+                break;
+            }
+            start = slash + 1;
+        }
+        if (!valid) {
+            ++tree.skipped_;
+        }
+    }
+    tree.files_ = static_cast<size_t>(std::count_if(tree.nodes_.begin(), tree.nodes_.end(),
+                                                    [](const Node& node) { return !node.directory; }));
+    return tree;
+}
+
+MountTree MountTree::single_file(const std::string& name, uint64_t size, uint64_t modified_time) {
+    MountTree tree;
+    Node& file = tree.nodes_[tree.child(0, name, false)];
+    file.size = size;
+    file.modified_time = modified_time;
+    tree.files_ = 1;
+    return tree;
+}
+
+const MountTree::Node* MountTree::lookup(const std::string& path) const {
+    if (path.empty() || path[0] != '/') {
+        return nullptr;
+    }
+    size_t index = 0;
+    size_t start = 1;
+    while (start < path.size()) {
+        size_t slash = path.find('/', start);
+        std::string part = path.substr(start, slash == std::string::npos ? slash : slash - start);
+        auto found = nodes_[index].children.find(part);
+        if (found == nodes_[index].children.end()) {
+            return nullptr;
+        }
+        index = found->second;
+        if (slash == std::string::npos) {
+            break;
+        }
+        start = slash + 1;
+    }
+    return &nodes_[index];
+}
+
+#ifdef FILEVAULT_HAVE_FUSE
+
+namespace {
+
+struct MountContext {
+    const MountTree* tree;
+    core::CachedStreamReader* cache;
+};
+
+MountContext& context() {
+    return *static_cast<MountContext*>(fuse_get_context()->private_data);
+}
+
+void* on_init(fuse_conn_info*, fuse_config* config) {
+    // Nothing changes under the mount, so the kernel may cache freely
+    config->kernel_cache = 1;
+    config->entry_timeout = config->attr_timeout = 3600;
+    return fuse_get_context()->private_data;
+}
+
+int on_getattr(const char* path, struct stat* st, fuse_file_info*) {
+    const auto* node = context().tree->lookup(path);
+    if (!node) {
+        return -ENOENT;
+    }
+    std::memset(st, 0, sizeof(*st));
+    if (node->directory) {
+        st->st_mode = S_IFDIR | node->permissions;
+        st->st_nlink = 2;
+    } else {
+        st->st_mode = S_IFREG | node->permissions;
+        st->st_nlink = 1;
+        st->st_size = static_cast<off_t>(node->size);
+        st->st_blksize = static_cast<blksize_t>(context().cache->chunk_size());
+    }
+    st->st_uid = getuid();
+    st->st_gid = getgid();
+    st->st_mtime = st->st_ctime = st->st_atime = static_cast<time_t>(node->modified_time);
+    return 0;
+}
+
+int on_readdir(const char* path, void* buf, fuse_fill_dir_t fill, off_t, fuse_file_info*, fuse_readdir_flags) {
+    const auto* node = context().tree->lookup(path);
+    if (!node) {
+        return -ENOENT;
+    }
+    if (!node->directory) {
+        return -ENOTDIR;
+    }
+    auto flags = static_cast<fuse_fill_dir_flags>(0);
+    fill(buf, ".", nullptr, 0, flags);
+    fill(buf, "..", nullptr, 0, flags);
+    for (const auto& [name, index] : node->children) {
+        fill(buf, name.c_str(), nullptr, 0, flags);
+    }
+    return 0;
+}
+
+int on_open(const char* path, fuse_file_info* fi) {
+    const auto* node = context().tree->lookup(path);
+    if (!node) {
+        return -ENOENT;
+    }
+    if (node->directory) {
+        return -EISDIR;
+    }
+    if ((fi->flags & O_ACCMODE) != O_RDONLY) {
+        return -EROFS;
+    }
+    fi->keep_cache = 1;
+    return 0;
+}
+
+int on_read(const char* path, char* buf, size_t size, off_t offset, fuse_file_info*) {
+    const auto* node = context().tree->lookup(path);
+    if (!node || node->directory) {
+        return -ENOENT;
+    }
+    if (offset < 0 || static_cast<uint64_t>(offset) >= node->size) {
+        return 0;
+    }
+    size = static_cast<size_t>(std::min<uint64_t>(size, node->size - offset));
+    std::vector<uint8_t> data;
+    auto error = context().cache->read(node->data_offset + static_cast<uint64_t>(offset), size, data);
+    if (!error.empty() || data.size() != size) {
+        return -EIO;
+    }
+    std::memcpy(buf, data.data(), size);
+    return static_cast<int>(size);
+}
+
+} // anonymous namespace
+
+bool fuse_available() {
+    return true;
+}
+
+core::Result<void> mount_read_only(const MountTree& tree, core::StreamReader& reader,
+                                   const std::string& mountpoint, const MountOptions& options,
+                                   core::StreamCacheStats* stats) {
+    core::CachedStreamReader cache(reader, options.cache_chunks, options.readahead_chunks);
+    MountContext mount_context{&tree, &cache};
+
+    fuse_operations ops{};
+    ops.init = on_init;
+    ops.getattr = on_getattr;
+    ops.readdir = on_readdir;
+    ops.open = on_open;
+    ops.read = on_read;
+
+    // Multi-threaded: CachedStreamReader serves cached chunks concurrently
+    std::vector<std::string> args = {"filevault", "-f", "-o", "ro,fsname=filevault,subtype=filevault"};
+    if (options.allow_other) {
+        args.insert(args.end(), {"-o", "allow_other"});
+    }
+    args.push_back(mountpoint);
+    std::vector<char*> argv;
+    for (auto& arg : args) {
+        argv.push_back(arg.data());
+    }
+
+    int status = fuse_main(static_cast<int>(argv.size()), argv.data(), &ops, &mount_context);
+    if (stats) {
+        *stats = cache.stats();
+    }
+    if (status != 0) {
+        return core::Result<void>::error("FUSE mount of " + mountpoint + " failed");
+    }
+    return core::Result<void>::ok();
+}
+
+#else
+
+bool fuse_available() {
+    return false;
+}
+
+core::Result<void> mount_read_only(const MountTree&, core::StreamReader&, const std::string&,
+                                   const MountOptions&, core::StreamCacheStats*) {
+    return core::Result<void>::error("This build has no FUSE support (configure with -DENABLE_FUSE=ON)");
+}
+
+#endif // FILEVAULT_HAVE_FUSE
+
+} // namespace filevault::archive
@@ -0,0 +1,294 @@
+#include "filevault/archive/directory_walker.hpp"
+#include "filevault/core/thread_pool.hpp"
+#include <algorithm>
+#include <future>
+#include <iterator>
+#include <system_error>
+
+namespace filevault::archive {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct PendingDirectory {
+    fs::path path;
+    std::string name;    // Member name prefix ("" for the contents of "." etc.)
+};
+
+struct Listing {
+    std::vector<ArchiveMember> members;
+    std::vector<PendingDirectory> directories;
+    std::vector<std::string> errors;
+};
+
+std::string join(const std::string& prefix, const std::string& name) {
+    return prefix.empty() ? name : prefix + "/" + name;
+}
+
+bool wanted_file(const std::string& name, const WalkOptions& options) {
+    return (options.include.empty() || DirectoryWalker::matches_any(options.include, name)) &&
+           !DirectoryWalker::matches_any(options.exclude, name);
+}
+
+/**
+ * @brief One directory's files (stat'ed) and subdirectories (not yet listed)
+ */
+Listing list_directory(const PendingDirectory& directory, const WalkOptions& options) {
+    Listing listing;
+    std::error_code ec;
+    fs::directory_iterator it(directory.path, fs::directory_options::skip_permission_denied, ec);
+
+    for (fs::directory_iterator end; !ec && it != end; it.increment(ec)) {
+        auto name = join(directory.name, it->path().filename().string());
+
+        // The type usually comes from the directory listing itself, so only
+        // files cost a stat (in stat_entry)
+        std::error_code type_ec;
+        auto type = it->symlink_status(type_ec).type();
+        if (type_ec) {
+            listing.errors.push_back(it->path().string() + ": " + type_ec.message());
+            continue;
+        }
+
+        if (type == fs::file_type::directory) {
+            if (!DirectoryWalker::matches_any(options.exclude, name)) {
+                listing.directories.push_back({it->path(), std::move(name)});
+            }
+        } else if (type == fs::file_type::regular || type == fs::file_type::symlink) {
+            if (!wanted_file(name, options)) {
+                continue;
+            }
+            ArchiveMember member{it->path(), {}};
+            if (ArchiveFormat::stat_entry(member.source, member.entry)) {
+                member.entry.filename = std::move(name);
+                listing.members.push_back(std::move(member));
+            } else if (type == fs::file_type::regular) {
+                listing.errors.push_back(it->path().string() + ": cannot stat");
+            }
+            // Dangling symlinks and symlinks to directories are skipped
+        }
+    }
+
+    if (ec) {
+        listing.errors.push_back(directory.path.string() + ": " + ec.message());
+    }
+    return listing;
+}
+
+bool match_class(std::string_view pattern, size_t& p, char c, bool& matched) {
+    size_t i = p + 1;
+    bool negate = i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^');
+    if (negate) {
+        ++i;
+    }
+    // A ']' right after the opening is a literal member
+    size_t close = pattern.find(']', i + 1);
+    if (close == std::string_view::npos) {
+        return false;
+    }
+
+    bool in_class = false;
+    for (size_t j = i; j < close; ++j) {
+        if (j + 2 < close && pattern[j + 1] == '-') {
+            in_class = in_class || (c >= pattern[j] && c <= pattern[j + 2]);
+            j += 2;
+        } else {
+            in_class = in_class || c == pattern[j];
+        }
+    }
+    matched = in_class != negate;
+    p = close + 1;
+    return true;
+}
+
+} // anonymous namespace
+
+bool DirectoryWalker::glob_match(std::string_view pattern, std::string_view name) {
+    size_t p = 0;
+    size_t n = 0;
+    while (p < pattern.size()) {
+        char c = pattern[p];
+
+        if (c == '*') {
+            if (p + 1 < pattern.size() && pattern[p + 1] == '*') {
+                auto rest = pattern.substr(p + 2);
+                // "**/" also matches no directories at all
+                if (!rest.empty() && rest.front() == '/' && glob_match(rest.substr(1), name.substr(n))) {
+                    return true;
+                }
+                for (size_t i = n; i <= name.size(); ++i) {
+                    if (glob_match(rest, name.substr(i))) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+            auto rest = pattern.substr(p + 1);
+            for (size_t i = n; i <= name.size(); ++i) {
+                if (glob_match(rest, name.substr(i))) {
+                    return true;
+                }
+                if (i < name.size() && name[i] == '/') {
+                    break;
+                }
+            }
+            return false;
+        }
+
+        if (n >= name.size()) {
+            return false;
+        }
+        if (c == '?') {
+            if (name[n] == '/') {
+                return false;
+            }
+            ++p;
+        } else if (c == '[') {
+            bool matched = false;
+            if (match_class(pattern, p, name[n], matched)) {
+                if (!matched || name[n] == '/') {
+                    return false;
+                }
+            } else if (name[n] != '[') {
+                return false;
+            } else {
+                ++p;    // Unterminated class: a literal '['
+            }
+        } else {
+            if (c != name[n]) {
+                return false;
+            }
+            ++p;
+        }
+        ++n;
+    }
+    return n == name.size();
+}
+
+bool DirectoryWalker::matches_any(const std::vector<std::string>& globs, std::string_view name) {
+    auto slash = name.rfind('/');
+    auto base = slash == std::string_view::npos ? name : name.substr(slash + 1);
+    return std::any_of(globs.begin(), globs.end(), [&](const std::string& glob) {
+        return glob_match(glob, glob.find('/') == std::string::npos ? base : name);
+    });
+}
+
+WalkResult DirectoryWalker::walk(const std::vector<fs::path>& inputs, const WalkOptions& options) {
+    WalkResult result;
+    std::vector<PendingDirectory> level;
+
+    for (const auto& input : inputs) {
+        std::error_code ec;
+        auto status = fs::status(input, ec);
+        if (ec || !fs::exists(status)) {
+            result.errors.push_back(input.string() + ": not found");
+            continue;
+        }
+
+        if (fs::is_directory(status)) {
+            // "dir" and "dir/" both give "dir/..." names
+            auto base = input.lexically_normal();
+            if (!base.has_filename()) {
+                base = base.parent_path();
+            }
+            auto prefix = base.filename().string();
+            if (prefix == "." || prefix == "..") {
+                prefix.clear();
+            }
+            if (prefix.empty() || !matches_any(options.exclude, prefix)) {
+                level.push_back({input, prefix});
+            }
+            continue;
+        }
+
+        auto name = input.filename().string();
+        if (!wanted_file(name, options)) {
+            continue;
+        }
+        ArchiveMember member{input, {}};
+        if (ArchiveFormat::stat_entry(input, member.entry)) {
+            member.entry.filename = std::move(name);
+            result.members.push_back(std::move(member));
+        } else {
+            result.errors.push_back(input.string() + ": not a regular file");
+        }
+    }
+
+    // Breadth first: every directory of a level is listed concurrently
+    if (!level.empty()) {
+        core::ThreadPool pool(options.threads);
+        while (!level.empty()) {
+            std::vector<std::future<Listing>> listings;
+            listings.reserve(level.size());
+            for (auto& directory : level) {
+                listings.push_back(pool.submit([&options, directory = std::move(directory)]() {
+                    return list_directory(directory, options);
+                }));
+            }
+            level.clear();
+
+            for (auto& future : listings) {
+                auto listing = future.get();
+                std::move(listing.members.begin(), listing.members.end(), std::back_inserter(result.members));
+                std::move(listing.errors.begin(), listing.errors.end(), std::back_inserter(result.errors));
+                std::move(listing.directories.begin(), listing.directories.end(), std::back_inserter(level));
+            }
+        }
+    }
+
+    // Name order keeps archives reproducible and related files adjacent
+    std::stable_sort(result.members.begin(), result.members.end(),
+                     [](const ArchiveMember& a, const ArchiveMember& b) {
+                         return a.entry.filename < b.entry.filename;
+                     });
+    return result;
+}
+
+InputExpansion DirectoryWalker::expand_inputs(const std::vector<std::string>& inputs,
+                                              const WalkOptions& options) {
+    InputExpansion result;
+    for (const auto& input : inputs) {
+        std::error_code ec;
+        if (fs::is_regular_file(input, ec)) {
+            result.files.push_back(input);
+            continue;
+        }
+
+        if (fs::is_directory(input, ec)) {
+            auto found = walk({input}, options);
+            result.errors.insert(result.errors.end(), found.errors.begin(), found.errors.end());
+            for (const auto& member : found.members) {
+                result.files.push_back(member.source.string());
+            }
+            continue;
+        }
+
+        // A glob the shell did not expand: walk from its last plain directory
+        auto pattern = fs::path(input).lexically_normal().generic_string();
+        auto magic = pattern.find_first_of("*?[");
+        if (magic == std::string::npos) {
+            result.missing.push_back(input + ": No such file or directory");
+            continue;
+        }
+        auto slash = pattern.rfind('/', magic);
+        fs::path root = slash == std::string::npos ? fs::path(".")
+                      : fs::path(slash == 0 ? "/" : pattern.substr(0, slash));
+
+        size_t matched = 0;
+        auto found = walk({root}, options);
+        for (const auto& member : found.members) {
+            auto path = member.source.lexically_normal().generic_string();
+            if (glob_match(pattern, path)) {
+                result.files.push_back(member.source.lexically_normal().string());
+                matched++;
+            }
+        }
+        if (matched == 0) {
+            result.missing.push_back(input + ": No files match");
+        }
+    }
+    return result;
+}
+
+} // namespace filevault::archive
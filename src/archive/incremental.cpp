@@ -0,0 +1,217 @@
+#include "filevault/archive/incremental.hpp"
+#include "filevault/core/thread_pool.hpp"
+#include "filevault/utils/checksum.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace filevault::archive {
+
+namespace {
+
+constexpr size_t HASH_BATCH = 64;   // Members hashed per pool task
+constexpr size_t READ_BUFFER_SIZE = 1024 * 1024;
+
+// Cache labels, as 'filevault hash -a blake2b-256 --cache --prefilter xxh3-128' stores them
+const char* const CONTENT_LABEL = "blake2b-256";
+const char* const PREFILTER_LABEL = "xxh3-128-prefilter";
+const char* const PREFILTER = "XXH3-128";
+
+/**
+ * @brief Feed a file to several digests in one read
+ */
+bool digest_file(const std::filesystem::path& path, std::initializer_list<Botan::HashFunction*> hashes) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::vector<char> buffer(READ_BUFFER_SIZE);
+    while (file) {
+        file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        for (auto* hash : hashes) {
+            hash->update(reinterpret_cast<const uint8_t*>(buffer.data()), static_cast<size_t>(file.gcount()));
+        }
+    }
+    return !file.bad();
+}
+
+/**
+ * @brief Content hash of one member, through the cache when there is one
+ */
+bool hash_member(ArchiveMember& member, utils::HashCache* cache) {
+    auto& hash = member.entry.content_hash;
+    auto identity = cache ? utils::HashCache::identify(member.source) : std::nullopt;
+    if (!identity) {
+        return ArchiveFormat::hash_file(member.source, hash);
+    }
+
+    auto cached = cache->lookup(*identity, CONTENT_LABEL);
+    if (cached && cached->size() == hash.size()) {
+        std::memcpy(hash.data(), cached->data(), hash.size());
+        return true;
+    }
+
+    // Touched but the same size: a matching checksum keeps the old hash
+    auto checksum = utils::create_hash_or_throw(PREFILTER);
+    auto old_sum = cache->stale(*identity, PREFILTER_LABEL);
+    auto old_hash = cache->stale(*identity, CONTENT_LABEL);
+    if (old_sum && old_hash && old_hash->size() == hash.size()) {
+        if (!digest_file(member.source, {checksum.get()})) {
+            return false;
+        }
+        auto sum = checksum->final();
+        if (std::string(sum.begin(), sum.end()) == *old_sum) {
+            std::memcpy(hash.data(), old_hash->data(), hash.size());
+            cache->store(*identity, CONTENT_LABEL, std::move(*old_hash));
+            cache->store(*identity, PREFILTER_LABEL, std::move(*old_sum));
+            return true;
+        }
+    }
+
+    auto content = utils::create_hash_or_throw(ArchiveFormat::CONTENT_HASH);
+    if (!digest_file(member.source, {content.get(), checksum.get()})) {
+        return false;
+    }
+    content->final(hash.data());
+    auto sum = checksum->final();
+    cache->store(*identity, CONTENT_LABEL, std::string(hash.begin(), hash.end()));
+    cache->store(*identity, PREFILTER_LABEL, std::string(sum.begin(), sum.end()));
+    return true;
+}
+
+/**
+ * @brief Hash the given members into their entries
+ */
+std::vector<std::string> hash_indices(std::vector<ArchiveMember>& members,
+                                      const std::vector<size_t>& indices, size_t threads,
+                                      utils::HashCache* cache) {
+    std::vector<std::string> errors;
+    if (indices.empty()) {
+        return errors;
+    }
+
+    core::ThreadPool pool(threads);
+    std::vector<std::future<std::vector<std::string>>> batches;
+    for (size_t start = 0; start < indices.size(); start += HASH_BATCH) {
+        size_t end = std::min(start + HASH_BATCH, indices.size());
+        batches.push_back(pool.submit([&members, &indices, start, end, cache]() {
+            std::vector<std::string> failed;
+            for (size_t i = start; i < end; ++i) {
+                auto& member = members[indices[i]];
+                if (!hash_member(member, cache)) {
+                    failed.push_back(member.source.string());
+                }
+            }
+            return failed;
+        }));
+    }
+    for (auto& batch : batches) {
+        auto failed = batch.get();
+        errors.insert(errors.end(), failed.begin(), failed.end());
+    }
+    return errors;
+}
+
+} // anonymous namespace
+
+std::vector<std::string> IncrementalPlanner::hash_members(std::vector<ArchiveMember>& members, size_t threads,
+                                                         utils::HashCache* cache) {
+    std::vector<size_t> all(members.size());
+    for (size_t i = 0; i < all.size(); ++i) {
+        all[i] = i;
+    }
+    return hash_indices(members, all, threads, cache);
+}
+
+std::vector<std::string> IncrementalPlanner::hash_candidates(std::vector<ArchiveMember>& members, size_t threads,
+                                                            utils::HashCache* cache) {
+    for (auto& member : members) {
+        auto& entry = member.entry;
+        auto identity = cache && !entry.in_base && !entry.has_hash() ? utils::HashCache::identify(member.source)
+                                                                      : std::nullopt;
+        auto cached = identity ? cache->lookup(*identity, CONTENT_LABEL) : std::nullopt;
+        if (cached && cached->size() == entry.content_hash.size()) {
+            std::memcpy(entry.content_hash.data(), cached->data(), entry.content_hash.size());
+        }
+    }
+    return hash_indices(members, ArchiveSource::duplicate_candidates(members), threads, cache);
+}
+
+void IncrementalPlanner::remember(const ArchiveSource& source, utils::HashCache& cache) {
+    const auto& entries = source.entries();
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (!entries[i].digest_after || !entries[i].has_hash()) {
+            continue;
+        }
+        if (auto identity = utils::HashCache::identify(source.sources()[i])) {
+            const auto& hash = entries[i].content_hash;
+            cache.store(*identity, CONTENT_LABEL, std::string(hash.begin(), hash.end()));
+        }
+    }
+}
+
+DeltaSummary IncrementalPlanner::plan(std::vector<ArchiveMember>& members, const std::vector<FileEntry>& base,
+                                      size_t threads, utils::HashCache* cache) {
+    DeltaSummary summary;
+
+    // Later entries win, as they do on extraction
+    std::unordered_map<std::string, const FileEntry*> by_name;
+    by_name.reserve(base.size());
+    for (const auto& entry : base) {
+        by_name[entry.filename] = &entry;
+    }
+
+    std::vector<size_t> to_hash;
+    std::vector<const FileEntry*> previous(members.size(), nullptr);
+    std::unordered_set<std::string> seen;
+    for (size_t i = 0; i < members.size(); ++i) {
+        auto& entry = members[i].entry;
+        seen.insert(entry.filename);
+        auto it = by_name.find(entry.filename);
+        if (it == by_name.end()) {
+            summary.added++;
+            continue;
+        }
+
+        const FileEntry& old = *it->second;
+        previous[i] = &old;
+        if (old.file_size == entry.file_size && old.modified_time == entry.modified_time) {
+            entry.in_base = true;
+            entry.content_hash = old.content_hash;
+        } else if (old.has_hash() && old.file_size == entry.file_size) {
+            to_hash.push_back(i);
+        } else {
+            summary.modified++;   // A new size cannot hash the same
+        }
+    }
+
+    summary.errors = hash_indices(members, to_hash, threads, cache);
+
+    // A touched file whose contents hash the same stays in the base
+    for (size_t i : to_hash) {
+        const FileEntry* old = previous[i];
+        auto& entry = members[i].entry;
+        if (old->content_hash == entry.content_hash) {
+            entry.in_base = true;
+        } else {
+            summary.modified++;
+        }
+    }
+
+    for (const auto& member : members) {
+        if (member.entry.in_base) {
+            summary.unchanged++;
+        } else {
+            summary.packed_bytes += member.entry.file_size;
+        }
+    }
+    for (const auto& [name, entry] : by_name) {
+        summary.removed += seen.count(name) ? 0 : 1;
+    }
+    return summary;
+}
+
+} // namespace filevault::archive
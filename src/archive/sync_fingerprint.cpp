@@ -0,0 +1,83 @@
+#include "filevault/archive/sync_fingerprint.hpp"
+#include "filevault/archive/archive_format.hpp"
+#include "filevault/core/crypto_engine.hpp"
+#include "filevault/core/streaming.hpp"
+#include <botan/mac.h>
+#include <algorithm>
+#include <string_view>
+
+namespace filevault::archive {
+
+namespace {
+
+const std::string_view KEY_LABEL = "filevault sync fingerprint";
+
+std::vector<uint8_t> meta_of(const core::TreeFile& file) {
+    std::vector<uint8_t> meta(SyncFingerprint::META_SIZE);
+    for (size_t i = 0; i < 8; i++) {
+        meta[i] = static_cast<uint8_t>(file.size >> (8 * i));
+        meta[8 + i] = static_cast<uint8_t>(file.modified_time >> (8 * i));
+    }
+    return meta;
+}
+
+std::optional<std::vector<uint8_t>> content_digest(const std::filesystem::path& path,
+                                                   std::span<const uint8_t> key) {
+    ContentHash hash{};
+    if (!ArchiveFormat::hash_file(path, hash)) {
+        return std::nullopt;
+    }
+    auto mac = Botan::MessageAuthenticationCode::create_or_throw("HMAC(SHA-256)");
+    mac->set_key(key.data(), key.size());
+    mac->update(hash.data(), hash.size());
+    auto digest = mac->final();
+    return std::vector<uint8_t>(digest.begin(), digest.begin() + SyncFingerprint::DIGEST_SIZE);
+}
+
+} // anonymous namespace
+
+std::vector<uint8_t> SyncFingerprint::derive_key(std::span<const uint8_t> password_key) {
+    auto mac = Botan::MessageAuthenticationCode::create_or_throw("HMAC(SHA-256)");
+    mac->set_key(password_key.data(), password_key.size());
+    mac->update(reinterpret_cast<const uint8_t*>(KEY_LABEL.data()), KEY_LABEL.size());
+    auto key = mac->final();
+    return std::vector<uint8_t>(key.begin(), key.end());
+}
+
+std::optional<std::vector<uint8_t>> SyncFingerprint::make(const core::TreeFile& file,
+                                                          std::span<const uint8_t> key) {
+    auto fingerprint = meta_of(file);
+    if (!key.empty()) {
+        auto digest = content_digest(file.source, key);
+        if (!digest) {
+            return std::nullopt;
+        }
+        fingerprint.insert(fingerprint.end(), digest->begin(), digest->end());
+    }
+    return fingerprint;
+}
+
+bool SyncFingerprint::is_current(const core::TreeFile& file, const std::vector<uint8_t>& salt,
+                                 std::span<const uint8_t> key) {
+    auto info = core::StreamingCrypto::read_info(file.target.string());
+    if (!info || info->fingerprint.size() < META_SIZE) {
+        return false;
+    }
+    auto meta = meta_of(file);
+    const auto& stored = info->fingerprint;
+    if (!std::equal(meta.begin(), meta.begin() + 8, stored.begin())) {
+        return false;
+    }
+    if (std::equal(meta.begin(), meta.end(), stored.begin())) {
+        return true;
+    }
+    auto file_batch = core::CryptoEngine::batch_salt_of(info->salt);
+    if (key.empty() || !std::equal(file_batch.begin(), file_batch.end(), salt.begin(), salt.end()) ||
+        stored.size() != META_SIZE + DIGEST_SIZE) {
+        return false;
+    }
+    auto digest = content_digest(file.source, key);
+    return digest && std::equal(digest->begin(), digest->end(), stored.begin() + META_SIZE);
+}
+
+} // namespace filevault::archive
@@ -0,0 +1,679 @@
+#include "filevault/archive/tar_stream.hpp"
+#include <botan/hash.h>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+
+namespace filevault::archive {
+
+namespace {
+
+constexpr size_t BLOCK = 512;
+constexpr uint64_t MAX_OCTAL_11 = 077777777777ULL;     // Largest value of a 12-byte octal field
+constexpr size_t MAX_EXTENDED_HEADER = 1024 * 1024;    // Pax or GNU long-name data held in memory
+constexpr size_t STREAM_BUFFER_SIZE = 1024 * 1024;
+
+uint64_t block_padding(uint64_t size) {
+    return (BLOCK - size % BLOCK) % BLOCK;
+}
+
+std::string field_string(const char* field, size_t size) {
+    return std::string(field, std::find(field, field + size, '\0'));
+}
+
+/**
+ * @brief An octal field, or a GNU base-256 one (high bit set)
+ */
+std::optional<uint64_t> parse_number(const char* field, size_t size) {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(field);
+    uint64_t value = 0;
+    if (bytes[0] & 0x80) {
+        if (bytes[0] & 0x40) {
+            return std::nullopt;   // Negative
+        }
+        value = bytes[0] & 0x3F;
+        for (size_t i = 1; i < size; ++i) {
+            if (value >> 56) {
+                return std::nullopt;
+            }
+            value = value << 8 | bytes[i];
+        }
+        return value;
+    }
+
+    size_t i = 0;
+    while (i < size && field[i] == ' ') {
+        ++i;
+    }
+    for (; i < size && field[i] >= '0' && field[i] <= '7'; ++i) {
+        if (value >> 61) {
+            return std::nullopt;
+        }
+        value = value * 8 + static_cast<uint64_t>(field[i] - '0');
+    }
+    for (; i < size; ++i) {
+        if (field[i] != ' ' && field[i] != '\0') {
+            return std::nullopt;
+        }
+    }
+    return value;
+}
+
+/**
+ * @brief Header checksum, as unsigned or (historically) signed bytes
+ */
+bool checksum_matches(const char* block) {
+    auto stored = parse_number(block + 148, 8);
+    if (!stored) {
+        return false;
+    }
+    uint64_t unsigned_sum = 0;
+    int64_t signed_sum = 0;
+    for (size_t i = 0; i < BLOCK; ++i) {
+        char c = i >= 148 && i < 156 ? ' ' : block[i];
+        unsigned_sum += static_cast<unsigned char>(c);
+        signed_sum += static_cast<signed char>(c);
+    }
+    return *stored == unsigned_sum || static_cast<int64_t>(*stored) == signed_sum;
+}
+
+void put_octal(char* field, size_t size, uint64_t value) {
+    // size - 1 zero-padded digits and a NUL
+    field[size - 1] = '\0';
+    for (size_t i = size - 1; i-- > 0;) {
+        field[i] = static_cast<char>('0' + (value & 7));
+        value >>= 3;
+    }
+}
+
+void put_base256(char* field, size_t size, uint64_t value) {
+    std::memset(field, 0, size);
+    field[0] = static_cast<char>(0x80);
+    for (size_t i = size - 1; i > 0 && value > 0; --i) {
+        field[i] = static_cast<char>(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+void fill_header(char* block, std::string_view name, std::string_view prefix,
+                 uint64_t size, uint64_t mtime, uint32_t mode, char type, std::string_view link = {}) {
+    std::memset(block, 0, BLOCK);
+    std::memcpy(block, name.data(), (std::min)(name.size(), size_t(100)));
+    std::memcpy(block + 157, link.data(), (std::min)(link.size(), size_t(100)));
+    put_octal(block + 100, 8, mode & 07777);
+    put_octal(block + 108, 8, 0);
+    put_octal(block + 116, 8, 0);
+    if (size <= MAX_OCTAL_11) {
+        put_octal(block + 124, 12, size);
+    } else {
+        put_base256(block + 124, 12, size);
+    }
+    put_octal(block + 136, 12, (std::min)(mtime, MAX_OCTAL_11));
+    block[156] = type;
+    std::memcpy(block + 257, "ustar", 6);
+    std::memcpy(block + 263, "00", 2);
+    std::memcpy(block + 345, prefix.data(), (std::min)(prefix.size(), size_t(155)));
+
+    std::memset(block + 148, ' ', 8);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < BLOCK; ++i) {
+        sum += static_cast<unsigned char>(block[i]);
+    }
+    put_octal(block + 148, 7, sum);   // Six digits, NUL, and the space left in place
+}
+
+/**
+ * @brief One pax record: "<length> <key>=<value>\n", the length counting itself
+ */
+std::string pax_record(std::string_view key, std::string_view value) {
+    size_t payload = key.size() + value.size() + 3;
+    size_t length = payload + 1;
+    while (std::to_string(length).size() + payload != length) {
+        length = std::to_string(length).size() + payload;
+    }
+    return std::to_string(length) + " " + std::string(key) + "=" + std::string(value) + "\n";
+}
+
+struct PaxOverrides {
+    std::string path;
+    std::string linkpath;
+    std::optional<uint64_t> size;
+    std::optional<uint64_t> mtime;
+};
+
+bool parse_pax(std::string_view text, PaxOverrides& pax) {
+    while (!text.empty()) {
+        size_t space = text.find(' ');
+        uint64_t length = 0;
+        if (space == std::string_view::npos ||
+            std::from_chars(text.data(), text.data() + space, length).ec != std::errc() ||
+            length <= space + 1 || length > text.size() || text[length - 1] != '\n') {
+            return false;
+        }
+        auto record = text.substr(space + 1, length - space - 2);
+        text.remove_prefix(length);
+
+        size_t equals = record.find('=');
+        if (equals == std::string_view::npos) {
+            return false;
+        }
+        auto key = record.substr(0, equals);
+        auto value = record.substr(equals + 1);
+        uint64_t number = 0;
+        bool numeric = std::from_chars(value.data(), value.data() + value.size(), number).ec == std::errc();
+        if (key == "path") {
+            pax.path = value;
+        } else if (key == "linkpath") {
+            pax.linkpath = value;
+        } else if (key == "size" && numeric) {
+            pax.size = number;
+        } else if (key == "mtime" && numeric) {
+            pax.mtime = number;   // Whole seconds; a fraction is dropped
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Tar names often start with "./" or "/"; members are relative
+ */
+std::string member_name(std::string name) {
+    while (name.starts_with("./")) {
+        name.erase(0, 2);
+    }
+    name.erase(0, (std::min)(name.find_first_not_of('/'), name.size()));
+    while (!name.empty() && name.back() == '/') {
+        name.pop_back();
+    }
+    return name;
+}
+
+/**
+ * @brief Header of a regular file, or of a hard link to @p link
+ */
+bool write_member_header(std::ostream& out, const FileEntry& entry, std::string_view link = {}) {
+    char block[BLOCK];
+    std::string_view name = entry.filename;
+    std::string_view prefix;
+    std::string records;
+
+    // ustar fits 100 bytes of name, or 255 split at a '/' into prefix and name
+    if (name.size() > 100) {
+        size_t slash = name.rfind('/', 155);
+        if (slash != std::string_view::npos && slash > 0 && name.size() - slash - 1 <= 100 &&
+            slash + 1 < name.size()) {
+            prefix = name.substr(0, slash);
+            name = name.substr(slash + 1);
+        } else {
+            records += pax_record("path", entry.filename);
+            name = name.substr(0, 100);
+        }
+    }
+    if (link.size() > 100) {
+        records += pax_record("linkpath", link);
+    }
+
+    // Longer: a pax header carries the full names
+    if (!records.empty()) {
+        fill_header(block, "././@PaxHeader", "", records.size(), entry.modified_time, 0644, 'x');
+        out.write(block, BLOCK);
+        out.write(records.data(), static_cast<std::streamsize>(records.size()));
+        char zeros[BLOCK] = {};
+        out.write(zeros, static_cast<std::streamsize>(block_padding(records.size())));
+    }
+
+    if (link.empty()) {
+        fill_header(block, name, prefix, entry.file_size, entry.modified_time, entry.permissions, '0');
+    } else {
+        fill_header(block, name, prefix, 0, entry.modified_time, entry.permissions, '1', link);
+    }
+    out.write(block, BLOCK);
+    return static_cast<bool>(out);
+}
+
+} // anonymous namespace
+
+// Tar to archive
+TarSource::TarSource(std::istream& tar, uint64_t alignment, size_t batch_bytes)
+    : tar_(tar), alignment_(alignment), batch_bytes_(batch_bytes) {
+}
+
+TarSource::~TarSource() = default;
+
+void TarSource::fail(const std::string& message) {
+    error_ = message;
+    throw std::runtime_error(message);
+}
+
+void TarSource::read_exact(char* data, size_t size, const char* what) {
+    tar_.read(data, static_cast<std::streamsize>(size));
+    if (static_cast<size_t>(tar_.gcount()) != size) {
+        fail(std::string("Truncated tar stream in ") + what);
+    }
+}
+
+void TarSource::skip(uint64_t size) {
+    while (size > 0) {
+        auto step = static_cast<std::streamsize>((std::min)(size, uint64_t(1) << 30));
+        tar_.ignore(step);
+        if (tar_.gcount() != step) {
+            fail("Truncated tar stream");
+        }
+        size -= static_cast<uint64_t>(step);
+    }
+}
+
+bool TarSource::next_member() {
+    PaxOverrides pax;
+    std::string long_name;
+    std::string long_link;
+    char block[BLOCK];
+    while (true) {
+        tar_.read(block, BLOCK);
+        if (tar_.gcount() == 0) {
+            tar_done_ = true;   // No end-of-archive blocks; still a whole tar
+            return false;
+        }
+        if (static_cast<size_t>(tar_.gcount()) != BLOCK) {
+            fail("Truncated tar header");
+        }
+        if (std::all_of(block, block + BLOCK, [](char c) { return c == '\0'; })) {
+            // End of archive; drain the rest of the record so the writer is not cut off
+            tar_.ignore(std::numeric_limits<std::streamsize>::max());
+            tar_done_ = true;
+            return false;
+        }
+        if (!checksum_matches(block)) {
+            fail("Not a tar stream (bad header checksum)");
+        }
+
+        char type = block[156];
+        auto size = parse_number(block + 124, 12);
+        auto mtime = parse_number(block + 136, 12);
+        auto mode = parse_number(block + 100, 8);
+        if (!size || !mtime || !mode) {
+            fail("Malformed tar header");
+        }
+        uint64_t data_size = pax.size.value_or(*size);
+
+        // Extended headers describe the member that follows them
+        if (type == 'x' || type == 'g' || type == 'L' || type == 'K') {
+            if (data_size > MAX_EXTENDED_HEADER) {
+                fail("Tar extended header too large");
+            }
+            std::string text(static_cast<size_t>(data_size), '\0');
+            read_exact(text.data(), text.size(), "an extended header");
+            skip(block_padding(data_size));
+            if (type == 'L') {
+                long_name = text.c_str();
+            } else if (type == 'K') {
+                long_link = text.c_str();
+            } else if (type == 'x' && !parse_pax(text, pax)) {
+                fail("Malformed pax header");
+            }
+            continue;
+        }
+
+        std::string name = !pax.path.empty() ? pax.path : !long_name.empty() ? long_name : "";
+        if (name.empty()) {
+            name = field_string(block, 100);
+            auto prefix = field_string(block + 345, 155);
+            if (std::memcmp(block + 257, "ustar", 5) == 0 && !prefix.empty()) {
+                name = prefix + "/" + name;
+            }
+        }
+
+        // Links carry no data whatever their size field says
+        if (type != '0' && type != '\0' && type != '7' && type != '1') {
+            if (type != '2') {
+                skip(data_size + block_padding(data_size));
+            }
+            if (type != '5') {
+                skipped_.push_back(name);
+            }
+            pax = {};
+            long_name.clear();
+            long_link.clear();
+            continue;
+        }
+
+        name = member_name(name);
+        if (name.empty() || !ArchiveFormat::is_safe_name(name)) {
+            fail("Unsafe member name in tar: " + name);
+        }
+        PendingMember member;
+        if (type == '1') {
+            // Resolved against the batch by next_segment()
+            member.entry.filename = std::move(name);
+            member.link = member_name(!pax.linkpath.empty() ? pax.linkpath
+                                      : !long_link.empty() ? long_link : field_string(block + 157, 100));
+            pending_ = std::move(member);
+            return true;
+        }
+        member.entry.filename = std::move(name);
+        member.entry.file_size = data_size;
+        member.entry.modified_time = pax.mtime.value_or(*mtime);
+        member.entry.permissions = static_cast<uint32_t>(*mode & 07777);
+        member.padding = block_padding(data_size);
+        pending_ = std::move(member);
+        return true;
+    }
+}
+
+bool TarSource::next_segment() {
+    if (segments_ > 0 && tar_done_ && !pending_) {
+        return false;
+    }
+    table_.clear();
+    batch_.clear();
+    served_ = 0;
+
+    std::vector<FileEntry> entries;
+    std::unordered_map<std::string, size_t> names;   // Batched member names -> entry
+    uint64_t held = 0;   // Contents and table bytes of the batch
+    while (pending_ || (!tar_done_ && next_member())) {
+        auto& member = *pending_;
+        if (!member.link.empty()) {
+            // A hard link to a batched file shares its data; others are dropped
+            auto target = names.find(member.link);
+            if (target == names.end()) {
+                skipped_.push_back(member.entry.filename);
+            } else {
+                FileEntry entry = entries[target->second];
+                entry.filename = std::move(member.entry.filename);
+                entry.shared = entry.file_size > 0;
+                if (!entry.shared) {
+                    entry.offset = batch_.size();
+                }
+                held += 4 + entry.filename.size() + FileEntry::fixed_size(ArchiveFormat::APPENDABLE_VERSION);
+                member_count_++;
+                names[entry.filename] = entries.size();
+                entries.push_back(std::move(entry));
+            }
+            pending_.reset();
+            continue;
+        }
+        uint64_t cost = member.entry.file_size + 4 + member.entry.filename.size() +
+                        FileEntry::fixed_size(ArchiveFormat::APPENDABLE_VERSION);
+        if (held + cost > batch_bytes_) {
+            if (!entries.empty()) {
+                break;   // The member opens the next batch
+            }
+            // Too big for any batch: a segment of its own, streamed through
+            // and hashed on the way
+            stream_left_ = member.entry.file_size;
+            stream_padding_ = member.padding;
+            member.entry.digest_after = true;
+            if (!hasher_) {
+                hasher_ = Botan::HashFunction::create_or_throw(ArchiveFormat::CONTENT_HASH);
+            }
+            hasher_->clear();
+            member_count_++;
+            member_bytes_ += member.entry.file_size;
+            entries.push_back(std::move(member.entry));
+            pending_.reset();
+            break;
+        }
+
+        size_t offset = batch_.size();
+        size_t size = static_cast<size_t>(member.entry.file_size);
+        batch_.resize(offset + size);
+        read_exact(batch_.data() + offset, size, member.entry.filename.c_str());
+        skip(member.padding);
+        member.entry.offset = offset;
+        member.entry.content_hash = ArchiveFormat::hash_bytes(
+            std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(batch_.data()) + offset, size));
+        held += cost;
+        member_count_++;
+        member_bytes_ += size;
+        names[member.entry.filename] = entries.size();
+        entries.push_back(std::move(member.entry));
+        pending_.reset();
+    }
+    if (entries.empty() && segments_ > 0) {
+        return false;
+    }
+
+    table_ = ArchiveFormat::serialize_table(entries, {}, ArchiveFormat::APPENDABLE_VERSION);
+    uint64_t segment_size = table_.size() + batch_.size() + ArchiveFormat::digest_block_size(entries) + stream_left_;
+    padding_left_ = alignment_ == 0 ? 0 : (alignment_ - (produced_ + segment_size) % alignment_) % alignment_;
+    segments_++;
+    return true;
+}
+
+TarSource::int_type TarSource::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+
+    while (true) {
+        // Table, then the batched contents, both from memory
+        size_t held = table_.size() + batch_.size();
+        if (served_ < held) {
+            char* begin = served_ < table_.size()
+                ? reinterpret_cast<char*>(table_.data()) + served_
+                : batch_.data() + (served_ - table_.size());
+            size_t size = served_ < table_.size() ? table_.size() - served_ : held - served_;
+            served_ += size;
+            produced_ += size;
+            setg(begin, begin, begin + size);
+            return traits_type::to_int_type(*gptr());
+        }
+
+        if (buffer_.empty()) {
+            buffer_.resize(STREAM_BUFFER_SIZE);
+        }
+        size_t want = 0;
+        if (stream_left_ > 0) {
+            want = static_cast<size_t>((std::min)(uint64_t(buffer_.size()), stream_left_));
+            read_exact(buffer_.data(), want, "member contents");
+            hasher_->update(reinterpret_cast<const uint8_t*>(buffer_.data()), want);
+            stream_left_ -= want;
+            if (stream_left_ == 0) {
+                skip(stream_padding_);
+                digest_.resize(sizeof(ContentHash));
+                hasher_->final(digest_.data());
+            }
+        } else if (!digest_.empty()) {
+            want = digest_.size();
+            std::memcpy(buffer_.data(), digest_.data(), want);
+            digest_.clear();
+        } else if (padding_left_ > 0) {
+            want = static_cast<size_t>((std::min)(uint64_t(buffer_.size()), padding_left_));
+            std::fill_n(buffer_.data(), want, '\0');
+            padding_left_ -= want;
+        } else if (!next_segment()) {
+            return traits_type::eof();
+        } else {
+            continue;
+        }
+        produced_ += want;
+        setg(buffer_.data(), buffer_.data(), buffer_.data() + want);
+        return traits_type::to_int_type(*gptr());
+    }
+}
+
+// Archive to tar
+TarSink::TarSink(std::ostream& tar) : tar_(tar) {
+}
+
+bool TarSink::fail(std::string message) {
+    if (error_.empty()) {
+        error_ = std::move(message);
+    }
+    return false;
+}
+
+bool TarSink::parse_table() {
+    std::string error;
+    if (table_offset_ == 0) {
+        if (!ArchiveFormat::parse_header(table_, segment_, error)) {
+            return error.empty() ? false : fail(error);
+        }
+        if (segment_.is_delta()) {
+            return fail("Delta archives cannot be exported as tar; unchanged members are in the base");
+        }
+        table_offset_ = segment_.size;
+        segment_entries_.clear();
+    }
+
+    if (!ArchiveFormat::parse_entries(table_, table_offset_, segment_, segment_entries_, error)) {
+        return error.empty() ? false : fail(error);
+    }
+    table_done_ = true;
+    member_ = 0;
+    segment_start_ = entries_.size();
+    digests_left_ = ArchiveFormat::digest_block_size(segment_entries_);
+    stored_at_.clear();
+    for (size_t i = 0; i < segment_entries_.size(); ++i) {
+        if (segment_entries_[i].stored_size() > 0) {
+            stored_at_[segment_entries_[i].offset] = segment_start_ + i;
+        }
+    }
+    entries_.insert(entries_.end(), segment_entries_.begin(), segment_entries_.end());
+    return true;
+}
+
+bool TarSink::begin_member() {
+    const auto& entry = segment_entries_[member_];
+    std::string_view link;
+    if (entry.shared) {
+        // A hard link to the member stored with this data, if tar still has it under that name
+        auto stored = stored_at_.find(entry.offset);
+        if (stored == stored_at_.end() || entries_[stored->second].file_size != entry.file_size) {
+            return fail("Shared member does not match a stored one: " + entry.filename);
+        }
+        link = entries_[stored->second].filename;
+        auto written = written_.find(std::string(link));
+        if (written == written_.end() || written->second != stored->second) {
+            return fail("Shared member's copy was overwritten before it: " + entry.filename);
+        }
+    }
+    if (!write_member_header(tar_, entry, link)) {
+        return fail("Failed to write the tar stream");
+    }
+    written_[entry.filename] = segment_start_ + member_;
+    member_open_ = true;
+    member_written_ = 0;
+    return true;
+}
+
+bool TarSink::end_member() {
+    char zeros[BLOCK] = {};
+    tar_.write(zeros, static_cast<std::streamsize>(block_padding(segment_entries_[member_].stored_size())));
+    member_open_ = false;
+    member_++;
+    return tar_ ? true : fail("Failed to write the tar stream");
+}
+
+TarSink::int_type TarSink::overflow(int_type ch) {
+    if (traits_type::eq_int_type(ch, traits_type::eof())) {
+        return traits_type::not_eof(ch);
+    }
+    char c = traits_type::to_char_type(ch);
+    return xsputn(&c, 1) == 1 ? ch : traits_type::eof();
+}
+
+std::streamsize TarSink::xsputn(const char* data, std::streamsize count) {
+    if (!error_.empty()) {
+        return 0;
+    }
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    size_t remaining = static_cast<size_t>(count);
+
+    while (remaining > 0) {
+        if (!table_done_) {
+            table_.insert(table_.end(), bytes, bytes + remaining);
+            if (!parse_table()) {
+                return error_.empty() ? count : 0;  // Wait for more of the table
+            }
+            size_t extra = table_.size() - table_offset_;
+            bytes += remaining - extra;
+            remaining = extra;
+            table_ = {};
+            continue;
+        }
+
+        // Empty and shared members take no bytes; write them on the way past
+        while (!member_open_ && member_ < segment_entries_.size()) {
+            if (!begin_member() || (segment_entries_[member_].stored_size() == 0 && !end_member())) {
+                return 0;
+            }
+        }
+
+        // Past the last member: the segment's hashes, which tar has no place for
+        if (!member_open_ && digests_left_ > 0) {
+            size_t n = static_cast<size_t>((std::min)(uint64_t(remaining), digests_left_));
+            digests_left_ -= n;
+            bytes += n;
+            remaining -= n;
+            continue;
+        }
+
+        // Then a padded segment may be followed by another
+        if (!member_open_) {
+            if (segment_.version < ArchiveFormat::APPENDABLE_VERSION) {
+                fail("Data past the end of the archive");
+                return 0;
+            }
+            auto* next = std::find_if(bytes, bytes + remaining, [](uint8_t byte) { return byte != 0; });
+            remaining -= static_cast<size_t>(next - bytes);
+            bytes = next;
+            if (remaining > 0) {
+                table_done_ = false;
+                table_offset_ = 0;
+            }
+            continue;
+        }
+
+        size_t n = static_cast<size_t>((std::min)(
+            uint64_t(remaining), segment_entries_[member_].file_size - member_written_));
+        tar_.write(reinterpret_cast<const char*>(bytes), static_cast<std::streamsize>(n));
+        if (!tar_) {
+            fail("Failed to write the tar stream");
+            return 0;
+        }
+        member_written_ += n;
+        bytes += n;
+        remaining -= n;
+
+        if (member_written_ == segment_entries_[member_].file_size && !end_member()) {
+            return 0;
+        }
+    }
+
+    return count;
+}
+
+bool TarSink::finish() {
+    if (!error_.empty()) {
+        return false;
+    }
+    if (!table_done_ || member_open_) {
+        return fail("Truncated archive");
+    }
+
+    // Empty and shared members after the last data have not been written yet
+    while (member_ < segment_entries_.size()) {
+        if (segment_entries_[member_].stored_size() > 0) {
+            return fail("Truncated archive");
+        }
+        if (!begin_member() || !end_member()) {
+            return false;
+        }
+    }
+    if (digests_left_ > 0) {
+        return fail("Truncated archive");
+    }
+
+    char end_blocks[2 * BLOCK] = {};
+    tar_.write(end_blocks, sizeof(end_blocks));
+    tar_.flush();
+    return tar_ ? true : fail("Failed to write the tar stream");
+}
+
+} // namespace filevault::archive
@@ -0,0 +1,557 @@
+/**
+ * @file filevault.cpp
+ * @brief C API over the engine, cipher sessions and streaming
+ */
+
+#include "filevault/filevault.h"
+#include "filevault/compression/compressor.hpp"
+#include "filevault/core/algorithm_traits.hpp"
+#include "filevault/core/crypto_engine.hpp"
+#include "filevault/core/random.hpp"
+#include "filevault/core/streaming.hpp"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <istream>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#ifndef FILEVAULT_VERSION
+#define FILEVAULT_VERSION "unknown"
+#endif
+
+using namespace filevault;
+
+struct fv_engine {
+    core::CryptoEngine engine;
+};
+
+struct fv_session {
+    std::unique_ptr<core::ICipherSession> session;
+    const core::AlgorithmTraits* traits = nullptr;
+    std::vector<uint8_t> buffer;        // Reused across messages
+    core::EncryptionConfig config;
+};
+
+struct fv_options {
+    core::AlgorithmType algorithm = core::AlgorithmType::AES_256_GCM;
+    core::KDFType kdf = core::KDFType::ARGON2ID;
+    core::SecurityLevel level = core::SecurityLevel::MEDIUM;
+    core::CompressionType compression = core::CompressionType::NONE;
+    int compression_level = 6;
+    size_t chunk_size = core::StreamingConfig{}.chunk_size;
+    size_t threads = 1;
+};
+
+namespace {
+
+thread_local std::string last_error;
+
+fv_status fail(fv_status status, std::string message) {
+    last_error = std::move(message);
+    return status;
+}
+
+/**
+ * @brief Run an API body, turning exceptions into status codes
+ */
+template<typename F>
+fv_status guarded(F&& body) {
+    try {
+        return body();
+    } catch (const std::bad_alloc&) {
+        return fail(FV_ERR_INTERNAL, "Out of memory");
+    } catch (const std::exception& e) {
+        return fail(FV_ERR_INTERNAL, e.what());
+    } catch (...) {
+        return fail(FV_ERR_INTERNAL, "Unknown error");
+    }
+}
+
+const core::AlgorithmTraits* lookup(const char* algorithm) {
+    if (!algorithm) {
+        return nullptr;
+    }
+    auto type = core::CryptoEngine::parse_algorithm(algorithm);
+    return type ? &core::algorithm_traits(*type) : nullptr;
+}
+
+bool parse_size(const char* value, size_t& out) {
+    const char* end = value + std::strlen(value);
+    auto [ptr, ec] = std::from_chars(value, end, out);
+    return ec == std::errc() && ptr == end;
+}
+
+core::StreamProgressCallback progress_adapter(fv_progress_fn progress, void* user_data, bool& cancelled) {
+    if (!progress) {
+        return nullptr;
+    }
+    return [progress, user_data, &cancelled](const core::ChunkInfo& info) {
+        if (progress(user_data, info.bytes_processed, info.total_bytes)) {
+            return true;
+        }
+        cancelled = true;
+        return false;
+    };
+}
+
+fv_status finish(const core::StreamingResult& result, bool cancelled) {
+    if (result.success) {
+        return FV_OK;
+    }
+    if (cancelled) {
+        return fail(FV_ERR_CANCELLED, result.error_message);
+    }
+    return fail(FV_ERR_FAILED, result.error_message);
+}
+
+core::StreamingConfig streaming_config(const fv_options* options) {
+    fv_options defaults;
+    const fv_options& o = options ? *options : defaults;
+    core::StreamingConfig config;
+    config.algorithm = o.algorithm;
+    config.kdf = o.kdf;
+    config.level = o.level;
+    config.compression = o.compression;
+    config.compression_level = o.compression_level;
+    config.chunk_size = o.chunk_size;
+    config.worker_threads = o.threads;
+    return config;
+}
+
+/**
+ * @brief std::streambuf over the caller's read/write callbacks
+ */
+class CallbackBuffer : public std::streambuf {
+public:
+    CallbackBuffer(fv_read_fn read, fv_write_fn write, void* context)
+        : read_(read), write_(write), context_(context) {
+        setg(in_.data(), in_.data(), in_.data());
+        setp(out_.data(), out_.data() + out_.size());
+    }
+
+    bool failed() const { return failed_; }
+
+protected:
+    int_type underflow() override {
+        if (!read_ || failed_) {
+            return traits_type::eof();
+        }
+        int64_t n = read_(context_, reinterpret_cast<uint8_t*>(in_.data()), in_.size());
+        if (n <= 0) {
+            failed_ = failed_ || n < 0;
+            return traits_type::eof();
+        }
+        setg(in_.data(), in_.data(), in_.data() + n);
+        return traits_type::to_int_type(in_[0]);
+    }
+
+    int_type overflow(int_type ch) override {
+        if (!flush_out()) {
+            return traits_type::eof();
+        }
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char* data, std::streamsize size) override {
+        // Large writes (whole chunks) bypass the buffer
+        if (size < static_cast<std::streamsize>(out_.size())) {
+            return std::streambuf::xsputn(data, size);
+        }
+        if (!flush_out() || !write_ ||
+            write_(context_, reinterpret_cast<const uint8_t*>(data), static_cast<size_t>(size)) != 0) {
+            failed_ = true;
+            return 0;
+        }
+        return size;
+    }
+
+    int sync() override { return flush_out() ? 0 : -1; }
+
+private:
+    bool flush_out() {
+        size_t pending = static_cast<size_t>(pptr() - pbase());
+        if (pending > 0) {
+            if (!write_ || write_(context_, reinterpret_cast<const uint8_t*>(pbase()), pending) != 0) {
+                failed_ = true;
+                return false;
+            }
+            setp(out_.data(), out_.data() + out_.size());
+        }
+        return !failed_;
+    }
+
+    fv_read_fn read_;
+    fv_write_fn write_;
+    void* context_;
+    bool failed_ = false;
+    std::array<char, 64 * 1024> in_;
+    std::array<char, 64 * 1024> out_;
+};
+
+} // anonymous namespace
+
+struct fv_stream {
+    fv_stream(fv_read_fn read, fv_write_fn write, void* context)
+        : buffer(read, write, context), input(&buffer), output(&buffer) {}
+
+    CallbackBuffer buffer;
+    std::istream input;
+    std::ostream output;
+};
+
+extern "C" {
+
+uint32_t fv_api_version(void) {
+    return FV_API_VERSION;
+}
+
+const char* fv_version(void) {
+    return FILEVAULT_VERSION;
+}
+
+const char* fv_last_error(void) {
+    return last_error.c_str();
+}
+
+const char* fv_status_string(fv_status status) {
+    switch (status) {
+        case FV_OK: return "ok";
+        case FV_ERR_INVALID_ARGUMENT: return "invalid argument";
+        case FV_ERR_UNSUPPORTED: return "unsupported";
+        case FV_ERR_AUTHENTICATION: return "authentication failed";
+        case FV_ERR_BUFFER_TOO_SMALL: return "buffer too small";
+        case FV_ERR_CANCELLED: return "cancelled";
+        case FV_ERR_FAILED: return "failed";
+        case FV_ERR_INTERNAL: return "internal error";
+    }
+    return "unknown status";
+}
+
+fv_status fv_random(uint8_t* buffer, size_t size) {
+    if (!buffer && size > 0) {
+        return fail(FV_ERR_INVALID_ARGUMENT, "Null buffer");
+    }
+    return guarded([&] {
+        core::RandomService::fill(std::span<uint8_t>(buffer, size));
+        return FV_OK;
+    });
+}
+
+fv_status fv_algorithm_sizes(const char* algorithm, size_t* key_size, size_t* nonce_size, size_t* tag_size) {
+    const auto* traits = lookup(algorithm);
+    if (!traits) {
+        return fail(FV_ERR_INVALID_ARGUMENT, std::string("Unknown algorithm: ") + (algorithm ? algorithm : "(null)"));
+    }
+    if (key_size) *key_size = traits->key_size;
+    if (nonce_size) *nonce_size = traits->nonce_size;
+    if (tag_size) *tag_size = traits->tag_size;
+    return FV_OK;
+}
+
+fv_status fv_engine_create(fv_engine** engine) {
+    if (!engine) {
+        return fail(FV_ERR_INVALID_ARGUMENT, "Null engine pointer");
+    }
+    *engine = nullptr;
+    return guarded([&] {
+        auto created = std::make_unique<fv_engine>();
+        created->engine.initialize();
+        *engine = created.release();
+        return FV_OK;
+    });
+}
+
+void fv_engine_destroy(fv_engine* engine) {
+    delete engine;
+}
+
+fv_status fv_derive_key(fv_engine* engine, const char* password, const uint8_t* salt, size_t salt_size,
+                        const fv_options* options, uint8_t* key, size_t key_size) {
+    if (!engine || !password || (!salt && salt_size > 0) || !key) {
+        return fail(FV_ERR_INVALID_ARGUMENT, "Null argument");
+    }
+    return guarded([&] {
+        fv_options defaults;
+        const fv_options& o = options ? *options : defaults;
+        core::EncryptionConfig config;
+        config.algorithm = o.algorithm;
+        config.kdf = o.kdf;
+        config.level = o.level;
+        config.apply_security_level();
+        auto derived = engine->engine.derive_key(password, std::vector<uint8_t>(salt, salt + salt_size), config);
+        if (derived.size() != key_size) {
+            return fail(FV_ERR_INVALID_ARGUMENT,
+                        "Key size must be " + std::to_string(derived.size()) + " bytes for this algorithm");
+        }
+        std::copy(derived.begin(), derived.end(), key);
+        std::fill(derived.begin(), derived.end(), uint8_t{0});
+        return FV_OK;
+    });
+}
+
+fv_status fv_session_create(fv_engine* engine, const char* algorithm, const uint8_t* key, size_t key_size,
+                            fv_session** session) {
+    if (!engine || !key || !session) {
+        return fail(FV_ERR_INVALID_ARGUMENT, "Null argument");
+    }
+    *session = nullptr;
+    const auto* traits = lookup(algorithm);
+    if (!traits) {
+        return fail(FV_ERR_INVALID_ARGUMENT, std::string("Unknown algorithm: ") + (algorithm ? algorithm : "(null)"));
+    }
+    if (!traits->is_aead()) {
+        return fail(FV_ERR_UNSUPPORTED, std::string(traits->name) + " is not an authenticated cipher");
+    }
+    return guarded([&] {
+        auto* impl = engine->engine.get_algorithm(traits->type);
+        if (!impl) {
+            return fail(FV_ERR_UNSUPPORTED, std::string(traits->name) + " is not available in this build");
+        }
+        auto created = std::make_unique<fv_session>();
+        created->session = impl->create_session(std::span<const uint8_t>(key, key_size));
+        if (!created->session) {
+            return fail(FV_ERR_INVALID_ARGUMENT, "Key must be " + std::to_string(impl->key_size()) + " bytes");
+        }
+        created->traits = traits;
+        created->config.algorithm = traits->type;
+        *session = created.release();
+        return FV_OK;
+    });
+}
+
+void fv_session_destroy(fv_session* session) {
+    delete session;
+}
+
+size_t fv_session_overhead(const fv_session* session) {
+    return session ? session->traits->nonce_size + session->traits->tag_size : 0;
+}
+
+fv_status fv_session_seal(fv_session* session, const uint8_t* plaintext, size_t size,
+                          const uint8_t* associated_data, size_t associated_size,
+                          uint8_t* output, size_t output_capacity, size_t* out_len) {
+    if (!session || (!plaintext && size > 0) || (!associated_data && associated_size > 0) || !out_len) {
+        return fail(FV_ERR_INVALID_ARGUMENT, "Null argument");
+    }
+    const size_t nonce_size = session->traits->nonce_size;
+    const size_t tag_size = session->traits->tag_size;
+    *out_len = size + nonce_size + tag_size;
+    if (!output || output_capacity < *out_len) {
+        return fail(FV_ERR_BUFFER_TOO_SMALL, "Output needs " + std::to_string(*out_len) + " bytes");
+    }
+    return guarded([&] {
+        auto& config = session->config;
+        config.nonce = core::ShortBytes(nonce_size);
+        core::RandomService::fill(std::span<uint8_t>(config.nonce->data(), nonce_size));
+        config.tag.reset();
+        if (associated_size > 0) {
+            config.associated_data = std::vector<uint8_t>(associated_data, associated_data + associated_size);
+        } else {
+            config.associated_data.reset();
+        }
+
+        session->buffer.assign(plaintext, plaintext + size);
+        auto sealed = session->session->encrypt_in_place(session->buffer, config);
+        if (!sealed.success || !sealed.tag || sealed.tag->size() != tag_size || session->buffer.size() != size) {
+            return fail(FV_ERR_FAILED, sealed.error_message.empty() ? "Encryption failed" : sealed.error_message);
+        }
+        std::memcpy(output, config.nonce->data(), nonce_size);
+        std::memcpy(output + nonce_size, session->buffer.data(), size);
+        std::memcpy(output + nonce_size + size, sealed.tag->data(), tag_size);
+        return FV_OK;
+    });
+}
+
+fv_status fv_session_open(fv_session* session, const uint8_t* sealed, size_t size,
+                          const uint8_t* associated_data, size_t associated_size,
+                          uint8_t* output, size_t output_capacity, size_t* out_len) {
+    if (!session || (!sealed && size > 0) || (!associated_data && associated_size > 0) || !out_len) {
+        return fail(FV_ERR_INVALID_ARGUMENT, "Null argument");
+    }
+    const size_t nonce_size = session->traits->nonce_size;
+    const size_t tag_size = session->traits->tag_size;
+    if (size < nonce_size + tag_size) {
+        *out_len = 0;
+        return fail(FV_ERR_AUTHENTICATION, "Message too short");
+    }
+    *out_len = size - nonce_size - tag_size;
+    if ((!output && *out_len > 0) || output_capacity < *out_len) {
+        return fail(FV_ERR_BUFFER_TOO_SMALL, "Output needs " + std::to_string(*out_len) + " bytes");
+    }
+    return guarded([&] {
+        auto& config = session->config;
+        config.nonce = core::ShortBytes(sealed, sealed + nonce_size);
+        config.tag = core::ShortBytes(sealed + size - tag_size, sealed + size);
+        if (associated_size > 0) {
+            config.associated_data = std::vector<uint8_t>(associated_data, associated_data + associated_size);
+        } else {
+            config.associated_data.reset();
+        }
+
+        session->buffer.assign(sealed + nonce_size, sealed + size - tag_size);
+        auto opened = session->session->decrypt_in_place(session->buffer, config);
+        if (!opened.success) {
+            std::fill(session->buffer.begin(), session->buffer.end(), uint8_t{0});
+            return fail(FV_ERR_AUTHENTICATION, "Authentication failed");
+        }
+        std::memcpy(output, session->buffer.data(), session->buffer.size());
+        *out_len = session->buffer.size();
+        return FV_OK;
+    });
+}
+
+fv_status fv_options_create(fv_options** options) {
+    if (!options) {
+        return fail(FV_ERR_INVALID_ARGUMENT, "Null options pointer");
+    }
+    *options = nullptr;
+    return guarded([&] {
+        *options = new fv_options();
+        return FV_OK;
+    });
+}
+
+void fv_options_destroy(fv_options* options) {
+    delete options;
+}
+
+fv_status fv_options_set(fv_options* options, const char* key, const char* value) {
+    if (!options || !key || !value) {
+        return fail(FV_ERR_INVALID_ARGUMENT, "Null argument");
+    }
+    return guarded([&] {
+        const std::string name = key;
+        auto invalid = [&] { return fail(FV_ERR_INVALID_ARGUMENT, "Invalid " + name + ": " + value); };
+        if (name == "algorithm") {
+            const auto* traits = lookup(value);
+            if (!traits) return invalid();
+            options->algorithm = traits->type;
+        } else if (name == "kdf") {
+            auto kdf = core::CryptoEngine::parse_kdf(value);
+            if (!kdf) return invalid();
+            options->kdf = *kdf;
+        } else if (name == "level") {
+            auto level = core::CryptoEngine::parse_security_level(value);
+            if (!level) return invalid();
+            options->level = *level;
+        } else if (name == "compression") {
+            try {
+                options->compression = compression::CompressionService::parse_algorithm(value);
+            } catch (const std::invalid_argument&) {
+                return invalid();
+            }
+        } else if (name == "compression-level") {
+            size_t level = 0;
+            if (!parse_size(value, level) || level < 1 || level > 22) return invalid();
+            options->compression_level = static_cast<int>(level);
+        } else if (name == "chunk-size") {
+            size_t bytes = 0;
+            if (!parse_size(value, bytes) || bytes == 0) return invalid();
+            options->chunk_size = bytes;
+        } else if (name == "threads") {
+            size_t threads = 0;
+            if (!parse_size(value, threads)) return invalid();
+            options->threads = threads;
+        } else {
+            return fail(FV_ERR_INVALID_ARGUMENT, "Unknown option: " + name);
+        }
+        return FV_OK;
+    });
+}
+
+fv_status fv_encrypt_file(const char* input_path, const char* output_path, const char* password,
+                          const fv_options* options, fv_progress_fn progress, void* user_data) {
+    if (!input_path || !output_path || !password) {
+        return fail(FV_ERR_INVALID_ARGUMENT, "Null argument");
+    }
+    return guarded([&] {
+        auto config = streaming_config(options);
+        if (!core::StreamingCrypto::supports_algorithm(config.algorithm)) {
+            return fail(FV_ERR_UNSUPPORTED, "Streaming supports AEAD algorithms only");
+        }
+        bool cancelled = false;
+        config.progress_callback = progress_adapter(progress, user_data, cancelled);
+        return finish(core::StreamingCrypto::encrypt_file(input_path, output_path, password, config), cancelled);
+    });
+}
+
+fv_status fv_decrypt_file(const char* input_path, const char* output_path, const char* password,
+                          const fv_options* options, fv_progress_fn progress, void* user_data) {
+    if (!input_path || !output_path || !password) {
+        return fail(FV_ERR_INVALID_ARGUMENT, "Null argument");
+    }
+    return guarded([&] {
+        bool cancelled = false;
+        auto result = core::StreamingCrypto::decrypt_file(input_path, output_path, password,
+                                                          progress_adapter(progress, user_data, cancelled),
+                                                          options ? options->threads : 1);
+        return finish(result, cancelled);
+    });
+}
+
+fv_status fv_stream_create(fv_read_fn read, fv_write_fn write, void* context, fv_stream** stream) {
+    if (!read || !write || !stream) {
+        return fail(FV_ERR_INVALID_ARGUMENT, "Null argument");
+    }
+    *stream = nullptr;
+    return guarded([&] {
+        *stream = new fv_stream(read, write, context);
+        return FV_OK;
+    });
+}
+
+void fv_stream_destroy(fv_stream* stream) {
+    delete stream;
+}
+
+fv_status fv_encrypt_stream(fv_stream* stream, const char* password, const fv_options* options,
+                            fv_progress_fn progress, void* user_data) {
+    if (!stream || !password) {
+        return fail(FV_ERR_INVALID_ARGUMENT, "Null argument");
+    }
+    return guarded([&] {
+        auto config = streaming_config(options);
+        if (!core::StreamingCrypto::supports_algorithm(config.algorithm)) {
+            return fail(FV_ERR_UNSUPPORTED, "Streaming supports AEAD algorithms only");
+        }
+        bool cancelled = false;
+        config.progress_callback = progress_adapter(progress, user_data, cancelled);
+        auto result = core::StreamingCrypto::encrypt_stream(stream->input, stream->output, password, config);
+        stream->output.flush();
+        if (result.success && stream->buffer.failed()) {
+            return fail(FV_ERR_FAILED, "Stream callback failed");
+        }
+        return finish(result, cancelled);
+    });
+}
+
+fv_status fv_decrypt_stream(fv_stream* stream, const char* password, const fv_options* options,
+                            fv_progress_fn progress, void* user_data) {
+    if (!stream || !password) {
+        return fail(FV_ERR_INVALID_ARGUMENT, "Null argument");
+    }
+    return guarded([&] {
+        bool cancelled = false;
+        auto result = core::StreamingCrypto::decrypt_stream(stream->input, stream->output, password,
+                                                            progress_adapter(progress, user_data, cancelled),
+                                                            options ? options->threads : 1);
+        stream->output.flush();
+        if (result.success && stream->buffer.failed()) {
+            return fail(FV_ERR_FAILED, "Stream callback failed");
+        }
+        return finish(result, cancelled);
+    });
+}
+
+} // extern "C"
@@ -14,16 +14,107 @@
 #include "filevault/cli/commands/dump_cmd.hpp"
 #include "filevault/cli/commands/sign_cmd.hpp"
 #include "filevault/cli/commands/verify_cmd.hpp"
+#include "filevault/cli/commands/rekey_cmd.hpp"
 #include "filevault/cli/commands/keyinfo_cmd.hpp"
+#include "filevault/cli/commands/dict_cmd.hpp"
+#include "filevault/cli/commands/dedup_cmd.hpp"
+#include "filevault/cli/commands/crack_cmd.hpp"
+#include "filevault/cli/commands/password_audit_cmd.hpp"
+#include "filevault/cli/commands/serve_cmd.hpp"
+#include "filevault/cli/commands/batch_cmd.hpp"
+#include "filevault/cli/commands/volume_cmd.hpp"
+#include "filevault/cli/commands/store_cmd.hpp"
+#include "filevault/cli/commands/mount_cmd.hpp"
+#include "filevault/cli/commands/watch_cmd.hpp"
+#include "filevault/core/buffer_pool.hpp"
+#include "filevault/core/cpu_features.hpp"
+#include "filevault/core/memory_budget.hpp"
+#include "filevault/core/numa.hpp"
+#include "filevault/core/offload.hpp"
+#include "filevault/core/system_resources.hpp"
+#include "filevault/utils/config.hpp"
 #include "filevault/utils/console.hpp"
+#include "filevault/utils/io_backend.hpp"
+#include "filevault/utils/run_stats.hpp"
+#include "filevault/utils/throttle.hpp"
+#include "filevault/utils/trace.hpp"
+#include <fmt/core.h>
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
+#include <functional>
 
 namespace filevault {
 namespace cli {
 
+namespace {
+
+/**
+ * @brief First positional argument, i.e. the subcommand name
+ * @param profile_startup Set if --profile-startup precedes it
+ * @param trace_file Set to the value of a preceding --trace
+ * @param stats_format Set to the value of a preceding --stats
+ * @param numa Set if --numa precedes it
+ * @param background Set if --background precedes it
+ */
+std::string find_subcommand(int argc, char** argv, bool& profile_startup,
+                            std::string& trace_file, std::string& stats_format, bool& numa,
+                            bool& background) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "--profile-startup") {
+            profile_startup = true;
+        } else if (arg == "--numa") {
+            numa = true;
+        } else if (arg == "--background") {
+            background = true;
+        } else if (arg.rfind("--trace=", 0) == 0) {
+            trace_file = arg.substr(8);
+        } else if (arg == "--trace") {
+            if (i + 1 < argc) {
+                trace_file = argv[++i];
+            }
+        } else if (arg.rfind("--stats=", 0) == 0) {
+            stats_format = arg.substr(8);
+        } else if (arg == "--stats") {
+            if (i + 1 < argc) {
+                stats_format = argv[++i];
+            }
+        } else if (arg == "--log-level" || arg == "--max-memory" || arg == "--rate-limit" || arg == "--offload") {
+            ++i;  // Skip its value
+        } else if (!arg.empty() && arg[0] != '-') {
+            return arg;
+        }
+    }
+    return "";
+}
+
+/**
+ * @brief Set the process-wide memory limit
+ * @param bytes 0 = three quarters of the container's limit, if any
+ *
+ * The buffer pool keeps at most its share cached; streams and key
+ * derivations lease from the limit as they run.
+ */
+void apply_memory_limit(uint64_t bytes) {
+    if (bytes == 0) {
+        // What is not leased (code, small allocations, the page cache
+        // charged to the cgroup) needs room too
+        bytes = core::SystemResources::detect().memory_limit / 4 * 3;
+    }
+    auto& budget = core::MemoryBudget::shared();
+    budget.set_limit(bytes);
+    core::BufferPool::shared().set_max_cached_bytes(
+        budget.pool_bytes(uint64_t{utils::Config::current().get_buffer_pool_mb()} * 1024 * 1024));
+    if (bytes > 0) {
+        spdlog::info("Memory limit: {} MB", bytes / (1024 * 1024));
+    }
+}
+
+} // anonymous namespace
+
 Application::Application() 
-    : app_("FileVault", "Professional file encryption CLI tool") {
+    : app_("FileVault", "Professional file encryption CLI tool"),
+      phase_start_(std::chrono::steady_clock::now()) {
     // Require subcommand or show help
     app_.require_subcommand(0);
     app_.set_help_all_flag("--help-all", "Show all help");
@@ -34,18 +125,56 @@ Application::~Application() = default;
 void Application::initialize() {
     // Setup logging first
     setup_logging();
+    mark_phase("logging");
     
-    // Initialize crypto engine
-    engine_ = std::make_unique<core::CryptoEngine>();
-    engine_->initialize();
+    // Botan reads its CPU feature mask once, so apply it before any crypto.
+    // Commands read the same parsed config (and profile) later on.
+    const auto& config = utils::Config::current();
+    core::CpuFeatures::disable_features(config.get_cpu_disabled_features());
+    utils::IoBackend::set_default(utils::IoBackend::parse(config.get_io_backend()).value_or(utils::IoBackendType::AUTO));
+    apply_memory_limit(uint64_t{config.get_max_memory_mb()} * 1024 * 1024);
+    core::BufferPool::shared().set_huge_pages(config.get_huge_pages());
+    core::Offload::configure(core::Offload::parse_mode(config.get_crypto_offload()).value_or(core::OffloadMode::OFF));
+    if (!config.get_profile().empty()) {
+        spdlog::info("Performance profile: {}", config.get_profile());
+    }
+    mark_phase("config");
     
     // Setup global options
     app_.add_flag("-v,--verbose", verbose_, "Verbose output");
     app_.add_option("--log-level", log_level_, "Log level (debug, info, warn, error)")
         ->check(CLI::IsMember({"debug", "info", "warn", "error"}));
-    
-    // Register commands
-    register_commands();
+    app_.add_flag("--profile-startup", profile_startup_, "Print a startup time breakdown to stderr");
+    app_.add_option("--trace", trace_file_,
+                    "Write KDF/compression/cipher/I/O spans as Chrome trace-event JSON (chrome://tracing, Perfetto)");
+    app_.add_option("--stats", stats_format_,
+                    "Print run metrics (bytes, stage times, throughput, peak RSS) to stderr when done")
+        ->check(CLI::IsMember({"json"}));
+    app_.add_flag("--numa", numa_,
+                  "NUMA-aware placement: workers spread over nodes, buffers on the worker's node");
+    // Applied as soon as it is parsed, before the command runs
+    app_.add_option_function<uint64_t>("--max-memory", [](const uint64_t& bytes) { apply_memory_limit(bytes); },
+                                       "Memory limit for chunk buffers, key derivations and caches "
+                                       "(e.g. 1G; overrides memory.max_mb)")
+        ->transform(CLI::AsSizeValue(false));
+    app_.add_option_function<uint64_t>("--rate-limit",
+                                       [](const uint64_t& bytes) {
+                                           utils::RateLimiter::reads().set_rate(bytes);
+                                           utils::RateLimiter::writes().set_rate(bytes);
+                                       },
+                                       "Cap streaming reads and writes, each, at this many bytes per second "
+                                       "(e.g. 200M)")
+        ->transform(CLI::AsSizeValue(false));
+    app_.add_option_function<std::string>("--offload",
+                                          [](const std::string& mode) {
+                                              core::Offload::configure(*core::Offload::parse_mode(mode));
+                                          },
+                                          "Run AES-GCM/CTR and ChaCha20 keystreams of large messages on a GPU "
+                                          "(off, auto, opencl; overrides crypto.offload)")
+        ->check(CLI::IsMember({"off", "auto", "opencl"}));
+    app_.add_flag("--background", background_,
+                  "Lowest CPU and I/O priority (nice 19, idle I/O class) for jobs on busy hosts");
+    mark_phase("global options");
     
     spdlog::info("FileVault initialized");
 }
@@ -74,7 +203,41 @@ int Application::run(int argc, char** argv) {
             spdlog::set_level(spdlog::level::info);
         }
         
+        // Only the selected command is constructed and set up
+        std::string selected = find_subcommand(argc, argv, profile_startup_, trace_file_, stats_format_, numa_,
+                                               background_);
+        command_name_ = selected;
+        
+        // Threads inherit the priority when created, so lower it before any is
+        if (background_) {
+            std::string detail;
+            if (utils::enter_background_mode(detail)) {
+                spdlog::info("Background priority: {}", detail);
+            } else {
+                utils::Console::warning("Cannot lower priority: " + detail);
+            }
+        }
+        
+        // The shared executor and buffer pool read it when first used
+        if (numa_) {
+            core::Numa::set_enabled(true);
+        }
+        
+        // Commands run inside parse(), so spans have to be on before it;
+        // --stats takes its stage times from them too
+        if (!trace_file_.empty() || stats_format_ == "json") {
+            utils::Tracer::instance().start();
+        }
+        run_start_ = std::chrono::steady_clock::now();
+        register_commands(selected);
+        mark_phase("commands");
+        
+        if (commands_.size() == 1) {
+            app_.get_subcommand(selected)->parse_complete_callback([this] { mark_phase("parse"); });
+        }
+        
         app_.parse(argc, argv);
+        mark_phase(commands_.size() == 1 ? "execute" : "parse");
         
         // Apply logging settings after parse
         if (verbose_) {
@@ -91,10 +254,17 @@ int Application::run(int argc, char** argv) {
             std::cout << app_.help() << std::endl;
         }
         
+        print_startup_profile();
+        print_run_stats(0);
+        write_trace();
         return 0;
         
     } catch (const CLI::RuntimeError& e) {
         // Command execution failed - return the error code
+        mark_phase("execute");
+        print_startup_profile();
+        print_run_stats(e.get_exit_code());
+        write_trace();
         return e.get_exit_code();
     } catch (const CLI::ParseError& e) {
         return app_.exit(e);
@@ -104,23 +274,57 @@ int Application::run(int argc, char** argv) {
     }
 }
 
-void Application::register_commands() {
-    commands_.push_back(std::make_unique<EncryptCommand>(*engine_));
-    commands_.push_back(std::make_unique<DecryptCommand>(*engine_));
-    commands_.push_back(std::make_unique<HashCommand>(*engine_));
-    commands_.push_back(std::make_unique<ListCommand>(*engine_));
-    commands_.push_back(std::make_unique<BenchmarkCommand>(*engine_));
-    commands_.push_back(std::make_unique<ConfigCommand>());
-    commands_.push_back(std::make_unique<InfoCommand>(*engine_));
-    commands_.push_back(std::make_unique<CompressCommand>());
-    commands_.push_back(std::make_unique<DecompressCommand>());
-    commands_.push_back(std::make_unique<commands::StegoCommand>());
-    commands_.push_back(std::make_unique<commands::ArchiveCommand>(*engine_));
-    commands_.push_back(std::make_unique<KeygenCommand>(*engine_));
-    commands_.push_back(std::make_unique<commands::DumpCommand>());
-    commands_.push_back(std::make_unique<commands::SignCommand>(*engine_));
-    commands_.push_back(std::make_unique<commands::VerifyCommand>(*engine_));
-    commands_.push_back(std::make_unique<commands::KeyInfoCommand>(*engine_));
+std::vector<std::pair<std::string, Application::CommandFactory>> Application::command_factories() {
+    return {
+        {"encrypt",    [this] { return std::make_unique<EncryptCommand>(engine()); }},
+        {"decrypt",    [this] { return std::make_unique<DecryptCommand>(engine()); }},
+        {"hash",       [this] { return std::make_unique<HashCommand>(engine()); }},
+        {"list",       [this] { return std::make_unique<ListCommand>(engine()); }},
+        {"benchmark",  [this] { return std::make_unique<BenchmarkCommand>(engine()); }},
+        {"config",     [] { return std::make_unique<ConfigCommand>(); }},
+        {"info",       [this] { return std::make_unique<InfoCommand>(engine()); }},
+        {"compress",   [] { return std::make_unique<CompressCommand>(); }},
+        {"decompress", [] { return std::make_unique<DecompressCommand>(); }},
+        {"stego",      [] { return std::make_unique<commands::StegoCommand>(); }},
+        {"archive",    [this] { return std::make_unique<commands::ArchiveCommand>(engine()); }},
+        {"keygen",     [this] { return std::make_unique<KeygenCommand>(engine()); }},
+        {"dump",       [] { return std::make_unique<commands::DumpCommand>(); }},
+        {"sign",       [this] { return std::make_unique<commands::SignCommand>(engine()); }},
+        {"verify",     [this] { return std::make_unique<commands::VerifyCommand>(engine()); }},
+        {"rekey",      [this] { return std::make_unique<commands::RekeyCommand>(engine()); }},
+        {"keyinfo",    [this] { return std::make_unique<commands::KeyInfoCommand>(engine()); }},
+        {"dict",       [] { return std::make_unique<DictCommand>(); }},
+        {"dedup",      [] { return std::make_unique<DedupCommand>(); }},
+        {"crack",      [] { return std::make_unique<CrackCommand>(); }},
+        {"password-audit", [] { return std::make_unique<PasswordAuditCommand>(); }},
+        {"volume",     [] { return std::make_unique<VolumeCommand>(); }},
+        {"store",      [] { return std::make_unique<StoreCommand>(); }},
+        {"mount",      [] { return std::make_unique<MountCommand>(); }},
+        {"batch",      [this] { return std::make_unique<BatchCommand>(engine()); }},
+        {"watch",      [this] { return std::make_unique<WatchCommand>(engine()); }},
+        {"serve",      [this] {
+            return std::make_unique<ServeCommand>(
+                engine(), [this](const std::vector<std::string>& args) { return run_command(args); });
+        }},
+    };
+}
+
+void Application::register_commands(const std::string& selected) {
+    const auto factories = command_factories();
+    
+    for (const auto& [name, make] : factories) {
+        if (selected == name) {
+            commands_.push_back(make());
+            break;
+        }
+    }
+    
+    // Help, no command or an unknown name: CLI11 needs them all
+    if (commands_.empty()) {
+        for (const auto& [name, make] : factories) {
+            commands_.push_back(make());
+        }
+    }
     
     // Setup each command
     for (auto& cmd : commands_) {
@@ -130,8 +334,98 @@ void Application::register_commands() {
     spdlog::info("Registered {} commands", commands_.size());
 }
 
+int Application::run_command(const std::vector<std::string>& args) {
+    if (args.empty()) {
+        utils::Console::error("No command given");
+        return 1;
+    }
+    
+    std::unique_ptr<ICommand> command;
+    for (auto& [name, make] : command_factories()) {
+        if (name == args[0] && name != "serve") {
+            command = make();
+            break;
+        }
+    }
+    if (!command) {
+        utils::Console::error("Unknown command: " + args[0]);
+        return 1;
+    }
+    
+    CLI::App app("FileVault", "Professional file encryption CLI tool");
+    app.require_subcommand(1);
+    command->setup(app);
+    
+    // CLI11 takes the arguments in reverse order
+    std::vector<std::string> reversed(args.rbegin(), args.rend());
+    try {
+        app.parse(reversed);
+        return 0;
+    } catch (const CLI::RuntimeError& e) {
+        return e.get_exit_code();
+    } catch (const CLI::ParseError& e) {
+        return app.exit(e);
+    } catch (const std::exception& e) {
+        utils::Console::error(std::string("Fatal error: ") + e.what());
+        return 1;
+    }
+}
+
+core::CryptoEngine& Application::engine() {
+    if (!engine_) {
+        engine_ = std::make_unique<core::CryptoEngine>();
+        engine_->initialize();
+    }
+    return *engine_;
+}
+
+void Application::mark_phase(const std::string& phase) {
+    auto now = std::chrono::steady_clock::now();
+    phases_.emplace_back(phase, std::chrono::duration<double, std::milli>(now - phase_start_).count());
+    phase_start_ = now;
+}
+
+void Application::print_startup_profile() const {
+    if (!profile_startup_) {
+        return;
+    }
+    
+    double total = 0.0;
+    fmt::print(stderr, "Startup profile:\n");
+    for (const auto& [phase, ms] : phases_) {
+        fmt::print(stderr, "  {:<16} {:>9.3f} ms\n", phase, ms);
+        total += ms;
+    }
+    fmt::print(stderr, "  {:<16} {:>9.3f} ms\n", "total", total);
+}
+
+void Application::print_run_stats(int exit_code) const {
+    if (stats_format_ != "json" || command_name_.empty()) {
+        return;
+    }
+    
+    double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - run_start_).count();
+    // stderr, so it never mixes with data piped through stdout
+    fmt::print(stderr, "{}\n", utils::RunStats::instance().to_json(command_name_, exit_code, wall_ms));
+}
+
+void Application::write_trace() const {
+    if (trace_file_.empty()) {
+        return;
+    }
+    
+    auto& tracer = utils::Tracer::instance();
+    tracer.stop();
+    if (!tracer.write(trace_file_)) {
+        utils::Console::error("Failed to write trace: " + trace_file_);
+        return;
+    }
+    spdlog::info("Wrote {} trace spans to {}", tracer.spans().size(), trace_file_);
+}
+
 void Application::setup_logging() {
-    auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+    // Log to stderr so stdout stays clean when it carries encrypted data
+    auto console_sink = std::make_shared<spdlog::sinks::stderr_color_sink_mt>();
     auto logger = std::make_shared<spdlog::logger>("filevault", console_sink);
     
     spdlog::set_default_logger(logger);
@@ -1,25 +1,62 @@
 #include "filevault/cli/commands/archive_cmd.hpp"
 #include "filevault/archive/archive_format.hpp"
+#include "filevault/archive/directory_walker.hpp"
+#include "filevault/archive/incremental.hpp"
+#include "filevault/archive/tar_stream.hpp"
 #include "filevault/compression/compressor.hpp"
+#include "filevault/compression/selector.hpp"
 #include "filevault/utils/file_io.hpp"
 #include "filevault/utils/console.hpp"
+#include "filevault/utils/hash_cache.hpp"
 #include "filevault/utils/password.hpp"
+#include "filevault/utils/row_writer.hpp"
+#include "filevault/utils/run_stats.hpp"
 #include "filevault/core/file_format.hpp"
+#include "filevault/core/streaming.hpp"
+#include "filevault/core/thread_pool.hpp"
+#include "filevault/utils/config.hpp"
 #include <fmt/core.h>
+#include <algorithm>
 #include <filesystem>
+#include <fstream>
+#include <memory>
+#include <iostream>
 #include <chrono>
 
 namespace filevault::cli::commands {
 
 namespace fs = std::filesystem;
 
+namespace {
+constexpr size_t CHUNKS_PER_WORKER = 4;
+constexpr size_t MIN_ARCHIVE_CHUNK = 1024 * 1024;
+constexpr size_t TAR_BATCH_CHUNKS = 16;     // Chunks of members gathered per segment from a tar
+
+// Leading bytes of an index ID, enough to tell archives apart in messages
+std::string short_id(const archive::ContentHash& id) {
+    std::string hex;
+    for (size_t i = 0; i < 8; ++i) {
+        hex += fmt::format("{:02x}", id[i]);
+    }
+    return hex;
+}
+} // anonymous namespace
+
 void ArchiveCommand::setup(CLI::App& app) {
     auto* cmd = app.add_subcommand(name(), description());
     
     // Create mode
     auto* create_cmd = cmd->add_subcommand("create", "Create encrypted archive");
-    create_cmd->add_option("files", input_files_, "Files to archive")
-        ->required()
+    create_cmd->add_option("files", input_files_, "Files or directories to archive")
+        ->check(CLI::ExistingPath);
+    create_cmd->add_option("--from-tar", from_tar_,
+                           "Archive the members of a tar stream instead of files ('-' = stdin)");
+    create_cmd->add_option("-i,--include", include_,
+                           "Only archive files matching these globs (e.g. '*.cpp', 'src/**')");
+    create_cmd->add_option("-x,--exclude", exclude_,
+                           "Skip files and directories matching these globs (e.g. '.git', '*.o')");
+    create_cmd->add_option("--base", base_archive_,
+                           "Only pack members changed since this full archive (delta archive)")
         ->check(CLI::ExistingFile);
     create_cmd->add_option("-o,--output", output_file_, "Output archive file")
         ->required();
@@ -27,11 +64,23 @@ void ArchiveCommand::setup(CLI::App& app) {
     create_cmd->add_option("-a,--algorithm", algorithm_, "Encryption algorithm")
         ->check(CLI::IsMember({"aes-128-gcm", "aes-192-gcm", "aes-256-gcm", "chacha20-poly1305"}));
     create_cmd->add_option("-c,--compression", compression_, "Compression algorithm")
-        ->check(CLI::IsMember({"zlib", "bzip2", "lzma", "none"}));
+        ->check(CLI::IsMember({"zlib", "bzip2", "lzma", "zstd", "lz4", "none", "auto"}));
+    create_cmd->add_option("--compression-target", compression_target_mbps_,
+                           "Minimum compression speed in MB/s for -c auto (default 200)")
+        ->check(CLI::Range(1.0, 100000.0));
     create_cmd->add_option("-k,--kdf", kdf_, "Key derivation function")
         ->check(CLI::IsMember({"argon2id", "argon2i", "pbkdf2-sha256", "pbkdf2-sha512"}));
+    create_cmd->add_option("--kdf-parallelism", kdf_parallelism_,
+                           "Argon2 lanes hashed in parallel (default: from security level)")
+        ->check(CLI::Range(1, 64));
     create_cmd->add_option("-s,--security", security_level_, "Security level")
         ->check(CLI::IsMember({"weak", "medium", "strong", "paranoid"}));
+    create_cmd->add_option("-T,--threads", threads_,
+                           "Threads compressing and encrypting chunks (0 = one per core)");
+    create_cmd->add_flag("--cache", cache_,
+                         "Reuse content hashes of unchanged files; touched files are checked by XXH3 first");
+    create_cmd->add_flag("--appendable", appendable_,
+                         "Pad the archive to whole chunks so that 'archive append' can add members");
     create_cmd->add_flag("-v,--verbose", verbose_, "Verbose output");
     create_cmd->callback([this]() { 
         int exit_code = execute();
@@ -40,13 +89,49 @@ void ArchiveCommand::setup(CLI::App& app) {
         }
     });
     
+    // Append mode: encrypts only the new members, after the existing chunks
+    auto* append_cmd = cmd->add_subcommand("append", "Add files to an appendable archive in place");
+    append_cmd->add_option("archive", output_file_, "Archive created with --appendable")
+        ->required()
+        ->check(CLI::ExistingFile);
+    append_cmd->add_option("files", input_files_, "Files or directories to add")
+        ->required()
+        ->check(CLI::ExistingPath);
+    append_cmd->add_option("-i,--include", include_, "Only add files matching these globs");
+    append_cmd->add_option("-x,--exclude", exclude_, "Skip files and directories matching these globs");
+    append_cmd->add_option("-p,--password", password_, "Archive password");
+    append_cmd->add_option("-T,--threads", threads_,
+                           "Threads compressing and encrypting chunks (0 = one per core)");
+    append_cmd->add_flag("--cache", cache_,
+                         "Reuse content hashes of unchanged files; touched files are checked by XXH3 first");
+    append_cmd->add_flag("-v,--verbose", verbose_, "Verbose output");
+    append_cmd->callback([this]() {
+        append_ = true;
+        int exit_code = execute();
+        if (exit_code != 0) {
+            throw CLI::RuntimeError(exit_code);
+        }
+    });
+    
     // Extract mode
     auto* extract_cmd = cmd->add_subcommand("extract", "Extract encrypted archive");
     extract_cmd->add_option("archive", input_files_, "Archive file to extract")
         ->required()
         ->check(CLI::ExistingFile);
     extract_cmd->add_option("-o,--output", extract_dir_, "Output directory");
+    extract_cmd->add_option("-m,--member", members_,
+                            "Extract only these members; decrypts just their chunks");
+    extract_cmd->add_option("--to-tar", to_tar_,
+                            "Write the members as a tar stream instead of files ('-' = stdout)");
     extract_cmd->add_option("-p,--password", password_, "Decryption password");
+    extract_cmd->add_option("--base", base_archive_, "Full archive a delta archive was made against")
+        ->check(CLI::ExistingFile);
+    extract_cmd->add_option("-T,--threads", threads_,
+                            "Threads decrypting chunks and writing files (0 = one per core)");
+    extract_cmd->add_flag("--preallocate", preallocate_,
+                          "Reserve each file's full size before writing it");
+    extract_cmd->add_flag("--verify", verify_,
+                          "Check each member against its content hash as it is written");
     extract_cmd->add_flag("-v,--verbose", verbose_, "Verbose output");
     extract_cmd->callback([this]() { 
         extract_ = true;
@@ -56,34 +141,86 @@ void ArchiveCommand::setup(CLI::App& app) {
         }
     });
     
-    // List mode - TODO: Implement proper listing without extraction
+    // Verify mode: decrypts and hashes every member, writes nothing
+    auto* verify_cmd = cmd->add_subcommand("verify", "Check every member against its content hash");
+    verify_cmd->add_option("archive", input_files_, "Archive file")
+        ->required()
+        ->check(CLI::ExistingFile);
+    verify_cmd->add_option("-p,--password", password_, "Decryption password");
+    verify_cmd->add_option("-T,--threads", threads_, "Threads decrypting chunks (0 = one per core)");
+    verify_cmd->callback([this]() {
+        verify_only_ = true;
+        int exit_code = execute();
+        if (exit_code != 0) {
+            throw CLI::RuntimeError(exit_code);
+        }
+    });
+    
+    // List mode: decrypts only the entry table
     auto* list_cmd = cmd->add_subcommand("list", "List archive contents");
     list_cmd->add_option("archive", input_files_, "Archive file")
         ->required()
         ->check(CLI::ExistingFile);
     list_cmd->add_option("-p,--password", password_, "Decryption password");
+    list_cmd->add_flag("-v,--verbose", verbose_, "Show the chunks holding each member");
+    list_cmd->add_option("--format", list_format_,
+                         "Listing format: auto (a table on a terminal, else tsv), table, tsv, jsonl")
+        ->check(CLI::IsMember({"auto", "table", "tsv", "jsonl"}));
     
     list_cmd->callback([this]() { 
-        extract_ = true;
+        list_ = true;
         int exit_code = execute();
         if (exit_code != 0) {
             throw CLI::RuntimeError(exit_code);
         }
-    });  // Temporarily use extract
+    });
     cmd->footer(
         "Examples:\n"
         "  filevault archive create file1.txt file2.txt -o backup.fva     # Create archive\n"
         "  filevault archive create *.txt -o docs.fva -c lzma -s strong   # LZMA + strong security\n"
         "  filevault archive create data/ -o data.fva -a chacha20-poly1305  # ChaCha20 encryption\n"
+        "  filevault archive create src/ -o src.fva -x build -x '*.o'    # Directory tree with excludes\n"
+        "  filevault archive create src/ -o mon.fva --base full.fva      # Only what changed since full.fva\n"
+        "  filevault archive create logs/ -o logs.fva --appendable       # Members can be added later\n"
+        "  filevault archive append logs.fva today.log                   # Encrypt only the new member\n"
         "  filevault archive extract backup.fva -o extracted/            # Extract archive\n"
         "  filevault archive extract docs.fva -p MyPass -v               # Extract with password\n"
+        "  filevault archive extract big.fva -m notes.txt                # Extract a single member\n"
+        "  filevault archive extract mon.fva --base full.fva             # Restore a delta archive\n"
+        "  filevault archive verify backup.fva                           # Check members, write nothing\n"
+        "  tar c data/ | filevault archive create --from-tar - -o d.fva -p pw  # Archive a tar stream\n"
+        "  filevault archive extract d.fva --to-tar - -p pw | tar x      # Extract as a tar stream\n"
         "  filevault archive list backup.fva                             # List archive contents\n"
+        "  filevault archive list big.fva --format jsonl > members.jsonl  # Machine-readable listing\n"
     );
 
     cmd->require_subcommand(1);
 }
 
 int ArchiveCommand::execute() {
+    // stdout carries the tar; messages go to stderr
+    if (to_tar_ == "-") {
+        utils::Console::set_stream(stderr);
+    }
+    
+    // The performance profile fills in what the command line left open
+    const auto& config = utils::Config::current();
+    if (threads_ == 0) {
+        threads_ = config.get_threads();
+    }
+    if (compression_target_mbps_ <= 0) {
+        compression_target_mbps_ = config.get_compression_target_mbps();
+    }
+    
+    if (list_) {
+        return do_list();
+    }
+    if (verify_only_) {
+        return do_verify();
+    }
+    if (append_) {
+        return do_append();
+    }
     if (extract_) {
         return do_extract();
     } else {
@@ -92,21 +229,35 @@ int ArchiveCommand::execute() {
 }
 
 int ArchiveCommand::do_create() {
+    if (!from_tar_.empty()) {
+        return do_create_from_tar();
+    }
+    
     utils::Console::separator();
     fmt::print("\n{:^80}\n", "FileVault Archive Creation");
     utils::Console::separator();
     
-    // Validate input files
-    std::vector<fs::path> file_paths;
-    for (const auto& file : input_files_) {
-        if (!fs::exists(file)) {
-            utils::Console::error(fmt::format("File not found: {}", file));
-            return 1;
-        }
-        file_paths.push_back(file);
+    if (input_files_.empty()) {
+        utils::Console::error("No files to archive (name files or directories, or use --from-tar)");
+        return 1;
+    }
+    
+    // Walk the inputs: directories recursively, one stat per file
+    archive::WalkOptions walk_options;
+    walk_options.include = include_;
+    walk_options.exclude = exclude_;
+    walk_options.threads = threads_;
+    auto walk = archive::DirectoryWalker::walk(
+        std::vector<fs::path>(input_files_.begin(), input_files_.end()), walk_options);
+    for (const auto& error : walk.errors) {
+        utils::Console::warning(fmt::format("Skipped {}", error));
+    }
+    if (walk.members.empty()) {
+        utils::Console::error("No files to archive");
+        return 1;
     }
     
-    utils::Console::info(fmt::format("Files:       {} file(s)", file_paths.size()));
+    utils::Console::info(fmt::format("Files:       {} file(s)", walk.members.size()));
     utils::Console::info(fmt::format("Algorithm:   {}", algorithm_));
     utils::Console::info(fmt::format("Compression: {}", compression_));
     utils::Console::info(fmt::format("KDF:         {}", kdf_));
@@ -116,71 +267,223 @@ int ArchiveCommand::do_create() {
     // Show file list
     if (verbose_) {
         utils::Console::info("Input files:");
-        for (const auto& path : file_paths) {
-            auto size = fs::file_size(path);
-            utils::Console::info(fmt::format("  {} ({} bytes)", path.filename().string(), size));
+        for (const auto& member : walk.members) {
+            utils::Console::info(fmt::format("  {} ({} bytes)", member.entry.filename, member.entry.file_size));
         }
         utils::Console::separator();
     }
     
-    // Step 1: Create archive
+    // Get password (a base archive's index is read with it too)
+    if (password_.empty()) {
+        password_ = utils::Password::read_secure("Enter password for archive: ", true);
+        if (password_.empty()) {
+            utils::Console::error("Password required");
+            return 1;
+        }
+    }
+    
+    // Step 1: Against a base, keep only what changed; hash up front only
+    // what deduplication needs, the rest is hashed as it is archived
+    std::unique_ptr<utils::HashCache> hash_cache;
+    if (cache_) {
+        hash_cache = std::make_unique<utils::HashCache>(utils::Config::get_hash_cache_path());
+        hash_cache->load();
+    }
+    archive::ContentHash base_id{};
+    std::vector<std::string> unreadable;
+    if (!base_archive_.empty()) {
+        archive::ArchiveReader base;
+        if (open_base(base) != 0) {
+            return 1;
+        }
+        // Touched members are compared by content hash
+        auto loaded = base.load_digests();
+        if (!loaded.success) {
+            utils::Console::error(fmt::format("Cannot read base archive {}: {}", base_archive_, loaded.error_message));
+            return 1;
+        }
+        auto delta = archive::IncrementalPlanner::plan(walk.members, base.entries(), threads_,
+                                                       hash_cache.get());
+        unreadable = std::move(delta.errors);
+        base_id = base.index_id();
+        utils::Console::info(fmt::format(
+            "Delta against {}: {} unchanged, {} modified, {} added, {} removed ({} bytes to pack)",
+            base_archive_, delta.unchanged, delta.modified, delta.added, delta.removed, delta.packed_bytes));
+    }
+    auto failed = archive::IncrementalPlanner::hash_candidates(walk.members, threads_, hash_cache.get());
+    unreadable.insert(unreadable.end(), failed.begin(), failed.end());
+    if (!unreadable.empty()) {
+        for (const auto& path : unreadable) {
+            utils::Console::error(fmt::format("Cannot read {}", path));
+        }
+        return 1;
+    }
+    
+    // Step 2: Build the entry table; member data is read only as it is encrypted
     utils::Console::info("Creating archive...");
-    auto start_archive = std::chrono::high_resolution_clock::now();
     
-    std::vector<uint8_t> archive_data;
+    size_t member_count = walk.members.size();
+    std::unique_ptr<archive::ArchiveSource> source;
     try {
-        archive_data = archive::ArchiveFormat::create_archive(file_paths);
+        source = std::make_unique<archive::ArchiveSource>(std::move(walk.members), base_id);
     } catch (const std::exception& e) {
         utils::Console::error(fmt::format("Archive creation failed: {}", e.what()));
         return 1;
     }
+    std::istream archive_stream(source.get());
     
-    auto end_archive = std::chrono::high_resolution_clock::now();
-    auto archive_time = std::chrono::duration<double, std::milli>(end_archive - start_archive);
-    
-    utils::Console::success(fmt::format("Archive created ({} bytes)", archive_data.size()));
+    utils::Console::success(fmt::format("Archive: {} bytes", source->size()));
+    if (source->shared_count() > 0) {
+        utils::Console::info(fmt::format("Duplicates: {} file(s) share stored contents ({} bytes not stored again)",
+                                         source->shared_count(), source->shared_bytes()));
+    }
     
-    // Step 2: Compress (if requested)
-    std::vector<uint8_t> compressed_data;
-    if (compression_ != "none") {
-        utils::Console::info(fmt::format("Compressing with {}...", compression_));
-        auto start_compress = std::chrono::high_resolution_clock::now();
-        
-        auto comp_type = compression::CompressionService::parse_algorithm(compression_);
-        auto compressor = compression::CompressionService::create(comp_type);
-        
-        if (!compressor) {
-            utils::Console::error("Failed to create compressor");
+    // Step 3: Choose compression (applied per chunk while streaming)
+    int compression_level = 6;
+    if (compression_ == "auto") {
+        auto sample = compression::CompressionSelector::sample_stream(archive_stream, source->size());
+        archive_stream.clear();
+        archive_stream.seekg(0);
+        if (!sample) {
+            utils::Console::error(source->error().empty() ? sample.error_message : source->error());
             return 1;
         }
-        
-        auto compress_result = compressor->compress(archive_data, 6);
-        if (!compress_result.success) {
-            utils::Console::error(compress_result.error_message);
-            return 1;
+        auto choice = compression::CompressionSelector::select(sample.value, compression_target_mbps_);
+        compression_ = compression::CompressionService::get_algorithm_name(choice.type);
+        compression_level = choice.level;
+        utils::Console::info(fmt::format("Auto compression: {}", choice.type == core::CompressionType::NONE
+            ? std::string("none") : fmt::format("{} level {} ({:.2f}x on a sample)",
+                                                compression_, choice.level, choice.ratio)));
+    }
+    
+    // Step 4: Encrypt
+    auto algo_type_opt = engine_.parse_algorithm(algorithm_);
+    auto kdf_type_opt = engine_.parse_kdf(kdf_);
+    if (!algo_type_opt || !kdf_type_opt) {
+        utils::Console::error("Invalid algorithm or KDF");
+        return 1;
+    }
+    if (!core::StreamingCrypto::supports_algorithm(*algo_type_opt)) {
+        utils::Console::error(fmt::format("Archives support AEAD algorithms only, not {}", algorithm_));
+        return 1;
+    }
+    
+    // The stream header does not record the security level; decryption
+    // always derives the key with the strong profile
+    if (security_level_ != "strong" || kdf_parallelism_ > 0) {
+        utils::Console::info("Archives use the strong KDF profile");
+    }
+    
+    // Chunks are the unit of parallel work: keep several per worker, but
+    // not below 1 MB where per-chunk overhead starts to show
+    size_t workers = threads_ == 0 ? core::ThreadPool::default_thread_count() : threads_;
+    size_t max_chunk = utils::Config::current().get_streaming_chunk_mb() * 1024 * 1024;
+    size_t per_worker = static_cast<size_t>(source->size() / (workers * CHUNKS_PER_WORKER));
+    
+    core::StreamingConfig config;
+    config.chunk_size = std::min(max_chunk, std::max(per_worker, MIN_ARCHIVE_CHUNK));
+    if (appendable_) {
+        // Appends start a new segment at a chunk boundary
+        source->pad_to(config.chunk_size);
+    }
+    config.algorithm = *algo_type_opt;
+    config.kdf = *kdf_type_opt;
+    config.compression = compression::CompressionService::parse_algorithm(compression_);
+    config.compression_level = compression_level;
+    config.worker_threads = threads_;  // 0 = one per hardware thread
+    
+    std::ofstream output(output_file_, std::ios::binary);
+    if (!output) {
+        utils::Console::error("Failed to create output file: " + output_file_);
+        return 1;
+    }
+    
+    utils::Console::info(compression_ != "none"
+        ? fmt::format("Compressing with {} and encrypting...", compression_)
+        : std::string("Encrypting..."));
+    auto result = core::StreamingCrypto::encrypt_stream(archive_stream, output, password_,
+                                                        source->size(), config);
+    output.close();
+    if (hash_cache) {
+        if (result.success) {
+            archive::IncrementalPlanner::remember(*source, *hash_cache);
         }
-        
-        compressed_data = std::move(compress_result.data);
-        auto end_compress = std::chrono::high_resolution_clock::now();
-        auto compress_time = std::chrono::duration<double, std::milli>(end_compress - start_compress);
-        
-        double ratio = (double)compressed_data.size() / archive_data.size() * 100.0;
-        utils::Console::success(fmt::format("Compressed to {} bytes ({:.1f}%)", 
-                                           compressed_data.size(), ratio));
-        
-        if (verbose_) {
-            utils::Console::info(fmt::format("Compression time: {:.2f} ms", compress_time.count()));
+        auto saved = hash_cache->save();
+        if (!saved) {
+            utils::Console::warning(saved.error_message);
         }
-    } else {
-        compressed_data = archive_data;
-        utils::Console::info("Skipping compression");
     }
     
-    // Step 3: Encrypt
-    utils::Console::info("Encrypting...");
+    if (!result.success) {
+        // A member that changed mid-read explains the failure better
+        utils::Console::error(source->error().empty() ? result.error_message : source->error());
+        std::error_code ec;
+        fs::remove(output_file_, ec);
+        return 1;
+    }
+    
+    size_t final_size = utils::FileIO::file_size(output_file_);
+    auto& run_stats = utils::RunStats::instance();
+    run_stats.add_bytes(source->size(), final_size);
+    run_stats.add_files(member_count);
+    run_stats.add_chunks(result.chunks_processed);
+    
+    // Summary
+    utils::Console::separator();
+    utils::Console::success("Archive created successfully!");
+    utils::Console::info(fmt::format("Output:     {}", output_file_));
+    utils::Console::info(fmt::format("Size:       {} bytes", final_size));
+    
+    if (verbose_) {
+        if (config.compression != core::CompressionType::NONE) {
+            utils::Console::info(fmt::format("Chunks:     {} ({} compressed)",
+                                             result.chunks_processed, result.chunks_compressed));
+        }
+        utils::Console::info(fmt::format("Total time: {:.2f} ms ({:.2f} MB/s)",
+                                         result.processing_time_ms, result.throughput_mbps));
+    }
+    
+    return 0;
+}
+
+int ArchiveCommand::do_create_from_tar() {
+    utils::Console::separator();
+    fmt::print("\n{:^80}\n", "FileVault Archive Creation");
+    utils::Console::separator();
+    
+    bool from_stdin = from_tar_ == "-";
+    if (!input_files_.empty() || !base_archive_.empty() || appendable_) {
+        utils::Console::error("--from-tar takes no files and cannot be combined with --base or --appendable");
+        return 1;
+    }
+    if (compression_ == "auto") {
+        // Sampling would need a second pass over the tar
+        utils::Console::error("-c auto samples the input; name a compression algorithm with --from-tar");
+        return 1;
+    }
     
-    // Get password
+    auto algo_type_opt = engine_.parse_algorithm(algorithm_);
+    auto kdf_type_opt = engine_.parse_kdf(kdf_);
+    if (!algo_type_opt || !kdf_type_opt) {
+        utils::Console::error("Invalid algorithm or KDF");
+        return 1;
+    }
+    if (!core::StreamingCrypto::supports_algorithm(*algo_type_opt)) {
+        utils::Console::error(fmt::format("Archives support AEAD algorithms only, not {}", algorithm_));
+        return 1;
+    }
+    
+    utils::Console::info(fmt::format("Tar:         {}", from_stdin ? "<stdin>" : from_tar_));
+    utils::Console::info(fmt::format("Algorithm:   {}", algorithm_));
+    utils::Console::info(fmt::format("Compression: {}", compression_));
+    utils::Console::separator();
+    
+    // The prompt would read from the tar
     if (password_.empty()) {
+        if (from_stdin) {
+            utils::Console::error("Reading the tar from stdin needs --password");
+            return 1;
+        }
         password_ = utils::Password::read_secure("Enter password for archive: ", true);
         if (password_.empty()) {
             utils::Console::error("Password required");
@@ -188,124 +491,231 @@ int ArchiveCommand::do_create() {
         }
     }
     
-    auto start_encrypt = std::chrono::high_resolution_clock::now();
+    std::ifstream tar_file;
+    std::istream* tar = &std::cin;
+    if (from_stdin) {
+        utils::FileIO::set_binary_stdio();
+    } else {
+        tar_file.open(from_tar_, std::ios::binary);
+        if (!tar_file) {
+            utils::Console::error("Cannot open file: " + from_tar_);
+            return 1;
+        }
+        tar = &tar_file;
+    }
     
-    // Parse algorithm
-    auto algo_type_opt = engine_.parse_algorithm(algorithm_);
-    if (!algo_type_opt) {
-        utils::Console::error(fmt::format("Unknown algorithm: {}", algorithm_));
+    // The length is unknown up front, so chunks are the profile's size;
+    // batches of members span several of them to keep the padding small
+    size_t max_chunk = utils::Config::current().get_streaming_chunk_mb() * 1024 * 1024;
+    core::StreamingConfig config;
+    config.chunk_size = std::max(max_chunk, MIN_ARCHIVE_CHUNK);
+    config.algorithm = *algo_type_opt;
+    config.kdf = *kdf_type_opt;
+    config.compression = compression::CompressionService::parse_algorithm(compression_);
+    config.worker_threads = threads_;
+    
+    archive::TarSource source(*tar, config.chunk_size,
+                              std::max(archive::TarSource::DEFAULT_BATCH_BYTES, TAR_BATCH_CHUNKS * config.chunk_size));
+    std::istream archive_stream(&source);
+    
+    std::ofstream output(output_file_, std::ios::binary);
+    if (!output) {
+        utils::Console::error("Failed to create output file: " + output_file_);
         return 1;
     }
-    auto algo_type = algo_type_opt.value();
     
-    // Parse KDF and security level
-    auto kdf_type_opt = engine_.parse_kdf(kdf_);
-    auto sec_level_opt = engine_.parse_security_level(security_level_);
+    utils::Console::info("Translating, compressing and encrypting...");
+    auto result = core::StreamingCrypto::encrypt_stream(archive_stream, output, password_, config);
+    output.close();
     
-    if (!kdf_type_opt || !sec_level_opt) {
-        utils::Console::error("Invalid KDF or security level");
+    // A bad tar ends the archive stream early, which alone looks like its end
+    if (!result.success || !source.error().empty()) {
+        utils::Console::error(source.error().empty() ? result.error_message : source.error());
+        std::error_code ec;
+        fs::remove(output_file_, ec);
         return 1;
     }
     
-    auto kdf_type = kdf_type_opt.value();
-    auto sec_level = sec_level_opt.value();
-    
-    // Setup encryption config
-    core::EncryptionConfig config;
-    config.algorithm = algo_type;
-    config.kdf = kdf_type;
-    config.level = sec_level;
-    config.apply_security_level();
-    config.compression = compression_ != "none" ? core::CompressionType::ZLIB : core::CompressionType::NONE;
+    for (const auto& name : source.skipped()) {
+        if (verbose_) {
+            utils::Console::warning(fmt::format("Skipped {} (not a regular file)", name));
+        }
+    }
+    if (!source.skipped().empty() && !verbose_) {
+        utils::Console::warning(fmt::format("Skipped {} link(s) and special file(s); -v lists them",
+                                            source.skipped().size()));
+    }
     
-    // Generate salt and derive key
-    auto salt = engine_.generate_salt(32);
-    auto key = engine_.derive_key(password_, salt, config);
-    auto nonce = engine_.generate_nonce(12);
-    config.nonce = nonce;
+    size_t final_size = utils::FileIO::file_size(output_file_);
+    auto& run_stats = utils::RunStats::instance();
+    run_stats.add_bytes(source.member_bytes(), final_size);
+    run_stats.add_files(source.member_count());
+    run_stats.add_chunks(result.chunks_processed);
     
-    // Get algorithm and encrypt
-    auto* algorithm = engine_.get_algorithm(algo_type);
-    if (!algorithm) {
-        utils::Console::error("Failed to get algorithm");
-        return 1;
+    utils::Console::separator();
+    utils::Console::success("Archive created successfully!");
+    utils::Console::info(fmt::format("Output:     {}", output_file_));
+    utils::Console::info(fmt::format("Members:    {} ({} bytes)", source.member_count(), source.member_bytes()));
+    utils::Console::info(fmt::format("Size:       {} bytes", final_size));
+    if (verbose_) {
+        utils::Console::info(fmt::format("Segments:   {}", source.segments()));
+        utils::Console::info(fmt::format("Total time: {:.2f} ms ({:.2f} MB/s)",
+                                         result.processing_time_ms, result.throughput_mbps));
     }
     
-    auto encrypt_result = algorithm->encrypt(compressed_data, key, config);
-    
-    auto end_encrypt = std::chrono::high_resolution_clock::now();
-    auto encrypt_time = std::chrono::duration<double, std::milli>(end_encrypt - start_encrypt);
+    return 0;
+}
+
+int ArchiveCommand::do_append() {
+    utils::Console::separator();
+    fmt::print("\n{:^80}\n", "FileVault Archive Append");
+    utils::Console::separator();
     
-    if (!encrypt_result.success) {
-        utils::Console::error(encrypt_result.error_message);
+    archive::WalkOptions walk_options;
+    walk_options.include = include_;
+    walk_options.exclude = exclude_;
+    walk_options.threads = threads_;
+    auto walk = archive::DirectoryWalker::walk(
+        std::vector<fs::path>(input_files_.begin(), input_files_.end()), walk_options);
+    for (const auto& error : walk.errors) {
+        utils::Console::warning(fmt::format("Skipped {}", error));
+    }
+    if (walk.members.empty()) {
+        utils::Console::error("No files to append");
         return 1;
     }
+    utils::Console::info(fmt::format("Archive: {}", output_file_));
+    utils::Console::info(fmt::format("Files:   {} file(s)", walk.members.size()));
+    utils::Console::separator();
     
-    utils::Console::success(fmt::format("Encrypted ({} bytes)", encrypt_result.data.size()));
+    if (password_.empty()) {
+        password_ = utils::Password::read_secure("Enter archive password: ", false);
+        if (password_.empty()) {
+            utils::Console::error("Password required");
+            return 1;
+        }
+    }
     
-    // Create file header and write encrypted file
-    auto header = core::FileFormatHandler::create_header(
-        algo_type, kdf_type, config, salt, nonce, compression_ != "none"
-    );
+    // The index says whether the archive is padded and which names are taken
+    size_t chunk_size = 0;
+    size_t replaced = 0;
+    size_t segments = 0;
+    {
+        archive::ArchiveReader reader;
+        auto opened = reader.open(output_file_, password_);
+        if (!opened.success) {
+            utils::Console::error(fmt::format("Decryption failed: {}", opened.error_message));
+            return 1;
+        }
+        if (!reader.appendable()) {
+            utils::Console::error(fmt::format(
+                "{} was not created with --appendable; recreate it to add members in place", output_file_));
+            return 1;
+        }
+        for (const auto& member : walk.members) {
+            if (reader.find(member.entry.filename)) {
+                replaced++;
+                if (verbose_) {
+                    utils::Console::info(fmt::format("  {} replaces the archived copy", member.entry.filename));
+                }
+            }
+        }
+        chunk_size = reader.stream().chunk_size();
+        segments = reader.segments();
+    }
     
-    // Get auth tag for AEAD algorithms
-    std::vector<uint8_t> auth_tag;
-    if (encrypt_result.tag.has_value()) {
-        auth_tag = encrypt_result.tag.value();
+    std::unique_ptr<utils::HashCache> hash_cache;
+    if (cache_) {
+        hash_cache = std::make_unique<utils::HashCache>(utils::Config::get_hash_cache_path());
+        hash_cache->load();
+    }
+    auto unreadable = archive::IncrementalPlanner::hash_candidates(walk.members, threads_, hash_cache.get());
+    if (!unreadable.empty()) {
+        for (const auto& path : unreadable) {
+            utils::Console::error(fmt::format("Cannot read {}", path));
+        }
+        return 1;
     }
     
-    // Write encrypted archive
-    core::FileFormatHandler::write_file(
-        output_file_, header, encrypt_result.data, auth_tag
-    );
+    // The new members form one more segment, padded like the first
+    size_t member_count = walk.members.size();
+    std::unique_ptr<archive::ArchiveSource> source;
+    try {
+        source = std::make_unique<archive::ArchiveSource>(std::move(walk.members));
+    } catch (const std::exception& e) {
+        utils::Console::error(fmt::format("Archive creation failed: {}", e.what()));
+        return 1;
+    }
+    source->pad_to(chunk_size);
+    std::istream segment_stream(source.get());
+    if (source->shared_count() > 0) {
+        utils::Console::info(fmt::format("Duplicates: {} file(s) share stored contents ({} bytes not stored again)",
+                                         source->shared_count(), source->shared_bytes()));
+    }
     
-    std::vector<uint8_t> final_data; // Just for size reporting
-    auto file_result = utils::FileIO::read_file(output_file_);
-    if (file_result.success) {
-        final_data = file_result.value;
+    utils::Console::info("Encrypting the new members...");
+    size_t old_size = utils::FileIO::file_size(output_file_);
+    auto result = core::StreamingCrypto::append_stream(output_file_, password_, segment_stream,
+                                                       source->size(), threads_);
+    if (hash_cache) {
+        if (result.success) {
+            archive::IncrementalPlanner::remember(*source, *hash_cache);
+        }
+        auto saved = hash_cache->save();
+        if (!saved) {
+            utils::Console::warning(saved.error_message);
+        }
+    }
+    if (!result.success) {
+        utils::Console::error(source->error().empty() ? result.error_message : source->error());
+        return 1;
     }
     
-    // Summary
-    utils::Console::separator();
-    utils::Console::success("Archive created successfully!");
-    utils::Console::info(fmt::format("Output:     {}", output_file_));
-    utils::Console::info(fmt::format("Size:       {} bytes", final_data.size()));
+    auto& run_stats = utils::RunStats::instance();
+    run_stats.add_bytes(source->size(), utils::FileIO::file_size(output_file_) - old_size);
+    run_stats.add_files(member_count);
+    run_stats.add_chunks(result.chunks_processed - result.chunks_resumed);
     
+    utils::Console::separator();
+    utils::Console::success(fmt::format("Appended {} file(s) to {} (segment {})",
+                                        member_count, output_file_, segments + 1));
+    if (replaced > 0) {
+        utils::Console::info(fmt::format("{} of them replace archived members of the same name", replaced));
+    }
     if (verbose_) {
-        auto total_time = archive_time.count() + encrypt_time.count();
-        if (compression_ != "none") {
-            // Add compression time if we tracked it
-        }
-        utils::Console::info(fmt::format("Total time: {:.2f} ms", total_time));
+        utils::Console::info(fmt::format("Encrypted {} new chunk(s); {} existing chunk(s) left untouched",
+                                         result.chunks_processed - result.chunks_resumed,
+                                         result.chunks_resumed));
     }
     
     return 0;
 }
 
 int ArchiveCommand::do_extract() {
-    utils::Console::separator();
-    fmt::print("\n{:^80}\n", "FileVault Archive Extraction");
-    utils::Console::separator();
-    
     if (input_files_.empty()) {
         utils::Console::error("No archive file specified");
         return 1;
     }
+    if (!to_tar_.empty()) {
+        return do_export_tar(input_files_[0]);
+    }
+    
+    utils::Console::separator();
+    fmt::print("\n{:^80}\n", "FileVault Archive Extraction");
+    utils::Console::separator();
     
     std::string archive_file = input_files_[0];
     utils::Console::info(fmt::format("Archive: {}", archive_file));
     utils::Console::info(fmt::format("Output:  {}", extract_dir_));
     utils::Console::separator();
     
-    // Step 1: Read encrypted archive
-    auto file_result = utils::FileIO::read_file(archive_file);
-    if (!file_result.success) {
-        utils::Console::error(file_result.error_message);
+    // Step 1: Check encrypted archive (parsed below by FileFormatHandler)
+    if (!utils::FileIO::file_exists(archive_file)) {
+        utils::Console::error("Cannot open file: " + archive_file);
         return 1;
     }
     
-    auto encrypted_data = file_result.value;
-    utils::Console::info(fmt::format("Read {} bytes", encrypted_data.size()));
+    utils::Console::info(fmt::format("Read {} bytes", utils::FileIO::file_size(archive_file)));
     
     // Step 2: Decrypt
     if (password_.empty()) {
@@ -316,6 +726,54 @@ int ArchiveCommand::do_extract() {
         }
     }
     
+    // Archives are streaming files; older ones were sealed in one piece
+    if (core::StreamingCrypto::is_streaming_file(archive_file)) {
+        return do_extract_streaming(archive_file);
+    }
+    
+    if (!members_.empty()) {
+        utils::Console::error("Selecting members needs an archive in the streaming format");
+        return 1;
+    }
+    
+    std::vector<uint8_t> archive_data;
+    if (decrypt_legacy(archive_file, archive_data) != 0) {
+        return 1;
+    }
+    
+    // Step 4: Extract archive
+    utils::Console::info("Extracting files...");
+    
+    bool success = archive::ArchiveFormat::extract_archive(
+        archive_data, extract_dir_, {threads_, preallocate_});
+    if (!success) {
+        utils::Console::error("Failed to extract archive");
+        return 1;
+    }
+    
+    // Show extracted files
+    auto entries = archive::ArchiveFormat::list_files(archive_data);
+    uint64_t extracted_bytes = 0;
+    for (const auto& entry : entries) {
+        extracted_bytes += entry.file_size;
+    }
+    utils::RunStats::instance().add_bytes(utils::FileIO::file_size(archive_file), extracted_bytes);
+    utils::RunStats::instance().add_files(entries.size());
+    
+    utils::Console::separator();
+    utils::Console::success(fmt::format("Extracted {} file(s) to {}", entries.size(), extract_dir_));
+    
+    if (verbose_) {
+        utils::Console::info("\nExtracted files:");
+        for (const auto& entry : entries) {
+            utils::Console::info(fmt::format("  {} ({} bytes)", entry.filename, entry.file_size));
+        }
+    }
+    
+    return 0;
+}
+
+int ArchiveCommand::decrypt_legacy(const std::string& archive_file, std::vector<uint8_t>& archive_data) {
     utils::Console::info("Decrypting...");
     
     // Read encrypted file format
@@ -333,6 +791,12 @@ int ArchiveCommand::do_extract() {
         utils::Console::info(fmt::format("Auth tag: {} bytes", auth_tag.size()));
     }
     
+    if (header.nonce.size() > core::ShortBytes::capacity() ||
+        auth_tag.size() > core::ShortBytes::capacity()) {
+        utils::Console::error("Invalid archive header: nonce or tag too long");
+        return 1;
+    }
+    
     // Setup config
     core::EncryptionConfig config;
     config.algorithm = algo_type;
@@ -404,38 +868,17 @@ int ArchiveCommand::do_extract() {
     auto decrypted_data = decrypt_result.data;
     utils::Console::success(fmt::format("Decrypted ({} bytes)", decrypted_data.size()));
     
-    // Step 3: Decompress (auto-detect)
-    std::vector<uint8_t> archive_data;
-    
+    // Decompress (auto-detect)
     // Try to detect if it's compressed by checking magic bytes
+    // "-c auto" may have picked any algorithm, so match every supported magic
     if (decrypted_data.size() >= 2) {
-        bool is_compressed = false;
-        std::string compression_type;
+        auto detected = compression::CompressionService::detect(decrypted_data);
         
-        // zlib
-        if (decrypted_data[0] == 0x78 && 
-            (decrypted_data[1] == 0x9C || decrypted_data[1] == 0x01 || decrypted_data[1] == 0xDA)) {
-            is_compressed = true;
-            compression_type = "zlib";
-        }
-        // bzip2
-        else if (decrypted_data[0] == 0x42 && decrypted_data[1] == 0x5A) {
-            is_compressed = true;
-            compression_type = "bzip2";
-        }
-        // lzma/xz
-        else if (decrypted_data.size() >= 4 && 
-                 decrypted_data[0] == 0xFD && decrypted_data[1] == 0x37 && 
-                 decrypted_data[2] == 0x7A && decrypted_data[3] == 0x58) {
-            is_compressed = true;
-            compression_type = "lzma";
-        }
-        
-        if (is_compressed) {
-            utils::Console::info(fmt::format("Decompressing (detected: {})...", compression_type));
+        if (detected) {
+            utils::Console::info(fmt::format("Decompressing (detected: {})...",
+                                             compression::CompressionService::get_algorithm_name(*detected)));
             
-            auto comp_type = compression::CompressionService::parse_algorithm(compression_type);
-            auto compressor = compression::CompressionService::create(comp_type);
+            auto compressor = compression::CompressionService::create(*detected);
             
             if (!compressor) {
                 utils::Console::error("Failed to create decompressor");
@@ -457,22 +900,91 @@ int ArchiveCommand::do_extract() {
         archive_data = decrypted_data;
     }
     
-    // Step 4: Extract archive
-    utils::Console::info("Extracting files...");
+    return 0;
+}
+
+int ArchiveCommand::do_extract_streaming(const std::string& archive_file) {
+    if (!members_.empty()) {
+        return extract_members(archive_file);
+    }
     
-    bool success = archive::ArchiveFormat::extract_archive(archive_data, extract_dir_);
-    if (!success) {
-        utils::Console::error("Failed to extract archive");
+    // A delta's unchanged members come from its base; open that first so
+    // a wrong or unreadable base is reported before anything is written
+    archive::ArchiveReader base;
+    if (!base_archive_.empty() && open_base(base) != 0) {
         return 1;
     }
     
-    // Show extracted files
-    auto entries = archive::ArchiveFormat::list_files(archive_data);
+    utils::Console::info("Decrypting and extracting...");
+    
+    std::ifstream input(archive_file, std::ios::binary);
+    if (!input) {
+        utils::Console::error("Cannot open file: " + archive_file);
+        return 1;
+    }
+    
+    // Members are written out as their chunks are authenticated
+    archive::ArchiveSink sink(extract_dir_, {threads_, preallocate_, verify_});
+    std::ostream output(&sink);
+    auto result = core::StreamingCrypto::decrypt_stream(input, output, password_, nullptr, threads_);
+    
+    if (!result.success) {
+        utils::Console::error(sink.error().empty()
+            ? fmt::format("Decryption failed: {}", result.error_message)
+            : sink.error());
+        return 1;
+    }
+    if (!sink.finish()) {
+        utils::Console::error(fmt::format("Failed to extract archive: {}", sink.error()));
+        return 1;
+    }
+    
+    const auto& entries = sink.entries();
+    
+    std::vector<const archive::FileEntry*> from_base;
+    for (const auto& entry : entries) {
+        if (entry.in_base) {
+            from_base.push_back(&entry);
+        }
+    }
+    if (sink.header().is_delta()) {
+        if (base_archive_.empty()) {
+            utils::Console::error(fmt::format(
+                "This is a delta archive; {} unchanged member(s) need its full archive (--base)",
+                from_base.size()));
+            return 1;
+        }
+        if (base.index_id() != sink.header().base_id) {
+            utils::Console::error(fmt::format("{} is not the base of this archive (expected index {})",
+                                              base_archive_, short_id(sink.header().base_id)));
+            return 1;
+        }
+        if (extract_from_base(base, from_base) != 0) {
+            return 1;
+        }
+    } else if (!base_archive_.empty()) {
+        utils::Console::warning("Not a delta archive; --base ignored");
+    }
+    
+    uint64_t extracted_bytes = 0;
+    for (const auto& entry : entries) {
+        extracted_bytes += entry.file_size;
+    }
+    auto& run_stats = utils::RunStats::instance();
+    run_stats.add_bytes(utils::FileIO::file_size(archive_file), extracted_bytes);
+    run_stats.add_files(entries.size());
+    run_stats.add_chunks(result.chunks_processed);
     
     utils::Console::separator();
     utils::Console::success(fmt::format("Extracted {} file(s) to {}", entries.size(), extract_dir_));
+    if (!from_base.empty()) {
+        utils::Console::info(fmt::format("{} unchanged file(s) restored from {}", from_base.size(), base_archive_));
+    }
     
     if (verbose_) {
+        utils::Console::info(fmt::format("Decrypted {} bytes in {} chunk(s) ({:.2f} MB/s)",
+                                         result.bytes_processed, result.chunks_processed,
+                                         result.throughput_mbps));
         utils::Console::info("\nExtracted files:");
         for (const auto& entry : entries) {
             utils::Console::info(fmt::format("  {} ({} bytes)", entry.filename, entry.file_size));
@@ -482,148 +994,370 @@ int ArchiveCommand::do_extract() {
     return 0;
 }
 
-} // namespace filevault::cli::commands
-
-// Commented out do_list() - to be implemented later
-/*
-int ArchiveCommand::do_list() {
-    utils::Console::separator();
-    fmt::print("\n{:^80}\n", "FileVault Archive Contents");
+int ArchiveCommand::do_export_tar(const std::string& archive_file) {
+    bool to_stdout = to_tar_ == "-";
+    utils::Console::header("FileVault Archive Export");
+    utils::Console::info(fmt::format("Archive: {}", archive_file));
+    utils::Console::info(fmt::format("Tar:     {}", to_stdout ? "<stdout>" : to_tar_));
     utils::Console::separator();
     
-    if (input_files_.empty()) {
-        utils::Console::error("No archive file specified");
+    if (!members_.empty() || !base_archive_.empty()) {
+        utils::Console::error("--to-tar exports whole archives; it cannot be combined with -m or --base");
+        return 1;
+    }
+    if (!core::StreamingCrypto::is_streaming_file(archive_file)) {
+        utils::Console::error("Only archives in the streaming format can be exported as tar");
         return 1;
     }
     
-    auto archive_file = input_files_[0];
+    // The prompt would print into the tar
+    if (password_.empty()) {
+        if (to_stdout) {
+            utils::Console::error("Writing the tar to stdout needs --password");
+            return 1;
+        }
+        password_ = utils::Password::read_secure("Enter archive password: ", false);
+        if (password_.empty()) {
+            utils::Console::error("Password required");
+            return 1;
+        }
+    }
     
-    if (!fs::exists(archive_file)) {
-        utils::Console::error(fmt::format("Archive not found: {}", archive_file));
+    std::ifstream input(archive_file, std::ios::binary);
+    if (!input) {
+        utils::Console::error("Cannot open file: " + archive_file);
         return 1;
     }
+    std::ofstream tar_file;
+    std::ostream* tar = &std::cout;
+    if (to_stdout) {
+        utils::FileIO::set_binary_stdio();
+    } else {
+        tar_file.open(to_tar_, std::ios::binary | std::ios::trunc);
+        if (!tar_file) {
+            utils::Console::error("Failed to create output file: " + to_tar_);
+            return 1;
+        }
+        tar = &tar_file;
+    }
     
-    utils::Console::info(fmt::format("Archive: {}", archive_file));
-    utils::Console::separator();
-    
-    // Read archive file
-    auto file_result = utils::FileIO::read_binary_file(archive_file);
-    if (!file_result.has_value()) {
-        utils::Console::error(fmt::format("Failed to read archive: {}", file_result.error()));
+    // Members become tar entries as their chunks are authenticated
+    archive::TarSink sink(*tar);
+    std::ostream archive_out(&sink);
+    auto result = core::StreamingCrypto::decrypt_stream(input, archive_out, password_, nullptr, threads_);
+    bool ok = result.success && sink.finish();
+    if (!ok) {
+        utils::Console::error(!sink.error().empty() ? sink.error()
+                                                    : fmt::format("Decryption failed: {}", result.error_message));
+        if (!to_stdout) {
+            tar_file.close();
+            std::error_code ec;
+            fs::remove(to_tar_, ec);
+        }
         return 1;
     }
     
-    auto encrypted_data = file_result.value;
-    utils::Console::info(fmt::format("Read {} bytes", encrypted_data.size()));
+    uint64_t exported_bytes = 0;
+    for (const auto& entry : sink.entries()) {
+        exported_bytes += entry.file_size;
+    }
+    auto& run_stats = utils::RunStats::instance();
+    run_stats.add_bytes(utils::FileIO::file_size(archive_file), exported_bytes);
+    run_stats.add_files(sink.entries().size());
+    run_stats.add_chunks(result.chunks_processed);
     
-    // Get password
-    if (password_.empty()) {
-        password_ = utils::Password::read_secure("Enter archive password: ", false);
-        if (password_.empty()) {
-            utils::Console::error("Password required");
+    utils::Console::success(fmt::format("Exported {} member(s), {} bytes, as tar",
+                                        sink.entries().size(), exported_bytes));
+    if (verbose_) {
+        for (const auto& entry : sink.entries()) {
+            utils::Console::info(fmt::format("  {} ({} bytes)", entry.filename, entry.file_size));
+        }
+    }
+    return 0;
+}
+
+int ArchiveCommand::extract_members(const std::string& archive_file) {
+    utils::Console::info("Reading archive index...");
+    
+    archive::ArchiveReader reader;
+    auto opened = reader.open(archive_file, password_);
+    if (!opened.success) {
+        utils::Console::error(fmt::format("Decryption failed: {}", opened.error_message));
+        return 1;
+    }
+    
+    // Check every name first so a typo does not leave a partial extraction
+    std::vector<const archive::FileEntry*> selected;
+    for (const auto& name : members_) {
+        const auto* entry = reader.find(name);
+        if (!entry) {
+            utils::Console::error(fmt::format("No member named {} in the archive", name));
             return 1;
         }
+        selected.push_back(entry);
     }
     
-    utils::Console::info("Decrypting...");
+    std::vector<const archive::FileEntry*> from_base;
+    for (const auto* entry : selected) {
+        if (entry->in_base) {
+            from_base.push_back(entry);
+            continue;
+        }
+        std::string error;
+        if (!reader.extract(*entry, extract_dir_, error, verify_)) {
+            utils::Console::error(fmt::format("Failed to extract {}: {}", entry->filename, error));
+            return 1;
+        }
+        if (verbose_) {
+            utils::Console::info(fmt::format("  {} ({} bytes)", entry->filename, entry->file_size));
+        }
+    }
     
-    // Read encrypted file format
-    auto [header, ciphertext, auth_tag] = core::FileFormatHandler::read_file(archive_file);
+    if (!from_base.empty()) {
+        archive::ArchiveReader base;
+        if (base_archive_.empty()) {
+            utils::Console::error("Some members are in the base of this delta archive; pass it with --base");
+            return 1;
+        }
+        if (open_base(base) != 0) {
+            return 1;
+        }
+        if (base.index_id() != reader.header().base_id) {
+            utils::Console::error(fmt::format("{} is not the base of this archive (expected index {})",
+                                              base_archive_, short_id(reader.header().base_id)));
+            return 1;
+        }
+        if (extract_from_base(base, from_base) != 0) {
+            return 1;
+        }
+    }
     
-    // Parse algorithm and KDF from header
-    auto algo_type = core::FileFormatHandler::from_algorithm_id(header.algorithm);
-    auto kdf_type = core::FileFormatHandler::from_kdf_id(header.kdf);
+    uint64_t extracted_bytes = 0;
+    for (const auto* entry : selected) {
+        extracted_bytes += entry->file_size;
+    }
+    utils::RunStats::instance().add_bytes(utils::FileIO::file_size(archive_file), extracted_bytes);
+    utils::RunStats::instance().add_files(selected.size());
+    utils::RunStats::instance().add_chunks(reader.chunks_decrypted());
     
+    utils::Console::separator();
+    utils::Console::success(fmt::format("Extracted {} file(s) to {}", selected.size(), extract_dir_));
     if (verbose_) {
-        utils::Console::info(fmt::format("Algorithm: {}", engine_.algorithm_name(algo_type)));
-        utils::Console::info(fmt::format("KDF: {}", engine_.kdf_name(kdf_type)));
+        utils::Console::info(fmt::format("Decrypted {} chunk(s) including the index",
+                                         reader.chunks_decrypted()));
     }
     
-    // Setup config
-    core::EncryptionConfig config;
-    config.algorithm = algo_type;
-    config.kdf = kdf_type;
-    config.nonce = header.nonce;
-    config.tag = auth_tag;
+    return 0;
+}
+
+int ArchiveCommand::do_verify() {
+    utils::Console::header("FileVault Archive Verification");
+    std::string archive_file = input_files_[0];
+    utils::Console::info(fmt::format("Archive: {}", archive_file));
+    utils::Console::separator();
     
-    // Parse KDF params
-    if (kdf_type == core::KDFType::ARGON2ID || kdf_type == core::KDFType::ARGON2I) {
-        auto params = core::Argon2Params::deserialize(header.kdf_params);
-        config.kdf_memory_kb = params.memory_kb;
-        config.kdf_iterations = params.iterations;
-        config.kdf_parallelism = params.parallelism;
-    } else if (kdf_type == core::KDFType::PBKDF2_SHA256 || kdf_type == core::KDFType::PBKDF2_SHA512) {
-        auto params = core::PBKDF2Params::deserialize(header.kdf_params);
-        config.kdf_iterations = params.iterations;
+    if (!core::StreamingCrypto::is_streaming_file(archive_file)) {
+        utils::Console::error("Only archives in the streaming format record content hashes");
+        return 1;
+    }
+    if (password_.empty()) {
+        password_ = utils::Password::read_secure("Enter archive password: ", false);
+        if (password_.empty()) {
+            utils::Console::error("Password required");
+            return 1;
+        }
     }
     
-    // Derive key
-    auto key = engine_.derive_key(password_, header.salt, config);
+    std::ifstream input(archive_file, std::ios::binary);
+    if (!input) {
+        utils::Console::error("Cannot open file: " + archive_file);
+        return 1;
+    }
     
-    // Decrypt
-    auto* algorithm = engine_.get_algorithm(algo_type);
-    if (!algorithm) {
-        utils::Console::error("Algorithm not available");
+    // Every chunk is authenticated and every member hashed; nothing is written
+    archive::ExtractOptions options;
+    options.verify = true;
+    options.check_only = true;
+    archive::ArchiveSink sink({}, options);
+    std::ostream output(&sink);
+    auto result = core::StreamingCrypto::decrypt_stream(input, output, password_, nullptr, threads_);
+    if (!result.success) {
+        utils::Console::error(sink.error().empty()
+            ? fmt::format("Decryption failed: {}", result.error_message)
+            : sink.error());
+        return 1;
+    }
+    if (!sink.finish()) {
+        utils::Console::error(fmt::format("Verification failed: {}", sink.error()));
         return 1;
     }
     
-    auto decrypt_result = algorithm->decrypt(ciphertext, key, config);
-    if (!decrypt_result.success) {
-        utils::Console::error(decrypt_result.error_message);
+    const auto& entries = sink.entries();
+    auto in_base = static_cast<size_t>(std::count_if(entries.begin(), entries.end(),
+        [](const archive::FileEntry& entry) { return entry.in_base; }));
+    auto& run_stats = utils::RunStats::instance();
+    run_stats.add_bytes(utils::FileIO::file_size(archive_file), result.bytes_processed);
+    run_stats.add_files(entries.size());
+    run_stats.add_chunks(result.chunks_processed);
+    
+    utils::Console::success(fmt::format("{} member(s) intact; {} checked against their content hash",
+                                        entries.size() - in_base, sink.verified()));
+    if (in_base > 0) {
+        utils::Console::info(fmt::format("{} unchanged member(s) live in the base archive and were not checked",
+                                         in_base));
+    }
+    return 0;
+}
+
+int ArchiveCommand::do_list() {
+    utils::RowFormat format = utils::RowFormat::TABLE;
+    utils::RowWriter::parse_format(list_format_, stdout, format);
+    bool table = format == utils::RowFormat::TABLE;
+    if (!table) {
+        // stdout carries only the rows
+        utils::Console::set_stream(stderr);
+    } else {
+        utils::Console::separator();
+        fmt::print("\n{:^80}\n", "FileVault Archive Contents");
+        utils::Console::separator();
+    }
+    
+    if (input_files_.empty()) {
+        utils::Console::error("No archive file specified");
         return 1;
     }
     
-    auto decrypted_data = decrypt_result.data;
-    utils::Console::success(fmt::format("Decrypted ({} bytes)", decrypted_data.size()));
+    std::string archive_file = input_files_[0];
+    if (!utils::FileIO::file_exists(archive_file)) {
+        utils::Console::error("Cannot open file: " + archive_file);
+        return 1;
+    }
+    if (table) {
+        utils::Console::info(fmt::format("Archive: {}", archive_file));
+        utils::Console::separator();
+    }
     
-    // Decompress if needed
-    auto decompressed_data = decrypted_data;
-    auto compression_type = core::FileFormatHandler::from_compression_id(header.compression);
+    if (password_.empty()) {
+        password_ = utils::Password::read_secure("Enter archive password: ", false);
+        if (password_.empty()) {
+            utils::Console::error("Password required");
+            return 1;
+        }
+    }
     
-    if (compression_type != core::CompressionType::NONE) {
-        std::string compression_name = "zlib";
-        if (compression_type == core::CompressionType::ZLIB) compression_name = "zlib";
-        else if (compression_type == core::CompressionType::LZMA) compression_name = "lzma";
-        else if (compression_type == core::CompressionType::BZIP2) compression_name = "bzip2";
-        
-        utils::Console::info(fmt::format("Decompressing ({})...", compression_name));
-        
-        auto decompressor = compression::ICompressor::create(compression_name);
-        if (!decompressor) {
-            utils::Console::error("Decompression not available");
+    std::vector<archive::FileEntry> entries;
+    archive::ArchiveReader reader;
+    bool streaming = core::StreamingCrypto::is_streaming_file(archive_file);
+    if (streaming) {
+        // Only the chunks holding the entry table are decrypted
+        auto opened = reader.open(archive_file, password_);
+        if (!opened.success) {
+            utils::Console::error(fmt::format("Decryption failed: {}", opened.error_message));
             return 1;
         }
-        
-        auto decompress_result = decompressor->decompress(decrypted_data);
-        if (!decompress_result.success) {
-            utils::Console::error(decompress_result.error_message);
+        entries = reader.entries();
+    } else {
+        std::vector<uint8_t> archive_data;
+        if (decrypt_legacy(archive_file, archive_data) != 0) {
             return 1;
         }
-        
-        decompressed_data = decompress_result.data;
-        utils::Console::success(fmt::format("Decompressed ({} bytes)", decompressed_data.size()));
+        entries = archive::ArchiveFormat::list_files(archive_data);
     }
     
-    // Parse archive
-    auto entries = archive::ArchiveFormat::parse(decompressed_data);
-    if (entries.empty()) {
-        utils::Console::error("Failed to parse archive or archive is empty");
-        return 1;
+    if (table) {
+        utils::Console::separator();
+    }
+    if (streaming && reader.header().is_delta()) {
+        utils::Console::info(fmt::format("Delta archive of base index {}; members marked (base) are stored there",
+                                         short_id(reader.header().base_id)));
+    }
+    if (table) {
+        utils::Console::success(fmt::format("Archive contains {} file(s):\n", entries.size()));
     }
     
-    utils::Console::separator();
-    utils::Console::success(fmt::format("Archive contains {} file(s):\n", entries.size()));
+    // Rows are formatted into one buffer and written in blocks
+    bool chunk_column = verbose_ && streaming;
+    std::vector<utils::RowColumn> columns = {
+        {"name", 40, false, false},
+        {"size", 12, true, true},
+        {"base", 0, false, true},
+    };
+    if (chunk_column) {
+        columns.push_back({"chunks", 0, false, false});
+    }
+    utils::RowWriter writer(std::move(columns), format);
+    writer.header();
     
-    // Print file list with details
-    size_t total_size = 0;
+    uint64_t total_size = 0;
+    std::string size, chunks;
     for (const auto& entry : entries) {
         total_size += entry.file_size;
-        fmt::print("  {:40} {:>12} bytes\n", entry.filename, entry.file_size);
+        size = std::to_string(entry.file_size);
+        std::string_view base = entry.in_base ? (table ? "(base)" : "true") : (table ? "" : "false");
+        if (chunk_column) {
+            auto [first, last] = reader.chunk_range(entry);
+            chunks = first > last ? std::string("-")
+                   : first == last ? std::to_string(first)
+                   : fmt::format("{}-{}", first, last);
+            writer.row({entry.filename, size, base, chunks});
+        } else {
+            writer.row({entry.filename, size, base});
+        }
+    }
+    if (!writer.flush()) {
+        utils::Console::error("Failed to write the listing");
+        return 1;
     }
     
-    utils::Console::separator();
-    fmt::print("Total: {} file(s), {} bytes\n", entries.size(), total_size);
+    if (table) {
+        utils::Console::separator();
+        fmt::print("Total: {} file(s), {} bytes\n", entries.size(), total_size);
+    }
+    if (verbose_ && streaming) {
+        utils::Console::info(fmt::format("Index read from {} decrypted chunk(s)", reader.chunks_decrypted()));
+    }
     
     return 0;
 }
-*/
+
+int ArchiveCommand::open_base(archive::ArchiveReader& base) {
+    auto opened = base.open(base_archive_, password_);
+    if (!opened.success) {
+        utils::Console::error(fmt::format("Cannot read base archive {}: {}", base_archive_, opened.error_message));
+        return 1;
+    }
+    if (base.header().is_delta()) {
+        utils::Console::error(fmt::format("{} is itself a delta; deltas are made against a full archive",
+                                          base_archive_));
+        return 1;
+    }
+    return 0;
+}
+
+int ArchiveCommand::extract_from_base(archive::ArchiveReader& base,
+                                      const std::vector<const archive::FileEntry*>& entries) {
+    for (const auto* entry : entries) {
+        const auto* stored = base.find(entry->filename);
+        if (!stored || stored->file_size != entry->file_size) {
+            utils::Console::error(fmt::format("Base archive has no matching member {}", entry->filename));
+            return 1;
+        }
+        std::string error;
+        if (!base.extract(*stored, extract_dir_, error, verify_)) {
+            utils::Console::error(fmt::format("Failed to extract {} from the base: {}", entry->filename, error));
+            return 1;
+        }
+        // The delta's entry has the current timestamps and permissions
+        try {
+            archive::ArchiveFormat::restore_metadata(fs::path(extract_dir_) / entry->filename, *entry);
+        } catch (const std::exception&) {
+            // Contents are intact; timestamps are best effort
+        }
+        if (verbose_) {
+            utils::Console::info(fmt::format("  {} ({} bytes, from base)", entry->filename, entry->file_size));
+        }
+    }
+    return 0;
+}
+
+} // namespace filevault::cli::commands
@@ -0,0 +1,383 @@
+#include "filevault/cli/commands/batch_cmd.hpp"
+#include "filevault/cli/commands/hash_cmd.hpp"
+#include "filevault/compression/compressor.hpp"
+#include "filevault/core/streaming.hpp"
+#include "filevault/core/executor.hpp"
+#include "filevault/utils/checksum.hpp"
+#include "filevault/utils/console.hpp"
+#include "filevault/utils/file_io.hpp"
+#include "filevault/utils/io_backend.hpp"
+#include "filevault/utils/run_stats.hpp"
+#include <botan/hash.h>
+#include <botan/hex.h>
+#include <fmt/core.h>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+
+namespace filevault {
+namespace cli {
+
+namespace {
+
+// Jobs queued ahead of the workers, per worker; bounds memory for huge job files
+constexpr size_t QUEUE_DEPTH_PER_WORKER = 4;
+
+struct Job {
+    size_t line = 0;
+    nlohmann::json id;                  // Echoed in the result (null if absent)
+    std::string op;
+    std::string input;
+    std::string output;
+    std::string password;
+    std::string algorithm;              // Cipher, hash or compressor, by op
+    int level = 6;                      // Compression level
+    core::StreamingConfig config;       // Encrypt jobs
+    std::string error;                  // Set for a line that is not a valid job
+};
+
+std::string strip_suffix(const std::string& path, const std::string& suffix) {
+    if (path.size() > suffix.size() && path.ends_with(suffix)) {
+        return path.substr(0, path.size() - suffix.size());
+    }
+    return path + ".dec";
+}
+
+std::string compressed_extension(const std::string& algorithm) {
+    if (algorithm == "zlib") return ".zlib";
+    if (algorithm == "bzip2") return ".bz2";
+    if (algorithm == "lzma") return ".xz";
+    if (algorithm == "lz4") return ".lz4";
+    return ".zst";
+}
+
+/**
+ * @brief Parse one job line; problems are reported through Job::error
+ */
+Job parse_job(const std::string& text, size_t line, const std::string& default_password) {
+    Job job;
+    job.line = line;
+
+    auto json = nlohmann::json::parse(text, nullptr, false);
+    if (!json.is_object()) {
+        job.error = "Not a JSON object";
+        return job;
+    }
+
+    try {
+        job.id = json.value("id", nlohmann::json(nullptr));
+        job.op = json.value("op", "");
+        job.input = json.value("input", "");
+        job.output = json.value("output", "");
+        job.password = json.value("password", default_password);
+        job.level = json.value("level", 6);
+
+        if (job.input.empty()) {
+            job.error = "Missing \"input\"";
+            return job;
+        }
+
+        if (job.op == "encrypt") {
+            job.algorithm = json.value("algorithm", "aes-256-gcm");
+            auto algorithm = core::CryptoEngine::parse_algorithm(job.algorithm);
+            auto kdf = core::CryptoEngine::parse_kdf(json.value("kdf", "argon2id"));
+            auto level = core::CryptoEngine::parse_security_level(json.value("security", "medium"));
+            if (!algorithm || !core::StreamingCrypto::supports_algorithm(*algorithm)) {
+                job.error = "Unsupported algorithm for batch encryption: " + job.algorithm;
+            } else if (!kdf || !level) {
+                job.error = "Unknown kdf or security level";
+            } else {
+                job.config.algorithm = *algorithm;
+                job.config.kdf = *kdf;
+                job.config.level = *level;
+            }
+            if (json.contains("compression")) {
+                job.config.compression = compression::CompressionService::parse_algorithm(
+                    json["compression"].get<std::string>());
+                job.config.compression_level = job.level;
+            }
+            if (job.output.empty()) {
+                job.output = job.input + ".fvlt";
+            }
+        } else if (job.op == "decrypt") {
+            if (job.output.empty()) {
+                job.output = strip_suffix(job.input, ".fvlt");
+            }
+        } else if (job.op == "hash") {
+            job.algorithm = json.value("algorithm", "sha256");
+        } else if (job.op == "compress") {
+            job.algorithm = json.value("algorithm", "zstd");
+            if (job.output.empty()) {
+                job.output = job.input + compressed_extension(job.algorithm);
+            }
+        } else {
+            job.error = "Unknown op \"" + job.op + "\" (encrypt, decrypt, hash, compress)";
+        }
+
+        if ((job.op == "encrypt" || job.op == "decrypt") && job.password.empty() && job.error.empty()) {
+            job.error = "No password (set \"password\" or pass -p)";
+        }
+    } catch (const nlohmann::json::exception& e) {
+        job.error = std::string("Invalid field: ") + e.what();
+    }
+    return job;
+}
+
+/**
+ * @brief Run one job; never throws
+ */
+nlohmann::json run_job(const Job& job, utils::CommitGroup* commit_group) {
+    nlohmann::json result = {{"line", job.line}, {"id", job.id}, {"op", job.op}, {"input", job.input}};
+    if (!job.error.empty()) {
+        result["ok"] = false;
+        result["error"] = job.error;
+        return result;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::string error;
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+
+    try {
+        if (job.op == "encrypt" || job.op == "decrypt") {
+            bool encrypting = job.op == "encrypt";
+            if (!encrypting && !core::StreamingCrypto::is_streaming_file(job.input)) {
+                error = "Not a v2 (streaming) file; use 'filevault decrypt' for v1 files";
+            } else {
+                auto stream = encrypting
+                    ? core::StreamingCrypto::encrypt_file(job.input, job.output, job.password, job.config)
+                    : core::StreamingCrypto::decrypt_file(job.input, job.output, job.password, nullptr, 1,
+                                                          {}, false, commit_group);
+                if (!stream.success) {
+                    error = stream.error_message;
+                } else {
+                    bytes_in = utils::FileIO::file_size(job.input);
+                    bytes_out = stream.bytes_written;
+                }
+            }
+        } else if (job.op == "hash") {
+            auto hash = utils::create_hash(HashCommand::get_botan_algorithm_name(job.algorithm));
+            auto mapped = utils::FileIO::map_file(job.input);
+            if (!hash) {
+                error = "Hash algorithm not available: " + job.algorithm;
+            } else if (!mapped) {
+                error = mapped.error_message;
+            } else {
+                auto data = mapped.value.span();
+                hash->update(data.data(), data.size());
+                result["digest"] = Botan::hex_encode(hash->final(), false);
+                bytes_in = data.size();
+            }
+        } else {
+            auto type = compression::CompressionService::parse_algorithm(job.algorithm);
+            auto compressor = compression::CompressionService::create(type);
+            if (type == core::CompressionType::NONE || !compressor) {
+                error = "Unknown compression algorithm: " + job.algorithm;
+            } else {
+                auto written = compression::CompressionService::process_file(
+                    *compressor, compression::StreamMode::COMPRESS, job.input, job.output, job.level);
+                if (!written) {
+                    error = written.error_message;
+                } else {
+                    bytes_in = utils::FileIO::file_size(job.input);
+                    bytes_out = written.value;
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        error = e.what();
+    }
+
+    result["ok"] = error.empty();
+    if (!error.empty()) {
+        result["error"] = error;
+    } else {
+        if (!job.output.empty()) {
+            result["output"] = job.output;
+        }
+        result["bytes_in"] = bytes_in;
+        result["bytes_out"] = bytes_out;
+        utils::RunStats::instance().add_bytes(bytes_in, bytes_out);
+        utils::RunStats::instance().add_files(1);
+    }
+    result["duration_ms"] = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+} // anonymous namespace
+
+BatchCommand::BatchCommand(core::CryptoEngine& engine)
+    : engine_(engine) {
+}
+
+void BatchCommand::setup(CLI::App& app) {
+    auto* cmd = app.add_subcommand(name(), description());
+
+    cmd->add_option("jobs", jobs_file_, "JSON-lines job file ('-' for stdin)")
+        ->required()
+        ->check(CLI::ExistingFile | CLI::IsMember({"-"}));
+    cmd->add_option("-p,--password", password_, "Password for jobs that do not set one");
+    cmd->add_option("-j,--jobs", jobs_, "Jobs run at once (0 = one per core)");
+    cmd->add_option("--io-depth", io_depth_,
+                    "Chunks read ahead per encrypt job; at most jobs x (depth + 1) chunks are buffered")
+        ->check(CLI::Range(0, 64));
+    cmd->add_flag("--ordered", ordered_, "Print results in job order instead of as jobs finish");
+    cmd->add_option("--group-commit", group_commit_,
+                    "Sync encrypt/decrypt outputs in groups of this many (0 = each file on its own)");
+    cmd->add_flag("--salt-per-job", salt_per_job_,
+                  "Stretch the password for every encrypt job (one KDF run per job, files do not reveal a shared password)");
+
+    cmd->footer(
+        "\nEach line is one job:\n"
+        "  {\"op\":\"encrypt\",\"input\":\"a.txt\",\"password\":\"pw\",\"algorithm\":\"aes-256-gcm\"}\n"
+        "  {\"op\":\"decrypt\",\"input\":\"a.txt.fvlt\",\"output\":\"a.txt\"}\n"
+        "  {\"op\":\"hash\",\"input\":\"a.txt\",\"algorithm\":\"sha256\"}\n"
+        "  {\"op\":\"compress\",\"input\":\"a.txt\",\"algorithm\":\"zstd\",\"level\":3}\n"
+        "Encrypt jobs write v2 files; \"kdf\", \"security\" and \"compression\" are optional.\n"
+        "One result line per job goes to stdout; exit code 1 if any job failed.\n"
+        "Outputs are written to a temp file and renamed into place once synced; with\n"
+        "--group-commit a file appears under its name when its group is synced.\n"
+        "\nExamples:\n"
+        "  Nightly run:        filevault batch jobs.jsonl -p \"$PW\" -j 8 > results.jsonl\n"
+        "  From a generator:   make-jobs | filevault batch - --ordered\n"
+        "  Many small files:   filevault batch jobs.jsonl -p \"$PW\" --group-commit 256\n"
+    );
+
+    cmd->callback([this]() {
+        int exit_code = execute();
+        if (exit_code != 0) {
+            throw CLI::RuntimeError(exit_code);
+        }
+    });
+}
+
+const std::vector<uint8_t>& BatchCommand::shared_salt(const std::string& password,
+                                                      const core::EncryptionConfig& config) {
+    auto group = core::KeyCache::instance().make_id(password, {}, config, 0);
+    auto it = salts_.find(group);
+    if (it != salts_.end()) {
+        return it->second;
+    }
+
+    auto salt = core::CryptoEngine::generate_salt(core::CryptoEngine::BATCH_SALT_SIZE);
+    // Warm the cache with the master key now; workers starting together
+    // would each miss it
+    engine_.derive_key(password, salt, config);
+    return salts_.emplace(group, std::move(salt)).first->second;
+}
+
+int BatchCommand::execute() {
+    // stdout carries the result lines
+    utils::Console::set_stream(stderr);
+
+    std::ifstream file;
+    std::istream* input = &std::cin;
+    if (jobs_file_ != "-") {
+        file.open(jobs_file_);
+        if (!file) {
+            utils::Console::error("Cannot open job file: " + jobs_file_);
+            return 1;
+        }
+        input = &file;
+    }
+
+    std::mutex output_mutex;
+    auto emit = [&output_mutex](const nlohmann::json& result) {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        fmt::print(stdout, "{}\n", result.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace));
+        std::fflush(stdout);
+    };
+
+    // Declared before the pool, so it outlives every job that adds to it
+    std::unique_ptr<utils::CommitGroup> commit_group;
+    if (group_commit_ > 0) {
+        commit_group = std::make_unique<utils::CommitGroup>(group_commit_);
+    }
+
+    core::TaskGroup pool(core::Executor::shared(), jobs_);
+    const size_t queue_limit = pool.size() * QUEUE_DEPTH_PER_WORKER;
+    std::deque<std::future<nlohmann::json>> pending;
+    size_t total = 0;
+    size_t failed = 0;
+
+    auto finish_oldest = [&] {
+        auto result = pool.wait(pending.front());
+        pending.pop_front();
+        if (ordered_) {
+            emit(result);
+        }
+        failed += result["ok"].get<bool>() ? 0 : 1;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::string text;
+    size_t line = 0;
+    while (std::getline(*input, text)) {
+        ++line;
+        if (text.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+
+        Job job = parse_job(text, line, password_);
+        if (job.op == "encrypt" && job.error.empty()) {
+            // Chunks are spread over jobs, not over threads within a job
+            job.config.worker_threads = 1;
+            job.config.io_buffers = io_depth_;
+            job.config.commit_group = commit_group.get();
+            if (!salt_per_job_) {
+                core::EncryptionConfig kdf_config;
+                kdf_config.algorithm = job.config.algorithm;
+                kdf_config.kdf = job.config.kdf;
+                kdf_config.level = job.config.level;
+                kdf_config.apply_security_level();
+                try {
+                    job.config.salt = core::CryptoEngine::batch_file_salt(shared_salt(job.password, kdf_config));
+                } catch (const std::exception& e) {
+                    job.error = std::string("Key derivation failed: ") + e.what();
+                }
+            }
+        }
+
+        ++total;
+        pending.push_back(pool.submit([this, &emit, &commit_group, job = std::move(job)] {
+            auto result = run_job(job, commit_group.get());
+            if (!ordered_) {
+                emit(result);
+            }
+            return result;
+        }));
+        if (pending.size() >= queue_limit) {
+            finish_oldest();
+        }
+    }
+    while (!pending.empty()) {
+        finish_oldest();
+    }
+    if (commit_group) {
+        commit_group->flush();
+        if (size_t lost = commit_group->failed()) {
+            utils::Console::error(fmt::format("{} outputs could not be synced to disk", lost));
+            failed += lost;
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    spdlog::info("Batch: {} KDF groups, {} jobs", salts_.size(), total);
+    if (failed == 0) {
+        utils::Console::success(fmt::format("{} jobs completed in {:.2f} s", total, seconds));
+    } else {
+        utils::Console::error(fmt::format("{} of {} jobs failed ({:.2f} s)", failed, total, seconds));
+    }
+    utils::Console::set_stream(nullptr);
+    return failed == 0 ? 0 : 1;
+}
+
+} // namespace cli
+} // namespace filevault
@@ -1,7 +1,10 @@
 #include "filevault/cli/commands/compress_cmd.hpp"
 #include "filevault/compression/compressor.hpp"
+#include "filevault/compression/seekable.hpp"
 #include "filevault/utils/file_io.hpp"
+#include "filevault/utils/config.hpp"
 #include "filevault/utils/console.hpp"
+#include "filevault/utils/run_stats.hpp"
 #include <fmt/core.h>
 #include <chrono>
 #include <fstream>
@@ -18,17 +21,26 @@ void CompressCommand::setup(CLI::App& app) {
     subcommand_->add_option("-o,--output", output_file_, "Output file");
     
     subcommand_->add_option("-a,--algorithm", algorithm_, "Compression algorithm")
-        ->check(CLI::IsMember({"zlib", "bzip2", "lzma"}));
+        ->check(CLI::IsMember({"zlib", "bzip2", "lzma", "zstd", "lz4"}));
     
     subcommand_->add_option("-l,--level", level_, "Compression level (1-9)")
         ->check(CLI::Range(1, 9));
     
+    subcommand_->add_option("-T,--threads", threads_,
+                  "Threads (0 = one per core, 1 = serial)");
+    
     subcommand_->add_flag("-d,--decompress", decompress_, 
                   "Decompress mode");
     
     subcommand_->add_flag("--auto-detect", auto_detect_,
                   "Auto-detect compression algorithm");
     
+    subcommand_->add_flag("--seekable", seekable_,
+                  "Compress in independent frames with a seek table (see decompress --range)");
+    
+    subcommand_->add_option("--frame-size", frame_size_, "Uncompressed bytes per seekable frame (default: 4M)")
+        ->transform(CLI::AsSizeValue(false));
+    
     subcommand_->add_flag("-v,--verbose", verbose_, "Verbose output");
     
     subcommand_->add_flag("--benchmark", benchmark_, 
@@ -39,11 +51,13 @@ void CompressCommand::setup(CLI::App& app) {
         "  Compress with LZMA:    filevault compress large_file.txt -a lzma\n"
         "  Maximum compression:   filevault compress file.txt -a lzma -l 9\n"
         "  Fast compression:      filevault compress file.txt -a zlib -l 1\n"
+        "  Single-threaded:       filevault compress file.txt -a lzma --threads 1\n"
         "  Decompress:            filevault compress file.txt.zlib -d\n"
         "  Auto-detect format:    filevault compress file.lzma -d --auto-detect\n"
         "  With benchmark:        filevault compress file.txt --benchmark\n"
+        "  Seekable frames:       filevault compress app.log -a zstd --seekable --frame-size 1M\n"
         "\n"
-        "Algorithms: zlib, bzip2, lzma\n"
+        "Algorithms: zlib, bzip2, lzma, zstd, lz4\n"
         "Levels: 1 (fastest) to 9 (best compression)\n"
         "Default: lzma level 6\n"
     );
@@ -57,6 +71,10 @@ void CompressCommand::setup(CLI::App& app) {
 }
 
 int CompressCommand::execute() {
+    if (threads_ == 0) {
+        threads_ = utils::Config::current().get_threads();
+    }
+    
     // Generate output path if not provided
     if (output_file_.empty()) {
         output_file_ = generate_output_path(input_file_, !decompress_);
@@ -79,18 +97,14 @@ int CompressCommand::do_compress() {
     utils::Console::info(fmt::format("Output:    {}", output_file_));
     utils::Console::info(fmt::format("Algorithm: {}", algorithm_));
     utils::Console::info(fmt::format("Level:     {}", level_));
-    utils::Console::separator();
-    
-    // Read input file
-    auto file_result = utils::FileIO::read_file(input_file_);
-    if (!file_result) {
-        utils::Console::error(file_result.error_message);
-        return 1;
+    utils::Console::info(fmt::format("Threads:   {}", threads_ == 0 ? std::string("auto") : std::to_string(threads_)));
+    if (seekable_) {
+        utils::Console::info(fmt::format("Frames:    {} bytes each, seekable", frame_size_));
     }
+    utils::Console::separator();
     
-    auto plaintext = file_result.value;
-    size_t original_size = plaintext.size();
-    utils::Console::info(fmt::format("Read {} bytes", original_size));
+    size_t original_size = utils::FileIO::file_size(input_file_);
+    utils::Console::info(fmt::format("Input size: {} bytes", original_size));
     
     // Parse algorithm
     auto comp_type = compression::CompressionService::parse_algorithm(algorithm_);
@@ -105,25 +119,23 @@ int CompressCommand::do_compress() {
         utils::Console::error("Failed to create compressor");
         return 1;
     }
+    compressor->set_threads(threads_);
     
-    // Compress
+    // Compress chunk by chunk so memory use does not grow with the file
     utils::Console::info("Compressing...");
     auto start = std::chrono::high_resolution_clock::now();
     
-    auto compress_result = compressor->compress(plaintext, level_);
+    auto stream_result = seekable_
+        ? compression::SeekableCompression::compress_file(
+              comp_type, input_file_, output_file_, level_, frame_size_, threads_)
+        : compression::CompressionService::process_file(
+              *compressor, compression::StreamMode::COMPRESS, input_file_, output_file_, level_);
     
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration<double, std::milli>(end - start);
     
-    if (!compress_result.success) {
-        utils::Console::error(compress_result.error_message);
-        return 1;
-    }
-    
-    // Write output
-    auto write_result = utils::FileIO::write_file(output_file_, compress_result.data);
-    if (!write_result) {
-        utils::Console::error(write_result.error_message);
+    if (!stream_result) {
+        utils::Console::error(stream_result.error_message);
         return 1;
     }
     
@@ -131,7 +143,9 @@ int CompressCommand::do_compress() {
     utils::Console::separator();
     utils::Console::success("Compression completed!");
     
-    size_t compressed_size = compress_result.data.size();
+    size_t compressed_size = stream_result.value;
+    utils::RunStats::instance().add_bytes(original_size, compressed_size);
+    utils::RunStats::instance().add_files(1);
     double ratio = (double)compressed_size / original_size * 100.0;
     double throughput = (original_size / 1024.0 / 1024.0) / (duration.count() / 1000.0);
     
@@ -182,16 +196,8 @@ int CompressCommand::do_decompress() {
     utils::Console::info(fmt::format("Algorithm: {}", algorithm_));
     utils::Console::separator();
     
-    // Read compressed file
-    auto file_result = utils::FileIO::read_file(input_file_);
-    if (!file_result) {
-        utils::Console::error(file_result.error_message);
-        return 1;
-    }
-    
-    auto compressed_data = file_result.value;
-    size_t compressed_size = compressed_data.size();
-    utils::Console::info(fmt::format("Read {} bytes", compressed_size));
+    size_t compressed_size = utils::FileIO::file_size(input_file_);
+    utils::Console::info(fmt::format("Input size: {} bytes", compressed_size));
     
     // Parse algorithm
     auto comp_type = compression::CompressionService::parse_algorithm(algorithm_);
@@ -206,25 +212,23 @@ int CompressCommand::do_decompress() {
         utils::Console::error("Failed to create compressor");
         return 1;
     }
+    compressor->set_threads(threads_);
     
-    // Decompress
+    // Decompress chunk by chunk, or frame by frame in parallel if seekable
     utils::Console::info("Decompressing...");
     auto start = std::chrono::high_resolution_clock::now();
     
-    auto decompress_result = compressor->decompress(compressed_data);
+    auto stream_result = compression::SeekableCompression::is_seekable(input_file_)
+        ? compression::SeekableCompression::decompress_file(
+              comp_type, input_file_, output_file_, 0, compression::SeekableCompression::TO_END, threads_)
+        : compression::CompressionService::process_file(
+              *compressor, compression::StreamMode::DECOMPRESS, input_file_, output_file_, level_);
     
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration<double, std::milli>(end - start);
     
-    if (!decompress_result.success) {
-        utils::Console::error(decompress_result.error_message);
-        return 1;
-    }
-    
-    // Write output
-    auto write_result = utils::FileIO::write_file(output_file_, decompress_result.data);
-    if (!write_result) {
-        utils::Console::error(write_result.error_message);
+    if (!stream_result) {
+        utils::Console::error(stream_result.error_message);
         return 1;
     }
     
@@ -232,7 +236,9 @@ int CompressCommand::do_decompress() {
     utils::Console::separator();
     utils::Console::success("Decompression completed!");
     
-    size_t decompressed_size = decompress_result.data.size();
+    size_t decompressed_size = stream_result.value;
+    utils::RunStats::instance().add_bytes(compressed_size, decompressed_size);
+    utils::RunStats::instance().add_files(1);
     double ratio = (double)compressed_size / decompressed_size * 100.0;
     double throughput = (decompressed_size / 1024.0 / 1024.0) / (duration.count() / 1000.0);
     
@@ -275,6 +281,16 @@ std::string CompressCommand::detect_algorithm(const std::string& path) {
         return "lzma";
     }
     
+    // Zstandard: 28 B5 2F FD
+    if (magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD) {
+        return "zstd";
+    }
+    
+    // LZ4 frame: 04 22 4D 18
+    if (magic[0] == 0x04 && magic[1] == 0x22 && magic[2] == 0x4D && magic[3] == 0x18) {
+        return "lz4";
+    }
+    
     // Try extension fallback
     if (path.ends_with(".zlib") || path.ends_with(".zz")) {
         return "zlib";
@@ -282,6 +298,10 @@ std::string CompressCommand::detect_algorithm(const std::string& path) {
         return "bzip2";
     } else if (path.ends_with(".xz") || path.ends_with(".lzma")) {
         return "lzma";
+    } else if (path.ends_with(".zst")) {
+        return "zstd";
+    } else if (path.ends_with(".lz4")) {
+        return "lz4";
     }
     
     return "";
@@ -296,6 +316,10 @@ std::string CompressCommand::generate_output_path(const std::string& input, bool
             return input + ".bz2";
         } else if (algorithm_ == "lzma") {
             return input + ".xz";
+        } else if (algorithm_ == "zstd") {
+            return input + ".zst";
+        } else if (algorithm_ == "lz4") {
+            return input + ".lz4";
         }
         return input + ".compressed";
     } else {
@@ -313,6 +337,8 @@ std::string CompressCommand::generate_output_path(const std::string& input, bool
             return output.substr(0, output.length() - 5);
         } else if (output.ends_with(".zz")) {
             return output.substr(0, output.length() - 3);
+        } else if (output.ends_with(".zst") || output.ends_with(".lz4")) {
+            return output.substr(0, output.length() - 4);
         } else if (output.ends_with(".compressed")) {
             return output.substr(0, output.length() - 11);
         }
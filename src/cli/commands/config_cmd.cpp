@@ -2,6 +2,7 @@
 #include "filevault/utils/console.hpp"
 #include "filevault/utils/table_formatter.hpp"
 #include <fmt/core.h>
+#include <type_traits>
 
 namespace filevault {
 namespace cli {
@@ -29,6 +30,26 @@ void ConfigCommand::setup(CLI::App& app) {
         subcommand_ = "reset";
         execute();
     });
+    
+    auto* profile = config_cmd->add_subcommand("profile", "List, show or select performance profiles");
+    auto* profile_list = profile->add_subcommand("list", "List built-in and user profiles");
+    profile_list->callback([this]() {
+        subcommand_ = "profile list";
+        execute();
+    });
+    auto* profile_show = profile->add_subcommand("show", "Show a profile's settings");
+    profile_show->add_option("name", key_, "Profile name (default: the active one)");
+    profile_show->callback([this]() {
+        subcommand_ = "profile show";
+        execute();
+    });
+    auto* profile_use = profile->add_subcommand("use", "Make a profile the default ('none' to clear)");
+    profile_use->add_option("name", key_, "Profile name")->required();
+    profile_use->callback([this]() {
+        subcommand_ = "profile use";
+        execute();
+    });
+    profile->require_subcommand(1);
 
     config_cmd->footer(
         "\nExamples:\n"
@@ -36,11 +57,15 @@ void ConfigCommand::setup(CLI::App& app) {
         "  Set default mode:      filevault config set default.mode standard\n"
         "  Set compression level: filevault config set compression_level 9\n"
         "  Reset config:          filevault config reset\n"
+        "  Pick a profile:        filevault config profile use throughput\n"
+        "  Tune a profile:        filevault config set profiles.laptop.threads 4\n"
+        "  Profile for one run:   FILEVAULT_PROFILE=low-memory filevault encrypt big.img\n"
         "\n"
         "Symmetric algorithms: aes-128-gcm, aes-192-gcm, aes-256-gcm, chacha20-poly1305,\n"
         "  serpent-256-gcm, twofish-{128,192,256}-gcm, camellia-{128,192,256}-gcm,\n"
-        "  aria-{128,192,256}-gcm, sm4-gcm, aes-{128,192,256}-{cbc,ctr,cfb,ofb,ecb,xts}\n"
-        "Asymmetric: rsa-{2048,3072,4096}, ecc-{p256,p384,p521}\n"
+        "  aria-{128,192,256}-gcm, sm4-gcm, aegis-256, aes-256-ocb, aes-256-siv,\n"
+        "  aes-{128,192,256}-{cbc,ctr,cfb,ofb,ecb,xts}\n"
+        "Asymmetric: rsa-{2048,3072,4096}, ecc-{p256,p384,p521,x25519}\n"
         "Post-Quantum: kyber-{512,768,1024}-hybrid\n"
         "Classical: caesar, vigenere, playfair, substitution, hill\n"
         "KDF options: argon2id, argon2i, pbkdf2-sha256, pbkdf2-sha512, scrypt\n"
@@ -57,6 +82,12 @@ int ConfigCommand::execute() {
         return set_value();
     } else if (subcommand_ == "reset") {
         return reset_config();
+    } else if (subcommand_ == "profile list") {
+        return list_profiles();
+    } else if (subcommand_ == "profile show") {
+        return show_profile();
+    } else if (subcommand_ == "profile use") {
+        return use_profile();
     }
     
     return 1;
@@ -81,6 +112,14 @@ int ConfigCommand::show_config() {
         fmt::print("  {:25} : {}\n", "Compression Level", config.get_compression_level());
         fmt::print("  {:25} : {}\n", "Show Progress", config.get_show_progress() ? "yes" : "no");
         fmt::print("  {:25} : {}\n", "Verbose", config.get_verbose() ? "yes" : "no");
+        fmt::print("  {:25} : {} MB\n", "Streaming Threshold", config.get_streaming_threshold_mb());
+        fmt::print("  {:25} : {} MB\n", "Streaming Chunk Size", config.get_streaming_chunk_mb());
+        fmt::print("  {:25} : {}\n", "Disabled CPU Features",
+                   config.get_cpu_disabled_features().empty() ? "none" : config.get_cpu_disabled_features());
+        fmt::print("  {:25} : {} MB\n", "KDF Memory Budget", config.get_kdf_max_memory_mb());
+        fmt::print("  {:25} : {}\n", "I/O Backend", config.get_io_backend());
+        fmt::print("  {:25} : {}\n", "Performance Profile",
+                   config.get_profile().empty() ? "none" : config.get_profile());
         fmt::print("\n");
         
         return 0;
@@ -99,12 +138,22 @@ int ConfigCommand::set_value() {
             utils::Console::error(fmt::format("Unknown configuration key: {}", key_));
             utils::Console::info("Valid keys:");
             utils::Console::info("  default.mode (basic/standard/advanced)");
-            utils::Console::info("  default.algorithm (aes-256-gcm, etc.)");
+            utils::Console::info("  default.algorithm (auto, aes-256-gcm, etc.)");
             utils::Console::info("  default.kdf (argon2id, pbkdf2-sha256, etc.)");
             utils::Console::info("  default.compression (none/zlib/lzma)");
             utils::Console::info("  compression_level (1-9)");
             utils::Console::info("  show_progress (true/false)");
             utils::Console::info("  verbose (true/false)");
+            utils::Console::info("  streaming.threshold_mb (0 = never stream)");
+            utils::Console::info("  streaming.chunk_mb (chunk size for streaming)");
+            utils::Console::info("  cpu.disabled_features (e.g. aesni,avx2; empty = none)");
+            utils::Console::info("  kdf.max_memory_mb (memory budget for --kdf-target-ms)");
+            utils::Console::info("  io.backend (auto/uring/iocp/dispatch/portable)");
+            utils::Console::info("  profile (a profile name, or none)");
+            utils::Console::info("  profiles.<name>.<knob> (threads, streaming.chunk_mb, streaming.threshold_mb,");
+            utils::Console::info("    streaming.io_buffers,");
+            utils::Console::info("    io.backend, io.direct, memory.buffer_pool_mb, memory.huge_pages,");
+            utils::Console::info("    kdf.max_memory_mb, compression.target_mbps, crypto.offload)");
             return 1;
         }
         
@@ -142,5 +191,79 @@ int ConfigCommand::reset_config() {
     }
 }
 
+int ConfigCommand::list_profiles() {
+    auto config = utils::Config::load();
+    const auto& builtin = utils::PerformanceProfile::builtin();
+    for (const auto& name : config.profile_names()) {
+        std::string origin = builtin.count(name) ? "built-in" : "user";
+        if (builtin.count(name) && config.find_profile(name)->to_json() != builtin.at(name).to_json()) {
+            origin = "built-in, customized";
+        }
+        fmt::print("  {} {:12} ({})\n", name == config.get_profile() ? '*' : ' ', name, origin);
+    }
+    return 0;
+}
+
+int ConfigCommand::show_profile() {
+    auto config = utils::Config::load();
+    std::string name = key_.empty() ? config.get_profile() : key_;
+    if (name.empty()) {
+        utils::Console::info("No performance profile is active");
+        return 0;
+    }
+    auto profile = config.find_profile(name);
+    if (!profile) {
+        utils::Console::error(fmt::format("Unknown profile: {}", name));
+        return 1;
+    }
+    
+    // Unset knobs show the plain setting they fall back to
+    auto knob = [](const auto& value, const std::string& fallback) {
+        if (!value) {
+            return fallback + " (not set)";
+        }
+        if constexpr (std::is_same_v<std::decay_t<decltype(*value)>, bool>) {
+            return std::string(*value ? "yes" : "no");
+        } else {
+            return fmt::format("{}", *value);
+        }
+    };
+    auto base = config;
+    base.set("profile", "none");
+    fmt::print("\n  Profile {}\n\n", name);
+    fmt::print("  {:25} : {}\n", "Threads", knob(profile->threads, "0"));
+    fmt::print("  {:25} : {}\n", "Streaming Chunk (MB)",
+               knob(profile->streaming_chunk_mb, std::to_string(base.get_streaming_chunk_mb())));
+    fmt::print("  {:25} : {}\n", "Streaming Threshold (MB)",
+               knob(profile->streaming_threshold_mb, std::to_string(base.get_streaming_threshold_mb())));
+    fmt::print("  {:25} : {}\n", "Streaming Read-ahead", knob(profile->streaming_io_buffers, "2"));
+    fmt::print("  {:25} : {}\n", "I/O Backend", knob(profile->io_backend, base.get_io_backend()));
+    fmt::print("  {:25} : {}\n", "Direct I/O", knob(profile->direct_io, "no"));
+    fmt::print("  {:25} : {}\n", "Buffer Pool (MB)", knob(profile->buffer_pool_mb, "1024"));
+    fmt::print("  {:25} : {}\n", "Huge Pages", knob(profile->huge_pages, "no"));
+    fmt::print("  {:25} : {}\n", "Memory Limit (MB)", knob(profile->max_memory_mb, "0"));
+    fmt::print("  {:25} : {}\n", "KDF Memory Budget (MB)",
+               knob(profile->kdf_max_memory_mb, std::to_string(base.get_kdf_max_memory_mb())));
+    fmt::print("  {:25} : {}\n", "Compression Target (MB/s)", knob(profile->compression_target_mbps, "200"));
+    fmt::print("  {:25} : {}\n", "Keystream Offload", knob(profile->crypto_offload, "off"));
+    fmt::print("\n");
+    return 0;
+}
+
+int ConfigCommand::use_profile() {
+    auto config = utils::Config::load();
+    if (!config.set("profile", key_)) {
+        utils::Console::error(fmt::format("Unknown profile: {} (see 'config profile list')", key_));
+        return 1;
+    }
+    if (!config.save()) {
+        utils::Console::error("Failed to save configuration");
+        return 1;
+    }
+    utils::Console::success(key_ == "none" ? "Performance profile cleared"
+                                           : fmt::format("Performance profile set to {}", key_));
+    return 0;
+}
+
 } // namespace cli
 } // namespace filevault
@@ -1,8 +1,13 @@
 #include "filevault/cli/commands/decompress_cmd.hpp"
 #include "filevault/compression/compressor.hpp"
+#include "filevault/compression/seekable.hpp"
+#include "filevault/utils/config.hpp"
 #include "filevault/utils/file_io.hpp"
 #include "filevault/utils/console.hpp"
+#include "filevault/utils/run_stats.hpp"
 #include <fmt/core.h>
+#include <algorithm>
+#include <cctype>
 #include <chrono>
 #include <fstream>
 
@@ -18,7 +23,13 @@ void DecompressCommand::setup(CLI::App& app) {
     subcommand_->add_option("-o,--output", output_file_, "Output file");
     
     subcommand_->add_option("-a,--algorithm", algorithm_, "Compression algorithm (auto-detected if not specified)")
-        ->check(CLI::IsMember({"zlib", "bzip2", "lzma"}));
+        ->check(CLI::IsMember({"zlib", "bzip2", "lzma", "zstd", "lz4"}));
+    
+    subcommand_->add_option("--range", range_,
+                  "Only OFFSET:LENGTH of the original data, e.g. 1G:1M (seekable files; LENGTH may be omitted)");
+    
+    subcommand_->add_option("-T,--threads", threads_,
+                  "Decompression threads for bzip2/lzma (0 = one per core, 1 = serial)");
     
     subcommand_->add_flag("--no-auto-detect", [this](int64_t) { auto_detect_ = false; },
                   "Disable auto-detection of algorithm");
@@ -34,8 +45,10 @@ void DecompressCommand::setup(CLI::App& app) {
         "  Specify algorithm:           filevault decompress file.txt.zlib -a zlib\n"
         "  Specify output file:         filevault decompress file.bz2 -o output.txt\n"
         "  With benchmark:              filevault decompress file.lzma --benchmark\n"
+        "  Single-threaded:             filevault decompress file.xz --threads 1\n"
+        "  1 MiB from the middle:       filevault decompress app.log.zst --range 20G:1M -o part.log\n"
         "\n"
-        "Algorithms: zlib, bzip2, lzma\n"
+        "Algorithms: zlib, bzip2, lzma, zstd, lz4\n"
     );
     subcommand_->callback([this]() { 
         int exit_code = execute();
@@ -46,6 +59,10 @@ void DecompressCommand::setup(CLI::App& app) {
 }
 
 int DecompressCommand::execute() {
+    if (threads_ == 0) {
+        threads_ = utils::Config::current().get_threads();
+    }
+    
     utils::Console::separator();
     fmt::print("\n{:^80}\n", "FileVault Decompression");
     utils::Console::separator();
@@ -56,7 +73,7 @@ int DecompressCommand::execute() {
         if (algorithm_.empty()) {
             utils::Console::error("Failed to auto-detect compression algorithm");
             utils::Console::info("Try specifying algorithm with -a/--algorithm");
-            utils::Console::info("Supported algorithms: zlib, bzip2, lzma");
+            utils::Console::info("Supported algorithms: zlib, bzip2, lzma, zstd, lz4");
             return 1;
         }
         if (verbose_) {
@@ -64,6 +81,13 @@ int DecompressCommand::execute() {
         }
     }
     
+    uint64_t range_offset = 0;
+    uint64_t range_length = compression::SeekableCompression::TO_END;
+    if (!range_.empty() && !parse_range(range_offset, range_length)) {
+        utils::Console::error(fmt::format("Invalid range: {} (expected OFFSET:LENGTH, e.g. 64M:1M)", range_));
+        return 1;
+    }
+    
     if (algorithm_.empty()) {
         utils::Console::error("Algorithm not specified and auto-detect disabled");
         utils::Console::info("Use -a/--algorithm to specify: zlib, bzip2, lzma");
@@ -81,16 +105,8 @@ int DecompressCommand::execute() {
     utils::Console::info(fmt::format("Algorithm: {}", algorithm_));
     utils::Console::separator();
     
-    // Read compressed file
-    auto file_result = utils::FileIO::read_file(input_file_);
-    if (!file_result) {
-        utils::Console::error(file_result.error_message);
-        return 1;
-    }
-    
-    auto compressed_data = file_result.value;
-    size_t compressed_size = compressed_data.size();
-    utils::Console::info(fmt::format("Read {} bytes", compressed_size));
+    size_t compressed_size = utils::FileIO::file_size(input_file_);
+    utils::Console::info(fmt::format("Input size: {} bytes", compressed_size));
     
     // Parse algorithm
     auto comp_type = compression::CompressionService::parse_algorithm(algorithm_);
@@ -105,25 +121,34 @@ int DecompressCommand::execute() {
         utils::Console::error("Failed to create decompressor");
         return 1;
     }
+    compressor->set_threads(threads_);
+    
+    // Seekable files decompress frame by frame in parallel, and only the
+    // frames a range covers; others chunk by chunk so memory use does not
+    // grow with the file
+    bool seekable = compression::SeekableCompression::is_seekable(input_file_);
+    if (!range_.empty() && !seekable) {
+        utils::Console::error("--range needs a seekable file (compress --seekable)");
+        return 1;
+    }
+    if (verbose_ && seekable) {
+        utils::Console::info("Seekable file: decompressing frames in parallel");
+    }
     
-    // Decompress
     utils::Console::info("Decompressing...");
     auto start = std::chrono::high_resolution_clock::now();
     
-    auto decompress_result = compressor->decompress(compressed_data);
+    auto stream_result = seekable
+        ? compression::SeekableCompression::decompress_file(
+              comp_type, input_file_, output_file_, range_offset, range_length, threads_)
+        : compression::CompressionService::process_file(
+              *compressor, compression::StreamMode::DECOMPRESS, input_file_, output_file_);
     
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration<double, std::milli>(end - start);
     
-    if (!decompress_result.success) {
-        utils::Console::error(decompress_result.error_message);
-        return 1;
-    }
-    
-    // Write output
-    auto write_result = utils::FileIO::write_file(output_file_, decompress_result.data);
-    if (!write_result) {
-        utils::Console::error(write_result.error_message);
+    if (!stream_result) {
+        utils::Console::error(stream_result.error_message);
         return 1;
     }
     
@@ -131,7 +156,9 @@ int DecompressCommand::execute() {
     utils::Console::separator();
     utils::Console::success("Decompression completed!");
     
-    size_t decompressed_size = decompress_result.data.size();
+    size_t decompressed_size = stream_result.value;
+    utils::RunStats::instance().add_bytes(compressed_size, decompressed_size);
+    utils::RunStats::instance().add_files(1);
     double ratio = (double)decompressed_size / compressed_size;
     double throughput = (decompressed_size / 1024.0 / 1024.0) / (duration.count() / 1000.0);
     
@@ -149,6 +176,43 @@ int DecompressCommand::execute() {
     return 0;
 }
 
+bool DecompressCommand::parse_range(uint64_t& offset, uint64_t& length) const {
+    // Byte count with an optional binary K/M/G/T suffix
+    auto parse_size = [](std::string text, uint64_t& value) {
+        uint64_t unit = 1;
+        if (!text.empty() && std::isalpha(static_cast<unsigned char>(text.back()))) {
+            switch (std::toupper(static_cast<unsigned char>(text.back()))) {
+                case 'K': unit = 1ull << 10; break;
+                case 'M': unit = 1ull << 20; break;
+                case 'G': unit = 1ull << 30; break;
+                case 'T': unit = 1ull << 40; break;
+                default: return false;
+            }
+            text.pop_back();
+        }
+        if (text.empty() || text.size() > 19 ||
+            !std::all_of(text.begin(), text.end(), [](unsigned char c) { return std::isdigit(c); })) {
+            return false;
+        }
+        value = std::stoull(text);
+        if (value > UINT64_MAX / unit) {
+            return false;
+        }
+        value *= unit;
+        return true;
+    };
+    
+    auto colon = range_.find(':');
+    if (!parse_size(range_.substr(0, colon), offset)) {
+        return false;
+    }
+    if (colon == std::string::npos || colon + 1 == range_.size()) {
+        length = compression::SeekableCompression::TO_END;
+        return true;
+    }
+    return parse_size(range_.substr(colon + 1), length);
+}
+
 std::string DecompressCommand::detect_algorithm(const std::string& path) {
     // Read first few bytes to detect magic numbers
     std::ifstream file(path, std::ios::binary);
@@ -180,6 +244,16 @@ std::string DecompressCommand::detect_algorithm(const std::string& path) {
         return "lzma";
     }
     
+    // Zstandard: 28 B5 2F FD
+    if (magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD) {
+        return "zstd";
+    }
+    
+    // LZ4 frame: 04 22 4D 18
+    if (magic[0] == 0x04 && magic[1] == 0x22 && magic[2] == 0x4D && magic[3] == 0x18) {
+        return "lz4";
+    }
+    
     // Try extension fallback
     if (path.ends_with(".zlib") || path.ends_with(".zz")) {
         return "zlib";
@@ -187,6 +261,10 @@ std::string DecompressCommand::detect_algorithm(const std::string& path) {
         return "bzip2";
     } else if (path.ends_with(".xz") || path.ends_with(".lzma")) {
         return "lzma";
+    } else if (path.ends_with(".zst")) {
+        return "zstd";
+    } else if (path.ends_with(".lz4")) {
+        return "lz4";
     }
     
     return "";
@@ -206,6 +284,8 @@ std::string DecompressCommand::generate_output_path(const std::string& input) {
         return output.substr(0, output.length() - 5);
     } else if (output.ends_with(".zz")) {
         return output.substr(0, output.length() - 3);
+    } else if (output.ends_with(".zst") || output.ends_with(".lz4")) {
+        return output.substr(0, output.length() - 4);
     } else if (output.ends_with(".compressed")) {
         return output.substr(0, output.length() - 11);
     }
@@ -1,18 +1,117 @@
 #include "filevault/cli/commands/decrypt_cmd.hpp"
-#include "filevault/format/file_header.hpp"
+#include "filevault/archive/directory_walker.hpp"
+#include "filevault/core/checkpoint.hpp"
+#include "filevault/core/envelope.hpp"
 #include "filevault/core/file_format.hpp"
+#include "filevault/core/kdf_scheduler.hpp"
+#include "filevault/core/key_cache.hpp"
+#include "filevault/core/streaming.hpp"
+#include "filevault/core/tree_runner.hpp"
+#include "filevault/utils/armor.hpp"
 #include "filevault/utils/console.hpp"
 #include "filevault/utils/file_io.hpp"
+#include "filevault/utils/io_backend.hpp"
+#include "filevault/utils/object_store.hpp"
+#include "filevault/utils/part_files.hpp"
+#include "filevault/utils/s3_store.hpp"
 #include "filevault/utils/crypto_utils.hpp"
 #include "filevault/utils/password.hpp"
 #include "filevault/utils/progress.hpp"
+#include "filevault/utils/run_stats.hpp"
 #include "filevault/compression/compressor.hpp"
+#include "filevault/compression/dictionary.hpp"
+#include "filevault/utils/config.hpp"
 #include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <mutex>
+#include <unordered_map>
 
 namespace filevault {
 namespace cli {
 
+// Ciphertext decrypted per step of the incremental path
+static constexpr size_t INCREMENTAL_PIECE_SIZE = 1024 * 1024;
+
+namespace {
+
+/**
+ * @brief Password keys of a tree's streaming files, derived ahead of the workers
+ */
+struct KeySchedule {
+    std::unique_ptr<core::KdfScheduler> scheduler;
+    std::unordered_map<std::string, size_t> tickets;    // By source path
+
+    /**
+     * @brief Wait until the file's key is in KeyCache (no-op for unscheduled files)
+     */
+    void wait(const std::string& source) const {
+        auto it = tickets.find(source);
+        if (scheduler && it != tickets.end()) {
+            scheduler->wait(it->second);
+        }
+    }
+};
+
+KeySchedule schedule_keys(const std::vector<core::TreeFile>& files, const core::TreeRunOptions& options,
+                          const std::string& password, uint64_t memory_budget) {
+    KeySchedule schedule;
+    // Keys reach the decryption through KeyCache; without it every file derives its own
+    if (files.size() < 2 || !core::KeyCache::instance().enabled()) {
+        return schedule;
+    }
+    core::KdfSchedulerOptions scheduler_options;
+    scheduler_options.memory_budget = memory_budget;
+    schedule.scheduler = std::make_unique<core::KdfScheduler>(password, scheduler_options);
+    for (size_t index : core::TreeRunner::schedule(files, options)) {
+        auto source = files[index].source.string();
+        auto info = core::StreamingCrypto::read_info(source);
+        if (!info || info->salt.empty()) {
+            continue;   // Not a password-keyed streaming file; its job reports why
+        }
+        core::EncryptionConfig config;
+        config.algorithm = info->algorithm;
+        config.kdf = info->kdf;
+        config.level = info->level;
+        config.apply_security_level();
+        schedule.tickets.emplace(source, schedule.scheduler->submit(std::move(info->salt), config));
+    }
+    return schedule;
+}
+
+/**
+ * @brief Work that needs no key, done while the password is typed
+ *
+ * Validates the header, constructs the cipher of a single-shot file and
+ * reads the first chunks into the page cache, so decryption starts on
+ * warm data once the password is in. Errors are left to the main path.
+ *
+ * @param bypass_cache --direct-io: the chunks are not read ahead
+ */
+void prepare_input(const std::string& path, core::CryptoEngine& engine, bool bypass_cache) {
+    try {
+        uint64_t length = utils::FileIO::PREFETCH_SIZE;
+        if (core::StreamingCrypto::is_streaming_file(path)) {
+            if (auto info = core::StreamingCrypto::read_info(path)) {
+                length = std::min<uint64_t>(length, info->header_size + 2 * uint64_t{info->chunk_size});
+            }
+        } else if (!utils::is_armored_file(path) && !core::FileFormatHandler::is_legacy_format(path)) {
+            auto layout = core::FileFormatHandler::read_header(path);
+            engine.get_algorithm(core::FileFormatHandler::from_algorithm_id(layout.header.algorithm));
+        }
+        utils::FileIO::prefetch(path, length, bypass_cache);
+    } catch (const std::exception& e) {
+        SPDLOG_DEBUG("Stopped preparing {}: {}", path, e.what());
+    }
+}
+
+} // anonymous namespace
+
 DecryptCommand::DecryptCommand(core::CryptoEngine& engine)
     : engine_(engine) {
 }
@@ -20,12 +119,34 @@ DecryptCommand::DecryptCommand(core::CryptoEngine& engine)
 void DecryptCommand::setup(CLI::App& app) {
     auto* cmd = app.add_subcommand(name(), description());
     
-    cmd->add_option("input", input_file_, "Input encrypted file")
+    CLI::Validator object_url(
+        [](std::string& text) {
+            return utils::ObjectUrl::is_object_url(text) ? std::string() : "Not an s3://bucket/key URL";
+        },
+        "S3URL");
+    cmd->add_option("input", input_file_,
+                    "Input encrypted file ('-' for stdin, s3://bucket/key, a directory with -r)")
         ->required()
-        ->check(CLI::ExistingFile);
+        ->check(CLI::ExistingPath | CLI::IsMember({"-"}) | object_url);
     
-    cmd->add_option("output", output_file_, "Output decrypted file");
+    cmd->add_option("output,-o,--output", output_file_,
+                    "Output decrypted file ('-' for stdout, a directory with -r)");
+    cmd->add_flag("-r,--recursive", recursive_,
+                  "Decrypt every .fvlt file under the input directory into a mirrored output tree");
+    cmd->add_option("-T,--threads", threads_, "Files decrypted at once with -r (0 = one per core)");
+    cmd->add_option("--kdf-memory", kdf_memory_,
+                    "Memory for key derivations running ahead of the workers with -r (e.g. 512M, 4G)")
+        ->transform(CLI::AsSizeValue(false));
     cmd->add_option("-p,--password", password_, "Decryption password (not recommended)");
+    cmd->add_option("--private-key", private_key_path_, "Private key for files encrypted to a public key")
+        ->check(CLI::ExistingFile);
+    cmd->add_option("--checkpoint-interval", checkpoint_interval_,
+                    "Chunks between checkpoints of a chunked file (0 = none)");
+    cmd->add_flag("--resume", resume_, "Continue an interrupted decryption from its checkpoint");
+    cmd->add_flag("--verify-only", verify_only_,
+                  "Authenticate the input (every file with -r) without writing any plaintext");
+    cmd->add_flag("--direct-io,--no-cache", direct_io_,
+                  "Keep input and output out of the page cache (bulk jobs on busy hosts)");
     cmd->add_flag("-v,--verbose", verbose_, "Verbose output");
     cmd->add_flag("--no-progress", no_progress_, "Disable progress bars");
     
@@ -35,6 +156,13 @@ void DecryptCommand::setup(CLI::App& app) {
         "  Specify output:        filevault decrypt secret.fvlt -o output.txt\n"
         "  With password arg:     filevault decrypt file.fvlt -p mypassword\n"
         "  Verbose mode:          filevault decrypt file.fvlt -v\n"
+        "  Pipe (stdin/stdout):   filevault decrypt - - -p secret < db.fvlt | psql db\n"
+        "  With a private key:    filevault decrypt backup.tar.fvlt --private-key team.key\n"
+        "  Resume after a crash:  filevault decrypt volume.img.fvlt --resume\n"
+        "  Whole directory:       filevault decrypt -r photos.fvlt -o photos\n"
+        "  Spare the page cache:  filevault decrypt -r backups.fvlt -o /restore --direct-io\n"
+        "  Straight from S3:      filevault decrypt s3://backups/db.dump.fvlt -o db.dump\n"
+        "  Check a backup set:    filevault decrypt -r backups.fvlt --verify-only -T 8\n"
         "\n"
         "Supported formats: .fvlt (FileVault encrypted files)\n"
         "Automatically detects: algorithm, mode, KDF settings from header\n"
@@ -50,8 +178,100 @@ void DecryptCommand::setup(CLI::App& app) {
 
 int DecryptCommand::execute() {
     try {
+        // "-" selects stdin/stdout; keep stdout clean for the plaintext
+        bool pipe_mode = input_file_ == "-" || output_file_ == "-";
+        if (pipe_mode) {
+            utils::Console::set_stream(stderr);
+        }
+        
         utils::Console::header("FileVault Decryption");
         
+        // The performance profile fills in what the command line left open
+        const auto& user_config = utils::Config::current();
+        if (threads_ == 0) {
+            threads_ = user_config.get_threads();
+        }
+        direct_io_ = direct_io_ || user_config.get_direct_io();
+        
+        bool directory_input = !pipe_mode && std::filesystem::is_directory(input_file_);
+        if (recursive_ != directory_input) {
+            utils::Console::error(recursive_ ? "--recursive needs an input directory"
+                                             : input_file_ + " is a directory (use --recursive)");
+            return 1;
+        }
+        
+        // Objects are read in ranges by the chunked decoder, and decrypt
+        // into the current directory unless told otherwise
+        auto object_url = utils::ObjectUrl::parse(input_file_);
+        if (object_url && resume_) {
+            utils::Console::error("--resume needs an input file, not an s3:// object");
+            return 1;
+        }
+        if (verify_only_ && (pipe_mode || object_url || !output_file_.empty() || resume_)) {
+            utils::Console::error("--verify-only reads local files and writes no output");
+            return 1;
+        }
+        
+        // Output split with --split-size: named by its manifest, any part, or the unsplit name
+        if (!pipe_mode && !recursive_ && !object_url && !utils::FileIO::file_exists(input_file_) &&
+            utils::PartSet::is_part_set(utils::PartSet::manifest_path(input_file_))) {
+            input_file_ = utils::PartSet::manifest_path(input_file_);
+        }
+        bool part_input = !pipe_mode && !recursive_ && !object_url && utils::PartSet::is_part_set(input_file_);
+        if (part_input && (resume_ || verify_only_)) {
+            utils::Console::error("Part files are decrypted in one pass, without --resume or --verify-only");
+            return 1;
+        }
+        if (part_input && output_file_.empty()) {
+            auto base = input_file_.ends_with(".parts")
+                ? input_file_.substr(0, input_file_.size() - 6)
+                : input_file_.substr(0, input_file_.rfind(".part"));
+            output_file_ = base.size() > 5 && base.ends_with(".fvlt")
+                ? base.substr(0, base.size() - 5)
+                : base + ".decrypted";
+        }
+        if (object_url && output_file_.empty()) {
+            output_file_ = std::filesystem::path(object_url->key).filename().string();
+            output_file_ = output_file_.size() > 5 && output_file_.ends_with(".fvlt")
+                ? output_file_.substr(0, output_file_.size() - 5)
+                : output_file_ + ".decrypted";
+        }
+        
+        // Files encrypted to a public key need the private key, not a password
+        bool envelope_file = !pipe_mode && !recursive_ && !object_url &&
+                             core::EnvelopeCrypto::is_envelope_file(input_file_);
+        if (!private_key_path_.empty() || envelope_file) {
+            if (private_key_path_.empty()) {
+                utils::Console::error("File is encrypted to a public key; use --private-key");
+                return 1;
+            }
+            if (verify_only_) {
+                return execute_verify();
+            }
+            if (recursive_) {
+                return execute_recursive();
+            }
+            if (output_file_.empty()) {
+                output_file_ = input_file_.size() > 5 && input_file_.ends_with(".fvlt")
+                    ? input_file_.substr(0, input_file_.size() - 5)
+                    : input_file_ + ".decrypted";
+            }
+            return execute_streaming();
+        }
+        
+        // The terminal prompt would read from (or print into) the data stream
+        if (pipe_mode && password_.empty()) {
+            utils::Console::error("Pipe mode needs --password: stdin/stdout carry the data");
+            return 1;
+        }
+        
+        // Header, cipher and first chunks need no key: ready them during the prompt.
+        // The task keeps running alongside key derivation; leaving execute() joins it
+        std::future<void> prepared;
+        if (password_.empty() && !pipe_mode && !object_url && !part_input && !recursive_) {
+            prepared = std::async(std::launch::async, prepare_input, input_file_, std::ref(engine_), direct_io_);
+        }
+        
         // Get password securely if not provided
         if (password_.empty()) {
             password_ = utils::Password::read_secure("Enter decryption password: ", false);
@@ -63,6 +283,16 @@ int DecryptCommand::execute() {
             utils::Console::warning("Using password from command line is insecure!");
         }
         
+        if (verify_only_) {
+            return execute_verify();
+        }
+        if (pipe_mode || object_url || part_input) {
+            return execute_streaming();
+        }
+        if (recursive_) {
+            return execute_recursive();
+        }
+        
         // Set output file if not specified
         if (output_file_.empty()) {
             output_file_ = input_file_;
@@ -74,31 +304,43 @@ int DecryptCommand::execute() {
             }
         }
         
+        // Chunked (FVAULT02 and FVST) files are decrypted block by block;
+        // armor only ever wraps the chunked format
+        if (core::StreamingCrypto::is_streaming_file(input_file_) || utils::is_armored_file(input_file_)) {
+            return execute_streaming();
+        }
+        if (resume_) {
+            utils::Console::error("--resume applies to chunked (FVAULT02) files only");
+            return 1;
+        }
+        
         utils::Console::info(fmt::format("Input:  {}", input_file_));
         utils::Console::info(fmt::format("Output: {}", output_file_));
         utils::Console::separator();
         
         // Read encrypted file
-        auto file_result = utils::FileIO::read_file(input_file_);
+        auto file_result = utils::FileIO::map_file(input_file_);
         if (!file_result) {
             utils::Console::error(file_result.error_message);
             return 1;
         }
         
-        const auto& encrypted_file = file_result.value;
+        std::span<const uint8_t> encrypted_file = file_result.value.span();
         utils::Console::info(fmt::format("Read {} bytes", encrypted_file.size()));
         
         // Check if this is enhanced or legacy format
         bool is_enhanced = !core::FileFormatHandler::is_legacy_format(input_file_);
         
         core::FileHeader enhanced_header;
-        std::vector<uint8_t> ciphertext_data;
+        std::span<const uint8_t> ciphertext_data;   // Into the mapped file, never copied
         std::vector<uint8_t> auth_tag_data;
         std::vector<uint8_t> salt_data;
         std::vector<uint8_t> nonce_data;
         core::AlgorithmType algo_type;
         core::KDFType kdf_type;
         bool is_compressed = false;
+        uint32_t dictionary_id = 0;             // Compression dictionary, if any
+        std::optional<uint64_t> original_size;  // Plaintext size, if the header records it
         
         // Variables to store KDF params from header
         uint32_t kdf_memory_kb = 0;
@@ -109,15 +351,22 @@ int DecryptCommand::execute() {
         if (is_enhanced) {
             // Enhanced format with full header
             try {
-                auto [header, ciphertext, auth_tag] = core::FileFormatHandler::read_file(input_file_);
+                // Header from a positional read; payload and tag are views of the mapping
+                auto layout = core::FileFormatHandler::read_header(input_file_);
+                if (layout.file_size != encrypted_file.size()) {
+                    throw std::runtime_error("File changed while reading");
+                }
+                const auto& header = layout.header;
                 enhanced_header = header;
-                ciphertext_data = ciphertext;
-                auth_tag_data = auth_tag;
+                ciphertext_data = encrypted_file.subspan(layout.ciphertext_offset, layout.ciphertext_size);
+                auto tag = encrypted_file.subspan(layout.tag_offset(), layout.tag_size);
+                auth_tag_data.assign(tag.begin(), tag.end());
                 salt_data = header.salt;
                 nonce_data = header.nonce;
                 algo_type = core::FileFormatHandler::from_algorithm_id(header.algorithm);
                 kdf_type = core::FileFormatHandler::from_kdf_id(header.kdf);
                 is_compressed = header.compressed;
+                dictionary_id = header.dictionary_id;
                 
                 // Parse KDF params from header
                 if (!header.kdf_params.empty()) {
@@ -137,7 +386,8 @@ int DecryptCommand::execute() {
                     }
                 }
                 
-                utils::Console::info("Format: Enhanced (v1.0)");
+                utils::Console::info(fmt::format("Format: Enhanced (v{}.{})",
+                                                 header.version_major, header.version_minor));
             } catch (const std::exception& e) {
                 utils::Console::error(fmt::format("Failed to parse enhanced format: {}", e.what()));
                 return 1;
@@ -145,35 +395,30 @@ int DecryptCommand::execute() {
         } else {
             // Legacy format - try old header parser
             utils::Console::info("Format: Legacy");
-            auto header_result = format::FileHeader::deserialize(encrypted_file);
+            auto header_result = core::LegacyHeaderView::parse(encrypted_file);
             if (!header_result) {
                 utils::Console::error(header_result.error_message);
                 return 1;
             }
             
-            auto header = header_result.value;
+            const auto& header = header_result.value;
             if (!header.validate()) {
                 utils::Console::error("Invalid file header");
                 return 1;
             }
             
-            salt_data = header.salt();
-            nonce_data = header.nonce();
-            algo_type = header.algorithm();
-            kdf_type = header.kdf();
+            salt_data.assign(header.salt.begin(), header.salt.end());
+            nonce_data.assign(header.nonce.begin(), header.nonce.end());
+            auth_tag_data.assign(header.tag.begin(), header.tag.end());
+            algo_type = header.algorithm;
+            kdf_type = header.kdf;
             is_compressed = header.is_compressed();
-            
-            // Extract ciphertext (skip old header)
-            size_t header_size = header.total_size();
-            if (encrypted_file.size() < header_size) {
-                utils::Console::error("File corrupted: too small");
-                return 1;
+            if (header.original_size > 0) {
+                original_size = header.original_size;
             }
             
-            ciphertext_data.assign(
-                encrypted_file.begin() + header_size,
-                encrypted_file.end()
-            );
+            // Ciphertext follows the old header (parse() checked it fits)
+            ciphertext_data = encrypted_file.subspan(header.size);
         }
         
         utils::Console::info(fmt::format("Algorithm: {}", engine_.algorithm_name(algo_type)));
@@ -186,6 +431,12 @@ int DecryptCommand::execute() {
             return 1;
         }
         
+        if (nonce_data.size() > core::ShortBytes::capacity() ||
+            auth_tag_data.size() > core::ShortBytes::capacity()) {
+            utils::Console::error("Invalid file header: nonce or tag too long");
+            return 1;
+        }
+        
         // Setup config for key derivation and decryption
         core::EncryptionConfig config;
         config.algorithm = algo_type;
@@ -218,9 +469,19 @@ int DecryptCommand::execute() {
             kdf_progress->mark_as_completed();
         }
         
-        // Prepare ciphertext for decryption
+        // Version 1.2 headers say up front whether the key is right
+        if (is_enhanced && !enhanced_header.matches_key(key)) {
+            utils::Console::error("Wrong password (key check failed)");
+            return 1;
+        }
+        
         // GCM algorithm expects config.nonce and config.tag, ciphertext WITHOUT tag
-        std::vector<uint8_t> ciphertext_to_decrypt = ciphertext_data;
+        
+        // AEAD payloads decrypt piece by piece, in constant memory
+        if (auto status = decrypt_incremental(*algorithm, key, config, ciphertext_data,
+                                              is_compressed, dictionary_id, original_size)) {
+            return *status;
+        }
         
         // Step 2: Decrypt
         utils::Console::info("Decrypting...");
@@ -230,7 +491,7 @@ int DecryptCommand::execute() {
             decrypt_progress->set_progress(50);
         }
         
-        auto decrypt_result = algorithm->decrypt(ciphertext_to_decrypt, key, config);
+        auto decrypt_result = algorithm->decrypt(ciphertext_data, key, config);
         
         if (decrypt_progress) {
             decrypt_progress->mark_as_completed();
@@ -257,15 +518,42 @@ int DecryptCommand::execute() {
                 decompress_progress->set_progress(50);
             }
             
-            // Determine compression type from header (for now assume zlib/lzma based on size)
-            // TODO: Add compression type to file header
-            auto decompressor = compression::CompressionService::create(core::CompressionType::LZMA);
+            // The header only flags compression; identify the format by its
+            // magic bytes, falling back to LZMA then ZLIB
+            auto detected = compression::CompressionService::detect(plaintext);
+            auto decompressor = compression::CompressionService::create(
+                detected.value_or(core::CompressionType::LZMA));
             if (!decompressor) {
                 decompressor = compression::CompressionService::create(core::CompressionType::ZLIB);
             }
             
+            // Small files may have been compressed with a trained dictionary
+            std::vector<uint8_t> dictionary;
+            if (dictionary_id != 0) {
+                compression::DictionaryStore store(utils::Config::get_dictionary_dir());
+                auto loaded = store.load(dictionary_id);
+                if (!loaded) {
+                    utils::Console::error(loaded.error_message);
+                    return 1;
+                }
+                dictionary = std::move(loaded.value);
+                if (decompressor && !decompressor->set_dictionary(dictionary)) {
+                    utils::Console::error(fmt::format("{} does not support compression dictionaries",
+                                                      decompressor->name()));
+                    return 1;
+                }
+                spdlog::info("Using compression dictionary {}",
+                             compression::DictionaryStore::format_id(dictionary_id));
+            }
+            
+            // With the size known, decompress once into an exact-size buffer
+            auto decompress_with = [&original_size](compression::ICompressor& c, std::span<const uint8_t> data) {
+                return original_size ? c.decompress(data, static_cast<size_t>(*original_size))
+                                     : c.decompress(data);
+            };
+            
             if (decompressor) {
-                auto decompress_result = decompressor->decompress(plaintext);
+                auto decompress_result = decompress_with(*decompressor, plaintext);
                 if (decompress_result.success) {
                     plaintext = std::move(decompress_result.data);
                     utils::Console::info(fmt::format("Decompressed: {} -> {} bytes",
@@ -275,7 +563,8 @@ int DecryptCommand::execute() {
                     // Try other compressor
                     auto decompressor2 = compression::CompressionService::create(core::CompressionType::ZLIB);
                     if (decompressor2) {
-                        auto result2 = decompressor2->decompress(decrypt_result.data);
+                        decompressor2->set_dictionary(dictionary);
+                        auto result2 = decompress_with(*decompressor2, decrypt_result.data);
                         if (result2.success) {
                             plaintext = std::move(result2.data);
                             utils::Console::info(fmt::format("Decompressed: {} -> {} bytes",
@@ -294,11 +583,17 @@ int DecryptCommand::execute() {
         }
         
         // Write output
-        auto write_result = utils::FileIO::write_file(output_file_, plaintext);
+        auto write_result = utils::FileIO::write_file(output_file_, plaintext, direct_io_);
         if (!write_result) {
             utils::Console::error(write_result.error_message);
             return 1;
         }
+        if (direct_io_) {
+            utils::FileIO::drop_cache(input_file_);
+        }
+        
+        utils::RunStats::instance().add_bytes(utils::FileIO::file_size(input_file_), plaintext.size());
+        utils::RunStats::instance().add_files(1);
         
         utils::Console::separator();
         utils::Console::success("Decryption completed!");
@@ -314,5 +609,696 @@ int DecryptCommand::execute() {
     }
 }
 
+std::optional<int> DecryptCommand::decrypt_incremental(
+    core::ICryptoAlgorithm& algorithm,
+    std::span<const uint8_t> key,
+    const core::EncryptionConfig& config,
+    std::span<const uint8_t> ciphertext,
+    bool compressed,
+    uint32_t dictionary_id,
+    std::optional<uint64_t> original_size) {
+    
+    auto session = algorithm.create_session(key);
+    if (!session || !session->decrypt_begin(config)) {
+        return std::nullopt;
+    }
+    
+    // Whole multiples of the cipher's preferred piece size
+    size_t granularity = session->decrypt_granularity();
+    size_t piece_size = std::max(granularity, INCREMENTAL_PIECE_SIZE / granularity * granularity);
+    
+    // Unauthenticated plaintext stays under a temporary name
+    utils::OutputFileOptions options;
+    options.atomic = true;
+    options.bypass_cache = direct_io_;
+    options.preallocate = compressed ? original_size.value_or(0) : ciphertext.size();
+    utils::OutputFile output(output_file_, options);
+    if (!output.is_open()) {
+        utils::Console::error("Cannot create output file: " + output_file_);
+        return 1;
+    }
+    
+    // Compressed payloads are decompressed as the plaintext arrives; the
+    // format is identified from the first piece, as in memory
+    std::unique_ptr<compression::ICompressor> decompressor;
+    std::vector<uint8_t> dictionary;
+    std::vector<uint8_t> decompressed;
+    uint64_t written = 0;
+    bool decompress_failed = false;
+    
+    auto write = [&](std::span<const uint8_t> data) {
+        output.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        written += data.size();
+        return static_cast<bool>(output);
+    };
+    auto emit = [&](std::span<const uint8_t> plain) {
+        if (!compressed) {
+            return write(plain);
+        }
+        if (decompress_failed) {
+            return true;
+        }
+        if (!decompressor && !plain.empty()) {
+            auto detected = compression::CompressionService::detect(plain);
+            decompressor = compression::CompressionService::create(detected.value_or(core::CompressionType::LZMA));
+            if (!decompressor || (!dictionary.empty() && !decompressor->set_dictionary(dictionary)) ||
+                !decompressor->begin(compression::StreamMode::DECOMPRESS)) {
+                decompress_failed = true;
+                return true;
+            }
+        }
+        if (decompressor) {
+            decompressed.clear();
+            if (!decompressor->update(plain, decompressed)) {
+                decompress_failed = true;
+                return true;
+            }
+            return write(decompressed);
+        }
+        return true;
+    };
+    
+    if (compressed && dictionary_id != 0) {
+        compression::DictionaryStore store(utils::Config::get_dictionary_dir());
+        auto loaded = store.load(dictionary_id);
+        if (!loaded) {
+            utils::Console::error(loaded.error_message);
+            return 1;
+        }
+        dictionary = std::move(loaded.value);
+    }
+    
+    utils::Console::info("Decrypting...");
+    std::unique_ptr<utils::ProgressBar> progress;
+    if (!no_progress_) {
+        progress = std::make_unique<utils::ProgressBar>("Decrypting", 100);
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> piece;
+    piece.reserve(piece_size + 16);
+    size_t offset = 0;
+    
+    // The last piece, however short, goes to decrypt_finish() with the tag
+    while (ciphertext.size() - offset > piece_size) {
+        piece.assign(ciphertext.begin() + offset, ciphertext.begin() + offset + piece_size);
+        size_t produced = session->decrypt_update(piece);
+        if (!emit(std::span<const uint8_t>(piece).first(produced))) {
+            utils::Console::error("Failed to write output file: " + output_file_);
+            return 1;
+        }
+        offset += piece_size;
+        if (progress) {
+            progress->set_progress(offset * 100 / ciphertext.size());
+        }
+    }
+    
+    piece.assign(ciphertext.begin() + offset, ciphertext.end());
+    auto finished = session->decrypt_finish(piece);
+    if (!finished.success) {
+        output.close();
+        utils::Console::error(finished.error_message);
+        if (finished.error_message.find("Authentication failed") != std::string::npos) {
+            utils::Console::error("Wrong password or file corrupted/tampered");
+        }
+        return 1;
+    }
+    
+    bool write_ok = emit(piece);
+    if (compressed && decompressor && !decompress_failed) {
+        decompressed.clear();
+        decompress_failed = !decompressor->finish(decompressed);
+        write_ok = write_ok && (decompress_failed || write(decompressed));
+    }
+    if (compressed && (decompress_failed || !decompressor ||
+                       (original_size && written != *original_size))) {
+        // Authentic but not in a format the stream decoder takes: the
+        // in-memory path has more fallbacks
+        output.close();
+        spdlog::info("Streaming decompression failed, decrypting in memory");
+        return std::nullopt;
+    }
+    if (!write_ok || !output.commit()) {
+        utils::Console::error("Failed to write output file: " + output_file_);
+        return 1;
+    }
+    if (progress) {
+        progress->mark_as_completed();
+    }
+    if (direct_io_) {
+        utils::FileIO::drop_cache(input_file_);
+    }
+    
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    utils::Console::info(fmt::format("Decrypted in {:.2f}ms", elapsed_ms));
+    
+    utils::RunStats::instance().add_bytes(utils::FileIO::file_size(input_file_), written);
+    utils::RunStats::instance().add_files(1);
+    
+    utils::Console::separator();
+    utils::Console::success("Decryption completed!");
+    utils::Console::info(fmt::format("Output: {} ({})",
+                       output_file_,
+                       utils::CryptoUtils::format_bytes(written)));
+    return 0;
+}
+
+int DecryptCommand::execute_streaming() {
+    bool from_stdin = input_file_ == "-";
+    bool to_stdout = output_file_ == "-" || (output_file_.empty() && from_stdin);
+    auto object_url = utils::ObjectUrl::parse(input_file_);
+    
+    // Checkpoints need a password job between two regular files
+    bool parts = !from_stdin && !object_url && utils::PartSet::is_part_set(input_file_);
+    bool armored = !from_stdin && !object_url && !parts && utils::is_armored_file(input_file_);
+    bool checkpointed = !from_stdin && !to_stdout && !object_url && !armored && !parts &&
+                        private_key_path_.empty();
+    if (resume_ && !checkpointed) {
+        utils::Console::error("--resume needs an input and an output file and a password");
+        return 1;
+    }
+    
+    utils::Console::info(fmt::format("Input:  {}", from_stdin ? "<stdin>" : input_file_));
+    utils::Console::info(fmt::format("Output: {}", to_stdout ? "<stdout>" : output_file_));
+    utils::Console::separator();
+    
+    // Chunks only store counters; the bar redraws on its own thread
+    core::StreamProgressCallback on_progress;
+    std::unique_ptr<utils::ProgressAggregator> progress;
+    if (!no_progress_ && !from_stdin && !to_stdout) {
+        progress = std::make_unique<utils::ProgressAggregator>("Decrypting", 0);
+        on_progress = [&progress](const core::ChunkInfo& info) {
+            progress->set_total(info.total_bytes);
+            progress->update(info.bytes_processed);
+            return true;
+        };
+    }
+    
+    // Only the chunked (FVAULT02/FVST) format can be decoded without seeking
+    core::StreamingResult result;
+    if (checkpointed) {
+        core::CheckpointOptions checkpoint;
+        checkpoint.interval = checkpoint_interval_;
+        checkpoint.resume = resume_;
+        result = core::StreamingCrypto::decrypt_file(input_file_, output_file_, password_,
+                                                     on_progress, 0, checkpoint, direct_io_);
+        if (progress && result.success) {
+            progress->finish();
+        }
+        return report_streaming(result);
+    }
+    
+    utils::FileIO::set_binary_stdio();
+    
+    utils::InputFileOptions input_options;
+    input_options.direct = direct_io_;
+    utils::OutputFileOptions output_options;
+    output_options.bypass_cache = direct_io_;
+    utils::InputFile file_in;
+    utils::OutputFile file_out;
+    std::unique_ptr<utils::S3Store> store;
+    std::unique_ptr<utils::ObjectInput> object_in;
+    std::unique_ptr<utils::PartInput> parts_in;
+    std::istream* in = &std::cin;
+    std::ostream* out = &std::cout;
+    if (object_url) {
+        auto s3_config = utils::S3Config::from_environment(object_url->bucket);
+        if (!s3_config) {
+            utils::Console::error(s3_config.error_message);
+            return 1;
+        }
+        store = std::make_unique<utils::S3Store>(std::move(s3_config.value));
+        object_in = std::make_unique<utils::ObjectInput>(*store, object_url->key);
+        if (!object_in->is_open()) {
+            utils::Console::error(fmt::format("Failed to open {}: {}", input_file_, object_in->error()));
+            return 1;
+        }
+        in = object_in.get();
+    } else if (parts) {
+        // Each next part is opened and read ahead while the current one is decrypted
+        auto set = utils::PartSet::load(input_file_);
+        if (!set) {
+            utils::Console::error(set.error_message);
+            return 1;
+        }
+        utils::Console::info(fmt::format("Reading {} parts ({})", set.value.parts.size(),
+                                         utils::CryptoUtils::format_bytes(set.value.total_size)));
+        parts_in = std::make_unique<utils::PartInput>(std::move(set.value), input_options);
+        in = parts_in.get();
+    } else if (!from_stdin) {
+        file_in.open(input_file_, input_options);
+        if (!file_in) {
+            utils::Console::error("Failed to open input file: " + input_file_);
+            return 1;
+        }
+        in = &file_in;
+    }
+    std::unique_ptr<utils::ArmorInput> armor_in;
+    if (in->peek() == utils::ARMOR_BEGIN.front()) {
+        armor_in = std::make_unique<utils::ArmorInput>(*in);
+        in = armor_in.get();
+    }
+    if (!to_stdout) {
+        file_out.open(output_file_, output_options);
+        if (!file_out) {
+            utils::Console::error("Failed to create output file: " + output_file_);
+            return 1;
+        }
+        out = &file_out;
+    }
+    
+    if (!private_key_path_.empty()) {
+        auto key_result = utils::FileIO::read_file(private_key_path_);
+        if (!key_result) {
+            utils::Console::error(key_result.error_message);
+            return 1;
+        }
+        result = core::EnvelopeCrypto::decrypt_stream(*in, *out, key_result.value, on_progress, 0);
+    } else {
+        result = core::StreamingCrypto::decrypt_stream(*in, *out, password_, on_progress, 0);
+    }
+    if (armor_in && !armor_in->error().empty()) {
+        result.success = false;
+        result.error_message = "Bad armored input: " + armor_in->error();
+    }
+    if (parts_in && !parts_in->error().empty()) {
+        result.success = false;
+        result.error_message = "Bad part file: " + parts_in->error();
+    }
+    if (progress && result.success) {
+        progress->finish();
+    }
+    return report_streaming(result);
+}
+
+int DecryptCommand::report_streaming(const core::StreamingResult& result) {
+    if (!result.success) {
+        utils::Console::error(result.error_message);
+        if (output_file_ != "-" && utils::FileIO::file_exists(core::Checkpoint::path_for(output_file_))) {
+            utils::Console::info("Run the same command with --resume to continue from the last checkpoint");
+        }
+        return 1;
+    }
+    
+    auto& run_stats = utils::RunStats::instance();
+    bool local_input = input_file_ != "-" && !utils::ObjectUrl::is_object_url(input_file_);
+    run_stats.add_bytes(local_input ? utils::FileIO::file_size(input_file_) : 0, result.bytes_processed);
+    run_stats.add_files(1);
+    run_stats.add_chunks(result.chunks_processed);
+    
+    utils::Console::separator();
+    utils::Console::success("Decryption completed!");
+    if (result.chunks_resumed > 0) {
+        utils::Console::info(fmt::format("Resumed after {} chunks kept from the interrupted run",
+                                         result.chunks_resumed));
+    }
+    utils::Console::info(fmt::format("Processed {} in {} chunks ({:.1f} MB/s)",
+                       utils::CryptoUtils::format_bytes(result.bytes_processed),
+                       result.chunks_processed,
+                       result.throughput_mbps));
+    
+    return 0;
+}
+
+int DecryptCommand::execute_recursive() {
+    namespace fs = std::filesystem;
+    
+    if (resume_) {
+        utils::Console::error("--resume applies to single files, not --recursive");
+        return 1;
+    }
+    
+    std::vector<uint8_t> private_key;
+    bool envelope = !private_key_path_.empty();
+    if (envelope) {
+        auto key_result = utils::FileIO::read_file(private_key_path_);
+        if (!key_result) {
+            utils::Console::error(key_result.error_message);
+            return 1;
+        }
+        private_key = std::move(key_result.value);
+    }
+    
+    // "photos.fvlt" and "photos.fvlt/" both give "photos"
+    auto root = fs::path(input_file_).lexically_normal();
+    if (!root.has_filename()) {
+        root = root.parent_path();
+    }
+    fs::path out_root = output_file_;
+    if (out_root.empty()) {
+        auto name = root.filename().string();
+        if (name == "." || name == "..") {
+            utils::Console::error("Name an output directory for the decrypted tree");
+            return 1;
+        }
+        out_root = name.size() > 5 && name.ends_with(".fvlt")
+            ? root.parent_path() / name.substr(0, name.size() - 5)
+            : fs::path(root.string() + ".decrypted");
+    }
+    auto inside = fs::weakly_canonical(out_root).lexically_relative(fs::weakly_canonical(root));
+    if (!inside.empty() && *inside.begin() != "..") {
+        utils::Console::error("Output directory must not be inside the input directory");
+        return 1;
+    }
+    
+    archive::WalkOptions walk_options;
+    walk_options.include = {"*.fvlt"};
+    auto walk = archive::DirectoryWalker::walk({root}, walk_options);
+    for (const auto& error : walk.errors) {
+        utils::Console::warning("Skipped " + error);
+    }
+    std::vector<core::TreeFile> files;
+    files.reserve(walk.members.size());
+    uint64_t total_bytes = 0;
+    for (const auto& member : walk.members) {
+        auto target = out_root / member.source.lexically_relative(root);
+        target.replace_extension();
+        files.push_back({member.source, std::move(target), member.entry.file_size});
+        total_bytes += member.entry.file_size;
+    }
+    if (files.empty()) {
+        utils::Console::error("No .fvlt files under " + root.string());
+        return 1;
+    }
+    
+    core::TreeRunOptions options;
+    options.workers = threads_;
+    options.large_file_bytes = utils::Config::current().get_streaming_threshold_mb() * 1024 * 1024;
+    
+    utils::Console::info(fmt::format("Input:  {} ({} files)", root.string(), files.size()));
+    utils::Console::info(fmt::format("Output: {}", out_root.string()));
+    utils::Console::separator();
+    
+    std::unique_ptr<utils::ProgressAggregator> progress;
+    if (!no_progress_) {
+        progress = std::make_unique<utils::ProgressAggregator>(fmt::format("Decrypting {} files", files.size()),
+                                                               total_bytes);
+        options.on_advance = [&progress](uint64_t bytes) { progress->add(bytes); };
+    }
+    
+    // Distinct salts cost one KDF per file: run them ahead, within the memory budget
+    auto keys = envelope ? KeySchedule{} : schedule_keys(files, options, password_, kdf_memory_);
+    
+    auto& run_stats = utils::RunStats::instance();
+    auto result = core::TreeRunner::run(files, [&](const core::TreeFile& file, size_t threads,
+                                                   const core::TreeRunner::Advance& advance) {
+        auto source = file.source.string();
+        if (!envelope && core::EnvelopeCrypto::is_envelope_file(source)) {
+            return std::string("encrypted to a public key; use --private-key");
+        }
+        if (!envelope && !core::StreamingCrypto::is_streaming_file(source)) {
+            return std::string("single-payload (v1) file; decrypt it on its own");
+        }
+        keys.wait(source);
+        // Progress is in plaintext bytes; the tree total is in file bytes
+        core::StreamProgressCallback on_progress = [&advance, &file](const core::ChunkInfo& info) {
+            if (info.total_bytes > 0) {
+                advance(file.size * info.bytes_processed / info.total_bytes);
+            }
+            return true;
+        };
+        auto decrypted = envelope
+            ? core::EnvelopeCrypto::decrypt_file(source, file.target.string(), private_key, on_progress,
+                                                 threads, direct_io_)
+            : core::StreamingCrypto::decrypt_file(source, file.target.string(), password_, on_progress,
+                                                  threads, {}, direct_io_);
+        if (!decrypted.success) {
+            return decrypted.error_message;
+        }
+        run_stats.add_bytes(file.size, decrypted.bytes_processed);
+        run_stats.add_files(1);
+        run_stats.add_chunks(decrypted.chunks_processed);
+        return std::string();
+    }, options);
+    
+    if (progress) {
+        progress->finish();
+    }
+    
+    utils::Console::separator();
+    for (const auto& error : result.errors) {
+        utils::Console::error(error);
+    }
+    double mbps = result.seconds > 0 ? result.bytes / (1024.0 * 1024.0) / result.seconds : 0.0;
+    utils::Console::info(fmt::format("Decrypted {} of {} files, {} in {:.2f} s ({:.1f} MB/s)",
+                       result.succeeded, files.size(),
+                       utils::CryptoUtils::format_bytes(result.bytes), result.seconds, mbps));
+    if (!result.errors.empty()) {
+        utils::Console::error(fmt::format("{} files failed", result.errors.size()));
+        return 1;
+    }
+    utils::Console::success("Decryption completed!");
+    return 0;
+}
+
+int DecryptCommand::execute_verify() {
+    namespace fs = std::filesystem;
+    
+    std::vector<uint8_t> private_key;
+    bool envelope = !private_key_path_.empty();
+    if (envelope) {
+        auto key_result = utils::FileIO::read_file(private_key_path_);
+        if (!key_result) {
+            utils::Console::error(key_result.error_message);
+            return 1;
+        }
+        private_key = std::move(key_result.value);
+    }
+    
+    // Verification has no targets: nothing is created or written
+    std::vector<core::TreeFile> files;
+    uint64_t total_bytes = 0;
+    if (recursive_) {
+        archive::WalkOptions walk_options;
+        walk_options.include = {"*.fvlt"};
+        auto walk = archive::DirectoryWalker::walk({fs::path(input_file_)}, walk_options);
+        for (const auto& error : walk.errors) {
+            utils::Console::warning("Skipped " + error);
+        }
+        files.reserve(walk.members.size());
+        for (const auto& member : walk.members) {
+            files.push_back({member.source, {}, member.entry.file_size});
+            total_bytes += member.entry.file_size;
+        }
+        if (files.empty()) {
+            utils::Console::error("No .fvlt files under " + input_file_);
+            return 1;
+        }
+    } else {
+        total_bytes = utils::FileIO::file_size(input_file_);
+        files.push_back({fs::path(input_file_), {}, total_bytes});
+    }
+    
+    core::TreeRunOptions options;
+    options.workers = threads_;
+    options.large_file_bytes = utils::Config::current().get_streaming_threshold_mb() * 1024 * 1024;
+    
+    utils::Console::info(fmt::format("Verifying: {} ({} files, {})", input_file_, files.size(),
+                                     utils::CryptoUtils::format_bytes(total_bytes)));
+    utils::Console::separator();
+    
+    std::unique_ptr<utils::ProgressAggregator> progress;
+    if (!no_progress_) {
+        progress = std::make_unique<utils::ProgressAggregator>(fmt::format("Verifying {} files", files.size()),
+                                                               total_bytes);
+        options.on_advance = [&progress](uint64_t bytes) { progress->add(bytes); };
+    }
+    
+    auto keys = envelope ? KeySchedule{} : schedule_keys(files, options, password_, kdf_memory_);
+    
+    std::mutex report_mutex;
+    std::vector<std::string> passed;    // Listed with -v
+    auto& run_stats = utils::RunStats::instance();
+    auto result = core::TreeRunner::run(files, [&](const core::TreeFile& file, size_t threads,
+                                                   const core::TreeRunner::Advance& advance) {
+        auto source = file.source.string();
+        auto start = std::chrono::steady_clock::now();
+        uint64_t plain_bytes = 0;
+        size_t chunks = 0;
+        
+        bool chunked = envelope || core::StreamingCrypto::is_streaming_file(source) ||
+                       utils::is_armored_file(source);
+        if (!envelope && core::EnvelopeCrypto::is_envelope_file(source)) {
+            return std::string("encrypted to a public key; use --private-key");
+        }
+        if (chunked) {
+            keys.wait(source);
+            // Same pipeline as decryption, chunks on the worker pool, into a sink
+            utils::InputFileOptions input_options;
+            input_options.direct = direct_io_;
+            utils::InputFile file_in(source, input_options);
+            if (!file_in) {
+                return std::string("cannot open file");
+            }
+            std::istream* in = &file_in;
+            std::unique_ptr<utils::ArmorInput> armor_in;
+            if (in->peek() == utils::ARMOR_BEGIN.front()) {
+                armor_in = std::make_unique<utils::ArmorInput>(*in);
+                in = armor_in.get();
+            }
+            core::StreamProgressCallback on_progress = [&advance, &file](const core::ChunkInfo& info) {
+                if (info.total_bytes > 0) {
+                    advance(file.size * info.bytes_processed / info.total_bytes);
+                }
+                return true;
+            };
+            utils::NullOutput sink;
+            auto verified = envelope
+                ? core::EnvelopeCrypto::decrypt_stream(*in, sink, private_key, on_progress, threads)
+                : core::StreamingCrypto::decrypt_stream(*in, sink, password_, on_progress, threads);
+            if (armor_in && !armor_in->error().empty()) {
+                return "bad armored input: " + armor_in->error();
+            }
+            if (!verified.success) {
+                return verified.error_message;
+            }
+            plain_bytes = verified.bytes_processed;
+            chunks = verified.chunks_processed;
+        } else {
+            auto error = verify_payload(source, plain_bytes);
+            if (!error.empty()) {
+                return error;
+            }
+        }
+        run_stats.add_bytes(file.size, plain_bytes);
+        run_stats.add_files(1);
+        run_stats.add_chunks(chunks);
+        
+        if (verbose_) {
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            double mbps = seconds > 0 ? file.size / (1024.0 * 1024.0) / seconds : 0.0;
+            std::lock_guard<std::mutex> lock(report_mutex);
+            passed.push_back(fmt::format("PASS {} ({}, {:.1f} MB/s)", source,
+                                         utils::CryptoUtils::format_bytes(file.size), mbps));
+        }
+        return std::string();
+    }, options);
+    
+    if (progress) {
+        progress->finish();
+    }
+    
+    utils::Console::separator();
+    std::sort(passed.begin(), passed.end());
+    for (const auto& line : passed) {
+        utils::Console::info(line);
+    }
+    for (const auto& error : result.errors) {
+        utils::Console::error("FAIL " + error);
+    }
+    double mbps = result.seconds > 0 ? result.bytes / (1024.0 * 1024.0) / result.seconds : 0.0;
+    utils::Console::info(fmt::format("Verified {} of {} files, {} in {:.2f} s ({:.1f} MB/s), nothing written",
+                       result.succeeded, files.size(),
+                       utils::CryptoUtils::format_bytes(result.bytes), result.seconds, mbps));
+    if (!result.errors.empty()) {
+        utils::Console::error(fmt::format("{} files failed verification", result.errors.size()));
+        return 1;
+    }
+    utils::Console::success("All files authenticated");
+    return 0;
+}
+
+std::string DecryptCommand::verify_payload(const std::string& path, uint64_t& plain_bytes) const {
+    auto file_result = utils::FileIO::map_file(path);
+    if (!file_result) {
+        return file_result.error_message;
+    }
+    std::span<const uint8_t> encrypted_file = file_result.value.span();
+    
+    // Header fields as execute() reads them, without the console output
+    core::EncryptionConfig config;
+    std::span<const uint8_t> ciphertext;
+    std::vector<uint8_t> salt;
+    std::optional<core::FileHeader> header;
+    bool has_kdf_params = false;
+    if (!core::FileFormatHandler::is_legacy_format(path)) {
+        auto layout = core::FileFormatHandler::read_header(path);
+        if (layout.file_size != encrypted_file.size()) {
+            return "file changed while reading";
+        }
+        header = std::move(layout.header);
+        ciphertext = encrypted_file.subspan(layout.ciphertext_offset, layout.ciphertext_size);
+        config.algorithm = core::FileFormatHandler::from_algorithm_id(header->algorithm);
+        config.kdf = core::FileFormatHandler::from_kdf_id(header->kdf);
+        config.nonce = core::ShortBytes(header->nonce);
+        config.tag = core::ShortBytes(encrypted_file.subspan(layout.tag_offset(), layout.tag_size));
+        salt = header->salt;
+        if (!header->kdf_params.empty()) {
+            if (config.kdf == core::KDFType::ARGON2ID || config.kdf == core::KDFType::ARGON2I) {
+                auto params = core::Argon2Params::deserialize(header->kdf_params);
+                config.kdf_memory_kb = params.memory_kb;
+                config.kdf_iterations = params.iterations;
+                config.kdf_parallelism = params.parallelism;
+                has_kdf_params = true;
+            } else if (config.kdf == core::KDFType::PBKDF2_SHA256 || config.kdf == core::KDFType::PBKDF2_SHA512) {
+                config.kdf_iterations = core::PBKDF2Params::deserialize(header->kdf_params).iterations;
+                has_kdf_params = true;
+            }
+        }
+    } else {
+        auto header_result = core::LegacyHeaderView::parse(encrypted_file);
+        if (!header_result) {
+            return header_result.error_message;
+        }
+        const auto& legacy = header_result.value;
+        if (!legacy.validate()) {
+            return "invalid file header";
+        }
+        ciphertext = encrypted_file.subspan(legacy.size);
+        config.algorithm = legacy.algorithm;
+        config.kdf = legacy.kdf;
+        config.nonce = core::ShortBytes(legacy.nonce);
+        config.tag = core::ShortBytes(legacy.tag);
+        salt.assign(legacy.salt.begin(), legacy.salt.end());
+    }
+    if (!has_kdf_params) {
+        config.level = core::SecurityLevel::MEDIUM;
+        config.apply_security_level();
+    }
+    
+    // A local engine: the pool's workers must not share one
+    core::CryptoEngine engine;
+    engine.initialize();
+    auto* algorithm = engine.get_algorithm(config.algorithm);
+    if (!algorithm) {
+        return "algorithm not supported";
+    }
+    auto key = engine.derive_key(password_, salt, config);
+    if (header && !header->matches_key(key)) {
+        return "wrong password (key check failed)";
+    }
+    
+    // Authenticate piece by piece through one reused buffer; without an
+    // incremental session, decrypt in memory and drop the result
+    auto session = algorithm->create_session(key);
+    if (session && session->decrypt_begin(config)) {
+        size_t granularity = session->decrypt_granularity();
+        size_t piece_size = std::max(granularity, INCREMENTAL_PIECE_SIZE / granularity * granularity);
+        std::vector<uint8_t> piece;
+        piece.reserve(piece_size + 16);
+        size_t offset = 0;
+        while (ciphertext.size() - offset > piece_size) {
+            piece.assign(ciphertext.begin() + offset, ciphertext.begin() + offset + piece_size);
+            session->decrypt_update(piece);
+            offset += piece_size;
+        }
+        piece.assign(ciphertext.begin() + offset, ciphertext.end());
+        auto finished = session->decrypt_finish(piece);
+        if (!finished.success) {
+            return finished.error_message;
+        }
+    } else {
+        auto decrypted = algorithm->decrypt(ciphertext, key, config);
+        if (!decrypted.success) {
+            return decrypted.error_message;
+        }
+    }
+    plain_bytes = ciphertext.size();
+    if (direct_io_) {
+        utils::FileIO::drop_cache(path);
+    }
+    return std::string();
+}
+
 } // namespace cli
 } // namespace filevault
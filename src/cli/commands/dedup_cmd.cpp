@@ -0,0 +1,277 @@
+#include "filevault/cli/commands/dedup_cmd.hpp"
+#include "filevault/compression/compressor.hpp"
+#include "filevault/core/crypto_engine.hpp"
+#include "filevault/dedup/chunk_store.hpp"
+#include "filevault/utils/console.hpp"
+#include "filevault/utils/crypto_utils.hpp"
+#include "filevault/utils/file_io.hpp"
+#include "filevault/utils/password.hpp"
+#include <fmt/core.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+namespace filevault {
+namespace cli {
+
+void DedupCommand::setup(CLI::App& app) {
+    auto* dedup_cmd = app.add_subcommand(name(), description());
+
+    auto* init_cmd = dedup_cmd->add_subcommand("init", "Create a chunk store");
+    init_cmd->add_option("store", store_dir_, "Store directory")->required();
+    init_cmd->add_option("-p,--password", password_, "Store password");
+    init_cmd->add_option("-a,--algorithm", algorithm_, "Chunk encryption algorithm")
+        ->check(CLI::IsMember({"aes-128-gcm", "aes-192-gcm", "aes-256-gcm", "chacha20-poly1305"}));
+    init_cmd->add_option("-k,--kdf", kdf_, "Key derivation function")
+        ->check(CLI::IsMember({"argon2id", "argon2i", "pbkdf2-sha256", "pbkdf2-sha512"}));
+    init_cmd->add_option("-s,--security", security_level_, "Security level")
+        ->check(CLI::IsMember({"weak", "medium", "strong", "paranoid"}));
+    init_cmd->add_option("-c,--compression", compression_, "Chunk compression")
+        ->check(CLI::IsMember({"zlib", "bzip2", "lzma", "zstd", "lz4", "none"}));
+    init_cmd->add_option("-l,--level", compression_level_, "Compression level")
+        ->check(CLI::Range(1, 22));
+    init_cmd->add_option("--avg-size", avg_chunk_kb_, "Average chunk size in KB (rounded to a power of two)")
+        ->check(CLI::Range(4, 16384));
+    init_cmd->callback([this]() {
+        subcommand_ = "init";
+        run();
+    });
+
+    auto* backup_cmd = dedup_cmd->add_subcommand("backup", "Store a file, writing only new chunks");
+    backup_cmd->add_option("file", input_file_, "File to back up")
+        ->required()
+        ->check(CLI::ExistingFile);
+    backup_cmd->add_option("--store", store_dir_, "Store directory")
+        ->required()
+        ->check(CLI::ExistingDirectory);
+    backup_cmd->add_option("-o,--output", output_file_, "Manifest file (default: <file>.fvdm)");
+    backup_cmd->add_option("-p,--password", password_, "Store password");
+    backup_cmd->add_option("-T,--threads", threads_, "Threads sealing chunks (0 = one per core)");
+    backup_cmd->callback([this]() {
+        subcommand_ = "backup";
+        run();
+    });
+
+    auto* restore_cmd = dedup_cmd->add_subcommand("restore", "Rebuild a file from its manifest");
+    restore_cmd->add_option("manifest", input_file_, "Manifest written by backup")
+        ->required()
+        ->check(CLI::ExistingFile);
+    restore_cmd->add_option("--store", store_dir_, "Store directory")
+        ->required()
+        ->check(CLI::ExistingDirectory);
+    restore_cmd->add_option("-o,--output", output_file_, "Restored file")->required();
+    restore_cmd->add_option("-p,--password", password_, "Store password");
+    restore_cmd->add_option("-T,--threads", threads_, "Threads opening chunks (0 = one per core)");
+    restore_cmd->callback([this]() {
+        subcommand_ = "restore";
+        run();
+    });
+
+    auto* stats_cmd = dedup_cmd->add_subcommand("stats", "Show store settings and size");
+    stats_cmd->add_option("store", store_dir_, "Store directory")
+        ->required()
+        ->check(CLI::ExistingDirectory);
+    stats_cmd->callback([this]() {
+        subcommand_ = "stats";
+        run();
+    });
+
+    dedup_cmd->footer(
+        "\nExamples:\n"
+        "  Create a store:   filevault dedup init ~/backups/store\n"
+        "  Nightly backup:   filevault dedup backup disk.img --store ~/backups/store -o disk-mon.fvdm\n"
+        "  Restore:          filevault dedup restore disk-mon.fvdm --store ~/backups/store -o disk.img\n"
+        "  Store size:       filevault dedup stats ~/backups/store\n"
+        "\n"
+        "Chunk boundaries follow the content, so data shifted by an edit still\n"
+        "deduplicates. Manifests are authenticated with the store key and are\n"
+        "only readable with the store they were written to.\n"
+    );
+
+    dedup_cmd->require_subcommand(1);
+}
+
+void DedupCommand::run() {
+    int exit_code = execute();
+    if (exit_code != 0) {
+        throw CLI::RuntimeError(exit_code);
+    }
+}
+
+int DedupCommand::execute() {
+    if (subcommand_ == "init") {
+        return init();
+    } else if (subcommand_ == "backup") {
+        return backup();
+    } else if (subcommand_ == "restore") {
+        return restore();
+    } else if (subcommand_ == "stats") {
+        return stats();
+    }
+    return 1;
+}
+
+bool DedupCommand::read_password(bool confirm) {
+    if (password_.empty()) {
+        password_ = utils::Password::read_secure("Enter store password: ", confirm);
+        if (password_.empty()) {
+            utils::Console::error("Password cannot be empty");
+            return false;
+        }
+    }
+    return true;
+}
+
+int DedupCommand::init() {
+    auto algorithm = core::CryptoEngine::parse_algorithm(algorithm_);
+    auto kdf = core::CryptoEngine::parse_kdf(kdf_);
+    auto level = core::CryptoEngine::parse_security_level(security_level_);
+    if (!algorithm || !kdf || !level) {
+        utils::Console::error("Invalid algorithm, KDF or security level");
+        return 1;
+    }
+
+    dedup::StoreConfig config;
+    config.algorithm = *algorithm;
+    config.kdf = *kdf;
+    config.level = *level;
+    config.compression = compression::CompressionService::parse_algorithm(compression_);
+    config.compression_level = compression_level_;
+    config.chunking.avg_size = avg_chunk_kb_ * 1024;
+    config.chunking.min_size = config.chunking.avg_size / 4;
+    config.chunking.max_size = config.chunking.avg_size * 4;
+
+    if (!read_password(true)) {
+        return 1;
+    }
+    dedup::ChunkStore store(store_dir_);
+    auto created = store.create(password_, config);
+    if (!created) {
+        utils::Console::error(created.error_message);
+        return 1;
+    }
+    utils::Console::success(fmt::format("Chunk store created in {} ({}, ~{} chunks)", store_dir_,
+                                        algorithm_,
+                                        utils::CryptoUtils::format_bytes(store.config().chunking.avg_size)));
+    return 0;
+}
+
+int DedupCommand::backup() {
+    if (output_file_.empty()) {
+        output_file_ = input_file_ + ".fvdm";
+    }
+    if (!read_password(false)) {
+        return 1;
+    }
+    dedup::ChunkStore store(store_dir_);
+    auto unlocked = store.unlock(password_);
+    if (!unlocked) {
+        utils::Console::error(unlocked.error_message);
+        return 1;
+    }
+
+    std::ifstream input(input_file_, std::ios::binary);
+    if (!input) {
+        utils::Console::error("Cannot open " + input_file_);
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    dedup::BackupStats stats;
+    auto manifest = store.backup(input, stats, threads_);
+    if (!manifest) {
+        utils::Console::error(manifest.error_message);
+        return 1;
+    }
+    auto written = utils::FileIO::write_file(output_file_, store.serialize_manifest(manifest.value));
+    if (!written) {
+        utils::Console::error(written.error_message);
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    utils::Console::success(fmt::format("Backed up {} to {}", input_file_, output_file_));
+    utils::Console::info(fmt::format("{} chunks, {} new: {} of {} stored as {} ({:.1f}s)",
+                                     stats.chunks, stats.new_chunks,
+                                     utils::CryptoUtils::format_bytes(stats.new_bytes),
+                                     utils::CryptoUtils::format_bytes(stats.bytes),
+                                     utils::CryptoUtils::format_bytes(stats.stored_bytes), seconds));
+    return 0;
+}
+
+int DedupCommand::restore() {
+    auto read_result = utils::FileIO::read_file(input_file_);
+    if (!read_result) {
+        utils::Console::error(read_result.error_message);
+        return 1;
+    }
+    if (!read_password(false)) {
+        return 1;
+    }
+    dedup::ChunkStore store(store_dir_);
+    auto unlocked = store.unlock(password_);
+    if (!unlocked) {
+        utils::Console::error(unlocked.error_message);
+        return 1;
+    }
+    auto manifest = store.parse_manifest(read_result.value);
+    if (!manifest) {
+        utils::Console::error(manifest.error_message);
+        return 1;
+    }
+
+    // Restore next to the target and move it into place only once every chunk checked out
+    auto temp_path = output_file_ + ".tmp";
+    std::error_code ec;
+    {
+        std::ofstream output(temp_path, std::ios::binary | std::ios::trunc);
+        if (!output) {
+            utils::Console::error("Failed to create output file: " + output_file_);
+            return 1;
+        }
+        auto restored = store.restore(manifest.value, output, threads_);
+        output.close();
+        if (!restored || !output) {
+            utils::Console::error(restored ? "Failed to write " + output_file_ : restored.error_message);
+            std::filesystem::remove(temp_path, ec);
+            return 1;
+        }
+    }
+    std::filesystem::rename(temp_path, output_file_, ec);
+    if (ec) {
+        utils::Console::error("Cannot replace " + output_file_ + ": " + ec.message());
+        std::filesystem::remove(temp_path, ec);
+        return 1;
+    }
+    utils::Console::success(fmt::format("Restored {} ({}, {} chunks)", output_file_,
+                                        utils::CryptoUtils::format_bytes(manifest.value.original_size),
+                                        manifest.value.chunks.size()));
+    return 0;
+}
+
+int DedupCommand::stats() {
+    dedup::ChunkStore store(store_dir_);
+    auto opened = store.open();
+    if (!opened) {
+        utils::Console::error(opened.error_message);
+        return 1;
+    }
+
+    const auto& config = store.config();
+    auto usage = store.usage();
+    utils::Console::header("Chunk Store");
+    fmt::print("  Location:     {}\n", store.directory().string());
+    fmt::print("  Algorithm:    {}\n", core::CryptoEngine::algorithm_name(config.algorithm));
+    fmt::print("  KDF:          {} ({})\n", core::CryptoEngine::kdf_name(config.kdf),
+               core::CryptoEngine::security_level_name(config.level));
+    fmt::print("  Compression:  {}\n", compression::CompressionService::get_algorithm_name(config.compression));
+    fmt::print("  Chunk sizes:  {} / {} / {} (min / avg / max)\n",
+               utils::CryptoUtils::format_bytes(config.chunking.min_size),
+               utils::CryptoUtils::format_bytes(config.chunking.avg_size),
+               utils::CryptoUtils::format_bytes(config.chunking.max_size));
+    fmt::print("  Chunks:       {} ({})\n", usage.chunks, utils::CryptoUtils::format_bytes(usage.bytes));
+    return 0;
+}
+
+} // namespace cli
+} // namespace filevault
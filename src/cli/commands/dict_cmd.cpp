@@ -0,0 +1,181 @@
+#include "filevault/cli/commands/dict_cmd.hpp"
+#include "filevault/compression/compressor.hpp"
+#include "filevault/compression/dictionary.hpp"
+#include "filevault/utils/config.hpp"
+#include "filevault/utils/console.hpp"
+#include "filevault/utils/crypto_utils.hpp"
+#include "filevault/utils/file_io.hpp"
+#include <fmt/core.h>
+#include <filesystem>
+
+namespace filevault {
+namespace cli {
+
+// Samples larger than this add little to a dictionary and only slow training
+static constexpr size_t MAX_SAMPLE_SIZE = 1024 * 1024;
+
+void DictCommand::setup(CLI::App& app) {
+    auto* dict_cmd = app.add_subcommand(name(), description());
+    
+    auto* train_cmd = dict_cmd->add_subcommand("train", "Train a dictionary from sample files");
+    train_cmd->add_option("samples", samples_, "Sample files or directories (searched recursively)")
+        ->required()
+        ->check(CLI::ExistingPath);
+    train_cmd->add_option("-s,--size", size_kb_, "Maximum dictionary size in KB")
+        ->check(CLI::Range(1, 1024));
+    train_cmd->add_option("-o,--output", output_file_, "Also write the dictionary to this file");
+    train_cmd->callback([this]() {
+        subcommand_ = "train";
+        run();
+    });
+    
+    auto* list_cmd = dict_cmd->add_subcommand("list", "List stored dictionaries");
+    list_cmd->callback([this]() {
+        subcommand_ = "list";
+        run();
+    });
+    
+    auto* import_cmd = dict_cmd->add_subcommand("import", "Add a dictionary file to the store");
+    import_cmd->add_option("file", input_file_, "Dictionary file")
+        ->required()
+        ->check(CLI::ExistingFile);
+    import_cmd->callback([this]() {
+        subcommand_ = "import";
+        run();
+    });
+    
+    dict_cmd->footer(
+        "\nExamples:\n"
+        "  Train from samples:    filevault dict train configs/ --size 64\n"
+        "  Use when encrypting:   filevault encrypt app.json --compression zstd --dictionary <id>\n"
+        "  Show stored:           filevault dict list\n"
+        "  Copy to another host:  filevault dict import 1a2b3c4d.dict\n"
+        "\n"
+        "Dictionaries work with zlib and zstd. Decryption looks the ID up in\n"
+        "~/.filevault/dictionaries, so import the dictionary on every machine\n"
+        "that decrypts the files.\n"
+    );
+    
+    dict_cmd->require_subcommand(1);
+}
+
+void DictCommand::run() {
+    int exit_code = execute();
+    if (exit_code != 0) {
+        throw CLI::RuntimeError(exit_code);
+    }
+}
+
+int DictCommand::execute() {
+    if (subcommand_ == "train") {
+        return train();
+    } else if (subcommand_ == "list") {
+        return list();
+    } else if (subcommand_ == "import") {
+        return import_file();
+    }
+    return 1;
+}
+
+int DictCommand::train() {
+    namespace fs = std::filesystem;
+    
+    // Gather sample files, expanding directories
+    std::vector<fs::path> paths;
+    for (const auto& sample : samples_) {
+        if (fs::is_directory(sample)) {
+            for (const auto& entry : fs::recursive_directory_iterator(sample)) {
+                if (entry.is_regular_file()) {
+                    paths.push_back(entry.path());
+                }
+            }
+        } else {
+            paths.push_back(sample);
+        }
+    }
+    
+    std::vector<std::vector<uint8_t>> samples;
+    size_t total = 0;
+    for (const auto& path : paths) {
+        auto read_result = utils::FileIO::read_file(path.string());
+        if (!read_result) {
+            utils::Console::warning(read_result.error_message);
+            continue;
+        }
+        auto& data = read_result.value;
+        if (data.size() > MAX_SAMPLE_SIZE) {
+            data.resize(MAX_SAMPLE_SIZE);
+        }
+        total += data.size();
+        samples.push_back(std::move(data));
+    }
+    utils::Console::info(fmt::format("Training on {} samples ({})", samples.size(),
+                                     utils::CryptoUtils::format_bytes(total)));
+    
+    auto trained = compression::CompressionService::train_dictionary(samples, size_kb_ * 1024);
+    if (!trained) {
+        utils::Console::error(trained.error_message);
+        return 1;
+    }
+    
+    compression::DictionaryStore store(utils::Config::get_dictionary_dir());
+    auto saved = store.save(trained.value);
+    if (!saved) {
+        utils::Console::error(saved.error_message);
+        return 1;
+    }
+    if (!output_file_.empty()) {
+        auto write_result = utils::FileIO::write_file(output_file_, trained.value);
+        if (!write_result) {
+            utils::Console::error(write_result.error_message);
+            return 1;
+        }
+    }
+    
+    utils::Console::success(fmt::format("Dictionary {} ({}) stored in {}",
+                                        compression::DictionaryStore::format_id(saved.value),
+                                        utils::CryptoUtils::format_bytes(trained.value.size()),
+                                        store.directory().string()));
+    utils::Console::info(fmt::format("Use it with: --compression zstd --dictionary {}",
+                                     compression::DictionaryStore::format_id(saved.value)));
+    return 0;
+}
+
+int DictCommand::list() {
+    compression::DictionaryStore store(utils::Config::get_dictionary_dir());
+    auto ids = store.list();
+    if (ids.empty()) {
+        utils::Console::info(fmt::format("No dictionaries in {}", store.directory().string()));
+        return 0;
+    }
+    
+    utils::Console::header("Compression Dictionaries");
+    for (uint32_t id : ids) {
+        std::error_code ec;
+        auto size = std::filesystem::file_size(store.path_for(id), ec);
+        fmt::print("  {}  {}\n", compression::DictionaryStore::format_id(id),
+                   ec ? std::string("?") : utils::CryptoUtils::format_bytes(size));
+    }
+    return 0;
+}
+
+int DictCommand::import_file() {
+    auto read_result = utils::FileIO::read_file(input_file_);
+    if (!read_result) {
+        utils::Console::error(read_result.error_message);
+        return 1;
+    }
+    
+    compression::DictionaryStore store(utils::Config::get_dictionary_dir());
+    auto saved = store.save(read_result.value);
+    if (!saved) {
+        utils::Console::error(saved.error_message);
+        return 1;
+    }
+    utils::Console::success(fmt::format("Imported dictionary {}",
+                                        compression::DictionaryStore::format_id(saved.value)));
+    return 0;
+}
+
+} // namespace cli
+} // namespace filevault
@@ -1,10 +1,24 @@
 #include "filevault/cli/commands/dump_cmd.hpp"
+#include "filevault/archive/directory_walker.hpp"
+#include "filevault/core/crypto_engine.hpp"
+#include "filevault/core/file_format.hpp"
+#include "filevault/core/streaming.hpp"
+#include "filevault/core/thread_pool.hpp"
+#include "filevault/utils/armor.hpp"
+#include "filevault/utils/codec_kernels.hpp"
 #include "filevault/utils/console.hpp"
+#include "filevault/utils/crypto_utils.hpp"
 #include "filevault/utils/file_io.hpp"
-#include <botan/hex.h>
-#include <botan/base64.h>
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <future>
 #include <iomanip>
+#include <iterator>
+#include <span>
 #include <sstream>
 #include <bitset>
 
@@ -12,35 +26,189 @@ namespace filevault {
 namespace cli {
 namespace commands {
 
+namespace {
+
+// Enough for any FileVault header: fixed fields, salt, KDF params and nonce
+constexpr size_t HEADER_PEEK_SIZE = 512;
+
+/**
+ * @brief Identify a file and parse its FileVault header from the first bytes
+ */
+nlohmann::json summarize_file(const std::string& path, size_t peek_size) {
+    nlohmann::json summary = {{"file", path}};
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        summary["error"] = "Failed to open file";
+        return summary;
+    }
+    std::error_code ec;
+    summary["size"] = std::filesystem::file_size(path, ec);
+    
+    std::vector<uint8_t> head(peek_size);
+    file.read(reinterpret_cast<char*>(head.data()), static_cast<std::streamsize>(head.size()));
+    head.resize(static_cast<size_t>(file.gcount()));
+    summary["head"] = utils::CryptoUtils::hex_encode(
+        std::span(head.data(), std::min<size_t>(16, head.size())), false);
+    
+    auto starts_with = [&head](const char* magic, size_t length) {
+        return head.size() >= length && std::memcmp(head.data(), magic, length) == 0;
+    };
+    if (starts_with(reinterpret_cast<const char*>(core::FILE_FORMAT_MAGIC), 8)) {
+        summary["format"] = "filevault";
+        try {
+            auto layout = core::FileFormatHandler::read_header(path);
+            const auto& header = layout.header;
+            summary["version"] = fmt::format("{}.{}", header.version_major, header.version_minor);
+            summary["algorithm"] = core::CryptoEngine::algorithm_name(
+                core::FileFormatHandler::from_algorithm_id(header.algorithm));
+            summary["kdf"] = core::CryptoEngine::kdf_name(core::FileFormatHandler::from_kdf_id(header.kdf));
+            summary["compression"] = core::FileFormatHandler::from_compression_id(header.compression);
+            summary["header_size"] = layout.header_size;
+            summary["ciphertext_size"] = layout.ciphertext_size;
+            summary["key_check"] = !header.key_check.empty();
+        } catch (const std::exception& e) {
+            summary["error"] = std::string("Unreadable header: ") + e.what();
+        }
+    } else if (starts_with(reinterpret_cast<const char*>(core::FILE_FORMAT_MAGIC_V2), 8) ||
+               starts_with("FVST", 4)) {
+        summary["format"] = starts_with("FVST", 4) ? "stream" : "filevault";
+        if (auto info = core::StreamingCrypto::read_info(path)) {
+            summary["version"] = info->authenticated_header ? std::string("2.0") : fmt::format("stream v{}", info->version);
+            summary["algorithm"] = core::CryptoEngine::algorithm_name(info->algorithm);
+            summary["kdf"] = core::CryptoEngine::kdf_name(info->kdf);
+            summary["chunk_size"] = info->chunk_size;
+            if (info->chunk_count) {
+                summary["chunks"] = *info->chunk_count;
+            }
+            summary["header_size"] = info->header_size;
+            summary["header_authenticated"] = info->authenticated_header;
+            summary["wrapped_key"] = info->wrapped_key;
+            summary["key_generation"] = info->key_generation;
+            summary["wide_frames"] = info->wide_frames;
+            summary["fingerprint"] = !info->fingerprint.empty();
+        } else {
+            summary["error"] = "Unreadable stream header";
+        }
+    } else if (starts_with("FVEN", 4)) {
+        summary["format"] = "envelope";
+    } else if (starts_with(utils::ARMOR_BEGIN.data(), utils::ARMOR_BEGIN.size())) {
+        summary["format"] = "armored";
+    } else {
+        summary["format"] = "unknown";
+    }
+    return summary;
+}
+
+// Whole hex (16) and binary (8) rows, and 57 bytes per 76-column base64 line
+constexpr size_t DUMP_BLOCK_SIZE = 57 * 1152;
+
+/**
+ * @brief Hexdump rows: offset | hex bytes | ASCII
+ */
+void render_hex(std::span<const uint8_t> block, uint64_t base, bool show_offset, bool show_ascii,
+                std::string& out) {
+    std::string hex(utils::codec::hex_encoded_size(block.size()), '\0');
+    utils::codec::hex_encode(block, hex);
+    for (size_t i = 0; i < block.size(); i += 16) {
+        if (show_offset) {
+            fmt::format_to(std::back_inserter(out), "{:08x}  ", base + i);
+        }
+        
+        size_t line_len = std::min(size_t(16), block.size() - i);
+        for (size_t j = 0; j < 16; j++) {
+            if (j < line_len) {
+                out.append(hex, 2 * (i + j), 2);
+                out += ' ';
+            } else {
+                out += "   ";
+            }
+            if (j == 7) out += ' ';
+        }
+        
+        if (show_ascii) {
+            out += " |";
+            for (size_t j = 0; j < line_len; j++) {
+                uint8_t c = block[i + j];
+                out += (c >= 32 && c < 127) ? char(c) : '.';
+            }
+            out += '|';
+        }
+        out += '\n';
+    }
+}
+
+/**
+ * @brief Eight bytes per row in binary
+ */
+void render_binary(std::span<const uint8_t> block, uint64_t base, bool show_offset, std::string& out) {
+    for (size_t i = 0; i < block.size(); i += 8) {
+        if (show_offset) {
+            fmt::format_to(std::back_inserter(out), "{:08x}  ", base + i);
+        }
+        size_t line_len = std::min(size_t(8), block.size() - i);
+        for (size_t j = 0; j < line_len; j++) {
+            out += std::bitset<8>(block[i + j]).to_string();
+            out += ' ';
+        }
+        out += '\n';
+    }
+}
+
+/**
+ * @brief Base64 wrapped at 76 characters (MIME)
+ */
+void render_base64(std::span<const uint8_t> block, std::string& out) {
+    char line[76];
+    for (size_t i = 0; i < block.size(); i += 57) {
+        size_t written = utils::codec::base64_encode(block.subspan(i, std::min(size_t(57), block.size() - i)), line);
+        out.append(line, written);
+        out += '\n';
+    }
+}
+
+} // anonymous namespace
+
 DumpCommand::DumpCommand() = default;
 
 void DumpCommand::setup(CLI::App& app) {
     auto* cmd = app.add_subcommand(name_, description_);
     
-    cmd->add_option("file", file_path_, "File to dump")
-        ->required()
-        ->check(CLI::ExistingFile);
+    cmd->add_option("files", file_paths_, "File to dump; several files, directories or quoted globs "
+                    "give a header summary per file")
+        ->required();
     
     cmd->add_option("-f,--format", format_, "Output format: hex, binary, base64")
         ->default_val("hex")
         ->check(CLI::IsMember({"hex", "binary", "base64"}));
     
-    cmd->add_option("-n,--max-bytes", max_bytes_, 
-                    "Maximum bytes to display (0 = all)")
+    cmd->add_option("-n,--max-bytes,--length", max_bytes_,
+                    "Maximum bytes to display (0 = to the end of the file or chunk)")
         ->default_val(0);
     
+    auto* offset_opt = cmd->add_option("--offset", offset_, "First byte to display");
+    
+    cmd->add_option("--chunk", chunk_, "Display frame N (from 0) of a streaming (v2) file")
+        ->excludes(offset_opt);
+    
     cmd->add_flag("--no-offset", [this](int64_t) { show_offset_ = false; },
                   "Hide byte offset column");
     
     cmd->add_flag("--no-ascii", [this](int64_t) { show_ascii_ = false; },
                   "Hide ASCII column (hex format only)");
     
+    cmd->add_flag("--json", json_, "Header summary as one JSON object per file (JSON lines)");
+    
+    cmd->add_option("-T,--threads", threads_, "Files summarized in parallel (0 = one per core)");
+    
     cmd->footer(
         "\nExamples:\n"
         "  Hex dump entire file:       filevault dump secret.bin\n"
         "  Binary dump first 256 bytes: filevault dump data.dat -f binary -n 256\n"
         "  Base64 dump file:           filevault dump image.png -f base64\n"
         "  Hex dump without ASCII:     filevault dump document.pdf --no-ascii\n"
+        "  Bytes from the middle:      filevault dump disk.img --offset 1048576 --length 512\n"
+        "  One chunk of a large file:  filevault dump backup.fvlt --chunk 5000\n"
+        "  Audit encrypted headers:    filevault dump vault/ --json > headers.jsonl\n"
         "\n"
         "Formats: hex (default), binary, base64\n"
     );
@@ -54,92 +222,77 @@ void DumpCommand::setup(CLI::App& app) {
 }
 
 int DumpCommand::execute() {
+    if (file_paths_.size() == 1 && !json_ && std::filesystem::is_regular_file(file_paths_.front())) {
+        return dump_file(file_paths_.front());
+    }
+    return summarize_files();
+}
+
+int DumpCommand::dump_file(const std::string& path) {
     try {
-        // Read file
-        std::ifstream file(file_path_, std::ios::binary);
-        if (!file) {
-            utils::Console::error(fmt::format("Failed to open file: {}", file_path_));
+        // Only the shown range is read, block by block, with positional reads
+        auto opened = utils::RandomAccessFile::open(path, false);
+        if (!opened) {
+            utils::Console::error(fmt::format("Failed to open file: {}", path));
             return 1;
         }
+        const auto& file = opened.value;
+        uint64_t file_size = file.size();
         
-        // Get file size
-        file.seekg(0, std::ios::end);
-        size_t file_size = file.tellg();
-        file.seekg(0, std::ios::beg);
-        
-        // Determine how many bytes to read
-        size_t bytes_to_read = max_bytes_ > 0 ? std::min(max_bytes_, file_size) : file_size;
-        
-        // Read file content
-        std::vector<uint8_t> buffer(bytes_to_read);
-        file.read(reinterpret_cast<char*>(buffer.data()), bytes_to_read);
-        file.close();
+        // A chunk is found from the frame index or by walking frame
+        // headers up to it; the payload before it is never read
+        uint64_t begin = offset_;
+        uint64_t end = file_size;
+        if (chunk_) {
+            auto frame = core::StreamingCrypto::locate_frame(path, *chunk_);
+            if (!frame) {
+                utils::Console::error(fmt::format("{} has no chunk {} (not a streaming file, or fewer chunks)",
+                                                  path, *chunk_));
+                return 1;
+            }
+            begin = frame->offset;
+            end = frame->offset + frame->size;
+            utils::Console::info(fmt::format("Chunk: {} at offset {}, {} bytes{}", *chunk_, frame->offset,
+                                             frame->size,
+                                             frame->zero_extent ? " (zero extent)"
+                                             : frame->compressed ? " (compressed)" : ""));
+        }
+        if (begin > file_size) {
+            utils::Console::error(fmt::format("Offset {} is past the end of {} ({} bytes)", begin, path, file_size));
+            return 1;
+        }
+        if (max_bytes_ > 0) {
+            end = std::min<uint64_t>(end, begin + max_bytes_);
+        }
         
         // Display header
-        utils::Console::info(fmt::format("File: {}", file_path_));
+        utils::Console::info(fmt::format("File: {}", path));
         utils::Console::info(fmt::format("Size: {} bytes", file_size));
-        if (max_bytes_ > 0 && bytes_to_read < file_size) {
-            utils::Console::info(fmt::format("Showing first {} bytes", bytes_to_read));
+        if (begin > 0 || end < file_size) {
+            utils::Console::info(fmt::format("Showing bytes {}-{} ({} bytes)", begin, end, end - begin));
         }
         utils::Console::info(fmt::format("Format: {}", format_));
         fmt::print("\n");
         
-        // Dump content based on format
-        if (format_ == "hex") {
-            // Hexdump format: offset | hex bytes | ASCII
-            for (size_t i = 0; i < buffer.size(); i += 16) {
-                // Offset
-                if (show_offset_) {
-                    fmt::print("{:08x}  ", i);
-                }
-                
-                // Hex bytes
-                size_t line_len = std::min(size_t(16), buffer.size() - i);
-                for (size_t j = 0; j < 16; j++) {
-                    if (j < line_len) {
-                        fmt::print("{:02x} ", buffer[i + j]);
-                    } else {
-                        fmt::print("   ");
-                    }
-                    if (j == 7) fmt::print(" ");
-                }
-                
-                // ASCII
-                if (show_ascii_) {
-                    fmt::print(" |");
-                    for (size_t j = 0; j < line_len; j++) {
-                        uint8_t c = buffer[i + j];
-                        fmt::print("{}", (c >= 32 && c < 127) ? char(c) : '.');
-                    }
-                    fmt::print("|");
-                }
-                
-                fmt::print("\n");
+        std::vector<uint8_t> buffer(static_cast<size_t>(std::min<uint64_t>(DUMP_BLOCK_SIZE, end - begin)));
+        std::string text;
+        for (uint64_t pos = begin; pos < end; pos += buffer.size()) {
+            auto block = std::span(buffer).first(static_cast<size_t>(std::min<uint64_t>(buffer.size(), end - pos)));
+            auto read = file.read_at(pos, block);
+            if (!read) {
+                utils::Console::error(read.error_message);
+                return 1;
             }
-        } else if (format_ == "binary") {
-            // Binary format: offset | binary representation
-            for (size_t i = 0; i < buffer.size(); i += 8) {
-                // Offset
-                if (show_offset_) {
-                    fmt::print("{:08x}  ", i);
-                }
-                
-                // Binary bytes
-                size_t line_len = std::min(size_t(8), buffer.size() - i);
-                for (size_t j = 0; j < line_len; j++) {
-                    fmt::print("{:08b} ", std::bitset<8>(buffer[i + j]).to_ulong());
-                }
-                
-                fmt::print("\n");
-            }
-        } else if (format_ == "base64") {
-            // Base64 format
-            std::string base64 = Botan::base64_encode(buffer.data(), buffer.size());
             
-            // Wrap at 76 characters (MIME standard)
-            for (size_t i = 0; i < base64.length(); i += 76) {
-                fmt::print("{}\n", base64.substr(i, 76));
+            text.clear();
+            if (format_ == "hex") {
+                render_hex(block, pos, show_offset_, show_ascii_, text);
+            } else if (format_ == "binary") {
+                render_binary(block, pos, show_offset_, text);
+            } else if (format_ == "base64") {
+                render_base64(block, text);
             }
+            fmt::print("{}", text);
         }
         
         fmt::print("\n");
@@ -151,6 +304,56 @@ int DumpCommand::execute() {
     }
 }
 
+int DumpCommand::summarize_files() {
+    auto start = std::chrono::steady_clock::now();
+    archive::WalkOptions options;
+    options.threads = threads_;
+    auto expansion = archive::DirectoryWalker::expand_inputs(file_paths_, options);
+    for (const auto& error : expansion.errors) {
+        utils::Console::warning(error);
+    }
+    for (const auto& missing : expansion.missing) {
+        utils::Console::error(missing);
+    }
+    
+    // Only the first bytes of each file are read, never the payload
+    size_t peek_size = max_bytes_ > 0 ? std::max(max_bytes_, size_t(16)) : HEADER_PEEK_SIZE;
+    core::ThreadPool pool(threads_);
+    std::vector<std::future<nlohmann::json>> summaries;
+    summaries.reserve(expansion.files.size());
+    for (const auto& path : expansion.files) {
+        summaries.push_back(pool.submit([path, peek_size]() { return summarize_file(path, peek_size); }));
+    }
+    
+    size_t failed = 0;
+    for (auto& future : summaries) {
+        auto summary = future.get();
+        bool ok = !summary.contains("error");
+        failed += ok ? 0 : 1;
+        if (json_) {
+            fmt::print("{}\n", summary.dump());
+        } else if (!ok) {
+            utils::Console::error(fmt::format("{}: {}", summary["file"].get<std::string>(),
+                                              summary["error"].get<std::string>()));
+        } else if (summary.contains("algorithm")) {
+            fmt::print("{}: {} {}, {}, {} bytes\n", summary["file"].get<std::string>(),
+                       summary["format"].get<std::string>(), summary["algorithm"].get<std::string>(),
+                       summary["kdf"].get<std::string>(), summary["size"].get<uintmax_t>());
+        } else {
+            fmt::print("{}: {}, {} bytes, starts {}\n", summary["file"].get<std::string>(),
+                       summary["format"].get<std::string>(), summary["size"].get<uintmax_t>(),
+                       summary["head"].get<std::string>());
+        }
+    }
+    
+    if (!json_) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        utils::Console::info(fmt::format("{} files, {} unreadable ({:.2f}s, {} threads)",
+                                         summaries.size(), failed, seconds, pool.size()));
+    }
+    return failed == 0 && expansion.missing.empty() ? 0 : 1;
+}
+
 } // namespace commands
 } // namespace cli
 } // namespace filevault
@@ -1,20 +1,66 @@
 #include "filevault/cli/commands/encrypt_cmd.hpp"
-#include "filevault/format/file_header.hpp"
+#include "filevault/archive/directory_walker.hpp"
+#include "filevault/archive/sync_fingerprint.hpp"
+#include "filevault/core/algorithm_traits.hpp"
+#include "filevault/core/checkpoint.hpp"
+#include "filevault/core/cpu_features.hpp"
+#include "filevault/core/envelope.hpp"
 #include "filevault/core/file_format.hpp"
+#include "filevault/core/kdf_calibration.hpp"
+#include "filevault/core/memory_budget.hpp"
 #include "filevault/core/modes.hpp"
+#include "filevault/core/streaming.hpp"
+#include "filevault/core/thread_pool.hpp"
+#include "filevault/core/tree_runner.hpp"
+#include "filevault/utils/armor.hpp"
 #include "filevault/utils/console.hpp"
 #include "filevault/utils/file_io.hpp"
+#include "filevault/utils/io_backend.hpp"
+#include "filevault/utils/object_store.hpp"
+#include "filevault/utils/part_files.hpp"
+#include "filevault/utils/s3_store.hpp"
+#include "filevault/utils/config.hpp"
 #include "filevault/utils/crypto_utils.hpp"
 #include "filevault/utils/password.hpp"
 #include "filevault/utils/progress.hpp"
+#include "filevault/utils/run_stats.hpp"
 #include "filevault/compression/compressor.hpp"
+#include "filevault/compression/dictionary.hpp"
+#include "filevault/compression/selector.hpp"
 #include <spdlog/spdlog.h>
+#include <algorithm>
+#include <charconv>
 #include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <future>
 #include <iostream>
 
 namespace filevault {
 namespace cli {
 
+// Plaintext read from the mapping per step of the incremental path
+static constexpr size_t INCREMENTAL_PIECE_SIZE = 1024 * 1024;
+
+// Outputs compared per pool task by a sync run
+static constexpr size_t SYNC_BATCH = 256;
+
+/**
+ * @brief Parse "MIN-MAX" compression levels, each 1-9 with MIN <= MAX
+ */
+static bool parse_level_range(const std::string& text, int& min_level, int& max_level) {
+    auto dash = text.find('-');
+    if (dash == std::string::npos) {
+        return false;
+    }
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    auto [min_end, min_ec] = std::from_chars(begin, begin + dash, min_level);
+    auto [max_end, max_ec] = std::from_chars(begin + dash + 1, end, max_level);
+    return min_ec == std::errc() && min_end == begin + dash && max_ec == std::errc() && max_end == end &&
+           min_level >= 1 && min_level <= max_level && max_level <= 9;
+}
+
 EncryptCommand::EncryptCommand(core::CryptoEngine& engine)
     : engine_(engine) {
 }
@@ -22,11 +68,18 @@ EncryptCommand::EncryptCommand(core::CryptoEngine& engine)
 void EncryptCommand::setup(CLI::App& app) {
     auto* encrypt_cmd = app.add_subcommand(name(), description());
     
-    encrypt_cmd->add_option("input", input_file_, "Input file to encrypt")
+    encrypt_cmd->add_option("input", input_file_, "Input file to encrypt ('-' for stdin, a directory with -r)")
         ->required()
-        ->check(CLI::ExistingFile);
+        ->check(CLI::ExistingPath | CLI::IsMember({"-"}));
+    
+    encrypt_cmd->add_option("output,-o,--output", output_file_,
+                            "Output encrypted file ('-' for stdout, s3://bucket/key, a directory with -r)");
     
-    encrypt_cmd->add_option("output", output_file_, "Output encrypted file");
+    encrypt_cmd->add_flag("-r,--recursive", recursive_,
+                          "Encrypt every file under the input directory into a mirrored output tree");
+    
+    encrypt_cmd->add_flag("--sync", sync_,
+                          "With -r: re-encrypt only files whose size, mtime or contents changed");
     
     encrypt_cmd->add_option("-m,--mode", mode_, "Mode preset (overrides other options)")
         ->check(CLI::IsMember({"basic", "standard", "advanced"}));
@@ -41,6 +94,8 @@ void EncryptCommand::setup(CLI::App& app) {
             "camellia-128-gcm", "camellia-192-gcm", "camellia-256-gcm",
             "aria-128-gcm", "aria-192-gcm", "aria-256-gcm",
             "sm4-gcm",
+            // AEAD beyond GCM
+            "aegis-256", "aes-256-ocb", "aes-256-siv",
             // Non-AEAD modes (CBC)
             "aes-128-cbc", "aes-192-cbc", "aes-256-cbc",
             // Non-AEAD modes (CTR)
@@ -59,6 +114,7 @@ void EncryptCommand::setup(CLI::App& app) {
             "rsa-2048", "rsa-3072", "rsa-4096", "rsa",
             // Asymmetric (ECC)
             "ecc-p256", "ecc-p384", "ecc-p521", "ecc", "p256", "p384", "p521",
+            "ecc-x25519", "x25519",
             // Post-Quantum (Kyber Hybrid - quantum-resistant)
             "kyber-512-hybrid", "kyber-768-hybrid", "kyber-1024-hybrid", "kyber-hybrid",
             // Classical (educational)
@@ -73,14 +129,76 @@ void EncryptCommand::setup(CLI::App& app) {
             "argon2id", "argon2i", "pbkdf2-sha256", "pbkdf2-sha512", "scrypt"
         }));
     
+    encrypt_cmd->add_option("--kdf-parallelism", kdf_parallelism_,
+                            "Argon2 lanes hashed in parallel (default: from security level)")
+        ->check(CLI::Range(1, 64));
+    
+    encrypt_cmd->add_option("--kdf-target-ms", kdf_target_ms_,
+                            "Calibrate KDF parameters to this derivation time on this machine")
+        ->check(CLI::Range(10, 600000));
+    
+    encrypt_cmd->add_flag("--kdf-recalibrate", kdf_recalibrate_,
+                          "Re-run KDF calibration instead of using the cached result");
+    
     encrypt_cmd->add_option("-p,--password", password_, "Encryption password (not recommended)");
     
+    encrypt_cmd->add_option("--public-key", public_key_paths_,
+                           "Encrypt to a public key (RSA, ECC or Kyber) instead of a password; "
+                           "repeat for several recipients")
+        ->check(CLI::ExistingFile);
+    
     encrypt_cmd->add_option("--compression", compression_type_, "Compression algorithm")
-        ->check(CLI::IsMember({"none", "zlib", "bzip2", "lzma"}));
+        ->check(CLI::IsMember({"none", "auto", "zlib", "bzip2", "lzma", "zstd", "lz4"}));
     
     encrypt_cmd->add_option("--compression-level", compression_level_, "Compression level (1-9)")
         ->check(CLI::Range(1, 9));
     
+    encrypt_cmd->add_option("--adaptive-level", adaptive_level_,
+                            "Let the v2 compression level move within MIN-MAX (e.g. 1-9), raised while "
+                            "the output keeps up and lowered while it waits on compression")
+        ->check(CLI::Validator([](std::string& text) {
+            int min_level = 0, max_level = 0;
+            return parse_level_range(text, min_level, max_level) ? std::string()
+                                                                 : "Expected MIN-MAX with 1 <= MIN <= MAX <= 9";
+        }, "MIN-MAX"));
+    
+    encrypt_cmd->add_option("--compression-target", compression_target_mbps_,
+                            "Minimum compression speed in MB/s per thread for --compression auto (default 200)")
+        ->check(CLI::Range(1.0, 100000.0));
+    
+    encrypt_cmd->add_option("--dictionary", dictionary_,
+                            "Compression dictionary ID or file (zlib/zstd, see 'dict train')");
+    
+    encrypt_cmd->add_option("--format", format_,
+                            "File format: v2 (authenticated blocks, streaming and random access), "
+                            "v1 (single sealed payload), or auto (v2 for AEAD ciphers)")
+        ->check(CLI::IsMember({"auto", "v1", "v2"}));
+    
+    encrypt_cmd->add_option("-T,--threads", threads_,
+                           "Threads for compression and streaming chunks (0 = one per core)");
+    
+    encrypt_cmd->add_option("--checkpoint-interval", checkpoint_interval_,
+                            "Chunks between checkpoints of a v2 file (0 = none)");
+    
+    encrypt_cmd->add_flag("--resume", resume_,
+                          "Continue an interrupted v2 encryption from its checkpoint");
+    
+    encrypt_cmd->add_flag("--direct-io,--no-cache", direct_io_,
+                          "Keep input and output out of the page cache (bulk jobs on busy hosts)");
+    
+    encrypt_cmd->add_flag("--armor", armor_,
+                          "Write ASCII-armored (base64) output for mail and chat");
+    
+    encrypt_cmd->add_option("--split-size", split_size_,
+                            "Write the output as numbered part files of this size plus a manifest "
+                            "(e.g. 100M, 5G), ready for parallel upload")
+        ->transform(CLI::AsSizeValue(false))
+        ->check(CLI::Range(uint64_t{64 * 1024}, UINT64_MAX));
+    
+    encrypt_cmd->add_option("--shard", shard_,
+                            "Encrypt one file from several hosts: 'init' lays out the output, "
+                            "'R/N' encrypts rank R of N in place, 'stitch' finishes it");
+    
     encrypt_cmd->add_flag("-v,--verbose", verbose_, "Verbose output");
     
     encrypt_cmd->add_flag("--no-progress", no_progress_, "Disable progress bars");
@@ -95,12 +213,28 @@ void EncryptCommand::setup(CLI::App& app) {
         "  Advanced encryption:   filevault encrypt file.txt -m advanced\n"
         "  Custom algorithm:      filevault encrypt file.txt -a aes-256-gcm\n"
         "  With compression:      filevault encrypt file.txt --compression lzma\n"
+        "  Pick compression:      filevault encrypt data.csv --compression auto --compression-target 100\n"
+        "  Small file + dict:     filevault encrypt app.json --compression zstd --dictionary 1a2b3c4d\n"
         "  Skip weak password:    filevault encrypt file.txt -m standard --yes\n"
+        "  Host-tuned KDF:        filevault encrypt file.txt --kdf-target-ms 500\n"
+        "  Resume after a crash:  filevault encrypt volume.img --resume\n"
+        "  Single-payload format: filevault encrypt file.txt --format v1\n"
+        "  Pipe (stdin/stdout):   pg_dump db | filevault encrypt - - -p secret > db.fvlt\n"
+        "  To a public key:       filevault encrypt backup.tar --public-key team.pub\n"
+        "  Several recipients:    filevault encrypt dump.sql --public-key alice.pub --public-key bob.pub\n"
+        "  Whole directory:       filevault encrypt -r photos -o photos.fvlt -T 8\n"
+        "  Spare the page cache:  filevault encrypt -r /backups -o /vault/backups.fvlt --direct-io\n"
+        "  Straight to S3:        filevault encrypt db.dump -o s3://backups/db.dump.fvlt\n"
+        "  Paste-able text:       filevault encrypt notes.txt --armor -o notes.asc\n"
+        "  Parts for upload:      filevault encrypt disk.img --split-size 5G\n"
+        "  From 4 hosts:          filevault encrypt big.raw --shard init, then --shard 0/4 .. 3/4,\n"
+        "                         then --shard stitch\n"
         "\n"
         "Symmetric algorithms: aes-128-gcm, aes-192-gcm, aes-256-gcm, chacha20-poly1305,\n"
         "  serpent-256-gcm, twofish-{128,192,256}-gcm, camellia-{128,192,256}-gcm,\n"
-        "  aria-{128,192,256}-gcm, sm4-gcm, aes-{128,192,256}-{cbc,ctr,cfb,ofb,ecb,xts}\n"
-        "Asymmetric: rsa-{2048,3072,4096}, ecc-{p256,p384,p521}\n"
+        "  aria-{128,192,256}-gcm, sm4-gcm, aegis-256, aes-256-ocb, aes-256-siv,\n"
+        "  aes-{128,192,256}-{cbc,ctr,cfb,ofb,ecb,xts}\n"
+        "Asymmetric: rsa-{2048,3072,4096}, ecc-{p256,p384,p521,x25519}\n"
         "Post-Quantum: kyber-{512,768,1024}-hybrid\n"
         "Classical: caesar, vigenere, playfair, substitution, hill\n"
         "KDF options: argon2id, argon2i, pbkdf2-sha256, pbkdf2-sha512, scrypt\n"
@@ -117,8 +251,66 @@ void EncryptCommand::setup(CLI::App& app) {
 
 int EncryptCommand::execute() {
     try {
+        // "-" selects stdin/stdout; keep stdout clean for the ciphertext
+        bool pipe_mode = input_file_ == "-" || output_file_ == "-";
+        if (pipe_mode) {
+            utils::Console::set_stream(stderr);
+        }
+        
         utils::Console::header("FileVault Encryption");
         
+        // The performance profile fills in what the command line left open
+        const auto& user_config = utils::Config::current();
+        if (threads_ == 0) {
+            threads_ = user_config.get_threads();
+        }
+        if (compression_target_mbps_ <= 0) {
+            compression_target_mbps_ = user_config.get_compression_target_mbps();
+        }
+        direct_io_ = direct_io_ || user_config.get_direct_io();
+        
+        bool directory_input = !pipe_mode && std::filesystem::is_directory(input_file_);
+        if (recursive_ != directory_input) {
+            utils::Console::error(recursive_ ? "--recursive needs an input directory"
+                                             : input_file_ + " is a directory (use --recursive)");
+            return 1;
+        }
+        
+        // Objects are uploaded as they are encrypted, so only the chunked
+        // format (which never seeks back) can be written to them
+        bool object_output = utils::ObjectUrl::is_object_url(output_file_);
+        if (object_output && (recursive_ || resume_ || format_ == "v1")) {
+            utils::Console::error("s3:// outputs take a single v2 file, without --resume");
+            return 1;
+        }
+        
+        // Armor wraps the chunked stream as it is written
+        if (armor_ && (recursive_ || resume_ || object_output || format_ == "v1")) {
+            utils::Console::error("--armor takes a single v2 file or pipe, without --resume or s3://");
+            return 1;
+        }
+        
+        // Parts are cut from the chunked stream as it is written
+        bool split = split_size_ > 0;
+        if (split && (recursive_ || resume_ || object_output || armor_ || format_ == "v1" ||
+                      output_file_ == "-")) {
+            utils::Console::error("--split-size takes a single v2 output file, without --resume, "
+                                  "--armor or s3://");
+            return 1;
+        }
+        
+        // Ranks write into one shared output file in place
+        bool sharded = !shard_.empty();
+        if (sharded && (recursive_ || resume_ || object_output || armor_ || split || pipe_mode ||
+                        format_ == "v1" || !public_key_paths_.empty())) {
+            utils::Console::error("--shard takes an input and an output file and a password, without "
+                                  "--resume, --split-size, --armor or s3://");
+            return 1;
+        }
+        if (shard_ == "stitch") {
+            return execute_shard();     // Needs no key
+        }
+        
         // Apply mode preset if specified (only for options not explicitly set)
         if (!mode_.empty()) {
             auto user_mode = core::ModePreset::parse_mode(mode_);
@@ -145,6 +337,50 @@ int EncryptCommand::execute() {
                                preset.name(), preset.description()));
         }
         
+        // No explicit algorithm: use the configured default, or let the CPU decide
+        // (AES-GCM with hardware AES, ChaCha20-Poly1305 without)
+        if (algorithm_.empty()) {
+            auto configured = user_config.get_default_algorithm();
+            if (configured != "auto" && engine_.parse_algorithm(configured)) {
+                algorithm_ = configured;
+            } else {
+                algorithm_ = engine_.algorithm_name(core::CpuFeatures::detect().preferred_aead());
+                spdlog::info("Selected {} from CPU features", algorithm_);
+            }
+        }
+        
+        if (compression_type_ == "auto" && recursive_) {
+            utils::Console::error("--compression auto samples one file; name an algorithm for --recursive");
+            return 1;
+        }
+        if (compression_type_ == "auto" && !resolve_auto_compression(pipe_mode)) {
+            return 1;
+        }
+        
+        // Public-key encryption needs no password; the data key is random
+        if (!public_key_paths_.empty()) {
+            if (!password_.empty()) {
+                utils::Console::error("--public-key and --password cannot be combined");
+                return 1;
+            }
+            return recursive_ ? execute_recursive() : execute_streaming();
+        }
+        
+        // The terminal prompt would read from (or print into) the data stream
+        if (pipe_mode && password_.empty()) {
+            utils::Console::error("Pipe mode needs --password: stdin/stdout carry the data");
+            return 1;
+        }
+        
+        // Read the start of the input while the password is typed; encryption
+        // then begins on cached data (leaving execute() joins the task)
+        std::future<uint64_t> prefetched;
+        if (password_.empty() && !recursive_ && !sharded) {
+            prefetched = std::async(std::launch::async, [path = input_file_, direct = direct_io_] {
+                return utils::FileIO::prefetch(path, utils::FileIO::PREFETCH_SIZE, direct);
+            });
+        }
+        
         // Get password securely if not provided
         if (password_.empty()) {
             // Try up to 3 times to get a valid password
@@ -183,7 +419,10 @@ int EncryptCommand::execute() {
                                        utils::Password::get_strength_label(strength_analysis.strength),
                                        static_cast<int>(strength_analysis.score)));
                 
-                if (!force_weak_password_) {
+                if (!force_weak_password_ && pipe_mode) {
+                    utils::Console::error("Weak password rejected in pipe mode (use --yes to accept)");
+                    return 1;
+                } else if (!force_weak_password_) {
                     fmt::print("Continue with weak password? (y/N): ");
                     std::string response;
                     std::getline(std::cin, response);
@@ -198,6 +437,46 @@ int EncryptCommand::execute() {
             }
         }
         
+        if (sharded) {
+            return execute_shard();
+        }
+        if (pipe_mode || object_output || armor_ || split) {
+            return execute_streaming();
+        }
+        if (recursive_) {
+            return execute_recursive();
+        }
+        
+        // FVAULT02 is the default for the AEAD ciphers. Dictionaries and KDF
+        // tuning are only recorded by the FVAULT01 header, so they keep v1.
+        auto stream_algo = engine_.parse_algorithm(algorithm_);
+        bool streamable = stream_algo && core::StreamingCrypto::supports_algorithm(*stream_algo);
+        if (resume_ && format_ == "v1") {
+            utils::Console::error("--resume applies to v2 (chunked) files only");
+            return 1;
+        }
+        if (format_ == "v2" || resume_ ||
+            (format_ == "auto" && streamable && dictionary_.empty() &&
+             kdf_parallelism_ == 0 && kdf_target_ms_ == 0)) {
+            return execute_streaming();
+        }
+        
+        // Large files go through the chunked streaming engine, so memory is
+        // bounded by the chunk size rather than the file size. Under
+        // --max-memory, so does anything larger than its in-memory share.
+        size_t threshold_mb = user_config.get_streaming_threshold_mb();
+        uint64_t threshold = core::MemoryBudget::shared().in_memory_bytes(
+            threshold_mb > 0 ? uint64_t{threshold_mb} * 1024 * 1024 : UINT64_MAX);
+        if (format_ == "auto" && threshold != UINT64_MAX &&
+            core::StreamingCrypto::should_use_streaming(input_file_, static_cast<size_t>(threshold))) {
+            if (streamable) {
+                utils::Console::info(fmt::format("Input exceeds {}, using streaming mode",
+                                                 utils::CryptoUtils::format_bytes(threshold)));
+                return execute_streaming();
+            }
+            utils::Console::warning(fmt::format("{} does not support streaming; encrypting in memory", algorithm_));
+        }
+        
         // Set output file if not specified
         if (output_file_.empty()) {
             output_file_ = input_file_ + ".fvlt";
@@ -211,58 +490,17 @@ int EncryptCommand::execute() {
         utils::Console::info(fmt::format("KDF:       {}", kdf_));
         utils::Console::separator();
         
-        // Read input file
-        auto file_result = utils::FileIO::read_file(input_file_);
+        // Map input file (no heap copy of the plaintext)
+        auto file_result = utils::FileIO::map_file(input_file_);
         if (!file_result) {
             utils::Console::error(file_result.error_message);
             return 1;
         }
         
-        auto plaintext = file_result.value;
+        std::span<const uint8_t> plaintext = file_result.value.span();
+        std::vector<uint8_t> compressed_data;
         utils::Console::info(fmt::format("Read {} bytes", plaintext.size()));
         
-        // Step 1: Compress if requested
-        bool compressed = false;
-        core::CompressionType comp_type = core::CompressionType::NONE;
-        size_t original_size = plaintext.size();
-        
-        if (compression_type_ != "none") {
-            utils::Console::info(fmt::format("Compressing with {}...", compression_type_));
-            
-            comp_type = compression::CompressionService::parse_algorithm(compression_type_);
-            
-            auto compressor = compression::CompressionService::create(comp_type);
-            if (!compressor) {
-                utils::Console::error("Failed to create compressor");
-                return 1;
-            }
-            
-            std::unique_ptr<utils::ProgressBar> compress_progress;
-            if (!no_progress_) {
-                compress_progress = std::make_unique<utils::ProgressBar>("Compressing", 100);
-                compress_progress->set_progress(50);  // Show activity
-            }
-            
-            auto compress_result = compressor->compress(plaintext, compression_level_);
-            
-            if (compress_progress) {
-                compress_progress->mark_as_completed();
-            }
-            
-            if (!compress_result.success) {
-                utils::Console::error(compress_result.error_message);
-                return 1;
-            }
-            
-            plaintext = std::move(compress_result.data);
-            compressed = true;
-            
-            utils::Console::info(fmt::format("Compressed: {} -> {} bytes ({:.1f}% ratio)",
-                               original_size,
-                               plaintext.size(),
-                               compress_result.compression_ratio));
-        }
-        
         spdlog::debug("Parsing configuration...");
         // Parse configuration
         auto algo_type_opt = engine_.parse_algorithm(algorithm_);
@@ -283,16 +521,9 @@ int EncryptCommand::execute() {
         
         // Check if asymmetric algorithm is selected without public key
         // RSA, ECC and KyberHybrid require public keys, not password-derived keys
-        bool is_asymmetric = (algo_type == core::AlgorithmType::RSA_2048 ||
-                              algo_type == core::AlgorithmType::RSA_3072 ||
-                              algo_type == core::AlgorithmType::RSA_4096 ||
-                              algo_type == core::AlgorithmType::ECC_P256 ||
-                              algo_type == core::AlgorithmType::ECC_P384 ||
-                              algo_type == core::AlgorithmType::ECC_P521);
-        
-        bool is_pqc_hybrid = (algo_type == core::AlgorithmType::KYBER_512_HYBRID ||
-                              algo_type == core::AlgorithmType::KYBER_768_HYBRID ||
-                              algo_type == core::AlgorithmType::KYBER_1024_HYBRID);
+        const auto& algo_traits = core::algorithm_traits(algo_type);
+        bool is_asymmetric = algo_traits.family == core::AlgorithmFamily::ASYMMETRIC;
+        bool is_pqc_hybrid = algo_traits.family == core::AlgorithmFamily::PQC_HYBRID;
         
         if (is_asymmetric || is_pqc_hybrid) {
             std::string alt_message = is_pqc_hybrid 
@@ -321,6 +552,72 @@ int EncryptCommand::execute() {
         config.kdf = kdf_type;
         config.level = sec_level;
         config.apply_security_level();
+        if (kdf_target_ms_ > 0 && !apply_kdf_calibration(config)) {
+            return 1;
+        }
+        if (kdf_parallelism_ > 0) {
+            if (kdf_type == core::KDFType::ARGON2ID || kdf_type == core::KDFType::ARGON2I) {
+                config.kdf_parallelism = kdf_parallelism_;  // Recorded in the header's Argon2 params
+            } else {
+                utils::Console::warning("--kdf-parallelism applies to Argon2 only");
+            }
+        }
+        
+        // Step 1: Set up compression if requested
+        uint32_t dictionary_id = 0;
+        core::CompressionType comp_type = core::CompressionType::NONE;
+        size_t original_size = plaintext.size();
+        std::unique_ptr<compression::ICompressor> compressor;
+        
+        if (compression_type_ != "none") {
+            comp_type = compression::CompressionService::parse_algorithm(compression_type_);
+            
+            compressor = compression::CompressionService::create(comp_type);
+            if (!compressor) {
+                utils::Console::error("Failed to create compressor");
+                return 1;
+            }
+            
+            compressor->set_threads(threads_);
+            if (!dictionary_.empty()) {
+                // A dictionary file is imported so decryption can find it by ID
+                compression::DictionaryStore store(utils::Config::get_dictionary_dir());
+                std::vector<uint8_t> dictionary;
+                if (std::filesystem::is_regular_file(dictionary_)) {
+                    auto read_result = utils::FileIO::read_file(dictionary_);
+                    if (!read_result) {
+                        utils::Console::error(read_result.error_message);
+                        return 1;
+                    }
+                    dictionary = std::move(read_result.value);
+                    auto saved = store.save(dictionary);
+                    if (!saved) {
+                        utils::Console::error(saved.error_message);
+                        return 1;
+                    }
+                    dictionary_id = saved.value;
+                } else {
+                    dictionary_id = compression::DictionaryStore::parse_id(dictionary_);
+                    if (dictionary_id == 0) {
+                        utils::Console::error(fmt::format("Not a dictionary file or ID: {}", dictionary_));
+                        return 1;
+                    }
+                    auto loaded = store.load(dictionary_id);
+                    if (!loaded) {
+                        utils::Console::error(loaded.error_message);
+                        return 1;
+                    }
+                    dictionary = std::move(loaded.value);
+                }
+                if (!compressor->set_dictionary(dictionary)) {
+                    utils::Console::error(fmt::format("{} does not support compression dictionaries "
+                                                      "(use zlib or zstd)", compression_type_));
+                    return 1;
+                }
+                utils::Console::info(fmt::format("Using dictionary {}",
+                                                 compression::DictionaryStore::format_id(dictionary_id)));
+            }
+        }
         
         // Step 2: Generate salt and derive key
         utils::Console::info("Deriving key...");
@@ -338,10 +635,50 @@ int EncryptCommand::execute() {
         }
         
         // Generate nonce and add to config
-        auto nonce = engine_.generate_nonce(12); // GCM standard
+        // AEAD nonces come from the traits table (AEGIS takes 32 bytes)
+        const auto& traits = core::algorithm_traits(config.algorithm);
+        auto nonce = engine_.generate_nonce(traits.is_aead() ? traits.nonce_size : 12);
         config.nonce = nonce;
         
-        // Step 3: Encrypt
+        // Single-tag AEAD files are sealed slice by slice from the mapping
+        if (auto status = encrypt_incremental(*algorithm, key, config, salt, plaintext,
+                                              compressor.get(), comp_type, dictionary_id)) {
+            return *status;
+        }
+        
+        // Step 3: Compress in memory
+        bool compressed = false;
+        if (compressor) {
+            utils::Console::info(fmt::format("Compressing with {}...", compression_type_));
+            
+            std::unique_ptr<utils::ProgressBar> compress_progress;
+            if (!no_progress_) {
+                compress_progress = std::make_unique<utils::ProgressBar>("Compressing", 100);
+                compress_progress->set_progress(50);  // Show activity
+            }
+            
+            auto compress_result = compressor->compress(plaintext, compression_level_);
+            
+            if (compress_progress) {
+                compress_progress->mark_as_completed();
+            }
+            
+            if (!compress_result.success) {
+                utils::Console::error(compress_result.error_message);
+                return 1;
+            }
+            
+            compressed_data = std::move(compress_result.data);
+            plaintext = compressed_data;
+            compressed = true;
+            
+            utils::Console::info(fmt::format("Compressed: {} -> {} bytes ({:.1f}% ratio)",
+                               original_size,
+                               plaintext.size(),
+                               compress_result.compression_ratio));
+        }
+        
+        // Step 4: Encrypt
         utils::Console::info("Encrypting...");
         std::unique_ptr<utils::ProgressBar> encrypt_progress;
         if (!no_progress_) {
@@ -379,6 +716,8 @@ int EncryptCommand::execute() {
             nonce_to_store,
             compressed
         );
+        header.set_dictionary_id(dictionary_id);
+        header.set_key_check(key);
         
         // Extract ciphertext and tag from CryptoResult
         // AES_GCM::encrypt() stores them separately in result.data and result.tag
@@ -386,21 +725,7 @@ int EncryptCommand::execute() {
         std::vector<uint8_t> auth_tag;
         
         // Only AEAD algorithms (GCM, ChaCha20-Poly1305) have authentication tags
-        bool is_aead = (algo_type == core::AlgorithmType::AES_128_GCM ||
-                       algo_type == core::AlgorithmType::AES_192_GCM ||
-                       algo_type == core::AlgorithmType::AES_256_GCM ||
-                       algo_type == core::AlgorithmType::CHACHA20_POLY1305 ||
-                       algo_type == core::AlgorithmType::SERPENT_256_GCM ||
-                       algo_type == core::AlgorithmType::TWOFISH_128_GCM ||
-                       algo_type == core::AlgorithmType::TWOFISH_192_GCM ||
-                       algo_type == core::AlgorithmType::TWOFISH_256_GCM ||
-                       algo_type == core::AlgorithmType::CAMELLIA_128_GCM ||
-                       algo_type == core::AlgorithmType::CAMELLIA_192_GCM ||
-                       algo_type == core::AlgorithmType::CAMELLIA_256_GCM ||
-                       algo_type == core::AlgorithmType::ARIA_128_GCM ||
-                       algo_type == core::AlgorithmType::ARIA_192_GCM ||
-                       algo_type == core::AlgorithmType::ARIA_256_GCM ||
-                       algo_type == core::AlgorithmType::SM4_GCM);
+        bool is_aead = core::algorithm_traits(algo_type).is_aead();
         
         if (is_aead) {
             if (encrypt_result.tag.has_value()) {
@@ -424,11 +749,17 @@ int EncryptCommand::execute() {
             utils::Console::error("Failed to write output file");
             return 1;
         }
+        if (direct_io_) {
+            utils::FileIO::drop_cache(input_file_);
+            utils::FileIO::drop_cache(output_file_);
+        }
         
         // Get final file size
         std::ifstream check_file(output_file_, std::ios::binary | std::ios::ate);
         size_t final_size = check_file.tellg();
         check_file.close();
+        utils::RunStats::instance().add_bytes(original_size, final_size);
+        utils::RunStats::instance().add_files(1);
         
         utils::Console::separator();
         utils::Console::success("Encryption completed!");
@@ -436,7 +767,7 @@ int EncryptCommand::execute() {
                            output_file_, 
                            utils::CryptoUtils::format_bytes(final_size)));
         utils::Console::info(fmt::format("Compression: {:.1f}%", 
-                           100.0 * final_size / plaintext.size()));
+                           100.0 * final_size / original_size));
         
         return 0;
         
@@ -446,5 +777,760 @@ int EncryptCommand::execute() {
     }
 }
 
+std::optional<int> EncryptCommand::encrypt_incremental(
+    core::ICryptoAlgorithm& algorithm,
+    std::span<const uint8_t> key,
+    core::EncryptionConfig config,
+    std::span<const uint8_t> salt,
+    std::span<const uint8_t> plaintext,
+    compression::ICompressor* compressor,
+    core::CompressionType compression,
+    uint32_t dictionary_id) {
+    
+    auto session = algorithm.create_session(key);
+    if (!session || !session->encrypt_begin(config)) {
+        return std::nullopt;
+    }
+    if (compressor && !compressor->begin(compression::StreamMode::COMPRESS, compression_level_, plaintext.size())) {
+        utils::Console::error(compressor->stream_error());
+        return 1;
+    }
+    
+    // The header only needs the nonce, so it goes out before the payload;
+    // the tag follows the ciphertext, so it is simply appended at the end
+    config.compression = compressor ? compression : core::CompressionType::NONE;
+    auto header = core::FileFormatHandler::create_header(
+        config.algorithm, config.kdf, config, salt, config.nonce.value(), compressor != nullptr);
+    header.set_dictionary_id(dictionary_id);
+    header.set_key_check(key);
+    
+    // Whole multiples of the cipher's preferred piece size
+    size_t granularity = session->encrypt_granularity();
+    size_t piece_size = std::max(granularity, INCREMENTAL_PIECE_SIZE / granularity * granularity);
+    
+    utils::OutputFileOptions options;
+    options.atomic = true;
+    options.bypass_cache = direct_io_;
+    options.preallocate = compressor ? 0 : header.size() + plaintext.size() + 16;
+    utils::OutputFile output(output_file_, options);
+    if (!output.is_open() || !header.write_to(output)) {
+        utils::Console::error("Cannot create output file: " + output_file_);
+        return 1;
+    }
+    
+    utils::Console::info(compressor ? fmt::format("Compressing with {} and encrypting...", compression_type_)
+                                    : std::string("Encrypting..."));
+    std::unique_ptr<utils::ProgressBar> progress;
+    if (!no_progress_) {
+        progress = std::make_unique<utils::ProgressBar>("Encrypting", 100);
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> pending;
+    pending.reserve(piece_size + granularity);
+    uint64_t payload_size = 0;
+    
+    auto write = [&](std::span<const uint8_t> data) {
+        output.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        payload_size += data.size();
+        return static_cast<bool>(output);
+    };
+    // Seals the whole granules pending; the rest waits for more input
+    auto seal = [&]() {
+        size_t ready = pending.size() / granularity * granularity;
+        if (ready == 0) {
+            return true;
+        }
+        size_t produced = session->encrypt_update(std::span<uint8_t>(pending).first(ready));
+        bool ok = write(std::span<const uint8_t>(pending).first(produced));
+        pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(ready));
+        return ok;
+    };
+    
+    for (size_t offset = 0; offset < plaintext.size(); offset += piece_size) {
+        auto slice = plaintext.subspan(offset, std::min(piece_size, plaintext.size() - offset));
+        if (compressor) {
+            if (!compressor->update(slice, pending)) {
+                output.close();
+                utils::Console::error(compressor->stream_error());
+                return 1;
+            }
+        } else {
+            pending.insert(pending.end(), slice.begin(), slice.end());
+        }
+        if (pending.size() >= piece_size && !seal()) {
+            utils::Console::error("Failed to write output file: " + output_file_);
+            return 1;
+        }
+        if (progress) {
+            progress->set_progress((offset + slice.size()) * 100 / plaintext.size());
+        }
+    }
+    if (compressor && !compressor->finish(pending)) {
+        output.close();
+        utils::Console::error(compressor->stream_error());
+        return 1;
+    }
+    
+    // The remainder, however short, goes to encrypt_finish() for the tag
+    if (!seal()) {
+        utils::Console::error("Failed to write output file: " + output_file_);
+        return 1;
+    }
+    auto finished = session->encrypt_finish(pending);
+    if (!finished.success || !finished.tag.has_value()) {
+        output.close();
+        utils::Console::error(finished.error_message);
+        return 1;
+    }
+    bool write_ok = write(pending);
+    output.write(reinterpret_cast<const char*>(finished.tag->data()),
+                 static_cast<std::streamsize>(finished.tag->size()));
+    if (!write_ok || !output || !output.commit()) {
+        utils::Console::error("Failed to write output file: " + output_file_);
+        return 1;
+    }
+    if (progress) {
+        progress->mark_as_completed();
+    }
+    if (direct_io_) {
+        utils::FileIO::drop_cache(input_file_);
+    }
+    
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (compressor) {
+        utils::Console::info(fmt::format("Compressed: {} -> {} bytes ({:.1f}% ratio)",
+                           plaintext.size(),
+                           payload_size,
+                           plaintext.empty() ? 0.0 : 100.0 * (1.0 - double(payload_size) / plaintext.size())));
+    }
+    utils::Console::info(fmt::format("Encrypted in {:.2f}ms", elapsed_ms));
+    
+    uint64_t final_size = header.size() + payload_size + finished.tag->size();
+    utils::RunStats::instance().add_bytes(plaintext.size(), final_size);
+    utils::RunStats::instance().add_files(1);
+    
+    utils::Console::separator();
+    utils::Console::success("Encryption completed!");
+    utils::Console::info(fmt::format("Output: {} ({})",
+                       output_file_,
+                       utils::CryptoUtils::format_bytes(final_size)));
+    utils::Console::info(fmt::format("Compression: {:.1f}%",
+                       plaintext.empty() ? 100.0 : 100.0 * final_size / plaintext.size()));
+    return 0;
+}
+
+bool EncryptCommand::apply_kdf_calibration(core::EncryptionConfig& config) {
+    if (!core::KdfCalibrator::supports(config.kdf)) {
+        utils::Console::error(fmt::format("{} does not support --kdf-target-ms (use argon2id or pbkdf2)", kdf_));
+        return false;
+    }
+    
+    // Benchmarking costs a few derivations, so the result is kept in the
+    // user config and reused until the budget or the machine changes
+    auto user_config = utils::Config::load();
+    uint32_t max_memory_mb = user_config.get_kdf_max_memory_mb();
+    auto cache_key = core::KdfCalibrator::cache_key(config.kdf, kdf_target_ms_, max_memory_mb);
+    
+    auto profile = kdf_recalibrate_ ? std::nullopt : user_config.get_kdf_calibration(cache_key);
+    if (!profile) {
+        utils::Console::info(fmt::format("Calibrating {} for {} ms (memory budget {} MB)...",
+                             kdf_, kdf_target_ms_, max_memory_mb));
+        profile = core::KdfCalibrator::calibrate(engine_, config.kdf, kdf_target_ms_, max_memory_mb);
+        user_config.set_kdf_calibration(cache_key, *profile);
+        if (!user_config.save()) {
+            utils::Console::warning("Could not save the KDF calibration to the config file");
+        }
+    }
+    
+    profile->apply(config);
+    utils::Console::info(fmt::format("KDF params: iterations={}, memory={} KB, parallelism={} (~{:.0f} ms)",
+                         config.kdf_iterations, config.kdf_memory_kb,
+                         config.kdf_parallelism, profile->measured_ms));
+    if (profile->measured_ms > kdf_target_ms_) {
+        utils::Console::warning("Even the cheapest parameters exceed the KDF target on this machine");
+    }
+    return true;
+}
+
+bool EncryptCommand::resolve_auto_compression(bool pipe_mode) {
+    if (pipe_mode) {
+        utils::Console::error("--compression auto needs an input file to sample, not a pipe");
+        return false;
+    }
+    auto sample = compression::CompressionSelector::sample_file(input_file_);
+    if (!sample) {
+        utils::Console::error(sample.error_message);
+        return false;
+    }
+    
+    auto choice = compression::CompressionSelector::select(sample.value, compression_target_mbps_);
+    compression_type_ = compression::CompressionService::get_algorithm_name(choice.type);
+    if (choice.type == core::CompressionType::NONE) {
+        utils::Console::info(fmt::format("Auto compression: none (input looks incompressible, "
+                                         "or nothing saves space at {:.0f} MB/s)", compression_target_mbps_));
+        return true;
+    }
+    compression_level_ = choice.level;
+    utils::Console::info(fmt::format("Auto compression: {} level {} ({:.2f}x at {:.0f} MB/s on a sample)",
+                                     compression_type_, compression_level_, choice.ratio, choice.compress_mbps));
+    return true;
+}
+
+bool EncryptCommand::make_streaming_config(core::StreamingConfig& config) {
+    auto algo_type = engine_.parse_algorithm(algorithm_);
+    auto kdf_type = engine_.parse_kdf(kdf_);
+    if (!algo_type || !kdf_type) {
+        utils::Console::error("Invalid configuration parameters");
+        return false;
+    }
+    
+    if (!core::StreamingCrypto::supports_algorithm(*algo_type)) {
+        utils::Console::error(fmt::format("Streaming supports AEAD algorithms only, not {}", algorithm_));
+        return false;
+    }
+    
+    auto level = engine_.parse_security_level(security_level_);
+    if (!level) {
+        utils::Console::error("Invalid security level: " + security_level_);
+        return false;
+    }
+    
+    config.chunk_size = utils::Config::current().get_streaming_chunk_mb() * 1024 * 1024;
+    config.algorithm = *algo_type;
+    config.kdf = *kdf_type;
+    config.level = *level;  // Recorded in the FVAULT02 header
+    config.compression = compression::CompressionService::parse_algorithm(compression_type_);
+    config.compression_level = compression_level_;
+    if (!adaptive_level_.empty()) {
+        config.adaptive_compression_level = parse_level_range(adaptive_level_, config.min_compression_level,
+                                                              config.max_compression_level);
+        if (config.compression == core::CompressionType::NONE) {
+            utils::Console::warning("--adaptive-level has no effect without --compression");
+        }
+    }
+    config.worker_threads = threads_;  // 0 = one per hardware thread
+    config.io_buffers = utils::Config::current().get_streaming_io_buffers();
+    config.bypass_cache = direct_io_;
+    if (!dictionary_.empty()) {
+        // Chunks are megabytes; a dictionary only helps small inputs
+        utils::Console::warning("Streaming format does not use compression dictionaries; ignoring --dictionary");
+    }
+    
+    // The stream header records the security level but not per-file KDF
+    // tuning; decryption derives the key from the level's profile
+    if (public_key_paths_.empty() && (kdf_parallelism_ > 0 || kdf_target_ms_ > 0)) {
+        utils::Console::info(fmt::format("Streaming format uses the {} KDF profile", security_level_));
+    }
+    return true;
+}
+
+bool EncryptCommand::load_public_keys(std::vector<std::vector<uint8_t>>& public_keys) {
+    // Payload is encrypted once; each recipient only costs one key wrap
+    for (const auto& path : public_key_paths_) {
+        auto key_result = utils::FileIO::read_file(path);
+        if (!key_result) {
+            utils::Console::error(key_result.error_message);
+            return false;
+        }
+        auto wrap_type = core::EnvelopeCrypto::key_algorithm(key_result.value);
+        if (!wrap_type) {
+            utils::Console::error(fmt::format("{} is not an RSA, ECC or Kyber public key", path));
+            return false;
+        }
+        utils::Console::info(fmt::format("Recipient: {} ({})", path, engine_.algorithm_name(*wrap_type)));
+        public_keys.push_back(std::move(key_result.value));
+    }
+    return true;
+}
+
+int EncryptCommand::execute_streaming() {
+    core::StreamingConfig config;
+    if (!make_streaming_config(config)) {
+        return 1;
+    }
+    
+    bool envelope = !public_key_paths_.empty();
+    std::vector<std::vector<uint8_t>> public_keys;
+    if (!load_public_keys(public_keys)) {
+        return 1;
+    }
+    
+    bool from_stdin = input_file_ == "-";
+    bool to_stdout = output_file_ == "-" || (output_file_.empty() && from_stdin);
+    auto object_url = utils::ObjectUrl::parse(output_file_);
+    if (output_file_.empty()) {
+        output_file_ = input_file_ + ".fvlt";
+    }
+    
+    // Checkpoints need a password job between two regular files
+    bool split = split_size_ > 0;
+    bool checkpointed = !from_stdin && !to_stdout && !object_url && !envelope && !armor_ && !split;
+    if (resume_ && !checkpointed) {
+        utils::Console::error("--resume needs an input and an output file and a password");
+        return 1;
+    }
+    if (checkpointed) {
+        config.checkpoint.interval = checkpoint_interval_;
+        config.checkpoint.resume = resume_;
+    }
+    
+    utils::Console::info(fmt::format("Input:     {}", from_stdin ? "<stdin>" : input_file_));
+    utils::Console::info(fmt::format("Output:    {}", to_stdout ? "<stdout>"
+                                     : split ? utils::PartSet::manifest_path(output_file_) : output_file_));
+    utils::Console::info(fmt::format("Algorithm: {}", algorithm_));
+    if (!envelope) {
+        utils::Console::info(fmt::format("Security:  {}", security_level_));
+        utils::Console::info(fmt::format("KDF:       {}", kdf_));
+    }
+    utils::Console::separator();
+    
+    core::StreamingResult result;
+    uint64_t object_bytes = 0;
+    if (from_stdin || to_stdout || object_url || armor_ || split) {
+        utils::FileIO::set_binary_stdio();
+        
+        utils::InputFileOptions input_options;
+        input_options.direct = direct_io_;
+        utils::OutputFileOptions output_options;
+        output_options.bypass_cache = direct_io_;
+        utils::InputFile file_in;
+        utils::OutputFile file_out;
+        std::unique_ptr<utils::S3Store> store;
+        std::unique_ptr<utils::ObjectOutput> object_out;
+        std::unique_ptr<utils::PartOutput> parts_out;
+        std::istream* in = &std::cin;
+        std::ostream* out = &std::cout;
+        if (!from_stdin) {
+            file_in.open(input_file_, input_options);
+            if (!file_in) {
+                utils::Console::error("Failed to open input file: " + input_file_);
+                return 1;
+            }
+            in = &file_in;
+        }
+        if (object_url) {
+            auto s3_config = utils::S3Config::from_environment(object_url->bucket);
+            if (!s3_config) {
+                utils::Console::error(s3_config.error_message);
+                return 1;
+            }
+            store = std::make_unique<utils::S3Store>(std::move(s3_config.value));
+            object_out = std::make_unique<utils::ObjectOutput>(*store, object_url->key);
+            if (!object_out->is_open()) {
+                utils::Console::error(fmt::format("Failed to start upload to {}: {}", output_file_, object_out->error()));
+                return 1;
+            }
+            out = object_out.get();
+        } else if (split) {
+            parts_out = std::make_unique<utils::PartOutput>(output_file_, split_size_, output_options);
+            out = parts_out.get();
+        } else if (!to_stdout) {
+            file_out.open(output_file_, output_options);
+            if (!file_out) {
+                utils::Console::error("Failed to create output file: " + output_file_);
+                return 1;
+            }
+            out = &file_out;
+        }
+        std::unique_ptr<utils::ArmorOutput> armor_out;
+        if (armor_) {
+            armor_out = std::make_unique<utils::ArmorOutput>(*out);
+            out = armor_out.get();
+        }
+        
+        // A known length gets the frame index that seekable reads use;
+        // stdout cannot report the offsets the index records
+        std::optional<size_t> input_size;
+        if ((object_url || split) && !from_stdin) {
+            input_size = static_cast<size_t>(file_in.size());
+        }
+        if (envelope) {
+            result = core::EnvelopeCrypto::encrypt_stream(*in, *out, public_keys, input_size, config);
+        } else if (input_size) {
+            result = core::StreamingCrypto::encrypt_stream(*in, *out, password_, *input_size, config);
+        } else {
+            result = core::StreamingCrypto::encrypt_stream(*in, *out, password_, config);
+        }
+        
+        if (armor_out && result.success && !armor_out->finish()) {
+            result.success = false;
+            result.error_message = "Failed to write armored output";
+        }
+        
+        // The object only appears once the upload is completed
+        if (object_out && result.success && !object_out->finish()) {
+            result.success = false;
+            result.error_message = fmt::format("Failed to upload {}: {}", output_file_, object_out->error());
+        }
+        
+        // The last part is marked and the manifest written once the stream ends
+        if (parts_out && result.success && !parts_out->finish()) {
+            result.success = false;
+            result.error_message = parts_out->error();
+        }
+        if (parts_out && result.success) {
+            utils::Console::info(fmt::format("Wrote {} parts of up to {}", parts_out->parts().parts.size(),
+                                             utils::CryptoUtils::format_bytes(split_size_)));
+        }
+        object_bytes = parts_out ? parts_out->parts().total_size : result.bytes_written;
+    } else {
+        // Chunks only store a counter; the bar redraws on its own thread
+        std::unique_ptr<utils::ProgressAggregator> progress;
+        if (!no_progress_) {
+            progress = std::make_unique<utils::ProgressAggregator>("Encrypting", utils::FileIO::file_size(input_file_));
+            config.progress_callback = [&progress](const core::ChunkInfo& info) {
+                progress->update(info.bytes_processed);
+                return true;
+            };
+        }
+        
+        result = envelope
+            ? core::EnvelopeCrypto::encrypt_file(input_file_, output_file_, public_keys, config)
+            : core::StreamingCrypto::encrypt_file(input_file_, output_file_, password_, config);
+        
+        if (progress && result.success) {
+            progress->finish();
+        }
+    }
+    
+    if (!result.success) {
+        utils::Console::error(result.error_message);
+        if (checkpointed && utils::FileIO::file_exists(core::Checkpoint::path_for(output_file_))) {
+            utils::Console::info("Run the same command with --resume to continue from the last checkpoint");
+        }
+        return 1;
+    }
+    
+    auto& run_stats = utils::RunStats::instance();
+    run_stats.add_bytes(result.bytes_processed,
+                        to_stdout ? 0 : object_url || split ? object_bytes : utils::FileIO::file_size(output_file_));
+    run_stats.add_files(1);
+    run_stats.add_chunks(result.chunks_processed);
+    
+    utils::Console::separator();
+    utils::Console::success("Encryption completed!");
+    if (result.chunks_resumed > 0) {
+        utils::Console::info(fmt::format("Resumed after {} chunks kept from the interrupted run",
+                                         result.chunks_resumed));
+    }
+    utils::Console::info(fmt::format("Processed {} in {} chunks ({:.1f} MB/s)",
+                       utils::CryptoUtils::format_bytes(result.bytes_processed),
+                       result.chunks_processed,
+                       result.throughput_mbps));
+    if (config.compression != core::CompressionType::NONE) {
+        utils::Console::info(fmt::format("Compressed {} chunks, skipped {} as incompressible",
+                           result.chunks_compressed, result.chunks_skipped));
+    }
+    if (!result.frame_levels.empty()) {
+        auto [lowest, highest] = std::minmax_element(result.frame_levels.begin(), result.frame_levels.end());
+        utils::Console::info(fmt::format("Adaptive compression levels {} to {}, last {}",
+                                         *lowest, *highest, result.frame_levels.back()));
+    }
+    if (result.chunks_sparse > 0) {
+        utils::Console::info(fmt::format("Stored {} chunks inside holes as zero extents",
+                                         result.chunks_sparse));
+    }
+    
+    return 0;
+}
+
+int EncryptCommand::execute_shard() {
+    if (output_file_.empty()) {
+        output_file_ = input_file_ + ".fvlt";
+    }
+    utils::Console::info(fmt::format("Input:     {}", input_file_));
+    utils::Console::info(fmt::format("Output:    {}", output_file_));
+    
+    if (shard_ == "stitch") {
+        utils::Console::separator();
+        auto result = core::StreamingCrypto::stitch_shards(output_file_);
+        if (!result.success) {
+            utils::Console::error(result.error_message);
+            return 1;
+        }
+        utils::Console::success(fmt::format("Stitched {} chunks; {} is complete",
+                                            result.chunks_processed, output_file_));
+        return 0;
+    }
+    
+    if (shard_ == "init") {
+        core::StreamingConfig config;
+        if (!make_streaming_config(config)) {
+            return 1;
+        }
+        utils::Console::info(fmt::format("Algorithm: {}", algorithm_));
+        utils::Console::info(fmt::format("Security:  {}", security_level_));
+        utils::Console::info(fmt::format("KDF:       {}", kdf_));
+        utils::Console::separator();
+        auto result = core::StreamingCrypto::init_shards(input_file_, output_file_, password_, config);
+        if (!result.success) {
+            utils::Console::error(result.error_message);
+            return 1;
+        }
+        utils::Console::success(fmt::format("Laid out {} ({} chunks of {})", output_file_,
+                                            (utils::FileIO::file_size(input_file_) + result.chunk_size - 1) /
+                                                (std::max)(result.chunk_size, size_t(1)),
+                                            utils::CryptoUtils::format_bytes(result.chunk_size)));
+        utils::Console::info("Run --shard R/N on each host, then --shard stitch once all have finished");
+        return 0;
+    }
+    
+    // "R/N": rank R of N, R < N
+    size_t rank = 0, ranks = 0;
+    auto slash = shard_.find('/');
+    bool parsed = slash != std::string::npos;
+    if (parsed) {
+        const char* begin = shard_.data();
+        const char* end = begin + shard_.size();
+        auto [rank_end, rank_ec] = std::from_chars(begin, begin + slash, rank);
+        auto [ranks_end, ranks_ec] = std::from_chars(begin + slash + 1, end, ranks);
+        parsed = rank_ec == std::errc() && rank_end == begin + slash &&
+                 ranks_ec == std::errc() && ranks_end == end && rank < ranks;
+    }
+    if (!parsed) {
+        utils::Console::error("--shard takes init, stitch or R/N with R below N (e.g. 0/4)");
+        return 1;
+    }
+    utils::Console::info(fmt::format("Rank:      {} of {}", rank, ranks));
+    utils::Console::separator();
+    
+    std::unique_ptr<utils::ProgressAggregator> progress;
+    core::StreamProgressCallback on_chunk;
+    if (!no_progress_) {
+        progress = std::make_unique<utils::ProgressAggregator>("Encrypting", utils::FileIO::file_size(input_file_));
+        on_chunk = [&progress](const core::ChunkInfo& info) {
+            progress->update(info.bytes_processed);
+            return true;
+        };
+    }
+    auto result = core::StreamingCrypto::encrypt_shard(input_file_, output_file_, password_, rank, ranks,
+                                                       threads_, on_chunk);
+    if (progress && result.success) {
+        progress->finish();
+    }
+    if (!result.success) {
+        utils::Console::error(result.error_message);
+        return 1;
+    }
+    
+    auto& run_stats = utils::RunStats::instance();
+    run_stats.add_bytes(result.bytes_processed, result.bytes_written);
+    run_stats.add_chunks(result.chunks_processed);
+    
+    utils::Console::separator();
+    utils::Console::success(fmt::format("Rank {} of {} done", rank, ranks));
+    utils::Console::info(fmt::format("Processed {} in {} chunks ({:.1f} MB/s)",
+                       utils::CryptoUtils::format_bytes(result.bytes_processed),
+                       result.chunks_processed,
+                       result.throughput_mbps));
+    return 0;
+}
+
+int EncryptCommand::execute_recursive() {
+    namespace fs = std::filesystem;
+    
+    if (resume_) {
+        utils::Console::error("--resume applies to single files, not --recursive");
+        return 1;
+    }
+    if (sync_ && !recursive_) {
+        utils::Console::error("--sync needs --recursive");
+        return 1;
+    }
+    
+    core::StreamingConfig base;
+    if (!make_streaming_config(base)) {
+        return 1;
+    }
+    bool envelope = !public_key_paths_.empty();
+    std::vector<std::vector<uint8_t>> public_keys;
+    if (!load_public_keys(public_keys)) {
+        return 1;
+    }
+    
+    // "dir" and "dir/" both give "dir.fvlt"
+    auto root = fs::path(input_file_).lexically_normal();
+    if (!root.has_filename()) {
+        root = root.parent_path();
+    }
+    fs::path out_root = output_file_;
+    if (out_root.empty()) {
+        if (root.filename() == "." || root.filename() == "..") {
+            utils::Console::error("Name an output directory for the encrypted tree");
+            return 1;
+        }
+        out_root = root.string() + ".fvlt";
+    }
+    auto inside = fs::weakly_canonical(out_root).lexically_relative(fs::weakly_canonical(root));
+    if (!inside.empty() && *inside.begin() != "..") {
+        utils::Console::error("Output directory must not be inside the input directory");
+        return 1;
+    }
+    
+    auto walk = archive::DirectoryWalker::walk({root});
+    for (const auto& error : walk.errors) {
+        utils::Console::warning("Skipped " + error);
+    }
+    std::vector<core::TreeFile> files;
+    files.reserve(walk.members.size());
+    uint64_t total_bytes = 0;
+    for (const auto& member : walk.members) {
+        auto target = out_root / member.source.lexically_relative(root);
+        target += ".fvlt";
+        files.push_back({member.source, std::move(target), member.entry.file_size,
+                         member.entry.modified_time});
+        total_bytes += member.entry.file_size;
+    }
+    if (files.empty()) {
+        utils::Console::error("No files to encrypt under " + root.string());
+        return 1;
+    }
+    
+    // One batch salt for the tree: the first file stretches the password,
+    // the rest find the master key in KeyCache, and each file's own salt
+    // gives it its own key. A sync keeps the batch salt of the existing
+    // outputs, so their digest key stays valid and touched files can be
+    // checked.
+    if (!envelope) {
+        for (size_t i = 0; sync_ && i < files.size() && base.salt.empty(); i++) {
+            auto info = core::StreamingCrypto::read_info(files[i].target.string());
+            if (!info || info->fingerprint.empty() || info->kdf != base.kdf || info->level != base.level) {
+                continue;
+            }
+            auto batch = core::CryptoEngine::batch_salt_of(info->salt);
+            if (batch.size() == core::CryptoEngine::BATCH_SALT_SIZE) {
+                base.salt.assign(batch.begin(), batch.end());
+            }
+        }
+        if (base.salt.empty()) {
+            base.salt = core::CryptoEngine::generate_salt(32);
+        }
+    }
+    
+    // Sync: compare every output's header fingerprint with its source, and
+    // keep only the files that changed
+    std::vector<uint8_t> sync_key;
+    size_t unchanged = 0;
+    if (sync_) {
+        if (!envelope) {
+            core::EncryptionConfig key_config;
+            key_config.algorithm = base.algorithm;
+            key_config.kdf = base.kdf;
+            key_config.level = base.level;
+            key_config.apply_security_level();
+            sync_key = archive::SyncFingerprint::derive_key(engine_.derive_key(password_, base.salt, key_config));
+        }
+        
+        std::vector<uint8_t> current(files.size(), 0);
+        {
+            core::ThreadPool pool(threads_);
+            std::vector<std::future<void>> batches;
+            for (size_t start = 0; start < files.size(); start += SYNC_BATCH) {
+                size_t end = (std::min)(start + SYNC_BATCH, files.size());
+                batches.push_back(pool.submit([&, start, end]() {
+                    for (size_t i = start; i < end; i++) {
+                        current[i] = archive::SyncFingerprint::is_current(files[i], base.salt, sync_key);
+                    }
+                }));
+            }
+            for (auto& batch : batches) {
+                batch.get();
+            }
+        }
+        
+        std::vector<core::TreeFile> changed;
+        for (size_t i = 0; i < files.size(); i++) {
+            if (current[i]) {
+                unchanged++;
+            } else {
+                changed.push_back(std::move(files[i]));
+            }
+        }
+        files = std::move(changed);
+        total_bytes = 0;
+        for (const auto& file : files) {
+            total_bytes += file.size;
+        }
+        if (files.empty()) {
+            utils::Console::success(fmt::format("All {} files are up to date", unchanged));
+            return 0;
+        }
+    }
+    
+    core::TreeRunOptions options;
+    options.workers = threads_;
+    options.large_file_bytes = utils::Config::current().get_streaming_threshold_mb() * 1024 * 1024;
+    
+    utils::Console::info(fmt::format("Input:     {} ({} files)", root.string(), files.size() + unchanged));
+    if (sync_) {
+        utils::Console::info(fmt::format("Changed:   {} files ({} up to date)", files.size(), unchanged));
+    }
+    utils::Console::info(fmt::format("Output:    {}", out_root.string()));
+    utils::Console::info(fmt::format("Algorithm: {}", algorithm_));
+    if (!envelope) {
+        utils::Console::info(fmt::format("Security:  {}", security_level_));
+        utils::Console::info(fmt::format("KDF:       {}", kdf_));
+    }
+    utils::Console::separator();
+    
+    std::unique_ptr<utils::ProgressAggregator> progress;
+    if (!no_progress_) {
+        progress = std::make_unique<utils::ProgressAggregator>(fmt::format("Encrypting {} files", files.size()),
+                                                               total_bytes);
+        options.on_advance = [&progress](uint64_t bytes) { progress->add(bytes); };
+    }
+    
+    auto& run_stats = utils::RunStats::instance();
+    auto result = core::TreeRunner::run(files, [&](const core::TreeFile& file, size_t threads,
+                                                   const core::TreeRunner::Advance& advance) {
+        auto config = base;
+        config.worker_threads = threads;
+        if (!envelope) {
+            config.salt = core::CryptoEngine::batch_file_salt(base.salt);
+        }
+        config.progress_callback = [&advance](const core::ChunkInfo& info) {
+            advance(info.bytes_processed);
+            return true;
+        };
+        if (sync_) {
+            auto fingerprint = archive::SyncFingerprint::make(file, sync_key);
+            if (!fingerprint) {
+                return std::string("Failed to read the file");
+            }
+            config.fingerprint = std::move(*fingerprint);
+        }
+        auto encrypted = envelope
+            ? core::EnvelopeCrypto::encrypt_file(file.source.string(), file.target.string(), public_keys, config)
+            : core::StreamingCrypto::encrypt_file(file.source.string(), file.target.string(), password_, config);
+        if (!encrypted.success) {
+            return encrypted.error_message;
+        }
+        run_stats.add_bytes(encrypted.bytes_processed, utils::FileIO::file_size(file.target.string()));
+        run_stats.add_files(1);
+        run_stats.add_chunks(encrypted.chunks_processed);
+        return std::string();
+    }, options);
+    
+    if (progress) {
+        progress->finish();
+    }
+    
+    utils::Console::separator();
+    for (const auto& error : result.errors) {
+        utils::Console::error(error);
+    }
+    double mbps = result.seconds > 0 ? result.bytes / (1024.0 * 1024.0) / result.seconds : 0.0;
+    utils::Console::info(fmt::format("Encrypted {} of {} files, {} in {:.2f} s ({:.1f} MB/s)",
+                       result.succeeded, files.size(),
+                       utils::CryptoUtils::format_bytes(result.bytes), result.seconds, mbps));
+    if (!result.errors.empty()) {
+        utils::Console::error(fmt::format("{} files failed", result.errors.size()));
+        return 1;
+    }
+    utils::Console::success("Encryption completed!");
+    return 0;
+}
+
 } // namespace cli
 } // namespace filevault
@@ -1,22 +1,201 @@
 #include "filevault/cli/commands/hash_cmd.hpp"
+#include "filevault/archive/directory_walker.hpp"
+#include "filevault/core/executor.hpp"
+#include "filevault/core/system_resources.hpp"
+#include "filevault/core/tree_hash.hpp"
+#include "filevault/utils/checksum.hpp"
+#include "filevault/utils/config.hpp"
 #include "filevault/utils/console.hpp"
 #include "filevault/utils/file_io.hpp"
 #include "filevault/utils/crypto_utils.hpp"
 #include "filevault/utils/progress.hpp"
+#include "filevault/utils/row_writer.hpp"
 #include <botan/hash.h>
-#include <botan/hex.h>
 #include <botan/mac.h>
-#include <botan/base64.h>
 #include <fmt/color.h>
+#include <fmt/ranges.h>
 #include <chrono>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
 #include <fstream>
+#include <future>
+#include <map>
 #include <algorithm>
+#include <atomic>
 #include <bitset>
+#include <mutex>
+#include <optional>
 #include <sstream>
+#include <thread>
 
 namespace filevault {
 namespace cli {
 
+namespace fs = std::filesystem;
+
+namespace {
+
+// Files hashed ahead of the one being printed, per worker
+constexpr size_t PENDING_PER_WORKER = 4;
+
+// Files below this size go through the multi-buffer kernels, this many at a time
+constexpr uint64_t SMALL_FILE_SIZE = 16 * 1024;
+constexpr size_t SMALL_FILE_BATCH = 256;
+
+/**
+ * @brief Output line in sha256sum format
+ *
+ * Like coreutils, names containing a backslash or newline are escaped and
+ * the line is prefixed with a backslash.
+ */
+std::string checksum_line(const std::string& hash, const std::string& filepath) {
+    if (filepath.find_first_of("\\\n") == std::string::npos) {
+        return fmt::format("{}  {}", hash, filepath);
+    }
+    std::string escaped;
+    for (char c : filepath) {
+        if (c == '\\') {
+            escaped += "\\\\";
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return fmt::format("\\{}  {}", hash, escaped);
+}
+
+/**
+ * @brief Output line in BSD tagged format, used when printing several digests
+ */
+std::string tagged_line(const std::string& algorithm, bool hmac, const std::string& hash,
+                        const std::string& filepath) {
+    std::string tag = algorithm;
+    std::transform(tag.begin(), tag.end(), tag.begin(), ::toupper);
+    return fmt::format("{}{} ({}) = {}", hmac ? "HMAC-" : "", tag, filepath, hash);
+}
+
+/**
+ * @brief HMAC state keyed once per thread, algorithm and digest slot
+ *
+ * set_key runs the HMAC key schedule (the padded inner and outer key
+ * blocks); final() leaves the MAC keyed, so every later file on the same
+ * thread starts from the precomputed state. Botan cannot copy a keyed MAC,
+ * so the state is reused per worker rather than cloned from a prototype.
+ */
+struct KeyedMac {
+    Botan::secure_vector<uint8_t> key;
+    std::unique_ptr<Botan::MessageAuthenticationCode> mac;
+    bool clean = false;   // False while a message is in progress
+};
+
+KeyedMac& keyed_mac(const std::string& algorithm, const std::vector<uint8_t>& key, size_t slot) {
+    // Aliases (blake2b, blake2b-512) share a Botan name; each slot needs its own state
+    thread_local std::map<std::pair<std::string, size_t>, KeyedMac> macs;
+    auto& entry = macs[{algorithm, slot}];
+    if (!entry.mac) {
+        entry.mac = Botan::MessageAuthenticationCode::create(fmt::format("HMAC({})", algorithm));
+        if (!entry.mac) {
+            throw std::runtime_error("HMAC not available for: " + algorithm);
+        }
+    }
+    // Rekey after a different key, or a message abandoned part way
+    if (!entry.clean || !std::equal(entry.key.begin(), entry.key.end(), key.begin(), key.end())) {
+        entry.mac->set_key(key.data(), key.size());
+        entry.key.assign(key.begin(), key.end());
+        entry.clean = true;
+    }
+    return entry;
+}
+
+/**
+ * @brief One line of a checksum manifest
+ */
+struct ChecksumEntry {
+    size_t line = 0;
+    std::string path;
+    std::string algorithm;  // CLI name, e.g. "sha256"; empty for the default
+    size_t leaf_kb = 0;     // Tree digest leaf size; 0 for plain digests
+    bool hmac = false;
+    std::string expected;   // Lowercase hex
+};
+
+bool is_hex(const std::string& text) {
+    return !text.empty() && text.size() % 2 == 0 &&
+           std::all_of(text.begin(), text.end(), [](unsigned char c) { return std::isxdigit(c); });
+}
+
+// Inverse of the escaping in checksum_line
+std::string unescape_name(const std::string& name) {
+    std::string result;
+    for (size_t i = 0; i < name.size(); ++i) {
+        if (name[i] == '\\' && i + 1 < name.size()) {
+            result += name[++i] == 'n' ? '\n' : name[i];
+        } else {
+            result += name[i];
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Parse "<hash>  <file>", "<hash> *<file>" or "ALGO (<file>) = <hash>"
+ */
+std::optional<ChecksumEntry> parse_checksum_line(const std::string& text, size_t line_number) {
+    ChecksumEntry entry;
+    entry.line = line_number;
+    bool escaped = !text.empty() && text[0] == '\\';
+    std::string line = escaped ? text.substr(1) : text;
+    
+    // BSD tagged format, as written for several digests and tree digests
+    auto open = line.find(" (");
+    auto close = line.rfind(") = ");
+    bool tagged = open != std::string::npos && close != std::string::npos && close > open && open > 0 &&
+                  std::all_of(line.begin(), line.begin() + open,
+                              [](unsigned char c) { return std::isalnum(c) || c == '-'; });
+    if (tagged) {
+        std::string tag = line.substr(0, open);
+        std::transform(tag.begin(), tag.end(), tag.begin(), ::tolower);
+        if (tag.rfind("hmac-", 0) == 0) {
+            entry.hmac = true;
+            tag.erase(0, 5);
+        }
+        auto tree = tag.find("-tree-");
+        if (tree != std::string::npos && tag.back() == 'k') {
+            try {
+                entry.leaf_kb = std::stoul(tag.substr(tree + 6, tag.size() - tree - 7));
+            } catch (...) {
+                return std::nullopt;
+            }
+            tag.erase(tree);
+        }
+        entry.algorithm = tag;
+        entry.path = line.substr(open + 2, close - open - 2);
+        entry.expected = line.substr(close + 4);
+    } else {
+        // sha256sum format: hash, space, ' ' (text) or '*' (binary), name
+        auto space = line.find(' ');
+        if (space == std::string::npos || space + 2 >= line.size() ||
+            (line[space + 1] != ' ' && line[space + 1] != '*')) {
+            return std::nullopt;
+        }
+        entry.expected = line.substr(0, space);
+        entry.path = line.substr(space + 2);
+    }
+    
+    std::transform(entry.expected.begin(), entry.expected.end(), entry.expected.begin(), ::tolower);
+    if (!is_hex(entry.expected) || entry.path.empty() || (entry.leaf_kb == 0 && entry.algorithm.ends_with("-tree"))) {
+        return std::nullopt;
+    }
+    if (escaped) {
+        entry.path = unescape_name(entry.path);
+    }
+    return entry;
+}
+
+} // anonymous namespace
+
 HashCommand::HashCommand(core::CryptoEngine& engine)
     : engine_(engine) {
 }
@@ -24,13 +203,12 @@ HashCommand::HashCommand(core::CryptoEngine& engine)
 void HashCommand::setup(CLI::App& app) {
     auto* cmd = app.add_subcommand(name(), description());
     
-    cmd->add_option("input", input_file_, "Input file to hash")
-        ->required()
-        ->check(CLI::ExistingFile);
+    cmd->add_option("inputs", inputs_, "Files, directories (hashed recursively) or quoted globs");
     
     cmd->add_option("-a,--algorithm", algorithm_, 
                    "Hash algorithm: md5, sha1, sha224, sha256, sha384, sha512, "
-                   "sha3-256, sha3-512, blake2b-512, blake2s-256")
+                   "sha3-256, sha3-512, blake2b-512, blake2s-256, xxh3-128, crc32c "
+                   "(comma-separated for several digests in one pass)")
         ->default_val("sha256");
     
     cmd->add_option("-o,--output", output_file_, 
@@ -39,6 +217,13 @@ void HashCommand::setup(CLI::App& app) {
     cmd->add_option("-v,--verify", verify_hash_, 
                    "Verify against expected hash");
     
+    cmd->add_option("-c,--check", check_file_,
+                   "Verify every file listed in a checksum manifest")
+        ->check(CLI::ExistingFile);
+    
+    cmd->add_option("--io-depth", io_depth_,
+                   "With --check, files read at once (0 = --threads; 1-2 for spinning disks)");
+    
     cmd->add_option("--hmac", hmac_key_, 
                    "Calculate HMAC with key (hex or string)");
     
@@ -53,12 +238,34 @@ void HashCommand::setup(CLI::App& app) {
     cmd->add_flag("--no-filename", no_filename_, 
                  "Don't include filename in output");
     
+    cmd->add_flag("--jsonl", jsonl_,
+                 "One JSON object per file and digest (file, algorithm, digest)");
+    
     cmd->add_flag("--verbose", verbose_, 
                  "Verbose output");
     
     cmd->add_flag("--benchmark", benchmark_, 
                  "Show performance metrics");
     
+    cmd->add_option("-T,--threads", threads_,
+                   "Files hashed in parallel (0 = one per core)");
+    
+    cmd->add_flag("--parallel-digests", parallel_digests_,
+                 "With several algorithms, compute each digest on its own thread");
+    
+    cmd->add_flag("--tree", tree_,
+                 "Merkle-tree digest: leaves hashed on all cores (not the plain hash)");
+    
+    cmd->add_option("--leaf-size", leaf_size_kb_, "Tree leaf size in KB")
+        ->check(CLI::Range(1, 1024 * 1024));
+    
+    cmd->add_flag("--cache", cache_,
+                 "Reuse digests of files unchanged since the last run (by inode, size and mtime)");
+    
+    cmd->add_option("--prefilter", prefilter_,
+                   "With --cache, revalidate touched files of unchanged size by this checksum")
+        ->check(CLI::IsMember({"xxh3-128", "crc32c"}));
+    
     cmd->footer(
         "\nExamples:\n"
         "  Hash with SHA256:      filevault hash file.txt\n"
@@ -68,12 +275,38 @@ void HashCommand::setup(CLI::App& app) {
         "  Verify hash:           filevault hash file.txt -v <expected-hash>\n"
         "  HMAC authentication:   filevault hash file.txt --hmac secretkey\n"
         "  Save to file:          filevault hash file.txt -o checksum.txt\n"
+        "  Checksum a tree:       filevault hash release/ -o SHA256SUMS\n"
+        "  Audit as JSON lines:   filevault hash release/ -a sha256,blake2b-512 --jsonl\n"
+        "  Glob (quoted):         filevault hash 'dist/**/*.tar.gz'\n"
+        "  Several digests:       filevault hash disk.img -a sha256,sha3-256,blake2b-512\n"
+        "  Huge file, all cores:  filevault hash disk.img --tree --leaf-size 1024\n"
+        "  Re-check a tree fast:  filevault hash release/ --cache\n"
+        "  ...after a touch/copy: filevault hash release/ --cache --prefilter xxh3-128\n"
+        "  Verify a manifest:     filevault hash --check SHA256SUMS -T 8\n"
         "\n"
         // Hash algorithm: md5, sha1, sha224, sha256, sha384, sha512, sha3-256, sha3-512, blake2b-512, blake2s-256
         "Algorithms: md5 (insecure), sha1 (insecure), sha224, sha256, sha384, sha512,\n"
         "            sha3-224, sha3-256, sha3-384, sha3-512,\n"
-        "            blake2b-256, blake2b-384, blake2b-512, blake2s-256\n"
+        "            blake2b-256, blake2b-384, blake2b-512, blake2s-256,\n"
+        "            xxh3-128, crc32c (checksums: accidental changes only)\n"
         "Output formats: hex, base64, binary\n"
+        "\n"
+        "Hex output is lowercase and one '<hash>  <file>' line per file, the\n"
+        "format sha256sum -c reads. Files are hashed in parallel and listed in\n"
+        "input order; directory contents are sorted by name. With several\n"
+        "algorithms each file is read once and printed as 'ALGO (file) = hash'.\n"
+        "Tree digests are printed as 'ALGO-TREE-<leaf>K (file) = hash' and only\n"
+        "match tree digests with the same algorithm and leaf size.\n"
+        "With sha256 or blake2s-256 alone, files under 16 KB are hashed in\n"
+        "batches, one file per SIMD lane (AVX2/AVX-512), for the same digests.\n"
+        "--cache keeps digests in ~/.filevault/hash_cache.bin; it trusts file\n"
+        "metadata, so a file rewritten with its old size and timestamps is missed.\n"
+        "HMACs are never cached. --prefilter stores a fast checksum next to the\n"
+        "digests; a file with new timestamps but the old size is checksummed, and\n"
+        "if that matches, the old digests are kept instead of being recomputed.\n"
+        "A mismatch costs one extra read of the file.\n"
+        "--check reads sha256sum and tagged lines; untagged lines use the first\n"
+        "-a algorithm. Files are always read, the cache is not consulted.\n"
     );
     
     cmd->callback([this]() { 
@@ -100,7 +333,11 @@ std::string HashCommand::get_botan_algorithm_name(const std::string& algo) {
         {"blake2b-256", "BLAKE2b(256)"},
         {"blake2b-384", "BLAKE2b(384)"},
         {"blake2b-512", "BLAKE2b(512)"},
-        {"blake2s-256", "Blake2s(256)"}
+        {"blake2b", "BLAKE2b(512)"},
+        {"blake2s-256", "Blake2s(256)"},
+        {"xxh3-128", "XXH3-128"},
+        {"xxh3", "XXH3-128"},
+        {"crc32c", "CRC32C"}
     };
     
     auto it = algo_map.find(algo);
@@ -111,100 +348,450 @@ bool HashCommand::is_secure_algorithm(const std::string& algo) {
     return algo != "md5" && algo != "sha1";
 }
 
+std::vector<std::string> HashCommand::expand_inputs(int& failures) {
+    archive::WalkOptions options;
+    options.threads = threads_;
+    auto expansion = archive::DirectoryWalker::expand_inputs(inputs_, options);
+    for (const auto& error : expansion.errors) {
+        utils::Console::warning(error);
+    }
+    for (const auto& missing : expansion.missing) {
+        utils::Console::error(missing);
+        failures++;
+    }
+    return std::move(expansion.files);
+}
+
+std::string HashCommand::format_hash(const std::string& hex_hash) const {
+    if (output_format_ == "base64") {
+        return utils::CryptoUtils::base64_encode(utils::CryptoUtils::hex_decode(hex_hash));
+    }
+    if (output_format_ == "binary") {
+        auto bytes = utils::CryptoUtils::hex_decode(hex_hash);
+        std::ostringstream binary_stream;
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            if (i > 0) binary_stream << " ";
+            binary_stream << std::bitset<8>(bytes[i]);
+        }
+        return binary_stream.str();
+    }
+    
+    std::string formatted = hex_hash;
+    if (uppercase_) {
+        std::transform(formatted.begin(), formatted.end(), formatted.begin(), ::toupper);
+    }
+    return formatted;
+}
+
+std::vector<std::string> HashCommand::hash_file(const std::string& filepath, bool show_progress) {
+    // Identity is taken before reading, so a write during hashing misses next time
+    std::optional<utils::FileIdentity> identity;
+    if (hash_cache_) {
+        identity = utils::HashCache::identify(filepath);
+    }
+    
+    std::vector<std::string> digests;
+    if (identity) {
+        digests = cached_digests(*identity);
+    }
+    
+    // Touched but possibly unchanged (copied, restored, checked out again):
+    // a matching checksum keeps the old digests
+    if (digests.empty() && identity && !prefilter_botan_.empty()) {
+        auto old_sum = hash_cache_->stale(*identity, prefilter_label_);
+        std::vector<std::string> old_digests;
+        for (const auto& label : labels_) {
+            auto old_digest = hash_cache_->stale(*identity, label);
+            if (!old_sum || !old_digest) {
+                break;
+            }
+            old_digests.push_back(std::move(*old_digest));
+        }
+        if (old_digests.size() == labels_.size()) {
+            auto sum = utils::CryptoUtils::hex_decode(
+                calculate_file_digests(filepath, {prefilter_botan_}, {}, show_progress).front());
+            if (std::string(sum.begin(), sum.end()) == *old_sum) {
+                hash_cache_->store(*identity, prefilter_label_, std::move(*old_sum));
+                for (size_t i = 0; i < labels_.size(); ++i) {
+                    digests.push_back(utils::CryptoUtils::hex_encode(
+                        std::span(reinterpret_cast<const uint8_t*>(old_digests[i].data()), old_digests[i].size()),
+                        false));
+                    hash_cache_->store(*identity, labels_[i], std::move(old_digests[i]));
+                }
+                prefilter_saves_++;
+            }
+        }
+    }
+    
+    if (digests.empty()) {
+        // The checksum rides along in the same pass over the file
+        auto algorithms = botan_algorithms_;
+        if (identity && !prefilter_botan_.empty()) {
+            algorithms.push_back(prefilter_botan_);
+        }
+        digests = calculate_file_digests(filepath, algorithms, hmac_key_bytes_, show_progress);
+        if (identity) {
+            store_digests(*identity, digests);
+        }
+        digests.resize(labels_.size());
+    }
+    for (auto& digest : digests) {
+        digest = format_hash(digest);
+    }
+    return digests;
+}
+
+std::vector<HashCommand::FileDigests> HashCommand::hash_small_files(const std::vector<std::string>& files) {
+    std::vector<FileDigests> results(files.size());
+    std::vector<std::optional<utils::FileIdentity>> identities(files.size());
+    std::vector<std::vector<uint8_t>> contents;
+    std::vector<size_t> unhashed;       // Index in files of each entry of contents
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (hash_cache_) {
+            identities[i] = utils::HashCache::identify(files[i]);
+            if (identities[i]) {
+                results[i].digests = cached_digests(*identities[i]);
+                if (!results[i].digests.empty()) {
+                    continue;
+                }
+            }
+        }
+        auto content = utils::FileIO::read_file(files[i]);
+        if (!content) {
+            results[i].error = content.error_message;
+            continue;
+        }
+        contents.push_back(std::move(content.value));
+        unhashed.push_back(i);
+    }
+    
+    std::vector<std::span<const uint8_t>> messages(contents.begin(), contents.end());
+    std::vector<uint8_t> digests(messages.size() * utils::multihash::DIGEST_SIZE);
+    utils::multihash::hash(*multi_buffer_, messages, digests);
+    for (size_t k = 0; k < unhashed.size(); ++k) {
+        size_t i = unhashed[k];
+        results[i].digests = {utils::CryptoUtils::hex_encode(
+            std::span(digests).subspan(k * utils::multihash::DIGEST_SIZE, utils::multihash::DIGEST_SIZE), false)};
+        if (identities[i]) {
+            store_digests(*identities[i], results[i].digests);
+        }
+    }
+    
+    for (auto& result : results) {
+        for (auto& digest : result.digests) {
+            digest = format_hash(digest);
+        }
+    }
+    return results;
+}
+
+std::vector<std::string> HashCommand::cached_digests(const utils::FileIdentity& identity) {
+    std::vector<std::string> digests;
+    bool complete = true;
+    for (const auto& label : labels_) {
+        auto cached = hash_cache_->lookup(identity, label);
+        if (cached) {
+            digests.push_back(utils::CryptoUtils::hex_encode(
+                std::span(reinterpret_cast<const uint8_t*>(cached->data()), cached->size()), false));
+        } else {
+            complete = false;
+        }
+    }
+    if (!complete) {
+        digests.clear();
+    }
+    return digests;
+}
+
+void HashCommand::store_digests(const utils::FileIdentity& identity, const std::vector<std::string>& digests) {
+    for (size_t i = 0; i < digests.size(); ++i) {
+        auto bytes = utils::CryptoUtils::hex_decode(digests[i]);
+        hash_cache_->store(identity, i < labels_.size() ? labels_[i] : prefilter_label_,
+                           std::string(bytes.begin(), bytes.end()));
+    }
+}
+
 int HashCommand::execute() {
     try {
-        // Warn about insecure algorithms
-        if (!is_secure_algorithm(algorithm_)) {
-            utils::Console::warning(
-                fmt::format("Algorithm '{}' is cryptographically BROKEN!", algorithm_)
-            );
-            fmt::print("  Use for compatibility only, not for security!\n\n");
+        // One or more algorithms, e.g. "sha256,blake2b-512"
+        algorithms_.clear();
+        botan_algorithms_.clear();
+        std::stringstream algorithm_list(algorithm_);
+        for (std::string algo; std::getline(algorithm_list, algo, ',');) {
+            algo.erase(std::remove_if(algo.begin(), algo.end(), ::isspace), algo.end());
+            std::transform(algo.begin(), algo.end(), algo.begin(), ::tolower);
+            if (algo.empty() || std::find(algorithms_.begin(), algorithms_.end(), algo) != algorithms_.end()) {
+                continue;
+            }
+            
+            // Warn about insecure algorithms
+            if (!is_secure_algorithm(algo)) {
+                utils::Console::warning(
+                    fmt::format("Algorithm '{}' is cryptographically BROKEN!", algo)
+                );
+                fmt::print("  Use for compatibility only, not for security!\n\n");
+            }
+            
+            // Get Botan algorithm name
+            std::string botan_algo = get_botan_algorithm_name(algo);
+            if (utils::is_checksum(botan_algo)) {
+                if (!hmac_key_.empty()) {
+                    utils::Console::error(fmt::format("{} is a checksum and cannot be keyed with --hmac", algo));
+                    return 1;
+                }
+                utils::Console::warning(
+                    fmt::format("'{}' is a checksum, not a cryptographic hash", algo)
+                );
+                fmt::print("  It catches corruption, not deliberate tampering.\n\n");
+            }
+            if (!utils::create_hash(botan_algo)) {
+                utils::Console::error("Hash algorithm not available: " + algo);
+                return 1;
+            }
+            algorithms_.push_back(algo);
+            botan_algorithms_.push_back(botan_algo);
         }
-        
-        // Get Botan algorithm name
-        std::string botan_algo = get_botan_algorithm_name(algorithm_);
-        
-        if (verbose_) {
-            utils::Console::info(fmt::format("Algorithm: {}", botan_algo));
-            utils::Console::info(fmt::format("File: {}", input_file_));
+        if (algorithms_.empty()) {
+            utils::Console::error("No hash algorithm given");
+            return 1;
+        }
+        // Tree digests are not the plain hash, so they are always labelled
+        bool multi_digest = algorithms_.size() > 1 || tree_;
+        if (tree_ && !hmac_key_.empty()) {
+            utils::Console::error("--tree cannot be combined with --hmac");
+            return 1;
+        }
+        labels_.clear();
+        for (const auto& algo : algorithms_) {
+            labels_.push_back(tree_ ? fmt::format("{}-tree-{}k", algo, leaf_size_kb_) : algo);
         }
         
-        // Calculate hash
-        std::string hash_result;
-        auto start_time = std::chrono::high_resolution_clock::now();
+        prefilter_botan_.clear();
+        prefilter_label_.clear();
+        prefilter_saves_ = 0;
+        if (!prefilter_.empty()) {
+            if (!cache_ || !hmac_key_.empty()) {
+                utils::Console::error("--prefilter needs --cache (and no --hmac)");
+                return 1;
+            }
+            prefilter_botan_ = get_botan_algorithm_name(prefilter_);
+            prefilter_label_ = fmt::format("{}-prefilter", tree_ ? fmt::format("{}-tree-{}k", prefilter_, leaf_size_kb_)
+                                                                : prefilter_);
+        }
         
-        if (hmac_key_.empty()) {
-            hash_result = calculate_file_hash(input_file_, botan_algo);
-        } else {
-            hash_result = calculate_file_hmac(input_file_, botan_algo, hmac_key_);
+        // One plain digest without a pre-filter: small files can share SIMD lanes
+        multi_buffer_.reset();
+        if (botan_algorithms_.size() == 1 && hmac_key_.empty() && !tree_ && prefilter_botan_.empty()) {
+            auto algorithm = utils::multihash::algorithm_for(botan_algorithms_.front());
+            if (algorithm && utils::multihash::preferred(*algorithm)) {
+                multi_buffer_ = algorithm;
+            }
         }
         
-        auto end_time = std::chrono::high_resolution_clock::now();
-        auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            end_time - start_time).count();
+        // Keyed digests depend on the key, so they are never cached
+        hash_cache_.reset();
+        if (cache_ && hmac_key_.empty()) {
+            hash_cache_ = std::make_unique<utils::HashCache>(utils::Config::get_hash_cache_path());
+            hash_cache_->load();
+        } else if (cache_ && verbose_) {
+            utils::Console::warning("--cache is ignored with --hmac");
+        }
         
-        // Convert to requested format
-        std::string formatted_hash;
-        if (output_format_ == "hex") {
-            formatted_hash = hash_result;
-            if (uppercase_) {
-                std::transform(formatted_hash.begin(), formatted_hash.end(), 
-                              formatted_hash.begin(), ::toupper);
+        // Parse key (try hex first, then as string)
+        hmac_key_bytes_.clear();
+        if (!hmac_key_.empty()) {
+            try {
+                hmac_key_bytes_ = utils::CryptoUtils::hex_decode(hmac_key_);
+            } catch (...) {
+                hmac_key_bytes_.assign(hmac_key_.begin(), hmac_key_.end());
             }
-        } else if (output_format_ == "base64") {
-            // Convert hex to base64
-            auto bytes = Botan::hex_decode(hash_result);
-            formatted_hash = Botan::base64_encode(bytes);
-        } else if (output_format_ == "binary") {
-            // Convert hex to binary string
-            auto bytes = Botan::hex_decode(hash_result);
-            std::ostringstream binary_stream;
-            for (size_t i = 0; i < bytes.size(); ++i) {
-                if (i > 0) binary_stream << " ";
-                binary_stream << std::bitset<8>(bytes[i]);
+        }
+        
+        if (!check_file_.empty()) {
+            if (tree_ || !inputs_.empty()) {
+                utils::Console::error("--check takes no files and no --tree (tree digests are tagged)");
+                return 1;
             }
-            formatted_hash = binary_stream.str();
-        } else {
-            formatted_hash = hash_result;
+            return check_mode();
+        }
+        if (inputs_.empty()) {
+            utils::Console::error("No input files (or use --check <manifest>)");
+            return 1;
+        }
+        
+        int failures = 0;
+        auto files = expand_inputs(failures);
+        if (!verify_hash_.empty() && (files.size() != 1 || multi_digest)) {
+            utils::Console::error("--verify takes exactly one file and one algorithm");
+            return 1;
         }
         
-        // Uppercase only applies to hex format
-        hash_result = formatted_hash;
+        if (verbose_) {
+            utils::Console::info(fmt::format("Algorithm: {}", fmt::join(botan_algorithms_, ", ")));
+            utils::Console::info(files.size() == 1 ? fmt::format("File: {}", files.front())
+                                                   : fmt::format("Files: {}", files.size()));
+        }
+        
+        auto start_time = std::chrono::high_resolution_clock::now();
         
         // Verify mode
         if (!verify_hash_.empty()) {
-            return verify_mode(hash_result);
+            int result = verify_mode(hash_file(files.front(), verbose_).front(), files.front());
+            if (hash_cache_) {
+                hash_cache_->save();
+            }
+            return result;
         }
         
-        // Normal output mode
-        std::string output;
-        if (!no_filename_) {
-            output = fmt::format("{}  {}", hash_result, input_file_);
-        } else {
-            output = hash_result;
+        if (jsonl_ && output_format_ == "binary") {
+            utils::Console::error("--jsonl needs a text digest format (hex or base64)");
+            return 1;
         }
         
-        // Write output
-        if (output_file_.empty()) {
-            fmt::print("{}\n", output);
-        } else {
-            std::ofstream out(output_file_);
-            out << output << '\n';
+        std::unique_ptr<std::FILE, int (*)(std::FILE*)> out_file(nullptr, &std::fclose);
+        if (!output_file_.empty()) {
+            out_file.reset(std::fopen(output_file_.c_str(), "wb"));
+            if (!out_file) {
+                utils::Console::error("Cannot create output file: " + output_file_);
+                return 1;
+            }
+        }
+        
+        // Lines are collected and written in blocks rather than one by one
+        utils::RowWriter writer({{"file", 0, false, false},
+                                 {"algorithm", 0, false, false},
+                                 {"digest", 0, false, false}},
+                                jsonl_ ? utils::RowFormat::JSONL : utils::RowFormat::TSV,
+                                out_file ? out_file.get() : stdout);
+        
+        // Each file is one task on the shared queue, so idle workers pick up
+        // the next file while a large one is still being read. Results are
+        // printed in input order as soon as every earlier file is done.
+        // Tree mode puts the cores on one file at a time instead
+        core::TaskGroup pool(core::Executor::shared(),
+                             tree_ ? 1 : threads_ == 0 ? 0 : std::min(threads_, std::max<size_t>(files.size(), 1)));
+        bool show_progress = verbose_ && files.size() == 1;
+        // A task is one file, or a batch of small files for the multi-buffer kernels
+        std::deque<std::pair<std::vector<std::string>, std::future<std::vector<FileDigests>>>> pending;
+        uint64_t total_bytes = 0;
+        
+        auto print_next = [&]() {
+            auto [filepaths, future] = std::move(pending.front());
+            pending.pop_front();
+            std::vector<FileDigests> results;
+            try {
+                results = pool.wait(future);
+            } catch (const std::exception& e) {
+                results.assign(filepaths.size(), FileDigests{{}, e.what()});
+            }
+            for (size_t f = 0; f < filepaths.size(); ++f) {
+                const auto& filepath = filepaths[f];
+                const auto& hashes = results[f].digests;
+                if (!results[f].error.empty()) {
+                    writer.flush();     // Keep the error after the lines before it
+                    utils::Console::error(fmt::format("{}: {}", filepath, results[f].error));
+                    failures++;
+                    continue;
+                }
+                for (size_t i = 0; i < hashes.size(); ++i) {
+                    if (jsonl_) {
+                        writer.row({filepath, labels_[i], hashes[i]});
+                        continue;
+                    }
+                    // Several digests use the BSD tagged format ("SHA256 (file) = ...")
+                    writer.line(no_filename_ ? hashes[i]
+                                : multi_digest ? tagged_line(labels_[i], !hmac_key_bytes_.empty(),
+                                                             hashes[i], filepath)
+                                : checksum_line(hashes[i], filepath));
+                }
+                std::error_code ec;
+                total_bytes += fs::file_size(filepath, ec);
+            }
+        };
+        auto keep_up = [&]() {
+            while (pending.size() >= pool.size() * PENDING_PER_WORKER) {
+                print_next();
+            }
+        };
+        
+        std::vector<std::string> small_files;
+        auto submit_small_files = [&]() {
+            if (small_files.empty()) {
+                return;
+            }
+            pending.emplace_back(small_files, pool.submit([this, batch = small_files]() {
+                return hash_small_files(batch);
+            }));
+            small_files.clear();
+            keep_up();
+        };
+        
+        for (const auto& filepath : files) {
+            if (multi_buffer_) {
+                std::error_code ec;
+                auto size = fs::file_size(filepath, ec);
+                if (!ec && size < SMALL_FILE_SIZE) {
+                    small_files.push_back(filepath);
+                    if (small_files.size() == SMALL_FILE_BATCH) {
+                        submit_small_files();
+                    }
+                    continue;
+                }
+            }
+            // Output order is input order, so a large file ends the batch before it
+            submit_small_files();
+            pending.emplace_back(std::vector<std::string>{filepath}, pool.submit([this, filepath, show_progress]() {
+                return std::vector<FileDigests>{{hash_file(filepath, show_progress), {}}};
+            }));
+            keep_up();
+        }
+        submit_small_files();
+        while (!pending.empty()) {
+            print_next();
+        }
+        
+        auto end_time = std::chrono::high_resolution_clock::now();
+        auto duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            end_time - start_time).count();
+        
+        if (!writer.flush()) {
+            utils::Console::error("Failed to write the digests");
+            failures++;
+        } else if (out_file) {
+            out_file.reset();
             utils::Console::success(fmt::format("Hash written to: {}", output_file_));
         }
         
+        if (hash_cache_) {
+            auto saved = hash_cache_->save();
+            if (!saved) {
+                utils::Console::warning(saved.error_message);
+            }
+        }
+        
         // Benchmark info
         if (benchmark_ || verbose_) {
-            auto file_size = utils::FileIO::file_size(input_file_);
-            double throughput_mbps = (file_size / 1024.0 / 1024.0) / (duration_ms / 1000.0);
+            double throughput_mbps = (total_bytes / 1024.0 / 1024.0) / (std::max<int64_t>(duration_ms, 1) / 1000.0);
             
             fmt::print("\n");
-            utils::Console::info(fmt::format("File size: {} bytes", file_size));
+            if (files.size() > 1) {
+                utils::Console::info(fmt::format("Files: {} ({} threads)", files.size(), pool.size()));
+            }
+            utils::Console::info(fmt::format("Total size: {} bytes", total_bytes));
             utils::Console::info(fmt::format("Time: {} ms", duration_ms));
             utils::Console::info(fmt::format("Throughput: {:.2f} MB/s", throughput_mbps));
+            if (hash_cache_) {
+                utils::Console::info(fmt::format("Cache: {} hits, {} misses ({} entries)",
+                                                 hash_cache_->hits(), hash_cache_->misses(),
+                                                 hash_cache_->size()));
+            }
+            if (!prefilter_botan_.empty()) {
+                utils::Console::info(fmt::format("Pre-filter: {} touched files kept their digests",
+                                                 prefilter_saves_.load()));
+            }
         }
         
-        return 0;
+        return failures == 0 ? 0 : 1;
         
     } catch (const Botan::Exception& e) {
         utils::Console::error(fmt::format("Botan error: {}", e.what()));
@@ -215,51 +802,106 @@ int HashCommand::execute() {
     }
 }
 
-std::string HashCommand::calculate_file_hash(
+std::vector<std::string> HashCommand::calculate_file_digests(
     const std::string& filepath,
-    const std::string& algorithm
+    const std::vector<std::string>& algorithms,
+    const std::vector<uint8_t>& hmac_key,
+    bool show_progress
 ) {
-    auto hash_func = Botan::HashFunction::create(algorithm);
-    if (!hash_func) {
-        throw std::runtime_error("Hash algorithm not available: " + algorithm);
+    // Plain hashes or HMACs; both are fed and finished the same way
+    std::vector<std::unique_ptr<Botan::HashFunction>> hashes;
+    std::vector<KeyedMac*> macs(hmac_key.empty() ? 0 : algorithms.size());
+    for (const auto& algorithm : algorithms) {
+        if (hmac_key.empty()) {
+            auto hash_func = utils::create_hash(algorithm);
+            if (!hash_func) {
+                throw std::runtime_error("Hash algorithm not available: " + algorithm);
+            }
+            hashes.push_back(std::move(hash_func));
+        }
     }
+    // MAC states are thread_local: bind each on the thread that feeds it
+    auto bind_mac = [&](size_t index) {
+        if (!hmac_key.empty()) {
+            macs[index] = &keyed_mac(algorithms[index], hmac_key, index);
+        }
+    };
     
-    std::ifstream file(filepath, std::ios::binary);
-    if (!file) {
-        throw std::runtime_error("Cannot open file: " + filepath);
+    // Read-only mapping: no copies through a stream buffer, and the kernel
+    // reads ahead sequentially
+    auto mapped = utils::FileIO::map_file(filepath);
+    if (!mapped) {
+        throw std::runtime_error(mapped.error_message);
     }
+    auto data = mapped.value.span();
     
-    // Get file size for progress
-    file.seekg(0, std::ios::end);
-    size_t file_size = file.tellg();
-    file.seekg(0, std::ios::beg);
+    std::vector<std::string> digests(algorithms.size());
+    if (tree_) {
+        for (size_t i = 0; i < algorithms.size(); ++i) {
+            core::TreeHash tree(algorithms[i], leaf_size_kb_ * 1024);
+            digests[i] = utils::CryptoUtils::hex_encode(tree.hash(data, threads_), false);
+        }
+        return digests;
+    }
     
-    // Read and hash in chunks
-    const size_t CHUNK_SIZE = 64 * 1024;  // 64KB chunks
-    std::vector<uint8_t> buffer(CHUNK_SIZE);
-    size_t total_read = 0;
+    auto feed = [&](size_t index, std::span<const uint8_t> slice) {
+        if (hmac_key.empty()) {
+            hashes[index]->update(slice.data(), slice.size());
+        } else {
+            macs[index]->clean = false;
+            macs[index]->mac->update(slice.data(), slice.size());
+        }
+    };
+    auto finish = [&](size_t index) {
+        if (hmac_key.empty()) {
+            return utils::CryptoUtils::hex_encode(hashes[index]->final(), false);
+        }
+        auto result = macs[index]->mac->final();
+        macs[index]->clean = true;
+        return utils::CryptoUtils::hex_encode(result, false);
+    };
+    
+    // Slices small enough to stay in cache between digests
+    const size_t SLICE_SIZE = 1024 * 1024;
+    
+    if (parallel_digests_ && algorithms.size() > 1) {
+        core::TaskGroup group(core::Executor::shared(), algorithms.size());
+        std::vector<std::future<std::string>> workers;
+        for (size_t i = 0; i < algorithms.size(); ++i) {
+            workers.push_back(group.submit([&, i]() {
+                bind_mac(i);
+                for (size_t offset = 0; offset < data.size(); offset += SLICE_SIZE) {
+                    feed(i, data.subspan(offset, std::min(SLICE_SIZE, data.size() - offset)));
+                }
+                return finish(i);
+            }));
+        }
+        for (size_t i = 0; i < workers.size(); ++i) {
+            digests[i] = group.wait(workers[i]);
+        }
+        return digests;
+    }
+    
+    for (size_t i = 0; i < macs.size(); ++i) {
+        bind_mac(i);
+    }
     
     // Progress bar for large files
     std::unique_ptr<utils::ProgressBar> progress;
-    if (verbose_ && file_size > 1024 * 1024) {  // > 1MB
+    if (show_progress && data.size() > 1024 * 1024) {  // > 1MB
         progress = std::make_unique<utils::ProgressBar>(
-            fmt::format("Hashing with {}", algorithm),
+            fmt::format("Hashing with {}", fmt::join(algorithms, ", ")),
             100  // Use percentage
         );
     }
     
-    while (file) {
-        file.read(reinterpret_cast<char*>(buffer.data()), CHUNK_SIZE);
-        std::streamsize bytes_read = file.gcount();
-        
-        if (bytes_read > 0) {
-            hash_func->update(buffer.data(), bytes_read);
-            total_read += bytes_read;
-            
-            if (progress) {
-                size_t percentage = (total_read * 100) / file_size;
-                progress->set_progress(percentage);
-            }
+    for (size_t offset = 0; offset < data.size(); offset += SLICE_SIZE) {
+        auto slice = data.subspan(offset, std::min(SLICE_SIZE, data.size() - offset));
+        for (size_t i = 0; i < algorithms.size(); ++i) {
+            feed(i, slice);
+        }
+        if (progress) {
+            progress->set_progress((offset + slice.size()) * 100 / data.size());
         }
     }
     
@@ -267,57 +909,124 @@ std::string HashCommand::calculate_file_hash(
         progress->mark_as_completed();
     }
     
-    auto result = hash_func->final();
-    return Botan::hex_encode(result);
+    for (size_t i = 0; i < algorithms.size(); ++i) {
+        digests[i] = finish(i);
+    }
+    return digests;
 }
 
-std::string HashCommand::calculate_file_hmac(
-    const std::string& filepath,
-    const std::string& hash_algorithm,
-    const std::string& key_str
-) {
-    // Parse key (try hex first, then as string)
-    std::vector<uint8_t> key;
-    try {
-        key = Botan::hex_decode(key_str);
-    } catch (...) {
-        key.assign(key_str.begin(), key_str.end());
+int HashCommand::check_mode() {
+    std::ifstream manifest(check_file_);
+    if (!manifest) {
+        utils::Console::error("Cannot open manifest: " + check_file_);
+        return 1;
     }
     
-    // Create HMAC
-    auto hmac = Botan::MessageAuthenticationCode::create(
-        fmt::format("HMAC({})", hash_algorithm)
-    );
+    // Parse everything first, so a malformed manifest fails before any I/O
+    std::vector<ChecksumEntry> entries;
+    size_t malformed = 0;
+    size_t line_number = 0;
+    for (std::string line; std::getline(manifest, line);) {
+        line_number++;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        auto entry = parse_checksum_line(line, line_number);
+        if (!entry) {
+            utils::Console::warning(fmt::format("{}:{}: improperly formatted line", check_file_, line_number));
+            malformed++;
+            continue;
+        }
+        if (entry->algorithm.empty()) {
+            entry->algorithm = algorithms_.front();
+            entry->hmac = !hmac_key_bytes_.empty();
+        }
+        entries.push_back(std::move(*entry));
+    }
+    if (entries.empty()) {
+        utils::Console::error(fmt::format("{}: no checksum lines found", check_file_));
+        return 1;
+    }
     
-    if (!hmac) {
-        throw std::runtime_error("HMAC not available for: " + hash_algorithm);
+    // Reading is the bottleneck on disks; more readers than io_depth_ only seek
+    size_t workers = threads_ == 0 ? core::SystemResources::detect().cpus : threads_;
+    if (io_depth_ > 0) {
+        workers = std::min(workers, io_depth_);
     }
+    core::TaskGroup pool(core::Executor::shared(), std::clamp<size_t>(workers, 1, entries.size()));
     
-    hmac->set_key(key);
+    std::mutex print_mutex;
+    std::atomic<uint64_t> total_bytes{0};
+    std::atomic<size_t> mismatched{0};
+    std::atomic<size_t> unreadable{0};
+    auto start_time = std::chrono::steady_clock::now();
     
-    // Read and process file
-    std::ifstream file(filepath, std::ios::binary);
-    if (!file) {
-        throw std::runtime_error("Cannot open file: " + filepath);
+    std::vector<std::future<void>> tasks;
+    tasks.reserve(entries.size());
+    for (const auto& entry : entries) {
+        tasks.push_back(pool.submit([&, &entry = entry]() {
+            std::string actual;
+            std::string error;
+            try {
+                std::string botan_algo = get_botan_algorithm_name(entry.algorithm);
+                if (entry.hmac && hmac_key_bytes_.empty()) {
+                    throw std::runtime_error("HMAC line needs --hmac");
+                }
+                if (entry.leaf_kb > 0) {
+                    auto mapped = utils::FileIO::map_file(entry.path);
+                    if (!mapped) {
+                        throw std::runtime_error(mapped.error_message);
+                    }
+                    core::TreeHash tree(botan_algo, entry.leaf_kb * 1024);
+                    actual = utils::CryptoUtils::hex_encode(tree.hash(mapped.value.span(), 1), false);
+                } else {
+                    auto key = entry.hmac ? hmac_key_bytes_ : std::vector<uint8_t>{};
+                    actual = calculate_file_digests(entry.path, {botan_algo}, key, false).front();
+                }
+                std::error_code ec;
+                total_bytes += fs::file_size(entry.path, ec);
+            } catch (const std::exception& e) {
+                error = e.what();
+            }
+            
+            std::lock_guard<std::mutex> lock(print_mutex);
+            if (!error.empty()) {
+                unreadable++;
+                utils::Console::error(fmt::format("{}: FAILED open or read ({})", entry.path, error));
+            } else if (actual != entry.expected) {
+                mismatched++;
+                utils::Console::error(fmt::format("{}: FAILED", entry.path));
+            } else if (verbose_) {
+                fmt::print("{}: OK\n", entry.path);
+            }
+        }));
+    }
+    for (auto& task : tasks) {
+        pool.wait(task);
     }
     
-    const size_t CHUNK_SIZE = 64 * 1024;
-    std::vector<uint8_t> buffer(CHUNK_SIZE);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    double throughput_mbps = (total_bytes / 1024.0 / 1024.0) / std::max(seconds, 0.001);
+    size_t failed = mismatched + unreadable;
     
-    while (file) {
-        file.read(reinterpret_cast<char*>(buffer.data()), CHUNK_SIZE);
-        std::streamsize bytes_read = file.gcount();
-        
-        if (bytes_read > 0) {
-            hmac->update(buffer.data(), bytes_read);
-        }
+    fmt::print("\n");
+    if (failed == 0 && malformed == 0) {
+        utils::Console::success(fmt::format("{} files OK", entries.size()));
+    } else {
+        utils::Console::error(fmt::format("{} of {} files failed ({} mismatched, {} unreadable), {} bad lines",
+                                          failed, entries.size(), mismatched.load(), unreadable.load(),
+                                          malformed));
     }
-    
-    auto result = hmac->final();
-    return Botan::hex_encode(result);
+    utils::Console::info(fmt::format("Checked {} in {:.2f}s: {:.2f} MB/s ({} readers)",
+                                     utils::CryptoUtils::format_bytes(total_bytes), seconds,
+                                     throughput_mbps, pool.size()));
+    return failed == 0 && malformed == 0 ? 0 : 1;
 }
 
-int HashCommand::verify_mode(const std::string& calculated_hash) {
+int HashCommand::verify_mode(const std::string& calculated_hash, const std::string& filepath) {
     // Normalize hashes for comparison
     std::string expected = verify_hash_;
     std::string actual = calculated_hash;
@@ -337,7 +1046,7 @@ int HashCommand::verify_mode(const std::string& calculated_hash) {
     if (!output_file_.empty()) {
         std::string output;
         if (!no_filename_) {
-            output = fmt::format("{}  {}", calculated_hash, input_file_);
+            output = fmt::format("{}  {}", calculated_hash, filepath);
         } else {
             output = calculated_hash;
         }
@@ -348,12 +1057,12 @@ int HashCommand::verify_mode(const std::string& calculated_hash) {
     
     if (verified) {
         utils::Console::success(
-            fmt::format("{}: [PASS] Hash verification successful", input_file_)
+            fmt::format("{}: [PASS] Hash verification successful", filepath)
         );
         return 0;
     } else {
         utils::Console::error(
-            fmt::format("{}: [FAIL] Hash verification failed", input_file_)
+            fmt::format("{}: [FAIL] Hash verification failed", filepath)
         );
         
         if (verbose_) {
@@ -1,8 +1,15 @@
 #include "filevault/cli/commands/info_cmd.hpp"
+#include "filevault/compression/compressor.hpp"
+#include "filevault/core/cpu_features.hpp"
 #include "filevault/core/file_format.hpp"
+#include "filevault/core/streaming.hpp"
+#include "filevault/core/system_resources.hpp"
 #include "filevault/utils/console.hpp"
 #include "filevault/utils/crypto_utils.hpp"
 #include <fmt/core.h>
+#include <fmt/ranges.h>
+#include <algorithm>
+#include <cstdlib>
 #include <fstream>
 
 namespace filevault {
@@ -16,15 +23,16 @@ void InfoCommand::setup(CLI::App& app) {
     auto* cmd = app.add_subcommand(name(), description());
     
     cmd->add_option("input", input_file_, "Encrypted file to inspect")
-        ->required()
         ->check(CLI::ExistingFile);
     
     cmd->add_flag("-v,--verbose", verbose_, "Show detailed information");
+    cmd->add_flag("--cpu", show_cpu_, "Show CPU crypto capabilities and usable CPUs and memory");
 
     cmd->footer(
         "\nExamples:\n"
         "  Show file info:        filevault info secret.fvlt\n"
         "  Verbose output:       filevault info secret.fvlt -v\n"
+        "  CPU capabilities:     filevault info --cpu\n"
         "\n"
         "Displays information about the encrypted file, including format version,\n"
         "encryption algorithm, KDF, compression, and sizes of various components.\n"
@@ -40,10 +48,21 @@ void InfoCommand::setup(CLI::App& app) {
 
 int InfoCommand::execute() {
     try {
-        utils::Console::header("File Information");
+        if (input_file_.empty() && !show_cpu_) {
+            utils::Console::error("Specify a file to inspect or --cpu");
+            return 1;
+        }
         
-        auto info = parse_file(input_file_);
-        display_info(info);
+        if (!input_file_.empty()) {
+            utils::Console::header("File Information");
+            
+            auto info = parse_file(input_file_);
+            display_info(info);
+        }
+        
+        if (show_cpu_) {
+            display_cpu_info();
+        }
         
         return 0;
         
@@ -65,11 +84,36 @@ InfoCommand::FileInfo InfoCommand::parse_file(const std::string& path) {
     info.file_size = file.tellg();
     file.seekg(0, std::ios::beg);
     
+    // Chunked format: header plus per-chunk frames, each with its own tag
+    if (auto stream = core::StreamingCrypto::read_info(path)) {
+        info.has_header = true;
+        info.version = !stream->authenticated_header ? fmt::format("stream v{}", stream->version)
+                     : stream->wide_frames ? "2.0 (wide frames)" : "2.0";
+        info.algorithm = engine_.algorithm_name(stream->algorithm);
+        info.kdf = engine_.kdf_name(stream->kdf);
+        info.security = engine_.security_level_name(stream->level);
+        info.compression = compression::CompressionService::get_algorithm_name(stream->compression);
+        info.compressed = stream->compression != core::CompressionType::NONE;
+        info.salt_size = stream->salt_size;
+        info.nonce_size = stream->nonce_size;
+        info.tag_size = 16;
+        info.header_size = stream->header_size;
+        info.data_size = info.file_size - (std::min)(info.file_size, info.header_size);
+        info.chunk_size = stream->chunk_size;
+        info.chunk_count = stream->chunk_count.value_or(0);
+        info.authenticated_header = stream->authenticated_header;
+        info.wrapped_key = stream->wrapped_key;
+        info.key_generation = stream->key_generation;
+        return info;
+    }
+    
     // Check if this is an enhanced format file
     if (!core::FileFormatHandler::is_legacy_format(path)) {
         // Enhanced format with header
         try {
-            auto [header, ciphertext, auth_tag] = core::FileFormatHandler::read_file(path);
+            // Header only: the payload is never read
+            auto layout = core::FileFormatHandler::read_header(path);
+            const auto& header = layout.header;
             
             info.has_header = true;
             info.version = fmt::format("{}.{}", header.version_major, header.version_minor);
@@ -82,9 +126,9 @@ InfoCommand::FileInfo InfoCommand::parse_file(const std::string& path) {
             info.compression = core::FileFormatHandler::from_compression_id(header.compression);
             info.salt_size = header.salt.size();
             info.nonce_size = header.nonce.size();
-            info.tag_size = auth_tag.size();
-            info.data_size = ciphertext.size();
-            info.header_size = header.size();
+            info.tag_size = layout.tag_size;
+            info.data_size = layout.ciphertext_size;
+            info.header_size = layout.header_size;
             info.compressed = header.compressed;
             
             return info;
@@ -129,6 +173,20 @@ void InfoCommand::display_info(const FileInfo& info) {
         fmt::print("     {:25} : {}\n", "Key Derivation", info.kdf);
         fmt::print("     {:25} : {}\n", "Compression", info.compression);
         fmt::print("     {:25} : {}\n", "Compressed", info.compressed ? "Yes" : "No");
+        if (!info.security.empty()) {
+            fmt::print("     {:25} : {}\n", "Security Level", info.security);
+        }
+        fmt::print("\n");
+    }
+    
+    if (info.chunk_size > 0) {
+        fmt::print("  🧱 Block Layout:\n");
+        fmt::print("     {:25} : {}\n", "Block Size", utils::CryptoUtils::format_bytes(info.chunk_size));
+        fmt::print("     {:25} : {}\n", "Blocks",
+                   info.chunk_count > 0 ? std::to_string(info.chunk_count) : std::string("unknown (piped)"));
+        fmt::print("     {:25} : {}\n", "Header Authenticated", info.authenticated_header ? "Yes" : "No");
+        fmt::print("     {:25} : {}{}\n", "Header Rewrites", info.key_generation,
+                   info.wrapped_key ? "" : " (re-encrypt to enable rekey)");
         fmt::print("\n");
     }
     
@@ -138,7 +196,7 @@ void InfoCommand::display_info(const FileInfo& info) {
     }
     fmt::print("     {:25} : {} bytes\n", "Salt", info.salt_size);
     fmt::print("     {:25} : {} bytes\n", "Nonce", info.nonce_size);
-    fmt::print("     {:25} : {} bytes\n", "Auth Tag", info.tag_size);
+    fmt::print("     {:25} : {} bytes{}\n", "Auth Tag", info.tag_size, info.chunk_size > 0 ? " per block" : "");
     
     // For enhanced format, data_size is already just ciphertext (tag separate)
     // For legacy format, data_size includes tag, so subtract it
@@ -172,5 +230,33 @@ void InfoCommand::display_info(const FileInfo& info) {
     fmt::print("\n");
 }
 
+void InfoCommand::display_cpu_info() {
+    const auto& cpu = core::CpuFeatures::detect();
+    
+    utils::Console::header("CPU Capabilities");
+    fmt::print("\n");
+    fmt::print("  {:25} : {}\n", "Architecture", cpu.architecture);
+    fmt::print("  {:25} : {}\n", "Features",
+               cpu.names().empty() ? std::string("none detected") : fmt::format("{}", fmt::join(cpu.names(), " ")));
+    fmt::print("  {:25} : {}\n", "Hardware AES", cpu.hardware_aes() ? "yes" : "no");
+    fmt::print("  {:25} : {}\n", "Default AEAD", engine_.algorithm_name(cpu.preferred_aead()));
+    
+    const auto& resources = core::SystemResources::detect();
+    fmt::print("  {:25} : {} of {}{}\n", "Usable CPUs", resources.cpus, resources.host_cpus,
+               resources.cpu_limited() ? fmt::format(" ({})", resources.limited_by) : std::string());
+    fmt::print("  {:25} : {}\n", "Memory",
+               resources.memory_limit > 0
+                   ? fmt::format("{} limit ({}), {} available",
+                                 utils::CryptoUtils::format_bytes(resources.memory_limit), resources.limited_by,
+                                 utils::CryptoUtils::format_bytes(core::SystemResources::available_memory()))
+                   : fmt::format("{}, {} available", utils::CryptoUtils::format_bytes(resources.physical_memory),
+                                 utils::CryptoUtils::format_bytes(core::SystemResources::available_memory())));
+    
+    if (const char* cleared = std::getenv("BOTAN_CLEAR_CPUID")) {
+        fmt::print("  {:25} : {}\n", "Disabled (BOTAN_CLEAR_CPUID)", cleared);
+    }
+    fmt::print("\n");
+}
+
 } // namespace cli
 } // namespace filevault
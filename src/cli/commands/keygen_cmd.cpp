@@ -7,15 +7,166 @@
 #include "filevault/algorithms/asymmetric/rsa.hpp"
 #include "filevault/algorithms/asymmetric/ecc.hpp"
 #include "filevault/algorithms/pqc/post_quantum.hpp"
+#include "filevault/core/thread_pool.hpp"
 #include "filevault/utils/console.hpp"
 #include "filevault/utils/file_io.hpp"
+#include <botan/base64.h>
+#include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
-#include <fstream>
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
+#include <fstream>
+#include <future>
 
 namespace filevault {
 namespace cli {
 
+namespace {
+
+/**
+ * @brief One generated key pair
+ */
+struct GeneratedKey {
+    std::vector<uint8_t> public_key;
+    std::vector<uint8_t> private_key;
+    std::string type;
+    double milliseconds = 0.0;
+};
+
+/**
+ * @brief Generate a key pair for a (lower-case) keygen algorithm name
+ *
+ * Uses the calling thread's RNG, so concurrent calls on worker threads
+ * do not contend on one generator.
+ * @return false for an unknown algorithm
+ */
+bool generate_key(const std::string& algo, GeneratedKey& key) {
+    auto start = std::chrono::steady_clock::now();
+    if (algo == "rsa" || algo == "rsa-2048") {
+        algorithms::asymmetric::RSA rsa(2048);
+        auto keypair = rsa.generate_key_pair();
+        key.public_key = std::move(keypair.public_key);
+        key.private_key = std::move(keypair.private_key);
+        key.type = "RSA-2048";
+    } else if (algo == "rsa-3072") {
+        algorithms::asymmetric::RSA rsa(3072);
+        auto keypair = rsa.generate_key_pair();
+        key.public_key = std::move(keypair.public_key);
+        key.private_key = std::move(keypair.private_key);
+        key.type = "RSA-3072";
+    } else if (algo == "rsa-4096") {
+        algorithms::asymmetric::RSA rsa(4096);
+        auto keypair = rsa.generate_key_pair();
+        key.public_key = std::move(keypair.public_key);
+        key.private_key = std::move(keypair.private_key);
+        key.type = "RSA-4096";
+    } else if (algo == "ecc" || algo == "ecc-p256") {
+        algorithms::asymmetric::ECCHybrid ecc(algorithms::asymmetric::ECCurve::SECP256R1);
+        auto keypair = ecc.generate_key_pair();
+        key.public_key = std::move(keypair.public_key);
+        key.private_key = std::move(keypair.private_key);
+        key.type = "ECC-P256";
+    } else if (algo == "ecdsa-p256") {
+        // Signing keys; ECCHybrid keys are ECDH and cannot sign
+        algorithms::asymmetric::ECDSA ecdsa(algorithms::asymmetric::ECCurve::SECP256R1);
+        auto keypair = ecdsa.generate_key_pair();
+        key.public_key = std::move(keypair.public_key);
+        key.private_key = std::move(keypair.private_key);
+        key.type = "ECDSA-P256";
+    } else if (algo == "ecc-p384") {
+        algorithms::asymmetric::ECCHybrid ecc(algorithms::asymmetric::ECCurve::SECP384R1);
+        auto keypair = ecc.generate_key_pair();
+        key.public_key = std::move(keypair.public_key);
+        key.private_key = std::move(keypair.private_key);
+        key.type = "ECC-P384";
+    } else if (algo == "ecdsa-p384") {
+        // Signing keys; ECCHybrid keys are ECDH and cannot sign
+        algorithms::asymmetric::ECDSA ecdsa(algorithms::asymmetric::ECCurve::SECP384R1);
+        auto keypair = ecdsa.generate_key_pair();
+        key.public_key = std::move(keypair.public_key);
+        key.private_key = std::move(keypair.private_key);
+        key.type = "ECDSA-P384";
+    } else if (algo == "ecc-p521") {
+        algorithms::asymmetric::ECCHybrid ecc(algorithms::asymmetric::ECCurve::SECP521R1);
+        auto keypair = ecc.generate_key_pair();
+        key.public_key = std::move(keypair.public_key);
+        key.private_key = std::move(keypair.private_key);
+        key.type = "ECC-P521";
+    } else if (algo == "ecdsa-p521") {
+        // Signing keys; ECCHybrid keys are ECDH and cannot sign
+        algorithms::asymmetric::ECDSA ecdsa(algorithms::asymmetric::ECCurve::SECP521R1);
+        auto keypair = ecdsa.generate_key_pair();
+        key.public_key = std::move(keypair.public_key);
+        key.private_key = std::move(keypair.private_key);
+        key.type = "ECDSA-P521";
+    } else if (algo == "ecc-x25519" || algo == "x25519") {
+        algorithms::asymmetric::ECCHybrid ecc(algorithms::asymmetric::ECCurve::X25519);
+        auto keypair = ecc.generate_key_pair();
+        key.public_key = std::move(keypair.public_key);
+        key.private_key = std::move(keypair.private_key);
+        key.type = "ECC-X25519";
+    } else if (algo == "ed25519") {
+        algorithms::asymmetric::Ed25519 ed25519;
+        auto keypair = ed25519.generate_key_pair();
+        key.public_key = std::move(keypair.public_key);
+        key.private_key = std::move(keypair.private_key);
+        key.type = "Ed25519";
+    } 
+    // Kyber KEM
+    else if (algo == "kyber" || algo == "kyber-768" || algo == "kyber-hybrid" || algo == "kyber-768-hybrid") {
+        algorithms::pqc::Kyber kyber(algorithms::pqc::Kyber::Variant::Kyber768);
+        auto keypair = kyber.generate_keypair();
+        key.public_key = std::move(keypair.public_key);
+        key.private_key = std::move(keypair.private_key);
+        key.type = "Kyber-768";
+    } else if (algo == "kyber-512" || algo == "kyber-512-hybrid") {
+        algorithms::pqc::Kyber kyber(algorithms::pqc::Kyber::Variant::Kyber512);
+        auto keypair = kyber.generate_keypair();
+        key.public_key = std::move(keypair.public_key);
+        key.private_key = std::move(keypair.private_key);
+        key.type = "Kyber-512";
+    } else if (algo == "kyber-1024" || algo == "kyber-1024-hybrid") {
+        algorithms::pqc::Kyber kyber(algorithms::pqc::Kyber::Variant::Kyber1024);
+        auto keypair = kyber.generate_keypair();
+        key.public_key = std::move(keypair.public_key);
+        key.private_key = std::move(keypair.private_key);
+        key.type = "Kyber-1024";
+    }
+    // Dilithium Signatures
+    else if (algo == "dilithium" || algo == "dilithium-3") {
+        algorithms::pqc::Dilithium dil(algorithms::pqc::Dilithium::Variant::Dilithium3);
+        auto keypair = dil.generate_keypair();
+        key.public_key = std::move(keypair.public_key);
+        key.private_key = std::move(keypair.private_key);
+        key.type = "Dilithium-3";
+    } else if (algo == "dilithium-2") {
+        algorithms::pqc::Dilithium dil(algorithms::pqc::Dilithium::Variant::Dilithium2);
+        auto keypair = dil.generate_keypair();
+        key.public_key = std::move(keypair.public_key);
+        key.private_key = std::move(keypair.private_key);
+        key.type = "Dilithium-2";
+    } else if (algo == "dilithium-5") {
+        algorithms::pqc::Dilithium dil(algorithms::pqc::Dilithium::Variant::Dilithium5);
+        auto keypair = dil.generate_keypair();
+        key.public_key = std::move(keypair.public_key);
+        key.private_key = std::move(keypair.private_key);
+        key.type = "Dilithium-5";
+    } else {
+        return false;
+    }
+    key.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+bool write_key_file(const std::string& path, const std::vector<uint8_t>& data) {
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    return static_cast<bool>(file);
+}
+
+} // anonymous namespace
+
 KeygenCommand::KeygenCommand(core::CryptoEngine& engine) 
     : engine_(engine) {
 }
@@ -26,8 +177,8 @@ void KeygenCommand::setup(CLI::App& app) {
     cmd->add_option("-a,--algorithm", algorithm_, "Algorithm for key generation")
         ->check(CLI::IsMember({
             "rsa-2048", "rsa-3072", "rsa-4096", "rsa",
-            "ecc-p256", "ecc-p384", "ecc-p521", "ecc",
-            "ecdsa-p256", "ecdsa-p384", "ecdsa-p521",
+            "ecc-p256", "ecc-p384", "ecc-p521", "ecc", "ecc-x25519", "x25519",
+            "ecdsa-p256", "ecdsa-p384", "ecdsa-p521", "ed25519",
             // PQC algorithms
             "kyber-512", "kyber-768", "kyber-1024", "kyber",
             "kyber-512-hybrid", "kyber-768-hybrid", "kyber-1024-hybrid", "kyber-hybrid",
@@ -36,6 +187,13 @@ void KeygenCommand::setup(CLI::App& app) {
     
     cmd->add_option("-o,--output", output_prefix_, "Output file prefix (default: filevault_key)");
     
+    cmd->add_option("-n,--count", count_, "Number of key pairs (> 1 writes <prefix>-0001.pub, ...)")
+        ->check(CLI::Range(size_t(1), size_t(1000000)));
+    
+    cmd->add_option("-T,--threads", threads_, "Key pairs generated in parallel (0 = one per core)");
+    
+    cmd->add_option("--bundle", bundle_path_, "Write all key pairs to one JSON file instead");
+    
     cmd->add_flag("-f,--force", force_, "Overwrite existing key files");
     cmd->add_flag("-v,--verbose", verbose_, "Verbose output");
     
@@ -47,9 +205,12 @@ void KeygenCommand::setup(CLI::App& app) {
         "  Post-Quantum Kyber:    filevault keygen -a kyber-768\n"
         "  PQ Hybrid:             filevault keygen -a kyber-1024-hybrid\n"
         "  Dilithium signature:   filevault keygen -a dilithium-3\n"
+        "  Ed25519 signing key:   filevault keygen -a ed25519\n"
+        "  1000 device keys:      filevault keygen -a ecc-p256 -n 1000 -o devices/dev\n"
+        "  JSON bundle:           filevault keygen -a rsa-4096 -n 50 --bundle keys.json\n"
         "\n"
         "RSA: rsa-2048, rsa-3072, rsa-4096\n"
-        "ECC: ecc-p256, ecc-p384, ecc-p521, ecdsa-p256, ecdsa-p384, ecdsa-p521\n"
+        "ECC: ecc-p256, ecc-p384, ecc-p521, ecc-x25519 (ECDH), ecdsa-p256, ecdsa-p384, ecdsa-p521, ed25519\n"
         "Post-Quantum KEM: kyber-512, kyber-768, kyber-1024\n"
         "PQ Hybrid: kyber-512-hybrid, kyber-768-hybrid, kyber-1024-hybrid\n"
         "PQ Signatures: dilithium-2, dilithium-3, dilithium-5\n"
@@ -67,6 +228,14 @@ void KeygenCommand::setup(CLI::App& app) {
 int KeygenCommand::execute() {
     utils::Console::header("FileVault Key Generation");
     
+    // Normalize algorithm name
+    std::string algo = algorithm_;
+    std::transform(algo.begin(), algo.end(), algo.begin(), ::tolower);
+    
+    if (count_ > 1 || !bundle_path_.empty()) {
+        return execute_batch(algo);
+    }
+    
     std::string pub_file = output_prefix_ + ".pub";
     std::string priv_file = output_prefix_ + ".key";
     
@@ -84,95 +253,15 @@ int KeygenCommand::execute() {
     
     utils::Console::info(fmt::format("Generating {} key pair...", algorithm_));
     
-    std::vector<uint8_t> public_key;
-    std::vector<uint8_t> private_key;
-    std::string algo_type;
-    
     try {
-        // Normalize algorithm name
-        std::string algo = algorithm_;
-        std::transform(algo.begin(), algo.end(), algo.begin(), ::tolower);
-        
-        if (algo == "rsa" || algo == "rsa-2048") {
-            algorithms::asymmetric::RSA rsa(2048);
-            auto keypair = rsa.generate_key_pair();
-            public_key = keypair.public_key;
-            private_key = keypair.private_key;
-            algo_type = "RSA-2048";
-        } else if (algo == "rsa-3072") {
-            algorithms::asymmetric::RSA rsa(3072);
-            auto keypair = rsa.generate_key_pair();
-            public_key = keypair.public_key;
-            private_key = keypair.private_key;
-            algo_type = "RSA-3072";
-        } else if (algo == "rsa-4096") {
-            algorithms::asymmetric::RSA rsa(4096);
-            auto keypair = rsa.generate_key_pair();
-            public_key = keypair.public_key;
-            private_key = keypair.private_key;
-            algo_type = "RSA-4096";
-        } else if (algo == "ecc" || algo == "ecc-p256" || algo == "ecdsa-p256") {
-            algorithms::asymmetric::ECCHybrid ecc(algorithms::asymmetric::ECCurve::SECP256R1);
-            auto keypair = ecc.generate_key_pair();
-            public_key = keypair.public_key;
-            private_key = keypair.private_key;
-            algo_type = "ECC-P256";
-        } else if (algo == "ecc-p384" || algo == "ecdsa-p384") {
-            algorithms::asymmetric::ECCHybrid ecc(algorithms::asymmetric::ECCurve::SECP384R1);
-            auto keypair = ecc.generate_key_pair();
-            public_key = keypair.public_key;
-            private_key = keypair.private_key;
-            algo_type = "ECC-P384";
-        } else if (algo == "ecc-p521" || algo == "ecdsa-p521") {
-            algorithms::asymmetric::ECCHybrid ecc(algorithms::asymmetric::ECCurve::SECP521R1);
-            auto keypair = ecc.generate_key_pair();
-            public_key = keypair.public_key;
-            private_key = keypair.private_key;
-            algo_type = "ECC-P521";
-        } 
-        // Kyber KEM
-        else if (algo == "kyber" || algo == "kyber-768" || algo == "kyber-hybrid" || algo == "kyber-768-hybrid") {
-            algorithms::pqc::Kyber kyber(algorithms::pqc::Kyber::Variant::Kyber768);
-            auto keypair = kyber.generate_keypair();
-            public_key = keypair.public_key;
-            private_key = keypair.private_key;
-            algo_type = "Kyber-768";
-        } else if (algo == "kyber-512" || algo == "kyber-512-hybrid") {
-            algorithms::pqc::Kyber kyber(algorithms::pqc::Kyber::Variant::Kyber512);
-            auto keypair = kyber.generate_keypair();
-            public_key = keypair.public_key;
-            private_key = keypair.private_key;
-            algo_type = "Kyber-512";
-        } else if (algo == "kyber-1024" || algo == "kyber-1024-hybrid") {
-            algorithms::pqc::Kyber kyber(algorithms::pqc::Kyber::Variant::Kyber1024);
-            auto keypair = kyber.generate_keypair();
-            public_key = keypair.public_key;
-            private_key = keypair.private_key;
-            algo_type = "Kyber-1024";
-        }
-        // Dilithium Signatures
-        else if (algo == "dilithium" || algo == "dilithium-3") {
-            algorithms::pqc::Dilithium dil(algorithms::pqc::Dilithium::Variant::Dilithium3);
-            auto keypair = dil.generate_keypair();
-            public_key = keypair.public_key;
-            private_key = keypair.private_key;
-            algo_type = "Dilithium-3";
-        } else if (algo == "dilithium-2") {
-            algorithms::pqc::Dilithium dil(algorithms::pqc::Dilithium::Variant::Dilithium2);
-            auto keypair = dil.generate_keypair();
-            public_key = keypair.public_key;
-            private_key = keypair.private_key;
-            algo_type = "Dilithium-2";
-        } else if (algo == "dilithium-5") {
-            algorithms::pqc::Dilithium dil(algorithms::pqc::Dilithium::Variant::Dilithium5);
-            auto keypair = dil.generate_keypair();
-            public_key = keypair.public_key;
-            private_key = keypair.private_key;
-            algo_type = "Dilithium-5";
-        } else {
+        GeneratedKey key;
+        if (!generate_key(algo, key)) {
             utils::Console::error(fmt::format("Unknown algorithm: {}", algorithm_));
             return 1;
         }
+        const auto& public_key = key.public_key;
+        const auto& private_key = key.private_key;
+        const auto& algo_type = key.type;
         
         // Write public key
         {
@@ -216,5 +305,122 @@ int KeygenCommand::execute() {
     }
 }
 
+int KeygenCommand::execute_batch(const std::string& algo) {
+    // Output paths up front, so nothing is generated for a run that cannot finish
+    auto key_path = [this](size_t index, const char* extension) {
+        return fmt::format("{}-{:04d}{}", output_prefix_, index + 1, extension);
+    };
+    if (bundle_path_.empty()) {
+        for (size_t i = 0; i < count_ && !force_; ++i) {
+            for (const char* extension : {".pub", ".key"}) {
+                if (std::filesystem::exists(key_path(i, extension))) {
+                    utils::Console::error(fmt::format("Key file '{}' already exists. Use -f to overwrite.",
+                                                      key_path(i, extension)));
+                    return 1;
+                }
+            }
+        }
+        auto parent = std::filesystem::path(output_prefix_).parent_path();
+        if (!parent.empty()) {
+            std::filesystem::create_directories(parent);
+        }
+    } else if (!force_ && std::filesystem::exists(bundle_path_)) {
+        utils::Console::error(fmt::format("Bundle file '{}' already exists. Use -f to overwrite.", bundle_path_));
+        return 1;
+    }
+    
+    try {
+        core::ThreadPool pool(threads_ == 0 ? 0 : std::min(threads_, count_));
+        utils::Console::info(fmt::format("Generating {} {} key pairs on {} threads...",
+                                         count_, algorithm_, pool.size()));
+        
+        // Keys are written as they finish; only a bundle keeps them all in memory
+        auto start = std::chrono::steady_clock::now();
+        bool to_files = bundle_path_.empty();
+        std::vector<std::future<GeneratedKey>> tasks;
+        tasks.reserve(count_);
+        for (size_t i = 0; i < count_; ++i) {
+            tasks.push_back(pool.submit([&algo, &key_path, to_files, i]() {
+                GeneratedKey key;
+                if (!generate_key(algo, key)) {
+                    throw std::invalid_argument("Unknown algorithm: " + algo);
+                }
+                if (to_files && (!write_key_file(key_path(i, ".pub"), key.public_key) ||
+                                 !write_key_file(key_path(i, ".key"), key.private_key))) {
+                    throw std::runtime_error("Failed to write " + key_path(i, ".key"));
+                }
+                if (to_files) {
+                    key.public_key.clear();
+                    key.private_key.clear();
+                }
+                return key;
+            }));
+        }
+        
+        nlohmann::json bundle;
+        std::vector<double> timings;
+        timings.reserve(count_);
+        std::string type;
+        for (size_t i = 0; i < count_; ++i) {
+            auto key = tasks[i].get();
+            timings.push_back(key.milliseconds);
+            type = key.type;
+            if (!to_files) {
+                bundle["keys"].push_back({
+                    {"index", i + 1},
+                    {"public_key", Botan::base64_encode(key.public_key)},
+                    {"private_key", Botan::base64_encode(key.private_key)},
+                    {"generation_ms", key.milliseconds},
+                });
+            }
+            if (verbose_) {
+                utils::Console::info(fmt::format("Key {:>5}: {:.2f} ms", i + 1, key.milliseconds));
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        
+        if (!to_files) {
+            bundle["algorithm"] = type;
+            bundle["count"] = count_;
+            bundle["encoding"] = "base64";
+            std::ofstream file(bundle_path_);
+            file << bundle.dump(2) << "\n";
+            if (!file) {
+                utils::Console::error(fmt::format("Failed to write bundle: {}", bundle_path_));
+                return 1;
+            }
+        }
+        
+        // Per-key latency: RSA generation time varies widely with prime search
+        std::sort(timings.begin(), timings.end());
+        auto percentile = [&timings](double p) {
+            return timings[std::min(timings.size() - 1, static_cast<size_t>(p * timings.size()))];
+        };
+        double total_ms = 0.0;
+        for (double t : timings) {
+            total_ms += t;
+        }
+        
+        utils::Console::separator();
+        utils::Console::success(fmt::format("{} {} key pairs generated in {:.2f}s ({:.1f} keys/s)",
+                                            count_, type, seconds, count_ / std::max(seconds, 1e-9)));
+        if (to_files) {
+            utils::Console::info(fmt::format("Key files:   {} ... {}", key_path(0, ".pub/.key"),
+                                             key_path(count_ - 1, ".pub/.key")));
+        } else {
+            utils::Console::info(fmt::format("Bundle:      {}", bundle_path_));
+        }
+        utils::Console::info(fmt::format("Per key (ms): min {:.2f}, mean {:.2f}, p50 {:.2f}, p99 {:.2f}, max {:.2f}",
+                                         timings.front(), total_ms / timings.size(), percentile(0.50),
+                                         percentile(0.99), timings.back()));
+        utils::Console::warning("Keep your private keys secure! Never share them.");
+        return 0;
+        
+    } catch (const std::exception& e) {
+        utils::Console::error(fmt::format("Key generation failed: {}", e.what()));
+        return 1;
+    }
+}
+
 } // namespace cli
 } // namespace filevault
@@ -1,38 +1,93 @@
 #include "filevault/cli/commands/keyinfo_cmd.hpp"
+#include "filevault/algorithms/asymmetric/loaded_key.hpp"
+#include "filevault/archive/directory_walker.hpp"
+#include "filevault/core/thread_pool.hpp"
 #include "filevault/utils/console.hpp"
+#include "filevault/utils/row_writer.hpp"
 #include <botan/pk_keys.h>
-#include <botan/pem.h>
-#include <botan/data_src.h>
 #include <botan/x509_key.h>
-#include <botan/pkcs8.h>
 #include <botan/hex.h>
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <filesystem>
 #include <fstream>
-#include <sstream>
+#include <future>
 
 namespace filevault {
 namespace cli {
 namespace commands {
 
+namespace {
+
+// Larger files are not keys; a 16384-bit RSA private key PEM is ~12 KB
+constexpr size_t MAX_KEY_FILE_SIZE = 64 * 1024;
+
+std::string fingerprint(const algorithms::asymmetric::LoadedKey& key) {
+    auto public_bits = key.public_key().public_key_bits();
+    return Botan::hex_encode(public_bits.data(), std::min(size_t(20), public_bits.size()));
+}
+
+/**
+ * @brief Parse one key file into a report; reads at most MAX_KEY_FILE_SIZE bytes
+ */
+nlohmann::json describe_key(const std::string& path) {
+    nlohmann::json report = {{"file", path}};
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> encoded(MAX_KEY_FILE_SIZE + 1);
+    file.read(reinterpret_cast<char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+    if (file.bad() || (!file && file.gcount() == 0)) {
+        report["error"] = "Failed to open key file";
+        return report;
+    }
+    encoded.resize(static_cast<size_t>(file.gcount()));
+    if (encoded.size() > MAX_KEY_FILE_SIZE) {
+        report["error"] = "Too large for a key file";
+        return report;
+    }
+    
+    auto key = algorithms::asymmetric::LoadedKey::load(encoded);
+    if (!key) {
+        report["error"] = key.error_message;
+        return report;
+    }
+    report["type"] = key.value.is_private() ? "private" : "public";
+    report["algorithm"] = key.value.algorithm();
+    report["bits"] = key.value.key_bits();
+    report["fingerprint"] = fingerprint(key.value);
+    return report;
+}
+
+} // anonymous namespace
+
 KeyInfoCommand::KeyInfoCommand(core::CryptoEngine& engine) 
     : engine_(engine) {}
 
 void KeyInfoCommand::setup(CLI::App& app) {
     auto* cmd = app.add_subcommand(name_, description_);
     
-    cmd->add_option("key", key_path_, "Key file to inspect (PEM format)")
-        ->required()
-        ->check(CLI::ExistingFile);
+    cmd->add_option("keys", key_paths_, "Key files, directories or quoted globs to inspect")
+        ->required();
     
     cmd->add_flag("--public", show_public_, "Extract and display public key from private key");
     
     cmd->add_option("--check-pair", pair_key_path_, "Check if this key forms a valid pair with the main key")
         ->check(CLI::ExistingFile);
     
+    cmd->add_flag("--json", json_, "One JSON object per key (JSON lines)");
+    
+    cmd->add_option("--format", format_,
+                    "Listing format for several keys: auto (a table on a terminal, else tsv), table, tsv, jsonl")
+        ->check(CLI::IsMember({"auto", "table", "tsv", "jsonl"}));
+    
+    cmd->add_option("-T,--threads", threads_, "Keys parsed in parallel (0 = one per core)");
+    
     cmd->footer(
         "\nExamples:\n"
         "  Show key info:         filevault keyinfo private.pem\n"
         "  Extract public key:    filevault keyinfo private.pem --public\n"
         "  Check key pair:        filevault keyinfo private.pem --check-pair public.pem\n"
+        "  Audit a key store:     filevault keyinfo /etc/keys 'backup/*.pem' --json > keys.jsonl\n"
+        "  Key store as TSV:      filevault keyinfo /etc/keys | sort -t$'\\t' -k3n\n"
         "\n"
         "Supported formats: PEM (PKCS#8 for private, X.509 for public)\n"
         "Displays: algorithm, key size, fingerprint, validity\n"
@@ -47,79 +102,49 @@ void KeyInfoCommand::setup(CLI::App& app) {
 }
 
 int KeyInfoCommand::execute() {
+    bool single = key_paths_.size() == 1 && std::filesystem::is_regular_file(key_paths_.front());
+    if (json_) {
+        format_ = "jsonl";
+    }
+    if (single && format_ == "auto") {
+        return inspect_key(key_paths_.front());
+    }
+    if (show_public_ || !pair_key_path_.empty()) {
+        utils::Console::error("--public and --check-pair take a single key");
+        return 1;
+    }
+    return inspect_keys();
+}
+
+int KeyInfoCommand::inspect_key(const std::string& key_path) {
     try {
-        // Read key file
-        std::ifstream file(key_path_, std::ios::binary);
-        if (!file) {
-            utils::Console::error("Failed to open key file");
-            return 1;
-        }
-        
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        std::string key_pem = buffer.str();
-        file.close();
+        // Parse once; private keys are tried first
+        auto key_result = algorithms::asymmetric::LoadedKey::load_file(key_path);
         
         utils::Console::header("Key Information");
-        utils::Console::info(fmt::format("File: {}", key_path_));
-        
-        // Try to load as private key first
-        bool is_private = false;
-        std::unique_ptr<Botan::Private_Key> priv_key;
-        std::unique_ptr<Botan::Public_Key> pub_key;
-        
-        try {
-            Botan::DataSource_Memory key_source(key_pem);
-            priv_key = Botan::PKCS8::load_key(key_source);
-            if (priv_key) {
-                is_private = true;
-                utils::Console::info("Type: Private Key");
-            }
-        } catch (...) {
-            // Not a private key, try public
-        }
-        
-        if (!is_private) {
-            try {
-                Botan::DataSource_Memory key_source(key_pem);
-                pub_key = Botan::X509::load_key(key_source);
-                if (pub_key) {
-                    utils::Console::info("Type: Public Key");
-                }
-            } catch (const std::exception& e) {
-                utils::Console::error(fmt::format("Failed to load key: {}", e.what()));
-                return 1;
-            }
-        }
-        
-        // Get key information
-        const Botan::Public_Key* key_to_inspect = nullptr;
-        if (is_private && priv_key) {
-            key_to_inspect = priv_key.get();
-        } else if (pub_key) {
-            key_to_inspect = pub_key.get();
-        }
+        utils::Console::info(fmt::format("File: {}", key_path));
         
-        if (!key_to_inspect) {
-            utils::Console::error("Invalid key format");
+        if (!key_result) {
+            utils::Console::error(key_result.error_message);
             return 1;
         }
+        const auto& key = key_result.value;
+        bool is_private = key.is_private();
+        utils::Console::info(is_private ? "Type: Private Key" : "Type: Public Key");
         
         // Display key properties
-        utils::Console::info(fmt::format("Algorithm: {}", key_to_inspect->algo_name()));
-        utils::Console::info(fmt::format("Key Size: {} bits", key_to_inspect->key_length()));
+        const Botan::Public_Key& key_to_inspect = key.public_key();
+        utils::Console::info(fmt::format("Algorithm: {}", key.algorithm()));
+        utils::Console::info(fmt::format("Key Size: {} bits", key.key_bits()));
         
         // Get fingerprint
-        auto public_bits = key_to_inspect->public_key_bits();
-        auto fingerprint = Botan::hex_encode(public_bits.data(), 
-                                             std::min(size_t(20), public_bits.size()));
-        utils::Console::info(fmt::format("Fingerprint: {}", fingerprint));
+        utils::Console::info(fmt::format("Fingerprint: {}", fingerprint(key)));
         
         // Show public key if requested
-        if (show_public_ && is_private && priv_key) {
+        if (show_public_ && is_private) {
             fmt::print("\n");
             utils::Console::header("Public Key (PEM)");
-            std::string pub_pem = Botan::X509::PEM_encode(*priv_key);
+            std::string pub_pem = Botan::X509::PEM_encode(key.private_key());
             fmt::print("{}\n", pub_pem);
         }
         
@@ -128,41 +153,16 @@ int KeyInfoCommand::execute() {
             fmt::print("\n");
             utils::Console::header("Key Pair Validation");
             
-            std::ifstream pair_file(pair_key_path_, std::ios::binary);
-            if (!pair_file) {
-                utils::Console::error("Failed to open pair key file");
+            auto pair_result = algorithms::asymmetric::LoadedKey::load_file(pair_key_path_);
+            if (!pair_result) {
+                utils::Console::error(pair_result.error_message);
                 return 1;
             }
             
-            std::stringstream pair_buffer;
-            pair_buffer << pair_file.rdbuf();
-            std::string pair_pem = pair_buffer.str();
-            pair_file.close();
-            
             try {
-                // Load the pair key
-                std::unique_ptr<Botan::Public_Key> pair_pub;
-                std::unique_ptr<Botan::Private_Key> pair_priv;
-                
-                try {
-                    Botan::DataSource_Memory source(pair_pem);
-                    pair_priv = Botan::PKCS8::load_key(source);
-                    if (pair_priv) {
-                        pair_pub.reset(dynamic_cast<Botan::Public_Key*>(pair_priv.get()));
-                    }
-                } catch (...) {
-                    Botan::DataSource_Memory source(pair_pem);
-                    pair_pub = Botan::X509::load_key(source);
-                }
-                
-                if (!pair_pub) {
-                    utils::Console::error("Failed to load pair key");
-                    return 1;
-                }
-                
                 // Compare public key bits
-                auto bits1 = key_to_inspect->public_key_bits();
-                auto bits2 = pair_pub->public_key_bits();
+                auto bits1 = key_to_inspect.public_key_bits();
+                auto bits2 = pair_result.value.public_key().public_key_bits();
                 
                 if (bits1 == bits2) {
                     utils::Console::success("✓ Keys form a valid pair");
@@ -186,6 +186,71 @@ int KeyInfoCommand::execute() {
     }
 }
 
+int KeyInfoCommand::inspect_keys() {
+    auto start = std::chrono::steady_clock::now();
+    utils::RowFormat format = utils::RowFormat::TABLE;
+    utils::RowWriter::parse_format(format_, stdout, format);
+    if (format != utils::RowFormat::TABLE) {
+        // stdout carries only the rows
+        utils::Console::set_stream(stderr);
+    }
+    
+    archive::WalkOptions options;
+    options.threads = threads_;
+    auto expansion = archive::DirectoryWalker::expand_inputs(key_paths_, options);
+    for (const auto& error : expansion.errors) {
+        utils::Console::warning(error);
+    }
+    for (const auto& missing : expansion.missing) {
+        utils::Console::error(missing);
+    }
+    
+    core::ThreadPool pool(threads_);
+    std::vector<std::future<nlohmann::json>> reports;
+    reports.reserve(expansion.files.size());
+    for (const auto& path : expansion.files) {
+        reports.push_back(pool.submit([path]() { return describe_key(path); }));
+    }
+    
+    utils::RowWriter writer({{"file", 40, false, false},
+                             {"algorithm", 12, false, false},
+                             {"bits", 5, true, true},
+                             {"type", 7, false, false},
+                             {"fingerprint", 0, false, false}},
+                            format);
+    writer.header();
+    
+    // Printed in input order as results arrive
+    size_t failed = 0;
+    for (auto& future : reports) {
+        auto report = future.get();
+        bool ok = !report.contains("error");
+        failed += ok ? 0 : 1;
+        if (format == utils::RowFormat::JSONL) {
+            // Unreadable keys keep their "error" member
+            writer.line(report.dump());
+        } else if (ok) {
+            writer.row({report["file"].get_ref<const std::string&>(),
+                        report["algorithm"].get_ref<const std::string&>(),
+                        std::to_string(report["bits"].get<size_t>()),
+                        report["type"].get_ref<const std::string&>(),
+                        report["fingerprint"].get_ref<const std::string&>()});
+        } else {
+            writer.flush();
+            utils::Console::error(fmt::format("{}: {}", report["file"].get<std::string>(),
+                                              report["error"].get<std::string>()));
+        }
+    }
+    writer.flush();
+    
+    if (format != utils::RowFormat::JSONL) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        utils::Console::info(fmt::format("{} keys, {} unreadable ({:.2f}s, {} threads)",
+                                         reports.size(), failed, seconds, pool.size()));
+    }
+    return failed == 0 && expansion.missing.empty() ? 0 : 1;
+}
+
 } // namespace commands
 } // namespace cli
 } // namespace filevault
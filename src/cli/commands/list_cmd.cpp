@@ -126,6 +126,7 @@ int ListCommand::execute() {
         table.add_row({"ECC-P256", "256-bit", "Strong", "***", "ECDH + AES-GCM hybrid"});
         table.add_row({"ECC-P384", "384-bit", "Strong", "**", "192-bit security"});
         table.add_row({"ECC-P521", "521-bit", "Maximum", "**", "256-bit security"});
+        table.add_row({"ECC-X25519", "255-bit", "Strong", "****", "Fastest ECDH + AES-GCM hybrid"});
         
         print_table_safe(table);
     }
@@ -0,0 +1,122 @@
+#include "filevault/cli/commands/mount_cmd.hpp"
+#include "filevault/archive/archive_format.hpp"
+#include "filevault/archive/archive_mount.hpp"
+#include "filevault/utils/console.hpp"
+#include "filevault/utils/crypto_utils.hpp"
+#include "filevault/utils/password.hpp"
+#include <fmt/core.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+
+namespace filevault {
+namespace cli {
+
+void MountCommand::setup(CLI::App& app) {
+    auto* cmd = app.add_subcommand(name(), description());
+
+    cmd->add_option("input", input_file_, "Encrypted archive or streaming-format file")
+        ->required()
+        ->check(CLI::ExistingFile);
+    cmd->add_option("mountpoint", mountpoint_, "Empty directory")
+        ->required()
+        ->check(CLI::ExistingDirectory);
+    cmd->add_option("-p,--password", password_, "Decryption password");
+    cmd->add_option("--cache", cache_mb_, "Decrypted chunk cache in MB (default: 32 chunks)");
+    cmd->add_option("--readahead", readahead_, "Chunks decrypted ahead of sequential reads (0 = off)")
+        ->check(CLI::Range(0, 64));
+    cmd->add_flag("--allow-other", allow_other_, "Let other users see the mount");
+
+    cmd->footer(
+        "\nExamples:\n"
+        "  Browse an archive:    filevault mount photos.fva ~/mnt/photos\n"
+        "  One encrypted file:   filevault mount db-dump.sql.fvlt ~/mnt/dump\n"
+        "  Bigger cache:         filevault mount photos.fva ~/mnt/photos --cache 512\n"
+        "  Unmount:              fusermount3 -u ~/mnt/photos\n"
+        "\n"
+        "Nothing is extracted to disk: chunks are decrypted as files are read.\n"
+        "Needs a chunked file (archives, or encrypt --format v2) and a build\n"
+        "configured with -DENABLE_FUSE=ON.\n"
+    );
+
+    cmd->callback([this]() { run(); });
+}
+
+void MountCommand::run() {
+    int exit_code = execute();
+    if (exit_code != 0) {
+        throw CLI::RuntimeError(exit_code);
+    }
+}
+
+int MountCommand::execute() {
+    if (!archive::fuse_available()) {
+        utils::Console::error("This build has no FUSE support (configure with -DENABLE_FUSE=ON)");
+        utils::Console::info("Use 'filevault archive extract -m <name>' to pull out single files");
+        return 1;
+    }
+
+    if (password_.empty()) {
+        password_ = utils::Password::read_secure("Enter password: ", false);
+        if (password_.empty()) {
+            utils::Console::error("Password cannot be empty");
+            return 1;
+        }
+    }
+
+    // One key derivation either way: a stream that turns out not to be an
+    // archive stays open in the reader
+    archive::ArchiveReader reader;
+    auto opened = reader.open(input_file_, password_);
+    std::optional<archive::MountTree> tree;
+    if (opened.success) {
+        tree = archive::MountTree::from_archive(reader.entries(), reader.data_start());
+    } else if (reader.stream().is_open()) {
+        std::vector<uint8_t> magic;
+        auto head = reader.stream().read(0, sizeof(archive::ArchiveFormat::MAGIC) - 1, magic);
+        bool is_archive = head.success && magic.size() == sizeof(archive::ArchiveFormat::MAGIC) - 1 &&
+                          std::memcmp(magic.data(), archive::ArchiveFormat::MAGIC, magic.size()) == 0;
+        if (head.success && !is_archive) {
+            std::string name = std::filesystem::path(input_file_).filename().string();
+            name = name.size() > 5 && name.ends_with(".fvlt") ? name.substr(0, name.size() - 5) : name + ".decrypted";
+            archive::FileEntry file_info;
+            archive::ArchiveFormat::stat_entry(input_file_, file_info);
+            tree = archive::MountTree::single_file(name, reader.stream().size(), file_info.modified_time);
+        }
+    }
+    if (!tree) {
+        utils::Console::error(opened.error_message);
+        return 1;
+    }
+    if (tree->skipped() > 0) {
+        utils::Console::warning(fmt::format("{} entries left out (stored in the base archive or unusable names)",
+                                            tree->skipped()));
+    }
+
+    archive::MountOptions options;
+    size_t chunk_size = std::max<size_t>(1, reader.stream().chunk_size());
+    if (cache_mb_ > 0) {
+        options.cache_chunks = std::max<size_t>(1, cache_mb_ * 1024 * 1024 / chunk_size);
+    }
+    options.readahead_chunks = readahead_;
+    options.allow_other = allow_other_;
+
+    utils::Console::info(fmt::format("Serving {} files from {} on {} (cache {}); unmount with: fusermount3 -u {}",
+                                     tree->file_count(), input_file_, mountpoint_,
+                                     utils::CryptoUtils::format_bytes(options.cache_chunks * chunk_size),
+                                     mountpoint_));
+
+    core::StreamCacheStats stats;
+    auto mounted = archive::mount_read_only(*tree, reader.stream(), mountpoint_, options, &stats);
+    if (!mounted) {
+        utils::Console::error(mounted.error_message);
+        return 1;
+    }
+    utils::Console::success(fmt::format("Unmounted {} ({} chunks decrypted on demand, {} prefetched, {} cache hits)",
+                                        mountpoint_, stats.misses, stats.prefetched, stats.hits));
+    return 0;
+}
+
+} // namespace cli
+} // namespace filevault
@@ -0,0 +1,320 @@
+#include "filevault/cli/commands/password_audit_cmd.hpp"
+#include "filevault/core/thread_pool.hpp"
+#include "filevault/utils/config.hpp"
+#include "filevault/utils/console.hpp"
+#include "filevault/utils/crypto_utils.hpp"
+#include "filevault/utils/password.hpp"
+#include "filevault/utils/password_filter.hpp"
+#include <fmt/core.h>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <vector>
+
+namespace filevault {
+namespace cli {
+
+// Passwords held in memory at once; lookups of one batch run in parallel
+static constexpr size_t BATCH_LINES = 1 << 20;
+
+namespace {
+
+constexpr std::array<const char*, 5> STRENGTH_NAMES = {"very_weak", "weak", "fair", "strong", "very_strong"};
+
+void append_number(std::string& out, uint64_t value) {
+    char digits[24];
+    auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    out.append(digits, end);
+}
+
+// {"line":12,"score":35,"strength":"weak","entropy":41.4,"length":9,"classes":"ld","repeated":false,"common":true}
+void append_json_line(std::string& out, uint64_t line, const utils::PasswordScore& scored) {
+    out += "{\"line\":";
+    append_number(out, line);
+    out += ",\"score\":";
+    append_number(out, static_cast<uint64_t>(scored.score));
+    out += ",\"strength\":\"";
+    out += STRENGTH_NAMES[static_cast<size_t>(scored.strength)];
+    out += "\",\"entropy\":";
+    char entropy[32];
+    auto end = std::to_chars(entropy, entropy + sizeof(entropy), scored.entropy_bits,
+                             std::chars_format::fixed, 1).ptr;
+    out.append(entropy, end);
+    out += ",\"length\":";
+    append_number(out, scored.length);
+    out += ",\"classes\":\"";
+    if (scored.has_lowercase) out += 'l';
+    if (scored.has_uppercase) out += 'u';
+    if (scored.has_digits) out += 'd';
+    if (scored.has_special) out += 's';
+    out += scored.has_repeated_chars ? "\",\"repeated\":true" : "\",\"repeated\":false";
+    out += scored.is_common_password ? ",\"common\":true}\n" : ",\"common\":false}\n";
+}
+
+// Fills batch with up to BATCH_LINES lines; false once the input is exhausted
+bool read_batch(std::istream& in, std::vector<std::string>& batch) {
+    batch.clear();
+    std::string line;
+    while (batch.size() < BATCH_LINES) {
+        if (!std::getline(in, line)) {
+            return false;
+        }
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        batch.push_back(std::move(line));
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+void PasswordAuditCommand::setup(CLI::App& app) {
+    auto* audit_cmd = app.add_subcommand(name(), description());
+
+    auto* build_cmd = audit_cmd->add_subcommand("build", "Build a filter from a breached-password corpus");
+    build_cmd->add_option("corpus", input_file_, "One password or SHA-1[:count] per line")
+        ->required()
+        ->check(CLI::ExistingFile);
+    build_cmd->add_option("-o,--output", filter_file_, "Filter file (default: ~/.filevault/breached.bloom)");
+    build_cmd->add_option("--fp-rate", false_positive_rate_, "False positive rate")
+        ->check(CLI::Range(0.000001, 0.5));
+    build_cmd->callback([this]() {
+        subcommand_ = "build";
+        run();
+    });
+
+    auto* check_cmd = audit_cmd->add_subcommand("check", "Look passwords up in the filter");
+    check_cmd->add_option("input", input_file_, "One password per line (default: stdin)");
+    check_cmd->add_option("-f,--filter", filter_file_, "Filter file (default: ~/.filevault/breached.bloom)")
+        ->check(CLI::ExistingFile);
+    check_cmd->add_option("-T,--threads", threads_, "Lookup threads (0 = one per core)");
+    check_cmd->add_flag("--show", show_matches_, "Print matching passwords, not just line numbers");
+    check_cmd->callback([this]() {
+        subcommand_ = "check";
+        run();
+    });
+
+    auto* score_cmd = audit_cmd->add_subcommand("score", "Rate password strength, one JSON line each");
+    score_cmd->add_option("input", input_file_, "One password per line (default: stdin)");
+    score_cmd->add_option("-T,--threads", threads_, "Scoring threads (0 = one per core)");
+    score_cmd->add_option("--below", below_score_, "Report only passwords scoring under this (0-100)")
+        ->check(CLI::Range(1, 101));
+    score_cmd->callback([this]() {
+        subcommand_ = "score";
+        run();
+    });
+
+    audit_cmd->footer(
+        "\nExamples:\n"
+        "  Install a filter:      filevault password-audit build pwned-passwords-sha1.txt\n"
+        "  Audit a list:          filevault password-audit check candidates.txt\n"
+        "  From another tool:     export-passwords | filevault password-audit check\n"
+        "  Find weak ones:        filevault password-audit score candidates.txt --below 40\n"
+        "\n"
+        "The installed filter is also checked by the strength meter when\n"
+        "encrypting. Matches are probable: a small share of them (the\n"
+        "--fp-rate chosen at build time) are false positives.\n"
+    );
+
+    audit_cmd->require_subcommand(1);
+}
+
+void PasswordAuditCommand::run() {
+    int exit_code = execute();
+    if (exit_code != 0) {
+        throw CLI::RuntimeError(exit_code);
+    }
+}
+
+int PasswordAuditCommand::execute() {
+    if (filter_file_.empty()) {
+        filter_file_ = utils::Config::get_breach_filter_path().string();
+    }
+    if (subcommand_ == "build") {
+        return build();
+    } else if (subcommand_ == "check") {
+        return check();
+    } else if (subcommand_ == "score") {
+        return score();
+    }
+    return 1;
+}
+
+int PasswordAuditCommand::build() {
+    utils::Console::info(fmt::format("Building filter from {}", input_file_));
+    auto start = std::chrono::steady_clock::now();
+    auto built = utils::PasswordFilter::build(input_file_, filter_file_, false_positive_rate_);
+    if (!built) {
+        utils::Console::error(built.error_message);
+        return 1;
+    }
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    auto filter = utils::PasswordFilter::open(filter_file_);
+    if (!filter) {
+        utils::Console::error(filter.error_message);
+        return 1;
+    }
+    utils::Console::success(fmt::format("{} entries in {} ({}, {} probes) in {:.1f}s",
+                                        built.value, filter_file_,
+                                        utils::CryptoUtils::format_bytes(filter.value.size_bytes()),
+                                        filter.value.hash_count(), seconds));
+    return 0;
+}
+
+int PasswordAuditCommand::check() {
+    auto opened = utils::PasswordFilter::open(filter_file_);
+    if (!opened) {
+        utils::Console::error(opened.error_message);
+        utils::Console::info("Build one with: filevault password-audit build <corpus>");
+        return 1;
+    }
+    const auto& filter = opened.value;
+
+    std::ifstream file;
+    if (input_file_ != "-") {
+        file.open(input_file_, std::ios::binary);
+        if (!file) {
+            utils::Console::error("Cannot open " + input_file_);
+            return 1;
+        }
+    }
+    std::istream& in = input_file_ == "-" ? std::cin : file;
+
+    if (threads_ == 0) {
+        threads_ = utils::Config::current().get_threads();
+    }
+    core::ThreadPool pool(threads_);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> batch;
+    uint64_t first_line = 1;
+    uint64_t checked = 0;
+    uint64_t matches = 0;
+    bool more = true;
+
+    while (more) {
+        more = read_batch(in, batch);
+        if (batch.empty()) {
+            break;
+        }
+
+        size_t workers = std::min(pool.size(), batch.size());
+        size_t per_worker = (batch.size() + workers - 1) / workers;
+        std::vector<std::future<std::vector<size_t>>> hits;
+        for (size_t begin = 0; begin < batch.size(); begin += per_worker) {
+            size_t end = std::min(batch.size(), begin + per_worker);
+            hits.push_back(pool.submit([&batch, &filter, begin, end] {
+                std::vector<size_t> found;
+                for (size_t i = begin; i < end; ++i) {
+                    if (!batch[i].empty() && filter.contains(batch[i])) {
+                        found.push_back(i);
+                    }
+                }
+                return found;
+            }));
+        }
+
+        for (auto& part : hits) {
+            for (size_t i : part.get()) {
+                if (show_matches_) {
+                    fmt::print("line {}: {}\n", first_line + i, batch[i]);
+                } else {
+                    fmt::print("line {}\n", first_line + i);
+                }
+                ++matches;
+            }
+        }
+        checked += std::count_if(batch.begin(), batch.end(), [](const std::string& p) { return !p.empty(); });
+        first_line += batch.size();
+    }
+
+    if (in.bad()) {
+        utils::Console::error("Error reading " + (input_file_ == "-" ? std::string("stdin") : input_file_));
+        return 1;
+    }
+
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::string summary = fmt::format("{} of {} passwords found in the breach filter ({:.0f} checks/s, {} threads)",
+                                      matches, checked, seconds > 0 ? checked / seconds : 0.0, pool.size());
+    if (matches > 0) {
+        utils::Console::warning(summary);
+    } else {
+        utils::Console::success(summary);
+    }
+    return 0;
+}
+
+int PasswordAuditCommand::score() {
+    // stdout carries the JSON lines
+    utils::Console::set_stream(stderr);
+
+    std::ifstream file;
+    if (input_file_ != "-") {
+        file.open(input_file_, std::ios::binary);
+        if (!file) {
+            utils::Console::error("Cannot open " + input_file_);
+            return 1;
+        }
+    }
+    std::istream& in = input_file_ == "-" ? std::cin : file;
+
+    if (threads_ == 0) {
+        threads_ = utils::Config::current().get_threads();
+    }
+    core::ThreadPool pool(threads_);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> batch;
+    std::vector<utils::PasswordScore> results;
+    std::string out;
+    std::array<uint64_t, STRENGTH_NAMES.size()> by_strength{};
+    uint64_t first_line = 1;
+    uint64_t scored = 0;
+    bool more = true;
+
+    while (more) {
+        more = read_batch(in, batch);
+        if (batch.empty()) {
+            break;
+        }
+        results.resize(batch.size());
+        utils::Password::score_batch(batch, results, pool);
+
+        out.clear();
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (batch[i].empty()) {
+                continue;
+            }
+            ++scored;
+            ++by_strength[static_cast<size_t>(results[i].strength)];
+            if (results[i].score < below_score_) {
+                append_json_line(out, first_line + i, results[i]);
+            }
+        }
+        std::fwrite(out.data(), 1, out.size(), stdout);
+        first_line += batch.size();
+    }
+    std::fflush(stdout);
+
+    if (in.bad()) {
+        utils::Console::error("Error reading " + (input_file_ == "-" ? std::string("stdin") : input_file_));
+        return 1;
+    }
+
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    utils::Console::success(fmt::format(
+        "Scored {} passwords ({:.0f}/s, {} threads): {} very weak, {} weak, {} fair, {} strong, {} very strong",
+        scored, seconds > 0 ? scored / seconds : 0.0, pool.size(),
+        by_strength[0], by_strength[1], by_strength[2], by_strength[3], by_strength[4]));
+    return 0;
+}
+
+} // namespace cli
+} // namespace filevault
@@ -0,0 +1,152 @@
+#include "filevault/cli/commands/rekey_cmd.hpp"
+#include "filevault/archive/directory_walker.hpp"
+#include "filevault/core/streaming.hpp"
+#include "filevault/core/tree_runner.hpp"
+#include "filevault/utils/console.hpp"
+#include "filevault/utils/crypto_utils.hpp"
+#include "filevault/utils/file_io.hpp"
+#include "filevault/utils/password.hpp"
+#include <filesystem>
+
+namespace filevault {
+namespace cli {
+namespace commands {
+
+RekeyCommand::RekeyCommand(core::CryptoEngine& engine)
+    : engine_(engine) {}
+
+void RekeyCommand::setup(CLI::App& app) {
+    auto* cmd = app.add_subcommand(name_, description_);
+
+    cmd->add_option("files", files_, "Encrypted files (directories with -r)")->required();
+
+    cmd->add_flag("-r,--recursive", recursive_, "Rekey every .fvlt file under the given directories");
+
+    cmd->add_option("-p,--password", password_, "Current password (not recommended)");
+
+    cmd->add_option("--new-password", new_password_, "New password (not recommended)");
+
+    cmd->add_option("-k,--kdf", kdf_, "Key derivation function for the new password (default: keep)")
+        ->check(CLI::IsMember({"argon2id", "argon2i", "pbkdf2-sha256", "pbkdf2-sha512", "scrypt"}));
+
+    cmd->add_option("-s,--security", security_level_, "Security level for the new password (default: keep)")
+        ->check(CLI::IsMember({"weak", "medium", "strong", "paranoid"}));
+
+    cmd->add_option("-T,--threads", threads_, "Files rekeyed in parallel (0 = one per core)");
+
+    cmd->footer(
+        "\nExamples:\n"
+        "  Change a password:     filevault rekey secret.pdf.fvlt\n"
+        "  Whole tree:            filevault rekey -r backups/\n"
+        "  Stronger KDF too:      filevault rekey file.fvlt -k argon2id -s strong\n"
+        "\n"
+        "Only the header is rewritten; the data and its file key stay the same.\n"
+        "Files written before key wrapping (and FVAULT01 files) must be decrypted\n"
+        "and encrypted again once.\n"
+    );
+
+    cmd->callback([this]() {
+        int exit_code = this->execute();
+        if (exit_code != 0) {
+            throw CLI::RuntimeError(exit_code);
+        }
+    });
+}
+
+int RekeyCommand::execute() {
+    namespace fs = std::filesystem;
+    
+    try {
+        core::RekeyOptions rekey_options;
+        if (!kdf_.empty()) {
+            rekey_options.kdf = engine_.parse_kdf(kdf_);
+        }
+        if (!security_level_.empty()) {
+            rekey_options.level = engine_.parse_security_level(security_level_);
+        }
+        
+        // Headers are rewritten in place: no targets, nothing created
+        std::vector<core::TreeFile> files;
+        if (recursive_) {
+            archive::WalkOptions walk_options;
+            walk_options.include = {"*.fvlt"};
+            std::vector<fs::path> roots(files_.begin(), files_.end());
+            auto walk = archive::DirectoryWalker::walk(roots, walk_options);
+            for (const auto& error : walk.errors) {
+                utils::Console::warning("Skipped " + error);
+            }
+            for (const auto& member : walk.members) {
+                files.push_back({member.source, {}, member.entry.file_size});
+            }
+        } else {
+            for (const auto& file : files_) {
+                if (fs::is_directory(file)) {
+                    utils::Console::error(file + " is a directory (use --recursive)");
+                    return 1;
+                }
+                files.push_back({fs::path(file), {}, utils::FileIO::file_size(file)});
+            }
+        }
+        if (files.empty()) {
+            utils::Console::error("No .fvlt files to rekey");
+            return 1;
+        }
+        
+        if (password_.empty()) {
+            password_ = utils::Password::read_secure("Enter current password: ", false);
+        } else {
+            utils::Console::warning("Using password from command line is insecure!");
+        }
+        if (new_password_.empty()) {
+            new_password_ = utils::Password::read_secure("Enter new password: ", true);
+        } else {
+            utils::Console::warning("Using password from command line is insecure!");
+        }
+        if (password_.empty() || new_password_.empty()) {
+            utils::Console::error("Password cannot be empty");
+            return 1;
+        }
+        
+        // One salt for the tree: files that shared a password and salt
+        // share one derivation of each password through the key cache
+        // (batch files keep keys of their own under it)
+        rekey_options.salt = core::CryptoEngine::generate_salt(core::CryptoEngine::BATCH_SALT_SIZE);
+        
+        core::TreeRunOptions options;
+        options.workers = threads_;
+        
+        utils::Console::info(fmt::format("Rekeying {} files", files.size()));
+        auto result = core::TreeRunner::run(files, [&](const core::TreeFile& file, size_t,
+                                                       const core::TreeRunner::Advance& advance) {
+            auto rekeyed = core::StreamingCrypto::rekey_file(file.source.string(), password_,
+                                                             new_password_, rekey_options);
+            if (!rekeyed.success) {
+                return rekeyed.error_message;
+            }
+            advance(file.size);
+            return std::string();
+        }, options);
+        
+        for (const auto& error : result.errors) {
+            utils::Console::error(error);
+        }
+        utils::Console::info(fmt::format("Rekeyed {} of {} files ({}) in {:.2f} s, payloads untouched",
+                                         result.succeeded, files.size(),
+                                         utils::CryptoUtils::format_bytes(result.bytes), result.seconds));
+        if (!result.errors.empty()) {
+            utils::Console::error(fmt::format("{} files failed; they keep the old password",
+                                              result.errors.size()));
+            return 1;
+        }
+        utils::Console::success("Password changed");
+        return 0;
+        
+    } catch (const std::exception& e) {
+        utils::Console::error(fmt::format("Rekey failed: {}", e.what()));
+        return 1;
+    }
+}
+
+} // namespace commands
+} // namespace cli
+} // namespace filevault
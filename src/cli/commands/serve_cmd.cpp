@@ -0,0 +1,870 @@
+#include "filevault/cli/commands/serve_cmd.hpp"
+#include "filevault/core/buffer_pool.hpp"
+#include "filevault/core/executor.hpp"
+#include "filevault/core/key_cache.hpp"
+#include "filevault/utils/console.hpp"
+#include "filevault/utils/json_rpc.hpp"
+#include "filevault/utils/metrics.hpp"
+#include "filevault/utils/progress.hpp"
+#include "filevault/utils/run_stats.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+
+#ifdef _WIN32
+    #include <fcntl.h>
+    #include <io.h>
+    #include <process.h>
+    #define FV_DUP _dup
+    #define FV_DUP2 _dup2
+    #define FV_CLOSE _close
+    #define FV_FILENO _fileno
+    #define FV_GETPID _getpid
+    #define FV_NULL_DEVICE "NUL"
+#else
+    #include <arpa/inet.h>
+    #include <csignal>
+    #include <fcntl.h>
+    #include <netinet/in.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+    #define FV_DUP dup
+    #define FV_DUP2 dup2
+    #define FV_CLOSE close
+    #define FV_FILENO fileno
+    #define FV_GETPID getpid
+    #define FV_NULL_DEVICE "/dev/null"
+#endif
+
+namespace filevault {
+namespace cli {
+
+using utils::JsonRpcDispatcher;
+using utils::RpcError;
+
+namespace {
+
+// Longest request line accepted; run arguments are a few hundred bytes
+constexpr size_t MAX_REQUEST_SIZE = 1 << 20;
+
+/**
+ * @brief Newline-delimited messages over a file descriptor or socket
+ *
+ * Writes are serialized, since progress notifications can come from
+ * worker threads while a response is being written.
+ */
+class LineChannel {
+public:
+    explicit LineChannel(int fd) : fd_(fd) {}
+
+    /**
+     * @brief Next line without the line ending
+     * @return false at end of input, on error, or for an oversized line
+     */
+    bool read_line(std::string& line) {
+        while (true) {
+            auto newline = buffer_.find('\n');
+            if (newline != std::string::npos) {
+                line.assign(buffer_, 0, newline);
+                buffer_.erase(0, newline + 1);
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                return true;
+            }
+            if (buffer_.size() > MAX_REQUEST_SIZE) {
+                return false;
+            }
+
+            char chunk[4096];
+            auto n = raw_read(chunk, sizeof(chunk));
+            if (n <= 0) {
+                return false;
+            }
+            buffer_.append(chunk, static_cast<size_t>(n));
+        }
+    }
+
+    bool write_line(const std::string& line) {
+        std::string message = line + "\n";
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        size_t written = 0;
+        while (written < message.size()) {
+            auto n = raw_write(message.data() + written, message.size() - written);
+            if (n <= 0) {
+                return false;
+            }
+            written += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+private:
+#ifdef _WIN32
+    long raw_read(char* data, size_t size) { return _read(fd_, data, static_cast<unsigned>(size)); }
+    long raw_write(const char* data, size_t size) { return _write(fd_, data, static_cast<unsigned>(size)); }
+#else
+    long raw_read(char* data, size_t size) { return ::read(fd_, data, size); }
+    long raw_write(const char* data, size_t size) { return ::write(fd_, data, size); }
+#endif
+
+    int fd_;
+    std::string buffer_;
+    std::mutex write_mutex_;
+};
+
+/**
+ * @brief Send fds 1 and 2 to temporary files for the lifetime of a run
+ *
+ * Commands print through Console, fmt, printf and iostreams; redirecting
+ * the descriptors catches all of them. Process-wide, so runs must not
+ * overlap.
+ */
+class OutputCapture {
+public:
+    OutputCapture() {
+        flush_all();
+        out_ = redirect(1, saved_out_);
+        err_ = redirect(2, saved_err_);
+    }
+
+    ~OutputCapture() {
+        restore();
+    }
+
+    OutputCapture(const OutputCapture&) = delete;
+    OutputCapture& operator=(const OutputCapture&) = delete;
+
+    /**
+     * @brief Restore the descriptors and return (stdout, stderr)
+     */
+    std::pair<std::string, std::string> finish() {
+        flush_all();
+        std::string out = contents(out_);
+        std::string err = contents(err_);
+        restore();
+        return {std::move(out), std::move(err)};
+    }
+
+private:
+    static void flush_all() {
+        std::cout.flush();
+        std::cerr.flush();
+        std::fflush(stdout);
+        std::fflush(stderr);
+    }
+
+    static std::FILE* redirect(int fd, int& saved) {
+        std::FILE* file = std::tmpfile();
+        if (!file) {
+            saved = -1;
+            return nullptr;
+        }
+        saved = FV_DUP(fd);
+        FV_DUP2(FV_FILENO(file), fd);
+        return file;
+    }
+
+    static std::string contents(std::FILE* file) {
+        std::string text;
+        if (!file) {
+            return text;
+        }
+        std::rewind(file);
+        char chunk[4096];
+        size_t n;
+        while ((n = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+            text.append(chunk, n);
+        }
+        return text;
+    }
+
+    void restore() {
+        if (restored_) {
+            return;
+        }
+        restored_ = true;
+        flush_all();
+        for (auto [file, saved, fd] : {std::tuple{out_, saved_out_, 1}, std::tuple{err_, saved_err_, 2}}) {
+            if (saved >= 0) {
+                FV_DUP2(saved, fd);
+                FV_CLOSE(saved);
+            }
+            if (file) {
+                std::fclose(file);
+            }
+        }
+    }
+
+    std::FILE* out_ = nullptr;
+    std::FILE* err_ = nullptr;
+    int saved_out_ = -1;
+    int saved_err_ = -1;
+    bool restored_ = false;
+};
+
+struct ServeState {
+    JsonRpcDispatcher dispatcher;
+    std::mutex run_mutex;   // Output capture and the progress observer are process-wide
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> requests{0};
+    std::atomic<int> runs_waiting{0};       // Queued behind run_mutex
+    std::atomic<bool> run_active{false};
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+};
+
+/**
+ * @brief Size class label of a run: the first of 64KiB, 1MiB, ... 4GiB that holds its input
+ */
+const char* size_class(uint64_t bytes) {
+    static const std::pair<uint64_t, const char*> classes[] = {
+        {uint64_t(64) << 10, "64KiB"},
+        {uint64_t(1) << 20, "1MiB"},
+        {uint64_t(16) << 20, "16MiB"},
+        {uint64_t(256) << 20, "256MiB"},
+        {uint64_t(4) << 30, "4GiB"},
+    };
+    for (auto [limit, name] : classes) {
+        if (bytes <= limit) {
+            return name;
+        }
+    }
+    return "inf";
+}
+
+/**
+ * @brief Command name as a label; anything that is not one becomes "other"
+ *
+ * args[0] comes from the client, and every distinct label value is a
+ * series for the life of the daemon.
+ */
+std::string command_label(const std::string& command) {
+    bool plain = !command.empty() && command.size() <= 24 &&
+                 std::all_of(command.begin(), command.end(), [](char c) { return (c >= 'a' && c <= 'z') || c == '-'; });
+    return plain ? command : "other";
+}
+
+void describe_metrics() {
+    auto& metrics = utils::Metrics::instance();
+    metrics.describe("filevault_run_duration_seconds",
+                     "Duration of runs by command, cipher and input size class", 1e-6);
+    metrics.describe("filevault_runs_total", "Runs by command and outcome");
+    metrics.describe("filevault_run_bytes_read_total", "Input bytes processed by runs");
+    metrics.describe("filevault_run_bytes_written_total", "Output bytes produced by runs");
+}
+
+void record_run(const std::string& command, const std::string& algorithm, int exit_code,
+                std::chrono::steady_clock::duration duration, uint64_t bytes_in, uint64_t bytes_out) {
+    auto& metrics = utils::Metrics::instance();
+    std::string label = command_label(command);
+    std::string cipher = algorithm.empty() ? "none" : algorithm;
+
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    metrics.observe(metrics.histogram("filevault_run_duration_seconds",
+                                      {{"command", label}, {"algorithm", cipher}, {"size", size_class(bytes_in)}}),
+                    static_cast<uint64_t>(std::max<int64_t>(micros, 0)));
+    metrics.add(metrics.counter("filevault_runs_total",
+                                {{"command", label}, {"status", exit_code == 0 ? "ok" : "error"}}));
+    metrics.add(metrics.counter("filevault_run_bytes_read_total", {{"command", label}, {"algorithm", cipher}}),
+                bytes_in);
+    metrics.add(metrics.counter("filevault_run_bytes_written_total", {{"command", label}, {"algorithm", cipher}}),
+                bytes_out);
+}
+
+/**
+ * @brief Values read when metrics are requested rather than recorded
+ */
+struct Gauges {
+    double uptime_seconds;
+    uint64_t requests;
+    int runs_waiting;
+    bool run_active;
+    size_t workers;
+    size_t queued_tasks;
+    double busy_seconds;
+    core::KeyCacheStats key_cache;
+    size_t key_cache_entries;
+    size_t pool_bytes;
+    size_t pool_limit;
+};
+
+Gauges read_gauges(const ServeState& state) {
+    auto& executor = core::Executor::shared();
+    auto& pool = core::BufferPool::shared();
+    auto& key_cache = core::KeyCache::instance();
+    return {
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - state.started).count(),
+        state.requests.load(),
+        state.runs_waiting.load(),
+        state.run_active.load(),
+        executor.size(),
+        executor.pending(),
+        static_cast<double>(executor.busy_ns()) / 1e9,
+        key_cache.stats(),
+        key_cache.size(),
+        pool.cached_bytes(),
+        pool.max_cached_bytes()
+    };
+}
+
+std::string prometheus_text(const ServeState& state) {
+    auto gauges = read_gauges(state);
+    std::string out;
+    utils::Metrics::instance().write_prometheus(out);
+    using utils::Metrics;
+    Metrics::write_sample(out, "filevault_uptime_seconds", "Time since the daemon started", "gauge",
+                          gauges.uptime_seconds);
+    Metrics::write_sample(out, "filevault_requests_total", "JSON-RPC requests received", "counter",
+                          static_cast<double>(gauges.requests));
+    Metrics::write_sample(out, "filevault_run_queue_depth", "Runs waiting for the one in progress", "gauge",
+                          gauges.runs_waiting);
+    Metrics::write_sample(out, "filevault_runs_in_progress", "Runs executing (at most 1)", "gauge",
+                          gauges.run_active ? 1 : 0);
+    Metrics::write_sample(out, "filevault_executor_workers", "Worker threads of the shared executor", "gauge",
+                          static_cast<double>(gauges.workers));
+    Metrics::write_sample(out, "filevault_executor_queued_tasks", "Executor tasks waiting for a worker", "gauge",
+                          static_cast<double>(gauges.queued_tasks));
+    Metrics::write_sample(out, "filevault_executor_busy_seconds_total",
+                          "Worker time spent running tasks; rate() / workers is utilization", "counter",
+                          gauges.busy_seconds);
+    Metrics::write_sample(out, "filevault_key_cache_hits_total", "Key derivations served from the cache",
+                          "counter", static_cast<double>(gauges.key_cache.hits));
+    Metrics::write_sample(out, "filevault_key_cache_misses_total", "Key derivations that ran the KDF",
+                          "counter", static_cast<double>(gauges.key_cache.misses));
+    Metrics::write_sample(out, "filevault_key_cache_entries", "Derived keys held", "gauge",
+                          static_cast<double>(gauges.key_cache_entries));
+    Metrics::write_sample(out, "filevault_buffer_pool_cached_bytes", "Bytes of idle buffers kept for reuse",
+                          "gauge", static_cast<double>(gauges.pool_bytes));
+    Metrics::write_sample(out, "filevault_buffer_pool_limit_bytes", "Most bytes the buffer pool keeps", "gauge",
+                          static_cast<double>(gauges.pool_limit));
+    return out;
+}
+
+nlohmann::json metrics_json(const ServeState& state) {
+    auto gauges = read_gauges(state);
+    auto& metrics = utils::Metrics::instance();
+    auto labels_json = [](const utils::MetricLabels& labels) {
+        nlohmann::json object = nlohmann::json::object();
+        for (const auto& [name, value] : labels) {
+            object[name] = value;
+        }
+        return object;
+    };
+
+    nlohmann::json histograms = nlohmann::json::array();
+    for (const auto& value : metrics.histograms()) {
+        const auto& snapshot = value.snapshot;
+        auto scaled = [&value](uint64_t recorded) { return static_cast<double>(recorded) * value.scale; };
+        histograms.push_back({
+            {"name", value.name},
+            {"labels", labels_json(value.labels)},
+            {"count", snapshot.count},
+            {"sum", scaled(snapshot.sum)},
+            {"p50", scaled(snapshot.quantile(0.5))},
+            {"p99", scaled(snapshot.quantile(0.99))},
+            {"p999", scaled(snapshot.quantile(0.999))},
+            {"max", scaled(snapshot.max)}
+        });
+    }
+    nlohmann::json counters = nlohmann::json::array();
+    for (const auto& value : metrics.counters()) {
+        counters.push_back({{"name", value.name}, {"labels", labels_json(value.labels)}, {"value", value.value}});
+    }
+
+    uint64_t lookups = gauges.key_cache.hits + gauges.key_cache.misses;
+    double worker_seconds = gauges.uptime_seconds * static_cast<double>(gauges.workers);
+    return {
+        {"uptime_ms", gauges.uptime_seconds * 1000.0},
+        {"requests", gauges.requests},
+        {"runs", {{"waiting", gauges.runs_waiting}, {"active", gauges.run_active}}},
+        {"executor", {
+            {"workers", gauges.workers},
+            {"queued_tasks", gauges.queued_tasks},
+            {"busy_seconds", gauges.busy_seconds},
+            {"utilization", worker_seconds > 0 ? gauges.busy_seconds / worker_seconds : 0.0}
+        }},
+        {"key_cache", {
+            {"entries", gauges.key_cache_entries},
+            {"hits", gauges.key_cache.hits},
+            {"misses", gauges.key_cache.misses},
+            {"hit_rate", lookups > 0 ? static_cast<double>(gauges.key_cache.hits) / lookups : 0.0}
+        }},
+        {"buffer_pool", {
+            {"cached_bytes", gauges.pool_bytes},
+            {"limit_bytes", gauges.pool_limit},
+            {"occupancy", gauges.pool_limit > 0 ? static_cast<double>(gauges.pool_bytes) / gauges.pool_limit : 0.0}
+        }},
+        {"histograms", std::move(histograms)},
+        {"counters", std::move(counters)}
+    };
+}
+
+void add_methods(ServeState& state, const ServeCommand::Runner& runner) {
+    describe_metrics();
+
+    state.dispatcher.add("ping", [&state](const nlohmann::json&, const JsonRpcDispatcher::Notify&) {
+        auto uptime = std::chrono::steady_clock::now() - state.started;
+        return nlohmann::json{
+            {"pid", static_cast<int>(FV_GETPID())},
+            {"uptime_ms", std::chrono::duration_cast<std::chrono::milliseconds>(uptime).count()},
+            {"requests", state.requests.load()},
+            {"key_cache_entries", core::KeyCache::instance().size()}
+        };
+    });
+
+    state.dispatcher.add("run", [&state, &runner](const nlohmann::json& params,
+                                                   const JsonRpcDispatcher::Notify& notify) {
+        if (!params.is_object() || !params.contains("args") || !params["args"].is_array()) {
+            throw RpcError(JsonRpcDispatcher::INVALID_PARAMS, "run expects {\"args\": [\"command\", ...]}");
+        }
+        auto args = params["args"].get<std::vector<std::string>>();
+        if (args.empty()) {
+            throw RpcError(JsonRpcDispatcher::INVALID_PARAMS, "args is empty");
+        }
+        if (args[0] == "serve") {
+            throw RpcError(JsonRpcDispatcher::INVALID_PARAMS, "serve cannot run inside serve");
+        }
+
+        state.runs_waiting++;
+        std::lock_guard<std::mutex> lock(state.run_mutex);
+        state.runs_waiting--;
+        state.run_active = true;
+        auto& run_stats = utils::RunStats::instance();
+        uint64_t bytes_in = run_stats.bytes_in();
+        uint64_t bytes_out = run_stats.bytes_out();
+        run_stats.set_algorithm({});
+
+        utils::ProgressBar::set_observer([&notify](const std::string& label, size_t progress, size_t total) {
+            notify("progress", {{"label", label}, {"progress", progress}, {"total", total}});
+        });
+
+        auto start = std::chrono::steady_clock::now();
+        int exit_code;
+        std::pair<std::string, std::string> output;
+        {
+            OutputCapture capture;
+            exit_code = runner(args);
+            output = capture.finish();
+        }
+        auto duration = std::chrono::steady_clock::now() - start;
+        double duration_ms = std::chrono::duration<double, std::milli>(duration).count();
+        record_run(args[0], run_stats.algorithm(), exit_code, duration,
+                   run_stats.bytes_in() - bytes_in, run_stats.bytes_out() - bytes_out);
+        state.run_active = false;
+
+        // Pipe-mode commands move console output to stderr; undo for the next run
+        utils::ProgressBar::set_observer(nullptr);
+        utils::Console::set_stream(nullptr);
+
+        return nlohmann::json{
+            {"exit_code", exit_code},
+            {"stdout", std::move(output.first)},
+            {"stderr", std::move(output.second)},
+            {"duration_ms", duration_ms}
+        };
+    });
+
+    state.dispatcher.add("metrics", [&state](const nlohmann::json& params, const JsonRpcDispatcher::Notify&) {
+        std::string format = params.is_object() ? params.value("format", std::string("json")) : "json";
+        if (format == "prometheus") {
+            return nlohmann::json{{"text", prometheus_text(state)}};
+        }
+        if (format != "json") {
+            throw RpcError(JsonRpcDispatcher::INVALID_PARAMS, "format must be \"json\" or \"prometheus\"");
+        }
+        return metrics_json(state);
+    });
+
+    state.dispatcher.add("shutdown", [&state](const nlohmann::json&, const JsonRpcDispatcher::Notify&) {
+        state.stopping = true;
+        return nlohmann::json(true);
+    });
+}
+
+/**
+ * @brief Answer requests until end of input or shutdown
+ * @param output May be the same channel as input (sockets)
+ */
+void serve_channel(LineChannel& input, LineChannel& output, ServeState& state) {
+    JsonRpcDispatcher::Notify notify = [&output](const std::string& method, const nlohmann::json& params) {
+        output.write_line(JsonRpcDispatcher::notification(method, params));
+    };
+
+    std::string line;
+    while (!state.stopping && input.read_line(line)) {
+        if (line.empty()) {
+            continue;
+        }
+        state.requests++;
+        std::string response = state.dispatcher.handle(line, notify);
+        if (!response.empty() && !output.write_line(response)) {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Point a standard descriptor at another one or the null device
+ */
+void replace_fd(int fd, int with) {
+    if (with >= 0) {
+        FV_DUP2(with, fd);
+        return;
+    }
+#ifdef _WIN32
+    int null_fd = _open(FV_NULL_DEVICE, _O_RDWR);
+#else
+    int null_fd = open(FV_NULL_DEVICE, O_RDWR);
+#endif
+    if (null_fd >= 0) {
+        FV_DUP2(null_fd, fd);
+        FV_CLOSE(null_fd);
+    }
+}
+
+/**
+ * @brief Answers GET /metrics over HTTP on 127.0.0.1 for Prometheus
+ *
+ * One connection at a time on its own thread: a scraper asks every few
+ * seconds and the response is built in well under a millisecond.
+ */
+class MetricsEndpoint {
+public:
+    MetricsEndpoint() = default;
+    ~MetricsEndpoint() { stop(); }
+
+    MetricsEndpoint(const MetricsEndpoint&) = delete;
+    MetricsEndpoint& operator=(const MetricsEndpoint&) = delete;
+
+    bool start(int port, std::function<std::string()> render) {
+#ifdef _WIN32
+        (void)port;
+        (void)render;
+        return false;
+#else
+        fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd_ < 0) {
+            return false;
+        }
+        int reuse = 1;
+        setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd_, 8) != 0) {
+            close(fd_);
+            fd_ = -1;
+            return false;
+        }
+        // A scraper that hangs up mid-response must not kill the daemon
+        std::signal(SIGPIPE, SIG_IGN);
+        render_ = std::move(render);
+        thread_ = std::thread([this] { accept_loop(); });
+        return true;
+#endif
+    }
+
+    void stop() {
+        stopping_ = true;
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        if (fd_ >= 0) {
+            FV_CLOSE(fd_);
+            fd_ = -1;
+        }
+    }
+
+private:
+#ifndef _WIN32
+    void accept_loop() {
+        while (!stopping_) {
+            pollfd pfd{fd_, POLLIN, 0};
+            if (poll(&pfd, 1, 200) <= 0) {
+                continue;
+            }
+            int client = accept(fd_, nullptr, nullptr);
+            if (client >= 0) {
+                answer(client);
+                close(client);
+            }
+        }
+    }
+
+    void answer(int client) {
+        // Only the request line matters; headers are read and ignored
+        std::string request;
+        char chunk[1024];
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+            pollfd pfd{client, POLLIN, 0};
+            if (poll(&pfd, 1, 1000) <= 0) {
+                return;
+            }
+            auto n = ::read(client, chunk, sizeof(chunk));
+            if (n <= 0) {
+                return;
+            }
+            request.append(chunk, static_cast<size_t>(n));
+        }
+
+        bool found = request.rfind("GET /metrics ", 0) == 0 || request.rfind("GET /metrics?", 0) == 0;
+        std::string body = found ? render_() : "Not found\n";
+        std::string response = std::string("HTTP/1.1 ") + (found ? "200 OK" : "404 Not Found") + "\r\n"
+            "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+            "Content-Length: " + std::to_string(body.size()) + "\r\n"
+            "Connection: close\r\n\r\n" + body;
+
+        size_t written = 0;
+        while (written < response.size()) {
+            auto n = ::write(client, response.data() + written, response.size() - written);
+            if (n <= 0) {
+                return;
+            }
+            written += static_cast<size_t>(n);
+        }
+    }
+#endif
+
+    int fd_ = -1;
+    std::atomic<bool> stopping_{false};
+    std::function<std::string()> render_;
+    std::thread thread_;
+};
+
+/**
+ * @brief Start the endpoint when --metrics-port was given
+ */
+bool start_metrics_endpoint(MetricsEndpoint& endpoint, int port, const ServeState& state) {
+    if (port == 0) {
+        return true;
+    }
+#ifdef _WIN32
+    utils::Console::error("--metrics-port is not available on Windows; use the metrics method");
+    return false;
+#else
+    if (!endpoint.start(port, [&state] { return prometheus_text(state); })) {
+        utils::Console::error("Failed to listen on 127.0.0.1:" + std::to_string(port));
+        return false;
+    }
+    spdlog::info("Serving metrics on http://127.0.0.1:{}/metrics", port);
+    return true;
+#endif
+}
+
+#ifndef _WIN32
+std::string default_socket_path() {
+    if (const char* runtime_dir = std::getenv("XDG_RUNTIME_DIR"); runtime_dir && *runtime_dir) {
+        return (std::filesystem::path(runtime_dir) / "filevault.sock").string();
+    }
+    return "/tmp/filevault-" + std::to_string(getuid()) + ".sock";
+}
+#endif
+
+} // anonymous namespace
+
+ServeCommand::ServeCommand(core::CryptoEngine& engine, Runner runner)
+    : engine_(engine), runner_(std::move(runner)) {
+}
+
+void ServeCommand::setup(CLI::App& app) {
+    auto* cmd = app.add_subcommand(name(), description());
+
+    cmd->add_flag("--stdio", stdio_, "Read requests from stdin and answer on stdout");
+    cmd->add_option("--socket", socket_path_,
+                    "Unix socket to listen on (default: $XDG_RUNTIME_DIR/filevault.sock)");
+    cmd->add_option("--metrics-port", metrics_port_,
+                    "Also answer GET /metrics (Prometheus text) on 127.0.0.1:PORT")
+        ->check(CLI::Range(1, 65535));
+
+    cmd->footer(
+        "\nProtocol: one JSON-RPC 2.0 message per line.\n"
+        "  {\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"run\",\"params\":{\"args\":[\"hash\",\"file.txt\"]}}\n"
+        "Methods: ping, run, metrics, shutdown. Runs are executed one at a time; progress\n"
+        "bars arrive as \"progress\" notifications. Passwords must be passed in the\n"
+        "arguments, and '-' (stdin/stdout) is not available to runs.\n"
+        "\nExamples:\n"
+        "  Child of a frontend:   filevault serve --stdio\n"
+        "  Shared daemon:         filevault serve --socket /run/user/1000/filevault.sock\n"
+        "  With Prometheus:       filevault serve --socket /run/user/1000/filevault.sock --metrics-port 9464\n"
+    );
+
+    cmd->callback([this]() {
+        int exit_code = execute();
+        if (exit_code != 0) {
+            throw CLI::RuntimeError(exit_code);
+        }
+    });
+}
+
+int ServeCommand::execute() {
+    // Construct the default ciphers now rather than on the first request
+    engine_.get_algorithm(core::AlgorithmType::AES_256_GCM);
+    engine_.get_algorithm(core::AlgorithmType::CHACHA20_POLY1305);
+
+    return stdio_ ? serve_stdio() : serve_socket();
+}
+
+int ServeCommand::serve_stdio() {
+    // Keep the protocol on private copies of stdin/stdout. Stray output
+    // between runs goes to stderr, and a password prompt reads EOF
+    // instead of consuming requests.
+    std::fflush(stdout);
+    int protocol_in = FV_DUP(0);
+    int protocol_out = FV_DUP(1);
+    if (protocol_in < 0 || protocol_out < 0) {
+        utils::Console::error("Failed to set up stdio");
+        return 1;
+    }
+#ifdef _WIN32
+    _setmode(protocol_in, _O_BINARY);
+    _setmode(protocol_out, _O_BINARY);
+#endif
+    replace_fd(0, -1);
+    replace_fd(1, 2);
+
+    ServeState state;
+    add_methods(state, runner_);
+    MetricsEndpoint metrics;
+    if (!start_metrics_endpoint(metrics, metrics_port_, state)) {
+        FV_CLOSE(protocol_in);
+        FV_CLOSE(protocol_out);
+        return 1;
+    }
+    spdlog::info("Serving JSON-RPC on stdio");
+
+    LineChannel input(protocol_in);
+    LineChannel output(protocol_out);
+    serve_channel(input, output, state);
+
+    FV_CLOSE(protocol_in);
+    FV_CLOSE(protocol_out);
+    return 0;
+}
+
+int ServeCommand::serve_socket() {
+#ifdef _WIN32
+    utils::Console::error("--socket is not available on Windows; use 'filevault serve --stdio'");
+    return 1;
+#else
+    std::string path = socket_path_.empty() ? default_socket_path() : socket_path_;
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        utils::Console::error("Socket path too long: " + path);
+        return 1;
+    }
+    addr.sun_family = AF_UNIX;
+    std::copy(path.begin(), path.end(), addr.sun_path);
+
+    // A leftover socket of a daemon that died is removed; a live one is not
+    if (std::filesystem::exists(path)) {
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        bool live = probe >= 0 && connect(probe, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+        if (probe >= 0) {
+            close(probe);
+        }
+        if (live) {
+            utils::Console::error("A daemon is already listening on " + path);
+            return 1;
+        }
+        std::filesystem::remove(path);
+    }
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        utils::Console::error("Failed to create socket");
+        return 1;
+    }
+    // Requests carry passwords: only the owner may connect
+    mode_t old_mask = umask(0177);
+    bool bound = bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    umask(old_mask);
+    if (!bound || listen(listen_fd, 16) != 0) {
+        utils::Console::error("Failed to listen on " + path);
+        close(listen_fd);
+        return 1;
+    }
+
+    // A client that disconnects mid-response must not kill the daemon
+    std::signal(SIGPIPE, SIG_IGN);
+    replace_fd(0, -1);
+
+    ServeState state;
+    add_methods(state, runner_);
+    MetricsEndpoint metrics;
+    if (!start_metrics_endpoint(metrics, metrics_port_, state)) {
+        close(listen_fd);
+        std::filesystem::remove(path);
+        return 1;
+    }
+    utils::Console::info("Listening on " + path);
+    std::fflush(stdout);
+
+    struct Connection {
+        std::thread thread;
+        int fd;
+        std::shared_ptr<std::atomic<bool>> done;
+    };
+    std::vector<Connection> connections;
+
+    while (!state.stopping) {
+        // Reap finished connections
+        for (auto it = connections.begin(); it != connections.end();) {
+            if (*it->done) {
+                it->thread.join();
+                close(it->fd);
+                it = connections.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        // Poll so a shutdown request is noticed without another connection
+        pollfd pfd{listen_fd, POLLIN, 0};
+        if (poll(&pfd, 1, 200) <= 0) {
+            continue;
+        }
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+
+        auto done = std::make_shared<std::atomic<bool>>(false);
+        std::thread thread([fd, done, &state] {
+            LineChannel channel(fd);
+            serve_channel(channel, channel, state);
+            *done = true;
+        });
+        connections.push_back({std::move(thread), fd, done});
+    }
+
+    // Wake connections blocked waiting for their next request
+    for (auto& connection : connections) {
+        shutdown(connection.fd, SHUT_RDWR);
+    }
+    for (auto& connection : connections) {
+        connection.thread.join();
+        close(connection.fd);
+    }
+
+    close(listen_fd);
+    std::filesystem::remove(path);
+    spdlog::info("Served {} requests", state.requests.load());
+    return 0;
+#endif
+}
+
+} // namespace cli
+} // namespace filevault
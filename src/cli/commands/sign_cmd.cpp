@@ -1,45 +1,57 @@
 #include "filevault/cli/commands/sign_cmd.hpp"
+#include "filevault/core/thread_pool.hpp"
 #include "filevault/utils/console.hpp"
 #include "filevault/utils/file_io.hpp"
-#include "filevault/algorithms/asymmetric/rsa.hpp"
 #include <botan/hex.h>
+#include <chrono>
 #include <fstream>
+#include <future>
 
 namespace filevault {
 namespace cli {
 namespace commands {
 
-SignCommand::SignCommand(core::CryptoEngine& engine) 
+using algorithms::asymmetric::DigestSigner;
+using algorithms::asymmetric::LoadedKey;
+
+SignCommand::SignCommand(core::CryptoEngine& engine)
     : engine_(engine) {}
 
 void SignCommand::setup(CLI::App& app) {
     auto* cmd = app.add_subcommand(name_, description_);
-    
-    cmd->add_option("file", file_path_, "File to sign")
+
+    cmd->add_option("files", files_, "Files to sign (legacy form: <file> <private-key>)")
         ->required()
         ->check(CLI::ExistingFile);
-    
-    cmd->add_option("private-key", private_key_path_, "Private key file (PEM format)")
-        ->required()
+
+    cmd->add_option("-k,--key", private_key_path_, "Private key file (PEM or DER)")
         ->check(CLI::ExistingFile);
-    
-    cmd->add_option("-o,--output", output_path_, "Output signature file (.sig)")
+
+    cmd->add_option("-o,--output", output_path_, "Output signature file (.sig), single file only")
         ->default_val("");
-    
-    cmd->add_option("-a,--algorithm", algorithm_, "Signature algorithm")
-        ->default_val("rsa")
+
+    cmd->add_option("-m,--manifest", manifest_path_,
+                   "Write one sha256sum manifest of all files, signed as <manifest>.sig");
+
+    cmd->add_option("-a,--algorithm", algorithm_, "Signature algorithm (default: from the key)")
         ->check(CLI::IsMember({"rsa", "ecc", "ed25519"}));
-    
+
+    cmd->add_option("-T,--threads", threads_, "Files hashed and signed in parallel (0 = one per core)");
+
     cmd->footer(
         "\nExamples:\n"
         "  Sign with RSA:     filevault sign document.txt private.pem -o document.sig\n"
         "  Sign with ECC:     filevault sign file.bin key.pem -a ecc\n"
+        "  Sign many files:   filevault sign dist/*.tar.gz -k release.key\n"
+        "  Signed manifest:   filevault sign dist/* -k release.key -m SHA256SUMS\n"
         "\n"
-        "Supported algorithms: rsa, ecc, ed25519\n"
+        "Supported algorithms: rsa (PSS), ecc (ECDSA), ed25519\n"
         "Default output: <filename>.sig\n"
+        "The SHA-256 digest of each file is signed; RSA and ECDSA signatures are\n"
+        "the same as signing the whole file with SHA-256.\n"
     );
-    
-    cmd->callback([this]() { 
+
+    cmd->callback([this]() {
         int exit_code = this->execute();
         if (exit_code != 0) {
             throw CLI::RuntimeError(exit_code);
@@ -49,79 +61,128 @@ void SignCommand::setup(CLI::App& app) {
 
 int SignCommand::execute() {
     try {
-        // Set default output path
-        if (output_path_.empty()) {
-            output_path_ = file_path_ + ".sig";
+        // Legacy form: the last positional is the key
+        if (private_key_path_.empty()) {
+            if (files_.size() < 2) {
+                utils::Console::error("No private key given (use -k <key>)");
+                return 1;
+            }
+            private_key_path_ = files_.back();
+            files_.pop_back();
         }
-        
-        utils::Console::info(fmt::format("Signing file: {}", file_path_));
-        utils::Console::info(fmt::format("Algorithm: {}", algorithm_));
-        
-        // Read file to sign
-        std::ifstream file(file_path_, std::ios::binary);
-        if (!file) {
-            utils::Console::error("Failed to open file");
+        if (!output_path_.empty() && (files_.size() != 1 || !manifest_path_.empty())) {
+            utils::Console::error("-o takes a single file; use -m for a manifest of several files");
             return 1;
         }
-        
-        file.seekg(0, std::ios::end);
-        size_t file_size = file.tellg();
-        file.seekg(0, std::ios::beg);
-        
-        std::vector<uint8_t> data(file_size);
-        file.read(reinterpret_cast<char*>(data.data()), file_size);
-        file.close();
-        
-        // Read private key
-        std::ifstream key_file(private_key_path_, std::ios::binary);
-        if (!key_file) {
-            utils::Console::error("Failed to open private key file");
+
+        // Parse the private key once
+        auto key_result = LoadedKey::load_file(private_key_path_);
+        if (!key_result || !key_result.value.is_private()) {
+            utils::Console::error(key_result ? "Not a private key: " + private_key_path_
+                                             : key_result.error_message);
             return 1;
         }
-        
-        key_file.seekg(0, std::ios::end);
-        size_t key_size = key_file.tellg();
-        key_file.seekg(0, std::ios::beg);
-        
-        std::vector<uint8_t> private_key(key_size);
-        key_file.read(reinterpret_cast<char*>(private_key.data()), key_size);
-        key_file.close();
-        
-        // Create signature based on algorithm
-        std::vector<uint8_t> signature;
-        
-        if (algorithm_ == "rsa") {
-            algorithms::asymmetric::RSA rsa;
-            signature = rsa.sign(data, private_key);
-        } else if (algorithm_ == "ecc") {
-            utils::Console::error("ECC signing not yet implemented");
+        DigestSigner signer(std::move(key_result.value));
+        if (!algorithm_.empty() && DigestSigner::parse_scheme(algorithm_) != signer.scheme()) {
+            utils::Console::error(fmt::format("Key is {}, not {}",
+                                              DigestSigner::scheme_name(signer.scheme()), algorithm_));
             return 1;
-        } else if (algorithm_ == "ed25519") {
-            utils::Console::error("Ed25519 signing not yet implemented");
+        }
+
+        utils::Console::info(fmt::format("Algorithm: {}", DigestSigner::scheme_name(signer.scheme())));
+        return manifest_path_.empty() ? sign_files(signer) : sign_manifest(signer);
+
+    } catch (const std::exception& e) {
+        utils::Console::error(fmt::format("Signing failed: {}", e.what()));
+        return 1;
+    }
+}
+
+int SignCommand::sign_files(const DigestSigner& signer) {
+    auto start = std::chrono::steady_clock::now();
+    core::ThreadPool pool(threads_ == 0 ? 0 : std::min(threads_, files_.size()));
+
+    // Each task hashes, signs and writes one .sig; results print in input order
+    std::vector<std::future<std::vector<uint8_t>>> tasks;
+    for (const auto& file : files_) {
+        auto sig_path = output_path_.empty() ? file + ".sig" : output_path_;
+        tasks.push_back(pool.submit([&signer, file, sig_path]() {
+            auto signature = signer.sign(DigestSigner::digest_file(file));
+            auto written = utils::FileIO::write_file(sig_path, signature);
+            if (!written) {
+                throw std::runtime_error(written.error_message);
+            }
+            return signature;
+        }));
+    }
+
+    int failures = 0;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        auto sig_path = output_path_.empty() ? files_[i] + ".sig" : output_path_;
+        try {
+            auto signature = tasks[i].get();
+            if (files_.size() == 1) {
+                utils::Console::success(fmt::format("Signature created: {}", sig_path));
+                utils::Console::info(fmt::format("Signature size: {} bytes", signature.size()));
+                utils::Console::info(fmt::format("Signature (hex): {}",
+                    Botan::hex_encode(signature.data(), std::min(size_t(32), signature.size()))));
+            } else {
+                fmt::print("{}: signed -> {}\n", files_[i], sig_path);
+            }
+        } catch (const std::exception& e) {
+            utils::Console::error(fmt::format("{}: {}", files_[i], e.what()));
+            failures++;
+        }
+    }
+
+    if (files_.size() > 1) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        utils::Console::info(fmt::format("Signed {} of {} files in {:.2f}s ({} threads)",
+                                         files_.size() - failures, files_.size(), seconds, pool.size()));
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+int SignCommand::sign_manifest(const DigestSigner& signer) {
+    auto start = std::chrono::steady_clock::now();
+    core::ThreadPool pool(threads_ == 0 ? 0 : std::min(threads_, files_.size()));
+
+    std::vector<std::future<std::vector<uint8_t>>> digests;
+    for (const auto& file : files_) {
+        if (file.find('\n') != std::string::npos) {
+            utils::Console::error("File names with newlines cannot go in a manifest");
             return 1;
         }
-        
-        // Write signature to file
-        std::ofstream sig_file(output_path_, std::ios::binary);
-        if (!sig_file) {
-            utils::Console::error("Failed to create signature file");
+        digests.push_back(pool.submit([file]() { return DigestSigner::digest_file(file); }));
+    }
+
+    // sha256sum format, so the manifest also works with hash --check
+    std::string manifest;
+    for (size_t i = 0; i < files_.size(); ++i) {
+        try {
+            manifest += fmt::format("{}  {}\n", Botan::hex_encode(digests[i].get(), false), files_[i]);
+        } catch (const std::exception& e) {
+            utils::Console::error(fmt::format("{}: {}", files_[i], e.what()));
             return 1;
         }
-        
-        sig_file.write(reinterpret_cast<const char*>(signature.data()), signature.size());
-        sig_file.close();
-        
-        utils::Console::success(fmt::format("Signature created: {}", output_path_));
-        utils::Console::info(fmt::format("Signature size: {} bytes", signature.size()));
-        utils::Console::info(fmt::format("Signature (hex): {}", 
-            Botan::hex_encode(signature.data(), std::min(size_t(32), signature.size()))));
-        
-        return 0;
-        
-    } catch (const std::exception& e) {
-        utils::Console::error(fmt::format("Signing failed: {}", e.what()));
+    }
+
+    auto manifest_bytes = std::span(reinterpret_cast<const uint8_t*>(manifest.data()), manifest.size());
+    auto signature = signer.sign(DigestSigner::digest(manifest_bytes));
+    auto written = utils::FileIO::write_file(manifest_path_, manifest_bytes);
+    if (written) {
+        written = utils::FileIO::write_file(manifest_path_ + ".sig", signature);
+    }
+    if (!written) {
+        utils::Console::error(written.error_message);
         return 1;
     }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    utils::Console::success(fmt::format("Manifest of {} files: {} (signature {}.sig)",
+                                        files_.size(), manifest_path_, manifest_path_));
+    utils::Console::info(fmt::format("Hashed and signed in {:.2f}s ({} threads)", seconds, pool.size()));
+    return 0;
 }
 
 } // namespace commands
@@ -1,17 +1,73 @@
 #include "filevault/cli/commands/stego_cmd.hpp"
+#include "filevault/archive/directory_walker.hpp"
+#include "filevault/core/thread_pool.hpp"
 #include "filevault/steganography/lsb.hpp"
+#include "filevault/steganography/steganalysis.hpp"
 #include "filevault/utils/console.hpp"
 #include "filevault/utils/file_io.hpp"
+#include <botan/hash.h>
+#include <botan/hex.h>
+#include <nlohmann/json.hpp>
+#include <chrono>
 #include <filesystem>
 #include <format>
 #include <fstream>
+#include <future>
 #include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
 
 namespace filevault::cli::commands {
 
 using namespace filevault::steganography;
 namespace fs = std::filesystem;
 
+namespace {
+
+constexpr const char* BATCH_MANIFEST_FORMAT = "filevault-stego-batch";
+
+PngWriteOptions make_png_options(int level, const std::string& filter) {
+    static const std::map<std::string, PngFilter> filters = {
+        {"adaptive", PngFilter::Adaptive}, {"none", PngFilter::None}, {"sub", PngFilter::Sub},
+        {"up", PngFilter::Up}, {"average", PngFilter::Average}, {"paeth", PngFilter::Paeth}
+    };
+    return PngWriteOptions{level, filters.at(filter)};
+}
+
+std::string sha256_hex(std::span<const uint8_t> data) {
+    auto hash = Botan::HashFunction::create_or_throw("SHA-256");
+    hash->update(data.data(), data.size());
+    return Botan::hex_encode(hash->final(), false);
+}
+
+/**
+ * @brief Split size bytes over covers in proportion to their capacity
+ *
+ * Spreading the payload keeps every cover at about the same embedding
+ * density; rounding leftovers go to the first covers with room.
+ */
+std::vector<size_t> shard_sizes(size_t size, const std::vector<size_t>& capacities) {
+    long double total = 0;
+    for (size_t capacity : capacities) {
+        total += static_cast<long double>(capacity);
+    }
+    std::vector<size_t> shares(capacities.size(), 0);
+    size_t assigned = 0;
+    for (size_t i = 0; i < capacities.size() && total > 0; ++i) {
+        shares[i] = std::min(capacities[i], static_cast<size_t>(size * (capacities[i] / total)));
+        assigned += shares[i];
+    }
+    for (size_t i = 0; i < capacities.size() && assigned < size; ++i) {
+        size_t extra = std::min(capacities[i] - shares[i], size - assigned);
+        shares[i] += extra;
+        assigned += extra;
+    }
+    return shares;
+}
+
+} // anonymous namespace
+
 void StegoCommand::setup(CLI::App& app) {
     auto* cmd = app.add_subcommand("stego", description());
     
@@ -27,6 +83,10 @@ void StegoCommand::setup(CLI::App& app) {
         ->required();
     embed_cmd->add_option("-b,--bits", bits_per_channel_, "Bits per channel (1-4, default: 1)")
         ->check(CLI::Range(1, 4));
+    embed_cmd->add_option("--png-level", png_level_, "PNG zlib level (0-9, default: 6; 1 is much faster)")
+        ->check(CLI::Range(0, 9));
+    embed_cmd->add_option("--png-filter", png_filter_, "PNG row filter (default: adaptive; 'up' is fastest)")
+        ->check(CLI::IsMember({"adaptive", "none", "sub", "up", "average", "paeth"}));
     embed_cmd->add_flag("-v,--verbose", verbose_, "Show detailed information");
     embed_cmd->callback([this]() { 
         operation_ = "embed";
@@ -69,11 +129,74 @@ void StegoCommand::setup(CLI::App& app) {
         }
     });
 
+    // Batch embed: one payload sharded over many covers
+    auto* batch_cmd = cmd->add_subcommand("embed-batch", "Spread data over many cover images");
+    batch_cmd->add_option("input", input_file_, "Secret file to hide (encrypt it first)")
+        ->required()
+        ->check(CLI::ExistingFile);
+    batch_cmd->add_option("covers", covers_, "Cover images (PNG/BMP) or directories of them")
+        ->required();
+    batch_cmd->add_option("-o,--output-dir", output_dir_, "Directory for the stego images")
+        ->required();
+    batch_cmd->add_option("-m,--manifest", manifest_path_, "Manifest path (default: <output-dir>/manifest.json)");
+    batch_cmd->add_option("-b,--bits", bits_per_channel_, "Bits per channel (1-4, default: 1)")
+        ->check(CLI::Range(1, 4));
+    batch_cmd->add_option("--png-level", png_level_, "PNG zlib level (0-9, default: 6; 1 is much faster)")
+        ->check(CLI::Range(0, 9));
+    batch_cmd->add_option("--png-filter", png_filter_, "PNG row filter (default: adaptive; 'up' is fastest)")
+        ->check(CLI::IsMember({"adaptive", "none", "sub", "up", "average", "paeth"}));
+    batch_cmd->add_option("-T,--threads", threads_, "Covers processed in parallel (0 = one per core)");
+    batch_cmd->add_flag("-v,--verbose", verbose_, "Show detailed information");
+    batch_cmd->callback([this]() {
+        operation_ = "embed-batch";
+        int exit_code = execute();
+        if (exit_code != 0) {
+            throw CLI::RuntimeError(exit_code);
+        }
+    });
+    
+    // Batch extract: reassemble from a manifest
+    auto* unbatch_cmd = cmd->add_subcommand("extract-batch", "Reassemble data spread by embed-batch");
+    unbatch_cmd->add_option("manifest", manifest_path_, "Manifest written by embed-batch")
+        ->required()
+        ->check(CLI::ExistingFile);
+    unbatch_cmd->add_option("output", output_file_, "Output file for the reassembled data")
+        ->required();
+    unbatch_cmd->add_option("-T,--threads", threads_, "Images read in parallel (0 = one per core)");
+    unbatch_cmd->add_flag("-v,--verbose", verbose_, "Show detailed information");
+    unbatch_cmd->callback([this]() {
+        operation_ = "extract-batch";
+        int exit_code = execute();
+        if (exit_code != 0) {
+            throw CLI::RuntimeError(exit_code);
+        }
+    });
+    
+    // Scan: steganalysis over image sets
+    auto* scan_cmd = cmd->add_subcommand("scan", "Check images for hidden LSB payloads");
+    scan_cmd->add_option("images", scan_inputs_, "Images (PNG/BMP) or directories of them")
+        ->required();
+    scan_cmd->add_option("-t,--threshold", threshold_, "Score from which an image is flagged (0-1, default: 0.5)")
+        ->check(CLI::Range(0.0, 1.0));
+    scan_cmd->add_option("-T,--threads", threads_, "Images scanned in parallel (0 = one per core)");
+    scan_cmd->add_flag("--json", json_, "One JSON object per image (JSON lines), then a summary");
+    scan_cmd->callback([this]() {
+        operation_ = "scan";
+        int exit_code = execute();
+        if (exit_code != 0) {
+            throw CLI::RuntimeError(exit_code);
+        }
+    });
+    
     capacity_cmd->footer(
         "\nExamples:\n"
         "  Embed data:          filevault stego embed secret.txt cover.png -o stego.png\n"
         "  Extract data:       filevault stego extract stego.png -o extracted.txt\n"
         "  Check capacity:     filevault stego capacity cover.png -b 2\n"
+        "  Fast PNG output:    filevault stego embed secret.txt cover.png stego.png --png-level 1 --png-filter up\n"
+        "  Spread over covers: filevault stego embed-batch secret.fvlt covers/ -o out/\n"
+        "  Reassemble:         filevault stego extract-batch out/manifest.json secret.fvlt\n"
+        "  Scan for payloads:  filevault stego scan outbound/ -T 8 --json\n"
         "\n"
         "Supported image formats: PNG, BMP\n"
     );
@@ -88,6 +211,12 @@ int StegoCommand::execute() {
         return do_extract();
     } else if (operation_ == "capacity") {
         return do_capacity();
+    } else if (operation_ == "embed-batch") {
+        return do_embed_batch();
+    } else if (operation_ == "extract-batch") {
+        return do_extract_batch();
+    } else if (operation_ == "scan") {
+        return do_scan();
     }
     
     utils::Console::error("Unknown operation");
@@ -149,7 +278,8 @@ int StegoCommand::do_embed() {
             cover_image_,
             data_with_metadata,
             output_file_,
-            bits_per_channel_
+            bits_per_channel_,
+            make_png_options(png_level_, png_filter_)
         );
         
         if (!success) {
@@ -313,4 +443,326 @@ int StegoCommand::do_capacity() {
     }
 }
 
+int StegoCommand::do_embed_batch() {
+    try {
+        auto start = std::chrono::steady_clock::now();
+        
+        archive::WalkOptions walk;
+        walk.include = {"*.png", "*.PNG", "*.bmp", "*.BMP"};
+        walk.threads = threads_;
+        auto expansion = archive::DirectoryWalker::expand_inputs(covers_, walk);
+        for (const auto& message : expansion.missing) {
+            utils::Console::error(message);
+        }
+        for (const auto& message : expansion.errors) {
+            utils::Console::warning(message);
+        }
+        if (!expansion.missing.empty() || expansion.files.empty()) {
+            utils::Console::error("No cover images found");
+            return 1;
+        }
+        const auto& covers = expansion.files;
+        
+        // Stego images keep their cover's file name, so names must be unique
+        std::set<std::string> names;
+        for (const auto& cover : covers) {
+            if (!names.insert(fs::path(cover).filename().string()).second) {
+                utils::Console::error(std::format("Two covers are named {}; rename one", fs::path(cover).filename().string()));
+                return 1;
+            }
+        }
+        
+        auto mapped = utils::FileIO::map_file(input_file_);
+        if (!mapped.success) {
+            utils::Console::error(std::format("Failed to read input file: {}", mapped.error_message));
+            return 1;
+        }
+        auto payload = mapped.value.span();
+        if (payload.empty()) {
+            utils::Console::error("Input file is empty");
+            return 1;
+        }
+        
+        core::ThreadPool pool(threads_ == 0 ? 0 : std::min(threads_, covers.size()));
+        
+        // Capacities from headers only (stbi_info), in parallel
+        std::vector<std::future<size_t>> probes;
+        for (const auto& cover : covers) {
+            probes.push_back(pool.submit([this, cover]() {
+                return LSBSteganography::calculate_capacity(cover, bits_per_channel_);
+            }));
+        }
+        std::vector<size_t> capacities;
+        size_t total_capacity = 0;
+        for (auto& probe : probes) {
+            capacities.push_back(probe.get());
+            total_capacity += capacities.back();
+        }
+        if (payload.size() > total_capacity) {
+            utils::Console::error(std::format(
+                "Secret data ({} bytes) exceeds the capacity of {} covers ({} bytes)",
+                payload.size(), covers.size(), total_capacity));
+            utils::Console::info(std::format("Try using --bits {} for more capacity", std::min(bits_per_channel_ + 1, 4)));
+            return 1;
+        }
+        auto shares = shard_sizes(payload.size(), capacities);
+        
+        fs::create_directories(output_dir_);
+        if (manifest_path_.empty()) {
+            manifest_path_ = (fs::path(output_dir_) / "manifest.json").string();
+        }
+        fs::path manifest_dir = fs::absolute(manifest_path_).parent_path();
+        
+        // Decode, embed and encode every cover on the pool
+        auto png_options = make_png_options(png_level_, png_filter_);
+        struct Shard {
+            std::string image;
+            size_t offset;
+            size_t size;
+            std::future<std::string> digest;   // Empty string = embed failed
+        };
+        std::vector<Shard> shards;
+        size_t offset = 0;
+        for (size_t i = 0; i < covers.size(); ++i) {
+            if (shares[i] == 0) {
+                continue;
+            }
+            auto image = (fs::path(output_dir_) / fs::path(covers[i]).filename()).string();
+            auto slice = payload.subspan(offset, shares[i]);
+            shards.push_back({image, offset, shares[i], pool.submit([this, cover = covers[i], image, slice, png_options]() {
+                if (!LSBSteganography::embed(cover, slice, image, bits_per_channel_, png_options)) {
+                    return std::string();
+                }
+                return sha256_hex(slice);
+            })});
+            offset += shares[i];
+        }
+        
+        nlohmann::json manifest;
+        manifest["format"] = BATCH_MANIFEST_FORMAT;
+        manifest["version"] = 1;
+        manifest["name"] = fs::path(input_file_).filename().string();
+        manifest["size"] = payload.size();
+        manifest["sha256"] = sha256_hex(payload);
+        manifest["bits_per_channel"] = bits_per_channel_;
+        manifest["shards"] = nlohmann::json::array();
+        
+        size_t failures = 0;
+        for (auto& shard : shards) {
+            std::string digest;
+            try {
+                digest = shard.digest.get();
+            } catch (const std::exception& e) {
+                utils::Console::error(std::format("{}: {}", shard.image, e.what()));
+            }
+            if (digest.empty()) {
+                utils::Console::error(std::format("Failed to embed into {}", shard.image));
+                failures++;
+                continue;
+            }
+            if (verbose_) {
+                utils::Console::info(std::format("{}: {} bytes at offset {}", shard.image, shard.size, shard.offset));
+            }
+            manifest["shards"].push_back({
+                {"image", fs::absolute(shard.image).lexically_relative(manifest_dir).generic_string()},
+                {"offset", shard.offset},
+                {"size", shard.size},
+                {"sha256", digest},
+            });
+        }
+        if (failures > 0) {
+            utils::Console::error(std::format("{} of {} covers failed; no manifest written", failures, shards.size()));
+            return 1;
+        }
+        
+        std::ofstream out(manifest_path_);
+        out << manifest.dump(2) << "\n";
+        if (!out) {
+            utils::Console::error(std::format("Failed to write manifest: {}", manifest_path_));
+            return 1;
+        }
+        
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        utils::Console::success(std::format("Embedded {} bytes into {} of {} covers", payload.size(), shards.size(), covers.size()));
+        utils::Console::info(std::format("Utilization: {:.1f}%", 100.0 * payload.size() / total_capacity));
+        utils::Console::info(std::format("Manifest: {}", manifest_path_));
+        utils::Console::info(std::format("Time: {:.2f}s ({} threads)", seconds, pool.size()));
+        return 0;
+        
+    } catch (const std::exception& e) {
+        utils::Console::error(std::format("Batch embed failed: {}", e.what()));
+        return 1;
+    }
+}
+
+int StegoCommand::do_extract_batch() {
+    try {
+        auto start = std::chrono::steady_clock::now();
+        
+        std::ifstream in(manifest_path_);
+        auto manifest = nlohmann::json::parse(in);
+        if (manifest.value("format", "") != BATCH_MANIFEST_FORMAT || manifest.value("version", 0) != 1) {
+            utils::Console::error(std::format("Not a stego batch manifest: {}", manifest_path_));
+            return 1;
+        }
+        int bits = manifest.at("bits_per_channel").get<int>();
+        size_t size = manifest.at("size").get<size_t>();
+        const auto& entries = manifest.at("shards");
+        fs::path manifest_dir = fs::path(manifest_path_).parent_path();
+        
+        // Shards must tile the payload exactly
+        size_t expected_offset = 0;
+        for (const auto& entry : entries) {
+            if (entry.at("offset").get<size_t>() != expected_offset) {
+                utils::Console::error("Manifest shards do not cover the payload in order");
+                return 1;
+            }
+            expected_offset += entry.at("size").get<size_t>();
+        }
+        if (expected_offset != size) {
+            utils::Console::error("Manifest shards do not add up to the payload size");
+            return 1;
+        }
+        
+        core::ThreadPool pool(threads_ == 0 ? 0 : std::min(threads_, std::max<size_t>(entries.size(), 1)));
+        std::vector<std::future<std::vector<uint8_t>>> tasks;
+        for (const auto& entry : entries) {
+            auto image = (manifest_dir / entry.at("image").get<std::string>()).string();
+            tasks.push_back(pool.submit([image, bits]() { return LSBSteganography::extract(image, bits); }));
+        }
+        
+        std::vector<uint8_t> payload;
+        payload.reserve(size);
+        size_t failures = 0;
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            const auto& entry = entries[i];
+            auto image = entry.at("image").get<std::string>();
+            std::vector<uint8_t> shard;
+            try {
+                shard = tasks[i].get();
+            } catch (const std::exception& e) {
+                utils::Console::error(std::format("{}: {}", image, e.what()));
+            }
+            if (shard.size() != entry.at("size").get<size_t>() || sha256_hex(shard) != entry.at("sha256").get<std::string>()) {
+                utils::Console::error(std::format("{}: shard missing or corrupted", image));
+                failures++;
+                continue;
+            }
+            if (verbose_) {
+                utils::Console::info(std::format("{}: {} bytes OK", image, shard.size()));
+            }
+            payload.insert(payload.end(), shard.begin(), shard.end());
+        }
+        if (failures > 0) {
+            utils::Console::error(std::format("{} of {} shards failed", failures, tasks.size()));
+            return 1;
+        }
+        if (sha256_hex(payload) != manifest.at("sha256").get<std::string>()) {
+            utils::Console::error("Reassembled data does not match the manifest checksum");
+            return 1;
+        }
+        
+        auto write_result = utils::FileIO::write_file(output_file_, payload);
+        if (!write_result.success) {
+            utils::Console::error(std::format("Failed to write output file: {}", write_result.error_message));
+            return 1;
+        }
+        
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        utils::Console::success(std::format("Reassembled {} bytes from {} images", payload.size(), tasks.size()));
+        utils::Console::info(std::format("Output: {} (originally {})", output_file_, manifest.value("name", "")));
+        utils::Console::info(std::format("Time: {:.2f}s ({} threads)", seconds, pool.size()));
+        return 0;
+        
+    } catch (const std::exception& e) {
+        utils::Console::error(std::format("Batch extract failed: {}", e.what()));
+        return 1;
+    }
+}
+
+int StegoCommand::do_scan() {
+    try {
+        auto start = std::chrono::steady_clock::now();
+        
+        archive::WalkOptions walk;
+        walk.include = {"*.png", "*.PNG", "*.bmp", "*.BMP"};
+        walk.threads = threads_;
+        auto expansion = archive::DirectoryWalker::expand_inputs(scan_inputs_, walk);
+        for (const auto& message : expansion.missing) {
+            utils::Console::error(message);
+        }
+        for (const auto& message : expansion.errors) {
+            utils::Console::warning(message);
+        }
+        if (expansion.files.empty()) {
+            utils::Console::error("No images found");
+            return 1;
+        }
+        const auto& images = expansion.files;
+        
+        // Every image is read and analysed on the pool; reports come back in input order
+        core::ThreadPool pool(threads_ == 0 ? 0 : std::min(threads_, images.size()));
+        std::vector<std::future<ScanReport>> scans;
+        scans.reserve(images.size());
+        for (const auto& image : images) {
+            scans.push_back(pool.submit([image]() { return Steganalysis::scan(image); }));
+        }
+        
+        size_t suspicious = 0;
+        size_t unreadable = 0;
+        for (auto& future : scans) {
+            auto report = future.get();
+            bool flagged = report.error.empty() && report.score >= threshold_;
+            suspicious += flagged ? 1 : 0;
+            unreadable += report.error.empty() ? 0 : 1;
+            
+            if (json_) {
+                nlohmann::json line = {{"image", report.path}};
+                if (!report.error.empty()) {
+                    line["error"] = report.error;
+                } else {
+                    line["width"] = report.width;
+                    line["height"] = report.height;
+                    line["channels"] = report.channels;
+                    line["chi_square"] = report.chi_square;
+                    line["payload_extent"] = report.payload_extent;
+                    line["rs_rate"] = report.rs_rate;
+                    line["score"] = report.score;
+                    line["suspicious"] = flagged;
+                }
+                std::cout << line.dump() << "\n";
+            } else if (!report.error.empty()) {
+                utils::Console::error(std::format("{}: {}", report.path, report.error));
+            } else {
+                auto message = std::format("{}: score {:.2f} (chi-square {:.2f}, leading {:.0f}%; RS rate {:.2f})",
+                                           report.path, report.score, report.chi_square,
+                                           report.payload_extent * 100, report.rs_rate);
+                if (flagged) {
+                    utils::Console::warning(message + " SUSPICIOUS");
+                } else {
+                    utils::Console::info(message);
+                }
+            }
+        }
+        
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double rate = seconds > 0 ? static_cast<double>(scans.size()) / seconds : 0.0;
+        if (json_) {
+            nlohmann::json summary = {
+                {"images", scans.size()}, {"suspicious", suspicious}, {"unreadable", unreadable},
+                {"seconds", seconds}, {"images_per_second", rate}, {"threads", pool.size()},
+            };
+            std::cout << nlohmann::json{{"summary", summary}}.dump() << "\n";
+        } else {
+            utils::Console::info(std::format("{} images, {} suspicious, {} unreadable ({:.2f}s, {:.1f} images/s, {} threads)",
+                                             scans.size(), suspicious, unreadable, seconds, rate, pool.size()));
+        }
+        return unreadable == 0 && expansion.missing.empty() ? 0 : 1;
+        
+    } catch (const std::exception& e) {
+        utils::Console::error(std::format("Scan failed: {}", e.what()));
+        return 1;
+    }
+}
+
 } // namespace filevault::cli::commands
@@ -0,0 +1,402 @@
+#include "filevault/cli/commands/store_cmd.hpp"
+#include "filevault/core/crypto_engine.hpp"
+#include "filevault/store/blob_store.hpp"
+#include "filevault/utils/console.hpp"
+#include "filevault/utils/crypto_utils.hpp"
+#include "filevault/utils/password.hpp"
+#include <fmt/core.h>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+namespace filevault {
+namespace cli {
+
+void StoreCommand::setup(CLI::App& app) {
+    auto* store_cmd = app.add_subcommand(name(), description());
+
+    auto* create_cmd = store_cmd->add_subcommand("create", "Create an empty store");
+    create_cmd->add_option("store", store_dir_, "Store directory")->required();
+    create_cmd->add_option("--segment-size", segment_bytes_, "Seal segments at this size (K, M, G suffixes allowed)")
+        ->transform(CLI::AsSizeValue(false));
+    create_cmd->add_option("-p,--password", password_, "Store password");
+    create_cmd->add_option("-k,--kdf", kdf_, "Key derivation function")
+        ->check(CLI::IsMember({"argon2id", "argon2i", "pbkdf2-sha256", "pbkdf2-sha512"}));
+    create_cmd->add_option("-s,--security", security_level_, "Security level")
+        ->check(CLI::IsMember({"weak", "medium", "strong", "paranoid"}));
+    create_cmd->callback([this]() {
+        subcommand_ = "create";
+        run();
+    });
+
+    auto* info_cmd = store_cmd->add_subcommand("info", "Show store settings and sizes");
+    info_cmd->add_option("store", store_dir_, "Store directory")
+        ->required()
+        ->check(CLI::ExistingDirectory);
+    info_cmd->add_option("-p,--password", password_, "Store password (for key and byte counts)");
+    info_cmd->callback([this]() {
+        subcommand_ = "info";
+        run();
+    });
+
+    auto* put_cmd = store_cmd->add_subcommand("put", "Store a value under a key");
+    put_cmd->add_option("store", store_dir_, "Store directory")
+        ->required()
+        ->check(CLI::ExistingDirectory);
+    put_cmd->add_option("key", key_, "Key")->required();
+    auto* value_opt = put_cmd->add_option("value", value_, "Value");
+    put_cmd->add_option("-f,--file", data_file_, "Read the value from a file ('-' = stdin)")->excludes(value_opt);
+    put_cmd->add_option("-p,--password", password_, "Store password");
+    put_cmd->callback([this]() {
+        subcommand_ = "put";
+        run();
+    });
+
+    auto* get_cmd = store_cmd->add_subcommand("get", "Print or save the value of a key");
+    get_cmd->add_option("store", store_dir_, "Store directory")
+        ->required()
+        ->check(CLI::ExistingDirectory);
+    get_cmd->add_option("key", key_, "Key")->required();
+    get_cmd->add_option("-o,--output", data_file_, "Output file (default: stdout)");
+    get_cmd->add_option("-p,--password", password_, "Store password");
+    get_cmd->callback([this]() {
+        subcommand_ = "get";
+        run();
+    });
+
+    auto* delete_cmd = store_cmd->add_subcommand("delete", "Delete a key");
+    delete_cmd->add_option("store", store_dir_, "Store directory")
+        ->required()
+        ->check(CLI::ExistingDirectory);
+    delete_cmd->add_option("key", key_, "Key")->required();
+    delete_cmd->add_option("-p,--password", password_, "Store password");
+    delete_cmd->callback([this]() {
+        subcommand_ = "delete";
+        run();
+    });
+
+    auto* list_cmd = store_cmd->add_subcommand("list", "List the keys");
+    list_cmd->add_option("store", store_dir_, "Store directory")
+        ->required()
+        ->check(CLI::ExistingDirectory);
+    list_cmd->add_option("-p,--password", password_, "Store password");
+    list_cmd->callback([this]() {
+        subcommand_ = "list";
+        run();
+    });
+
+    auto* compact_cmd = store_cmd->add_subcommand("compact", "Drop overwritten and deleted records");
+    compact_cmd->add_option("store", store_dir_, "Store directory")
+        ->required()
+        ->check(CLI::ExistingDirectory);
+    compact_cmd->add_option("-p,--password", password_, "Store password");
+    compact_cmd->callback([this]() {
+        subcommand_ = "compact";
+        run();
+    });
+
+    auto* passwd_cmd = store_cmd->add_subcommand("passwd", "Change a store's password");
+    passwd_cmd->add_option("store", store_dir_, "Store directory")
+        ->required()
+        ->check(CLI::ExistingDirectory);
+    passwd_cmd->add_option("-p,--password", password_, "Current password");
+    passwd_cmd->add_option("--new-password", new_password_, "New password");
+    passwd_cmd->callback([this]() {
+        subcommand_ = "passwd";
+        run();
+    });
+
+    store_cmd->footer(
+        "\nExamples:\n"
+        "  Create a store:     filevault store create secrets.fvs\n"
+        "  Store a value:      filevault store put secrets.fvs db-password 'hunter2'\n"
+        "  Store a file:       filevault store put secrets.fvs id_ed25519 --file ~/.ssh/id_ed25519\n"
+        "  Read it back:       filevault store get secrets.fvs id_ed25519 -o key\n"
+        "  Reclaim space:      filevault store compact secrets.fvs\n"
+        "\n"
+        "Records are appended and sealed with AES-256-GCM; overwritten and\n"
+        "deleted values take space until the store is compacted.\n"
+    );
+
+    store_cmd->require_subcommand(1);
+}
+
+void StoreCommand::run() {
+    int exit_code = execute();
+    if (exit_code != 0) {
+        throw CLI::RuntimeError(exit_code);
+    }
+}
+
+int StoreCommand::execute() {
+    if (subcommand_ == "create") {
+        return create();
+    } else if (subcommand_ == "info") {
+        return info();
+    } else if (subcommand_ == "put") {
+        return put();
+    } else if (subcommand_ == "get") {
+        return get();
+    } else if (subcommand_ == "delete") {
+        return remove();
+    } else if (subcommand_ == "list") {
+        return list();
+    } else if (subcommand_ == "compact") {
+        return compact();
+    } else if (subcommand_ == "passwd") {
+        return passwd();
+    }
+    return 1;
+}
+
+bool StoreCommand::read_password(const std::string& prompt, bool confirm, std::string& password) {
+    if (password.empty()) {
+        password = utils::Password::read_secure(prompt, confirm);
+        if (password.empty()) {
+            utils::Console::error("Password cannot be empty");
+            return false;
+        }
+    }
+    return true;
+}
+
+int StoreCommand::create() {
+    auto kdf = core::CryptoEngine::parse_kdf(kdf_);
+    auto level = core::CryptoEngine::parse_security_level(security_level_);
+    if (!kdf || !level) {
+        utils::Console::error("Invalid KDF or security level");
+        return 1;
+    }
+
+    store::BlobStoreConfig config;
+    config.kdf = *kdf;
+    config.level = *level;
+    config.segment_bytes = segment_bytes_;
+
+    if (!read_password("Enter store password: ", true, password_)) {
+        return 1;
+    }
+    store::BlobStore blobs(store_dir_);
+    auto created = blobs.create(password_, config);
+    if (!created) {
+        utils::Console::error(created.error_message);
+        return 1;
+    }
+    utils::Console::success(fmt::format("Store created: {} (segments of {})", store_dir_,
+                                        utils::CryptoUtils::format_bytes(config.segment_bytes)));
+    return 0;
+}
+
+int StoreCommand::info() {
+    store::BlobStore blobs(store_dir_);
+    auto opened = blobs.open();
+    if (!opened) {
+        utils::Console::error(opened.error_message);
+        return 1;
+    }
+
+    utils::Console::header("Encrypted Store");
+    fmt::print("  Location:     {}\n", blobs.directory().string());
+    fmt::print("  Cipher:       AES-256-GCM per record (key sealed with AES-256-GCM)\n");
+    fmt::print("  KDF:          {} ({})\n", core::CryptoEngine::kdf_name(blobs.config().kdf),
+               core::CryptoEngine::security_level_name(blobs.config().level));
+    fmt::print("  Segment size: {}\n", utils::CryptoUtils::format_bytes(blobs.config().segment_bytes));
+
+    if (password_.empty()) {
+        return 0;
+    }
+    auto unlocked = blobs.unlock(password_, true);
+    if (!unlocked) {
+        utils::Console::error(unlocked.error_message);
+        return 1;
+    }
+    auto stats = blobs.stats();
+    fmt::print("  Keys:         {}\n", stats.keys);
+    fmt::print("  Segments:     {}\n", stats.segments);
+    fmt::print("  Live data:    {}\n", utils::CryptoUtils::format_bytes(stats.live_bytes));
+    fmt::print("  On disk:      {}\n", utils::CryptoUtils::format_bytes(stats.disk_bytes));
+    return 0;
+}
+
+int StoreCommand::put() {
+    std::vector<uint8_t> value;
+    if (data_file_.empty()) {
+        value.assign(value_.begin(), value_.end());
+    } else if (data_file_ == "-") {
+        if (password_.empty()) {
+            utils::Console::error("Reading the value from stdin needs --password");
+            return 1;
+        }
+        value.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+    } else {
+        std::ifstream in(data_file_, std::ios::binary);
+        if (!in) {
+            utils::Console::error("Cannot open " + data_file_);
+            return 1;
+        }
+        value.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    if (!read_password("Enter store password: ", false, password_)) {
+        return 1;
+    }
+    store::BlobStore blobs(store_dir_);
+    auto unlocked = blobs.unlock(password_);
+    if (!unlocked) {
+        utils::Console::error(unlocked.error_message);
+        return 1;
+    }
+    auto stored = blobs.put(key_, value);
+    if (stored) {
+        stored = blobs.close();
+    }
+    if (!stored) {
+        utils::Console::error(stored.error_message);
+        return 1;
+    }
+    utils::Console::success(fmt::format("Stored {} ({})", key_, utils::CryptoUtils::format_bytes(value.size())));
+    return 0;
+}
+
+int StoreCommand::get() {
+    bool to_stdout = data_file_.empty() || data_file_ == "-";
+    if (to_stdout) {
+        // stdout carries the value
+        utils::Console::set_stream(stderr);
+    }
+    if (!read_password("Enter store password: ", false, password_)) {
+        return 1;
+    }
+    store::BlobStore blobs(store_dir_);
+    auto unlocked = blobs.unlock(password_, true);
+    if (!unlocked) {
+        utils::Console::error(unlocked.error_message);
+        return 1;
+    }
+
+    std::vector<uint8_t> value;
+    auto found = blobs.get(key_, value);
+    if (!found) {
+        utils::Console::error(found.error_message);
+        return 1;
+    }
+    if (!found.value) {
+        utils::Console::error("No such key: " + key_);
+        return 1;
+    }
+
+    std::FILE* out = to_stdout ? stdout : std::fopen(data_file_.c_str(), "wb");
+    if (!out) {
+        utils::Console::error("Cannot create " + data_file_);
+        return 1;
+    }
+    bool ok = std::fwrite(value.data(), 1, value.size(), out) == value.size();
+    if (to_stdout) {
+        ok = std::fflush(stdout) == 0 && ok;
+    } else {
+        ok = std::fclose(out) == 0 && ok;
+    }
+    if (!ok) {
+        utils::Console::error("Failed to write " + (to_stdout ? std::string("stdout") : data_file_));
+        return 1;
+    }
+    if (!to_stdout) {
+        utils::Console::success(fmt::format("Wrote {} ({})", data_file_, utils::CryptoUtils::format_bytes(value.size())));
+    }
+    return 0;
+}
+
+int StoreCommand::remove() {
+    if (!read_password("Enter store password: ", false, password_)) {
+        return 1;
+    }
+    store::BlobStore blobs(store_dir_);
+    auto unlocked = blobs.unlock(password_);
+    if (!unlocked) {
+        utils::Console::error(unlocked.error_message);
+        return 1;
+    }
+    auto removed = blobs.remove(key_);
+    if (!removed) {
+        utils::Console::error(removed.error_message);
+        return 1;
+    }
+    if (!removed.value) {
+        utils::Console::error("No such key: " + key_);
+        return 1;
+    }
+    auto closed = blobs.close();
+    if (!closed) {
+        utils::Console::error(closed.error_message);
+        return 1;
+    }
+    utils::Console::success("Deleted " + key_);
+    return 0;
+}
+
+int StoreCommand::list() {
+    if (!read_password("Enter store password: ", false, password_)) {
+        return 1;
+    }
+    store::BlobStore blobs(store_dir_);
+    auto unlocked = blobs.unlock(password_, true);
+    if (!unlocked) {
+        utils::Console::error(unlocked.error_message);
+        return 1;
+    }
+    for (const auto& key : blobs.keys()) {
+        fmt::print("{}\n", key);
+    }
+    return 0;
+}
+
+int StoreCommand::compact() {
+    if (!read_password("Enter store password: ", false, password_)) {
+        return 1;
+    }
+    store::BlobStore blobs(store_dir_);
+    auto unlocked = blobs.unlock(password_);
+    if (!unlocked) {
+        utils::Console::error(unlocked.error_message);
+        return 1;
+    }
+    auto before = blobs.stats();
+    auto compacted = blobs.compact();
+    if (!compacted) {
+        utils::Console::error(compacted.error_message);
+        return 1;
+    }
+    auto after = blobs.stats();
+    utils::Console::success(fmt::format("Compacted {}: {} -> {} in {} segment(s), {} keys", store_dir_,
+                                        utils::CryptoUtils::format_bytes(before.disk_bytes),
+                                        utils::CryptoUtils::format_bytes(after.disk_bytes), after.segments,
+                                        after.keys));
+    return 0;
+}
+
+int StoreCommand::passwd() {
+    if (!read_password("Enter current password: ", false, password_)) {
+        return 1;
+    }
+    store::BlobStore blobs(store_dir_);
+    auto unlocked = blobs.unlock(password_);
+    if (!unlocked) {
+        utils::Console::error(unlocked.error_message);
+        return 1;
+    }
+    if (!read_password("Enter new password: ", true, new_password_)) {
+        return 1;
+    }
+    auto changed = blobs.change_password(new_password_);
+    if (!changed) {
+        utils::Console::error(changed.error_message);
+        return 1;
+    }
+    utils::Console::success("Password changed for " + store_dir_);
+    return 0;
+}
+
+} // namespace cli
+} // namespace filevault
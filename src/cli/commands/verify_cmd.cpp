@@ -1,45 +1,55 @@
 #include "filevault/cli/commands/verify_cmd.hpp"
+#include "filevault/core/thread_pool.hpp"
 #include "filevault/utils/console.hpp"
 #include "filevault/utils/file_io.hpp"
-#include "filevault/algorithms/asymmetric/rsa.hpp"
-#include <fstream>
+#include <botan/hex.h>
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <sstream>
 
 namespace filevault {
 namespace cli {
 namespace commands {
 
-VerifyCommand::VerifyCommand(core::CryptoEngine& engine) 
+using algorithms::asymmetric::DigestSigner;
+using algorithms::asymmetric::LoadedKey;
+
+VerifyCommand::VerifyCommand(core::CryptoEngine& engine)
     : engine_(engine) {}
 
 void VerifyCommand::setup(CLI::App& app) {
     auto* cmd = app.add_subcommand(name_, description_);
-    
-    cmd->add_option("file", file_path_, "File to verify")
-        ->required()
+
+    cmd->add_option("files", files_, "Files to verify (legacy form: <file> <signature> <public-key>)");
+
+    cmd->add_option("-k,--key", public_key_path_, "Public key file (PEM or DER)")
         ->check(CLI::ExistingFile);
-    
-    cmd->add_option("signature", signature_path_, "Signature file (.sig)")
-        ->required()
+
+    cmd->add_option("-s,--signature", signature_path_, "Signature file, single file only (default: <file>.sig)")
         ->check(CLI::ExistingFile);
-    
-    cmd->add_option("public-key", public_key_path_, "Public key file (PEM format)")
-        ->required()
+
+    cmd->add_option("-m,--manifest", manifest_path_,
+                   "Verify a manifest written by sign -m, then every file it lists")
         ->check(CLI::ExistingFile);
-    
-    cmd->add_option("-a,--algorithm", algorithm_, "Signature algorithm")
-        ->default_val("rsa")
+
+    cmd->add_option("-a,--algorithm", algorithm_, "Signature algorithm (default: from the key)")
         ->check(CLI::IsMember({"rsa", "ecc", "ed25519"}));
-    
+
+    cmd->add_option("-T,--threads", threads_, "Files verified in parallel (0 = one per core)");
+
     cmd->footer(
         "\nExamples:\n"
         "  Verify RSA signature:  filevault verify document.txt document.sig public.pem\n"
         "  Verify ECC signature:  filevault verify file.bin file.sig key.pem -a ecc\n"
+        "  Verify many files:     filevault verify dist/*.tar.gz -k release.pub\n"
+        "  Verify a manifest:     filevault verify -m SHA256SUMS -k release.pub\n"
         "\n"
         "Supported algorithms: rsa, ecc, ed25519\n"
-        "Exit code: 0 = valid signature, 1 = invalid signature or error\n"
+        "Exit code: 0 = all signatures valid, 1 = invalid signature or error\n"
     );
-    
-    cmd->callback([this]() { 
+
+    cmd->callback([this]() {
         int exit_code = this->execute();
         if (exit_code != 0) {
             throw CLI::RuntimeError(exit_code);
@@ -49,82 +59,158 @@ void VerifyCommand::setup(CLI::App& app) {
 
 int VerifyCommand::execute() {
     try {
-        utils::Console::info(fmt::format("Verifying signature for: {}", file_path_));
-        utils::Console::info(fmt::format("Algorithm: {}", algorithm_));
-        
-        // Read file data
-        std::ifstream file(file_path_, std::ios::binary);
-        if (!file) {
-            utils::Console::error("Failed to open file");
-            return 1;
+        // Legacy forms: the last positional is the key, optionally after <file> <signature>
+        if (public_key_path_.empty()) {
+            if (files_.empty()) {
+                utils::Console::error("No public key given (use -k <key>)");
+                return 1;
+            }
+            public_key_path_ = files_.back();
+            files_.pop_back();
+            if (files_.size() == 2 && signature_path_.empty() && manifest_path_.empty()) {
+                signature_path_ = files_.back();
+                files_.pop_back();
+            }
         }
-        
-        file.seekg(0, std::ios::end);
-        size_t file_size = file.tellg();
-        file.seekg(0, std::ios::beg);
-        
-        std::vector<uint8_t> data(file_size);
-        file.read(reinterpret_cast<char*>(data.data()), file_size);
-        file.close();
-        
-        // Read signature
-        std::ifstream sig_file(signature_path_, std::ios::binary);
-        if (!sig_file) {
-            utils::Console::error("Failed to open signature file");
+        if (manifest_path_.empty() && files_.empty()) {
+            utils::Console::error("Nothing to verify: give files or -m <manifest>");
             return 1;
         }
-        
-        sig_file.seekg(0, std::ios::end);
-        size_t sig_size = sig_file.tellg();
-        sig_file.seekg(0, std::ios::beg);
-        
-        std::vector<uint8_t> signature(sig_size);
-        sig_file.read(reinterpret_cast<char*>(signature.data()), sig_size);
-        sig_file.close();
-        
-        // Read public key
-        std::ifstream key_file(public_key_path_, std::ios::binary);
-        if (!key_file) {
-            utils::Console::error("Failed to open public key file");
+        if (!signature_path_.empty() && files_.size() > 1) {
+            utils::Console::error("-s takes a single file; several files use <file>.sig");
             return 1;
         }
-        
-        key_file.seekg(0, std::ios::end);
-        size_t key_size = key_file.tellg();
-        key_file.seekg(0, std::ios::beg);
-        
-        std::vector<uint8_t> public_key(key_size);
-        key_file.read(reinterpret_cast<char*>(public_key.data()), key_size);
-        key_file.close();
-        
-        // Verify signature based on algorithm
-        bool valid = false;
-        
-        if (algorithm_ == "rsa") {
-            algorithms::asymmetric::RSA rsa;
-            valid = rsa.verify(data, signature, public_key);
-        } else if (algorithm_ == "ecc") {
-            utils::Console::error("ECC verification not yet implemented");
-            return 1;
-        } else if (algorithm_ == "ed25519") {
-            utils::Console::error("Ed25519 verification not yet implemented");
+
+        auto key_result = LoadedKey::load_file(public_key_path_);
+        if (!key_result) {
+            utils::Console::error(key_result.error_message);
             return 1;
         }
-        
-        if (valid) {
-            utils::Console::success("✓ Signature is VALID");
-            return 0;
-        } else {
-            utils::Console::error("✗ Signature is INVALID");
+        DigestSigner verifier(std::move(key_result.value));
+        if (!algorithm_.empty() && DigestSigner::parse_scheme(algorithm_) != verifier.scheme()) {
+            utils::Console::error(fmt::format("Key is {}, not {}",
+                                              DigestSigner::scheme_name(verifier.scheme()), algorithm_));
             return 1;
         }
-        
+
+        utils::Console::info(fmt::format("Algorithm: {}", DigestSigner::scheme_name(verifier.scheme())));
+        return manifest_path_.empty() ? verify_files(verifier) : verify_manifest(verifier);
+
     } catch (const std::exception& e) {
         utils::Console::error(fmt::format("Verification failed: {}", e.what()));
         return 1;
     }
 }
 
+int VerifyCommand::verify_files(const DigestSigner& verifier) {
+    auto start = std::chrono::steady_clock::now();
+    core::ThreadPool pool(threads_ == 0 ? 0 : std::min(threads_, files_.size()));
+
+    std::vector<std::future<bool>> tasks;
+    for (const auto& file : files_) {
+        auto sig_path = signature_path_.empty() ? file + ".sig" : signature_path_;
+        tasks.push_back(pool.submit([&verifier, file, sig_path]() {
+            auto signature = utils::FileIO::read_file(sig_path);
+            if (!signature) {
+                throw std::runtime_error(signature.error_message);
+            }
+            return verifier.verify(DigestSigner::digest_file(file), signature.value);
+        }));
+    }
+
+    size_t invalid = 0;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        bool valid = false;
+        try {
+            valid = tasks[i].get();
+        } catch (const std::exception& e) {
+            utils::Console::error(fmt::format("{}: {}", files_[i], e.what()));
+        }
+        invalid += valid ? 0 : 1;
+        if (files_.size() == 1) {
+            if (valid) {
+                utils::Console::success("✓ Signature is VALID");
+            } else {
+                utils::Console::error("✗ Signature is INVALID");
+            }
+        } else if (valid) {
+            fmt::print("{}: OK\n", files_[i]);
+        } else {
+            utils::Console::error(fmt::format("{}: INVALID", files_[i]));
+        }
+    }
+
+    if (files_.size() > 1) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        utils::Console::info(fmt::format("{} of {} signatures valid ({:.2f}s, {} threads)",
+                                         files_.size() - invalid, files_.size(), seconds, pool.size()));
+    }
+    return invalid == 0 ? 0 : 1;
+}
+
+int VerifyCommand::verify_manifest(const DigestSigner& verifier) {
+    auto manifest = utils::FileIO::read_file(manifest_path_);
+    auto sig_path = signature_path_.empty() ? manifest_path_ + ".sig" : signature_path_;
+    auto signature = utils::FileIO::read_file(sig_path);
+    if (!manifest || !signature) {
+        utils::Console::error(manifest ? signature.error_message : manifest.error_message);
+        return 1;
+    }
+
+    // Nothing in the manifest is trusted before its signature checks out
+    if (!verifier.verify(DigestSigner::digest(manifest.value), signature.value)) {
+        utils::Console::error(fmt::format("✗ Manifest signature is INVALID: {}", manifest_path_));
+        return 1;
+    }
+    utils::Console::success(fmt::format("✓ Manifest signature is VALID: {}", manifest_path_));
+
+    std::vector<std::pair<std::string, std::string>> entries;   // (expected hex, path)
+    std::istringstream lines(std::string(manifest.value.begin(), manifest.value.end()));
+    for (std::string line; std::getline(lines, line);) {
+        auto separator = line.find("  ");
+        if (separator == std::string::npos) {
+            utils::Console::error(fmt::format("Malformed manifest line: {}", line));
+            return 1;
+        }
+        entries.emplace_back(line.substr(0, separator), line.substr(separator + 2));
+    }
+    // Listed files only; an explicit file list narrows the check
+    if (!files_.empty()) {
+        std::erase_if(entries, [this](const auto& entry) {
+            return std::find(files_.begin(), files_.end(), entry.second) == files_.end();
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    core::ThreadPool pool(threads_ == 0 ? 0 : std::min(threads_, std::max<size_t>(entries.size(), 1)));
+    std::vector<std::future<std::string>> digests;
+    for (const auto& entry : entries) {
+        digests.push_back(pool.submit([path = entry.second]() {
+            return Botan::hex_encode(DigestSigner::digest_file(path), false);
+        }));
+    }
+
+    size_t failed = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const auto& [expected, path] = entries[i];
+        try {
+            if (digests[i].get() == expected) {
+                fmt::print("{}: OK\n", path);
+                continue;
+            }
+            utils::Console::error(fmt::format("{}: FAILED", path));
+        } catch (const std::exception& e) {
+            utils::Console::error(fmt::format("{}: {}", path, e.what()));
+        }
+        failed++;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    utils::Console::info(fmt::format("{} of {} files match ({:.2f}s, {} threads)",
+                                     entries.size() - failed, entries.size(), seconds, pool.size()));
+    return failed == 0 ? 0 : 1;
+}
+
 } // namespace commands
 } // namespace cli
 } // namespace filevault
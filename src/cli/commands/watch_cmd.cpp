@@ -0,0 +1,436 @@
+#include "filevault/cli/commands/watch_cmd.hpp"
+#include "filevault/archive/archive_format.hpp"
+#include "filevault/archive/directory_walker.hpp"
+#include "filevault/archive/sync_fingerprint.hpp"
+#include "filevault/compression/compressor.hpp"
+#include "filevault/core/cpu_features.hpp"
+#include "filevault/utils/config.hpp"
+#include "filevault/utils/console.hpp"
+#include "filevault/utils/crypto_utils.hpp"
+#include "filevault/utils/dir_watcher.hpp"
+#include "filevault/utils/file_io.hpp"
+#include "filevault/utils/password.hpp"
+#include <fmt/core.h>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <mutex>
+
+namespace filevault {
+namespace cli {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char* const STATE_FILE_NAME = ".filevault-watch";
+constexpr int STATE_VERSION = 1;
+
+// Files modified within this many seconds before a session started
+// watching may have changed in the same mtime tick, unseen
+constexpr int64_t MTIME_SLACK_SECONDS = 2;
+
+std::atomic<bool> stop_requested{false};
+
+void request_stop(int) {
+    stop_requested.store(true);
+}
+
+int64_t now_seconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // anonymous namespace
+
+WatchCommand::WatchCommand(core::CryptoEngine& engine)
+    : engine_(engine) {
+}
+
+void WatchCommand::setup(CLI::App& app) {
+    auto* cmd = app.add_subcommand(name(), description());
+
+    cmd->add_option("input", input_dir_, "Directory to watch")
+        ->required()
+        ->check(CLI::ExistingDirectory);
+
+    cmd->add_option("-o,--output", output_dir_, "Encrypted mirror of the directory (default: <input>.fvlt)");
+
+    cmd->add_option("-p,--password", password_, "Encryption password (not recommended)");
+
+    cmd->add_option("-a,--algorithm", algorithm_, "AEAD algorithm (default: configured or CPU-preferred)");
+
+    cmd->add_option("-s,--security", security_level_, "Security level")
+        ->check(CLI::IsMember({"weak", "medium", "strong", "paranoid"}));
+
+    cmd->add_option("-k,--kdf", kdf_, "Key derivation function")
+        ->check(CLI::IsMember({"argon2id", "argon2i", "pbkdf2-sha256", "pbkdf2-sha512", "scrypt"}));
+
+    cmd->add_option("--compression", compression_type_, "Compression algorithm")
+        ->check(CLI::IsMember({"none", "zlib", "bzip2", "lzma", "zstd", "lz4"}));
+
+    cmd->add_option("--compression-level", compression_level_, "Compression level (1-9)")
+        ->check(CLI::Range(1, 9));
+
+    cmd->add_option("-T,--threads", threads_, "Files encrypted in parallel (0 = one per core)");
+
+    cmd->add_option("--quiet-ms", quiet_ms_, "Encrypt a file once it has been unchanged this long (default 2000)");
+
+    cmd->add_option("--max-delay-ms", max_delay_ms_,
+                    "Encrypt a file that keeps changing at most this long after it first changed (default 60000)");
+
+    cmd->add_option("--poll-ms", poll_ms_, "Scan interval where the OS gives no change notifications (default 2000)");
+
+    cmd->add_option("--state", state_file_, "State file (default: <output>/.filevault-watch)");
+
+    cmd->add_flag("--once", once_, "Encrypt what changed since the last session and exit");
+
+    cmd->footer(
+        "\nExamples:\n"
+        "  Keep a mirror current:   filevault watch ~/Documents -o /backup/Documents.fvlt\n"
+        "  Catch up and exit:       filevault watch src/ -o enc/ --once\n"
+        "\n"
+        "Outputs carry the same fingerprints as 'encrypt -r --sync', so either\n"
+        "one continues where the other stopped. Deleted files keep their output.\n"
+    );
+
+    cmd->callback([this]() {
+        int exit_code = this->execute();
+        if (exit_code != 0) {
+            throw CLI::RuntimeError(exit_code);
+        }
+    });
+}
+
+bool WatchCommand::make_tree_file(const fs::path& source, core::TreeFile& file) const {
+    archive::FileEntry entry;
+    if (!archive::ArchiveFormat::stat_entry(source, entry)) {
+        return false;
+    }
+    file.source = source;
+    file.target = out_root_ / source.lexically_relative(root_);
+    file.target += ".fvlt";
+    file.size = entry.file_size;
+    file.modified_time = entry.modified_time;
+    return true;
+}
+
+bool WatchCommand::load_state(std::vector<uint8_t>& salt, int64_t& scanned,
+                              std::set<std::string>& pending) const {
+    auto data = utils::FileIO::read_file(state_file_);
+    if (!data) {
+        return false;
+    }
+    try {
+        auto state = nlohmann::json::parse(data.value.begin(), data.value.end());
+        if (state.value("version", 0) != STATE_VERSION) {
+            return false;
+        }
+        salt = utils::CryptoUtils::hex_decode(state.value("salt", std::string()));
+        scanned = state.value("scanned", int64_t(0));
+        for (const auto& path : state.value("pending", nlohmann::json::array())) {
+            pending.insert(path.get<std::string>());
+        }
+        return true;
+    } catch (const std::exception& e) {
+        utils::Console::warning(fmt::format("Ignoring unreadable state file {}: {}", state_file_, e.what()));
+        salt.clear();
+        scanned = 0;
+        pending.clear();
+        return false;
+    }
+}
+
+bool WatchCommand::save_state(const std::vector<uint8_t>& salt, int64_t scanned,
+                              const std::set<std::string>& pending) const {
+    nlohmann::json state = {
+        {"version", STATE_VERSION},
+        {"salt", utils::CryptoUtils::hex_encode(salt, false)},
+        {"scanned", scanned},
+        {"pending", pending},
+    };
+    auto text = state.dump(2) + "\n";
+    auto written = utils::FileIO::write_file(
+        state_file_, std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(text.data()), text.size()));
+    if (!written) {
+        utils::Console::warning(fmt::format("Cannot save state: {}", written.error_message));
+        return false;
+    }
+    return true;
+}
+
+WatchCommand::BatchResult WatchCommand::run_batch(std::vector<core::TreeFile> files,
+                                                  const core::StreamingConfig& base,
+                                                  const std::vector<uint8_t>& sync_key) {
+    BatchResult batch;
+    if (files.empty()) {
+        return batch;
+    }
+
+    core::TreeRunOptions options;
+    options.workers = threads_;
+    options.large_file_bytes = utils::Config::current().get_streaming_threshold_mb() * 1024 * 1024;
+
+    // Outputs whose fingerprint still matches (a save without changes,
+    // a file already caught up) are left alone
+    std::atomic<size_t> unchanged{0};
+    std::atomic<uint64_t> bytes{0};
+    std::mutex failed_mutex;
+    auto result = core::TreeRunner::run(files, [&](const core::TreeFile& file, size_t threads,
+                                                   const core::TreeRunner::Advance&) {
+        std::string error;
+        if (archive::SyncFingerprint::is_current(file, base.salt, sync_key)) {
+            unchanged++;
+            return error;
+        }
+        auto config = base;
+        config.worker_threads = threads;
+        config.salt = core::CryptoEngine::batch_file_salt(base.salt);
+        auto fingerprint = archive::SyncFingerprint::make(file, sync_key);
+        if (!fingerprint) {
+            error = "Failed to read the file";
+        } else {
+            config.fingerprint = std::move(*fingerprint);
+            auto encrypted = core::StreamingCrypto::encrypt_file(file.source.string(), file.target.string(),
+                                                                 password_, config);
+            if (encrypted.success) {
+                bytes += encrypted.bytes_processed;
+            } else {
+                error = encrypted.error_message;
+            }
+        }
+        if (!error.empty()) {
+            std::lock_guard<std::mutex> lock(failed_mutex);
+            batch.failed.push_back(file.source.lexically_relative(root_).generic_string());
+        }
+        return error;
+    }, options);
+
+    for (const auto& error : result.errors) {
+        utils::Console::error(error);
+    }
+    batch.unchanged = unchanged.load();
+    batch.encrypted = result.succeeded - batch.unchanged;
+    batch.bytes = bytes.load();
+    batch.seconds = result.seconds;
+    return batch;
+}
+
+int WatchCommand::execute() {
+    try {
+        root_ = fs::path(input_dir_).lexically_normal();
+        if (!root_.has_filename()) {
+            root_ = root_.parent_path();
+        }
+        out_root_ = output_dir_;
+        if (out_root_.empty()) {
+            if (root_.filename() == "." || root_.filename() == "..") {
+                utils::Console::error("Name an output directory for the encrypted mirror");
+                return 1;
+            }
+            out_root_ = root_.string() + ".fvlt";
+        }
+        auto inside = fs::weakly_canonical(out_root_).lexically_relative(fs::weakly_canonical(root_));
+        if (!inside.empty() && *inside.begin() != "..") {
+            utils::Console::error("Output directory must not be inside the watched directory");
+            return 1;
+        }
+        if (state_file_.empty()) {
+            state_file_ = (out_root_ / STATE_FILE_NAME).string();
+        }
+        if (quiet_ms_ > max_delay_ms_) {
+            utils::Console::error("--quiet-ms must not exceed --max-delay-ms");
+            return 1;
+        }
+
+        // Streaming settings, as 'encrypt -r' makes them
+        const auto& user_config = utils::Config::current();
+        if (algorithm_.empty()) {
+            auto configured = user_config.get_default_algorithm();
+            algorithm_ = configured != "auto" && engine_.parse_algorithm(configured)
+                ? configured
+                : engine_.algorithm_name(core::CpuFeatures::detect().preferred_aead());
+        }
+        auto algorithm = engine_.parse_algorithm(algorithm_);
+        auto kdf = engine_.parse_kdf(kdf_);
+        auto level = engine_.parse_security_level(security_level_);
+        if (!algorithm || !kdf || !level) {
+            utils::Console::error("Invalid configuration parameters");
+            return 1;
+        }
+        if (!core::StreamingCrypto::supports_algorithm(*algorithm)) {
+            utils::Console::error(fmt::format("Streaming supports AEAD algorithms only, not {}", algorithm_));
+            return 1;
+        }
+        if (threads_ == 0) {
+            threads_ = user_config.get_threads();
+        }
+        core::StreamingConfig base;
+        base.chunk_size = user_config.get_streaming_chunk_mb() * 1024 * 1024;
+        base.algorithm = *algorithm;
+        base.kdf = *kdf;
+        base.level = *level;
+        base.compression = compression::CompressionService::parse_algorithm(compression_type_);
+        base.compression_level = compression_level_;
+        base.io_buffers = user_config.get_streaming_io_buffers();
+
+        if (password_.empty()) {
+            password_ = utils::Password::read_secure("Enter encryption password: ", true);
+        } else {
+            utils::Console::warning("Using password from command line is insecure!");
+        }
+        if (password_.empty()) {
+            utils::Console::error("Password cannot be empty");
+            return 1;
+        }
+
+        fs::create_directories(out_root_);
+        std::vector<uint8_t> salt;
+        int64_t scanned = 0;
+        std::set<std::string> pending;
+        load_state(salt, scanned, pending);
+
+        // One batch salt for the mirror, kept across sessions; the password
+        // is stretched once here, every batch finds the master key in
+        // KeyCache, and each file gets a subkey from its own salt
+        if (salt.size() != core::CryptoEngine::BATCH_SALT_SIZE) {
+            salt = core::CryptoEngine::generate_salt(core::CryptoEngine::BATCH_SALT_SIZE);
+            scanned = 0;
+        }
+        base.salt = salt;
+        core::EncryptionConfig key_config;
+        key_config.algorithm = base.algorithm;
+        key_config.kdf = base.kdf;
+        key_config.level = base.level;
+        key_config.apply_security_level();
+        auto sync_key = archive::SyncFingerprint::derive_key(engine_.derive_key(password_, base.salt, key_config));
+
+        // Watch before catching up, so nothing changes unseen in between
+        utils::DirectoryWatcher watcher(root_, std::chrono::milliseconds(poll_ms_));
+        if (auto started = watcher.start(); !started) {
+            utils::Console::error(started.error_message);
+            return 1;
+        }
+        int64_t session_start = now_seconds();
+
+        utils::Console::info(fmt::format("Watching:  {} ({})", root_.string(),
+                                         watcher.native() ? "change notifications" : "polling"));
+        utils::Console::info(fmt::format("Output:    {}", out_root_.string()));
+        utils::Console::info(fmt::format("Algorithm: {}", algorithm_));
+        utils::Console::separator();
+
+        auto update_pending = [&](const std::vector<core::TreeFile>& files, const BatchResult& batch) {
+            for (const auto& file : files) {
+                pending.erase(file.source.lexically_relative(root_).generic_string());
+            }
+            pending.insert(batch.failed.begin(), batch.failed.end());
+        };
+        auto report = [](const BatchResult& batch) {
+            utils::Console::info(fmt::format("Encrypted {} files ({}) in {:.2f} s, {} unchanged{}",
+                                             batch.encrypted, utils::CryptoUtils::format_bytes(batch.bytes),
+                                             batch.seconds, batch.unchanged,
+                                             batch.failed.empty() ? std::string()
+                                                 : fmt::format(", {} failed", batch.failed.size())));
+        };
+
+        // Catch up: files left pending, modified since the last session
+        // started watching, or without an output
+        auto catch_up = [&](bool everything) {
+            auto walk = archive::DirectoryWalker::walk({root_});
+            for (const auto& error : walk.errors) {
+                utils::Console::warning("Skipped " + error);
+            }
+            std::vector<core::TreeFile> files;
+            for (const auto& member : walk.members) {
+                core::TreeFile file;
+                file.source = member.source;
+                file.target = out_root_ / member.source.lexically_relative(root_);
+                file.target += ".fvlt";
+                file.size = member.entry.file_size;
+                file.modified_time = member.entry.modified_time;
+                auto relative = member.source.lexically_relative(root_).generic_string();
+                if (everything || pending.count(relative) ||
+                    static_cast<int64_t>(file.modified_time) + MTIME_SLACK_SECONDS >= scanned ||
+                    !fs::exists(file.target)) {
+                    files.push_back(std::move(file));
+                }
+            }
+            auto batch = run_batch(files, base, sync_key);
+            update_pending(files, batch);
+            report(batch);
+            return batch;
+        };
+
+        auto first = catch_up(scanned == 0);
+        save_state(salt, session_start, pending);
+        if (once_) {
+            return first.failed.empty() ? 0 : 1;
+        }
+
+        stop_requested = false;
+        std::signal(SIGINT, request_stop);
+        std::signal(SIGTERM, request_stop);
+
+        utils::ChangeDebouncer debouncer{std::chrono::milliseconds(quiet_ms_),
+                                         std::chrono::milliseconds(max_delay_ms_)};
+        fs::path state_path = fs::absolute(state_file_);
+        while (!stop_requested) {
+            auto timeout = std::chrono::milliseconds(-1);
+            if (auto deadline = debouncer.next_deadline()) {
+                timeout = (std::max)(std::chrono::milliseconds(0),
+                                     std::chrono::duration_cast<std::chrono::milliseconds>(
+                                         *deadline - utils::ChangeDebouncer::Clock::now()));
+            }
+            auto events = watcher.wait(timeout, stop_requested);
+            auto now = utils::ChangeDebouncer::Clock::now();
+            for (const auto& path : events.changed) {
+                if (fs::absolute(path) != state_path) {
+                    debouncer.touch(path, now);
+                }
+            }
+
+            if (events.overflow) {
+                // Notifications were dropped: every output is checked again
+                utils::Console::warning("Change notifications overflowed; rescanning");
+                debouncer.take_all();
+                catch_up(true);
+                save_state(salt, session_start, pending);
+                continue;
+            }
+
+            std::vector<core::TreeFile> files;
+            for (const auto& path : debouncer.take_ready(now)) {
+                core::TreeFile file;
+                if (make_tree_file(path, file)) {
+                    files.push_back(std::move(file));
+                }
+            }
+            if (files.empty()) {
+                continue;
+            }
+            auto batch = run_batch(files, base, sync_key);
+            update_pending(files, batch);
+            report(batch);
+            save_state(salt, session_start, pending);
+        }
+
+        // Changes still settling are done at the next start
+        for (const auto& path : debouncer.take_all()) {
+            pending.insert(path.lexically_relative(root_).generic_string());
+        }
+        save_state(salt, session_start, pending);
+        std::signal(SIGINT, SIG_DFL);
+        std::signal(SIGTERM, SIG_DFL);
+        utils::Console::success(fmt::format("Stopped watching; {} files pending", pending.size()));
+        return 0;
+
+    } catch (const std::exception& e) {
+        utils::Console::error(fmt::format("Watch failed: {}", e.what()));
+        return 1;
+    }
+}
+
+} // namespace cli
+} // namespace filevault
@@ -0,0 +1,52 @@
+/**
+ * @file adaptive_level.cpp
+ * @brief Compression level controller driven by write-queue occupancy
+ */
+
+#include "filevault/compression/adaptive_level.hpp"
+#include <algorithm>
+
+namespace filevault {
+namespace compression {
+
+namespace {
+
+// Weight of the newest observation in the smoothed occupancy
+constexpr double SMOOTHING = 0.3;
+
+} // anonymous namespace
+
+AdaptiveLevel::AdaptiveLevel(int min_level, int max_level, int start)
+    : min_level_((std::min)(min_level, max_level)),
+      max_level_((std::max)(min_level, max_level)),
+      level_(std::clamp(start, min_level_, max_level_)) {}
+
+int AdaptiveLevel::observe(size_t ready, size_t in_flight) {
+    int current = level();
+    if (in_flight == 0) {
+        return current;
+    }
+    double share = static_cast<double>((std::min)(ready, in_flight)) / static_cast<double>(in_flight);
+    occupancy_ += SMOOTHING * (share - occupancy_);
+
+    // Chunks already in flight were compressed at the old level
+    if (++since_change_ < in_flight) {
+        return current;
+    }
+
+    int next = current;
+    if (occupancy_ > RAISE_ABOVE && current < max_level_) {
+        next = current + 1;
+    } else if (occupancy_ < LOWER_BELOW && current > min_level_) {
+        next = current - 1;
+    }
+    if (next != current) {
+        level_.store(next, std::memory_order_relaxed);
+        occupancy_ = 0.5;
+        since_change_ = 0;
+    }
+    return next;
+}
+
+} // namespace compression
+} // namespace filevault
@@ -1,9 +1,22 @@
 #include "filevault/compression/compressor.hpp"
+#include "filevault/core/buffer_pool.hpp"
+#include "filevault/core/thread_pool.hpp"
+#include "filevault/utils/trace.hpp"
 #include <zlib.h>
 #include <libbz3.h>  // BZIP3 API
 #include <lzma.h>
+#include <zstd.h>
+#include <zstd_errors.h>
+#include <lz4frame.h>
+#include <zdict.h>
 #include <algorithm>
+#include <array>
 #include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <optional>
 #include <stdexcept>
 #include <fmt/core.h>
 
@@ -22,6 +35,10 @@ std::unique_ptr<ICompressor> CompressionService::create(core::CompressionType ty
             return std::make_unique<Bzip2Compressor>();  // Using BZIP3 API
         case core::CompressionType::LZMA:
             return std::make_unique<LzmaCompressor>();
+        case core::CompressionType::ZSTD:
+            return std::make_unique<ZstdCompressor>();
+        case core::CompressionType::LZ4:
+            return std::make_unique<Lz4Compressor>();
         case core::CompressionType::NONE:
             throw std::invalid_argument("Cannot create compressor for NONE type");
         default:
@@ -35,6 +52,8 @@ std::string CompressionService::get_algorithm_name(core::CompressionType type) {
         case core::CompressionType::ZLIB: return "zlib";
         case core::CompressionType::BZIP2: return "bzip2";
         case core::CompressionType::LZMA: return "lzma";
+        case core::CompressionType::ZSTD: return "zstd";
+        case core::CompressionType::LZ4: return "lz4";
         default: return "unknown";
     }
 }
@@ -44,18 +63,490 @@ core::CompressionType CompressionService::parse_algorithm(const std::string& nam
     if (name == "zlib") return core::CompressionType::ZLIB;
     if (name == "bzip2" || name == "bz2") return core::CompressionType::BZIP2;
     if (name == "lzma" || name == "xz") return core::CompressionType::LZMA;
+    if (name == "zstd" || name == "zst") return core::CompressionType::ZSTD;
+    if (name == "lz4") return core::CompressionType::LZ4;
     
     throw std::invalid_argument("Unknown compression algorithm: " + name);
 }
 
+std::optional<core::CompressionType> CompressionService::detect(std::span<const uint8_t> data) {
+    auto starts_with = [&](std::initializer_list<uint8_t> magic) {
+        return data.size() >= magic.size() && std::equal(magic.begin(), magic.end(), data.begin());
+    };
+    
+    if (starts_with({0x28, 0xB5, 0x2F, 0xFD})) return core::CompressionType::ZSTD;
+    if (starts_with({0x04, 0x22, 0x4D, 0x18})) return core::CompressionType::LZ4;
+    if (starts_with({0xFD, '7', 'z', 'X', 'Z', 0x00})) return core::CompressionType::LZMA;
+    if (starts_with({'B', 'Z', '3', 'v', '1'})) return core::CompressionType::BZIP2;
+    
+    // zlib: deflate with a 32 KB window and a valid header check
+    if (data.size() >= 2 && data[0] == 0x78 && ((data[0] << 8) | data[1]) % 31 == 0) {
+        return core::CompressionType::ZLIB;
+    }
+    return std::nullopt;
+}
+
+// Entropy sampling: window count and size, and the "looks random" threshold
+static constexpr size_t ENTROPY_WINDOWS = 16;
+static constexpr size_t ENTROPY_WINDOW_SIZE = 4096;
+static constexpr size_t ENTROPY_MIN_INPUT = 1024;
+static constexpr double INCOMPRESSIBLE_ENTROPY = 7.9;
+
+double CompressionService::sample_entropy(std::span<const uint8_t> data) {
+    if (data.empty()) {
+        return 0.0;
+    }
+    
+    std::array<uint32_t, 256> counts{};
+    size_t sampled = 0;
+    auto count = [&](std::span<const uint8_t> window) {
+        for (uint8_t byte : window) {
+            ++counts[byte];
+        }
+        sampled += window.size();
+    };
+    
+    if (data.size() <= ENTROPY_WINDOWS * ENTROPY_WINDOW_SIZE) {
+        count(data);
+    } else {
+        size_t stride = (data.size() - ENTROPY_WINDOW_SIZE) / (ENTROPY_WINDOWS - 1);
+        for (size_t i = 0; i < ENTROPY_WINDOWS; ++i) {
+            count(data.subspan(i * stride, ENTROPY_WINDOW_SIZE));
+        }
+    }
+    
+    double entropy = 0.0;
+    for (uint32_t c : counts) {
+        if (c > 0) {
+            double p = static_cast<double>(c) / sampled;
+            entropy -= p * std::log2(p);
+        }
+    }
+    return entropy;
+}
+
+bool CompressionService::likely_incompressible(std::span<const uint8_t> data) {
+    return data.size() >= ENTROPY_MIN_INPUT && sample_entropy(data) >= INCOMPRESSIBLE_ENTROPY;
+}
+
+core::Result<std::vector<uint8_t>> CompressionService::train_dictionary(
+    const std::vector<std::vector<uint8_t>>& samples,
+    size_t max_size
+) {
+    // ZDICT takes the samples concatenated, with a size list
+    std::vector<uint8_t> joined;
+    std::vector<size_t> sizes;
+    sizes.reserve(samples.size());
+    for (const auto& sample : samples) {
+        if (!sample.empty()) {
+            joined.insert(joined.end(), sample.begin(), sample.end());
+            sizes.push_back(sample.size());
+        }
+    }
+    if (sizes.empty()) {
+        return core::Result<std::vector<uint8_t>>::error("No samples to train a dictionary from");
+    }
+    
+    std::vector<uint8_t> dictionary(max_size);
+    size_t ret = ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(), joined.data(),
+                                       sizes.data(), static_cast<unsigned>(sizes.size()));
+    if (ZDICT_isError(ret)) {
+        return core::Result<std::vector<uint8_t>>::error(
+            fmt::format("Dictionary training failed: {} (too few or too small samples?)",
+                        ZDICT_getErrorName(ret)));
+    }
+    dictionary.resize(ret);
+    return core::Result<std::vector<uint8_t>>::ok(std::move(dictionary));
+}
+
+uint32_t CompressionService::dictionary_id(std::span<const uint8_t> dictionary) {
+    return dictionary.empty() ? 0 : ZDICT_getDictID(dictionary.data(), dictionary.size());
+}
+
+// Input is read this much at a time by process_file()
+static constexpr size_t FILE_CHUNK_SIZE = 1024 * 1024;
+
+core::Result<uint64_t> CompressionService::process_file(
+    ICompressor& compressor,
+    StreamMode mode,
+    const std::string& input_path,
+    const std::string& output_path,
+    int level)
+{
+    std::error_code ec;
+    auto input_size = std::filesystem::file_size(input_path, ec);
+    std::ifstream in(input_path, std::ios::binary);
+    if (ec || !in) {
+        return core::Result<uint64_t>::error("Cannot open input file: " + input_path);
+    }
+    std::ofstream out(output_path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return core::Result<uint64_t>::error("Cannot create output file: " + output_path);
+    }
+    
+    // Don't leave a partial output file behind
+    auto fail = [&](const std::string& message) {
+        out.close();
+        std::error_code remove_ec;
+        std::filesystem::remove(output_path, remove_ec);
+        return core::Result<uint64_t>::error(message);
+    };
+    
+    if (!compressor.begin(mode, level, input_size)) {
+        return fail(compressor.stream_error());
+    }
+    
+    std::vector<uint8_t> chunk(FILE_CHUNK_SIZE);
+    std::vector<uint8_t> produced;
+    uint64_t written = 0;
+    
+    auto flush = [&]() {
+        out.write(reinterpret_cast<const char*>(produced.data()), static_cast<std::streamsize>(produced.size()));
+        written += produced.size();
+        produced.clear();
+        return static_cast<bool>(out);
+    };
+    
+    while (in) {
+        in.read(reinterpret_cast<char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+        auto n = static_cast<size_t>(in.gcount());
+        if (n == 0) {
+            break;
+        }
+        if (!compressor.update(std::span<const uint8_t>(chunk.data(), n), produced)) {
+            return fail(compressor.stream_error());
+        }
+        if (!flush()) {
+            return fail("Failed to write output file: " + output_path);
+        }
+    }
+    if (in.bad()) {
+        return fail("Failed to read input file: " + input_path);
+    }
+    
+    if (!compressor.finish(produced)) {
+        return fail(compressor.stream_error());
+    }
+    if (!flush()) {
+        return fail("Failed to write output file: " + output_path);
+    }
+    return core::Result<uint64_t>::ok(written);
+}
+
+// ============================================================================
+// ICompressor
+// ============================================================================
+
+size_t ICompressor::worker_count() const {
+    return threads_ == 0 ? core::ThreadPool::default_thread_count() : threads_;
+}
+
+/**
+ * @brief Pool with exactly threads workers, (re)created on demand
+ */
+static core::ThreadPool& pool_for(std::unique_ptr<core::ThreadPool>& pool, size_t threads) {
+    if (!pool || pool->size() != threads) {
+        pool.reset();
+        pool = std::make_unique<core::ThreadPool>(threads);
+    }
+    return *pool;
+}
+
 // ============================================================================
 // ZlibCompressor
 // ============================================================================
 
+// zlib counts bytes in uInt; larger buffers are fed in pieces
+static constexpr size_t ZLIB_MAX_STEP = static_cast<uInt>(-1);
+
+// Output is grown by this much at a time while streaming
+static constexpr size_t STREAM_OUTPUT_STEP = 64 * 1024;
+
+// Parallel deflate: block size and the history each block is primed with
+static constexpr size_t ZLIB_PARALLEL_BLOCK = 1024 * 1024;
+static constexpr size_t ZLIB_WINDOW_SIZE = 32 * 1024;
+
+/**
+ * @brief One block of a parallel deflate stream
+ */
+struct DeflatedBlock {
+    int status = Z_OK;
+    std::vector<uint8_t> data;
+    uLong adler = 0;            // Adler-32 of the block's input
+    size_t length = 0;
+};
+
+/**
+ * @brief Raw-deflate one block, primed with the preceding window
+ *
+ * Non-final blocks end with a sync flush so they land on a byte boundary
+ * and the next block's output can simply be appended.
+ */
+static DeflatedBlock deflate_block(std::span<const uint8_t> dictionary,
+                                   std::span<const uint8_t> block, int level, bool last) {
+    DeflatedBlock out;
+    out.length = block.size();
+    out.adler = adler32(adler32(0L, Z_NULL, 0), block.data(), static_cast<uInt>(block.size()));
+    
+    z_stream strm{};
+    out.status = deflateInit2(&strm, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    if (out.status != Z_OK) {
+        return out;
+    }
+    if (!dictionary.empty()) {
+        deflateSetDictionary(&strm, dictionary.data(), static_cast<uInt>(dictionary.size()));
+    }
+    
+    out.data.resize(deflateBound(&strm, block.size()) + 16);
+    strm.next_in = const_cast<Bytef*>(block.data());
+    strm.avail_in = static_cast<uInt>(block.size());
+    strm.next_out = out.data.data();
+    strm.avail_out = static_cast<uInt>(out.data.size());
+    
+    int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+    int ret = deflate(&strm, flush);
+    while (ret == Z_OK && strm.avail_out == 0) {
+        size_t used = out.data.size();
+        out.data.resize(used + STREAM_OUTPUT_STEP);
+        strm.next_out = out.data.data() + used;
+        strm.avail_out = static_cast<uInt>(STREAM_OUTPUT_STEP);
+        ret = deflate(&strm, flush);
+    }
+    out.data.resize(out.data.size() - strm.avail_out);
+    deflateEnd(&strm);
+    
+    bool done = last ? ret == Z_STREAM_END : (ret == Z_OK && strm.avail_in == 0);
+    out.status = done ? Z_OK : (ret == Z_OK ? Z_BUF_ERROR : ret);
+    return out;
+}
+
+/**
+ * @brief Deflate data as ZLIB_PARALLEL_BLOCK blocks on the pool
+ * @param history Input preceding data (its last 32 KB primes the first block)
+ * @param last Whether data ends the stream (the final block gets Z_FINISH)
+ * @param adler Running Adler-32, combined with each block's in order
+ * @return Z_OK or the first block's error
+ */
+static int deflate_parallel(core::ThreadPool& pool, std::span<const uint8_t> history,
+                            std::span<const uint8_t> data, int level, bool last,
+                            std::vector<uint8_t>& output, uLong& adler) {
+    size_t blocks = (data.size() + ZLIB_PARALLEL_BLOCK - 1) / ZLIB_PARALLEL_BLOCK;
+    if (blocks == 0 && last) {
+        blocks = 1;  // The stream still needs its final (empty) block
+    }
+    if (history.size() > ZLIB_WINDOW_SIZE) {
+        history = history.last(ZLIB_WINDOW_SIZE);
+    }
+    
+    std::vector<std::future<DeflatedBlock>> futures;
+    futures.reserve(blocks);
+    for (size_t i = 0; i < blocks; ++i) {
+        size_t offset = i * ZLIB_PARALLEL_BLOCK;
+        auto block = data.subspan(offset, std::min(ZLIB_PARALLEL_BLOCK, data.size() - offset));
+        auto dictionary = (i == 0) ? history
+            : data.subspan(offset - ZLIB_WINDOW_SIZE, ZLIB_WINDOW_SIZE);
+        bool final_block = last && i + 1 == blocks;
+        futures.push_back(pool.submit([=]() {
+            return deflate_block(dictionary, block, level, final_block);
+        }));
+    }
+    
+    // Collect every future even after a failure; the tasks reference data
+    int status = Z_OK;
+    for (auto& future : futures) {
+        auto block = future.get();
+        if (status != Z_OK) {
+            continue;
+        }
+        if (block.status != Z_OK) {
+            status = block.status;
+            continue;
+        }
+        output.insert(output.end(), block.data.begin(), block.data.end());
+        adler = adler32_combine(adler, block.adler, static_cast<z_off_t>(block.length));
+    }
+    return status;
+}
+
+/**
+ * @brief zlib stream header for a level (as deflateInit writes it)
+ */
+static void append_zlib_header(std::vector<uint8_t>& out, int level) {
+    unsigned cmf = 0x78;  // Deflate, 32 KB window
+    unsigned flevel = level == 1 ? 0 : (level < 6 ? 1 : (level == 6 ? 2 : 3));
+    unsigned flg = flevel << 6;
+    flg += 31 - ((cmf << 8) + flg) % 31;
+    out.push_back(static_cast<uint8_t>(cmf));
+    out.push_back(static_cast<uint8_t>(flg));
+}
+
+static void append_be32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 3; i >= 0; --i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+struct ZlibCompressor::Streams {
+    z_stream deflate_stream{};
+    z_stream inflate_stream{};
+    bool deflate_ready = false;
+    bool inflate_ready = false;
+    int deflate_level = 0;
+    
+    // Incremental stream in progress
+    bool active = false;
+    bool ended = false;
+    StreamMode mode = StreamMode::COMPRESS;
+    
+    // Parallel compression: input not yet deflated, the 32 KB before it
+    std::unique_ptr<core::ThreadPool> pool;
+    bool parallel = false;
+    bool header_written = false;
+    int parallel_level = 6;
+    uLong adler = 1;
+    std::vector<uint8_t> pending;
+    std::vector<uint8_t> window;
+    
+    /**
+     * @brief Reset (or create) the deflate stream for a level
+     */
+    int prepare_deflate(int level) {
+        active = false;
+        if (deflate_ready && deflate_level == level) {
+            return deflateReset(&deflate_stream);
+        }
+        if (deflate_ready) {
+            deflateEnd(&deflate_stream);
+            deflate_ready = false;
+        }
+        deflate_stream = z_stream{};
+        int ret = deflateInit(&deflate_stream, level);
+        deflate_ready = (ret == Z_OK);
+        deflate_level = level;
+        return ret;
+    }
+    
+    /**
+     * @brief prepare_deflate(), then prime the stream with a dictionary
+     */
+    int prepare_deflate(int level, std::span<const uint8_t> dictionary) {
+        int ret = prepare_deflate(level);
+        if (ret == Z_OK && !dictionary.empty()) {
+            ret = deflateSetDictionary(&deflate_stream, dictionary.data(),
+                                       static_cast<uInt>(dictionary.size()));
+        }
+        return ret;
+    }
+    
+    /**
+     * @brief Reset (or create) the inflate stream
+     */
+    int prepare_inflate() {
+        active = false;
+        if (inflate_ready) {
+            return inflateReset(&inflate_stream);
+        }
+        inflate_stream = z_stream{};
+        int ret = inflateInit(&inflate_stream);
+        inflate_ready = (ret == Z_OK);
+        return ret;
+    }
+};
+
+/**
+ * @brief inflate(), supplying the preset dictionary if the stream asks for one
+ *
+ * Returns Z_NEED_DICT if there is none, and Z_DATA_ERROR if the stream
+ * was compressed with a different one.
+ */
+static int inflate_with(z_stream& strm, std::span<const uint8_t> dictionary) {
+    int ret = inflate(&strm, Z_NO_FLUSH);
+    if (ret == Z_NEED_DICT && !dictionary.empty()) {
+        ret = inflateSetDictionary(&strm, dictionary.data(), static_cast<uInt>(dictionary.size()));
+        if (ret == Z_OK) {
+            ret = inflate(&strm, Z_NO_FLUSH);
+        }
+    }
+    return ret;
+}
+
+/**
+ * @brief Describe a zlib error code
+ */
+static std::string zlib_error(const char* operation, int ret) {
+    if (ret == Z_NEED_DICT) {
+        return fmt::format("zlib {} failed: data was compressed with a dictionary", operation);
+    }
+    return fmt::format("zlib {} failed: error {}", operation, ret);
+}
+
+/**
+ * @brief Run deflate/inflate over input, appending everything produced
+ * @return Z_OK once the input is consumed, Z_STREAM_END, or an error
+ */
+static int zlib_pump(z_stream& strm, StreamMode mode, std::span<const uint8_t> input,
+                     std::vector<uint8_t>& output, int flush,
+                     std::span<const uint8_t> dictionary = {}) {
+    const uint8_t* in = input.data();
+    size_t in_left = input.size();
+    strm.avail_in = 0;
+    
+    while (true) {
+        if (strm.avail_in == 0 && in_left > 0) {
+            strm.next_in = const_cast<Bytef*>(in);
+            strm.avail_in = static_cast<uInt>((std::min)(in_left, ZLIB_MAX_STEP));
+            in += strm.avail_in;
+            in_left -= strm.avail_in;
+        }
+        
+        size_t used = output.size();
+        output.resize(used + STREAM_OUTPUT_STEP);
+        strm.next_out = output.data() + used;
+        strm.avail_out = static_cast<uInt>(STREAM_OUTPUT_STEP);
+        
+        int ret = (mode == StreamMode::COMPRESS)
+            ? deflate(&strm, in_left > 0 ? Z_NO_FLUSH : flush)
+            : inflate_with(strm, dictionary);
+        output.resize(used + STREAM_OUTPUT_STEP - strm.avail_out);
+        
+        if (ret == Z_STREAM_END) {
+            return ret;
+        }
+        bool consumed = (strm.avail_in == 0 && in_left == 0);
+        if (ret == Z_BUF_ERROR && consumed) {
+            return Z_OK;  // Nothing left to do until more input arrives
+        }
+        if (ret != Z_OK) {
+            return ret;
+        }
+        if (consumed && strm.avail_out > 0 && flush != Z_FINISH) {
+            return Z_OK;
+        }
+    }
+}
+
+ZlibCompressor::ZlibCompressor() : streams_(std::make_unique<Streams>()) {}
+
+ZlibCompressor::~ZlibCompressor() {
+    if (streams_->deflate_ready) {
+        deflateEnd(&streams_->deflate_stream);
+    }
+    if (streams_->inflate_ready) {
+        inflateEnd(&streams_->inflate_stream);
+    }
+}
+
+bool ZlibCompressor::set_dictionary(std::span<const uint8_t> dictionary) {
+    streams_->active = false;
+    dictionary_.assign(dictionary.begin(), dictionary.end());
+    return true;
+}
+
 CompressionResult ZlibCompressor::compress(
     std::span<const uint8_t> input,
     int level
 ) {
+    utils::ScopedSpan trace_span("ZlibCompressor::compress", "compression", input.size());
     CompressionResult result;
     auto start = std::chrono::high_resolution_clock::now();
     
@@ -63,32 +554,1608 @@ CompressionResult ZlibCompressor::compress(
         // Clamp level to valid range
         level = std::clamp(level, 1, 9);
         
+        size_t workers = worker_count();
+        if (workers > 1 && input.size() > ZLIB_PARALLEL_BLOCK && dictionary_.empty()) {
+            streams_->active = false;
+            result.data = core::BufferPool::shared().acquire(compressBound(input.size()));
+            append_zlib_header(result.data, level);
+            uLong adler = adler32(0L, Z_NULL, 0);
+            int ret = deflate_parallel(pool_for(streams_->pool, workers), {}, input, level, true,
+                                       result.data, adler);
+            if (ret != Z_OK) {
+                result.success = false;
+                result.error_message = fmt::format("zlib compression failed: error {}", ret);
+                return result;
+            }
+            append_be32(result.data, static_cast<uint32_t>(adler));
+            
+            result.success = true;
+            result.original_size = input.size();
+            result.compressed_size = result.data.size();
+            result.compression_ratio = 100.0 * (1.0 - static_cast<double>(result.data.size()) / input.size());
+            
+            auto end = std::chrono::high_resolution_clock::now();
+            result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+            return result;
+        }
+        
+        // Reuse the deflate state; a level change needs a fresh stream
+        z_stream& strm = streams_->deflate_stream;
+        int ret = streams_->prepare_deflate(level, dictionary_);
+        
+        if (ret != Z_OK) {
+            result.success = false;
+            result.error_message = fmt::format("zlib compression failed: error {}", ret);
+            return result;
+        }
+        
         // Allocate output buffer (worst case: original size + 0.1% + 12 bytes)
-        uLongf dest_len = compressBound(input.size());
+        size_t dest_len = compressBound(input.size());
+        result.data = core::BufferPool::shared().acquire(dest_len);
+        result.data.resize(dest_len);
+        
+        // Compress (same stream layout as compress2)
+        size_t in_left = input.size();
+        size_t out_left = dest_len;
+        strm.next_in = const_cast<Bytef*>(input.data());
+        strm.avail_in = 0;
+        strm.next_out = result.data.data();
+        strm.avail_out = 0;
+        
+        do {
+            if (strm.avail_out == 0) {
+                strm.avail_out = static_cast<uInt>((std::min)(out_left, ZLIB_MAX_STEP));
+                out_left -= strm.avail_out;
+            }
+            if (strm.avail_in == 0) {
+                strm.avail_in = static_cast<uInt>((std::min)(in_left, ZLIB_MAX_STEP));
+                in_left -= strm.avail_in;
+            }
+            ret = deflate(&strm, in_left > 0 ? Z_NO_FLUSH : Z_FINISH);
+        } while (ret == Z_OK);
+        
+        if (ret != Z_STREAM_END) {
+            result.success = false;
+            result.error_message = fmt::format("zlib compression failed: error {}", ret);
+            return result;
+        }
+        
+        // Resize to actual size
+        dest_len = static_cast<size_t>(strm.next_out - result.data.data());
+        result.data.resize(dest_len);
+        
+        result.success = true;
+        result.original_size = input.size();
+        result.compressed_size = dest_len;
+        result.compression_ratio = 100.0 * (1.0 - static_cast<double>(dest_len) / input.size());
+        
+    } catch (const std::exception& e) {
+        result.success = false;
+        result.error_message = e.what();
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    
+    return result;
+}
+
+CompressionResult ZlibCompressor::decompress(std::span<const uint8_t> input) {
+    utils::ScopedSpan trace_span("ZlibCompressor::decompress", "compression", input.size());
+    CompressionResult result;
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    try {
+        // Reuse the inflate state
+        z_stream& strm = streams_->inflate_stream;
+        int ret = streams_->prepare_inflate();
+        
+        if (ret != Z_OK) {
+            result.success = false;
+            result.error_message = fmt::format("zlib decompression failed: error {}", ret);
+            return result;
+        }
+        
+        // Start with 4x size, grow if needed
+        size_t dest_len = (std::max)(input.size() * 4, size_t(64));
+        result.data = core::BufferPool::shared().acquire(dest_len);
+        result.data.resize(dest_len);
+        
+        size_t in_left = input.size();
+        size_t out_left = dest_len;
+        strm.next_in = const_cast<Bytef*>(input.data());
+        strm.avail_in = 0;
+        strm.next_out = result.data.data();
+        strm.avail_out = 0;
+        int attempts = 0;
+        
+        // Decompress, growing the buffer if needed (at most 10 doublings)
+        while (true) {
+            if (strm.avail_out == 0 && out_left == 0) {
+                if (++attempts > 10) {
+                    ret = Z_BUF_ERROR;
+                    break;
+                }
+                size_t used = result.data.size();
+                result.data.resize(used * 2);
+                strm.next_out = result.data.data() + used;
+                out_left = used;
+            }
+            if (strm.avail_out == 0) {
+                strm.avail_out = static_cast<uInt>((std::min)(out_left, ZLIB_MAX_STEP));
+                out_left -= strm.avail_out;
+            }
+            if (strm.avail_in == 0) {
+                strm.avail_in = static_cast<uInt>((std::min)(in_left, ZLIB_MAX_STEP));
+                in_left -= strm.avail_in;
+            }
+            
+            ret = inflate_with(strm, dictionary_);
+            if (ret == Z_STREAM_END) {
+                break;
+            }
+            if (ret == Z_BUF_ERROR) {
+                // Out of output space: grow on the next pass.
+                // Otherwise the input ran out before the end of the stream.
+                if (strm.avail_out > 0 && strm.avail_in == 0 && in_left == 0) {
+                    break;
+                }
+            } else if (ret != Z_OK) {
+                break;
+            }
+        }
+        
+        if (ret != Z_STREAM_END) {
+            result.success = false;
+            result.error_message = zlib_error("decompression", ret);
+            return result;
+        }
+        
+        dest_len = static_cast<size_t>(strm.next_out - result.data.data());
         result.data.resize(dest_len);
         
-        // Compress
-        int ret = ::compress2(
-            result.data.data(),
-            &dest_len,
-            input.data(),
-            input.size(),
-            level
-        );
+        result.success = true;
+        result.original_size = input.size();
+        result.compressed_size = dest_len;
+        
+    } catch (const std::exception& e) {
+        result.success = false;
+        result.error_message = e.what();
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    
+    return result;
+}
+
+CompressionResult ZlibCompressor::decompress(std::span<const uint8_t> input, size_t expected_size) {
+    utils::ScopedSpan trace_span("ZlibCompressor::decompress", "compression", input.size());
+    if (expected_size == 0) {
+        // Nothing to pre-size; just check the stream is valid and empty
+        auto result = decompress(input);
+        if (result.success && !result.data.empty()) {
+            result.success = false;
+            result.error_message = "zlib decompression failed: size does not match the expected 0 bytes";
+        }
+        return result;
+    }
+    
+    CompressionResult result;
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    try {
+        z_stream& strm = streams_->inflate_stream;
+        int ret = streams_->prepare_inflate();
+        if (ret != Z_OK) {
+            result.success = false;
+            result.error_message = fmt::format("zlib decompression failed: error {}", ret);
+            return result;
+        }
+        
+        // One pass into a buffer of exactly the expected size
+        result.data = core::BufferPool::shared().acquire(expected_size);
+        result.data.resize(expected_size);
+        
+        size_t in_left = input.size();
+        size_t out_left = expected_size;
+        strm.next_in = const_cast<Bytef*>(input.data());
+        strm.avail_in = 0;
+        strm.next_out = result.data.data();
+        strm.avail_out = 0;
+        
+        do {
+            if (strm.avail_out == 0 && out_left > 0) {
+                strm.avail_out = static_cast<uInt>((std::min)(out_left, ZLIB_MAX_STEP));
+                out_left -= strm.avail_out;
+            }
+            if (strm.avail_in == 0 && in_left > 0) {
+                strm.avail_in = static_cast<uInt>((std::min)(in_left, ZLIB_MAX_STEP));
+                in_left -= strm.avail_in;
+            }
+            ret = inflate_with(strm, dictionary_);
+        } while (ret == Z_OK);
+        
+        size_t produced = static_cast<size_t>(strm.next_out - result.data.data());
+        if (ret != Z_STREAM_END || produced != expected_size) {
+            result.success = false;
+            result.error_message = (ret == Z_STREAM_END || ret == Z_BUF_ERROR)
+                ? fmt::format("zlib decompression failed: size does not match the expected {} bytes", expected_size)
+                : zlib_error("decompression", ret);
+            return result;
+        }
+        
+        result.success = true;
+        result.original_size = input.size();
+        result.compressed_size = expected_size;
+        
+    } catch (const std::exception& e) {
+        result.success = false;
+        result.error_message = e.what();
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    
+    return result;
+}
+
+bool ZlibCompressor::begin(StreamMode mode, int level, std::optional<uint64_t> /*input_size*/) {
+    stream_error_.clear();
+    auto& st = *streams_;
+    size_t workers = worker_count();
+    st.parallel = false;
+    
+    if (mode == StreamMode::COMPRESS && workers > 1 && dictionary_.empty()) {
+        // Blocks are deflated independently; no shared deflate stream
+        pool_for(st.pool, workers);
+        st.parallel = true;
+        st.header_written = false;
+        st.parallel_level = std::clamp(level, 1, 9);
+        st.adler = adler32(0L, Z_NULL, 0);
+        st.pending.clear();
+        st.window.clear();
+        st.active = true;
+        st.ended = false;
+        st.mode = mode;
+        return true;
+    }
+    
+    int ret = (mode == StreamMode::COMPRESS)
+        ? streams_->prepare_deflate(std::clamp(level, 1, 9), dictionary_)
+        : streams_->prepare_inflate();
+    if (ret != Z_OK) {
+        stream_error_ = fmt::format("zlib stream initialization failed: error {}", ret);
+        return false;
+    }
+    
+    streams_->active = true;
+    streams_->ended = false;
+    streams_->mode = mode;
+    return true;
+}
+
+bool ZlibCompressor::update(std::span<const uint8_t> input, std::vector<uint8_t>& output) {
+    if (!streams_->active) {
+        stream_error_ = "No zlib stream in progress";
+        return false;
+    }
+    if (streams_->ended || input.empty()) {
+        return true;  // Data after the end of the stream is ignored, as in decompress()
+    }
+    if (streams_->parallel) {
+        return update_parallel(input, output, false);
+    }
+    
+    bool compressing = (streams_->mode == StreamMode::COMPRESS);
+    z_stream& strm = compressing ? streams_->deflate_stream : streams_->inflate_stream;
+    int ret = zlib_pump(strm, streams_->mode, input, output, Z_NO_FLUSH, dictionary_);
+    if (ret == Z_STREAM_END) {
+        streams_->ended = true;
+    } else if (ret != Z_OK) {
+        streams_->active = false;
+        stream_error_ = zlib_error(compressing ? "compression" : "decompression", ret);
+        return false;
+    }
+    return true;
+}
+
+bool ZlibCompressor::finish(std::vector<uint8_t>& output) {
+    if (!streams_->active) {
+        stream_error_ = "No zlib stream in progress";
+        return false;
+    }
+    streams_->active = false;
+    
+    if (streams_->mode == StreamMode::DECOMPRESS) {
+        if (!streams_->ended) {
+            stream_error_ = "zlib decompression failed: stream is truncated";
+            return false;
+        }
+        return true;
+    }
+    
+    if (streams_->parallel) {
+        return update_parallel({}, output, true);
+    }
+    
+    int ret = zlib_pump(streams_->deflate_stream, StreamMode::COMPRESS, {}, output, Z_FINISH);
+    if (ret != Z_STREAM_END) {
+        stream_error_ = fmt::format("zlib compression failed: error {}", ret);
+        return false;
+    }
+    return true;
+}
+
+bool ZlibCompressor::update_parallel(std::span<const uint8_t> input, std::vector<uint8_t>& output, bool last) {
+    auto& st = *streams_;
+    if (!st.header_written) {
+        append_zlib_header(output, st.parallel_level);
+        st.header_written = true;
+    }
+    st.pending.insert(st.pending.end(), input.begin(), input.end());
+    
+    // Gather a block per worker before dispatching; the rest waits
+    size_t batch = ZLIB_PARALLEL_BLOCK * st.pool->size();
+    if (!last && st.pending.size() < batch) {
+        return true;
+    }
+    size_t take = last ? st.pending.size() : st.pending.size() / ZLIB_PARALLEL_BLOCK * ZLIB_PARALLEL_BLOCK;
+    auto data = std::span<const uint8_t>(st.pending).first(take);
+    
+    int ret = deflate_parallel(*st.pool, st.window, data, st.parallel_level, last, output, st.adler);
+    if (ret != Z_OK) {
+        st.active = false;
+        stream_error_ = fmt::format("zlib compression failed: error {}", ret);
+        return false;
+    }
+    if (last) {
+        append_be32(output, static_cast<uint32_t>(st.adler));
+        st.pending.clear();
+        return true;
+    }
+    
+    // Keep the last 32 KB of input as the next batch's dictionary
+    st.window.assign(st.pending.begin() + (take - ZLIB_WINDOW_SIZE), st.pending.begin() + take);
+    st.pending.erase(st.pending.begin(), st.pending.begin() + take);
+    return true;
+}
+
+// ============================================================================
+// Bzip2Compressor - Using BZIP3 API
+// ============================================================================
+
+// bzip3 frame layout (as written by bz3_compress):
+//   "BZ3v1" | block size (le32) | block count (le32)
+//   then per block: compressed size (le32) | original size (le32) | data
+static constexpr uint8_t BZ3_MAGIC[5] = {'B', 'Z', '3', 'v', '1'};
+static constexpr size_t BZ3_FRAME_HEADER_SIZE = 13;
+static constexpr size_t BZ3_BLOCK_HEADER_SIZE = 8;
+static constexpr int32_t BZ3_MIN_BLOCK_SIZE = 65 * 1024;
+static constexpr int32_t BZ3_MAX_BLOCK_SIZE = 511 * 1024 * 1024;
+
+static void append_le32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+static uint32_t read_le32(const uint8_t* in) {
+    return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+           (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+/**
+ * @brief One block of a parallel bzip3 frame, with its block header
+ */
+struct EncodedBlock {
+    std::string error;          // Empty on success
+    std::vector<uint8_t> data;
+};
+
+static EncodedBlock bz3_encode_task(std::span<const uint8_t> block, int32_t block_size) {
+    EncodedBlock out;
+    bz3_state* state = bz3_new(block_size);
+    if (!state) {
+        out.error = "BZIP3 compression failed: out of memory";
+        return out;
+    }
+    
+    out.data.resize(BZ3_BLOCK_HEADER_SIZE + bz3_bound(block.size()));
+    uint8_t* buffer = out.data.data() + BZ3_BLOCK_HEADER_SIZE;
+    std::copy(block.begin(), block.end(), buffer);
+    int32_t size = bz3_encode_block(state, buffer, static_cast<int32_t>(block.size()));
+    if (size < 0) {
+        out.error = fmt::format("BZIP3 compression failed: {}", bz3_strerror(state));
+        bz3_free(state);
+        return out;
+    }
+    bz3_free(state);
+    
+    out.data.resize(BZ3_BLOCK_HEADER_SIZE + size);
+    for (int i = 0; i < 4; ++i) {
+        out.data[i] = static_cast<uint8_t>(static_cast<uint32_t>(size) >> (8 * i));
+        out.data[4 + i] = static_cast<uint8_t>(block.size() >> (8 * i));
+    }
+    return out;
+}
+
+/**
+ * @brief Encode data as block_size blocks on the pool, appended in order
+ * @return false on failure (error is set)
+ */
+static bool bz3_encode_parallel(core::ThreadPool& pool, std::span<const uint8_t> data, int32_t block_size,
+                                std::vector<uint8_t>& output, std::string& error) {
+    std::vector<std::future<EncodedBlock>> futures;
+    for (size_t offset = 0; offset < data.size(); offset += block_size) {
+        auto block = data.subspan(offset, std::min(static_cast<size_t>(block_size), data.size() - offset));
+        futures.push_back(pool.submit([=]() { return bz3_encode_task(block, block_size); }));
+    }
+    
+    // Collect every future even after a failure; the tasks reference data
+    error.clear();
+    for (auto& future : futures) {
+        auto block = future.get();
+        if (error.empty() && !block.error.empty()) {
+            error = block.error;
+        }
+        if (error.empty()) {
+            output.insert(output.end(), block.data.begin(), block.data.end());
+        }
+    }
+    return error.empty();
+}
+
+static EncodedBlock bz3_decode_task(std::span<const uint8_t> compressed, int32_t orig_size, int32_t block_size) {
+    EncodedBlock out;
+    bz3_state* state = bz3_new(block_size);
+    if (!state) {
+        out.error = "BZIP3 decompression failed: out of memory";
+        return out;
+    }
+    
+    out.data.resize(std::max(bz3_bound(orig_size), compressed.size()));
+    std::copy(compressed.begin(), compressed.end(), out.data.begin());
+    int32_t size = bz3_decode_block(state, out.data.data(), out.data.size(),
+                                    static_cast<int32_t>(compressed.size()), orig_size);
+    if (size < 0) {
+        out.error = fmt::format("BZIP3 decompression failed: {}", bz3_strerror(state));
+    }
+    bz3_free(state);
+    out.data.resize(static_cast<size_t>(orig_size));
+    return out;
+}
+
+/**
+ * @brief Where one block's data lies, from its block header
+ */
+struct Bz3Block {
+    size_t offset = 0;          // Of the compressed data, past the block header
+    size_t compressed_size = 0;
+    int32_t orig_size = 0;
+};
+
+/**
+ * @brief Parse the headers of up to count whole blocks at the start of blocks
+ * @return The blocks, fewer than count if the input ends first; nullopt if
+ *         a header is bad
+ */
+static std::optional<std::vector<Bz3Block>> bz3_block_headers(
+    std::span<const uint8_t> blocks, size_t count, int32_t block_size) {
+    std::vector<Bz3Block> headers;
+    size_t offset = 0;
+    while (headers.size() < count && blocks.size() - offset >= BZ3_BLOCK_HEADER_SIZE) {
+        auto compressed_size = static_cast<int32_t>(read_le32(blocks.data() + offset));
+        auto orig_size = static_cast<int32_t>(read_le32(blocks.data() + offset + 4));
+        if (compressed_size < 0 || static_cast<size_t>(compressed_size) > bz3_bound(block_size) ||
+            orig_size < 0 || orig_size > block_size) {
+            return std::nullopt;
+        }
+        if (blocks.size() - offset - BZ3_BLOCK_HEADER_SIZE < static_cast<size_t>(compressed_size)) {
+            break;
+        }
+        headers.push_back({offset + BZ3_BLOCK_HEADER_SIZE, static_cast<size_t>(compressed_size), orig_size});
+        offset += BZ3_BLOCK_HEADER_SIZE + compressed_size;
+    }
+    return headers;
+}
+
+/**
+ * @brief Decode the given blocks on the pool, appended to output in order
+ * @return false on failure (error is set)
+ *
+ * bzip3 blocks are independent, so any frame decodes in parallel, not
+ * only those written by the parallel encoder.
+ */
+static bool bz3_decode_parallel(core::ThreadPool& pool, std::span<const uint8_t> blocks,
+                                const std::vector<Bz3Block>& headers, int32_t block_size,
+                                std::vector<uint8_t>& output, std::string& error) {
+    std::vector<std::future<EncodedBlock>> futures;
+    for (const auto& header : headers) {
+        auto compressed = blocks.subspan(header.offset, header.compressed_size);
+        int32_t orig_size = header.orig_size;
+        futures.push_back(pool.submit([=]() { return bz3_decode_task(compressed, orig_size, block_size); }));
+    }
+    
+    // Collect every future even after a failure; the tasks reference blocks
+    error.clear();
+    for (auto& future : futures) {
+        auto block = future.get();
+        if (error.empty() && !block.error.empty()) {
+            error = block.error;
+        }
+        if (error.empty()) {
+            output.insert(output.end(), block.data.begin(), block.data.end());
+        }
+    }
+    return error.empty();
+}
+
+struct Bzip2Compressor::Streams {
+    bz3_state* state = nullptr;
+    bool active = false;
+    StreamMode mode = StreamMode::COMPRESS;
+    int32_t block_size = 0;
+    std::vector<uint8_t> block;     // bz3_bound(block_size) work buffer
+    
+    // Compression: bytes waiting in block, bytes still expected
+    size_t filled = 0;
+    uint64_t remaining = 0;
+    
+    // Decompression: unparsed input, header state, blocks still to come
+    // (parallel compression also gathers its input in pending)
+    std::vector<uint8_t> pending;
+    bool header_done = false;
+    uint32_t blocks_left = 0;
+    
+    // Parallel compression and decompression: blocks are coded by tasks
+    // with their own state
+    std::unique_ptr<core::ThreadPool> pool;
+    bool parallel = false;
+    
+    void reset() {
+        if (state) {
+            bz3_free(state);
+            state = nullptr;
+        }
+        active = false;
+        filled = 0;
+        remaining = 0;
+        pending.clear();
+        header_done = false;
+        blocks_left = 0;
+        parallel = false;
+    }
+    
+    ~Streams() { reset(); }
+};
+
+Bzip2Compressor::Bzip2Compressor() : streams_(std::make_unique<Streams>()) {}
+
+Bzip2Compressor::~Bzip2Compressor() = default;
+
+CompressionResult Bzip2Compressor::compress(
+    std::span<const uint8_t> input,
+    int level
+) {
+    utils::ScopedSpan trace_span("Bzip2Compressor::compress", "compression", input.size());
+    CompressionResult result;
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    try {
+        if (input.empty()) {
+            result.success = false;
+            result.error_message = "Empty input";
+            return result;
+        }
+        
+        // BZIP3 block size (65KB to 511MB, recommended: 1MB to 8MB)
+        // Level 1-9 maps to block sizes
+        int32_t block_size;
+        if (level <= 3) {
+            block_size = 1 * 1024 * 1024;      // 1MB - fast
+        } else if (level <= 6) {
+            block_size = 4 * 1024 * 1024;      // 4MB - balanced
+        } else {
+            block_size = 8 * 1024 * 1024;      // 8MB - best compression
+        }
+        
+        size_t workers = worker_count();
+        if (workers > 1 && input.size() > static_cast<size_t>(block_size)) {
+            // Same frame as bz3_compress, with the blocks encoded concurrently
+            uint64_t blocks = (input.size() + block_size - 1) / block_size;
+            result.data = core::BufferPool::shared().acquire(bz3_bound(input.size()));
+            result.data.insert(result.data.end(), std::begin(BZ3_MAGIC), std::end(BZ3_MAGIC));
+            append_le32(result.data, static_cast<uint32_t>(block_size));
+            append_le32(result.data, static_cast<uint32_t>(blocks));
+            
+            std::string error;
+            if (!bz3_encode_parallel(pool_for(streams_->pool, workers), input, block_size, result.data, error)) {
+                result.success = false;
+                result.error_message = error;
+                return result;
+            }
+            
+            auto end = std::chrono::high_resolution_clock::now();
+            result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+            result.success = true;
+            return result;
+        }
+        
+        // Calculate output buffer size
+        size_t out_size = bz3_bound(input.size());
+        result.data = core::BufferPool::shared().acquire(out_size);
+        result.data.resize(out_size);
+        
+        // Compress using bzip3
+        int status = bz3_compress(
+            block_size,
+            input.data(),
+            result.data.data(),
+            input.size(),
+            &out_size
+        );
+        
+        if (status != BZ3_OK) {
+            result.success = false;
+            result.error_message = std::format("BZIP3 compression failed with error code: {}", status);
+            return result;
+        }
+        
+        // Resize to actual compressed size
+        result.data.resize(out_size);
+        
+        auto end = std::chrono::high_resolution_clock::now();
+        result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        result.success = true;
+        
+    } catch (const std::exception& e) {
+        result.success = false;
+        result.error_message = std::format("BZIP3 compression error: {}", e.what());
+    }
+    
+    return result;
+}
+
+/**
+ * @brief Total decompressed size of a bzip3 frame, from its block headers
+ * @return nullopt if the frame is malformed
+ */
+static std::optional<size_t> bz3_frame_size(std::span<const uint8_t> input) {
+    if (input.size() < BZ3_FRAME_HEADER_SIZE ||
+        !std::equal(std::begin(BZ3_MAGIC), std::end(BZ3_MAGIC), input.begin())) {
+        return std::nullopt;
+    }
+    
+    uint32_t blocks = read_le32(input.data() + 9);
+    size_t offset = BZ3_FRAME_HEADER_SIZE;
+    size_t total = 0;
+    for (uint32_t i = 0; i < blocks; ++i) {
+        if (input.size() - offset < BZ3_BLOCK_HEADER_SIZE) {
+            return std::nullopt;
+        }
+        size_t compressed_size = read_le32(input.data() + offset);
+        total += read_le32(input.data() + offset + 4);
+        offset += BZ3_BLOCK_HEADER_SIZE;
+        if (input.size() - offset < compressed_size) {
+            return std::nullopt;
+        }
+        offset += compressed_size;
+    }
+    return total;
+}
+
+CompressionResult Bzip2Compressor::decompress(std::span<const uint8_t> input) {
+    utils::ScopedSpan trace_span("Bzip2Compressor::decompress", "compression", input.size());
+    if (input.empty()) {
+        CompressionResult result;
+        result.success = false;
+        result.error_message = "Empty input";
+        return result;
+    }
+    
+    // bz3_decompress needs the output size; the frame's block headers give it exactly
+    auto size = bz3_frame_size(input);
+    if (!size) {
+        CompressionResult result;
+        result.success = false;
+        result.error_message = "BZIP3 decompression failed: malformed frame";
+        return result;
+    }
+    return decompress(input, *size);
+}
+
+CompressionResult Bzip2Compressor::decompress(std::span<const uint8_t> input, size_t expected_size) {
+    utils::ScopedSpan trace_span("Bzip2Compressor::decompress", "compression", input.size());
+    CompressionResult result;
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    try {
+        if (input.empty()) {
+            result.success = false;
+            result.error_message = "Empty input";
+            return result;
+        }
+        
+        // Frames of several blocks decode a block per worker
+        size_t workers = worker_count();
+        if (workers > 1 && input.size() >= BZ3_FRAME_HEADER_SIZE &&
+            std::equal(std::begin(BZ3_MAGIC), std::end(BZ3_MAGIC), input.begin()) &&
+            read_le32(input.data() + 9) > 1) {
+            auto block_size = static_cast<int32_t>(read_le32(input.data() + 5));
+            uint32_t count = read_le32(input.data() + 9);
+            auto blocks = input.subspan(BZ3_FRAME_HEADER_SIZE);
+            auto headers = block_size < BZ3_MIN_BLOCK_SIZE || block_size > BZ3_MAX_BLOCK_SIZE
+                ? std::nullopt
+                : bz3_block_headers(blocks, count, block_size);
+            if (!headers || headers->size() != count) {
+                result.success = false;
+                result.error_message = "BZIP3 decompression failed: malformed frame";
+                return result;
+            }
+            
+            result.data = core::BufferPool::shared().acquire(expected_size);
+            std::string error;
+            if (!bz3_decode_parallel(pool_for(streams_->pool, workers), blocks, *headers, block_size,
+                                     result.data, error)) {
+                result.success = false;
+                result.error_message = error;
+                return result;
+            }
+            if (result.data.size() != expected_size) {
+                result.success = false;
+                result.error_message = fmt::format("BZIP3 decompression failed: size does not match the expected {} bytes",
+                                                   expected_size);
+                return result;
+            }
+            
+            auto end = std::chrono::high_resolution_clock::now();
+            result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+            result.success = true;
+            return result;
+        }
+        
+        result.data = core::BufferPool::shared().acquire(expected_size);
+        result.data.resize(expected_size);
+        
+        size_t out_size = expected_size;
+        int status = bz3_decompress(
+            input.data(),
+            result.data.data(),
+            input.size(),
+            &out_size
+        );
+        
+        if (status != BZ3_OK) {
+            result.success = false;
+            result.error_message = std::format("BZIP3 decompression failed with error code: {}", status);
+            return result;
+        }
+        if (out_size != expected_size) {
+            result.success = false;
+            result.error_message = std::format("BZIP3 decompression failed: size does not match the expected {} bytes",
+                                               expected_size);
+            return result;
+        }
+        
+        auto end = std::chrono::high_resolution_clock::now();
+        result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        result.success = true;
+        
+    } catch (const std::exception& e) {
+        result.success = false;
+        result.error_message = std::format("BZIP3 decompression error: {}", e.what());
+    }
+    
+    return result;
+}
+
+bool Bzip2Compressor::begin(StreamMode mode, int level, std::optional<uint64_t> input_size) {
+    stream_error_.clear();
+    auto& st = *streams_;
+    st.reset();
+    st.mode = mode;
+    
+    if (mode == StreamMode::DECOMPRESS) {
+        size_t workers = worker_count();
+        if (workers > 1) {
+            pool_for(st.pool, workers);
+            st.parallel = true;
+        }
+        st.active = true;
+        return true;
+    }
+    
+    if (!input_size) {
+        stream_error_ = "BZIP3 stream compression needs the total input size";
+        return false;
+    }
+    
+    // Same level -> block size mapping as compress(), shrunk for small inputs
+    int32_t block_size = level <= 3 ? 1 * 1024 * 1024 : (level <= 6 ? 4 * 1024 * 1024 : 8 * 1024 * 1024);
+    if (*input_size < static_cast<uint64_t>(block_size)) {
+        block_size = std::max(static_cast<int32_t>(*input_size), BZ3_MIN_BLOCK_SIZE);
+    }
+    
+    uint64_t blocks = (*input_size + block_size - 1) / block_size;
+    if (blocks > UINT32_MAX) {
+        stream_error_ = "Input too large for a BZIP3 frame";
+        return false;
+    }
+    
+    size_t workers = worker_count();
+    if (workers > 1 && blocks > 1) {
+        pool_for(st.pool, workers);
+        st.parallel = true;
+        st.block_size = block_size;
+        st.remaining = *input_size;
+        st.blocks_left = static_cast<uint32_t>(blocks);
+        st.active = true;
+        return true;
+    }
+    
+    st.state = bz3_new(block_size);
+    if (!st.state) {
+        stream_error_ = "BZIP3 stream initialization failed";
+        return false;
+    }
+    st.block_size = block_size;
+    st.block.resize(bz3_bound(block_size));
+    st.remaining = *input_size;
+    st.blocks_left = static_cast<uint32_t>(blocks);
+    st.active = true;
+    return true;
+}
+
+bool Bzip2Compressor::update(std::span<const uint8_t> input, std::vector<uint8_t>& output) {
+    auto& st = *streams_;
+    if (!st.active) {
+        stream_error_ = "No BZIP3 stream in progress";
+        return false;
+    }
+    
+    if (st.mode == StreamMode::COMPRESS) {
+        // The header is emitted with the first call so begin() needs no output
+        if (!st.header_done) {
+            output.insert(output.end(), std::begin(BZ3_MAGIC), std::end(BZ3_MAGIC));
+            append_le32(output, static_cast<uint32_t>(st.block_size));
+            append_le32(output, st.blocks_left);
+            st.header_done = true;
+        }
+        if (input.size() > st.remaining) {
+            st.reset();
+            stream_error_ = "BZIP3 stream received more input than announced";
+            return false;
+        }
+        st.remaining -= input.size();
+        
+        if (st.parallel) {
+            // Dispatch once there is a block for every worker
+            st.pending.insert(st.pending.end(), input.begin(), input.end());
+            size_t block_size = static_cast<size_t>(st.block_size);
+            if (st.pending.size() < block_size * st.pool->size()) {
+                return true;
+            }
+            size_t take = st.pending.size() / block_size * block_size;
+            std::string error;
+            if (!bz3_encode_parallel(*st.pool, std::span<const uint8_t>(st.pending).first(take),
+                                     st.block_size, output, error)) {
+                st.reset();
+                stream_error_ = error;
+                return false;
+            }
+            st.pending.erase(st.pending.begin(), st.pending.begin() + take);
+            return true;
+        }
+        
+        while (!input.empty()) {
+            size_t take = std::min(input.size(), static_cast<size_t>(st.block_size) - st.filled);
+            std::copy_n(input.data(), take, st.block.data() + st.filled);
+            st.filled += take;
+            input = input.subspan(take);
+            
+            if (st.filled == static_cast<size_t>(st.block_size)) {
+                int32_t size = bz3_encode_block(st.state, st.block.data(), static_cast<int32_t>(st.filled));
+                if (size < 0) {
+                    stream_error_ = fmt::format("BZIP3 compression failed: {}", bz3_strerror(st.state));
+                    st.reset();
+                    return false;
+                }
+                append_le32(output, static_cast<uint32_t>(size));
+                append_le32(output, static_cast<uint32_t>(st.filled));
+                output.insert(output.end(), st.block.begin(), st.block.begin() + size);
+                st.filled = 0;
+            }
+        }
+        return true;
+    }
+    
+    // Decompression: buffer input until a whole header or block is available
+    st.pending.insert(st.pending.end(), input.begin(), input.end());
+    size_t offset = 0;
+    
+    if (!st.header_done) {
+        if (st.pending.size() < BZ3_FRAME_HEADER_SIZE) {
+            return true;
+        }
+        const uint8_t* header = st.pending.data();
+        auto block_size = static_cast<int32_t>(read_le32(header + 5));
+        if (!std::equal(std::begin(BZ3_MAGIC), std::end(BZ3_MAGIC), header) ||
+            block_size < BZ3_MIN_BLOCK_SIZE || block_size > BZ3_MAX_BLOCK_SIZE) {
+            st.reset();
+            stream_error_ = "BZIP3 decompression failed: bad frame header";
+            return false;
+        }
+        if (!st.parallel) {
+            st.state = bz3_new(block_size);
+            if (!st.state) {
+                st.reset();
+                stream_error_ = "BZIP3 stream initialization failed";
+                return false;
+            }
+            st.block.resize(bz3_bound(block_size));
+        }
+        st.block_size = block_size;
+        st.blocks_left = read_le32(header + 9);
+        st.header_done = true;
+        offset = BZ3_FRAME_HEADER_SIZE;
+    }
+    
+    // In parallel, whole blocks are gathered until every worker has one
+    // (or the last block is in), then decoded together
+    while (st.parallel && st.blocks_left > 0) {
+        auto blocks = std::span<const uint8_t>(st.pending).subspan(offset);
+        size_t batch = std::min<size_t>(st.blocks_left, st.pool->size());
+        auto headers = bz3_block_headers(blocks, batch, st.block_size);
+        if (!headers) {
+            st.reset();
+            stream_error_ = "BZIP3 decompression failed: bad block header";
+            return false;
+        }
+        if (headers->size() < batch) {
+            break;  // Wait for the rest of the batch
+        }
+        std::string error;
+        if (!bz3_decode_parallel(*st.pool, blocks, *headers, st.block_size, output, error)) {
+            st.reset();
+            stream_error_ = error;
+            return false;
+        }
+        offset += headers->back().offset + headers->back().compressed_size;
+        st.blocks_left -= static_cast<uint32_t>(batch);
+    }
+    
+    while (!st.parallel && st.blocks_left > 0 && st.pending.size() - offset >= BZ3_BLOCK_HEADER_SIZE) {
+        const uint8_t* header = st.pending.data() + offset;
+        auto compressed_size = static_cast<int32_t>(read_le32(header));
+        auto orig_size = static_cast<int32_t>(read_le32(header + 4));
+        if (compressed_size < 0 || static_cast<size_t>(compressed_size) > st.block.size() ||
+            orig_size < 0 || orig_size > st.block_size) {
+            st.reset();
+            stream_error_ = "BZIP3 decompression failed: bad block header";
+            return false;
+        }
+        if (st.pending.size() - offset - BZ3_BLOCK_HEADER_SIZE < static_cast<size_t>(compressed_size)) {
+            break;  // Wait for the rest of the block
+        }
+        
+        std::copy_n(header + BZ3_BLOCK_HEADER_SIZE, compressed_size, st.block.data());
+        int32_t size = bz3_decode_block(st.state, st.block.data(), st.block.size(),
+                                        compressed_size, orig_size);
+        if (size < 0) {
+            stream_error_ = fmt::format("BZIP3 decompression failed: {}", bz3_strerror(st.state));
+            st.reset();
+            return false;
+        }
+        output.insert(output.end(), st.block.begin(), st.block.begin() + orig_size);
+        offset += BZ3_BLOCK_HEADER_SIZE + compressed_size;
+        --st.blocks_left;
+    }
+    
+    st.pending.erase(st.pending.begin(), st.pending.begin() + offset);
+    return true;
+}
+
+bool Bzip2Compressor::finish(std::vector<uint8_t>& output) {
+    auto& st = *streams_;
+    if (!st.active) {
+        stream_error_ = "No BZIP3 stream in progress";
+        return false;
+    }
+    
+    if (st.mode == StreamMode::DECOMPRESS) {
+        bool complete = st.header_done && st.blocks_left == 0;
+        st.reset();
+        if (!complete) {
+            stream_error_ = "BZIP3 decompression failed: stream is truncated";
+            return false;
+        }
+        return true;
+    }
+    
+    if (st.remaining != 0) {
+        st.reset();
+        stream_error_ = "BZIP3 stream received less input than announced";
+        return false;
+    }
+    
+    // Emits the header for empty input, then the final partial block
+    if (!update({}, output)) {
+        return false;
+    }
+    if (st.parallel) {
+        std::string error;
+        bool ok = bz3_encode_parallel(*st.pool, st.pending, st.block_size, output, error);
+        st.reset();
+        if (!ok) {
+            stream_error_ = error;
+        }
+        return ok;
+    }
+    if (st.filled > 0) {
+        int32_t size = bz3_encode_block(st.state, st.block.data(), static_cast<int32_t>(st.filled));
+        if (size < 0) {
+            stream_error_ = fmt::format("BZIP3 compression failed: {}", bz3_strerror(st.state));
+            st.reset();
+            return false;
+        }
+        append_le32(output, static_cast<uint32_t>(size));
+        append_le32(output, static_cast<uint32_t>(st.filled));
+        output.insert(output.end(), st.block.begin(), st.block.begin() + size);
+    }
+    
+    st.reset();
+    return true;
+}
+
+// ============================================================================
+// LzmaCompressor
+// ============================================================================
+
+struct LzmaCompressor::Streams {
+    lzma_stream encoder = LZMA_STREAM_INIT;
+    lzma_stream decoder = LZMA_STREAM_INIT;
+    
+    // Incremental stream in progress
+    bool active = false;
+    StreamMode mode = StreamMode::COMPRESS;
+};
+
+/**
+ * @brief Run lzma_code over input, appending everything produced
+ * @return LZMA_OK once the input is consumed (LZMA_RUN), LZMA_STREAM_END, or an error
+ */
+static lzma_ret lzma_pump(lzma_stream& strm, std::span<const uint8_t> input,
+                          std::vector<uint8_t>& output, lzma_action action) {
+    strm.next_in = input.data();
+    strm.avail_in = input.size();
+    
+    while (true) {
+        size_t used = output.size();
+        output.resize(used + STREAM_OUTPUT_STEP);
+        strm.next_out = output.data() + used;
+        strm.avail_out = STREAM_OUTPUT_STEP;
+        
+        lzma_ret ret = lzma_code(&strm, action);
+        output.resize(used + STREAM_OUTPUT_STEP - strm.avail_out);
+        
+        if (ret == LZMA_STREAM_END) {
+            return ret;
+        }
+        if (ret == LZMA_BUF_ERROR && action == LZMA_RUN && strm.avail_in == 0) {
+            return LZMA_OK;
+        }
+        if (ret != LZMA_OK) {
+            return ret;
+        }
+        if (action == LZMA_RUN && strm.avail_in == 0 && strm.avail_out > 0) {
+            return LZMA_OK;
+        }
+    }
+}
+
+/**
+ * @brief (Re)initialise an encoder, multithreaded when workers > 1
+ *
+ * The threaded encoder cuts the input into blocks of three times the
+ * preset's dictionary size; as xz -T0 does, threads are dropped while its
+ * memory use would exceed a quarter of physical RAM.
+ */
+static lzma_ret init_lzma_encoder(lzma_stream& strm, int level, size_t workers) {
+    if (workers <= 1) {
+        return lzma_easy_encoder(&strm, level, LZMA_CHECK_CRC64);
+    }
+    
+    lzma_mt mt{};
+    mt.threads = static_cast<uint32_t>(std::min<size_t>(workers, UINT32_MAX));
+    mt.preset = static_cast<uint32_t>(level);
+    mt.check = LZMA_CHECK_CRC64;
+    uint64_t limit = lzma_physmem() / 4;
+    while (mt.threads > 1 && limit > 0 && lzma_stream_encoder_mt_memusage(&mt) > limit) {
+        --mt.threads;
+    }
+    return lzma_stream_encoder_mt(&strm, &mt);
+}
+
+/**
+ * @brief (Re)initialise a decoder, multithreaded when workers > 1
+ *
+ * liblzma 5.4 decodes the blocks of a multi-block stream (as written by the
+ * threaded encoder) in parallel; single-block streams still decode in one
+ * thread. Threading stops at a quarter of physical RAM, never the decode.
+ */
+static lzma_ret init_lzma_decoder(lzma_stream& strm, size_t workers) {
+#if LZMA_VERSION >= 50040002
+    if (workers > 1) {
+        lzma_mt mt{};
+        mt.threads = static_cast<uint32_t>(std::min<size_t>(workers, UINT32_MAX));
+        mt.flags = LZMA_CONCATENATED;
+        mt.memlimit_threading = lzma_physmem() / 4;
+        mt.memlimit_stop = UINT64_MAX;
+        return lzma_stream_decoder_mt(&strm, &mt);
+    }
+#else
+    (void)workers;
+#endif
+    return lzma_stream_decoder(&strm, UINT64_MAX, LZMA_CONCATENATED);
+}
+
+LzmaCompressor::LzmaCompressor() : streams_(std::make_unique<Streams>()) {}
+
+LzmaCompressor::~LzmaCompressor() {
+    lzma_end(&streams_->encoder);
+    lzma_end(&streams_->decoder);
+}
+
+CompressionResult LzmaCompressor::compress(
+    std::span<const uint8_t> input,
+    int level
+) {
+    utils::ScopedSpan trace_span("LzmaCompressor::compress", "compression", input.size());
+    CompressionResult result;
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    try {
+        level = std::clamp(level, 1, 9);
+        
+        // Re-initialise the persistent encoder; its buffers are reused
+        streams_->active = false;
+        lzma_stream& strm = streams_->encoder;
+        lzma_ret ret = init_lzma_encoder(strm, level, worker_count());
+        if (ret != LZMA_OK) {
+            result.success = false;
+            result.error_message = "LZMA encoder initialization failed";
+            return result;
+        }
+        
+        // Allocate output buffer
+        size_t out_size = lzma_stream_buffer_bound(input.size());
+        result.data = core::BufferPool::shared().acquire(out_size);
+        result.data.resize(out_size);
+        
+        // Setup streams
+        strm.next_in = input.data();
+        strm.avail_in = input.size();
+        strm.next_out = result.data.data();
+        strm.avail_out = result.data.size();
+        
+        // Compress; a multi-block (threaded) stream may exceed the bound
+        ret = lzma_code(&strm, LZMA_FINISH);
+        while (ret == LZMA_OK) {
+            if (strm.avail_out == 0) {
+                size_t used = result.data.size();
+                result.data.resize(used + STREAM_OUTPUT_STEP);
+                strm.next_out = result.data.data() + used;
+                strm.avail_out = STREAM_OUTPUT_STEP;
+            }
+            ret = lzma_code(&strm, LZMA_FINISH);
+        }
+        
+        if (ret != LZMA_STREAM_END) {
+            result.success = false;
+            result.error_message = fmt::format("LZMA compression failed: error {}", static_cast<int>(ret));
+            return result;
+        }
+        
+        size_t compressed_size = strm.total_out;
+        
+        result.data.resize(compressed_size);
+        
+        result.success = true;
+        result.original_size = input.size();
+        result.compressed_size = compressed_size;
+        result.compression_ratio = 100.0 * (1.0 - static_cast<double>(compressed_size) / input.size());
+        
+    } catch (const std::exception& e) {
+        result.success = false;
+        result.error_message = e.what();
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    
+    return result;
+}
+
+CompressionResult LzmaCompressor::decompress(std::span<const uint8_t> input) {
+    utils::ScopedSpan trace_span("LzmaCompressor::decompress", "compression", input.size());
+    CompressionResult result;
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    try {
+        // Re-initialise the persistent decoder; its buffers are reused
+        streams_->active = false;
+        lzma_stream& strm = streams_->decoder;
+        lzma_ret ret = init_lzma_decoder(strm, worker_count());
+        if (ret != LZMA_OK) {
+            result.success = false;
+            result.error_message = "LZMA decoder initialization failed";
+            return result;
+        }
+        
+        // Allocate output buffer
+        result.data = core::BufferPool::shared().acquire(input.size() * 4);
+        result.data.resize(input.size() * 4);
+        
+        strm.next_in = input.data();
+        strm.avail_in = input.size();
+        strm.next_out = result.data.data();
+        strm.avail_out = result.data.size();
+        
+        // Decompress, growing buffer if needed
+        while (true) {
+            // Use LZMA_FINISH for single-call decompression when all input is available
+            lzma_action action = (strm.avail_in > 0) ? LZMA_RUN : LZMA_FINISH;
+            ret = lzma_code(&strm, action);
+            
+            if (ret == LZMA_STREAM_END) {
+                break;
+            }
+            
+            if (ret == LZMA_OK && strm.avail_out == 0) {
+                // Need more output space
+                size_t old_size = result.data.size();
+                result.data.resize(old_size * 2);
+                strm.next_out = result.data.data() + old_size;
+                strm.avail_out = old_size;
+                continue;
+            }
+            
+            if (ret != LZMA_OK) {
+                result.success = false;
+                result.error_message = fmt::format("LZMA decompression failed: error {}", static_cast<int>(ret));
+                return result;
+            }
+        }
+        
+        size_t decompressed_size = strm.total_out;
+        
+        result.data.resize(decompressed_size);
+        
+        result.success = true;
+        result.original_size = input.size();
+        result.compressed_size = decompressed_size;
+        
+    } catch (const std::exception& e) {
+        result.success = false;
+        result.error_message = e.what();
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    
+    return result;
+}
+
+CompressionResult LzmaCompressor::decompress(std::span<const uint8_t> input, size_t expected_size) {
+    utils::ScopedSpan trace_span("LzmaCompressor::decompress", "compression", input.size());
+    CompressionResult result;
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    try {
+        streams_->active = false;
+        lzma_stream& strm = streams_->decoder;
+        lzma_ret ret = init_lzma_decoder(strm, worker_count());
+        if (ret != LZMA_OK) {
+            result.success = false;
+            result.error_message = "LZMA decoder initialization failed";
+            return result;
+        }
+        
+        // One pass into a buffer of exactly the expected size
+        result.data = core::BufferPool::shared().acquire(expected_size);
+        result.data.resize(expected_size);
+        
+        strm.next_in = input.data();
+        strm.avail_in = input.size();
+        strm.next_out = result.data.data();
+        strm.avail_out = result.data.size();
+        
+        do {
+            ret = lzma_code(&strm, LZMA_FINISH);
+        } while (ret == LZMA_OK);
+        
+        if (ret != LZMA_STREAM_END || strm.total_out != expected_size) {
+            result.success = false;
+            result.error_message = (ret == LZMA_STREAM_END || ret == LZMA_BUF_ERROR)
+                ? fmt::format("LZMA decompression failed: size does not match the expected {} bytes", expected_size)
+                : fmt::format("LZMA decompression failed: error {}", static_cast<int>(ret));
+            return result;
+        }
+        
+        result.success = true;
+        result.original_size = input.size();
+        result.compressed_size = expected_size;
+        
+    } catch (const std::exception& e) {
+        result.success = false;
+        result.error_message = e.what();
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    
+    return result;
+}
+
+bool LzmaCompressor::begin(StreamMode mode, int level, std::optional<uint64_t> /*input_size*/) {
+    stream_error_.clear();
+    streams_->active = false;
+    
+    lzma_ret ret = (mode == StreamMode::COMPRESS)
+        ? init_lzma_encoder(streams_->encoder, std::clamp(level, 1, 9), worker_count())
+        : init_lzma_decoder(streams_->decoder, worker_count());
+    if (ret != LZMA_OK) {
+        stream_error_ = fmt::format("LZMA stream initialization failed: error {}", static_cast<int>(ret));
+        return false;
+    }
+    
+    streams_->active = true;
+    streams_->mode = mode;
+    return true;
+}
+
+bool LzmaCompressor::update(std::span<const uint8_t> input, std::vector<uint8_t>& output) {
+    if (!streams_->active) {
+        stream_error_ = "No LZMA stream in progress";
+        return false;
+    }
+    if (input.empty()) {
+        return true;
+    }
+    
+    bool compressing = (streams_->mode == StreamMode::COMPRESS);
+    lzma_stream& strm = compressing ? streams_->encoder : streams_->decoder;
+    lzma_ret ret = lzma_pump(strm, input, output, LZMA_RUN);
+    if (ret != LZMA_OK) {
+        streams_->active = false;
+        stream_error_ = fmt::format("LZMA {} failed: error {}",
+                                    compressing ? "compression" : "decompression", static_cast<int>(ret));
+        return false;
+    }
+    return true;
+}
+
+bool LzmaCompressor::finish(std::vector<uint8_t>& output) {
+    if (!streams_->active) {
+        stream_error_ = "No LZMA stream in progress";
+        return false;
+    }
+    streams_->active = false;
+    
+    bool compressing = (streams_->mode == StreamMode::COMPRESS);
+    lzma_stream& strm = compressing ? streams_->encoder : streams_->decoder;
+    lzma_ret ret = lzma_pump(strm, {}, output, LZMA_FINISH);
+    if (ret != LZMA_STREAM_END) {
+        stream_error_ = fmt::format("LZMA {} failed: error {}",
+                                    compressing ? "compression" : "decompression", static_cast<int>(ret));
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// ZstdCompressor
+// ============================================================================
+
+// Long-distance matching from this level up, over a 128 MB window: the
+// largest the zstd tool decodes without --long
+static constexpr int ZSTD_LDM_MIN_LEVEL = 7;
+static constexpr int ZSTD_LDM_WINDOW_LOG = 27;
+
+static int zstd_level(int level) {
+    static constexpr int LEVELS[9] = {1, 2, 3, 4, 5, 6, 9, 15, 19};
+    return LEVELS[std::clamp(level, 1, 9) - 1];
+}
+
+struct ZstdCompressor::Streams {
+    ZSTD_CCtx* cctx = ZSTD_createCCtx();
+    ZSTD_DCtx* dctx = ZSTD_createDCtx();
+    
+    // Digested dictionary: compression tables are built for one level
+    ZSTD_CDict* cdict = nullptr;
+    int cdict_level = 0;
+    ZSTD_DDict* ddict = nullptr;
+    
+    // Incremental stream in progress
+    bool active = false;
+    StreamMode mode = StreamMode::COMPRESS;
+    size_t hint = 0;    // Last ZSTD_decompressStream result (0 = at a frame boundary)
+    
+    /**
+     * @brief Compression dictionary for a level, rebuilt only when it changes
+     * @return nullptr if there is no dictionary (or out of memory)
+     */
+    ZSTD_CDict* cdict_for(std::span<const uint8_t> dictionary, int level) {
+        if (dictionary.empty()) {
+            return nullptr;
+        }
+        if (!cdict || cdict_level != level) {
+            ZSTD_freeCDict(cdict);
+            cdict = ZSTD_createCDict(dictionary.data(), dictionary.size(), zstd_level(level));
+            cdict_level = level;
+        }
+        return cdict;
+    }
+    
+    void clear_dictionary() {
+        ZSTD_DCtx_refDDict(dctx, nullptr);
+        ZSTD_freeCDict(cdict);
+        ZSTD_freeDDict(ddict);
+        cdict = nullptr;
+        ddict = nullptr;
+    }
+    
+    ~Streams() {
+        ZSTD_freeCCtx(cctx);
+        ZSTD_freeDCtx(dctx);
+        ZSTD_freeCDict(cdict);
+        ZSTD_freeDDict(ddict);
+    }
+};
+
+/**
+ * @brief Reset the compression context and apply a level's parameters
+ * @return 0 or a zstd error code
+ */
+static size_t configure_zstd(ZSTD_CCtx* cctx, int level, size_t workers, std::optional<uint64_t> input_size,
+                             ZSTD_CDict* cdict = nullptr) {
+    level = std::clamp(level, 1, 9);
+    ZSTD_CCtx_reset(cctx, ZSTD_reset_session_and_parameters);
+    size_t ret = ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, zstd_level(level));
+    if (ZSTD_isError(ret)) {
+        return ret;
+    }
+    if (cdict) {
+        ret = ZSTD_CCtx_refCDict(cctx, cdict);
+        if (ZSTD_isError(ret)) {
+            return ret;
+        }
+    }
+    ZSTD_CCtx_setParameter(cctx, ZSTD_c_checksumFlag, 1);
+    if (level >= ZSTD_LDM_MIN_LEVEL) {
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_enableLongDistanceMatching, 1);
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_windowLog, ZSTD_LDM_WINDOW_LOG);
+    }
+    if (workers > 1) {
+        // Fails harmlessly (stays serial) without ZSTD_MULTITHREAD
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_nbWorkers, static_cast<int>(std::min<size_t>(workers, 200)));
+    }
+    if (input_size) {
+        ret = ZSTD_CCtx_setPledgedSrcSize(cctx, *input_size);
+    }
+    return ZSTD_isError(ret) ? ret : 0;
+}
+
+/**
+ * @brief Run ZSTD_compressStream2 over input, appending everything produced
+ * @return 0 once the input is consumed (and, for ZSTD_e_end, flushed), or an error code
+ */
+static size_t zstd_compress_pump(ZSTD_CCtx* cctx, std::span<const uint8_t> input,
+                                 std::vector<uint8_t>& output, ZSTD_EndDirective directive) {
+    ZSTD_inBuffer in{input.data(), input.size(), 0};
+    while (true) {
+        size_t used = output.size();
+        output.resize(used + STREAM_OUTPUT_STEP);
+        ZSTD_outBuffer out{output.data() + used, STREAM_OUTPUT_STEP, 0};
+        
+        size_t remaining = ZSTD_compressStream2(cctx, &out, &in, directive);
+        output.resize(used + out.pos);
+        
+        if (ZSTD_isError(remaining)) {
+            return remaining;
+        }
+        bool done = (directive == ZSTD_e_continue) ? in.pos == in.size : remaining == 0;
+        if (done) {
+            return 0;
+        }
+    }
+}
+
+/**
+ * @brief Run ZSTD_decompressStream over input, appending everything produced
+ * @param hint Receives the last result (0 when the data ends on a frame boundary)
+ * @return 0 once the input is consumed, or an error code
+ */
+static size_t zstd_decompress_pump(ZSTD_DCtx* dctx, std::span<const uint8_t> input,
+                                   std::vector<uint8_t>& output, size_t& hint) {
+    ZSTD_inBuffer in{input.data(), input.size(), 0};
+    while (true) {
+        size_t used = output.size();
+        output.resize(used + STREAM_OUTPUT_STEP);
+        ZSTD_outBuffer out{output.data() + used, STREAM_OUTPUT_STEP, 0};
+        
+        size_t ret = ZSTD_decompressStream(dctx, &out, &in);
+        output.resize(used + out.pos);
+        
+        if (ZSTD_isError(ret)) {
+            return ret;
+        }
+        hint = ret;
+        // A frame that ends exactly on a full step is done too: another call
+        // would start on the next frame and report its header as pending
+        if (in.pos == in.size && (out.pos < out.size || ret == 0)) {
+            return 0;
+        }
+    }
+}
+
+ZstdCompressor::ZstdCompressor() : streams_(std::make_unique<Streams>()) {}
+
+ZstdCompressor::~ZstdCompressor() = default;
+
+bool ZstdCompressor::set_dictionary(std::span<const uint8_t> dictionary) {
+    auto& st = *streams_;
+    st.active = false;
+    st.clear_dictionary();
+    dictionary_.assign(dictionary.begin(), dictionary.end());
+    if (!dictionary_.empty()) {
+        st.ddict = ZSTD_createDDict(dictionary_.data(), dictionary_.size());
+        if (!st.ddict || ZSTD_isError(ZSTD_DCtx_refDDict(st.dctx, st.ddict))) {
+            st.clear_dictionary();
+            dictionary_.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+CompressionResult ZstdCompressor::compress(
+    std::span<const uint8_t> input,
+    int level
+) {
+    utils::ScopedSpan trace_span("ZstdCompressor::compress", "compression", input.size());
+    CompressionResult result;
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    try {
+        streams_->active = false;
+        ZSTD_CCtx* cctx = streams_->cctx;
+        size_t ret = cctx ? configure_zstd(cctx, level, worker_count(), std::nullopt,
+                                           streams_->cdict_for(dictionary_, level)) : 0;
+        if (!cctx || ZSTD_isError(ret)) {
+            result.success = false;
+            result.error_message = fmt::format("zstd compression failed: {}",
+                                               cctx ? ZSTD_getErrorName(ret) : "out of memory");
+            return result;
+        }
+        
+        size_t bound = ZSTD_compressBound(input.size());
+        result.data = core::BufferPool::shared().acquire(bound);
+        result.data.resize(bound);
         
-        if (ret != Z_OK) {
+        ret = ZSTD_compress2(cctx, result.data.data(), bound, input.data(), input.size());
+        if (ZSTD_isError(ret)) {
             result.success = false;
-            result.error_message = fmt::format("zlib compression failed: error {}", ret);
+            result.error_message = fmt::format("zstd compression failed: {}", ZSTD_getErrorName(ret));
             return result;
         }
-        
-        // Resize to actual size
-        result.data.resize(dest_len);
+        result.data.resize(ret);
         
         result.success = true;
         result.original_size = input.size();
-        result.compressed_size = dest_len;
-        result.compression_ratio = 100.0 * (1.0 - static_cast<double>(dest_len) / input.size());
+        result.compressed_size = ret;
+        result.compression_ratio = 100.0 * (1.0 - static_cast<double>(ret) / input.size());
         
     } catch (const std::exception& e) {
         result.success = false;
@@ -101,45 +2168,48 @@ CompressionResult ZlibCompressor::compress(
     return result;
 }
 
-CompressionResult ZlibCompressor::decompress(std::span<const uint8_t> input) {
+CompressionResult ZstdCompressor::decompress(std::span<const uint8_t> input) {
+    utils::ScopedSpan trace_span("ZstdCompressor::decompress", "compression", input.size());
     CompressionResult result;
     auto start = std::chrono::high_resolution_clock::now();
     
     try {
-        // Start with 4x size, grow if needed
-        uLongf dest_len = input.size() * 4;
-        result.data.resize(dest_len);
-        
-        int ret = Z_BUF_ERROR;
-        int attempts = 0;
+        if (input.empty()) {
+            result.success = false;
+            result.error_message = "Empty input";
+            return result;
+        }
         
-        // Try decompression, growing buffer if needed
-        while (ret == Z_BUF_ERROR && attempts < 10) {
-            dest_len = result.data.size();
-            ret = ::uncompress(
-                result.data.data(),
-                &dest_len,
-                input.data(),
-                input.size()
-            );
-            
-            if (ret == Z_BUF_ERROR) {
-                result.data.resize(result.data.size() * 2);
-                attempts++;
-            }
+        // A single frame that records its size decodes in one exact pass
+        unsigned long long content_size = ZSTD_getFrameContentSize(input.data(), input.size());
+        if (content_size != ZSTD_CONTENTSIZE_UNKNOWN && content_size != ZSTD_CONTENTSIZE_ERROR &&
+            ZSTD_findFrameCompressedSize(input.data(), input.size()) == input.size()) {
+            return decompress(input, static_cast<size_t>(content_size));
         }
         
-        if (ret != Z_OK) {
+        streams_->active = false;
+        ZSTD_DCtx* dctx = streams_->dctx;
+        if (!dctx) {
             result.success = false;
-            result.error_message = fmt::format("zlib decompression failed: error {}", ret);
+            result.error_message = "zstd decompression failed: out of memory";
             return result;
         }
+        ZSTD_DCtx_reset(dctx, ZSTD_reset_session_only);
         
-        result.data.resize(dest_len);
+        result.data = core::BufferPool::shared().acquire(input.size() * 4);
+        size_t hint = 0;
+        size_t ret = zstd_decompress_pump(dctx, input, result.data, hint);
+        if (ZSTD_isError(ret) || hint != 0) {
+            result.success = false;
+            result.error_message = ZSTD_isError(ret)
+                ? fmt::format("zstd decompression failed: {}", ZSTD_getErrorName(ret))
+                : std::string("zstd decompression failed: stream is truncated");
+            return result;
+        }
         
         result.success = true;
         result.original_size = input.size();
-        result.compressed_size = dest_len;
+        result.compressed_size = result.data.size();
         
     } catch (const std::exception& e) {
         result.success = false;
@@ -152,184 +2222,289 @@ CompressionResult ZlibCompressor::decompress(std::span<const uint8_t> input) {
     return result;
 }
 
-// ============================================================================
-// Bzip2Compressor - Using BZIP3 API
-// ============================================================================
-
-CompressionResult Bzip2Compressor::compress(
-    std::span<const uint8_t> input,
-    int level
-) {
+CompressionResult ZstdCompressor::decompress(std::span<const uint8_t> input, size_t expected_size) {
+    utils::ScopedSpan trace_span("ZstdCompressor::decompress", "compression", input.size());
     CompressionResult result;
     auto start = std::chrono::high_resolution_clock::now();
     
     try {
-        if (input.empty()) {
+        streams_->active = false;
+        ZSTD_DCtx* dctx = streams_->dctx;
+        if (!dctx) {
             result.success = false;
-            result.error_message = "Empty input";
+            result.error_message = "zstd decompression failed: out of memory";
             return result;
         }
+        ZSTD_DCtx_reset(dctx, ZSTD_reset_session_only);
         
-        // BZIP3 block size (65KB to 511MB, recommended: 1MB to 8MB)
-        // Level 1-9 maps to block sizes
-        int32_t block_size;
-        if (level <= 3) {
-            block_size = 1 * 1024 * 1024;      // 1MB - fast
-        } else if (level <= 6) {
-            block_size = 4 * 1024 * 1024;      // 4MB - balanced
-        } else {
-            block_size = 8 * 1024 * 1024;      // 8MB - best compression
-        }
-        
-        // Calculate output buffer size
-        size_t out_size = bz3_bound(input.size());
-        result.data.resize(out_size);
-        
-        // Compress using bzip3
-        int status = bz3_compress(
-            block_size,
-            input.data(),
-            result.data.data(),
-            input.size(),
-            &out_size
-        );
+        // One pass into a buffer of exactly the expected size
+        result.data = core::BufferPool::shared().acquire(expected_size);
+        result.data.resize(expected_size);
         
-        if (status != BZ3_OK) {
+        size_t ret = ZSTD_decompressDCtx(dctx, result.data.data(), expected_size, input.data(), input.size());
+        if (ZSTD_isError(ret) || ret != expected_size) {
             result.success = false;
-            result.error_message = std::format("BZIP3 compression failed with error code: {}", status);
+            result.error_message = (!ZSTD_isError(ret) || ZSTD_getErrorCode(ret) == ZSTD_error_dstSize_tooSmall)
+                ? fmt::format("zstd decompression failed: size does not match the expected {} bytes", expected_size)
+                : fmt::format("zstd decompression failed: {}", ZSTD_getErrorName(ret));
             return result;
         }
         
-        // Resize to actual compressed size
-        result.data.resize(out_size);
-        
-        auto end = std::chrono::high_resolution_clock::now();
-        result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
         result.success = true;
+        result.original_size = input.size();
+        result.compressed_size = expected_size;
         
     } catch (const std::exception& e) {
         result.success = false;
-        result.error_message = std::format("BZIP3 compression error: {}", e.what());
+        result.error_message = e.what();
     }
     
+    auto end = std::chrono::high_resolution_clock::now();
+    result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    
     return result;
 }
 
-CompressionResult Bzip2Compressor::decompress(std::span<const uint8_t> input) {
+bool ZstdCompressor::begin(StreamMode mode, int level, std::optional<uint64_t> input_size) {
+    stream_error_.clear();
+    auto& st = *streams_;
+    st.active = false;
+    if (!st.cctx || !st.dctx) {
+        stream_error_ = "zstd stream initialization failed: out of memory";
+        return false;
+    }
+    
+    if (mode == StreamMode::COMPRESS) {
+        size_t ret = configure_zstd(st.cctx, level, worker_count(), input_size,
+                                    st.cdict_for(dictionary_, level));
+        if (ZSTD_isError(ret)) {
+            stream_error_ = fmt::format("zstd stream initialization failed: {}", ZSTD_getErrorName(ret));
+            return false;
+        }
+    } else {
+        ZSTD_DCtx_reset(st.dctx, ZSTD_reset_session_only);
+        st.hint = 1;  // Nothing decoded yet
+    }
+    
+    st.active = true;
+    st.mode = mode;
+    return true;
+}
+
+bool ZstdCompressor::update(std::span<const uint8_t> input, std::vector<uint8_t>& output) {
+    auto& st = *streams_;
+    if (!st.active) {
+        stream_error_ = "No zstd stream in progress";
+        return false;
+    }
+    if (input.empty()) {
+        return true;
+    }
+    
+    bool compressing = (st.mode == StreamMode::COMPRESS);
+    size_t ret = compressing
+        ? zstd_compress_pump(st.cctx, input, output, ZSTD_e_continue)
+        : zstd_decompress_pump(st.dctx, input, output, st.hint);
+    if (ZSTD_isError(ret)) {
+        st.active = false;
+        stream_error_ = fmt::format("zstd {} failed: {}",
+                                    compressing ? "compression" : "decompression", ZSTD_getErrorName(ret));
+        return false;
+    }
+    return true;
+}
+
+bool ZstdCompressor::finish(std::vector<uint8_t>& output) {
+    auto& st = *streams_;
+    if (!st.active) {
+        stream_error_ = "No zstd stream in progress";
+        return false;
+    }
+    st.active = false;
+    
+    if (st.mode == StreamMode::DECOMPRESS) {
+        if (st.hint != 0) {
+            stream_error_ = "zstd decompression failed: stream is truncated";
+            return false;
+        }
+        return true;
+    }
+    
+    size_t ret = zstd_compress_pump(st.cctx, {}, output, ZSTD_e_end);
+    if (ZSTD_isError(ret)) {
+        stream_error_ = fmt::format("zstd compression failed: {}", ZSTD_getErrorName(ret));
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// Lz4Compressor
+// ============================================================================
+
+struct Lz4Compressor::Streams {
+    LZ4F_cctx* cctx = nullptr;
+    LZ4F_dctx* dctx = nullptr;
+    
+    // Incremental stream in progress
+    bool active = false;
+    StreamMode mode = StreamMode::COMPRESS;
+    LZ4F_preferences_t preferences{};
+    bool header_written = false;
+    size_t hint = 0;    // Last LZ4F_decompress result (0 = at a frame boundary)
+    
+    Streams() {
+        LZ4F_createCompressionContext(&cctx, LZ4F_VERSION);
+        LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION);
+    }
+    
+    ~Streams() {
+        LZ4F_freeCompressionContext(cctx);
+        LZ4F_freeDecompressionContext(dctx);
+    }
+};
+
+static LZ4F_preferences_t lz4_preferences(int level, std::optional<uint64_t> input_size) {
+    LZ4F_preferences_t preferences{};
+    preferences.frameInfo.blockSizeID = LZ4F_max4MB;
+    preferences.frameInfo.blockMode = LZ4F_blockLinked;
+    preferences.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+    preferences.frameInfo.contentSize = input_size.value_or(0);
+    
+    level = std::clamp(level, 1, 9);
+    preferences.compressionLevel = level <= 3 ? 0 : level + 3;  // 0 = fast, 7-12 = HC
+    return preferences;
+}
+
+/**
+ * @brief Run LZ4F_decompress over input, appending everything produced
+ * @param hint Receives the last result (0 when the data ends on a frame boundary)
+ * @return 0 once the input is consumed, or an error code
+ */
+static size_t lz4_decompress_pump(LZ4F_dctx* dctx, std::span<const uint8_t> input,
+                                  std::vector<uint8_t>& output, size_t& hint) {
+    const uint8_t* in = input.data();
+    size_t in_left = input.size();
+    while (true) {
+        size_t used = output.size();
+        output.resize(used + STREAM_OUTPUT_STEP);
+        size_t dst_size = STREAM_OUTPUT_STEP;
+        size_t src_size = in_left;
+        
+        size_t ret = LZ4F_decompress(dctx, output.data() + used, &dst_size, in, &src_size, nullptr);
+        output.resize(used + dst_size);
+        
+        if (LZ4F_isError(ret)) {
+            return ret;
+        }
+        in += src_size;
+        in_left -= src_size;
+        hint = ret;
+        // As in zstd_decompress_pump(): stop at a frame end that fills the step
+        if (in_left == 0 && (dst_size < STREAM_OUTPUT_STEP || ret == 0)) {
+            return 0;
+        }
+    }
+}
+
+Lz4Compressor::Lz4Compressor() : streams_(std::make_unique<Streams>()) {}
+
+Lz4Compressor::~Lz4Compressor() = default;
+
+CompressionResult Lz4Compressor::compress(
+    std::span<const uint8_t> input,
+    int level
+) {
+    utils::ScopedSpan trace_span("Lz4Compressor::compress", "compression", input.size());
     CompressionResult result;
     auto start = std::chrono::high_resolution_clock::now();
     
     try {
-        if (input.empty()) {
+        streams_->active = false;
+        LZ4F_cctx* cctx = streams_->cctx;
+        if (!cctx) {
             result.success = false;
-            result.error_message = "Empty input";
+            result.error_message = "LZ4 compression failed: out of memory";
             return result;
         }
         
-        // For decompression, bz3_decompress needs the EXACT output size
-        // BZIP3 stores frame size in header, but we don't parse it here
-        // Use a large buffer and let bzip3 tell us the actual size
-        // Typical compression ratio: 5-20%, so 100x should be safe
-        size_t estimated_size = std::max<size_t>(input.size() * 100, 1024 * 1024);  // At least 1MB
-        result.data.resize(estimated_size);
-        
-        size_t out_size = estimated_size;
-        int status = bz3_decompress(
-            input.data(),
-            result.data.data(),
-            input.size(),
-            &out_size
-        );
+        // Record the size so decompression can use an exact buffer
+        auto preferences = lz4_preferences(level, input.size());
+        size_t bound = LZ4F_HEADER_SIZE_MAX + LZ4F_compressBound(input.size(), &preferences);
+        result.data = core::BufferPool::shared().acquire(bound);
+        result.data.resize(bound);
         
-        // If buffer too small, try with maximum possible size
-        if (status == BZ3_ERR_DATA_TOO_BIG || status == BZ3_ERR_DATA_SIZE_TOO_SMALL) {
-            estimated_size = input.size() * 1000;  // 1000x
-            result.data.resize(estimated_size);
-            out_size = estimated_size;
-            
-            status = bz3_decompress(
-                input.data(),
-                result.data.data(),
-                input.size(),
-                &out_size
-            );
+        // Begin/update/end on the persistent context rather than LZ4F_compressFrame,
+        // which allocates a fresh one per call
+        size_t written = LZ4F_compressBegin(cctx, result.data.data(), bound, &preferences);
+        size_t ret = written;
+        if (!LZ4F_isError(ret)) {
+            ret = LZ4F_compressUpdate(cctx, result.data.data() + written, bound - written,
+                                      input.data(), input.size(), nullptr);
         }
-        
-        if (status != BZ3_OK) {
+        if (!LZ4F_isError(ret)) {
+            written += ret;
+            ret = LZ4F_compressEnd(cctx, result.data.data() + written, bound - written, nullptr);
+        }
+        if (LZ4F_isError(ret)) {
             result.success = false;
-            result.error_message = std::format("BZIP3 decompression failed with error code: {}", status);
+            result.error_message = fmt::format("LZ4 compression failed: {}", LZ4F_getErrorName(ret));
             return result;
         }
+        written += ret;
+        result.data.resize(written);
         
-        // Resize to actual decompressed size
-        result.data.resize(out_size);
-        
-        auto end = std::chrono::high_resolution_clock::now();
-        result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
         result.success = true;
+        result.original_size = input.size();
+        result.compressed_size = written;
+        result.compression_ratio = 100.0 * (1.0 - static_cast<double>(written) / input.size());
         
     } catch (const std::exception& e) {
         result.success = false;
-        result.error_message = std::format("BZIP3 decompression error: {}", e.what());
+        result.error_message = e.what();
     }
     
+    auto end = std::chrono::high_resolution_clock::now();
+    result.processing_time_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    
     return result;
 }
 
-// ============================================================================
-// LzmaCompressor
-// ============================================================================
-
-CompressionResult LzmaCompressor::compress(
-    std::span<const uint8_t> input,
-    int level
-) {
+CompressionResult Lz4Compressor::decompress(std::span<const uint8_t> input) {
+    utils::ScopedSpan trace_span("Lz4Compressor::decompress", "compression", input.size());
     CompressionResult result;
     auto start = std::chrono::high_resolution_clock::now();
     
     try {
-        level = std::clamp(level, 1, 9);
-        
-        // LZMA properties
-        lzma_stream strm = LZMA_STREAM_INIT;
-        
-        // Initialize encoder
-        lzma_ret ret = lzma_easy_encoder(&strm, level, LZMA_CHECK_CRC64);
-        if (ret != LZMA_OK) {
+        if (input.empty()) {
             result.success = false;
-            result.error_message = "LZMA encoder initialization failed";
+            result.error_message = "Empty input";
             return result;
         }
         
-        // Allocate output buffer
-        size_t out_size = lzma_stream_buffer_bound(input.size());
-        result.data.resize(out_size);
-        
-        // Setup streams
-        strm.next_in = input.data();
-        strm.avail_in = input.size();
-        strm.next_out = result.data.data();
-        strm.avail_out = result.data.size();
-        
-        // Compress
-        ret = lzma_code(&strm, LZMA_FINISH);
-        
-        if (ret != LZMA_STREAM_END) {
-            lzma_end(&strm);
+        streams_->active = false;
+        LZ4F_dctx* dctx = streams_->dctx;
+        if (!dctx) {
             result.success = false;
-            result.error_message = fmt::format("LZMA compression failed: error {}", static_cast<int>(ret));
+            result.error_message = "LZ4 decompression failed: out of memory";
             return result;
         }
+        LZ4F_resetDecompressionContext(dctx);
         
-        size_t compressed_size = strm.total_out;
-        lzma_end(&strm);
-        
-        result.data.resize(compressed_size);
+        result.data = core::BufferPool::shared().acquire(input.size() * 4);
+        size_t hint = 0;
+        size_t ret = lz4_decompress_pump(dctx, input, result.data, hint);
+        if (LZ4F_isError(ret) || hint != 0) {
+            result.success = false;
+            result.error_message = LZ4F_isError(ret)
+                ? fmt::format("LZ4 decompression failed: {}", LZ4F_getErrorName(ret))
+                : std::string("LZ4 decompression failed: stream is truncated");
+            return result;
+        }
         
         result.success = true;
         result.original_size = input.size();
-        result.compressed_size = compressed_size;
-        result.compression_ratio = 100.0 * (1.0 - static_cast<double>(compressed_size) / input.size());
+        result.compressed_size = result.data.size();
         
     } catch (const std::exception& e) {
         result.success = false;
@@ -342,64 +2517,55 @@ CompressionResult LzmaCompressor::compress(
     return result;
 }
 
-CompressionResult LzmaCompressor::decompress(std::span<const uint8_t> input) {
+CompressionResult Lz4Compressor::decompress(std::span<const uint8_t> input, size_t expected_size) {
+    utils::ScopedSpan trace_span("Lz4Compressor::decompress", "compression", input.size());
     CompressionResult result;
     auto start = std::chrono::high_resolution_clock::now();
     
     try {
-        lzma_stream strm = LZMA_STREAM_INIT;
-        
-        // Initialize decoder
-        lzma_ret ret = lzma_stream_decoder(&strm, UINT64_MAX, LZMA_CONCATENATED);
-        if (ret != LZMA_OK) {
+        streams_->active = false;
+        LZ4F_dctx* dctx = streams_->dctx;
+        if (!dctx) {
             result.success = false;
-            result.error_message = "LZMA decoder initialization failed";
+            result.error_message = "LZ4 decompression failed: out of memory";
             return result;
         }
+        LZ4F_resetDecompressionContext(dctx);
         
-        // Allocate output buffer
-        result.data.resize(input.size() * 4);
-        
-        strm.next_in = input.data();
-        strm.avail_in = input.size();
-        strm.next_out = result.data.data();
-        strm.avail_out = result.data.size();
+        // One pass into a buffer of exactly the expected size
+        result.data = core::BufferPool::shared().acquire(expected_size);
+        result.data.resize(expected_size);
         
-        // Decompress, growing buffer if needed
-        while (true) {
-            // Use LZMA_FINISH for single-call decompression when all input is available
-            lzma_action action = (strm.avail_in > 0) ? LZMA_RUN : LZMA_FINISH;
-            ret = lzma_code(&strm, action);
-            
-            if (ret == LZMA_STREAM_END) {
+        const uint8_t* in = input.data();
+        size_t in_left = input.size();
+        size_t produced = 0;
+        size_t ret = 1;
+        while (in_left > 0) {
+            size_t dst_size = expected_size - produced;
+            size_t src_size = in_left;
+            ret = LZ4F_decompress(dctx, result.data.data() + produced, &dst_size, in, &src_size, nullptr);
+            if (LZ4F_isError(ret)) {
                 break;
             }
-            
-            if (ret == LZMA_OK && strm.avail_out == 0) {
-                // Need more output space
-                size_t old_size = result.data.size();
-                result.data.resize(old_size * 2);
-                strm.next_out = result.data.data() + old_size;
-                strm.avail_out = old_size;
-                continue;
-            }
-            
-            if (ret != LZMA_OK) {
-                lzma_end(&strm);
-                result.success = false;
-                result.error_message = fmt::format("LZMA decompression failed: error {}", static_cast<int>(ret));
-                return result;
+            produced += dst_size;
+            in += src_size;
+            in_left -= src_size;
+            if (src_size == 0 && dst_size == 0) {
+                break;  // Output is full but the frame goes on
             }
         }
         
-        size_t decompressed_size = strm.total_out;
-        lzma_end(&strm);
-        
-        result.data.resize(decompressed_size);
+        if (LZ4F_isError(ret) || ret != 0 || in_left != 0 || produced != expected_size) {
+            result.success = false;
+            result.error_message = LZ4F_isError(ret)
+                ? fmt::format("LZ4 decompression failed: {}", LZ4F_getErrorName(ret))
+                : fmt::format("LZ4 decompression failed: size does not match the expected {} bytes", expected_size);
+            return result;
+        }
         
         result.success = true;
         result.original_size = input.size();
-        result.compressed_size = decompressed_size;
+        result.compressed_size = expected_size;
         
     } catch (const std::exception& e) {
         result.success = false;
@@ -412,5 +2578,109 @@ CompressionResult LzmaCompressor::decompress(std::span<const uint8_t> input) {
     return result;
 }
 
+bool Lz4Compressor::begin(StreamMode mode, int level, std::optional<uint64_t> input_size) {
+    stream_error_.clear();
+    auto& st = *streams_;
+    st.active = false;
+    if (!st.cctx || !st.dctx) {
+        stream_error_ = "LZ4 stream initialization failed: out of memory";
+        return false;
+    }
+    
+    if (mode == StreamMode::COMPRESS) {
+        // The frame header is emitted with the first call so begin() needs no output
+        st.preferences = lz4_preferences(level, input_size);
+        st.header_written = false;
+    } else {
+        LZ4F_resetDecompressionContext(st.dctx);
+        st.hint = 1;  // Nothing decoded yet
+    }
+    
+    st.active = true;
+    st.mode = mode;
+    return true;
+}
+
+bool Lz4Compressor::update(std::span<const uint8_t> input, std::vector<uint8_t>& output) {
+    auto& st = *streams_;
+    if (!st.active) {
+        stream_error_ = "No LZ4 stream in progress";
+        return false;
+    }
+    
+    if (st.mode == StreamMode::DECOMPRESS) {
+        if (input.empty()) {
+            return true;
+        }
+        size_t ret = lz4_decompress_pump(st.dctx, input, output, st.hint);
+        if (LZ4F_isError(ret)) {
+            st.active = false;
+            stream_error_ = fmt::format("LZ4 decompression failed: {}", LZ4F_getErrorName(ret));
+            return false;
+        }
+        return true;
+    }
+    
+    size_t used = output.size();
+    output.resize(used + LZ4F_HEADER_SIZE_MAX + LZ4F_compressBound(input.size(), &st.preferences));
+    size_t ret = 0;
+    if (!st.header_written) {
+        ret = LZ4F_compressBegin(st.cctx, output.data() + used, output.size() - used, &st.preferences);
+        if (!LZ4F_isError(ret)) {
+            used += ret;
+            st.header_written = true;
+        }
+    }
+    if (!LZ4F_isError(ret) && !input.empty()) {
+        ret = LZ4F_compressUpdate(st.cctx, output.data() + used, output.size() - used,
+                                  input.data(), input.size(), nullptr);
+        if (!LZ4F_isError(ret)) {
+            used += ret;
+        }
+    }
+    output.resize(used);
+    
+    if (LZ4F_isError(ret)) {
+        st.active = false;
+        stream_error_ = fmt::format("LZ4 compression failed: {}", LZ4F_getErrorName(ret));
+        return false;
+    }
+    return true;
+}
+
+bool Lz4Compressor::finish(std::vector<uint8_t>& output) {
+    auto& st = *streams_;
+    if (!st.active) {
+        stream_error_ = "No LZ4 stream in progress";
+        return false;
+    }
+    
+    if (st.mode == StreamMode::DECOMPRESS) {
+        st.active = false;
+        if (st.hint != 0) {
+            stream_error_ = "LZ4 decompression failed: stream is truncated";
+            return false;
+        }
+        return true;
+    }
+    
+    // Emits the header for empty input
+    if (!update({}, output)) {
+        return false;
+    }
+    st.active = false;
+    
+    size_t used = output.size();
+    output.resize(used + LZ4F_compressBound(0, &st.preferences));
+    size_t ret = LZ4F_compressEnd(st.cctx, output.data() + used, output.size() - used, nullptr);
+    if (LZ4F_isError(ret)) {
+        output.resize(used);
+        stream_error_ = fmt::format("LZ4 compression failed: {}", LZ4F_getErrorName(ret));
+        return false;
+    }
+    output.resize(used + ret);
+    return true;
+}
+
 } // namespace compression
 } // namespace filevault
@@ -0,0 +1,108 @@
+/**
+ * @file dictionary.cpp
+ * @brief On-disk store of trained compression dictionaries
+ */
+
+#include "filevault/compression/dictionary.hpp"
+#include "filevault/compression/compressor.hpp"
+#include <fmt/core.h>
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iterator>
+
+namespace filevault {
+namespace compression {
+
+static constexpr const char* DICTIONARY_EXTENSION = ".dict";
+
+DictionaryStore::DictionaryStore(std::filesystem::path directory)
+    : directory_(std::move(directory)) {}
+
+std::filesystem::path DictionaryStore::path_for(uint32_t id) const {
+    return directory_ / (format_id(id) + DICTIONARY_EXTENSION);
+}
+
+std::string DictionaryStore::format_id(uint32_t id) {
+    return fmt::format("{:08x}", id);
+}
+
+uint32_t DictionaryStore::parse_id(const std::string& text) {
+    std::string digits = text;
+    if (digits.size() > 2 && digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X')) {
+        digits = digits.substr(2);
+    }
+    if (digits.empty() || digits.size() > 8 ||
+        !std::all_of(digits.begin(), digits.end(), [](unsigned char c) { return std::isxdigit(c); })) {
+        return 0;
+    }
+    return static_cast<uint32_t>(std::stoul(digits, nullptr, 16));
+}
+
+core::Result<uint32_t> DictionaryStore::save(std::span<const uint8_t> dictionary) {
+    uint32_t id = CompressionService::dictionary_id(dictionary);
+    if (id == 0) {
+        return core::Result<uint32_t>::error("Not a trained dictionary (no dictionary ID)");
+    }
+    
+    auto path = path_for(id);
+    std::error_code ec;
+    if (std::filesystem::exists(path, ec)) {
+        return core::Result<uint32_t>::ok(id);
+    }
+    std::filesystem::create_directories(directory_, ec);
+    
+    // Write to a temporary name first so a half-written file is never found by ID
+    auto temp_path = path;
+    temp_path += ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(dictionary.data()),
+                   static_cast<std::streamsize>(dictionary.size()));
+        if (!file) {
+            std::filesystem::remove(temp_path, ec);
+            return core::Result<uint32_t>::error("Cannot write dictionary: " + temp_path.string());
+        }
+    }
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec) {
+        std::filesystem::remove(temp_path, ec);
+        return core::Result<uint32_t>::error("Cannot store dictionary: " + path.string());
+    }
+    return core::Result<uint32_t>::ok(id);
+}
+
+core::Result<std::vector<uint8_t>> DictionaryStore::load(uint32_t id) const {
+    auto path = path_for(id);
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return core::Result<std::vector<uint8_t>>::error(
+            fmt::format("Compression dictionary {} not found in {}", format_id(id), directory_.string()));
+    }
+    std::vector<uint8_t> dictionary{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    
+    // The file name is only a lookup key; trust the ID inside
+    if (CompressionService::dictionary_id(dictionary) != id) {
+        return core::Result<std::vector<uint8_t>>::error(
+            fmt::format("Compression dictionary file {} is corrupt", path.string()));
+    }
+    return core::Result<std::vector<uint8_t>>::ok(std::move(dictionary));
+}
+
+std::vector<uint32_t> DictionaryStore::list() const {
+    std::vector<uint32_t> ids;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(directory_, ec)) {
+        if (entry.path().extension() == DICTIONARY_EXTENSION) {
+            uint32_t id = parse_id(entry.path().stem().string());
+            if (id != 0) {
+                ids.push_back(id);
+            }
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+} // namespace compression
+} // namespace filevault
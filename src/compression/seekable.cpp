@@ -0,0 +1,353 @@
+/**
+ * @file seekable.cpp
+ * @brief Independently compressed frames with a zstd-style seek table
+ */
+
+#include "filevault/compression/seekable.hpp"
+#include "filevault/compression/compressor.hpp"
+#include "filevault/core/thread_pool.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <span>
+
+namespace filevault {
+namespace compression {
+
+namespace {
+
+void put_le32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+uint32_t get_le32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+/**
+ * @brief One compressor per frame slot, and a pool to run the slots on
+ */
+struct FrameWorkers {
+    std::vector<std::unique_ptr<ICompressor>> compressors;
+    std::unique_ptr<core::ThreadPool> pool;
+
+    FrameWorkers(core::CompressionType type, size_t threads) {
+        size_t count = threads == 0 ? core::ThreadPool::default_thread_count() : threads;
+        for (size_t i = 0; i < std::max<size_t>(count, 1); ++i) {
+            auto compressor = CompressionService::create(type);
+            if (!compressor) {
+                break;
+            }
+            // Parallelism comes from the frames
+            compressor->set_threads(1);
+            compressors.push_back(std::move(compressor));
+        }
+        if (compressors.size() > 1) {
+            pool = std::make_unique<core::ThreadPool>(compressors.size());
+        }
+    }
+
+    size_t size() const { return compressors.size(); }
+
+    /**
+     * @brief Run job(slot, compressor) for slots [0, count), in parallel if possible
+     */
+    template<typename Job>
+    std::vector<CompressionResult> run(size_t count, Job job) {
+        std::vector<CompressionResult> results(count);
+        if (!pool || count == 1) {
+            for (size_t i = 0; i < count; ++i) {
+                results[i] = job(i, *compressors[i]);
+            }
+            return results;
+        }
+        std::vector<std::future<CompressionResult>> pending;
+        pending.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            pending.push_back(pool->submit([&job, i, this]() { return job(i, *compressors[i]); }));
+        }
+        for (size_t i = 0; i < count; ++i) {
+            results[i] = pending[i].get();
+        }
+        return results;
+    }
+};
+
+/**
+ * @brief Output file that is removed again unless committed
+ */
+class PartialOutput {
+public:
+    explicit PartialOutput(const std::string& path)
+        : path_(path), out_(path, std::ios::binary | std::ios::trunc) {}
+
+    ~PartialOutput() {
+        if (!committed_) {
+            out_.close();
+            std::error_code ec;
+            std::filesystem::remove(path_, ec);
+        }
+    }
+
+    bool is_open() const { return out_.is_open(); }
+
+    bool write(std::span<const uint8_t> data) {
+        out_.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        written_ += data.size();
+        return static_cast<bool>(out_);
+    }
+
+    bool commit() {
+        out_.close();
+        committed_ = !out_.fail();
+        return committed_;
+    }
+
+    uint64_t written() const { return written_; }
+
+private:
+    std::string path_;
+    std::ofstream out_;
+    uint64_t written_ = 0;
+    bool committed_ = false;
+};
+
+} // anonymous namespace
+
+core::Result<uint64_t> SeekableCompression::compress_file(
+    core::CompressionType type,
+    const std::string& input_path,
+    const std::string& output_path,
+    int level,
+    uint64_t frame_size,
+    size_t threads)
+{
+    using R = core::Result<uint64_t>;
+    if (frame_size == 0 || frame_size > MAX_FRAME_SIZE) {
+        return R::error("Frame size must be between 1 byte and 1 GiB");
+    }
+    FrameWorkers workers(type, threads);
+    if (workers.size() == 0) {
+        return R::error("Unsupported compression algorithm");
+    }
+    std::ifstream in(input_path, std::ios::binary);
+    if (!in) {
+        return R::error("Cannot open input file: " + input_path);
+    }
+    PartialOutput out(output_path);
+    if (!out.is_open()) {
+        return R::error("Cannot create output file: " + output_path);
+    }
+
+    std::vector<std::vector<uint8_t>> inputs(workers.size());
+    std::vector<uint8_t> table;
+    put_le32(table, SKIPPABLE_MAGIC);
+    put_le32(table, 0);                 // Filled in once the frame count is known
+    uint32_t frame_count = 0;
+
+    while (true) {
+        size_t count = 0;
+        for (; count < inputs.size() && in; ++count) {
+            inputs[count].resize(frame_size);
+            in.read(reinterpret_cast<char*>(inputs[count].data()), static_cast<std::streamsize>(frame_size));
+            inputs[count].resize(static_cast<size_t>(in.gcount()));
+            if (inputs[count].empty()) {
+                break;
+            }
+        }
+        if (in.bad()) {
+            return R::error("Failed to read input file: " + input_path);
+        }
+        // An empty input still gets one (empty) frame, so the file starts with its format's magic
+        if (count == 0 && frame_count == 0) {
+            count = 1;
+        }
+        if (count == 0) {
+            break;
+        }
+
+        auto results = workers.run(count, [&](size_t i, ICompressor& compressor) {
+            if (!inputs[i].empty()) {
+                return compressor.compress(inputs[i], level);
+            }
+            // Not every one-shot compress() takes empty input; the stream does
+            CompressionResult empty;
+            empty.success = compressor.begin(StreamMode::COMPRESS, level, 0) && compressor.finish(empty.data);
+            empty.error_message = compressor.stream_error();
+            return empty;
+        });
+        for (size_t i = 0; i < count; ++i) {
+            if (!results[i].success) {
+                return R::error(results[i].error_message);
+            }
+            if (results[i].data.size() > UINT32_MAX) {
+                return R::error("Compressed frame exceeds 4 GiB");
+            }
+            if (!out.write(results[i].data)) {
+                return R::error("Failed to write output file: " + output_path);
+            }
+            put_le32(table, static_cast<uint32_t>(results[i].data.size()));
+            put_le32(table, static_cast<uint32_t>(inputs[i].size()));
+            ++frame_count;
+        }
+        if (count < inputs.size() || inputs[count - 1].size() < frame_size) {
+            break;
+        }
+    }
+
+    put_le32(table, frame_count);
+    table.push_back(0);                 // Descriptor: no checksums
+    put_le32(table, SEEKABLE_MAGIC);
+    uint32_t payload = static_cast<uint32_t>(table.size() - 8);
+    for (int i = 0; i < 4; ++i) {
+        table[4 + i] = static_cast<uint8_t>(payload >> (8 * i));
+    }
+    if (!out.write(table) || !out.commit()) {
+        return R::error("Failed to write output file: " + output_path);
+    }
+    return R::ok(out.written());
+}
+
+core::Result<std::vector<SeekableFrame>> SeekableCompression::read_index(const std::string& path) {
+    using R = core::Result<std::vector<SeekableFrame>>;
+    std::error_code ec;
+    uint64_t file_size = std::filesystem::file_size(path, ec);
+    std::ifstream in(path, std::ios::binary);
+    if (ec || !in) {
+        return R::error("Cannot open input file: " + path);
+    }
+    if (file_size < 8 + FOOTER_SIZE) {
+        return R::error("Not a seekable file: " + path);
+    }
+
+    uint8_t footer[FOOTER_SIZE];
+    in.seekg(static_cast<std::streamoff>(file_size - FOOTER_SIZE));
+    if (!in.read(reinterpret_cast<char*>(footer), FOOTER_SIZE) || get_le32(footer + 5) != SEEKABLE_MAGIC) {
+        return R::error("Not a seekable file: " + path);
+    }
+    uint64_t frame_count = get_le32(footer);
+    uint8_t descriptor = footer[4];
+    if (descriptor & 0x7C) {
+        return R::error("Unsupported seek table flags");
+    }
+    uint64_t entry_size = (descriptor & 0x80) ? 12 : 8;
+    uint64_t table_size = 8 + frame_count * entry_size + FOOTER_SIZE;
+    if (table_size > file_size) {
+        return R::error("Corrupt seek table: larger than the file");
+    }
+
+    std::vector<uint8_t> table(static_cast<size_t>(table_size - FOOTER_SIZE));
+    in.seekg(static_cast<std::streamoff>(file_size - table_size));
+    if (!in.read(reinterpret_cast<char*>(table.data()), static_cast<std::streamsize>(table.size()))) {
+        return R::error("Failed to read seek table");
+    }
+    if (get_le32(table.data()) != SKIPPABLE_MAGIC || get_le32(table.data() + 4) != table_size - 8) {
+        return R::error("Corrupt seek table header");
+    }
+
+    std::vector<SeekableFrame> frames(static_cast<size_t>(frame_count));
+    uint64_t compressed = 0;
+    uint64_t decompressed = 0;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        const uint8_t* entry = table.data() + 8 + i * entry_size;
+        frames[i].compressed_offset = compressed;
+        frames[i].decompressed_offset = decompressed;
+        frames[i].compressed_size = get_le32(entry);
+        frames[i].decompressed_size = get_le32(entry + 4);
+        compressed += frames[i].compressed_size;
+        decompressed += frames[i].decompressed_size;
+    }
+    if (compressed != file_size - table_size) {
+        return R::error("Corrupt seek table: frame sizes do not match the file");
+    }
+    return R::ok(std::move(frames));
+}
+
+bool SeekableCompression::is_seekable(const std::string& path) {
+    return static_cast<bool>(read_index(path));
+}
+
+core::Result<uint64_t> SeekableCompression::decompress_file(
+    core::CompressionType type,
+    const std::string& input_path,
+    const std::string& output_path,
+    uint64_t offset,
+    uint64_t length,
+    size_t threads)
+{
+    using R = core::Result<uint64_t>;
+    auto index = read_index(input_path);
+    if (!index) {
+        return R::error(index.error_message);
+    }
+    const auto& frames = index.value;
+    uint64_t total = frames.empty() ? 0 : frames.back().decompressed_offset + frames.back().decompressed_size;
+    if (offset > total) {
+        return R::error("Range starts past the end of the data (" + std::to_string(total) + " bytes)");
+    }
+    uint64_t end = total - offset < length ? total : offset + length;
+
+    // Frames overlapping [offset, end)
+    auto first = std::upper_bound(frames.begin(), frames.end(), offset,
+        [](uint64_t value, const SeekableFrame& frame) { return value < frame.decompressed_offset; });
+    if (first != frames.begin()) {
+        --first;
+    }
+    auto last = std::lower_bound(first, frames.end(), end,
+        [](const SeekableFrame& frame, uint64_t value) { return frame.decompressed_offset < value; });
+
+    FrameWorkers workers(type, threads);
+    if (workers.size() == 0) {
+        return R::error("Unsupported compression algorithm");
+    }
+    std::ifstream in(input_path, std::ios::binary);
+    if (!in) {
+        return R::error("Cannot open input file: " + input_path);
+    }
+    PartialOutput out(output_path);
+    if (!out.is_open()) {
+        return R::error("Cannot create output file: " + output_path);
+    }
+
+    std::vector<std::vector<uint8_t>> inputs(workers.size());
+    for (auto batch = first; batch < last; ) {
+        size_t count = std::min<size_t>(inputs.size(), static_cast<size_t>(last - batch));
+        in.seekg(static_cast<std::streamoff>(batch->compressed_offset));
+        for (size_t i = 0; i < count; ++i) {
+            inputs[i].resize(batch[i].compressed_size);
+            if (!in.read(reinterpret_cast<char*>(inputs[i].data()), static_cast<std::streamsize>(inputs[i].size()))) {
+                return R::error("Failed to read input file: " + input_path);
+            }
+        }
+
+        auto results = workers.run(count, [&](size_t i, ICompressor& compressor) {
+            return compressor.decompress(inputs[i], batch[i].decompressed_size);
+        });
+        for (size_t i = 0; i < count; ++i) {
+            if (!results[i].success) {
+                return R::error(results[i].error_message);
+            }
+            const auto& frame = batch[i];
+            uint64_t from = std::max(offset, frame.decompressed_offset) - frame.decompressed_offset;
+            uint64_t to = std::min<uint64_t>(end, frame.decompressed_offset + frame.decompressed_size) -
+                          frame.decompressed_offset;
+            if (!out.write(std::span<const uint8_t>(results[i].data).subspan(from, to - from))) {
+                return R::error("Failed to write output file: " + output_path);
+            }
+        }
+        batch += static_cast<std::ptrdiff_t>(count);
+    }
+
+    if (!out.commit()) {
+        return R::error("Failed to write output file: " + output_path);
+    }
+    return R::ok(out.written());
+}
+
+} // namespace compression
+} // namespace filevault
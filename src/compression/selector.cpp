@@ -0,0 +1,159 @@
+/**
+ * @file selector.cpp
+ * @brief Sample-based choice of compression algorithm and level
+ */
+
+#include "filevault/compression/selector.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+namespace filevault {
+namespace compression {
+
+namespace {
+
+constexpr size_t SAMPLE_BLOCKS = 4;
+constexpr size_t SAMPLE_BLOCK_SIZE = 64 * 1024;
+constexpr double MIN_USEFUL_RATIO = 1.02;   // Must save at least 2%
+
+// Fastest first; level 6 of an algorithm follows its level 1
+constexpr std::array<core::CompressionType, 5> CANDIDATES = {
+    core::CompressionType::LZ4,
+    core::CompressionType::ZSTD,
+    core::CompressionType::ZLIB,
+    core::CompressionType::BZIP2,
+    core::CompressionType::LZMA,
+};
+constexpr std::array<int, 2> CANDIDATE_LEVELS = {1, 6};
+
+/**
+ * @brief Offsets of the sampled blocks in an input of the given size
+ */
+std::vector<uint64_t> sample_offsets(uint64_t size) {
+    std::vector<uint64_t> offsets;
+    if (size <= SAMPLE_BLOCKS * SAMPLE_BLOCK_SIZE) {
+        offsets.push_back(0);
+        return offsets;
+    }
+    uint64_t stride = (size - SAMPLE_BLOCK_SIZE) / (SAMPLE_BLOCKS - 1);
+    for (size_t i = 0; i < SAMPLE_BLOCKS; ++i) {
+        offsets.push_back(i * stride);
+    }
+    return offsets;
+}
+
+} // anonymous namespace
+
+std::vector<uint8_t> CompressionSelector::sample(std::span<const uint8_t> data) {
+    if (data.size() <= SAMPLE_BLOCKS * SAMPLE_BLOCK_SIZE) {
+        return {data.begin(), data.end()};
+    }
+    std::vector<uint8_t> out;
+    out.reserve(SAMPLE_BLOCKS * SAMPLE_BLOCK_SIZE);
+    for (uint64_t offset : sample_offsets(data.size())) {
+        auto block = data.subspan(static_cast<size_t>(offset), SAMPLE_BLOCK_SIZE);
+        out.insert(out.end(), block.begin(), block.end());
+    }
+    return out;
+}
+
+core::Result<std::vector<uint8_t>> CompressionSelector::sample_file(const std::string& path) {
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(path, ec);
+    std::ifstream file(path, std::ios::binary);
+    if (ec || !file) {
+        return core::Result<std::vector<uint8_t>>::error("Cannot read " + path + " to choose compression");
+    }
+    
+    auto result = sample_stream(file, size);
+    if (!result) {
+        return core::Result<std::vector<uint8_t>>::error("Cannot read " + path + " to choose compression");
+    }
+    return result;
+}
+
+core::Result<std::vector<uint8_t>> CompressionSelector::sample_stream(std::istream& file, uint64_t size) {
+    size_t block = size <= SAMPLE_BLOCKS * SAMPLE_BLOCK_SIZE ? static_cast<size_t>(size) : SAMPLE_BLOCK_SIZE;
+    std::vector<uint8_t> out;
+    for (uint64_t offset : sample_offsets(size)) {
+        size_t used = out.size();
+        out.resize(used + block);
+        file.seekg(static_cast<std::streamoff>(offset));
+        file.read(reinterpret_cast<char*>(out.data() + used), static_cast<std::streamsize>(block));
+        if (!file) {
+            return core::Result<std::vector<uint8_t>>::error("Cannot read input to choose compression");
+        }
+    }
+    return core::Result<std::vector<uint8_t>>::ok(std::move(out));
+}
+
+CompressionChoice CompressionSelector::select(std::span<const uint8_t> sample, double min_mbps) {
+    CompressionChoice best;
+    if (sample.empty() || CompressionService::likely_incompressible(sample)) {
+        return best;
+    }
+    
+    double sample_mb = sample.size() / 1024.0 / 1024.0;
+    for (auto type : CANDIDATES) {
+        auto compressor = CompressionService::create(type);
+        if (!compressor) {
+            continue;
+        }
+        compressor->set_threads(1);  // The target is per thread
+        
+        for (int level : CANDIDATE_LEVELS) {
+            CompressionResult result;
+            double ms = time_compression(*compressor, sample, level, 1, &result);
+            if (!result.success || result.data.empty()) {
+                break;
+            }
+            double mbps = ms > 0 ? sample_mb / (ms / 1000.0) : 1e9;
+            double ratio = static_cast<double>(sample.size()) / result.data.size();
+            SPDLOG_DEBUG("Compression candidate {} level {}: {:.2f}x at {:.0f} MB/s",
+                          compressor->name(), level, ratio, mbps);
+            if (mbps < min_mbps) {
+                break;  // Higher levels are slower still
+            }
+            if (ratio >= MIN_USEFUL_RATIO && ratio > best.ratio) {
+                best = {type, level, ratio, mbps};
+            }
+        }
+    }
+    return best;
+}
+
+double CompressionSelector::time_compression(ICompressor& compressor, std::span<const uint8_t> data,
+                                             int level, int runs, CompressionResult* last) {
+    runs = std::max(1, runs);
+    double total_ms = 0.0;
+    CompressionResult result;
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        result = compressor.compress(data, level);
+        auto end = std::chrono::high_resolution_clock::now();
+        total_ms += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+    if (last) {
+        *last = std::move(result);
+    }
+    return total_ms / runs;
+}
+
+double CompressionSelector::time_decompression(ICompressor& compressor, std::span<const uint8_t> data, int runs) {
+    runs = std::max(1, runs);
+    double total_ms = 0.0;
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        auto result = compressor.decompress(data);
+        auto end = std::chrono::high_resolution_clock::now();
+        total_ms += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+    return total_ms / runs;
+}
+
+} // namespace compression
+} // namespace filevault
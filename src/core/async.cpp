@@ -0,0 +1,122 @@
+/**
+ * @file async.cpp
+ * @brief Awaitable forms of the blocking library calls
+ */
+
+#include "filevault/core/async.hpp"
+#include "filevault/utils/file_io.hpp"
+
+namespace filevault {
+namespace core {
+
+namespace {
+
+/**
+ * @brief Progress callback that reports through the options and stops on cancellation
+ */
+StreamProgressCallback progress_for(const AsyncOptions& options, StreamProgressCallback user) {
+    return [token = options.token, dispatch = options.dispatch, on_progress = options.on_progress,
+            user = std::move(user)](const ChunkInfo& info) {
+        if (on_progress) {
+            if (dispatch) {
+                dispatch([on_progress, info]() { on_progress(info); });
+            } else {
+                on_progress(info);
+            }
+        }
+        if (user && !user(info)) {
+            return false;
+        }
+        return !token.cancelled();
+    };
+}
+
+StreamingResult unless_cancelled(StreamingResult result, const CancellationToken& token) {
+    if (!result.success && token.cancelled()) {
+        throw TaskCancelled();
+    }
+    return result;
+}
+
+} // anonymous namespace
+
+AsyncOperation<StreamingResult> AsyncCrypto::encrypt_file(std::string input_path, std::string output_path,
+                                                          std::string password, StreamingConfig config,
+                                                          AsyncOptions options) {
+    config.progress_callback = progress_for(options, std::move(config.progress_callback));
+    auto token = options.token;
+    return run_async([input_path = std::move(input_path), output_path = std::move(output_path),
+                      password = std::move(password), config = std::move(config), token]() {
+        return unless_cancelled(StreamingCrypto::encrypt_file(input_path, output_path, password, config), token);
+    }, std::move(options));
+}
+
+AsyncOperation<StreamingResult> AsyncCrypto::decrypt_file(std::string input_path, std::string output_path,
+                                                          std::string password, size_t worker_threads,
+                                                          AsyncOptions options) {
+    auto progress = progress_for(options, nullptr);
+    auto token = options.token;
+    return run_async([input_path = std::move(input_path), output_path = std::move(output_path),
+                      password = std::move(password), progress = std::move(progress), worker_threads, token]() {
+        return unless_cancelled(
+            StreamingCrypto::decrypt_file(input_path, output_path, password, progress, worker_threads), token);
+    }, std::move(options));
+}
+
+AsyncOperation<CryptoResult> AsyncCrypto::encrypt(ICryptoAlgorithm& algorithm, std::vector<uint8_t> plaintext,
+                                                  std::vector<uint8_t> key, EncryptionConfig config,
+                                                  AsyncOptions options) {
+    return run_async([&algorithm, plaintext = std::move(plaintext), key = std::move(key),
+                      config = std::move(config)]() { return algorithm.encrypt(plaintext, key, config); },
+                     std::move(options));
+}
+
+AsyncOperation<CryptoResult> AsyncCrypto::decrypt(ICryptoAlgorithm& algorithm, std::vector<uint8_t> ciphertext,
+                                                  std::vector<uint8_t> key, EncryptionConfig config,
+                                                  AsyncOptions options) {
+    return run_async([&algorithm, ciphertext = std::move(ciphertext), key = std::move(key),
+                      config = std::move(config)]() { return algorithm.decrypt(ciphertext, key, config); },
+                     std::move(options));
+}
+
+AsyncOperation<compression::CompressionResult> AsyncCrypto::compress(CompressionType type,
+                                                                     std::vector<uint8_t> data, int level,
+                                                                     AsyncOptions options) {
+    return run_async([type, data = std::move(data), level]() {
+        auto compressor = compression::CompressionService::create(type);
+        if (!compressor) {
+            compression::CompressionResult result;
+            result.error_message = "Compression algorithm not available";
+            return result;
+        }
+        return compressor->compress(data, level);
+    }, std::move(options));
+}
+
+AsyncOperation<compression::CompressionResult> AsyncCrypto::decompress(CompressionType type,
+                                                                       std::vector<uint8_t> data,
+                                                                       AsyncOptions options) {
+    return run_async([type, data = std::move(data)]() {
+        auto compressor = compression::CompressionService::create(type);
+        if (!compressor) {
+            compression::CompressionResult result;
+            result.error_message = "Compression algorithm not available";
+            return result;
+        }
+        return compressor->decompress(data);
+    }, std::move(options));
+}
+
+AsyncOperation<Result<std::vector<uint8_t>>> AsyncCrypto::read_file(std::string path, AsyncOptions options) {
+    return run_async([path = std::move(path)]() { return utils::FileIO::read_file(path); }, std::move(options));
+}
+
+AsyncOperation<Result<void>> AsyncCrypto::write_file(std::string path, std::vector<uint8_t> data,
+                                                     AsyncOptions options) {
+    return run_async([path = std::move(path), data = std::move(data)]() {
+        return utils::FileIO::write_file(path, data);
+    }, std::move(options));
+}
+
+} // namespace core
+} // namespace filevault
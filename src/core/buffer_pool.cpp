@@ -0,0 +1,152 @@
+/**
+ * @file buffer_pool.cpp
+ * @brief Reusable byte buffer cache
+ */
+
+#include "filevault/core/buffer_pool.hpp"
+#include "filevault/core/numa.hpp"
+#include <botan/mem_ops.h>
+#include <cstdint>
+#include <fstream>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace filevault {
+namespace core {
+
+BufferPool::BufferPool(size_t max_cached_bytes)
+    : buffers_(Numa::node_count()), max_cached_bytes_(max_cached_bytes) {}
+
+std::vector<uint8_t> BufferPool::acquire(size_t min_capacity) {
+    bool numa = Numa::enabled();
+    size_t node = numa ? Numa::current_node() % buffers_.size() : 0;
+    if (min_capacity >= MIN_POOLED_CAPACITY) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& buffers = buffers_[node];
+        auto it = buffers.lower_bound(min_capacity);
+        // Don't hand a huge buffer to a small request
+        if (it != buffers.end() && it->first / 2 <= min_capacity) {
+            std::vector<uint8_t> buffer = std::move(it->second);
+            cached_bytes_ -= it->first;
+            buffers.erase(it);
+            return buffer;
+        }
+    }
+
+    std::vector<uint8_t> buffer;
+    buffer.reserve(min_capacity);
+    // reserve() touches no pages, so they can still be placed
+    if (numa && min_capacity >= MIN_POOLED_CAPACITY) {
+        Numa::prefer_node(buffer.data(), buffer.capacity(), node);
+    }
+    if (min_capacity >= HUGE_PAGE_SIZE && huge_pages()) {
+        advise_huge_pages(buffer.data(), buffer.capacity());
+    }
+    return buffer;
+}
+
+void BufferPool::release(std::vector<uint8_t>&& buffer, bool scrub) {
+    if (scrub && !buffer.empty()) {
+        Botan::secure_scrub_memory(buffer.data(), buffer.size());
+    }
+    buffer.clear();
+
+    size_t capacity = buffer.capacity();
+    if (capacity < MIN_POOLED_CAPACITY) {
+        return;
+    }
+
+    // Filed under the node the memory is on, not the releasing thread's
+    size_t node = Numa::enabled() ? Numa::node_of_memory(buffer.data()) % buffers_.size() : 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cached_bytes_ + capacity > max_cached_bytes_) {
+        return;  // Over budget: let the buffer be freed
+    }
+    cached_bytes_ += capacity;
+    buffers_[node].emplace(capacity, std::move(buffer));
+}
+
+void BufferPool::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& buffers : buffers_) {
+        buffers.clear();
+    }
+    cached_bytes_ = 0;
+}
+
+void BufferPool::set_max_cached_bytes(size_t max_cached_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_cached_bytes_ = max_cached_bytes;
+    // Largest buffers go first when the budget shrinks
+    while (cached_bytes_ > max_cached_bytes_) {
+        std::multimap<size_t, std::vector<uint8_t>>* holder = nullptr;
+        for (auto& buffers : buffers_) {
+            if (!buffers.empty() && (!holder || buffers.rbegin()->first > holder->rbegin()->first)) {
+                holder = &buffers;
+            }
+        }
+        if (!holder) {
+            break;
+        }
+        auto largest = std::prev(holder->end());
+        cached_bytes_ -= largest->first;
+        holder->erase(largest);
+    }
+}
+
+void BufferPool::set_huge_pages(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    huge_pages_ = enabled;
+}
+
+bool BufferPool::huge_pages() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return huge_pages_;
+}
+
+bool BufferPool::advise_huge_pages(void* data, size_t size) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(data) + HUGE_PAGE_SIZE - 1) & ~uintptr_t(HUGE_PAGE_SIZE - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(data) + size) & ~uintptr_t(HUGE_PAGE_SIZE - 1);
+    if (!data || end <= begin) {
+        return false;
+    }
+    return madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE) == 0;
+#else
+    (void)data;
+    (void)size;
+    return false;
+#endif
+}
+
+std::string BufferPool::transparent_huge_page_mode() {
+    // e.g. "always [madvise] never"
+    std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+    std::string modes;
+    if (!file || !std::getline(file, modes)) {
+        return "";
+    }
+    size_t open = modes.find('[');
+    size_t close = modes.find(']', open);
+    return open == std::string::npos || close == std::string::npos ? "" : modes.substr(open + 1, close - open - 1);
+}
+
+size_t BufferPool::cached_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cached_bytes_;
+}
+
+size_t BufferPool::max_cached_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return max_cached_bytes_;
+}
+
+BufferPool& BufferPool::shared() {
+    static BufferPool pool;
+    return pool;
+}
+
+} // namespace core
+} // namespace filevault
@@ -0,0 +1,169 @@
+/**
+ * @file checkpoint.cpp
+ * @brief Checkpoint sidecars for resumable streaming jobs
+ */
+
+#include "filevault/core/checkpoint.hpp"
+#include "filevault/core/header_codec.hpp"
+#include <botan/hash.h>
+#include <spdlog/spdlog.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace filevault {
+namespace core {
+
+static constexpr uint8_t CHECKPOINT_MAGIC[4] = {'F', 'V', 'C', 'P'};
+static constexpr uint8_t CHECKPOINT_VERSION = 1;
+static constexpr size_t CHECKPOINT_SIZE = 8 + 7 * 8 + 32;
+
+void Checkpoint::add_tag(std::span<const uint8_t> tag) {
+    auto hash = Botan::HashFunction::create_or_throw("SHA-256");
+    hash->update(tag_digest.data(), tag_digest.size());
+    hash->update(tag.data(), tag.size());
+    hash->final(tag_digest.data());
+}
+
+bool Checkpoint::stamp_input(const std::string& input_path) {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(input_path, ec);
+    if (ec) {
+        return false;
+    }
+    auto mtime = std::filesystem::last_write_time(input_path, ec);
+    if (ec) {
+        return false;
+    }
+    input_size = size;
+    input_mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+    return true;
+}
+
+bool Checkpoint::matches_input(const std::string& input_path) const {
+    Checkpoint current;
+    return current.stamp_input(input_path) &&
+           current.input_size == input_size &&
+           current.input_mtime == input_mtime;
+}
+
+bool Checkpoint::save(const std::string& path) const {
+    HeaderWriter<CHECKPOINT_SIZE> out;
+    out.bytes(CHECKPOINT_MAGIC);
+    out.u8(CHECKPOINT_VERSION);
+    out.u8(static_cast<uint8_t>(operation));
+    out.zeros(2);
+    out.u64(input_size);
+    out.u64(static_cast<uint64_t>(input_mtime));
+    out.u64(chunk_size);
+    out.u64(chunks_committed);
+    out.u64(input_offset);
+    out.u64(output_offset);
+    out.u64(bytes_committed);
+    out.bytes(tag_digest);
+
+    // A crash mid-write leaves the old sidecar in place, never a torn one
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out.write_to(file)) {
+            return false;
+        }
+        file.flush();
+        if (!file) {
+            return false;
+        }
+    }
+    if (!sync_file(temp_path)) {
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec) {
+        spdlog::warn("Failed to replace checkpoint {}: {}", path, ec.message());
+        return false;
+    }
+    return true;
+}
+
+std::optional<Checkpoint> Checkpoint::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    uint8_t buffer[CHECKPOINT_SIZE];
+    file.read(reinterpret_cast<char*>(buffer), CHECKPOINT_SIZE);
+    if (!file) {
+        return std::nullopt;
+    }
+
+    try {
+        HeaderReader in(buffer);
+        if (std::memcmp(in.bytes(4, "magic").data(), CHECKPOINT_MAGIC, 4) != 0 ||
+            in.u8("version") != CHECKPOINT_VERSION) {
+            return std::nullopt;
+        }
+
+        Checkpoint checkpoint;
+        uint8_t operation = in.u8("operation");
+        if (operation != static_cast<uint8_t>(Operation::ENCRYPT) &&
+            operation != static_cast<uint8_t>(Operation::DECRYPT)) {
+            return std::nullopt;
+        }
+        checkpoint.operation = static_cast<Operation>(operation);
+        in.skip(2, "reserved bytes");
+        checkpoint.input_size = in.u64("input size");
+        checkpoint.input_mtime = static_cast<int64_t>(in.u64("input time"));
+        checkpoint.chunk_size = in.u64("chunk size");
+        checkpoint.chunks_committed = in.u64("chunk count");
+        checkpoint.input_offset = in.u64("input offset");
+        checkpoint.output_offset = in.u64("output offset");
+        checkpoint.bytes_committed = in.u64("committed bytes");
+        auto digest = in.bytes(checkpoint.tag_digest.size(), "tag digest");
+        std::memcpy(checkpoint.tag_digest.data(), digest.data(), digest.size());
+        return checkpoint;
+    } catch (const std::runtime_error&) {
+        return std::nullopt;
+    }
+}
+
+void Checkpoint::remove(const std::string& path) {
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    std::filesystem::remove(path + ".tmp", ec);
+}
+
+bool sync_file(const std::string& path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    bool ok = FlushFileBuffers(file) != 0;
+    CloseHandle(file);
+    return ok;
+#else
+    // fsync covers the file, not just this descriptor's writes
+    int fd = open(path.c_str(), O_RDWR);
+    if (fd < 0) {
+        return false;
+    }
+    int rc;
+    do {
+        rc = fsync(fd);
+    } while (rc != 0 && errno == EINTR);
+    close(fd);
+    return rc == 0;
+#endif
+}
+
+} // namespace core
+} // namespace filevault
@@ -0,0 +1,190 @@
+/**
+ * @file cpu_features.cpp
+ * @brief CPU capability probe
+ */
+
+#include "filevault/core/cpu_features.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <sstream>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <intrin.h>
+    #include <immintrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+    #include <cpuid.h>
+#endif
+
+#if defined(__aarch64__) && defined(__linux__)
+    #include <sys/auxv.h>
+#endif
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#endif
+
+namespace filevault {
+namespace core {
+
+namespace {
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #define FILEVAULT_X86 1
+void cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+    int out[4];
+    __cpuidex(out, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i) regs[i] = static_cast<unsigned>(out[i]);
+}
+unsigned long long xgetbv() { return _xgetbv(0); }
+#elif defined(__x86_64__) || defined(__i386__)
+    #define FILEVAULT_X86 1
+void cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+    regs[0] = regs[1] = regs[2] = regs[3] = 0;
+    __get_cpuid_count(leaf, subleaf, &regs[0], &regs[1], &regs[2], &regs[3]);
+}
+unsigned long long xgetbv() {
+    unsigned lo = 0, hi = 0;
+    __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<unsigned long long>(hi) << 32) | lo;
+}
+#endif
+
+void probe(CpuFeatures& f) {
+#if defined(FILEVAULT_X86)
+    f.architecture = sizeof(void*) == 8 ? "x86_64" : "x86";
+    
+    unsigned regs[4];
+    cpuid(0, 0, regs);
+    unsigned max_leaf = regs[0];
+    
+    cpuid(1, 0, regs);
+    unsigned ecx1 = regs[2], edx1 = regs[3];
+    f.sse2 = (edx1 >> 26) & 1;
+    f.ssse3 = (ecx1 >> 9) & 1;
+    f.sse42 = (ecx1 >> 20) & 1;
+    f.aesni = (ecx1 >> 25) & 1;
+    f.clmul = (ecx1 >> 1) & 1;
+    
+    // Wide registers are only usable if the OS saves their state
+    bool osxsave = (ecx1 >> 27) & 1;
+    unsigned long long xcr0 = osxsave ? xgetbv() : 0;
+    bool ymm_ok = (xcr0 & 0x6) == 0x6;
+    bool zmm_ok = (xcr0 & 0xE6) == 0xE6;
+    
+    if (max_leaf >= 7) {
+        cpuid(7, 0, regs);
+        unsigned ebx7 = regs[1], ecx7 = regs[2];
+        f.avx2 = ymm_ok && ((ebx7 >> 5) & 1);
+        f.avx512 = zmm_ok && ((ebx7 >> 16) & 1);
+        f.sha = (ebx7 >> 29) & 1;
+        f.vaes = ymm_ok && ((ecx7 >> 9) & 1);
+        f.vpclmulqdq = ymm_ok && ((ecx7 >> 10) & 1);
+    }
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    f.architecture = "aarch64";
+    f.neon = true;  // Mandatory in ARMv8-A
+    #if defined(__APPLE__)
+        // Every Apple silicon core has the crypto extensions
+        f.armv8aes = f.armv8pmull = f.armv8sha2 = f.armv8crc32 = true;
+    #elif defined(__linux__)
+        unsigned long hwcap = getauxval(AT_HWCAP);
+        f.armv8aes = (hwcap >> 3) & 1;     // HWCAP_AES
+        f.armv8pmull = (hwcap >> 4) & 1;   // HWCAP_PMULL
+        f.armv8sha2 = (hwcap >> 6) & 1;    // HWCAP_SHA2
+        f.armv8crc32 = (hwcap >> 7) & 1;   // HWCAP_CRC32
+    #elif defined(_WIN32)
+        bool crypto = IsProcessorFeaturePresent(PF_ARM_V8_CRYPTO_INSTRUCTIONS_AVAILABLE);
+        f.armv8aes = f.armv8pmull = f.armv8sha2 = crypto;
+        f.armv8crc32 = IsProcessorFeaturePresent(PF_ARM_V8_CRC32_INSTRUCTIONS_AVAILABLE);
+    #endif
+#else
+    f.architecture = "unknown";
+#endif
+}
+
+// Clear every feature named in a comma-separated list
+void apply_clear_list(CpuFeatures& f, const std::string& list) {
+    std::stringstream ss(list);
+    std::string name;
+    while (std::getline(ss, name, ',')) {
+        name.erase(std::remove_if(name.begin(), name.end(), ::isspace), name.end());
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        
+        if (name == "sse2") f.sse2 = false;
+        else if (name == "ssse3") f.ssse3 = false;
+        else if (name == "sse42") f.sse42 = false;
+        else if (name == "avx2") f.avx2 = false;
+        else if (name == "avx512") f.avx512 = false;
+        else if (name == "aesni") f.aesni = false;
+        else if (name == "clmul") f.clmul = false;
+        else if (name == "vaes") f.vaes = false;
+        else if (name == "vpclmulqdq") f.vpclmulqdq = false;
+        else if (name == "sha" || name == "intel_sha") f.sha = false;
+        else if (name == "neon") f.neon = false;
+        else if (name == "armv8aes") f.armv8aes = false;
+        else if (name == "armv8pmull") f.armv8pmull = false;
+        else if (name == "armv8sha2") f.armv8sha2 = false;
+        else if (name == "armv8crc32") f.armv8crc32 = false;
+    }
+}
+
+} // anonymous namespace
+
+const CpuFeatures& CpuFeatures::detect() {
+    static const CpuFeatures features = []() {
+        CpuFeatures f;
+        probe(f);
+        if (const char* cleared = std::getenv("BOTAN_CLEAR_CPUID")) {
+            apply_clear_list(f, cleared);
+        }
+        return f;
+    }();
+    return features;
+}
+
+bool CpuFeatures::hardware_aes() const {
+    return (aesni && clmul) || (armv8aes && armv8pmull);
+}
+
+AlgorithmType CpuFeatures::preferred_aead() const {
+    return hardware_aes() ? AlgorithmType::AES_256_GCM : AlgorithmType::CHACHA20_POLY1305;
+}
+
+std::vector<std::string> CpuFeatures::names() const {
+    std::vector<std::string> out;
+    auto add = [&out](bool present, const char* name) {
+        if (present) out.emplace_back(name);
+    };
+    add(sse2, "sse2");
+    add(ssse3, "ssse3");
+    add(sse42, "sse42");
+    add(avx2, "avx2");
+    add(avx512, "avx512");
+    add(aesni, "aesni");
+    add(clmul, "clmul");
+    add(vaes, "vaes");
+    add(vpclmulqdq, "vpclmulqdq");
+    add(sha, "sha");
+    add(neon, "neon");
+    add(armv8aes, "armv8aes");
+    add(armv8pmull, "armv8pmull");
+    add(armv8sha2, "armv8sha2");
+    add(armv8crc32, "armv8crc32");
+    return out;
+}
+
+void CpuFeatures::disable_features(const std::string& features) {
+    if (features.empty() || std::getenv("BOTAN_CLEAR_CPUID") != nullptr) {
+        return;
+    }
+#if defined(_WIN32)
+    _putenv_s("BOTAN_CLEAR_CPUID", features.c_str());
+#else
+    setenv("BOTAN_CLEAR_CPUID", features.c_str(), 0);
+#endif
+}
+
+} // namespace core
+} // namespace filevault
@@ -0,0 +1,177 @@
+/**
+ * @file crypto_algorithm.cpp
+ * @brief Default cipher session and batch implementations
+ */
+
+#include "filevault/core/crypto_algorithm.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace filevault {
+namespace core {
+
+BatchResult ICipherSession::encrypt_batch(
+    std::span<const std::span<const uint8_t>> messages,
+    const EncryptionConfig& config,
+    std::vector<uint8_t>& arena) {
+    
+    BatchResult result;
+    size_t arena_start = arena.size();
+    result.records.reserve(messages.size());
+    
+    // Let encrypt_in_place() pick a fresh nonce for every message
+    EncryptionConfig message_config = config;
+    message_config.nonce.reset();
+    
+    std::vector<uint8_t> scratch;
+    for (size_t i = 0; i < messages.size(); ++i) {
+        scratch.assign(messages[i].begin(), messages[i].end());
+        auto sealed = encrypt_in_place(scratch, message_config);
+        if (!sealed.success || !sealed.nonce.has_value() || !sealed.tag.has_value()) {
+            arena.resize(arena_start);
+            result.records.clear();
+            result.failed_index = i;
+            result.error_message = sealed.success ? "Cipher returned no nonce or tag" : sealed.error_message;
+            return result;
+        }
+        
+        const auto& nonce = sealed.nonce.value();
+        const auto& tag = sealed.tag.value();
+        
+        BatchRecord record;
+        record.offset = arena.size();
+        record.nonce_size = nonce.size();
+        record.data_size = scratch.size();
+        record.tag_size = tag.size();
+        
+        arena.insert(arena.end(), nonce.begin(), nonce.end());
+        arena.insert(arena.end(), scratch.begin(), scratch.end());
+        arena.insert(arena.end(), tag.begin(), tag.end());
+        result.records.push_back(record);
+    }
+    
+    result.success = true;
+    return result;
+}
+
+BatchResult ICipherSession::decrypt_batch(
+    std::span<const uint8_t> arena,
+    std::span<const BatchRecord> records,
+    const EncryptionConfig& config,
+    std::vector<uint8_t>& output) {
+    
+    BatchResult result;
+    size_t output_start = output.size();
+    result.records.reserve(records.size());
+    
+    EncryptionConfig message_config = config;
+    std::vector<uint8_t> scratch;
+    
+    for (size_t i = 0; i < records.size(); ++i) {
+        const auto& record = records[i];
+        CryptoResult opened;
+        
+        if (record.offset > arena.size() || record.total_size() > arena.size() - record.offset) {
+            opened.error_message = "Record out of bounds";
+        } else if (record.nonce_size > ShortBytes::capacity() || record.tag_size > ShortBytes::capacity()) {
+            opened.error_message = "Invalid nonce or tag size";
+        } else {
+            auto message = record.view(arena);
+            message_config.nonce = message.nonce;
+            message_config.tag = message.tag;
+            scratch.assign(message.data.begin(), message.data.end());
+            opened = decrypt_in_place(scratch, message_config);
+        }
+        
+        if (!opened.success) {
+            std::fill(output.begin() + output_start, output.end(), 0);
+            output.resize(output_start);
+            result.records.clear();
+            result.failed_index = i;
+            result.error_message = opened.error_message;
+            return result;
+        }
+        
+        BatchRecord plain;
+        plain.offset = output.size();
+        plain.data_size = scratch.size();
+        output.insert(output.end(), scratch.begin(), scratch.end());
+        result.records.push_back(plain);
+    }
+    
+    result.success = true;
+    return result;
+}
+
+bool ICipherSession::encrypt_begin(const EncryptionConfig&) {
+    return false;
+}
+
+size_t ICipherSession::encrypt_update(std::span<uint8_t>) {
+    throw std::logic_error("Incremental encryption not supported");
+}
+
+CryptoResult ICipherSession::encrypt_finish(std::vector<uint8_t>& buffer) {
+    buffer.clear();
+    CryptoResult result;
+    result.success = false;
+    result.error_message = "Incremental encryption not supported";
+    return result;
+}
+
+bool ICipherSession::decrypt_begin(const EncryptionConfig&) {
+    return false;
+}
+
+size_t ICipherSession::decrypt_update(std::span<uint8_t>) {
+    throw std::logic_error("Incremental decryption not supported");
+}
+
+CryptoResult ICipherSession::decrypt_finish(std::vector<uint8_t>& buffer) {
+    buffer.clear();
+    CryptoResult result;
+    result.success = false;
+    result.error_message = "Incremental decryption not supported";
+    return result;
+}
+
+std::unique_ptr<ICipherSession> ICryptoAlgorithm::create_session(std::span<const uint8_t> key) {
+    if (key.size() != key_size()) {
+        return nullptr;
+    }
+    return std::make_unique<KeyedCipherSession>(*this, key);
+}
+
+BatchResult ICryptoAlgorithm::encrypt_batch(
+    std::span<const std::span<const uint8_t>> messages,
+    std::span<const uint8_t> key,
+    const EncryptionConfig& config,
+    std::vector<uint8_t>& arena) {
+    
+    auto session = create_session(key);
+    if (!session) {
+        BatchResult result;
+        result.error_message = "Invalid key size";
+        return result;
+    }
+    return session->encrypt_batch(messages, config, arena);
+}
+
+BatchResult ICryptoAlgorithm::decrypt_batch(
+    std::span<const uint8_t> arena,
+    std::span<const BatchRecord> records,
+    std::span<const uint8_t> key,
+    const EncryptionConfig& config,
+    std::vector<uint8_t>& output) {
+    
+    auto session = create_session(key);
+    if (!session) {
+        BatchResult result;
+        result.error_message = "Invalid key size";
+        return result;
+    }
+    return session->decrypt_batch(arena, records, config, output);
+}
+
+} // namespace core
+} // namespace filevault
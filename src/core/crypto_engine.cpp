@@ -1,4 +1,5 @@
 #include "filevault/core/crypto_engine.hpp"
+#include "filevault/core/algorithm_traits.hpp"
 #include "filevault/core/types.hpp"
 #include "filevault/algorithms/symmetric/aes_gcm.hpp"
 #include "filevault/algorithms/symmetric/aes_cbc.hpp"
@@ -14,6 +15,9 @@
 #include "filevault/algorithms/symmetric/camellia_gcm.hpp"
 #include "filevault/algorithms/symmetric/aria_gcm.hpp"
 #include "filevault/algorithms/symmetric/sm4_gcm.hpp"
+#include "filevault/algorithms/symmetric/aegis256.hpp"
+#include "filevault/algorithms/symmetric/aes_ocb.hpp"
+#include "filevault/algorithms/symmetric/aes_siv.hpp"
 #include "filevault/algorithms/asymmetric/rsa.hpp"
 #include "filevault/algorithms/asymmetric/ecc.hpp"
 #include "filevault/algorithms/pqc/post_quantum.hpp"
@@ -22,8 +26,14 @@
 #include "filevault/algorithms/classical/playfair.hpp"
 #include "filevault/algorithms/classical/hill.hpp"
 #include "filevault/algorithms/classical/substitution.hpp"
-#include <botan/auto_rng.h>
+#include "filevault/core/kdf_scheduler.hpp"
+#include "filevault/core/key_cache.hpp"
+#include "filevault/core/memory_budget.hpp"
+#include "filevault/core/random.hpp"
+#include "filevault/utils/run_stats.hpp"
+#include "filevault/utils/trace.hpp"
 #include <botan/argon2.h>
+#include <botan/kdf.h>
 #include <botan/pwdhash.h>
 #include <spdlog/spdlog.h>
 #include <algorithm>
@@ -32,103 +42,140 @@
 namespace filevault {
 namespace core {
 
+// Batch file salts start with this; the HKDF label of their subkeys
+static constexpr uint8_t BATCH_SALT_MAGIC[4] = {'F', 'V', 'B', 'K'};
+static constexpr char BATCH_KEY_LABEL[] = "FileVault batch file key";
+
 CryptoEngine::CryptoEngine() {
-    spdlog::debug("CryptoEngine created");
+    SPDLOG_DEBUG("CryptoEngine created");
 }
 
 CryptoEngine::~CryptoEngine() {
-    spdlog::debug("CryptoEngine destroyed");
+    SPDLOG_DEBUG("CryptoEngine destroyed");
 }
 
 void CryptoEngine::initialize() {
-    spdlog::info("Initializing CryptoEngine...");
-    
-    // Register modern symmetric algorithms (AEAD)
-    register_algorithm(std::make_unique<algorithms::symmetric::AES_GCM>(128));
-    register_algorithm(std::make_unique<algorithms::symmetric::AES_GCM>(192));
-    register_algorithm(std::make_unique<algorithms::symmetric::AES_GCM>(256));
-    register_algorithm(std::make_unique<algorithms::symmetric::ChaCha20Poly1305>());
-    register_algorithm(std::make_unique<algorithms::symmetric::Serpent_GCM>());
-    register_algorithm(std::make_unique<algorithms::symmetric::Twofish_GCM>(128));
-    register_algorithm(std::make_unique<algorithms::symmetric::Twofish_GCM>(192));
-    register_algorithm(std::make_unique<algorithms::symmetric::Twofish_GCM>(256));
-    
-    // Register international standard algorithms
-    register_algorithm(std::make_unique<algorithms::symmetric::Camellia_GCM>(128));
-    register_algorithm(std::make_unique<algorithms::symmetric::Camellia_GCM>(192));
-    register_algorithm(std::make_unique<algorithms::symmetric::Camellia_GCM>(256));
-    register_algorithm(std::make_unique<algorithms::symmetric::ARIA_GCM>(128));
-    register_algorithm(std::make_unique<algorithms::symmetric::ARIA_GCM>(192));
-    register_algorithm(std::make_unique<algorithms::symmetric::ARIA_GCM>(256));
-    register_algorithm(std::make_unique<algorithms::symmetric::SM4_GCM>());
-    
-    // Register non-AEAD symmetric algorithms (CBC, CTR modes)
-    register_algorithm(std::make_unique<algorithms::symmetric::AES_CBC>(128));
-    register_algorithm(std::make_unique<algorithms::symmetric::AES_CBC>(192));
-    register_algorithm(std::make_unique<algorithms::symmetric::AES_CBC>(256));
-    register_algorithm(std::make_unique<algorithms::symmetric::AES_CTR>(128));
-    register_algorithm(std::make_unique<algorithms::symmetric::AES_CTR>(192));
-    register_algorithm(std::make_unique<algorithms::symmetric::AES_CTR>(256));
-    
-    // Register CFB mode algorithms
-    register_algorithm(std::make_unique<algorithms::symmetric::AES_CFB>(128));
-    register_algorithm(std::make_unique<algorithms::symmetric::AES_CFB>(192));
-    register_algorithm(std::make_unique<algorithms::symmetric::AES_CFB>(256));
-    
-    // Register OFB mode algorithms
-    register_algorithm(std::make_unique<algorithms::symmetric::AES_OFB>(128));
-    register_algorithm(std::make_unique<algorithms::symmetric::AES_OFB>(192));
-    register_algorithm(std::make_unique<algorithms::symmetric::AES_OFB>(256));
-    
-    // Register ECB mode algorithms (INSECURE - educational only)
-    register_algorithm(std::make_unique<algorithms::symmetric::AES_ECB>(128));
-    register_algorithm(std::make_unique<algorithms::symmetric::AES_ECB>(192));
-    register_algorithm(std::make_unique<algorithms::symmetric::AES_ECB>(256));
-    
-    // Register XTS mode algorithms (disk encryption)
-    register_algorithm(std::make_unique<algorithms::symmetric::AES_XTS>(128));
-    register_algorithm(std::make_unique<algorithms::symmetric::AES_XTS>(256));
-    
-    // Register legacy algorithms (for compatibility only)
-    register_algorithm(std::make_unique<algorithms::symmetric::TripleDES>());
-    
-    // Register asymmetric algorithms (RSA)
-    register_algorithm(std::make_unique<algorithms::asymmetric::RSA>(2048));
-    register_algorithm(std::make_unique<algorithms::asymmetric::RSA>(3072));
-    register_algorithm(std::make_unique<algorithms::asymmetric::RSA>(4096));
-    
-    // Register asymmetric algorithms (ECC hybrid - ECDH + AES-GCM)
-    register_algorithm(std::make_unique<algorithms::asymmetric::ECCHybrid>(algorithms::asymmetric::ECCurve::SECP256R1));
-    register_algorithm(std::make_unique<algorithms::asymmetric::ECCHybrid>(algorithms::asymmetric::ECCurve::SECP384R1));
-    register_algorithm(std::make_unique<algorithms::asymmetric::ECCHybrid>(algorithms::asymmetric::ECCurve::SECP521R1));
-    
-    // Register classical ciphers (educational only)
-    register_algorithm(std::make_unique<algorithms::classical::Caesar>());
-    register_algorithm(std::make_unique<algorithms::classical::Vigenere>());
-    register_algorithm(std::make_unique<algorithms::classical::Playfair>());
-    register_algorithm(std::make_unique<algorithms::classical::HillCipher>());
-    register_algorithm(std::make_unique<algorithms::classical::SubstitutionCipher>());
-    
-    // Register Post-Quantum algorithms (NIST FIPS 203/204)
-    register_algorithm(std::make_unique<algorithms::pqc::KyberHybrid>(algorithms::pqc::Kyber::Variant::Kyber512));
-    register_algorithm(std::make_unique<algorithms::pqc::KyberHybrid>(algorithms::pqc::Kyber::Variant::Kyber768));
-    register_algorithm(std::make_unique<algorithms::pqc::KyberHybrid>(algorithms::pqc::Kyber::Variant::Kyber1024));
+    // Algorithms are built on first use by get_algorithm()
+    SPDLOG_DEBUG("CryptoEngine ready ({} algorithm slots)", ALGORITHM_SLOTS);
+}
+
+std::unique_ptr<ICryptoAlgorithm> CryptoEngine::create_algorithm(AlgorithmType type) {
+    using namespace algorithms;
     
-    spdlog::info("CryptoEngine initialized with {} algorithms", algorithms_.size());
+    switch (type) {
+        // Modern symmetric algorithms (AEAD)
+        case AlgorithmType::AES_128_GCM:       return std::make_unique<symmetric::AES_GCM>(128);
+        case AlgorithmType::AES_192_GCM:       return std::make_unique<symmetric::AES_GCM>(192);
+        case AlgorithmType::AES_256_GCM:       return std::make_unique<symmetric::AES_GCM>(256);
+        case AlgorithmType::CHACHA20_POLY1305: return std::make_unique<symmetric::ChaCha20Poly1305>();
+        case AlgorithmType::SERPENT_256_GCM:   return std::make_unique<symmetric::Serpent_GCM>();
+        case AlgorithmType::TWOFISH_128_GCM:   return std::make_unique<symmetric::Twofish_GCM>(128);
+        case AlgorithmType::TWOFISH_192_GCM:   return std::make_unique<symmetric::Twofish_GCM>(192);
+        case AlgorithmType::TWOFISH_256_GCM:   return std::make_unique<symmetric::Twofish_GCM>(256);
+        
+        // International standard algorithms
+        case AlgorithmType::CAMELLIA_128_GCM:  return std::make_unique<symmetric::Camellia_GCM>(128);
+        case AlgorithmType::CAMELLIA_192_GCM:  return std::make_unique<symmetric::Camellia_GCM>(192);
+        case AlgorithmType::CAMELLIA_256_GCM:  return std::make_unique<symmetric::Camellia_GCM>(256);
+        case AlgorithmType::ARIA_128_GCM:      return std::make_unique<symmetric::ARIA_GCM>(128);
+        case AlgorithmType::ARIA_192_GCM:      return std::make_unique<symmetric::ARIA_GCM>(192);
+        case AlgorithmType::ARIA_256_GCM:      return std::make_unique<symmetric::ARIA_GCM>(256);
+        case AlgorithmType::SM4_GCM:           return std::make_unique<symmetric::SM4_GCM>();
+        
+        // AEAD beyond GCM; left unregistered when the linked Botan lacks the mode
+        case AlgorithmType::AEGIS_256:
+            return symmetric::AEGIS_256::is_available() ? std::make_unique<symmetric::AEGIS_256>() : nullptr;
+        case AlgorithmType::AES_256_OCB:
+            return symmetric::AES_OCB::is_available() ? std::make_unique<symmetric::AES_OCB>() : nullptr;
+        case AlgorithmType::AES_256_SIV:
+            return symmetric::AES_SIV::is_available() ? std::make_unique<symmetric::AES_SIV>() : nullptr;
+        
+        // Non-AEAD symmetric algorithms
+        case AlgorithmType::AES_128_CBC:       return std::make_unique<symmetric::AES_CBC>(128);
+        case AlgorithmType::AES_192_CBC:       return std::make_unique<symmetric::AES_CBC>(192);
+        case AlgorithmType::AES_256_CBC:       return std::make_unique<symmetric::AES_CBC>(256);
+        case AlgorithmType::AES_128_CTR:       return std::make_unique<symmetric::AES_CTR>(128);
+        case AlgorithmType::AES_192_CTR:       return std::make_unique<symmetric::AES_CTR>(192);
+        case AlgorithmType::AES_256_CTR:       return std::make_unique<symmetric::AES_CTR>(256);
+        case AlgorithmType::AES_128_CFB:       return std::make_unique<symmetric::AES_CFB>(128);
+        case AlgorithmType::AES_192_CFB:       return std::make_unique<symmetric::AES_CFB>(192);
+        case AlgorithmType::AES_256_CFB:       return std::make_unique<symmetric::AES_CFB>(256);
+        case AlgorithmType::AES_128_OFB:       return std::make_unique<symmetric::AES_OFB>(128);
+        case AlgorithmType::AES_192_OFB:       return std::make_unique<symmetric::AES_OFB>(192);
+        case AlgorithmType::AES_256_OFB:       return std::make_unique<symmetric::AES_OFB>(256);
+        
+        // ECB mode (INSECURE - educational only)
+        case AlgorithmType::AES_128_ECB:       return std::make_unique<symmetric::AES_ECB>(128);
+        case AlgorithmType::AES_192_ECB:       return std::make_unique<symmetric::AES_ECB>(192);
+        case AlgorithmType::AES_256_ECB:       return std::make_unique<symmetric::AES_ECB>(256);
+        
+        // XTS mode (disk encryption)
+        case AlgorithmType::AES_128_XTS:       return std::make_unique<symmetric::AES_XTS>(128);
+        case AlgorithmType::AES_256_XTS:       return std::make_unique<symmetric::AES_XTS>(256);
+        
+        // Legacy algorithms (for compatibility only)
+        case AlgorithmType::TRIPLE_DES_CBC:    return std::make_unique<symmetric::TripleDES>();
+        
+        // Asymmetric algorithms (RSA, ECC hybrid - ECDH + AES-GCM)
+        case AlgorithmType::RSA_2048:          return std::make_unique<asymmetric::RSA>(2048);
+        case AlgorithmType::RSA_3072:          return std::make_unique<asymmetric::RSA>(3072);
+        case AlgorithmType::RSA_4096:          return std::make_unique<asymmetric::RSA>(4096);
+        case AlgorithmType::ECC_P256:          return std::make_unique<asymmetric::ECCHybrid>(asymmetric::ECCurve::SECP256R1);
+        case AlgorithmType::ECC_P384:          return std::make_unique<asymmetric::ECCHybrid>(asymmetric::ECCurve::SECP384R1);
+        case AlgorithmType::ECC_P521:          return std::make_unique<asymmetric::ECCHybrid>(asymmetric::ECCurve::SECP521R1);
+        case AlgorithmType::ECC_X25519:        return std::make_unique<asymmetric::ECCHybrid>(asymmetric::ECCurve::X25519);
+        
+        // Classical ciphers (educational only)
+        case AlgorithmType::CAESAR:            return std::make_unique<classical::Caesar>();
+        case AlgorithmType::VIGENERE:          return std::make_unique<classical::Vigenere>();
+        case AlgorithmType::PLAYFAIR:          return std::make_unique<classical::Playfair>();
+        case AlgorithmType::HILL:              return std::make_unique<classical::HillCipher>();
+        case AlgorithmType::SUBSTITUTION:      return std::make_unique<classical::SubstitutionCipher>();
+        
+        // Post-Quantum algorithms (NIST FIPS 203)
+        case AlgorithmType::KYBER_512_HYBRID:  return std::make_unique<pqc::KyberHybrid>(pqc::Kyber::Variant::Kyber512);
+        case AlgorithmType::KYBER_768_HYBRID:  return std::make_unique<pqc::KyberHybrid>(pqc::Kyber::Variant::Kyber768);
+        case AlgorithmType::KYBER_1024_HYBRID: return std::make_unique<pqc::KyberHybrid>(pqc::Kyber::Variant::Kyber1024);
+        
+        // Bare KEMs and signatures are not file ciphers
+        default:
+            return nullptr;
+    }
 }
 
 void CryptoEngine::register_algorithm(std::unique_ptr<ICryptoAlgorithm> algorithm) {
     auto type = algorithm->type();
-    algorithms_[type] = std::move(algorithm);
-    spdlog::debug("Registered algorithm: {}", algorithm_name(type));
+    auto index = static_cast<size_t>(type);
+    if (index >= ALGORITHM_SLOTS) {
+        spdlog::warn("Cannot register algorithm with unknown type {}", index);
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(algorithms_mutex_);
+    algorithms_[index] = std::move(algorithm);
+    lookup_[index].store(algorithms_[index].get(), std::memory_order_release);
+    SPDLOG_DEBUG("Registered algorithm: {}", algorithm_name(type));
 }
 
 ICryptoAlgorithm* CryptoEngine::get_algorithm(AlgorithmType type) {
-    auto it = algorithms_.find(type);
-    if (it != algorithms_.end()) {
-        return it->second.get();
+    auto index = static_cast<size_t>(type);
+    if (index >= ALGORITHM_SLOTS) {
+        return nullptr;
+    }
+    if (auto* algorithm = lookup_[index].load(std::memory_order_acquire)) {
+        return algorithm;
     }
-    return nullptr;
+    
+    std::lock_guard<std::mutex> lock(algorithms_mutex_);
+    if (!algorithms_[index]) {
+        algorithms_[index] = create_algorithm(type);
+        if (!algorithms_[index]) {
+            return nullptr;
+        }
+        SPDLOG_DEBUG("Constructed algorithm: {}", algorithm_name(type));
+    }
+    lookup_[index].store(algorithms_[index].get(), std::memory_order_release);
+    return algorithms_[index].get();
 }
 
 std::vector<uint8_t> CryptoEngine::derive_key(
@@ -136,18 +183,54 @@ std::vector<uint8_t> CryptoEngine::derive_key(
     const std::vector<uint8_t>& salt,
     const EncryptionConfig& config
 ) {
-    spdlog::debug("Deriving key with {} (iterations: {}, memory: {}KB)",
+    utils::ScopedSpan trace_span("CryptoEngine::derive_key", "kdf");
+    utils::RunStats::instance().set_algorithm(algorithm_name(config.algorithm));
+    SPDLOG_DEBUG("Deriving key with {} (iterations: {}, memory: {}KB)",
                   kdf_name(config.kdf), config.kdf_iterations, config.kdf_memory_kb);
     
-    // Determine key size based on algorithm
+    // Key size comes from the traits table unless a registered (or already
+    // built) implementation says otherwise; no algorithm is constructed here
     size_t key_size = 32; // Default 256-bit
-    auto* algo = get_algorithm(config.algorithm);
-    if (algo) {
-        key_size = algo->key_size();
+    auto index = static_cast<size_t>(config.algorithm);
+    if (index < ALGORITHM_SLOTS) {
+        if (auto* algo = lookup_[index].load(std::memory_order_acquire)) {
+            key_size = algo->key_size();
+        } else if (algorithm_traits(config.algorithm).key_size != 0) {
+            key_size = algorithm_traits(config.algorithm).key_size;
+        }
+    }
+    
+    // A batch file's key is a subkey of the batch's master key, so the
+    // batch stretches the password once
+    if (is_batch_file_salt(salt)) {
+        auto batch = batch_salt_of(salt);
+        auto master = derive_key(password, std::vector<uint8_t>(batch.begin(), batch.end()), config);
+        std::vector<uint8_t> key(master.size());
+        auto hkdf = Botan::KDF::create_or_throw("HKDF(SHA-256)");
+        hkdf->derive_key(key, master, std::span<const uint8_t>(salt).subspan(4 + BATCH_SALT_SIZE),
+                         std::span(reinterpret_cast<const uint8_t*>(BATCH_KEY_LABEL), sizeof(BATCH_KEY_LABEL) - 1));
+        std::fill(master.begin(), master.end(), uint8_t{0});
+        return key;
+    }
+    
+    // Repeated derivations of the same password + salt + params cost one KDF
+    auto& cache = KeyCache::instance();
+    bool use_cache = cache.enabled();
+    KeyCache::Id cache_id{};
+    if (use_cache) {
+        cache_id = cache.make_id(password, salt, config, key_size);
+        std::vector<uint8_t> cached;
+        if (cache.lookup(cache_id, cached)) {
+            SPDLOG_DEBUG("Derived key served from cache");
+            return cached;
+        }
     }
     
     std::vector<uint8_t> key(key_size);
     
+    // Argon2/scrypt memory counts against --max-memory while the KDF runs
+    auto memory = MemoryBudget::shared().lease(KdfScheduler::memory_cost(config));
+    
     try {
         switch (config.kdf) {
             case KDFType::ARGON2ID:
@@ -162,9 +245,16 @@ std::vector<uint8_t> CryptoEngine::derive_key(
                     throw std::runtime_error("Failed to create Argon2 instance");
                 }
                 
-                spdlog::info("Argon2 params: memory={}KB, iterations={}, parallelism={}", 
+                SPDLOG_DEBUG("Argon2 params: memory={}KB, iterations={}, parallelism={}", 
                              config.kdf_memory_kb, config.kdf_iterations, config.kdf_parallelism);
                 
+                // Lanes are hashed concurrently on Botan's thread pool; each
+                // lane needs at least 8 KiB of the memory budget
+                if (config.kdf_parallelism == 0 ||
+                    config.kdf_memory_kb < 8ull * config.kdf_parallelism) {
+                    throw std::runtime_error("Argon2 parallelism must be 1 to memory_kb / 8");
+                }
+                
                 auto argon2 = pwdhash->from_params(
                     config.kdf_memory_kb,
                     config.kdf_iterations, 
@@ -233,7 +323,10 @@ std::vector<uint8_t> CryptoEngine::derive_key(
                 throw std::runtime_error("Unknown KDF type");
         }
         
-        spdlog::debug("Key derived successfully ({}  bytes)", key.size());
+        SPDLOG_DEBUG("Key derived successfully ({}  bytes)", key.size());
+        if (use_cache) {
+            cache.store(cache_id, key);
+        }
         return key;
         
     } catch (const Botan::Exception& e) {
@@ -243,79 +336,46 @@ std::vector<uint8_t> CryptoEngine::derive_key(
 }
 
 std::vector<uint8_t> CryptoEngine::generate_salt(size_t length) {
-    Botan::AutoSeeded_RNG rng;
+    auto& rng = RandomService::rng();
     std::vector<uint8_t> salt(length);
     rng.randomize(salt.data(), salt.size());
-    spdlog::debug("Generated random salt ({} bytes)", length);
+    SPDLOG_DEBUG("Generated random salt ({} bytes)", length);
+    return salt;
+}
+
+std::vector<uint8_t> CryptoEngine::batch_file_salt(std::span<const uint8_t> batch_salt) {
+    if (batch_salt.size() != BATCH_SALT_SIZE) {
+        throw std::invalid_argument("Batch salt must be 32 bytes");
+    }
+    std::vector<uint8_t> salt(std::begin(BATCH_SALT_MAGIC), std::end(BATCH_SALT_MAGIC));
+    salt.insert(salt.end(), batch_salt.begin(), batch_salt.end());
+    auto own = generate_salt(BATCH_FILE_SALT_SIZE - salt.size());
+    salt.insert(salt.end(), own.begin(), own.end());
     return salt;
 }
 
+bool CryptoEngine::is_batch_file_salt(std::span<const uint8_t> salt) {
+    return salt.size() == BATCH_FILE_SALT_SIZE &&
+           std::equal(std::begin(BATCH_SALT_MAGIC), std::end(BATCH_SALT_MAGIC), salt.begin());
+}
+
+std::span<const uint8_t> CryptoEngine::batch_salt_of(std::span<const uint8_t> salt) {
+    return is_batch_file_salt(salt) ? salt.subspan(4, BATCH_SALT_SIZE) : salt;
+}
+
 std::vector<uint8_t> CryptoEngine::generate_nonce(size_t length) {
-    Botan::AutoSeeded_RNG rng;
+    auto& rng = RandomService::rng();
     std::vector<uint8_t> nonce(length);
     rng.randomize(nonce.data(), nonce.size());
-    spdlog::debug("Generated random nonce ({} bytes)", length);
+    SPDLOG_DEBUG("Generated random nonce ({} bytes)", length);
     return nonce;
 }
 
 std::string CryptoEngine::algorithm_name(AlgorithmType type) {
-    switch (type) {
-        case AlgorithmType::AES_128_GCM: return "AES-128-GCM";
-        case AlgorithmType::AES_192_GCM: return "AES-192-GCM";
-        case AlgorithmType::AES_256_GCM: return "AES-256-GCM";
-        case AlgorithmType::AES_128_CBC: return "AES-128-CBC";
-        case AlgorithmType::AES_192_CBC: return "AES-192-CBC";
-        case AlgorithmType::AES_256_CBC: return "AES-256-CBC";
-        case AlgorithmType::AES_128_CTR: return "AES-128-CTR";
-        case AlgorithmType::AES_192_CTR: return "AES-192-CTR";
-        case AlgorithmType::AES_256_CTR: return "AES-256-CTR";
-        case AlgorithmType::AES_128_CFB: return "AES-128-CFB";
-        case AlgorithmType::AES_192_CFB: return "AES-192-CFB";
-        case AlgorithmType::AES_256_CFB: return "AES-256-CFB";
-        case AlgorithmType::AES_128_OFB: return "AES-128-OFB";
-        case AlgorithmType::AES_192_OFB: return "AES-192-OFB";
-        case AlgorithmType::AES_256_OFB: return "AES-256-OFB";
-        case AlgorithmType::AES_128_ECB: return "AES-128-ECB";
-        case AlgorithmType::AES_192_ECB: return "AES-192-ECB";
-        case AlgorithmType::AES_256_ECB: return "AES-256-ECB";
-        case AlgorithmType::AES_128_XTS: return "AES-128-XTS";
-        case AlgorithmType::AES_256_XTS: return "AES-256-XTS";
-        case AlgorithmType::TRIPLE_DES_CBC: return "3DES-CBC";
-        case AlgorithmType::RSA_2048: return "RSA-2048";
-        case AlgorithmType::RSA_3072: return "RSA-3072";
-        case AlgorithmType::RSA_4096: return "RSA-4096";
-        case AlgorithmType::ECC_P256: return "ECC-P256";
-        case AlgorithmType::ECC_P384: return "ECC-P384";
-        case AlgorithmType::ECC_P521: return "ECC-P521";
-        case AlgorithmType::CHACHA20_POLY1305: return "ChaCha20-Poly1305";
-        case AlgorithmType::SERPENT_256_GCM: return "Serpent-256-GCM";
-        case AlgorithmType::TWOFISH_128_GCM: return "Twofish-128-GCM";
-        case AlgorithmType::TWOFISH_192_GCM: return "Twofish-192-GCM";
-        case AlgorithmType::TWOFISH_256_GCM: return "Twofish-256-GCM";
-        case AlgorithmType::CAMELLIA_128_GCM: return "Camellia-128-GCM";
-        case AlgorithmType::CAMELLIA_192_GCM: return "Camellia-192-GCM";
-        case AlgorithmType::CAMELLIA_256_GCM: return "Camellia-256-GCM";
-        case AlgorithmType::ARIA_128_GCM: return "ARIA-128-GCM";
-        case AlgorithmType::ARIA_192_GCM: return "ARIA-192-GCM";
-        case AlgorithmType::ARIA_256_GCM: return "ARIA-256-GCM";
-        case AlgorithmType::SM4_GCM: return "SM4-GCM";
-        case AlgorithmType::CAESAR: return "Caesar";
-        case AlgorithmType::VIGENERE: return "Vigenère";
-        case AlgorithmType::PLAYFAIR: return "Playfair";
-        case AlgorithmType::SUBSTITUTION: return "Substitution";
-        case AlgorithmType::HILL: return "Hill";
-        // Post-Quantum algorithms
-        case AlgorithmType::KYBER_512: return "Kyber-512";
-        case AlgorithmType::KYBER_768: return "Kyber-768";
-        case AlgorithmType::KYBER_1024: return "Kyber-1024";
-        case AlgorithmType::DILITHIUM_2: return "Dilithium-2";
-        case AlgorithmType::DILITHIUM_3: return "Dilithium-3";
-        case AlgorithmType::DILITHIUM_5: return "Dilithium-5";
-        case AlgorithmType::KYBER_512_HYBRID: return "Kyber-512-Hybrid";
-        case AlgorithmType::KYBER_768_HYBRID: return "Kyber-768-Hybrid";
-        case AlgorithmType::KYBER_1024_HYBRID: return "Kyber-1024-Hybrid";
-        default: return "Unknown";
+    if (static_cast<size_t>(type) >= ALGORITHM_COUNT) {
+        return "Unknown";
     }
+    return std::string(algorithm_traits(type).name);
 }
 
 std::string CryptoEngine::kdf_name(KDFType type) {
@@ -343,84 +403,10 @@ std::optional<AlgorithmType> CryptoEngine::parse_algorithm(const std::string& na
     std::string lower = name;
     std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
     
-    // AES-GCM (AEAD)
-    if (lower == "aes-128-gcm" || lower == "aes128gcm") return AlgorithmType::AES_128_GCM;
-    if (lower == "aes-192-gcm" || lower == "aes192gcm") return AlgorithmType::AES_192_GCM;
-    if (lower == "aes-256-gcm" || lower == "aes256gcm" || lower == "aes" || lower == "aes256") return AlgorithmType::AES_256_GCM;
-    
-    // AES-CBC (legacy, not authenticated)
-    if (lower == "aes-128-cbc" || lower == "aes128cbc") return AlgorithmType::AES_128_CBC;
-    if (lower == "aes-192-cbc" || lower == "aes192cbc") return AlgorithmType::AES_192_CBC;
-    if (lower == "aes-256-cbc" || lower == "aes256cbc") return AlgorithmType::AES_256_CBC;
-    
-    // AES-CTR (stream mode, not authenticated)
-    if (lower == "aes-128-ctr" || lower == "aes128ctr") return AlgorithmType::AES_128_CTR;
-    if (lower == "aes-192-ctr" || lower == "aes192ctr") return AlgorithmType::AES_192_CTR;
-    if (lower == "aes-256-ctr" || lower == "aes256ctr") return AlgorithmType::AES_256_CTR;
-    
-    // AES-CFB (self-synchronizing stream mode)
-    if (lower == "aes-128-cfb" || lower == "aes128cfb") return AlgorithmType::AES_128_CFB;
-    if (lower == "aes-192-cfb" || lower == "aes192cfb") return AlgorithmType::AES_192_CFB;
-    if (lower == "aes-256-cfb" || lower == "aes256cfb") return AlgorithmType::AES_256_CFB;
-    
-    // AES-OFB (output feedback stream mode)
-    if (lower == "aes-128-ofb" || lower == "aes128ofb") return AlgorithmType::AES_128_OFB;
-    if (lower == "aes-192-ofb" || lower == "aes192ofb") return AlgorithmType::AES_192_OFB;
-    if (lower == "aes-256-ofb" || lower == "aes256ofb") return AlgorithmType::AES_256_OFB;
-    
-    // AES-ECB (INSECURE - educational only)
-    if (lower == "aes-128-ecb" || lower == "aes128ecb") return AlgorithmType::AES_128_ECB;
-    if (lower == "aes-192-ecb" || lower == "aes192ecb") return AlgorithmType::AES_192_ECB;
-    if (lower == "aes-256-ecb" || lower == "aes256ecb") return AlgorithmType::AES_256_ECB;
-    
-    // AES-XTS (disk encryption mode)
-    if (lower == "aes-128-xts" || lower == "aes128xts") return AlgorithmType::AES_128_XTS;
-    if (lower == "aes-256-xts" || lower == "aes256xts" || lower == "xts") return AlgorithmType::AES_256_XTS;
-    
-    // Legacy algorithms
-    if (lower == "3des" || lower == "3des-cbc" || lower == "tripledes" || lower == "triple-des") return AlgorithmType::TRIPLE_DES_CBC;
-    
-    // RSA asymmetric encryption
-    if (lower == "rsa-2048" || lower == "rsa2048") return AlgorithmType::RSA_2048;
-    if (lower == "rsa-3072" || lower == "rsa3072") return AlgorithmType::RSA_3072;
-    if (lower == "rsa-4096" || lower == "rsa4096" || lower == "rsa") return AlgorithmType::RSA_4096;
-    
-    // ECC hybrid encryption (ECDH + AES-GCM)
-    if (lower == "ecc-p256" || lower == "eccp256" || lower == "p256" || lower == "secp256r1") return AlgorithmType::ECC_P256;
-    if (lower == "ecc-p384" || lower == "eccp384" || lower == "p384" || lower == "secp384r1") return AlgorithmType::ECC_P384;
-    if (lower == "ecc-p521" || lower == "eccp521" || lower == "p521" || lower == "secp521r1" || lower == "ecc") return AlgorithmType::ECC_P521;
-    
-    if (lower == "chacha20-poly1305" || lower == "chacha20" || lower == "chacha") return AlgorithmType::CHACHA20_POLY1305;
-    if (lower == "serpent-256-gcm" || lower == "serpent" || lower == "serpent256") return AlgorithmType::SERPENT_256_GCM;
-    if (lower == "twofish-128-gcm" || lower == "twofish128") return AlgorithmType::TWOFISH_128_GCM;
-    if (lower == "twofish-192-gcm" || lower == "twofish192") return AlgorithmType::TWOFISH_192_GCM;
-    if (lower == "twofish-256-gcm" || lower == "twofish" || lower == "twofish256") return AlgorithmType::TWOFISH_256_GCM;
-    if (lower == "camellia-128-gcm" || lower == "camellia128") return AlgorithmType::CAMELLIA_128_GCM;
-    if (lower == "camellia-192-gcm" || lower == "camellia192") return AlgorithmType::CAMELLIA_192_GCM;
-    if (lower == "camellia-256-gcm" || lower == "camellia" || lower == "camellia256") return AlgorithmType::CAMELLIA_256_GCM;
-    if (lower == "aria-128-gcm" || lower == "aria128") return AlgorithmType::ARIA_128_GCM;
-    if (lower == "aria-192-gcm" || lower == "aria192") return AlgorithmType::ARIA_192_GCM;
-    if (lower == "aria-256-gcm" || lower == "aria" || lower == "aria256") return AlgorithmType::ARIA_256_GCM;
-    if (lower == "sm4-gcm" || lower == "sm4") return AlgorithmType::SM4_GCM;
-    if (lower == "caesar") return AlgorithmType::CAESAR;
-    if (lower == "vigenere" || lower == "vigenère") return AlgorithmType::VIGENERE;
-    if (lower == "playfair") return AlgorithmType::PLAYFAIR;
-    if (lower == "substitution" || lower == "sub") return AlgorithmType::SUBSTITUTION;
-    if (lower == "hill") return AlgorithmType::HILL;
-    
-    // Post-Quantum algorithms (ML-KEM / Kyber)
-    if (lower == "kyber-512" || lower == "kyber512") return AlgorithmType::KYBER_512;
-    if (lower == "kyber-768" || lower == "kyber768") return AlgorithmType::KYBER_768;
-    if (lower == "kyber-1024" || lower == "kyber1024" || lower == "kyber") return AlgorithmType::KYBER_1024;
-    if (lower == "kyber-512-hybrid" || lower == "kyber512hybrid") return AlgorithmType::KYBER_512_HYBRID;
-    if (lower == "kyber-768-hybrid" || lower == "kyber768hybrid") return AlgorithmType::KYBER_768_HYBRID;
-    if (lower == "kyber-1024-hybrid" || lower == "kyber1024hybrid" || lower == "kyber-hybrid") return AlgorithmType::KYBER_1024_HYBRID;
-    
-    // Post-Quantum signatures (ML-DSA / Dilithium)
-    if (lower == "dilithium-2" || lower == "dilithium2") return AlgorithmType::DILITHIUM_2;
-    if (lower == "dilithium-3" || lower == "dilithium3") return AlgorithmType::DILITHIUM_3;
-    if (lower == "dilithium-5" || lower == "dilithium5" || lower == "dilithium") return AlgorithmType::DILITHIUM_5;
-    
+    // Canonical names and aliases live in the traits table
+    if (const auto* traits = find_algorithm(lower)) {
+        return traits->type;
+    }
     return std::nullopt;
 }
 
@@ -0,0 +1,382 @@
+/**
+ * @file envelope.cpp
+ * @brief Public-key envelope encryption over the streaming engine
+ */
+
+#include "filevault/core/envelope.hpp"
+#include "filevault/core/crypto_engine.hpp"
+#include "filevault/core/random.hpp"
+#include "filevault/algorithms/asymmetric/loaded_key.hpp"
+#include "filevault/algorithms/pqc/post_quantum.hpp"
+#include "filevault/utils/io_backend.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace filevault {
+namespace core {
+
+namespace {
+
+// Magic bytes for envelope files: "FVEN" (FileVault ENvelope)
+constexpr uint8_t ENVELOPE_MAGIC[4] = {'F', 'V', 'E', 'N'};
+constexpr uint8_t ENVELOPE_VERSION = 1;
+
+// Sanity limits for a recipient list read from an untrusted file
+constexpr uint16_t MAX_RECIPIENTS = 1024;
+constexpr uint32_t MAX_WRAPPED_SIZE = 64 * 1024;
+
+/**
+ * @brief Data-key size of a stream algorithm, which must be an AEAD
+ */
+bool data_key_size(CryptoEngine& engine, AlgorithmType algorithm, size_t& size, std::string& error) {
+    if (!StreamingCrypto::supports_algorithm(algorithm)) {
+        error = "Envelope encryption needs an AEAD algorithm";
+        return false;
+    }
+    auto* algo = engine.get_algorithm(algorithm);
+    if (!algo) {
+        error = "Algorithm not available";
+        return false;
+    }
+    size = algo->key_size();
+    return true;
+}
+
+} // anonymous namespace
+
+std::optional<AlgorithmType> EnvelopeCrypto::key_algorithm(std::span<const uint8_t> key) {
+    auto loaded = algorithms::asymmetric::LoadedKey::load(key);
+    if (loaded) {
+        auto name = loaded.value.algorithm();
+        size_t bits = loaded.value.key_bits();
+        if (name == "RSA") {
+            return bits <= 2048 ? AlgorithmType::RSA_2048
+                 : bits <= 3072 ? AlgorithmType::RSA_3072
+                                : AlgorithmType::RSA_4096;
+        }
+        if (name == "ECDH") {
+            switch (bits) {
+                case 256: return AlgorithmType::ECC_P256;
+                case 384: return AlgorithmType::ECC_P384;
+                case 521: return AlgorithmType::ECC_P521;
+                default:  return std::nullopt;
+            }
+        }
+        if (name == "X25519") {
+            return AlgorithmType::ECC_X25519;
+        }
+        return std::nullopt;
+    }
+
+    // Kyber keys are written raw by keygen
+    using Variant = algorithms::pqc::Kyber::Variant;
+    const std::pair<Variant, AlgorithmType> variants[] = {
+        {Variant::Kyber512, AlgorithmType::KYBER_512_HYBRID},
+        {Variant::Kyber768, AlgorithmType::KYBER_768_HYBRID},
+        {Variant::Kyber1024, AlgorithmType::KYBER_1024_HYBRID},
+    };
+    for (const auto& [variant, type] : variants) {
+        algorithms::pqc::Kyber kyber(variant);
+        if (key.size() == kyber.public_key_size() || key.size() == kyber.private_key_size()) {
+            return type;
+        }
+    }
+    return std::nullopt;
+}
+
+bool EnvelopeCrypto::write_header(std::ostream& output, const std::vector<WrappedKey>& recipients) {
+    output.write(reinterpret_cast<const char*>(ENVELOPE_MAGIC), 4);
+    output.write(reinterpret_cast<const char*>(&ENVELOPE_VERSION), 1);
+
+    uint16_t count = static_cast<uint16_t>(recipients.size());
+    output.write(reinterpret_cast<const char*>(&count), 2);
+
+    for (const auto& recipient : recipients) {
+        uint8_t algo = static_cast<uint8_t>(recipient.algorithm);
+        uint32_t size = static_cast<uint32_t>(recipient.data.size());
+        output.write(reinterpret_cast<const char*>(&algo), 1);
+        output.write(reinterpret_cast<const char*>(&size), 4);
+        output.write(reinterpret_cast<const char*>(recipient.data.data()), size);
+    }
+
+    return output.good();
+}
+
+bool EnvelopeCrypto::read_header(std::istream& input, std::vector<WrappedKey>& recipients, std::string& error) {
+    uint8_t magic[4] = {};
+    input.read(reinterpret_cast<char*>(magic), 4);
+    if (!input || std::memcmp(magic, ENVELOPE_MAGIC, 4) != 0) {
+        error = "Not an envelope (public-key) encrypted file";
+        return false;
+    }
+
+    uint8_t version = 0;
+    input.read(reinterpret_cast<char*>(&version), 1);
+    if (version != ENVELOPE_VERSION) {
+        error = "Unsupported envelope format version: " + std::to_string(version);
+        return false;
+    }
+
+    uint16_t count = 0;
+    input.read(reinterpret_cast<char*>(&count), 2);
+    if (!input || count == 0 || count > MAX_RECIPIENTS) {
+        error = "Invalid envelope recipient list";
+        return false;
+    }
+
+    recipients.clear();
+    for (uint16_t i = 0; i < count; ++i) {
+        uint8_t algo = 0;
+        uint32_t size = 0;
+        input.read(reinterpret_cast<char*>(&algo), 1);
+        input.read(reinterpret_cast<char*>(&size), 4);
+        if (!input || size == 0 || size > MAX_WRAPPED_SIZE) {
+            error = "Invalid envelope recipient list";
+            return false;
+        }
+        WrappedKey recipient{static_cast<AlgorithmType>(algo), std::vector<uint8_t>(size)};
+        input.read(reinterpret_cast<char*>(recipient.data.data()), size);
+        recipients.push_back(std::move(recipient));
+    }
+
+    if (!input) {
+        error = "Truncated envelope header";
+        return false;
+    }
+    return true;
+}
+
+StreamingResult EnvelopeCrypto::encrypt_file(
+    const std::string& input_path,
+    const std::string& output_path,
+    std::span<const uint8_t> public_key,
+    const StreamingConfig& config
+) {
+    return encrypt_file(input_path, output_path, std::vector<std::vector<uint8_t>>{
+        std::vector<uint8_t>(public_key.begin(), public_key.end())}, config);
+}
+
+StreamingResult EnvelopeCrypto::encrypt_file(
+    const std::string& input_path,
+    const std::string& output_path,
+    const std::vector<std::vector<uint8_t>>& public_keys,
+    const StreamingConfig& config
+) {
+    StreamingResult result;
+
+    utils::InputFileOptions input_options;
+    input_options.direct = config.bypass_cache;
+    utils::InputFile input(input_path, input_options);
+    if (!input.is_open()) {
+        result.error_message = "Failed to open input file: " + input_path;
+        return result;
+    }
+    size_t file_size = static_cast<size_t>(input.size());
+
+    utils::OutputFileOptions output_options;
+    output_options.bypass_cache = config.bypass_cache;
+    output_options.atomic = true;
+    utils::OutputFile output(output_path, output_options);
+    if (!output) {
+        result.error_message = "Failed to create output file: " + output_path;
+        return result;
+    }
+
+    result = encrypt_stream(input, output, public_keys, file_size, config);
+    result.bytes_written = output ? static_cast<uint64_t>(output.tellp()) : 0;
+    if (result.success && !output.commit(config.commit_group)) {
+        result.success = false;
+        result.error_message = "Failed to write output file: " + output_path;
+    }
+    return result;
+}
+
+StreamingResult EnvelopeCrypto::encrypt_stream(
+    std::istream& input,
+    std::ostream& output,
+    std::span<const uint8_t> public_key,
+    std::optional<size_t> input_size,
+    const StreamingConfig& config
+) {
+    return encrypt_stream(input, output, std::vector<std::vector<uint8_t>>{
+        std::vector<uint8_t>(public_key.begin(), public_key.end())}, input_size, config);
+}
+
+StreamingResult EnvelopeCrypto::encrypt_stream(
+    std::istream& input,
+    std::ostream& output,
+    const std::vector<std::vector<uint8_t>>& public_keys,
+    std::optional<size_t> input_size,
+    const StreamingConfig& config
+) {
+    StreamingResult result;
+
+    try {
+        if (public_keys.empty() || public_keys.size() > MAX_RECIPIENTS) {
+            result.error_message = "Envelope encryption needs 1 to " + std::to_string(MAX_RECIPIENTS) +
+                                   " recipients";
+            return result;
+        }
+
+        CryptoEngine engine;
+        engine.initialize();
+
+        size_t key_size = 0;
+        if (!data_key_size(engine, config.algorithm, key_size, result.error_message)) {
+            return result;
+        }
+
+        // Fresh data key per file; only this goes through the public-key step,
+        // once per recipient
+        auto data_key = RandomService::bytes(key_size);
+        std::vector<WrappedKey> recipients;
+        for (size_t i = 0; i < public_keys.size(); ++i) {
+            const auto& public_key = public_keys[i];
+            if (std::find(public_keys.begin(), public_keys.begin() + i, public_key) != public_keys.begin() + i) {
+                continue;   // Same key twice: one slot is enough
+            }
+
+            auto wrap_type = key_algorithm(public_key);
+            if (!wrap_type) {
+                result.error_message = "Unsupported public key for recipient " + std::to_string(i + 1) +
+                                       ": use an RSA, ECC (ecc-*) or Kyber key";
+                return result;
+            }
+            auto* wrapper = engine.get_algorithm(*wrap_type);
+            if (!wrapper) {
+                result.error_message = "Key wrapping algorithm not available";
+                return result;
+            }
+
+            EncryptionConfig wrap_config;
+            wrap_config.algorithm = *wrap_type;
+            auto wrapped = wrapper->encrypt(data_key, public_key, wrap_config);
+            if (!wrapped.success) {
+                result.error_message = "Failed to wrap data key for recipient " + std::to_string(i + 1) +
+                                       ": " + wrapped.error_message;
+                return result;
+            }
+            recipients.push_back({*wrap_type, std::move(wrapped.data)});
+        }
+        spdlog::info("Envelope encryption: data key wrapped for {} recipient(s)", recipients.size());
+
+        if (!write_header(output, recipients)) {
+            result.error_message = "Failed to write envelope header";
+            return result;
+        }
+
+        return StreamingCrypto::encrypt_stream_with_key(input, output, data_key, input_size, config);
+
+    } catch (const std::exception& e) {
+        result.error_message = std::string("Envelope encryption failed: ") + e.what();
+    }
+
+    return result;
+}
+
+StreamingResult EnvelopeCrypto::decrypt_file(
+    const std::string& input_path,
+    const std::string& output_path,
+    std::span<const uint8_t> private_key,
+    StreamProgressCallback progress_callback,
+    size_t worker_threads,
+    bool bypass_cache
+) {
+    StreamingResult result;
+
+    utils::InputFileOptions input_options;
+    input_options.direct = bypass_cache;
+    utils::InputFile input(input_path, input_options);
+    if (!input.is_open()) {
+        result.error_message = "Failed to open input file: " + input_path;
+        return result;
+    }
+
+    utils::OutputFileOptions output_options;
+    output_options.bypass_cache = bypass_cache;
+    output_options.atomic = true;
+    utils::OutputFile output(output_path, output_options);
+    if (!output) {
+        result.error_message = "Failed to create output file: " + output_path;
+        return result;
+    }
+
+    result = decrypt_stream(input, output, private_key, std::move(progress_callback), worker_threads);
+    result.bytes_written = output ? static_cast<uint64_t>(output.tellp()) : 0;
+    if (result.success && !output.commit()) {
+        result.success = false;
+        result.error_message = "Failed to write output file: " + output_path;
+    }
+    return result;
+}
+
+StreamingResult EnvelopeCrypto::decrypt_stream(
+    std::istream& input,
+    std::ostream& output,
+    std::span<const uint8_t> private_key,
+    StreamProgressCallback progress_callback,
+    size_t worker_threads
+) {
+    StreamingResult result;
+
+    try {
+        std::vector<WrappedKey> recipients;
+        if (!read_header(input, recipients, result.error_message)) {
+            return result;
+        }
+
+        auto key_type = key_algorithm(private_key);
+        if (!key_type) {
+            result.error_message = "Unsupported private key: use an RSA, ECC (ecc-*) or Kyber key";
+            return result;
+        }
+
+        CryptoEngine engine;
+        engine.initialize();
+        auto* wrapper = engine.get_algorithm(*key_type);
+        if (!wrapper) {
+            result.error_message = "Key wrapping algorithm not available";
+            return result;
+        }
+
+        // Every wrap is authenticated, so a slot for another key fails cleanly
+        std::vector<uint8_t> data_key;
+        EncryptionConfig wrap_config;
+        wrap_config.algorithm = *key_type;
+        for (const auto& recipient : recipients) {
+            if (recipient.algorithm != *key_type) {
+                continue;
+            }
+            auto unwrapped = wrapper->decrypt(recipient.data, private_key, wrap_config);
+            if (unwrapped.success && !unwrapped.data.empty()) {
+                data_key = std::move(unwrapped.data);
+                break;
+            }
+        }
+        if (data_key.empty()) {
+            result.error_message = "Private key does not match any of the file's " +
+                                   std::to_string(recipients.size()) + " recipient(s)";
+            return result;
+        }
+
+        return StreamingCrypto::decrypt_stream_with_key(input, output, data_key,
+                                                        std::move(progress_callback), worker_threads);
+
+    } catch (const std::exception& e) {
+        result.error_message = std::string("Envelope decryption failed: ") + e.what();
+    }
+
+    return result;
+}
+
+bool EnvelopeCrypto::is_envelope_file(const std::string& file_path) {
+    std::ifstream file(file_path, std::ios::binary);
+    uint8_t magic[4] = {};
+    file.read(reinterpret_cast<char*>(magic), 4);
+    return file && std::memcmp(magic, ENVELOPE_MAGIC, 4) == 0;
+}
+
+} // namespace core
+} // namespace filevault
@@ -0,0 +1,269 @@
+/**
+ * @file executor.cpp
+ * @brief Shared work-stealing executor and task groups
+ */
+
+#include "filevault/core/executor.hpp"
+#include "filevault/core/numa.hpp"
+#include "filevault/core/thread_pool.hpp"
+#include <spdlog/spdlog.h>
+
+namespace filevault {
+namespace core {
+
+namespace {
+
+// Worker identity of the calling thread (nullptr outside any executor)
+thread_local Executor* tl_executor = nullptr;
+thread_local size_t tl_worker = 0;
+
+constexpr size_t NOT_A_WORKER = static_cast<size_t>(-1);
+
+} // anonymous namespace
+
+Executor::Executor(size_t thread_count, size_t max_queued)
+    : max_queued_(max_queued) {
+    if (thread_count == 0) {
+        thread_count = ThreadPool::default_thread_count();
+    }
+
+    bool numa = Numa::enabled();
+    locals_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        locals_.push_back(std::make_unique<TaskQueue>());
+        worker_node_.push_back(numa ? i % Numa::node_count() : 0);
+    }
+    workers_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_.emplace_back([this, i, numa]() {
+            if (numa) {
+                Numa::pin_current_thread(worker_node_[i]);
+            }
+            worker_loop(i);
+        });
+    }
+
+    SPDLOG_DEBUG("Executor started with {} workers on {} NUMA node(s)", thread_count,
+                 numa ? Numa::node_count() : 1);
+}
+
+Executor::~Executor() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stopping_ = true;
+    }
+    work_cv_.notify_all();
+    room_cv_.notify_all();
+
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+Executor& Executor::shared() {
+    static Executor executor;
+    return executor;
+}
+
+Executor* Executor::current() {
+    return tl_executor;
+}
+
+bool Executor::try_post(std::function<void()> task, TaskPriority priority) {
+    return enqueue(std::move(task), priority, false);
+}
+
+void Executor::post(std::function<void()> task, TaskPriority priority) {
+    enqueue(std::move(task), priority, true);
+}
+
+bool Executor::enqueue(std::function<void()> task, TaskPriority priority, bool wait_for_room) {
+    bool from_worker = tl_executor == this;
+
+    // Soft bound: concurrent submitters may overshoot by a task each
+    if (max_queued_ > 0 && !from_worker) {
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        if (!wait_for_room && queued_.load() >= max_queued_) {
+            return false;
+        }
+        room_cv_.wait(lock, [this]() { return stopping_ || queued_.load() < max_queued_; });
+    }
+
+    TaskQueue& queue = from_worker ? *locals_[tl_worker] : injection_;
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.lanes[static_cast<size_t>(priority)].push_back(std::move(task));
+    }
+    queued_.fetch_add(1);
+
+    // Workers re-check queued_ under sleep_mutex_ before sleeping, so
+    // notifying under it cannot miss one
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    if (sleeping_ > 0) {
+        work_cv_.notify_one();
+    }
+    return true;
+}
+
+bool Executor::take(size_t self, std::function<void()>& task) {
+    auto pop = [&](TaskQueue& queue, size_t lane, bool newest) {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        auto& tasks = queue.lanes[lane];
+        if (tasks.empty()) {
+            return false;
+        }
+        if (newest) {
+            task = std::move(tasks.back());
+            tasks.pop_back();
+        } else {
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        return true;
+    };
+
+    size_t count = locals_.size();
+    for (size_t lane = 0; lane < PRIORITIES; ++lane) {
+        bool found = (self != NOT_A_WORKER && pop(*locals_[self], lane, true)) ||
+                     pop(injection_, lane, false);
+        // Steal the oldest task of another worker, starting after our own;
+        // workers on our NUMA node first, whose data is in local memory
+        size_t first = self == NOT_A_WORKER ? 0 : self + 1;
+        for (size_t pass = 0; !found && pass < 2; ++pass) {
+            for (size_t i = 0; !found && i < count; ++i) {
+                size_t victim = (first + i) % count;
+                bool same_node = self == NOT_A_WORKER || worker_node_[victim] == worker_node_[self];
+                found = victim != self && same_node == (pass == 0) && pop(*locals_[victim], lane, false);
+            }
+        }
+        if (found) {
+            queued_.fetch_sub(1);
+            if (max_queued_ > 0) {
+                std::lock_guard<std::mutex> lock(sleep_mutex_);
+                room_cv_.notify_one();
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Executor::run_one() {
+    std::function<void()> task;
+    if (!take(tl_executor == this ? tl_worker : NOT_A_WORKER, task)) {
+        return false;
+    }
+    task();
+    return true;
+}
+
+void Executor::worker_loop(size_t index) {
+    tl_executor = this;
+    tl_worker = index;
+
+    while (true) {
+        std::function<void()> task;
+        if (take(index, task)) {
+            auto start = std::chrono::steady_clock::now();
+            // submit() captures exceptions in the future; post() callers own theirs
+            try {
+                task();
+            } catch (const std::exception& e) {
+                spdlog::error("Executor task failed: {}", e.what());
+            } catch (...) {
+                spdlog::error("Executor task failed with an unknown exception");
+            }
+            // Tasks run by a worker waiting inside a task are already in this span
+            busy_ns_.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count()), std::memory_order_relaxed);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        // Drain remaining tasks before exiting
+        if (stopping_ && queued_.load() == 0) {
+            return;
+        }
+        ++sleeping_;
+        work_cv_.wait(lock, [this]() { return stopping_ || queued_.load() > 0; });
+        --sleeping_;
+    }
+}
+
+TaskGroup::TaskGroup(Executor& executor, size_t max_concurrency, TaskPriority priority)
+    : executor_(executor),
+      limit_(max_concurrency > 0 ? max_concurrency : executor.size()),
+      priority_(priority) {
+}
+
+TaskGroup::~TaskGroup() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_ > 0 || inline_ > 0 || !waiting_.empty()) {
+        lock.unlock();
+        if (!run_waiting() && !(Executor::current() == &executor_ && executor_.run_one())) {
+            lock.lock();
+            idle_cv_.wait_for(lock, std::chrono::milliseconds(1));
+            continue;
+        }
+        lock.lock();
+    }
+}
+
+void TaskGroup::add(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_ >= limit_) {
+            waiting_.push_back(std::move(job));
+            return;
+        }
+        ++running_;
+    }
+    dispatch(std::move(job));
+}
+
+void TaskGroup::dispatch(std::function<void()> job) {
+    executor_.post([this, job = std::move(job)]() {
+        job();
+        finished();
+    }, priority_);
+}
+
+void TaskGroup::finished() {
+    std::function<void()> next;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (waiting_.empty()) {
+            --running_;
+            // Under the lock: the destructor cannot return before we do
+            idle_cv_.notify_all();
+            return;
+        }
+        next = std::move(waiting_.front());
+        waiting_.pop_front();
+    }
+    dispatch(std::move(next));
+}
+
+bool TaskGroup::run_waiting() {
+    std::function<void()> job;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (waiting_.empty()) {
+            return false;
+        }
+        job = std::move(waiting_.front());
+        waiting_.pop_front();
+        ++inline_;
+    }
+    // Runs on top of the cap, so it frees no slot for the next waiting task
+    job();
+    std::lock_guard<std::mutex> lock(mutex_);
+    --inline_;
+    idle_cv_.notify_all();
+    return true;
+}
+
+} // namespace core
+} // namespace filevault
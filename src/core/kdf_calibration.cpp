@@ -0,0 +1,160 @@
+/**
+ * @file kdf_calibration.cpp
+ * @brief Host-specific KDF parameter selection
+ */
+
+#include "filevault/core/kdf_calibration.hpp"
+#include "filevault/core/cpu_features.hpp"
+#include "filevault/core/crypto_engine.hpp"
+#include "filevault/core/system_resources.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+namespace filevault {
+namespace core {
+
+namespace {
+
+constexpr uint32_t MIN_ARGON2_MEMORY_KB = 8192;     // 8 MB floor
+constexpr uint32_t MAX_ARGON2_LANES = 4;
+constexpr uint32_t MAX_ARGON2_PASSES = 16;
+constexpr uint32_t PBKDF2_PROBE_ITERATIONS = 100000;
+constexpr uint32_t MIN_PBKDF2_ITERATIONS = 10000;
+
+const std::string CALIBRATION_PASSWORD = "filevault-kdf-calibration";
+
+KdfProfile calibrate_argon2(CryptoEngine& engine, KDFType kdf,
+                            uint32_t target_ms, uint32_t max_memory_mb) {
+    EncryptionConfig config;
+    config.kdf = kdf;
+    const auto& resources = SystemResources::detect();
+    config.kdf_parallelism = std::clamp<uint32_t>(static_cast<uint32_t>(resources.cpus), 1, MAX_ARGON2_LANES);
+    
+    // In a container, a quarter of its limit at most, whatever the config says
+    if (uint64_t memory_mb = resources.memory_limit / (1024 * 1024); memory_mb > 0) {
+        max_memory_mb = static_cast<uint32_t>(std::min<uint64_t>(max_memory_mb, memory_mb / 4));
+    }
+    config.kdf_iterations = 1;
+    config.kdf_memory_kb = std::max(max_memory_mb * 1024, MIN_ARGON2_MEMORY_KB);
+
+    // Memory first: halve it until a single pass fits the budget
+    double ms = KdfCalibrator::time_derivation(engine, config);
+    while (ms > target_ms && config.kdf_memory_kb / 2 >= MIN_ARGON2_MEMORY_KB) {
+        config.kdf_memory_kb /= 2;
+        ms = KdfCalibrator::time_derivation(engine, config);
+    }
+
+    // Then passes, which scale linearly; check the estimate once
+    uint32_t passes = ms > 0 ? static_cast<uint32_t>(target_ms / ms) : MAX_ARGON2_PASSES;
+    passes = std::clamp<uint32_t>(passes, 1, MAX_ARGON2_PASSES);
+    if (passes > 1) {
+        config.kdf_iterations = passes;
+        ms = KdfCalibrator::time_derivation(engine, config);
+        if (ms > target_ms) {
+            double per_pass = ms / passes;
+            config.kdf_iterations = std::max<uint32_t>(1, static_cast<uint32_t>(target_ms / per_pass));
+            ms = per_pass * config.kdf_iterations;
+        }
+    }
+
+    KdfProfile profile;
+    profile.kdf = kdf;
+    profile.iterations = config.kdf_iterations;
+    profile.memory_kb = config.kdf_memory_kb;
+    profile.parallelism = config.kdf_parallelism;
+    profile.measured_ms = ms;
+    return profile;
+}
+
+KdfProfile calibrate_pbkdf2(CryptoEngine& engine, KDFType kdf, uint32_t target_ms) {
+    EncryptionConfig config;
+    config.kdf = kdf;
+    config.kdf_iterations = PBKDF2_PROBE_ITERATIONS;
+    double ms = KdfCalibrator::time_derivation(engine, config);
+
+    // Cost is linear in the iteration count; round down to thousands
+    double scaled = ms > 0 ? PBKDF2_PROBE_ITERATIONS * (target_ms / ms) : PBKDF2_PROBE_ITERATIONS;
+    auto iterations = static_cast<uint32_t>(std::min(scaled, 4.0e9) / 1000) * 1000;
+    iterations = std::max(iterations, MIN_PBKDF2_ITERATIONS);
+
+    KdfProfile profile;
+    profile.kdf = kdf;
+    profile.iterations = iterations;
+    profile.memory_kb = 0;
+    profile.parallelism = 1;
+    profile.measured_ms = ms * iterations / PBKDF2_PROBE_ITERATIONS;
+    return profile;
+}
+
+} // anonymous namespace
+
+void KdfProfile::apply(EncryptionConfig& config) const {
+    config.kdf = kdf;
+    config.kdf_iterations = iterations;
+    if (kdf == KDFType::ARGON2ID || kdf == KDFType::ARGON2I) {
+        config.kdf_memory_kb = memory_kb;
+        config.kdf_parallelism = parallelism;
+    }
+}
+
+bool KdfCalibrator::supports(KDFType kdf) {
+    switch (kdf) {
+        case KDFType::ARGON2ID:
+        case KDFType::ARGON2I:
+        case KDFType::PBKDF2_SHA256:
+        case KDFType::PBKDF2_SHA512:
+            return true;
+        default:
+            return false;
+    }
+}
+
+KdfProfile KdfCalibrator::calibrate(CryptoEngine& engine, KDFType kdf,
+                                    uint32_t target_ms, uint32_t max_memory_mb) {
+    if (!supports(kdf)) {
+        throw std::invalid_argument(CryptoEngine::kdf_name(kdf) + " cannot be calibrated");
+    }
+    if (target_ms == 0) {
+        throw std::invalid_argument("KDF target time must be positive");
+    }
+
+    auto profile = (kdf == KDFType::ARGON2ID || kdf == KDFType::ARGON2I)
+        ? calibrate_argon2(engine, kdf, target_ms, max_memory_mb)
+        : calibrate_pbkdf2(engine, kdf, target_ms);
+
+    spdlog::info("Calibrated {} for {} ms: iterations={}, memory={}KB, parallelism={} ({:.0f} ms)",
+                 CryptoEngine::kdf_name(kdf), target_ms, profile.iterations,
+                 profile.memory_kb, profile.parallelism, profile.measured_ms);
+    return profile;
+}
+
+double KdfCalibrator::time_derivation(CryptoEngine& engine, const EncryptionConfig& config, int runs) {
+    runs = std::max(1, runs);
+    double total_ms = 0.0;
+    for (int i = 0; i < runs; ++i) {
+        // A fresh salt per run keeps the derived-key cache out of the timing
+        auto salt = CryptoEngine::generate_salt(32);
+        auto start = std::chrono::high_resolution_clock::now();
+        engine.derive_key(CALIBRATION_PASSWORD, salt, config);
+        auto end = std::chrono::high_resolution_clock::now();
+        total_ms += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+    return total_ms / runs;
+}
+
+std::string KdfCalibrator::cache_key(KDFType kdf, uint32_t target_ms, uint32_t max_memory_mb) {
+    const auto& cpu = CpuFeatures::detect();
+    std::string key = CryptoEngine::kdf_name(kdf) + ":" + std::to_string(target_ms) + "ms:" +
+                      std::to_string(max_memory_mb) + "mb:" + cpu.architecture + ":" +
+                      std::to_string(SystemResources::detect().cpus) + "t";
+    for (const auto& feature : cpu.names()) {
+        key += ":" + feature;
+    }
+    return key;
+}
+
+} // namespace core
+} // namespace filevault
@@ -0,0 +1,188 @@
+/**
+ * @file kdf_scheduler.cpp
+ * @brief Memory-budgeted parallel key derivation
+ */
+
+#include "filevault/core/kdf_scheduler.hpp"
+#include "filevault/core/algorithm_traits.hpp"
+#include "filevault/core/key_cache.hpp"
+#include "filevault/core/memory_budget.hpp"
+#include "filevault/core/system_resources.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <exception>
+
+namespace filevault {
+namespace core {
+
+KdfScheduler::KdfScheduler(std::string password, KdfSchedulerOptions options)
+    : password_(std::move(password)), options_(options) {
+    if (options_.max_parallel == 0) {
+        options_.max_parallel = SystemResources::detect().cpus;
+    }
+    // Derivations running ahead get a share of --max-memory, not all of it
+    options_.memory_budget = std::min(options_.memory_budget,
+                                      MemoryBudget::shared().kdf_bytes(options_.memory_budget));
+    engine_.initialize();
+}
+
+KdfScheduler::~KdfScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_cv_.notify_all();
+    // Derivations already running finish; queued ones are dropped
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+uint64_t KdfScheduler::memory_cost(const EncryptionConfig& config) {
+    switch (config.kdf) {
+        case KDFType::ARGON2ID:
+        case KDFType::ARGON2I:
+            return uint64_t{config.kdf_memory_kb} * 1024;
+        case KDFType::SCRYPT: {
+            // 128 * r * N, with N per level as in CryptoEngine::derive_key
+            uint64_t n = 16384;
+            switch (config.level) {
+                case SecurityLevel::WEAK:     n = 1024;  break;
+                case SecurityLevel::MEDIUM:   n = 16384; break;
+                case SecurityLevel::STRONG:   n = 32768; break;
+                case SecurityLevel::PARANOID: n = 65536; break;
+            }
+            return 128 * 8 * n;
+        }
+        default:
+            return 0;   // PBKDF2: negligible
+    }
+}
+
+size_t KdfScheduler::submit(std::vector<uint8_t> salt, const EncryptionConfig& config) {
+    if (CryptoEngine::is_batch_file_salt(salt)) {
+        auto batch = CryptoEngine::batch_salt_of(salt);
+        salt = std::vector<uint8_t>(batch.begin(), batch.end());
+    }
+    auto id = KeyCache::instance().make_id(password_, salt, config, algorithm_traits(config.algorithm).key_size);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto it = submitted_.find(id); it != submitted_.end()) {
+        return it->second;
+    }
+    submitted_.emplace(id, jobs_.size());
+    Job& job = jobs_.emplace_back();
+    job.salt = std::move(salt);
+    job.config = config;
+    job.cost = memory_cost(config);
+
+    // Threads are started as work arrives, up to max_parallel
+    if (threads_.size() < options_.max_parallel) {
+        threads_.emplace_back([this]() { work(); });
+    }
+    work_cv_.notify_one();
+    return jobs_.size() - 1;
+}
+
+bool KdfScheduler::next_job(size_t& index) {
+    while (!demanded_.empty() && jobs_[demanded_.front()].state != State::QUEUED) {
+        demanded_.pop_front();
+    }
+    size_t candidate = 0;
+    if (!demanded_.empty()) {
+        candidate = demanded_.front();
+    } else {
+        while (next_ < jobs_.size() && jobs_[next_].state != State::QUEUED) {
+            ++next_;
+        }
+        if (next_ == jobs_.size()) {
+            return false;
+        }
+        candidate = next_;
+    }
+
+    // In order: a job that does not fit waits for memory rather than being overtaken
+    if (running_ > 0 && in_use_ + jobs_[candidate].cost > options_.memory_budget) {
+        return false;
+    }
+    index = candidate;
+    return true;
+}
+
+void KdfScheduler::work() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        size_t index = 0;
+        work_cv_.wait(lock, [&]() { return stopping_ || next_job(index); });
+        if (stopping_) {
+            return;
+        }
+
+        Job& job = jobs_[index];
+        job.state = State::RUNNING;
+        ++running_;
+        in_use_ += job.cost;
+        stats_.peak_parallel = std::max(stats_.peak_parallel, running_);
+        stats_.peak_memory = std::max(stats_.peak_memory, in_use_);
+        lock.unlock();
+
+        // salt and config are not touched by others while RUNNING
+        std::vector<uint8_t> key;
+        bool derived = false;
+        try {
+            key = engine_.derive_key(password_, job.salt, job.config);
+            derived = true;
+        } catch (const std::exception& e) {
+            spdlog::debug("Scheduled key derivation failed: {}", e.what());
+        }
+
+        lock.lock();
+        --running_;
+        in_use_ -= job.cost;
+        if (derived) {
+            job.key.assign(key.begin(), key.end());
+            std::fill(key.begin(), key.end(), uint8_t{0});
+            job.state = State::DONE;
+            ++stats_.derived;
+        } else {
+            job.state = State::FAILED;
+            ++stats_.failed;
+        }
+        done_cv_.notify_all();
+        work_cv_.notify_all();      // Memory was freed
+    }
+}
+
+bool KdfScheduler::wait(size_t ticket) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (ticket >= jobs_.size()) {
+        return false;
+    }
+    Job& job = jobs_[ticket];
+    if (job.state == State::QUEUED) {
+        demanded_.push_back(ticket);
+        work_cv_.notify_one();
+    }
+    done_cv_.wait(lock, [&job]() { return job.state != State::QUEUED && job.state != State::RUNNING; });
+
+    if (job.state == State::FAILED) {
+        return false;
+    }
+    if (job.state == State::DONE) {
+        auto& cache = KeyCache::instance();
+        if (cache.enabled()) {
+            cache.store(cache.make_id(password_, job.salt, job.config, job.key.size()), job.key);
+        }
+        SecureBytes().swap(job.key);
+        job.state = State::TAKEN;
+    }
+    return true;
+}
+
+KdfSchedulerStats KdfScheduler::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+} // namespace core
+} // namespace filevault
@@ -0,0 +1,144 @@
+/**
+ * @file key_cache.cpp
+ * @brief Bounded derived-key cache
+ */
+
+#include "filevault/core/key_cache.hpp"
+#include "filevault/core/random.hpp"
+#include <botan/mac.h>
+#include <algorithm>
+
+namespace filevault {
+namespace core {
+
+namespace {
+
+void update_u64(Botan::MessageAuthenticationCode& mac, uint64_t value) {
+    uint8_t bytes[8];
+    for (int i = 0; i < 8; ++i) {
+        bytes[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+    mac.update(bytes, sizeof(bytes));
+}
+
+} // anonymous namespace
+
+KeyCache& KeyCache::instance() {
+    static KeyCache cache;
+    return cache;
+}
+
+KeyCache::KeyCache() {
+    id_key_.resize(32);
+    RandomService::fill(id_key_);
+}
+
+KeyCache::Id KeyCache::make_id(
+    const std::string& password,
+    std::span<const uint8_t> salt,
+    const EncryptionConfig& config,
+    size_t key_size) const
+{
+    auto mac = Botan::MessageAuthenticationCode::create_or_throw("HMAC(SHA-256)");
+    mac->set_key(id_key_);
+
+    // Length-prefix the variable fields so no two inputs share an encoding
+    update_u64(*mac, static_cast<uint32_t>(config.kdf));
+    update_u64(*mac, static_cast<uint32_t>(config.level));  // Scrypt cost follows the level
+    update_u64(*mac, config.kdf_iterations);
+    update_u64(*mac, config.kdf_memory_kb);
+    update_u64(*mac, config.kdf_parallelism);
+    update_u64(*mac, key_size);
+    update_u64(*mac, password.size());
+    mac->update(reinterpret_cast<const uint8_t*>(password.data()), password.size());
+    update_u64(*mac, salt.size());
+    mac->update(salt.data(), salt.size());
+
+    Id id;
+    mac->final(id.data());
+    return id;
+}
+
+bool KeyCache::lookup(const Id& id, std::vector<uint8_t>& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    evict_expired(std::chrono::steady_clock::now());
+
+    for (auto& entry : entries_) {
+        if (entry.id == id) {
+            entry.last_used = ++clock_;
+            key.assign(entry.key.begin(), entry.key.end());
+            stats_.hits++;
+            return true;
+        }
+    }
+    stats_.misses++;
+    return false;
+}
+
+void KeyCache::store(const Id& id, std::span<const uint8_t> key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (capacity_ == 0 || ttl_.count() == 0) {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    evict_expired(now);
+
+    auto it = std::find_if(entries_.begin(), entries_.end(),
+                           [&](const Entry& e) { return e.id == id; });
+    if (it == entries_.end()) {
+        if (entries_.size() >= capacity_) {
+            it = std::min_element(entries_.begin(), entries_.end(),
+                                  [](const Entry& a, const Entry& b) { return a.last_used < b.last_used; });
+        } else {
+            it = entries_.emplace(entries_.end());
+        }
+    }
+
+    it->id = id;
+    it->key.assign(key.begin(), key.end());
+    it->expires = now + ttl_;
+    it->last_used = ++clock_;
+}
+
+void KeyCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
+
+void KeyCache::configure(size_t capacity, std::chrono::seconds ttl) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = capacity;
+    ttl_ = ttl;
+    if (capacity_ == 0 || ttl_.count() == 0) {
+        entries_.clear();
+    }
+    while (entries_.size() > capacity_) {
+        entries_.erase(std::min_element(entries_.begin(), entries_.end(),
+                                        [](const Entry& a, const Entry& b) { return a.last_used < b.last_used; }));
+    }
+}
+
+bool KeyCache::enabled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return capacity_ > 0 && ttl_.count() > 0;
+}
+
+size_t KeyCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+KeyCacheStats KeyCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void KeyCache::evict_expired(std::chrono::steady_clock::time_point now) {
+    entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                  [&](const Entry& e) { return e.expires <= now; }),
+                   entries_.end());
+}
+
+} // namespace core
+} // namespace filevault
@@ -0,0 +1,147 @@
+/**
+ * @file memory_budget.cpp
+ * @brief Process-wide memory limit shared by streams, KDFs and caches
+ */
+
+#include "filevault/core/memory_budget.hpp"
+#include <algorithm>
+
+namespace filevault {
+namespace core {
+
+MemoryBudget::Lease::~Lease() {
+    release();
+}
+
+MemoryBudget::Lease::Lease(Lease&& other) noexcept
+    : budget_(other.budget_), bytes_(other.bytes_) {
+    other.budget_ = nullptr;
+    other.bytes_ = 0;
+}
+
+MemoryBudget::Lease& MemoryBudget::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        release();
+        budget_ = other.budget_;
+        bytes_ = other.bytes_;
+        other.budget_ = nullptr;
+        other.bytes_ = 0;
+    }
+    return *this;
+}
+
+void MemoryBudget::Lease::release() {
+    if (budget_) {
+        budget_->give_back(bytes_);
+        budget_ = nullptr;
+        bytes_ = 0;
+    }
+}
+
+MemoryBudget::MemoryBudget(uint64_t limit)
+    : limit_(limit) {
+}
+
+MemoryBudget& MemoryBudget::shared() {
+    static MemoryBudget budget;
+    return budget;
+}
+
+void MemoryBudget::set_limit(uint64_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        limit_ = bytes;
+    }
+    freed_.notify_all();
+}
+
+uint64_t MemoryBudget::limit() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return limit_;
+}
+
+MemoryBudget::Lease MemoryBudget::lease(uint64_t bytes) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // Nothing else leased: even an oversized request goes ahead, alone
+    freed_.wait(lock, [&] { return limit_ == 0 || in_use_ == 0 || in_use_ + bytes <= limit_; });
+    in_use_ += bytes;
+    peak_ = (std::max)(peak_, in_use_);
+    return Lease(this, bytes);
+}
+
+MemoryBudget::Lease MemoryBudget::try_lease(uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (limit_ != 0 && in_use_ != 0 && in_use_ + bytes > limit_) {
+        return Lease();
+    }
+    in_use_ += bytes;
+    peak_ = (std::max)(peak_, in_use_);
+    return Lease(this, bytes);
+}
+
+void MemoryBudget::give_back(uint64_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_use_ -= bytes;
+    }
+    freed_.notify_all();
+}
+
+uint64_t MemoryBudget::in_use() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return in_use_;
+}
+
+uint64_t MemoryBudget::peak() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return peak_;
+}
+
+uint64_t MemoryBudget::stream_bytes(uint64_t fallback) const {
+    auto limit = this->limit();
+    return limit ? limit / 2 : fallback;
+}
+
+uint64_t MemoryBudget::kdf_bytes(uint64_t fallback) const {
+    auto limit = this->limit();
+    return limit ? limit / 4 : fallback;
+}
+
+uint64_t MemoryBudget::pool_bytes(uint64_t fallback) const {
+    auto limit = this->limit();
+    return limit ? (std::min)(fallback, limit / 8) : fallback;
+}
+
+uint64_t MemoryBudget::in_memory_bytes(uint64_t fallback) const {
+    auto limit = this->limit();
+    return limit ? (std::min)(fallback, limit / 8) : fallback;
+}
+
+uint64_t MemoryBudget::stream_cost(const StreamShape& shape, uint64_t chunks) {
+    // In-flight workers, the writer's reorder slack and the read-ahead
+    uint64_t slots = shape.workers + 2 + shape.io_buffers;
+    if (chunks > 0) {
+        slots = (std::min)(slots, chunks);
+    }
+    return 2 * slots * uint64_t{shape.chunk_size};
+}
+
+MemoryBudget::StreamShape MemoryBudget::fit_stream(StreamShape shape, bool fixed_chunk) const {
+    uint64_t share = stream_bytes(0);
+    if (share == 0) {
+        return shape;
+    }
+    while (stream_cost(shape) > share && shape.io_buffers > 0) {
+        shape.io_buffers--;
+    }
+    while (stream_cost(shape) > share && shape.workers > 1) {
+        shape.workers--;
+    }
+    while (!fixed_chunk && stream_cost(shape) > share && shape.chunk_size / 2 >= MIN_CHUNK_SIZE) {
+        shape.chunk_size /= 2;
+    }
+    return shape;
+}
+
+} // namespace core
+} // namespace filevault
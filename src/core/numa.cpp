@@ -0,0 +1,200 @@
+/**
+ * @file numa.cpp
+ * @brief NUMA topology discovery, thread and memory placement
+ */
+
+#include "filevault/core/numa.hpp"
+#include "filevault/core/thread_pool.hpp"
+#include <spdlog/spdlog.h>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace filevault {
+namespace core {
+
+namespace {
+
+struct Topology {
+    std::vector<std::vector<size_t>> node_cpus;
+    std::vector<size_t> node_ids;       // Kernel node number of each entry
+    std::vector<size_t> cpu_node;       // Indexed by CPU
+};
+
+const Topology& topology() {
+    static const Topology topo = [] {
+        Topology t;
+#ifdef __linux__
+        // Node ids may have holes (offline nodes); keep only those with CPUs
+        std::ifstream online("/sys/devices/system/node/online");
+        std::string list;
+        if (online && std::getline(online, list)) {
+            for (size_t node : Numa::parse_cpu_list(list)) {
+                std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+                std::string cpus;
+                if (file && std::getline(file, cpus)) {
+                    auto parsed = Numa::parse_cpu_list(cpus);
+                    if (!parsed.empty()) {
+                        t.node_cpus.push_back(std::move(parsed));
+                        t.node_ids.push_back(node);
+                    }
+                }
+            }
+        }
+#endif
+        if (t.node_cpus.empty()) {
+            std::vector<size_t> all(ThreadPool::default_thread_count());
+            for (size_t i = 0; i < all.size(); ++i) {
+                all[i] = i;
+            }
+            t.node_cpus.push_back(std::move(all));
+            t.node_ids.assign(1, 0);
+        }
+        for (size_t node = 0; node < t.node_cpus.size(); ++node) {
+            for (size_t cpu : t.node_cpus[node]) {
+                if (cpu >= t.cpu_node.size()) {
+                    t.cpu_node.resize(cpu + 1, 0);
+                }
+                t.cpu_node[cpu] = node;
+            }
+        }
+        return t;
+    }();
+    return topo;
+}
+
+std::atomic<bool> placement_enabled{false};
+
+} // anonymous namespace
+
+std::vector<size_t> Numa::parse_cpu_list(const std::string& list) {
+    std::vector<size_t> cpus;
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        size_t first = 0;
+        size_t last = 0;
+        try {
+            size_t dash = range.find('-');
+            first = std::stoul(range.substr(0, dash));
+            last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+        } catch (const std::exception&) {
+            continue;   // Blank or malformed piece
+        }
+        for (size_t cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+size_t Numa::node_count() {
+    return topology().node_cpus.size();
+}
+
+const std::vector<size_t>& Numa::node_cpus(size_t node) {
+    const auto& nodes = topology().node_cpus;
+    return nodes[node % nodes.size()];
+}
+
+size_t Numa::node_of_cpu(size_t cpu) {
+    const auto& map = topology().cpu_node;
+    return cpu < map.size() ? map[cpu] : 0;
+}
+
+size_t Numa::current_node() {
+#ifdef __linux__
+    if (node_count() > 1) {
+        int cpu = sched_getcpu();
+        return cpu >= 0 ? node_of_cpu(static_cast<size_t>(cpu)) : 0;
+    }
+#endif
+    return 0;
+}
+
+bool Numa::pin_current_thread(size_t node) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (size_t cpu : node_cpus(node)) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)node;
+    return false;
+#endif
+}
+
+bool Numa::prefer_node(void* data, size_t size, size_t node) {
+#if defined(__linux__) && defined(SYS_mbind)
+    if (node_count() < 2 || !data) {
+        return false;
+    }
+    // mbind works on whole pages
+    const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(data) + page - 1) & ~(page - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(data) + size) & ~(page - 1);
+    if (end <= begin) {
+        return false;
+    }
+    constexpr int MPOL_PREFERRED_MODE = 1;  // <numaif.h> MPOL_PREFERRED, without libnuma
+    constexpr size_t BITS = sizeof(unsigned long) * 8;
+    size_t id = topology().node_ids[node % node_count()];
+    std::vector<unsigned long> mask(id / BITS + 1, 0);
+    mask[id / BITS] = 1UL << (id % BITS);
+    // The kernel reads maxnode - 1 bits
+    long status = syscall(SYS_mbind, begin, end - begin, MPOL_PREFERRED_MODE, mask.data(),
+                          mask.size() * BITS + 1, 0);
+    return status == 0;
+#else
+    (void)data;
+    (void)size;
+    (void)node;
+    return false;
+#endif
+}
+
+size_t Numa::node_of_memory(const void* data) {
+#if defined(__linux__) && defined(SYS_get_mempolicy)
+    if (node_count() > 1 && data) {
+        constexpr unsigned long MPOL_F_NODE_ADDR = 1 | 2;  // MPOL_F_NODE | MPOL_F_ADDR
+        int id = -1;
+        if (syscall(SYS_get_mempolicy, &id, nullptr, 0, data, MPOL_F_NODE_ADDR) == 0 && id >= 0) {
+            const auto& ids = topology().node_ids;
+            for (size_t node = 0; node < ids.size(); ++node) {
+                if (ids[node] == static_cast<size_t>(id)) {
+                    return node;
+                }
+            }
+        }
+    }
+#else
+    (void)data;
+#endif
+    return current_node();
+}
+
+void Numa::set_enabled(bool enabled) {
+    placement_enabled.store(enabled, std::memory_order_relaxed);
+    if (enabled && node_count() < 2) {
+        spdlog::info("NUMA placement requested, but this machine has a single node");
+    }
+}
+
+bool Numa::enabled() {
+    return placement_enabled.load(std::memory_order_relaxed) && node_count() > 1;
+}
+
+} // namespace core
+} // namespace filevault
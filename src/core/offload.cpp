@@ -0,0 +1,391 @@
+/**
+ * @file offload.cpp
+ * @brief Keystream device selection and the portable reference kernels
+ */
+
+#include "filevault/core/offload.hpp"
+#include <botan/stream_cipher.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace filevault {
+namespace core {
+
+namespace {
+
+struct OffloadState {
+    std::mutex mutex;
+    OffloadMode mode = OffloadMode::OFF;
+    size_t min_bytes = Offload::DEFAULT_MIN_BYTES;
+    bool probed = false;
+    bool disabled = false;
+    // Kept after disable(): another thread may still be inside a call
+    std::unique_ptr<IKeystreamDevice> device;
+};
+
+OffloadState& state() {
+    static OffloadState instance;
+    return instance;
+}
+
+// Several kernel blocks plus a partial one, so both the device path and
+// the tail are checked
+constexpr size_t SELF_TEST_SIZE = 8 * 64 + 37;
+constexpr uint32_t SELF_TEST_CHACHA_COUNTER = 1;      // What the AEAD sessions start from
+
+} // anonymous namespace
+
+std::optional<OffloadMode> Offload::parse_mode(const std::string& text) {
+    if (text == "off" || text == "cpu") return OffloadMode::OFF;
+    if (text == "auto") return OffloadMode::AUTO;
+    if (text == "opencl" || text == "gpu") return OffloadMode::OPENCL;
+    return std::nullopt;
+}
+
+void Offload::configure(OffloadMode mode, size_t min_bytes) {
+    auto& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.mode != mode) {
+        s.probed = false;
+        s.disabled = false;
+    }
+    s.mode = mode;
+    s.min_bytes = min_bytes;
+}
+
+IKeystreamDevice* Offload::device() {
+    auto& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.disabled) {
+        return nullptr;
+    }
+    if (!s.probed) {
+        s.probed = true;
+        if (s.mode != OffloadMode::OFF) {
+            std::string detail;
+            s.device = open_opencl_device(detail);
+            if (s.device && !self_test(*s.device, detail)) {
+                spdlog::warn("Offload device {} failed its self-test ({}), using the CPU",
+                             s.device->name(), detail);
+                s.device.reset();
+            } else if (s.device) {
+                spdlog::info("Offloading keystreams to {}", detail);
+            } else if (s.mode == OffloadMode::OPENCL) {
+                spdlog::warn("No OpenCL device ({}), using the CPU", detail);
+            } else {
+                spdlog::debug("No offload device ({}), using the CPU", detail);
+            }
+        }
+    }
+    return s.device.get();
+}
+
+size_t Offload::min_bytes() {
+    auto& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.min_bytes;
+}
+
+void Offload::set_min_bytes(size_t min_bytes) {
+    auto& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.min_bytes = min_bytes;
+}
+
+void Offload::disable(const std::string& reason) {
+    auto& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (!s.disabled && s.device) {
+        spdlog::warn("Offload device {} failed ({}), using the CPU from now on", s.device->name(), reason);
+    }
+    s.disabled = true;
+}
+
+bool Offload::self_test(IKeystreamDevice& device, std::string& detail) {
+    std::vector<uint8_t> plaintext(SELF_TEST_SIZE);
+    for (size_t i = 0; i < plaintext.size(); ++i) {
+        plaintext[i] = static_cast<uint8_t>(i * 31 + 7);
+    }
+    std::array<uint8_t, 32> key;
+    for (size_t i = 0; i < key.size(); ++i) {
+        key[i] = static_cast<uint8_t>(i * 13 + 1);
+    }
+    // Low 64 bits about to wrap, so the carry into the high half is covered
+    std::array<uint8_t, 16> counter = {0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+                                       0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfd};
+    auto nonce = std::span<const uint8_t, 12>(counter.data(), 12);
+
+    try {
+        for (size_t key_size : {size_t{16}, size_t{32}}) {
+            std::string name = "AES-" + std::to_string(key_size * 8);
+            auto expected = plaintext;
+            auto cipher = Botan::StreamCipher::create_or_throw("CTR-BE(" + name + ")");
+            cipher->set_key(key.data(), key_size);
+            cipher->set_iv(counter.data(), counter.size());
+            cipher->cipher1(expected.data(), expected.size());
+
+            auto actual = plaintext;
+            if (device.aes_ctr(std::span<const uint8_t>(key.data(), key_size), counter, actual) !=
+                    OffloadStatus::DONE || actual != expected) {
+                detail = name + "-CTR does not match Botan";
+                return false;
+            }
+        }
+
+        auto expected = plaintext;
+        auto cipher = Botan::StreamCipher::create_or_throw("ChaCha(20)");
+        cipher->set_key(key.data(), key.size());
+        cipher->set_iv(nonce.data(), nonce.size());
+        cipher->seek(uint64_t{SELF_TEST_CHACHA_COUNTER} * 64);
+        cipher->cipher1(expected.data(), expected.size());
+
+        auto actual = plaintext;
+        if (device.chacha20(key, nonce, SELF_TEST_CHACHA_COUNTER, actual) != OffloadStatus::DONE ||
+                actual != expected) {
+            detail = "ChaCha20 does not match Botan";
+            return false;
+        }
+    } catch (const std::exception& e) {
+        detail = e.what();
+        return false;
+    }
+    return true;
+}
+
+void Offload::install(std::unique_ptr<IKeystreamDevice> device, size_t min_bytes) {
+    auto& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.mode = device ? OffloadMode::AUTO : OffloadMode::OFF;
+    s.min_bytes = min_bytes;
+    s.probed = true;
+    s.disabled = false;
+    s.device = std::move(device);
+}
+
+namespace keystream {
+
+namespace {
+
+uint8_t xtime(uint8_t x) {
+    return static_cast<uint8_t>((x << 1) ^ ((x & 0x80) ? 0x1B : 0x00));
+}
+
+uint8_t rotl8(uint8_t x, int shift) {
+    return static_cast<uint8_t>((x << shift) | (x >> (8 - shift)));
+}
+
+uint32_t rotr32(uint32_t x, int shift) {
+    return (x >> shift) | (x << (32 - shift));
+}
+
+uint32_t rotl32(uint32_t x, int shift) {
+    return (x << shift) | (x >> (32 - shift));
+}
+
+uint32_t load_be32(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+void store_be32(uint8_t* p, uint32_t v) {
+    p[0] = static_cast<uint8_t>(v >> 24);
+    p[1] = static_cast<uint8_t>(v >> 16);
+    p[2] = static_cast<uint8_t>(v >> 8);
+    p[3] = static_cast<uint8_t>(v);
+}
+
+uint32_t load_le32(const uint8_t* p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+void store_le32(uint8_t* p, uint32_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+    p[2] = static_cast<uint8_t>(v >> 16);
+    p[3] = static_cast<uint8_t>(v >> 24);
+}
+
+AesTables build_tables() {
+    AesTables tables{};
+    // S-box from the multiplicative inverse (p walks GF(2^8) by 3, q by 1/3)
+    uint8_t p = 1;
+    uint8_t q = 1;
+    do {
+        p = static_cast<uint8_t>(p ^ xtime(p));
+        q = static_cast<uint8_t>(q ^ (q << 1));
+        q = static_cast<uint8_t>(q ^ (q << 2));
+        q = static_cast<uint8_t>(q ^ (q << 4));
+        if (q & 0x80) {
+            q ^= 0x09;
+        }
+        uint8_t affine = static_cast<uint8_t>(q ^ rotl8(q, 1) ^ rotl8(q, 2) ^ rotl8(q, 3) ^ rotl8(q, 4));
+        tables.sbox[p] = static_cast<uint8_t>(affine ^ 0x63);
+    } while (p != 1);
+    tables.sbox[0] = 0x63;
+
+    for (size_t i = 0; i < 256; ++i) {
+        uint8_t s = tables.sbox[i];
+        uint8_t s2 = xtime(s);
+        tables.te0[i] = (uint32_t(s2) << 24) | (uint32_t(s) << 16) | (uint32_t(s) << 8) | uint32_t(s2 ^ s);
+    }
+    return tables;
+}
+
+void quarter_round(uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d) {
+    a += b; d ^= a; d = rotl32(d, 16);
+    c += d; b ^= c; b = rotl32(b, 12);
+    a += b; d ^= a; d = rotl32(d, 8);
+    c += d; b ^= c; b = rotl32(b, 7);
+}
+
+} // anonymous namespace
+
+const AesTables& aes_tables() {
+    static const AesTables tables = build_tables();
+    return tables;
+}
+
+int aes_expand_key(std::span<const uint8_t> key, std::array<uint32_t, AES_MAX_ROUND_WORDS>& round_keys) {
+    size_t nk = key.size() / 4;
+    if (key.size() != 16 && key.size() != 24 && key.size() != 32) {
+        return 0;
+    }
+    int rounds = static_cast<int>(nk) + 6;
+    size_t total = 4 * static_cast<size_t>(rounds + 1);
+    const auto& sbox = aes_tables().sbox;
+
+    for (size_t i = 0; i < nk; ++i) {
+        round_keys[i] = load_be32(key.data() + 4 * i);
+    }
+    uint8_t rcon = 0x01;
+    for (size_t i = nk; i < total; ++i) {
+        uint32_t temp = round_keys[i - 1];
+        if (i % nk == 0 || (nk > 6 && i % nk == 4)) {
+            if (i % nk == 0) {
+                temp = (temp << 8) | (temp >> 24);
+            }
+            temp = (uint32_t(sbox[temp >> 24]) << 24) | (uint32_t(sbox[(temp >> 16) & 0xFF]) << 16) |
+                   (uint32_t(sbox[(temp >> 8) & 0xFF]) << 8) | uint32_t(sbox[temp & 0xFF]);
+            if (i % nk == 0) {
+                temp ^= uint32_t(rcon) << 24;
+                rcon = xtime(rcon);
+            }
+        }
+        round_keys[i] = round_keys[i - nk] ^ temp;
+    }
+    return rounds;
+}
+
+void aes_encrypt_block(const std::array<uint32_t, AES_MAX_ROUND_WORDS>& round_keys, int rounds,
+                       const uint8_t in[16], uint8_t out[16]) {
+    const auto& t = aes_tables();
+    const auto& te = t.te0;
+    const uint32_t* rk = round_keys.data();
+
+    uint32_t s0 = load_be32(in) ^ rk[0];
+    uint32_t s1 = load_be32(in + 4) ^ rk[1];
+    uint32_t s2 = load_be32(in + 8) ^ rk[2];
+    uint32_t s3 = load_be32(in + 12) ^ rk[3];
+
+    for (int round = 1; round < rounds; ++round) {
+        rk += 4;
+        uint32_t t0 = te[s0 >> 24] ^ rotr32(te[(s1 >> 16) & 0xFF], 8) ^ rotr32(te[(s2 >> 8) & 0xFF], 16) ^
+                      rotr32(te[s3 & 0xFF], 24) ^ rk[0];
+        uint32_t t1 = te[s1 >> 24] ^ rotr32(te[(s2 >> 16) & 0xFF], 8) ^ rotr32(te[(s3 >> 8) & 0xFF], 16) ^
+                      rotr32(te[s0 & 0xFF], 24) ^ rk[1];
+        uint32_t t2 = te[s2 >> 24] ^ rotr32(te[(s3 >> 16) & 0xFF], 8) ^ rotr32(te[(s0 >> 8) & 0xFF], 16) ^
+                      rotr32(te[s1 & 0xFF], 24) ^ rk[2];
+        uint32_t t3 = te[s3 >> 24] ^ rotr32(te[(s0 >> 16) & 0xFF], 8) ^ rotr32(te[(s1 >> 8) & 0xFF], 16) ^
+                      rotr32(te[s2 & 0xFF], 24) ^ rk[3];
+        s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+    }
+
+    // Last round: SubBytes and ShiftRows only
+    rk += 4;
+    const auto& sbox = t.sbox;
+    auto last = [&](uint32_t a, uint32_t b, uint32_t c, uint32_t d, uint32_t k) {
+        return ((uint32_t(sbox[a >> 24]) << 24) | (uint32_t(sbox[(b >> 16) & 0xFF]) << 16) |
+                (uint32_t(sbox[(c >> 8) & 0xFF]) << 8) | uint32_t(sbox[d & 0xFF])) ^ k;
+    };
+    store_be32(out, last(s0, s1, s2, s3, rk[0]));
+    store_be32(out + 4, last(s1, s2, s3, s0, rk[1]));
+    store_be32(out + 8, last(s2, s3, s0, s1, rk[2]));
+    store_be32(out + 12, last(s3, s0, s1, s2, rk[3]));
+}
+
+void add_counter(std::span<uint8_t, 16> counter, uint64_t blocks) {
+    uint64_t carry = blocks;
+    for (size_t i = 16; i-- > 0 && carry != 0;) {
+        uint64_t sum = counter[i] + (carry & 0xFF);
+        counter[i] = static_cast<uint8_t>(sum);
+        carry = (carry >> 8) + (sum >> 8);
+    }
+}
+
+void aes_ctr_xor(std::span<const uint8_t> key, std::span<const uint8_t, 16> counter, std::span<uint8_t> data) {
+    std::array<uint32_t, AES_MAX_ROUND_WORDS> round_keys{};
+    int rounds = aes_expand_key(key, round_keys);
+    if (rounds == 0) {
+        return;
+    }
+    std::array<uint8_t, 16> block;
+    std::copy(counter.begin(), counter.end(), block.begin());
+    uint8_t stream[16];
+    for (size_t offset = 0; offset < data.size(); offset += 16) {
+        aes_encrypt_block(round_keys, rounds, block.data(), stream);
+        size_t n = (std::min)(size_t{16}, data.size() - offset);
+        for (size_t i = 0; i < n; ++i) {
+            data[offset + i] ^= stream[i];
+        }
+        add_counter(block, 1);
+    }
+    std::fill(round_keys.begin(), round_keys.end(), 0u);
+}
+
+void chacha20_block(std::span<const uint8_t, 32> key, std::span<const uint8_t, 12> nonce, uint32_t counter,
+                    uint8_t out[64]) {
+    uint32_t input[16] = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574};
+    for (size_t i = 0; i < 8; ++i) {
+        input[4 + i] = load_le32(key.data() + 4 * i);
+    }
+    input[12] = counter;
+    for (size_t i = 0; i < 3; ++i) {
+        input[13 + i] = load_le32(nonce.data() + 4 * i);
+    }
+
+    uint32_t x[16];
+    std::memcpy(x, input, sizeof(x));
+    for (int i = 0; i < 10; ++i) {
+        quarter_round(x[0], x[4], x[8], x[12]);
+        quarter_round(x[1], x[5], x[9], x[13]);
+        quarter_round(x[2], x[6], x[10], x[14]);
+        quarter_round(x[3], x[7], x[11], x[15]);
+        quarter_round(x[0], x[5], x[10], x[15]);
+        quarter_round(x[1], x[6], x[11], x[12]);
+        quarter_round(x[2], x[7], x[8], x[13]);
+        quarter_round(x[3], x[4], x[9], x[14]);
+    }
+    for (size_t i = 0; i < 16; ++i) {
+        store_le32(out + 4 * i, x[i] + input[i]);
+    }
+}
+
+void chacha20_xor(std::span<const uint8_t, 32> key, std::span<const uint8_t, 12> nonce, uint32_t counter,
+                  std::span<uint8_t> data) {
+    uint8_t stream[64];
+    for (size_t offset = 0; offset < data.size(); offset += 64, ++counter) {
+        chacha20_block(key, nonce, counter, stream);
+        size_t n = (std::min)(size_t{64}, data.size() - offset);
+        for (size_t i = 0; i < n; ++i) {
+            data[offset + i] ^= stream[i];
+        }
+    }
+    std::memset(stream, 0, sizeof(stream));
+}
+
+} // namespace keystream
+
+} // namespace core
+} // namespace filevault
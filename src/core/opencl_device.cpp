@@ -0,0 +1,587 @@
+/**
+ * @file opencl_device.cpp
+ * @brief Keystream device on OpenCL, loaded at run time
+ */
+
+#include "filevault/core/offload.hpp"
+#include <botan/stream_cipher.h>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#define FV_CL_CALL __stdcall
+#else
+#include <dlfcn.h>
+#define FV_CL_CALL
+#endif
+
+namespace filevault {
+namespace core {
+
+namespace {
+
+// Tails and rollbacks go through Botan; the reference tables only feed the kernels
+void host_aes_ctr(std::span<const uint8_t> key, std::span<const uint8_t, 16> counter, uint64_t first_block,
+                  std::span<uint8_t> data) {
+    auto cipher = Botan::StreamCipher::create_or_throw("CTR-BE(AES-" + std::to_string(key.size() * 8) + ")");
+    cipher->set_key(key.data(), key.size());
+    cipher->set_iv(counter.data(), counter.size());
+    cipher->seek(first_block * 16);
+    cipher->cipher1(data.data(), data.size());
+}
+
+void host_chacha20(std::span<const uint8_t, 32> key, std::span<const uint8_t, 12> nonce, uint32_t counter,
+                   std::span<uint8_t> data) {
+    auto cipher = Botan::StreamCipher::create_or_throw("ChaCha(20)");
+    cipher->set_key(key.data(), key.size());
+    cipher->set_iv(nonce.data(), nonce.size());
+    cipher->seek(uint64_t{counter} * 64);
+    cipher->cipher1(data.data(), data.size());
+}
+
+// The few OpenCL 1.2 declarations used here, so no SDK headers are needed
+using cl_int = int32_t;
+using cl_uint = uint32_t;
+using cl_ulong = uint64_t;
+using cl_platform_id = struct _cl_platform_id*;
+using cl_device_id = struct _cl_device_id*;
+using cl_context = struct _cl_context*;
+using cl_command_queue = struct _cl_command_queue*;
+using cl_mem = struct _cl_mem*;
+using cl_program = struct _cl_program*;
+using cl_kernel = struct _cl_kernel*;
+using cl_event = struct _cl_event*;
+
+constexpr cl_int CL_SUCCESS = 0;
+constexpr cl_uint CL_TRUE = 1;
+constexpr cl_ulong CL_DEVICE_TYPE_GPU = 1 << 2;
+constexpr cl_ulong CL_DEVICE_TYPE_ACCELERATOR = 1 << 3;
+constexpr cl_uint CL_DEVICE_NAME = 0x102B;
+constexpr cl_uint CL_PROGRAM_BUILD_LOG = 0x1183;
+constexpr cl_ulong CL_MEM_READ_WRITE = 1 << 0;
+constexpr cl_ulong CL_MEM_READ_ONLY = 1 << 2;
+constexpr cl_ulong CL_MEM_ALLOC_HOST_PTR = 1 << 4;
+constexpr cl_ulong CL_MEM_COPY_HOST_PTR = 1 << 5;
+constexpr cl_ulong CL_MAP_READ = 1 << 0;
+constexpr cl_ulong CL_MAP_WRITE = 1 << 1;
+
+struct OpenClApi {
+    cl_int (FV_CL_CALL *GetPlatformIDs)(cl_uint, cl_platform_id*, cl_uint*);
+    cl_int (FV_CL_CALL *GetDeviceIDs)(cl_platform_id, cl_ulong, cl_uint, cl_device_id*, cl_uint*);
+    cl_int (FV_CL_CALL *GetDeviceInfo)(cl_device_id, cl_uint, size_t, void*, size_t*);
+    cl_context (FV_CL_CALL *CreateContext)(const intptr_t*, cl_uint, const cl_device_id*, void*, void*, cl_int*);
+    cl_command_queue (FV_CL_CALL *CreateCommandQueue)(cl_context, cl_device_id, cl_ulong, cl_int*);
+    cl_mem (FV_CL_CALL *CreateBuffer)(cl_context, cl_ulong, size_t, void*, cl_int*);
+    cl_program (FV_CL_CALL *CreateProgramWithSource)(cl_context, cl_uint, const char**, const size_t*, cl_int*);
+    cl_int (FV_CL_CALL *BuildProgram)(cl_program, cl_uint, const cl_device_id*, const char*, void*, void*);
+    cl_int (FV_CL_CALL *GetProgramBuildInfo)(cl_program, cl_device_id, cl_uint, size_t, void*, size_t*);
+    cl_kernel (FV_CL_CALL *CreateKernel)(cl_program, const char*, cl_int*);
+    cl_int (FV_CL_CALL *SetKernelArg)(cl_kernel, cl_uint, size_t, const void*);
+    cl_int (FV_CL_CALL *EnqueueWriteBuffer)(cl_command_queue, cl_mem, cl_uint, size_t, size_t, const void*,
+                                            cl_uint, const cl_event*, cl_event*);
+    cl_int (FV_CL_CALL *EnqueueReadBuffer)(cl_command_queue, cl_mem, cl_uint, size_t, size_t, void*,
+                                           cl_uint, const cl_event*, cl_event*);
+    cl_int (FV_CL_CALL *EnqueueNDRangeKernel)(cl_command_queue, cl_kernel, cl_uint, const size_t*, const size_t*,
+                                              const size_t*, cl_uint, const cl_event*, cl_event*);
+    void* (FV_CL_CALL *EnqueueMapBuffer)(cl_command_queue, cl_mem, cl_uint, cl_ulong, size_t, size_t,
+                                         cl_uint, const cl_event*, cl_event*, cl_int*);
+    cl_int (FV_CL_CALL *EnqueueUnmapMemObject)(cl_command_queue, cl_mem, void*, cl_uint, const cl_event*, cl_event*);
+    cl_int (FV_CL_CALL *Flush)(cl_command_queue);
+    cl_int (FV_CL_CALL *Finish)(cl_command_queue);
+    cl_int (FV_CL_CALL *ReleaseMemObject)(cl_mem);
+    cl_int (FV_CL_CALL *ReleaseKernel)(cl_kernel);
+    cl_int (FV_CL_CALL *ReleaseProgram)(cl_program);
+    cl_int (FV_CL_CALL *ReleaseCommandQueue)(cl_command_queue);
+    cl_int (FV_CL_CALL *ReleaseContext)(cl_context);
+};
+
+// One work item per cipher block; the host keeps the partial block at the end
+const char* KERNEL_SOURCE = R"CL(
+__kernel void aes_ctr(__global uchar* data, __constant uint* te0, __constant uchar* sbox,
+                      __constant uint* rk, int rounds, uint c0, uint c1, uint c2, uint c3) {
+    ulong n = (ulong)get_global_id(0);
+    ulong lo = (((ulong)c2 << 32) | c3) + n;
+    ulong hi = (((ulong)c0 << 32) | c1) + (lo < n ? 1 : 0);
+    uint s0 = (uint)(hi >> 32) ^ rk[0];
+    uint s1 = (uint)hi ^ rk[1];
+    uint s2 = (uint)(lo >> 32) ^ rk[2];
+    uint s3 = (uint)lo ^ rk[3];
+    for (int r = 1; r < rounds; ++r) {
+        __constant uint* k = rk + 4 * r;
+        uint t0 = te0[s0 >> 24] ^ rotate(te0[(s1 >> 16) & 0xff], 24u) ^ rotate(te0[(s2 >> 8) & 0xff], 16u) ^ rotate(te0[s3 & 0xff], 8u) ^ k[0];
+        uint t1 = te0[s1 >> 24] ^ rotate(te0[(s2 >> 16) & 0xff], 24u) ^ rotate(te0[(s3 >> 8) & 0xff], 16u) ^ rotate(te0[s0 & 0xff], 8u) ^ k[1];
+        uint t2 = te0[s2 >> 24] ^ rotate(te0[(s3 >> 16) & 0xff], 24u) ^ rotate(te0[(s0 >> 8) & 0xff], 16u) ^ rotate(te0[s1 & 0xff], 8u) ^ k[2];
+        uint t3 = te0[s3 >> 24] ^ rotate(te0[(s0 >> 16) & 0xff], 24u) ^ rotate(te0[(s1 >> 8) & 0xff], 16u) ^ rotate(te0[s2 & 0xff], 8u) ^ k[3];
+        s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+    }
+    __constant uint* k = rk + 4 * rounds;
+    uint out[4];
+    out[0] = (((uint)sbox[s0 >> 24] << 24) | ((uint)sbox[(s1 >> 16) & 0xff] << 16) | ((uint)sbox[(s2 >> 8) & 0xff] << 8) | sbox[s3 & 0xff]) ^ k[0];
+    out[1] = (((uint)sbox[s1 >> 24] << 24) | ((uint)sbox[(s2 >> 16) & 0xff] << 16) | ((uint)sbox[(s3 >> 8) & 0xff] << 8) | sbox[s0 & 0xff]) ^ k[1];
+    out[2] = (((uint)sbox[s2 >> 24] << 24) | ((uint)sbox[(s3 >> 16) & 0xff] << 16) | ((uint)sbox[(s0 >> 8) & 0xff] << 8) | sbox[s1 & 0xff]) ^ k[2];
+    out[3] = (((uint)sbox[s3 >> 24] << 24) | ((uint)sbox[(s0 >> 16) & 0xff] << 16) | ((uint)sbox[(s1 >> 8) & 0xff] << 8) | sbox[s2 & 0xff]) ^ k[3];
+    __global uchar* p = data + 16 * get_global_id(0);
+    for (int i = 0; i < 4; ++i) {
+        p[4 * i] ^= (uchar)(out[i] >> 24);
+        p[4 * i + 1] ^= (uchar)(out[i] >> 16);
+        p[4 * i + 2] ^= (uchar)(out[i] >> 8);
+        p[4 * i + 3] ^= (uchar)out[i];
+    }
+}
+
+#define QR(a, b, c, d) \
+    a += b; d = rotate(d ^ a, 16u); c += d; b = rotate(b ^ c, 12u); \
+    a += b; d = rotate(d ^ a, 8u); c += d; b = rotate(b ^ c, 7u);
+
+__kernel void chacha20(__global uchar* data, __constant uint* key, uint n0, uint n1, uint n2, uint counter) {
+    uint in[16] = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+                   key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+                   counter + (uint)get_global_id(0), n0, n1, n2};
+    uint x[16];
+    for (int i = 0; i < 16; ++i) x[i] = in[i];
+    for (int i = 0; i < 10; ++i) {
+        QR(x[0], x[4], x[8], x[12]) QR(x[1], x[5], x[9], x[13])
+        QR(x[2], x[6], x[10], x[14]) QR(x[3], x[7], x[11], x[15])
+        QR(x[0], x[5], x[10], x[15]) QR(x[1], x[6], x[11], x[12])
+        QR(x[2], x[7], x[8], x[13]) QR(x[3], x[4], x[9], x[14])
+    }
+    __global uchar* p = data + 64 * get_global_id(0);
+    for (int i = 0; i < 16; ++i) {
+        uint v = x[i] + in[i];
+        p[4 * i] ^= (uchar)v;
+        p[4 * i + 1] ^= (uchar)(v >> 8);
+        p[4 * i + 2] ^= (uchar)(v >> 16);
+        p[4 * i + 3] ^= (uchar)(v >> 24);
+    }
+}
+)CL";
+
+class Library {
+public:
+    Library() {
+#ifdef _WIN32
+        handle_ = LoadLibraryA("OpenCL.dll");
+#elif defined(__APPLE__)
+        handle_ = dlopen("/System/Library/Frameworks/OpenCL.framework/OpenCL", RTLD_NOW | RTLD_LOCAL);
+#else
+        handle_ = dlopen("libOpenCL.so.1", RTLD_NOW | RTLD_LOCAL);
+        if (!handle_) {
+            handle_ = dlopen("libOpenCL.so", RTLD_NOW | RTLD_LOCAL);
+        }
+#endif
+    }
+
+    ~Library() {
+        if (handle_) {
+#ifdef _WIN32
+            FreeLibrary(static_cast<HMODULE>(handle_));
+#else
+            dlclose(handle_);
+#endif
+        }
+    }
+
+    Library(const Library&) = delete;
+    Library& operator=(const Library&) = delete;
+
+    bool loaded() const { return handle_ != nullptr; }
+
+    template <typename Fn>
+    bool bind(Fn& fn, const char* name) {
+#ifdef _WIN32
+        auto address = GetProcAddress(static_cast<HMODULE>(handle_), name);
+#else
+        void* address = dlsym(handle_, name);
+#endif
+        fn = reinterpret_cast<Fn>(address);
+        return fn != nullptr;
+    }
+
+private:
+    void* handle_ = nullptr;
+};
+
+/**
+ * Two slots of SLICE_SIZE bytes, each with its own in-order queue and a
+ * pinned staging buffer, take turns: while the GPU works on one slice,
+ * the CPU copies the previous result out of the other slot and the next
+ * slice in. Pinned memory lets the driver DMA straight from the staging
+ * buffer instead of bouncing through a copy of its own.
+ */
+class OpenClDevice : public IKeystreamDevice {
+public:
+    static constexpr size_t SLICE_SIZE = 8 * 1024 * 1024;
+    static constexpr size_t SLOTS = 2;
+
+    ~OpenClDevice() override { release(); }
+
+    bool open(std::string& detail) {
+        if (!library_.loaded()) {
+            detail = "OpenCL runtime not installed";
+            return false;
+        }
+        bool bound =
+            library_.bind(cl_.GetPlatformIDs, "clGetPlatformIDs") &&
+            library_.bind(cl_.GetDeviceIDs, "clGetDeviceIDs") &&
+            library_.bind(cl_.GetDeviceInfo, "clGetDeviceInfo") &&
+            library_.bind(cl_.CreateContext, "clCreateContext") &&
+            library_.bind(cl_.CreateCommandQueue, "clCreateCommandQueue") &&
+            library_.bind(cl_.CreateBuffer, "clCreateBuffer") &&
+            library_.bind(cl_.CreateProgramWithSource, "clCreateProgramWithSource") &&
+            library_.bind(cl_.BuildProgram, "clBuildProgram") &&
+            library_.bind(cl_.GetProgramBuildInfo, "clGetProgramBuildInfo") &&
+            library_.bind(cl_.CreateKernel, "clCreateKernel") &&
+            library_.bind(cl_.SetKernelArg, "clSetKernelArg") &&
+            library_.bind(cl_.EnqueueWriteBuffer, "clEnqueueWriteBuffer") &&
+            library_.bind(cl_.EnqueueReadBuffer, "clEnqueueReadBuffer") &&
+            library_.bind(cl_.EnqueueNDRangeKernel, "clEnqueueNDRangeKernel") &&
+            library_.bind(cl_.EnqueueMapBuffer, "clEnqueueMapBuffer") &&
+            library_.bind(cl_.EnqueueUnmapMemObject, "clEnqueueUnmapMemObject") &&
+            library_.bind(cl_.Flush, "clFlush") &&
+            library_.bind(cl_.Finish, "clFinish") &&
+            library_.bind(cl_.ReleaseMemObject, "clReleaseMemObject") &&
+            library_.bind(cl_.ReleaseKernel, "clReleaseKernel") &&
+            library_.bind(cl_.ReleaseProgram, "clReleaseProgram") &&
+            library_.bind(cl_.ReleaseCommandQueue, "clReleaseCommandQueue") &&
+            library_.bind(cl_.ReleaseContext, "clReleaseContext");
+        if (!bound) {
+            detail = "OpenCL runtime is missing functions";
+            return false;
+        }
+
+        if (!find_device()) {
+            detail = "no OpenCL GPU or accelerator";
+            return false;
+        }
+        char name[256] = {};
+        cl_.GetDeviceInfo(device_, CL_DEVICE_NAME, sizeof(name) - 1, name, nullptr);
+        name_ = std::string("OpenCL ") + name;
+
+        cl_int err = CL_SUCCESS;
+        context_ = cl_.CreateContext(nullptr, 1, &device_, nullptr, nullptr, &err);
+        if (err != CL_SUCCESS) {
+            detail = "cannot create an OpenCL context (" + std::to_string(err) + ")";
+            return false;
+        }
+        if (!build_program(detail)) {
+            return false;
+        }
+
+        const auto& tables = keystream::aes_tables();
+        te0_ = cl_.CreateBuffer(context_, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(tables.te0),
+                                const_cast<uint32_t*>(tables.te0.data()), &err);
+        if (err == CL_SUCCESS) {
+            sbox_ = cl_.CreateBuffer(context_, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(tables.sbox),
+                                     const_cast<uint8_t*>(tables.sbox.data()), &err);
+        }
+        if (err == CL_SUCCESS) {
+            round_keys_ = cl_.CreateBuffer(context_, CL_MEM_READ_ONLY,
+                                           keystream::AES_MAX_ROUND_WORDS * sizeof(uint32_t), nullptr, &err);
+        }
+        for (auto& slot : slots_) {
+            if (err != CL_SUCCESS) {
+                break;
+            }
+            slot.queue = cl_.CreateCommandQueue(context_, device_, 0, &err);
+            if (err == CL_SUCCESS) {
+                slot.pinned = cl_.CreateBuffer(context_, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, SLICE_SIZE,
+                                               nullptr, &err);
+            }
+            if (err == CL_SUCCESS) {
+                slot.staging = static_cast<uint8_t*>(cl_.EnqueueMapBuffer(
+                    slot.queue, slot.pinned, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, SLICE_SIZE,
+                    0, nullptr, nullptr, &err));
+            }
+            if (err == CL_SUCCESS) {
+                slot.device = cl_.CreateBuffer(context_, CL_MEM_READ_WRITE, SLICE_SIZE, nullptr, &err);
+            }
+        }
+        if (err != CL_SUCCESS) {
+            detail = "cannot allocate OpenCL buffers (" + std::to_string(err) + ")";
+            return false;
+        }
+        detail = name_;
+        return true;
+    }
+
+    std::string name() const override { return name_; }
+
+    OffloadStatus aes_ctr(std::span<const uint8_t> key, std::span<const uint8_t, 16> counter,
+                          std::span<uint8_t> data) override {
+        std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return OffloadStatus::BUSY;
+        }
+        std::array<uint32_t, keystream::AES_MAX_ROUND_WORDS> round_keys{};
+        cl_int rounds = keystream::aes_expand_key(key, round_keys);
+        if (rounds == 0) {
+            return OffloadStatus::FAILED;
+        }
+        cl_int err = cl_.EnqueueWriteBuffer(slots_[0].queue, round_keys_, CL_TRUE, 0, sizeof(round_keys),
+                                            round_keys.data(), 0, nullptr, nullptr);
+        std::fill(round_keys.begin(), round_keys.end(), 0u);
+        if (err != CL_SUCCESS) {
+            return OffloadStatus::FAILED;
+        }
+
+        auto set_slice_args = [&](size_t offset) {
+            std::array<uint8_t, 16> block;
+            std::copy(counter.begin(), counter.end(), block.begin());
+            keystream::add_counter(block, offset / 16);
+            cl_int e = set_arg(aes_kernel_, 1, te0_) | set_arg(aes_kernel_, 2, sbox_) |
+                       set_arg(aes_kernel_, 3, round_keys_) | set_arg(aes_kernel_, 4, rounds);
+            for (cl_uint i = 0; i < 4; ++i) {
+                uint32_t word = (uint32_t(block[4 * i]) << 24) | (uint32_t(block[4 * i + 1]) << 16) |
+                                (uint32_t(block[4 * i + 2]) << 8) | uint32_t(block[4 * i + 3]);
+                e |= set_arg(aes_kernel_, 5 + i, word);
+            }
+            return e;
+        };
+        size_t whole = data.size() / 16 * 16;
+        size_t done = run(aes_kernel_, 16, data.first(whole), set_slice_args);
+        if (done != whole) {
+            // Keystream XOR is its own inverse: put back what was already written
+            host_aes_ctr(key, counter, 0, data.first(done));
+            clear_round_keys();
+            return OffloadStatus::FAILED;
+        }
+        clear_round_keys();
+
+        if (whole < data.size()) {
+            host_aes_ctr(key, counter, whole / 16, data.subspan(whole));
+        }
+        return OffloadStatus::DONE;
+    }
+
+    OffloadStatus chacha20(std::span<const uint8_t, 32> key, std::span<const uint8_t, 12> nonce,
+                           uint32_t counter, std::span<uint8_t> data) override {
+        std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return OffloadStatus::BUSY;
+        }
+        std::array<uint32_t, 8> key_words;
+        for (size_t i = 0; i < 8; ++i) {
+            key_words[i] = load_le32(key.data() + 4 * i);
+        }
+        cl_int err = cl_.EnqueueWriteBuffer(slots_[0].queue, round_keys_, CL_TRUE, 0, sizeof(key_words),
+                                            key_words.data(), 0, nullptr, nullptr);
+        std::fill(key_words.begin(), key_words.end(), 0u);
+        if (err != CL_SUCCESS) {
+            return OffloadStatus::FAILED;
+        }
+
+        auto set_slice_args = [&](size_t offset) {
+            uint32_t slice_counter = counter + static_cast<uint32_t>(offset / 64);
+            return set_arg(chacha_kernel_, 1, round_keys_) |
+                   set_arg(chacha_kernel_, 2, load_le32(nonce.data())) |
+                   set_arg(chacha_kernel_, 3, load_le32(nonce.data() + 4)) |
+                   set_arg(chacha_kernel_, 4, load_le32(nonce.data() + 8)) |
+                   set_arg(chacha_kernel_, 5, slice_counter);
+        };
+        size_t whole = data.size() / 64 * 64;
+        size_t done = run(chacha_kernel_, 64, data.first(whole), set_slice_args);
+        if (done != whole) {
+            host_chacha20(key, nonce, counter, data.first(done));
+            clear_round_keys();
+            return OffloadStatus::FAILED;
+        }
+        clear_round_keys();
+
+        if (whole < data.size()) {
+            host_chacha20(key, nonce, counter + static_cast<uint32_t>(whole / 64), data.subspan(whole));
+        }
+        return OffloadStatus::DONE;
+    }
+
+private:
+    struct Slot {
+        cl_command_queue queue = nullptr;
+        cl_mem pinned = nullptr;        // Host-side staging, mapped at staging
+        cl_mem device = nullptr;
+        uint8_t* staging = nullptr;
+        uint8_t* target = nullptr;      // Where the slice in flight goes back to
+        size_t size = 0;
+    };
+
+    static uint32_t load_le32(const uint8_t* p) {
+        return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+    }
+
+    template <typename T>
+    cl_int set_arg(cl_kernel kernel, cl_uint index, const T& value) {
+        return cl_.SetKernelArg(kernel, index, sizeof(T), &value);
+    }
+
+    bool find_device() {
+        cl_uint count = 0;
+        if (cl_.GetPlatformIDs(0, nullptr, &count) != CL_SUCCESS || count == 0) {
+            return false;
+        }
+        std::vector<cl_platform_id> platforms(count);
+        if (cl_.GetPlatformIDs(count, platforms.data(), nullptr) != CL_SUCCESS) {
+            return false;
+        }
+        for (auto platform : platforms) {
+            cl_uint devices = 0;
+            if (cl_.GetDeviceIDs(platform, CL_DEVICE_TYPE_GPU | CL_DEVICE_TYPE_ACCELERATOR, 1, &device_,
+                                 &devices) == CL_SUCCESS && devices > 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool build_program(std::string& detail) {
+        cl_int err = CL_SUCCESS;
+        program_ = cl_.CreateProgramWithSource(context_, 1, &KERNEL_SOURCE, nullptr, &err);
+        if (err == CL_SUCCESS) {
+            err = cl_.BuildProgram(program_, 1, &device_, "", nullptr, nullptr);
+        }
+        if (err != CL_SUCCESS) {
+            detail = "OpenCL kernels failed to build (" + std::to_string(err) + ")";
+            if (program_) {
+                char log[512] = {};
+                cl_.GetProgramBuildInfo(program_, device_, CL_PROGRAM_BUILD_LOG, sizeof(log) - 1, log, nullptr);
+                std::string first_line(log, std::find(log, log + std::strlen(log), '\n'));
+                if (!first_line.empty()) {
+                    detail += ": " + first_line;
+                }
+            }
+            return false;
+        }
+        aes_kernel_ = cl_.CreateKernel(program_, "aes_ctr", &err);
+        if (err == CL_SUCCESS) {
+            chacha_kernel_ = cl_.CreateKernel(program_, "chacha20", &err);
+        }
+        if (err != CL_SUCCESS) {
+            detail = "cannot create OpenCL kernels (" + std::to_string(err) + ")";
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Push data through kernel slice by slice, alternating slots
+     * @return Bytes of data finished (all of it unless a call failed)
+     */
+    template <typename SetArgs>
+    size_t run(cl_kernel kernel, size_t block_size, std::span<uint8_t> data, SetArgs& set_slice_args) {
+        size_t done = 0;
+        size_t next = 0;
+        bool failed = false;
+
+        auto collect = [&](Slot& slot) {
+            if (slot.size == 0) {
+                return;
+            }
+            if (!failed && cl_.Finish(slot.queue) == CL_SUCCESS) {
+                std::memcpy(slot.target, slot.staging, slot.size);
+                done += slot.size;
+            } else {
+                failed = true;
+            }
+            slot.size = 0;
+        };
+
+        size_t slices = 0;
+        for (; next < data.size() && !failed; ++slices) {
+            Slot& slot = slots_[slices % SLOTS];
+            collect(slot);
+            if (failed) {
+                break;
+            }
+            size_t size = (std::min)(SLICE_SIZE, data.size() - next);
+            std::memcpy(slot.staging, data.data() + next, size);
+            size_t items = size / block_size;
+            cl_int err = set_slice_args(next) | set_arg(kernel, 0, slot.device);
+            if (err == CL_SUCCESS) {
+                err = cl_.EnqueueWriteBuffer(slot.queue, slot.device, 0, 0, size, slot.staging, 0, nullptr, nullptr);
+            }
+            if (err == CL_SUCCESS) {
+                err = cl_.EnqueueNDRangeKernel(slot.queue, kernel, 1, nullptr, &items, nullptr, 0, nullptr, nullptr);
+            }
+            if (err == CL_SUCCESS) {
+                err = cl_.EnqueueReadBuffer(slot.queue, slot.device, 0, 0, size, slot.staging, 0, nullptr, nullptr);
+            }
+            if (err == CL_SUCCESS) {
+                err = cl_.Flush(slot.queue);
+            }
+            if (err != CL_SUCCESS) {
+                failed = true;
+                break;
+            }
+            slot.target = data.data() + next;
+            slot.size = size;
+            next += size;
+        }
+
+        // Results come back in order, so a failure leaves a finished prefix
+        for (size_t i = 0; i < SLOTS; ++i) {
+            Slot& slot = slots_[(slices + i) % SLOTS];
+            if (failed) {
+                cl_.Finish(slot.queue);
+                slot.size = 0;
+            } else {
+                collect(slot);
+            }
+        }
+        return done;
+    }
+
+    void clear_round_keys() {
+        std::array<uint32_t, keystream::AES_MAX_ROUND_WORDS> zeros{};
+        cl_.EnqueueWriteBuffer(slots_[0].queue, round_keys_, CL_TRUE, 0, sizeof(zeros), zeros.data(),
+                               0, nullptr, nullptr);
+    }
+
+    void release() {
+        if (!library_.loaded() || !cl_.ReleaseContext) {
+            return;
+        }
+        for (auto& slot : slots_) {
+            if (slot.queue) cl_.Finish(slot.queue);
+            if (slot.staging) cl_.EnqueueUnmapMemObject(slot.queue, slot.pinned, slot.staging, 0, nullptr, nullptr);
+            if (slot.queue) cl_.Finish(slot.queue);
+            if (slot.device) cl_.ReleaseMemObject(slot.device);
+            if (slot.pinned) cl_.ReleaseMemObject(slot.pinned);
+            if (slot.queue) cl_.ReleaseCommandQueue(slot.queue);
+        }
+        if (round_keys_) cl_.ReleaseMemObject(round_keys_);
+        if (sbox_) cl_.ReleaseMemObject(sbox_);
+        if (te0_) cl_.ReleaseMemObject(te0_);
+        if (aes_kernel_) cl_.ReleaseKernel(aes_kernel_);
+        if (chacha_kernel_) cl_.ReleaseKernel(chacha_kernel_);
+        if (program_) cl_.ReleaseProgram(program_);
+        if (context_) cl_.ReleaseContext(context_);
+    }
+
+    Library library_;
+    OpenClApi cl_{};
+    std::string name_;
+    std::mutex mutex_;
+    cl_device_id device_ = nullptr;
+    cl_context context_ = nullptr;
+    cl_program program_ = nullptr;
+    cl_kernel aes_kernel_ = nullptr;
+    cl_kernel chacha_kernel_ = nullptr;
+    cl_mem te0_ = nullptr;
+    cl_mem sbox_ = nullptr;
+    cl_mem round_keys_ = nullptr;       // AES round keys or the ChaCha20 key
+    std::array<Slot, SLOTS> slots_{};
+};
+
+} // anonymous namespace
+
+std::unique_ptr<IKeystreamDevice> open_opencl_device(std::string& detail) {
+    auto device = std::make_unique<OpenClDevice>();
+    if (!device->open(detail)) {
+        return nullptr;
+    }
+    return device;
+}
+
+} // namespace core
+} // namespace filevault
@@ -0,0 +1,69 @@
+/**
+ * @file random.cpp
+ * @brief Thread-local RNG service and counter nonces
+ */
+
+#include "filevault/core/random.hpp"
+#include <botan/auto_rng.h>
+#include <stdexcept>
+
+namespace filevault {
+namespace core {
+
+Botan::RandomNumberGenerator& RandomService::rng() {
+    thread_local Botan::AutoSeeded_RNG generator;
+    return generator;
+}
+
+void RandomService::fill(std::span<uint8_t> output) {
+    rng().randomize(output.data(), output.size());
+}
+
+std::vector<uint8_t> RandomService::bytes(size_t length) {
+    std::vector<uint8_t> output(length);
+    fill(output);
+    return output;
+}
+
+CounterNonce::CounterNonce(size_t nonce_size) {
+    if (nonce_size < sizeof(uint64_t)) {
+        throw std::invalid_argument("Counter nonce must be at least 8 bytes");
+    }
+    prefix_ = RandomService::bytes(nonce_size - sizeof(uint64_t));
+    
+    uint64_t start = 0;
+    RandomService::fill(std::span<uint8_t>(reinterpret_cast<uint8_t*>(&start), sizeof(start)));
+    counter_.store(start, std::memory_order_relaxed);
+}
+
+void CounterNonce::write_nonce(std::span<uint8_t> output, std::span<const uint8_t> prefix, uint64_t counter) {
+    std::copy(prefix.begin(), prefix.end(), output.begin());
+    for (size_t i = 0; i < sizeof(uint64_t); ++i) {
+        output[prefix.size() + i] = static_cast<uint8_t>(counter >> (56 - 8 * i));
+    }
+}
+
+void CounterNonce::next(std::span<uint8_t> output) {
+    next_n(output, 1);
+}
+
+std::vector<uint8_t> CounterNonce::next() {
+    std::vector<uint8_t> nonce(nonce_size());
+    next(nonce);
+    return nonce;
+}
+
+void CounterNonce::next_n(std::span<uint8_t> output, size_t count) {
+    if (output.size() != count * nonce_size()) {
+        throw std::invalid_argument("Nonce buffer size mismatch");
+    }
+    
+    // One atomic add reserves the whole range
+    uint64_t first = counter_.fetch_add(count, std::memory_order_relaxed);
+    for (size_t i = 0; i < count; ++i) {
+        write_nonce(output.subspan(i * nonce_size(), nonce_size()), prefix_, first + i);
+    }
+}
+
+} // namespace core
+} // namespace filevault
@@ -0,0 +1,158 @@
+/**
+ * @file secure_arena.cpp
+ * @brief Locked, size-classed memory for key material
+ */
+
+#include "filevault/core/secure_arena.hpp"
+#include <botan/mem_ops.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace filevault {
+namespace core {
+
+SecureArena& SecureArena::shared() {
+    static SecureArena arena;
+    return arena;
+}
+
+SecureArena::SecureArena(size_t capacity) {
+#ifdef _WIN32
+    void* region = VirtualAlloc(nullptr, capacity, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (region) {
+        locked_ = VirtualLock(region, capacity) != 0;
+    }
+#else
+    void* region = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        region = nullptr;
+    }
+    if (region) {
+        locked_ = mlock(region, capacity) == 0;
+#ifdef MADV_DONTDUMP
+        madvise(region, capacity, MADV_DONTDUMP);
+#endif
+#ifdef MADV_WIPEONFORK
+        madvise(region, capacity, MADV_WIPEONFORK);
+#endif
+    }
+#endif
+    if (region) {
+        region_ = static_cast<uint8_t*>(region);
+        capacity_ = capacity;
+    }
+    if (!locked_) {
+        spdlog::debug("Secure arena: could not lock {} KB, keys may be swapped out", capacity / 1024);
+    }
+}
+
+SecureArena::~SecureArena() {
+    if (!region_) {
+        return;
+    }
+    Botan::secure_scrub_memory(region_, capacity_);
+#ifdef _WIN32
+    if (locked_) {
+        VirtualUnlock(region_, capacity_);
+    }
+    VirtualFree(region_, 0, MEM_RELEASE);
+#else
+    if (locked_) {
+        munlock(region_, capacity_);
+    }
+    munmap(region_, capacity_);
+#endif
+}
+
+size_t SecureArena::class_index(size_t size) {
+    size_t index = 0;
+    size_t block = MIN_CLASS;
+    while (block < size) {
+        block *= 2;
+        ++index;
+    }
+    return index;
+}
+
+void* SecureArena::allocate(size_t size) {
+    if (size == 0) {
+        size = 1;
+    }
+    if (size <= MAX_CLASS && region_) {
+        size_t index = class_index(size);
+        size_t block = MIN_CLASS << index;
+        std::lock_guard<std::mutex> lock(mutex_);
+        void* data = nullptr;
+        if (free_[index]) {
+            data = free_[index];
+            std::memcpy(&free_[index], data, sizeof(void*));
+            std::memset(data, 0, sizeof(void*));
+        } else if (used_ + block <= capacity_) {
+            data = region_ + used_;
+            used_ += block;
+        }
+        if (data) {
+            in_use_ += block;
+            peak_ = (std::max)(peak_, in_use_);
+            return data;
+        }
+    }
+
+    // Too large, or the region is full
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++fallbacks_;
+    }
+    void* data = ::operator new(size);
+    std::memset(data, 0, size);
+    return data;
+}
+
+void SecureArena::deallocate(void* data, size_t size) noexcept {
+    if (!data) {
+        return;
+    }
+    if (size == 0) {
+        size = 1;
+    }
+    if (!owns(data)) {
+        Botan::secure_scrub_memory(data, size);
+        ::operator delete(data);
+        return;
+    }
+    size_t index = class_index(size);
+    size_t block = MIN_CLASS << index;
+    // Zeroed outside the lock; the block is still ours until it is linked
+    Botan::secure_scrub_memory(data, block);
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::memcpy(data, &free_[index], sizeof(void*));
+    free_[index] = data;
+    in_use_ -= block;
+}
+
+bool SecureArena::owns(const void* data) const {
+    auto* p = static_cast<const uint8_t*>(data);
+    return region_ && p >= region_ && p < region_ + capacity_;
+}
+
+SecureArenaStats SecureArena::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SecureArenaStats stats;
+    stats.capacity = capacity_;
+    stats.in_use = in_use_;
+    stats.peak = peak_;
+    stats.fallbacks = fallbacks_;
+    stats.locked = locked_;
+    return stats;
+}
+
+} // namespace core
+} // namespace filevault
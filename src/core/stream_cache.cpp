@@ -0,0 +1,157 @@
+/**
+ * @file stream_cache.cpp
+ * @brief LRU chunk cache and readahead over StreamReader
+ */
+
+#include "filevault/core/stream_cache.hpp"
+#include "filevault/core/thread_pool.hpp"
+#include <algorithm>
+
+namespace filevault {
+namespace core {
+
+CachedStreamReader::CachedStreamReader(StreamReader& reader, size_t cache_chunks, size_t readahead_chunks)
+    : reader_(reader),
+      size_(reader.size()),
+      chunk_size_(reader.chunk_size()),
+      capacity_(std::max<size_t>(1, cache_chunks)),
+      readahead_(std::min(readahead_chunks, capacity_ / 2)) {
+    chunk_count_ = chunk_size_ == 0 ? 0 : static_cast<size_t>((size_ + chunk_size_ - 1) / chunk_size_);
+    if (readahead_ > 0) {
+        prefetcher_ = std::make_unique<ThreadPool>(1);
+    }
+}
+
+CachedStreamReader::~CachedStreamReader() {
+    // Queued prefetches return at once; the pool then joins
+    stopping_ = true;
+    prefetcher_.reset();
+}
+
+StreamCacheStats CachedStreamReader::stats() const {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    return stats_;
+}
+
+CachedStreamReader::Chunk CachedStreamReader::find(size_t index) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    auto found = index_.find(index);
+    if (found == index_.end()) {
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, found->second);
+    return found->second->second;
+}
+
+void CachedStreamReader::insert(size_t index, Chunk chunk) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    if (index_.count(index)) {
+        return;
+    }
+    while (lru_.size() >= capacity_) {
+        index_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+    lru_.emplace_front(index, std::move(chunk));
+    index_[index] = lru_.begin();
+}
+
+CachedStreamReader::Chunk CachedStreamReader::load(size_t index, std::string& error) {
+    if (auto chunk = find(index)) {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        ++stats_.hits;
+        return chunk;
+    }
+
+    // A prefetch of this chunk may be running: once it has the reader
+    // released, the chunk is usually cached
+    std::lock_guard<std::mutex> reader_lock(reader_mutex_);
+    if (auto chunk = find(index)) {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        ++stats_.hits;
+        return chunk;
+    }
+    auto plain = std::make_shared<std::vector<uint8_t>>();
+    auto result = reader_.read(static_cast<uint64_t>(index) * chunk_size_, chunk_size_, *plain);
+    if (!result.success) {
+        error = result.error_message;
+        return nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        ++stats_.misses;
+    }
+    insert(index, plain);
+    return plain;
+}
+
+void CachedStreamReader::prefetch(size_t first, size_t last) {
+    for (size_t index = first; index <= last && index < chunk_count_; ++index) {
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex_);
+            if (index_.count(index) || !queued_.insert(index).second) {
+                continue;
+            }
+        }
+        prefetcher_->submit([this, index] {
+            std::lock_guard<std::mutex> reader_lock(reader_mutex_);
+            bool wanted = !stopping_ && !find(index);
+            if (wanted) {
+                auto plain = std::make_shared<std::vector<uint8_t>>();
+                if (reader_.read(static_cast<uint64_t>(index) * chunk_size_, chunk_size_, *plain).success) {
+                    insert(index, plain);
+                    std::lock_guard<std::mutex> lock(cache_mutex_);
+                    ++stats_.prefetched;
+                }
+            }
+            std::lock_guard<std::mutex> lock(cache_mutex_);
+            queued_.erase(index);
+        });
+    }
+}
+
+std::string CachedStreamReader::read(uint64_t offset, size_t length, std::vector<uint8_t>& output) {
+    output.clear();
+    if (offset > size_) {
+        return "Offset beyond end of file";
+    }
+    length = static_cast<size_t>(std::min<uint64_t>(length, size_ - offset));
+    if (length == 0) {
+        return {};
+    }
+
+    size_t first_chunk = static_cast<size_t>(offset / chunk_size_);
+    size_t last_chunk = static_cast<size_t>((offset + length - 1) / chunk_size_);
+    bool sequential;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        sequential = first_chunk == next_sequential_ || first_chunk + 1 == next_sequential_;
+        next_sequential_ = last_chunk + 1;
+    }
+    if (sequential && readahead_ > 0) {
+        prefetch(last_chunk + 1, last_chunk + readahead_);
+    }
+
+    output.reserve(length);
+    for (size_t i = first_chunk; i <= last_chunk; ++i) {
+        std::string error;
+        auto chunk = load(i, error);
+        if (!chunk) {
+            output.clear();
+            return error;
+        }
+        uint64_t chunk_start = static_cast<uint64_t>(i) * chunk_size_;
+        uint64_t copy_from = std::max(offset, chunk_start);
+        uint64_t copy_to = std::min<uint64_t>(offset + length, chunk_start + chunk->size());
+        if (copy_from >= copy_to) {
+            output.clear();
+            return "Truncated chunk " + std::to_string(i);
+        }
+        output.insert(output.end(), chunk->begin() + static_cast<std::ptrdiff_t>(copy_from - chunk_start),
+                      chunk->begin() + static_cast<std::ptrdiff_t>(copy_to - chunk_start));
+    }
+    return {};
+}
+
+} // namespace core
+} // namespace filevault
@@ -4,60 +4,826 @@
  */
 
 #include "filevault/core/streaming.hpp"
+#include "filevault/core/algorithm_traits.hpp"
 #include "filevault/core/crypto_engine.hpp"
+#include "filevault/core/file_format.hpp"
+#include "filevault/core/header_codec.hpp"
+#include "filevault/core/executor.hpp"
+#include "filevault/core/thread_pool.hpp"
+#include "filevault/core/bounded_queue.hpp"
+#include "filevault/core/buffer_pool.hpp"
+#include "filevault/core/checkout_cache.hpp"
+#include "filevault/core/checkpoint.hpp"
+#include "filevault/core/memory_budget.hpp"
+#include "filevault/core/random.hpp"
+#include "filevault/core/system_resources.hpp"
+#include "filevault/compression/adaptive_level.hpp"
 #include "filevault/compression/compressor.hpp"
+#include "filevault/utils/io_backend.hpp"
+#include "filevault/utils/throttle.hpp"
+#include "filevault/utils/trace.hpp"
 #include <botan/auto_rng.h>
 #include <spdlog/spdlog.h>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <cstring>
-
-#ifdef _WIN32
-#include <windows.h>
-#elif defined(__APPLE__)
-#include <unistd.h>
-#include <sys/types.h>
-#include <sys/sysctl.h>
-#include <mach/mach.h>
-#else
-// Linux
-#include <unistd.h>
-#include <sys/sysinfo.h>
-#endif
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
 
 namespace filevault {
 namespace core {
 
-// Magic bytes for streaming format: "FVST" (FileVault STreaming)
+// Magic bytes of the older streaming format: "FVST" (FileVault STreaming)
 static constexpr uint8_t STREAM_MAGIC[4] = {'F', 'V', 'S', 'T'};
-static constexpr uint8_t STREAM_VERSION = 1;
+static constexpr uint8_t STREAM_VERSION = 2;
 
-size_t StreamingCrypto::get_recommended_chunk_size() {
-    size_t available_memory = 0;
+// Version 1 streams have no per-chunk compressed flag
+static constexpr uint8_t STREAM_VERSION_NO_FRAME_FLAGS = 1;
+
+// FVAULT02 files: version 2 frames behind an authenticated header
+static constexpr uint8_t STREAM_VERSION_AUTHENTICATED = 3;
+
+// FVAULT02 files with 64-bit frame size prefixes and chunk count
+static constexpr uint8_t STREAM_VERSION_WIDE = 4;
+
+// FVAULT02 header: 16 fixed bytes (magic, IDs, level, flags, reserved),
+// then chunk size, total size and chunk count (4 or 8 bytes), then salt
+// and nonce (and a wrapped data key and a source fingerprint) with their
+// lengths, then the header tag
+static constexpr size_t V2_HEADER_FIXED_SIZE = 16 + 8 + 8 + 4;
+static constexpr size_t V2_HEADER_FIXED_SIZE_WIDE = V2_HEADER_FIXED_SIZE + 4;
+static constexpr size_t V2_HEADER_MAX_SIZE = V2_HEADER_FIXED_SIZE_WIDE + 4 * (1 + 255);
+static constexpr size_t V2_FLAGS_OFFSET = 12;
+static constexpr size_t V2_GENERATION_OFFSET = 13;
+
+// FVAULT02 header flags: the file key is random, wrapped under the
+// password key; frames and the chunk count are 64-bit; a fingerprint of
+// the source follows the wrapped key. Other bits are refused, so a reader
+// never misparses a layout it does not know.
+static constexpr uint8_t HEADER_FLAG_WRAPPED_KEY = 0x01;
+static constexpr uint8_t HEADER_FLAG_WIDE_FRAMES = 0x02;
+static constexpr uint8_t HEADER_FLAG_FINGERPRINT = 0x04;
+static constexpr uint8_t HEADER_FLAGS_KNOWN = HEADER_FLAG_WRAPPED_KEY | HEADER_FLAG_WIDE_FRAMES |
+                                              HEADER_FLAG_FINGERPRINT;
+
+// FVST header before the salt: magic, version, IDs, sizes and chunk count
+static constexpr size_t V1_HEADER_FIXED_SIZE = 4 + 1 + 3 + 8 + 8 + 4;
+
+// Top bit of a frame's size prefix: the chunk is compressed. On an empty
+// frame the flag marks a zero extent: a chunk that lies in a hole of the
+// input and decrypts to zeros. Its tag covers the empty ciphertext.
+static constexpr uint32_t FRAME_COMPRESSED = 0x80000000u;
+static constexpr uint32_t FRAME_SIZE_MASK = 0x7FFFFFFFu;
+
+// The same flag and mask in the 8-byte prefixes of wide frames
+static constexpr uint64_t WIDE_FRAME_COMPRESSED = uint64_t(1) << 63;
+static constexpr uint64_t WIDE_FRAME_SIZE_MASK = WIDE_FRAME_COMPRESSED - 1;
+
+// Tag size of the AEAD ciphers used for streaming (GCM / Poly1305)
+static constexpr size_t AEAD_TAG_SIZE = 16;
+
+// Trailer of the frame index footer: [8 bytes index offset]["FVIX"]
+static constexpr uint8_t INDEX_MAGIC[4] = {'F', 'V', 'I', 'X'};
+static constexpr size_t INDEX_TRAILER_SIZE = 12;
+
+// Header size/count values of a stream whose length was unknown up front
+static constexpr uint64_t STREAM_SIZE_UNKNOWN = UINT64_MAX;
+static constexpr uint32_t STREAM_CHUNKS_UNKNOWN = UINT32_MAX;
+static constexpr uint64_t WIDE_STREAM_CHUNKS_UNKNOWN = UINT64_MAX;
+
+// Frame size prefix that marks the end-of-stream trailer of such streams:
+// [4 or 8 bytes marker][16 bytes encrypted (total size, chunk count)][16 bytes tag]
+static constexpr uint32_t TRAILER_MARKER = UINT32_MAX;
+static constexpr uint64_t WIDE_TRAILER_MARKER = UINT64_MAX;
+static constexpr size_t TRAILER_PAYLOAD_SIZE = 16;
+
+// Per-chunk debug lines are sampled; one line per chunk floods the log
+// and costs more than the chunk on fast ciphers (power of two)
+static constexpr size_t CHUNK_LOG_INTERVAL = 256;
+
+// Plaintext fed to the compressor per step of a fused compress + encrypt
+// (and ciphertext per step of decrypt + decompress): small enough that
+// what one step produces is still in L2 when the next stage reads it
+static constexpr size_t FUSED_SLICE_SIZE = 128 * 1024;
+
+namespace {
+
+using StageClock = std::chrono::steady_clock;
+
+/**
+ * @brief Times the password of a FVAULT02 file was changed (0 for other formats)
+ */
+uint16_t header_generation(const std::vector<uint8_t>& header_bytes) {
+    if (header_bytes.size() < V2_HEADER_FIXED_SIZE ||
+        std::memcmp(header_bytes.data(), FILE_FORMAT_MAGIC_V2, 8) != 0) {
+        return 0;
+    }
+    return static_cast<uint16_t>(header_bytes[V2_GENERATION_OFFSET] |
+                                 header_bytes[V2_GENERATION_OFFSET + 1] << 8);
+}
+
+/**
+ * @brief A frame's size prefix, decoded
+ */
+struct FramePrefix {
+    uint64_t size = 0;              // Ciphertext bytes, tag excluded
+    bool compressed = false;
+    bool zero_extent = false;
+    bool trailer = false;           // End-of-stream trailer marker, not a frame
+};
+
+bool is_authenticated_version(uint8_t version) {
+    return version == STREAM_VERSION_AUTHENTICATED || version == STREAM_VERSION_WIDE;
+}
+
+size_t frame_prefix_size(uint8_t version) {
+    return version == STREAM_VERSION_WIDE ? 8 : 4;
+}
+
+/**
+ * @brief Read and decode one size prefix (in a single read, so gcount() tells a clean EOF)
+ */
+bool read_frame_prefix(std::istream& in, uint8_t version, FramePrefix& prefix) {
+    bool flagged = false;
+    if (version == STREAM_VERSION_WIDE) {
+        uint64_t raw = 0;
+        in.read(reinterpret_cast<char*>(&raw), 8);
+        prefix.trailer = raw == WIDE_TRAILER_MARKER;
+        flagged = (raw & WIDE_FRAME_COMPRESSED) != 0;
+        prefix.size = raw & WIDE_FRAME_SIZE_MASK;
+    } else {
+        uint32_t raw = 0;
+        in.read(reinterpret_cast<char*>(&raw), 4);
+        prefix.trailer = raw == TRAILER_MARKER;
+        flagged = version != STREAM_VERSION_NO_FRAME_FLAGS && (raw & FRAME_COMPRESSED) != 0;
+        prefix.size = raw & FRAME_SIZE_MASK;
+    }
+    prefix.zero_extent = flagged && prefix.size == 0;
+    prefix.compressed = flagged && !prefix.zero_extent;
+    return static_cast<bool>(in);
+}
+
+void write_frame_prefix(std::ostream& out, uint8_t version, uint64_t size, bool compressed, bool zero_extent) {
+    bool flagged = compressed || zero_extent;
+    if (version == STREAM_VERSION_WIDE) {
+        uint64_t raw = (zero_extent ? 0 : size) | (flagged ? WIDE_FRAME_COMPRESSED : 0);
+        out.write(reinterpret_cast<const char*>(&raw), 8);
+    } else {
+        uint32_t raw = (zero_extent ? 0 : static_cast<uint32_t>(size)) | (flagged ? FRAME_COMPRESSED : 0);
+        out.write(reinterpret_cast<const char*>(&raw), 4);
+    }
+}
+
+double ms_since(StageClock::time_point start) {
+    return std::chrono::duration<double, std::milli>(StageClock::now() - start).count();
+}
+
+/**
+ * @brief Output of one chunk's compress + encrypt step
+ */
+struct SealedChunk {
+    bool success = false;
+    std::string error_message;
+    std::vector<uint8_t> data;
+    std::optional<ShortBytes> tag;
+    bool compressed = false;
+    bool zero_extent = false;   // Chunk in a hole: empty ciphertext, tag only
+    bool skipped = false;       // Predicted incompressible, compressor not run
+    int level = 0;              // Compression level, if compressed
+    double compress_ms = 0.0;
+    double cipher_ms = 0.0;
+};
+
+/**
+ * @brief Output of one chunk's decrypt + decompress step
+ */
+struct OpenedChunk {
+    bool success = false;
+    std::string error_message;
+    std::vector<uint8_t> data;
+    size_t zero_size = 0;       // Zero-extent frame: plaintext bytes (data stays empty)
+    double compress_ms = 0.0;
+    double cipher_ms = 0.0;
+};
+
+/**
+ * @brief Plaintext size of chunk index in a stream of known length
+ */
+size_t chunk_plain_size(size_t index, size_t chunk_size, uint64_t original_size) {
+    uint64_t chunk_start = static_cast<uint64_t>(index) * chunk_size;
+    return static_cast<size_t>((std::min)(static_cast<uint64_t>(chunk_size), original_size - chunk_start));
+}
+
+/**
+ * @brief Associated data binding a chunk's frame flags to its tag
+ */
+std::vector<uint8_t> frame_associated_data(bool compressed, bool zero_extent = false) {
+    return {static_cast<uint8_t>(zero_extent ? 2 : compressed ? 1 : 0)};
+}
+
+/**
+ * @brief Write the plaintext of a zero-extent frame
+ *
+ * A file output gets a hole, a NullOutput only the count; other
+ * streams (pipes) get the zeros.
+ * Failures set the stream's error state.
+ */
+void write_zero_extent(std::ostream& output, uint64_t length) {
+    if (auto* file = dynamic_cast<utils::OutputFile*>(&output)) {
+        file->write_zeros(length);
+        return;
+    }
+    if (auto* sink = dynamic_cast<utils::NullOutput*>(&output)) {
+        sink->write_zeros(length);
+        return;
+    }
+    static const std::vector<char> zeros(64 * 1024);
+    while (length > 0 && output) {
+        size_t piece = static_cast<size_t>((std::min)(static_cast<uint64_t>(zeros.size()), length));
+        output.write(zeros.data(), static_cast<std::streamsize>(piece));
+        length -= piece;
+    }
+}
+
+/**
+ * @brief Decompress a version 1 chunk whose plaintext size is known
+ *
+ * Chunks that did not shrink are stored raw, so a frame of exactly the
+ * plaintext size needs no decompression; the rest are decompressed once
+ * into an exact-size buffer. A failed result means "use the data as is".
+ */
+compression::CompressionResult expand_chunk(
+    compression::ICompressor& decompressor,
+    std::span<const uint8_t> data,
+    size_t plain_size)
+{
+    if (data.size() == plain_size) {
+        return {};
+    }
+    return decompressor.decompress(data, plain_size);
+}
+
+/**
+ * @brief Replace an opened chunk with its plaintext
+ * @param decompressor nullptr for streams written without compression
+ * @param plain_size Plaintext size, if the stream length is known
+ * @return false (with error) if a flagged chunk cannot be decompressed
+ *
+ * Version 2 frames say whether they were compressed. Version 1 frames do
+ * not, so the old rules apply: a frame of exactly the plaintext size is
+ * raw, and a failed decompression means the chunk was stored as is.
+ */
+bool expand_opened_chunk(
+    compression::ICompressor* decompressor,
+    std::vector<uint8_t>& data,
+    uint8_t version,
+    bool compressed,
+    std::optional<size_t> plain_size,
+    std::string& error)
+{
+    compression::CompressionResult decomp_result;
+    if (version == STREAM_VERSION_NO_FRAME_FLAGS) {
+        if (!decompressor) {
+            return true;
+        }
+        decomp_result = plain_size
+            ? expand_chunk(*decompressor, data, *plain_size)
+            : decompressor->decompress(data);
+        if (!decomp_result.success) {
+            return true;
+        }
+    } else {
+        if (!compressed) {
+            return true;
+        }
+        if (!decompressor) {
+            error = "compressed chunk in a stream without compression";
+            return false;
+        }
+        decomp_result = plain_size
+            ? decompressor->decompress(data, *plain_size)
+            : decompressor->decompress(data);
+        if (!decomp_result.success) {
+            error = "decompression failed: " + decomp_result.error_message;
+            return false;
+        }
+    }
+    BufferPool::shared().release(std::move(data));
+    data = std::move(decomp_result.data);
+    return true;
+}
+
+/**
+ * @brief Compress a chunk and encrypt the compressed bytes as they are produced
+ * @param config Chunk nonce and associated data (marked compressed)
+ * @param data Plaintext chunk; replaced by the ciphertext if it was compressed
+ * @param sealed Receives compressed, tag and stage times; error_message on failure
+ * @return false if the cipher failed; true with sealed.compressed false
+ *         when the chunk did not shrink and data is still the plaintext
+ *
+ * compress() followed by encrypt_in_place() writes the whole compressed
+ * chunk to memory and reads it back. Here the compressor is fed one slice
+ * at a time and whatever it has appended is encrypted straight away, while
+ * still in cache. Sessions that cannot encrypt piece by piece take the
+ * two-pass route, which produces the same frame.
+ */
+bool compress_and_seal(
+    compression::ICompressor& compressor,
+    int level,
+    ICipherSession& session,
+    const EncryptionConfig& config,
+    std::vector<uint8_t>& data,
+    SealedChunk& sealed)
+{
+    auto& buffers = BufferPool::shared();
+    
+    if (!session.encrypt_begin(config)) {
+        auto compress_start = StageClock::now();
+        auto comp_result = compressor.compress(data, level);
+        sealed.compress_ms += ms_since(compress_start);
+        if (!comp_result.success || comp_result.data.size() >= data.size()) {
+            buffers.release(std::move(comp_result.data));
+            return true;
+        }
+        auto cipher_start = StageClock::now();
+        auto enc_result = session.encrypt_in_place(comp_result.data, config);
+        sealed.cipher_ms += ms_since(cipher_start);
+        if (!enc_result.success) {
+            buffers.release(std::move(comp_result.data));
+            sealed.error_message = enc_result.error_message;
+            return false;
+        }
+        buffers.release(std::move(data));
+        data = std::move(comp_result.data);
+        sealed.tag = std::move(enc_result.tag);
+        sealed.compressed = true;
+        return true;
+    }
+    
+    // Sessions left mid-message here are restarted by their next begin
+    auto compress_start = StageClock::now();
+    if (!compressor.begin(compression::StreamMode::COMPRESS, level, data.size())) {
+        sealed.compress_ms += ms_since(compress_start);
+        return true;
+    }
+    sealed.compress_ms += ms_since(compress_start);
+    
+    size_t granularity = session.encrypt_granularity();
+    std::vector<uint8_t> output = buffers.acquire(data.size());
+    size_t encrypted = 0;
+    
+    // Encrypts the whole granules the compressor has appended so far
+    auto seal_ready = [&]() {
+        size_t ready = (output.size() - encrypted) / granularity * granularity;
+        if (ready == 0) {
+            return true;
+        }
+        auto cipher_start = StageClock::now();
+        size_t produced = session.encrypt_update(std::span<uint8_t>(output).subspan(encrypted, ready));
+        sealed.cipher_ms += ms_since(cipher_start);
+        encrypted += ready;
+        return produced == ready;
+    };
+    
+    bool shrinks = true;
+    for (size_t offset = 0; offset < data.size() && shrinks; offset += FUSED_SLICE_SIZE) {
+        auto slice = std::span<const uint8_t>(data).subspan(offset, std::min(FUSED_SLICE_SIZE, data.size() - offset));
+        compress_start = StageClock::now();
+        shrinks = compressor.update(slice, output) && output.size() < data.size();
+        sealed.compress_ms += ms_since(compress_start);
+        if (shrinks && !seal_ready()) {
+            sealed.error_message = "Cipher did not encrypt a whole piece";
+            buffers.release(std::move(output));
+            return false;
+        }
+    }
+    if (shrinks) {
+        compress_start = StageClock::now();
+        shrinks = compressor.finish(output) && output.size() < data.size();
+        sealed.compress_ms += ms_since(compress_start);
+    }
+    if (!shrinks) {
+        buffers.release(std::move(output));
+        return true;
+    }
+    if (!seal_ready()) {
+        sealed.error_message = "Cipher did not encrypt a whole piece";
+        buffers.release(std::move(output));
+        return false;
+    }
+    
+    // The last partial granule goes through encrypt_finish() for the tag
+    auto cipher_start = StageClock::now();
+    std::vector<uint8_t> tail(output.begin() + static_cast<std::ptrdiff_t>(encrypted), output.end());
+    auto enc_result = session.encrypt_finish(tail);
+    sealed.cipher_ms += ms_since(cipher_start);
+    if (!enc_result.success) {
+        sealed.error_message = enc_result.error_message;
+        buffers.release(std::move(output));
+        return false;
+    }
+    std::copy(tail.begin(), tail.end(), output.begin() + static_cast<std::ptrdiff_t>(encrypted));
+    
+    buffers.release(std::move(data));
+    data = std::move(output);
+    sealed.tag = std::move(enc_result.tag);
+    sealed.compressed = true;
+    return true;
+}
+
+/**
+ * @brief Decrypt a compressed chunk and decompress each slice as it is decrypted
+ * @param config Chunk nonce, tag and associated data
+ * @param data Ciphertext of a compressed chunk; the plaintext chunk on success
+ * @param plain_size Plaintext size, if the stream length is known
+ * @param max_plain_size Bound on the plaintext when plain_size is not known
+ * @param opened Receives stage times; error_message on failure
+ * @return false on a bad tag or a chunk that does not decompress
+ *
+ * The reverse of compress_and_seal(). Output decompressed before the tag
+ * is checked stays in a buffer of its own and is dropped unless the tag
+ * checks out. If decompression fails or outgrows the chunk, the rest of
+ * the frame is only decrypted and the authenticated compressed chunk is
+ * expanded the two-pass way, so a damaged chunk reports the same error
+ * as without fusion and unauthenticated input cannot inflate without bound.
+ */
+bool open_and_expand(
+    ICipherSession& session,
+    compression::ICompressor& decompressor,
+    const EncryptionConfig& config,
+    uint8_t version,
+    std::vector<uint8_t>& data,
+    std::optional<size_t> plain_size,
+    size_t max_plain_size,
+    OpenedChunk& opened)
+{
+    auto& buffers = BufferPool::shared();
+    
+    if (!session.decrypt_begin(config)) {
+        auto cipher_start = StageClock::now();
+        auto dec_result = session.decrypt_in_place(data, config);
+        opened.cipher_ms += ms_since(cipher_start);
+        if (!dec_result.success) {
+            opened.error_message = dec_result.error_message;
+            return false;
+        }
+        auto compress_start = StageClock::now();
+        bool expanded = expand_opened_chunk(&decompressor, data, version, true, plain_size,
+                                            opened.error_message);
+        opened.compress_ms += ms_since(compress_start);
+        return expanded;
+    }
+    
+    size_t limit = plain_size.value_or(max_plain_size);
+    auto compress_start = StageClock::now();
+    bool expanding = decompressor.begin(compression::StreamMode::DECOMPRESS);
+    opened.compress_ms += ms_since(compress_start);
+    
+    size_t granularity = session.decrypt_granularity();
+    size_t step = std::max(granularity, FUSED_SLICE_SIZE / granularity * granularity);
+    std::vector<uint8_t> plain = buffers.acquire(limit);
+    
+    size_t offset = 0;
+    for (; data.size() - offset > step; offset += step) {
+        auto slice = std::span<uint8_t>(data).subspan(offset, step);
+        auto cipher_start = StageClock::now();
+        size_t produced = session.decrypt_update(slice);
+        opened.cipher_ms += ms_since(cipher_start);
+        if (produced != step) {
+            opened.error_message = "Cipher did not decrypt a whole piece";
+            buffers.release(std::move(plain));
+            buffers.release(std::move(data));
+            return false;
+        }
+        if (expanding) {
+            compress_start = StageClock::now();
+            expanding = decompressor.update(slice, plain) && plain.size() <= limit;
+            opened.compress_ms += ms_since(compress_start);
+        }
+    }
+    
+    // The rest, with the tag check, through decrypt_finish()
+    auto cipher_start = StageClock::now();
+    std::vector<uint8_t> tail(data.begin() + static_cast<std::ptrdiff_t>(offset), data.end());
+    auto dec_result = session.decrypt_finish(tail);
+    opened.cipher_ms += ms_since(cipher_start);
+    if (!dec_result.success) {
+        opened.error_message = dec_result.error_message;
+        buffers.release(std::move(plain));
+        buffers.release(std::move(data));
+        return false;
+    }
+    std::copy(tail.begin(), tail.end(), data.begin() + static_cast<std::ptrdiff_t>(offset));
+    
+    if (expanding) {
+        compress_start = StageClock::now();
+        expanding = decompressor.update(tail, plain) && decompressor.finish(plain) &&
+                    (plain_size ? plain.size() == *plain_size : plain.size() <= limit);
+        opened.compress_ms += ms_since(compress_start);
+    }
+    if (expanding) {
+        buffers.release(std::move(data));
+        data = std::move(plain);
+        return true;
+    }
+    buffers.release(std::move(plain));
+    
+    compress_start = StageClock::now();
+    bool expanded = expand_opened_chunk(&decompressor, data, version, true, plain_size, opened.error_message);
+    opened.compress_ms += ms_since(compress_start);
+    return expanded;
+}
+
+/**
+ * @brief Plaintext chunk read from the input file
+ */
+struct PlainChunk {
+    size_t index = 0;
+    std::vector<uint8_t> data;
+    size_t hole_size = 0;       // Chunk lies in a hole: its length, data is not read
+    bool ok = false;
+    double read_ms = 0.0;
+};
+
+/**
+ * @brief Encrypted chunk frame read from a streaming file
+ */
+struct EncryptedFrame {
+    size_t index = 0;
+    std::vector<uint8_t> encrypted;
+    ShortBytes tag;
+    bool compressed = false;
+    bool zero_extent = false;
+    uint64_t end_offset = 0;    // Input offset just past this frame
+    bool ok = false;
+    double read_ms = 0.0;
+};
+
+/**
+ * @brief Read-ahead stage for the streaming loops
+ *
+ * With depth > 0 the producer runs on a background thread and keeps up to
+ * depth items buffered, so disk reads overlap with crypto. With depth == 0
+ * the producer is called inline from next().
+ *
+ * The producer returns std::nullopt when the input is exhausted. The
+ * destructor closes the queue and joins, so early returns are safe.
+ */
+template<typename T>
+class ReadAhead {
+public:
+    ReadAhead(size_t depth, std::function<std::optional<T>()> produce)
+        : produce_(std::move(produce)), queue_(depth) {
+        if (depth > 0) {
+            thread_ = std::thread([this]() {
+                while (auto item = produce_()) {
+                    if (!queue_.push(std::move(*item))) {
+                        break;
+                    }
+                }
+                queue_.close();
+            });
+        }
+    }
+    
+    ~ReadAhead() {
+        queue_.close();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+    
+    ReadAhead(const ReadAhead&) = delete;
+    ReadAhead& operator=(const ReadAhead&) = delete;
+    
+    std::optional<T> next() {
+        return thread_.joinable() ? queue_.pop() : produce_();
+    }
+
+private:
+    std::function<std::optional<T>()> produce_;
+    BoundedQueue<T> queue_;
+    std::thread thread_;
+};
+
+// Candidate chunk sizes tried by adaptive sizing (64KB .. 64MB, x4 steps)
+static constexpr size_t ADAPTIVE_CHUNK_SIZES[] = {
+    64 * 1024, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024, 16 * 1024 * 1024, 64 * 1024 * 1024
+};
+
+/**
+ * @brief Pick the chunk size with the best measured throughput
+ *
+ * Each candidate processes the same sample from the start of the input
+ * (read, compress, encrypt) with a throwaway key, so per-chunk overheads
+ * and cache effects are included. The sample is 1/32 of the file, at
+ * least 256KB and at most 64MB, which keeps calibration to a few percent
+ * of the total work.
+ *
+ * @return Chosen chunk size, or fallback if fewer than two candidates fit
+ */
+size_t calibrate_chunk_size(
+    std::istream& input,
+    size_t file_size,
+    const StreamingConfig& config,
+    ICryptoAlgorithm* algo,
+    size_t key_size,
+    size_t max_chunk_size,
+    size_t fallback
+) {
+    size_t sample_size = std::clamp(file_size / 32, size_t(256 * 1024), size_t(64 * 1024 * 1024));
+    sample_size = (std::min)(sample_size, file_size);
+    
+    std::vector<size_t> candidates;
+    for (size_t size : ADAPTIVE_CHUNK_SIZES) {
+        if (size <= sample_size && size <= max_chunk_size) {
+            candidates.push_back(size);
+        }
+    }
+    if (candidates.size() < 2) {
+        return fallback;
+    }
+    
+    auto& buffers = BufferPool::shared();
+    auto key = CryptoEngine::generate_salt(key_size);
+    auto session = algo->create_session(key);
+    if (!session) {
+        return fallback;
+    }
+    
+    std::unique_ptr<compression::ICompressor> compressor;
+    if (config.compression != CompressionType::NONE) {
+        compressor = compression::CompressionService::create(config.compression);
+    }
+    
+    EncryptionConfig enc_config;
+    enc_config.algorithm = config.algorithm;
     
-#ifdef _WIN32
-    MEMORYSTATUSEX status;
-    status.dwLength = sizeof(status);
-    if (GlobalMemoryStatusEx(&status)) {
-        available_memory = static_cast<size_t>(status.ullAvailPhys);
+    size_t best_size = fallback;
+    double best_rate = 0.0;
+    
+    for (size_t candidate : candidates) {
+        auto start = std::chrono::steady_clock::now();
+        input.clear();
+        input.seekg(0);
+        
+        for (size_t done = 0; done < sample_size; done += candidate) {
+            size_t bytes = (std::min)(candidate, sample_size - done);
+            auto data = buffers.acquire(bytes + AEAD_TAG_SIZE);
+            data.resize(bytes);
+            input.read(reinterpret_cast<char*>(data.data()), bytes);
+            
+            if (compressor && !(config.skip_incompressible &&
+                                compression::CompressionService::likely_incompressible(data))) {
+                auto comp_result = compressor->compress(data, config.compression_level);
+                if (comp_result.success && comp_result.data.size() < data.size()) {
+                    buffers.release(std::move(data));
+                    data = std::move(comp_result.data);
+                } else {
+                    buffers.release(std::move(comp_result.data));
+                }
+            }
+            
+            enc_config.nonce = CryptoEngine::generate_nonce(algorithm_traits(config.algorithm).nonce_size);
+            session->encrypt_in_place(data, enc_config);
+            buffers.release(std::move(data), false);
+        }
+        
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double rate = sample_size / (std::max)(seconds, 1e-9);
+        SPDLOG_DEBUG("Adaptive chunk size {}: {:.2f} MB/s", candidate, rate / 1024.0 / 1024.0);
+        
+        // Larger chunks must win clearly; smaller ones give finer progress and locality
+        if (rate > best_rate * 1.05) {
+            best_rate = rate;
+            best_size = candidate;
+        }
     }
-#elif defined(__APPLE__)
-    // macOS: Use mach API to get free memory
-    mach_port_t host_port = mach_host_self();
-    vm_size_t page_size;
-    vm_statistics64_data_t vm_stats;
-    mach_msg_type_number_t count = sizeof(vm_stats) / sizeof(natural_t);
     
-    if (host_page_size(host_port, &page_size) == KERN_SUCCESS &&
-        host_statistics64(host_port, HOST_VM_INFO64, (host_info64_t)&vm_stats, &count) == KERN_SUCCESS) {
-        available_memory = static_cast<size_t>(vm_stats.free_count) * page_size;
+    input.clear();
+    input.seekg(0);
+    return best_size;
+}
+
+/**
+ * @brief Walk count frames from data_start, folding their tags into a digest
+ * @param offsets Receives the frame offsets if not null
+ * @return Offset just past the last frame, or std::nullopt if truncated
+ *
+ * Only size prefixes and tags are read, so checking the committed prefix
+ * of a multi-terabyte file costs a seek per chunk.
+ */
+std::optional<uint64_t> walk_frames(
+    std::istream& file,
+    uint64_t data_start,
+    uint64_t count,
+    uint8_t version,
+    Checkpoint& digest,
+    std::vector<uint64_t>* offsets)
+{
+    uint64_t pos = data_start;
+    uint8_t tag[AEAD_TAG_SIZE];
+    size_t prefix_size = frame_prefix_size(version);
+    for (uint64_t i = 0; i < count; ++i) {
+        FramePrefix prefix;
+        file.seekg(static_cast<std::streamoff>(pos));
+        if (!read_frame_prefix(file, version, prefix) || prefix.trailer) {
+            return std::nullopt;
+        }
+        file.seekg(static_cast<std::streamoff>(pos + prefix_size + prefix.size));
+        file.read(reinterpret_cast<char*>(tag), AEAD_TAG_SIZE);
+        if (!file) {
+            return std::nullopt;
+        }
+        digest.add_tag(tag);
+        if (offsets) {
+            offsets->push_back(pos);
+        }
+        pos += prefix_size + prefix.size + AEAD_TAG_SIZE;
+    }
+    return pos;
+}
+
+/**
+ * @brief Where the frames of a sharded file lie
+ *
+ * Sharded files are uncompressed and have no zero extents, so every
+ * frame but the last holds exactly one chunk.
+ */
+struct ShardLayout {
+    uint64_t data_start = 0;        // First frame, right after the header
+    size_t chunk_size = 0;
+    size_t chunk_count = 0;
+    uint64_t original_size = 0;
+    uint8_t version = 0;
+
+    uint64_t frame_size(size_t index) const {
+        return frame_prefix_size(version) + chunk_plain_size(index, chunk_size, original_size) + AEAD_TAG_SIZE;
+    }
+    uint64_t frame_offset(size_t index) const {
+        return data_start + static_cast<uint64_t>(index) * frame_size(0);
+    }
+    uint64_t data_end() const {
+        return chunk_count == 0 ? data_start : frame_offset(chunk_count - 1) + frame_size(chunk_count - 1);
     }
-#else
-    // Linux
-    struct sysinfo info;
-    if (sysinfo(&info) == 0) {
-        available_memory = info.freeram * info.mem_unit;
+    uint64_t file_size() const {
+        return data_end() + static_cast<uint64_t>(chunk_count) * 8 + INDEX_TRAILER_SIZE;
+    }
+    size_t first_chunk(size_t rank, size_t ranks) const {
+        // chunk_count * rank / ranks without overflowing
+        return chunk_count / ranks * rank + chunk_count % ranks * rank / ranks;
+    }
+};
+
+} // anonymous namespace
+
+struct StreamingCrypto::ResumeState {
+    std::string output_path;
+    std::string sidecar_path;
+    size_t interval = 0;            // Chunks between checkpoints
+    size_t since_save = 0;
+    Checkpoint checkpoint;          // Committed progress, advanced by the writer
+    bool resuming = false;          // Continue after checkpoint.chunks_committed
+    bool append = false;            // Input starts at input_offset; header rewritten at the end
+    bool shard = false;             // One rank of a sharded file: no index, no sidecar
+    size_t end_chunk = 0;           // Shard: chunks from here on belong to later ranks
+    
+    // Header and frame offsets of the output being resumed (encryption)
+    std::vector<uint8_t> salt, base_nonce, header_bytes, header_tag, wrapped_key;
+    std::vector<uint64_t> frame_offsets;
+    
+    /**
+     * @brief Record a written chunk; every interval chunks, make it durable
+     * @return false if the output or the sidecar could not be synced
+     */
+    bool commit(std::ostream& output, std::span<const uint8_t> tag,
+                uint64_t input_offset, uint64_t output_offset, uint64_t bytes_committed) {
+        checkpoint.add_tag(tag);
+        checkpoint.chunks_committed++;
+        checkpoint.input_offset = input_offset;
+        checkpoint.output_offset = output_offset;
+        checkpoint.bytes_committed = bytes_committed;
+        if (interval == 0 || ++since_save < interval) {
+            return true;
+        }
+        since_save = 0;
+        
+        // The sidecar may only describe bytes that are already on disk
+        output.flush();
+        return output && sync_file(output_path) && checkpoint.save(sidecar_path);
     }
-#endif
+};
+
+size_t StreamingCrypto::get_recommended_chunk_size() {
+    // Within the container's memory limit, not the host's free RAM
+    size_t available_memory = static_cast<size_t>(SystemResources::available_memory());
     
     // Use 1/4 of available memory, capped between 16MB and 256MB
     size_t chunk_size = available_memory / 4;
@@ -74,420 +840,2639 @@ bool StreamingCrypto::should_use_streaming(const std::string& file_path, size_t
     std::ifstream file(file_path, std::ios::binary | std::ios::ate);
     if (!file) return false;
     
-    auto size = file.tellg();
-    return static_cast<size_t>(size) > threshold;
+    auto size = file.tellg();
+    return static_cast<size_t>(size) > threshold;
+}
+
+bool StreamingCrypto::is_streaming_file(const std::string& file_path) {
+    std::ifstream file(file_path, std::ios::binary);
+    uint8_t magic[8] = {};
+    file.read(reinterpret_cast<char*>(magic), 8);
+    return file && (std::memcmp(magic, FILE_FORMAT_MAGIC_V2, 8) == 0 ||
+                    std::memcmp(magic, STREAM_MAGIC, 4) == 0);
+}
+
+bool StreamingCrypto::supports_algorithm(AlgorithmType algorithm) {
+    return static_cast<size_t>(algorithm) < ALGORITHM_COUNT && algorithm_traits(algorithm).streaming;
+}
+
+ShortBytes StreamingCrypto::derive_chunk_nonce(
+    const std::vector<uint8_t>& base_nonce,
+    size_t chunk_index
+) {
+    ShortBytes chunk_nonce = base_nonce;
+    
+    // Ensure nonce is at least 12 bytes
+    if (chunk_nonce.size() < 12) {
+        chunk_nonce.resize(12, 0);
+    }
+    
+    // XOR the low 32 bits of the index into bytes 8-11 and the high 32
+    // bits into bytes 0-3. Below 2^32 chunks this is the original layout;
+    // bytes 4-7, which the trailer and header nonces vary, stay untouched.
+    uint64_t index = chunk_index;
+    for (int i = 0; i < 4; ++i) {
+        chunk_nonce[8 + i] ^= static_cast<uint8_t>((index >> (i * 8)) & 0xFF);
+        chunk_nonce[i] ^= static_cast<uint8_t>((index >> (32 + i * 8)) & 0xFF);
+    }
+    
+    return chunk_nonce;
+}
+
+ShortBytes StreamingCrypto::derive_trailer_nonce(
+    const std::vector<uint8_t>& base_nonce
+) {
+    // Chunk nonces only vary bytes 0-3 and 8-11, so flipping byte 7 cannot collide
+    ShortBytes trailer_nonce = base_nonce;
+    if (trailer_nonce.size() < 12) {
+        trailer_nonce.resize(12, 0);
+    }
+    trailer_nonce[7] ^= 0x01;
+    return trailer_nonce;
+}
+
+ShortBytes StreamingCrypto::derive_header_nonce(
+    const std::vector<uint8_t>& base_nonce,
+    uint16_t generation
+) {
+    // Distinct from the trailer nonce (bit 0 of byte 7) and all chunk nonces.
+    // Each rekey tags a new header under the same file key, so the key
+    // generation goes into bytes 5-6: a nonce is never used twice.
+    ShortBytes header_nonce = base_nonce;
+    if (header_nonce.size() < 12) {
+        header_nonce.resize(12, 0);
+    }
+    header_nonce[7] ^= 0x02;
+    header_nonce[6] ^= static_cast<uint8_t>(generation & 0xFF);
+    header_nonce[5] ^= static_cast<uint8_t>(generation >> 8);
+    return header_nonce;
+}
+
+ShortBytes StreamingCrypto::derive_wrap_nonce(
+    const std::vector<uint8_t>& base_nonce
+) {
+    // Under the password key, not the file key; distinct all the same
+    ShortBytes wrap_nonce = base_nonce;
+    if (wrap_nonce.size() < 12) {
+        wrap_nonce.resize(12, 0);
+    }
+    wrap_nonce[7] ^= 0x04;
+    return wrap_nonce;
+}
+
+std::vector<uint8_t> StreamingCrypto::wrap_data_key(
+    ICryptoAlgorithm& algo,
+    std::span<const uint8_t> password_key,
+    const EncryptionConfig& enc_config,
+    const std::vector<uint8_t>& base_nonce,
+    std::span<const uint8_t> data_key
+) {
+    EncryptionConfig wrap_config = enc_config;
+    wrap_config.nonce = derive_wrap_nonce(base_nonce);
+    auto sealed = algo.encrypt(data_key, password_key, wrap_config);
+    if (!sealed.success || !sealed.tag.has_value() || sealed.tag->size() != AEAD_TAG_SIZE) {
+        spdlog::error("Failed to wrap the data key: {}", sealed.error_message);
+        return {};
+    }
+    auto wrapped = std::move(sealed.data);
+    wrapped.insert(wrapped.end(), sealed.tag->begin(), sealed.tag->end());
+    return wrapped;
+}
+
+bool StreamingCrypto::unwrap_data_key(
+    ICryptoAlgorithm& algo,
+    std::span<const uint8_t> password_key,
+    const EncryptionConfig& enc_config,
+    const std::vector<uint8_t>& base_nonce,
+    const std::vector<uint8_t>& wrapped_key,
+    std::vector<uint8_t>& data_key
+) {
+    if (wrapped_key.size() != algo.key_size() + AEAD_TAG_SIZE) {
+        return false;
+    }
+    EncryptionConfig wrap_config = enc_config;
+    wrap_config.nonce = derive_wrap_nonce(base_nonce);
+    wrap_config.tag = ShortBytes(wrapped_key.end() - AEAD_TAG_SIZE, wrapped_key.end());
+    auto opened = algo.decrypt(std::span<const uint8_t>(wrapped_key).first(algo.key_size()),
+                               password_key, wrap_config);
+    if (!opened.success) {
+        return false;
+    }
+    data_key = std::move(opened.data);
+    return true;
+}
+
+bool StreamingCrypto::write_stream_header(
+    std::ostream& file,
+    const StreamingConfig& config,
+    const std::vector<uint8_t>& salt,
+    const std::vector<uint8_t>& base_nonce,
+    size_t total_size,
+    size_t chunk_count,
+    ICryptoAlgorithm& algo,
+    std::span<const uint8_t> key,
+    const EncryptionConfig& enc_config,
+    std::span<const uint8_t> wrapped_key,
+    uint16_t generation
+) {
+    if (salt.size() > 255 || base_nonce.size() > 255 || wrapped_key.size() > 255 ||
+        config.fingerprint.size() > 255) {
+        return false;
+    }
+    
+    HeaderWriter<V2_HEADER_MAX_SIZE + AEAD_TAG_SIZE> header;
+    
+    // Magic, then algorithm, KDF, compression and security level (1 byte each)
+    header.bytes(FILE_FORMAT_MAGIC_V2);
+    header.u8(static_cast<uint8_t>(config.algorithm));
+    header.u8(static_cast<uint8_t>(config.kdf));
+    header.u8(static_cast<uint8_t>(config.compression));
+    header.u8(static_cast<uint8_t>(config.level));
+    header.u8((wrapped_key.empty() ? 0 : HEADER_FLAG_WRAPPED_KEY) |
+              (config.wide_frames ? HEADER_FLAG_WIDE_FRAMES : 0) |
+              (config.fingerprint.empty() ? 0 : HEADER_FLAG_FINGERPRINT));
+    header.u16(generation);
+    header.zeros(1);    // Reserved
+    
+    // Chunk size (8 bytes), total size (8 bytes), chunk count (4 bytes, 8 if wide)
+    header.u64(config.chunk_size);
+    header.u64(total_size == SIZE_MAX ? STREAM_SIZE_UNKNOWN : total_size);
+    if (config.wide_frames) {
+        header.u64(chunk_count == SIZE_MAX ? WIDE_STREAM_CHUNKS_UNKNOWN : chunk_count);
+    } else if (chunk_count != SIZE_MAX && chunk_count >= STREAM_CHUNKS_UNKNOWN) {
+        return false;
+    } else {
+        header.u32(chunk_count == SIZE_MAX ? STREAM_CHUNKS_UNKNOWN : static_cast<uint32_t>(chunk_count));
+    }
+    
+    // Salt and base nonce, each after a 1-byte length
+    header.u8(static_cast<uint8_t>(salt.size()));
+    header.bytes(salt);
+    header.u8(static_cast<uint8_t>(base_nonce.size()));
+    header.bytes(base_nonce);
+    if (!wrapped_key.empty()) {
+        header.u8(static_cast<uint8_t>(wrapped_key.size()));
+        header.bytes(wrapped_key);
+    }
+    if (!config.fingerprint.empty()) {
+        header.u8(static_cast<uint8_t>(config.fingerprint.size()));
+        header.bytes(config.fingerprint);
+    }
+    
+    // Header tag: AEAD over an empty message with the header as associated data
+    EncryptionConfig header_config = enc_config;
+    header_config.nonce = derive_header_nonce(base_nonce, generation);
+    header_config.associated_data = std::vector<uint8_t>(header.data().begin(), header.data().end());
+    auto sealed = algo.encrypt({}, key, header_config);
+    if (!sealed.success || !sealed.tag.has_value() || sealed.tag->size() != AEAD_TAG_SIZE) {
+        spdlog::error("Failed to authenticate stream header: {}", sealed.error_message);
+        return false;
+    }
+    header.bytes(*sealed.tag);
+    
+    return header.write_to(file);
+}
+
+bool StreamingCrypto::read_stream_header(
+    std::istream& file,
+    StreamingConfig& config,
+    std::vector<uint8_t>& salt,
+    std::vector<uint8_t>& base_nonce,
+    size_t& original_size,
+    size_t& chunk_count,
+    uint8_t& version,
+    std::vector<uint8_t>& header_bytes,
+    std::vector<uint8_t>& header_tag,
+    std::vector<uint8_t>& wrapped_key
+) {
+    header_bytes.clear();
+    header_tag.clear();
+    wrapped_key.clear();
+    config.fingerprint.clear();
+    
+    // The header is read into a stack buffer in a few reads (fixed fields,
+    // salt, nonce, optional fields), then parsed in place
+    uint8_t buffer[V2_HEADER_MAX_SIZE];
+    size_t filled = 0;
+    auto fill = [&](size_t count) {
+        file.read(reinterpret_cast<char*>(buffer + filled), static_cast<std::streamsize>(count));
+        filled += static_cast<size_t>(file.gcount());
+        return static_cast<bool>(file);
+    };
+    
+    // Magic bytes: "FVAULT02", or "FVST" and a version byte
+    if (!fill(8)) {
+        spdlog::error("Invalid streaming file format");
+        return false;
+    }
+    size_t fixed_size = 0;
+    if (std::memcmp(buffer, FILE_FORMAT_MAGIC_V2, 8) == 0) {
+        // The flags pick the layout of the rest of the header and the frames
+        if (!fill(V2_FLAGS_OFFSET + 1 - filled)) {
+            spdlog::error("Truncated stream header");
+            return false;
+        }
+        uint8_t flags = buffer[V2_FLAGS_OFFSET];
+        if (flags & ~HEADER_FLAGS_KNOWN) {
+            spdlog::error("Unsupported stream header flags 0x{:02x} (written by a newer version?)", flags);
+            return false;
+        }
+        bool wide = (flags & HEADER_FLAG_WIDE_FRAMES) != 0;
+        version = wide ? STREAM_VERSION_WIDE : STREAM_VERSION_AUTHENTICATED;
+        fixed_size = wide ? V2_HEADER_FIXED_SIZE_WIDE : V2_HEADER_FIXED_SIZE;
+    } else if (std::memcmp(buffer, STREAM_MAGIC, 4) == 0) {
+        version = buffer[4];
+        if (version != STREAM_VERSION && version != STREAM_VERSION_NO_FRAME_FLAGS) {
+            spdlog::error("Unsupported streaming format version: {}", version);
+            return false;
+        }
+        fixed_size = V1_HEADER_FIXED_SIZE;
+    } else {
+        spdlog::error("Invalid streaming file format");
+        return false;
+    }
+    
+    // Fixed fields and the salt length, then the salt and nonce length, then the nonce
+    if (!fill(fixed_size + 1 - filled) || !fill(buffer[filled - 1] + size_t(1)) ||
+        !fill(buffer[filled - 1])) {
+        spdlog::error("Truncated stream header");
+        return false;
+    }
+    uint8_t flags = is_authenticated_version(version) ? buffer[V2_FLAGS_OFFSET] : 0;
+    bool wrapped = (flags & HEADER_FLAG_WRAPPED_KEY) != 0;
+    bool fingerprinted = (flags & HEADER_FLAG_FINGERPRINT) != 0;
+    if ((wrapped && (!fill(1) || !fill(buffer[filled - 1]))) ||
+        (fingerprinted && (!fill(1) || !fill(buffer[filled - 1])))) {
+        spdlog::error("Truncated stream header");
+        return false;
+    }
+    
+    try {
+        HeaderReader in(std::span<const uint8_t>(buffer, filled));
+        in.skip(is_authenticated_version(version) ? 8 : 5, "magic");
+        
+        // Algorithm, KDF and compression type (1 byte each)
+        config.algorithm = static_cast<AlgorithmType>(in.u8("algorithm"));
+        config.kdf = static_cast<KDFType>(in.u8("KDF"));
+        config.compression = static_cast<CompressionType>(in.u8("compression"));
+        
+        // FVAULT02: security level of the KDF, then flags and reserved bytes
+        if (is_authenticated_version(version)) {
+            uint8_t level = in.u8("security level");
+            if (level > static_cast<uint8_t>(SecurityLevel::PARANOID)) {
+                spdlog::error("Invalid security level in stream header");
+                return false;
+            }
+            config.level = static_cast<SecurityLevel>(level);
+            in.skip(4, "flags, key generation and reserved byte");
+        }
+        
+        // Chunk size, total size and chunk count
+        config.chunk_size = static_cast<size_t>(in.u64("chunk size"));
+        uint64_t total_sz = in.u64("total size");
+        original_size = total_sz == STREAM_SIZE_UNKNOWN ? SIZE_MAX : static_cast<size_t>(total_sz);
+        if (version == STREAM_VERSION_WIDE) {
+            uint64_t chunks = in.u64("chunk count");
+            chunk_count = chunks == WIDE_STREAM_CHUNKS_UNKNOWN ? SIZE_MAX : static_cast<size_t>(chunks);
+        } else {
+            uint32_t chunks = in.u32("chunk count");
+            chunk_count = chunks == STREAM_CHUNKS_UNKNOWN ? SIZE_MAX : chunks;
+        }
+        
+        // Salt and base nonce
+        auto salt_view = in.bytes(in.u8("salt length"), "salt");
+        salt.assign(salt_view.begin(), salt_view.end());
+        auto nonce_view = in.bytes(in.u8("nonce length"), "nonce");
+        base_nonce.assign(nonce_view.begin(), nonce_view.end());
+        if (wrapped) {
+            auto wrapped_view = in.bytes(in.u8("wrapped key length"), "wrapped key");
+            wrapped_key.assign(wrapped_view.begin(), wrapped_view.end());
+        }
+        if (fingerprinted) {
+            auto fingerprint_view = in.bytes(in.u8("fingerprint length"), "fingerprint");
+            config.fingerprint.assign(fingerprint_view.begin(), fingerprint_view.end());
+        }
+    } catch (const std::runtime_error& e) {
+        spdlog::error("Invalid stream header: {}", e.what());
+        return false;
+    }
+    
+    // Header tag (not part of the authenticated bytes)
+    header_bytes.assign(buffer, buffer + filled);
+    if (is_authenticated_version(version)) {
+        header_tag.resize(AEAD_TAG_SIZE);
+        file.read(reinterpret_cast<char*>(header_tag.data()), AEAD_TAG_SIZE);
+    }
+    
+    return file.good();
+}
+
+bool StreamingCrypto::verify_stream_header(
+    ICryptoAlgorithm& algo,
+    std::span<const uint8_t> key,
+    const EncryptionConfig& enc_config,
+    const std::vector<uint8_t>& base_nonce,
+    const std::vector<uint8_t>& header_bytes,
+    const std::vector<uint8_t>& header_tag
+) {
+    if (header_tag.empty()) {
+        return true;
+    }
+    
+    EncryptionConfig header_config = enc_config;
+    header_config.nonce = derive_header_nonce(base_nonce, header_generation(header_bytes));
+    header_config.associated_data = header_bytes;
+    header_config.tag = header_tag;
+    return algo.decrypt({}, key, header_config).success;
+}
+
+std::optional<StreamInfo> StreamingCrypto::read_info(const std::string& file_path) {
+    std::ifstream file(file_path, std::ios::binary);
+    if (!file) {
+        return std::nullopt;
+    }
+    
+    StreamingConfig config;
+    std::vector<uint8_t> salt, base_nonce, header_bytes, header_tag, wrapped_key;
+    size_t original_size = 0, chunk_count = 0;
+    uint8_t version = 0;
+    if (!read_stream_header(file, config, salt, base_nonce, original_size, chunk_count,
+                            version, header_bytes, header_tag, wrapped_key)) {
+        return std::nullopt;
+    }
+    
+    StreamInfo info;
+    info.version = version;
+    info.algorithm = config.algorithm;
+    info.kdf = config.kdf;
+    info.level = config.level;
+    info.compression = config.compression;
+    info.chunk_size = config.chunk_size;
+    if (original_size != SIZE_MAX) {
+        info.original_size = original_size;
+        info.chunk_count = chunk_count;
+    }
+    info.salt_size = salt.size();
+    info.salt = std::move(salt);
+    info.nonce_size = base_nonce.size();
+    info.header_size = header_bytes.size() + header_tag.size();
+    info.authenticated_header = !header_tag.empty();
+    info.wrapped_key = !wrapped_key.empty();
+    info.key_generation = header_generation(header_bytes);
+    info.wide_frames = version == STREAM_VERSION_WIDE;
+    info.fingerprint = std::move(config.fingerprint);
+    return info;
+}
+
+std::optional<FrameLocation> StreamingCrypto::locate_frame(const std::string& file_path, size_t chunk) {
+    auto info = read_info(file_path);
+    if (!info || (info->chunk_count && chunk >= *info->chunk_count)) {
+        return std::nullopt;
+    }
+    std::ifstream file(file_path, std::ios::binary);
+    if (!file) {
+        return std::nullopt;
+    }
+    file.seekg(0, std::ios::end);
+    uint64_t file_size = static_cast<uint64_t>(file.tellg());
+    
+    // One entry of the footer, when it is present and consistent
+    std::optional<uint64_t> offset;
+    if (info->chunk_count) {
+        uint64_t index_size = static_cast<uint64_t>(*info->chunk_count) * 8 + INDEX_TRAILER_SIZE;
+        if (file_size >= info->header_size + index_size) {
+            uint64_t index_offset = 0;
+            uint8_t magic[4] = {};
+            file.seekg(static_cast<std::streamoff>(file_size - INDEX_TRAILER_SIZE));
+            file.read(reinterpret_cast<char*>(&index_offset), 8);
+            file.read(reinterpret_cast<char*>(magic), 4);
+            if (file && std::memcmp(magic, INDEX_MAGIC, 4) == 0 && index_offset + index_size == file_size) {
+                uint64_t entry = 0;
+                file.seekg(static_cast<std::streamoff>(index_offset + chunk * 8));
+                file.read(reinterpret_cast<char*>(&entry), 8);
+                if (file) {
+                    offset = entry;
+                }
+            }
+        }
+        file.clear();
+    }
+    
+    // No footer: walk the size prefixes; unknown-length streams end at the trailer
+    FramePrefix prefix;
+    size_t prefix_size = frame_prefix_size(info->version);
+    uint64_t pos = offset.value_or(info->header_size);
+    for (size_t i = offset ? chunk : 0;; ++i) {
+        file.seekg(static_cast<std::streamoff>(pos));
+        if (!read_frame_prefix(file, info->version, prefix) || prefix.trailer) {
+            return std::nullopt;
+        }
+        if (i == chunk) {
+            break;
+        }
+        pos += prefix_size + prefix.size + AEAD_TAG_SIZE;
+    }
+    
+    FrameLocation location;
+    location.offset = pos;
+    location.size = prefix_size + prefix.size + AEAD_TAG_SIZE;
+    location.zero_extent = prefix.zero_extent;
+    location.compressed = prefix.compressed;
+    if (location.offset + location.size > file_size) {
+        return std::nullopt;
+    }
+    return location;
+}
+
+bool StreamingCrypto::write_frame_index(
+    std::ostream& file,
+    const std::vector<uint64_t>& frame_offsets,
+    uint64_t index_offset
+) {
+    // Frame offsets (8 bytes each)
+    for (uint64_t offset : frame_offsets) {
+        file.write(reinterpret_cast<const char*>(&offset), 8);
+    }
+    
+    // Trailer: index offset (8 bytes) and magic (4 bytes)
+    file.write(reinterpret_cast<const char*>(&index_offset), 8);
+    file.write(reinterpret_cast<const char*>(INDEX_MAGIC), 4);
+    
+    return file.good();
+}
+
+bool StreamingCrypto::read_frame_index(
+    std::istream& file,
+    uint64_t data_start,
+    size_t chunk_count,
+    size_t last_chunk,
+    uint8_t version,
+    std::vector<uint64_t>& frame_offsets
+) {
+    frame_offsets.clear();
+    
+    file.seekg(0, std::ios::end);
+    uint64_t file_size = static_cast<uint64_t>(file.tellg());
+    uint64_t index_size = static_cast<uint64_t>(chunk_count) * 8 + INDEX_TRAILER_SIZE;
+    
+    // Use the footer when it is present and consistent with the header
+    if (file_size >= data_start + index_size) {
+        uint64_t index_offset = 0;
+        uint8_t magic[4] = {};
+        file.seekg(static_cast<std::streamoff>(file_size - INDEX_TRAILER_SIZE));
+        file.read(reinterpret_cast<char*>(&index_offset), 8);
+        file.read(reinterpret_cast<char*>(magic), 4);
+        
+        if (file && std::memcmp(magic, INDEX_MAGIC, 4) == 0 &&
+            index_offset + index_size == file_size) {
+            frame_offsets.resize(chunk_count);
+            file.seekg(static_cast<std::streamoff>(index_offset));
+            file.read(reinterpret_cast<char*>(frame_offsets.data()), chunk_count * 8);
+            if (file) {
+                return true;
+            }
+        }
+        file.clear();
+        frame_offsets.clear();
+    }
+    
+    // No footer: walk the length prefixes up to the last chunk needed.
+    // Offsets are not authenticated either way; a wrong offset yields a
+    // frame that fails the per-chunk tag check.
+    uint64_t pos = data_start;
+    for (size_t i = 0; i <= last_chunk; ++i) {
+        FramePrefix prefix;
+        file.seekg(static_cast<std::streamoff>(pos));
+        if (!read_frame_prefix(file, version, prefix)) {
+            return false;
+        }
+        frame_offsets.push_back(pos);
+        pos += frame_prefix_size(version) + prefix.size + AEAD_TAG_SIZE;
+    }
+    
+    return true;
+}
+
+StreamingResult StreamingCrypto::encrypt_file(
+    const std::string& input_path,
+    const std::string& output_path,
+    const std::string& password,
+    const StreamingConfig& config
+) {
+    StreamingResult result;
+    
+    // Open input file (reads ahead through the configured I/O backend)
+    utils::InputFileOptions input_options;
+    input_options.direct = config.bypass_cache;
+    utils::InputFile input(input_path, input_options);
+    if (!input.is_open()) {
+        result.error_message = "Failed to open input file: " + input_path;
+        return result;
+    }
+    
+    size_t file_size = static_cast<size_t>(input.size());
+    
+    spdlog::info("Streaming encryption: {} ({} bytes)", input_path, file_size);
+    
+    // Chunks inside holes of a sparse input are recorded, not read
+    auto extents = utils::data_extents(input_path);
+    uint64_t allocated = file_size;
+    if (extents) {
+        allocated = 0;
+        for (const auto& extent : *extents) {
+            allocated += extent.length;
+        }
+        if (allocated < file_size) {
+            spdlog::info("Sparse input: {} of {} bytes hold data", allocated, file_size);
+        }
+    }
+    const auto* holes = extents && allocated < file_size ? &*extents : nullptr;
+    
+    utils::OutputFileOptions output_options;
+    output_options.bypass_cache = config.bypass_cache;
+    
+    if (config.checkpoint.interval == 0 && !config.checkpoint.resume) {
+        // Temp file renamed into place once complete; sized for the input's
+        // data plus a length, tag and index entry per frame (what
+        // compression saves is released again)
+        output_options.atomic = true;
+        output_options.preallocate = allocated + 4096 +
+            (file_size / (std::max)(config.chunk_size, size_t(1)) + 1) * (4 + AEAD_TAG_SIZE + sizeof(uint64_t));
+        utils::OutputFile output(output_path, output_options);
+        if (!output) {
+            result.error_message = "Failed to create output file: " + output_path;
+            return result;
+        }
+        
+        result = encrypt_impl(input, output, password, {}, config, file_size, nullptr, holes);
+        result.bytes_written = output ? static_cast<uint64_t>(output.tellp()) : 0;
+        if (result.success && !output.commit(config.commit_group)) {
+            result.success = false;
+            result.error_message = "Failed to write output file: " + output_path;
+        }
+        return result;
+    }
+    
+    ResumeState resume;
+    resume.output_path = output_path;
+    resume.sidecar_path = Checkpoint::path_for(output_path);
+    resume.interval = config.checkpoint.interval;
+    resume.checkpoint.operation = Checkpoint::Operation::ENCRYPT;
+    if (!resume.checkpoint.stamp_input(input_path)) {
+        result.error_message = "Failed to stat input file: " + input_path;
+        return result;
+    }
+    
+    StreamingConfig job_config = config;
+    utils::OutputFile output;
+    if (config.checkpoint.resume) {
+        auto saved = Checkpoint::load(resume.sidecar_path);
+        if (!saved || saved->operation != Checkpoint::Operation::ENCRYPT) {
+            result.error_message = "No encryption checkpoint for " + output_path;
+            return result;
+        }
+        if (!saved->matches_input(input_path)) {
+            result.error_message = "Input changed since the checkpoint was written: " + input_path;
+            return result;
+        }
+        
+        // The committed frames must be exactly those the checkpoint describes
+        std::ifstream existing(output_path, std::ios::binary);
+        StreamingConfig header_config;
+        size_t original_size = 0, chunk_count = 0;
+        uint8_t version = 0;
+        Checkpoint walked;
+        bool consistent = existing &&
+            read_stream_header(existing, header_config, resume.salt, resume.base_nonce,
+                               original_size, chunk_count, version,
+                               resume.header_bytes, resume.header_tag, resume.wrapped_key) &&
+            is_authenticated_version(version) &&
+            original_size == file_size &&
+            header_config.chunk_size == saved->chunk_size &&
+            saved->chunks_committed <= chunk_count &&
+            saved->input_offset == (std::min)(saved->chunks_committed * saved->chunk_size,
+                                              static_cast<uint64_t>(file_size));
+        if (consistent) {
+            auto end = walk_frames(existing, static_cast<uint64_t>(existing.tellg()),
+                                   saved->chunks_committed, version, walked, &resume.frame_offsets);
+            consistent = end && *end == saved->output_offset && walked.tag_digest == saved->tag_digest;
+        }
+        if (!consistent) {
+            result.error_message = "Output does not match its checkpoint: " + output_path;
+            return result;
+        }
+        existing.close();
+        
+        // Settings come from the existing header, which encrypt_impl authenticates
+        job_config.algorithm = header_config.algorithm;
+        job_config.kdf = header_config.kdf;
+        job_config.level = header_config.level;
+        job_config.compression = header_config.compression;
+        job_config.chunk_size = header_config.chunk_size;
+        job_config.wide_frames = version == STREAM_VERSION_WIDE;
+        job_config.adaptive_chunk_size = false;
+        
+        // Drop whatever was written after the last checkpoint
+        std::error_code ec;
+        std::filesystem::resize_file(output_path, saved->output_offset, ec);
+        if (ec) {
+            result.error_message = "Failed to truncate output file: " + output_path;
+            return result;
+        }
+        output_options.truncate = false;
+        output.open(output_path, output_options);
+        output.seekp(static_cast<std::streamoff>(saved->output_offset));
+        
+        resume.checkpoint = *saved;
+        resume.resuming = true;
+        spdlog::info("Resuming after chunk {} of {}", saved->chunks_committed, chunk_count);
+    } else {
+        Checkpoint::remove(resume.sidecar_path);
+        output.open(output_path, output_options);
+    }
+    if (!output) {
+        result.error_message = "Failed to create output file: " + output_path;
+        return result;
+    }
+    
+    result = encrypt_impl(input, output, password, {}, job_config, file_size, &resume, holes);
+    result.bytes_written = output ? static_cast<uint64_t>(output.tellp()) : 0;
+    return result;
+}
+
+StreamingResult StreamingCrypto::encrypt_stream(
+    std::istream& input,
+    std::ostream& output,
+    const std::string& password,
+    const StreamingConfig& config
+) {
+    spdlog::info("Streaming encryption of input with unknown length");
+    return encrypt_impl(input, output, password, {}, config, std::nullopt);
+}
+
+StreamingResult StreamingCrypto::encrypt_stream(
+    std::istream& input,
+    std::ostream& output,
+    const std::string& password,
+    size_t input_size,
+    const StreamingConfig& config
+) {
+    spdlog::info("Streaming encryption of input ({} bytes)", input_size);
+    return encrypt_impl(input, output, password, {}, config, input_size);
+}
+
+StreamingResult StreamingCrypto::encrypt_stream_with_key(
+    std::istream& input,
+    std::ostream& output,
+    std::span<const uint8_t> data_key,
+    std::optional<size_t> input_size,
+    const StreamingConfig& config
+) {
+    StreamingResult result;
+    if (data_key.empty()) {
+        result.error_message = "Data key must not be empty";
+        return result;
+    }
+    return encrypt_impl(input, output, std::string(), data_key, config, input_size);
+}
+
+StreamingResult StreamingCrypto::encrypt_impl(
+    std::istream& input,
+    std::ostream& output,
+    const std::string& password,
+    std::span<const uint8_t> data_key,
+    const StreamingConfig& config,
+    std::optional<size_t> input_size,
+    ResumeState* resume,
+    const std::vector<utils::FileExtent>* extents
+) {
+    utils::ScopedSpan trace_span("StreamingCrypto::encrypt", "streaming", input_size.value_or(0));
+    StreamingResult result;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    bool resuming = resume && resume->resuming;
+    uint64_t resumed_bytes = resuming ? resume->checkpoint.bytes_committed : 0;
+    
+    try {
+        // Without a known size, chunks are framed until EOF and the stream
+        // ends with an authenticated trailer instead of the frame index
+        bool known_size = input_size.has_value();
+        size_t file_size = input_size.value_or(0);
+        
+        if (config.chunk_size == 0) {
+            result.error_message = "Chunk size must be non-zero";
+            return result;
+        }
+        
+        // Initialize crypto engine
+        CryptoEngine engine;
+        engine.initialize();
+        
+        // Generate salt and derive the password key; a supplied data key
+        // needs neither. A resumed job keeps the salt and nonce of the
+        // existing header.
+        std::vector<uint8_t> salt;
+        std::vector<uint8_t> key(data_key.begin(), data_key.end());
+        std::vector<uint8_t> password_key;
+        auto base_nonce = resuming ? resume->base_nonce
+                                   : CryptoEngine::generate_nonce(algorithm_traits(config.algorithm).nonce_size);
+        
+        EncryptionConfig enc_config;
+        enc_config.algorithm = config.algorithm;
+        enc_config.kdf = config.kdf;
+        enc_config.level = config.level;
+        enc_config.apply_security_level();
+        
+        if (key.empty()) {
+            if (resuming) {
+                salt = resume->salt;
+            } else {
+                salt = config.salt.empty() ? CryptoEngine::generate_salt(32) : config.salt;
+            }
+            auto kdf_start = StageClock::now();
+            password_key = engine.derive_key(password, salt, enc_config);
+            result.stages.kdf_ms = ms_since(kdf_start);
+        }
+        
+        // Get algorithm
+        auto* algo = engine.get_algorithm(config.algorithm);
+        if (!algo) {
+            result.error_message = "Algorithm not available";
+            return result;
+        }
+        if (!data_key.empty() && data_key.size() != algo->key_size()) {
+            result.error_message = "Data key size does not match " + algo->name();
+            return result;
+        }
+        
+        // Chunks are encrypted under a random file key that the password key
+        // wraps in the header, so rekey_file() can change the password
+        // without touching them. Interrupted files from before wrapping
+        // continue under the password key itself.
+        std::vector<uint8_t> wrapped_key;
+        if (!password_key.empty()) {
+            if (resuming && resume->wrapped_key.empty()) {
+                key = password_key;
+            } else if (resuming) {
+                wrapped_key = resume->wrapped_key;
+                if (!unwrap_data_key(*algo, password_key, enc_config, base_nonce, wrapped_key, key)) {
+                    result.error_message = "Header authentication failed (wrong password for the interrupted file)";
+                    return result;
+                }
+            } else {
+                key = RandomService::bytes(algo->key_size());
+                wrapped_key = wrap_data_key(*algo, password_key, enc_config, base_nonce, key);
+                if (wrapped_key.empty()) {
+                    result.error_message = "Failed to wrap the file key";
+                    return result;
+                }
+            }
+        }
+        
+        // Appending under another key would leave a file no password opens
+        if (resuming && !verify_stream_header(*algo, key, enc_config, base_nonce,
+                                              resume->header_bytes, resume->header_tag)) {
+            result.error_message = "Header authentication failed (wrong password for the interrupted file)";
+            return result;
+        }
+        
+        size_t worker_count = config.worker_threads == 0
+            ? ThreadPool::default_thread_count()
+            : config.worker_threads;
+        
+        // Under a memory limit, read-ahead, workers and then the chunk size
+        // shrink until the stream's buffers fit its share
+        auto& budget = MemoryBudget::shared();
+        auto shape = budget.fit_stream({config.chunk_size, worker_count, config.io_buffers}, resuming);
+        worker_count = shape.workers;
+        const size_t io_buffers = shape.io_buffers;
+        
+        // Choose the chunk size. The header records it, so decryption and
+        // range reads work the same for fixed and adaptive sizes.
+        size_t chunk_size = shape.chunk_size;
+        if (config.adaptive_chunk_size && known_size && !resuming) {
+            // Chunk buffers alive at once: in-flight workers plus read-ahead
+            size_t buffer_slots = worker_count + 2 + io_buffers;
+            size_t memory_cap = config.max_chunk_memory > 0
+                ? config.max_chunk_memory
+                : get_recommended_chunk_size() * buffer_slots;
+            memory_cap = static_cast<size_t>(budget.stream_bytes(memory_cap * 2) / 2);
+            size_t max_chunk_size = (std::max)(memory_cap / buffer_slots, size_t(1));
+            
+            chunk_size = calibrate_chunk_size(input, file_size, config, algo, key.size(),
+                                              max_chunk_size, (std::min)(chunk_size, max_chunk_size));
+            spdlog::info("Adaptive chunk size: {} bytes", chunk_size);
+        }
+        
+        size_t chunk_count = known_size ? (file_size + chunk_size - 1) / chunk_size : 0;
+        size_t end_chunk = resume && resume->shard ? (std::min)(resume->end_chunk, chunk_count) : chunk_count;
+        result.chunk_size = chunk_size;
+        
+        // 4-byte frame sizes and chunk count unless they would overflow
+        // (or the caller asked); readers before wide frames open the rest
+        bool wide = config.wide_frames || chunk_size >= FRAME_SIZE_MASK ||
+                    (known_size && chunk_count >= STREAM_CHUNKS_UNKNOWN);
+        uint8_t frame_version = wide ? STREAM_VERSION_WIDE : STREAM_VERSION_AUTHENTICATED;
+        
+        // Write header; a resumed job continues after its committed chunks
+        size_t first_chunk = 0;
+        if (resuming) {
+            first_chunk = static_cast<size_t>(resume->checkpoint.chunks_committed);
+            if (!resume->append) {
+                input.seekg(static_cast<std::streamoff>(resume->checkpoint.input_offset));
+            }
+            result.chunks_processed = result.chunks_resumed = first_chunk;
+        } else {
+            StreamingConfig header_config = config;
+            header_config.chunk_size = chunk_size;
+            header_config.wide_frames = wide;
+            if (!write_stream_header(output, header_config, salt, base_nonce,
+                                     known_size ? file_size : SIZE_MAX,
+                                     known_size ? chunk_count : SIZE_MAX,
+                                     *algo, key, enc_config, wrapped_key)) {
+                result.error_message = "Failed to write stream header";
+                return result;
+            }
+            if (resume) {
+                resume->checkpoint.chunk_size = chunk_size;
+            }
+        }
+        
+        // File offset of every frame, written as the footer for random access
+        std::vector<uint64_t> frame_offsets;
+        if (resuming) {
+            frame_offsets = std::move(resume->frame_offsets);
+        }
+        frame_offsets.reserve(chunk_count);
+        uint64_t write_pos = static_cast<uint64_t>(output.tellp());
+        
+        // Process chunks as a three-stage pipeline: a read-ahead thread fills
+        // chunk buffers, compression + encryption (independent per chunk thanks
+        // to the per-index nonce) runs on a worker pool, and this thread writes
+        // finished chunks in order.
+        std::atomic<bool> cancelled{false};
+        
+        // Chunk, compression and ciphertext buffers are recycled across chunks
+        auto& buffers = BufferPool::shared();
+        CheckoutCache<compression::ICompressor> compressors([&config]() {
+            return compression::CompressionService::create(config.compression);
+        });
+        
+        // Keyed cipher sessions, so the key schedule is built once per worker
+        CheckoutCache<ICipherSession> sessions([&]() { return algo->create_session(key); });
+        
+        // Set once the worker pool exists, before any chunk is submitted
+        std::optional<compression::AdaptiveLevel> adaptive_level;
+        
+        auto seal_chunk = [&](
+            size_t index, std::vector<uint8_t> data, bool hole
+        ) -> SealedChunk {
+            utils::ScopedSpan chunk_span("seal chunk", "streaming", data.size());
+            SealedChunk sealed;
+            if (cancelled.load(std::memory_order_relaxed)) {
+                return sealed;
+            }
+            sealed.zero_extent = hole;
+            
+            // Each task gets its own config copy carrying the chunk-specific
+            // nonce and the frame flags as associated data
+            EncryptionConfig chunk_config = enc_config;
+            chunk_config.nonce = derive_chunk_nonce(base_nonce, index);
+            
+            auto session = sessions.acquire();
+            if (!session) {
+                sealed.error_message = "Failed to create cipher session";
+                return sealed;
+            }
+            
+            // Compress if enabled, unless a sample says it would not shrink;
+            // a chunk that shrinks is encrypted as it is compressed
+            if (config.compression != CompressionType::NONE && !hole) {
+                if (config.skip_incompressible &&
+                    compression::CompressionService::likely_incompressible(data)) {
+                    sealed.skipped = true;
+                } else {
+                    chunk_config.associated_data = frame_associated_data(true);
+                    sealed.level = adaptive_level ? adaptive_level->level() : config.compression_level;
+                    auto compressor = compressors.acquire();
+                    bool ok = compress_and_seal(*compressor, sealed.level, *session,
+                                                chunk_config, data, sealed);
+                    compressors.release(std::move(compressor));
+                    if (!ok) {
+                        return sealed;
+                    }
+                }
+            }
+            if (!wide && data.size() >= FRAME_SIZE_MASK) {
+                sealed.error_message = "Chunk too large for a stream frame";
+                return sealed;
+            }
+            
+            // Otherwise encrypt in place: the read buffer becomes the ciphertext buffer
+            if (!sealed.compressed) {
+                chunk_config.associated_data = frame_associated_data(false, hole);
+                auto cipher_start = StageClock::now();
+                auto enc_result = session->encrypt_in_place(data, chunk_config);
+                sealed.cipher_ms = ms_since(cipher_start);
+                if (!enc_result.success) {
+                    sealed.error_message = enc_result.error_message;
+                    return sealed;
+                }
+                sealed.tag = std::move(enc_result.tag);
+            }
+            sessions.release(std::move(session));
+            
+            sealed.success = true;
+            sealed.data = std::move(data);
+            return sealed;
+        };
+        
+        // Declared after engine/key so in-flight tasks finish before those are destroyed.
+        // With async I/O, even a single worker moves crypto off the writer thread.
+        bool multi_chunk = !known_size || chunk_count > 1;
+        auto memory = budget.lease(MemoryBudget::stream_cost({chunk_size, worker_count, io_buffers},
+                                                             known_size ? (std::max)(chunk_count, size_t(1)) : 0));
+        std::unique_ptr<TaskGroup> pool;
+        if ((worker_count > 1 || io_buffers > 0) && multi_chunk) {
+            pool = std::make_unique<TaskGroup>(Executor::shared(), worker_count);
+        }
+        
+        // Bound the number of chunks held in memory at once
+        const size_t max_in_flight = pool ? pool->size() + 2 : 1;
+        
+        // Without the pool, compression runs on this thread and there is no queue to watch
+        if (config.adaptive_compression_level && config.compression != CompressionType::NONE && pool) {
+            adaptive_level.emplace(config.min_compression_level, config.max_compression_level,
+                                   config.compression_level);
+        }
+        
+        size_t next_read = first_chunk;
+        size_t bytes_read = static_cast<size_t>(resumed_bytes);
+        bool input_done = false;
+        
+        // Whether a chunk has no data extent; extents are sorted, so the
+        // scan resumes at the first one that may still reach a chunk
+        size_t next_extent = 0;
+        bool input_behind = false;  // Hole chunks were skipped without reading
+        auto in_hole = [&](uint64_t offset, uint64_t length) {
+            while (next_extent < extents->size() &&
+                   (*extents)[next_extent].offset + (*extents)[next_extent].length <= offset) {
+                ++next_extent;
+            }
+            return next_extent == extents->size() || (*extents)[next_extent].offset >= offset + length;
+        };
+        
+        ReadAhead<PlainChunk> reader(multi_chunk ? io_buffers : 0,
+            [&]() -> std::optional<PlainChunk> {
+                if (known_size ? next_read >= end_chunk : input_done) {
+                    return std::nullopt;
+                }
+                PlainChunk chunk;
+                size_t bytes_to_read = known_size
+                    ? (std::min)(chunk_size, file_size - bytes_read)
+                    : chunk_size;
+                if (known_size && extents && in_hole(bytes_read, bytes_to_read)) {
+                    chunk.index = next_read++;
+                    chunk.hole_size = bytes_to_read;
+                    chunk.ok = true;
+                    bytes_read += bytes_to_read;
+                    input_behind = true;
+                    return chunk;
+                }
+                if (input_behind) {
+                    input.seekg(static_cast<std::streamoff>(bytes_read));
+                    input_behind = false;
+                }
+                // Spare capacity for the AEAD tag keeps in-place encryption realloc-free
+                chunk.data = buffers.acquire(bytes_to_read + AEAD_TAG_SIZE);
+                chunk.data.resize(bytes_to_read);
+                utils::RateLimiter::reads().acquire(bytes_to_read);
+                auto read_start = StageClock::now();
+                utils::ScopedSpan read_span("read chunk", "io", bytes_to_read);
+                input.read(reinterpret_cast<char*>(chunk.data.data()), bytes_to_read);
+                chunk.read_ms = ms_since(read_start);
+                
+                if (known_size) {
+                    chunk.ok = input || input.eof();
+                } else {
+                    // A short read means EOF; an empty final read ends the stream
+                    size_t got = static_cast<size_t>(input.gcount());
+                    input_done = got < bytes_to_read;
+                    chunk.data.resize(got);
+                    chunk.ok = !input.bad();
+                    if (got == 0 && chunk.ok) {
+                        buffers.release(std::move(chunk.data));
+                        return std::nullopt;
+                    }
+                }
+                
+                chunk.index = next_read++;
+                bytes_read += chunk.data.size();
+                return chunk;
+            });
+        
+        struct PendingChunk {
+            size_t index;
+            size_t plain_size;
+            std::future<SealedChunk> sealed;
+        };
+        std::deque<PendingChunk> pending;
+        size_t bytes_processed = static_cast<size_t>(resumed_bytes);
+        
+        // Write the oldest pending chunk; returns false on failure or cancel
+        auto write_next = [&]() -> bool {
+            if (adaptive_level) {
+                size_t ready = 0;
+                for (const auto& waiting : pending) {
+                    ready += waiting.sealed.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                }
+                adaptive_level->observe(ready, pending.size());
+            }
+            
+            PendingChunk chunk = std::move(pending.front());
+            pending.pop_front();
+            
+            SealedChunk sealed = pool ? pool->wait(chunk.sealed) : chunk.sealed.get();
+            if (!sealed.success) {
+                result.error_message = "Encryption failed at chunk " + std::to_string(chunk.index);
+                if (!sealed.error_message.empty()) {
+                    result.error_message += ": " + sealed.error_message;
+                }
+                return false;
+            }
+            
+            result.stages.compress_ms += sealed.compress_ms;
+            result.stages.cipher_ms += sealed.cipher_ms;
+            
+            // Write encrypted chunk: [4 or 8 bytes size | flag][data][16 bytes tag]
+            utils::RateLimiter::writes().acquire(sealed.data.size());
+            auto write_start = StageClock::now();
+            {
+                utils::ScopedSpan write_span("write chunk", "io", sealed.data.size());
+                frame_offsets.push_back(write_pos);
+                write_frame_prefix(output, frame_version, sealed.data.size(), sealed.compressed,
+                                   sealed.zero_extent);
+                output.write(reinterpret_cast<const char*>(sealed.data.data()), sealed.data.size());
+                write_pos += frame_prefix_size(frame_version) + sealed.data.size();
+                
+                // Write tag if present
+                if (sealed.tag.has_value()) {
+                    output.write(reinterpret_cast<const char*>(sealed.tag.value().data()), 
+                                sealed.tag.value().size());
+                    write_pos += sealed.tag.value().size();
+                }
+            }
+            result.stages.write_ms += ms_since(write_start);
+            
+            // Ciphertext needs no scrubbing before reuse
+            buffers.release(std::move(sealed.data), false);
+            
+            if (!output) {
+                result.error_message = "Failed to write chunk " + std::to_string(chunk.index);
+                return false;
+            }
+            
+            bytes_processed += chunk.plain_size;
+            result.chunks_processed++;
+            result.chunks_compressed += sealed.compressed ? 1 : 0;
+            result.chunks_skipped += sealed.skipped ? 1 : 0;
+            result.chunks_sparse += sealed.zero_extent ? 1 : 0;
+            if (adaptive_level) {
+                result.frame_levels.push_back(sealed.compressed ? sealed.level : 0);
+            }
+            if ((result.chunks_processed & (CHUNK_LOG_INTERVAL - 1)) == 0) {
+                SPDLOG_DEBUG("Encrypted {} chunks, {} bytes", result.chunks_processed, bytes_processed);
+            }
+            
+            // Plaintext offset = bytes consumed, output offset = bytes written
+            if (resume && !resume->commit(output, sealed.tag.value_or(ShortBytes{}),
+                                          bytes_processed, write_pos, bytes_processed)) {
+                result.error_message = "Failed to write checkpoint after chunk " + std::to_string(chunk.index);
+                return false;
+            }
+            
+            // Progress callback
+            if (config.progress_callback) {
+                ChunkInfo info{chunk.index, chunk.plain_size, chunk_count, bytes_processed, file_size};
+                if (!config.progress_callback(info)) {
+                    result.error_message = "Operation cancelled by user";
+                    return false;
+                }
+            }
+            
+            return true;
+        };
+        
+        while (auto chunk = reader.next()) {
+            result.stages.read_ms += chunk->read_ms;
+            if (!chunk->ok) {
+                cancelled = true;
+                result.error_message = "Failed to read input chunk";
+                return result;
+            }
+            
+            size_t i = chunk->index;
+            bool hole = chunk->hole_size > 0;
+            size_t plain_size = hole ? chunk->hole_size : chunk->data.size();
+            
+            if (pool) {
+                pending.push_back({i, plain_size,
+                    pool->submit([&seal_chunk, i, data = std::move(chunk->data), hole]() mutable {
+                        return seal_chunk(i, std::move(data), hole);
+                    })});
+            } else {
+                std::promise<SealedChunk> ready;
+                ready.set_value(seal_chunk(i, std::move(chunk->data), hole));
+                pending.push_back({i, plain_size, ready.get_future()});
+            }
+            
+            while (pending.size() >= max_in_flight) {
+                if (!write_next()) {
+                    cancelled = true;
+                    return result;
+                }
+            }
+        }
+        
+        while (!pending.empty()) {
+            if (!write_next()) {
+                cancelled = true;
+                return result;
+            }
+        }
+        
+        if (resume && resume->shard) {
+            // stitch_shards() writes the index once every rank is done
+        } else if (known_size) {
+            if (!write_frame_index(output, frame_offsets, write_pos)) {
+                result.error_message = "Failed to write frame index";
+                return result;
+            }
+        } else {
+            // Authenticated end-of-stream trailer: detects truncation
+            uint8_t totals[TRAILER_PAYLOAD_SIZE];
+            uint64_t total_bytes = bytes_processed;
+            uint64_t total_chunks = result.chunks_processed;
+            std::memcpy(totals, &total_bytes, 8);
+            std::memcpy(totals + 8, &total_chunks, 8);
+            
+            EncryptionConfig trailer_config = enc_config;
+            trailer_config.nonce = derive_trailer_nonce(base_nonce);
+            auto sealed = algo->encrypt(totals, key, trailer_config);
+            if (!sealed.success || !sealed.tag.has_value()) {
+                result.error_message = "Failed to seal end-of-stream trailer";
+                return result;
+            }
+            
+            if (wide) {
+                uint64_t marker = WIDE_TRAILER_MARKER;
+                output.write(reinterpret_cast<const char*>(&marker), 8);
+            } else {
+                uint32_t marker = TRAILER_MARKER;
+                output.write(reinterpret_cast<const char*>(&marker), 4);
+            }
+            output.write(reinterpret_cast<const char*>(sealed.data.data()), sealed.data.size());
+            output.write(reinterpret_cast<const char*>(sealed.tag.value().data()), sealed.tag.value().size());
+        }
+        
+        auto flush_start = StageClock::now();
+        output.flush();
+        result.stages.write_ms += ms_since(flush_start);
+        if (!output) {
+            result.error_message = "Failed to write stream trailer";
+            return result;
+        }
+        
+        // An append is committed by the header: it still describes the file
+        // without the new chunks until they are on disk
+        if (resuming && resume->append) {
+            StreamingConfig header_config = config;
+            header_config.chunk_size = chunk_size;
+            header_config.wide_frames = wide;
+            output.seekp(0);
+            if (!sync_file(resume->output_path) ||
+                !write_stream_header(output, header_config, salt, base_nonce, file_size, chunk_count,
+                                     *algo, key, enc_config, wrapped_key,
+                                     header_generation(resume->header_bytes) + 1) ||
+                !output.flush() || !sync_file(resume->output_path)) {
+                result.error_message = "Failed to commit the appended chunks: " + resume->output_path;
+                return result;
+            }
+        } else if (resume && !resume->shard) {
+            Checkpoint::remove(resume->sidecar_path);
+        }
+        
+        result.bytes_processed = bytes_processed;
+        result.success = true;
+        
+    } catch (const std::exception& e) {
+        result.error_message = std::string("Streaming encryption failed: ") + e.what();
+        return result;
+    }
+    
+    // Throughput covers this run only, not the resumed prefix
+    auto end_time = std::chrono::high_resolution_clock::now();
+    result.processing_time_ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+    result.throughput_mbps = ((result.bytes_processed - resumed_bytes) / 1024.0 / 1024.0) / (result.processing_time_ms / 1000.0);
+    if (result.chunks_processed > 0) {
+        result.skip_rate = static_cast<double>(result.chunks_skipped) / result.chunks_processed;
+    }
+    
+    spdlog::info("Streaming encryption completed: {} chunks, {:.2f} MB/s", 
+                 result.chunks_processed, result.throughput_mbps);
+    if (config.compression != CompressionType::NONE) {
+        spdlog::info("Compression: {} chunks compressed, {} skipped as incompressible",
+                     result.chunks_compressed, result.chunks_skipped);
+    }
+    if (result.chunks_sparse > 0) {
+        spdlog::info("Sparse input: {} chunks stored as zero extents", result.chunks_sparse);
+    }
+    
+    return result;
+}
+
+StreamingResult StreamingCrypto::decrypt_file(
+    const std::string& input_path,
+    const std::string& output_path,
+    const std::string& password,
+    StreamProgressCallback progress_callback,
+    size_t worker_threads,
+    const CheckpointOptions& checkpoint,
+    bool bypass_cache,
+    utils::CommitGroup* commit_group
+) {
+    StreamingResult result;
+    
+    // Open input file (reads ahead through the configured I/O backend)
+    utils::InputFileOptions input_options;
+    input_options.direct = bypass_cache;
+    utils::InputFile input(input_path, input_options);
+    if (!input.is_open()) {
+        result.error_message = "Failed to open input file: " + input_path;
+        return result;
+    }
+    
+    utils::OutputFileOptions output_options;
+    output_options.bypass_cache = bypass_cache;
+    
+    if (checkpoint.interval == 0 && !checkpoint.resume) {
+        // Temp file renamed into place once every chunk has authenticated
+        output_options.atomic = true;
+        utils::OutputFile output(output_path, output_options);
+        if (!output) {
+            result.error_message = "Failed to create output file: " + output_path;
+            return result;
+        }
+        
+        result = decrypt_impl(input, output, password, {}, std::move(progress_callback), worker_threads);
+        result.bytes_written = output ? static_cast<uint64_t>(output.tellp()) : 0;
+        if (result.success && !output.commit(commit_group)) {
+            result.success = false;
+            result.error_message = "Failed to write output file: " + output_path;
+        }
+        return result;
+    }
+    
+    ResumeState resume;
+    resume.output_path = output_path;
+    resume.sidecar_path = Checkpoint::path_for(output_path);
+    resume.interval = checkpoint.interval;
+    resume.checkpoint.operation = Checkpoint::Operation::DECRYPT;
+    if (!resume.checkpoint.stamp_input(input_path)) {
+        result.error_message = "Failed to stat input file: " + input_path;
+        return result;
+    }
+    
+    utils::OutputFile output;
+    if (checkpoint.resume) {
+        auto saved = Checkpoint::load(resume.sidecar_path);
+        if (!saved || saved->operation != Checkpoint::Operation::DECRYPT) {
+            result.error_message = "No decryption checkpoint for " + output_path;
+            return result;
+        }
+        if (!saved->matches_input(input_path)) {
+            result.error_message = "Input changed since the checkpoint was written: " + input_path;
+            return result;
+        }
+        
+        // The input frames up to the checkpoint must be the ones it hashed
+        StreamingConfig header_config;
+        std::vector<uint8_t> salt, base_nonce, header_bytes, header_tag, wrapped_key;
+        size_t original_size = 0, chunk_count = 0;
+        uint8_t version = 0;
+        Checkpoint walked;
+        std::error_code ec;
+        bool consistent =
+            read_stream_header(input, header_config, salt, base_nonce, original_size, chunk_count,
+                               version, header_bytes, header_tag, wrapped_key) &&
+            header_config.chunk_size == saved->chunk_size &&
+            saved->chunks_committed <= chunk_count &&
+            std::filesystem::file_size(output_path, ec) >= saved->output_offset && !ec;
+        if (consistent) {
+            auto end = walk_frames(input, static_cast<uint64_t>(input.tellg()),
+                                   saved->chunks_committed, version, walked, nullptr);
+            consistent = end && *end == saved->input_offset && walked.tag_digest == saved->tag_digest;
+        }
+        if (!consistent) {
+            result.error_message = "Input does not match the checkpoint of " + output_path;
+            return result;
+        }
+        input.clear();
+        input.seekg(0);
+        
+        // Drop whatever was written after the last checkpoint
+        std::filesystem::resize_file(output_path, saved->output_offset, ec);
+        if (ec) {
+            result.error_message = "Failed to truncate output file: " + output_path;
+            return result;
+        }
+        output_options.truncate = false;
+        output.open(output_path, output_options);
+        output.seekp(static_cast<std::streamoff>(saved->output_offset));
+        
+        resume.checkpoint = *saved;
+        resume.resuming = true;
+        spdlog::info("Resuming after chunk {}", saved->chunks_committed);
+    } else {
+        Checkpoint::remove(resume.sidecar_path);
+        output.open(output_path, output_options);
+    }
+    if (!output) {
+        result.error_message = "Failed to create output file: " + output_path;
+        return result;
+    }
+    
+    result = decrypt_impl(input, output, password, {}, std::move(progress_callback), worker_threads, &resume);
+    result.bytes_written = output ? static_cast<uint64_t>(output.tellp()) : 0;
+    return result;
+}
+
+StreamingResult StreamingCrypto::decrypt_stream(
+    std::istream& input,
+    std::ostream& output,
+    const std::string& password,
+    StreamProgressCallback progress_callback,
+    size_t worker_threads
+) {
+    return decrypt_impl(input, output, password, {}, std::move(progress_callback), worker_threads);
+}
+
+StreamingResult StreamingCrypto::decrypt_stream_with_key(
+    std::istream& input,
+    std::ostream& output,
+    std::span<const uint8_t> data_key,
+    StreamProgressCallback progress_callback,
+    size_t worker_threads
+) {
+    StreamingResult result;
+    if (data_key.empty()) {
+        result.error_message = "Data key must not be empty";
+        return result;
+    }
+    return decrypt_impl(input, output, std::string(), data_key, std::move(progress_callback), worker_threads);
+}
+
+StreamingResult StreamingCrypto::decrypt_impl(
+    std::istream& input,
+    std::ostream& output,
+    const std::string& password,
+    std::span<const uint8_t> data_key,
+    StreamProgressCallback progress_callback,
+    size_t worker_threads,
+    ResumeState* resume
+) {
+    utils::ScopedSpan trace_span("StreamingCrypto::decrypt", "streaming");
+    StreamingResult result;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    bool resuming = resume && resume->resuming;
+    uint64_t resumed_bytes = resuming ? resume->checkpoint.bytes_committed : 0;
+    
+    try {
+        // Read header
+        StreamingConfig config;
+        std::vector<uint8_t> salt, base_nonce, header_bytes, header_tag, wrapped_key;
+        size_t original_size, chunk_count;
+        uint8_t version;
+        
+        if (!read_stream_header(input, config, salt, base_nonce, original_size, chunk_count, version,
+                                header_bytes, header_tag, wrapped_key)) {
+            result.error_message = "Failed to read stream header";
+            return result;
+        }
+        
+        // Streams written from a pipe carry no size; they end with a trailer
+        bool known_size = original_size != SIZE_MAX;
+        if (known_size) {
+            spdlog::info("Streaming decryption: {} chunks, {} bytes original", chunk_count, original_size);
+        } else {
+            spdlog::info("Streaming decryption of stream with unknown length");
+        }
+        result.chunk_size = config.chunk_size;
+        
+        // Initialize crypto engine
+        CryptoEngine engine;
+        engine.initialize();
+        
+        // Derive key, unless the caller holds the data key
+        EncryptionConfig enc_config;
+        enc_config.algorithm = config.algorithm;
+        enc_config.kdf = config.kdf;
+        enc_config.level = config.level;
+        enc_config.apply_security_level();
+        
+        std::vector<uint8_t> key(data_key.begin(), data_key.end());
+        if (key.empty()) {
+            auto kdf_start = StageClock::now();
+            key = engine.derive_key(password, salt, enc_config);
+            result.stages.kdf_ms = ms_since(kdf_start);
+        }
+        
+        // Get algorithm
+        auto* algo = engine.get_algorithm(config.algorithm);
+        if (!algo) {
+            result.error_message = "Algorithm not available";
+            return result;
+        }
+        
+        // The password key opens a wrapped file key; a wrong password fails here
+        std::vector<uint8_t> file_key;
+        if (data_key.empty() && !wrapped_key.empty()) {
+            if (!unwrap_data_key(*algo, key, enc_config, base_nonce, wrapped_key, file_key)) {
+                result.error_message = "Header authentication failed (wrong password or corrupted header)";
+                return result;
+            }
+            key = std::move(file_key);
+        }
+        
+        // Nothing is decrypted under a header that does not authenticate
+        if (!verify_stream_header(*algo, key, enc_config, base_nonce, header_bytes, header_tag)) {
+            result.error_message = "Header authentication failed (wrong password or corrupted header)";
+            return result;
+        }
+        
+        // Input offset of the next frame, tracked for checkpoints only
+        // (tellg() does not work on pipes)
+        size_t first_chunk = 0;
+        uint64_t read_pos = 0;
+        if (resuming) {
+            first_chunk = static_cast<size_t>(resume->checkpoint.chunks_committed);
+            read_pos = resume->checkpoint.input_offset;
+            input.seekg(static_cast<std::streamoff>(read_pos));
+            result.chunks_processed = result.chunks_resumed = first_chunk;
+        } else if (resume) {
+            read_pos = static_cast<uint64_t>(input.tellg());
+            resume->checkpoint.chunk_size = config.chunk_size;
+        }
+        
+        // Process chunks. Frames are read ahead on a background thread,
+        // authenticated and decompressed on the worker pool, and written back
+        // strictly in order by this thread.
+        size_t worker_count = worker_threads == 0
+            ? ThreadPool::default_thread_count()
+            : worker_threads;
+        
+        // cancelled: the writer gave up, skip everything still queued.
+        // failed_chunk: lowest chunk index that failed authentication; later
+        // chunks are skipped, earlier ones still finish so they can be written.
+        std::atomic<bool> cancelled{false};
+        std::atomic<size_t> failed_chunk{SIZE_MAX};
+        
+        // Frame and plaintext buffers are recycled across chunks
+        auto& buffers = BufferPool::shared();
+        CheckoutCache<compression::ICompressor> decompressors([&config]() {
+            return compression::CompressionService::create(config.compression);
+        });
+        CheckoutCache<ICipherSession> sessions([&]() { return algo->create_session(key); });
+        
+        auto open_chunk = [&](
+            size_t index, std::vector<uint8_t> encrypted, ShortBytes tag,
+            bool compressed, bool zero_extent
+        ) -> OpenedChunk {
+            utils::ScopedSpan chunk_span("open chunk", "streaming", encrypted.size());
+            OpenedChunk opened;
+            if (cancelled.load(std::memory_order_relaxed) ||
+                index > failed_chunk.load(std::memory_order_relaxed)) {
+                opened.error_message = "cancelled after earlier failure";
+                return opened;
+            }
+            
+            // Each task gets its own config copy carrying the chunk nonce and tag
+            EncryptionConfig chunk_config = enc_config;
+            chunk_config.nonce = derive_chunk_nonce(base_nonce, index);
+            chunk_config.tag = tag;
+            if (version != STREAM_VERSION_NO_FRAME_FLAGS) {
+                chunk_config.associated_data = frame_associated_data(compressed, zero_extent);
+            }
+            
+            auto session = sessions.acquire();
+            if (!session) {
+                opened.error_message = "Failed to create cipher session";
+                return opened;
+            }
+            
+            std::optional<size_t> plain_size;
+            if (known_size) {
+                plain_size = chunk_plain_size(index, config.chunk_size, original_size);
+            }
+            
+            // A flagged compressed chunk is decompressed as it is decrypted
+            if (compressed && version != STREAM_VERSION_NO_FRAME_FLAGS &&
+                config.compression != CompressionType::NONE) {
+                auto decompressor = decompressors.acquire();
+                bool ok = open_and_expand(*session, *decompressor, chunk_config, version, encrypted,
+                                          plain_size, config.chunk_size, opened);
+                decompressors.release(std::move(decompressor));
+                if (!ok) {
+                    size_t current = failed_chunk.load();
+                    while (index < current && !failed_chunk.compare_exchange_weak(current, index)) {
+                    }
+                    return opened;
+                }
+                sessions.release(std::move(session));
+                opened.data = std::move(encrypted);
+                opened.success = true;
+                return opened;
+            }
+            
+            // Decrypt in place: the frame buffer becomes the plaintext buffer
+            auto cipher_start = StageClock::now();
+            auto dec_result = session->decrypt_in_place(encrypted, chunk_config);
+            sessions.release(std::move(session));
+            opened.cipher_ms = ms_since(cipher_start);
+            if (!dec_result.success) {
+                size_t current = failed_chunk.load();
+                while (index < current && !failed_chunk.compare_exchange_weak(current, index)) {
+                }
+                opened.error_message = dec_result.error_message;
+                return opened;
+            }
+            
+            // A hole's length is that of the chunk, known from the header
+            if (zero_extent) {
+                buffers.release(std::move(encrypted), false);
+                if (!plain_size) {
+                    opened.error_message = "zero extent in a stream of unknown length";
+                    return opened;
+                }
+                opened.zero_size = *plain_size;
+                opened.success = true;
+                return opened;
+            }
+            
+            // Decompress if needed
+            opened.data = std::move(encrypted);
+            auto compress_start = StageClock::now();
+            std::unique_ptr<compression::ICompressor> decompressor;
+            if (config.compression != CompressionType::NONE) {
+                decompressor = decompressors.acquire();
+            }
+            bool expanded = expand_opened_chunk(decompressor.get(), opened.data, version,
+                                                compressed, plain_size, opened.error_message);
+            if (decompressor) {
+                decompressors.release(std::move(decompressor));
+            }
+            opened.compress_ms = ms_since(compress_start);
+            if (!expanded) {
+                return opened;
+            }
+            
+            opened.success = true;
+            return opened;
+        };
+        
+        // Declared after engine/key so in-flight tasks finish before those are destroyed.
+        // With async I/O, even a single worker moves crypto off the writer thread.
+        bool multi_chunk = !known_size || chunk_count > 1;
+        auto& budget = MemoryBudget::shared();
+        auto shape = budget.fit_stream({config.chunk_size, worker_count, config.io_buffers}, true);
+        worker_count = shape.workers;
+        const size_t io_buffers = shape.io_buffers;
+        auto memory = budget.lease(MemoryBudget::stream_cost(shape,
+                                                             known_size ? (std::max)(chunk_count, size_t(1)) : 0));
+        std::unique_ptr<TaskGroup> pool;
+        if ((worker_count > 1 || io_buffers > 0) && multi_chunk) {
+            pool = std::make_unique<TaskGroup>(Executor::shared(), worker_count);
+        }
+        
+        // Bound the number of chunks held in memory at once
+        const size_t max_in_flight = pool ? pool->size() + 2 : 1;
+        
+        // End-of-stream trailer, filled in by the reader (unknown length only)
+        bool trailer_seen = false;
+        std::vector<uint8_t> trailer;
+        
+        size_t next_read = first_chunk;
+        ReadAhead<EncryptedFrame> reader(multi_chunk ? io_buffers : 0,
+            [&]() -> std::optional<EncryptedFrame> {
+                // Stop reading ahead once a chunk failed authentication
+                if (next_read >= chunk_count ||
+                    failed_chunk.load(std::memory_order_relaxed) != SIZE_MAX) {
+                    return std::nullopt;
+                }
+                EncryptedFrame frame;
+                frame.index = next_read++;
+                auto read_start = StageClock::now();
+                utils::ScopedSpan read_span("read frame", "io");
+                
+                // Read encrypted chunk size
+                FramePrefix prefix;
+                read_frame_prefix(input, version, prefix);
+                
+                if (!known_size) {
+                    // Clean EOF before the trailer is reported as truncation below
+                    if (input.gcount() == 0 && input.eof()) {
+                        return std::nullopt;
+                    }
+                    if (input && prefix.trailer) {
+                        trailer.resize(TRAILER_PAYLOAD_SIZE + AEAD_TAG_SIZE);
+                        input.read(reinterpret_cast<char*>(trailer.data()), trailer.size());
+                        trailer_seen = static_cast<bool>(input);
+                        return std::nullopt;
+                    }
+                }
+                frame.zero_extent = prefix.zero_extent;
+                frame.compressed = prefix.compressed;
+                
+                // No frame is larger than a chunk; a bigger size is damage,
+                // not a reason to allocate it
+                if (prefix.size > config.chunk_size + AEAD_TAG_SIZE) {
+                    input.setstate(std::ios::failbit);
+                }
+                auto enc_size = input ? static_cast<size_t>(prefix.size) : size_t(0);
+                
+                // Read encrypted data
+                if (input) {
+                    utils::RateLimiter::reads().acquire(enc_size);
+                    frame.encrypted = buffers.acquire(enc_size + AEAD_TAG_SIZE);
+                    frame.encrypted.resize(enc_size);
+                    input.read(reinterpret_cast<char*>(frame.encrypted.data()), enc_size);
+                }
+                
+                // Read tag (16 bytes for GCM)
+                frame.tag.resize(AEAD_TAG_SIZE);
+                input.read(reinterpret_cast<char*>(frame.tag.data()), AEAD_TAG_SIZE);
+                
+                read_pos += frame_prefix_size(version) + enc_size + AEAD_TAG_SIZE;
+                frame.end_offset = read_pos;
+                frame.ok = static_cast<bool>(input);
+                frame.read_ms = ms_since(read_start);
+                read_span.set_bytes(frame.encrypted.size());
+                return frame;
+            });
+        
+        struct PendingChunk {
+            size_t index;
+            std::future<OpenedChunk> opened;
+            ShortBytes tag;             // Kept for checkpoints only
+            uint64_t end_offset = 0;
+        };
+        std::deque<PendingChunk> pending;
+        size_t bytes_processed = static_cast<size_t>(resumed_bytes);
+        
+        // Write the oldest pending chunk; returns false on failure or cancel
+        auto write_next = [&]() -> bool {
+            PendingChunk chunk = std::move(pending.front());
+            pending.pop_front();
+            
+            OpenedChunk opened = pool ? pool->wait(chunk.opened) : chunk.opened.get();
+            if (!opened.success) {
+                result.error_message = "Decryption failed at chunk " + std::to_string(chunk.index) + 
+                                       ": " + opened.error_message;
+                return false;
+            }
+            
+            result.stages.compress_ms += opened.compress_ms;
+            result.stages.cipher_ms += opened.cipher_ms;
+            
+            // Write decrypted data; a zero extent becomes a hole in the output
+            size_t plain_size = opened.zero_size > 0 ? opened.zero_size : opened.data.size();
+            if (opened.zero_size == 0) {
+                utils::RateLimiter::writes().acquire(plain_size);
+            }
+            auto write_start = StageClock::now();
+            {
+                utils::ScopedSpan write_span("write chunk", "io", plain_size);
+                if (opened.zero_size > 0) {
+                    write_zero_extent(output, plain_size);
+                } else {
+                    output.write(reinterpret_cast<const char*>(opened.data.data()), plain_size);
+                }
+            }
+            result.stages.write_ms += ms_since(write_start);
+            buffers.release(std::move(opened.data));
+            if (!output) {
+                result.error_message = "Failed to write chunk " + std::to_string(chunk.index);
+                return false;
+            }
+            
+            bytes_processed += plain_size;
+            result.chunks_processed++;
+            if ((result.chunks_processed & (CHUNK_LOG_INTERVAL - 1)) == 0) {
+                SPDLOG_DEBUG("Decrypted {} chunks, {} bytes", result.chunks_processed, bytes_processed);
+            }
+            
+            // The output holds exactly the plaintext of the committed chunks
+            if (resume && !resume->commit(output, chunk.tag, chunk.end_offset,
+                                          bytes_processed, bytes_processed)) {
+                result.error_message = "Failed to write checkpoint after chunk " + std::to_string(chunk.index);
+                return false;
+            }
+            
+            // Progress callback
+            if (progress_callback) {
+                ChunkInfo info{chunk.index, plain_size, known_size ? chunk_count : 0,
+                               bytes_processed, known_size ? original_size : 0};
+                if (!progress_callback(info)) {
+                    result.error_message = "Operation cancelled by user";
+                    return false;
+                }
+            }
+            
+            return true;
+        };
+        
+        while (auto frame = reader.next()) {
+            result.stages.read_ms += frame->read_ms;
+            
+            // A worker already hit a bad tag: stop reading, report the failed chunk
+            if (failed_chunk.load(std::memory_order_relaxed) != SIZE_MAX) {
+                break;
+            }
+            
+            size_t i = frame->index;
+            if (!frame->ok) {
+                cancelled = true;
+                result.error_message = "Truncated chunk " + std::to_string(i);
+                return result;
+            }
+            
+            auto encrypted = std::move(frame->encrypted);
+            auto tag = std::move(frame->tag);
+            bool compressed = frame->compressed;
+            bool zero_extent = frame->zero_extent;
+            ShortBytes kept_tag;
+            if (resume) {
+                kept_tag = tag;
+            }
+            
+            if (pool) {
+                pending.push_back({i, pool->submit(
+                    [&open_chunk, i, encrypted = std::move(encrypted), tag = std::move(tag),
+                     compressed, zero_extent]() mutable {
+                        return open_chunk(i, std::move(encrypted), std::move(tag), compressed, zero_extent);
+                    }), std::move(kept_tag), frame->end_offset});
+            } else {
+                std::promise<OpenedChunk> ready;
+                ready.set_value(open_chunk(i, std::move(encrypted), std::move(tag), compressed, zero_extent));
+                pending.push_back({i, ready.get_future(), std::move(kept_tag), frame->end_offset});
+            }
+            
+            while (pending.size() >= max_in_flight) {
+                if (!write_next()) {
+                    cancelled = true;
+                    return result;
+                }
+            }
+        }
+        
+        while (!pending.empty()) {
+            if (!write_next()) {
+                cancelled = true;
+                return result;
+            }
+        }
+        
+        if (!known_size) {
+            // Only an authentic trailer proves the stream was not cut short
+            if (!trailer_seen) {
+                result.error_message = "Stream truncated: missing end-of-stream trailer";
+                return result;
+            }
+            
+            EncryptionConfig trailer_config = enc_config;
+            trailer_config.nonce = derive_trailer_nonce(base_nonce);
+            trailer_config.tag = ShortBytes(trailer.begin() + TRAILER_PAYLOAD_SIZE, trailer.end());
+            auto opened = algo->decrypt(std::span<const uint8_t>(trailer.data(), TRAILER_PAYLOAD_SIZE),
+                                        key, trailer_config);
+            if (!opened.success || opened.data.size() != TRAILER_PAYLOAD_SIZE) {
+                result.error_message = "End-of-stream trailer failed authentication";
+                return result;
+            }
+            
+            uint64_t total_bytes = 0;
+            uint64_t total_chunks = 0;
+            std::memcpy(&total_bytes, opened.data.data(), 8);
+            std::memcpy(&total_chunks, opened.data.data() + 8, 8);
+            if (total_bytes != bytes_processed || total_chunks != result.chunks_processed) {
+                result.error_message = "Stream length does not match end-of-stream trailer";
+                return result;
+            }
+        }
+        
+        auto flush_start = StageClock::now();
+        output.flush();
+        result.stages.write_ms += ms_since(flush_start);
+        if (!output) {
+            result.error_message = "Failed to write decrypted output";
+            return result;
+        }
+        if (resume) {
+            Checkpoint::remove(resume->sidecar_path);
+        }
+        
+        result.bytes_processed = bytes_processed;
+        result.success = true;
+        
+    } catch (const std::exception& e) {
+        result.error_message = std::string("Streaming decryption failed: ") + e.what();
+        return result;
+    }
+    
+    // Throughput covers this run only, not the resumed prefix
+    auto end_time = std::chrono::high_resolution_clock::now();
+    result.processing_time_ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+    result.throughput_mbps = ((result.bytes_processed - resumed_bytes) / 1024.0 / 1024.0) / (result.processing_time_ms / 1000.0);
+    
+    spdlog::info("Streaming decryption completed: {} chunks, {:.2f} MB/s", 
+                 result.chunks_processed, result.throughput_mbps);
+    
+    return result;
+}
+
+StreamingResult StreamingCrypto::rekey_file(
+    const std::string& path,
+    const std::string& password,
+    const std::string& new_password,
+    const RekeyOptions& options
+) {
+    utils::ScopedSpan trace_span("StreamingCrypto::rekey", "streaming");
+    StreamingResult result;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    
+    try {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        if (!file) {
+            result.error_message = "Failed to open file: " + path;
+            return result;
+        }
+        
+        StreamingConfig config;
+        std::vector<uint8_t> salt, base_nonce, header_bytes, header_tag, wrapped_key;
+        size_t original_size = 0, chunk_count = 0;
+        uint8_t version = 0;
+        if (!read_stream_header(file, config, salt, base_nonce, original_size, chunk_count, version,
+                                header_bytes, header_tag, wrapped_key)) {
+            result.error_message = "Failed to read stream header";
+            return result;
+        }
+        if (!is_authenticated_version(version) || wrapped_key.empty()) {
+            result.error_message = "File key is not wrapped (file predates key wrapping); "
+                                   "decrypt and re-encrypt it once";
+            return result;
+        }
+        uint16_t generation = header_generation(header_bytes);
+        if (generation == UINT16_MAX) {
+            result.error_message = "Password changed too often; decrypt and re-encrypt the file";
+            return result;
+        }
+        
+        CryptoEngine engine;
+        engine.initialize();
+        auto* algo = engine.get_algorithm(config.algorithm);
+        if (!algo) {
+            result.error_message = "Algorithm not available";
+            return result;
+        }
+        
+        // Open the file key with the current password, header and all
+        EncryptionConfig enc_config;
+        enc_config.algorithm = config.algorithm;
+        enc_config.kdf = config.kdf;
+        enc_config.level = config.level;
+        enc_config.apply_security_level();
+        
+        auto kdf_start = StageClock::now();
+        std::vector<uint8_t> key;
+        if (!unwrap_data_key(*algo, engine.derive_key(password, salt, enc_config), enc_config,
+                             base_nonce, wrapped_key, key) ||
+            !verify_stream_header(*algo, key, enc_config, base_nonce, header_bytes, header_tag)) {
+            result.error_message = "Header authentication failed (wrong password or corrupted header)";
+            return result;
+        }
+        
+        // Wrap it under the new password. Salt and wrapped key keep their
+        // lengths, so the header keeps its size and the chunks stay put.
+        StreamingConfig new_config = config;
+        new_config.kdf = options.kdf.value_or(config.kdf);
+        new_config.level = options.level.value_or(config.level);
+        // A batch file moves to a new batch: options.salt, or one of its own
+        std::vector<uint8_t> new_salt;
+        if (CryptoEngine::is_batch_file_salt(salt) &&
+            (options.salt.empty() || options.salt.size() == CryptoEngine::BATCH_SALT_SIZE)) {
+            new_salt = CryptoEngine::batch_file_salt(
+                options.salt.empty() ? CryptoEngine::generate_salt(CryptoEngine::BATCH_SALT_SIZE) : options.salt);
+        } else {
+            new_salt = options.salt.empty() ? CryptoEngine::generate_salt(salt.size()) : options.salt;
+        }
+        if (new_salt.size() != salt.size()) {
+            result.error_message = "New salt must be " + std::to_string(salt.size()) + " bytes, as the file's";
+            return result;
+        }
+        EncryptionConfig new_enc_config;
+        new_enc_config.algorithm = new_config.algorithm;
+        new_enc_config.kdf = new_config.kdf;
+        new_enc_config.level = new_config.level;
+        new_enc_config.apply_security_level();
+        auto new_wrapped = wrap_data_key(*algo, engine.derive_key(new_password, new_salt, new_enc_config),
+                                         new_enc_config, base_nonce, key);
+        result.stages.kdf_ms = ms_since(kdf_start);
+        
+        std::ostringstream header;
+        if (new_wrapped.empty() ||
+            !write_stream_header(header, new_config, new_salt, base_nonce, original_size, chunk_count,
+                                 *algo, key, enc_config, new_wrapped, generation + 1)) {
+            result.error_message = "Failed to build the new header";
+            return result;
+        }
+        auto bytes = header.str();
+        if (bytes.size() != header_bytes.size() + header_tag.size()) {
+            result.error_message = "New header does not fit in place of the old one";
+            return result;
+        }
+        
+        // A few hundred bytes at offset 0: one sector, written and synced once
+        file.seekp(0);
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        file.close();
+        if (!file || !sync_file(path)) {
+            result.error_message = "Failed to write the new header: " + path;
+            return result;
+        }
+        
+        result.bytes_written = bytes.size();
+        result.success = true;
+        
+    } catch (const std::exception& e) {
+        result.error_message = std::string("Password change failed: ") + e.what();
+        return result;
+    }
+    
+    result.processing_time_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - start_time).count();
+    return result;
+}
+
+StreamingResult StreamingCrypto::append_stream(
+    const std::string& path,
+    const std::string& password,
+    std::istream& input,
+    size_t input_size,
+    size_t worker_threads
+) {
+    utils::ScopedSpan trace_span("StreamingCrypto::append", "streaming", input_size);
+    StreamingResult result;
+    
+    ResumeState resume;
+    resume.output_path = path;
+    resume.append = true;
+    
+    std::ifstream existing(path, std::ios::binary);
+    StreamingConfig config;
+    size_t original_size = 0, chunk_count = 0;
+    uint8_t version = 0;
+    if (!existing ||
+        !read_stream_header(existing, config, resume.salt, resume.base_nonce, original_size, chunk_count,
+                            version, resume.header_bytes, resume.header_tag, resume.wrapped_key)) {
+        result.error_message = "Failed to read stream header: " + path;
+        return result;
+    }
+    if (!is_authenticated_version(version) || original_size == SIZE_MAX) {
+        result.error_message = "Only FVAULT02 files of known length can be appended to";
+        return result;
+    }
+    if (config.chunk_size == 0 || original_size % config.chunk_size != 0) {
+        result.error_message = "File does not end on a chunk boundary; its last chunk cannot be extended";
+        return result;
+    }
+    if (header_generation(resume.header_bytes) == UINT16_MAX) {
+        result.error_message = "Header rewritten too often; decrypt and re-encrypt the file";
+        return result;
+    }
+    if (input_size == 0) {
+        result.error_message = "Nothing to append";
+        return result;
+    }
+    size_t total_size = original_size + input_size;
+    if (version != STREAM_VERSION_WIDE &&
+        (total_size + config.chunk_size - 1) / config.chunk_size >= STREAM_CHUNKS_UNKNOWN) {
+        result.error_message = "Too many chunks for the file's 4-byte chunk count";
+        return result;
+    }
+    
+    // The frames must end exactly in an intact index
+    Checkpoint walked;
+    uint64_t data_start = static_cast<uint64_t>(existing.tellg());
+    auto end = walk_frames(existing, data_start, chunk_count, version, walked, &resume.frame_offsets);
+    existing.clear();
+    existing.seekg(0, std::ios::end);
+    uint64_t file_size = static_cast<uint64_t>(existing.tellg());
+    bool intact = end && file_size == *end + static_cast<uint64_t>(chunk_count) * 8 + INDEX_TRAILER_SIZE;
+    if (intact) {
+        std::vector<uint64_t> indexed(chunk_count);
+        uint64_t index_offset = 0;
+        uint8_t magic[4] = {};
+        existing.seekg(static_cast<std::streamoff>(*end));
+        existing.read(reinterpret_cast<char*>(indexed.data()), static_cast<std::streamsize>(chunk_count * 8));
+        existing.read(reinterpret_cast<char*>(&index_offset), 8);
+        existing.read(reinterpret_cast<char*>(magic), 4);
+        intact = existing && indexed == resume.frame_offsets && index_offset == *end &&
+                 std::memcmp(magic, INDEX_MAGIC, 4) == 0;
+    }
+    if (!intact) {
+        result.error_message = "Data does not end in the frame index (an interrupted append?): " + path;
+        return result;
+    }
+    existing.close();
+    
+    // Settings come from the existing header, which encrypt_impl authenticates
+    StreamingConfig job_config;
+    job_config.algorithm = config.algorithm;
+    job_config.kdf = config.kdf;
+    job_config.level = config.level;
+    job_config.compression = config.compression;
+    job_config.chunk_size = config.chunk_size;
+    job_config.wide_frames = version == STREAM_VERSION_WIDE;
+    job_config.worker_threads = worker_threads;
+    
+    // Kept so the header is rewritten at its old size; it describes the
+    // source before the append, so a sync no longer matches it
+    job_config.fingerprint = config.fingerprint;
+    
+    resume.checkpoint.chunk_size = config.chunk_size;
+    resume.checkpoint.chunks_committed = chunk_count;
+    resume.checkpoint.input_offset = original_size;
+    resume.checkpoint.output_offset = *end;
+    resume.checkpoint.bytes_committed = original_size;
+    resume.resuming = true;
+    
+    // New frames go over the old index. Until the header is rewritten it
+    // still counts only the old chunks, the footer no longer matches that
+    // count, and readers walk the old frames instead
+    utils::OutputFileOptions output_options;
+    output_options.truncate = false;
+    utils::OutputFile output(path, output_options);
+    if (!output) {
+        result.error_message = "Failed to open file for writing: " + path;
+        return result;
+    }
+    output.seekp(static_cast<std::streamoff>(*end));
+    
+    result = encrypt_impl(input, output, password, {}, job_config, total_size, &resume);
+    result.bytes_written = output ? static_cast<uint64_t>(output.tellp()) : 0;
+    return result;
 }
 
-std::vector<uint8_t> StreamingCrypto::derive_chunk_nonce(
-    const std::vector<uint8_t>& base_nonce,
-    size_t chunk_index
+StreamingResult StreamingCrypto::init_shards(
+    const std::string& input_path,
+    const std::string& output_path,
+    const std::string& password,
+    const StreamingConfig& config
 ) {
-    // XOR chunk index into last 4 bytes of nonce
-    std::vector<uint8_t> chunk_nonce = base_nonce;
+    StreamingResult result;
+    if (config.compression != CompressionType::NONE) {
+        result.error_message = "Sharded files cannot be compressed: frame offsets must be known in advance";
+        return result;
+    }
     
-    // Ensure nonce is at least 12 bytes
-    if (chunk_nonce.size() < 12) {
-        chunk_nonce.resize(12, 0);
+    std::ifstream input(input_path, std::ios::binary | std::ios::ate);
+    if (!input) {
+        result.error_message = "Failed to open input file: " + input_path;
+        return result;
     }
+    size_t file_size = static_cast<size_t>(input.tellg());
+    input.seekg(0);
     
-    // XOR chunk index into bytes 8-11
-    for (int i = 0; i < 4; ++i) {
-        chunk_nonce[8 + i] ^= static_cast<uint8_t>((chunk_index >> (i * 8)) & 0xFF);
+    // encrypt_impl() with an empty share writes just the header
+    ResumeState resume;
+    resume.output_path = output_path;
+    resume.shard = true;
+    resume.end_chunk = 0;
+    StreamingConfig job_config = config;
+    job_config.adaptive_chunk_size = false;
+    {
+        utils::OutputFile output(output_path);
+        if (!output) {
+            result.error_message = "Failed to create output file: " + output_path;
+            return result;
+        }
+        result = encrypt_impl(input, output, password, {}, job_config, file_size, &resume);
+        if (!result.success) {
+            return result;
+        }
+        if (!output.commit()) {
+            result.success = false;
+            result.error_message = "Failed to write output file: " + output_path;
+            return result;
+        }
     }
     
-    return chunk_nonce;
+    // Extend to the final size (sparse), so each rank only writes inside it
+    std::ifstream written(output_path, std::ios::binary);
+    StreamingConfig header_config;
+    std::vector<uint8_t> salt, base_nonce, header_bytes, header_tag, wrapped_key;
+    ShardLayout layout;
+    size_t original_size = 0;
+    if (!written ||
+        !read_stream_header(written, header_config, salt, base_nonce, original_size, layout.chunk_count,
+                            layout.version, header_bytes, header_tag, wrapped_key)) {
+        result.success = false;
+        result.error_message = "Failed to read back the stream header: " + output_path;
+        return result;
+    }
+    layout.data_start = static_cast<uint64_t>(written.tellg());
+    layout.chunk_size = header_config.chunk_size;
+    layout.original_size = original_size;
+    written.close();
+    
+    std::error_code ec;
+    std::filesystem::resize_file(output_path, layout.file_size(), ec);
+    if (ec || !sync_file(output_path)) {
+        result.success = false;
+        result.error_message = "Failed to extend output file: " + output_path;
+        return result;
+    }
+    result.chunks_processed = 0;
+    result.bytes_written = layout.file_size();
+    spdlog::info("Sharded output laid out: {} chunks of {} bytes, {} bytes", layout.chunk_count,
+                 layout.chunk_size, layout.file_size());
+    return result;
 }
 
-bool StreamingCrypto::write_stream_header(
-    std::ofstream& file,
-    const StreamingConfig& config,
-    const std::vector<uint8_t>& salt,
-    const std::vector<uint8_t>& base_nonce,
-    size_t total_size,
-    size_t chunk_count
+StreamingResult StreamingCrypto::encrypt_shard(
+    const std::string& input_path,
+    const std::string& output_path,
+    const std::string& password,
+    size_t rank,
+    size_t ranks,
+    size_t worker_threads,
+    StreamProgressCallback progress_callback
 ) {
-    // Write magic bytes
-    file.write(reinterpret_cast<const char*>(STREAM_MAGIC), 4);
-    
-    // Write version
-    file.write(reinterpret_cast<const char*>(&STREAM_VERSION), 1);
+    StreamingResult result;
+    if (ranks == 0 || rank >= ranks) {
+        result.error_message = "Rank must be below the number of ranks";
+        return result;
+    }
     
-    // Write algorithm type (1 byte)
-    uint8_t algo = static_cast<uint8_t>(config.algorithm);
-    file.write(reinterpret_cast<const char*>(&algo), 1);
+    ResumeState resume;
+    resume.output_path = output_path;
+    resume.shard = true;
     
-    // Write KDF type (1 byte)
-    uint8_t kdf = static_cast<uint8_t>(config.kdf);
-    file.write(reinterpret_cast<const char*>(&kdf), 1);
+    std::ifstream existing(output_path, std::ios::binary);
+    StreamingConfig config;
+    ShardLayout layout;
+    size_t original_size = 0;
+    if (!existing ||
+        !read_stream_header(existing, config, resume.salt, resume.base_nonce, original_size, layout.chunk_count,
+                            layout.version, resume.header_bytes, resume.header_tag, resume.wrapped_key)) {
+        result.error_message = "Failed to read stream header (run init_shards first): " + output_path;
+        return result;
+    }
+    layout.data_start = static_cast<uint64_t>(existing.tellg());
+    layout.chunk_size = config.chunk_size;
+    layout.original_size = original_size;
+    existing.seekg(0, std::ios::end);
+    uint64_t output_size = static_cast<uint64_t>(existing.tellg());
+    existing.close();
+    if (!is_authenticated_version(layout.version) || original_size == SIZE_MAX ||
+        config.compression != CompressionType::NONE || output_size != layout.file_size()) {
+        result.error_message = "Not a file laid out for sharded encryption: " + output_path;
+        return result;
+    }
     
-    // Write compression type (1 byte)
-    uint8_t comp = static_cast<uint8_t>(config.compression);
-    file.write(reinterpret_cast<const char*>(&comp), 1);
+    utils::InputFile input(input_path);
+    if (!input.is_open()) {
+        result.error_message = "Failed to open input file: " + input_path;
+        return result;
+    }
+    if (input.size() != original_size) {
+        result.error_message = "Input size does not match the sharded file: " + input_path;
+        return result;
+    }
     
-    // Write chunk size (8 bytes)
-    uint64_t chunk_sz = config.chunk_size;
-    file.write(reinterpret_cast<const char*>(&chunk_sz), 8);
+    // Settings come from the header, which encrypt_impl authenticates
+    StreamingConfig job_config;
+    job_config.algorithm = config.algorithm;
+    job_config.kdf = config.kdf;
+    job_config.level = config.level;
+    job_config.chunk_size = config.chunk_size;
+    job_config.wide_frames = layout.version == STREAM_VERSION_WIDE;
+    job_config.worker_threads = worker_threads;
+    job_config.progress_callback = std::move(progress_callback);
     
-    // Write total size (8 bytes)
-    uint64_t total_sz = total_size;
-    file.write(reinterpret_cast<const char*>(&total_sz), 8);
+    size_t first = layout.first_chunk(rank, ranks);
+    resume.end_chunk = layout.first_chunk(rank + 1, ranks);
+    uint64_t first_byte = static_cast<uint64_t>(first) * layout.chunk_size;
+    resume.checkpoint.chunk_size = layout.chunk_size;
+    resume.checkpoint.chunks_committed = first;
+    resume.checkpoint.input_offset = first_byte;
+    resume.checkpoint.output_offset = layout.frame_offset(first);
+    resume.checkpoint.bytes_committed = first_byte;
+    resume.resuming = true;
+    spdlog::info("Rank {} of {}: chunks {} to {}", rank, ranks, first, resume.end_chunk);
     
-    // Write chunk count (4 bytes)
-    uint32_t chunks = static_cast<uint32_t>(chunk_count);
-    file.write(reinterpret_cast<const char*>(&chunks), 4);
+    utils::OutputFileOptions output_options;
+    output_options.truncate = false;
+    utils::OutputFile output(output_path, output_options);
+    if (!output) {
+        result.error_message = "Failed to open file for writing: " + output_path;
+        return result;
+    }
+    output.seekp(static_cast<std::streamoff>(layout.frame_offset(first)));
     
-    // Write salt length and salt (1 + N bytes)
-    uint8_t salt_len = static_cast<uint8_t>(salt.size());
-    file.write(reinterpret_cast<const char*>(&salt_len), 1);
-    file.write(reinterpret_cast<const char*>(salt.data()), salt.size());
+    result = encrypt_impl(input, output, password, {}, job_config, original_size, &resume);
+    if (result.success && !output.commit()) {
+        result.success = false;
+        result.error_message = "Failed to sync the frames of rank " + std::to_string(rank);
+    }
     
-    // Write nonce length and base nonce (1 + N bytes)
-    uint8_t nonce_len = static_cast<uint8_t>(base_nonce.size());
-    file.write(reinterpret_cast<const char*>(&nonce_len), 1);
-    file.write(reinterpret_cast<const char*>(base_nonce.data()), base_nonce.size());
+    if (!result.success) {
+        return result;
+    }
     
-    return file.good();
+    // Report this rank's share, not the chunks before it
+    result.bytes_processed -= static_cast<size_t>(first_byte);
+    result.chunks_processed -= result.chunks_resumed;
+    result.chunks_resumed = 0;
+    if (resume.end_chunk > first) {
+        size_t last = resume.end_chunk - 1;
+        result.bytes_written = layout.frame_offset(last) + layout.frame_size(last) - layout.frame_offset(first);
+    }
+    return result;
 }
 
-bool StreamingCrypto::read_stream_header(
-    std::ifstream& file,
-    StreamingConfig& config,
-    std::vector<uint8_t>& salt,
-    std::vector<uint8_t>& base_nonce,
-    size_t& original_size,
-    size_t& chunk_count
-) {
-    // Read and verify magic bytes
-    uint8_t magic[4];
-    file.read(reinterpret_cast<char*>(magic), 4);
-    if (std::memcmp(magic, STREAM_MAGIC, 4) != 0) {
-        spdlog::error("Invalid streaming file format");
-        return false;
+StreamingResult StreamingCrypto::stitch_shards(const std::string& output_path) {
+    StreamingResult result;
+    
+    std::fstream file(output_path, std::ios::binary | std::ios::in | std::ios::out);
+    StreamingConfig config;
+    std::vector<uint8_t> salt, base_nonce, header_bytes, header_tag, wrapped_key;
+    ShardLayout layout;
+    size_t original_size = 0;
+    if (!file ||
+        !read_stream_header(file, config, salt, base_nonce, original_size, layout.chunk_count,
+                            layout.version, header_bytes, header_tag, wrapped_key)) {
+        result.error_message = "Failed to read stream header: " + output_path;
+        return result;
+    }
+    layout.data_start = static_cast<uint64_t>(file.tellg());
+    layout.chunk_size = config.chunk_size;
+    layout.original_size = original_size;
+    file.seekg(0, std::ios::end);
+    uint64_t output_size = static_cast<uint64_t>(file.tellg());
+    if (!is_authenticated_version(layout.version) || original_size == SIZE_MAX ||
+        config.compression != CompressionType::NONE || output_size != layout.file_size()) {
+        result.error_message = "Not a file laid out for sharded encryption: " + output_path;
+        return result;
     }
     
-    // Read version
-    uint8_t version;
-    file.read(reinterpret_cast<char*>(&version), 1);
-    if (version != STREAM_VERSION) {
-        spdlog::error("Unsupported streaming format version: {}", version);
-        return false;
+    // Parts not yet written read as zeros: a zero prefix or an all-zero tag
+    std::vector<uint64_t> frame_offsets(layout.chunk_count);
+    for (size_t i = 0; i < layout.chunk_count; ++i) {
+        frame_offsets[i] = layout.frame_offset(i);
+        FramePrefix prefix;
+        file.seekg(static_cast<std::streamoff>(frame_offsets[i]));
+        bool written = read_frame_prefix(file, layout.version, prefix) && !prefix.compressed &&
+                       !prefix.zero_extent && prefix.size == chunk_plain_size(i, layout.chunk_size, original_size);
+        if (written) {
+            uint8_t tag[AEAD_TAG_SIZE] = {};
+            file.seekg(static_cast<std::streamoff>(frame_offsets[i] + layout.frame_size(i) - AEAD_TAG_SIZE));
+            file.read(reinterpret_cast<char*>(tag), AEAD_TAG_SIZE);
+            written = file && std::any_of(std::begin(tag), std::end(tag), [](uint8_t b) { return b != 0; });
+        }
+        if (!written) {
+            result.error_message = "Chunk " + std::to_string(i) + " has not been written; not every rank has finished";
+            return result;
+        }
     }
     
-    // Read algorithm type
-    uint8_t algo;
-    file.read(reinterpret_cast<char*>(&algo), 1);
-    config.algorithm = static_cast<AlgorithmType>(algo);
-    
-    // Read KDF type
-    uint8_t kdf;
-    file.read(reinterpret_cast<char*>(&kdf), 1);
-    config.kdf = static_cast<KDFType>(kdf);
-    
-    // Read compression type
-    uint8_t comp;
-    file.read(reinterpret_cast<char*>(&comp), 1);
-    config.compression = static_cast<CompressionType>(comp);
-    
-    // Read chunk size
-    uint64_t chunk_sz;
-    file.read(reinterpret_cast<char*>(&chunk_sz), 8);
-    config.chunk_size = static_cast<size_t>(chunk_sz);
-    
-    // Read total size
-    uint64_t total_sz;
-    file.read(reinterpret_cast<char*>(&total_sz), 8);
-    original_size = static_cast<size_t>(total_sz);
-    
-    // Read chunk count
-    uint32_t chunks;
-    file.read(reinterpret_cast<char*>(&chunks), 4);
-    chunk_count = chunks;
-    
-    // Read salt
-    uint8_t salt_len;
-    file.read(reinterpret_cast<char*>(&salt_len), 1);
-    salt.resize(salt_len);
-    file.read(reinterpret_cast<char*>(salt.data()), salt_len);
-    
-    // Read base nonce
-    uint8_t nonce_len;
-    file.read(reinterpret_cast<char*>(&nonce_len), 1);
-    base_nonce.resize(nonce_len);
-    file.read(reinterpret_cast<char*>(base_nonce.data()), nonce_len);
+    file.clear();
+    file.seekp(static_cast<std::streamoff>(layout.data_end()));
+    if (!write_frame_index(file, frame_offsets, layout.data_end()) || !file.flush()) {
+        result.error_message = "Failed to write frame index: " + output_path;
+        return result;
+    }
+    file.close();
+    if (!sync_file(output_path)) {
+        result.error_message = "Failed to sync output file: " + output_path;
+        return result;
+    }
     
-    return file.good();
+    result.success = true;
+    result.chunk_size = layout.chunk_size;
+    result.chunks_processed = layout.chunk_count;
+    result.bytes_processed = original_size;
+    result.bytes_written = layout.file_size();
+    return result;
 }
 
-StreamingResult StreamingCrypto::encrypt_file(
+StreamingResult StreamingCrypto::decrypt_range(
     const std::string& input_path,
-    const std::string& output_path,
     const std::string& password,
-    const StreamingConfig& config
+    uint64_t offset,
+    size_t length,
+    std::vector<uint8_t>& output
 ) {
+    output.clear();
+    
+    StreamReader reader;
+    auto result = reader.open(input_path, password);
+    if (!result.success) {
+        return result;
+    }
+    return reader.read(offset, length, output);
+}
+
+struct StreamReader::State {
+    std::unique_ptr<std::istream> input;
+    StreamingConfig config;
+    std::vector<uint8_t> salt;
+    std::vector<uint8_t> base_nonce;
+    size_t original_size = 0;
+    size_t chunk_count = 0;
+    uint8_t version = 0;
+    uint64_t data_start = 0;
+    std::vector<uint64_t> frame_offsets;
+    
+    CryptoEngine engine;
+    EncryptionConfig enc_config;
+    std::unique_ptr<ICipherSession> session;
+    std::unique_ptr<compression::ICompressor> decompressor;
+    
+    // Plaintext of the last chunk opened
+    size_t cached_index = SIZE_MAX;
+    std::vector<uint8_t> cached;
+    size_t chunks_decrypted = 0;
+};
+
+StreamReader::StreamReader() = default;
+StreamReader::~StreamReader() = default;
+
+StreamingResult StreamReader::open(const std::string& input_path, const std::string& password) {
+    auto input = std::make_unique<std::ifstream>(input_path, std::ios::binary);
+    if (!*input) {
+        state_.reset();
+        StreamingResult result;
+        result.error_message = "Failed to open input file: " + input_path;
+        return result;
+    }
+    return open(std::move(input), password);
+}
+
+StreamingResult StreamReader::open(std::unique_ptr<std::istream> input, const std::string& password) {
     StreamingResult result;
-    auto start_time = std::chrono::high_resolution_clock::now();
+    state_.reset();
     
     try {
-        // Open input file
-        std::ifstream input(input_path, std::ios::binary | std::ios::ate);
-        if (!input) {
-            result.error_message = "Failed to open input file: " + input_path;
+        auto state = std::make_unique<State>();
+        state->input = std::move(input);
+        
+        // Read header
+        std::vector<uint8_t> header_bytes, header_tag, wrapped_key;
+        if (!StreamingCrypto::read_stream_header(*state->input, state->config, state->salt,
+                                                 state->base_nonce, state->original_size,
+                                                 state->chunk_count, state->version,
+                                                 header_bytes, header_tag, wrapped_key)) {
+            result.error_message = "Failed to read stream header";
             return result;
         }
+        state->data_start = static_cast<uint64_t>(state->input->tellg());
         
-        size_t file_size = input.tellg();
-        input.seekg(0);
-        
-        spdlog::info("Streaming encryption: {} ({} bytes)", input_path, file_size);
-        
-        // Calculate chunk count
-        size_t chunk_size = config.chunk_size;
-        size_t chunk_count = (file_size + chunk_size - 1) / chunk_size;
+        if (state->config.chunk_size == 0) {
+            result.error_message = "Invalid chunk size in stream header";
+            return result;
+        }
+        if (state->original_size == SIZE_MAX) {
+            result.error_message = "Range reads need a stream of known length";
+            return result;
+        }
         
         // Initialize crypto engine
-        CryptoEngine engine;
-        engine.initialize();
-        
-        // Generate salt and derive key
-        auto salt = CryptoEngine::generate_salt(32);
-        auto base_nonce = CryptoEngine::generate_nonce(12);
+        state->engine.initialize();
         
-        EncryptionConfig enc_config;
-        enc_config.algorithm = config.algorithm;
-        enc_config.kdf = config.kdf;
-        enc_config.level = config.level;
-        enc_config.apply_security_level();
+        // Derive key
+        state->enc_config.algorithm = state->config.algorithm;
+        state->enc_config.kdf = state->config.kdf;
+        state->enc_config.level = state->config.level;
+        state->enc_config.apply_security_level();
         
-        auto key = engine.derive_key(password, salt, enc_config);
+        auto key = state->engine.derive_key(password, state->salt, state->enc_config);
         
         // Get algorithm
-        auto* algo = engine.get_algorithm(config.algorithm);
+        auto* algo = state->engine.get_algorithm(state->config.algorithm);
         if (!algo) {
             result.error_message = "Algorithm not available";
             return result;
         }
         
-        // Open output file
-        std::ofstream output(output_path, std::ios::binary);
-        if (!output) {
-            result.error_message = "Failed to create output file: " + output_path;
-            return result;
+        std::vector<uint8_t> file_key;
+        if (!wrapped_key.empty()) {
+            if (!StreamingCrypto::unwrap_data_key(*algo, key, state->enc_config, state->base_nonce,
+                                                  wrapped_key, file_key)) {
+                result.error_message = "Header authentication failed (wrong password or corrupted header)";
+                return result;
+            }
+            key = std::move(file_key);
         }
         
-        // Write header
-        if (!write_stream_header(output, config, salt, base_nonce, file_size, chunk_count)) {
-            result.error_message = "Failed to write stream header";
+        if (!StreamingCrypto::verify_stream_header(*algo, key, state->enc_config, state->base_nonce,
+                                                   header_bytes, header_tag)) {
+            result.error_message = "Header authentication failed (wrong password or corrupted header)";
             return result;
         }
         
-        // Process chunks
-        std::vector<uint8_t> chunk_buffer(chunk_size);
-        size_t bytes_processed = 0;
+        state->session = algo->create_session(key);
+        if (!state->session) {
+            result.error_message = "Failed to create cipher session";
+            return result;
+        }
         
-        for (size_t i = 0; i < chunk_count; ++i) {
-            // Read chunk
-            size_t bytes_to_read = (std::min)(chunk_size, file_size - bytes_processed);
-            input.read(reinterpret_cast<char*>(chunk_buffer.data()), bytes_to_read);
-            
-            if (!input && !input.eof()) {
-                result.error_message = "Failed to read input chunk";
-                return result;
-            }
-            
-            // Compress if enabled
-            std::vector<uint8_t> data_to_encrypt(chunk_buffer.begin(), 
-                                                  chunk_buffer.begin() + bytes_to_read);
-            
-            if (config.compression != CompressionType::NONE) {
-                auto compressor = compression::CompressionService::create(config.compression);
-                if (compressor) {
-                    auto comp_result = compressor->compress(data_to_encrypt, config.compression_level);
-                    if (comp_result.success && comp_result.data.size() < data_to_encrypt.size()) {
-                        data_to_encrypt = std::move(comp_result.data);
-                    }
-                }
-            }
-            
-            // Generate chunk-specific nonce
-            auto chunk_nonce = derive_chunk_nonce(base_nonce, i);
-            enc_config.nonce = chunk_nonce;
-            
-            // Encrypt chunk
-            auto enc_result = algo->encrypt(data_to_encrypt, key, enc_config);
-            if (!enc_result.success) {
-                result.error_message = "Encryption failed at chunk " + std::to_string(i);
-                return result;
-            }
-            
-            // Write encrypted chunk: [4 bytes size][data][16 bytes tag]
-            uint32_t enc_size = static_cast<uint32_t>(enc_result.data.size());
-            output.write(reinterpret_cast<const char*>(&enc_size), 4);
-            output.write(reinterpret_cast<const char*>(enc_result.data.data()), enc_result.data.size());
-            
-            // Write tag if present
-            if (enc_result.tag.has_value()) {
-                output.write(reinterpret_cast<const char*>(enc_result.tag.value().data()), 
-                            enc_result.tag.value().size());
-            }
-            
-            bytes_processed += bytes_to_read;
-            result.chunks_processed++;
-            
-            // Progress callback
-            if (config.progress_callback) {
-                ChunkInfo info{i, bytes_to_read, chunk_count, bytes_processed, file_size};
-                if (!config.progress_callback(info)) {
-                    result.error_message = "Operation cancelled by user";
-                    return result;
-                }
-            }
+        if (state->config.compression != CompressionType::NONE) {
+            state->decompressor = compression::CompressionService::create(state->config.compression);
         }
         
-        result.bytes_processed = bytes_processed;
+        result.chunk_size = state->config.chunk_size;
         result.success = true;
+        state_ = std::move(state);
         
     } catch (const std::exception& e) {
-        result.error_message = std::string("Streaming encryption failed: ") + e.what();
-        return result;
+        result.error_message = std::string("Failed to open stream: ") + e.what();
     }
     
-    auto end_time = std::chrono::high_resolution_clock::now();
-    result.processing_time_ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
-    result.throughput_mbps = (result.bytes_processed / 1024.0 / 1024.0) / (result.processing_time_ms / 1000.0);
+    return result;
+}
+
+uint64_t StreamReader::size() const {
+    return state_ ? state_->original_size : 0;
+}
+
+size_t StreamReader::chunk_size() const {
+    return state_ ? state_->config.chunk_size : 0;
+}
+
+size_t StreamReader::chunks_decrypted() const {
+    return state_ ? state_->chunks_decrypted : 0;
+}
+
+bool StreamReader::load_chunk(size_t i, std::string& error) {
+    State& s = *state_;
+    if (s.cached_index == i) {
+        return true;
+    }
+    s.cached_index = SIZE_MAX;
     
-    spdlog::info("Streaming encryption completed: {} chunks, {:.2f} MB/s", 
-                 result.chunks_processed, result.throughput_mbps);
+    // Frames are located lazily: scanning (no footer) stops at chunk i
+    if (i >= s.frame_offsets.size() &&
+        !StreamingCrypto::read_frame_index(*s.input, s.data_start, s.chunk_count, i, s.version,
+                                           s.frame_offsets)) {
+        error = "Failed to locate chunk frames";
+        return false;
+    }
     
-    return result;
+    auto& buffers = BufferPool::shared();
+    
+    // Read frame: [4 or 8 bytes size | flag][data][16 bytes tag]
+    FramePrefix prefix;
+    s.input->clear();
+    s.input->seekg(static_cast<std::streamoff>(s.frame_offsets[i]));
+    read_frame_prefix(*s.input, s.version, prefix);
+    bool compressed = prefix.compressed;
+    bool zero_extent = prefix.zero_extent;
+    if (prefix.size > s.config.chunk_size + AEAD_TAG_SIZE) {
+        error = "Corrupt frame size at chunk " + std::to_string(i);
+        return false;
+    }
+    auto enc_size = static_cast<size_t>(prefix.size);
+    
+    std::vector<uint8_t> data;
+    if (*s.input) {
+        data = buffers.acquire(enc_size + AEAD_TAG_SIZE);
+        data.resize(enc_size);
+        s.input->read(reinterpret_cast<char*>(data.data()), enc_size);
+    }
+    
+    ShortBytes tag(AEAD_TAG_SIZE);
+    s.input->read(reinterpret_cast<char*>(tag.data()), AEAD_TAG_SIZE);
+    if (!*s.input) {
+        buffers.release(std::move(data));
+        error = "Truncated chunk " + std::to_string(i);
+        return false;
+    }
+    
+    EncryptionConfig chunk_config = s.enc_config;
+    chunk_config.nonce = StreamingCrypto::derive_chunk_nonce(s.base_nonce, i);
+    chunk_config.tag = tag;
+    if (s.version != STREAM_VERSION_NO_FRAME_FLAGS) {
+        chunk_config.associated_data = frame_associated_data(compressed, zero_extent);
+    }
+    
+    auto dec_result = s.session->decrypt_in_place(data, chunk_config);
+    if (!dec_result.success) {
+        buffers.release(std::move(data));
+        error = "Decryption failed at chunk " + std::to_string(i) + ": " + dec_result.error_message;
+        return false;
+    }
+    s.chunks_decrypted++;
+    
+    // Every chunk but the last holds exactly chunk_size plaintext bytes
+    size_t expected = chunk_plain_size(i, s.config.chunk_size, s.original_size);
+    
+    // A zero extent holds only its tag; decompress anything else if needed
+    std::string expand_error;
+    if (zero_extent) {
+        data.assign(expected, 0);
+    } else if (!expand_opened_chunk(s.decompressor.get(), data, s.version, compressed,
+                             expected, expand_error)) {
+        buffers.release(std::move(data));
+        error = "Chunk " + std::to_string(i) + ": " + expand_error;
+        return false;
+    }
+    if (data.size() != expected) {
+        buffers.release(std::move(data));
+        error = "Unexpected plaintext size in chunk " + std::to_string(i);
+        return false;
+    }
+    
+    buffers.release(std::move(s.cached));
+    s.cached = std::move(data);
+    s.cached_index = i;
+    return true;
 }
 
-StreamingResult StreamingCrypto::decrypt_file(
-    const std::string& input_path,
-    const std::string& output_path,
-    const std::string& password,
-    StreamProgressCallback progress_callback
-) {
+StreamingResult StreamReader::read(uint64_t offset, size_t length, std::vector<uint8_t>& output) {
     StreamingResult result;
     auto start_time = std::chrono::high_resolution_clock::now();
+    output.clear();
+    
+    if (!state_) {
+        result.error_message = "Stream is not open";
+        return result;
+    }
+    State& s = *state_;
+    result.chunk_size = s.config.chunk_size;
     
     try {
-        // Open input file
-        std::ifstream input(input_path, std::ios::binary);
-        if (!input) {
-            result.error_message = "Failed to open input file: " + input_path;
-            return result;
-        }
-        
-        // Read header
-        StreamingConfig config;
-        std::vector<uint8_t> salt, base_nonce;
-        size_t original_size, chunk_count;
-        
-        if (!read_stream_header(input, config, salt, base_nonce, original_size, chunk_count)) {
-            result.error_message = "Failed to read stream header";
+        if (offset > s.original_size) {
+            result.error_message = "Offset beyond end of file";
             return result;
         }
         
-        spdlog::info("Streaming decryption: {} chunks, {} bytes original", chunk_count, original_size);
-        
-        // Initialize crypto engine
-        CryptoEngine engine;
-        engine.initialize();
-        
-        // Derive key
-        EncryptionConfig enc_config;
-        enc_config.algorithm = config.algorithm;
-        enc_config.kdf = config.kdf;
-        enc_config.level = config.level;
-        enc_config.apply_security_level();
-        
-        auto key = engine.derive_key(password, salt, enc_config);
-        
-        // Get algorithm
-        auto* algo = engine.get_algorithm(config.algorithm);
-        if (!algo) {
-            result.error_message = "Algorithm not available";
+        // Clamp the range to the end of the plaintext
+        length = static_cast<size_t>((std::min)(static_cast<uint64_t>(length), s.original_size - offset));
+        if (length == 0) {
+            result.success = true;
             return result;
         }
         
-        // Open output file
-        std::ofstream output(output_path, std::ios::binary);
-        if (!output) {
-            result.error_message = "Failed to create output file: " + output_path;
+        size_t first_chunk = static_cast<size_t>(offset / s.config.chunk_size);
+        size_t last_chunk = static_cast<size_t>((offset + length - 1) / s.config.chunk_size);
+        if (last_chunk >= s.chunk_count) {
+            result.error_message = "Range not covered by stream chunks";
             return result;
         }
         
-        // Process chunks
-        size_t bytes_processed = 0;
+        // Assembled separately so output stays empty on failure
+        std::vector<uint8_t> range;
+        range.reserve(length);
+        size_t decrypted_before = s.chunks_decrypted;
         
-        for (size_t i = 0; i < chunk_count; ++i) {
-            // Read encrypted chunk size
-            uint32_t enc_size;
-            input.read(reinterpret_cast<char*>(&enc_size), 4);
-            
-            // Read encrypted data
-            std::vector<uint8_t> encrypted(enc_size);
-            input.read(reinterpret_cast<char*>(encrypted.data()), enc_size);
-            
-            // Read tag (16 bytes for GCM)
-            std::vector<uint8_t> tag(16);
-            input.read(reinterpret_cast<char*>(tag.data()), 16);
-            
-            // Generate chunk-specific nonce
-            auto chunk_nonce = derive_chunk_nonce(base_nonce, i);
-            enc_config.nonce = chunk_nonce;
-            enc_config.tag = tag;
-            
-            // Decrypt chunk
-            auto dec_result = algo->decrypt(encrypted, key, enc_config);
-            if (!dec_result.success) {
-                result.error_message = "Decryption failed at chunk " + std::to_string(i) + 
-                                       ": " + dec_result.error_message;
+        for (size_t i = first_chunk; i <= last_chunk; ++i) {
+            if (!load_chunk(i, result.error_message)) {
                 return result;
             }
             
-            // Decompress if needed
-            std::vector<uint8_t> plaintext = std::move(dec_result.data);
-            if (config.compression != CompressionType::NONE) {
-                auto decompressor = compression::CompressionService::create(config.compression);
-                if (decompressor) {
-                    auto decomp_result = decompressor->decompress(plaintext);
-                    if (decomp_result.success) {
-                        plaintext = std::move(decomp_result.data);
-                    }
-                }
-            }
-            
-            // Write decrypted data
-            output.write(reinterpret_cast<const char*>(plaintext.data()), plaintext.size());
-            
-            bytes_processed += plaintext.size();
-            result.chunks_processed++;
-            
-            // Progress callback
-            if (progress_callback) {
-                ChunkInfo info{i, plaintext.size(), chunk_count, bytes_processed, original_size};
-                if (!progress_callback(info)) {
-                    result.error_message = "Operation cancelled by user";
-                    return result;
-                }
-            }
+            // Copy the part of this chunk that overlaps the requested range
+            uint64_t chunk_start = static_cast<uint64_t>(i) * s.config.chunk_size;
+            uint64_t copy_from = (std::max)(offset, chunk_start);
+            uint64_t copy_to = (std::min)(offset + length, chunk_start + s.cached.size());
+            range.insert(range.end(),
+                          s.cached.begin() + static_cast<std::ptrdiff_t>(copy_from - chunk_start),
+                          s.cached.begin() + static_cast<std::ptrdiff_t>(copy_to - chunk_start));
         }
         
-        result.bytes_processed = bytes_processed;
+        output = std::move(range);
+        result.bytes_processed = output.size();
+        result.chunks_processed = s.chunks_decrypted - decrypted_before;
         result.success = true;
         
     } catch (const std::exception& e) {
-        result.error_message = std::string("Streaming decryption failed: ") + e.what();
+        result.error_message = std::string("Streaming range decryption failed: ") + e.what();
         return result;
     }
     
     auto end_time = std::chrono::high_resolution_clock::now();
     result.processing_time_ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
-    result.throughput_mbps = (result.bytes_processed / 1024.0 / 1024.0) / (result.processing_time_ms / 1000.0);
     
-    spdlog::info("Streaming decryption completed: {} chunks, {:.2f} MB/s", 
-                 result.chunks_processed, result.throughput_mbps);
+    SPDLOG_DEBUG("Range decryption: {} bytes from {} chunks", 
+                  result.bytes_processed, result.chunks_processed);
     
     return result;
 }
@@ -0,0 +1,356 @@
+/**
+ * @file system_resources.cpp
+ * @brief Container- and job-aware CPU and memory limits
+ */
+
+#include "filevault/core/system_resources.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <sys/types.h>
+#include <sys/sysctl.h>
+#include <mach/mach.h>
+#else
+#include <sched.h>
+#include <sys/sysinfo.h>
+#endif
+
+namespace filevault {
+namespace core {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// v1 reports "no limit" as LONG_MAX rounded down to a page
+constexpr uint64_t UNLIMITED_THRESHOLD = 1ull << 60;
+
+std::optional<std::string> read_first_line(const fs::path& path) {
+    std::ifstream in(path);
+    std::string line;
+    if (!in || !std::getline(in, line)) {
+        return std::nullopt;
+    }
+    return line;
+}
+
+std::optional<uint64_t> read_number(const fs::path& path) {
+    auto line = read_first_line(path);
+    if (!line) {
+        return std::nullopt;
+    }
+    try {
+        size_t used = 0;
+        long long value = std::stoll(*line, &used);
+        if (value < 0) {
+            return std::nullopt;
+        }
+        return static_cast<uint64_t>(value);
+    } catch (...) {
+        return std::nullopt;
+    }
+}
+
+/**
+ * @brief Directory of a cgroup under its mount, and its ancestors up to the mount
+ *
+ * Without a cgroup namespace a container sees the host's path in
+ * /proc/self/cgroup while its own cgroup is mounted at the root; the
+ * mount itself is used then.
+ */
+std::vector<fs::path> cgroup_chain(const fs::path& mount, const std::string& path) {
+    std::vector<fs::path> chain;
+    std::error_code ec;
+    if (!fs::is_directory(mount, ec)) {
+        return chain;
+    }
+    auto relative = fs::path(path).relative_path().lexically_normal();
+    fs::path dir = mount;
+    if (!relative.empty() && relative != "." && *relative.begin() != ".." &&
+        fs::is_directory(mount / relative, ec)) {
+        dir = mount / relative;
+    }
+    chain.push_back(dir);
+    while (dir != mount && dir.has_relative_path()) {
+        dir = dir.parent_path();
+        chain.push_back(dir);
+    }
+    return chain;
+}
+
+} // anonymous namespace
+
+std::optional<double> SystemResources::parse_cpu_max(const std::string& text) {
+    std::istringstream in(text);
+    std::string quota;
+    uint64_t period = 100000;
+    if (!(in >> quota) || quota == "max") {
+        return std::nullopt;
+    }
+    in >> period;
+    try {
+        double value = std::stod(quota);
+        if (value <= 0 || period == 0) {
+            return std::nullopt;
+        }
+        return value / static_cast<double>(period);
+    } catch (...) {
+        return std::nullopt;
+    }
+}
+
+std::optional<uint64_t> SystemResources::parse_memory_max(const std::string& text) {
+    if (text.rfind("max", 0) == 0) {
+        return std::nullopt;
+    }
+    try {
+        size_t used = 0;
+        unsigned long long value = std::stoull(text, &used);
+        if (used == 0 || value == 0 || value >= UNLIMITED_THRESHOLD) {
+            return std::nullopt;
+        }
+        return static_cast<uint64_t>(value);
+    } catch (...) {
+        return std::nullopt;
+    }
+}
+
+bool SystemResources::apply_cgroup(const fs::path& cgroup_root, const std::string& proc_cgroup) {
+    std::optional<double> cpu_quota;
+    std::optional<uint64_t> memory;
+    fs::path usage;
+    std::string version;
+
+    auto lower_cpu = [&cpu_quota](std::optional<double> quota) {
+        if (quota && (!cpu_quota || *quota < *cpu_quota)) {
+            cpu_quota = quota;
+        }
+    };
+    auto lower_memory = [&memory](std::optional<uint64_t> limit) {
+        if (limit && (!memory || *limit < *memory)) {
+            memory = limit;
+        }
+    };
+
+    // Lines are "id:controllers:path"; v2 has id 0 and no controllers
+    std::istringstream lines(proc_cgroup);
+    std::string line;
+    while (std::getline(lines, line)) {
+        auto first = line.find(':');
+        auto second = first == std::string::npos ? first : line.find(':', first + 1);
+        if (second == std::string::npos) {
+            continue;
+        }
+        std::string controllers = line.substr(first + 1, second - first - 1);
+        std::string path = line.substr(second + 1);
+
+        if (controllers.empty()) {
+            // A hybrid host lists the v2 hierarchy too, mounted elsewhere
+            if (!fs::exists(cgroup_root / "cgroup.controllers")) {
+                continue;
+            }
+            auto chain = cgroup_chain(cgroup_root, path);
+            for (const auto& dir : chain) {
+                if (auto text = read_first_line(dir / "cpu.max")) {
+                    lower_cpu(parse_cpu_max(*text));
+                }
+                if (auto text = read_first_line(dir / "memory.max")) {
+                    lower_memory(parse_memory_max(*text));
+                }
+            }
+            if (!chain.empty() && fs::exists(chain.front() / "memory.current")) {
+                usage = chain.front() / "memory.current";
+            }
+            version = "cgroup v2";
+            continue;
+        }
+
+        std::vector<std::string> names;
+        std::istringstream list(controllers);
+        for (std::string name; std::getline(list, name, ',');) {
+            names.push_back(name);
+        }
+        auto has = [&names](const char* name) {
+            return std::find(names.begin(), names.end(), name) != names.end();
+        };
+        if (has("cpu")) {
+            for (const char* mount : {"cpu,cpuacct", "cpu", "cpuacct,cpu"}) {
+                for (const auto& dir : cgroup_chain(cgroup_root / mount, path)) {
+                    auto quota = read_first_line(dir / "cpu.cfs_quota_us");
+                    auto period = read_number(dir / "cpu.cfs_period_us");
+                    if (quota && period && quota->front() != '-') {
+                        lower_cpu(parse_cpu_max(*quota + " " + std::to_string(*period)));
+                    }
+                }
+            }
+        }
+        if (has("memory")) {
+            auto chain = cgroup_chain(cgroup_root / "memory", path);
+            for (const auto& dir : chain) {
+                if (auto text = read_first_line(dir / "memory.limit_in_bytes")) {
+                    lower_memory(parse_memory_max(*text));
+                }
+            }
+            if (!chain.empty() && fs::exists(chain.front() / "memory.usage_in_bytes")) {
+                usage = chain.front() / "memory.usage_in_bytes";
+            }
+        }
+        if (version.empty() && (has("cpu") || has("memory"))) {
+            version = "cgroup v1";
+        }
+    }
+
+    bool limited = false;
+    if (cpu_quota) {
+        auto quota_cpus = static_cast<size_t>(std::ceil(*cpu_quota));
+        if (quota_cpus < cpus) {
+            cpus = (std::max)(quota_cpus, size_t(1));
+            limited = true;
+        }
+    }
+    if (memory && (physical_memory == 0 || *memory < physical_memory)) {
+        memory_limit = *memory;
+        memory_usage = usage;
+        limited = true;
+    }
+    if (limited) {
+        limited_by = version;
+    }
+    return limited;
+}
+
+const SystemResources& SystemResources::detect() {
+    static const SystemResources resources = [] {
+        SystemResources r;
+        r.host_cpus = (std::max)(std::thread::hardware_concurrency(), 1u);
+        r.cpus = r.host_cpus;
+
+#ifdef _WIN32
+        MEMORYSTATUSEX status;
+        status.dwLength = sizeof(status);
+        if (GlobalMemoryStatusEx(&status)) {
+            r.physical_memory = status.ullTotalPhys;
+        }
+
+        // A null handle queries the job the process runs in, if any
+        JOBOBJECT_EXTENDED_LIMIT_INFORMATION limits{};
+        if (QueryInformationJobObject(nullptr, JobObjectExtendedLimitInformation,
+                                      &limits, sizeof(limits), nullptr)) {
+            uint64_t memory = 0;
+            auto flags = limits.BasicLimitInformation.LimitFlags;
+            if (flags & JOB_OBJECT_LIMIT_PROCESS_MEMORY) {
+                memory = limits.ProcessMemoryLimit;
+            }
+            if ((flags & JOB_OBJECT_LIMIT_JOB_MEMORY) && (memory == 0 || limits.JobMemoryLimit < memory)) {
+                memory = limits.JobMemoryLimit;
+            }
+            if (memory > 0) {
+                r.memory_limit = memory;
+                r.limited_by = "job object";
+            }
+        }
+        JOBOBJECT_CPU_RATE_CONTROL_INFORMATION rate{};
+        if (QueryInformationJobObject(nullptr, JobObjectCpuRateControlInformation,
+                                      &rate, sizeof(rate), nullptr) &&
+            (rate.ControlFlags & JOB_OBJECT_CPU_RATE_CONTROL_ENABLE) &&
+            (rate.ControlFlags & JOB_OBJECT_CPU_RATE_CONTROL_HARD_CAP)) {
+            // In 1/100 of a percent of all CPUs
+            auto capped = static_cast<size_t>(std::ceil(rate.CpuRate / 10000.0 * r.host_cpus));
+            r.cpus = std::clamp(capped, size_t(1), r.host_cpus);
+            r.limited_by = "job object";
+        }
+#elif defined(__APPLE__)
+        uint64_t memsize = 0;
+        size_t length = sizeof(memsize);
+        if (sysctlbyname("hw.memsize", &memsize, &length, nullptr, 0) == 0) {
+            r.physical_memory = memsize;
+        }
+#else
+        struct sysinfo info;
+        if (sysinfo(&info) == 0) {
+            r.physical_memory = static_cast<uint64_t>(info.totalram) * info.mem_unit;
+        }
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0 && CPU_COUNT(&set) > 0) {
+            r.cpus = (std::min)(r.cpus, static_cast<size_t>(CPU_COUNT(&set)));
+        }
+        std::ifstream in("/proc/self/cgroup");
+        std::stringstream text;
+        text << in.rdbuf();
+        r.apply_cgroup("/sys/fs/cgroup", text.str());
+#endif
+
+        if (!r.limited_by.empty()) {
+            spdlog::info("Resource limits ({}): {} of {} CPUs, memory {} MB", r.limited_by, r.cpus,
+                         r.host_cpus, r.memory_limit / (1024 * 1024));
+        }
+        return r;
+    }();
+    return resources;
+}
+
+uint64_t SystemResources::effective_memory() const {
+    return memory_limit > 0 ? memory_limit : physical_memory;
+}
+
+uint64_t SystemResources::available_memory() {
+    const auto& resources = detect();
+    uint64_t available = 0;
+
+#ifdef _WIN32
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if (GlobalMemoryStatusEx(&status)) {
+        available = status.ullAvailPhys;
+    }
+#elif defined(__APPLE__)
+    mach_port_t host_port = mach_host_self();
+    vm_size_t page_size;
+    vm_statistics64_data_t vm_stats;
+    mach_msg_type_number_t count = sizeof(vm_stats) / sizeof(natural_t);
+    if (host_page_size(host_port, &page_size) == KERN_SUCCESS &&
+        host_statistics64(host_port, HOST_VM_INFO64, (host_info64_t)&vm_stats, &count) == KERN_SUCCESS) {
+        available = static_cast<uint64_t>(vm_stats.free_count) * page_size;
+    }
+#else
+    // MemAvailable counts reclaimable page cache, which freeram does not
+    std::ifstream meminfo("/proc/meminfo");
+    std::string key;
+    uint64_t kb = 0;
+    std::string unit;
+    while (meminfo >> key >> kb >> unit) {
+        if (key == "MemAvailable:") {
+            available = kb * 1024;
+            break;
+        }
+    }
+    if (available == 0) {
+        struct sysinfo info;
+        if (sysinfo(&info) == 0) {
+            available = static_cast<uint64_t>(info.freeram) * info.mem_unit;
+        }
+    }
+#endif
+
+    if (resources.memory_limit > 0) {
+        uint64_t used = 0;
+        if (!resources.memory_usage.empty()) {
+            used = read_number(resources.memory_usage).value_or(0);
+        }
+        uint64_t headroom = resources.memory_limit > used ? resources.memory_limit - used : 0;
+        available = available > 0 ? (std::min)(available, headroom) : headroom;
+    }
+    return available;
+}
+
+} // namespace core
+} // namespace filevault
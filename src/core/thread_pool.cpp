@@ -0,0 +1,92 @@
+/**
+ * @file thread_pool.cpp
+ * @brief Fixed-size worker pool implementation
+ */
+
+#include "filevault/core/thread_pool.hpp"
+#include "filevault/core/system_resources.hpp"
+#include <spdlog/spdlog.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace filevault {
+namespace core {
+
+size_t ThreadPool::default_thread_count() {
+    // CPUs the affinity mask and any cgroup/job CPU quota allow
+    return SystemResources::detect().cpus;
+}
+
+bool ThreadPool::pin_current_thread(size_t cpu) {
+    cpu %= default_thread_count();
+#ifdef _WIN32
+    if (cpu >= sizeof(DWORD_PTR) * 8) {
+        return false;
+    }
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+ThreadPool::ThreadPool(size_t thread_count) {
+    if (thread_count == 0) {
+        thread_count = default_thread_count();
+    }
+
+    workers_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_.emplace_back([this]() { worker_loop(); });
+    }
+
+    SPDLOG_DEBUG("ThreadPool started with {} workers", thread_count);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void ThreadPool::worker_loop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+
+            // Drain remaining tasks before exiting
+            if (tasks_.empty()) {
+                return;
+            }
+
+            task = std::move(tasks_.front());
+            tasks_.pop();
+        }
+
+        // Exceptions are captured by the packaged_task and rethrown on future::get()
+        task();
+    }
+}
+
+} // namespace core
+} // namespace filevault
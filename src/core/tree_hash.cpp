@@ -0,0 +1,114 @@
+/**
+ * @file tree_hash.cpp
+ * @brief Parallel Merkle-tree hashing
+ */
+
+#include "filevault/core/tree_hash.hpp"
+#include "filevault/core/thread_pool.hpp"
+#include "filevault/utils/checksum.hpp"
+#include <algorithm>
+#include <future>
+#include <stdexcept>
+
+namespace filevault {
+namespace core {
+
+namespace {
+
+constexpr uint8_t LEAF_PREFIX = 0x00;
+constexpr uint8_t NODE_PREFIX = 0x01;
+
+// Leaves per pool task, so tiny leaves do not drown in scheduling
+constexpr size_t MIN_BYTES_PER_TASK = 4 * 1024 * 1024;
+
+} // anonymous namespace
+
+TreeHash::TreeHash(std::string algorithm, size_t leaf_size)
+    : algorithm_(std::move(algorithm)), leaf_size_(leaf_size) {
+    if (leaf_size_ == 0) {
+        throw std::invalid_argument("Tree hash leaf size must be non-zero");
+    }
+    if (!utils::create_hash(algorithm_)) {
+        throw std::invalid_argument("Hash algorithm not available: " + algorithm_);
+    }
+}
+
+std::vector<uint8_t> TreeHash::leaf(std::span<const uint8_t> data) const {
+    auto hash = utils::create_hash_or_throw(algorithm_);
+    hash->update(&LEAF_PREFIX, 1);
+    hash->update(data.data(), data.size());
+    auto digest = hash->final();
+    return {digest.begin(), digest.end()};
+}
+
+std::vector<uint8_t> TreeHash::node(std::span<const uint8_t> left, std::span<const uint8_t> right) const {
+    auto hash = utils::create_hash_or_throw(algorithm_);
+    hash->update(&NODE_PREFIX, 1);
+    hash->update(left.data(), left.size());
+    hash->update(right.data(), right.size());
+    auto digest = hash->final();
+    return {digest.begin(), digest.end()};
+}
+
+std::vector<std::vector<uint8_t>> TreeHash::leaf_hashes(std::span<const uint8_t> data, size_t threads) const {
+    size_t count = std::max<size_t>((data.size() + leaf_size_ - 1) / leaf_size_, 1);
+    std::vector<std::vector<uint8_t>> leaves(count);
+    
+    auto hash_range = [&](size_t first, size_t last) {
+        // One hash object per task, reset by final()
+        auto hash = utils::create_hash_or_throw(algorithm_);
+        for (size_t i = first; i < last; ++i) {
+            size_t offset = i * leaf_size_;
+            auto slice = data.subspan(std::min(offset, data.size()),
+                                      std::min(leaf_size_, data.size() - std::min(offset, data.size())));
+            hash->update(&LEAF_PREFIX, 1);
+            hash->update(slice.data(), slice.size());
+            auto digest = hash->final();
+            leaves[i].assign(digest.begin(), digest.end());
+        }
+    };
+    
+    size_t per_task = std::max<size_t>(MIN_BYTES_PER_TASK / leaf_size_, 1);
+    if (count <= per_task || threads == 1) {
+        hash_range(0, count);
+        return leaves;
+    }
+    
+    ThreadPool pool(threads);
+    // Several tasks per worker keep them busy when leaves hash at different speeds
+    per_task = std::max(per_task, count / (pool.size() * 4));
+    std::vector<std::future<void>> tasks;
+    for (size_t first = 0; first < count; first += per_task) {
+        size_t last = std::min(first + per_task, count);
+        tasks.push_back(pool.submit([&hash_range, first, last]() { hash_range(first, last); }));
+    }
+    for (auto& task : tasks) {
+        task.get();
+    }
+    return leaves;
+}
+
+std::vector<uint8_t> TreeHash::root(std::vector<std::vector<uint8_t>> level) const {
+    if (level.empty()) {
+        return leaf({});
+    }
+    while (level.size() > 1) {
+        std::vector<std::vector<uint8_t>> parents;
+        parents.reserve((level.size() + 1) / 2);
+        for (size_t i = 0; i + 1 < level.size(); i += 2) {
+            parents.push_back(node(level[i], level[i + 1]));
+        }
+        if (level.size() % 2 == 1) {
+            parents.push_back(std::move(level.back()));
+        }
+        level = std::move(parents);
+    }
+    return std::move(level.front());
+}
+
+std::vector<uint8_t> TreeHash::hash(std::span<const uint8_t> data, size_t threads) const {
+    return root(leaf_hashes(data, threads));
+}
+
+} // namespace core
+} // namespace filevault
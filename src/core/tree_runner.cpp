@@ -0,0 +1,174 @@
+/**
+ * @file tree_runner.cpp
+ * @brief Per-file jobs over a directory tree on a worker pool
+ */
+
+#include "filevault/core/tree_runner.hpp"
+#include "filevault/core/thread_pool.hpp"
+#include "filevault/utils/trace.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+
+namespace filevault {
+namespace core {
+
+namespace {
+
+// Files per grouped task, so thousands of empty files still spread out
+constexpr size_t MAX_GROUP_FILES = 64;
+
+// Index of the file run() processes on the calling thread first
+size_t warm_file(const std::vector<TreeFile>& files) {
+    return static_cast<size_t>(std::min_element(files.begin(), files.end(),
+        [](const TreeFile& a, const TreeFile& b) { return a.size < b.size; }) - files.begin());
+}
+
+} // anonymous namespace
+
+TreePlan TreeRunner::plan(const std::vector<TreeFile>& files, const TreeRunOptions& options) {
+    TreePlan plan;
+    std::vector<size_t> group;
+    uint64_t group_bytes = 0;
+    auto flush = [&]() {
+        if (!group.empty()) {
+            plan.tasks.push_back(std::move(group));
+            group.clear();
+            group_bytes = 0;
+        }
+    };
+
+    for (size_t i = 0; i < files.size(); ++i) {
+        uint64_t size = files[i].size;
+        if (options.large_file_bytes > 0 && size >= options.large_file_bytes) {
+            plan.large.push_back(i);
+        } else if (size < options.small_file_bytes) {
+            group.push_back(i);
+            group_bytes += size;
+            if (group_bytes >= options.group_bytes || group.size() >= MAX_GROUP_FILES) {
+                flush();
+            }
+        } else {
+            plan.tasks.push_back({i});
+        }
+    }
+    flush();
+
+    auto task_bytes = [&files](const std::vector<size_t>& task) {
+        return std::accumulate(task.begin(), task.end(), uint64_t{0},
+                               [&files](uint64_t sum, size_t i) { return sum + files[i].size; });
+    };
+    std::stable_sort(plan.tasks.begin(), plan.tasks.end(),
+                     [&task_bytes](const auto& a, const auto& b) { return task_bytes(a) > task_bytes(b); });
+    std::stable_sort(plan.large.begin(), plan.large.end(),
+                     [&files](size_t a, size_t b) { return files[a].size > files[b].size; });
+    return plan;
+}
+
+std::vector<size_t> TreeRunner::schedule(const std::vector<TreeFile>& files, const TreeRunOptions& options) {
+    std::vector<size_t> order;
+    if (files.empty()) {
+        return order;
+    }
+    order.reserve(files.size());
+    auto plan = TreeRunner::plan(files, options);
+    auto warm = warm_file(files);
+    order.push_back(warm);
+    for (const auto& task : plan.tasks) {
+        std::copy_if(task.begin(), task.end(), std::back_inserter(order), [warm](size_t i) { return i != warm; });
+    }
+    std::copy_if(plan.large.begin(), plan.large.end(), std::back_inserter(order),
+                 [warm](size_t i) { return i != warm; });
+    return order;
+}
+
+TreeRunResult TreeRunner::run(const std::vector<TreeFile>& files, const Job& job,
+                              const TreeRunOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+    TreeRunResult result;
+    if (files.empty()) {
+        return result;
+    }
+
+    size_t workers = options.workers > 0 ? options.workers : ThreadPool::default_thread_count();
+    uint64_t total = std::accumulate(files.begin(), files.end(), uint64_t{0},
+                                     [](uint64_t sum, const TreeFile& file) { return sum + file.size; });
+    utils::ScopedSpan trace_span("TreeRunner::run", "tree", total);
+
+    std::mutex mutex;   // Guards result
+
+    auto process = [&](const TreeFile& file, size_t threads) {
+        // A job may report from its own threads; only increases count
+        std::atomic<uint64_t> reported{0};
+        Advance advance = [&](uint64_t bytes) {
+            bytes = std::min(bytes, file.size);
+            uint64_t previous = reported.load(std::memory_order_relaxed);
+            while (bytes > previous && !reported.compare_exchange_weak(previous, bytes, std::memory_order_relaxed)) {
+            }
+            if (bytes > previous && options.on_advance) {
+                options.on_advance(bytes - previous);
+            }
+        };
+
+        std::string error;
+        try {
+            std::error_code ec;
+            if (file.target.has_parent_path()) {
+                std::filesystem::create_directories(file.target.parent_path(), ec);
+            }
+            error = ec ? "cannot create " + file.target.parent_path().string() + ": " + ec.message()
+                       : job(file, threads, advance);
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+        advance(file.size);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (error.empty()) {
+            ++result.succeeded;
+            result.bytes += file.size;
+        } else {
+            result.errors.push_back(file.source.string() + ": " + error);
+        }
+    };
+
+    auto plan = TreeRunner::plan(files, options);
+    auto warm = warm_file(files);
+    process(files[warm], 1);
+
+    {
+        ThreadPool pool(workers);
+        std::vector<std::future<void>> pending;
+        pending.reserve(plan.tasks.size());
+        for (const auto& task : plan.tasks) {
+            pending.push_back(pool.submit([&process, &files, &task, warm]() {
+                for (size_t i : task) {
+                    if (i != warm) {
+                        process(files[i], 1);
+                    }
+                }
+            }));
+        }
+        for (auto& future : pending) {
+            future.get();
+        }
+    }
+
+    // Jobs that parallelize within a file get the whole machine each
+    for (size_t i : plan.large) {
+        if (i != warm) {
+            process(files[i], workers);
+        }
+    }
+
+    std::sort(result.errors.begin(), result.errors.end());
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+} // namespace core
+} // namespace filevault
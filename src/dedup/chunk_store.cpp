@@ -0,0 +1,636 @@
+/**
+ * @file chunk_store.cpp
+ * @brief Encrypted content-addressed chunk store
+ */
+
+#include "filevault/dedup/chunk_store.hpp"
+#include "filevault/compression/compressor.hpp"
+#include "filevault/core/algorithm_traits.hpp"
+#include "filevault/core/checkout_cache.hpp"
+#include "filevault/core/crypto_engine.hpp"
+#include "filevault/core/streaming.hpp"
+#include "filevault/core/thread_pool.hpp"
+#include <botan/mac.h>
+#include <botan/mem_ops.h>
+#include <fmt/core.h>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <mutex>
+#include <set>
+
+namespace filevault {
+namespace dedup {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr const char* CONFIG_FILE = "store.fvcs";
+constexpr const char* CHUNK_DIR = "chunks";
+constexpr uint8_t STORE_MAGIC[4] = {'F', 'V', 'C', 'S'};
+constexpr uint8_t MANIFEST_MAGIC[4] = {'F', 'V', 'D', 'M'};
+constexpr uint8_t FORMAT_VERSION = 1;
+
+constexpr size_t SALT_SIZE = 32;
+constexpr size_t MAC_SIZE = 32;
+constexpr size_t NONCE_SIZE = 12;
+constexpr size_t TAG_SIZE = 16;
+
+// Chunk file: [flags][nonce][ciphertext][tag]
+constexpr uint8_t FLAG_COMPRESSED = 0x01;
+constexpr size_t CHUNK_OVERHEAD = 1 + NONCE_SIZE + TAG_SIZE;
+
+// Manifest: [magic][version][original size][count] then [id][size] per chunk, then a MAC
+constexpr size_t MANIFEST_HEADER_SIZE = 4 + 1 + 8 + 4;
+constexpr size_t MANIFEST_ENTRY_SIZE = 32 + 4;
+
+// Chunks in flight per worker, enough to cover read and write stalls
+constexpr size_t PENDING_PER_WORKER = 2;
+
+void put_u32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+void put_u64(std::vector<uint8_t>& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+uint32_t get_u32(const uint8_t* data) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(data[i]) << (8 * i);
+    }
+    return value;
+}
+
+uint64_t get_u64(const uint8_t* data) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value |= static_cast<uint64_t>(data[i]) << (8 * i);
+    }
+    return value;
+}
+
+std::vector<uint8_t> hmac(std::span<const uint8_t> key, std::span<const uint8_t> data) {
+    auto mac = Botan::MessageAuthenticationCode::create_or_throw("HMAC(SHA-256)");
+    mac->set_key(key.data(), key.size());
+    mac->update(data.data(), data.size());
+    std::vector<uint8_t> out(MAC_SIZE);
+    mac->final(out.data());
+    return out;
+}
+
+/**
+ * @brief Independent subkey of the master key for one purpose
+ */
+std::vector<uint8_t> subkey(const std::vector<uint8_t>& master, const std::string& label) {
+    std::string info = "filevault-dedup " + label;
+    return hmac(master, {reinterpret_cast<const uint8_t*>(info.data()), info.size()});
+}
+
+/**
+ * @brief Associated data binding a chunk's ID and flags to its tag
+ *
+ * A chunk file renamed to another ID, or with its compressed flag
+ * flipped, fails authentication.
+ */
+std::vector<uint8_t> chunk_associated_data(const ChunkId& id, uint8_t flags) {
+    std::vector<uint8_t> data(id.begin(), id.end());
+    data.push_back(flags);
+    return data;
+}
+
+bool write_atomically(const fs::path& path, std::span<const uint8_t> head, std::span<const uint8_t> body,
+                      std::span<const uint8_t> tail) {
+    // A half-written chunk must never be found under its ID
+    auto temp_path = path;
+    temp_path += ".tmp";
+    std::error_code ec;
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        for (auto part : {head, body, tail}) {
+            file.write(reinterpret_cast<const char*>(part.data()), static_cast<std::streamsize>(part.size()));
+        }
+        if (!file) {
+            file.close();
+            fs::remove(temp_path, ec);
+            return false;
+        }
+    }
+    fs::rename(temp_path, path, ec);
+    if (ec) {
+        fs::remove(temp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Result of storing or loading one chunk on a worker
+ */
+struct ChunkTask {
+    ChunkRef ref;
+    bool is_new = false;
+    uint64_t stored_bytes = 0;
+    std::vector<uint8_t> data;      // Restored plaintext
+    std::string error_message;
+};
+
+} // anonymous namespace
+
+ChunkStore::ChunkStore(fs::path directory)
+    : directory_(std::move(directory)) {}
+
+ChunkStore::~ChunkStore() {
+    for (auto* key : {&id_key_, &chunk_key_, &manifest_key_}) {
+        Botan::secure_scrub_memory(key->data(), key->size());
+    }
+}
+
+bool ChunkStore::exists(const fs::path& directory) {
+    std::error_code ec;
+    return fs::is_regular_file(directory / CONFIG_FILE, ec);
+}
+
+std::string ChunkStore::format_id(const ChunkId& id) {
+    std::string hex;
+    hex.reserve(id.size() * 2);
+    for (uint8_t byte : id) {
+        hex += fmt::format("{:02x}", byte);
+    }
+    return hex;
+}
+
+fs::path ChunkStore::path_for(const ChunkId& id) const {
+    auto hex = format_id(id);
+    return directory_ / CHUNK_DIR / hex.substr(0, 2) / hex;
+}
+
+bool ChunkStore::contains(const ChunkId& id) const {
+    std::error_code ec;
+    return fs::exists(path_for(id), ec);
+}
+
+ChunkId ChunkStore::chunk_id(std::span<const uint8_t> chunk) const {
+    auto mac = hmac(id_key_, chunk);
+    ChunkId id{};
+    std::memcpy(id.data(), mac.data(), id.size());
+    return id;
+}
+
+std::vector<uint8_t> ChunkStore::derive_keys(const std::string& password, const std::vector<uint8_t>& salt) {
+    core::CryptoEngine engine;
+    engine.initialize();
+    auto* algo = engine.get_algorithm(config_.algorithm);
+    if (!algo) {
+        return {};
+    }
+
+    core::EncryptionConfig enc_config;
+    enc_config.algorithm = config_.algorithm;
+    enc_config.kdf = config_.kdf;
+    enc_config.level = config_.level;
+    enc_config.apply_security_level();
+    auto master = engine.derive_key(password, salt, enc_config);
+
+    id_key_ = subkey(master, "chunk-id");
+    chunk_key_ = subkey(master, "chunk-key");
+    chunk_key_.resize(algo->key_size());
+    manifest_key_ = subkey(master, "manifest");
+    auto check = subkey(master, "key-check");
+    Botan::secure_scrub_memory(master.data(), master.size());
+    return check;
+}
+
+core::Result<void> ChunkStore::create(const std::string& password, const StoreConfig& config) {
+    if (exists(directory_)) {
+        return core::Result<void>::error("A chunk store already exists in " + directory_.string());
+    }
+    if (!core::StreamingCrypto::supports_algorithm(config.algorithm)) {
+        return core::Result<void>::error("Chunk stores support AEAD algorithms only");
+    }
+    if (core::algorithm_traits(config.algorithm).nonce_size != NONCE_SIZE) {
+        return core::Result<void>::error("Chunk stores need an AEAD with a 96-bit nonce");
+    }
+    if (!config.chunking.valid()) {
+        return core::Result<void>::error("Chunk sizes must satisfy 64B <= min < average < max <= 64MB");
+    }
+
+    config_ = config;
+    config_.chunking.avg_size = ContentChunker(config.chunking).params().avg_size;
+    auto salt = core::CryptoEngine::generate_salt(SALT_SIZE);
+    auto check = derive_keys(password, salt);
+    if (check.empty()) {
+        return core::Result<void>::error("Algorithm not available");
+    }
+
+    std::vector<uint8_t> header(STORE_MAGIC, STORE_MAGIC + 4);
+    header.push_back(FORMAT_VERSION);
+    header.push_back(static_cast<uint8_t>(config_.algorithm));
+    header.push_back(static_cast<uint8_t>(config_.kdf));
+    header.push_back(static_cast<uint8_t>(config_.level));
+    header.push_back(static_cast<uint8_t>(config_.compression));
+    header.push_back(static_cast<uint8_t>(config_.compression_level));
+    put_u32(header, config_.chunking.min_size);
+    put_u32(header, config_.chunking.avg_size);
+    put_u32(header, config_.chunking.max_size);
+    header.push_back(static_cast<uint8_t>(salt.size()));
+    header.insert(header.end(), salt.begin(), salt.end());
+
+    std::error_code ec;
+    fs::create_directories(directory_ / CHUNK_DIR, ec);
+    if (ec || !write_atomically(directory_ / CONFIG_FILE, header, check, {})) {
+        return core::Result<void>::error("Cannot write chunk store in " + directory_.string());
+    }
+    return core::Result<void>::ok();
+}
+
+core::Result<void> ChunkStore::open() {
+    std::ifstream file(directory_ / CONFIG_FILE, std::ios::binary);
+    if (!file) {
+        return core::Result<void>::error("No chunk store in " + directory_.string());
+    }
+    std::vector<uint8_t> data{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+
+    constexpr size_t FIXED_SIZE = 4 + 1 + 5 + 12 + 1;
+    if (data.size() < FIXED_SIZE || std::memcmp(data.data(), STORE_MAGIC, 4) != 0) {
+        return core::Result<void>::error("Not a chunk store: " + directory_.string());
+    }
+    if (data[4] != FORMAT_VERSION) {
+        return core::Result<void>::error(fmt::format("Unsupported chunk store version {}", data[4]));
+    }
+
+    StoreConfig config;
+    config.algorithm = static_cast<core::AlgorithmType>(data[5]);
+    config.kdf = static_cast<core::KDFType>(data[6]);
+    config.level = static_cast<core::SecurityLevel>(data[7]);
+    config.compression = static_cast<core::CompressionType>(data[8]);
+    config.compression_level = static_cast<int8_t>(data[9]);
+    config.chunking.min_size = get_u32(&data[10]);
+    config.chunking.avg_size = get_u32(&data[14]);
+    config.chunking.max_size = get_u32(&data[18]);
+    size_t salt_size = data[22];
+    if (data.size() != FIXED_SIZE + salt_size + MAC_SIZE || !config.chunking.valid()) {
+        return core::Result<void>::error("Chunk store configuration is corrupt");
+    }
+
+    config_ = config;
+    salt_.assign(data.begin() + FIXED_SIZE, data.begin() + FIXED_SIZE + salt_size);
+    key_check_.assign(data.end() - MAC_SIZE, data.end());
+    return core::Result<void>::ok();
+}
+
+core::Result<void> ChunkStore::unlock(const std::string& password) {
+    auto opened = open();
+    if (!opened) {
+        return opened;
+    }
+    auto check = derive_keys(password, salt_);
+    if (check.empty() || !Botan::constant_time_compare(check.data(), key_check_.data(), MAC_SIZE)) {
+        id_key_.clear();
+        chunk_key_.clear();
+        manifest_key_.clear();
+        return core::Result<void>::error(check.empty() ? "Algorithm not available"
+                                                       : "Wrong password for chunk store");
+    }
+    return core::Result<void>::ok();
+}
+
+core::Result<Manifest> ChunkStore::backup(std::istream& input, BackupStats& stats, size_t threads) {
+    if (!unlocked()) {
+        return core::Result<Manifest>::error("Chunk store is locked");
+    }
+
+    core::CryptoEngine engine;
+    engine.initialize();
+    auto* algo = engine.get_algorithm(config_.algorithm);
+    if (!algo) {
+        return core::Result<Manifest>::error("Algorithm not available");
+    }
+    core::CheckoutCache<core::ICipherSession> sessions([&]() { return algo->create_session(chunk_key_); });
+    core::CheckoutCache<compression::ICompressor> compressors([this]() {
+        return compression::CompressionService::create(config_.compression);
+    });
+
+    // Two chunks of one run can share an ID; only the first one writes it
+    std::mutex claimed_mutex;
+    std::set<ChunkId> claimed;
+    std::atomic<bool> failed{false};
+
+    auto store_chunk = [&](std::vector<uint8_t> data) -> ChunkTask {
+        ChunkTask task;
+        task.ref.size = static_cast<uint32_t>(data.size());
+        if (failed.load(std::memory_order_relaxed)) {
+            return task;
+        }
+        task.ref.id = chunk_id(data);
+        {
+            std::lock_guard<std::mutex> lock(claimed_mutex);
+            if (!claimed.insert(task.ref.id).second) {
+                return task;
+            }
+        }
+        if (contains(task.ref.id)) {
+            return task;
+        }
+
+        uint8_t flags = 0;
+        if (config_.compression != core::CompressionType::NONE &&
+            !compression::CompressionService::likely_incompressible(data)) {
+            auto compressor = compressors.acquire();
+            auto compressed = compressor->compress(data, config_.compression_level);
+            compressors.release(std::move(compressor));
+            if (compressed.success && compressed.data.size() < data.size()) {
+                data = std::move(compressed.data);
+                flags |= FLAG_COMPRESSED;
+            }
+        }
+
+        core::EncryptionConfig chunk_config;
+        chunk_config.algorithm = config_.algorithm;
+        chunk_config.nonce = core::CryptoEngine::generate_nonce(NONCE_SIZE);
+        chunk_config.associated_data = chunk_associated_data(task.ref.id, flags);
+
+        auto session = sessions.acquire();
+        if (!session) {
+            task.error_message = "Failed to create cipher session";
+            return task;
+        }
+        auto sealed = session->encrypt_in_place(data, chunk_config);
+        sessions.release(std::move(session));
+        if (!sealed.success || !sealed.tag || sealed.tag->size() != TAG_SIZE) {
+            task.error_message = sealed.success ? "Unexpected tag size" : sealed.error_message;
+            return task;
+        }
+
+        std::vector<uint8_t> head{flags};
+        head.insert(head.end(), chunk_config.nonce->begin(), chunk_config.nonce->end());
+        auto path = path_for(task.ref.id);
+        std::error_code ec;
+        fs::create_directories(path.parent_path(), ec);
+        if (!write_atomically(path, head, data, *sealed.tag)) {
+            task.error_message = "Cannot write chunk: " + path.string();
+            return task;
+        }
+        task.is_new = true;
+        task.stored_bytes = CHUNK_OVERHEAD + data.size();
+        return task;
+    };
+
+    ContentChunker chunker(config_.chunking);
+    const size_t max_size = config_.chunking.max_size;
+    Manifest manifest;
+    std::string error;
+
+    core::ThreadPool pool(threads);
+    std::deque<std::future<ChunkTask>> pending;
+    auto collect = [&]() {
+        auto task = pending.front().get();
+        pending.pop_front();
+        if (!task.error_message.empty() && error.empty()) {
+            error = task.error_message;
+            failed = true;
+        }
+        manifest.chunks.push_back(task.ref);
+        stats.chunks++;
+        stats.bytes += task.ref.size;
+        if (task.is_new) {
+            stats.new_chunks++;
+            stats.new_bytes += task.ref.size;
+            stats.stored_bytes += task.stored_bytes;
+        }
+    };
+
+    // Cutting needs max_size bytes of look-ahead; refill once less is left
+    std::vector<uint8_t> window;
+    size_t start = 0;
+    bool eof = false;
+    while (error.empty()) {
+        if (!eof && window.size() - start < max_size) {
+            window.erase(window.begin(), window.begin() + static_cast<std::ptrdiff_t>(start));
+            start = 0;
+            size_t filled = window.size();
+            window.resize(filled + max_size);
+            input.read(reinterpret_cast<char*>(window.data() + filled), static_cast<std::streamsize>(max_size));
+            window.resize(filled + static_cast<size_t>(input.gcount()));
+            if (input.bad()) {
+                error = "Failed to read input";
+                break;
+            }
+            eof = input.eof();
+        }
+        if (start == window.size()) {
+            if (eof) {
+                break;
+            }
+            continue;
+        }
+
+        size_t length = chunker.next_boundary(std::span<const uint8_t>(window).subspan(start));
+        std::vector<uint8_t> chunk(window.begin() + static_cast<std::ptrdiff_t>(start),
+                                   window.begin() + static_cast<std::ptrdiff_t>(start + length));
+        start += length;
+        pending.push_back(pool.submit([&store_chunk, chunk = std::move(chunk)]() mutable {
+            return store_chunk(std::move(chunk));
+        }));
+        while (pending.size() >= pool.size() * PENDING_PER_WORKER) {
+            collect();
+        }
+    }
+    while (!pending.empty()) {
+        collect();
+    }
+
+    if (!error.empty()) {
+        return core::Result<Manifest>::error(error);
+    }
+    manifest.original_size = stats.bytes;
+    return core::Result<Manifest>::ok(std::move(manifest));
+}
+
+core::Result<void> ChunkStore::restore(const Manifest& manifest, std::ostream& output, size_t threads) {
+    if (!unlocked()) {
+        return core::Result<void>::error("Chunk store is locked");
+    }
+
+    core::CryptoEngine engine;
+    engine.initialize();
+    auto* algo = engine.get_algorithm(config_.algorithm);
+    if (!algo) {
+        return core::Result<void>::error("Algorithm not available");
+    }
+    core::CheckoutCache<core::ICipherSession> sessions([&]() { return algo->create_session(chunk_key_); });
+    core::CheckoutCache<compression::ICompressor> decompressors([this]() {
+        return compression::CompressionService::create(config_.compression);
+    });
+    std::atomic<bool> failed{false};
+
+    auto open_chunk = [&](const ChunkRef& ref) -> ChunkTask {
+        ChunkTask task;
+        task.ref = ref;
+        if (failed.load(std::memory_order_relaxed)) {
+            return task;
+        }
+        auto path = path_for(ref.id);
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            task.error_message = "Chunk missing from store: " + format_id(ref.id);
+            return task;
+        }
+        std::vector<uint8_t> stored{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        if (stored.size() < CHUNK_OVERHEAD) {
+            task.error_message = "Chunk file is truncated: " + path.string();
+            return task;
+        }
+
+        uint8_t flags = stored[0];
+        core::EncryptionConfig chunk_config;
+        chunk_config.algorithm = config_.algorithm;
+        chunk_config.nonce = core::ShortBytes(stored.begin() + 1, stored.begin() + 1 + NONCE_SIZE);
+        chunk_config.tag = core::ShortBytes(stored.end() - TAG_SIZE, stored.end());
+        chunk_config.associated_data = chunk_associated_data(ref.id, flags);
+        std::vector<uint8_t> data(stored.begin() + 1 + NONCE_SIZE, stored.end() - TAG_SIZE);
+
+        auto session = sessions.acquire();
+        if (!session) {
+            task.error_message = "Failed to create cipher session";
+            return task;
+        }
+        auto opened = session->decrypt_in_place(data, chunk_config);
+        sessions.release(std::move(session));
+        if (!opened.success) {
+            task.error_message = "Chunk failed authentication: " + format_id(ref.id);
+            return task;
+        }
+
+        if (flags & FLAG_COMPRESSED) {
+            auto decompressor = decompressors.acquire();
+            auto expanded = decompressor->decompress(data, ref.size);
+            decompressors.release(std::move(decompressor));
+            if (!expanded.success) {
+                task.error_message = "Cannot decompress chunk " + format_id(ref.id) + ": " + expanded.error_message;
+                return task;
+            }
+            data = std::move(expanded.data);
+        }
+        if (data.size() != ref.size || chunk_id(data) != ref.id) {
+            task.error_message = "Chunk does not match its ID: " + format_id(ref.id);
+            return task;
+        }
+        task.data = std::move(data);
+        return task;
+    };
+
+    core::ThreadPool pool(threads);
+    std::deque<std::future<ChunkTask>> pending;
+    std::string error;
+    auto collect = [&]() {
+        auto task = pending.front().get();
+        pending.pop_front();
+        if (!error.empty()) {
+            return;
+        }
+        if (!task.error_message.empty()) {
+            error = task.error_message;
+            failed = true;
+            return;
+        }
+        output.write(reinterpret_cast<const char*>(task.data.data()), static_cast<std::streamsize>(task.data.size()));
+        if (!output) {
+            error = "Failed to write output";
+            failed = true;
+        }
+    };
+
+    for (const auto& ref : manifest.chunks) {
+        if (!error.empty()) {
+            break;
+        }
+        pending.push_back(pool.submit([&open_chunk, ref]() { return open_chunk(ref); }));
+        while (pending.size() >= pool.size() * PENDING_PER_WORKER) {
+            collect();
+        }
+    }
+    while (!pending.empty()) {
+        collect();
+    }
+
+    if (!error.empty()) {
+        return core::Result<void>::error(error);
+    }
+    return core::Result<void>::ok();
+}
+
+std::vector<uint8_t> ChunkStore::serialize_manifest(const Manifest& manifest) const {
+    std::vector<uint8_t> data(MANIFEST_MAGIC, MANIFEST_MAGIC + 4);
+    data.reserve(MANIFEST_HEADER_SIZE + manifest.chunks.size() * MANIFEST_ENTRY_SIZE + MAC_SIZE);
+    data.push_back(FORMAT_VERSION);
+    put_u64(data, manifest.original_size);
+    put_u32(data, static_cast<uint32_t>(manifest.chunks.size()));
+    for (const auto& ref : manifest.chunks) {
+        data.insert(data.end(), ref.id.begin(), ref.id.end());
+        put_u32(data, ref.size);
+    }
+    auto mac = hmac(manifest_key_, data);
+    data.insert(data.end(), mac.begin(), mac.end());
+    return data;
+}
+
+core::Result<Manifest> ChunkStore::parse_manifest(std::span<const uint8_t> data) const {
+    if (data.size() < MANIFEST_HEADER_SIZE + MAC_SIZE || std::memcmp(data.data(), MANIFEST_MAGIC, 4) != 0) {
+        return core::Result<Manifest>::error("Not a backup manifest");
+    }
+    if (data[4] != FORMAT_VERSION) {
+        return core::Result<Manifest>::error(fmt::format("Unsupported manifest version {}", data[4]));
+    }
+
+    Manifest manifest;
+    manifest.original_size = get_u64(&data[5]);
+    uint64_t count = get_u32(&data[13]);
+    if (data.size() != MANIFEST_HEADER_SIZE + count * MANIFEST_ENTRY_SIZE + MAC_SIZE) {
+        return core::Result<Manifest>::error("Backup manifest is truncated");
+    }
+    auto body = data.first(data.size() - MAC_SIZE);
+    auto mac = hmac(manifest_key_, body);
+    if (!Botan::constant_time_compare(mac.data(), data.data() + body.size(), MAC_SIZE)) {
+        return core::Result<Manifest>::error("Backup manifest failed authentication (wrong store or modified)");
+    }
+
+    uint64_t total = 0;
+    manifest.chunks.resize(static_cast<size_t>(count));
+    const uint8_t* entry = data.data() + MANIFEST_HEADER_SIZE;
+    for (auto& ref : manifest.chunks) {
+        std::memcpy(ref.id.data(), entry, ref.id.size());
+        ref.size = get_u32(entry + ref.id.size());
+        total += ref.size;
+        entry += MANIFEST_ENTRY_SIZE;
+    }
+    if (total != manifest.original_size) {
+        return core::Result<Manifest>::error("Backup manifest chunk sizes do not add up");
+    }
+    return core::Result<Manifest>::ok(std::move(manifest));
+}
+
+StoreUsage ChunkStore::usage() const {
+    StoreUsage usage;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(directory_ / CHUNK_DIR, ec), end; !ec && it != end; it.increment(ec)) {
+        std::error_code size_ec;
+        if (it->is_regular_file(size_ec) && it->path().extension() != ".tmp") {
+            usage.chunks++;
+            usage.bytes += it->file_size(size_ec);
+        }
+    }
+    return usage;
+}
+
+} // namespace dedup
+} // namespace filevault
@@ -0,0 +1,96 @@
+/**
+ * @file chunker.cpp
+ * @brief FastCDC content-defined chunking
+ */
+
+#include "filevault/dedup/chunker.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+
+namespace filevault {
+namespace dedup {
+
+namespace {
+
+constexpr uint32_t MIN_CHUNK_LIMIT = 64;
+constexpr uint32_t MAX_CHUNK_LIMIT = 64 * 1024 * 1024;
+
+/**
+ * @brief Gear table: one pseudo-random 64-bit value per byte
+ *
+ * Generated with splitmix64 from a fixed seed. Boundaries depend on it, so
+ * changing it would stop new backups deduplicating against old chunks.
+ */
+constexpr std::array<uint64_t, 256> make_gear_table() {
+    std::array<uint64_t, 256> table{};
+    uint64_t state = 0x46564443'44454455ull;  // "FVDCDEDU"
+    for (auto& value : table) {
+        state += 0x9e3779b97f4a7c15ull;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        value = z ^ (z >> 31);
+    }
+    return table;
+}
+
+constexpr auto GEAR = make_gear_table();
+
+// The shift-add hash mixes new bytes into the high bits, so masks test those
+constexpr uint64_t top_bits(unsigned bits) {
+    return bits == 0 ? 0 : ~uint64_t(0) << (64 - bits);
+}
+
+} // anonymous namespace
+
+bool ChunkerParams::valid() const {
+    return min_size >= MIN_CHUNK_LIMIT && min_size < avg_size && avg_size < max_size &&
+           max_size <= MAX_CHUNK_LIMIT;
+}
+
+ContentChunker::ContentChunker(const ChunkerParams& params)
+    : params_(params) {
+    params_.avg_size = std::bit_floor(params_.avg_size);
+    unsigned bits = static_cast<unsigned>(std::countr_zero(params_.avg_size));
+    mask_small_ = top_bits(bits + 1);
+    mask_large_ = top_bits(bits > 1 ? bits - 1 : 1);
+}
+
+size_t ContentChunker::next_boundary(std::span<const uint8_t> data) const {
+    size_t limit = std::min<size_t>(data.size(), params_.max_size);
+    if (limit <= params_.min_size) {
+        return limit;
+    }
+    size_t normal = std::min<size_t>(limit, params_.avg_size);
+    
+    uint64_t hash = 0;
+    size_t i = params_.min_size;
+    for (; i < normal; ++i) {
+        hash = (hash << 1) + GEAR[data[i]];
+        if ((hash & mask_small_) == 0) {
+            return i + 1;
+        }
+    }
+    for (; i < limit; ++i) {
+        hash = (hash << 1) + GEAR[data[i]];
+        if ((hash & mask_large_) == 0) {
+            return i + 1;
+        }
+    }
+    return limit;
+}
+
+std::vector<size_t> ContentChunker::split(std::span<const uint8_t> data) const {
+    std::vector<size_t> lengths;
+    size_t offset = 0;
+    while (offset < data.size()) {
+        size_t length = next_boundary(data.subspan(offset));
+        lengths.push_back(length);
+        offset += length;
+    }
+    return lengths;
+}
+
+} // namespace dedup
+} // namespace filevault
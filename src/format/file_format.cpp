@@ -1,11 +1,46 @@
 #include "filevault/core/file_format.hpp"
+#include "filevault/core/algorithm_traits.hpp"
+#include "filevault/core/header_codec.hpp"
+#include "filevault/utils/file_io.hpp"
+#include "filevault/utils/io_backend.hpp"
+#include "filevault/utils/trace.hpp"
+#include <botan/kdf.h>
+#include <botan/mem_ops.h>
+#include <algorithm>
 #include <fstream>
 #include <cstring>
 #include <stdexcept>
+#include <tuple>
 
 namespace filevault {
 namespace core {
 
+// Bits of the header's compressed flag byte
+static constexpr uint8_t COMPRESSED_FLAG = 0x01;
+static constexpr uint8_t DICTIONARY_FLAG = 0x02;
+static constexpr uint8_t KEY_CHECK_FLAG = 0x04;
+
+// HKDF label of the key check value
+static constexpr char KEY_CHECK_LABEL[] = "FileVault key check";
+
+// Header bytes read_header() fetches first; covers every header FileVault writes
+static constexpr size_t HEADER_READ_SIZE = 512;
+
+// Fixed fields before the KDF parameters: magic..reserved, salt, length prefix
+static constexpr size_t HEADER_FIXED_SIZE = 16 + 32 + 4;
+
+// Upper bound on KDF parameters in a well-formed header
+static constexpr uint32_t MAX_KDF_PARAMS_SIZE = 4096;
+
+// Stack buffer for serializing a header: fixed fields, salt and nonce of
+// up to 255 bytes, KDF parameters, the flag byte, dictionary ID and key check
+static constexpr size_t HEADER_MAX_SIZE = 16 + 255 + 4 + MAX_KDF_PARAMS_SIZE + 1 + 255 + 1 + 4 + KEY_CHECK_SIZE;
+
+// "FVLT" files: magic as a little-endian integer, and their major version
+static constexpr uint32_t LEGACY_MAGIC = 0x544C5646;
+static constexpr uint8_t LEGACY_VERSION_MAJOR = 1;
+static constexpr size_t LEGACY_MIN_HEADER_SIZE = 64;
+
 // ============================================================================
 // Argon2Params
 // ============================================================================
@@ -94,121 +129,248 @@ size_t FileHeader::size() const {
            kdf_params.size() +
            1 +  // nonce size byte
            nonce.size() +
-           1;   // compressed flag
+           1 +  // compressed flag
+           (dictionary_id != 0 ? 4 : 0) +
+           key_check.size();
 }
 
-std::vector<uint8_t> FileHeader::serialize() const {
-    std::vector<uint8_t> data;
-    data.reserve(size());
-    
-    // Magic bytes
-    data.insert(data.end(), magic, magic + 8);
-    
-    // Version
-    data.push_back(version_major);
-    data.push_back(version_minor);
+void FileHeader::set_dictionary_id(uint32_t id) {
+    dictionary_id = id;
+    if (id != 0) {
+        version_minor = std::max(version_minor, FILE_FORMAT_VERSION_MINOR_DICTIONARY);
+    }
+}
+
+void FileHeader::set_key_check(std::span<const uint8_t> key) {
+    key_check = compute_key_check(key);
+    version_minor = std::max(version_minor, FILE_FORMAT_VERSION_MINOR_KEY_CHECK);
+}
+
+bool FileHeader::matches_key(std::span<const uint8_t> key) const {
+    if (key_check.empty()) {
+        return true;
+    }
+    auto expected = compute_key_check(key);
+    return key_check.size() == expected.size() &&
+           Botan::constant_time_compare(key_check.data(), expected.data(), expected.size());
+}
+
+std::vector<uint8_t> FileHeader::compute_key_check(std::span<const uint8_t> key) {
+    auto hkdf = Botan::KDF::create_or_throw("HKDF(SHA-256)");
+    std::vector<uint8_t> check(KEY_CHECK_SIZE);
+    hkdf->derive_key(check, key, std::span<const uint8_t>(),
+                     std::span(reinterpret_cast<const uint8_t*>(KEY_CHECK_LABEL), sizeof(KEY_CHECK_LABEL) - 1));
+    return check;
+}
+
+namespace {
+
+/**
+ * @brief Append the header's fields to a writer, in file order
+ */
+template<size_t Capacity>
+void encode_header(const FileHeader& header, HeaderWriter<Capacity>& out) {
+    // Magic bytes and version
+    out.bytes(std::span<const uint8_t>(header.magic, 8));
+    out.u8(header.version_major);
+    out.u8(header.version_minor);
     
     // Algorithm, KDF, Compression
-    data.push_back(static_cast<uint8_t>(algorithm));
-    data.push_back(static_cast<uint8_t>(kdf));
-    data.push_back(static_cast<uint8_t>(compression));
+    out.u8(static_cast<uint8_t>(header.algorithm));
+    out.u8(static_cast<uint8_t>(header.kdf));
+    out.u8(static_cast<uint8_t>(header.compression));
     
     // Reserved
-    data.insert(data.end(), reserved, reserved + 3);
-    
-    // Salt
-    data.insert(data.end(), salt.begin(), salt.end());
+    out.bytes(std::span<const uint8_t>(header.reserved, 3));
     
-    // KDF params (length-prefixed)
-    uint32_t kdf_params_len = static_cast<uint32_t>(kdf_params.size());
-    uint8_t len_bytes[4];
-    std::memcpy(len_bytes, &kdf_params_len, 4);
-    data.insert(data.end(), len_bytes, len_bytes + 4);
-    data.insert(data.end(), kdf_params.begin(), kdf_params.end());
+    // Salt, then KDF params (length-prefixed)
+    out.bytes(header.salt);
+    out.u32(static_cast<uint32_t>(header.kdf_params.size()));
+    out.bytes(header.kdf_params);
     
     // Nonce (size-prefixed: 1 byte for size, then nonce data)
-    uint8_t nonce_size = static_cast<uint8_t>(nonce.size());
-    data.push_back(nonce_size);
-    data.insert(data.end(), nonce.begin(), nonce.end());
+    out.u8(static_cast<uint8_t>(header.nonce.size()));
+    out.bytes(header.nonce);
     
-    // Compressed flag
-    data.push_back(compressed ? 0x01 : 0x00);
-    
-    return data;
+    // Compressed flag, then the dictionary ID if one was used, then the key check
+    uint8_t flag = header.compressed ? COMPRESSED_FLAG : 0x00;
+    if (header.compressed && header.dictionary_id != 0) {
+        flag |= DICTIONARY_FLAG;
+    }
+    if (!header.key_check.empty()) {
+        flag |= KEY_CHECK_FLAG;
+    }
+    out.u8(flag);
+    if (flag & DICTIONARY_FLAG) {
+        out.u32(header.dictionary_id);
+    }
+    out.bytes(header.key_check);
 }
 
-std::pair<FileHeader, size_t> FileHeader::deserialize(std::span<const uint8_t> data) {
-    FileHeader header;
-    size_t offset = 0;
-    
+bool header_fits(const FileHeader& header) {
+    return header.salt.size() <= 255 && header.nonce.size() <= 255 &&
+           header.kdf_params.size() <= MAX_KDF_PARAMS_SIZE &&
+           (header.key_check.empty() || header.key_check.size() == KEY_CHECK_SIZE);
+}
+
+} // anonymous namespace
+
+std::vector<uint8_t> FileHeader::serialize() const {
+    if (!header_fits(*this)) {
+        throw std::runtime_error("Header fields exceed the format's limits");
+    }
+    HeaderWriter<HEADER_MAX_SIZE> out;
+    encode_header(*this, out);
+    auto bytes = out.data();
+    return std::vector<uint8_t>(bytes.begin(), bytes.end());
+}
+
+bool FileHeader::write_to(std::ostream& stream) const {
+    if (!header_fits(*this)) {
+        return false;
+    }
+    HeaderWriter<HEADER_MAX_SIZE> out;
+    encode_header(*this, out);
+    return out.write_to(stream);
+}
+
+FileHeaderView FileHeaderView::parse(std::span<const uint8_t> data) {
     // Check minimum size
     if (data.size() < 16) {
         throw std::runtime_error("File too small to contain valid header");
     }
     
-    // Magic bytes
-    std::memcpy(header.magic, data.data() + offset, 8);
-    offset += 8;
+    HeaderReader in(data);
+    FileHeaderView view;
     
-    if (!header.is_valid()) {
+    // Magic bytes
+    if (std::memcmp(in.bytes(8, "magic").data(), FILE_FORMAT_MAGIC, 8) != 0) {
         throw std::runtime_error("Invalid file format magic bytes");
     }
     
-    // Version
-    header.version_major = data[offset++];
-    header.version_minor = data[offset++];
-    
-    // Algorithm, KDF, Compression
-    header.algorithm = static_cast<AlgorithmID>(data[offset++]);
-    header.kdf = static_cast<KDFID>(data[offset++]);
-    header.compression = static_cast<CompressionID>(data[offset++]);
-    
-    // Reserved
-    std::memcpy(header.reserved, data.data() + offset, 3);
-    offset += 3;
-    
-    // Salt (32 bytes)
-    if (data.size() < offset + 32) {
-        throw std::runtime_error("File too small for salt");
+    // Version, then algorithm, KDF and compression IDs
+    view.version_major = in.u8("version");
+    view.version_minor = in.u8("version");
+    view.algorithm = static_cast<AlgorithmID>(in.u8("algorithm"));
+    view.kdf = static_cast<KDFID>(in.u8("KDF"));
+    view.compression = static_cast<CompressionID>(in.u8("compression"));
+    view.reserved = in.bytes(3, "reserved bytes");
+    
+    // Salt (32 bytes), then length-prefixed KDF params
+    view.salt = in.bytes(32, "salt");
+    uint32_t kdf_params_len = in.u32("KDF params length");
+    view.kdf_params = in.bytes(kdf_params_len, "KDF params");
+    
+    // Nonce (1-byte size, then data)
+    uint8_t nonce_size = in.u8("nonce size");
+    view.nonce = in.bytes(nonce_size, "nonce");
+    
+    // Compressed flag, then the dictionary ID and key check if flagged
+    uint8_t flag = in.u8("compressed flag");
+    view.compressed = (flag & COMPRESSED_FLAG) != 0;
+    if (flag & DICTIONARY_FLAG) {
+        view.dictionary_id = in.u32("dictionary ID");
     }
-    header.salt.assign(data.begin() + offset, data.begin() + offset + 32);
-    offset += 32;
-    
-    // KDF params length
-    if (data.size() < offset + 4) {
-        throw std::runtime_error("File too small for KDF params length");
+    if (flag & KEY_CHECK_FLAG) {
+        view.key_check = in.bytes(KEY_CHECK_SIZE, "key check");
     }
-    uint32_t kdf_params_len;
-    std::memcpy(&kdf_params_len, data.data() + offset, 4);
-    offset += 4;
     
-    // KDF params
-    if (data.size() < offset + kdf_params_len) {
-        throw std::runtime_error("File too small for KDF params");
+    view.size = in.offset();
+    return view;
+}
+
+FileHeader FileHeader::from_view(const FileHeaderView& view) {
+    FileHeader header;
+    std::memcpy(header.magic, FILE_FORMAT_MAGIC, 8);
+    header.version_major = view.version_major;
+    header.version_minor = view.version_minor;
+    header.algorithm = view.algorithm;
+    header.kdf = view.kdf;
+    header.compression = view.compression;
+    std::memcpy(header.reserved, view.reserved.data(), 3);
+    header.salt.assign(view.salt.begin(), view.salt.end());
+    header.kdf_params.assign(view.kdf_params.begin(), view.kdf_params.end());
+    header.nonce.assign(view.nonce.begin(), view.nonce.end());
+    header.compressed = view.compressed;
+    header.dictionary_id = view.dictionary_id;
+    header.key_check.assign(view.key_check.begin(), view.key_check.end());
+    return header;
+}
+
+std::pair<FileHeader, size_t> FileHeader::deserialize(std::span<const uint8_t> data) {
+    auto view = FileHeaderView::parse(data);
+    return {from_view(view), view.size};
+}
+
+// ============================================================================
+// LegacyHeaderView
+// ============================================================================
+
+Result<LegacyHeaderView> LegacyHeaderView::parse(std::span<const uint8_t> data) {
+    if (data.size() < LEGACY_MIN_HEADER_SIZE) {
+        return Result<LegacyHeaderView>::error("Header too small");
     }
-    header.kdf_params.assign(data.begin() + offset, data.begin() + offset + kdf_params_len);
-    offset += kdf_params_len;
     
-    // Nonce size (1 byte)
-    if (data.size() < offset + 1) {
-        throw std::runtime_error("File too small for nonce size");
+    try {
+        HeaderReader in(data);
+        LegacyHeaderView view;
+        
+        if (in.u32("magic") != LEGACY_MAGIC) {
+            return Result<LegacyHeaderView>::error("Invalid magic bytes");
+        }
+        
+        // Version (minor is ignored)
+        if (in.u8("version") != LEGACY_VERSION_MAJOR) {
+            return Result<LegacyHeaderView>::error("Unsupported version");
+        }
+        in.skip(1, "version");
+        
+        // Algorithm, KDF, Security
+        view.algorithm = static_cast<AlgorithmType>(in.u8("algorithm"));
+        view.kdf = static_cast<KDFType>(in.u8("KDF"));
+        view.security_level = static_cast<SecurityLevel>(in.u8("security level"));
+        
+        // Salt, nonce and tag, each after a 2-byte length
+        view.salt = in.bytes(in.u16("salt length"), "salt");
+        view.nonce = in.bytes(in.u16("nonce length"), "nonce");
+        view.tag = in.bytes(in.u16("tag length"), "tag");
+        
+        // Sizes, timestamp, flags and reserved bytes
+        view.original_size = in.u64("original size");
+        view.encrypted_size = in.u64("encrypted size");
+        view.timestamp = in.u64("timestamp");
+        view.flags = in.u32("flags");
+        in.skip(16, "reserved bytes");
+        
+        view.size = in.offset();
+        return Result<LegacyHeaderView>::ok(view);
+    } catch (const std::runtime_error& e) {
+        return Result<LegacyHeaderView>::error(std::string("Header truncated: ") + e.what());
+    }
+}
+
+bool LegacyHeaderView::validate() const {
+    // Check salt
+    if (salt.empty() || salt.size() > 64) {
+        return false;
     }
-    uint8_t nonce_size = data[offset++];
     
-    // Nonce (variable size)
-    if (data.size() < offset + nonce_size) {
-        throw std::runtime_error("File too small for nonce");
+    // Check nonce (GCM needs 12 bytes typically)
+    if (nonce.empty() || nonce.size() > 32) {
+        return false;
     }
-    header.nonce.assign(data.begin() + offset, data.begin() + offset + nonce_size);
-    offset += nonce_size;
     
-    // Compressed flag
-    if (data.size() < offset + 1) {
-        throw std::runtime_error("File too small for compressed flag");
+    // Check tag for AEAD modes
+    if (algorithm == AlgorithmType::AES_128_GCM ||
+        algorithm == AlgorithmType::AES_192_GCM ||
+        algorithm == AlgorithmType::AES_256_GCM ||
+        algorithm == AlgorithmType::CHACHA20_POLY1305) {
+        if (tag.size() != 16) {
+            return false;
+        }
     }
-    header.compressed = (data[offset++] == 0x01);
     
-    return {header, offset};
+    return true;
 }
 
 // ============================================================================
@@ -240,6 +402,8 @@ FileHeader FileFormatHandler::create_header(
         case CompressionType::ZLIB: comp_str = "zlib"; break;
         case CompressionType::BZIP2: comp_str = "bzip2"; break;
         case CompressionType::LZMA: comp_str = "lzma"; break;
+        case CompressionType::ZSTD: comp_str = "zstd"; break;
+        case CompressionType::LZ4: comp_str = "lz4"; break;
         default: comp_str = "none"; break;
     }
     header.compression = to_compression_id(comp_str);
@@ -281,15 +445,21 @@ bool FileFormatHandler::write_file(
     std::span<const uint8_t> ciphertext,
     std::span<const uint8_t> auth_tag
 ) {
+    utils::ScopedSpan trace_span("FileFormatHandler::write_file", "format", ciphertext.size() + auth_tag.size());
     try {
-        std::ofstream file(path, std::ios::binary);
+        // Temp file beside path, renamed into place after one fsync
+        utils::OutputFileOptions options;
+        options.atomic = true;
+        options.preallocate = header.size() + ciphertext.size() + auth_tag.size();
+        utils::OutputFile file(path, options);
         if (!file) {
             return false;
         }
         
-        // Write header
-        auto header_data = header.serialize();
-        file.write(reinterpret_cast<const char*>(header_data.data()), header_data.size());
+        // Write header (one write from a stack buffer)
+        if (!header.write_to(file)) {
+            return false;
+        }
         
         // Write ciphertext
         file.write(reinterpret_cast<const char*>(ciphertext.data()), ciphertext.size());
@@ -297,7 +467,7 @@ bool FileFormatHandler::write_file(
         // Write auth tag
         file.write(reinterpret_cast<const char*>(auth_tag.data()), auth_tag.size());
         
-        return true;
+        return file && file.commit();
     } catch (...) {
         return false;
     }
@@ -306,39 +476,22 @@ bool FileFormatHandler::write_file(
 std::tuple<FileHeader, std::vector<uint8_t>, std::vector<uint8_t>> FileFormatHandler::read_file(
     const std::string& path
 ) {
-    std::ifstream file(path, std::ios::binary | std::ios::ate);
-    if (!file) {
+    utils::ScopedSpan trace_span("FileFormatHandler::read_file", "format");
+    // Map file; only ciphertext and tag are copied out
+    auto mapped = utils::FileIO::map_file(path);
+    if (!mapped) {
         throw std::runtime_error("Failed to open file");
     }
     
-    size_t file_size = file.tellg();
-    file.seekg(0, std::ios::beg);
-    
-    // Read entire file
-    std::vector<uint8_t> file_data(file_size);
-    file.read(reinterpret_cast<char*>(file_data.data()), file_size);
+    std::span<const uint8_t> file_data = mapped.value.span();
+    size_t file_size = file_data.size();
     
     // Deserialize header
     auto [header, header_size] = FileHeader::deserialize(file_data);
     
-    // Check if algorithm uses authentication tag (AEAD)
-    bool has_tag = (header.algorithm == AlgorithmID::AES_128_GCM ||
-                    header.algorithm == AlgorithmID::AES_192_GCM ||
-                    header.algorithm == AlgorithmID::AES_256_GCM ||
-                    header.algorithm == AlgorithmID::CHACHA20_POLY1305 ||
-                    header.algorithm == AlgorithmID::SERPENT_256_GCM ||
-                    header.algorithm == AlgorithmID::TWOFISH_128_GCM ||
-                    header.algorithm == AlgorithmID::TWOFISH_192_GCM ||
-                    header.algorithm == AlgorithmID::TWOFISH_256_GCM ||
-                    header.algorithm == AlgorithmID::CAMELLIA_128_GCM ||
-                    header.algorithm == AlgorithmID::CAMELLIA_192_GCM ||
-                    header.algorithm == AlgorithmID::CAMELLIA_256_GCM ||
-                    header.algorithm == AlgorithmID::ARIA_128_GCM ||
-                    header.algorithm == AlgorithmID::ARIA_192_GCM ||
-                    header.algorithm == AlgorithmID::ARIA_256_GCM ||
-                    header.algorithm == AlgorithmID::SM4_GCM);
-    
-    size_t tag_size = has_tag ? 16 : 0;
+    // AEAD algorithms store their tag after the ciphertext
+    const auto* traits = find_algorithm(header.algorithm);
+    size_t tag_size = traits ? traits->tag_size : 0;
     
     // Remaining data is ciphertext + tag (if AEAD)
     if (file_size < header_size + tag_size) {
@@ -351,112 +504,66 @@ std::tuple<FileHeader, std::vector<uint8_t>, std::vector<uint8_t>> FileFormatHan
     std::memcpy(ciphertext.data(), file_data.data() + header_size, ciphertext_size);
     
     std::vector<uint8_t> auth_tag;
-    if (has_tag) {
-        auth_tag.resize(16);
-        std::memcpy(auth_tag.data(), file_data.data() + header_size + ciphertext_size, 16);
+    if (tag_size != 0) {
+        auth_tag.resize(tag_size);
+        std::memcpy(auth_tag.data(), file_data.data() + header_size + ciphertext_size, tag_size);
     }
     
     return {header, ciphertext, auth_tag};
 }
 
+FileLayout FileFormatHandler::read_header(const std::string& path) {
+    utils::ScopedSpan trace_span("FileFormatHandler::read_header", "format");
+    auto head = utils::FileIO::read_range(path, 0, HEADER_READ_SIZE);
+    if (!head) {
+        throw std::runtime_error(head.error_message);
+    }
+    
+    // Long KDF parameters: fetch exactly the rest of the header
+    if (head.value.size() == HEADER_READ_SIZE) {
+        uint32_t kdf_params_len = 0;
+        std::memcpy(&kdf_params_len, head.value.data() + HEADER_FIXED_SIZE - 4, 4);
+        if (kdf_params_len > MAX_KDF_PARAMS_SIZE) {
+            throw std::runtime_error("Invalid KDF params length");
+        }
+        size_t needed = HEADER_FIXED_SIZE + kdf_params_len + 1 + 255 + 1 + 4;
+        if (needed > head.value.size()) {
+            auto rest = utils::FileIO::read_range(path, head.value.size(), needed - head.value.size());
+            if (!rest) {
+                throw std::runtime_error(rest.error_message);
+            }
+            head.value.insert(head.value.end(), rest.value.begin(), rest.value.end());
+        }
+    }
+    
+    FileLayout layout;
+    std::tie(layout.header, layout.header_size) = FileHeader::deserialize(head.value);
+    layout.file_size = utils::FileIO::file_size(path);
+    const auto* traits = find_algorithm(layout.header.algorithm);
+    layout.tag_size = traits ? traits->tag_size : 0;
+    if (layout.file_size < layout.header_size + layout.tag_size) {
+        throw std::runtime_error("File too small for header and ciphertext");
+    }
+    layout.ciphertext_offset = layout.header_size;
+    layout.ciphertext_size = layout.file_size - layout.header_size - layout.tag_size;
+    return layout;
+}
+
+bool FileFormatHandler::has_auth_tag(AlgorithmID id) {
+    const auto* traits = find_algorithm(id);
+    return traits && traits->tag_size != 0;
+}
+
 AlgorithmID FileFormatHandler::to_algorithm_id(AlgorithmType type) {
-    switch (type) {
-        case AlgorithmType::AES_128_GCM: return AlgorithmID::AES_128_GCM;
-        case AlgorithmType::AES_192_GCM: return AlgorithmID::AES_192_GCM;
-        case AlgorithmType::AES_256_GCM: return AlgorithmID::AES_256_GCM;
-        case AlgorithmType::AES_128_CBC: return AlgorithmID::AES_128_CBC;
-        case AlgorithmType::AES_192_CBC: return AlgorithmID::AES_192_CBC;
-        case AlgorithmType::AES_256_CBC: return AlgorithmID::AES_256_CBC;
-        case AlgorithmType::AES_128_CTR: return AlgorithmID::AES_128_CTR;
-        case AlgorithmType::AES_192_CTR: return AlgorithmID::AES_192_CTR;
-        case AlgorithmType::AES_256_CTR: return AlgorithmID::AES_256_CTR;
-        case AlgorithmType::AES_128_CFB: return AlgorithmID::AES_128_CFB;
-        case AlgorithmType::AES_192_CFB: return AlgorithmID::AES_192_CFB;
-        case AlgorithmType::AES_256_CFB: return AlgorithmID::AES_256_CFB;
-        case AlgorithmType::AES_128_OFB: return AlgorithmID::AES_128_OFB;
-        case AlgorithmType::AES_192_OFB: return AlgorithmID::AES_192_OFB;
-        case AlgorithmType::AES_256_OFB: return AlgorithmID::AES_256_OFB;
-        case AlgorithmType::AES_128_ECB: return AlgorithmID::AES_128_ECB;
-        case AlgorithmType::AES_192_ECB: return AlgorithmID::AES_192_ECB;
-        case AlgorithmType::AES_256_ECB: return AlgorithmID::AES_256_ECB;
-        case AlgorithmType::AES_128_XTS: return AlgorithmID::AES_128_XTS;
-        case AlgorithmType::AES_256_XTS: return AlgorithmID::AES_256_XTS;
-        case AlgorithmType::TRIPLE_DES_CBC: return AlgorithmID::TRIPLE_DES_CBC;
-        case AlgorithmType::RSA_2048: return AlgorithmID::RSA_2048;
-        case AlgorithmType::RSA_3072: return AlgorithmID::RSA_3072;
-        case AlgorithmType::RSA_4096: return AlgorithmID::RSA_4096;
-        case AlgorithmType::ECC_P256: return AlgorithmID::ECC_P256;
-        case AlgorithmType::ECC_P384: return AlgorithmID::ECC_P384;
-        case AlgorithmType::ECC_P521: return AlgorithmID::ECC_P521;
-        case AlgorithmType::CHACHA20_POLY1305: return AlgorithmID::CHACHA20_POLY1305;
-        case AlgorithmType::SERPENT_256_GCM: return AlgorithmID::SERPENT_256_GCM;
-        case AlgorithmType::TWOFISH_128_GCM: return AlgorithmID::TWOFISH_128_GCM;
-        case AlgorithmType::TWOFISH_192_GCM: return AlgorithmID::TWOFISH_192_GCM;
-        case AlgorithmType::TWOFISH_256_GCM: return AlgorithmID::TWOFISH_256_GCM;
-        case AlgorithmType::CAMELLIA_128_GCM: return AlgorithmID::CAMELLIA_128_GCM;
-        case AlgorithmType::CAMELLIA_192_GCM: return AlgorithmID::CAMELLIA_192_GCM;
-        case AlgorithmType::CAMELLIA_256_GCM: return AlgorithmID::CAMELLIA_256_GCM;
-        case AlgorithmType::ARIA_128_GCM: return AlgorithmID::ARIA_128_GCM;
-        case AlgorithmType::ARIA_192_GCM: return AlgorithmID::ARIA_192_GCM;
-        case AlgorithmType::ARIA_256_GCM: return AlgorithmID::ARIA_256_GCM;
-        case AlgorithmType::SM4_GCM: return AlgorithmID::SM4_GCM;
-        case AlgorithmType::CAESAR: return AlgorithmID::CAESAR;
-        case AlgorithmType::VIGENERE: return AlgorithmID::VIGENERE;
-        case AlgorithmType::PLAYFAIR: return AlgorithmID::PLAYFAIR;
-        case AlgorithmType::SUBSTITUTION: return AlgorithmID::SUBSTITUTION;
-        case AlgorithmType::HILL: return AlgorithmID::HILL;
-        default: return AlgorithmID::UNKNOWN;
+    if (static_cast<size_t>(type) >= ALGORITHM_COUNT) {
+        return AlgorithmID::UNKNOWN;
     }
+    return algorithm_traits(type).id;
 }
 
 AlgorithmType FileFormatHandler::from_algorithm_id(AlgorithmID id) {
-    switch (id) {
-        case AlgorithmID::AES_128_GCM: return AlgorithmType::AES_128_GCM;
-        case AlgorithmID::AES_192_GCM: return AlgorithmType::AES_192_GCM;
-        case AlgorithmID::AES_256_GCM: return AlgorithmType::AES_256_GCM;
-        case AlgorithmID::AES_128_CBC: return AlgorithmType::AES_128_CBC;
-        case AlgorithmID::AES_192_CBC: return AlgorithmType::AES_192_CBC;
-        case AlgorithmID::AES_256_CBC: return AlgorithmType::AES_256_CBC;
-        case AlgorithmID::AES_128_CTR: return AlgorithmType::AES_128_CTR;
-        case AlgorithmID::AES_192_CTR: return AlgorithmType::AES_192_CTR;
-        case AlgorithmID::AES_256_CTR: return AlgorithmType::AES_256_CTR;
-        case AlgorithmID::AES_128_CFB: return AlgorithmType::AES_128_CFB;
-        case AlgorithmID::AES_192_CFB: return AlgorithmType::AES_192_CFB;
-        case AlgorithmID::AES_256_CFB: return AlgorithmType::AES_256_CFB;
-        case AlgorithmID::AES_128_OFB: return AlgorithmType::AES_128_OFB;
-        case AlgorithmID::AES_192_OFB: return AlgorithmType::AES_192_OFB;
-        case AlgorithmID::AES_256_OFB: return AlgorithmType::AES_256_OFB;
-        case AlgorithmID::AES_128_ECB: return AlgorithmType::AES_128_ECB;
-        case AlgorithmID::AES_192_ECB: return AlgorithmType::AES_192_ECB;
-        case AlgorithmID::AES_256_ECB: return AlgorithmType::AES_256_ECB;
-        case AlgorithmID::AES_128_XTS: return AlgorithmType::AES_128_XTS;
-        case AlgorithmID::AES_256_XTS: return AlgorithmType::AES_256_XTS;
-        case AlgorithmID::TRIPLE_DES_CBC: return AlgorithmType::TRIPLE_DES_CBC;
-        case AlgorithmID::RSA_2048: return AlgorithmType::RSA_2048;
-        case AlgorithmID::RSA_3072: return AlgorithmType::RSA_3072;
-        case AlgorithmID::RSA_4096: return AlgorithmType::RSA_4096;
-        case AlgorithmID::ECC_P256: return AlgorithmType::ECC_P256;
-        case AlgorithmID::ECC_P384: return AlgorithmType::ECC_P384;
-        case AlgorithmID::ECC_P521: return AlgorithmType::ECC_P521;
-        case AlgorithmID::CHACHA20_POLY1305: return AlgorithmType::CHACHA20_POLY1305;
-        case AlgorithmID::SERPENT_256_GCM: return AlgorithmType::SERPENT_256_GCM;
-        case AlgorithmID::TWOFISH_128_GCM: return AlgorithmType::TWOFISH_128_GCM;
-        case AlgorithmID::TWOFISH_192_GCM: return AlgorithmType::TWOFISH_192_GCM;
-        case AlgorithmID::TWOFISH_256_GCM: return AlgorithmType::TWOFISH_256_GCM;
-        case AlgorithmID::CAMELLIA_128_GCM: return AlgorithmType::CAMELLIA_128_GCM;
-        case AlgorithmID::CAMELLIA_192_GCM: return AlgorithmType::CAMELLIA_192_GCM;
-        case AlgorithmID::CAMELLIA_256_GCM: return AlgorithmType::CAMELLIA_256_GCM;
-        case AlgorithmID::ARIA_128_GCM: return AlgorithmType::ARIA_128_GCM;
-        case AlgorithmID::ARIA_192_GCM: return AlgorithmType::ARIA_192_GCM;
-        case AlgorithmID::ARIA_256_GCM: return AlgorithmType::ARIA_256_GCM;
-        case AlgorithmID::SM4_GCM: return AlgorithmType::SM4_GCM;
-        case AlgorithmID::CAESAR: return AlgorithmType::CAESAR;
-        case AlgorithmID::VIGENERE: return AlgorithmType::VIGENERE;
-        case AlgorithmID::PLAYFAIR: return AlgorithmType::PLAYFAIR;
-        case AlgorithmID::SUBSTITUTION: return AlgorithmType::SUBSTITUTION;
-        case AlgorithmID::HILL: return AlgorithmType::HILL;
-        default: return AlgorithmType::AES_256_GCM;
-    }
+    const auto* traits = find_algorithm(id);
+    return traits ? traits->type : AlgorithmType::AES_256_GCM;
 }
 
 KDFID FileFormatHandler::to_kdf_id(KDFType type) {
@@ -485,6 +592,8 @@ CompressionID FileFormatHandler::to_compression_id(const std::string& type) {
     if (type == "zlib") return CompressionID::ZLIB;
     if (type == "bzip2") return CompressionID::BZIP2;
     if (type == "lzma") return CompressionID::LZMA;
+    if (type == "zstd") return CompressionID::ZSTD;
+    if (type == "lz4") return CompressionID::LZ4;
     return CompressionID::NONE;
 }
 
@@ -493,6 +602,8 @@ std::string FileFormatHandler::from_compression_id(CompressionID id) {
         case CompressionID::ZLIB: return "zlib";
         case CompressionID::BZIP2: return "bzip2";
         case CompressionID::LZMA: return "lzma";
+        case CompressionID::ZSTD: return "zstd";
+        case CompressionID::LZ4: return "lz4";
         default: return "none";
     }
 }
@@ -512,6 +623,7 @@ bool FileFormatHandler::is_legacy_format(const std::string& path) {
 std::tuple<std::vector<uint8_t>, std::vector<uint8_t>, std::vector<uint8_t>> FileFormatHandler::read_legacy_file(
     const std::string& path
 ) {
+    utils::ScopedSpan trace_span("FileFormatHandler::read_legacy_file", "format");
     std::ifstream file(path, std::ios::binary | std::ios::ate);
     if (!file) {
         throw std::runtime_error("Failed to open file");
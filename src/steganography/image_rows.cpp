@@ -0,0 +1,133 @@
+/**
+ * @file image_rows.cpp
+ * @brief Row access to stego images: streamed PNG, mapped BMP or stb
+ */
+
+#include "filevault/steganography/image_rows.hpp"
+#include <stb_image.h>
+#include <climits>
+#include <stdexcept>
+#include <string>
+
+namespace filevault::steganography {
+
+namespace {
+
+uint32_t read_le32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+} // anonymous namespace
+
+std::optional<BmpRowReader> BmpRowReader::open(const std::string& path) {
+    auto mapped = utils::FileIO::map_file(path);
+    if (!mapped) {
+        return std::nullopt;
+    }
+    std::span<const uint8_t> file = mapped.value.span();
+    if (file.size() < 54 || file[0] != 'B' || file[1] != 'M') {
+        return std::nullopt;
+    }
+
+    uint32_t pixel_offset = read_le32(&file[10]);
+    uint32_t header_size = read_le32(&file[14]);
+    int32_t width = static_cast<int32_t>(read_le32(&file[18]));
+    int32_t height = static_cast<int32_t>(read_le32(&file[22]));
+    uint16_t bpp = static_cast<uint16_t>(file[28] | (file[29] << 8));
+    uint32_t compression = read_le32(&file[30]);
+
+    int channels = 0;
+    if (bpp == 24 && compression == 0 && header_size >= 40) {
+        channels = 3;
+    } else if (bpp == 32 && compression == 3 && header_size >= 108 && file.size() >= 14 + 56 &&
+               read_le32(&file[54]) == 0x00FF0000 && read_le32(&file[58]) == 0x0000FF00 &&
+               read_le32(&file[62]) == 0x000000FF && read_le32(&file[66]) == 0xFF000000) {
+        channels = 4;
+    }
+    if (channels == 0 || width <= 0 || height == 0 || height == INT32_MIN) {
+        return std::nullopt;
+    }
+
+    BmpRowReader reader;
+    reader.width_ = static_cast<uint32_t>(width);
+    reader.height_ = static_cast<uint32_t>(height < 0 ? -height : height);
+    reader.channels_ = channels;
+    reader.bottom_up_ = height > 0;
+    reader.pixel_offset_ = pixel_offset;
+    reader.stride_ = (static_cast<uint64_t>(reader.width_) * channels + 3) & ~uint64_t{3};
+    if (pixel_offset + reader.stride_ * reader.height_ > file.size()) {
+        return std::nullopt;
+    }
+    reader.row_.resize(static_cast<size_t>(reader.width_) * channels);
+    reader.file_ = std::move(mapped.value);
+    return reader;
+}
+
+std::span<const uint8_t> BmpRowReader::next_row() {
+    if (rows_read_ == height_) {
+        return {};
+    }
+    uint32_t y = bottom_up_ ? height_ - 1 - rows_read_ : rows_read_;
+    const uint8_t* source = file_.data() + pixel_offset_ + stride_ * y;
+    for (size_t i = 0; i < row_.size(); i += channels_) {
+        row_[i] = source[i + 2];
+        row_[i + 1] = source[i + 1];
+        row_[i + 2] = source[i];
+        if (channels_ == 4) {
+            row_[i + 3] = source[i + 3];
+            alpha_seen_ |= source[i + 3] != 0;
+        }
+    }
+    ++rows_read_;
+    return row_;
+}
+
+ImageRows::ImageRows(const std::string& path) {
+    if (auto info = PngRowReader::probe(path)) {
+        png_ = std::make_unique<PngRowReader>(path);
+        width_ = info->width;
+        height_ = info->height;
+        channels_ = info->channels;
+        return;
+    }
+    bmp_ = BmpRowReader::open(path);
+    if (bmp_) {
+        width_ = bmp_->width();
+        height_ = bmp_->height();
+        channels_ = bmp_->channels();
+        return;
+    }
+
+    int width, height, channels;
+    decoded_ = stbi_load(path.c_str(), &width, &height, &channels, 0);
+    if (!decoded_) {
+        const char* reason = stbi_failure_reason();
+        throw std::runtime_error(std::string("Cannot decode image: ") + (reason ? reason : "unknown format"));
+    }
+    width_ = static_cast<uint32_t>(width);
+    height_ = static_cast<uint32_t>(height);
+    channels_ = channels;
+}
+
+ImageRows::~ImageRows() {
+    if (decoded_) {
+        stbi_image_free(decoded_);
+    }
+}
+
+std::span<const uint8_t> ImageRows::next_row() {
+    if (png_) {
+        return png_->next_row();
+    }
+    if (bmp_) {
+        return bmp_->next_row();
+    }
+    if (rows_read_ == height_) {
+        return {};
+    }
+    size_t row_bytes = static_cast<size_t>(width_) * channels_;
+    return {decoded_ + row_bytes * rows_read_++, row_bytes};
+}
+
+} // namespace filevault::steganography
@@ -1,7 +1,11 @@
 #include "filevault/steganography/lsb.hpp"
+#include "filevault/steganography/image_rows.hpp"
+#include "filevault/steganography/lsb_kernels.hpp"
+#include "filevault/steganography/png_stream.hpp"
 #include <fstream>
 #include <cstring>
 #include <algorithm>
+#include <filesystem>
 #include <spdlog/spdlog.h>
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -12,16 +16,112 @@
 
 namespace filevault::steganography {
 
+namespace {
+
+std::string lower_extension(const std::string& path) {
+    std::string ext = path.substr(path.find_last_of('.') + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext;
+}
+
+/**
+ * @brief Whole bytes the channels hold, length header included
+ *
+ * Each byte takes ceil(8 / bits) channels (see lsb_kernels.hpp), so at
+ * 3 bits a byte uses 3 channels, not 8 / 3 of one.
+ */
+uint64_t byte_slots(uint64_t channel_count, int bits_per_channel) {
+    return channel_count / ((8 + bits_per_channel - 1) / bits_per_channel);
+}
+
+bool is_large_png(const std::string& path) {
+    auto info = PngRowReader::probe(path);
+    return info && info->channel_count() >= LSBSteganography::STREAMING_THRESHOLD;
+}
+
+/**
+ * @brief Write a decoded bitmap through PngRowWriter
+ */
+bool write_png(const std::string& path, std::span<const uint8_t> pixels, int width, int height, int channels,
+               const PngWriteOptions& options) {
+    try {
+        PngInfo info{static_cast<uint32_t>(width), static_cast<uint32_t>(height), channels};
+        PngRowWriter writer(path, info, options);
+        for (size_t offset = 0; offset < pixels.size(); offset += info.row_bytes()) {
+            writer.write_row(pixels.subspan(offset, info.row_bytes()));
+        }
+        writer.finish();
+        return true;
+    } catch (const std::exception& e) {
+        spdlog::error("PNG write failed for {}: {}", path, e.what());
+        spdlog::error("Image dimensions: {}x{}x{} channels", width, height, channels);
+        return false;
+    }
+}
+
+/*
+ * Streaming helpers. Byte j of a payload segment that starts at channel
+ * base owns channels base + j * cpb onwards; these handle the part of a
+ * segment falling in one row, finishing a byte the previous row cut off
+ * channel by channel before handing whole bytes to the kernels.
+ */
+
+void embed_row(std::span<uint8_t> row, uint64_t row_start, std::span<const uint8_t> segment,
+               uint64_t base, int bits) {
+    const uint64_t cpb = (8 + bits - 1) / bits;
+    uint64_t begin = std::max(row_start, base);
+    uint64_t end = std::min<uint64_t>(row_start + row.size(), base + segment.size() * cpb);
+    const uint8_t mask = static_cast<uint8_t>((1 << bits) - 1);
+
+    uint64_t c = begin;
+    for (; c < end && (c - base) % cpb != 0; ++c) {
+        uint8_t value = (segment[(c - base) / cpb] >> (((c - base) % cpb) * bits)) & mask;
+        uint8_t& channel = row[c - row_start];
+        channel = static_cast<uint8_t>((channel & ~mask) | value);
+    }
+    if (c < end) {
+        size_t first = static_cast<size_t>((c - base) / cpb);
+        size_t count = static_cast<size_t>(std::min<uint64_t>(segment.size() - first, (end - c + cpb - 1) / cpb));
+        kernels::embed(row.first(end - row_start), c - row_start, segment.subspan(first, count), bits);
+    }
+}
+
+void extract_row(std::span<const uint8_t> row, uint64_t row_start, std::span<uint8_t> segment,
+                 uint64_t base, int bits) {
+    const uint64_t cpb = (8 + bits - 1) / bits;
+    uint64_t begin = std::max(row_start, base);
+    uint64_t end = std::min<uint64_t>(row_start + row.size(), base + segment.size() * cpb);
+    const uint8_t mask = static_cast<uint8_t>((1 << bits) - 1);
+
+    uint64_t c = begin;
+    for (; c < end && (c - base) % cpb != 0; ++c) {
+        segment[(c - base) / cpb] |= static_cast<uint8_t>((row[c - row_start] & mask) << (((c - base) % cpb) * bits));
+    }
+    if (c < end) {
+        size_t first = static_cast<size_t>((c - base) / cpb);
+        size_t count = static_cast<size_t>(std::min<uint64_t>(segment.size() - first, (end - c + cpb - 1) / cpb));
+        kernels::extract(row.first(end - row_start), c - row_start, segment.subspan(first, count), bits);
+    }
+}
+
+} // anonymous namespace
+
 bool LSBSteganography::embed(
     const std::string& cover_image_path,
     std::span<const uint8_t> secret_data,
     const std::string& output_path,
-    int bits_per_channel
+    int bits_per_channel,
+    const PngWriteOptions& png_options
 ) {
     if (bits_per_channel < 1 || bits_per_channel > 4) {
         return false;
     }
     
+    // Huge PNG covers go row by row instead of through one decoded bitmap
+    if (lower_extension(output_path) != "bmp" && is_large_png(cover_image_path)) {
+        return embed_streaming(cover_image_path, secret_data, output_path, bits_per_channel, png_options);
+    }
+    
     // Load image
     int width, height, channels;
     unsigned char* image_data = stbi_load(cover_image_path.c_str(), &width, &height, &channels, 0);
@@ -33,46 +133,31 @@ bool LSBSteganography::embed(
     
     // Check capacity
     size_t pixel_count = width * height * channels;
-    size_t max_bytes = (pixel_count * bits_per_channel) / 8;
-    size_t required_bytes = LENGTH_HEADER_SIZE + secret_data.size();
-    
-    if (required_bytes > max_bytes) {
+    if (LENGTH_HEADER_SIZE + secret_data.size() > byte_slots(pixel_count, bits_per_channel)) {
         stbi_image_free(image_data);
         return false;
     }
     
     // Embed length header (4 bytes)
-    size_t bit_index = 0;
+    std::span<uint8_t> pixels(image_data, pixel_count);
     uint32_t data_length = static_cast<uint32_t>(secret_data.size());
-    
-    for (int i = 0; i < 4; ++i) {
-        uint8_t byte = (data_length >> (i * 8)) & 0xFF;
-        embed_byte(image_data, pixel_count, bit_index, byte, bits_per_channel);
+    uint8_t length_header[LENGTH_HEADER_SIZE];
+    for (size_t i = 0; i < LENGTH_HEADER_SIZE; ++i) {
+        length_header[i] = (data_length >> (i * 8)) & 0xFF;
     }
+    size_t bit_index = kernels::embed(pixels, 0, length_header, bits_per_channel);
     
     // Embed secret data
-    for (uint8_t byte : secret_data) {
-        embed_byte(image_data, pixel_count, bit_index, byte, bits_per_channel);
-    }
+    kernels::embed(pixels, bit_index, secret_data, bits_per_channel);
     
     // Save stego image
     bool success = false;
     
     // Determine format from extension
-    std::string ext = output_path.substr(output_path.find_last_of('.') + 1);
-    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    std::string ext = lower_extension(output_path);
     
     if (ext == "png") {
-        success = stbi_write_png(output_path.c_str(), width, height, channels, image_data, width * channels);
-        if (!success) {
-            spdlog::error("PNG write failed for: {}", output_path);
-            spdlog::error("Image dimensions: {}x{}x{} channels", width, height, channels);
-            spdlog::error("Stride: {} bytes", width * channels);
-            const char* reason = stbi_failure_reason();
-            if (reason) {
-                spdlog::error("STB reason: {}", reason);
-            }
-        }
+        success = write_png(output_path, pixels, width, height, channels, png_options);
     } else if (ext == "bmp") {
         success = stbi_write_bmp(output_path.c_str(), width, height, channels, image_data);
         if (!success) {
@@ -85,14 +170,7 @@ bool LSBSteganography::embed(
     } else {
         // Default to PNG
         spdlog::warn("Unknown extension '{}', defaulting to PNG format", ext);
-        success = stbi_write_png(output_path.c_str(), width, height, channels, image_data, width * channels);
-        if (!success) {
-            spdlog::error("PNG write (default) failed for: {}", output_path);
-            const char* reason = stbi_failure_reason();
-            if (reason) {
-                spdlog::error("STB reason: {}", reason);
-            }
-        }
+        success = write_png(output_path, pixels, width, height, channels, png_options);
     }
     
     stbi_image_free(image_data);
@@ -107,6 +185,17 @@ std::vector<uint8_t> LSBSteganography::extract(
         return {};
     }
     
+    // Decode only the rows the payload occupies where the format allows
+    if (PngRowReader::probe(stego_image_path)) {
+        return extract_streaming(stego_image_path, bits_per_channel);
+    }
+    if (auto bmp = BmpRowReader::open(stego_image_path)) {
+        auto secret_data = extract_rows([&]() { return bmp->next_row(); }, bmp->channel_count(), bits_per_channel);
+        if (bmp->alpha_seen()) {
+            return secret_data;
+        }
+    }
+    
     // Load image
     int width, height, channels;
     unsigned char* image_data = stbi_load(stego_image_path.c_str(), &width, &height, &channels, 0);
@@ -117,32 +206,149 @@ std::vector<uint8_t> LSBSteganography::extract(
     }
     
     size_t pixel_count = width * height * channels;
-    size_t bit_index = 0;
+    std::span<const uint8_t> pixels(image_data, pixel_count);
     
     // Extract length header (4 bytes)
+    uint8_t length_header[LENGTH_HEADER_SIZE];
+    size_t bit_index = kernels::extract(pixels, 0, length_header, bits_per_channel);
     uint32_t data_length = 0;
-    for (int i = 0; i < 4; ++i) {
-        uint8_t byte = extract_byte(image_data, pixel_count, bit_index, bits_per_channel);
-        data_length |= (static_cast<uint32_t>(byte) << (i * 8));
+    for (size_t i = 0; i < LENGTH_HEADER_SIZE; ++i) {
+        data_length |= (static_cast<uint32_t>(length_header[i]) << (i * 8));
     }
     
     // Validate length
-    size_t max_bytes = (pixel_count * bits_per_channel) / 8 - LENGTH_HEADER_SIZE;
-    if (data_length == 0 || data_length > max_bytes) {
+    if (data_length == 0 || LENGTH_HEADER_SIZE + data_length > byte_slots(pixel_count, bits_per_channel)) {
         stbi_image_free(image_data);
         return {};
     }
     
     // Extract secret data
     std::vector<uint8_t> secret_data(data_length);
-    for (size_t i = 0; i < data_length; ++i) {
-        secret_data[i] = extract_byte(image_data, pixel_count, bit_index, bits_per_channel);
-    }
+    kernels::extract(pixels, bit_index, secret_data, bits_per_channel);
     
     stbi_image_free(image_data);
     return secret_data;
 }
 
+bool LSBSteganography::embed_streaming(
+    const std::string& cover_image_path,
+    std::span<const uint8_t> secret_data,
+    const std::string& output_path,
+    int bits_per_channel,
+    const PngWriteOptions& png_options
+) {
+    if (bits_per_channel < 1 || bits_per_channel > 4) {
+        return false;
+    }
+    
+    auto info = PngRowReader::probe(cover_image_path);
+    if (!info) {
+        return false;
+    }
+    
+    // Check capacity
+    if (LENGTH_HEADER_SIZE + secret_data.size() > byte_slots(info->channel_count(), bits_per_channel)) {
+        return false;
+    }
+    
+    uint32_t data_length = static_cast<uint32_t>(secret_data.size());
+    uint8_t length_header[LENGTH_HEADER_SIZE];
+    for (size_t i = 0; i < LENGTH_HEADER_SIZE; ++i) {
+        length_header[i] = (data_length >> (i * 8)) & 0xFF;
+    }
+    const uint64_t data_start = LENGTH_HEADER_SIZE * ((8 + bits_per_channel - 1) / bits_per_channel);
+    
+    // Written beside the output and renamed, so the cover can be overwritten
+    std::string temp_path = output_path + ".tmp";
+    std::error_code ec;
+    try {
+        PngRowReader reader(cover_image_path);
+        PngRowWriter writer(temp_path, reader.info(), png_options);
+        uint64_t row_start = 0;
+        for (auto row = reader.next_row(); !row.empty(); row = reader.next_row()) {
+            embed_row(row, row_start, length_header, 0, bits_per_channel);
+            embed_row(row, row_start, secret_data, data_start, bits_per_channel);
+            writer.write_row(row);
+            row_start += row.size();
+        }
+        writer.finish();
+    } catch (const std::exception& e) {
+        spdlog::error("Streaming embed failed for {}: {}", output_path, e.what());
+        std::filesystem::remove(temp_path, ec);
+        return false;
+    }
+    
+    std::filesystem::rename(temp_path, output_path, ec);
+    if (ec) {
+        spdlog::error("Failed to write {}: {}", output_path, ec.message());
+        std::filesystem::remove(temp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+std::vector<uint8_t> LSBSteganography::extract_streaming(
+    const std::string& stego_image_path,
+    int bits_per_channel
+) {
+    if (bits_per_channel < 1 || bits_per_channel > 4) {
+        return {};
+    }
+    
+    try {
+        PngRowReader reader(stego_image_path);
+        return extract_rows([&]() { return std::span<const uint8_t>(reader.next_row()); },
+                            reader.info().channel_count(), bits_per_channel);
+    } catch (const std::exception& e) {
+        spdlog::error("Streaming extract failed for {}: {}", stego_image_path, e.what());
+        return {};
+    }
+}
+
+std::vector<uint8_t> LSBSteganography::extract_rows(
+    const std::function<std::span<const uint8_t>()>& next_row,
+    uint64_t channel_count,
+    int bits_per_channel
+) {
+    const uint64_t cpb = (8 + bits_per_channel - 1) / bits_per_channel;
+    const uint64_t data_start = LENGTH_HEADER_SIZE * cpb;
+    uint64_t slots = byte_slots(channel_count, bits_per_channel);
+    if (slots <= LENGTH_HEADER_SIZE) {
+        return {};
+    }
+    uint64_t max_bytes = slots - LENGTH_HEADER_SIZE;
+    
+    uint8_t length_header[LENGTH_HEADER_SIZE] = {};
+    std::vector<uint8_t> secret_data;
+    bool have_length = false;
+    uint64_t row_start = 0;
+    for (auto row = next_row(); !row.empty(); row = next_row()) {
+        uint64_t row_end = row_start + row.size();
+        extract_row(row, row_start, length_header, 0, bits_per_channel);
+        
+        if (!have_length && row_end >= data_start) {
+            uint32_t data_length = 0;
+            for (size_t i = 0; i < LENGTH_HEADER_SIZE; ++i) {
+                data_length |= (static_cast<uint32_t>(length_header[i]) << (i * 8));
+            }
+            // Validate length
+            if (data_length == 0 || data_length > max_bytes) {
+                return {};
+            }
+            secret_data.resize(data_length);
+            have_length = true;
+        }
+        if (have_length) {
+            extract_row(row, row_start, secret_data, data_start, bits_per_channel);
+            if (row_end >= data_start + secret_data.size() * cpb) {
+                break;
+            }
+        }
+        row_start = row_end;
+    }
+    return secret_data;
+}
+
 size_t LSBSteganography::calculate_capacity(
     const std::string& image_path,
     int bits_per_channel
@@ -167,60 +373,10 @@ size_t LSBSteganography::calculate_capacity(
     }
     
     size_t pixel_count = width * height * channels;
-    size_t max_bytes = (pixel_count * bits_per_channel) / 8;
+    uint64_t slots = byte_slots(pixel_count, bits_per_channel);
     
     // Subtract header size
-    return (max_bytes > LENGTH_HEADER_SIZE) ? (max_bytes - LENGTH_HEADER_SIZE) : 0;
-}
-
-void LSBSteganography::embed_byte(
-    uint8_t* pixel_data,
-    size_t pixel_count,
-    size_t& bit_index,
-    uint8_t byte,
-    int bits_per_channel
-) {
-    uint8_t mask = (1 << bits_per_channel) - 1;  // e.g., 0b00000001 for 1 bit
-    
-    for (int bit_pos = 0; bit_pos < 8; bit_pos += bits_per_channel) {
-        if (bit_index >= pixel_count) {
-            return;  // Out of space
-        }
-        
-        // Extract bits from byte
-        uint8_t bits = (byte >> bit_pos) & mask;
-        
-        // Clear LSBs in pixel
-        pixel_data[bit_index] = (pixel_data[bit_index] & ~mask) | bits;
-        
-        bit_index++;
-    }
-}
-
-uint8_t LSBSteganography::extract_byte(
-    const uint8_t* pixel_data,
-    size_t pixel_count,
-    size_t& bit_index,
-    int bits_per_channel
-) {
-    uint8_t byte = 0;
-    uint8_t mask = (1 << bits_per_channel) - 1;
-    
-    for (int bit_pos = 0; bit_pos < 8; bit_pos += bits_per_channel) {
-        if (bit_index >= pixel_count) {
-            return byte;  // Out of data
-        }
-        
-        // Extract LSBs from pixel
-        uint8_t bits = pixel_data[bit_index] & mask;
-        
-        // Place bits in byte
-        byte |= (bits << bit_pos);
-        
-        bit_index++;
-    }
-    
-    return byte;
+    return (slots > LENGTH_HEADER_SIZE) ? static_cast<size_t>(slots - LENGTH_HEADER_SIZE) : 0;
 }
 
 } // namespace filevault::steganography
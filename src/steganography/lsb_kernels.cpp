@@ -0,0 +1,636 @@
+/**
+ * @file lsb_kernels.cpp
+ * @brief SIMD bit-plane kernels for LSB steganography
+ */
+
+#include "filevault/steganography/lsb_kernels.hpp"
+#include "filevault/core/cpu_features.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define FILEVAULT_STEGO_X86 1
+    #include <emmintrin.h>
+    #include <tmmintrin.h>
+    #include <immintrin.h>
+    #if defined(__GNUC__) || defined(__clang__)
+        #define FILEVAULT_TARGET_SSSE3 __attribute__((target("ssse3")))
+        #define FILEVAULT_TARGET_AVX2 __attribute__((target("avx2")))
+    #else
+        #define FILEVAULT_TARGET_SSSE3
+        #define FILEVAULT_TARGET_AVX2
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define FILEVAULT_STEGO_NEON 1
+    #include <arm_neon.h>
+#endif
+
+namespace filevault::steganography::kernels {
+
+namespace {
+
+constexpr size_t kBlock = 16;   // Payload bytes per SIMD step
+
+constexpr int channels_per_byte(int bits) {
+    return (8 + bits - 1) / bits;
+}
+
+/**
+ * @brief Lane tables for a block of 16 payload bytes
+ *
+ * Register r of a block holds channels 16r..16r+15; channel c belongs to
+ * payload byte c / cpb and carries its bits from (c % cpb) * bits up.
+ */
+struct Tables {
+    uint8_t source[4][8][16] = {};          // [bits-1][r][lane]: payload byte of the lane
+    uint8_t payload_bit[4][4][8][16] = {};  // [bits-1][t][r][lane]: byte bit in channel bit t, 0 if none
+    uint8_t plane[4][16] = {};              // [t][lane]: channel bit t
+    uint8_t gather3[3][3][16] = {};         // [r][s][byte]: lane of channel 3 * byte + s, 0x80 if not in r
+};
+
+constexpr Tables make_tables() {
+    Tables tables;
+    for (int bits = 1; bits <= 4; ++bits) {
+        const int cpb = channels_per_byte(bits);
+        for (int r = 0; r < cpb; ++r) {
+            for (int lane = 0; lane < 16; ++lane) {
+                int c = 16 * r + lane;
+                tables.source[bits - 1][r][lane] = static_cast<uint8_t>(c / cpb);
+                for (int t = 0; t < bits; ++t) {
+                    int pos = (c % cpb) * bits + t;
+                    tables.payload_bit[bits - 1][t][r][lane] = pos < 8 ? static_cast<uint8_t>(1u << pos) : 0;
+                }
+            }
+        }
+    }
+    for (int t = 0; t < 4; ++t) {
+        for (int lane = 0; lane < 16; ++lane) {
+            tables.plane[t][lane] = static_cast<uint8_t>(1u << t);
+        }
+    }
+    for (int r = 0; r < 3; ++r) {
+        for (int s = 0; s < 3; ++s) {
+            for (int j = 0; j < 16; ++j) {
+                int c = 3 * j + s;
+                tables.gather3[r][s][j] = (c >= 16 * r && c < 16 * r + 16) ? static_cast<uint8_t>(c - 16 * r) : 0x80;
+            }
+        }
+    }
+    return tables;
+}
+
+constexpr Tables kTables = make_tables();
+
+size_t embed_scalar(uint8_t* channels, size_t count, size_t index,
+                    const uint8_t* bytes, size_t n, int bits) {
+    const uint8_t mask = static_cast<uint8_t>((1 << bits) - 1);
+    for (size_t j = 0; j < n; ++j) {
+        for (int pos = 0; pos < 8; pos += bits) {
+            if (index >= count) {
+                return index;   // Out of space
+            }
+            channels[index] = static_cast<uint8_t>((channels[index] & ~mask) | ((bytes[j] >> pos) & mask));
+            index++;
+        }
+    }
+    return index;
+}
+
+size_t extract_scalar(const uint8_t* channels, size_t count, size_t index,
+                      uint8_t* bytes, size_t n, int bits) {
+    const uint8_t mask = static_cast<uint8_t>((1 << bits) - 1);
+    for (size_t j = 0; j < n; ++j) {
+        uint8_t byte = 0;
+        for (int pos = 0; pos < 8 && index < count; pos += bits) {
+            byte |= static_cast<uint8_t>((channels[index] & mask) << pos);
+            index++;
+        }
+        bytes[j] = byte;
+    }
+    return index;
+}
+
+int smoothness(const int* g) {
+    return std::abs(g[1] - g[0]) + std::abs(g[2] - g[1]) + std::abs(g[3] - g[2]);
+}
+
+void rs_scalar(const uint8_t* plane, size_t groups, RsCounts& counts) {
+    for (size_t i = 0; i < groups; ++i) {
+        const uint8_t* p = plane + 4 * i;
+        for (int inverted = 0; inverted < 2; ++inverted) {
+            int g[4], flipped[4], shifted[4];
+            for (int k = 0; k < 4; ++k) {
+                g[k] = p[k] ^ inverted;
+                bool masked = k == 1 || k == 2;
+                flipped[k] = masked ? g[k] ^ 1 : g[k];
+                shifted[k] = masked ? g[k] + ((g[k] & 1) ? 1 : -1) : g[k];
+            }
+            int f = smoothness(g);
+            int f_flipped = smoothness(flipped);
+            int f_shifted = smoothness(shifted);
+            counts.regular[inverted * 2] += f_flipped > f;
+            counts.singular[inverted * 2] += f_flipped < f;
+            counts.regular[inverted * 2 + 1] += f_shifted > f;
+            counts.singular[inverted * 2 + 1] += f_shifted < f;
+        }
+    }
+    counts.groups += groups;
+}
+
+#if defined(FILEVAULT_STEGO_X86)
+
+inline __m128i load(const uint8_t* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+// Lane-wise (v & test) != 0 ? set : 0
+inline __m128i test_bits(__m128i v, const uint8_t* test, const uint8_t* set) {
+    __m128i clear = _mm_cmpeq_epi8(_mm_and_si128(v, load(test)), _mm_setzero_si128());
+    return _mm_andnot_si128(clear, load(set));
+}
+
+// Channel bits for register r of a block whose lanes hold their payload byte
+inline __m128i channel_bits(__m128i spread, int bits, int r) {
+    __m128i value = _mm_setzero_si128();
+    for (int t = 0; t < bits; ++t) {
+        value = _mm_or_si128(value, test_bits(spread, kTables.payload_bit[bits - 1][t][r], kTables.plane[t]));
+    }
+    return value;
+}
+
+// Payload bits each lane of register r contributes to its byte
+inline __m128i payload_bits(__m128i channels, int bits, int r) {
+    __m128i value = _mm_setzero_si128();
+    for (int t = 0; t < bits; ++t) {
+        value = _mm_or_si128(value, test_bits(channels, kTables.plane[t], kTables.payload_bit[bits - 1][t][r]));
+    }
+    return value;
+}
+
+inline void store_channels(uint8_t* p, __m128i bits, __m128i keep) {
+    __m128i c = load(p);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_or_si128(_mm_and_si128(c, keep), bits));
+}
+
+// Repeat every byte 2x: each unpack level doubles @p width (1, 2, 4 bytes)
+inline void repeat(__m128i v, int width, __m128i& lo, __m128i& hi) {
+    switch (width) {
+        case 1:  lo = _mm_unpacklo_epi8(v, v);  hi = _mm_unpackhi_epi8(v, v);  break;
+        case 2:  lo = _mm_unpacklo_epi16(v, v); hi = _mm_unpackhi_epi16(v, v); break;
+        default: lo = _mm_unpacklo_epi32(v, v); hi = _mm_unpackhi_epi32(v, v); break;
+    }
+}
+
+// 1, 2 and 4 bits: cpb is a power of two, so unpacks do the broadcast
+void embed_sse2(uint8_t* channels, const uint8_t* bytes, size_t blocks, int bits) {
+    const int cpb = channels_per_byte(bits);
+    const __m128i keep = _mm_set1_epi8(static_cast<char>(~((1 << bits) - 1)));
+    for (size_t b = 0; b < blocks; ++b) {
+        __m128i spread[8];
+        spread[0] = load(bytes + b * kBlock);
+        int n = 1;
+        for (int width = 1; width < cpb; width *= 2, n *= 2) {
+            for (int i = n - 1; i >= 0; --i) {
+                repeat(spread[i], width, spread[2 * i], spread[2 * i + 1]);
+            }
+        }
+        uint8_t* out = channels + b * kBlock * cpb;
+        for (int r = 0; r < cpb; ++r) {
+            store_channels(out + 16 * r, channel_bits(spread[r], bits, r), keep);
+        }
+    }
+}
+
+void extract_sse2(const uint8_t* channels, uint8_t* bytes, size_t blocks, int bits) {
+    const int cpb = channels_per_byte(bits);
+    for (size_t b = 0; b < blocks; ++b) {
+        const uint8_t* in = channels + b * kBlock * cpb;
+        uint8_t* out = bytes + b * kBlock;
+        if (bits == 1) {
+            // Bit 0 to the sign bit: one movemask reads 16 channels = 2 bytes
+            for (int r = 0; r < 8; ++r) {
+                int m = _mm_movemask_epi8(_mm_slli_epi16(load(in + 16 * r), 7));
+                out[2 * r] = static_cast<uint8_t>(m);
+                out[2 * r + 1] = static_cast<uint8_t>(m >> 8);
+            }
+            continue;
+        }
+
+        // Lanes of a byte hold disjoint bits: fold them with shifts, then pack
+        __m128i v[4];
+        for (int r = 0; r < cpb; ++r) {
+            v[r] = payload_bits(load(in + 16 * r), bits, r);
+            v[r] = _mm_or_si128(v[r], _mm_srli_epi16(v[r], 8));
+            if (cpb == 4) {
+                v[r] = _mm_and_si128(_mm_or_si128(v[r], _mm_srli_epi32(v[r], 16)), _mm_set1_epi32(0xFF));
+            } else {
+                v[r] = _mm_and_si128(v[r], _mm_set1_epi16(0xFF));
+            }
+        }
+        __m128i result = cpb == 4
+            ? _mm_packus_epi16(_mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3]))
+            : _mm_packus_epi16(v[0], v[1]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), result);
+    }
+}
+
+FILEVAULT_TARGET_SSSE3
+void embed_ssse3(uint8_t* channels, const uint8_t* bytes, size_t blocks, int bits) {
+    const int cpb = channels_per_byte(bits);
+    const __m128i keep = _mm_set1_epi8(static_cast<char>(~((1 << bits) - 1)));
+    for (size_t b = 0; b < blocks; ++b) {
+        __m128i x = load(bytes + b * kBlock);
+        uint8_t* out = channels + b * kBlock * cpb;
+        for (int r = 0; r < cpb; ++r) {
+            __m128i spread = _mm_shuffle_epi8(x, load(kTables.source[bits - 1][r]));
+            store_channels(out + 16 * r, channel_bits(spread, bits, r), keep);
+        }
+    }
+}
+
+// 3 bits: 48 channels per block, a byte may straddle two registers
+FILEVAULT_TARGET_SSSE3
+void extract3_ssse3(const uint8_t* channels, uint8_t* bytes, size_t blocks) {
+    for (size_t b = 0; b < blocks; ++b) {
+        const uint8_t* in = channels + b * kBlock * 3;
+        __m128i result = _mm_setzero_si128();
+        for (int r = 0; r < 3; ++r) {
+            __m128i v = payload_bits(load(in + 16 * r), 3, r);
+            for (int s = 0; s < 3; ++s) {
+                result = _mm_or_si128(result, _mm_shuffle_epi8(v, load(kTables.gather3[r][s])));
+            }
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes + b * kBlock), result);
+    }
+}
+
+FILEVAULT_TARGET_AVX2
+inline __m256i load256(const uint8_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+// 1, 2 and 4 bits: both 128-bit halves shuffle from the same 16 bytes
+FILEVAULT_TARGET_AVX2
+void embed_avx2(uint8_t* channels, const uint8_t* bytes, size_t blocks, int bits) {
+    const int cpb = channels_per_byte(bits);
+    const __m256i keep = _mm256_set1_epi8(static_cast<char>(~((1 << bits) - 1)));
+    const __m256i zero = _mm256_setzero_si256();
+    for (size_t b = 0; b < blocks; ++b) {
+        __m256i x = _mm256_broadcastsi128_si256(load(bytes + b * kBlock));
+        uint8_t* out = channels + b * kBlock * cpb;
+        for (int r = 0; r < cpb; r += 2) {
+            __m256i spread = _mm256_shuffle_epi8(x, load256(kTables.source[bits - 1][r]));
+            __m256i value = zero;
+            for (int t = 0; t < bits; ++t) {
+                __m256i clear = _mm256_cmpeq_epi8(
+                    _mm256_and_si256(spread, load256(kTables.payload_bit[bits - 1][t][r])), zero);
+                value = _mm256_or_si256(value, _mm256_andnot_si256(clear, _mm256_set1_epi8(static_cast<char>(1 << t))));
+            }
+            __m256i c = load256(out + 16 * r);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 16 * r),
+                                _mm256_or_si256(_mm256_and_si256(c, keep), value));
+        }
+    }
+}
+
+FILEVAULT_TARGET_AVX2
+void extract1_avx2(const uint8_t* channels, uint8_t* bytes, size_t blocks) {
+    for (size_t b = 0; b < blocks; ++b) {
+        const uint8_t* in = channels + b * kBlock * 8;
+        uint8_t* out = bytes + b * kBlock;
+        for (int q = 0; q < 4; ++q) {
+            __m256i c = load256(in + 32 * q);
+            auto m = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_slli_epi16(c, 7)));
+            for (int i = 0; i < 4; ++i) {
+                out[4 * q + i] = static_cast<uint8_t>(m >> (8 * i));
+            }
+        }
+    }
+}
+
+/*
+ * RS in 16-bit lanes: a 128-bit register holds two groups, and every
+ * 128-bit half of an AVX2 register the same. Neighbour differences come
+ * from a one-lane shift that stays inside the half; the difference that
+ * would cross into the next group is masked off, and the group sums land
+ * in 32-bit lanes 0 and 2 of each half.
+ */
+
+inline __m128i smoothness_sse2(__m128i g, __m128i within, __m128i ones) {
+    __m128i d = _mm_sub_epi16(_mm_srli_si128(g, 2), g);
+    d = _mm_and_si128(_mm_max_epi16(d, _mm_sub_epi16(_mm_setzero_si128(), d)), within);
+    __m128i s = _mm_madd_epi16(d, ones);
+    return _mm_add_epi32(s, _mm_srli_epi64(s, 32));
+}
+
+void rs_sse2(const uint8_t* plane, size_t steps, RsCounts& counts) {
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i mask = _mm_setr_epi16(0, -1, -1, 0, 0, -1, -1, 0);
+    const __m128i within = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+    const __m128i sums = _mm_setr_epi32(-1, 0, -1, 0);
+    __m128i regular[4], singular[4];
+    for (int i = 0; i < 4; ++i) {
+        regular[i] = singular[i] = _mm_setzero_si128();
+    }
+
+    for (size_t step = 0; step < steps; ++step) {
+        __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(plane + 8 * step)),
+                                      _mm_setzero_si128());
+        for (int inverted = 0; inverted < 2; ++inverted) {
+            __m128i g = inverted ? _mm_xor_si128(v, ones) : v;
+            __m128i flipped = _mm_xor_si128(g, _mm_and_si128(mask, ones));
+            __m128i step_sign = _mm_sub_epi16(_mm_slli_epi16(_mm_and_si128(g, ones), 1), ones);
+            __m128i shifted = _mm_add_epi16(g, _mm_and_si128(mask, step_sign));
+
+            __m128i f = smoothness_sse2(g, within, ones);
+            __m128i f_flipped = smoothness_sse2(flipped, within, ones);
+            __m128i f_shifted = smoothness_sse2(shifted, within, ones);
+            int k = inverted * 2;
+            regular[k] = _mm_sub_epi32(regular[k], _mm_and_si128(_mm_cmpgt_epi32(f_flipped, f), sums));
+            singular[k] = _mm_sub_epi32(singular[k], _mm_and_si128(_mm_cmpgt_epi32(f, f_flipped), sums));
+            regular[k + 1] = _mm_sub_epi32(regular[k + 1], _mm_and_si128(_mm_cmpgt_epi32(f_shifted, f), sums));
+            singular[k + 1] = _mm_sub_epi32(singular[k + 1], _mm_and_si128(_mm_cmpgt_epi32(f, f_shifted), sums));
+        }
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        alignas(16) uint32_t r[4], s[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(r), regular[i]);
+        _mm_store_si128(reinterpret_cast<__m128i*>(s), singular[i]);
+        counts.regular[i] += uint64_t{r[0]} + r[2];
+        counts.singular[i] += uint64_t{s[0]} + s[2];
+    }
+    counts.groups += steps * 2;
+}
+
+FILEVAULT_TARGET_AVX2
+inline __m256i smoothness_avx2(__m256i g, __m256i within, __m256i ones) {
+    __m256i d = _mm256_sub_epi16(_mm256_srli_si256(g, 2), g);
+    d = _mm256_and_si256(_mm256_abs_epi16(d), within);
+    __m256i s = _mm256_madd_epi16(d, ones);
+    return _mm256_add_epi32(s, _mm256_srli_epi64(s, 32));
+}
+
+FILEVAULT_TARGET_AVX2
+void rs_avx2(const uint8_t* plane, size_t steps, RsCounts& counts) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i mask = _mm256_setr_epi16(0, -1, -1, 0, 0, -1, -1, 0, 0, -1, -1, 0, 0, -1, -1, 0);
+    const __m256i within = _mm256_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0);
+    const __m256i sums = _mm256_setr_epi32(-1, 0, -1, 0, -1, 0, -1, 0);
+    __m256i regular[4], singular[4];
+    for (int i = 0; i < 4; ++i) {
+        regular[i] = singular[i] = _mm256_setzero_si256();
+    }
+
+    for (size_t step = 0; step < steps; ++step) {
+        __m256i v = _mm256_cvtepu8_epi16(load(plane + 16 * step));
+        for (int inverted = 0; inverted < 2; ++inverted) {
+            __m256i g = inverted ? _mm256_xor_si256(v, ones) : v;
+            __m256i flipped = _mm256_xor_si256(g, _mm256_and_si256(mask, ones));
+            __m256i step_sign = _mm256_sub_epi16(_mm256_slli_epi16(_mm256_and_si256(g, ones), 1), ones);
+            __m256i shifted = _mm256_add_epi16(g, _mm256_and_si256(mask, step_sign));
+
+            __m256i f = smoothness_avx2(g, within, ones);
+            __m256i f_flipped = smoothness_avx2(flipped, within, ones);
+            __m256i f_shifted = smoothness_avx2(shifted, within, ones);
+            int k = inverted * 2;
+            regular[k] = _mm256_sub_epi32(regular[k], _mm256_and_si256(_mm256_cmpgt_epi32(f_flipped, f), sums));
+            singular[k] = _mm256_sub_epi32(singular[k], _mm256_and_si256(_mm256_cmpgt_epi32(f, f_flipped), sums));
+            regular[k + 1] = _mm256_sub_epi32(regular[k + 1], _mm256_and_si256(_mm256_cmpgt_epi32(f_shifted, f), sums));
+            singular[k + 1] = _mm256_sub_epi32(singular[k + 1], _mm256_and_si256(_mm256_cmpgt_epi32(f, f_shifted), sums));
+        }
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        alignas(32) uint32_t r[8], s[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(r), regular[i]);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(s), singular[i]);
+        counts.regular[i] += uint64_t{r[0]} + r[2] + r[4] + r[6];
+        counts.singular[i] += uint64_t{s[0]} + s[2] + s[4] + s[6];
+    }
+    counts.groups += steps * 4;
+}
+
+#elif defined(FILEVAULT_STEGO_NEON)
+
+void embed_neon(uint8_t* channels, const uint8_t* bytes, size_t blocks, int bits) {
+    const int cpb = channels_per_byte(bits);
+    const uint8x16_t mask = vdupq_n_u8(static_cast<uint8_t>((1 << bits) - 1));
+    for (size_t b = 0; b < blocks; ++b) {
+        uint8x16_t x = vld1q_u8(bytes + b * kBlock);
+        uint8_t* out = channels + b * kBlock * cpb;
+        for (int r = 0; r < cpb; ++r) {
+            uint8x16_t spread = vqtbl1q_u8(x, vld1q_u8(kTables.source[bits - 1][r]));
+            uint8x16_t value = vdupq_n_u8(0);
+            for (int t = 0; t < bits; ++t) {
+                value = vorrq_u8(value, vandq_u8(vtstq_u8(spread, vld1q_u8(kTables.payload_bit[bits - 1][t][r])),
+                                                 vld1q_u8(kTables.plane[t])));
+            }
+            vst1q_u8(out + 16 * r, vbslq_u8(mask, value, vld1q_u8(out + 16 * r)));
+        }
+    }
+}
+
+void extract_neon(const uint8_t* channels, uint8_t* bytes, size_t blocks, int bits) {
+    const int cpb = channels_per_byte(bits);
+    for (size_t b = 0; b < blocks; ++b) {
+        const uint8_t* in = channels + b * kBlock * cpb;
+        uint8x16_t v[8];
+        for (int r = 0; r < cpb; ++r) {
+            uint8x16_t c = vld1q_u8(in + 16 * r);
+            v[r] = vdupq_n_u8(0);
+            for (int t = 0; t < bits; ++t) {
+                v[r] = vorrq_u8(v[r], vandq_u8(vtstq_u8(c, vld1q_u8(kTables.plane[t])),
+                                               vld1q_u8(kTables.payload_bit[bits - 1][t][r])));
+            }
+        }
+
+        uint8x16_t result;
+        if (bits == 3) {
+            result = vdupq_n_u8(0);
+            for (int r = 0; r < 3; ++r) {
+                for (int s = 0; s < 3; ++s) {
+                    result = vorrq_u8(result, vqtbl1q_u8(v[r], vld1q_u8(kTables.gather3[r][s])));
+                }
+            }
+        } else {
+            // Disjoint bits add without carries; pairwise adds keep byte order
+            for (int n = cpb; n > 1; n /= 2) {
+                for (int i = 0; i < n / 2; ++i) {
+                    v[i] = vpaddq_u8(v[2 * i], v[2 * i + 1]);
+                }
+            }
+            result = v[0];
+        }
+        vst1q_u8(bytes + b * kBlock, result);
+    }
+}
+
+#endif
+
+void check_arguments(int bits, Isa isa) {
+    if (bits < 1 || bits > 4) {
+        throw std::invalid_argument("Bits per channel must be 1-4, got " + std::to_string(bits));
+    }
+    if (!is_supported(isa)) {
+        throw std::invalid_argument(std::string("Kernel not available on this CPU: ") + isa_name(isa));
+    }
+}
+
+// Whole bytes that fit after index, in SIMD blocks
+size_t full_blocks(size_t channel_count, size_t index, size_t byte_count, int bits) {
+    size_t room = index < channel_count ? (channel_count - index) / channels_per_byte(bits) : 0;
+    return std::min(byte_count, room) / kBlock;
+}
+
+} // anonymous namespace
+
+Isa best_isa() {
+    [[maybe_unused]] const auto& cpu = core::CpuFeatures::detect();
+#if defined(FILEVAULT_STEGO_X86)
+    if (cpu.avx2) return Isa::AVX2;
+    if (cpu.ssse3) return Isa::SSSE3;
+    return Isa::SSE2;
+#elif defined(FILEVAULT_STEGO_NEON)
+    return Isa::NEON;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+bool is_supported(Isa isa) {
+    [[maybe_unused]] const auto& cpu = core::CpuFeatures::detect();
+    switch (isa) {
+        case Isa::Scalar: return true;
+#if defined(FILEVAULT_STEGO_X86)
+        case Isa::SSE2:   return true;
+        case Isa::SSSE3:  return cpu.ssse3;
+        case Isa::AVX2:   return cpu.avx2;
+#elif defined(FILEVAULT_STEGO_NEON)
+        case Isa::NEON:   return true;
+#endif
+        default:          return false;
+    }
+}
+
+const char* isa_name(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::SSE2:   return "sse2";
+        case Isa::SSSE3:  return "ssse3";
+        case Isa::AVX2:   return "avx2";
+        case Isa::NEON:   return "neon";
+    }
+    return "unknown";
+}
+
+size_t embed(std::span<uint8_t> channels, size_t index, std::span<const uint8_t> bytes,
+             int bits, Isa isa) {
+    check_arguments(bits, isa);
+    size_t blocks = full_blocks(channels.size(), index, bytes.size(), bits);
+    [[maybe_unused]] uint8_t* out = channels.data() + std::min(index, channels.size());
+
+    switch (isa) {
+#if defined(FILEVAULT_STEGO_X86)
+        case Isa::AVX2:
+            if (bits != 3) {
+                embed_avx2(out, bytes.data(), blocks, bits);
+                break;
+            }
+            [[fallthrough]];
+        case Isa::SSSE3:
+            embed_ssse3(out, bytes.data(), blocks, bits);
+            break;
+        case Isa::SSE2:
+            if (bits != 3) {
+                embed_sse2(out, bytes.data(), blocks, bits);
+                break;
+            }
+            blocks = 0;
+            break;
+#elif defined(FILEVAULT_STEGO_NEON)
+        case Isa::NEON:
+            embed_neon(out, bytes.data(), blocks, bits);
+            break;
+#endif
+        default:
+            blocks = 0;
+            break;
+    }
+
+    size_t done = blocks * kBlock;
+    return embed_scalar(channels.data(), channels.size(), index + done * channels_per_byte(bits),
+                        bytes.data() + done, bytes.size() - done, bits);
+}
+
+size_t extract(std::span<const uint8_t> channels, size_t index, std::span<uint8_t> bytes,
+               int bits, Isa isa) {
+    check_arguments(bits, isa);
+    size_t blocks = full_blocks(channels.size(), index, bytes.size(), bits);
+    [[maybe_unused]] const uint8_t* in = channels.data() + std::min(index, channels.size());
+
+    switch (isa) {
+#if defined(FILEVAULT_STEGO_X86)
+        case Isa::AVX2:
+            if (bits == 1) {
+                extract1_avx2(in, bytes.data(), blocks);
+                break;
+            }
+            [[fallthrough]];
+        case Isa::SSSE3:
+            if (bits == 3) {
+                extract3_ssse3(in, bytes.data(), blocks);
+                break;
+            }
+            [[fallthrough]];
+        case Isa::SSE2:
+            if (bits != 3) {
+                extract_sse2(in, bytes.data(), blocks, bits);
+                break;
+            }
+            blocks = 0;
+            break;
+#elif defined(FILEVAULT_STEGO_NEON)
+        case Isa::NEON:
+            extract_neon(in, bytes.data(), blocks, bits);
+            break;
+#endif
+        default:
+            blocks = 0;
+            break;
+    }
+
+    size_t done = blocks * kBlock;
+    return extract_scalar(channels.data(), channels.size(), index + done * channels_per_byte(bits),
+                          bytes.data() + done, bytes.size() - done, bits);
+}
+
+void rs_count(std::span<const uint8_t> plane, RsCounts& counts, Isa isa) {
+    if (!is_supported(isa)) {
+        throw std::invalid_argument(std::string("Kernel not available on this CPU: ") + isa_name(isa));
+    }
+    size_t groups = plane.size() / 4;
+    size_t done = 0;
+
+    switch (isa) {
+#if defined(FILEVAULT_STEGO_X86)
+        case Isa::AVX2:
+            rs_avx2(plane.data(), groups / 4, counts);
+            done = groups / 4 * 4;
+            break;
+        case Isa::SSSE3:
+        case Isa::SSE2:
+            rs_sse2(plane.data(), groups / 2, counts);
+            done = groups / 2 * 2;
+            break;
+#endif
+        default:
+            break;
+    }
+
+    rs_scalar(plane.data() + 4 * done, groups - done, counts);
+}
+
+} // namespace filevault::steganography::kernels
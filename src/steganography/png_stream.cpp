@@ -0,0 +1,401 @@
+/**
+ * @file png_stream.cpp
+ * @brief Row-streaming PNG decoder and encoder for large stego images
+ */
+
+#include "filevault/steganography/png_stream.hpp"
+#include <zlib.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace filevault::steganography {
+
+namespace {
+
+constexpr uint8_t PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+constexpr size_t IDAT_SIZE = 64 * 1024;
+constexpr size_t INPUT_BUFFER_SIZE = 64 * 1024;
+
+uint32_t read_be32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+void put_be32(uint8_t* p, uint32_t v) {
+    p[0] = static_cast<uint8_t>(v >> 24);
+    p[1] = static_cast<uint8_t>(v >> 16);
+    p[2] = static_cast<uint8_t>(v >> 8);
+    p[3] = static_cast<uint8_t>(v);
+}
+
+struct ChunkHeader {
+    uint32_t length = 0;
+    char type[5] = {};
+};
+
+bool read_chunk_header(std::ifstream& file, ChunkHeader& chunk) {
+    uint8_t raw[8];
+    if (!file.read(reinterpret_cast<char*>(raw), 8)) {
+        return false;
+    }
+    chunk.length = read_be32(raw);
+    std::memcpy(chunk.type, raw + 4, 4);
+    return true;
+}
+
+int channels_for_color_type(uint8_t color_type) {
+    switch (color_type) {
+        case 0:  return 1;
+        case 4:  return 2;
+        case 2:  return 3;
+        case 6:  return 4;
+        default: return 0;      // Palette or invalid
+    }
+}
+
+/**
+ * @brief Parse the signature and IHDR, then skip to the first IDAT
+ * @return Length of the first IDAT chunk, whose data the stream is at
+ */
+uint32_t parse_header(std::ifstream& file, PngInfo& info, std::string& error) {
+    uint8_t signature[8];
+    if (!file.read(reinterpret_cast<char*>(signature), 8) || std::memcmp(signature, PNG_SIGNATURE, 8) != 0) {
+        error = "Not a PNG image";
+        return 0;
+    }
+
+    ChunkHeader chunk;
+    uint8_t ihdr[13];
+    if (!read_chunk_header(file, chunk) || std::strcmp(chunk.type, "IHDR") != 0 || chunk.length != 13 ||
+        !file.read(reinterpret_cast<char*>(ihdr), 13)) {
+        error = "Missing PNG header";
+        return 0;
+    }
+    info.width = read_be32(ihdr);
+    info.height = read_be32(ihdr + 4);
+    info.channels = channels_for_color_type(ihdr[9]);
+    if (info.width == 0 || info.height == 0) {
+        error = "Invalid PNG dimensions";
+        return 0;
+    }
+    if (ihdr[8] != 8 || info.channels == 0 || ihdr[10] != 0 || ihdr[11] != 0 || ihdr[12] != 0) {
+        error = "Only 8-bit, non-interlaced gray/RGB(A) PNG images can be streamed";
+        return 0;
+    }
+    file.seekg(4, std::ios::cur);   // CRC
+
+    while (read_chunk_header(file, chunk)) {
+        if (std::strcmp(chunk.type, "IDAT") == 0) {
+            return chunk.length;
+        }
+        if (std::strcmp(chunk.type, "tRNS") == 0 || std::strcmp(chunk.type, "IEND") == 0) {
+            break;
+        }
+        file.seekg(static_cast<std::streamoff>(chunk.length) + 4, std::ios::cur);
+    }
+    error = std::strcmp(chunk.type, "tRNS") == 0 ? "PNG transparency chunks cannot be streamed"
+                                                 : "PNG image has no image data";
+    return 0;
+}
+
+uint8_t paeth(uint8_t a, uint8_t b, uint8_t c) {
+    int p = static_cast<int>(a) + b - c;
+    int pa = std::abs(p - a);
+    int pb = std::abs(p - b);
+    int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+/**
+ * @brief Write filter byte + filtered row to out
+ * @return Sum of |residual| as signed bytes, the adaptive filter's cost
+ */
+uint64_t filter_row(uint8_t filter, std::span<const uint8_t> row, const std::vector<uint8_t>& previous,
+                    uint8_t* out, size_t bpp) {
+    const size_t n = row.size();
+    const uint8_t* x = row.data();
+    const uint8_t* up = previous.data();
+    uint8_t* r = out + 1;
+    out[0] = filter;
+    switch (filter) {
+        case 0:
+            std::copy(x, x + n, r);
+            break;
+        case 1:
+            std::copy(x, x + std::min(bpp, n), r);
+            for (size_t i = bpp; i < n; ++i) r[i] = static_cast<uint8_t>(x[i] - x[i - bpp]);
+            break;
+        case 2:
+            for (size_t i = 0; i < n; ++i) r[i] = static_cast<uint8_t>(x[i] - up[i]);
+            break;
+        case 3:
+            for (size_t i = 0; i < std::min(bpp, n); ++i) r[i] = static_cast<uint8_t>(x[i] - (up[i] >> 1));
+            for (size_t i = bpp; i < n; ++i) {
+                r[i] = static_cast<uint8_t>(x[i] - ((static_cast<unsigned>(x[i - bpp]) + up[i]) >> 1));
+            }
+            break;
+        default:
+            for (size_t i = 0; i < std::min(bpp, n); ++i) r[i] = static_cast<uint8_t>(x[i] - up[i]);
+            for (size_t i = bpp; i < n; ++i) r[i] = static_cast<uint8_t>(x[i] - paeth(x[i - bpp], up[i], up[i - bpp]));
+            break;
+    }
+
+    uint64_t cost = 0;
+    for (size_t i = 0; i < n; ++i) {
+        cost += static_cast<uint64_t>(std::abs(static_cast<int>(static_cast<int8_t>(r[i]))));
+    }
+    return cost;
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// PngRowReader
+// ============================================================================
+
+struct PngRowReader::Inflater {
+    z_stream stream{};
+    ~Inflater() { inflateEnd(&stream); }
+};
+
+std::optional<PngInfo> PngRowReader::probe(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    PngInfo info;
+    std::string error;
+    if (!file || parse_header(file, info, error) == 0) {
+        return std::nullopt;
+    }
+    return info;
+}
+
+PngRowReader::PngRowReader(const std::string& path)
+    : file_(path, std::ios::binary) {
+    if (!file_) {
+        throw std::runtime_error("Failed to open image: " + path);
+    }
+    std::string error;
+    idat_remaining_ = parse_header(file_, info_, error);
+    if (idat_remaining_ == 0) {
+        throw std::runtime_error(error);
+    }
+
+    inflater_ = std::make_unique<Inflater>();
+    if (inflateInit(&inflater_->stream) != Z_OK) {
+        throw std::runtime_error("Failed to initialize zlib");
+    }
+    input_.resize(INPUT_BUFFER_SIZE);
+    row_.resize(info_.row_bytes() + 1);
+    previous_.assign(info_.row_bytes(), 0);
+}
+
+PngRowReader::~PngRowReader() = default;
+
+bool PngRowReader::read_compressed() {
+    while (idat_remaining_ == 0 && !idat_done_) {
+        ChunkHeader chunk;
+        file_.seekg(4, std::ios::cur);  // CRC of the previous chunk
+        if (!read_chunk_header(file_, chunk) || std::strcmp(chunk.type, "IDAT") != 0) {
+            idat_done_ = true;          // IDAT chunks are consecutive
+            return false;
+        }
+        idat_remaining_ = chunk.length;
+    }
+    if (idat_done_) {
+        return false;
+    }
+
+    size_t length = std::min<size_t>(idat_remaining_, input_.size());
+    if (!file_.read(reinterpret_cast<char*>(input_.data()), static_cast<std::streamsize>(length))) {
+        throw std::runtime_error("Truncated PNG image data");
+    }
+    idat_remaining_ -= static_cast<uint32_t>(length);
+    inflater_->stream.next_in = input_.data();
+    inflater_->stream.avail_in = static_cast<uInt>(length);
+    return true;
+}
+
+std::span<uint8_t> PngRowReader::next_row() {
+    if (rows_read_ == info_.height) {
+        return {};
+    }
+
+    auto& stream = inflater_->stream;
+    stream.next_out = row_.data();
+    stream.avail_out = static_cast<uInt>(row_.size());
+    while (stream.avail_out > 0) {
+        if (stream.avail_in == 0 && !read_compressed()) {
+            throw std::runtime_error("Truncated PNG image data");
+        }
+        int status = inflate(&stream, Z_NO_FLUSH);
+        if (status == Z_STREAM_END && stream.avail_out > 0) {
+            throw std::runtime_error("Truncated PNG image data");
+        }
+        if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR) {
+            throw std::runtime_error("Corrupt PNG image data");
+        }
+    }
+
+    // Undo the row filter in place; bpp is the channel count at 8 bits
+    const size_t bpp = static_cast<size_t>(info_.channels);
+    uint8_t* x = row_.data() + 1;
+    const uint8_t* prev = previous_.data();
+    const size_t n = info_.row_bytes();
+    switch (row_[0]) {
+        case 0:
+            break;
+        case 1:
+            for (size_t i = bpp; i < n; ++i) x[i] = static_cast<uint8_t>(x[i] + x[i - bpp]);
+            break;
+        case 2:
+            for (size_t i = 0; i < n; ++i) x[i] = static_cast<uint8_t>(x[i] + prev[i]);
+            break;
+        case 3:
+            for (size_t i = 0; i < n; ++i) {
+                unsigned left = i >= bpp ? x[i - bpp] : 0;
+                x[i] = static_cast<uint8_t>(x[i] + ((left + prev[i]) >> 1));
+            }
+            break;
+        case 4:
+            for (size_t i = 0; i < n; ++i) {
+                uint8_t left = i >= bpp ? x[i - bpp] : 0;
+                uint8_t corner = i >= bpp ? prev[i - bpp] : 0;
+                x[i] = static_cast<uint8_t>(x[i] + paeth(left, prev[i], corner));
+            }
+            break;
+        default:
+            throw std::runtime_error("Corrupt PNG image data (bad row filter)");
+    }
+
+    std::copy(x, x + n, previous_.begin());
+    rows_read_++;
+    return std::span<uint8_t>(x, n);
+}
+
+// ============================================================================
+// PngRowWriter
+// ============================================================================
+
+struct PngRowWriter::Deflater {
+    z_stream stream{};
+    bool initialized = false;
+    ~Deflater() {
+        if (initialized) {
+            deflateEnd(&stream);
+        }
+    }
+};
+
+PngRowWriter::PngRowWriter(const std::string& path, const PngInfo& info, const PngWriteOptions& options)
+    : file_(path, std::ios::binary), info_(info), options_(options) {
+    if (!file_) {
+        throw std::runtime_error("Failed to create image: " + path);
+    }
+
+    deflater_ = std::make_unique<Deflater>();
+    // Filtered rows are mostly small residuals; Z_FILTERED suits them, as in libpng
+    int strategy = options_.filter == PngFilter::None ? Z_DEFAULT_STRATEGY : Z_FILTERED;
+    if (deflateInit2(&deflater_->stream, std::clamp(options_.level, 0, 9), Z_DEFLATED, 15, 8, strategy) != Z_OK) {
+        throw std::runtime_error("Failed to initialize zlib");
+    }
+    deflater_->initialized = true;
+
+    static constexpr uint8_t color_types[] = {0, 0, 4, 2, 6};
+    uint8_t ihdr[13] = {};
+    put_be32(ihdr, info_.width);
+    put_be32(ihdr + 4, info_.height);
+    ihdr[8] = 8;
+    ihdr[9] = color_types[info_.channels];
+    file_.write(reinterpret_cast<const char*>(PNG_SIGNATURE), 8);
+    write_chunk("IHDR", ihdr);
+
+    previous_.assign(info_.row_bytes(), 0);
+    filtered_.resize(info_.row_bytes() + 1);
+    candidate_.resize(info_.row_bytes() + 1);
+    output_.resize(IDAT_SIZE);
+    deflater_->stream.next_out = output_.data();
+    deflater_->stream.avail_out = static_cast<uInt>(output_.size());
+}
+
+PngRowWriter::~PngRowWriter() = default;
+
+void PngRowWriter::write_chunk(const char type[4], std::span<const uint8_t> data) {
+    uint8_t header[8];
+    put_be32(header, static_cast<uint32_t>(data.size()));
+    std::memcpy(header + 4, type, 4);
+    uLong crc = crc32(0L, header + 4, 4);
+    if (!data.empty()) {
+        crc = crc32(crc, data.data(), static_cast<uInt>(data.size()));   // A null buffer resets the CRC
+    }
+    uint8_t trailer[4];
+    put_be32(trailer, static_cast<uint32_t>(crc));
+
+    file_.write(reinterpret_cast<const char*>(header), 8);
+    file_.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    file_.write(reinterpret_cast<const char*>(trailer), 4);
+}
+
+void PngRowWriter::deflate_row(int flush) {
+    auto& stream = deflater_->stream;
+    for (;;) {
+        int status = deflate(&stream, flush);
+        if (status == Z_STREAM_ERROR) {
+            throw std::runtime_error("PNG compression failed");
+        }
+        if (stream.avail_out == 0 || (flush == Z_FINISH && status == Z_STREAM_END)) {
+            write_chunk("IDAT", std::span<const uint8_t>(output_.data(), output_.size() - stream.avail_out));
+            stream.next_out = output_.data();
+            stream.avail_out = static_cast<uInt>(output_.size());
+        }
+        if (flush == Z_FINISH ? status == Z_STREAM_END : stream.avail_in == 0) {
+            return;
+        }
+    }
+}
+
+void PngRowWriter::write_row(std::span<const uint8_t> row) {
+    const size_t n = info_.row_bytes();
+    const size_t bpp = static_cast<size_t>(info_.channels);
+    if (row.size() != n || rows_written_ == info_.height) {
+        throw std::invalid_argument("PNG row does not fit the image");
+    }
+
+    if (options_.filter != PngFilter::Adaptive) {
+        filter_row(static_cast<uint8_t>(options_.filter), row, previous_, filtered_.data(), bpp);
+    } else {
+        // Pick the filter with the smallest sum of |signed residuals|
+        uint64_t best_cost = UINT64_MAX;
+        for (uint8_t filter = 0; filter <= 4; ++filter) {
+            uint64_t cost = filter_row(filter, row, previous_, candidate_.data(), bpp);
+            if (cost < best_cost) {
+                best_cost = cost;
+                filtered_.swap(candidate_);
+            }
+        }
+    }
+
+    auto& stream = deflater_->stream;
+    stream.next_in = filtered_.data();
+    stream.avail_in = static_cast<uInt>(filtered_.size());
+    deflate_row(Z_NO_FLUSH);
+
+    std::copy(row.begin(), row.end(), previous_.begin());
+    rows_written_++;
+}
+
+void PngRowWriter::finish() {
+    if (rows_written_ != info_.height) {
+        throw std::runtime_error("PNG image is missing rows");
+    }
+    deflater_->stream.avail_in = 0;
+    deflate_row(Z_FINISH);
+    write_chunk("IEND", {});
+    file_.flush();
+    if (!file_) {
+        throw std::runtime_error("Failed to write PNG image");
+    }
+}
+
+} // namespace filevault::steganography
@@ -0,0 +1,171 @@
+/**
+ * @file steganalysis.cpp
+ * @brief Chi-square and RS detection of LSB payloads
+ */
+
+#include "filevault/steganography/steganalysis.hpp"
+#include "filevault/steganography/image_rows.hpp"
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <vector>
+
+namespace filevault::steganography {
+
+namespace {
+
+/**
+ * @brief Regularized upper incomplete gamma function Q(a, x)
+ *
+ * Series below a + 1, continued fraction (modified Lentz) above.
+ */
+double gamma_q(double a, double x) {
+    if (x <= 0) {
+        return 1.0;
+    }
+    const double prefix = std::exp(-x + a * std::log(x) - std::lgamma(a));
+    if (x < a + 1) {
+        double term = 1.0 / a;
+        double sum = term;
+        for (int n = 1; n < 1000; ++n) {
+            term *= x / (a + n);
+            sum += term;
+            if (std::abs(term) < std::abs(sum) * 1e-15) {
+                break;
+            }
+        }
+        return std::clamp(1.0 - sum * prefix, 0.0, 1.0);
+    }
+
+    constexpr double tiny = 1e-300;
+    double b = x + 1 - a;
+    double c = 1.0 / tiny;
+    double d = 1.0 / b;
+    double h = d;
+    for (int i = 1; i < 1000; ++i) {
+        double an = -i * (i - a);
+        b += 2;
+        d = an * d + b;
+        d = std::abs(d) < tiny ? tiny : d;
+        c = b + an / c;
+        c = std::abs(c) < tiny ? tiny : c;
+        d = 1.0 / d;
+        double delta = d * c;
+        h *= delta;
+        if (std::abs(delta - 1.0) < 1e-15) {
+            break;
+        }
+    }
+    return std::clamp(prefix * h, 0.0, 1.0);
+}
+
+} // anonymous namespace
+
+double Steganalysis::chi_square_p(const std::array<uint64_t, 256>& histogram) {
+    double chi = 0;
+    int pairs = 0;
+    for (size_t i = 0; i < 256; i += 2) {
+        double expected = (static_cast<double>(histogram[i]) + static_cast<double>(histogram[i + 1])) / 2;
+        if (expected < 5) {
+            continue;
+        }
+        double d = static_cast<double>(histogram[i]) - expected;
+        chi += d * d / expected;
+        ++pairs;
+    }
+    if (pairs < 2) {
+        return 0;
+    }
+    return gamma_q((pairs - 1) / 2.0, chi / 2);
+}
+
+double Steganalysis::rs_rate(const kernels::RsCounts& counts) {
+    if (counts.groups == 0) {
+        return 0;
+    }
+    auto diff = [&](int i) {
+        return (static_cast<double>(counts.regular[i]) - static_cast<double>(counts.singular[i])) /
+               static_cast<double>(counts.groups);
+    };
+    double d0 = diff(0);        // R_M - S_M
+    double d0_neg = diff(1);    // R_-M - S_-M
+    double d1 = diff(2);        // Same with all LSBs inverted
+    double d1_neg = diff(3);
+
+    // 2(d1 + d0)x^2 + (d-0 - d-1 - d1 - 3d0)x + d0 - d-0 = 0, rate = x / (x - 1/2)
+    double a = 2 * (d1 + d0);
+    double b = d0_neg - d1_neg - d1 - 3 * d0;
+    double c = d0 - d0_neg;
+    double x;
+    if (std::abs(a) < 1e-12) {
+        if (std::abs(b) < 1e-12) {
+            return 0;
+        }
+        x = -c / b;
+    } else {
+        double disc = b * b - 4 * a * c;
+        if (disc < 0) {
+            return 0;
+        }
+        double root = std::sqrt(disc);
+        double x1 = (-b + root) / (2 * a);
+        double x2 = (-b - root) / (2 * a);
+        x = std::abs(x1) < std::abs(x2) ? x1 : x2;
+    }
+    if (std::abs(x - 0.5) < 1e-12) {
+        return 1;
+    }
+    return std::clamp(x / (x - 0.5), 0.0, 1.0);
+}
+
+ScanReport Steganalysis::scan(const std::string& path, kernels::Isa isa) {
+    ScanReport report;
+    report.path = path;
+    try {
+        ImageRows rows(path);
+        report.width = rows.width();
+        report.height = rows.height();
+        report.channels = rows.channels();
+
+        // Gray(+alpha) has one colour channel, RGB(A) three
+        const int channels = rows.channels();
+        const int colours = channels >= 3 ? 3 : 1;
+        const uint32_t rows_per_checkpoint = std::max<uint32_t>(1, (rows.height() + CHECKPOINTS - 1) / CHECKPOINTS);
+
+        std::array<uint64_t, 256> histogram{};
+        kernels::RsCounts counts;
+        std::vector<uint8_t> plane(rows.width());
+        bool leading = true;
+        uint32_t y = 0;
+        for (auto row = rows.next_row(); !row.empty(); row = rows.next_row()) {
+            for (int c = 0; c < colours; ++c) {
+                for (uint32_t x = 0; x < rows.width(); ++x) {
+                    uint8_t value = row[static_cast<size_t>(x) * channels + c];
+                    plane[x] = value;
+                    ++histogram[value];
+                }
+                kernels::rs_count(plane, counts, isa);
+            }
+
+            ++y;
+            if (y % rows_per_checkpoint == 0 || y == rows.height()) {
+                double p = chi_square_p(histogram);
+                if (y <= rows_per_checkpoint) {
+                    report.chi_square = p;
+                }
+                leading = leading && p >= 0.5;
+                if (leading) {
+                    report.payload_extent = static_cast<double>(y) / rows.height();
+                }
+            }
+        }
+
+        report.rs_rate = rs_rate(counts);
+        report.score = std::max(report.chi_square, report.rs_rate);
+    } catch (const std::exception& e) {
+        report.error = e.what();
+    }
+    return report;
+}
+
+} // namespace filevault::steganography
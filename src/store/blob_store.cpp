@@ -0,0 +1,893 @@
+/**
+ * @file blob_store.cpp
+ * @brief Encrypted log-structured key-value store
+ */
+
+#include "filevault/store/blob_store.hpp"
+#include "filevault/core/crypto_engine.hpp"
+#include <botan/mem_ops.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstring>
+#include <fmt/core.h>
+
+namespace filevault {
+namespace store {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Header file: "FVBS" | u8 version | u8 algorithm | u8 KDF | u8 security level
+//              | u64 segment bytes | salt[32]            (the associated data)
+//              | nonce[12] | sealed data key[32] | tag[16] (the key slot)
+constexpr const char* HEADER_FILE = "store.hdr";
+constexpr uint8_t MAGIC[4] = {'F', 'V', 'B', 'S'};
+constexpr uint8_t FORMAT_VERSION = 1;
+constexpr size_t SALT_SIZE = 32;
+constexpr size_t PREFIX_SIZE = 16 + SALT_SIZE;
+constexpr size_t NONCE_SIZE = 12;
+constexpr size_t DATA_KEY_SIZE = 32;
+constexpr size_t TAG_SIZE = 16;
+constexpr size_t KEY_SLOT_SIZE = NONCE_SIZE + DATA_KEY_SIZE + TAG_SIZE;
+constexpr size_t HEADER_SIZE = PREFIX_SIZE + KEY_SLOT_SIZE;
+constexpr core::AlgorithmType ALGORITHM = core::AlgorithmType::AES_256_GCM;
+
+constexpr uint64_t MIN_SEGMENT_BYTES = 64 * 1024;
+constexpr uint64_t MAX_SEGMENT_BYTES = uint64_t(1) << 32;
+
+// Segment file "<16 hex digits>.seg": "FVSG" | u8 version | zeros[3] | u64 segment id,
+// then records, then (once sealed) a footer record and the trailer
+constexpr const char* SEGMENT_SUFFIX = ".seg";
+constexpr uint8_t SEGMENT_MAGIC[4] = {'F', 'V', 'S', 'G'};
+constexpr size_t SEGMENT_HEADER_SIZE = 16;
+
+// Record: u32 body size | u8 type | nonce[12] | body | tag[16]
+constexpr size_t RECORD_HEAD_SIZE = 4 + 1 + NONCE_SIZE;
+constexpr size_t RECORD_OVERHEAD = RECORD_HEAD_SIZE + TAG_SIZE;
+constexpr size_t ASSOCIATED_DATA_SIZE = 8 + 8 + 5;   // Segment id, offset, body size and type
+constexpr uint8_t RECORD_PUT = 1;                    // Body: u16 key size | key | value
+constexpr uint8_t RECORD_DELETE = 2;                 // Body: u16 key size | key
+constexpr uint8_t RECORD_FOOTER = 3;                 // Body: u32 count | entries
+
+// Footer entry: u8 type | u16 key size | key | u64 offset | u32 record size
+constexpr size_t FOOTER_ENTRY_SIZE = 1 + 2 + 8 + 4;
+
+// Trailer: u64 footer offset | u32 footer size | "FVSF"
+constexpr uint8_t TRAILER_MAGIC[4] = {'F', 'V', 'S', 'F'};
+constexpr size_t TRAILER_SIZE = 16;
+
+void put_u16(uint8_t* out, uint16_t value) {
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+void put_u32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+void put_u64(uint8_t* out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+uint16_t get_u16(const uint8_t* in) {
+    return static_cast<uint16_t>(in[0] | in[1] << 8);
+}
+
+uint32_t get_u32(const uint8_t* in) {
+    return uint32_t(in[0]) | uint32_t(in[1]) << 8 | uint32_t(in[2]) << 16 | uint32_t(in[3]) << 24;
+}
+
+uint64_t get_u64(const uint8_t* in) {
+    return uint64_t(get_u32(in)) | uint64_t(get_u32(in + 4)) << 32;
+}
+
+/**
+ * @brief Segment id from a file name, or 0 if it is not a segment
+ */
+uint64_t parse_segment_name(const std::string& name) {
+    const size_t digits = 16;
+    if (name.size() != digits + std::strlen(SEGMENT_SUFFIX) ||
+        name.compare(digits, std::string::npos, SEGMENT_SUFFIX) != 0) {
+        return 0;
+    }
+    uint64_t id = 0;
+    for (size_t i = 0; i < digits; ++i) {
+        char c = name[i];
+        int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+        if (digit < 0) {
+            return 0;
+        }
+        id = id << 4 | uint64_t(digit);
+    }
+    return id;
+}
+
+} // anonymous namespace
+
+BlobStore::BlobStore(fs::path directory)
+    : directory_(std::move(directory)) {}
+
+BlobStore::~BlobStore() {
+    if (unlocked()) {
+        auto closed = close();
+        if (!closed) {
+            spdlog::warn("Store {} not sealed on close: {}", directory_.string(), closed.error_message);
+        }
+    }
+}
+
+bool BlobStore::is_store(const fs::path& directory) {
+    auto head = utils::FileIO::read_range((directory / HEADER_FILE).string(), 0, sizeof(MAGIC));
+    return head && head.value.size() == sizeof(MAGIC) && std::memcmp(head.value.data(), MAGIC, sizeof(MAGIC)) == 0;
+}
+
+fs::path BlobStore::header_path() const {
+    return directory_ / HEADER_FILE;
+}
+
+fs::path BlobStore::segment_path(uint64_t id) const {
+    return directory_ / fmt::format("{:016x}{}", id, SEGMENT_SUFFIX);
+}
+
+std::vector<uint8_t> BlobStore::header_prefix(const std::vector<uint8_t>& salt) const {
+    std::vector<uint8_t> prefix(PREFIX_SIZE, 0);
+    std::memcpy(prefix.data(), MAGIC, sizeof(MAGIC));
+    prefix[4] = FORMAT_VERSION;
+    prefix[5] = static_cast<uint8_t>(ALGORITHM);
+    prefix[6] = static_cast<uint8_t>(config_.kdf);
+    prefix[7] = static_cast<uint8_t>(config_.level);
+    put_u64(&prefix[8], config_.segment_bytes);
+    std::copy(salt.begin(), salt.end(), prefix.begin() + 16);
+    return prefix;
+}
+
+std::vector<uint8_t> BlobStore::derive_slot_key(const std::string& password, const std::vector<uint8_t>& salt) const {
+    core::CryptoEngine engine;
+    engine.initialize();
+    core::EncryptionConfig config;
+    config.algorithm = ALGORITHM;
+    config.kdf = config_.kdf;
+    config.level = config_.level;
+    config.apply_security_level();
+    return engine.derive_key(password, salt, config);
+}
+
+core::Result<std::vector<uint8_t>> BlobStore::seal_header(const std::string& password,
+                                                          const std::vector<uint8_t>& salt) const {
+    core::CryptoEngine engine;
+    engine.initialize();
+    auto* slot_cipher = engine.get_algorithm(ALGORITHM);
+    if (!slot_cipher) {
+        return core::Result<std::vector<uint8_t>>::error("Algorithm not available");
+    }
+
+    auto header = header_prefix(salt);
+    auto slot_key = derive_slot_key(password, salt);
+    core::EncryptionConfig slot;
+    slot.nonce = core::CryptoEngine::generate_nonce(NONCE_SIZE);
+    slot.associated_data = header;
+    auto sealed = slot_cipher->encrypt(data_key_, slot_key, slot);
+    Botan::secure_scrub_memory(slot_key.data(), slot_key.size());
+    if (!sealed.success || !sealed.tag || sealed.data.size() != DATA_KEY_SIZE) {
+        return core::Result<std::vector<uint8_t>>::error("Cannot seal the store key: " + sealed.error_message);
+    }
+
+    header.insert(header.end(), slot.nonce->begin(), slot.nonce->end());
+    header.insert(header.end(), sealed.data.begin(), sealed.data.end());
+    header.insert(header.end(), sealed.tag->begin(), sealed.tag->end());
+    return core::Result<std::vector<uint8_t>>::ok(std::move(header));
+}
+
+core::Result<void> BlobStore::start_session() {
+    if (!engine_) {
+        engine_ = std::make_unique<core::CryptoEngine>();
+        engine_->initialize();
+    }
+    auto* algo = engine_->get_algorithm(ALGORITHM);
+    if (!algo) {
+        return core::Result<void>::error("Algorithm not available");
+    }
+    session_ = algo->create_session(data_key_);
+    if (!session_) {
+        return core::Result<void>::error("Failed to create cipher session");
+    }
+    nonces_ = std::make_unique<core::CounterNonce>(NONCE_SIZE);
+    record_config_.algorithm = ALGORITHM;
+    record_config_.associated_data.emplace(ASSOCIATED_DATA_SIZE, 0);
+    return core::Result<void>::ok();
+}
+
+core::Result<void> BlobStore::create(const std::string& password, const BlobStoreConfig& config) {
+    std::error_code ec;
+    if (fs::exists(directory_, ec) && !fs::is_empty(directory_, ec)) {
+        return core::Result<void>::error("Directory is not empty: " + directory_.string());
+    }
+    if (config.segment_bytes < MIN_SEGMENT_BYTES || config.segment_bytes > MAX_SEGMENT_BYTES) {
+        return core::Result<void>::error("Segment size must be from 64 KiB to 4 GiB");
+    }
+
+    config_ = config;
+    core::SecureBytes data_key(DATA_KEY_SIZE);
+    core::RandomService::rng().randomize(data_key.data(), data_key.size());
+    data_key_ = std::move(data_key);
+
+    auto salt = core::CryptoEngine::generate_salt(SALT_SIZE);
+    auto header = seal_header(password, salt);
+    if (!header) {
+        return core::Result<void>::error(header.error_message);
+    }
+    fs::create_directories(directory_, ec);
+    auto written = utils::FileIO::write_file(header_path().string(), header.value);
+    if (!written) {
+        return written;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    salt_ = std::move(salt);
+    key_slot_.assign(header.value.begin() + PREFIX_SIZE, header.value.end());
+    read_only_ = false;
+    next_segment_ = 1;
+    return start_session();
+}
+
+core::Result<void> BlobStore::open() {
+    auto head = utils::FileIO::read_range(header_path().string(), 0, HEADER_SIZE);
+    if (!head) {
+        return core::Result<void>::error("No store at " + directory_.string());
+    }
+    const auto& data = head.value;
+    if (data.size() != HEADER_SIZE || std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0) {
+        return core::Result<void>::error("Not a store: " + directory_.string());
+    }
+    if (data[4] != FORMAT_VERSION) {
+        return core::Result<void>::error(fmt::format("Unsupported store version {}", data[4]));
+    }
+
+    BlobStoreConfig config;
+    config.kdf = static_cast<core::KDFType>(data[6]);
+    config.level = static_cast<core::SecurityLevel>(data[7]);
+    config.segment_bytes = get_u64(&data[8]);
+    if (data[5] != static_cast<uint8_t>(ALGORITHM) || config.segment_bytes < MIN_SEGMENT_BYTES ||
+        config.segment_bytes > MAX_SEGMENT_BYTES) {
+        return core::Result<void>::error("Store header is corrupt: " + header_path().string());
+    }
+
+    config_ = config;
+    salt_.assign(data.begin() + 16, data.begin() + PREFIX_SIZE);
+    key_slot_.assign(data.begin() + PREFIX_SIZE, data.end());
+    return core::Result<void>::ok();
+}
+
+core::Result<void> BlobStore::unlock(const std::string& password, bool read_only) {
+    if (unlocked()) {
+        auto closed = close();
+        if (!closed) {
+            return closed;
+        }
+    }
+    auto opened = open();
+    if (!opened) {
+        return opened;
+    }
+
+    core::CryptoEngine engine;
+    engine.initialize();
+    auto* slot_cipher = engine.get_algorithm(ALGORITHM);
+    if (!slot_cipher) {
+        return core::Result<void>::error("Algorithm not available");
+    }
+    auto slot_key = derive_slot_key(password, salt_);
+    core::EncryptionConfig slot;
+    slot.nonce = core::ShortBytes(key_slot_.begin(), key_slot_.begin() + NONCE_SIZE);
+    slot.tag = core::ShortBytes(key_slot_.end() - TAG_SIZE, key_slot_.end());
+    slot.associated_data = header_prefix(salt_);
+    auto opened_key = slot_cipher->decrypt(
+        std::span<const uint8_t>(key_slot_).subspan(NONCE_SIZE, DATA_KEY_SIZE), slot_key, slot);
+    Botan::secure_scrub_memory(slot_key.data(), slot_key.size());
+    if (!opened_key.success || opened_key.data.size() != DATA_KEY_SIZE) {
+        return core::Result<void>::error("Wrong password for store (or the header was modified)");
+    }
+
+    std::vector<uint64_t> ids;
+    std::error_code ec;
+    for (fs::directory_iterator it(directory_, ec), end; !ec && it != end; it.increment(ec)) {
+        if (auto id = parse_segment_name(it->path().filename().string())) {
+            ids.push_back(id);
+        }
+    }
+    if (ec) {
+        return core::Result<void>::error("Cannot list " + directory_.string() + ": " + ec.message());
+    }
+    std::sort(ids.begin(), ids.end());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    data_key_.assign(opened_key.data.begin(), opened_key.data.end());
+    Botan::secure_scrub_memory(opened_key.data.data(), opened_key.data.size());
+    read_only_ = read_only;
+    next_segment_ = ids.empty() ? 1 : ids.back() + 1;
+    auto started = start_session();
+    if (!started) {
+        return started;
+    }
+
+    for (auto id : ids) {
+        auto loaded = load_segment(id);
+        if (!loaded) {
+            session_.reset();
+            index_.clear();
+            segments_.clear();
+            active_ = 0;
+            buffer_.clear();
+            live_bytes_ = 0;
+            return loaded;
+        }
+    }
+    return core::Result<void>::ok();
+}
+
+core::Result<void> BlobStore::change_password(const std::string& new_password) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto writable = check_writable();
+    if (!writable) {
+        return writable;
+    }
+    auto salt = core::CryptoEngine::generate_salt(SALT_SIZE);
+    auto header = seal_header(new_password, salt);
+    if (!header) {
+        return core::Result<void>::error(header.error_message);
+    }
+    auto written = utils::FileIO::write_file(header_path().string(), header.value);
+    if (!written) {
+        return written;
+    }
+    salt_ = std::move(salt);
+    key_slot_.assign(header.value.begin() + PREFIX_SIZE, header.value.end());
+    return core::Result<void>::ok();
+}
+
+core::Result<void> BlobStore::check_writable() const {
+    if (!unlocked()) {
+        return core::Result<void>::error("Store is locked");
+    }
+    if (read_only_) {
+        return core::Result<void>::error("Store is open read-only");
+    }
+    return core::Result<void>::ok();
+}
+
+void BlobStore::set_associated_data(uint64_t segment, uint64_t offset, const uint8_t* head) {
+    auto& ad = *record_config_.associated_data;
+    put_u64(&ad[0], segment);
+    put_u64(&ad[8], offset);
+    std::memcpy(&ad[16], head, 5);
+}
+
+core::Result<BlobStore::Location> BlobStore::append(uint8_t type) {
+    if (!active_) {
+        auto started = start_segment();
+        if (!started) {
+            return core::Result<Location>::error(started.error_message);
+        }
+    }
+
+    uint8_t head[RECORD_HEAD_SIZE];
+    put_u32(head, static_cast<uint32_t>(body_.size()));
+    head[4] = type;
+    nonces_->next(std::span<uint8_t>(head + 5, NONCE_SIZE));
+    set_associated_data(active_, active_size_, head);
+    record_config_.nonce = core::ShortBytes(head + 5, head + RECORD_HEAD_SIZE);
+    record_config_.tag.reset();
+    auto sealed = session_->encrypt_in_place(body_, record_config_);
+    if (!sealed.success || !sealed.tag || sealed.tag->size() != TAG_SIZE) {
+        return core::Result<Location>::error(sealed.success ? "Unexpected tag size" : sealed.error_message);
+    }
+
+    buffer_.insert(buffer_.end(), head, head + RECORD_HEAD_SIZE);
+    buffer_.insert(buffer_.end(), body_.begin(), body_.end());
+    buffer_.insert(buffer_.end(), sealed.tag->begin(), sealed.tag->end());
+    Location location{active_, active_size_, static_cast<uint32_t>(RECORD_OVERHEAD + body_.size())};
+    active_size_ += location.size;
+    if (buffer_.size() >= WRITE_BUFFER_BYTES) {
+        auto written = write_buffer();
+        if (!written) {
+            return core::Result<Location>::error(written.error_message);
+        }
+    }
+    return core::Result<Location>::ok(location);
+}
+
+core::Result<void> BlobStore::start_segment() {
+    uint64_t id = next_segment_++;
+    auto created = utils::RandomAccessFile::create(segment_path(id).string(), 0);
+    if (!created) {
+        return core::Result<void>::error(created.error_message);
+    }
+    segments_[id] = Segment{std::move(created.value), 0};
+    active_ = id;
+    active_entries_.clear();
+
+    uint8_t header[SEGMENT_HEADER_SIZE] = {};
+    std::memcpy(header, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+    header[4] = FORMAT_VERSION;
+    put_u64(header + 8, id);
+    buffer_.assign(header, header + SEGMENT_HEADER_SIZE);
+    active_size_ = SEGMENT_HEADER_SIZE;
+    return core::Result<void>::ok();
+}
+
+core::Result<void> BlobStore::write_buffer() {
+    if (buffer_.empty()) {
+        return core::Result<void>::ok();
+    }
+    auto& segment = segments_.at(active_);
+    auto written = segment.file.write_at(segment.size, buffer_);
+    if (!written) {
+        return written;
+    }
+    segment.size += buffer_.size();
+    buffer_.clear();
+    return core::Result<void>::ok();
+}
+
+core::Result<void> BlobStore::seal_active() {
+    if (!active_) {
+        return core::Result<void>::ok();
+    }
+
+    size_t footer_size = 4;
+    for (const auto& [key, entry] : active_entries_) {
+        footer_size += FOOTER_ENTRY_SIZE + key.size();
+    }
+    body_.resize(footer_size);
+    put_u32(body_.data(), static_cast<uint32_t>(active_entries_.size()));
+    uint8_t* out = body_.data() + 4;
+    for (const auto& [key, entry] : active_entries_) {
+        out[0] = entry.type;
+        put_u16(out + 1, static_cast<uint16_t>(key.size()));
+        std::memcpy(out + 3, key.data(), key.size());
+        put_u64(out + 3 + key.size(), entry.offset);
+        put_u32(out + 11 + key.size(), entry.size);
+        out += FOOTER_ENTRY_SIZE + key.size();
+    }
+    auto footer = append(RECORD_FOOTER);
+    if (!footer) {
+        return core::Result<void>::error(footer.error_message);
+    }
+
+    uint8_t trailer[TRAILER_SIZE];
+    put_u64(trailer, footer.value.offset);
+    put_u32(trailer + 8, footer.value.size);
+    std::memcpy(trailer + 12, TRAILER_MAGIC, sizeof(TRAILER_MAGIC));
+    buffer_.insert(buffer_.end(), trailer, trailer + TRAILER_SIZE);
+    active_size_ += TRAILER_SIZE;
+
+    auto written = write_buffer();
+    if (written) {
+        written = segments_.at(active_).file.sync();
+    }
+    if (!written) {
+        return written;
+    }
+    active_ = 0;
+    active_entries_.clear();
+    return core::Result<void>::ok();
+}
+
+core::Result<void> BlobStore::read_record(const Location& location, std::vector<uint8_t>& record) {
+    auto segment = segments_.find(location.segment);
+    if (segment == segments_.end()) {
+        return core::Result<void>::error(fmt::format("Segment {} is missing", location.segment));
+    }
+    record.resize(location.size);
+    uint64_t on_disk = segment->second.size;
+    if (location.segment == active_ && location.offset >= on_disk) {
+        std::memcpy(record.data(), buffer_.data() + (location.offset - on_disk), location.size);
+        return core::Result<void>::ok();
+    }
+    return segment->second.file.read_at(location.offset, record);
+}
+
+bool BlobStore::open_record(uint64_t segment, uint64_t offset, std::vector<uint8_t>& record, uint8_t& type,
+                            std::vector<uint8_t>& body) {
+    if (record.size() < RECORD_OVERHEAD || get_u32(record.data()) != record.size() - RECORD_OVERHEAD) {
+        return false;
+    }
+    type = record[4];
+    set_associated_data(segment, offset, record.data());
+    record_config_.nonce = core::ShortBytes(record.begin() + 5, record.begin() + RECORD_HEAD_SIZE);
+    record_config_.tag = core::ShortBytes(record.end() - TAG_SIZE, record.end());
+    body.assign(record.begin() + RECORD_HEAD_SIZE, record.end() - TAG_SIZE);
+    return session_->decrypt_in_place(body, record_config_).success;
+}
+
+core::Result<bool> BlobStore::read_footer(uint64_t id, Segment& segment, EntryMap& entries) {
+    uint8_t trailer[TRAILER_SIZE];
+    if (segment.size < SEGMENT_HEADER_SIZE + RECORD_OVERHEAD + TRAILER_SIZE ||
+        !segment.file.read_at(segment.size - TRAILER_SIZE, trailer) ||
+        std::memcmp(trailer + 12, TRAILER_MAGIC, sizeof(TRAILER_MAGIC)) != 0) {
+        return core::Result<bool>::ok(false);
+    }
+
+    auto corrupt = core::Result<bool>::error(fmt::format("Segment {} is corrupt", segment_path(id).string()));
+    uint64_t footer_offset = get_u64(trailer);
+    uint32_t footer_size = get_u32(trailer + 8);
+    if (footer_offset < SEGMENT_HEADER_SIZE || footer_offset > segment.size ||
+        segment.size - footer_offset != uint64_t(footer_size) + TRAILER_SIZE) {
+        return corrupt;
+    }
+    record_.resize(footer_size);
+    uint8_t type = 0;
+    if (!segment.file.read_at(footer_offset, record_) || !open_record(id, footer_offset, record_, type, body_) ||
+        type != RECORD_FOOTER || body_.size() < 4) {
+        return corrupt;
+    }
+
+    uint32_t count = get_u32(body_.data());
+    size_t at = 4;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (body_.size() - at < FOOTER_ENTRY_SIZE) {
+            return corrupt;
+        }
+        const uint8_t* in = body_.data() + at;
+        uint16_t key_size = get_u16(in + 1);
+        if (body_.size() - at < FOOTER_ENTRY_SIZE + key_size) {
+            return corrupt;
+        }
+        FooterEntry entry{in[0], get_u64(in + 3 + key_size), get_u32(in + 11 + key_size)};
+        if ((entry.type != RECORD_PUT && entry.type != RECORD_DELETE) || entry.offset < SEGMENT_HEADER_SIZE ||
+            entry.offset > footer_offset || entry.size > footer_offset - entry.offset) {
+            return corrupt;
+        }
+        entries[std::string(reinterpret_cast<const char*>(in + 3), key_size)] = entry;
+        at += FOOTER_ENTRY_SIZE + key_size;
+    }
+    return core::Result<bool>::ok(true);
+}
+
+uint64_t BlobStore::scan_segment(uint64_t id, Segment& segment, EntryMap& entries) {
+    uint64_t offset = SEGMENT_HEADER_SIZE;
+    while (segment.size - offset >= RECORD_OVERHEAD) {
+        uint8_t head[4];
+        if (!segment.file.read_at(offset, head)) {
+            break;
+        }
+        uint64_t size = RECORD_OVERHEAD + uint64_t(get_u32(head));
+        if (size > segment.size - offset) {
+            break;
+        }
+        record_.resize(size);
+        uint8_t type = 0;
+        if (!segment.file.read_at(offset, record_) || !open_record(id, offset, record_, type, body_)) {
+            break;
+        }
+        if (type == RECORD_FOOTER) {
+            break;      // The trailer after it was lost; the footer is rewritten on sealing
+        }
+        if ((type != RECORD_PUT && type != RECORD_DELETE) || body_.size() < 2 ||
+            body_.size() - 2 < get_u16(body_.data())) {
+            break;
+        }
+        entries[std::string(reinterpret_cast<const char*>(body_.data() + 2), get_u16(body_.data()))] =
+            FooterEntry{type, offset, static_cast<uint32_t>(size)};
+        offset += size;
+    }
+    return offset;
+}
+
+void BlobStore::apply(const std::string& key, const FooterEntry& entry, uint64_t segment) {
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        live_bytes_ -= it->second.size;
+    }
+    if (entry.type == RECORD_DELETE) {
+        if (it != index_.end()) {
+            index_.erase(it);
+        }
+        return;
+    }
+    Location location{segment, entry.offset, entry.size};
+    if (it != index_.end()) {
+        it->second = location;
+    } else {
+        index_.emplace(key, location);
+    }
+    live_bytes_ += entry.size;
+}
+
+core::Result<void> BlobStore::load_segment(uint64_t id) {
+    auto path = segment_path(id);
+    auto file = utils::RandomAccessFile::open(path.string(), !read_only_);
+    if (!file) {
+        return core::Result<void>::error(file.error_message);
+    }
+    Segment segment{std::move(file.value), 0};
+    segment.size = segment.file.size();
+
+    uint8_t header[SEGMENT_HEADER_SIZE];
+    if (segment.size < SEGMENT_HEADER_SIZE || !segment.file.read_at(0, header) ||
+        std::memcmp(header, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) != 0 || header[4] != FORMAT_VERSION ||
+        get_u64(header + 8) != id) {
+        return core::Result<void>::error("Not a store segment: " + path.string());
+    }
+
+    EntryMap entries;
+    auto sealed = read_footer(id, segment, entries);
+    if (!sealed) {
+        return core::Result<void>::error(sealed.error_message);
+    }
+    if (!sealed.value) {
+        // Left open by a session that did not close the store
+        uint64_t end = scan_segment(id, segment, entries);
+        if (end < segment.size) {
+            spdlog::warn("Segment {} ends with {} bytes of incomplete records{}", path.string(), segment.size - end,
+                         read_only_ ? "" : "; they are discarded");
+        }
+        if (!read_only_) {
+            std::error_code ec;
+            if (entries.empty()) {
+                segment.file = utils::RandomAccessFile();
+                fs::remove(path, ec);
+                return core::Result<void>::ok();
+            }
+            if (end < segment.size) {
+                fs::resize_file(path, end, ec);
+                if (ec) {
+                    return core::Result<void>::error("Cannot truncate " + path.string() + ": " + ec.message());
+                }
+                segment.size = end;
+            }
+            segments_[id] = std::move(segment);
+            active_ = id;
+            active_size_ = end;
+            active_entries_ = entries;
+            buffer_.clear();
+            auto resealed = seal_active();
+            if (!resealed) {
+                return resealed;
+            }
+            for (const auto& [key, entry] : entries) {
+                apply(key, entry, id);
+            }
+            return core::Result<void>::ok();
+        }
+    }
+
+    for (const auto& [key, entry] : entries) {
+        apply(key, entry, id);
+    }
+    segments_[id] = std::move(segment);
+    return core::Result<void>::ok();
+}
+
+core::Result<void> BlobStore::put(std::string_view key, std::span<const uint8_t> value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto writable = check_writable();
+    if (!writable) {
+        return writable;
+    }
+    if (key.empty() || key.size() > MAX_KEY_SIZE) {
+        return core::Result<void>::error(fmt::format("Keys must be 1 to {} bytes", MAX_KEY_SIZE));
+    }
+    if (value.size() > MAX_VALUE_SIZE) {
+        return core::Result<void>::error(fmt::format("Values are limited to {} bytes", MAX_VALUE_SIZE));
+    }
+
+    body_.resize(2 + key.size() + value.size());
+    put_u16(body_.data(), static_cast<uint16_t>(key.size()));
+    std::memcpy(body_.data() + 2, key.data(), key.size());
+    if (!value.empty()) {
+        std::memcpy(body_.data() + 2 + key.size(), value.data(), value.size());
+    }
+    auto location = append(RECORD_PUT);
+    if (!location) {
+        return core::Result<void>::error(location.error_message);
+    }
+
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        live_bytes_ -= it->second.size;
+        it->second = location.value;
+    } else {
+        it = index_.emplace(std::string(key), location.value).first;
+    }
+    live_bytes_ += location.value.size;
+    active_entries_[it->first] = FooterEntry{RECORD_PUT, location.value.offset, location.value.size};
+
+    if (active_size_ >= config_.segment_bytes) {
+        return seal_active();
+    }
+    return core::Result<void>::ok();
+}
+
+core::Result<bool> BlobStore::get(std::string_view key, std::vector<uint8_t>& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!unlocked()) {
+        return core::Result<bool>::error("Store is locked");
+    }
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        return core::Result<bool>::ok(false);
+    }
+
+    auto read = read_record(it->second, record_);
+    if (!read) {
+        return core::Result<bool>::error(read.error_message);
+    }
+    uint8_t type = 0;
+    if (!open_record(it->second.segment, it->second.offset, record_, type, body_) || type != RECORD_PUT ||
+        body_.size() < 2 + key.size() || get_u16(body_.data()) != key.size() ||
+        std::memcmp(body_.data() + 2, key.data(), key.size()) != 0) {
+        return core::Result<bool>::error(fmt::format("Record for key '{}' is corrupt (segment {})", key,
+                                                     segment_path(it->second.segment).string()));
+    }
+    value.assign(body_.begin() + 2 + key.size(), body_.end());
+    return core::Result<bool>::ok(true);
+}
+
+core::Result<bool> BlobStore::remove(std::string_view key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto writable = check_writable();
+    if (!writable) {
+        return core::Result<bool>::error(writable.error_message);
+    }
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        return core::Result<bool>::ok(false);   // Nothing on disk to hide
+    }
+
+    body_.resize(2 + key.size());
+    put_u16(body_.data(), static_cast<uint16_t>(key.size()));
+    std::memcpy(body_.data() + 2, key.data(), key.size());
+    auto location = append(RECORD_DELETE);
+    if (!location) {
+        return core::Result<bool>::error(location.error_message);
+    }
+
+    live_bytes_ -= it->second.size;
+    active_entries_[it->first] = FooterEntry{RECORD_DELETE, location.value.offset, location.value.size};
+    index_.erase(it);
+
+    if (active_size_ >= config_.segment_bytes) {
+        auto sealed = seal_active();
+        if (!sealed) {
+            return core::Result<bool>::error(sealed.error_message);
+        }
+    }
+    return core::Result<bool>::ok(true);
+}
+
+bool BlobStore::contains(std::string_view key) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_.find(key) != index_.end();
+}
+
+std::vector<std::string> BlobStore::keys() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> keys;
+    keys.reserve(index_.size());
+    for (const auto& [key, location] : index_) {
+        keys.push_back(key);
+    }
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+core::Result<void> BlobStore::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!unlocked() || read_only_ || !active_) {
+        return core::Result<void>::ok();
+    }
+    auto written = write_buffer();
+    if (!written) {
+        return written;
+    }
+    return segments_.at(active_).file.sync();
+}
+
+core::Result<void> BlobStore::compact() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto writable = check_writable();
+    if (!writable) {
+        return writable;
+    }
+    auto sealed = seal_active();
+    if (!sealed) {
+        return sealed;
+    }
+
+    std::vector<uint64_t> old_segments;
+    for (const auto& [id, segment] : segments_) {
+        old_segments.push_back(id);
+    }
+
+    // Copy in disk order, so the old segments are read sequentially
+    std::vector<Index::value_type*> live;
+    live.reserve(index_.size());
+    for (auto& item : index_) {
+        live.push_back(&item);
+    }
+    std::sort(live.begin(), live.end(), [](const auto* a, const auto* b) {
+        return a->second.segment != b->second.segment ? a->second.segment < b->second.segment
+                                                      : a->second.offset < b->second.offset;
+    });
+
+    uint64_t live_bytes = 0;
+    for (auto* item : live) {
+        auto read = read_record(item->second, record_);
+        uint8_t type = 0;
+        if (!read || !open_record(item->second.segment, item->second.offset, record_, type, body_) ||
+            type != RECORD_PUT) {
+            return core::Result<void>::error(fmt::format("Record for key '{}' is corrupt (segment {})", item->first,
+                                                         segment_path(item->second.segment).string()));
+        }
+        auto location = append(RECORD_PUT);     // body_ holds the plaintext just read
+        if (!location) {
+            return core::Result<void>::error(location.error_message);
+        }
+        item->second = location.value;
+        live_bytes += location.value.size;
+        active_entries_[item->first] = FooterEntry{RECORD_PUT, location.value.offset, location.value.size};
+        if (active_size_ >= config_.segment_bytes) {
+            sealed = seal_active();
+            if (!sealed) {
+                return sealed;
+            }
+        }
+    }
+    sealed = seal_active();
+    if (!sealed) {
+        return sealed;
+    }
+    live_bytes_ = live_bytes;
+
+    // Oldest first: a tombstone must outlive the records it hides
+    for (auto id : old_segments) {
+        segments_.erase(id);
+        std::error_code ec;
+        if (!fs::remove(segment_path(id), ec) && ec) {
+            return core::Result<void>::error("Cannot delete " + segment_path(id).string() + ": " + ec.message());
+        }
+    }
+    return core::Result<void>::ok();
+}
+
+core::Result<void> BlobStore::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!unlocked()) {
+        return core::Result<void>::ok();
+    }
+    auto sealed = read_only_ ? core::Result<void>::ok() : seal_active();
+
+    session_.reset();
+    nonces_.reset();
+    Botan::secure_scrub_memory(data_key_.data(), data_key_.size());
+    data_key_.clear();
+    index_.clear();
+    segments_.clear();
+    active_ = 0;
+    active_entries_.clear();
+    buffer_.clear();
+    live_bytes_ = 0;
+    return sealed;
+}
+
+BlobStoreStats BlobStore::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    BlobStoreStats stats;
+    stats.keys = index_.size();
+    stats.segments = segments_.size();
+    stats.live_bytes = live_bytes_;
+    for (const auto& [id, segment] : segments_) {
+        stats.disk_bytes += segment.size;
+    }
+    stats.disk_bytes += buffer_.size();
+    return stats;
+}
+
+} // namespace store
+} // namespace filevault
@@ -0,0 +1,115 @@
+/**
+ * @file alloc_hooks.cpp
+ * @brief Counting malloc for ENABLE_ALLOC_STATS builds (glibc)
+ *
+ * Linked into executables only, never into libfilevault: defining malloc
+ * in the program replaces it for the whole process, as glibc documents
+ * under "Replacing malloc". Every allocating entry point is replaced,
+ * since one left to glibc would hand out blocks that free() then
+ * subtracts. Calls are forwarded to glibc's own allocator and reported
+ * to AllocStats.
+ */
+
+#include "filevault/utils/alloc_stats.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <malloc.h>
+#include <unistd.h>
+
+#ifndef __GLIBC__
+#error "ENABLE_ALLOC_STATS needs glibc"
+#endif
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* pointer);
+}
+
+using filevault::utils::AllocStats;
+
+namespace {
+
+void* counted(void* pointer, size_t requested) noexcept {
+    if (pointer) {
+        AllocStats::on_alloc(requested, malloc_usable_size(pointer));
+    }
+    return pointer;
+}
+
+size_t page_size() noexcept {
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+// Runs before main(); allocations made earlier are counted all the same
+const bool registered = (AllocStats::set_enabled(), true);
+
+} // anonymous namespace
+
+extern "C" {
+
+void* malloc(size_t size) noexcept {
+    return counted(__libc_malloc(size), size);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+    return counted(__libc_calloc(count, size), count * size);
+}
+
+void* realloc(void* pointer, size_t size) noexcept {
+    size_t old_usable = pointer ? malloc_usable_size(pointer) : 0;
+    void* moved = __libc_realloc(pointer, size);
+    if (moved || size == 0) {
+        AllocStats::on_free(old_usable);    // Failure leaves the old block alive
+    }
+    return counted(moved, size);
+}
+
+void free(void* pointer) noexcept {
+    if (pointer) {
+        AllocStats::on_free(malloc_usable_size(pointer));
+        __libc_free(pointer);
+    }
+}
+
+void* memalign(size_t alignment, size_t size) noexcept {
+    return counted(__libc_memalign(alignment, size), size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept {
+    return counted(__libc_memalign(alignment, size), size);
+}
+
+int posix_memalign(void** result, size_t alignment, size_t size) noexcept {
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    void* pointer = counted(__libc_memalign(alignment, size), size);
+    if (!pointer && size > 0) {
+        return ENOMEM;
+    }
+    *result = pointer;
+    return 0;
+}
+
+void* valloc(size_t size) noexcept {
+    return counted(__libc_memalign(page_size(), size), size);
+}
+
+void* pvalloc(size_t size) noexcept {
+    size_t page = page_size();
+    size_t rounded = (size + page - 1) / page * page;
+    return counted(__libc_memalign(page, rounded), rounded);
+}
+
+void* reallocarray(void* pointer, size_t count, size_t size) noexcept {
+    if (size != 0 && count > static_cast<size_t>(-1) / size) {
+        errno = ENOMEM;
+        return nullptr;
+    }
+    return realloc(pointer, count * size);
+}
+
+} // extern "C"
@@ -0,0 +1,71 @@
+/**
+ * @file alloc_stats.cpp
+ * @brief Heap allocation counters for ENABLE_ALLOC_STATS builds
+ */
+
+#include "filevault/utils/alloc_stats.hpp"
+#include <atomic>
+
+namespace filevault {
+namespace utils {
+
+namespace {
+
+// Constant-initialized: the allocator may call in before any constructor runs
+std::atomic<bool> hooks_linked{false};
+std::atomic<uint64_t> total_allocations{0};
+std::atomic<uint64_t> total_bytes{0};
+std::atomic<uint64_t> live{0};
+std::atomic<uint64_t> peak{0};
+
+thread_local uint64_t thread_allocations = 0;
+thread_local uint64_t thread_bytes = 0;
+
+} // anonymous namespace
+
+bool AllocStats::enabled() {
+    return hooks_linked.load(std::memory_order_relaxed);
+}
+
+AllocCounters AllocStats::totals() {
+    return {total_allocations.load(std::memory_order_relaxed), total_bytes.load(std::memory_order_relaxed)};
+}
+
+AllocCounters AllocStats::thread() {
+    return {thread_allocations, thread_bytes};
+}
+
+uint64_t AllocStats::live_bytes() {
+    return live.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocStats::peak_bytes() {
+    return peak.load(std::memory_order_relaxed);
+}
+
+void AllocStats::reset_peak() {
+    peak.store(live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void AllocStats::set_enabled() noexcept {
+    hooks_linked.store(true, std::memory_order_relaxed);
+}
+
+void AllocStats::on_alloc(size_t requested, size_t usable) noexcept {
+    total_allocations.fetch_add(1, std::memory_order_relaxed);
+    total_bytes.fetch_add(requested, std::memory_order_relaxed);
+    ++thread_allocations;
+    thread_bytes += requested;
+
+    uint64_t now = live.fetch_add(usable, std::memory_order_relaxed) + usable;
+    uint64_t seen = peak.load(std::memory_order_relaxed);
+    while (now > seen && !peak.compare_exchange_weak(seen, now, std::memory_order_relaxed)) {
+    }
+}
+
+void AllocStats::on_free(size_t usable) noexcept {
+    live.fetch_sub(usable, std::memory_order_relaxed);
+}
+
+} // namespace utils
+} // namespace filevault
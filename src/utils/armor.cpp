@@ -0,0 +1,247 @@
+/**
+ * @file armor.cpp
+ * @brief Streaming ASCII armor over the base64 kernels
+ */
+
+#include "filevault/utils/armor.hpp"
+#include "filevault/utils/codec_kernels.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <vector>
+
+namespace filevault {
+namespace utils {
+
+namespace {
+
+constexpr size_t ROW_BYTES = 48;        // One 64-character line
+constexpr size_t ROWS_PER_BLOCK = 1024;
+constexpr size_t READ_SIZE = 64 * 1024;
+
+} // anonymous namespace
+
+bool is_armored_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::string head(ARMOR_BEGIN.size(), '\0');
+    file.read(head.data(), static_cast<std::streamsize>(head.size()));
+    return file && head == ARMOR_BEGIN;
+}
+
+// ArmorOutput implementation
+
+class ArmorOutput::Buffer : public std::streambuf {
+public:
+    explicit Buffer(std::ostream& sink)
+        : sink_(sink), isa_(codec::best_isa()),
+          bytes_(ROW_BYTES * ROWS_PER_BLOCK), text_((64 + 1) * ROWS_PER_BLOCK) {
+        sink_.write(ARMOR_BEGIN.data(), static_cast<std::streamsize>(ARMOR_BEGIN.size())).put('\n');
+        setp(bytes_.data(), bytes_.data() + bytes_.size());
+    }
+
+    bool finish() {
+        if (!done_) {
+            encode(static_cast<size_t>(pptr() - pbase()), true);
+            sink_.write(ARMOR_END.data(), static_cast<std::streamsize>(ARMOR_END.size())).put('\n');
+            sink_.flush();
+            done_ = true;
+        }
+        return sink_.good();
+    }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (done_ || !sink_) {
+            return traits_type::eof();
+        }
+        encode(static_cast<size_t>(pptr() - pbase()), false);
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    // Only whole lines can be written early; a partial one stays buffered
+    int sync() override {
+        if (!done_) {
+            encode(static_cast<size_t>(pptr() - pbase()), false);
+        }
+        sink_.flush();
+        return sink_ ? 0 : -1;
+    }
+
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+        if (off != 0 || dir != std::ios_base::cur || !(which & std::ios_base::out)) {
+            return pos_type(off_type(-1));
+        }
+        return pos_type(static_cast<off_type>(written_ + static_cast<uint64_t>(pptr() - pbase())));
+    }
+
+private:
+    // Encode the first @p size buffered bytes (whole rows unless @p final)
+    void encode(size_t size, bool final) {
+        size_t rows_end = final ? size : size - size % ROW_BYTES;
+        size_t pos = 0;
+        for (size_t offset = 0; offset < rows_end; offset += ROW_BYTES) {
+            size_t length = std::min(ROW_BYTES, rows_end - offset);
+            auto row = std::span(reinterpret_cast<const uint8_t*>(bytes_.data()) + offset, length);
+            pos += codec::base64_encode(row, std::span(text_.data() + pos, 64), isa_);
+            text_[pos++] = '\n';
+        }
+        sink_.write(text_.data(), static_cast<std::streamsize>(pos));
+
+        // Keep the partial row at the front of the buffer
+        size_t rest = size - rows_end;
+        std::memmove(bytes_.data(), bytes_.data() + rows_end, rest);
+        written_ += rows_end;
+        setp(bytes_.data(), bytes_.data() + bytes_.size());
+        pbump(static_cast<int>(rest));
+    }
+
+    std::ostream& sink_;
+    codec::Isa isa_;
+    std::vector<char> bytes_;
+    std::vector<char> text_;
+    uint64_t written_ = 0;
+    bool done_ = false;
+};
+
+ArmorOutput::ArmorOutput(std::ostream& sink)
+    : std::ostream(nullptr), buffer_(std::make_unique<Buffer>(sink)) {
+    rdbuf(buffer_.get());
+}
+
+ArmorOutput::~ArmorOutput() = default;
+
+bool ArmorOutput::finish() {
+    bool ok = buffer_->finish();
+    if (!ok) {
+        setstate(std::ios_base::badbit);
+    }
+    return ok;
+}
+
+// ArmorInput implementation
+
+class ArmorInput::Buffer : public std::streambuf {
+public:
+    explicit Buffer(std::istream& source)
+        : source_(source), isa_(codec::best_isa()), raw_(READ_SIZE) {
+        std::string line;
+        std::getline(source_, line);
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line != ARMOR_BEGIN) {
+            fail("Input is not armored (no BEGIN line)");
+        }
+    }
+
+    const std::string& error() const { return error_; }
+
+protected:
+    int_type underflow() override {
+        while (gptr() == egptr()) {
+            if (failed_ || (ended_ && pending_.empty())) {
+                return traits_type::eof();
+            }
+            if (!ended_) {
+                read_text();
+            }
+            decode();
+        }
+        return traits_type::to_int_type(*gptr());
+    }
+
+private:
+    void fail(std::string message) {
+        if (!failed_) {
+            failed_ = true;
+            error_ = std::move(message);
+        }
+    }
+
+    // Append the base64 of the next raw block to pending_, up to the END line
+    void read_text() {
+        source_.read(raw_.data(), static_cast<std::streamsize>(raw_.size()));
+        size_t n = static_cast<size_t>(source_.gcount());
+        if (n == 0) {
+            fail("Armored input ends without an END line");
+            return;
+        }
+        size_t pos = 0;
+        while (pos < n) {
+            const char* start = raw_.data() + pos;
+            const auto* newline = static_cast<const char*>(std::memchr(start, '\n', n - pos));
+            size_t length = newline ? static_cast<size_t>(newline - start) : n - pos;
+            if (at_line_start_ && length > 0 && *start == '-') {
+                std::string marker(start, length);
+                if (!newline) {
+                    std::string rest;
+                    std::getline(source_, rest);
+                    marker += rest;
+                }
+                if (!marker.starts_with(ARMOR_END)) {
+                    fail("Malformed armor END line");
+                }
+                ended_ = true;
+                return;
+            }
+            size_t keep = length;
+            if (keep > 0 && start[keep - 1] == '\r') {
+                keep--;
+            }
+            pending_.append(start, keep);
+            at_line_start_ = newline != nullptr;
+            pos += length + (newline ? 1 : 0);
+        }
+    }
+
+    // Decode whole quads (all of them once the END line is seen)
+    void decode() {
+        if (failed_) {
+            return;
+        }
+        size_t usable = ended_ ? pending_.size() : pending_.size() / 4 * 4;
+        if (ended_ && usable % 4 != 0) {
+            fail("Armored data is truncated");
+            return;
+        }
+        bytes_.resize(codec::base64_decoded_capacity(usable));
+        auto written = codec::base64_decode(std::string_view(pending_.data(), usable),
+                                            std::span(reinterpret_cast<uint8_t*>(bytes_.data()), bytes_.size()),
+                                            isa_);
+        if (!written) {
+            fail("Armored data has a character outside base64");
+            return;
+        }
+        pending_.erase(0, usable);
+        setg(bytes_.data(), bytes_.data(), bytes_.data() + *written);
+    }
+
+    std::istream& source_;
+    codec::Isa isa_;
+    std::vector<char> raw_;
+    std::vector<char> bytes_;
+    std::string pending_;
+    std::string error_;
+    bool at_line_start_ = true;
+    bool ended_ = false;
+    bool failed_ = false;
+};
+
+ArmorInput::ArmorInput(std::istream& source)
+    : std::istream(nullptr), buffer_(std::make_unique<Buffer>(source)) {
+    rdbuf(buffer_.get());
+}
+
+ArmorInput::~ArmorInput() = default;
+
+const std::string& ArmorInput::error() const {
+    return buffer_->error();
+}
+
+} // namespace utils
+} // namespace filevault
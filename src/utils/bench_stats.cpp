@@ -0,0 +1,523 @@
+/**
+ * @file bench_stats.cpp
+ * @brief Sample statistics, cycle counters and energy for the benchmark command
+ */
+
+#include "filevault/utils/bench_stats.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define FILEVAULT_HAVE_RDTSC 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#elif defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace filevault {
+namespace utils {
+
+namespace {
+
+// Two-sided 95% Student t quantiles for 1-30 degrees of freedom
+constexpr double T_95[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+double t_quantile(size_t degrees) {
+    if (degrees == 0) {
+        return 0.0;
+    }
+    return degrees <= std::size(T_95) ? T_95[degrees - 1] : 1.96;
+}
+
+/**
+ * @brief Nearest-rank percentile of sorted values
+ */
+double percentile(const std::vector<double>& sorted, double fraction) {
+    size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+double median(const std::vector<double>& sorted) {
+    size_t n = sorted.size();
+    return n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2.0;
+}
+
+} // anonymous namespace
+
+CycleCounter::CycleCounter() {
+#ifdef __linux__
+    // Core cycles of this thread in user space; often refused by
+    // perf_event_paranoid or inside containers
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fd >= 0) {
+        perf_fd_ = static_cast<int>(fd);
+        source_ = Source::PERF_EVENT;
+        return;
+    }
+#endif
+#ifdef FILEVAULT_HAVE_RDTSC
+    source_ = Source::RDTSC;
+#endif
+}
+
+CycleCounter::~CycleCounter() {
+#ifdef __linux__
+    if (perf_fd_ >= 0) {
+        close(perf_fd_);
+    }
+#endif
+}
+
+const char* CycleCounter::source() const {
+    switch (source_) {
+        case Source::PERF_EVENT: return "perf_event";
+        case Source::RDTSC: return "rdtsc";
+        default: return "none";
+    }
+}
+
+uint64_t CycleCounter::read() const {
+#ifdef __linux__
+    if (source_ == Source::PERF_EVENT) {
+        uint64_t value = 0;
+        if (::read(perf_fd_, &value, sizeof(value)) != sizeof(value)) {
+            return 0;
+        }
+        return value;
+    }
+#endif
+#ifdef FILEVAULT_HAVE_RDTSC
+    if (source_ == Source::RDTSC) {
+        return __rdtsc();
+    }
+#endif
+    return 0;
+}
+
+namespace {
+
+// CounterValues fields in PerfCounters slot order
+constexpr double CounterValues::*COUNTER_FIELDS[] = {
+    &CounterValues::cycles,
+    &CounterValues::instructions,
+    &CounterValues::l1d_misses,
+    &CounterValues::llc_misses,
+    &CounterValues::branch_misses,
+    &CounterValues::dtlb_misses,
+};
+
+} // anonymous namespace
+
+PerfCounters::PerfCounters() {
+#ifdef __linux__
+    struct Event {
+        uint32_t type;
+        uint64_t config;
+    };
+    constexpr uint64_t L1D_READ_MISS = PERF_COUNT_HW_CACHE_L1D |
+                                       (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                       (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    constexpr uint64_t DTLB_READ_MISS = PERF_COUNT_HW_CACHE_DTLB |
+                                        (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    const Event events[] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, L1D_READ_MISS},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        {PERF_TYPE_HW_CACHE, DTLB_READ_MISS},
+    };
+
+    for (size_t slot = 0; slot < std::size(events); ++slot) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = events[slot].type;
+        attr.size = sizeof(attr);
+        attr.config = events[slot].config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.disabled = fds_.empty() ? 1 : 0;   // Members follow the leader
+        int leader = fds_.empty() ? -1 : fds_.front();
+        long fd = syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+        if (fd < 0) {
+            if (slot == 0) {
+                return;     // No cycles, no group
+            }
+            continue;
+        }
+        fds_.push_back(static_cast<int>(fd));
+        slots_.push_back(static_cast<int>(slot));
+    }
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    for (int fd : fds_) {
+        close(fd);
+    }
+#endif
+}
+
+void PerfCounters::start() {
+#ifdef __linux__
+    if (available()) {
+        ioctl(fds_.front(), PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds_.front(), PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+}
+
+CounterValues PerfCounters::stop() {
+    CounterValues values;
+#ifdef __linux__
+    if (!available()) {
+        return values;
+    }
+    ioctl(fds_.front(), PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    // PERF_FORMAT_GROUP layout: count, then one value per member
+    std::vector<uint64_t> buffer(1 + fds_.size());
+    ssize_t expected = static_cast<ssize_t>(buffer.size() * sizeof(uint64_t));
+    if (::read(fds_.front(), buffer.data(), expected) != expected) {
+        return values;
+    }
+    for (size_t i = 0; i < fds_.size() && i < buffer[0]; ++i) {
+        values.*COUNTER_FIELDS[slots_[i]] = static_cast<double>(buffer[1 + i]);
+    }
+#endif
+    return values;
+}
+
+#ifdef __linux__
+namespace {
+
+uint64_t read_energy_uj(int fd) {
+    char text[32];
+    ssize_t n = pread(fd, text, sizeof(text) - 1, 0);
+    if (n <= 0) {
+        return 0;
+    }
+    text[n] = '\0';
+    return std::strtoull(text, nullptr, 10);
+}
+
+} // anonymous namespace
+#endif
+
+EnergyMeter::EnergyMeter() {
+#ifdef __linux__
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator("/sys/class/powercap", ec)) {
+        // intel-rapl:N are packages; intel-rapl:N:M are parts of them
+        std::string zone = entry.path().filename().string();
+        if (zone.rfind("intel-rapl:", 0) != 0 || zone.find(':') != zone.rfind(':')) {
+            continue;
+        }
+        std::ifstream name_file(entry.path() / "name");
+        std::ifstream range_file(entry.path() / "max_energy_range_uj");
+        std::string name;
+        Domain domain;
+        if (!(name_file >> name) || name.rfind("package", 0) != 0 || !(range_file >> domain.max_range_uj)) {
+            continue;
+        }
+        domain.fd = open((entry.path() / "energy_uj").c_str(), O_RDONLY | O_CLOEXEC);
+        if (domain.fd < 0) {
+            continue;       // Root only on current kernels
+        }
+        domains_.push_back(domain);
+    }
+#endif
+}
+
+EnergyMeter::~EnergyMeter() {
+#ifdef __linux__
+    for (const auto& domain : domains_) {
+        close(domain.fd);
+    }
+#endif
+}
+
+void EnergyMeter::start() {
+#ifdef __linux__
+    for (auto& domain : domains_) {
+        domain.start_uj = read_energy_uj(domain.fd);
+    }
+#endif
+}
+
+double EnergyMeter::stop() {
+    uint64_t total_uj = 0;
+#ifdef __linux__
+    for (const auto& domain : domains_) {
+        uint64_t end = read_energy_uj(domain.fd);
+        total_uj += end >= domain.start_uj ? end - domain.start_uj
+                                           : domain.max_range_uj - domain.start_uj + end;
+    }
+#endif
+    return static_cast<double>(total_uj) / 1e6;
+}
+
+double SampleStats::mbps(size_t bytes) const {
+    return median_ms > 0 ? (bytes / 1024.0 / 1024.0) / (median_ms / 1000.0) : 0.0;
+}
+
+SampleStats SampleStats::summarize(std::vector<double> times_ms, std::vector<double> cycles, size_t bytes) {
+    SampleStats stats;
+    stats.samples = times_ms.size();
+    if (times_ms.empty()) {
+        return stats;
+    }
+
+    std::vector<double> sorted = times_ms;
+    std::sort(sorted.begin(), sorted.end());
+    stats.min_ms = sorted.front();
+    stats.max_ms = sorted.back();
+    stats.median_ms = median(sorted);
+    stats.p95_ms = percentile(sorted, 0.95);
+    stats.p99_ms = percentile(sorted, 0.99);
+
+    // Tukey fence; only slow outliers are dropped, a fast run is not noise
+    double q1 = percentile(sorted, 0.25);
+    double q3 = percentile(sorted, 0.75);
+    double fence = q3 + 1.5 * (q3 - q1);
+    std::vector<double> kept;
+    kept.reserve(sorted.size());
+    for (double t : sorted) {
+        if (t <= fence) {
+            kept.push_back(t);
+        }
+    }
+    stats.outliers = sorted.size() - kept.size();
+
+    double sum = 0.0;
+    for (double t : kept) {
+        sum += t;
+    }
+    stats.mean_ms = sum / kept.size();
+    if (kept.size() > 1) {
+        double squares = 0.0;
+        for (double t : kept) {
+            squares += (t - stats.mean_ms) * (t - stats.mean_ms);
+        }
+        stats.stddev_ms = std::sqrt(squares / (kept.size() - 1));
+        stats.ci95_ms = t_quantile(kept.size() - 1) * stats.stddev_ms / std::sqrt(static_cast<double>(kept.size()));
+    }
+
+    if (!cycles.empty() && bytes > 0) {
+        std::sort(cycles.begin(), cycles.end());
+        stats.cycles_per_byte = median(cycles) / static_cast<double>(bytes);
+    }
+    stats.times_ms = std::move(times_ms);
+    return stats;
+}
+
+LinearFit LinearFit::fit(const std::vector<double>& x, const std::vector<double>& y) {
+    LinearFit result;
+    size_t count = std::min(x.size(), y.size());
+    double sw = 0, sx = 0, sy = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (y[i] <= 0) {
+            continue;
+        }
+        double w = 1.0 / (y[i] * y[i]);
+        sw += w;
+        sx += w * x[i];
+        sy += w * y[i];
+    }
+    if (sw == 0) {
+        return result;
+    }
+    double mx = sx / sw, my = sy / sw;
+
+    double sxx = 0, sxy = 0, syy = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (y[i] <= 0) {
+            continue;
+        }
+        double w = 1.0 / (y[i] * y[i]);
+        sxx += w * (x[i] - mx) * (x[i] - mx);
+        sxy += w * (x[i] - mx) * (y[i] - my);
+        syy += w * (y[i] - my) * (y[i] - my);
+    }
+    if (sxx == 0) {
+        result.intercept = my;
+        return result;
+    }
+    result.slope = sxy / sxx;
+    result.intercept = my - result.slope * mx;
+    result.r_squared = syy > 0 ? (sxy * sxy) / (sxx * syy) : 1.0;
+    return result;
+}
+
+MannWhitney MannWhitney::test(const std::vector<double>& a, const std::vector<double>& b) {
+    MannWhitney result;
+    double n1 = static_cast<double>(a.size());
+    double n2 = static_cast<double>(b.size());
+    if (a.empty() || b.empty()) {
+        return result;
+    }
+
+    std::vector<std::pair<double, bool>> pooled;   // (value, from a)
+    pooled.reserve(a.size() + b.size());
+    for (double v : a) {
+        pooled.push_back({v, true});
+    }
+    for (double v : b) {
+        pooled.push_back({v, false});
+    }
+    std::sort(pooled.begin(), pooled.end());
+
+    // Mid-ranks for ties, and the tie term of the variance
+    double rank_sum_a = 0.0, tie_term = 0.0;
+    for (size_t i = 0; i < pooled.size();) {
+        size_t j = i;
+        while (j < pooled.size() && pooled[j].first == pooled[i].first) {
+            ++j;
+        }
+        double rank = (i + 1 + j) / 2.0;
+        double ties = static_cast<double>(j - i);
+        for (size_t k = i; k < j; ++k) {
+            if (pooled[k].second) {
+                rank_sum_a += rank;
+            }
+        }
+        tie_term += ties * ties * ties - ties;
+        i = j;
+    }
+
+    double n = n1 + n2;
+    result.u = rank_sum_a - n1 * (n1 + 1) / 2.0;
+    double mean_u = n1 * n2 / 2.0;
+    double variance = n1 * n2 / 12.0 * ((n + 1) - tie_term / (n * (n - 1)));
+    if (variance <= 0) {
+        return result;
+    }
+    double diff = result.u - mean_u;
+    double corrected = std::max(0.0, std::abs(diff) - 0.5);
+    result.z = std::copysign(corrected / std::sqrt(variance), diff);
+    result.p_value = std::min(1.0, std::erfc(std::abs(result.z) / std::sqrt(2.0)));
+    return result;
+}
+
+Sampler::Sampler(SamplingPolicy policy) : policy_(policy) {
+    if (policy_.hardware_counters) {
+        counters_ = std::make_unique<PerfCounters>();
+    }
+    if (policy_.energy) {
+        energy_ = std::make_unique<EnergyMeter>();
+    }
+}
+
+CounterValues Sampler::mean_counters(const std::vector<CounterValues>& samples) {
+    CounterValues mean;
+    if (samples.empty()) {
+        return mean;
+    }
+    for (auto field : COUNTER_FIELDS) {
+        if (samples.front().*field < 0) {
+            continue;       // Event not in the group
+        }
+        double sum = 0.0;
+        for (const auto& sample : samples) {
+            sum += sample.*field;
+        }
+        mean.*field = sum / static_cast<double>(samples.size());
+    }
+    return mean;
+}
+
+bool Sampler::within_target(double mean, double m2, size_t count) const {
+    if (mean <= 0.0) {
+        return true;
+    }
+    double stddev = std::sqrt(m2 / (count - 1));
+    double half_width = t_quantile(count - 1) * stddev / std::sqrt(static_cast<double>(count));
+    return half_width / mean <= policy_.target_ci;
+}
+
+#ifdef __linux__
+namespace {
+
+// A "Vm...:" field of /proc/self/status in bytes
+size_t proc_status_bytes(const char* field) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    size_t length = std::strlen(field);
+    while (std::getline(status, line)) {
+        if (line.compare(0, length, field) == 0) {
+            return static_cast<size_t>(std::stoull(line.substr(length))) * 1024;
+        }
+    }
+    return 0;
+}
+
+} // anonymous namespace
+#endif
+
+size_t peak_rss_bytes() {
+#ifdef __linux__
+    // VmHWM, unlike getrusage's maxrss, honours reset_peak_rss()
+    return proc_status_bytes("VmHWM:");
+#elif defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#elif defined(__APPLE__)
+    struct rusage usage;
+    return getrusage(RUSAGE_SELF, &usage) == 0 ? static_cast<size_t>(usage.ru_maxrss) : 0;
+#else
+    return 0;
+#endif
+}
+
+bool reset_peak_rss() {
+#ifdef __linux__
+    {
+        std::ofstream clear_refs("/proc/self/clear_refs");
+        clear_refs << "5";
+    }
+    // Some kernels accept the write but keep the old peak
+    return peak_rss_bytes() <= proc_status_bytes("VmRSS:") + (1u << 20);
+#else
+    return false;
+#endif
+}
+
+} // namespace utils
+} // namespace filevault
@@ -0,0 +1,303 @@
+/**
+ * @file checksum.cpp
+ * @brief CRC32C kernels and the XXH3-128 wrapper
+ */
+
+#include "filevault/utils/checksum.hpp"
+#include "filevault/core/cpu_features.hpp"
+#include <xxhash.h>
+#include <array>
+#include <cstring>
+#include <new>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define FILEVAULT_CRC_X86 1
+    #include <nmmintrin.h>
+    #if defined(__GNUC__) || defined(__clang__)
+        #define FILEVAULT_TARGET_SSE42 __attribute__((target("sse4.2")))
+    #else
+        #define FILEVAULT_TARGET_SSE42
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define FILEVAULT_CRC_ARM 1
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+        #define FILEVAULT_TARGET_CRC
+    #else
+        #include <arm_acle.h>
+        #if defined(__clang__)
+            #define FILEVAULT_TARGET_CRC __attribute__((target("crc")))
+        #else
+            #define FILEVAULT_TARGET_CRC __attribute__((target("+crc")))
+        #endif
+    #endif
+#endif
+
+namespace filevault {
+namespace utils {
+
+namespace {
+
+constexpr uint32_t POLY = 0x82F63B78;   // Castagnoli, bit-reflected
+
+// Bytes per stream when three run interleaved; the instruction has a
+// latency of three cycles and a throughput of one, so one stream stalls
+constexpr size_t STRIPE = 4096;
+
+constexpr std::array<std::array<uint32_t, 256>, 8> make_tables() {
+    std::array<std::array<uint32_t, 256>, 8> tables{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = crc & 1 ? (crc >> 1) ^ POLY : crc >> 1;
+        }
+        tables[0][i] = crc;
+    }
+    for (size_t k = 1; k < 8; ++k) {
+        for (size_t i = 0; i < 256; ++i) {
+            tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xFF];
+        }
+    }
+    return tables;
+}
+
+constexpr auto TABLES = make_tables();
+
+/**
+ * @brief a * b mod P, reflected (as zlib's multmodp); a must be non-zero
+ */
+constexpr uint32_t multmodp(uint32_t a, uint32_t b) {
+    uint32_t m = 1u << 31;
+    uint32_t product = 0;
+    for (;;) {
+        if (a & m) {
+            product ^= b;
+            if ((a & (m - 1)) == 0) {
+                break;
+            }
+        }
+        m >>= 1;
+        b = b & 1 ? (b >> 1) ^ POLY : b >> 1;
+    }
+    return product;
+}
+
+/**
+ * @brief x^(8n) mod P: the operator that appends n zero bytes to a CRC register
+ */
+constexpr uint32_t zeros_operator(size_t n) {
+    uint32_t result = 1u << 31;   // x^0
+    uint32_t square = 1u << 23;   // x^8
+    for (; n > 0; n >>= 1) {
+        if (n & 1) {
+            result = multmodp(square, result);
+        }
+        square = multmodp(square, square);
+    }
+    return result;
+}
+
+constexpr uint32_t SHIFT_ONE_STRIPE = zeros_operator(STRIPE);
+constexpr uint32_t SHIFT_TWO_STRIPES = zeros_operator(2 * STRIPE);
+
+uint64_t load_le64(const uint8_t* p) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value |= uint64_t(p[i]) << (8 * i);
+    }
+    return value;
+}
+
+// The kernels take and return the raw register (no pre/post inversion)
+
+uint32_t crc32c_tables(const uint8_t* p, size_t n, uint32_t crc) {
+    for (; n >= 8; p += 8, n -= 8) {
+        uint64_t v = load_le64(p) ^ crc;
+        crc = TABLES[7][v & 0xFF] ^ TABLES[6][(v >> 8) & 0xFF] ^
+              TABLES[5][(v >> 16) & 0xFF] ^ TABLES[4][(v >> 24) & 0xFF] ^
+              TABLES[3][(v >> 32) & 0xFF] ^ TABLES[2][(v >> 40) & 0xFF] ^
+              TABLES[1][(v >> 48) & 0xFF] ^ TABLES[0][v >> 56];
+    }
+    for (; n > 0; ++p, --n) {
+        crc = TABLES[0][(crc ^ *p) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#if defined(FILEVAULT_CRC_X86)
+
+FILEVAULT_TARGET_SSE42
+uint32_t crc32c_sse42(const uint8_t* p, size_t n, uint32_t crc) {
+    auto word = [](const uint8_t* at) {
+        uint64_t value;
+        std::memcpy(&value, at, 8);
+        return value;
+    };
+    uint64_t c0 = crc;
+    for (; n >= 3 * STRIPE; p += 3 * STRIPE, n -= 3 * STRIPE) {
+        uint64_t c1 = 0;
+        uint64_t c2 = 0;
+        for (size_t i = 0; i < STRIPE; i += 8) {
+            c0 = _mm_crc32_u64(c0, word(p + i));
+            c1 = _mm_crc32_u64(c1, word(p + STRIPE + i));
+            c2 = _mm_crc32_u64(c2, word(p + 2 * STRIPE + i));
+        }
+        c0 = multmodp(SHIFT_TWO_STRIPES, static_cast<uint32_t>(c0)) ^
+             multmodp(SHIFT_ONE_STRIPE, static_cast<uint32_t>(c1)) ^ c2;
+    }
+    for (; n >= 8; p += 8, n -= 8) {
+        c0 = _mm_crc32_u64(c0, word(p));
+    }
+    auto c = static_cast<uint32_t>(c0);
+    for (; n > 0; ++p, --n) {
+        c = _mm_crc32_u8(c, *p);
+    }
+    return c;
+}
+
+#elif defined(FILEVAULT_CRC_ARM)
+
+FILEVAULT_TARGET_CRC
+uint32_t crc32c_armv8(const uint8_t* p, size_t n, uint32_t crc) {
+    auto word = [](const uint8_t* at) {
+        uint64_t value;
+        std::memcpy(&value, at, 8);
+        return value;
+    };
+    uint32_t c0 = crc;
+    for (; n >= 3 * STRIPE; p += 3 * STRIPE, n -= 3 * STRIPE) {
+        uint32_t c1 = 0;
+        uint32_t c2 = 0;
+        for (size_t i = 0; i < STRIPE; i += 8) {
+            c0 = __crc32cd(c0, word(p + i));
+            c1 = __crc32cd(c1, word(p + STRIPE + i));
+            c2 = __crc32cd(c2, word(p + 2 * STRIPE + i));
+        }
+        c0 = multmodp(SHIFT_TWO_STRIPES, c0) ^ multmodp(SHIFT_ONE_STRIPE, c1) ^ c2;
+    }
+    for (; n >= 8; p += 8, n -= 8) {
+        c0 = __crc32cd(c0, word(p));
+    }
+    for (; n > 0; ++p, --n) {
+        c0 = __crc32cb(c0, *p);
+    }
+    return c0;
+}
+
+#endif
+
+using Kernel = uint32_t (*)(const uint8_t*, size_t, uint32_t);
+
+Kernel select_kernel() {
+    [[maybe_unused]] const auto& cpu = core::CpuFeatures::detect();
+#if defined(FILEVAULT_CRC_X86)
+    if (cpu.sse42) return crc32c_sse42;
+#elif defined(FILEVAULT_CRC_ARM)
+    if (cpu.armv8crc32) return crc32c_armv8;
+#endif
+    return crc32c_tables;
+}
+
+Kernel kernel() {
+    static const Kernel selected = select_kernel();
+    return selected;
+}
+
+} // anonymous namespace
+
+uint32_t crc32c(std::span<const uint8_t> data, uint32_t crc) {
+    return ~kernel()(data.data(), data.size(), ~crc);
+}
+
+uint32_t crc32c_portable(std::span<const uint8_t> data, uint32_t crc) {
+    return ~crc32c_tables(data.data(), data.size(), ~crc);
+}
+
+bool crc32c_hardware() {
+    return kernel() != crc32c_tables;
+}
+
+// Crc32c implementation
+
+std::unique_ptr<Botan::HashFunction> Crc32c::new_object() const {
+    return std::make_unique<Crc32c>();
+}
+
+std::unique_ptr<Botan::HashFunction> Crc32c::copy_state() const {
+    return std::make_unique<Crc32c>(*this);
+}
+
+void Crc32c::add_data(std::span<const uint8_t> input) {
+    crc_ = crc32c(input, crc_);
+}
+
+void Crc32c::final_result(std::span<uint8_t> output) {
+    for (size_t i = 0; i < 4; ++i) {
+        output[i] = static_cast<uint8_t>(crc_ >> (24 - 8 * i));
+    }
+    crc_ = 0;
+}
+
+// Xxh3_128 implementation
+
+Xxh3_128::Xxh3_128() : state_(XXH3_createState()) {
+    if (!state_) {
+        throw std::bad_alloc();
+    }
+    XXH3_128bits_reset(state_);
+}
+
+Xxh3_128::~Xxh3_128() {
+    XXH3_freeState(state_);
+}
+
+std::unique_ptr<Botan::HashFunction> Xxh3_128::new_object() const {
+    return std::make_unique<Xxh3_128>();
+}
+
+std::unique_ptr<Botan::HashFunction> Xxh3_128::copy_state() const {
+    auto copy = std::make_unique<Xxh3_128>();
+    XXH3_copyState(copy->state_, state_);
+    return copy;
+}
+
+void Xxh3_128::clear() {
+    XXH3_128bits_reset(state_);
+}
+
+void Xxh3_128::add_data(std::span<const uint8_t> input) {
+    XXH3_128bits_update(state_, input.data(), input.size());
+}
+
+void Xxh3_128::final_result(std::span<uint8_t> output) {
+    XXH128_canonical_t canonical;
+    XXH128_canonicalFromHash(&canonical, XXH3_128bits_digest(state_));
+    std::memcpy(output.data(), canonical.digest, sizeof(canonical.digest));
+    XXH3_128bits_reset(state_);
+}
+
+// Factory
+
+bool is_checksum(const std::string& name) {
+    return name == "CRC32C" || name == "XXH3-128";
+}
+
+std::unique_ptr<Botan::HashFunction> create_hash(const std::string& name) {
+    if (name == "CRC32C") {
+        return std::make_unique<Crc32c>();
+    }
+    if (name == "XXH3-128") {
+        return std::make_unique<Xxh3_128>();
+    }
+    return Botan::HashFunction::create(name);
+}
+
+std::unique_ptr<Botan::HashFunction> create_hash_or_throw(const std::string& name) {
+    if (is_checksum(name)) {
+        return create_hash(name);
+    }
+    return Botan::HashFunction::create_or_throw(name);
+}
+
+} // namespace utils
+} // namespace filevault
@@ -0,0 +1,561 @@
+/**
+ * @file codec_kernels.cpp
+ * @brief SIMD hex and base64 codecs
+ */
+
+#include "filevault/utils/codec_kernels.hpp"
+#include "filevault/core/cpu_features.hpp"
+#include <array>
+#include <stdexcept>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define FILEVAULT_CODEC_X86 1
+    #include <emmintrin.h>
+    #include <tmmintrin.h>
+    #include <immintrin.h>
+    #if defined(__GNUC__) || defined(__clang__)
+        #define FILEVAULT_TARGET_SSSE3 __attribute__((target("ssse3")))
+        #define FILEVAULT_TARGET_AVX2 __attribute__((target("avx2")))
+    #else
+        #define FILEVAULT_TARGET_SSSE3
+        #define FILEVAULT_TARGET_AVX2
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define FILEVAULT_CODEC_NEON 1
+    #include <arm_neon.h>
+#endif
+
+namespace filevault::utils::codec {
+
+namespace {
+
+constexpr char kHexLower[] = "0123456789abcdef";
+constexpr char kHexUpper[] = "0123456789ABCDEF";
+constexpr char kBase64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+constexpr uint8_t kInvalid = 0xFF;
+
+constexpr std::array<uint8_t, 256> make_hex_values() {
+    std::array<uint8_t, 256> values{};
+    for (auto& v : values) v = kInvalid;
+    for (int i = 0; i < 10; ++i) values['0' + i] = static_cast<uint8_t>(i);
+    for (int i = 0; i < 6; ++i) {
+        values['a' + i] = static_cast<uint8_t>(10 + i);
+        values['A' + i] = static_cast<uint8_t>(10 + i);
+    }
+    return values;
+}
+
+constexpr std::array<uint8_t, 256> make_base64_values() {
+    std::array<uint8_t, 256> values{};
+    for (auto& v : values) v = kInvalid;
+    for (int i = 0; i < 64; ++i) values[static_cast<uint8_t>(kBase64[i])] = static_cast<uint8_t>(i);
+    return values;
+}
+
+constexpr auto kHexValues = make_hex_values();
+constexpr auto kBase64Values = make_base64_values();
+
+void hex_encode_scalar(const uint8_t* in, size_t n, char* out, bool uppercase) {
+    const char* digits = uppercase ? kHexUpper : kHexLower;
+    for (size_t i = 0; i < n; ++i) {
+        out[2 * i] = digits[in[i] >> 4];
+        out[2 * i + 1] = digits[in[i] & 0x0F];
+    }
+}
+
+bool hex_decode_scalar(const char* in, size_t n, uint8_t* out) {
+    for (size_t i = 0; i < n; ++i) {
+        uint8_t hi = kHexValues[static_cast<uint8_t>(in[2 * i])];
+        uint8_t lo = kHexValues[static_cast<uint8_t>(in[2 * i + 1])];
+        if (hi > 15 || lo > 15) {
+            return false;
+        }
+        out[i] = static_cast<uint8_t>((hi << 4) | lo);
+    }
+    return true;
+}
+
+// Whole groups of 3 bytes; returns characters written
+size_t base64_encode_scalar(const uint8_t* in, size_t n, char* out) {
+    size_t o = 0;
+    size_t i = 0;
+    for (; i + 3 <= n; i += 3) {
+        uint32_t v = (uint32_t{in[i]} << 16) | (uint32_t{in[i + 1]} << 8) | in[i + 2];
+        out[o++] = kBase64[(v >> 18) & 0x3F];
+        out[o++] = kBase64[(v >> 12) & 0x3F];
+        out[o++] = kBase64[(v >> 6) & 0x3F];
+        out[o++] = kBase64[v & 0x3F];
+    }
+    if (i < n) {
+        uint32_t v = uint32_t{in[i]} << 16;
+        if (i + 1 < n) v |= uint32_t{in[i + 1]} << 8;
+        out[o++] = kBase64[(v >> 18) & 0x3F];
+        out[o++] = kBase64[(v >> 12) & 0x3F];
+        out[o++] = i + 1 < n ? kBase64[(v >> 6) & 0x3F] : '=';
+        out[o++] = '=';
+    }
+    return o;
+}
+
+// Quads from the start of @p in; only the last may carry padding
+std::optional<size_t> base64_decode_scalar(const char* in, size_t n, uint8_t* out) {
+    size_t o = 0;
+    for (size_t i = 0; i < n; i += 4) {
+        bool last = i + 4 == n;
+        size_t pad = 0;
+        if (last) {
+            pad = (in[i + 3] == '=') + (in[i + 3] == '=' && in[i + 2] == '=');
+        }
+        uint32_t v = 0;
+        for (size_t k = 0; k < 4; ++k) {
+            uint8_t d = k >= 4 - pad ? 0 : kBase64Values[static_cast<uint8_t>(in[i + k])];
+            if (d == kInvalid) {
+                return std::nullopt;
+            }
+            v = (v << 6) | d;
+        }
+        out[o++] = static_cast<uint8_t>(v >> 16);
+        if (pad < 2) out[o++] = static_cast<uint8_t>(v >> 8);
+        if (pad < 1) out[o++] = static_cast<uint8_t>(v);
+    }
+    return o;
+}
+
+#if defined(FILEVAULT_CODEC_X86)
+
+inline __m128i load(const void* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+inline void store(void* p, __m128i v) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+}
+
+// Digit of each lane's low nibble (high bits must be clear)
+FILEVAULT_TARGET_SSSE3
+inline __m128i hex_digits(__m128i nibbles, bool uppercase) {
+    return _mm_shuffle_epi8(load(uppercase ? kHexUpper : kHexLower), nibbles);
+}
+
+FILEVAULT_TARGET_SSSE3
+size_t hex_encode_ssse3(const uint8_t* in, size_t n, char* out, bool uppercase) {
+    const __m128i low = _mm_set1_epi8(0x0F);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = load(in + i);
+        __m128i hi = hex_digits(_mm_and_si128(_mm_srli_epi16(v, 4), low), uppercase);
+        __m128i lo = hex_digits(_mm_and_si128(v, low), uppercase);
+        store(out + 2 * i, _mm_unpacklo_epi8(hi, lo));
+        store(out + 2 * i + 16, _mm_unpackhi_epi8(hi, lo));
+    }
+    return i;
+}
+
+// Nibble values of 16 hex digits, or false if one is not a digit
+FILEVAULT_TARGET_SSSE3
+inline bool hex_values(__m128i c, __m128i& values) {
+    __m128i digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    __m128i alpha = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    __m128i is_alpha = _mm_cmpeq_epi8(_mm_min_epu8(alpha, _mm_set1_epi8(5)), alpha);
+    values = _mm_or_si128(_mm_and_si128(is_digit, digit),
+                          _mm_and_si128(is_alpha, _mm_add_epi8(alpha, _mm_set1_epi8(10))));
+    return _mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha)) == 0xFFFF;
+}
+
+// Stops before the first block with a bad digit; the scalar loop reports it
+FILEVAULT_TARGET_SSSE3
+size_t hex_decode_ssse3(const char* in, size_t n, uint8_t* out) {
+    const __m128i weights = _mm_set1_epi16(0x0110);    // High nibble * 16 + low nibble
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i a, b;
+        if (!hex_values(load(in + 2 * i), a) || !hex_values(load(in + 2 * i + 16), b)) {
+            break;
+        }
+        store(out + i, _mm_packus_epi16(_mm_maddubs_epi16(a, weights), _mm_maddubs_epi16(b, weights)));
+    }
+    return i;
+}
+
+// 12 bytes (from a 16-byte load) to 16 six-bit indices, one per lane
+FILEVAULT_TARGET_SSSE3
+inline __m128i base64_indices(__m128i v) {
+    v = _mm_shuffle_epi8(v, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    __m128i ac = _mm_mulhi_epu16(_mm_and_si128(v, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+    __m128i bd = _mm_mullo_epi16(_mm_and_si128(v, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(ac, bd);
+}
+
+// Index to ASCII: pick the offset of the index's range with one shuffle
+FILEVAULT_TARGET_SSSE3
+inline __m128i base64_chars(__m128i indices) {
+    __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                          '/' - 63, 'A', 0, 0);
+    return _mm_add_epi8(_mm_shuffle_epi8(offsets, range), indices);
+}
+
+// Each step reads 16 bytes and consumes 12
+FILEVAULT_TARGET_SSSE3
+size_t base64_encode_ssse3(const uint8_t* in, size_t n, char* out) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 12) {
+        store(out + i / 3 * 4, base64_chars(base64_indices(load(in + i))));
+    }
+    return i;
+}
+
+// Six-bit values of 16 characters, or false if one is outside the alphabet
+FILEVAULT_TARGET_SSSE3
+inline bool base64_values(__m128i c, __m128i& values) {
+    const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                         0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                         0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+
+    __m128i hi = _mm_and_si128(_mm_srli_epi32(c, 4), nibble);
+    __m128i lo = _mm_and_si128(c, nibble);
+    __m128i bad = _mm_and_si128(_mm_shuffle_epi8(lut_lo, lo), _mm_shuffle_epi8(lut_hi, hi));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(bad, _mm_setzero_si128())) != 0xFFFF) {
+        return false;
+    }
+    __m128i slash = _mm_cmpeq_epi8(c, _mm_set1_epi8('/'));
+    values = _mm_add_epi8(c, _mm_shuffle_epi8(lut_roll, _mm_add_epi8(slash, hi)));
+    return true;
+}
+
+// 16 six-bit values to 12 bytes in the low lanes
+FILEVAULT_TARGET_SSSE3
+inline __m128i base64_pack(__m128i values) {
+    __m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    __m128i triples = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+    return _mm_shuffle_epi8(triples, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+// Each step stores 16 bytes and keeps 12; stops at a bad character
+FILEVAULT_TARGET_SSSE3
+size_t base64_decode_ssse3(const char* in, size_t n, uint8_t* out, size_t room) {
+    size_t i = 0;
+    for (; i + 16 <= n && i / 4 * 3 + 16 <= room; i += 16) {
+        __m128i values;
+        if (!base64_values(load(in + i), values)) {
+            break;
+        }
+        store(out + i / 4 * 3, base64_pack(values));
+    }
+    return i;
+}
+
+FILEVAULT_TARGET_AVX2
+inline __m256i load256(const void* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+FILEVAULT_TARGET_AVX2
+inline void store256(void* p, __m256i v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+}
+
+FILEVAULT_TARGET_AVX2
+size_t hex_encode_avx2(const uint8_t* in, size_t n, char* out, bool uppercase) {
+    const __m256i digits = _mm256_broadcastsi128_si256(load(uppercase ? kHexUpper : kHexLower));
+    const __m256i low = _mm256_set1_epi8(0x0F);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = load256(in + i);
+        __m256i hi = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+        __m256i lo = _mm256_shuffle_epi8(digits, _mm256_and_si256(v, low));
+        // Unpacks interleave within 128-bit lanes: bytes 0-7|16-23 and 8-15|24-31
+        __m256i a = _mm256_unpacklo_epi8(hi, lo);
+        __m256i b = _mm256_unpackhi_epi8(hi, lo);
+        store256(out + 2 * i, _mm256_permute2x128_si256(a, b, 0x20));
+        store256(out + 2 * i + 32, _mm256_permute2x128_si256(a, b, 0x31));
+    }
+    return i + hex_encode_ssse3(in + i, n - i, out + 2 * i, uppercase);
+}
+
+FILEVAULT_TARGET_AVX2
+inline bool hex_values_avx2(__m256i c, __m256i& values) {
+    __m256i digit = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+    __m256i alpha = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    __m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+    __m256i is_alpha = _mm256_cmpeq_epi8(_mm256_min_epu8(alpha, _mm256_set1_epi8(5)), alpha);
+    values = _mm256_or_si256(_mm256_and_si256(is_digit, digit),
+                             _mm256_and_si256(is_alpha, _mm256_add_epi8(alpha, _mm256_set1_epi8(10))));
+    return _mm256_movemask_epi8(_mm256_or_si256(is_digit, is_alpha)) == -1;
+}
+
+FILEVAULT_TARGET_AVX2
+size_t hex_decode_avx2(const char* in, size_t n, uint8_t* out) {
+    const __m256i weights = _mm256_set1_epi16(0x0110);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i a, b;
+        if (!hex_values_avx2(load256(in + 2 * i), a) || !hex_values_avx2(load256(in + 2 * i + 32), b)) {
+            break;
+        }
+        // Per-lane pack gives a.lo b.lo a.hi b.hi; restore byte order
+        __m256i packed = _mm256_packus_epi16(_mm256_maddubs_epi16(a, weights), _mm256_maddubs_epi16(b, weights));
+        store256(out + i, _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    return i + hex_decode_ssse3(in + 2 * i, n - i, out + i);
+}
+
+// Two SSSE3 steps side by side: lanes take bytes 0-11 and 12-23 of 28 readable
+FILEVAULT_TARGET_AVX2
+size_t base64_encode_avx2(const uint8_t* in, size_t n, char* out) {
+    size_t i = 0;
+    for (; i + 28 <= n; i += 24) {
+        __m128i lo = base64_chars(base64_indices(load(in + i)));
+        __m128i hi = base64_chars(base64_indices(load(in + i + 12)));
+        store256(out + i / 3 * 4, _mm256_set_m128i(hi, lo));
+    }
+    return i + base64_encode_ssse3(in + i, n - i, out + i / 3 * 4);
+}
+
+// Two SSSE3 steps side by side, compacted to 24 contiguous bytes
+FILEVAULT_TARGET_AVX2
+size_t base64_decode_avx2(const char* in, size_t n, uint8_t* out, size_t room) {
+    size_t i = 0;
+    for (; i + 32 <= n && i / 4 * 3 + 32 <= room; i += 32) {
+        __m128i lo, hi;
+        if (!base64_values(load(in + i), lo) || !base64_values(load(in + i + 16), hi)) {
+            break;
+        }
+        __m256i packed = _mm256_set_m128i(base64_pack(hi), base64_pack(lo));
+        store256(out + i / 4 * 3, _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7)));
+    }
+    size_t o = i / 4 * 3;
+    return i + base64_decode_ssse3(in + i, n - i, out + o, room - o);
+}
+
+#elif defined(FILEVAULT_CODEC_NEON)
+
+size_t hex_encode_neon(const uint8_t* in, size_t n, char* out, bool uppercase) {
+    const uint8x16_t digits = vld1q_u8(reinterpret_cast<const uint8_t*>(uppercase ? kHexUpper : kHexLower));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t v = vld1q_u8(in + i);
+        uint8x16x2_t chars;
+        chars.val[0] = vqtbl1q_u8(digits, vshrq_n_u8(v, 4));
+        chars.val[1] = vqtbl1q_u8(digits, vandq_u8(v, vdupq_n_u8(0x0F)));
+        vst2q_u8(reinterpret_cast<uint8_t*>(out + 2 * i), chars);
+    }
+    return i;
+}
+
+inline uint8x16_t hex_values_neon(uint8x16_t c, uint8x16_t& valid) {
+    uint8x16_t digit = vsubq_u8(c, vdupq_n_u8('0'));
+    uint8x16_t alpha = vsubq_u8(vorrq_u8(c, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+    uint8x16_t is_digit = vcleq_u8(digit, vdupq_n_u8(9));
+    uint8x16_t is_alpha = vcleq_u8(alpha, vdupq_n_u8(5));
+    valid = vandq_u8(valid, vorrq_u8(is_digit, is_alpha));
+    return vorrq_u8(vandq_u8(is_digit, digit), vandq_u8(is_alpha, vaddq_u8(alpha, vdupq_n_u8(10))));
+}
+
+size_t hex_decode_neon(const char* in, size_t n, uint8_t* out) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x2_t chars = vld2q_u8(reinterpret_cast<const uint8_t*>(in + 2 * i));
+        uint8x16_t valid = vdupq_n_u8(0xFF);
+        uint8x16_t hi = hex_values_neon(chars.val[0], valid);
+        uint8x16_t lo = hex_values_neon(chars.val[1], valid);
+        if (vminvq_u8(valid) == 0) {
+            break;
+        }
+        vst1q_u8(out + i, vorrq_u8(vshlq_n_u8(hi, 4), lo));
+    }
+    return i;
+}
+
+inline uint8x16x4_t base64_alphabet() {
+    return vld1q_u8_x4(reinterpret_cast<const uint8_t*>(kBase64));
+}
+
+size_t base64_encode_neon(const uint8_t* in, size_t n, char* out) {
+    const uint8x16x4_t alphabet = base64_alphabet();
+    const uint8x16_t six = vdupq_n_u8(0x3F);
+    size_t i = 0;
+    for (; i + 48 <= n; i += 48) {
+        uint8x16x3_t v = vld3q_u8(in + i);
+        uint8x16x4_t chars;
+        chars.val[0] = vshrq_n_u8(v.val[0], 2);
+        chars.val[1] = vandq_u8(vorrq_u8(vshlq_n_u8(v.val[0], 4), vshrq_n_u8(v.val[1], 4)), six);
+        chars.val[2] = vandq_u8(vorrq_u8(vshlq_n_u8(v.val[1], 2), vshrq_n_u8(v.val[2], 6)), six);
+        chars.val[3] = vandq_u8(v.val[2], six);
+        for (auto& c : chars.val) {
+            c = vqtbl4q_u8(alphabet, c);
+        }
+        vst4q_u8(reinterpret_cast<uint8_t*>(out + i / 3 * 4), chars);
+    }
+    return i;
+}
+
+size_t base64_decode_neon(const char* in, size_t n, uint8_t* out) {
+    // Two 64-entry halves of the 128 ASCII codes; characters >= 128 are invalid
+    uint8x16x4_t low, high;
+    low = vld1q_u8_x4(kBase64Values.data());
+    high = vld1q_u8_x4(kBase64Values.data() + 64);
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        uint8x16x4_t c = vld4q_u8(reinterpret_cast<const uint8_t*>(in + i));
+        uint8x16_t bad = vdupq_n_u8(0);
+        for (auto& v : c.val) {
+            uint8x16_t ascii_high = vcgeq_u8(v, vdupq_n_u8(128));
+            v = vqtbx4q_u8(vqtbl4q_u8(low, v), high, vsubq_u8(v, vdupq_n_u8(64)));
+            v = vorrq_u8(v, ascii_high);
+            bad = vorrq_u8(bad, v);
+        }
+        if (vmaxvq_u8(bad) > 0x3F) {
+            break;
+        }
+        uint8x16x3_t bytes;
+        bytes.val[0] = vorrq_u8(vshlq_n_u8(c.val[0], 2), vshrq_n_u8(c.val[1], 4));
+        bytes.val[1] = vorrq_u8(vshlq_n_u8(c.val[1], 4), vshrq_n_u8(c.val[2], 2));
+        bytes.val[2] = vorrq_u8(vshlq_n_u8(c.val[2], 6), c.val[3]);
+        vst3q_u8(out + i / 4 * 3, bytes);
+    }
+    return i;
+}
+
+#endif
+
+void check_isa(Isa isa) {
+    if (!is_supported(isa)) {
+        throw std::invalid_argument(std::string("Kernel not available on this CPU: ") + isa_name(isa));
+    }
+}
+
+void check_room(size_t needed, size_t available) {
+    if (available < needed) {
+        throw std::invalid_argument("Output buffer too small: need " + std::to_string(needed) +
+                                    " bytes, have " + std::to_string(available));
+    }
+}
+
+} // anonymous namespace
+
+Isa best_isa() {
+    [[maybe_unused]] const auto& cpu = core::CpuFeatures::detect();
+#if defined(FILEVAULT_CODEC_X86)
+    if (cpu.avx2) return Isa::AVX2;
+    if (cpu.ssse3) return Isa::SSSE3;
+    return Isa::Scalar;
+#elif defined(FILEVAULT_CODEC_NEON)
+    return Isa::NEON;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+bool is_supported(Isa isa) {
+    [[maybe_unused]] const auto& cpu = core::CpuFeatures::detect();
+    switch (isa) {
+        case Isa::Scalar: return true;
+#if defined(FILEVAULT_CODEC_X86)
+        case Isa::SSSE3:  return cpu.ssse3;
+        case Isa::AVX2:   return cpu.avx2 && cpu.ssse3;
+#elif defined(FILEVAULT_CODEC_NEON)
+        case Isa::NEON:   return true;
+#endif
+        default:          return false;
+    }
+}
+
+const char* isa_name(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::SSSE3:  return "ssse3";
+        case Isa::AVX2:   return "avx2";
+        case Isa::NEON:   return "neon";
+    }
+    return "unknown";
+}
+
+void hex_encode(std::span<const uint8_t> bytes, std::span<char> out, bool uppercase, Isa isa) {
+    check_isa(isa);
+    check_room(hex_encoded_size(bytes.size()), out.size());
+    size_t done = 0;
+    switch (isa) {
+#if defined(FILEVAULT_CODEC_X86)
+        case Isa::AVX2:  done = hex_encode_avx2(bytes.data(), bytes.size(), out.data(), uppercase); break;
+        case Isa::SSSE3: done = hex_encode_ssse3(bytes.data(), bytes.size(), out.data(), uppercase); break;
+#elif defined(FILEVAULT_CODEC_NEON)
+        case Isa::NEON:  done = hex_encode_neon(bytes.data(), bytes.size(), out.data(), uppercase); break;
+#endif
+        default: break;
+    }
+    hex_encode_scalar(bytes.data() + done, bytes.size() - done, out.data() + 2 * done, uppercase);
+}
+
+bool hex_decode(std::string_view hex, std::span<uint8_t> out, Isa isa) {
+    check_isa(isa);
+    if (hex.size() % 2 != 0) {
+        return false;
+    }
+    size_t n = hex.size() / 2;
+    check_room(n, out.size());
+    size_t done = 0;
+    switch (isa) {
+#if defined(FILEVAULT_CODEC_X86)
+        case Isa::AVX2:  done = hex_decode_avx2(hex.data(), n, out.data()); break;
+        case Isa::SSSE3: done = hex_decode_ssse3(hex.data(), n, out.data()); break;
+#elif defined(FILEVAULT_CODEC_NEON)
+        case Isa::NEON:  done = hex_decode_neon(hex.data(), n, out.data()); break;
+#endif
+        default: break;
+    }
+    return hex_decode_scalar(hex.data() + 2 * done, n - done, out.data() + done);
+}
+
+size_t base64_encode(std::span<const uint8_t> bytes, std::span<char> out, Isa isa) {
+    check_isa(isa);
+    check_room(base64_encoded_size(bytes.size()), out.size());
+    size_t done = 0;
+    switch (isa) {
+#if defined(FILEVAULT_CODEC_X86)
+        case Isa::AVX2:  done = base64_encode_avx2(bytes.data(), bytes.size(), out.data()); break;
+        case Isa::SSSE3: done = base64_encode_ssse3(bytes.data(), bytes.size(), out.data()); break;
+#elif defined(FILEVAULT_CODEC_NEON)
+        case Isa::NEON:  done = base64_encode_neon(bytes.data(), bytes.size(), out.data()); break;
+#endif
+        default: break;
+    }
+    size_t written = done / 3 * 4;
+    return written + base64_encode_scalar(bytes.data() + done, bytes.size() - done, out.data() + written);
+}
+
+std::optional<size_t> base64_decode(std::string_view text, std::span<uint8_t> out, Isa isa) {
+    check_isa(isa);
+    if (text.size() % 4 != 0) {
+        return std::nullopt;
+    }
+    check_room(base64_decoded_capacity(text.size()), out.size());
+
+    // SIMD never sees the last quad, the only one that may be padded
+    [[maybe_unused]] size_t body = text.empty() ? 0 : text.size() - 4;
+    size_t done = 0;
+    switch (isa) {
+#if defined(FILEVAULT_CODEC_X86)
+        case Isa::AVX2:  done = base64_decode_avx2(text.data(), body, out.data(), out.size()); break;
+        case Isa::SSSE3: done = base64_decode_ssse3(text.data(), body, out.data(), out.size()); break;
+#elif defined(FILEVAULT_CODEC_NEON)
+        case Isa::NEON:  done = base64_decode_neon(text.data(), body, out.data()); break;
+#endif
+        default: break;
+    }
+    size_t written = done / 4 * 3;
+    auto rest = base64_decode_scalar(text.data() + done, text.size() - done, out.data() + written);
+    if (!rest) {
+        return std::nullopt;
+    }
+    return written + *rest;
+}
+
+} // namespace filevault::utils::codec
@@ -1,5 +1,9 @@
 #include "filevault/utils/config.hpp"
+#include "filevault/core/offload.hpp"
 #include "filevault/utils/console.hpp"
+#include "filevault/utils/io_backend.hpp"
+#include <spdlog/spdlog.h>
+#include <cstdlib>
 #include <fstream>
 #include <sstream>
 
@@ -15,6 +19,202 @@
 namespace filevault {
 namespace utils {
 
+namespace {
+
+constexpr std::string_view PROFILES_PREFIX = "profiles.";
+
+bool parse_size(const std::string& value, size_t& out, size_t min_value = 0) {
+    try {
+        size_t used = 0;
+        unsigned long long parsed = std::stoull(value, &used);
+        if (used != value.size() || parsed < min_value || value.front() == '-') {
+            return false;
+        }
+        out = static_cast<size_t>(parsed);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+std::optional<bool> parse_bool(const std::string& value) {
+    if (value == "true" || value == "1" || value == "yes") return true;
+    if (value == "false" || value == "0" || value == "no") return false;
+    return std::nullopt;
+}
+
+} // anonymous namespace
+
+bool PerformanceProfile::set(const std::string& knob, const std::string& value) {
+    size_t number = 0;
+    if (knob == "threads") {
+        if (!parse_size(value, number)) return false;
+        threads = number;
+        return true;
+    }
+    if (knob == "streaming.chunk_mb") {
+        if (!parse_size(value, number, 1)) return false;
+        streaming_chunk_mb = number;
+        return true;
+    }
+    if (knob == "streaming.threshold_mb") {
+        if (!parse_size(value, number)) return false;
+        streaming_threshold_mb = number;
+        return true;
+    }
+    if (knob == "streaming.io_buffers") {
+        if (!parse_size(value, number) || number > 64) return false;
+        streaming_io_buffers = number;
+        return true;
+    }
+    if (knob == "io.backend") {
+        if (!IoBackend::parse(value)) return false;
+        io_backend = value;
+        return true;
+    }
+    if (knob == "io.direct") {
+        direct_io = parse_bool(value);
+        return direct_io.has_value();
+    }
+    if (knob == "memory.buffer_pool_mb") {
+        if (!parse_size(value, number)) return false;
+        buffer_pool_mb = number;
+        return true;
+    }
+    if (knob == "memory.huge_pages") {
+        huge_pages = parse_bool(value);
+        return huge_pages.has_value();
+    }
+    if (knob == "memory.max_mb") {
+        if (!parse_size(value, number)) return false;
+        max_memory_mb = number;
+        return true;
+    }
+    if (knob == "kdf.max_memory_mb") {
+        if (!parse_size(value, number, 1) || number > 1024 * 1024) return false;
+        kdf_max_memory_mb = static_cast<uint32_t>(number);
+        return true;
+    }
+    if (knob == "compression.target_mbps") {
+        try {
+            size_t used = 0;
+            double mbps = std::stod(value, &used);
+            if (used != value.size() || !(mbps > 0)) return false;
+            compression_target_mbps = mbps;
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+    if (knob == "crypto.offload") {
+        if (!core::Offload::parse_mode(value)) return false;
+        crypto_offload = value;
+        return true;
+    }
+    return false;
+}
+
+void PerformanceProfile::overlay(const PerformanceProfile& other) {
+    if (other.threads) threads = other.threads;
+    if (other.streaming_chunk_mb) streaming_chunk_mb = other.streaming_chunk_mb;
+    if (other.streaming_threshold_mb) streaming_threshold_mb = other.streaming_threshold_mb;
+    if (other.streaming_io_buffers) streaming_io_buffers = other.streaming_io_buffers;
+    if (other.io_backend) io_backend = other.io_backend;
+    if (other.direct_io) direct_io = other.direct_io;
+    if (other.buffer_pool_mb) buffer_pool_mb = other.buffer_pool_mb;
+    if (other.huge_pages) huge_pages = other.huge_pages;
+    if (other.max_memory_mb) max_memory_mb = other.max_memory_mb;
+    if (other.kdf_max_memory_mb) kdf_max_memory_mb = other.kdf_max_memory_mb;
+    if (other.compression_target_mbps) compression_target_mbps = other.compression_target_mbps;
+    if (other.crypto_offload) crypto_offload = other.crypto_offload;
+}
+
+nlohmann::json PerformanceProfile::to_json() const {
+    nlohmann::json j = nlohmann::json::object();
+    if (threads) j["threads"] = *threads;
+    if (streaming_chunk_mb) j["streaming"]["chunk_mb"] = *streaming_chunk_mb;
+    if (streaming_threshold_mb) j["streaming"]["threshold_mb"] = *streaming_threshold_mb;
+    if (streaming_io_buffers) j["streaming"]["io_buffers"] = *streaming_io_buffers;
+    if (io_backend) j["io"]["backend"] = *io_backend;
+    if (direct_io) j["io"]["direct"] = *direct_io;
+    if (buffer_pool_mb) j["memory"]["buffer_pool_mb"] = *buffer_pool_mb;
+    if (huge_pages) j["memory"]["huge_pages"] = *huge_pages;
+    if (max_memory_mb) j["memory"]["max_mb"] = *max_memory_mb;
+    if (kdf_max_memory_mb) j["kdf"]["max_memory_mb"] = *kdf_max_memory_mb;
+    if (compression_target_mbps) j["compression"]["target_mbps"] = *compression_target_mbps;
+    if (crypto_offload) j["crypto"]["offload"] = *crypto_offload;
+    return j;
+}
+
+PerformanceProfile PerformanceProfile::from_json(const nlohmann::json& j) {
+    PerformanceProfile profile;
+    // Same nesting as to_json(); a malformed knob is skipped, not fatal
+    auto read = [&j](const char* section, const char* key, auto& out) {
+        try {
+            const nlohmann::json* node = &j;
+            if (section) {
+                if (!j.contains(section)) return;
+                node = &j[section];
+            }
+            if (node->contains(key)) {
+                out = (*node)[key].get<typename std::decay_t<decltype(out)>::value_type>();
+            }
+        } catch (const std::exception&) {
+        }
+    };
+    read(nullptr, "threads", profile.threads);
+    read("streaming", "chunk_mb", profile.streaming_chunk_mb);
+    read("streaming", "threshold_mb", profile.streaming_threshold_mb);
+    read("streaming", "io_buffers", profile.streaming_io_buffers);
+    read("io", "backend", profile.io_backend);
+    read("io", "direct", profile.direct_io);
+    read("memory", "buffer_pool_mb", profile.buffer_pool_mb);
+    read("memory", "huge_pages", profile.huge_pages);
+    read("memory", "max_mb", profile.max_memory_mb);
+    read("kdf", "max_memory_mb", profile.kdf_max_memory_mb);
+    read("compression", "target_mbps", profile.compression_target_mbps);
+    read("crypto", "offload", profile.crypto_offload);
+    return profile;
+}
+
+const std::map<std::string, PerformanceProfile>& PerformanceProfile::builtin() {
+    static const std::map<std::string, PerformanceProfile> profiles = [] {
+        std::map<std::string, PerformanceProfile> p;
+        
+        // Dedicated backup hosts: every core, big chunks, bulk I/O that
+        // should not evict the page cache
+        auto& throughput = p["throughput"];
+        throughput.threads = 0;
+        throughput.streaming_chunk_mb = 16;
+        throughput.streaming_threshold_mb = 32;
+        throughput.io_backend = "auto";
+        throughput.crypto_offload = "off";     // Until the OpenCL path is proven on real GPUs
+        throughput.direct_io = true;
+        throughput.buffer_pool_mb = 2048;
+        throughput.huge_pages = true;
+        throughput.compression_target_mbps = 500.0;
+        
+        // Containers and small VMs: one worker, 1 MB chunks, little cached
+        auto& low_memory = p["low-memory"];
+        low_memory.threads = 1;
+        low_memory.streaming_chunk_mb = 1;
+        low_memory.streaming_threshold_mb = 16;
+        low_memory.buffer_pool_mb = 32;
+        low_memory.max_memory_mb = 512;
+        low_memory.kdf_max_memory_mb = 64;
+        
+        // Interactive machines: leave cores free, moderate memory
+        auto& laptop = p["laptop"];
+        laptop.threads = 2;
+        laptop.streaming_chunk_mb = 4;
+        laptop.buffer_pool_mb = 256;
+        laptop.kdf_max_memory_mb = 128;
+        laptop.compression_target_mbps = 100.0;
+        return p;
+    }();
+    return profiles;
+}
+
 std::filesystem::path Config::get_config_path() {
     std::filesystem::path config_dir;
     
@@ -49,6 +249,18 @@ std::filesystem::path Config::get_config_path() {
     return config_dir / "config.json";
 }
 
+std::filesystem::path Config::get_dictionary_dir() {
+    return get_config_path().parent_path() / "dictionaries";
+}
+
+std::filesystem::path Config::get_hash_cache_path() {
+    return get_config_path().parent_path() / "hash_cache.bin";
+}
+
+std::filesystem::path Config::get_breach_filter_path() {
+    return get_config_path().parent_path() / "breached.bloom";
+}
+
 Config Config::load() {
     auto config_path = get_config_path();
     
@@ -74,6 +286,11 @@ Config Config::load() {
     }
 }
 
+const Config& Config::current() {
+    static const Config config = load();
+    return config;
+}
+
 bool Config::save() const {
     try {
         auto config_path = get_config_path();
@@ -106,12 +323,21 @@ bool Config::save() const {
 Config Config::get_default() {
     Config config;
     config.default_mode_ = "standard";
-    config.default_algorithm_ = "aes-256-gcm";
+    config.default_algorithm_ = "auto";
     config.default_kdf_ = "argon2id";
     config.default_compression_ = "none";
     config.compression_level_ = 6;
     config.show_progress_ = true;
     config.verbose_ = false;
+    config.streaming_threshold_mb_ = 100;
+    config.streaming_chunk_mb_ = 4;
+    config.cpu_disabled_features_.clear();
+    config.kdf_max_memory_mb_ = 256;
+    config.kdf_calibrations_.clear();
+    config.io_backend_ = "auto";
+    config.profile_.clear();
+    config.profiles_.clear();
+    config.resolve_profile();
     return config;
 }
 
@@ -127,11 +353,43 @@ std::optional<std::string> Config::get(const std::string& key) const {
     if (key == "compression_level") return std::to_string(compression_level_);
     if (key == "show_progress") return show_progress_ ? "true" : "false";
     if (key == "verbose") return verbose_ ? "true" : "false";
+    if (key == "streaming.threshold_mb") return std::to_string(streaming_threshold_mb_);
+    if (key == "streaming.chunk_mb") return std::to_string(streaming_chunk_mb_);
+    if (key == "cpu.disabled_features") return cpu_disabled_features_;
+    if (key == "kdf.max_memory_mb") return std::to_string(kdf_max_memory_mb_);
+    if (key == "io.backend") return io_backend_;
+    if (key == "profile") return profile_.empty() ? "none" : profile_;
     
     return std::nullopt;
 }
 
 bool Config::set(const std::string& key, const std::string& value) {
+    if (key == "profile") {
+        if (value == "none" || value.empty()) {
+            profile_.clear();
+        } else if (find_profile(value)) {
+            profile_ = value;
+        } else {
+            return false;
+        }
+        resolve_profile();
+        return true;
+    }
+    if (key.starts_with(PROFILES_PREFIX)) {
+        // profiles.<name>.<knob>, where knobs may contain dots themselves
+        auto rest = key.substr(PROFILES_PREFIX.size());
+        size_t dot = rest.find('.');
+        if (dot == 0 || dot == std::string::npos) {
+            return false;
+        }
+        PerformanceProfile profile = profiles_[rest.substr(0, dot)];
+        if (!profile.set(rest.substr(dot + 1), value)) {
+            return false;
+        }
+        profiles_[rest.substr(0, dot)] = profile;
+        resolve_profile();
+        return true;
+    }
     if (key == "default.mode") {
         default_mode_ = value;
         return true;
@@ -164,11 +422,130 @@ bool Config::set(const std::string& key, const std::string& value) {
         verbose_ = (value == "true" || value == "1" || value == "yes");
         return true;
     }
+    if (key == "streaming.threshold_mb") {
+        try {
+            streaming_threshold_mb_ = std::stoul(value);
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+    if (key == "streaming.chunk_mb") {
+        try {
+            size_t mb = std::stoul(value);
+            if (mb == 0) {
+                return false;
+            }
+            streaming_chunk_mb_ = mb;
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+    if (key == "cpu.disabled_features") {
+        cpu_disabled_features_ = value;
+        return true;
+    }
+    if (key == "io.backend") {
+        if (!IoBackend::parse(value)) {
+            return false;
+        }
+        io_backend_ = value;
+        return true;
+    }
+    if (key == "kdf.max_memory_mb") {
+        try {
+            unsigned long mb = std::stoul(value);
+            if (mb == 0 || mb > 1024 * 1024) {
+                return false;
+            }
+            kdf_max_memory_mb_ = static_cast<uint32_t>(mb);
+            kdf_calibrations_.clear();  // Calibrated for the old budget
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
     
     return false;
 }
 
+std::optional<core::KdfProfile> Config::get_kdf_calibration(const std::string& key) const {
+    auto it = kdf_calibrations_.find(key);
+    if (it == kdf_calibrations_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+void Config::set_kdf_calibration(const std::string& key, const core::KdfProfile& profile) {
+    kdf_calibrations_[key] = profile;
+}
+
+std::optional<PerformanceProfile> Config::find_profile(const std::string& name) const {
+    const auto& builtin = PerformanceProfile::builtin();
+    auto shipped = builtin.find(name);
+    auto user = profiles_.find(name);
+    if (shipped == builtin.end() && user == profiles_.end()) {
+        return std::nullopt;
+    }
+    PerformanceProfile profile = shipped != builtin.end() ? shipped->second : PerformanceProfile{};
+    if (user != profiles_.end()) {
+        profile.overlay(user->second);
+    }
+    return profile;
+}
+
+std::vector<std::string> Config::profile_names() const {
+    std::vector<std::string> names;
+    for (const auto& [name, profile] : PerformanceProfile::builtin()) {
+        names.push_back(name);
+    }
+    for (const auto& [name, profile] : profiles_) {
+        if (!PerformanceProfile::builtin().count(name)) {
+            names.push_back(name);
+        }
+    }
+    return names;
+}
+
+void Config::resolve_profile() {
+    active_name_ = profile_;
+    if (const char* chosen = std::getenv("FILEVAULT_PROFILE"); chosen && *chosen) {
+        active_name_ = chosen;
+    }
+    if (active_name_ == "none") {
+        active_name_.clear();
+    }
+    active_ = {};
+    if (active_name_.empty()) {
+        return;
+    }
+    if (auto profile = find_profile(active_name_)) {
+        active_ = *profile;
+    } else {
+        spdlog::warn("Unknown performance profile '{}', using plain settings", active_name_);
+        active_name_.clear();
+    }
+}
+
 nlohmann::json Config::to_json() const {
+    nlohmann::json profiles = nlohmann::json::object();
+    for (const auto& [name, profile] : profiles_) {
+        profiles[name] = profile.to_json();
+    }
+    
+    nlohmann::json calibrations = nlohmann::json::object();
+    for (const auto& [key, profile] : kdf_calibrations_) {
+        calibrations[key] = {
+            {"kdf", static_cast<int>(profile.kdf)},
+            {"iterations", profile.iterations},
+            {"memory_kb", profile.memory_kb},
+            {"parallelism", profile.parallelism},
+            {"measured_ms", profile.measured_ms}
+        };
+    }
+    
     return nlohmann::json{
         {"version", "1.0"},
         {"default", {
@@ -181,7 +558,23 @@ nlohmann::json Config::to_json() const {
         {"ui", {
             {"show_progress", show_progress_},
             {"verbose", verbose_}
-        }}
+        }},
+        {"streaming", {
+            {"threshold_mb", streaming_threshold_mb_},
+            {"chunk_mb", streaming_chunk_mb_}
+        }},
+        {"cpu", {
+            {"disabled_features", cpu_disabled_features_}
+        }},
+        {"io", {
+            {"backend", io_backend_}
+        }},
+        {"kdf", {
+            {"max_memory_mb", kdf_max_memory_mb_},
+            {"calibrations", calibrations}
+        }},
+        {"profile", profile_},
+        {"profiles", profiles}
     };
 }
 
@@ -207,10 +600,52 @@ Config Config::from_json(const nlohmann::json& j) {
             if (ui.contains("verbose")) config.verbose_ = ui["verbose"];
         }
         
+        if (j.contains("streaming")) {
+            const auto& streaming = j["streaming"];
+            if (streaming.contains("threshold_mb")) config.streaming_threshold_mb_ = streaming["threshold_mb"];
+            if (streaming.contains("chunk_mb")) config.streaming_chunk_mb_ = streaming["chunk_mb"];
+        }
+        
+        if (j.contains("cpu")) {
+            const auto& cpu = j["cpu"];
+            if (cpu.contains("disabled_features")) config.cpu_disabled_features_ = cpu["disabled_features"];
+        }
+        
+        if (j.contains("io")) {
+            const auto& io = j["io"];
+            if (io.contains("backend")) config.io_backend_ = io["backend"];
+        }
+        
+        if (j.contains("kdf")) {
+            const auto& kdf = j["kdf"];
+            if (kdf.contains("max_memory_mb")) config.kdf_max_memory_mb_ = kdf["max_memory_mb"];
+            if (kdf.contains("calibrations")) {
+                for (const auto& [key, entry] : kdf["calibrations"].items()) {
+                    core::KdfProfile profile;
+                    profile.kdf = static_cast<core::KDFType>(entry["kdf"].get<int>());
+                    profile.iterations = entry["iterations"];
+                    profile.memory_kb = entry["memory_kb"];
+                    profile.parallelism = entry["parallelism"];
+                    profile.measured_ms = entry["measured_ms"];
+                    config.kdf_calibrations_[key] = profile;
+                }
+            }
+        }
+        
+        if (j.contains("profile")) {
+            config.profile_ = j["profile"];
+        }
+        if (j.contains("profiles")) {
+            for (const auto& [name, entry] : j["profiles"].items()) {
+                config.profiles_[name] = PerformanceProfile::from_json(entry);
+            }
+        }
+        
     } catch (const std::exception&) {
         // If any field fails, keep default value
     }
     
+    config.resolve_profile();
     return config;
 }
 
@@ -1,16 +1,71 @@
 #include "filevault/utils/crypto_utils.hpp"
-#include <botan/hex.h>
+#include "filevault/utils/codec_kernels.hpp"
 #include <fmt/core.h>
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+#include <stdexcept>
 
 namespace filevault {
 namespace utils {
 
-std::string CryptoUtils::hex_encode(std::span<const uint8_t> data) {
-    return Botan::hex_encode(data.data(), data.size());
+namespace {
+
+// Pasted keys and digests often carry spaces or line breaks
+std::string strip_whitespace(std::string_view text) {
+    std::string out;
+    out.reserve(text.size());
+    std::copy_if(text.begin(), text.end(), std::back_inserter(out),
+                 [](char c) { return !std::isspace(static_cast<unsigned char>(c)); });
+    return out;
+}
+
+bool has_whitespace(std::string_view text) {
+    return std::any_of(text.begin(), text.end(),
+                       [](char c) { return std::isspace(static_cast<unsigned char>(c)); });
+}
+
+} // anonymous namespace
+
+std::string CryptoUtils::hex_encode(std::span<const uint8_t> data, bool uppercase) {
+    std::string out(codec::hex_encoded_size(data.size()), '\0');
+    codec::hex_encode(data, out, uppercase);
+    return out;
 }
 
 std::vector<uint8_t> CryptoUtils::hex_decode(const std::string& hex) {
-    return Botan::hex_decode(hex);
+    std::string stripped;
+    std::string_view text = hex;
+    if (has_whitespace(text)) {
+        stripped = strip_whitespace(text);
+        text = stripped;
+    }
+    std::vector<uint8_t> out(text.size() / 2);
+    if (!codec::hex_decode(text, out)) {
+        throw std::invalid_argument("Invalid hex string");
+    }
+    return out;
+}
+
+std::string CryptoUtils::base64_encode(std::span<const uint8_t> data) {
+    std::string out(codec::base64_encoded_size(data.size()), '\0');
+    codec::base64_encode(data, out);
+    return out;
+}
+
+std::vector<uint8_t> CryptoUtils::base64_decode(std::string_view text) {
+    std::string stripped;
+    if (has_whitespace(text)) {
+        stripped = strip_whitespace(text);
+        text = stripped;
+    }
+    std::vector<uint8_t> out(codec::base64_decoded_capacity(text.size()));
+    auto written = codec::base64_decode(text, out);
+    if (!written) {
+        throw std::invalid_argument("Invalid base64 string");
+    }
+    out.resize(*written);
+    return out;
 }
 
 std::string CryptoUtils::format_bytes(size_t bytes) {
@@ -0,0 +1,261 @@
+/**
+ * @file dir_watcher.cpp
+ * @brief Change notifications for a directory tree, with burst coalescing
+ */
+
+#include "filevault/utils/dir_watcher.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <thread>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace filevault {
+namespace utils {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Longest a wait sleeps before looking at the stop flag again
+constexpr std::chrono::milliseconds STOP_CHECK_INTERVAL{1000};
+
+// Polling fallback: longest sleep between looks at the clock and flag
+constexpr std::chrono::milliseconds POLL_SLICE{250};
+
+#ifdef __linux__
+constexpr uint32_t WATCH_MASK = IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR;
+constexpr size_t EVENT_BUFFER_SIZE = 64 * 1024;
+#endif
+
+} // anonymous namespace
+
+ChangeDebouncer::ChangeDebouncer(Clock::duration quiet_period, Clock::duration max_delay)
+    : quiet_period_(quiet_period), max_delay_(max_delay) {
+}
+
+void ChangeDebouncer::touch(const fs::path& path, Clock::time_point now) {
+    auto [it, inserted] = bursts_.try_emplace(path, Burst{now, now});
+    if (!inserted) {
+        it->second.last = now;
+    }
+}
+
+ChangeDebouncer::Clock::time_point ChangeDebouncer::ready_at(const Burst& burst) const {
+    return (std::min)(burst.last + quiet_period_, burst.first + max_delay_);
+}
+
+std::vector<fs::path> ChangeDebouncer::take_ready(Clock::time_point now) {
+    std::vector<fs::path> ready;
+    for (auto it = bursts_.begin(); it != bursts_.end();) {
+        if (ready_at(it->second) <= now) {
+            ready.push_back(it->first);
+            it = bursts_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return ready;
+}
+
+std::vector<fs::path> ChangeDebouncer::take_all() {
+    std::vector<fs::path> all;
+    all.reserve(bursts_.size());
+    for (const auto& [path, burst] : bursts_) {
+        all.push_back(path);
+    }
+    bursts_.clear();
+    return all;
+}
+
+std::optional<ChangeDebouncer::Clock::time_point> ChangeDebouncer::next_deadline() const {
+    std::optional<Clock::time_point> next;
+    for (const auto& [path, burst] : bursts_) {
+        auto at = ready_at(burst);
+        if (!next || at < *next) {
+            next = at;
+        }
+    }
+    return next;
+}
+
+DirectoryWatcher::DirectoryWatcher(fs::path root, std::chrono::milliseconds poll_interval)
+    : root_(std::move(root)), poll_interval_(poll_interval) {
+}
+
+DirectoryWatcher::~DirectoryWatcher() {
+#ifdef __linux__
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+#endif
+}
+
+bool DirectoryWatcher::native() const {
+    return fd_ >= 0;
+}
+
+core::Result<void> DirectoryWatcher::start() {
+    std::error_code ec;
+    if (!fs::is_directory(root_, ec)) {
+        return core::Result<void>::error("Not a directory: " + root_.string());
+    }
+#ifdef __linux__
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ >= 0) {
+        add_tree(root_, nullptr);
+        if (!dirs_.empty()) {
+            return core::Result<void>::ok();
+        }
+        ::close(fd_);
+        fd_ = -1;
+    }
+#endif
+    // No kernel notifications: compare against a snapshot every interval
+    snapshot_ = scan();
+    next_poll_ = std::chrono::steady_clock::now() + poll_interval_;
+    return core::Result<void>::ok();
+}
+
+void DirectoryWatcher::add_tree(const fs::path& dir, WatchEvents* found) {
+#ifdef __linux__
+    auto watch = [this](const fs::path& path) {
+        int wd = inotify_add_watch(fd_, path.c_str(), WATCH_MASK);
+        if (wd >= 0) {
+            dirs_[wd] = path;
+        }
+    };
+    watch(dir);
+
+    // Files written before the watch was in place are reported as found
+    std::error_code ec;
+    fs::recursive_directory_iterator it(dir, fs::directory_options::skip_permission_denied, ec);
+    for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (it->is_directory(ec) && !it->is_symlink(ec)) {
+            watch(it->path());
+        } else if (found && it->is_regular_file(ec)) {
+            found->changed.push_back(it->path());
+        }
+    }
+#else
+    (void)dir;
+    (void)found;
+#endif
+}
+
+DirectoryWatcher::Snapshot DirectoryWatcher::scan() const {
+    Snapshot snapshot;
+    std::error_code ec;
+    fs::recursive_directory_iterator it(root_, fs::directory_options::skip_permission_denied, ec);
+    for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        std::error_code entry_ec;
+        if (!it->is_regular_file(entry_ec)) {
+            continue;
+        }
+        auto size = it->file_size(entry_ec);
+        auto mtime = it->last_write_time(entry_ec).time_since_epoch().count();
+        if (!entry_ec) {
+            snapshot[it->path().string()] = {size, static_cast<int64_t>(mtime)};
+        }
+    }
+    return snapshot;
+}
+
+WatchEvents DirectoryWatcher::wait(std::chrono::milliseconds timeout, const std::atomic<bool>& stop) {
+    using Clock = std::chrono::steady_clock;
+    WatchEvents events;
+    std::optional<Clock::time_point> deadline;
+    if (timeout.count() >= 0) {
+        deadline = Clock::now() + timeout;
+    }
+    auto remaining = [&deadline](std::chrono::milliseconds cap) {
+        if (!deadline) {
+            return cap;
+        }
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(*deadline - Clock::now());
+        return std::clamp(left, std::chrono::milliseconds(0), cap);
+    };
+
+    while (!stop.load(std::memory_order_relaxed)) {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            pollfd ready{fd_, POLLIN, 0};
+            int n = ::poll(&ready, 1, static_cast<int>(remaining(STOP_CHECK_INTERVAL).count()));
+            if (n < 0 && errno != EINTR) {
+                events.overflow = true;
+                return events;
+            }
+            if (n > 0) {
+                alignas(inotify_event) char buffer[EVENT_BUFFER_SIZE];
+                ssize_t length;
+                while ((length = ::read(fd_, buffer, sizeof(buffer))) > 0) {
+                    for (char* p = buffer; p < buffer + length;) {
+                        auto* event = reinterpret_cast<inotify_event*>(p);
+                        p += sizeof(inotify_event) + event->len;
+                        if (event->mask & IN_Q_OVERFLOW) {
+                            events.overflow = true;
+                            continue;
+                        }
+                        if (event->mask & IN_IGNORED) {
+                            dirs_.erase(event->wd);
+                            continue;
+                        }
+                        auto dir = dirs_.find(event->wd);
+                        if (dir == dirs_.end() || event->len == 0) {
+                            continue;
+                        }
+                        auto path = dir->second / event->name;
+                        if (event->mask & IN_ISDIR) {
+                            if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                                add_tree(path, &events);
+                            }
+                        } else {
+                            events.changed.push_back(std::move(path));
+                        }
+                    }
+                }
+                if (!events.changed.empty() || events.overflow) {
+                    std::sort(events.changed.begin(), events.changed.end());
+                    events.changed.erase(std::unique(events.changed.begin(), events.changed.end()),
+                                         events.changed.end());
+                    return events;
+                }
+            }
+            if (deadline && Clock::now() >= *deadline) {
+                return events;
+            }
+            continue;
+        }
+#endif
+        auto now = Clock::now();
+        if (now >= next_poll_) {
+            next_poll_ = now + poll_interval_;
+            auto current = scan();
+            for (const auto& [path, state] : current) {
+                auto old = snapshot_.find(path);
+                if (old == snapshot_.end() || old->second != state) {
+                    events.changed.emplace_back(path);
+                }
+            }
+            snapshot_ = std::move(current);
+            if (!events.changed.empty()) {
+                std::sort(events.changed.begin(), events.changed.end());
+                return events;
+            }
+        }
+        if (deadline && Clock::now() >= *deadline) {
+            return events;
+        }
+        auto until_poll = std::chrono::duration_cast<std::chrono::milliseconds>(next_poll_ - Clock::now());
+        std::this_thread::sleep_for((std::max)(std::chrono::milliseconds(1),
+                                                (std::min)(until_poll, remaining(POLL_SLICE))));
+    }
+    return events;
+}
+
+} // namespace utils
+} // namespace filevault
@@ -1,12 +1,30 @@
 #include "filevault/utils/file_io.hpp"
+#include "filevault/utils/io_backend.hpp"
+#include "filevault/utils/trace.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
 #include <fstream>
 #include <filesystem>
 #include <spdlog/spdlog.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#include <winioctl.h>
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace filevault {
 namespace utils {
 
-core::Result<std::vector<uint8_t>> FileIO::read_file(const std::string& path) {
+core::Result<std::vector<uint8_t>> FileIO::read_file(const std::string& path, bool bypass_cache) {
+    ScopedSpan trace_span("FileIO::read_file", "io");
     try {
         std::ifstream file(path, std::ios::binary);
         if (!file) {
@@ -17,14 +35,19 @@ core::Result<std::vector<uint8_t>> FileIO::read_file(const std::string& path) {
         size_t size = file.tellg();
         file.seekg(0, std::ios::beg);
         
+        trace_span.set_bytes(size);
+        
         std::vector<uint8_t> data(size);
         file.read(reinterpret_cast<char*>(data.data()), size);
         
         if (!file) {
             return core::Result<std::vector<uint8_t>>::error("Failed to read file: " + path);
         }
+        if (bypass_cache) {
+            drop_cache(path);
+        }
         
-        spdlog::debug("Read {} bytes from {}", size, path);
+        SPDLOG_DEBUG("Read {} bytes from {}", size, path);
         return core::Result<std::vector<uint8_t>>::ok(std::move(data));
         
     } catch (const std::exception& e) {
@@ -32,20 +55,150 @@ core::Result<std::vector<uint8_t>> FileIO::read_file(const std::string& path) {
     }
 }
 
-core::Result<void> FileIO::write_file(const std::string& path, std::span<const uint8_t> data) {
+// ============================================================================
+// MappedFile
+// ============================================================================
+
+MappedFile::~MappedFile() {
+    unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        data_ = other.data_;
+        size_ = other.size_;
+        mapped_ = other.mapped_;
+        owned_ = std::move(other.owned_);
+#ifdef _WIN32
+        mapping_handle_ = other.mapping_handle_;
+        other.mapping_handle_ = nullptr;
+#endif
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.mapped_ = false;
+    }
+    return *this;
+}
+
+void MappedFile::unmap() {
+    if (mapped_ && data_) {
+#ifdef _WIN32
+        UnmapViewOfFile(data_);
+        if (mapping_handle_) {
+            CloseHandle(static_cast<HANDLE>(mapping_handle_));
+            mapping_handle_ = nullptr;
+        }
+#else
+        munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+    }
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    owned_.clear();
+}
+
+core::Result<MappedFile> FileIO::map_file(const std::string& path) {
+    ScopedSpan trace_span("FileIO::map_file", "io");
+    MappedFile mapped;
+    
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return core::Result<MappedFile>::error("Cannot open file: " + path);
+    }
+    
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        CloseHandle(file);
+        return core::Result<MappedFile>::error("Cannot stat file: " + path);
+    }
+    
+    if (file_size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) {
+            void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (view) {
+                mapped.data_ = static_cast<const uint8_t*>(view);
+                mapped.size_ = static_cast<size_t>(file_size.QuadPart);
+                mapped.mapped_ = true;
+                mapped.mapping_handle_ = mapping;
+            } else {
+                CloseHandle(mapping);
+            }
+        }
+    }
+    CloseHandle(file);
+    bool need_fallback = file_size.QuadPart > 0 && !mapped.mapped_;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return core::Result<MappedFile>::error("Cannot open file: " + path);
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return core::Result<MappedFile>::error("Cannot stat file: " + path);
+    }
+    
+    bool need_fallback = !S_ISREG(st.st_mode);
+    if (!need_fallback && st.st_size > 0) {
+        void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            madvise(addr, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+            mapped.data_ = static_cast<const uint8_t*>(addr);
+            mapped.size_ = static_cast<size_t>(st.st_size);
+            mapped.mapped_ = true;
+        } else {
+            need_fallback = true;
+        }
+    }
+    ::close(fd);  // The mapping keeps its own reference
+#endif
+    
+    if (need_fallback) {
+        auto read_result = read_file(path);
+        if (!read_result) {
+            return core::Result<MappedFile>::error(read_result.error_message);
+        }
+        mapped.owned_ = std::move(read_result.value);
+        mapped.data_ = mapped.owned_.data();
+        mapped.size_ = mapped.owned_.size();
+    }
+    
+    trace_span.set_bytes(mapped.size_);
+    SPDLOG_DEBUG("Mapped {} bytes from {} ({})", mapped.size_, path,
+                  mapped.mapped_ ? "mmap" : "buffered");
+    return core::Result<MappedFile>::ok(std::move(mapped));
+}
+
+core::Result<void> FileIO::write_file(const std::string& path, std::span<const uint8_t> data,
+                                      bool bypass_cache) {
+    ScopedSpan trace_span("FileIO::write_file", "io", data.size());
     try {
-        std::ofstream file(path, std::ios::binary);
+        OutputFileOptions options;
+        options.atomic = true;
+        options.preallocate = data.size();
+        options.bypass_cache = bypass_cache;
+        OutputFile file(path, options);
         if (!file) {
             return core::Result<void>::error("Cannot create file: " + path);
         }
         
         file.write(reinterpret_cast<const char*>(data.data()), data.size());
         
-        if (!file) {
+        if (!file || !file.commit()) {
             return core::Result<void>::error("Failed to write file: " + path);
         }
         
-        spdlog::debug("Wrote {} bytes to {}", data.size(), path);
+        SPDLOG_DEBUG("Wrote {} bytes to {}", data.size(), path);
         return core::Result<void>::ok();
         
     } catch (const std::exception& e) {
@@ -53,6 +206,63 @@ core::Result<void> FileIO::write_file(const std::string& path, std::span<const u
     }
 }
 
+core::Result<std::vector<uint8_t>> FileIO::read_range(const std::string& path, uint64_t offset, size_t length) {
+    ScopedSpan trace_span("FileIO::read_range", "io", length);
+    std::vector<uint8_t> data(length);
+    size_t total = 0;
+    
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return core::Result<std::vector<uint8_t>>::error("Failed to open file: " + path);
+    }
+    while (total < length) {
+        OVERLAPPED at = {};
+        uint64_t position = offset + total;
+        at.Offset = static_cast<DWORD>(position);
+        at.OffsetHigh = static_cast<DWORD>(position >> 32);
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(length - total, 1u << 30));
+        DWORD got = 0;
+        if (!ReadFile(file, data.data() + total, chunk, &got, &at)) {
+            if (GetLastError() == ERROR_HANDLE_EOF) {
+                break;
+            }
+            CloseHandle(file);
+            return core::Result<std::vector<uint8_t>>::error("Failed to read file: " + path);
+        }
+        if (got == 0) {
+            break;
+        }
+        total += got;
+    }
+    CloseHandle(file);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return core::Result<std::vector<uint8_t>>::error("Failed to open file: " + path);
+    }
+    while (total < length) {
+        ssize_t got = pread(fd, data.data() + total, length - total, static_cast<off_t>(offset + total));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got < 0) {
+            close(fd);
+            return core::Result<std::vector<uint8_t>>::error("Failed to read file: " + path);
+        }
+        if (got == 0) {
+            break;
+        }
+        total += static_cast<size_t>(got);
+    }
+    close(fd);
+#endif
+    
+    data.resize(total);
+    return core::Result<std::vector<uint8_t>>::ok(std::move(data));
+}
+
 bool FileIO::file_exists(const std::string& path) {
     return std::filesystem::exists(path);
 }
@@ -64,5 +274,237 @@ size_t FileIO::file_size(const std::string& path) {
     return std::filesystem::file_size(path);
 }
 
+void FileIO::set_binary_stdio() {
+#ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+}
+
+bool FileIO::drop_cache(const std::string& path) {
+#if defined(_WIN32) || !defined(POSIX_FADV_DONTNEED)
+    (void)path;
+    return false;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    // Dirty pages are not dropped, so write them back first
+    bool ok = fdatasync(fd) == 0 && posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return ok;
+#endif
+}
+
+uint64_t FileIO::prefetch(const std::string& path, uint64_t length, bool bypass_cache) {
+    if (bypass_cache) {
+        return 0;
+    }
+    ScopedSpan trace_span("FileIO::prefetch", "io");
+#if !defined(_WIN32) && defined(POSIX_FADV_WILLNEED)
+    if (int fd = open(path.c_str(), O_RDONLY); fd >= 0) {
+        posix_fadvise(fd, 0, static_cast<off_t>(length), POSIX_FADV_WILLNEED);
+        close(fd);
+    }
+#endif
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return 0;
+    }
+    std::vector<char> buffer(1024 * 1024);
+    uint64_t total = 0;
+    while (total < length) {
+        auto want = std::min<uint64_t>(buffer.size(), length - total);
+        file.read(buffer.data(), static_cast<std::streamsize>(want));
+        if (file.gcount() <= 0) {
+            break;
+        }
+        total += static_cast<uint64_t>(file.gcount());
+    }
+    SPDLOG_DEBUG("Prefetched {} bytes of {}", total, path);
+    return total;
+}
+
+// ============================================================================
+// RandomAccessFile
+// ============================================================================
+
+RandomAccessFile::~RandomAccessFile() {
+    close();
+}
+
+RandomAccessFile::RandomAccessFile(RandomAccessFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+RandomAccessFile& RandomAccessFile::operator=(RandomAccessFile&& other) noexcept {
+    if (this != &other) {
+        close();
+#ifdef _WIN32
+        handle_ = other.handle_;
+        other.handle_ = nullptr;
+#else
+        fd_ = other.fd_;
+        other.fd_ = -1;
+#endif
+        path_ = std::move(other.path_);
+    }
+    return *this;
+}
+
+void RandomAccessFile::close() {
+#ifdef _WIN32
+    if (handle_) {
+        CloseHandle(static_cast<HANDLE>(handle_));
+        handle_ = nullptr;
+    }
+#else
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+#endif
+}
+
+bool RandomAccessFile::is_open() const {
+#ifdef _WIN32
+    return handle_ != nullptr;
+#else
+    return fd_ >= 0;
+#endif
+}
+
+core::Result<RandomAccessFile> RandomAccessFile::open(const std::string& path, bool writable) {
+    RandomAccessFile file;
+    file.path_ = path;
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ | (writable ? GENERIC_WRITE : 0),
+                                FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return core::Result<RandomAccessFile>::error("Failed to open file: " + path);
+    }
+    file.handle_ = handle;
+#else
+    file.fd_ = ::open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+    if (file.fd_ < 0) {
+        return core::Result<RandomAccessFile>::error("Failed to open file: " + path);
+    }
+#endif
+    return core::Result<RandomAccessFile>::ok(std::move(file));
+}
+
+core::Result<RandomAccessFile> RandomAccessFile::create(const std::string& path, uint64_t size) {
+    RandomAccessFile file;
+    file.path_ = path;
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                                CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return core::Result<RandomAccessFile>::error("Cannot create file (it may already exist): " + path);
+    }
+    file.handle_ = handle;
+    // Sparse, so the unwritten range takes no disk space
+    DWORD returned = 0;
+    DeviceIoControl(handle, FSCTL_SET_SPARSE, nullptr, 0, nullptr, 0, &returned, nullptr);
+    LARGE_INTEGER end;
+    end.QuadPart = static_cast<LONGLONG>(size);
+    if (!SetFilePointerEx(handle, end, nullptr, FILE_BEGIN) || !SetEndOfFile(handle)) {
+        file.close();
+        DeleteFileA(path.c_str());
+        return core::Result<RandomAccessFile>::error("Cannot size file: " + path);
+    }
+#else
+    file.fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (file.fd_ < 0) {
+        return core::Result<RandomAccessFile>::error(
+            errno == EEXIST ? "File already exists: " + path : "Cannot create file: " + path);
+    }
+    if (ftruncate(file.fd_, static_cast<off_t>(size)) != 0) {
+        file.close();
+        unlink(path.c_str());
+        return core::Result<RandomAccessFile>::error("Cannot size file: " + path);
+    }
+#endif
+    return core::Result<RandomAccessFile>::ok(std::move(file));
+}
+
+core::Result<void> RandomAccessFile::read_at(uint64_t offset, std::span<uint8_t> data) const {
+    ScopedSpan trace_span("RandomAccessFile::read_at", "io", data.size());
+    size_t total = 0;
+    while (total < data.size()) {
+#ifdef _WIN32
+        OVERLAPPED at = {};
+        uint64_t position = offset + total;
+        at.Offset = static_cast<DWORD>(position);
+        at.OffsetHigh = static_cast<DWORD>(position >> 32);
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(data.size() - total, 1u << 30));
+        DWORD got = 0;
+        if (!ReadFile(static_cast<HANDLE>(handle_), data.data() + total, chunk, &got, &at) || got == 0) {
+            return core::Result<void>::error("Failed to read file: " + path_);
+        }
+#else
+        ssize_t got = pread(fd_, data.data() + total, data.size() - total, static_cast<off_t>(offset + total));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return core::Result<void>::error("Failed to read file: " + path_);
+        }
+#endif
+        total += static_cast<size_t>(got);
+    }
+    return core::Result<void>::ok();
+}
+
+core::Result<void> RandomAccessFile::write_at(uint64_t offset, std::span<const uint8_t> data) {
+    ScopedSpan trace_span("RandomAccessFile::write_at", "io", data.size());
+    size_t total = 0;
+    while (total < data.size()) {
+#ifdef _WIN32
+        OVERLAPPED at = {};
+        uint64_t position = offset + total;
+        at.Offset = static_cast<DWORD>(position);
+        at.OffsetHigh = static_cast<DWORD>(position >> 32);
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(data.size() - total, 1u << 30));
+        DWORD put = 0;
+        if (!WriteFile(static_cast<HANDLE>(handle_), data.data() + total, chunk, &put, &at) || put == 0) {
+            return core::Result<void>::error("Failed to write file: " + path_);
+        }
+#else
+        ssize_t put = pwrite(fd_, data.data() + total, data.size() - total, static_cast<off_t>(offset + total));
+        if (put < 0 && errno == EINTR) {
+            continue;
+        }
+        if (put <= 0) {
+            return core::Result<void>::error("Failed to write file: " + path_);
+        }
+#endif
+        total += static_cast<size_t>(put);
+    }
+    return core::Result<void>::ok();
+}
+
+core::Result<void> RandomAccessFile::sync() {
+#ifdef _WIN32
+    bool ok = FlushFileBuffers(static_cast<HANDLE>(handle_)) != 0;
+#elif defined(__APPLE__)
+    bool ok = fsync(fd_) == 0;
+#else
+    bool ok = fdatasync(fd_) == 0;
+#endif
+    return ok ? core::Result<void>::ok() : core::Result<void>::error("Failed to sync file: " + path_);
+}
+
+uint64_t RandomAccessFile::size() const {
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    return GetFileSizeEx(static_cast<HANDLE>(handle_), &size) ? static_cast<uint64_t>(size.QuadPart) : 0;
+#else
+    struct stat info;
+    return fstat(fd_, &info) == 0 ? static_cast<uint64_t>(info.st_size) : 0;
+#endif
+}
+
 } // namespace utils
 } // namespace filevault
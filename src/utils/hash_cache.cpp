@@ -0,0 +1,257 @@
+/**
+ * @file hash_cache.cpp
+ * @brief Persistent digest cache for the hash command
+ */
+
+#include "filevault/utils/hash_cache.hpp"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace filevault {
+namespace utils {
+
+namespace {
+
+// File layout: "FVHC" | u32 version | u64 count | entries
+//   entry: u64 device | u64 inode | u64 size | i64 mtime_ns | i64 ctime_ns
+//          | u8 algorithm length | algorithm | u8 digest length | digest
+constexpr char MAGIC[4] = {'F', 'V', 'H', 'C'};
+constexpr uint32_t VERSION = 1;
+constexpr size_t KEY_PREFIX = 16;                         // device + inode
+constexpr int64_t RACY_WINDOW_NS = 2'000'000'000;         // Coarsest common mtime granularity
+
+void put_u64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+uint32_t get_u32(const uint8_t* in) {
+    return uint32_t(in[0]) | uint32_t(in[1]) << 8 | uint32_t(in[2]) << 16 | uint32_t(in[3]) << 24;
+}
+
+uint64_t get_u64(const uint8_t* in) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value |= uint64_t(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // anonymous namespace
+
+HashCache::HashCache(std::filesystem::path path)
+    : path_(std::move(path)) {
+}
+
+std::string HashCache::make_key(const FileIdentity& identity, const std::string& algorithm) {
+    std::string key;
+    key.reserve(KEY_PREFIX + algorithm.size());
+    put_u64(key, identity.device);
+    put_u64(key, identity.inode);
+    key += algorithm;
+    return key;
+}
+
+std::optional<FileIdentity> HashCache::identify(const std::filesystem::path& path) {
+    FileIdentity identity;
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return std::nullopt;
+    }
+    BY_HANDLE_FILE_INFORMATION info;
+    bool ok = GetFileInformationByHandle(file, &info) != 0;
+    CloseHandle(file);
+    if (!ok || (info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+        return std::nullopt;
+    }
+    // FILETIME is 100 ns ticks; NTFS has no ctime, so creation time stands in
+    auto ticks = [](FILETIME t) {
+        return static_cast<int64_t>((uint64_t(t.dwHighDateTime) << 32) | t.dwLowDateTime) * 100;
+    };
+    identity.device = info.dwVolumeSerialNumber;
+    identity.inode = (uint64_t(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+    identity.size = (uint64_t(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+    identity.mtime_ns = ticks(info.ftLastWriteTime);
+    identity.ctime_ns = ticks(info.ftCreationTime);
+#else
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        return std::nullopt;
+    }
+    identity.device = static_cast<uint64_t>(st.st_dev);
+    identity.inode = static_cast<uint64_t>(st.st_ino);
+    identity.size = static_cast<uint64_t>(st.st_size);
+#ifdef __APPLE__
+    identity.mtime_ns = int64_t(st.st_mtimespec.tv_sec) * 1'000'000'000 + st.st_mtimespec.tv_nsec;
+    identity.ctime_ns = int64_t(st.st_ctimespec.tv_sec) * 1'000'000'000 + st.st_ctimespec.tv_nsec;
+#else
+    identity.mtime_ns = int64_t(st.st_mtim.tv_sec) * 1'000'000'000 + st.st_mtim.tv_nsec;
+    identity.ctime_ns = int64_t(st.st_ctim.tv_sec) * 1'000'000'000 + st.st_ctim.tv_nsec;
+#endif
+#endif
+    return identity;
+}
+
+bool HashCache::load() {
+    std::ifstream file(path_, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    if (data.size() < 16 || std::memcmp(data.data(), MAGIC, 4) != 0 ||
+        get_u32(data.data() + 4) != VERSION) {
+        return false;
+    }
+    uint64_t count = get_u64(data.data() + 8);
+
+    // Read field by field; a truncated table keeps what came before the cut
+    size_t pos = 16;
+    auto take = [&](size_t n) {
+        if (data.size() - pos < n) {
+            return false;
+        }
+        pos += n;
+        return true;
+    };
+    for (uint64_t i = 0; i < count && i < MAX_ENTRIES; ++i) {
+        size_t start = pos;
+        if (!take(41)) {
+            break;
+        }
+        FileIdentity identity;
+        identity.device = get_u64(&data[start]);
+        identity.inode = get_u64(&data[start + 8]);
+        identity.size = get_u64(&data[start + 16]);
+        identity.mtime_ns = static_cast<int64_t>(get_u64(&data[start + 24]));
+        identity.ctime_ns = static_cast<int64_t>(get_u64(&data[start + 32]));
+        size_t algorithm_length = data[start + 40];
+        if (!take(algorithm_length + 1)) {
+            break;
+        }
+        std::string algorithm(data.begin() + start + 41, data.begin() + start + 41 + algorithm_length);
+        size_t digest_length = data[pos - 1];
+        if (!take(digest_length)) {
+            break;
+        }
+        std::string digest(data.begin() + (pos - digest_length), data.begin() + pos);
+        entries_[make_key(identity, algorithm)] = Entry{identity, std::move(digest), false};
+    }
+    return true;
+}
+
+core::Result<void> HashCache::save() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!dirty_) {
+        return core::Result<void>::ok();
+    }
+
+    bool prune = entries_.size() > MAX_ENTRIES;
+    std::string out(MAGIC, sizeof(MAGIC));
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>(VERSION >> (8 * i)));
+    }
+    size_t count_pos = out.size();
+    put_u64(out, 0);
+
+    uint64_t count = 0;
+    for (const auto& [key, entry] : entries_) {
+        if (prune && !entry.used) {
+            continue;
+        }
+        put_u64(out, entry.identity.device);
+        put_u64(out, entry.identity.inode);
+        put_u64(out, entry.identity.size);
+        put_u64(out, static_cast<uint64_t>(entry.identity.mtime_ns));
+        put_u64(out, static_cast<uint64_t>(entry.identity.ctime_ns));
+        out.push_back(static_cast<char>(key.size() - KEY_PREFIX));
+        out.append(key, KEY_PREFIX);
+        out.push_back(static_cast<char>(entry.digest.size()));
+        out += entry.digest;
+        count++;
+    }
+    std::string count_bytes;
+    put_u64(count_bytes, count);
+    out.replace(count_pos, 8, count_bytes);
+
+    std::error_code ec;
+    std::filesystem::create_directories(path_.parent_path(), ec);
+    auto temp_path = path_;
+    temp_path += ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        file.write(out.data(), static_cast<std::streamsize>(out.size()));
+        if (!file) {
+            std::filesystem::remove(temp_path, ec);
+            return core::Result<void>::error("Cannot write hash cache: " + temp_path.string());
+        }
+    }
+    std::filesystem::rename(temp_path, path_, ec);
+    if (ec) {
+        std::filesystem::remove(temp_path, ec);
+        return core::Result<void>::error("Cannot replace hash cache: " + path_.string());
+    }
+    dirty_ = false;
+    return core::Result<void>::ok();
+}
+
+std::optional<std::string> HashCache::lookup(const FileIdentity& identity, const std::string& algorithm) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(make_key(identity, algorithm));
+    if (it == entries_.end() || it->second.identity != identity) {
+        misses_++;
+        return std::nullopt;
+    }
+    it->second.used = true;
+    hits_++;
+    return it->second.digest;
+}
+
+std::optional<std::string> HashCache::stale(const FileIdentity& identity, const std::string& algorithm) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(make_key(identity, algorithm));
+    if (it == entries_.end() || it->second.identity.size != identity.size) {
+        return std::nullopt;
+    }
+    return it->second.digest;
+}
+
+void HashCache::store(const FileIdentity& identity, const std::string& algorithm, std::string digest) {
+    // Both length fields are one byte on disk
+    if (algorithm.size() > 255 || digest.size() > 255) {
+        return;
+    }
+    // A write in the same tick as the one we saw would leave the identity unchanged
+    if (identity.mtime_ns > now_ns() - RACY_WINDOW_NS) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[make_key(identity, algorithm)] = Entry{identity, std::move(digest), true};
+    dirty_ = true;
+}
+
+size_t HashCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+} // namespace utils
+} // namespace filevault
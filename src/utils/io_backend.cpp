@@ -0,0 +1,1608 @@
+/**
+ * @file io_backend.cpp
+ * @brief io_uring, IOCP, dispatch I/O and portable read backends, the
+ *        read-ahead InputFile and the descriptor-backed OutputFile
+ */
+
+#include "filevault/utils/io_backend.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <random>
+#include <set>
+#include <system_error>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <winioctl.h>
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef FILEVAULT_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+#ifdef __APPLE__
+#include <dispatch/dispatch.h>
+#include <condition_variable>
+#endif
+
+namespace filevault {
+namespace utils {
+
+namespace {
+
+// O_DIRECT alignment for buffers, offsets and lengths
+constexpr size_t ALIGNMENT = 4096;
+
+// Output written between page cache evictions
+constexpr uint64_t EVICT_WINDOW = 8 * 1024 * 1024;
+
+std::atomic<IoBackendType> default_type{IoBackendType::AUTO};
+
+// What AUTO stands for when no default is configured
+#if defined(_WIN32)
+constexpr IoBackendType NATIVE_TYPE = IoBackendType::IOCP;
+#elif defined(__APPLE__)
+constexpr IoBackendType NATIVE_TYPE = IoBackendType::DISPATCH;
+#else
+constexpr IoBackendType NATIVE_TYPE = IoBackendType::URING;
+#endif
+
+/**
+ * Writes back and drops ranges of one file from the page cache. Uses a
+ * descriptor of its own: cached pages belong to the file, not to the
+ * descriptor that wrote them.
+ */
+class CacheEvictor {
+public:
+    ~CacheEvictor() { close(); }
+
+    // false where the platform cannot evict (Windows, macOS)
+    bool open(const std::string& path) {
+        close();
+#if !defined(_WIN32) && defined(POSIX_FADV_DONTNEED)
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+#else
+        (void)path;
+#endif
+        return fd_ >= 0;
+    }
+
+    void close() {
+#ifndef _WIN32
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+#endif
+        fd_ = -1;
+    }
+
+    // Start writing back a range without waiting for it (Linux only)
+    void start_writeback(uint64_t offset, uint64_t length) {
+#ifdef SYNC_FILE_RANGE_WRITE
+        if (fd_ >= 0 && length > 0) {
+            sync_file_range(fd_, static_cast<off_t>(offset), static_cast<off_t>(length),
+                            SYNC_FILE_RANGE_WRITE);
+        }
+#else
+        (void)offset;
+        (void)length;
+#endif
+    }
+
+    // Dirty pages are not dropped, so written ranges are synced first
+    void evict(uint64_t offset, uint64_t length, bool dirty) {
+#if !defined(_WIN32) && defined(POSIX_FADV_DONTNEED)
+        if (fd_ < 0 || length == 0) {
+            return;
+        }
+        if (dirty) {
+#ifdef SYNC_FILE_RANGE_WRITE
+            sync_file_range(fd_, static_cast<off_t>(offset), static_cast<off_t>(length),
+                            SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+#else
+            fdatasync(fd_);
+#endif
+        }
+        posix_fadvise(fd_, static_cast<off_t>(offset), static_cast<off_t>(length), POSIX_FADV_DONTNEED);
+#else
+        (void)offset;
+        (void)length;
+        (void)dirty;
+#endif
+    }
+
+private:
+    int fd_ = -1;
+};
+
+bool sync_descriptor(int fd) {
+#ifdef _WIN32
+    return _commit(fd) == 0;
+#else
+    int rc;
+    do {
+        rc = fsync(fd);
+    } while (rc != 0 && errno == EINTR);
+    return rc == 0;
+#endif
+}
+
+// A rename is durable only once its directory is synced (POSIX)
+bool sync_directory(const std::filesystem::path& directory) {
+#ifdef _WIN32
+    (void)directory;
+    return true;
+#else
+    std::string name = directory.empty() ? "." : directory.string();
+    int fd = ::open(name.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECTORY);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = sync_descriptor(fd);
+    ::close(fd);
+    return ok;
+#endif
+}
+
+int open_for_sync(const std::string& path) {
+#ifdef _WIN32
+    return _open(path.c_str(), _O_RDWR | _O_BINARY);
+#else
+    return ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+#endif
+}
+
+void close_descriptor(int fd) {
+#ifdef _WIN32
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+}
+
+// Deallocate a range so it reads as zeros; false where unsupported
+bool punch_hole(int fd, uint64_t offset, uint64_t length) {
+#if defined(__linux__) && defined(FALLOC_FL_PUNCH_HOLE)
+    return fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                     static_cast<off_t>(offset), static_cast<off_t>(length)) == 0;
+#elif defined(_WIN32)
+    // Zeroed ranges are only deallocated in a file marked sparse
+    HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+    DWORD returned = 0;
+    if (!DeviceIoControl(handle, FSCTL_SET_SPARSE, nullptr, 0, nullptr, 0, &returned, nullptr)) {
+        return false;
+    }
+    FILE_ZERO_DATA_INFORMATION zero{};
+    zero.FileOffset.QuadPart = static_cast<LONGLONG>(offset);
+    zero.BeyondFinalZero.QuadPart = static_cast<LONGLONG>(offset + length);
+    return DeviceIoControl(handle, FSCTL_SET_ZERO_DATA, &zero, sizeof(zero),
+                           nullptr, 0, &returned, nullptr) != 0;
+#else
+    (void)fd;
+    (void)offset;
+    (void)length;
+    return false;
+#endif
+}
+
+class PortableBackend : public IoBackend {
+public:
+    const char* name() const override { return "portable"; }
+
+    bool open(const std::string& path, bool /*direct*/) override {
+        file_.open(path, std::ios::binary | std::ios::ate);
+        if (!file_) {
+            return false;
+        }
+        size_ = static_cast<uint64_t>(file_.tellg());
+        return true;
+    }
+
+    uint64_t size() const override { return size_; }
+
+    bool set_buffers(std::span<const std::span<uint8_t>> buffers) override {
+        buffers_.assign(buffers.begin(), buffers.end());
+        offsets_.assign(buffers.size(), 0);
+        return true;
+    }
+
+    void queue_read(size_t slot, uint64_t offset) override { offsets_[slot] = offset; }
+
+    bool submit() override { return true; }
+
+    int64_t wait(size_t slot) override {
+        auto buffer = buffers_[slot];
+        file_.clear();
+        file_.seekg(static_cast<std::streamoff>(offsets_[slot]));
+        file_.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+        if (file_.bad()) {
+            return -EIO;
+        }
+        return file_.gcount();
+    }
+
+private:
+    std::ifstream file_;
+    uint64_t size_ = 0;
+    std::vector<std::span<uint8_t>> buffers_;
+    std::vector<uint64_t> offsets_;
+};
+
+#ifdef FILEVAULT_HAVE_IO_URING
+
+int uring_setup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int uring_enter(int ring, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int uring_register(int ring, unsigned opcode, const void* arg, unsigned count) {
+    return static_cast<int>(syscall(__NR_io_uring_register, ring, opcode, arg, count));
+}
+
+/**
+ * One ring per file, sized to the slot count; each slot has at most one
+ * read in flight, so the submission queue cannot overflow. Without
+ * liburing the rings are mapped and driven by hand.
+ */
+class UringBackend : public IoBackend {
+public:
+    ~UringBackend() override {
+        if (sqes_) {
+            munmap(sqes_, sqes_size_);
+        }
+        if (cq_ring_ && cq_ring_ != sq_ring_) {
+            munmap(cq_ring_, cq_ring_size_);
+        }
+        if (sq_ring_) {
+            munmap(sq_ring_, sq_ring_size_);
+        }
+        if (ring_fd_ >= 0) {
+            close(ring_fd_);
+        }
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    const char* name() const override { return "io_uring"; }
+
+    bool open(const std::string& path, bool direct) override {
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | (direct ? O_DIRECT : 0));
+        if (fd_ < 0 && direct && errno == EINVAL) {
+            // Filesystems such as tmpfs refuse O_DIRECT
+            spdlog::debug("{}: O_DIRECT not supported, using the page cache", path);
+            fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        }
+        struct stat st {};
+        if (fd_ < 0 || fstat(fd_, &st) != 0) {
+            return false;
+        }
+        size_ = static_cast<uint64_t>(st.st_size);
+        return true;
+    }
+
+    uint64_t size() const override { return size_; }
+
+    bool set_buffers(std::span<const std::span<uint8_t>> buffers) override {
+        io_uring_params params {};
+        ring_fd_ = uring_setup(static_cast<unsigned>(buffers.size()), &params);
+        if (ring_fd_ < 0) {
+            return false;
+        }
+
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap) {
+            sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+        }
+        sq_ring_ = map_ring(sq_ring_size_, IORING_OFF_SQ_RING);
+        cq_ring_ = single_mmap ? sq_ring_ : map_ring(cq_ring_size_, IORING_OFF_CQ_RING);
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(map_ring(sqes_size_, IORING_OFF_SQES));
+        if (!sq_ring_ || !cq_ring_ || !sqes_) {
+            return false;
+        }
+
+        auto* sq = static_cast<uint8_t*>(sq_ring_);
+        auto* cq = static_cast<uint8_t*>(cq_ring_);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        iovecs_.clear();
+        for (auto buffer : buffers) {
+            iovecs_.push_back({buffer.data(), buffer.size()});
+        }
+        offsets_.assign(buffers.size(), 0);
+        results_.assign(buffers.size(), 0);
+        done_.assign(buffers.size(), false);
+
+        // Registered buffers are pinned once instead of on every read;
+        // RLIMIT_MEMLOCK may refuse, which only costs that saving
+        registered_ = uring_register(ring_fd_, IORING_REGISTER_BUFFERS, iovecs_.data(),
+                                     static_cast<unsigned>(iovecs_.size())) == 0;
+        if (!registered_) {
+            spdlog::debug("io_uring buffer registration failed: {}", std::strerror(errno));
+        }
+        return true;
+    }
+
+    void queue_read(size_t slot, uint64_t offset) override {
+        unsigned tail = *sq_tail_;
+        unsigned index = tail & sq_mask_;
+        io_uring_sqe* sqe = &sqes_[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->fd = fd_;
+        sqe->off = offset;
+        if (registered_) {
+            sqe->opcode = IORING_OP_READ_FIXED;
+            sqe->addr = reinterpret_cast<uint64_t>(iovecs_[slot].iov_base);
+            sqe->len = static_cast<uint32_t>(iovecs_[slot].iov_len);
+            sqe->buf_index = static_cast<uint16_t>(slot);
+        } else {
+            sqe->opcode = IORING_OP_READV;
+            sqe->addr = reinterpret_cast<uint64_t>(&iovecs_[slot]);
+            sqe->len = 1;
+        }
+        sqe->user_data = slot;
+        sq_array_[index] = index;
+        offsets_[slot] = offset;
+        done_[slot] = false;
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+        ++to_submit_;
+    }
+
+    bool submit() override {
+        while (to_submit_ > 0) {
+            int submitted = uring_enter(ring_fd_, to_submit_, 0, 0);
+            if (submitted < 0) {
+                if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                    continue;
+                }
+                return false;
+            }
+            to_submit_ -= static_cast<unsigned>(submitted);
+        }
+        return true;
+    }
+
+    int64_t wait(size_t slot) override {
+        while (!done_[slot]) {
+            if (!reap()) {
+                int rc = uring_enter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS);
+                if (rc < 0 && errno != EINTR) {
+                    return -errno;
+                }
+            }
+        }
+        done_[slot] = false;
+
+        int64_t got = results_[slot];
+        auto& iov = iovecs_[slot];
+        // Regular files only read short at end of file, but finish the
+        // slot synchronously if the kernel stops early anyway
+        while (got >= 0 && static_cast<size_t>(got) < iov.iov_len && offsets_[slot] + got < size_) {
+            ssize_t more = pread(fd_, static_cast<uint8_t*>(iov.iov_base) + got, iov.iov_len - got,
+                                 static_cast<off_t>(offsets_[slot] + got));
+            if (more < 0 && errno == EINTR) {
+                continue;
+            }
+            if (more <= 0) {
+                return more < 0 ? -errno : got;
+            }
+            got += more;
+        }
+        return got;
+    }
+
+private:
+    void* map_ring(size_t size, uint64_t offset) {
+        void* ring = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          ring_fd_, static_cast<off_t>(offset));
+        return ring == MAP_FAILED ? nullptr : ring;
+    }
+
+    // Collect every finished read; returns false if none was ready
+    bool reap() {
+        unsigned head = *cq_head_;
+        unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            return false;
+        }
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+            auto slot = static_cast<size_t>(cqe.user_data);
+            results_[slot] = cqe.res;
+            done_[slot] = true;
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    int fd_ = -1;
+    int ring_fd_ = -1;
+    uint64_t size_ = 0;
+    void* sq_ring_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    void* cq_ring_ = nullptr;
+    size_t cq_ring_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+    unsigned* sq_tail_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned* sq_array_ = nullptr;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned to_submit_ = 0;        // Queued but not yet handed to the kernel
+    bool registered_ = false;       // READ_FIXED into registered buffers, else READV
+    std::vector<iovec> iovecs_;
+    std::vector<uint64_t> offsets_;
+    std::vector<int64_t> results_;
+    std::vector<bool> done_;
+};
+
+#endif // FILEVAULT_HAVE_IO_URING
+
+#ifdef _WIN32
+
+/**
+ * Overlapped reads on a handle bound to a completion port of its own.
+ * Each slot owns an OVERLAPPED, so a completion names its slot. Reads
+ * served from the cache finish inside ReadFile and skip the port. With
+ * direct, FILE_FLAG_NO_BUFFERING reads straight into the aligned slots.
+ */
+class OverlappedBackend : public IoBackend {
+public:
+    ~OverlappedBackend() override {
+        if (file_ != INVALID_HANDLE_VALUE) {
+            // The kernel writes into the slots until each read completes
+            CancelIoEx(file_, nullptr);
+            while (in_flight_ > 0 && collect()) {
+            }
+            CloseHandle(file_);
+        }
+        if (port_) {
+            CloseHandle(port_);
+        }
+    }
+
+    const char* name() const override { return "iocp"; }
+
+    bool open(const std::string& path, bool direct) override {
+        DWORD flags = FILE_FLAG_OVERLAPPED | (direct ? FILE_FLAG_NO_BUFFERING : FILE_FLAG_SEQUENTIAL_SCAN);
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                            nullptr, OPEN_EXISTING, flags, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE && direct && GetLastError() == ERROR_INVALID_PARAMETER) {
+            spdlog::debug("{}: unbuffered reads not supported, using the file cache", path);
+            file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                nullptr, OPEN_EXISTING, FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        }
+        LARGE_INTEGER size{};
+        if (file_ == INVALID_HANDLE_VALUE || !GetFileSizeEx(file_, &size)) {
+            return false;
+        }
+        size_ = static_cast<uint64_t>(size.QuadPart);
+
+        port_ = CreateIoCompletionPort(file_, nullptr, 0, 1);
+        if (!port_) {
+            return false;
+        }
+        skip_port_ = SetFileCompletionNotificationModes(
+            file_, FILE_SKIP_COMPLETION_PORT_ON_SUCCESS | FILE_SKIP_SET_EVENT_ON_HANDLE) != 0;
+        return true;
+    }
+
+    uint64_t size() const override { return size_; }
+
+    bool set_buffers(std::span<const std::span<uint8_t>> buffers) override {
+        for (auto buffer : buffers) {
+            if (buffer.size() > MAXDWORD) {
+                return false;
+            }
+        }
+        buffers_.assign(buffers.begin(), buffers.end());
+        overlapped_.assign(buffers.size(), OVERLAPPED{});
+        results_.assign(buffers.size(), 0);
+        done_.assign(buffers.size(), false);
+        return true;
+    }
+
+    void queue_read(size_t slot, uint64_t offset) override {
+        OVERLAPPED& overlapped = overlapped_[slot];
+        overlapped = OVERLAPPED{};
+        overlapped.Offset = static_cast<DWORD>(offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        done_[slot] = false;
+        queued_.push_back(slot);
+    }
+
+    bool submit() override {
+        for (size_t slot : queued_) {
+            auto buffer = buffers_[slot];
+            OVERLAPPED* overlapped = &overlapped_[slot];
+            if (ReadFile(file_, buffer.data(), static_cast<DWORD>(buffer.size()), nullptr, overlapped)) {
+                if (skip_port_) {
+                    DWORD got = 0;
+                    BOOL ok = GetOverlappedResult(file_, overlapped, &got, FALSE);
+                    finish(slot, ok ? static_cast<int64_t>(got) : error_result(GetLastError()));
+                } else {
+                    ++in_flight_;
+                }
+                continue;
+            }
+            DWORD error = GetLastError();
+            if (error == ERROR_IO_PENDING) {
+                ++in_flight_;
+            } else {
+                // Refused outright (at end of file, for one): no completion follows
+                finish(slot, error_result(error));
+            }
+        }
+        queued_.clear();
+        return true;
+    }
+
+    int64_t wait(size_t slot) override {
+        while (!done_[slot]) {
+            if (!collect()) {
+                return -EIO;
+            }
+        }
+        done_[slot] = false;
+        return results_[slot];
+    }
+
+private:
+    static int64_t error_result(DWORD error) {
+        return error == ERROR_HANDLE_EOF ? 0 : -EIO;
+    }
+
+    void finish(size_t slot, int64_t result) {
+        results_[slot] = result;
+        done_[slot] = true;
+    }
+
+    // Take one completion off the port; false if the port itself failed
+    bool collect() {
+        DWORD got = 0;
+        ULONG_PTR key = 0;
+        OVERLAPPED* overlapped = nullptr;
+        BOOL ok = GetQueuedCompletionStatus(port_, &got, &key, &overlapped, INFINITE);
+        if (!overlapped) {
+            return false;
+        }
+        --in_flight_;
+        auto slot = static_cast<size_t>(overlapped - overlapped_.data());
+        finish(slot, ok ? static_cast<int64_t>(got) : error_result(GetLastError()));
+        return true;
+    }
+
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE port_ = nullptr;
+    uint64_t size_ = 0;
+    bool skip_port_ = false;        // Reads that finish inside ReadFile post no completion
+    size_t in_flight_ = 0;          // Completions still to come through the port
+    std::vector<std::span<uint8_t>> buffers_;
+    std::vector<OVERLAPPED> overlapped_;
+    std::vector<int64_t> results_;
+    std::vector<bool> done_;
+    std::vector<size_t> queued_;
+};
+
+#endif // _WIN32
+
+#ifdef __APPLE__
+
+/**
+ * Reads through a random-access dispatch I/O channel: libdispatch runs
+ * them on its own I/O threads (over kqueue) and delivers each one whole
+ * on a private serial queue, which copies it into the slot. With direct,
+ * F_NOCACHE keeps the blocks out of the unified buffer cache.
+ */
+class DispatchBackend : public IoBackend {
+public:
+    ~DispatchBackend() override {
+        if (channel_) {
+            // Stopped reads still call their handlers (with ECANCELED)
+            dispatch_io_close(channel_, DISPATCH_IO_STOP);
+            std::unique_lock<std::mutex> lock(mutex_);
+            finished_.wait(lock, [this] { return in_flight_ == 0; });
+            lock.unlock();
+            dispatch_release(channel_);     // The cleanup handler closes the descriptor
+        } else if (fd_ >= 0) {
+            close(fd_);
+        }
+        if (queue_) {
+            dispatch_release(queue_);
+        }
+    }
+
+    const char* name() const override { return "dispatch_io"; }
+
+    bool open(const std::string& path, bool direct) override {
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st {};
+        if (fd_ < 0 || fstat(fd_, &st) != 0) {
+            return false;
+        }
+        size_ = static_cast<uint64_t>(st.st_size);
+        if (direct && fcntl(fd_, F_NOCACHE, 1) != 0) {
+            spdlog::debug("{}: F_NOCACHE not supported, using the buffer cache", path);
+        }
+
+        queue_ = dispatch_queue_create("filevault.io", DISPATCH_QUEUE_SERIAL);
+        int fd = fd_;
+        channel_ = dispatch_io_create(DISPATCH_IO_RANDOM, fd, queue_, ^(int) { close(fd); });
+        if (!channel_) {
+            return false;
+        }
+        // One handler call per read, with all of its data
+        dispatch_io_set_low_water(channel_, SIZE_MAX);
+        return true;
+    }
+
+    uint64_t size() const override { return size_; }
+
+    bool set_buffers(std::span<const std::span<uint8_t>> buffers) override {
+        buffers_.assign(buffers.begin(), buffers.end());
+        offsets_.assign(buffers.size(), 0);
+        received_.assign(buffers.size(), 0);
+        results_.assign(buffers.size(), 0);
+        done_.assign(buffers.size(), false);
+        return true;
+    }
+
+    void queue_read(size_t slot, uint64_t offset) override {
+        offsets_[slot] = offset;
+        queued_.push_back(slot);
+    }
+
+    bool submit() override {
+        for (size_t slot : queued_) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                done_[slot] = false;
+                ++in_flight_;
+            }
+            received_[slot] = 0;
+            dispatch_io_read(channel_, static_cast<off_t>(offsets_[slot]), buffers_[slot].size(), queue_,
+                             ^(bool done, dispatch_data_t data, int error) { deliver(slot, done, data, error); });
+        }
+        queued_.clear();
+        return true;
+    }
+
+    int64_t wait(size_t slot) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        finished_.wait(lock, [this, slot] { return static_cast<bool>(done_[slot]); });
+        done_[slot] = false;
+        return results_[slot];
+    }
+
+private:
+    // Runs on queue_, one call at a time
+    void deliver(size_t slot, bool done, dispatch_data_t data, int error) {
+        auto target = buffers_[slot];
+        if (data) {
+            size_t base = received_[slot];
+            dispatch_data_apply(data, ^bool(dispatch_data_t, size_t offset, const void* bytes, size_t size) {
+                size_t at = base + offset;
+                if (at < target.size()) {
+                    std::memcpy(target.data() + at, bytes, std::min(size, target.size() - at));
+                }
+                return true;
+            });
+            received_[slot] += dispatch_data_get_size(data);
+        }
+        if (done) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            results_[slot] = error != 0 ? -static_cast<int64_t>(error)
+                                        : static_cast<int64_t>(std::min(received_[slot], target.size()));
+            done_[slot] = true;
+            --in_flight_;
+            finished_.notify_all();
+        }
+    }
+
+    int fd_ = -1;
+    uint64_t size_ = 0;
+    dispatch_queue_t queue_ = nullptr;
+    dispatch_io_t channel_ = nullptr;
+    std::vector<std::span<uint8_t>> buffers_;
+    std::vector<uint64_t> offsets_;
+    std::vector<size_t> received_;      // Bytes delivered so far (queue_ only)
+    std::vector<size_t> queued_;
+    std::mutex mutex_;
+    std::condition_variable finished_;
+    std::vector<int64_t> results_;      // results_, done_ and in_flight_ under mutex_
+    std::vector<bool> done_;
+    size_t in_flight_ = 0;
+};
+
+#endif // __APPLE__
+
+} // anonymous namespace
+
+bool IoBackend::uring_available() {
+#ifdef FILEVAULT_HAVE_IO_URING
+    // Containers and hardened kernels often block io_uring_setup
+    static const bool available = []() {
+        io_uring_params params {};
+        int ring = uring_setup(2, &params);
+        if (ring < 0) {
+            spdlog::debug("io_uring unavailable: {}", std::strerror(errno));
+            return false;
+        }
+        close(ring);
+        return true;
+    }();
+    return available;
+#else
+    return false;
+#endif
+}
+
+void IoBackend::set_default(IoBackendType type) {
+    default_type.store(type, std::memory_order_relaxed);
+}
+
+IoBackendType IoBackend::resolve(IoBackendType type) {
+    if (type == IoBackendType::AUTO) {
+        type = default_type.load(std::memory_order_relaxed);
+    }
+    if (type == IoBackendType::AUTO) {
+        type = NATIVE_TYPE;
+    }
+    // Each async backend exists on one platform only
+    bool available = type == IoBackendType::URING ? uring_available() : type == NATIVE_TYPE;
+    return available ? type : IoBackendType::PORTABLE;
+}
+
+std::unique_ptr<IoBackend> IoBackend::create(IoBackendType type) {
+    switch (resolve(type)) {
+#ifdef FILEVAULT_HAVE_IO_URING
+        case IoBackendType::URING: return std::make_unique<UringBackend>();
+#endif
+#ifdef _WIN32
+        case IoBackendType::IOCP: return std::make_unique<OverlappedBackend>();
+#endif
+#ifdef __APPLE__
+        case IoBackendType::DISPATCH: return std::make_unique<DispatchBackend>();
+#endif
+        default: return std::make_unique<PortableBackend>();
+    }
+}
+
+std::optional<IoBackendType> IoBackend::parse(std::string_view name) {
+    if (name == "auto") return IoBackendType::AUTO;
+    if (name == "uring" || name == "io_uring") return IoBackendType::URING;
+    if (name == "iocp" || name == "overlapped") return IoBackendType::IOCP;
+    if (name == "dispatch" || name == "dispatch_io") return IoBackendType::DISPATCH;
+    if (name == "portable") return IoBackendType::PORTABLE;
+    return std::nullopt;
+}
+
+const char* IoBackend::type_name(IoBackendType type) {
+    switch (type) {
+        case IoBackendType::URING: return "uring";
+        case IoBackendType::IOCP: return "iocp";
+        case IoBackendType::DISPATCH: return "dispatch";
+        case IoBackendType::PORTABLE: return "portable";
+        default: return "auto";
+    }
+}
+
+std::optional<std::vector<FileExtent>> data_extents(const std::string& path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return std::nullopt;
+    }
+    std::optional<std::vector<FileExtent>> extents;
+    LARGE_INTEGER size{};
+    if (GetFileSizeEx(file, &size)) {
+        extents.emplace();
+        FILE_ALLOCATED_RANGE_BUFFER query{};
+        query.Length = size;
+        FILE_ALLOCATED_RANGE_BUFFER ranges[64];
+        while (query.Length.QuadPart > 0) {
+            DWORD returned = 0;
+            BOOL done = DeviceIoControl(file, FSCTL_QUERY_ALLOCATED_RANGES, &query, sizeof(query),
+                                        ranges, sizeof(ranges), &returned, nullptr);
+            if (!done && GetLastError() != ERROR_MORE_DATA) {
+                extents.reset();
+                break;
+            }
+            size_t count = returned / sizeof(ranges[0]);
+            for (size_t i = 0; i < count; ++i) {
+                extents->push_back({static_cast<uint64_t>(ranges[i].FileOffset.QuadPart),
+                                    static_cast<uint64_t>(ranges[i].Length.QuadPart)});
+            }
+            if (done || count == 0) {
+                break;
+            }
+            // More ranges than fit: continue after the last one returned
+            LONGLONG next = ranges[count - 1].FileOffset.QuadPart + ranges[count - 1].Length.QuadPart;
+            query.Length.QuadPart -= next - query.FileOffset.QuadPart;
+            query.FileOffset.QuadPart = next;
+        }
+    }
+    CloseHandle(file);
+    return extents;
+#elif defined(SEEK_DATA) && defined(SEEK_HOLE)
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return std::nullopt;
+    }
+    std::optional<std::vector<FileExtent>> extents;
+    struct stat st {};
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        extents.emplace();
+        off_t offset = 0;
+        while (offset < st.st_size) {
+            off_t data = ::lseek(fd, offset, SEEK_DATA);
+            if (data < 0) {
+                // ENXIO: only a hole is left
+                if (errno != ENXIO) {
+                    extents.reset();
+                }
+                break;
+            }
+            off_t hole = ::lseek(fd, data, SEEK_HOLE);
+            if (hole < 0) {
+                extents.reset();
+                break;
+            }
+            hole = std::min(hole, st.st_size);
+            extents->push_back({static_cast<uint64_t>(data), static_cast<uint64_t>(hole - data)});
+            offset = hole;
+        }
+    }
+    ::close(fd);
+    return extents;
+#else
+    (void)path;
+    return std::nullopt;
+#endif
+}
+
+// InputFile implementation
+class InputFile::Buffer : public std::streambuf {
+public:
+    ~Buffer() override {
+        // The kernel may still be writing into the slots
+        drain();
+    }
+
+    bool open(const std::string& path, const InputFileOptions& options) {
+        drain();
+        backend_ = IoBackend::create(options.backend);
+        if (!backend_->open(path, options.direct)) {
+            backend_.reset();
+            return false;
+        }
+        size_ = backend_->size();
+        // Backends that could not open with O_DIRECT still keep out of the cache
+        evict_ = options.direct && evictor_.open(path);
+
+        block_size_ = std::max(ALIGNMENT, (options.block_size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT);
+        size_t depth = std::max<size_t>(options.depth, 2);
+        storage_.reset(static_cast<uint8_t*>(::operator new[](depth * block_size_, std::align_val_t(ALIGNMENT))));
+        slots_.clear();
+        for (size_t i = 0; i < depth; ++i) {
+            slots_.emplace_back(storage_.get() + i * block_size_, block_size_);
+        }
+        if (!backend_->set_buffers(slots_)) {
+            // A ring could not be set up after all; fall back for this file
+            spdlog::debug("{}: {} backend setup failed, using portable reads", path, backend_->name());
+            backend_ = IoBackend::create(IoBackendType::PORTABLE);
+            if (!backend_->open(path, false) || !backend_->set_buffers(slots_)) {
+                backend_.reset();
+                return false;
+            }
+        }
+        restart(0);
+        return true;
+    }
+
+    bool is_open() const { return backend_ != nullptr; }
+    uint64_t size() const { return size_; }
+    const char* backend_name() const { return backend_ ? backend_->name() : "none"; }
+
+protected:
+    int_type underflow() override {
+        if (gptr() < egptr()) {
+            return traits_type::to_int_type(*gptr());
+        }
+        if (!backend_) {
+            return traits_type::eof();
+        }
+        while (true) {
+            release_current();
+            fill_queue();
+            if (queued_.empty()) {
+                return traits_type::eof();
+            }
+
+            auto [slot, offset] = queued_.front();
+            queued_.pop_front();
+            int64_t got = backend_->wait(slot);
+            if (got < 0) {
+                free_.push_back(slot);
+                throw std::ios_base::failure("Read failed",
+                                             std::error_code(static_cast<int>(-got), std::generic_category()));
+            }
+            current_ = slot;
+            current_offset_ = offset;
+            // The freed slot was refilled above; keep the queue full
+            fill_queue();
+
+            auto* base = reinterpret_cast<char*>(slots_[slot].data());
+            size_t skip = std::min(skip_, static_cast<size_t>(got));
+            skip_ = 0;
+            setg(base, base + skip, base + got);
+            if (gptr() < egptr()) {
+                return traits_type::to_int_type(*gptr());
+            }
+        }
+    }
+
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+        if (!backend_ || !(which & std::ios_base::in)) {
+            return pos_type(off_type(-1));
+        }
+        if (dir == std::ios_base::cur && off == 0) {
+            return pos_type(static_cast<off_type>(position()));  // tellg()
+        }
+        off_type base = dir == std::ios_base::beg ? 0
+                      : dir == std::ios_base::cur ? static_cast<off_type>(position())
+                      : static_cast<off_type>(size_);
+        return seekpos(pos_type(base + off), which);
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+        auto target = static_cast<off_type>(pos);
+        if (!backend_ || !(which & std::ios_base::in) || target < 0) {
+            return pos_type(off_type(-1));
+        }
+        restart(static_cast<uint64_t>(target));
+        return pos;
+    }
+
+private:
+    struct Queued {
+        size_t slot;
+        uint64_t offset;
+    };
+
+    struct AlignedDelete {
+        void operator()(uint8_t* data) const { ::operator delete[](data, std::align_val_t(ALIGNMENT)); }
+    };
+
+    uint64_t position() const {
+        return current_offset_ + (current_ ? static_cast<uint64_t>(gptr() - eback()) : 0);
+    }
+
+    void release_current() {
+        if (current_) {
+            auto consumed = static_cast<uint64_t>(egptr() - eback());
+            if (evict_) {
+                evictor_.evict(current_offset_, consumed, false);
+            }
+            current_offset_ += consumed;
+            free_.push_back(*current_);
+            current_.reset();
+        }
+        setg(nullptr, nullptr, nullptr);
+    }
+
+    void fill_queue() {
+        bool queued = false;
+        while (!free_.empty() && next_offset_ < size_) {
+            size_t slot = free_.back();
+            free_.pop_back();
+            backend_->queue_read(slot, next_offset_);
+            queued_.push_back({slot, next_offset_});
+            next_offset_ += block_size_;
+            queued = true;
+        }
+        if (queued && !backend_->submit()) {
+            throw std::ios_base::failure("Read submission failed");
+        }
+    }
+
+    void drain() {
+        if (backend_) {
+            for (const auto& read : queued_) {
+                backend_->wait(read.slot);
+                free_.push_back(read.slot);
+            }
+        }
+        queued_.clear();
+    }
+
+    // Reads restart at the aligned block holding position
+    void restart(uint64_t position) {
+        drain();
+        release_current();
+        free_.clear();
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            free_.push_back(i);
+        }
+        position = std::min(position, size_);
+        next_offset_ = position / ALIGNMENT * ALIGNMENT;
+        skip_ = static_cast<size_t>(position - next_offset_);
+        current_offset_ = position;
+    }
+
+    std::unique_ptr<IoBackend> backend_;
+    std::unique_ptr<uint8_t[], AlignedDelete> storage_;
+    std::vector<std::span<uint8_t>> slots_;
+    std::vector<size_t> free_;          // Slots with no read queued or being consumed
+    std::deque<Queued> queued_;         // Reads in flight, in file order
+    std::optional<size_t> current_;     // Slot behind the get area
+    uint64_t current_offset_ = 0;       // File offset of eback(), or the position without a slot
+    uint64_t next_offset_ = 0;          // Offset of the next block to queue
+    size_t skip_ = 0;                   // Bytes of the next block before a seek target
+    size_t block_size_ = 0;
+    uint64_t size_ = 0;
+    CacheEvictor evictor_;
+    bool evict_ = false;                // Drop consumed blocks from the page cache
+};
+
+InputFile::InputFile()
+    : std::istream(nullptr), buffer_(std::make_unique<Buffer>()) {
+    rdbuf(buffer_.get());
+}
+
+InputFile::InputFile(const std::string& path, const InputFileOptions& options)
+    : InputFile() {
+    open(path, options);
+}
+
+InputFile::~InputFile() = default;
+
+bool InputFile::open(const std::string& path, const InputFileOptions& options) {
+    if (!buffer_->open(path, options)) {
+        setstate(std::ios_base::failbit);
+        return false;
+    }
+    clear();
+    return true;
+}
+
+bool InputFile::is_open() const {
+    return buffer_->is_open();
+}
+
+uint64_t InputFile::size() const {
+    return buffer_->size();
+}
+
+const char* InputFile::backend_name() const {
+    return buffer_->backend_name();
+}
+
+// OutputFile implementation
+class OutputFile::Buffer : public std::streambuf {
+public:
+    ~Buffer() override {
+        close();
+    }
+
+    bool open(const std::string& path, const OutputFileOptions& options) {
+        close();
+        path_ = path;
+        // Devices and pipes are written in place; a link keeps pointing
+        // at the file it names, which is what gets replaced
+        std::error_code ec;
+        auto status = std::filesystem::status(path, ec);
+        bool exists = std::filesystem::exists(status);
+        if (options.atomic && (!exists || std::filesystem::is_regular_file(status))) {
+            if (std::filesystem::is_symlink(std::filesystem::symlink_status(path, ec))) {
+                path_ = std::filesystem::canonical(path, ec).string();
+            }
+            // A fresh name each time, so concurrent jobs never share a temp file
+            std::random_device random;
+            for (int attempt = 0; attempt < 8 && fd_ < 0; ++attempt) {
+                temp_path_ = path_ + temp_suffix(random());
+                fd_ = open_descriptor(temp_path_, true, true);
+                if (fd_ < 0 && errno != EEXIST) {
+                    break;
+                }
+            }
+            if (fd_ >= 0 && exists) {
+                std::filesystem::permissions(temp_path_, status.permissions(), ec);
+            }
+        } else {
+            temp_path_.clear();
+            fd_ = open_descriptor(path, options.truncate, false);
+        }
+        if (fd_ < 0) {
+            temp_path_.clear();
+            return false;
+        }
+        failed_ = false;
+        position_ = end_ = evicted_ = started_ = 0;
+        reserved_ = 0;
+        if (options.preallocate > 0) {
+            reserve(options.preallocate);
+        }
+        evict_ = options.bypass_cache && evictor_.open(temp_path_.empty() ? path : temp_path_);
+        buffer_.resize(std::max<size_t>(options.buffer_size, ALIGNMENT));
+        setp(buffer_.data(), buffer_.data() + buffer_.size());
+        return true;
+    }
+
+    bool is_open() const { return fd_ >= 0; }
+
+    bool close() {
+        if (fd_ < 0) {
+            return !failed_;
+        }
+        bool ok = finish(false);
+        discard();
+        return ok;
+    }
+
+    bool commit(CommitGroup* group) {
+        if (fd_ < 0) {
+            return false;
+        }
+        bool atomic = !temp_path_.empty();
+        // A group syncs its files together, after this one is closed
+        if (!finish(!(atomic && group))) {
+            discard();
+            return false;
+        }
+        if (!atomic) {
+            return true;
+        }
+        if (group) {
+            group->add(temp_path_, path_);
+            temp_path_.clear();
+            return true;
+        }
+        std::error_code ec;
+        std::filesystem::rename(temp_path_, path_, ec);
+        if (ec) {
+            spdlog::error("Cannot move {} into place: {}", path_, ec.message());
+            discard();
+            return false;
+        }
+        temp_path_.clear();
+        return sync_directory(std::filesystem::path(path_).parent_path());
+    }
+
+    bool write_zeros(uint64_t length) {
+        if (fd_ < 0 || !flush_buffer()) {
+            return false;
+        }
+        finish_eviction();
+        uint64_t end = position_ + length;
+        uint64_t size = file_size();
+        if (!punch_hole(fd_, position_, length) && position_ < size) {
+            // No holes here: overwrite what the file already holds, the
+            // rest reads back as zeros once the file is extended
+            uint64_t overwrite_end = std::min(end, size);
+            std::fill(buffer_.begin(), buffer_.end(), char(0));
+            while (position_ < overwrite_end) {
+                size_t piece = static_cast<size_t>(std::min<uint64_t>(buffer_.size(), overwrite_end - position_));
+                if (!write_all(buffer_.data(), piece)) {
+                    return false;
+                }
+            }
+        }
+#ifdef _WIN32
+        bool ok = _lseeki64(fd_, static_cast<__int64>(end), SEEK_SET) >= 0 &&
+                  (end <= size || _chsize_s(fd_, static_cast<__int64>(end)) == 0);
+#else
+        bool ok = ::lseek(fd_, static_cast<off_t>(end), SEEK_SET) >= 0 &&
+                  (end <= size || ftruncate(fd_, static_cast<off_t>(end)) == 0);
+#endif
+        if (!ok) {
+            failed_ = true;
+            return false;
+        }
+        position_ = evicted_ = started_ = end;
+        end_ = std::max(end_, end);
+        return true;
+    }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (fd_ < 0 || !flush_buffer()) {
+            return traits_type::eof();
+        }
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char* data, std::streamsize count) override {
+        // Whole chunks go straight to the descriptor
+        if (fd_ >= 0 && static_cast<size_t>(count) >= buffer_.size()) {
+            if (!flush_buffer() || !write_all(data, static_cast<size_t>(count))) {
+                return 0;
+            }
+            advance_eviction();
+            return count;
+        }
+        return std::streambuf::xsputn(data, count);
+    }
+
+    int sync() override {
+        return fd_ >= 0 && flush_buffer() ? 0 : -1;
+    }
+
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+        if (fd_ < 0 || !(which & std::ios_base::out)) {
+            return pos_type(off_type(-1));
+        }
+        if (dir == std::ios_base::cur && off == 0) {
+            return pos_type(static_cast<off_type>(position_ + static_cast<uint64_t>(pptr() - pbase())));
+        }
+        if (!flush_buffer()) {
+            return pos_type(off_type(-1));
+        }
+        finish_eviction();
+        int whence = dir == std::ios_base::beg ? SEEK_SET : dir == std::ios_base::cur ? SEEK_CUR : SEEK_END;
+#ifdef _WIN32
+        auto target = _lseeki64(fd_, off, whence);
+#else
+        auto target = ::lseek(fd_, static_cast<off_t>(off), whence);
+#endif
+        if (target < 0) {
+            return pos_type(off_type(-1));
+        }
+        position_ = evicted_ = started_ = static_cast<uint64_t>(target);
+        return pos_type(static_cast<off_type>(target));
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+
+private:
+    static std::string temp_suffix(unsigned value) {
+        char suffix[16];
+        std::snprintf(suffix, sizeof(suffix), ".%08x.tmp", value);
+        return suffix;
+    }
+
+    static int open_descriptor(const std::string& path, bool truncate, bool exclusive) {
+#ifdef _WIN32
+        int flags = _O_WRONLY | _O_CREAT | _O_BINARY | (truncate ? _O_TRUNC : 0) | (exclusive ? _O_EXCL : 0);
+        return _open(path.c_str(), flags, _S_IREAD | _S_IWRITE);
+#else
+        int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : 0) | (exclusive ? O_EXCL : 0);
+        return ::open(path.c_str(), flags, 0666);
+#endif
+    }
+
+    uint64_t file_size() const {
+#ifdef _WIN32
+        struct _stat64 st {};
+        return _fstat64(fd_, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+#else
+        struct stat st {};
+        return fstat(fd_, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+#endif
+    }
+
+    // Reserve blocks past the end without changing the size, so a good
+    // estimate gives contiguous extents and an overestimate costs nothing
+    void reserve(uint64_t bytes) {
+#if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+        if (fallocate(fd_, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(bytes)) == 0) {
+            reserved_ = bytes;
+        }
+#else
+        (void)bytes;
+#endif
+    }
+
+    // Flush, release unused reserved blocks, optionally sync, and close
+    bool finish(bool sync) {
+        bool ok = flush_buffer();
+#ifndef _WIN32
+        struct stat st {};
+        if (reserved_ > 0 && fstat(fd_, &st) == 0 && reserved_ > static_cast<uint64_t>(st.st_size)) {
+            ok = ftruncate(fd_, st.st_size) == 0 && ok;
+        }
+#endif
+        if (sync) {
+            ok = ok && sync_descriptor(fd_);
+        }
+        finish_eviction();
+        evictor_.close();
+#ifdef _WIN32
+        ok = _close(fd_) == 0 && ok;
+#else
+        ok = ::close(fd_) == 0 && ok;
+#endif
+        fd_ = -1;
+        setp(nullptr, nullptr);
+        if (!ok) {
+            failed_ = true;
+        }
+        return ok;
+    }
+
+    // Drop an uncommitted atomic file
+    void discard() {
+        if (!temp_path_.empty()) {
+            std::error_code ec;
+            std::filesystem::remove(temp_path_, ec);
+            temp_path_.clear();
+        }
+    }
+
+    bool write_all(const char* data, size_t size) {
+        while (size > 0) {
+#ifdef _WIN32
+            int written = _write(fd_, data, static_cast<unsigned>(std::min<size_t>(size, 1u << 30)));
+#else
+            ssize_t written = ::write(fd_, data, size);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+#endif
+            if (written <= 0) {
+                failed_ = true;
+                return false;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+            position_ += static_cast<uint64_t>(written);
+        }
+        end_ = std::max(end_, position_);
+        return true;
+    }
+
+    bool flush_buffer() {
+        if (failed_) {
+            return false;
+        }
+        bool ok = write_all(pbase(), static_cast<size_t>(pptr() - pbase()));
+        setp(buffer_.data(), buffer_.data() + buffer_.size());
+        advance_eviction();
+        return ok;
+    }
+
+    // Wait for and drop the previous window while the kernel writes back
+    // the one just filled
+    void advance_eviction() {
+        if (evict_ && position_ - started_ >= EVICT_WINDOW) {
+            evictor_.evict(evicted_, started_ - evicted_, true);
+            evictor_.start_writeback(started_, position_ - started_);
+            evicted_ = started_;
+            started_ = position_;
+        }
+    }
+
+    void finish_eviction() {
+        if (evict_) {
+            evictor_.evict(evicted_, position_ - evicted_, true);
+            evicted_ = started_ = position_;
+        }
+    }
+
+    int fd_ = -1;
+    bool failed_ = false;
+    std::string path_;
+    std::string temp_path_;             // Atomic file being written, until committed
+    std::vector<char> buffer_;
+    uint64_t position_ = 0;             // File offset of pbase()
+    uint64_t end_ = 0;                  // Furthest byte written
+    uint64_t reserved_ = 0;             // Bytes preallocated
+    CacheEvictor evictor_;
+    bool evict_ = false;
+    uint64_t evicted_ = 0;              // Written data before this is out of the cache
+    uint64_t started_ = 0;              // Write-back was started up to here
+};
+
+OutputFile::OutputFile()
+    : std::ostream(nullptr), buffer_(std::make_unique<Buffer>()) {
+    rdbuf(buffer_.get());
+}
+
+OutputFile::OutputFile(const std::string& path, const OutputFileOptions& options)
+    : OutputFile() {
+    open(path, options);
+}
+
+OutputFile::~OutputFile() = default;
+
+bool OutputFile::open(const std::string& path, const OutputFileOptions& options) {
+    if (!buffer_->open(path, options)) {
+        setstate(std::ios_base::failbit);
+        return false;
+    }
+    clear();
+    return true;
+}
+
+bool OutputFile::is_open() const {
+    return buffer_->is_open();
+}
+
+bool OutputFile::close() {
+    if (!buffer_->close()) {
+        setstate(std::ios_base::badbit);
+        return false;
+    }
+    return true;
+}
+
+bool OutputFile::commit(CommitGroup* group) {
+    if (!buffer_->commit(group)) {
+        setstate(std::ios_base::badbit);
+        return false;
+    }
+    return true;
+}
+
+bool OutputFile::write_zeros(uint64_t length) {
+    if (!buffer_->write_zeros(length)) {
+        setstate(std::ios_base::badbit);
+        return false;
+    }
+    return true;
+}
+
+// NullOutput implementation
+class NullOutput::Buffer : public std::streambuf {
+public:
+    uint64_t bytes = 0;
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            ++bytes;
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char*, std::streamsize count) override {
+        bytes += static_cast<uint64_t>(count);
+        return count;
+    }
+};
+
+NullOutput::NullOutput()
+    : std::ostream(nullptr), buffer_(std::make_unique<Buffer>()) {
+    rdbuf(buffer_.get());
+}
+
+NullOutput::~NullOutput() = default;
+
+void NullOutput::write_zeros(uint64_t length) {
+    buffer_->bytes += length;
+}
+
+uint64_t NullOutput::bytes() const {
+    return buffer_->bytes;
+}
+
+// CommitGroup implementation
+CommitGroup::CommitGroup(size_t limit)
+    : limit_(std::max<size_t>(limit, 1)) {
+}
+
+CommitGroup::~CommitGroup() {
+    flush();
+}
+
+void CommitGroup::add(const std::string& temp_path, const std::string& path) {
+    std::vector<Pending> full;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.push_back({temp_path, path});
+        if (pending_.size() < limit_) {
+            return;
+        }
+        full.swap(pending_);
+    }
+    // The thread that fills the group commits it; others keep adding
+    commit(std::move(full));
+}
+
+bool CommitGroup::flush() {
+    std::vector<Pending> files;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        files.swap(pending_);
+    }
+    return commit(std::move(files));
+}
+
+size_t CommitGroup::failed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return failed_;
+}
+
+bool CommitGroup::commit(std::vector<Pending> files) {
+    if (files.empty()) {
+        return true;
+    }
+    // Queue write-back of every file before waiting on the first
+    std::vector<int> fds;
+    for (const auto& file : files) {
+        int fd = open_for_sync(file.temp_path);
+#ifdef SYNC_FILE_RANGE_WRITE
+        if (fd >= 0) {
+            sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WRITE);
+        }
+#endif
+        fds.push_back(fd);
+    }
+
+    size_t failed = 0;
+    std::set<std::filesystem::path> directories;
+    for (size_t i = 0; i < files.size(); ++i) {
+        bool ok = fds[i] >= 0 && sync_descriptor(fds[i]);
+        if (fds[i] >= 0) {
+            close_descriptor(fds[i]);
+        }
+        std::error_code ec;
+        if (ok) {
+            std::filesystem::rename(files[i].temp_path, files[i].path, ec);
+            ok = !ec;
+        }
+        if (!ok) {
+            spdlog::error("Cannot commit {}{}", files[i].path, ec ? ": " + ec.message() : "");
+            std::filesystem::remove(files[i].temp_path, ec);
+            ++failed;
+            continue;
+        }
+        directories.insert(std::filesystem::path(files[i].path).parent_path());
+    }
+    for (const auto& directory : directories) {
+        if (!sync_directory(directory)) {
+            spdlog::error("Cannot sync directory {}", directory.string());
+            ++failed;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    failed_ += failed;
+    return failed == 0;
+}
+
+} // namespace utils
+} // namespace filevault
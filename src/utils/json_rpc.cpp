@@ -0,0 +1,93 @@
+/**
+ * @file json_rpc.cpp
+ * @brief JSON-RPC 2.0 request dispatch
+ */
+
+#include "filevault/utils/json_rpc.hpp"
+
+namespace filevault {
+namespace utils {
+
+namespace {
+
+// Captured command output may hold invalid UTF-8; replace rather than throw
+std::string dump_line(const nlohmann::json& message) {
+    return message.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+}
+
+std::string error_response(const nlohmann::json& id, int code, const std::string& message) {
+    nlohmann::json response = {
+        {"jsonrpc", "2.0"},
+        {"id", id},
+        {"error", {{"code", code}, {"message", message}}}
+    };
+    return dump_line(response);
+}
+
+} // anonymous namespace
+
+void JsonRpcDispatcher::add(const std::string& method, Handler handler) {
+    handlers_[method] = std::move(handler);
+}
+
+std::string JsonRpcDispatcher::handle(const std::string& line, const Notify& notify) const {
+    nlohmann::json request = nlohmann::json::parse(line, nullptr, false);
+    if (request.is_discarded()) {
+        return error_response(nullptr, PARSE_ERROR, "Parse error");
+    }
+
+    // Batches are not supported; every line is a single request
+    if (!request.is_object() || request.value("jsonrpc", "") != "2.0" ||
+        !request.contains("method") || !request["method"].is_string()) {
+        return error_response(nullptr, INVALID_REQUEST, "Invalid request");
+    }
+
+    bool has_id = request.contains("id");
+    nlohmann::json id = has_id ? request["id"] : nlohmann::json(nullptr);
+    if (has_id && !id.is_string() && !id.is_number_integer() && !id.is_null()) {
+        return error_response(nullptr, INVALID_REQUEST, "Invalid request id");
+    }
+
+    std::string method = request["method"];
+    nlohmann::json params = request.value("params", nlohmann::json::object());
+    if (!params.is_object() && !params.is_array()) {
+        return has_id ? error_response(id, INVALID_PARAMS, "params must be an object or array") : "";
+    }
+
+    auto it = handlers_.find(method);
+    if (it == handlers_.end()) {
+        return has_id ? error_response(id, METHOD_NOT_FOUND, "Method not found: " + method) : "";
+    }
+
+    Notify tagged = [&](const std::string& event, const nlohmann::json& event_params) {
+        nlohmann::json with_id = event_params;
+        with_id["id"] = id;
+        notify(event, with_id);
+    };
+
+    nlohmann::json result;
+    try {
+        result = it->second(params, tagged);
+    } catch (const RpcError& e) {
+        return has_id ? error_response(id, e.code(), e.what()) : "";
+    } catch (const nlohmann::json::exception& e) {
+        // Wrong parameter types surface as json type errors
+        return has_id ? error_response(id, INVALID_PARAMS, e.what()) : "";
+    } catch (const std::exception& e) {
+        return has_id ? error_response(id, INTERNAL_ERROR, e.what()) : "";
+    }
+
+    if (!has_id) {
+        return "";
+    }
+    nlohmann::json response = {{"jsonrpc", "2.0"}, {"id", id}, {"result", std::move(result)}};
+    return dump_line(response);
+}
+
+std::string JsonRpcDispatcher::notification(const std::string& method, const nlohmann::json& params) {
+    nlohmann::json message = {{"jsonrpc", "2.0"}, {"method", method}, {"params", params}};
+    return dump_line(message);
+}
+
+} // namespace utils
+} // namespace filevault
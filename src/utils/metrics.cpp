@@ -0,0 +1,305 @@
+/**
+ * @file metrics.cpp
+ * @brief Per-thread counters and latency histograms merged on scrape
+ */
+
+#include "filevault/utils/metrics.hpp"
+#include <fmt/format.h>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace filevault {
+namespace utils {
+
+namespace {
+
+// Single writer: a plain load and store, no locked read-modify-write
+void bump(std::atomic<uint64_t>& counter, uint64_t delta) {
+    counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+std::string escape_label(const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        switch (c) {
+            case '\\': escaped += "\\\\"; break;
+            case '"':  escaped += "\\\""; break;
+            case '\n': escaped += "\\n"; break;
+            default:   escaped += c;
+        }
+    }
+    return escaped;
+}
+
+/**
+ * @brief {a="x",b="y"} with an optional extra label, or "" when there are none
+ */
+std::string format_labels(const MetricLabels& labels, const char* extra_name = nullptr,
+                          const std::string& extra_value = {}) {
+    if (labels.empty() && !extra_name) {
+        return {};
+    }
+    std::string text = "{";
+    for (const auto& [name, value] : labels) {
+        if (text.size() > 1) {
+            text += ',';
+        }
+        text += name + "=\"" + escape_label(value) + "\"";
+    }
+    if (extra_name) {
+        if (text.size() > 1) {
+            text += ',';
+        }
+        text += std::string(extra_name) + "=\"" + extra_value + "\"";
+    }
+    return text + "}";
+}
+
+struct ShardLease {
+    std::atomic<bool>* in_use = nullptr;
+
+    ~ShardLease() {
+        if (in_use) {
+            in_use->store(false, std::memory_order_release);
+        }
+    }
+};
+
+} // anonymous namespace
+
+void LatencyHistogram::record(uint64_t value) {
+    value = std::min(value, MAX_VALUE);
+    bump(counts_[bucket_of(value)], 1);
+    bump(total_, 1);
+    bump(sum_, value);
+    if (value > max_.load(std::memory_order_relaxed)) {
+        max_.store(value, std::memory_order_relaxed);
+    }
+}
+
+size_t LatencyHistogram::bucket_of(uint64_t value) {
+    value = std::min(value, MAX_VALUE);
+    if (value < 2 * SUB_BUCKETS) {
+        return static_cast<size_t>(value);
+    }
+    // Group g >= 1 covers [32 << g, 64 << g) in 32 steps of 2^g
+    unsigned group = static_cast<unsigned>(std::bit_width(value)) - (SUB_BITS + 1);
+    return static_cast<size_t>(SUB_BUCKETS * (group + 1) + ((value >> group) - SUB_BUCKETS));
+}
+
+uint64_t LatencyHistogram::bucket_limit(size_t bucket) {
+    if (bucket < 2 * SUB_BUCKETS) {
+        return bucket;
+    }
+    unsigned group = static_cast<unsigned>(bucket / SUB_BUCKETS) - 1;
+    uint64_t step = bucket % SUB_BUCKETS;
+    return ((SUB_BUCKETS + step) << group) + (uint64_t(1) << group) - 1;
+}
+
+void HistogramSnapshot::merge(const LatencyHistogram& histogram) {
+    if (counts.empty()) {
+        counts.resize(LatencyHistogram::BUCKETS, 0);
+    }
+    // Count from the buckets, so quantile() ranks against what it walks
+    for (size_t i = 0; i < LatencyHistogram::BUCKETS; i++) {
+        uint64_t n = histogram.count(i);
+        counts[i] += n;
+        count += n;
+    }
+    sum += histogram.sum();
+    max = std::max(max, histogram.max());
+}
+
+uint64_t HistogramSnapshot::quantile(double q) const {
+    if (count == 0) {
+        return 0;
+    }
+    auto rank = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(count)));
+    rank = std::clamp<uint64_t>(rank, 1, count);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return std::min(LatencyHistogram::bucket_limit(i), max);
+        }
+    }
+    return max;
+}
+
+Metrics& Metrics::instance() {
+    static Metrics metrics;
+    return metrics;
+}
+
+Metrics::Id Metrics::counter(const std::string& name, const MetricLabels& labels) {
+    return resolve(Kind::COUNTER, name, labels);
+}
+
+Metrics::Id Metrics::histogram(const std::string& name, const MetricLabels& labels) {
+    return resolve(Kind::HISTOGRAM, name, labels);
+}
+
+Metrics::Id Metrics::resolve(Kind kind, const std::string& name, const MetricLabels& labels) {
+    std::string key = (kind == Kind::COUNTER ? "c:" : "h:") + name + format_labels(labels);
+
+    thread_local std::unordered_map<std::string, Id> known;
+    if (auto it = known.find(key); it != known.end()) {
+        return it->second;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Id id;
+    if (auto it = index_.find(key); it != index_.end()) {
+        id = it->second;
+    } else if (series_.size() >= MAX_SERIES) {
+        return INVALID;     // Not cached: the table may never have room
+    } else {
+        id = series_.size();
+        series_.push_back({name, labels, kind});
+        index_.emplace(key, id);
+    }
+    known.emplace(std::move(key), id);
+    return id;
+}
+
+Metrics::Shard& Metrics::local_shard() {
+    thread_local Shard* shard = nullptr;
+    thread_local ShardLease lease;
+    if (shard) {
+        return *shard;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& candidate : shards_) {
+        bool idle = false;
+        if (candidate->in_use.compare_exchange_strong(idle, true, std::memory_order_acquire)) {
+            shard = candidate.get();
+            break;
+        }
+    }
+    if (!shard) {
+        shards_.push_back(std::make_unique<Shard>());
+        shard = shards_.back().get();
+    }
+    lease.in_use = &shard->in_use;
+    return *shard;
+}
+
+void Metrics::add(Id id, uint64_t delta) {
+    if (id >= MAX_SERIES) {
+        return;
+    }
+    bump(local_shard().counters[id], delta);
+}
+
+void Metrics::observe(Id id, uint64_t value) {
+    if (id >= MAX_SERIES) {
+        return;
+    }
+    auto& shard = local_shard();
+    auto* histogram = shard.histograms[id].load(std::memory_order_relaxed);
+    if (!histogram) {
+        shard.owned.push_back(std::make_unique<LatencyHistogram>());
+        histogram = shard.owned.back().get();
+        shard.histograms[id].store(histogram, std::memory_order_release);
+    }
+    histogram->record(value);
+}
+
+void Metrics::describe(const std::string& name, const std::string& help, double scale) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    families_[name] = {help, scale};
+}
+
+std::vector<Metrics::CounterValue> Metrics::counters() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<CounterValue> values;
+    for (Id id = 0; id < series_.size(); id++) {
+        if (series_[id].kind != Kind::COUNTER) {
+            continue;
+        }
+        uint64_t total = 0;
+        for (const auto& shard : shards_) {
+            total += shard->counters[id].load(std::memory_order_relaxed);
+        }
+        values.push_back({series_[id].name, series_[id].labels, total});
+    }
+    return values;
+}
+
+std::vector<Metrics::HistogramValue> Metrics::histograms() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<HistogramValue> values;
+    for (Id id = 0; id < series_.size(); id++) {
+        if (series_[id].kind != Kind::HISTOGRAM) {
+            continue;
+        }
+        HistogramValue value{series_[id].name, series_[id].labels, {}, 1.0};
+        if (auto it = families_.find(series_[id].name); it != families_.end()) {
+            value.scale = it->second.scale;
+        }
+        for (const auto& shard : shards_) {
+            if (auto* histogram = shard->histograms[id].load(std::memory_order_acquire)) {
+                value.snapshot.merge(*histogram);
+            }
+        }
+        values.push_back(std::move(value));
+    }
+    return values;
+}
+
+void Metrics::write_prometheus(std::string& out) const {
+    auto counter_values = counters();
+    auto histogram_values = histograms();
+    std::unordered_map<std::string, Family> families;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        families = families_;
+    }
+
+    // Samples of a family must be contiguous, under one HELP/TYPE header
+    auto header = [&](const std::string& name, const char* type, std::string& last) {
+        if (name == last) {
+            return;
+        }
+        last = name;
+        if (auto it = families.find(name); it != families.end() && !it->second.help.empty()) {
+            out += fmt::format("# HELP {} {}\n", name, it->second.help);
+        }
+        out += fmt::format("# TYPE {} {}\n", name, type);
+    };
+
+    std::stable_sort(counter_values.begin(), counter_values.end(),
+                     [](const CounterValue& a, const CounterValue& b) { return a.name < b.name; });
+    std::string last;
+    for (const auto& value : counter_values) {
+        header(value.name, "counter", last);
+        out += fmt::format("{}{} {}\n", value.name, format_labels(value.labels), value.value);
+    }
+
+    std::stable_sort(histogram_values.begin(), histogram_values.end(),
+                     [](const HistogramValue& a, const HistogramValue& b) { return a.name < b.name; });
+    last.clear();
+    for (const auto& value : histogram_values) {
+        header(value.name, "summary", last);
+        const auto& snapshot = value.snapshot;
+        for (auto [label, q] : {std::pair{"0.5", 0.5}, std::pair{"0.99", 0.99}, std::pair{"0.999", 0.999}}) {
+            out += fmt::format("{}{} {}\n", value.name, format_labels(value.labels, "quantile", label),
+                               static_cast<double>(snapshot.quantile(q)) * value.scale);
+        }
+        out += fmt::format("{}_sum{} {}\n", value.name, format_labels(value.labels),
+                           static_cast<double>(snapshot.sum) * value.scale);
+        out += fmt::format("{}_count{} {}\n", value.name, format_labels(value.labels), snapshot.count);
+    }
+}
+
+void Metrics::write_sample(std::string& out, const std::string& name, const std::string& help,
+                           const char* type, double value) {
+    out += fmt::format("# HELP {} {}\n# TYPE {} {}\n{} {}\n", name, help, name, type, name, value);
+}
+
+} // namespace utils
+} // namespace filevault
@@ -0,0 +1,439 @@
+/**
+ * @file multi_hash.cpp
+ * @brief Multi-buffer SHA-256 and BLAKE2s-256, one message per SIMD lane
+ */
+
+#include "filevault/utils/multi_hash.hpp"
+#include "filevault/core/cpu_features.hpp"
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+// Lanes are GCC/Clang vector types; the kernels are written once and
+// instantiated per width inside functions built for that instruction set
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+    #define FILEVAULT_MULTIHASH_X86 1
+    #define FILEVAULT_TARGET_AVX2 __attribute__((target("avx2")))
+    #define FILEVAULT_TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define FILEVAULT_ALWAYS_INLINE __attribute__((always_inline)) inline
+#else
+    #define FILEVAULT_ALWAYS_INLINE inline
+#endif
+
+namespace filevault::utils::multihash {
+
+namespace {
+
+#ifdef FILEVAULT_MULTIHASH_X86
+typedef uint32_t Lanes4 __attribute__((vector_size(16)));
+typedef uint32_t Lanes8 __attribute__((vector_size(32)));
+typedef uint32_t Lanes16 __attribute__((vector_size(64)));
+#endif
+
+#define FILEVAULT_ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+template<typename V>
+FILEVAULT_ALWAYS_INLINE uint32_t& lane(V& v, size_t index) {
+    return reinterpret_cast<uint32_t*>(&v)[index];
+}
+
+template<typename V>
+FILEVAULT_ALWAYS_INLINE uint32_t lane(const V& v, size_t index) {
+    return reinterpret_cast<const uint32_t*>(&v)[index];
+}
+
+uint32_t load_be32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+uint32_t load_le32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+constexpr uint32_t SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+constexpr uint32_t SHA256_IV[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+// BLAKE2s shares SHA-256's initial values
+constexpr const uint32_t* BLAKE2S_IV = SHA256_IV;
+
+constexpr uint8_t BLAKE2S_SIGMA[10][16] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+    {11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4},
+    {7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8},
+    {9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13},
+    {2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9},
+    {12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11},
+    {13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10},
+    {6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5},
+    {10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0}
+};
+
+/**
+ * @brief SHA-256 (FIPS 180-4): Merkle-Damgard, length-padded tail
+ */
+struct Sha256 {
+    static uint64_t blocks(size_t length) { return (length + 9 + 63) / 64; }
+    static uint64_t direct_blocks(size_t length) { return length / 64; }
+
+    // 0x80, zeros, then the length in bits; 64 or 128 bytes
+    static void tail(const uint8_t* data, size_t length, uint8_t* out) {
+        size_t rest = length % 64;
+        size_t size = (blocks(length) - direct_blocks(length)) * 64;
+        std::memcpy(out, data + length - rest, rest);
+        std::memset(out + rest, 0, size - rest);
+        out[rest] = 0x80;
+        uint64_t bits = static_cast<uint64_t>(length) * 8;
+        for (int i = 0; i < 8; ++i) {
+            out[size - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+        }
+    }
+
+    template<typename V>
+    static FILEVAULT_ALWAYS_INLINE void init(V* state, size_t index) {
+        for (int i = 0; i < 8; ++i) {
+            lane(state[i], index) = SHA256_IV[i];
+        }
+    }
+
+    template<typename V, size_t L>
+    static FILEVAULT_ALWAYS_INLINE void compress(V* state, const uint8_t* const* block, const uint64_t*, const bool*) {
+        V w[16];
+        for (int t = 0; t < 16; ++t) {
+            for (size_t l = 0; l < L; ++l) {
+                lane(w[t], l) = load_be32(block[l] + 4 * t);
+            }
+        }
+        V a = state[0], b = state[1], c = state[2], d = state[3];
+        V e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; ++i) {
+            if (i >= 16) {
+                V w15 = w[(i - 15) & 15];
+                V w2 = w[(i - 2) & 15];
+                V s0 = FILEVAULT_ROTR(w15, 7) ^ FILEVAULT_ROTR(w15, 18) ^ (w15 >> 3);
+                V s1 = FILEVAULT_ROTR(w2, 17) ^ FILEVAULT_ROTR(w2, 19) ^ (w2 >> 10);
+                w[i & 15] += s0 + w[(i - 7) & 15] + s1;
+            }
+            V t1 = h + (FILEVAULT_ROTR(e, 6) ^ FILEVAULT_ROTR(e, 11) ^ FILEVAULT_ROTR(e, 25)) +
+                   ((e & f) ^ (~e & g)) + SHA256_K[i] + w[i & 15];
+            V t2 = (FILEVAULT_ROTR(a, 2) ^ FILEVAULT_ROTR(a, 13) ^ FILEVAULT_ROTR(a, 22)) +
+                   ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+
+    template<typename V>
+    static FILEVAULT_ALWAYS_INLINE void digest(const V* state, size_t index, uint8_t* out) {
+        for (int i = 0; i < 8; ++i) {
+            uint32_t word = lane(state[i], index);
+            out[4 * i] = static_cast<uint8_t>(word >> 24);
+            out[4 * i + 1] = static_cast<uint8_t>(word >> 16);
+            out[4 * i + 2] = static_cast<uint8_t>(word >> 8);
+            out[4 * i + 3] = static_cast<uint8_t>(word);
+        }
+    }
+};
+
+/**
+ * @brief BLAKE2s-256 (RFC 7693), unkeyed: zero-padded last block, flagged
+ */
+struct Blake2s {
+    static uint64_t blocks(size_t length) { return length == 0 ? 1 : (length + 63) / 64; }
+    static uint64_t direct_blocks(size_t length) { return blocks(length) - 1; }
+
+    static void tail(const uint8_t* data, size_t length, uint8_t* out) {
+        size_t rest = length - direct_blocks(length) * 64;
+        if (rest > 0) {
+            std::memcpy(out, data + length - rest, rest);
+        }
+        std::memset(out + rest, 0, 64 - rest);
+    }
+
+    template<typename V>
+    static FILEVAULT_ALWAYS_INLINE void init(V* state, size_t index) {
+        for (int i = 0; i < 8; ++i) {
+            lane(state[i], index) = BLAKE2S_IV[i];
+        }
+        lane(state[0], index) ^= 0x01010000 | DIGEST_SIZE;     // Fanout and depth 1, no key
+    }
+
+    template<typename V, size_t L>
+    static FILEVAULT_ALWAYS_INLINE void compress(V* state, const uint8_t* const* block,
+                                                 const uint64_t* counter, const bool* last) {
+        V m[16];
+        for (int t = 0; t < 16; ++t) {
+            for (size_t l = 0; l < L; ++l) {
+                lane(m[t], l) = load_le32(block[l] + 4 * t);
+            }
+        }
+        V v[16];
+        for (int i = 0; i < 8; ++i) {
+            v[i] = state[i];
+            v[i + 8] = V{} + BLAKE2S_IV[i];
+        }
+        for (size_t l = 0; l < L; ++l) {
+            lane(v[12], l) ^= static_cast<uint32_t>(counter[l]);
+            lane(v[13], l) ^= static_cast<uint32_t>(counter[l] >> 32);
+            lane(v[14], l) ^= last[l] ? 0xFFFFFFFFu : 0u;
+        }
+
+#define FILEVAULT_BLAKE2S_G(a, b, c, d, x, y) \
+        do {                                                    \
+            v[a] += v[b] + m[x];                                \
+            v[d] = FILEVAULT_ROTR(v[d] ^ v[a], 16);             \
+            v[c] += v[d];                                       \
+            v[b] = FILEVAULT_ROTR(v[b] ^ v[c], 12);             \
+            v[a] += v[b] + m[y];                                \
+            v[d] = FILEVAULT_ROTR(v[d] ^ v[a], 8);              \
+            v[c] += v[d];                                       \
+            v[b] = FILEVAULT_ROTR(v[b] ^ v[c], 7);              \
+        } while (0)
+
+        for (int r = 0; r < 10; ++r) {
+            const uint8_t* s = BLAKE2S_SIGMA[r];
+            FILEVAULT_BLAKE2S_G(0, 4, 8, 12, s[0], s[1]);
+            FILEVAULT_BLAKE2S_G(1, 5, 9, 13, s[2], s[3]);
+            FILEVAULT_BLAKE2S_G(2, 6, 10, 14, s[4], s[5]);
+            FILEVAULT_BLAKE2S_G(3, 7, 11, 15, s[6], s[7]);
+            FILEVAULT_BLAKE2S_G(0, 5, 10, 15, s[8], s[9]);
+            FILEVAULT_BLAKE2S_G(1, 6, 11, 12, s[10], s[11]);
+            FILEVAULT_BLAKE2S_G(2, 7, 8, 13, s[12], s[13]);
+            FILEVAULT_BLAKE2S_G(3, 4, 9, 14, s[14], s[15]);
+        }
+#undef FILEVAULT_BLAKE2S_G
+
+        for (int i = 0; i < 8; ++i) {
+            state[i] ^= v[i] ^ v[i + 8];
+        }
+    }
+
+    template<typename V>
+    static FILEVAULT_ALWAYS_INLINE void digest(const V* state, size_t index, uint8_t* out) {
+        for (int i = 0; i < 8; ++i) {
+            uint32_t word = lane(state[i], index);
+            out[4 * i] = static_cast<uint8_t>(word);
+            out[4 * i + 1] = static_cast<uint8_t>(word >> 8);
+            out[4 * i + 2] = static_cast<uint8_t>(word >> 16);
+            out[4 * i + 3] = static_cast<uint8_t>(word >> 24);
+        }
+    }
+};
+
+/**
+ * @brief Feed messages through L lanes until every one is hashed
+ *
+ * Whole blocks are read in place; only a message's padded tail is copied.
+ * A lane with no message left compresses a dummy block whose result is
+ * never read.
+ */
+template<typename Kernel, typename V, size_t L>
+FILEVAULT_ALWAYS_INLINE void run(std::span<const std::span<const uint8_t>> messages, uint8_t* digests) {
+    struct Lane {
+        const uint8_t* data = nullptr;
+        size_t length = 0;
+        size_t message = 0;
+        uint64_t block = 0;
+        uint64_t blocks = 0;
+        uint64_t direct = 0;        // Blocks read straight from the message
+        bool active = false;
+        alignas(64) uint8_t tail[128];
+    };
+    static const uint8_t idle_block[64] = {};
+
+    std::array<Lane, L> slots;
+    V state[8] = {};
+    const uint8_t* block[L];
+    uint64_t counter[L] = {};
+    bool last[L] = {};
+    size_t next = 0;
+    size_t active = 0;
+
+    auto refill = [&](size_t l) {
+        Lane& slot = slots[l];
+        slot.active = next < messages.size();
+        if (!slot.active) {
+            return;
+        }
+        slot.message = next++;
+        slot.data = messages[slot.message].data();
+        slot.length = messages[slot.message].size();
+        slot.block = 0;
+        slot.blocks = Kernel::blocks(slot.length);
+        slot.direct = Kernel::direct_blocks(slot.length);
+        Kernel::tail(slot.data, slot.length, slot.tail);
+        Kernel::init(state, l);
+        ++active;
+    };
+    for (size_t l = 0; l < L; ++l) {
+        refill(l);
+    }
+
+    while (active > 0) {
+        for (size_t l = 0; l < L; ++l) {
+            const Lane& slot = slots[l];
+            if (!slot.active) {
+                block[l] = idle_block;
+                continue;
+            }
+            block[l] = slot.block < slot.direct ? slot.data + 64 * slot.block
+                                                : slot.tail + 64 * (slot.block - slot.direct);
+            last[l] = slot.block + 1 == slot.blocks;
+            counter[l] = last[l] ? slot.length : 64 * (slot.block + 1);
+        }
+        Kernel::template compress<V, L>(state, block, counter, last);
+        for (size_t l = 0; l < L; ++l) {
+            Lane& slot = slots[l];
+            if (slot.active && ++slot.block == slot.blocks) {
+                Kernel::digest(state, l, digests + DIGEST_SIZE * slot.message);
+                --active;
+                refill(l);
+            }
+        }
+    }
+}
+
+using Messages = std::span<const std::span<const uint8_t>>;
+
+template<typename Kernel>
+void run_scalar(Messages messages, uint8_t* digests) {
+    run<Kernel, uint32_t, 1>(messages, digests);
+}
+
+#ifdef FILEVAULT_MULTIHASH_X86
+// SSE2 is the x86-64 baseline, so the 4-lane path needs no attribute
+template<typename Kernel>
+void run_sse2(Messages messages, uint8_t* digests) {
+    run<Kernel, Lanes4, 4>(messages, digests);
+}
+
+template<typename Kernel>
+FILEVAULT_TARGET_AVX2 void run_avx2(Messages messages, uint8_t* digests) {
+    run<Kernel, Lanes8, 8>(messages, digests);
+}
+
+template<typename Kernel>
+FILEVAULT_TARGET_AVX512 void run_avx512(Messages messages, uint8_t* digests) {
+    run<Kernel, Lanes16, 16>(messages, digests);
+}
+#endif
+
+template<typename Kernel>
+void dispatch(Messages messages, uint8_t* digests, Isa isa) {
+    switch (isa) {
+#ifdef FILEVAULT_MULTIHASH_X86
+        case Isa::AVX512: run_avx512<Kernel>(messages, digests); return;
+        case Isa::AVX2:   run_avx2<Kernel>(messages, digests); return;
+        case Isa::SSE2:   run_sse2<Kernel>(messages, digests); return;
+#endif
+        default:          run_scalar<Kernel>(messages, digests); return;
+    }
+}
+
+} // anonymous namespace
+
+Isa best_isa() {
+    [[maybe_unused]] const auto& cpu = core::CpuFeatures::detect();
+#ifdef FILEVAULT_MULTIHASH_X86
+    if (cpu.avx512) return Isa::AVX512;
+    if (cpu.avx2) return Isa::AVX2;
+    return Isa::SSE2;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+bool is_supported(Isa isa) {
+    [[maybe_unused]] const auto& cpu = core::CpuFeatures::detect();
+    switch (isa) {
+        case Isa::Scalar: return true;
+#ifdef FILEVAULT_MULTIHASH_X86
+        case Isa::SSE2:   return true;
+        case Isa::AVX2:   return cpu.avx2;
+        case Isa::AVX512: return cpu.avx512;
+#endif
+        default:          return false;
+    }
+}
+
+const char* isa_name(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::SSE2:   return "sse2";
+        case Isa::AVX2:   return "avx2";
+        case Isa::AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+size_t lanes(Isa isa) {
+    switch (isa) {
+        case Isa::SSE2:   return 4;
+        case Isa::AVX2:   return 8;
+        case Isa::AVX512: return 16;
+        default:          return 1;
+    }
+}
+
+bool preferred(Algorithm algorithm) {
+    Isa isa = best_isa();
+    if (lanes(isa) < 4) {
+        return false;
+    }
+    return algorithm != Algorithm::SHA256 || !core::CpuFeatures::detect().sha || isa == Isa::AVX512;
+}
+
+std::optional<Algorithm> algorithm_for(std::string_view botan_name) {
+    if (botan_name == "SHA-256") {
+        return Algorithm::SHA256;
+    }
+    if (botan_name == "Blake2s(256)" || botan_name == "BLAKE2s(256)") {
+        return Algorithm::BLAKE2S_256;
+    }
+    return std::nullopt;
+}
+
+void hash(Algorithm algorithm, std::span<const std::span<const uint8_t>> messages,
+          std::span<uint8_t> digests, Isa isa) {
+    if (!is_supported(isa)) {
+        throw std::invalid_argument(std::string("Kernel not available on this CPU: ") + isa_name(isa));
+    }
+    if (digests.size() < messages.size() * DIGEST_SIZE) {
+        throw std::invalid_argument("Digest buffer too small: need " +
+                                    std::to_string(messages.size() * DIGEST_SIZE) + " bytes, have " +
+                                    std::to_string(digests.size()));
+    }
+    switch (algorithm) {
+        case Algorithm::SHA256:      dispatch<Sha256>(messages, digests.data(), isa); break;
+        case Algorithm::BLAKE2S_256: dispatch<Blake2s>(messages, digests.data(), isa); break;
+    }
+}
+
+} // namespace filevault::utils::multihash
@@ -0,0 +1,430 @@
+/**
+ * @file object_store.cpp
+ * @brief Object URLs, the multipart ObjectOutput and the ranged ObjectInput
+ */
+
+#include "filevault/utils/object_store.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <future>
+
+namespace filevault {
+namespace utils {
+
+namespace {
+
+constexpr std::string_view OBJECT_SCHEME = "s3://";
+
+} // anonymous namespace
+
+std::optional<ObjectUrl> ObjectUrl::parse(std::string_view url) {
+    if (!is_object_url(url)) {
+        return std::nullopt;
+    }
+    url.remove_prefix(OBJECT_SCHEME.size());
+    size_t slash = url.find('/');
+    if (slash == 0 || slash == std::string_view::npos || slash + 1 == url.size()) {
+        return std::nullopt;
+    }
+    return ObjectUrl{std::string(url.substr(0, slash)), std::string(url.substr(slash + 1))};
+}
+
+bool ObjectUrl::is_object_url(std::string_view text) {
+    return text.starts_with(OBJECT_SCHEME);
+}
+
+// ObjectOutput implementation
+class ObjectOutput::Buffer : public std::streambuf {
+public:
+    Buffer(ObjectStore& store, std::string key, const ObjectOutputOptions& options)
+        : store_(store), key_(std::move(key)), options_(options) {
+        options_.part_size = std::max<size_t>(options_.part_size, 1);
+        options_.max_in_flight = std::max<size_t>(options_.max_in_flight, 1);
+        auto upload = store_.begin_upload(key_);
+        if (!upload) {
+            fail("Cannot start upload of " + key_ + ": " + upload.error_message);
+            return;
+        }
+        upload_id_ = std::move(upload.value);
+        reset_part();
+    }
+
+    ~Buffer() override {
+        if (!upload_id_.empty() && !done_) {
+            abort();
+        }
+    }
+
+    bool is_open() const { return !upload_id_.empty(); }
+
+    bool finish() {
+        if (done_) {
+            return !failed_;
+        }
+        // An empty object is still one (empty) part
+        if (!failed_ && (pptr() > pbase() || next_part_ == 1)) {
+            submit_part();
+        }
+        while (!in_flight_.empty()) {
+            collect_oldest();
+        }
+        if (failed_) {
+            abort();
+            return false;
+        }
+        auto completed = store_.complete_upload(key_, upload_id_, etags_);
+        if (!completed) {
+            fail("Cannot complete upload of " + key_ + ": " + completed.error_message);
+            abort();
+            return false;
+        }
+        done_ = true;
+        spdlog::debug("Uploaded {} in {} parts ({} bytes)", key_, etags_.size(), written_);
+        return true;
+    }
+
+    const std::string& error() const { return error_; }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (failed_ || done_) {
+            return traits_type::eof();
+        }
+        submit_part();
+        if (failed_) {
+            return traits_type::eof();
+        }
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    // Parts are fixed-size; a flush has nothing it could upload early
+    int sync() override {
+        return failed_ ? -1 : 0;
+    }
+
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+        if (off != 0 || dir != std::ios_base::cur || !(which & std::ios_base::out)) {
+            return pos_type(off_type(-1));
+        }
+        return pos_type(static_cast<off_type>(written_ + static_cast<uint64_t>(pptr() - pbase())));
+    }
+
+private:
+    struct InFlight {
+        int part_number;
+        std::future<core::Result<std::string>> result;
+    };
+
+    void fail(std::string message) {
+        if (!failed_) {
+            spdlog::error("{}", message);
+            error_ = std::move(message);
+        }
+        failed_ = true;
+        setp(nullptr, nullptr);
+    }
+
+    void abort() {
+        // Parts still uploading would be orphaned by an abort sent first
+        while (!in_flight_.empty()) {
+            in_flight_.front().result.wait();
+            in_flight_.pop_front();
+        }
+        store_.abort_upload(key_, upload_id_);
+        done_ = true;
+    }
+
+    void reset_part() {
+        part_.resize(options_.part_size);
+        setp(part_.data(), part_.data() + part_.size());
+    }
+
+    // Hand the filled part to an upload thread, first waiting for the
+    // oldest one if max_in_flight are already out
+    void submit_part() {
+        while (in_flight_.size() >= options_.max_in_flight && !failed_) {
+            collect_oldest();
+        }
+        if (failed_) {
+            return;
+        }
+        size_t used = static_cast<size_t>(pptr() - pbase());
+        part_.resize(used);
+        written_ += used;
+        int number = next_part_++;
+        in_flight_.push_back({number, std::async(std::launch::async,
+            [this, number, data = std::move(part_)]() {
+                return store_.upload_part(key_, upload_id_, number,
+                                          std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(data.data()),
+                                                                   data.size()));
+            })});
+        part_ = {};
+        reset_part();
+    }
+
+    void collect_oldest() {
+        InFlight part = std::move(in_flight_.front());
+        in_flight_.pop_front();
+        auto etag = part.result.get();
+        if (!etag) {
+            fail("Upload of part " + std::to_string(part.part_number) + " of " + key_ +
+                 " failed: " + etag.error_message);
+            return;
+        }
+        if (etags_.size() < static_cast<size_t>(part.part_number)) {
+            etags_.resize(static_cast<size_t>(part.part_number));
+        }
+        etags_[static_cast<size_t>(part.part_number) - 1] = std::move(etag.value);
+    }
+
+    ObjectStore& store_;
+    std::string key_;
+    ObjectOutputOptions options_;
+    std::string upload_id_;
+    std::vector<char> part_;                // Put area: the part being filled
+    std::deque<InFlight> in_flight_;        // Oldest first
+    std::vector<std::string> etags_;        // By part number - 1
+    int next_part_ = 1;
+    uint64_t written_ = 0;                  // Bytes handed to parts already
+    bool failed_ = false;
+    bool done_ = false;
+    std::string error_;
+};
+
+ObjectOutput::ObjectOutput(ObjectStore& store, std::string key, const ObjectOutputOptions& options)
+    : std::ostream(nullptr), buffer_(std::make_unique<Buffer>(store, std::move(key), options)) {
+    rdbuf(buffer_.get());
+    if (!buffer_->is_open()) {
+        setstate(std::ios_base::failbit);
+    }
+}
+
+ObjectOutput::~ObjectOutput() = default;
+
+bool ObjectOutput::is_open() const {
+    return buffer_->is_open();
+}
+
+bool ObjectOutput::finish() {
+    if (!buffer_->finish()) {
+        setstate(std::ios_base::badbit);
+        return false;
+    }
+    return true;
+}
+
+const std::string& ObjectOutput::error() const {
+    return buffer_->error();
+}
+
+// ObjectInput implementation
+class ObjectInput::Buffer : public std::streambuf {
+public:
+    Buffer(ObjectStore& store, std::string key, const ObjectInputOptions& options)
+        : store_(store), key_(std::move(key)), options_(options) {
+        options_.block_size = std::max<size_t>(options_.block_size, 1);
+        auto size = store_.size(key_);
+        if (!size) {
+            error_ = "Cannot open " + key_ + ": " + size.error_message;
+            return;
+        }
+        size_ = size.value;
+        open_ = true;
+    }
+
+    ~Buffer() override {
+        drop_prefetch();
+    }
+
+    bool is_open() const { return open_; }
+    uint64_t size() const { return size_; }
+    uint64_t bytes_fetched() const { return fetched_.load(); }
+    const std::string& error() const { return error_; }
+
+protected:
+    int_type underflow() override {
+        if (gptr() < egptr()) {
+            return traits_type::to_int_type(*gptr());
+        }
+        uint64_t pos = position();
+        if (!open_ || pos >= size_) {
+            return traits_type::eof();
+        }
+        // Back-to-back blocks mean a sequential reader: fetch ahead
+        bool sequential = !block_.empty() && pos == block_offset_ + block_.size();
+
+        std::vector<uint8_t> data;
+        if (!prefetch_.empty() && prefetch_.front().offset == pos) {
+            auto fetched = prefetch_.front().data.get();
+            prefetch_.pop_front();
+            data = take(std::move(fetched));
+        } else {
+            drop_prefetch();
+            data = take(store_.read(key_, pos, block_length(pos)));
+        }
+        if (data.empty()) {
+            return traits_type::eof();
+        }
+        block_.assign(data.begin(), data.end());
+        block_offset_ = pos;
+        setg(block_.data(), block_.data(), block_.data() + block_.size());
+
+        if (sequential) {
+            uint64_t next = prefetch_.empty() ? pos + block_.size()
+                                              : prefetch_.back().offset + block_length(prefetch_.back().offset);
+            while (prefetch_.size() < options_.read_ahead && next < size_) {
+                size_t length = block_length(next);
+                prefetch_.push_back({next, std::async(std::launch::async, [this, next, length]() {
+                    return store_.read(key_, next, length);
+                })});
+                next += length;
+            }
+        }
+        return traits_type::to_int_type(*gptr());
+    }
+
+    // Reads of a block or more skip the block buffer and fetch exactly
+    // the bytes asked for
+    std::streamsize xsgetn(char* out, std::streamsize count) override {
+        std::streamsize done = 0;
+        while (done < count) {
+            std::streamsize available = egptr() - gptr();
+            if (available > 0) {
+                std::streamsize piece = std::min(available, count - done);
+                std::memcpy(out + done, gptr(), static_cast<size_t>(piece));
+                gbump(static_cast<int>(piece));
+                done += piece;
+                continue;
+            }
+            uint64_t pos = position();
+            if (!open_ || pos >= size_) {
+                break;
+            }
+            uint64_t wanted = static_cast<uint64_t>(count - done);
+            if (wanted >= options_.block_size) {
+                drop_prefetch();
+                auto data = take(store_.read(key_, pos, static_cast<size_t>(std::min(wanted, size_ - pos))));
+                if (data.empty()) {
+                    break;
+                }
+                std::memcpy(out + done, data.data(), data.size());
+                done += static_cast<std::streamsize>(data.size());
+                jump(pos + data.size());
+                continue;
+            }
+            if (traits_type::eq_int_type(underflow(), traits_type::eof())) {
+                break;
+            }
+        }
+        return done;
+    }
+
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+        if (!open_ || !(which & std::ios_base::in)) {
+            return pos_type(off_type(-1));
+        }
+        off_type base = dir == std::ios_base::beg ? 0
+                      : dir == std::ios_base::cur ? static_cast<off_type>(position())
+                      : static_cast<off_type>(size_);
+        off_type target = base + off;
+        if (target < 0 || static_cast<uint64_t>(target) > size_) {
+            return pos_type(off_type(-1));
+        }
+        uint64_t pos = static_cast<uint64_t>(target);
+        if (pos >= block_offset_ && pos < block_offset_ + block_.size()) {
+            setg(block_.data(), block_.data() + (pos - block_offset_), block_.data() + block_.size());
+        } else {
+            jump(pos);
+        }
+        return pos_type(target);
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+
+private:
+    struct Prefetch {
+        uint64_t offset;
+        std::future<core::Result<std::vector<uint8_t>>> data;
+    };
+
+    uint64_t position() const {
+        return block_offset_ + static_cast<uint64_t>(gptr() - eback());
+    }
+
+    size_t block_length(uint64_t offset) const {
+        return static_cast<size_t>(std::min<uint64_t>(options_.block_size, size_ - offset));
+    }
+
+    // Continue at pos with an empty get area
+    void jump(uint64_t pos) {
+        block_.clear();
+        block_offset_ = pos;
+        setg(nullptr, nullptr, nullptr);
+    }
+
+    // Unwrap a read; failures are thrown so the stream sets badbit
+    std::vector<uint8_t> take(core::Result<std::vector<uint8_t>> result) {
+        if (!result) {
+            error_ = "Read of " + key_ + " failed: " + result.error_message;
+            throw std::ios_base::failure(error_);
+        }
+        fetched_ += result.value.size();
+        return std::move(result.value);
+    }
+
+    void drop_prefetch() {
+        while (!prefetch_.empty()) {
+            prefetch_.front().data.wait();
+            prefetch_.pop_front();
+        }
+    }
+
+    ObjectStore& store_;
+    std::string key_;
+    ObjectInputOptions options_;
+    bool open_ = false;
+    uint64_t size_ = 0;
+    std::vector<char> block_;               // Get area
+    uint64_t block_offset_ = 0;             // Object offset of eback()
+    std::deque<Prefetch> prefetch_;         // Consecutive blocks after the current one
+    std::atomic<uint64_t> fetched_{0};
+    std::string error_;
+};
+
+ObjectInput::ObjectInput(ObjectStore& store, std::string key, const ObjectInputOptions& options)
+    : std::istream(nullptr), buffer_(std::make_unique<Buffer>(store, std::move(key), options)) {
+    rdbuf(buffer_.get());
+    if (!buffer_->is_open()) {
+        setstate(std::ios_base::failbit);
+    }
+}
+
+ObjectInput::~ObjectInput() = default;
+
+bool ObjectInput::is_open() const {
+    return buffer_->is_open();
+}
+
+uint64_t ObjectInput::size() const {
+    return buffer_->size();
+}
+
+uint64_t ObjectInput::bytes_fetched() const {
+    return buffer_->bytes_fetched();
+}
+
+const std::string& ObjectInput::error() const {
+    return buffer_->error();
+}
+
+} // namespace utils
+} // namespace filevault
@@ -0,0 +1,558 @@
+/**
+ * @file part_files.cpp
+ * @brief Streams split into numbered part files
+ */
+
+#include "filevault/utils/part_files.hpp"
+#include <nlohmann/json.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <optional>
+#include <random>
+#include <string_view>
+
+namespace filevault {
+namespace utils {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr std::string_view PART_MAGIC = "FVPT";
+constexpr uint8_t PART_VERSION = 1;
+constexpr uint8_t PART_FLAG_LAST = 0x01;
+constexpr std::string_view MANIFEST_FORMAT = "filevault-parts";
+constexpr size_t READ_BLOCK = 1024 * 1024;
+
+struct PartHeader {
+    uint8_t flags = 0;
+    uint32_t number = 0;
+    std::array<uint8_t, 16> stream_id{};
+    uint64_t offset = 0;
+    uint64_t length = 0;
+
+    bool last() const { return (flags & PART_FLAG_LAST) != 0; }
+};
+
+void store_le(uint8_t* out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+uint64_t load_le(const uint8_t* in, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+std::array<char, PART_HEADER_SIZE> encode_header(const PartHeader& header) {
+    std::array<char, PART_HEADER_SIZE> raw{};
+    auto* out = reinterpret_cast<uint8_t*>(raw.data());
+    std::memcpy(out, PART_MAGIC.data(), PART_MAGIC.size());
+    out[4] = PART_VERSION;
+    out[5] = header.flags;
+    store_le(out + 8, header.number, 4);
+    std::memcpy(out + 12, header.stream_id.data(), header.stream_id.size());
+    store_le(out + 28, header.offset, 8);
+    store_le(out + 36, header.length, 8);
+    return raw;
+}
+
+std::optional<PartHeader> read_header(std::istream& in) {
+    std::array<uint8_t, PART_HEADER_SIZE> raw{};
+    in.read(reinterpret_cast<char*>(raw.data()), static_cast<std::streamsize>(raw.size()));
+    if (!in || std::memcmp(raw.data(), PART_MAGIC.data(), PART_MAGIC.size()) != 0 ||
+        raw[4] != PART_VERSION) {
+        return std::nullopt;
+    }
+    PartHeader header;
+    header.flags = raw[5];
+    header.number = static_cast<uint32_t>(load_le(raw.data() + 8, 4));
+    std::memcpy(header.stream_id.data(), raw.data() + 12, header.stream_id.size());
+    header.offset = load_le(raw.data() + 28, 8);
+    header.length = load_le(raw.data() + 36, 8);
+    return header;
+}
+
+std::optional<PartHeader> read_header(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return read_header(in);
+}
+
+std::string hex(const std::array<uint8_t, 16>& bytes) {
+    std::string text;
+    for (uint8_t byte : bytes) {
+        text += fmt::format("{:02x}", byte);
+    }
+    return text;
+}
+
+bool parse_hex(const std::string& text, std::array<uint8_t, 16>& bytes) {
+    if (text.size() != bytes.size() * 2) {
+        return false;
+    }
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        unsigned value = 0;
+        for (char c : text.substr(i * 2, 2)) {
+            int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+            if (digit < 0) {
+                return false;
+            }
+            value = value * 16 + static_cast<unsigned>(digit);
+        }
+        bytes[i] = static_cast<uint8_t>(value);
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+// PartSet implementation
+
+std::string PartSet::part_path(const std::string& base, size_t number) {
+    return fmt::format("{}.part{:03}", base, number);
+}
+
+std::string PartSet::manifest_path(const std::string& base) {
+    return base + ".parts";
+}
+
+bool PartSet::is_part_set(const std::string& path) {
+    std::error_code ec;
+    if (!fs::is_regular_file(path, ec)) {
+        return false;
+    }
+    return path.ends_with(".parts") || read_header(path).has_value();
+}
+
+core::Result<PartSet> PartSet::load(const std::string& path) {
+    PartSet set;
+
+    if (auto first = read_header(path)) {
+        // No manifest: follow the part numbers from the first part
+        auto suffix = path.rfind(".part");
+        if (first->number != 1 || suffix == std::string::npos) {
+            return core::Result<PartSet>::error("Start from the first part (.part001): " + path);
+        }
+        std::string base = path.substr(0, suffix);
+        set.stream_id = first->stream_id;
+        set.part_size = first->length;
+        for (size_t number = 1;; ++number) {
+            std::string part = part_path(base, number);
+            auto header = number == 1 ? first : read_header(part);
+            if (!header || header->stream_id != set.stream_id) {
+                return core::Result<PartSet>::error(fmt::format("Part {} is missing: {}", number, part));
+            }
+            set.parts.push_back({part, header->offset, header->length});
+            if (header->last()) {
+                set.total_size = header->offset + header->length;
+                return core::Result<PartSet>::ok(std::move(set));
+            }
+        }
+    }
+
+    std::ifstream in(path);
+    if (!in) {
+        return core::Result<PartSet>::error("Failed to open part manifest: " + path);
+    }
+    try {
+        auto j = nlohmann::json::parse(in);
+        if (j.value("format", "") != MANIFEST_FORMAT || j.value("version", 0) != PART_VERSION ||
+            !parse_hex(j.value("stream_id", ""), set.stream_id)) {
+            return core::Result<PartSet>::error("Not a FileVault part manifest: " + path);
+        }
+        set.part_size = j.at("part_size").get<uint64_t>();
+        set.total_size = j.at("total_size").get<uint64_t>();
+        auto dir = fs::path(path).parent_path();
+        uint64_t expected = 0;
+        for (const auto& entry : j.at("parts")) {
+            PartInfo info;
+            info.path = (dir / entry.at("file").get<std::string>()).string();
+            info.offset = entry.at("offset").get<uint64_t>();
+            info.length = entry.at("length").get<uint64_t>();
+            if (info.offset != expected) {
+                return core::Result<PartSet>::error("Part manifest has a gap at " + info.path);
+            }
+            expected += info.length;
+            set.parts.push_back(std::move(info));
+        }
+        if (set.parts.empty() || expected != set.total_size) {
+            return core::Result<PartSet>::error("Part manifest does not cover the stream: " + path);
+        }
+    } catch (const nlohmann::json::exception& e) {
+        return core::Result<PartSet>::error(fmt::format("Bad part manifest {}: {}", path, e.what()));
+    }
+    return core::Result<PartSet>::ok(std::move(set));
+}
+
+core::Result<void> PartSet::save_manifest(const std::string& path) const {
+    nlohmann::json parts_json = nlohmann::json::array();
+    for (const auto& part : parts) {
+        parts_json.push_back({
+            {"file", fs::path(part.path).filename().string()},
+            {"offset", part.offset},
+            {"length", part.length},
+        });
+    }
+    nlohmann::json j = {
+        {"format", MANIFEST_FORMAT},
+        {"version", PART_VERSION},
+        {"stream_id", hex(stream_id)},
+        {"part_size", part_size},
+        {"total_size", total_size},
+        {"parts", std::move(parts_json)},
+    };
+
+    OutputFileOptions options;
+    options.atomic = true;
+    OutputFile out(path, options);
+    out << j.dump(2) << '\n';
+    if (!out.commit()) {
+        return core::Result<void>::error("Failed to write part manifest: " + path);
+    }
+    return core::Result<void>::ok();
+}
+
+// PartOutput implementation
+
+class PartOutput::Buffer : public std::streambuf {
+public:
+    Buffer(const std::string& base, uint64_t part_size, const OutputFileOptions& options)
+        : base_(base), options_(options) {
+        options_.atomic = true;
+        options_.preallocate = PART_HEADER_SIZE + part_size;
+        set_.part_size = (std::max)(part_size, uint64_t(1));
+        std::random_device random;
+        for (auto& byte : set_.stream_id) {
+            byte = static_cast<uint8_t>(random());
+        }
+    }
+
+    bool finish() {
+        if (!done_ && error_.empty()) {
+            done_ = true;
+            if (!part_ && !start_part()) {
+                return false;
+            }
+            end_part(true);
+            if (error_.empty()) {
+                set_.total_size = written_;
+                auto saved = set_.save_manifest(PartSet::manifest_path(base_));
+                if (!saved) {
+                    error_ = saved.error_message;
+                }
+            }
+        }
+        return error_.empty();
+    }
+
+    const PartSet& parts() const { return set_; }
+    const std::string& error() const { return error_; }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (traits_type::eq_int_type(ch, traits_type::eof())) {
+            return traits_type::not_eof(ch);
+        }
+        char c = traits_type::to_char_type(ch);
+        return xsputn(&c, 1) == 1 ? ch : traits_type::eof();
+    }
+
+    std::streamsize xsputn(const char* data, std::streamsize count) override {
+        std::streamsize done = 0;
+        while (done < count && error_.empty() && !done_) {
+            if (part_ && in_part_ == set_.part_size) {
+                end_part(false);
+            }
+            if (!part_ && !start_part()) {
+                break;
+            }
+            auto take = static_cast<std::streamsize>(
+                (std::min)(static_cast<uint64_t>(count - done), set_.part_size - in_part_));
+            if (!part_->write(data + done, take)) {
+                error_ = "Failed to write " + set_.parts.back().path;
+                break;
+            }
+            done += take;
+            in_part_ += static_cast<uint64_t>(take);
+            written_ += static_cast<uint64_t>(take);
+        }
+        return done;
+    }
+
+    int sync() override {
+        return part_ && !part_->flush() ? -1 : 0;
+    }
+
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+        if (off != 0 || dir != std::ios_base::cur || !(which & std::ios_base::out)) {
+            return pos_type(off_type(-1));
+        }
+        return pos_type(static_cast<off_type>(written_));
+    }
+
+private:
+    PartHeader header(bool last) const {
+        PartHeader h;
+        h.flags = last ? PART_FLAG_LAST : 0;
+        h.number = static_cast<uint32_t>(set_.parts.size());
+        h.stream_id = set_.stream_id;
+        h.offset = set_.parts.back().offset;
+        h.length = last ? in_part_ : set_.part_size;
+        return h;
+    }
+
+    // Full parts get their final header up front; only the last is rewritten
+    bool start_part() {
+        PartInfo info;
+        info.path = PartSet::part_path(base_, set_.parts.size() + 1);
+        info.offset = written_;
+        set_.parts.push_back(info);
+        in_part_ = 0;
+        part_ = std::make_unique<OutputFile>(info.path, options_);
+        auto raw = encode_header(header(false));
+        if (!*part_ || !part_->write(raw.data(), static_cast<std::streamsize>(raw.size()))) {
+            error_ = "Failed to create " + info.path;
+            part_.reset();
+            return false;
+        }
+        return true;
+    }
+
+    void end_part(bool last) {
+        set_.parts.back().length = in_part_;
+        if (last) {
+            auto raw = encode_header(header(true));
+            part_->seekp(0);
+            part_->write(raw.data(), static_cast<std::streamsize>(raw.size()));
+        }
+        if (!*part_ || !part_->commit(nullptr)) {
+            error_ = "Failed to write " + set_.parts.back().path;
+        }
+        part_.reset();
+    }
+
+    std::string base_;
+    OutputFileOptions options_;
+    PartSet set_;
+    std::unique_ptr<OutputFile> part_;
+    uint64_t in_part_ = 0;              // Stream bytes in the open part
+    uint64_t written_ = 0;
+    std::string error_;
+    bool done_ = false;
+};
+
+PartOutput::PartOutput(const std::string& base, uint64_t part_size, const OutputFileOptions& options)
+    : std::ostream(nullptr), buffer_(std::make_unique<Buffer>(base, part_size, options)) {
+    rdbuf(buffer_.get());
+}
+
+PartOutput::~PartOutput() = default;
+
+bool PartOutput::finish() {
+    flush();
+    bool ok = buffer_->finish();
+    if (!ok) {
+        setstate(std::ios_base::badbit);
+    }
+    return ok;
+}
+
+const PartSet& PartOutput::parts() const {
+    return buffer_->parts();
+}
+
+const std::string& PartOutput::error() const {
+    return buffer_->error();
+}
+
+// PartInput implementation
+
+class PartInput::Buffer : public std::streambuf {
+public:
+    Buffer(PartSet set, const InputFileOptions& options)
+        : set_(std::move(set)), options_(options) {
+        open_at(0);
+    }
+
+    ~Buffer() override {
+        if (next_.valid()) {
+            next_.wait();
+        }
+    }
+
+    const std::string& error() const { return error_; }
+
+protected:
+    int_type underflow() override {
+        if (gptr() < egptr()) {
+            return traits_type::to_int_type(*gptr());
+        }
+        if (!error_.empty()) {
+            return traits_type::eof();
+        }
+        position_ += static_cast<uint64_t>(egptr() - eback());
+        setg(nullptr, nullptr, nullptr);
+
+        if (current_.file && current_.remaining > 0) {
+            size_t want = static_cast<size_t>((std::min)(current_.remaining, uint64_t(READ_BLOCK)));
+            current_.block.resize(want);
+            current_.file->read(current_.block.data(), static_cast<std::streamsize>(want));
+            if (static_cast<size_t>(current_.file->gcount()) != want) {
+                error_ = "Part is truncated: " + set_.parts[index_].path;
+                return traits_type::eof();
+            }
+            current_.remaining -= want;
+        } else {
+            if (index_ + 1 >= set_.parts.size()) {
+                return traits_type::eof();
+            }
+            ++index_;
+            current_ = next_.valid() ? next_.get() : open_part(set_, index_, 0, options_);
+            prefetch();
+        }
+        if (!current_.error.empty()) {
+            error_ = current_.error;
+            return traits_type::eof();
+        }
+        if (current_.block.empty()) {
+            return underflow();
+        }
+        setg(current_.block.data(), current_.block.data(), current_.block.data() + current_.block.size());
+        return traits_type::to_int_type(*gptr());
+    }
+
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+        auto here = static_cast<off_type>(position_ + static_cast<uint64_t>(gptr() - eback()));
+        off_type base = dir == std::ios_base::beg ? 0
+                      : dir == std::ios_base::cur ? here
+                      : static_cast<off_type>(set_.total_size);
+        if (dir == std::ios_base::cur && off == 0) {
+            return pos_type(here);  // tellg()
+        }
+        return seekpos(pos_type(base + off), which);
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+        auto target = static_cast<off_type>(pos);
+        if (!(which & std::ios_base::in) || target < 0 ||
+            static_cast<uint64_t>(target) > set_.total_size || !error_.empty()) {
+            return pos_type(off_type(-1));
+        }
+        auto offset = static_cast<uint64_t>(target);
+        auto buffered = static_cast<uint64_t>(egptr() - eback());
+        if (eback() && offset >= position_ && offset < position_ + buffered) {
+            setg(eback(), eback() + (offset - position_), egptr());
+        } else {
+            open_at(offset);
+        }
+        return pos;
+    }
+
+private:
+    struct OpenPart {
+        std::unique_ptr<InputFile> file;
+        std::vector<char> block;        // First bytes read from skip on
+        uint64_t remaining = 0;         // Part bytes after the block
+        std::string error;
+    };
+
+    // Open a part, check its header against the set and read its first block
+    static OpenPart open_part(const PartSet& set, size_t index, uint64_t skip,
+                              const InputFileOptions& options) {
+        OpenPart part;
+        const auto& info = set.parts[index];
+        part.file = std::make_unique<InputFile>(info.path, options);
+        if (!part.file->is_open()) {
+            part.error = fmt::format("Part {} is missing: {}", index + 1, info.path);
+            return part;
+        }
+        auto header = read_header(*part.file);
+        bool last = index + 1 == set.parts.size();
+        if (!header || header->stream_id != set.stream_id) {
+            part.error = "Part belongs to another stream: " + info.path;
+        } else if (header->number != index + 1 || header->offset != info.offset ||
+                   header->length != info.length || header->last() != last) {
+            part.error = "Part does not match the manifest: " + info.path;
+        } else if (part.file->size() != PART_HEADER_SIZE + info.length) {
+            part.error = "Part is truncated: " + info.path;
+        }
+        if (!part.error.empty()) {
+            return part;
+        }
+        if (skip > 0) {
+            part.file->seekg(static_cast<std::streamoff>(PART_HEADER_SIZE + skip));
+        }
+        size_t want = static_cast<size_t>((std::min)(info.length - skip, uint64_t(READ_BLOCK)));
+        part.block.resize(want);
+        part.file->read(part.block.data(), static_cast<std::streamsize>(want));
+        if (static_cast<size_t>(part.file->gcount()) != want) {
+            part.error = "Part is truncated: " + info.path;
+        }
+        part.remaining = info.length - skip - want;
+        return part;
+    }
+
+    // The next part is opened while this one is read
+    void prefetch() {
+        if (index_ + 1 < set_.parts.size()) {
+            next_ = std::async(std::launch::async, open_part, std::cref(set_), index_ + 1,
+                               uint64_t(0), options_);
+        }
+    }
+
+    void open_at(uint64_t offset) {
+        if (next_.valid()) {
+            next_.wait();
+            next_ = {};
+        }
+        setg(nullptr, nullptr, nullptr);
+        position_ = offset;
+        if (set_.parts.empty()) {
+            return;
+        }
+        // Last part starting at or before offset (the end lands in the last part)
+        index_ = 0;
+        while (index_ + 1 < set_.parts.size() && set_.parts[index_ + 1].offset <= offset) {
+            ++index_;
+        }
+        current_ = open_part(set_, index_, offset - set_.parts[index_].offset, options_);
+        if (!current_.error.empty()) {
+            error_ = current_.error;
+            return;
+        }
+        prefetch();
+        if (!current_.block.empty()) {
+            setg(current_.block.data(), current_.block.data(), current_.block.data() + current_.block.size());
+        }
+    }
+
+    PartSet set_;
+    InputFileOptions options_;
+    size_t index_ = 0;
+    OpenPart current_;
+    std::future<OpenPart> next_;
+    uint64_t position_ = 0;             // Stream offset of eback()
+    std::string error_;
+};
+
+PartInput::PartInput(PartSet set, const InputFileOptions& options)
+    : std::istream(nullptr), buffer_(std::make_unique<Buffer>(std::move(set), options)) {
+    rdbuf(buffer_.get());
+}
+
+PartInput::~PartInput() = default;
+
+const std::string& PartInput::error() const {
+    return buffer_->error();
+}
+
+} // namespace utils
+} // namespace filevault
@@ -1,12 +1,15 @@
 #include "filevault/utils/password.hpp"
+#include "filevault/core/thread_pool.hpp"
 #include "filevault/utils/console.hpp"
+#include "filevault/utils/password_filter.hpp"
 #include <fmt/core.h>
 #include <fmt/color.h>
 #include <iostream>
 #include <cmath>
 #include <algorithm>
 #include <cctype>
-#include <unordered_map>
+#include <future>
+#include <unordered_set>
 
 #ifdef _WIN32
     #include <windows.h>
@@ -132,74 +135,127 @@ std::string Password::read_secure(const std::string& prompt, bool confirm) {
     return password;
 }
 
-core::PasswordAnalysis Password::analyze_strength(const std::string& password) {
-    core::PasswordAnalysis analysis;
-    analysis.length = password.length();
-    
-    // Character class detection
-    analysis.has_lowercase = false;
-    analysis.has_uppercase = false;
-    analysis.has_digits = false;
-    analysis.has_special = false;
-    analysis.has_repeated_chars = false;
-    
-    std::unordered_map<char, int> char_count;
+PasswordScore Password::score(std::string_view password) {
+    PasswordScore result;
+    result.length = static_cast<uint32_t>(password.size());
+    
+    // Character classes and repeats in one pass; the lowercase copy stays
+    // on the stack for all realistic lengths
+    uint8_t char_count[256] = {};
+    char lower_buffer[128];
+    std::string lower_heap;
+    char* lower = lower_buffer;
+    if (password.size() > sizeof(lower_buffer)) {
+        lower_heap.resize(password.size());
+        lower = lower_heap.data();
+    }
     
-    for (char c : password) {
-        if (std::islower(c)) analysis.has_lowercase = true;
-        if (std::isupper(c)) analysis.has_uppercase = true;
-        if (std::isdigit(c)) analysis.has_digits = true;
-        if (!std::isalnum(c)) analysis.has_special = true;
+    for (size_t i = 0; i < password.size(); ++i) {
+        auto c = static_cast<unsigned char>(password[i]);
+        if (std::islower(c)) result.has_lowercase = true;
+        if (std::isupper(c)) result.has_uppercase = true;
+        if (std::isdigit(c)) result.has_digits = true;
+        if (!std::isalnum(c)) result.has_special = true;
         
-        char_count[c]++;
-        if (char_count[c] > 2) {
-            analysis.has_repeated_chars = true;
+        if (char_count[c] < 255 && ++char_count[c] > 2) {
+            result.has_repeated_chars = true;
         }
+        lower[i] = static_cast<char>(std::tolower(c));
     }
     
     // Check common passwords
-    std::string lower_password = password;
-    std::transform(lower_password.begin(), lower_password.end(), 
-                   lower_password.begin(), ::tolower);
+    std::string_view lower_password(lower, password.size());
+    result.is_common_password = is_common_password(lower_password) ||
+                                (lower_password != password && is_common_password(password));
     
-    analysis.is_common_password = is_common_password(lower_password);
+    // Entropy: length * log2(charset size)
+    int charset_size = 0;
+    if (result.has_lowercase) charset_size += 26;
+    if (result.has_uppercase) charset_size += 26;
+    if (result.has_digits) charset_size += 10;
+    if (result.has_special) charset_size += 32;  // Common special chars
+    if (charset_size == 0) charset_size = 1;     // Avoid log(0)
+    result.entropy_bits = password.size() * std::log2(charset_size);
     
     // Calculate score (0-100)
     int score = 0;
     
     // Length bonus
-    if (analysis.length >= 8) score += 20;
-    if (analysis.length >= 12) score += 10;
-    if (analysis.length >= 16) score += 10;
-    if (analysis.length >= 20) score += 10;
+    if (result.length >= 8) score += 20;
+    if (result.length >= 12) score += 10;
+    if (result.length >= 16) score += 10;
+    if (result.length >= 20) score += 10;
     
     // Character variety
-    if (analysis.has_lowercase) score += 10;
-    if (analysis.has_uppercase) score += 10;
-    if (analysis.has_digits) score += 10;
-    if (analysis.has_special) score += 15;
+    if (result.has_lowercase) score += 10;
+    if (result.has_uppercase) score += 10;
+    if (result.has_digits) score += 10;
+    if (result.has_special) score += 15;
     
     // Penalties
-    if (analysis.length < 8) score -= 30;
-    if (analysis.has_repeated_chars) score -= 10;
-    if (analysis.is_common_password) score -= 50;
-    if (!analysis.has_special && !analysis.has_digits) score -= 20;
+    if (result.length < 8) score -= 30;
+    if (result.has_repeated_chars) score -= 10;
+    if (result.is_common_password) score -= 50;
+    if (!result.has_special && !result.has_digits) score -= 20;
     
-    analysis.score = std::clamp(score, 0, 100);
+    result.score = std::clamp(score, 0, 100);
     
     // Determine strength
-    if (analysis.score < 20) {
-        analysis.strength = core::PasswordStrength::VERY_WEAK;
-    } else if (analysis.score < 40) {
-        analysis.strength = core::PasswordStrength::WEAK;
-    } else if (analysis.score < 60) {
-        analysis.strength = core::PasswordStrength::FAIR;
-    } else if (analysis.score < 80) {
-        analysis.strength = core::PasswordStrength::STRONG;
+    if (result.score < 20) {
+        result.strength = core::PasswordStrength::VERY_WEAK;
+    } else if (result.score < 40) {
+        result.strength = core::PasswordStrength::WEAK;
+    } else if (result.score < 60) {
+        result.strength = core::PasswordStrength::FAIR;
+    } else if (result.score < 80) {
+        result.strength = core::PasswordStrength::STRONG;
     } else {
-        analysis.strength = core::PasswordStrength::VERY_STRONG;
+        result.strength = core::PasswordStrength::VERY_STRONG;
     }
     
+    return result;
+}
+
+void Password::score_batch(std::span<const std::string> passwords, std::span<PasswordScore> results,
+                           core::ThreadPool& pool) {
+    // A few slices per worker evens out uneven lengths
+    size_t slices = std::min(passwords.size(), pool.size() * 4);
+    if (slices <= 1) {
+        for (size_t i = 0; i < passwords.size(); ++i) {
+            results[i] = score(passwords[i]);
+        }
+        return;
+    }
+    
+    size_t per_slice = (passwords.size() + slices - 1) / slices;
+    std::vector<std::future<void>> pending;
+    for (size_t begin = 0; begin < passwords.size(); begin += per_slice) {
+        size_t end = std::min(passwords.size(), begin + per_slice);
+        pending.push_back(pool.submit([passwords, results, begin, end] {
+            for (size_t i = begin; i < end; ++i) {
+                results[i] = score(passwords[i]);
+            }
+        }));
+    }
+    for (auto& task : pending) {
+        task.get();
+    }
+}
+
+core::PasswordAnalysis Password::analyze_strength(const std::string& password) {
+    auto scored = score(password);
+    
+    core::PasswordAnalysis analysis;
+    analysis.length = password.length();
+    analysis.has_lowercase = scored.has_lowercase;
+    analysis.has_uppercase = scored.has_uppercase;
+    analysis.has_digits = scored.has_digits;
+    analysis.has_special = scored.has_special;
+    analysis.has_repeated_chars = scored.has_repeated_chars;
+    analysis.is_common_password = scored.is_common_password;
+    analysis.score = scored.score;
+    analysis.strength = scored.strength;
+    
     // Generate warnings and suggestions
     if (analysis.length < 8) {
         analysis.warnings.push_back("Too short (minimum 8 characters)");
@@ -231,41 +287,24 @@ core::PasswordAnalysis Password::analyze_strength(const std::string& password) {
         analysis.suggestions.push_back("Avoid repeated patterns");
     }
     
-    // Calculate entropy and crack time
-    double entropy = calculate_entropy(password);
-    auto [online_time, offline_time] = estimate_crack_time(entropy, analysis);
+    // Crack time from the entropy computed above
+    auto [online_time, offline_time] = estimate_crack_time(scored.entropy_bits, analysis);
     analysis.crack_time_online = online_time;
     analysis.crack_time_offline = offline_time;
     
     return analysis;
 }
 
-bool Password::is_common_password(const std::string& password) {
-    return std::find(common_passwords_.begin(), common_passwords_.end(), password) 
-           != common_passwords_.end();
-}
-
-double Password::calculate_entropy(const std::string& password) {
-    int charset_size = 0;
-    
-    bool has_lower = false, has_upper = false;
-    bool has_digit = false, has_special = false;
-    
-    for (char c : password) {
-        if (std::islower(c)) has_lower = true;
-        if (std::isupper(c)) has_upper = true;
-        if (std::isdigit(c)) has_digit = true;
-        if (!std::isalnum(c)) has_special = true;
+bool Password::is_common_password(std::string_view password) {
+    static const std::unordered_set<std::string_view> common(common_passwords_.begin(),
+                                                             common_passwords_.end());
+    if (common.count(password) > 0) {
+        return true;
     }
     
-    if (has_lower) charset_size += 26;
-    if (has_upper) charset_size += 26;
-    if (has_digit) charset_size += 10;
-    if (has_special) charset_size += 32;  // Common special chars
-    
-    if (charset_size == 0) charset_size = 1;  // Avoid log(0)
-    
-    return password.length() * std::log2(charset_size);
+    // Breach corpora keep the original case
+    const auto* filter = PasswordFilter::shared();
+    return filter && filter->contains(password);
 }
 
 std::pair<std::string, std::string> Password::estimate_crack_time(
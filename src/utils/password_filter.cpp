@@ -0,0 +1,239 @@
+/**
+ * @file password_filter.cpp
+ * @brief Blocked Bloom filter over breached passwords
+ */
+
+#include "filevault/utils/password_filter.hpp"
+#include "filevault/utils/config.hpp"
+#include <botan/hash.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+namespace filevault {
+namespace utils {
+
+namespace {
+
+// File layout: "FVPB" | u32 version | u32 hash count | u32 reserved
+//              | u64 block count | u64 entry count | zero padding to 64 bytes
+//              | block count * 64-byte blocks
+// Digest bytes 0-7 pick the block; bytes 8-15 seed the probes inside it.
+constexpr char MAGIC[4] = {'F', 'V', 'P', 'B'};
+constexpr uint32_t VERSION = 1;
+constexpr uint32_t MAX_HASH_COUNT = 16;
+constexpr size_t BLOCK_BITS = PasswordFilter::BLOCK_BYTES * 8;
+constexpr double BLOCKED_OVERHEAD = 1.25;     // Extra bits that offset uneven block loads
+
+void put_u32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+void put_u64(uint8_t* out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+uint32_t get_u32(const uint8_t* in) {
+    return uint32_t(in[0]) | uint32_t(in[1]) << 8 | uint32_t(in[2]) << 16 | uint32_t(in[3]) << 24;
+}
+
+uint64_t get_u64(const uint8_t* in) {
+    return uint64_t(get_u32(in)) | uint64_t(get_u32(in + 4)) << 32;
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// "<40 hex>" or "<40 hex>:<count>"
+bool parse_hibp_line(const std::string& line, PasswordFilter::Digest& digest) {
+    if (line.size() < 40 || (line.size() > 40 && line[40] != ':')) {
+        return false;
+    }
+    for (size_t i = 0; i < digest.size(); ++i) {
+        int high = hex_value(line[2 * i]);
+        int low = hex_value(line[2 * i + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        digest[i] = static_cast<uint8_t>(high << 4 | low);
+    }
+    return true;
+}
+
+// Calls fn for every non-empty line, without the line ending
+template<typename F>
+bool for_each_line(const std::string& path, F&& fn) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty()) {
+            fn(line);
+        }
+    }
+    return !in.bad();
+}
+
+} // anonymous namespace
+
+core::Result<PasswordFilter> PasswordFilter::open(const std::string& path) {
+    auto mapped = FileIO::map_file(path);
+    if (!mapped) {
+        return core::Result<PasswordFilter>::error(mapped.error_message);
+    }
+
+    PasswordFilter filter;
+    filter.file_ = std::move(mapped.value);
+    const uint8_t* data = filter.file_.data();
+    size_t size = filter.file_.size();
+
+    if (size < HEADER_BYTES || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+        return core::Result<PasswordFilter>::error("Not a password filter: " + path);
+    }
+    if (get_u32(data + 4) != VERSION) {
+        return core::Result<PasswordFilter>::error("Unsupported password filter version: " + path);
+    }
+
+    filter.hash_count_ = get_u32(data + 8);
+    filter.block_count_ = get_u64(data + 16);
+    filter.entry_count_ = get_u64(data + 24);
+    if (filter.hash_count_ == 0 || filter.hash_count_ > MAX_HASH_COUNT || filter.block_count_ == 0 ||
+        filter.block_count_ != (size - HEADER_BYTES) / BLOCK_BYTES ||
+        (size - HEADER_BYTES) % BLOCK_BYTES != 0) {
+        return core::Result<PasswordFilter>::error("Corrupt password filter: " + path);
+    }
+
+#ifndef _WIN32
+    // Lookups hit one block anywhere in the file: read-ahead would only
+    // pull in pages that are never probed
+    if (filter.file_.is_mapped()) {
+        madvise(const_cast<uint8_t*>(data), size, MADV_RANDOM);
+    }
+#endif
+
+    return core::Result<PasswordFilter>::ok(std::move(filter));
+}
+
+core::Result<uint64_t> PasswordFilter::build(const std::string& corpus_path, const std::string& output_path,
+                                             double false_positive_rate) {
+    if (!(false_positive_rate > 0.0 && false_positive_rate < 1.0)) {
+        return core::Result<uint64_t>::error("False positive rate must be between 0 and 1");
+    }
+
+    // First pass sizes the filter, second fills it
+    uint64_t lines = 0;
+    if (!for_each_line(corpus_path, [&](const std::string&) { ++lines; })) {
+        return core::Result<uint64_t>::error("Cannot read corpus: " + corpus_path);
+    }
+    if (lines == 0) {
+        return core::Result<uint64_t>::error("Corpus is empty: " + corpus_path);
+    }
+
+    const double ln2 = std::log(2.0);
+    double bits_per_entry = -std::log(false_positive_rate) / (ln2 * ln2);
+    auto hash_count = static_cast<uint32_t>(
+        std::clamp(std::lround(bits_per_entry * ln2), 1L, static_cast<long>(MAX_HASH_COUNT)));
+    auto total_bits = static_cast<uint64_t>(std::ceil(double(lines) * bits_per_entry * BLOCKED_OVERHEAD));
+    uint64_t block_count = std::max<uint64_t>(1, (total_bits + BLOCK_BITS - 1) / BLOCK_BITS);
+
+    std::vector<uint8_t> out(HEADER_BYTES + block_count * BLOCK_BYTES, 0);
+    std::memcpy(out.data(), MAGIC, sizeof(MAGIC));
+    put_u32(&out[4], VERSION);
+    put_u32(&out[8], hash_count);
+    put_u64(&out[16], block_count);
+
+    uint64_t entries = 0;
+    Digest digest_bytes{};
+    bool read_ok = for_each_line(corpus_path, [&](const std::string& line) {
+        if (!parse_hibp_line(line, digest_bytes)) {
+            digest_bytes = digest(line);
+        }
+        uint8_t* block = &out[HEADER_BYTES + (get_u64(digest_bytes.data()) % block_count) * BLOCK_BYTES];
+        uint32_t position = get_u32(&digest_bytes[8]);
+        uint32_t step = get_u32(&digest_bytes[12]) | 1;
+        for (uint32_t i = 0; i < hash_count; ++i, position += step) {
+            uint32_t bit = position % BLOCK_BITS;
+            block[bit / 8] |= static_cast<uint8_t>(1u << (bit % 8));
+        }
+        ++entries;
+    });
+    if (!read_ok) {
+        return core::Result<uint64_t>::error("Cannot read corpus: " + corpus_path);
+    }
+    put_u64(&out[24], entries);
+
+    auto written = FileIO::write_file(output_path, out);
+    if (!written) {
+        return core::Result<uint64_t>::error(written.error_message);
+    }
+    return core::Result<uint64_t>::ok(entries);
+}
+
+const PasswordFilter* PasswordFilter::shared() {
+    static const std::optional<PasswordFilter> filter = []() -> std::optional<PasswordFilter> {
+        auto path = Config::get_breach_filter_path();
+        std::error_code ec;
+        if (!std::filesystem::exists(path, ec)) {
+            return std::nullopt;
+        }
+        auto opened = open(path.string());
+        if (!opened) {
+            spdlog::warn("Ignoring breached-password filter: {}", opened.error_message);
+            return std::nullopt;
+        }
+        return std::move(opened.value);
+    }();
+    return filter ? &*filter : nullptr;
+}
+
+PasswordFilter::Digest PasswordFilter::digest(std::string_view password) {
+    // One hash object per thread; creating it costs more than hashing
+    thread_local auto sha1 = Botan::HashFunction::create_or_throw("SHA-1");
+    sha1->update(reinterpret_cast<const uint8_t*>(password.data()), password.size());
+    auto full = sha1->final();
+    Digest result;
+    std::copy_n(full.begin(), result.size(), result.begin());
+    return result;
+}
+
+bool PasswordFilter::contains_digest(const Digest& digest) const {
+    if (!is_open()) {
+        return false;
+    }
+    const uint8_t* block = file_.data() + HEADER_BYTES + (get_u64(digest.data()) % block_count_) * BLOCK_BYTES;
+    uint32_t position = get_u32(&digest[8]);
+    uint32_t step = get_u32(&digest[12]) | 1;
+    for (uint32_t i = 0; i < hash_count_; ++i, position += step) {
+        uint32_t bit = position % BLOCK_BITS;
+        if ((block[bit / 8] & (1u << (bit % 8))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace utils
+} // namespace filevault
@@ -1,5 +1,8 @@
 #include "filevault/utils/progress.hpp"
+#include <fmt/format.h>
+#include <algorithm>
 #include <iostream>
+#include <mutex>
 
 #ifdef _WIN32
     #include <io.h>
@@ -20,11 +23,26 @@ static bool is_terminal() {
     return ISATTY(FILENO(stdout)) != 0;
 }
 
+static std::mutex observer_mutex;
+static ProgressBar::Observer global_observer;
+
+void ProgressBar::set_observer(Observer observer) {
+    std::lock_guard<std::mutex> lock(observer_mutex);
+    global_observer = std::move(observer);
+}
+
 ProgressBar::ProgressBar(const std::string& prefix, size_t max_progress)
     : current_progress_(0), max_progress_(max_progress) {
+    {
+        std::lock_guard<std::mutex> lock(observer_mutex);
+        observer_ = global_observer;
+    }
     
-    // Only show fancy progress bar if stdout is a terminal
-    if (is_terminal()) {
+    if (observer_) {
+        prefix_ = prefix;
+        bar_ = nullptr;
+    } else if (is_terminal()) {
+        // Only show fancy progress bar if stdout is a terminal
         bar_ = std::make_unique<indicators::ProgressBar>(
             option::BarWidth{40},
             option::Start{"["},
@@ -51,11 +69,22 @@ ProgressBar::~ProgressBar() {
     // The caller should call mark_as_completed() explicitly
 }
 
+void ProgressBar::notify() const {
+    if (observer_) {
+        observer_(prefix_, current_progress_, max_progress_);
+    }
+}
+
 void ProgressBar::set_progress(size_t progress) {
+    // Callers report per chunk; the observer only hears about changes
+    bool changed = progress != current_progress_;
     current_progress_ = progress;
     if (bar_) {
         bar_->set_progress(progress);
     }
+    if (changed) {
+        notify();
+    }
 }
 
 void ProgressBar::tick() {
@@ -71,6 +100,10 @@ void ProgressBar::set_postfix(const std::string& text) {
 }
 
 void ProgressBar::mark_as_completed() {
+    if (observer_ && current_progress_ < max_progress_) {
+        current_progress_ = max_progress_;
+        notify();
+    }
     if (bar_ && !bar_->is_completed()) {
         bar_->set_progress(100);  // Ensure it shows 100% before completing
         bar_->mark_as_completed();
@@ -114,5 +147,65 @@ void BlockProgressBar::mark_as_completed() {
     }
 }
 
+// ProgressAggregator implementation
+ProgressAggregator::ProgressAggregator(const std::string& prefix, uint64_t total_bytes,
+                                       std::chrono::milliseconds interval)
+    : bar_(prefix, 100),
+      total_(total_bytes),
+      interval_(interval),
+      start_(std::chrono::steady_clock::now()),
+      thread_([this]() { render_loop(); }) {
+}
+
+ProgressAggregator::~ProgressAggregator() {
+    // Leaves the bar as last drawn; finish() completes it
+    stop();
+}
+
+void ProgressAggregator::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void ProgressAggregator::render_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!cv_.wait_for(lock, interval_, [this]() { return stopping_; })) {
+        lock.unlock();
+        render();
+        lock.lock();
+    }
+}
+
+void ProgressAggregator::render() {
+    uint64_t done = this->done();
+    uint64_t total = this->total();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    if (total > 0) {
+        bar_.set_progress(static_cast<size_t>(std::min(done, total) * 100 / total));
+    }
+    bar_.set_postfix(" " + format_rate(done, total, seconds));
+}
+
+void ProgressAggregator::finish() {
+    stop();
+    render();
+    bar_.mark_as_completed();
+}
+
+std::string ProgressAggregator::format_rate(uint64_t done, uint64_t total, double seconds) {
+    double mbps = seconds > 0 ? done / (1024.0 * 1024.0) / seconds : 0.0;
+    if (total == 0 || done >= total || done == 0) {
+        return fmt::format("{:.1f} MB/s", mbps);
+    }
+    auto eta = static_cast<uint64_t>(seconds * (total - done) / done + 0.5);
+    return fmt::format("{:.1f} MB/s, ETA {}:{:02}", mbps, eta / 60, eta % 60);
+}
+
 } // namespace utils
 } // namespace filevault
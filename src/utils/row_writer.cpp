@@ -0,0 +1,200 @@
+#include "filevault/utils/row_writer.hpp"
+#include <algorithm>
+
+#ifdef _WIN32
+    #include <io.h>
+    #define ISATTY _isatty
+    #define FILENO _fileno
+#else
+    #include <unistd.h>
+    #define ISATTY isatty
+    #define FILENO fileno
+#endif
+
+namespace filevault {
+namespace utils {
+
+namespace {
+
+// Buffered bytes that force a write before flush_rows is reached
+constexpr size_t FLUSH_BYTES = 1024 * 1024;
+
+// Displayed width, counting UTF-8 sequences as one column each
+size_t display_width(std::string_view text) {
+    return static_cast<size_t>(std::count_if(text.begin(), text.end(), [](char c) {
+        return (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+    }));
+}
+
+void append_padded(std::string& out, std::string_view cell, size_t width, bool right, bool last) {
+    size_t pad = width > display_width(cell) ? width - display_width(cell) : 0;
+    if (right) {
+        out.append(pad, ' ');
+    }
+    out.append(cell);
+    if (!right && !last) {
+        out.append(pad, ' ');
+    }
+}
+
+void append_tsv(std::string& out, std::string_view cell) {
+    if (cell.find_first_of("\t\n\r\\") == std::string_view::npos) {
+        out.append(cell);
+        return;
+    }
+    for (char c : cell) {
+        switch (c) {
+            case '\t': out += "\\t";  break;
+            case '\n': out += "\\n";  break;
+            case '\r': out += "\\r";  break;
+            case '\\': out += "\\\\"; break;
+            default:   out += c;
+        }
+    }
+}
+
+void append_json_string(std::string& out, std::string_view text) {
+    static const char HEX[] = "0123456789abcdef";
+    out += '"';
+    for (char c : text) {
+        auto byte = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else if (c == '\t') {
+            out += "\\t";
+        } else if (c == '\r') {
+            out += "\\r";
+        } else if (byte < 0x20) {
+            out += "\\u00";
+            out += HEX[byte >> 4];
+            out += HEX[byte & 0x0F];
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+} // anonymous namespace
+
+RowWriter::RowWriter(std::vector<RowColumn> columns, RowFormat format, std::FILE* out, size_t flush_rows)
+    : columns_(std::move(columns)), format_(format), out_(out ? out : stdout),
+      flush_rows_(is_terminal(out_) ? 1 : std::max<size_t>(flush_rows, 1)) {
+    buffer_.reserve(FLUSH_BYTES + 4096);
+}
+
+RowWriter::~RowWriter() {
+    flush();
+}
+
+bool RowWriter::parse_format(const std::string& name, std::FILE* out, RowFormat& format) {
+    if (name == "auto") {
+        format = is_terminal(out) ? RowFormat::TABLE : RowFormat::TSV;
+    } else if (name == "table") {
+        format = RowFormat::TABLE;
+    } else if (name == "tsv") {
+        format = RowFormat::TSV;
+    } else if (name == "jsonl") {
+        format = RowFormat::JSONL;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool RowWriter::is_terminal(std::FILE* out) {
+    return out && ISATTY(FILENO(out)) != 0;
+}
+
+void RowWriter::header() {
+    if (format_ == RowFormat::JSONL) {
+        return;
+    }
+    std::vector<std::string_view> names;
+    names.reserve(columns_.size());
+    for (const auto& column : columns_) {
+        names.push_back(column.name);
+    }
+    row(names);
+    --rows_;
+}
+
+void RowWriter::row(const std::vector<std::string_view>& cells) {
+    const size_t count = columns_.size();
+    switch (format_) {
+        case RowFormat::TABLE:
+            buffer_ += "  ";
+            for (size_t i = 0; i < count; ++i) {
+                if (i > 0) {
+                    buffer_ += "  ";
+                }
+                std::string_view cell = i < cells.size() ? cells[i] : std::string_view();
+                append_padded(buffer_, cell, columns_[i].width, columns_[i].right, i + 1 == count);
+            }
+            // Empty trailing cells leave no trailing blanks
+            while (!buffer_.empty() && buffer_.back() == ' ') {
+                buffer_.pop_back();
+            }
+            break;
+        case RowFormat::TSV:
+            for (size_t i = 0; i < count; ++i) {
+                if (i > 0) {
+                    buffer_ += '\t';
+                }
+                if (i < cells.size()) {
+                    append_tsv(buffer_, cells[i]);
+                }
+            }
+            break;
+        case RowFormat::JSONL:
+            buffer_ += '{';
+            for (size_t i = 0; i < count; ++i) {
+                if (i > 0) {
+                    buffer_ += ',';
+                }
+                append_json_string(buffer_, columns_[i].name);
+                buffer_ += ':';
+                std::string_view cell = i < cells.size() ? cells[i] : std::string_view();
+                if (columns_[i].literal && !cell.empty()) {
+                    buffer_.append(cell);
+                } else if (columns_[i].literal) {
+                    buffer_ += "null";
+                } else {
+                    append_json_string(buffer_, cell);
+                }
+            }
+            buffer_ += '}';
+            break;
+    }
+    buffer_ += '\n';
+    row_done();
+}
+
+void RowWriter::line(std::string_view text) {
+    buffer_.append(text);
+    buffer_ += '\n';
+    row_done();
+}
+
+void RowWriter::row_done() {
+    ++rows_;
+    if (++pending_ >= flush_rows_ || buffer_.size() >= FLUSH_BYTES) {
+        flush();
+    }
+}
+
+bool RowWriter::flush() {
+    if (!buffer_.empty() && !failed_) {
+        failed_ = std::fwrite(buffer_.data(), 1, buffer_.size(), out_) != buffer_.size() ||
+                  std::fflush(out_) != 0;
+    }
+    buffer_.clear();
+    pending_ = 0;
+    return !failed_;
+}
+
+} // namespace utils
+} // namespace filevault
@@ -0,0 +1,111 @@
+/**
+ * @file run_stats.cpp
+ * @brief Per-run metrics for --stats json
+ */
+
+#include "filevault/utils/run_stats.hpp"
+#include "filevault/utils/bench_stats.hpp"
+#include "filevault/utils/trace.hpp"
+#include <nlohmann/json.hpp>
+#include <map>
+
+namespace filevault {
+namespace utils {
+
+RunStats& RunStats::instance() {
+    static RunStats stats;
+    return stats;
+}
+
+void RunStats::add_bytes(uint64_t bytes_in, uint64_t bytes_out) {
+    bytes_in_.fetch_add(bytes_in, std::memory_order_relaxed);
+    bytes_out_.fetch_add(bytes_out, std::memory_order_relaxed);
+}
+
+void RunStats::add_files(uint64_t files) {
+    files_.fetch_add(files, std::memory_order_relaxed);
+}
+
+void RunStats::add_chunks(uint64_t chunks) {
+    chunks_.fetch_add(chunks, std::memory_order_relaxed);
+}
+
+void RunStats::set_algorithm(const std::string& algorithm) {
+    std::lock_guard<std::mutex> lock(algorithm_mutex_);
+    algorithm_ = algorithm;
+}
+
+std::string RunStats::algorithm() const {
+    std::lock_guard<std::mutex> lock(algorithm_mutex_);
+    return algorithm_;
+}
+
+void RunStats::reset() {
+    bytes_in_ = 0;
+    bytes_out_ = 0;
+    files_ = 0;
+    chunks_ = 0;
+    set_algorithm({});
+}
+
+std::string RunStats::to_json(const std::string& command, int exit_code, double wall_ms) const {
+    // Span categories that are pipeline stages; "streaming" and "format"
+    // spans enclose the others and would count them twice
+    const std::map<std::string, std::string> stage_names = {
+        {"kdf", "kdf_ms"},
+        {"compression", "compress_ms"},
+        {"cipher", "cipher_ms"},
+        {"io", "io_ms"},
+    };
+    std::map<std::string, double> stages;
+    std::map<std::string, AllocCounters> stage_allocs;
+    for (const auto& [category, key] : stage_names) {
+        stages[key] = 0.0;
+    }
+    for (const auto& span : Tracer::instance().spans()) {
+        auto it = stage_names.find(span.category);
+        if (it != stage_names.end()) {
+            stages[it->second] += span.duration_us / 1000.0;
+            auto& allocs = stage_allocs[span.category];
+            allocs.allocations += span.allocs.allocations;
+            allocs.bytes += span.allocs.bytes;
+        }
+    }
+
+    uint64_t in = bytes_in();
+    uint64_t out = bytes_out();
+    double seconds = wall_ms / 1000.0;
+    nlohmann::json json = {
+        {"command", command},
+        {"exit_code", exit_code},
+        {"duration_ms", wall_ms},
+        {"bytes_in", in},
+        {"bytes_out", out},
+        {"throughput_mbps", seconds > 0 ? (in / 1024.0 / 1024.0) / seconds : 0.0},
+        {"compression_ratio", in > 0 && out > 0 ? static_cast<double>(in) / out : 0.0},
+        {"files", files_.load(std::memory_order_relaxed)},
+        {"chunks", chunks_.load(std::memory_order_relaxed)},
+        {"stages", stages},
+        {"peak_rss_bytes", peak_rss_bytes()}
+    };
+    if (auto name = algorithm(); !name.empty()) {
+        json["algorithm"] = name;
+    }
+    if (AllocStats::enabled()) {
+        // Counting allocator build: whole run and per stage
+        auto totals = AllocStats::totals();
+        nlohmann::json allocations = {
+            {"count", totals.allocations},
+            {"bytes", totals.bytes},
+            {"peak_live_bytes", AllocStats::peak_bytes()}
+        };
+        for (const auto& [category, allocs] : stage_allocs) {
+            allocations["stages"][category] = {{"count", allocs.allocations}, {"bytes", allocs.bytes}};
+        }
+        json["allocations"] = std::move(allocations);
+    }
+    return json.dump();
+}
+
+} // namespace utils
+} // namespace filevault
@@ -0,0 +1,705 @@
+/**
+ * @file s3_store.cpp
+ * @brief S3 REST client: SigV4 signing and HTTP/1.1 over sockets or TLS
+ */
+
+#include "filevault/utils/s3_store.hpp"
+#include <botan/build.h>
+#include <botan/hash.h>
+#include <botan/hex.h>
+#include <botan/mac.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#if defined(BOTAN_HAS_TLS) && defined(BOTAN_HAS_CERTSTOR_SYSTEM)
+#define FILEVAULT_HAVE_TLS 1
+#include <botan/auto_rng.h>
+#include <botan/certstor_system.h>
+#include <botan/credentials_manager.h>
+#include <botan/tls_callbacks.h>
+#include <botan/tls_client.h>
+#include <botan/tls_policy.h>
+#include <botan/tls_session_manager_memory.h>
+#endif
+
+namespace filevault {
+namespace utils {
+
+using Headers = std::vector<std::pair<std::string, std::string>>;
+
+struct S3Store::Response {
+    int status = 0;                 // 0 = no response (error says why)
+    std::string error;
+    Headers headers;                // Names lowercased
+    std::vector<uint8_t> body;
+
+    std::optional<std::string> header(std::string_view name) const {
+        for (const auto& [key, value] : headers) {
+            if (key == name) {
+                return value;
+            }
+        }
+        return std::nullopt;
+    }
+};
+
+namespace {
+
+// Socket reads and writes that stall this long fail the request
+constexpr int IO_TIMEOUT_SECONDS = 60;
+
+std::string lowercase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+std::string trim(std::string_view text) {
+    size_t begin = text.find_first_not_of(" \t");
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    size_t end = text.find_last_not_of(" \t\r");
+    return std::string(text.substr(begin, end - begin + 1));
+}
+
+std::string sha256_hex(std::span<const uint8_t> data) {
+    auto hash = Botan::HashFunction::create_or_throw("SHA-256");
+    hash->update(data.data(), data.size());
+    auto digest = hash->final();
+    return Botan::hex_encode(digest.data(), digest.size(), false);
+}
+
+std::string sha256_hex(std::string_view text) {
+    return sha256_hex(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(text.data()), text.size()));
+}
+
+std::vector<uint8_t> hmac_sha256(std::span<const uint8_t> key, std::string_view message) {
+    auto mac = Botan::MessageAuthenticationCode::create_or_throw("HMAC(SHA-256)");
+    mac->set_key(key.data(), key.size());
+    mac->update(reinterpret_cast<const uint8_t*>(message.data()), message.size());
+    auto tag = mac->final();
+    return std::vector<uint8_t>(tag.begin(), tag.end());
+}
+
+std::string amz_now() {
+    std::time_t now = std::time(nullptr);
+    std::tm utc {};
+#ifdef _WIN32
+    gmtime_s(&utc, &now);
+#else
+    gmtime_r(&now, &utc);
+#endif
+    char text[32];
+    std::strftime(text, sizeof(text), "%Y%m%dT%H%M%SZ", &utc);
+    return text;
+}
+
+// Text of the first <tag> element; enough for S3's flat responses
+std::string xml_value(std::string_view body, std::string_view tag) {
+    std::string open = "<" + std::string(tag) + ">";
+    std::string close = "</" + std::string(tag) + ">";
+    size_t begin = body.find(open);
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    begin += open.size();
+    size_t end = body.find(close, begin);
+    return end == std::string_view::npos ? std::string() : std::string(body.substr(begin, end - begin));
+}
+
+std::string_view as_text(const std::vector<uint8_t>& body) {
+    return {reinterpret_cast<const char*>(body.data()), body.size()};
+}
+
+#ifdef _WIN32
+using SocketHandle = SOCKET;
+constexpr SocketHandle NO_SOCKET = INVALID_SOCKET;
+
+void close_socket(SocketHandle socket) {
+    closesocket(socket);
+}
+
+bool start_sockets() {
+    static bool started = []() {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    return started;
+}
+#else
+using SocketHandle = int;
+constexpr SocketHandle NO_SOCKET = -1;
+
+void close_socket(SocketHandle socket) {
+    ::close(socket);
+}
+
+bool start_sockets() {
+    return true;
+}
+#endif
+
+/**
+ * Blocking TCP connection, optionally wrapped in TLS. Reads return 0 at
+ * the end of the stream and -1 on errors.
+ */
+class Connection {
+public:
+    ~Connection() {
+        close();
+    }
+
+    bool open(const std::string& host, const std::string& port, bool tls, std::string& error) {
+        if (!start_sockets()) {
+            error = "socket library unavailable";
+            return false;
+        }
+        addrinfo hints {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* found = nullptr;
+        if (getaddrinfo(host.c_str(), port.c_str(), &hints, &found) != 0 || !found) {
+            error = "cannot resolve " + host;
+            return false;
+        }
+        for (addrinfo* address = found; address && socket_ == NO_SOCKET; address = address->ai_next) {
+            socket_ = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+            if (socket_ == NO_SOCKET) {
+                continue;
+            }
+            if (::connect(socket_, address->ai_addr, static_cast<int>(address->ai_addrlen)) != 0) {
+                close_socket(socket_);
+                socket_ = NO_SOCKET;
+            }
+        }
+        freeaddrinfo(found);
+        if (socket_ == NO_SOCKET) {
+            error = "cannot connect to " + host + ":" + port;
+            return false;
+        }
+        set_timeouts();
+        if (tls) {
+            return start_tls(host, port, error);
+        }
+        return true;
+    }
+
+    bool write(std::span<const uint8_t> data) {
+#ifdef FILEVAULT_HAVE_TLS
+        if (tls_) {
+            tls_->client->send(data.data(), data.size());
+            return !tls_->callbacks->failed;
+        }
+#endif
+        return write_raw(data);
+    }
+
+    int64_t read(uint8_t* out, size_t size) {
+#ifdef FILEVAULT_HAVE_TLS
+        if (tls_) {
+            auto& received = tls_->callbacks->received;
+            while (received.empty() && !tls_->client->is_closed()) {
+                uint8_t raw[16 * 1024];
+                int64_t got = read_raw(raw, sizeof(raw));
+                if (got <= 0) {
+                    return got;
+                }
+                try {
+                    tls_->client->received_data(raw, static_cast<size_t>(got));
+                } catch (const std::exception& e) {
+                    spdlog::debug("TLS error: {}", e.what());
+                    return -1;
+                }
+                if (tls_->callbacks->failed) {
+                    return -1;
+                }
+            }
+            size_t piece = std::min(size, received.size());
+            std::memcpy(out, received.data(), piece);
+            received.erase(received.begin(), received.begin() + static_cast<std::ptrdiff_t>(piece));
+            return static_cast<int64_t>(piece);
+        }
+#endif
+        return read_raw(out, size);
+    }
+
+    void close() {
+#ifdef FILEVAULT_HAVE_TLS
+        tls_.reset();
+#endif
+        if (socket_ != NO_SOCKET) {
+            close_socket(socket_);
+            socket_ = NO_SOCKET;
+        }
+    }
+
+private:
+    void set_timeouts() {
+#ifdef _WIN32
+        DWORD timeout = IO_TIMEOUT_SECONDS * 1000;
+#else
+        timeval timeout {};
+        timeout.tv_sec = IO_TIMEOUT_SECONDS;
+#endif
+        setsockopt(socket_, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+        setsockopt(socket_, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+        int one = 1;
+        setsockopt(socket_, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&one), sizeof(one));
+    }
+
+    bool write_raw(std::span<const uint8_t> data) {
+        while (!data.empty()) {
+            int chunk = static_cast<int>(std::min<size_t>(data.size(), 1u << 30));
+#ifdef _WIN32
+            int sent = ::send(socket_, reinterpret_cast<const char*>(data.data()), chunk, 0);
+#elif defined(MSG_NOSIGNAL)
+            auto sent = ::send(socket_, data.data(), static_cast<size_t>(chunk), MSG_NOSIGNAL);
+#else
+            auto sent = ::send(socket_, data.data(), static_cast<size_t>(chunk), 0);
+#endif
+            if (sent <= 0) {
+                return false;
+            }
+            data = data.subspan(static_cast<size_t>(sent));
+        }
+        return true;
+    }
+
+    int64_t read_raw(uint8_t* out, size_t size) {
+        int chunk = static_cast<int>(std::min<size_t>(size, 1u << 30));
+#ifdef _WIN32
+        int got = ::recv(socket_, reinterpret_cast<char*>(out), chunk, 0);
+#else
+        auto got = ::recv(socket_, out, static_cast<size_t>(chunk), 0);
+#endif
+        return got < 0 ? -1 : static_cast<int64_t>(got);
+    }
+
+#ifdef FILEVAULT_HAVE_TLS
+    class Callbacks : public Botan::TLS::Callbacks {
+    public:
+        explicit Callbacks(Connection& connection) : connection_(connection) {}
+
+        void tls_emit_data(std::span<const uint8_t> data) override {
+            failed = failed || !connection_.write_raw(data);
+        }
+
+        void tls_record_received(uint64_t, std::span<const uint8_t> data) override {
+            received.insert(received.end(), data.begin(), data.end());
+        }
+
+        void tls_alert(Botan::TLS::Alert alert) override {
+            if (alert.is_fatal()) {
+                spdlog::debug("TLS alert: {}", alert.type_string());
+                failed = true;
+            }
+        }
+
+        std::vector<uint8_t> received;
+        bool failed = false;
+
+    private:
+        Connection& connection_;
+    };
+
+    class SystemCredentials : public Botan::Credentials_Manager {
+    public:
+        std::vector<Botan::Certificate_Store*> trusted_certificate_authorities(
+            const std::string&, const std::string&) override {
+            return {&roots_};
+        }
+
+    private:
+        Botan::System_Certificate_Store roots_;
+    };
+
+    struct Tls {
+        std::shared_ptr<Callbacks> callbacks;
+        std::unique_ptr<Botan::TLS::Client> client;
+    };
+
+    bool start_tls(const std::string& host, const std::string& port, std::string& error) {
+        try {
+            auto rng = std::make_shared<Botan::AutoSeeded_RNG>();
+            tls_ = std::make_unique<Tls>();
+            tls_->callbacks = std::make_shared<Callbacks>(*this);
+            tls_->client = std::make_unique<Botan::TLS::Client>(
+                tls_->callbacks,
+                std::make_shared<Botan::TLS::Session_Manager_In_Memory>(rng),
+                std::make_shared<SystemCredentials>(),
+                std::make_shared<Botan::TLS::Policy>(),
+                rng,
+                Botan::TLS::Server_Information(host, static_cast<uint16_t>(std::stoi(port))));
+            // Application data can only be sent once the handshake is done
+            uint8_t raw[16 * 1024];
+            while (!tls_->client->is_active()) {
+                int64_t got = read_raw(raw, sizeof(raw));
+                if (got <= 0 || tls_->callbacks->failed) {
+                    error = "TLS handshake with " + host + " failed";
+                    return false;
+                }
+                tls_->client->received_data(raw, static_cast<size_t>(got));
+            }
+            return !tls_->callbacks->failed;
+        } catch (const std::exception& e) {
+            error = "TLS handshake with " + host + " failed: " + e.what();
+            return false;
+        }
+    }
+
+    std::unique_ptr<Tls> tls_;
+#else
+    bool start_tls(const std::string&, const std::string&, std::string& error) {
+        error = "https endpoints need Botan built with TLS support";
+        return false;
+    }
+#endif
+
+    SocketHandle socket_ = NO_SOCKET;
+};
+
+// Undo chunked transfer coding; false if the body is malformed
+bool dechunk(std::vector<uint8_t>& body) {
+    std::vector<uint8_t> plain;
+    size_t pos = 0;
+    auto text = as_text(body);
+    while (true) {
+        size_t line_end = text.find("\r\n", pos);
+        if (line_end == std::string_view::npos) {
+            return false;
+        }
+        size_t length = std::strtoull(std::string(text.substr(pos, line_end - pos)).c_str(), nullptr, 16);
+        pos = line_end + 2;
+        if (length == 0) {
+            break;
+        }
+        if (pos + length > body.size()) {
+            return false;
+        }
+        plain.insert(plain.end(), body.begin() + static_cast<std::ptrdiff_t>(pos),
+                     body.begin() + static_cast<std::ptrdiff_t>(pos + length));
+        pos += length + 2;
+    }
+    body = std::move(plain);
+    return true;
+}
+
+} // anonymous namespace
+
+core::Result<S3Config> S3Config::from_environment(const std::string& bucket) {
+    auto env = [](const char* name) {
+        const char* value = std::getenv(name);
+        return std::string(value ? value : "");
+    };
+    S3Config config;
+    config.bucket = bucket;
+    config.access_key = env("AWS_ACCESS_KEY_ID");
+    config.secret_key = env("AWS_SECRET_ACCESS_KEY");
+    config.session_token = env("AWS_SESSION_TOKEN");
+    if (config.access_key.empty() || config.secret_key.empty()) {
+        return core::Result<S3Config>::error("Set AWS_ACCESS_KEY_ID and AWS_SECRET_ACCESS_KEY for s3:// paths");
+    }
+    std::string region = env("AWS_REGION");
+    if (region.empty()) {
+        region = env("AWS_DEFAULT_REGION");
+    }
+    if (!region.empty()) {
+        config.region = region;
+    }
+    config.endpoint = env("AWS_ENDPOINT_URL");
+    config.path_style = !config.endpoint.empty();
+    if (config.endpoint.empty()) {
+        config.endpoint = "https://s3." + config.region + ".amazonaws.com";
+    }
+    return core::Result<S3Config>::ok(std::move(config));
+}
+
+S3Store::S3Store(S3Config config)
+    : config_(std::move(config)) {
+    std::string_view endpoint = config_.endpoint;
+    tls_ = !endpoint.starts_with("http://");
+    if (size_t scheme = endpoint.find("://"); scheme != std::string_view::npos) {
+        endpoint.remove_prefix(scheme + 3);
+    }
+    endpoint = endpoint.substr(0, endpoint.find('/'));
+    size_t colon = endpoint.rfind(':');
+    if (colon != std::string_view::npos && endpoint.find(']', colon) == std::string_view::npos) {
+        host_ = std::string(endpoint.substr(0, colon));
+        port_ = std::string(endpoint.substr(colon + 1));
+    } else {
+        host_ = std::string(endpoint);
+        port_ = tls_ ? "443" : "80";
+    }
+}
+
+std::string S3Store::uri_encode(std::string_view text, bool keep_slash) {
+    static constexpr char HEX[] = "0123456789ABCDEF";
+    std::string encoded;
+    encoded.reserve(text.size());
+    for (unsigned char c : text) {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~' || (keep_slash && c == '/')) {
+            encoded += static_cast<char>(c);
+        } else {
+            encoded += '%';
+            encoded += HEX[c >> 4];
+            encoded += HEX[c & 0x0F];
+        }
+    }
+    return encoded;
+}
+
+std::string S3Store::authorization(const S3Request& request, const S3Config& config,
+                                   const std::string& amz_date) {
+    Headers headers;
+    for (const auto& [name, value] : request.headers) {
+        headers.emplace_back(lowercase(name), trim(value));
+    }
+    std::sort(headers.begin(), headers.end());
+    std::string canonical_headers, signed_headers;
+    for (const auto& [name, value] : headers) {
+        canonical_headers += name + ":" + value + "\n";
+        signed_headers += (signed_headers.empty() ? "" : ";") + name;
+    }
+
+    Headers query;
+    for (const auto& [name, value] : request.query) {
+        query.emplace_back(uri_encode(name, false), uri_encode(value, false));
+    }
+    std::sort(query.begin(), query.end());
+    std::string canonical_query;
+    for (const auto& [name, value] : query) {
+        canonical_query += (canonical_query.empty() ? "" : "&") + name + "=" + value;
+    }
+
+    std::string canonical_request = request.method + "\n" + request.path + "\n" + canonical_query + "\n" +
+                                    canonical_headers + "\n" + signed_headers + "\n" + request.payload_hash;
+    std::string date = amz_date.substr(0, 8);
+    std::string scope = date + "/" + config.region + "/s3/aws4_request";
+    std::string string_to_sign = "AWS4-HMAC-SHA256\n" + amz_date + "\n" + scope + "\n" +
+                                 sha256_hex(canonical_request);
+
+    std::string secret = "AWS4" + config.secret_key;
+    auto key = hmac_sha256(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(secret.data()), secret.size()),
+                           date);
+    key = hmac_sha256(key, config.region);
+    key = hmac_sha256(key, "s3");
+    key = hmac_sha256(key, "aws4_request");
+    auto signature = hmac_sha256(key, string_to_sign);
+
+    return "AWS4-HMAC-SHA256 Credential=" + config.access_key + "/" + scope +
+           ", SignedHeaders=" + signed_headers +
+           ", Signature=" + Botan::hex_encode(signature.data(), signature.size(), false);
+}
+
+S3Store::Response S3Store::send(const std::string& method, const std::string& key, Headers query,
+                                Headers headers, std::span<const uint8_t> body) {
+    S3Request request;
+    request.method = method;
+    request.host = config_.path_style ? host_ : config_.bucket + "." + host_;
+    if ((tls_ && port_ != "443") || (!tls_ && port_ != "80")) {
+        request.host += ":" + port_;
+    }
+    request.path = config_.path_style ? "/" + uri_encode(config_.bucket, false) + "/" + uri_encode(key, true)
+                                      : "/" + uri_encode(key, true);
+    request.query = std::move(query);
+    request.payload_hash = sha256_hex(body);
+    request.headers = std::move(headers);
+    request.headers.emplace_back("host", request.host);
+    request.headers.emplace_back("x-amz-content-sha256", request.payload_hash);
+    if (!config_.session_token.empty()) {
+        request.headers.emplace_back("x-amz-security-token", config_.session_token);
+    }
+
+    std::string target = request.path;
+    for (size_t i = 0; i < request.query.size(); ++i) {
+        target += (i == 0 ? "?" : "&") + uri_encode(request.query[i].first, false) + "=" +
+                  uri_encode(request.query[i].second, false);
+    }
+    std::string connect_host = config_.path_style ? host_ : config_.bucket + "." + host_;
+
+    Response response;
+    for (int attempt = 0; attempt < std::max(config_.retries, 1); ++attempt) {
+        if (attempt > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200 << attempt));
+        }
+        // Signed per attempt; a retry must not carry a stale date
+        std::string amz_date = amz_now();
+        S3Request signed_request = request;
+        signed_request.headers.emplace_back("x-amz-date", amz_date);
+        std::string head = method + " " + target + " HTTP/1.1\r\n";
+        for (const auto& [name, value] : signed_request.headers) {
+            head += name + ": " + value + "\r\n";
+        }
+        head += "authorization: " + authorization(signed_request, config_, amz_date) + "\r\n";
+        head += "content-length: " + std::to_string(body.size()) + "\r\nconnection: close\r\n\r\n";
+
+        response = Response();
+        Connection connection;
+        if (!connection.open(connect_host, port_, tls_, response.error)) {
+            continue;
+        }
+        if (!connection.write(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(head.data()), head.size())) ||
+            !connection.write(body)) {
+            response.error = "cannot send request to " + connect_host;
+            continue;
+        }
+
+        // The server closes the connection once the response is complete
+        std::vector<uint8_t> raw;
+        uint8_t buffer[64 * 1024];
+        int64_t got;
+        while ((got = connection.read(buffer, sizeof(buffer))) > 0) {
+            raw.insert(raw.end(), buffer, buffer + got);
+        }
+        auto text = as_text(raw);
+        size_t head_end = text.find("\r\n\r\n");
+        if (got < 0 || head_end == std::string_view::npos || !text.starts_with("HTTP/1.")) {
+            response.error = "no valid response from " + connect_host;
+            continue;
+        }
+
+        size_t line_end = text.find("\r\n");
+        response.status = std::atoi(std::string(text.substr(9, 3)).c_str());
+        for (size_t pos = line_end + 2; pos < head_end;) {
+            size_t end = text.find("\r\n", pos);
+            auto line = text.substr(pos, end - pos);
+            size_t colon = line.find(':');
+            if (colon != std::string_view::npos) {
+                response.headers.emplace_back(lowercase(std::string(line.substr(0, colon))), trim(line.substr(colon + 1)));
+            }
+            pos = end + 2;
+        }
+        response.body.assign(raw.begin() + static_cast<std::ptrdiff_t>(head_end + 4), raw.end());
+        if (lowercase(response.header("transfer-encoding").value_or("")) == "chunked" && !dechunk(response.body)) {
+            response.status = 0;
+            response.error = "malformed chunked response from " + connect_host;
+            continue;
+        }
+        if (auto length = response.header("content-length"); length && method != "HEAD" &&
+            std::strtoull(length->c_str(), nullptr, 10) != response.body.size()) {
+            response.status = 0;
+            response.error = "truncated response from " + connect_host;
+            continue;
+        }
+        // Throttling and server errors are worth another attempt
+        if (response.status != 429 && response.status < 500) {
+            break;
+        }
+    }
+    return response;
+}
+
+std::string S3Store::describe(const Response& response) {
+    if (response.status == 0) {
+        return response.error;
+    }
+    auto body = as_text(response.body);
+    std::string code = xml_value(body, "Code");
+    std::string message = xml_value(body, "Message");
+    std::string text = "HTTP " + std::to_string(response.status);
+    if (!code.empty()) {
+        text += " " + code;
+    }
+    if (!message.empty()) {
+        text += ": " + message;
+    }
+    return text;
+}
+
+core::Result<uint64_t> S3Store::size(const std::string& key) {
+    auto response = send("HEAD", key, {}, {}, {});
+    if (response.status == 404) {
+        return core::Result<uint64_t>::error("no such object");
+    }
+    auto length = response.header("content-length");
+    if (response.status != 200 || !length) {
+        return core::Result<uint64_t>::error(describe(response));
+    }
+    return core::Result<uint64_t>::ok(std::strtoull(length->c_str(), nullptr, 10));
+}
+
+core::Result<std::vector<uint8_t>> S3Store::read(const std::string& key, uint64_t offset, size_t length) {
+    using ReadResult = core::Result<std::vector<uint8_t>>;
+    if (length == 0) {
+        return ReadResult::ok({});
+    }
+    std::string range = "bytes=" + std::to_string(offset) + "-" + std::to_string(offset + length - 1);
+    auto response = send("GET", key, {}, {{"range", range}}, {});
+    // 200 means the server ignored the range and sent the whole object
+    if (response.status == 200 && offset == 0 && response.body.size() > length) {
+        response.body.resize(length);
+    } else if (response.status != 206 && !(response.status == 200 && offset == 0)) {
+        return ReadResult::error(describe(response));
+    }
+    return ReadResult::ok(std::move(response.body));
+}
+
+core::Result<std::string> S3Store::begin_upload(const std::string& key) {
+    auto response = send("POST", key, {{"uploads", ""}}, {}, {});
+    std::string upload_id = xml_value(as_text(response.body), "UploadId");
+    if (response.status != 200 || upload_id.empty()) {
+        return core::Result<std::string>::error(describe(response));
+    }
+    return core::Result<std::string>::ok(std::move(upload_id));
+}
+
+core::Result<std::string> S3Store::upload_part(const std::string& key, const std::string& upload_id,
+                                               int part_number, std::span<const uint8_t> data) {
+    auto response = send("PUT", key, {{"partNumber", std::to_string(part_number)}, {"uploadId", upload_id}},
+                         {}, data);
+    auto etag = response.header("etag");
+    if (response.status != 200 || !etag) {
+        return core::Result<std::string>::error(describe(response));
+    }
+    return core::Result<std::string>::ok(std::move(*etag));
+}
+
+core::Result<void> S3Store::complete_upload(const std::string& key, const std::string& upload_id,
+                                            const std::vector<std::string>& etags) {
+    std::string manifest = "<CompleteMultipartUpload>";
+    for (size_t i = 0; i < etags.size(); ++i) {
+        manifest += "<Part><PartNumber>" + std::to_string(i + 1) + "</PartNumber><ETag>" + etags[i] + "</ETag></Part>";
+    }
+    manifest += "</CompleteMultipartUpload>";
+    auto response = send("POST", key, {{"uploadId", upload_id}}, {{"content-type", "application/xml"}},
+                         std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(manifest.data()), manifest.size()));
+    // S3 can report a failed completion inside a 200 response
+    if (response.status != 200 || as_text(response.body).find("<Error>") != std::string_view::npos) {
+        return core::Result<void>::error(describe(response));
+    }
+    return core::Result<void>::ok();
+}
+
+void S3Store::abort_upload(const std::string& key, const std::string& upload_id) {
+    auto response = send("DELETE", key, {{"uploadId", upload_id}}, {}, {});
+    if (response.status != 204 && response.status != 200) {
+        spdlog::warn("Cannot abort upload of {}: {}", key, describe(response));
+    }
+}
+
+} // namespace utils
+} // namespace filevault
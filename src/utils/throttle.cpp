@@ -0,0 +1,135 @@
+/**
+ * @file throttle.cpp
+ * @brief I/O rate limiting and background priority
+ */
+
+#include "filevault/utils/throttle.hpp"
+#include "filevault/utils/trace.hpp"
+#include <algorithm>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace filevault {
+namespace utils {
+
+namespace {
+
+constexpr double BUCKET_SECONDS = 0.1;
+constexpr double MIN_BUCKET_BYTES = 64 * 1024;
+
+#ifdef __linux__
+// ioprio_set has no glibc wrapper; values from linux/ioprio.h
+constexpr int IOPRIO_WHO_PROCESS = 1;
+constexpr int IOPRIO_CLASS_IDLE = 3;
+constexpr int IOPRIO_CLASS_SHIFT = 13;
+#endif
+
+} // anonymous namespace
+
+RateLimiter::RateLimiter(uint64_t bytes_per_second) {
+    set_rate(bytes_per_second);
+}
+
+RateLimiter& RateLimiter::reads() {
+    static RateLimiter limiter;
+    return limiter;
+}
+
+RateLimiter& RateLimiter::writes() {
+    static RateLimiter limiter;
+    return limiter;
+}
+
+void RateLimiter::set_rate(uint64_t bytes_per_second) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    rate_.store(bytes_per_second, std::memory_order_relaxed);
+    capacity_ = (std::max)(static_cast<double>(bytes_per_second) * BUCKET_SECONDS, MIN_BUCKET_BYTES);
+    tokens_ = capacity_;
+    last_ = Clock::now();
+}
+
+RateLimiter::Clock::duration RateLimiter::reserve(uint64_t bytes, Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto rate = static_cast<double>(rate_.load(std::memory_order_relaxed));
+    if (rate <= 0) {
+        return Clock::duration::zero();
+    }
+    if (now > last_) {
+        tokens_ = (std::min)(capacity_, tokens_ + rate * std::chrono::duration<double>(now - last_).count());
+        last_ = now;
+    }
+    tokens_ -= static_cast<double>(bytes);
+    if (tokens_ >= 0) {
+        return Clock::duration::zero();
+    }
+    auto wait = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(-tokens_ / rate));
+    throttled_ += wait;
+    return wait;
+}
+
+void RateLimiter::acquire(uint64_t bytes) {
+    if (rate() == 0) {
+        return;
+    }
+    auto wait = reserve(bytes, Clock::now());
+    if (wait > Clock::duration::zero()) {
+        ScopedSpan span("rate limit", "io", bytes);
+        std::this_thread::sleep_for(wait);
+    }
+}
+
+RateLimiter::Clock::duration RateLimiter::throttled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return throttled_;
+}
+
+bool enter_background_mode(std::string& detail) {
+#ifdef _WIN32
+    if (!SetPriorityClass(GetCurrentProcess(), PROCESS_MODE_BACKGROUND_BEGIN)) {
+        detail = "SetPriorityClass failed (error " + std::to_string(GetLastError()) + ")";
+        return false;
+    }
+    detail = "background processing mode";
+    return true;
+#elif defined(__APPLE__)
+    if (setpriority(PRIO_DARWIN_PROCESS, 0, PRIO_DARWIN_BG) != 0) {
+        detail = std::string("setpriority failed: ") + std::strerror(errno);
+        return false;
+    }
+    detail = "Darwin background band";
+    return true;
+#else
+    bool lowered = false;
+    detail.clear();
+    if (setpriority(PRIO_PROCESS, 0, 19) == 0) {
+        detail = "nice 19";
+        lowered = true;
+    } else {
+        detail = std::string("nice failed: ") + std::strerror(errno);
+    }
+#ifdef __linux__
+    if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT) == 0) {
+        detail += ", idle I/O class";
+        lowered = true;
+    } else {
+        detail += std::string(", ioprio_set failed: ") + std::strerror(errno);
+    }
+#endif
+    return lowered;
+#endif
+}
+
+} // namespace utils
+} // namespace filevault
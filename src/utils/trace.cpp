@@ -0,0 +1,106 @@
+/**
+ * @file trace.cpp
+ * @brief Span collection and Chrome trace-event output
+ */
+
+#include "filevault/utils/trace.hpp"
+#include <nlohmann/json.hpp>
+#include <fstream>
+
+#ifdef _WIN32
+#include <process.h>
+#define FILEVAULT_GETPID _getpid
+#else
+#include <unistd.h>
+#define FILEVAULT_GETPID getpid
+#endif
+
+namespace filevault {
+namespace utils {
+
+namespace {
+
+// Small sequential thread ids read better in trace viewers than native ones
+uint32_t current_thread_index() {
+    static std::atomic<uint32_t> next{1};
+    thread_local uint32_t index = next.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+} // anonymous namespace
+
+Tracer& Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+void Tracer::start() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        spans_.clear();
+        epoch_ = std::chrono::steady_clock::now();
+    }
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::stop() {
+    enabled_.store(false, std::memory_order_relaxed);
+}
+
+void Tracer::record(const char* name, const char* category,
+                    std::chrono::steady_clock::time_point start,
+                    std::chrono::steady_clock::time_point end, uint64_t bytes,
+                    AllocCounters allocs) {
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    uint32_t thread = current_thread_index();
+    std::lock_guard<std::mutex> lock(mutex_);
+    spans_.push_back({name, category, thread,
+                      duration_cast<microseconds>(start - epoch_).count(),
+                      duration_cast<microseconds>(end - start).count(),
+                      bytes, allocs});
+}
+
+std::vector<Tracer::Span> Tracer::spans() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return spans_;
+}
+
+bool Tracer::write(const std::string& path) const {
+    auto recorded = spans();
+    int pid = static_cast<int>(FILEVAULT_GETPID());
+
+    nlohmann::json events = nlohmann::json::array();
+    for (const auto& span : recorded) {
+        // "X" = complete event: start and duration in microseconds
+        nlohmann::json event = {
+            {"name", span.name},
+            {"cat", span.category},
+            {"ph", "X"},
+            {"ts", span.start_us},
+            {"dur", span.duration_us},
+            {"pid", pid},
+            {"tid", span.thread}
+        };
+        if (span.bytes > 0) {
+            event["args"]["bytes"] = span.bytes;
+        }
+        if (span.allocs.allocations > 0) {
+            event["args"]["allocations"] = span.allocs.allocations;
+            event["args"]["alloc_bytes"] = span.allocs.bytes;
+        }
+        events.push_back(std::move(event));
+    }
+
+    std::ofstream file(path);
+    if (!file) {
+        return false;
+    }
+    nlohmann::json trace = {{"traceEvents", std::move(events)}, {"displayTimeUnit", "ms"}};
+    file << trace.dump();
+    return static_cast<bool>(file);
+}
+
+} // namespace utils
+} // namespace filevault
@@ -0,0 +1,164 @@
+/**
+ * @file fuse_mount.cpp
+ * @brief Expose a volume's decrypted contents as a file through FUSE 3
+ */
+
+#include "filevault/volume/fuse_mount.hpp"
+#include "filevault/volume/volume.hpp"
+
+#ifdef FILEVAULT_HAVE_FUSE
+#define FUSE_USE_VERSION 31
+#include <fuse.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <vector>
+#endif
+
+namespace filevault {
+namespace volume {
+
+#ifdef FILEVAULT_HAVE_FUSE
+
+namespace {
+
+constexpr const char* FILE_PATH = "/volume";
+
+Volume& current_volume() {
+    return *static_cast<Volume*>(fuse_get_context()->private_data);
+}
+
+void* on_init(fuse_conn_info*, fuse_config* config) {
+    // The file only changes through this mount, so cached pages stay valid
+    config->kernel_cache = 1;
+    return fuse_get_context()->private_data;
+}
+
+int on_getattr(const char* path, struct stat* st, fuse_file_info*) {
+    std::memset(st, 0, sizeof(*st));
+    auto& volume = current_volume();
+    if (std::strcmp(path, "/") == 0) {
+        st->st_mode = S_IFDIR | 0700;
+        st->st_nlink = 2;
+    } else if (std::strcmp(path, FILE_PATH) == 0) {
+        st->st_mode = S_IFREG | (volume.read_only() ? 0400 : 0600);
+        st->st_nlink = 1;
+        st->st_size = static_cast<off_t>(volume.size());
+        st->st_blksize = static_cast<blksize_t>(volume.sector_size());
+    } else {
+        return -ENOENT;
+    }
+    st->st_uid = getuid();
+    st->st_gid = getgid();
+    st->st_mtime = st->st_ctime = st->st_atime = time(nullptr);
+    return 0;
+}
+
+int on_readdir(const char* path, void* buf, fuse_fill_dir_t fill, off_t, fuse_file_info*, fuse_readdir_flags) {
+    if (std::strcmp(path, "/") != 0) {
+        return -ENOENT;
+    }
+    fill(buf, ".", nullptr, 0, static_cast<fuse_fill_dir_flags>(0));
+    fill(buf, "..", nullptr, 0, static_cast<fuse_fill_dir_flags>(0));
+    fill(buf, FILE_PATH + 1, nullptr, 0, static_cast<fuse_fill_dir_flags>(0));
+    return 0;
+}
+
+int on_open(const char* path, fuse_file_info* fi) {
+    if (std::strcmp(path, FILE_PATH) != 0) {
+        return -ENOENT;
+    }
+    if ((fi->flags & O_ACCMODE) != O_RDONLY && current_volume().read_only()) {
+        return -EROFS;
+    }
+    return 0;
+}
+
+// Reads and writes past the end are clipped, as for a block device
+int on_read(const char*, char* buf, size_t size, off_t offset, fuse_file_info*) {
+    auto& volume = current_volume();
+    if (offset < 0 || static_cast<uint64_t>(offset) >= volume.size()) {
+        return 0;
+    }
+    size = static_cast<size_t>(std::min<uint64_t>(size, volume.size() - offset));
+    auto read = volume.read(static_cast<uint64_t>(offset), {reinterpret_cast<uint8_t*>(buf), size});
+    return read ? static_cast<int>(size) : -EIO;
+}
+
+int on_write(const char*, const char* buf, size_t size, off_t offset, fuse_file_info*) {
+    auto& volume = current_volume();
+    if (offset < 0 || static_cast<uint64_t>(offset) >= volume.size()) {
+        return -ENOSPC;
+    }
+    size = static_cast<size_t>(std::min<uint64_t>(size, volume.size() - offset));
+    auto written = volume.write(static_cast<uint64_t>(offset), {reinterpret_cast<const uint8_t*>(buf), size});
+    return written ? static_cast<int>(size) : -EIO;
+}
+
+int on_truncate(const char*, off_t size, fuse_file_info*) {
+    // The size is fixed; mkfs and loop devices only ever "truncate" to it
+    return static_cast<uint64_t>(size) == current_volume().size() ? 0 : -EPERM;
+}
+
+int on_fsync(const char*, int, fuse_file_info*) {
+    return current_volume().flush() ? 0 : -EIO;
+}
+
+int on_flush(const char*, fuse_file_info*) {
+    return current_volume().flush() ? 0 : -EIO;
+}
+
+} // anonymous namespace
+
+bool fuse_available() {
+    return true;
+}
+
+core::Result<void> mount_fuse(Volume& volume, const std::string& mountpoint, bool allow_other) {
+    fuse_operations ops{};
+    ops.init = on_init;
+    ops.getattr = on_getattr;
+    ops.readdir = on_readdir;
+    ops.open = on_open;
+    ops.read = on_read;
+    ops.write = on_write;
+    ops.truncate = on_truncate;
+    ops.fsync = on_fsync;
+    ops.flush = on_flush;
+
+    // Single-threaded: Volume serializes calls anyway
+    std::vector<std::string> args = {"filevault", "-f", "-s", "-o", "fsname=filevault,subtype=filevault"};
+    if (allow_other) {
+        args.insert(args.end(), {"-o", "allow_other"});
+    }
+    args.push_back(mountpoint);
+    std::vector<char*> argv;
+    for (auto& arg : args) {
+        argv.push_back(arg.data());
+    }
+
+    int status = fuse_main(static_cast<int>(argv.size()), argv.data(), &ops, &volume);
+    auto flushed = volume.flush();
+    if (status != 0) {
+        return core::Result<void>::error("FUSE mount of " + mountpoint + " failed");
+    }
+    return flushed;
+}
+
+#else
+
+bool fuse_available() {
+    return false;
+}
+
+core::Result<void> mount_fuse(Volume&, const std::string&, bool) {
+    return core::Result<void>::error("This build has no FUSE support (configure with -DENABLE_FUSE=ON)");
+}
+
+#endif // FILEVAULT_HAVE_FUSE
+
+} // namespace volume
+} // namespace filevault
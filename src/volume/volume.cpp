@@ -0,0 +1,628 @@
+/**
+ * @file volume.cpp
+ * @brief Encrypted sector container with a LUKS-style key slot
+ */
+
+#include "filevault/volume/volume.hpp"
+#include "filevault/core/crypto_engine.hpp"
+#include "filevault/core/random.hpp"
+#include "filevault/core/thread_pool.hpp"
+#include "filevault/utils/trace.hpp"
+#include <botan/mem_ops.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstring>
+#include <fmt/core.h>
+
+namespace filevault {
+namespace volume {
+
+namespace fs = std::filesystem;
+using algorithms::symmetric::XtsSectorCipher;
+
+namespace {
+
+// Header sector: "FVVL" | u8 version | u8 algorithm | u8 KDF | u8 security level
+//                | u32 sector size | u32 reserved | u64 sector count | u64 data offset
+//                | salt[32]                                   (the associated data)
+//                | nonce[12] | sealed master key[64] | tag[16] (the key slot)
+//                | zeros to HEADER_SIZE
+constexpr uint8_t MAGIC[4] = {'F', 'V', 'V', 'L'};
+constexpr uint8_t FORMAT_VERSION = 1;
+constexpr size_t SALT_SIZE = 32;
+constexpr size_t PREFIX_SIZE = 32 + SALT_SIZE;
+constexpr size_t NONCE_SIZE = 12;
+constexpr size_t MASTER_KEY_SIZE = 64;              // Both AES-256-XTS keys
+constexpr size_t TAG_SIZE = 16;
+constexpr size_t KEY_SLOT_SIZE = NONCE_SIZE + MASTER_KEY_SIZE + TAG_SIZE;
+constexpr core::AlgorithmType SLOT_ALGORITHM = core::AlgorithmType::AES_256_GCM;
+
+// Runs up to this long go through the cache; longer ones are streamed
+constexpr size_t CACHED_RUN_SECTORS = 8;
+
+// Ciphertext staged per write, enough to keep every XTS worker busy
+constexpr size_t WRITE_SLICE_BYTES = 4 * 1024 * 1024;
+
+void put_u32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+void put_u64(uint8_t* out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+uint32_t get_u32(const uint8_t* in) {
+    return uint32_t(in[0]) | uint32_t(in[1]) << 8 | uint32_t(in[2]) << 16 | uint32_t(in[3]) << 24;
+}
+
+uint64_t get_u64(const uint8_t* in) {
+    return uint64_t(get_u32(in)) | uint64_t(get_u32(in + 4)) << 32;
+}
+
+bool valid_sector_size(size_t size) {
+    return size >= XtsSectorCipher::MIN_SECTOR_SIZE && size <= XtsSectorCipher::MAX_SECTOR_SIZE &&
+           (size & (size - 1)) == 0;
+}
+
+} // anonymous namespace
+
+Volume::Volume(fs::path path)
+    : path_(std::move(path)) {}
+
+Volume::~Volume() {
+    if (unlocked() && !read_only_) {
+        auto flushed = flush();
+        if (!flushed) {
+            spdlog::warn("Volume {} not flushed on close: {}", path_.string(), flushed.error_message);
+        }
+    }
+}
+
+bool Volume::is_volume(const fs::path& path) {
+    auto head = utils::FileIO::read_range(path.string(), 0, sizeof(MAGIC));
+    return head && head.value.size() == sizeof(MAGIC) && std::memcmp(head.value.data(), MAGIC, sizeof(MAGIC)) == 0;
+}
+
+std::vector<uint8_t> Volume::header_prefix(const std::vector<uint8_t>& salt) const {
+    std::vector<uint8_t> prefix(PREFIX_SIZE, 0);
+    std::memcpy(prefix.data(), MAGIC, sizeof(MAGIC));
+    prefix[4] = FORMAT_VERSION;
+    prefix[5] = static_cast<uint8_t>(core::AlgorithmType::AES_256_XTS);
+    prefix[6] = static_cast<uint8_t>(config_.kdf);
+    prefix[7] = static_cast<uint8_t>(config_.level);
+    put_u32(&prefix[8], static_cast<uint32_t>(config_.sector_size));
+    put_u64(&prefix[16], sector_count_);
+    put_u64(&prefix[24], data_offset_);
+    std::copy(salt.begin(), salt.end(), prefix.begin() + 32);
+    return prefix;
+}
+
+std::vector<uint8_t> Volume::derive_slot_key(const std::string& password, const std::vector<uint8_t>& salt) const {
+    core::CryptoEngine engine;
+    engine.initialize();
+    core::EncryptionConfig config;
+    config.algorithm = SLOT_ALGORITHM;
+    config.kdf = config_.kdf;
+    config.level = config_.level;
+    config.apply_security_level();
+    return engine.derive_key(password, salt, config);
+}
+
+core::Result<std::vector<uint8_t>> Volume::seal_header(const std::string& password,
+                                                       const std::vector<uint8_t>& salt) const {
+    core::CryptoEngine engine;
+    engine.initialize();
+    auto* slot_cipher = engine.get_algorithm(SLOT_ALGORITHM);
+    if (!slot_cipher) {
+        return core::Result<std::vector<uint8_t>>::error("Algorithm not available");
+    }
+
+    auto header = header_prefix(salt);
+    auto slot_key = derive_slot_key(password, salt);
+    core::EncryptionConfig slot;
+    slot.nonce = core::CryptoEngine::generate_nonce(NONCE_SIZE);
+    slot.associated_data = header;
+    auto sealed = slot_cipher->encrypt(master_key_, slot_key, slot);
+    Botan::secure_scrub_memory(slot_key.data(), slot_key.size());
+    if (!sealed.success || !sealed.tag || sealed.data.size() != MASTER_KEY_SIZE) {
+        return core::Result<std::vector<uint8_t>>::error("Cannot seal the volume key: " + sealed.error_message);
+    }
+
+    header.insert(header.end(), slot.nonce->begin(), slot.nonce->end());
+    header.insert(header.end(), sealed.data.begin(), sealed.data.end());
+    header.insert(header.end(), sealed.tag->begin(), sealed.tag->end());
+    header.resize(HEADER_SIZE, 0);
+    return core::Result<std::vector<uint8_t>>::ok(std::move(header));
+}
+
+core::Result<void> Volume::create(const std::string& password, uint64_t volume_size, const VolumeConfig& config) {
+    std::error_code ec;
+    if (fs::exists(path_, ec)) {
+        return core::Result<void>::error("File already exists: " + path_.string());
+    }
+    if (!valid_sector_size(config.sector_size)) {
+        return core::Result<void>::error("Sector size must be a power of two from 512 to 65536 bytes");
+    }
+    if (volume_size == 0) {
+        return core::Result<void>::error("Volume size must be at least one sector");
+    }
+
+    config_ = config;
+    sector_count_ = (volume_size + config.sector_size - 1) / config.sector_size;
+    data_offset_ = std::max(HEADER_SIZE, config.sector_size);
+    master_key_.resize(MASTER_KEY_SIZE);
+    core::RandomService::rng().randomize(master_key_.data(), master_key_.size());
+
+    auto salt = core::CryptoEngine::generate_salt(SALT_SIZE);
+    auto header = seal_header(password, salt);
+    if (!header) {
+        return core::Result<void>::error(header.error_message);
+    }
+
+    // Sparse: only the header and written sectors take disk space
+    auto created = utils::RandomAccessFile::create(path_.string(), data_offset_ + size());
+    if (!created) {
+        return core::Result<void>::error(created.error_message);
+    }
+    auto written = created.value.write_at(0, header.value);
+    if (written) {
+        written = created.value.sync();
+    }
+    if (!written) {
+        created.value = utils::RandomAccessFile();
+        fs::remove(path_, ec);
+        return written;
+    }
+
+    salt_ = std::move(salt);
+    key_slot_.assign(header.value.begin() + PREFIX_SIZE, header.value.begin() + PREFIX_SIZE + KEY_SLOT_SIZE);
+    file_ = std::move(created.value);
+    cipher_ = std::make_unique<XtsSectorCipher>(master_key_, config_.sector_size);
+    read_only_ = false;
+    return core::Result<void>::ok();
+}
+
+core::Result<void> Volume::open() {
+    auto head = utils::FileIO::read_range(path_.string(), 0, HEADER_SIZE);
+    if (!head) {
+        return core::Result<void>::error("No volume at " + path_.string());
+    }
+    const auto& data = head.value;
+    if (data.size() < PREFIX_SIZE + KEY_SLOT_SIZE || std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0) {
+        return core::Result<void>::error("Not a volume: " + path_.string());
+    }
+    if (data[4] != FORMAT_VERSION) {
+        return core::Result<void>::error(fmt::format("Unsupported volume version {}", data[4]));
+    }
+
+    VolumeConfig config;
+    config.kdf = static_cast<core::KDFType>(data[6]);
+    config.level = static_cast<core::SecurityLevel>(data[7]);
+    config.sector_size = get_u32(&data[8]);
+    uint64_t sector_count = get_u64(&data[16]);
+    uint64_t data_offset = get_u64(&data[24]);
+    if (data[5] != static_cast<uint8_t>(core::AlgorithmType::AES_256_XTS) ||
+        !valid_sector_size(config.sector_size) ||
+        data_offset != std::max(HEADER_SIZE, config.sector_size) || sector_count == 0 ||
+        sector_count > (UINT64_MAX - data_offset) / config.sector_size) {
+        return core::Result<void>::error("Volume header is corrupt: " + path_.string());
+    }
+    std::error_code ec;
+    auto file_size = fs::file_size(path_, ec);
+    if (ec || file_size < data_offset + sector_count * config.sector_size) {
+        return core::Result<void>::error("Volume is truncated: " + path_.string());
+    }
+
+    config_ = config;
+    sector_count_ = sector_count;
+    data_offset_ = data_offset;
+    salt_.assign(data.begin() + 32, data.begin() + PREFIX_SIZE);
+    key_slot_.assign(data.begin() + PREFIX_SIZE, data.begin() + PREFIX_SIZE + KEY_SLOT_SIZE);
+    return core::Result<void>::ok();
+}
+
+core::Result<void> Volume::unlock(const std::string& password, bool read_only) {
+    auto opened = open();
+    if (!opened) {
+        return opened;
+    }
+
+    core::CryptoEngine engine;
+    engine.initialize();
+    auto* slot_cipher = engine.get_algorithm(SLOT_ALGORITHM);
+    if (!slot_cipher) {
+        return core::Result<void>::error("Algorithm not available");
+    }
+    auto slot_key = derive_slot_key(password, salt_);
+    core::EncryptionConfig slot;
+    slot.nonce = core::ShortBytes(key_slot_.begin(), key_slot_.begin() + NONCE_SIZE);
+    slot.tag = core::ShortBytes(key_slot_.end() - TAG_SIZE, key_slot_.end());
+    slot.associated_data = header_prefix(salt_);
+    auto opened_key = slot_cipher->decrypt(
+        std::span<const uint8_t>(key_slot_).subspan(NONCE_SIZE, MASTER_KEY_SIZE), slot_key, slot);
+    Botan::secure_scrub_memory(slot_key.data(), slot_key.size());
+    if (!opened_key.success || opened_key.data.size() != MASTER_KEY_SIZE) {
+        return core::Result<void>::error("Wrong password for volume (or the header was modified)");
+    }
+    core::SecureBytes master_key(opened_key.data.begin(), opened_key.data.end());
+    Botan::secure_scrub_memory(opened_key.data.data(), opened_key.data.size());
+
+    auto file = utils::RandomAccessFile::open(path_.string(), !read_only);
+    if (!file) {
+        return core::Result<void>::error(file.error_message);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    master_key_ = std::move(master_key);
+    file_ = std::move(file.value);
+    cipher_ = std::make_unique<XtsSectorCipher>(master_key_, config_.sector_size);
+    read_only_ = read_only;
+    lru_.clear();
+    index_.clear();
+    stats_ = {};
+    return core::Result<void>::ok();
+}
+
+core::Result<void> Volume::change_password(const std::string& new_password) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!unlocked() || read_only_) {
+        return core::Result<void>::error("Volume is not unlocked for writing");
+    }
+    auto salt = core::CryptoEngine::generate_salt(SALT_SIZE);
+    auto header = seal_header(new_password, salt);
+    if (!header) {
+        return core::Result<void>::error(header.error_message);
+    }
+    auto written = file_.write_at(0, header.value);
+    if (written) {
+        written = file_.sync();
+    }
+    if (!written) {
+        return written;
+    }
+    salt_ = std::move(salt);
+    key_slot_.assign(header.value.begin() + PREFIX_SIZE, header.value.begin() + PREFIX_SIZE + KEY_SLOT_SIZE);
+    return core::Result<void>::ok();
+}
+
+void Volume::set_cache_bytes(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_bytes_ = bytes;
+}
+
+void Volume::set_threads(size_t threads) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    threads_ = threads;
+    pool_.reset();
+}
+
+CacheStats Volume::cache_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+size_t Volume::cache_capacity() const {
+    return std::max<size_t>(1, cache_bytes_ / config_.sector_size);
+}
+
+core::ThreadPool* Volume::pool() {
+    if (!pool_) {
+        pool_ = std::make_unique<core::ThreadPool>(threads_);
+    }
+    return pool_.get();
+}
+
+core::Result<void> Volume::check_range(uint64_t offset, size_t bytes, bool writing) const {
+    if (!unlocked()) {
+        return core::Result<void>::error("Volume is locked");
+    }
+    if (writing && read_only_) {
+        return core::Result<void>::error("Volume is open read-only");
+    }
+    if (offset > size() || bytes > size() - offset) {
+        return core::Result<void>::error(fmt::format("Range {}+{} is beyond the end of the volume ({} bytes)",
+                                                     offset, bytes, size()));
+    }
+    return core::Result<void>::ok();
+}
+
+core::Result<void> Volume::read_direct(uint64_t first_sector, std::span<uint8_t> data) {
+    auto read = file_.read_at(data_offset_ + first_sector * config_.sector_size, data);
+    if (!read) {
+        return read;
+    }
+    cipher_->decrypt(first_sector, data, pool());
+    return core::Result<void>::ok();
+}
+
+core::Result<void> Volume::write_direct(uint64_t first_sector, std::span<const uint8_t> data) {
+    // Encrypt a copy slice by slice; the caller's plaintext is left alone
+    size_t slice_bytes = std::max(config_.sector_size, WRITE_SLICE_BYTES / config_.sector_size * config_.sector_size);
+    for (size_t offset = 0; offset < data.size(); offset += slice_bytes) {
+        auto slice = data.subspan(offset, std::min(slice_bytes, data.size() - offset));
+        uint64_t sector = first_sector + offset / config_.sector_size;
+        scratch_.assign(slice.begin(), slice.end());
+        cipher_->encrypt(sector, scratch_, pool());
+        auto written = file_.write_at(data_offset_ + sector * config_.sector_size, scratch_);
+        if (!written) {
+            return written;
+        }
+        stats_.sectors_written += slice.size() / config_.sector_size;
+    }
+    return core::Result<void>::ok();
+}
+
+core::Result<void> Volume::write_back() {
+    std::vector<CachedSector*> dirty;
+    for (auto& entry : lru_) {
+        if (entry.dirty) {
+            dirty.push_back(&entry);
+        }
+    }
+    if (dirty.empty()) {
+        return core::Result<void>::ok();
+    }
+    std::sort(dirty.begin(), dirty.end(),
+              [](const CachedSector* a, const CachedSector* b) { return a->sector < b->sector; });
+
+    // One encrypt and one write per run of adjacent sectors
+    size_t ss = config_.sector_size;
+    for (size_t begin = 0; begin < dirty.size();) {
+        size_t end = begin + 1;
+        while (end < dirty.size() && dirty[end]->sector == dirty[end - 1]->sector + 1 &&
+               (end - begin) * ss < WRITE_SLICE_BYTES) {
+            ++end;
+        }
+        scratch_.resize((end - begin) * ss);
+        for (size_t i = begin; i < end; ++i) {
+            std::memcpy(scratch_.data() + (i - begin) * ss, dirty[i]->data.data(), ss);
+        }
+        uint64_t first = dirty[begin]->sector;
+        cipher_->encrypt(first, scratch_, pool());
+        auto written = file_.write_at(data_offset_ + first * ss, scratch_);
+        if (!written) {
+            return written;
+        }
+        for (size_t i = begin; i < end; ++i) {
+            dirty[i]->dirty = false;
+        }
+        stats_.sectors_written += end - begin;
+        begin = end;
+    }
+    return core::Result<void>::ok();
+}
+
+core::Result<void> Volume::make_room() {
+    while (lru_.size() >= cache_capacity()) {
+        if (lru_.back().dirty) {
+            auto written = write_back();
+            if (!written) {
+                return written;
+            }
+        }
+        index_.erase(lru_.back().sector);
+        lru_.pop_back();
+    }
+    return core::Result<void>::ok();
+}
+
+core::Result<void> Volume::insert(uint64_t sector, std::span<const uint8_t> data, bool dirty) {
+    auto found = index_.find(sector);
+    if (found != index_.end()) {
+        std::copy(data.begin(), data.end(), found->second->data.begin());
+        found->second->dirty = found->second->dirty || dirty;
+        lru_.splice(lru_.begin(), lru_, found->second);
+        return core::Result<void>::ok();
+    }
+    auto room = make_room();
+    if (!room) {
+        return room;
+    }
+    lru_.push_front(CachedSector{sector, Botan::secure_vector<uint8_t>(data.begin(), data.end()), dirty});
+    index_[sector] = lru_.begin();
+    return core::Result<void>::ok();
+}
+
+core::Result<Volume::CacheList::iterator> Volume::load(uint64_t sector) {
+    auto found = index_.find(sector);
+    if (found != index_.end()) {
+        ++stats_.hits;
+        lru_.splice(lru_.begin(), lru_, found->second);
+        return core::Result<CacheList::iterator>::ok(lru_.begin());
+    }
+    ++stats_.misses;
+    Botan::secure_vector<uint8_t> plain(config_.sector_size);
+    auto read = read_direct(sector, plain);
+    if (!read) {
+        return core::Result<CacheList::iterator>::error(read.error_message);
+    }
+    auto inserted = insert(sector, plain, false);
+    if (!inserted) {
+        return core::Result<CacheList::iterator>::error(inserted.error_message);
+    }
+    return core::Result<CacheList::iterator>::ok(lru_.begin());
+}
+
+core::Result<void> Volume::read_locked(uint64_t first_sector, std::span<uint8_t> data) {
+    size_t ss = config_.sector_size;
+    size_t count = data.size() / ss;
+    for (size_t i = 0; i < count;) {
+        auto found = index_.find(first_sector + i);
+        if (found != index_.end()) {
+            ++stats_.hits;
+            std::copy(found->second->data.begin(), found->second->data.end(), data.begin() + i * ss);
+            lru_.splice(lru_.begin(), lru_, found->second);
+            ++i;
+            continue;
+        }
+
+        // Uncached sectors up to the next cached one are read in one go
+        size_t end = i + 1;
+        while (end < count && !index_.count(first_sector + end)) {
+            ++end;
+        }
+        stats_.misses += end - i;
+        auto run = data.subspan(i * ss, (end - i) * ss);
+        auto read = read_direct(first_sector + i, run);
+        if (!read) {
+            return read;
+        }
+        if (end - i <= CACHED_RUN_SECTORS) {
+            for (size_t k = i; k < end; ++k) {
+                auto inserted = insert(first_sector + k, data.subspan(k * ss, ss), false);
+                if (!inserted) {
+                    return inserted;
+                }
+            }
+        }
+        i = end;
+    }
+    return core::Result<void>::ok();
+}
+
+core::Result<void> Volume::write_locked(uint64_t first_sector, std::span<const uint8_t> data) {
+    size_t ss = config_.sector_size;
+    size_t count = data.size() / ss;
+    if (count <= CACHED_RUN_SECTORS) {
+        for (size_t i = 0; i < count; ++i) {
+            auto inserted = insert(first_sector + i, data.subspan(i * ss, ss), true);
+            if (!inserted) {
+                return inserted;
+            }
+        }
+        return core::Result<void>::ok();
+    }
+
+    // Cached copies are superseded by the new contents
+    for (size_t i = 0; i < count; ++i) {
+        auto found = index_.find(first_sector + i);
+        if (found != index_.end()) {
+            lru_.erase(found->second);
+            index_.erase(found);
+        }
+    }
+    return write_direct(first_sector, data);
+}
+
+core::Result<void> Volume::read_sectors(uint64_t first_sector, std::span<uint8_t> data) {
+    utils::ScopedSpan trace_span("Volume::read_sectors", "volume", data.size());
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (data.size() % config_.sector_size != 0) {
+        return core::Result<void>::error("Sector reads must be whole sectors");
+    }
+    if (first_sector > sector_count_) {
+        return core::Result<void>::error("Sector is beyond the end of the volume");
+    }
+    auto in_range = check_range(first_sector * config_.sector_size, data.size(), false);
+    if (!in_range) {
+        return in_range;
+    }
+    return read_locked(first_sector, data);
+}
+
+core::Result<void> Volume::write_sectors(uint64_t first_sector, std::span<const uint8_t> data) {
+    utils::ScopedSpan trace_span("Volume::write_sectors", "volume", data.size());
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (data.size() % config_.sector_size != 0) {
+        return core::Result<void>::error("Sector writes must be whole sectors");
+    }
+    if (first_sector > sector_count_) {
+        return core::Result<void>::error("Sector is beyond the end of the volume");
+    }
+    auto in_range = check_range(first_sector * config_.sector_size, data.size(), true);
+    if (!in_range) {
+        return in_range;
+    }
+    return write_locked(first_sector, data);
+}
+
+core::Result<void> Volume::read(uint64_t offset, std::span<uint8_t> data) {
+    utils::ScopedSpan trace_span("Volume::read", "volume", data.size());
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto in_range = check_range(offset, data.size(), false);
+    if (!in_range) {
+        return in_range;
+    }
+
+    size_t ss = config_.sector_size;
+    size_t done = 0;
+    while (done < data.size()) {
+        uint64_t position = offset + done;
+        uint64_t sector = position / ss;
+        size_t within = position % ss;
+        size_t remaining = data.size() - done;
+        if (within == 0 && remaining >= ss) {
+            size_t whole = remaining / ss * ss;
+            auto read = read_locked(sector, data.subspan(done, whole));
+            if (!read) {
+                return read;
+            }
+            done += whole;
+            continue;
+        }
+        auto entry = load(sector);
+        if (!entry) {
+            return core::Result<void>::error(entry.error_message);
+        }
+        size_t part = std::min(ss - within, remaining);
+        std::memcpy(data.data() + done, entry.value->data.data() + within, part);
+        done += part;
+    }
+    return core::Result<void>::ok();
+}
+
+core::Result<void> Volume::write(uint64_t offset, std::span<const uint8_t> data) {
+    utils::ScopedSpan trace_span("Volume::write", "volume", data.size());
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto in_range = check_range(offset, data.size(), true);
+    if (!in_range) {
+        return in_range;
+    }
+
+    size_t ss = config_.sector_size;
+    size_t done = 0;
+    while (done < data.size()) {
+        uint64_t position = offset + done;
+        uint64_t sector = position / ss;
+        size_t within = position % ss;
+        size_t remaining = data.size() - done;
+        if (within == 0 && remaining >= ss) {
+            size_t whole = remaining / ss * ss;
+            auto written = write_locked(sector, data.subspan(done, whole));
+            if (!written) {
+                return written;
+            }
+            done += whole;
+            continue;
+        }
+        // Partly covered sector: patch the cached plaintext
+        auto entry = load(sector);
+        if (!entry) {
+            return core::Result<void>::error(entry.error_message);
+        }
+        size_t part = std::min(ss - within, remaining);
+        std::memcpy(entry.value->data.data() + within, data.data() + done, part);
+        entry.value->dirty = true;
+        done += part;
+    }
+    return core::Result<void>::ok();
+}
+
+core::Result<void> Volume::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!unlocked() || read_only_) {
+        return core::Result<void>::ok();
+    }
+    auto written = write_back();
+    if (!written) {
+        return written;
+    }
+    return file_.sync();
+}
+
+} // namespace volume
+} // namespace filevault
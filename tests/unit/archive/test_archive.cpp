@@ -7,8 +7,17 @@
 
 #include <catch2/catch_test_macros.hpp>
 #include "filevault/archive/archive_format.hpp"
+#include "filevault/archive/archive_mount.hpp"
+#include "filevault/archive/directory_walker.hpp"
+#include "filevault/archive/incremental.hpp"
+#include "filevault/archive/tar_stream.hpp"
 #include <filesystem>
 #include <fstream>
+#include <algorithm>
+#include <iterator>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
 #include <vector>
 #include <string>
 
@@ -348,6 +357,735 @@ TEST_CASE("Archive Error Handling", "[archive][errors]") {
     TestFileHelper::cleanup();
 }
 
+// ===========================================
+// Streaming Source and Sink Tests
+// ===========================================
+TEST_CASE("Archive Streaming", "[archive][stream]") {
+    TestFileHelper::setup();
+    
+    std::vector<fs::path> files = {
+        TestFileHelper::create_test_file("one.txt", "First member"),
+        TestFileHelper::create_test_file("empty.txt", ""),
+        TestFileHelper::create_test_file("two.txt", std::string(5000, 'z')),
+    };
+    auto expected = ArchiveFormat::create_archive(files);
+    
+    SECTION("Source yields the same bytes as create_archive") {
+        ArchiveSource source(files);
+        REQUIRE(source.size() == expected.size());
+        REQUIRE(source.entries().size() == 3);
+        
+        std::istream in(&source);
+        std::vector<uint8_t> streamed(std::istreambuf_iterator<char>(in), {});
+        REQUIRE(streamed == expected);
+    }
+    
+    SECTION("Source supports seeking") {
+        ArchiveSource source(files);
+        std::istream in(&source);
+        
+        // The hashes of one.txt and two.txt follow the data
+        in.seekg(-10 - 2 * 32, std::ios::end);
+        REQUIRE(static_cast<uint64_t>(in.tellg()) == expected.size() - 74);
+        std::string tail(10, '\0');
+        in.read(tail.data(), 10);
+        REQUIRE(tail == std::string(10, 'z'));
+        
+        in.seekg(0);
+        std::string magic(6, '\0');
+        in.read(magic.data(), 6);
+        REQUIRE(magic == "FVARCH");
+    }
+    
+    SECTION("Source fails when a member shrinks") {
+        ArchiveSource source(files);
+        TestFileHelper::create_test_file("two.txt", "short");
+        
+        std::istream in(&source);
+        std::vector<char> buffer(expected.size());
+        in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        REQUIRE_FALSE(in);
+        REQUIRE(source.error().find("two.txt") != std::string::npos);
+    }
+    
+    SECTION("Sink extracts data written in pieces") {
+        fs::path extract_dir = fs::path(TestFileHelper::test_dir) / "sink";
+        ArchiveSink sink(extract_dir);
+        std::ostream out(&sink);
+        for (size_t i = 0; i < expected.size(); i += 7) {
+            size_t n = std::min<size_t>(7, expected.size() - i);
+            out.write(reinterpret_cast<const char*>(&expected[i]), static_cast<std::streamsize>(n));
+        }
+        REQUIRE(out);
+        REQUIRE(sink.finish());
+        REQUIRE(sink.entries().size() == 3);
+        REQUIRE(TestFileHelper::read_file(extract_dir / "one.txt") == "First member");
+        REQUIRE(fs::exists(extract_dir / "empty.txt"));
+        REQUIRE(TestFileHelper::read_file(extract_dir / "two.txt") == std::string(5000, 'z'));
+    }
+    
+    SECTION("Sink rejects truncated and invalid archives") {
+        fs::path extract_dir = fs::path(TestFileHelper::test_dir) / "sink_bad";
+        {
+            ArchiveSink sink(extract_dir);
+            std::ostream out(&sink);
+            out.write(reinterpret_cast<const char*>(expected.data()),
+                      static_cast<std::streamsize>(expected.size() - 1));
+            REQUIRE_FALSE(sink.finish());
+        }
+        {
+            ArchiveSink sink(extract_dir);
+            std::ostream out(&sink);
+            out.write("GARBAGE-DATA", 12);
+            REQUIRE_FALSE(out);
+            REQUIRE_FALSE(sink.finish());
+        }
+    }
+    
+    SECTION("Padded segments extract one after another") {
+        ArchiveSource first(files);
+        first.pad_to(4096);
+        REQUIRE(first.size() % 4096 == 0);
+        std::istream first_in(&first);
+        std::vector<uint8_t> bytes(std::istreambuf_iterator<char>(first_in), {});
+        REQUIRE(bytes.size() == first.size());
+        REQUIRE(bytes[6] == ArchiveFormat::APPENDABLE_VERSION);
+        REQUIRE(std::all_of(bytes.begin() + static_cast<std::ptrdiff_t>(expected.size()), bytes.end(),
+                            [](uint8_t byte) { return byte == 0; }));
+        
+        // The second segment replaces one.txt and ends in an empty member
+        fs::create_directories(fs::path(TestFileHelper::test_dir) / "later");
+        std::vector<fs::path> later = {
+            TestFileHelper::create_test_file("later/one.txt", "Second version"),
+            TestFileHelper::create_test_file("later/new.txt", ""),
+        };
+        ArchiveSource second(later);
+        second.pad_to(4096);
+        std::istream second_in(&second);
+        bytes.insert(bytes.end(), std::istreambuf_iterator<char>(second_in), {});
+        
+        fs::path extract_dir = fs::path(TestFileHelper::test_dir) / "segments";
+        ArchiveSink sink(extract_dir);
+        std::ostream out(&sink);
+        for (size_t i = 0; i < bytes.size(); i += 1000) {
+            size_t n = std::min<size_t>(1000, bytes.size() - i);
+            out.write(reinterpret_cast<const char*>(&bytes[i]), static_cast<std::streamsize>(n));
+        }
+        REQUIRE(out);
+        REQUIRE(sink.finish());
+        REQUIRE(sink.entries().size() == 5);
+        REQUIRE(sink.header().version == ArchiveFormat::APPENDABLE_VERSION);
+        REQUIRE(TestFileHelper::read_file(extract_dir / "one.txt") == "Second version");
+        REQUIRE(TestFileHelper::read_file(extract_dir / "two.txt") == std::string(5000, 'z'));
+        REQUIRE(fs::exists(extract_dir / "new.txt"));
+        
+        // Unpadded archives end at their last member
+        ArchiveSink closed(extract_dir);
+        std::ostream closed_out(&closed);
+        closed_out.write(reinterpret_cast<const char*>(expected.data()), static_cast<std::streamsize>(expected.size()));
+        closed_out.write(reinterpret_cast<const char*>(expected.data()), static_cast<std::streamsize>(expected.size()));
+        REQUIRE_FALSE(closed_out);
+        REQUIRE(closed.error().find("past the end") != std::string::npos);
+    }
+    
+    TestFileHelper::cleanup();
+}
+
+// ===========================================
+// Tar Stream Tests
+// ===========================================
+TEST_CASE("Tar Streams", "[archive][tar]") {
+    // Members with names for each ustar form: plain, prefix-split and pax
+    std::vector<std::pair<std::string, std::string>> members = {
+        {"short.txt", "Short member"},
+        {"empty", ""},
+        {"deep/" + std::string(120, 'd') + "/name.txt", std::string(700, 'p')},
+        {std::string(150, 'a') + "/" + std::string(150, 'b') + "/long.txt", "Named by pax"},
+        {"big.bin", std::string(20000, 'B')},
+        {"after.txt", "After the streamed member"},
+    };
+    std::vector<FileEntry> entries;
+    std::string data;
+    for (const auto& [name, contents] : members) {
+        FileEntry entry;
+        entry.filename = name;
+        entry.file_size = contents.size();
+        entry.offset = data.size();
+        entry.modified_time = 1700000000;
+        entry.permissions = 0640;
+        entries.push_back(entry);
+        data += contents;
+    }
+    auto table = ArchiveFormat::serialize_table(entries);
+    std::string archive(table.begin(), table.end());
+    archive += data;
+    
+    auto export_tar = [](const std::string& bytes, std::string& error) {
+        std::ostringstream tar;
+        TarSink sink(tar);
+        std::ostream out(&sink);
+        for (size_t i = 0; i < bytes.size(); i += 999) {
+            out.write(bytes.data() + i, static_cast<std::streamsize>(std::min<size_t>(999, bytes.size() - i)));
+        }
+        bool ok = static_cast<bool>(out) && sink.finish();
+        error = sink.error();
+        return ok ? tar.str() : std::string();
+    };
+    std::string error;
+    auto tar = export_tar(archive, error);
+    REQUIRE(error.empty());
+    REQUIRE(tar.size() % 512 == 0);
+    REQUIRE(tar.find("path=" + members[3].first + "\n") != std::string::npos);
+    
+    SECTION("Tar to archive and back gives the same tar") {
+        std::istringstream in(tar);
+        TarSource source(in, 4096, 8192);
+        std::istream archive_in(&source);
+        std::string ingested(std::istreambuf_iterator<char>(archive_in), {});
+        REQUIRE(source.error().empty());
+        REQUIRE(ingested.size() % 4096 == 0);
+        REQUIRE(source.member_count() == members.size());
+        REQUIRE(source.member_bytes() == data.size());
+        REQUIRE(source.segments() == 3);   // Before, for and after big.bin
+        REQUIRE(static_cast<uint8_t>(ingested[6]) == ArchiveFormat::APPENDABLE_VERSION);
+        
+        REQUIRE(export_tar(ingested, error) == tar);
+    }
+    
+    SECTION("Links are skipped") {
+        std::string link(512, '\0');
+        std::memcpy(link.data(), "link", 4);
+        std::memcpy(link.data() + 100, "0000777", 7);
+        std::memcpy(link.data() + 124, "00000000000", 11);
+        std::memcpy(link.data() + 136, "14540000000", 11);
+        link[156] = '2';
+        std::memcpy(link.data() + 157, "short.txt", 9);
+        std::memcpy(link.data() + 257, "ustar\0" "00", 8);
+        std::memset(link.data() + 148, ' ', 8);
+        unsigned sum = 0;
+        for (char c : link) {
+            sum += static_cast<unsigned char>(c);
+        }
+        std::snprintf(link.data() + 148, 8, "%06o", sum);
+        
+        std::istringstream in(link + tar);
+        TarSource source(in, 4096);
+        std::istream archive_in(&source);
+        std::string ingested(std::istreambuf_iterator<char>(archive_in), {});
+        REQUIRE(source.error().empty());
+        REQUIRE(source.skipped() == std::vector<std::string>{"link"});
+        REQUIRE(source.segments() == 1);
+        REQUIRE(export_tar(ingested, error) == tar);
+    }
+    
+    SECTION("An empty tar is an empty archive") {
+        std::istringstream in(std::string(1024, '\0'));
+        TarSource source(in, 4096);
+        std::istream archive_in(&source);
+        std::string ingested(std::istreambuf_iterator<char>(archive_in), {});
+        REQUIRE(ingested.size() == 4096);
+        REQUIRE(export_tar(ingested, error) == std::string(1024, '\0'));
+    }
+    
+    SECTION("Malformed tars fail the read") {
+        std::string corrupt = tar;
+        corrupt[0] ^= 1;
+        std::string truncated = tar.substr(0, 1000);
+        for (const auto& bad : {corrupt, truncated}) {
+            std::istringstream in(bad);
+            TarSource source(in, 4096);
+            std::istream archive_in(&source);
+            std::vector<char> buffer(4096);
+            while (archive_in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()))) {
+            }
+            REQUIRE(archive_in.bad());
+            REQUIRE_FALSE(source.error().empty());
+        }
+    }
+    
+    SECTION("Truncated archives are not exported") {
+        REQUIRE(export_tar(archive.substr(0, archive.size() - 1), error).empty());
+        REQUIRE(error == "Truncated archive");
+    }
+}
+
+// ===========================================
+// Deduplication Tests
+// ===========================================
+TEST_CASE("Archive Deduplication", "[archive][dedup]") {
+    TestFileHelper::setup();
+    
+    std::string repeated(5000, 'r');
+    std::vector<fs::path> files = {
+        TestFileHelper::create_test_file("first.txt", repeated),
+        TestFileHelper::create_test_file("other.txt", "Unique"),
+        TestFileHelper::create_test_file("copy.txt", repeated),
+        TestFileHelper::create_test_file("empty1.txt", ""),
+        TestFileHelper::create_test_file("empty2.txt", ""),
+        TestFileHelper::create_test_file("last.txt", repeated),
+    };
+    ArchiveSource source(files);
+    REQUIRE(source.shared_count() == 2);
+    REQUIRE(source.shared_bytes() == 2 * repeated.size());
+    auto archive = ArchiveFormat::create_archive(files);
+    REQUIRE(archive.size() < 2 * repeated.size());
+    
+    auto check = [&](const fs::path& dir) {
+        REQUIRE(TestFileHelper::read_file(dir / "first.txt") == repeated);
+        REQUIRE(TestFileHelper::read_file(dir / "copy.txt") == repeated);
+        REQUIRE(TestFileHelper::read_file(dir / "last.txt") == repeated);
+        REQUIRE(TestFileHelper::read_file(dir / "other.txt") == "Unique");
+        REQUIRE(fs::exists(dir / "empty2.txt"));
+    };
+    
+    SECTION("Duplicates point at the first copy") {
+        auto entries = ArchiveFormat::list_files(archive);
+        REQUIRE(entries.size() == 6);
+        REQUIRE_FALSE(entries[0].shared);
+        REQUIRE(entries[2].shared);
+        REQUIRE(entries[2].offset == entries[0].offset);
+        REQUIRE(entries[2].stored_size() == 0);
+        REQUIRE(entries[5].shared);
+        REQUIRE_FALSE(entries[4].shared);   // Empty files have nothing to share
+        
+        fs::path extract_dir = fs::path(TestFileHelper::test_dir) / "buffer";
+        REQUIRE(ArchiveFormat::extract_archive(archive, extract_dir));
+        check(extract_dir);
+    }
+    
+    SECTION("Sink copies shared members") {
+        for (size_t threads : {size_t(1), size_t(4)}) {
+            fs::path extract_dir = fs::path(TestFileHelper::test_dir) / ("sink" + std::to_string(threads));
+            ExtractOptions options;
+            options.threads = threads;
+            ArchiveSink sink(extract_dir, options);
+            std::ostream out(&sink);
+            for (size_t i = 0; i < archive.size(); i += 1000) {
+                size_t n = std::min<size_t>(1000, archive.size() - i);
+                out.write(reinterpret_cast<const char*>(&archive[i]), static_cast<std::streamsize>(n));
+            }
+            REQUIRE(out);
+            REQUIRE(sink.finish());
+            check(extract_dir);
+        }
+    }
+    
+    SECTION("Tar export links shared members, and ingest shares them again") {
+        std::ostringstream tar;
+        TarSink sink(tar);
+        std::ostream out(&sink);
+        out.write(reinterpret_cast<const char*>(archive.data()), static_cast<std::streamsize>(archive.size()));
+        REQUIRE(sink.finish());
+        std::string exported = tar.str();
+        REQUIRE(exported.size() < 2 * repeated.size());
+        
+        std::istringstream in(exported);
+        TarSource ingest(in, 0);
+        std::istream archive_in(&ingest);
+        std::vector<uint8_t> ingested(std::istreambuf_iterator<char>(archive_in), {});
+        REQUIRE(ingest.skipped().empty());
+        auto entries = ArchiveFormat::list_files(ingested);
+        REQUIRE(entries.size() == 6);
+        REQUIRE(entries[2].shared);
+        REQUIRE(entries[5].shared);
+        
+        fs::path extract_dir = fs::path(TestFileHelper::test_dir) / "tar";
+        REQUIRE(ArchiveFormat::extract_archive(ingested, extract_dir));
+        check(extract_dir);
+    }
+    
+    SECTION("Shared members must point into stored data") {
+        std::vector<FileEntry> entries(2);
+        entries[0].filename = "a";
+        entries[0].file_size = 10;
+        entries[1].filename = "b";
+        entries[1].file_size = 10;
+        entries[1].offset = 5;
+        entries[1].shared = true;
+        auto table = ArchiveFormat::serialize_table(entries);
+        
+        ArchiveHeader header;
+        std::string error;
+        REQUIRE(ArchiveFormat::parse_header(table, header, error));
+        size_t offset = header.size;
+        std::vector<FileEntry> parsed;
+        REQUIRE_FALSE(ArchiveFormat::parse_entries(table, offset, header, parsed, error));
+        REQUIRE(error.find("Shared member") != std::string::npos);
+    }
+    
+    TestFileHelper::cleanup();
+}
+
+TEST_CASE("Member Hashes Computed While Archiving", "[archive][digest]") {
+    TestFileHelper::setup();
+    
+    std::vector<fs::path> files = {
+        TestFileHelper::create_test_file("alpha.txt", "alpha"),
+        TestFileHelper::create_test_file("bravo.txt", "bravo!"),
+        TestFileHelper::create_test_file("same1.txt", "same contents"),
+        TestFileHelper::create_test_file("same2.txt", "same contents"),
+        TestFileHelper::create_test_file("empty.txt", ""),
+    };
+    auto hash_of = [](const std::string& text) {
+        return ArchiveFormat::hash_bytes(std::span<const uint8_t>(
+            reinterpret_cast<const uint8_t*>(text.data()), text.size()));
+    };
+    auto extract = [](const std::vector<uint8_t>& archive, const fs::path& dir, ExtractOptions options) {
+        auto sink = std::make_unique<ArchiveSink>(dir, options);
+        std::ostream out(sink.get());
+        out.write(reinterpret_cast<const char*>(archive.data()), static_cast<std::streamsize>(archive.size()));
+        return sink;
+    };
+    
+    // Only the members of equal size are hashed before reading
+    ArchiveSource source(files);
+    REQUIRE(source.entries()[0].digest_after);
+    REQUIRE(source.entries()[1].digest_after);
+    REQUIRE_FALSE(source.entries()[2].digest_after);
+    REQUIRE(source.entries()[3].shared);
+    REQUIRE_FALSE(source.entries()[4].digest_after);
+    REQUIRE(source.size() == ArchiveFormat::create_archive(files).size());
+    
+    std::istream in(&source);
+    std::vector<uint8_t> archive(std::istreambuf_iterator<char>(in), {});
+    REQUIRE(archive.size() == source.size());
+    REQUIRE(source.entries()[0].content_hash == hash_of("alpha"));
+    REQUIRE(source.entries()[1].content_hash == hash_of("bravo!"));
+    
+    SECTION("Hashes follow the data in table order") {
+        auto alpha = hash_of("alpha");
+        REQUIRE(std::equal(alpha.begin(), alpha.end(), archive.end() - 64));
+        auto listed = ArchiveFormat::list_files(archive);
+        REQUIRE(listed.size() == files.size());
+        REQUIRE(listed[1].content_hash == hash_of("bravo!"));
+        REQUIRE(listed[2].content_hash == hash_of("same contents"));
+    }
+    
+    SECTION("A member read out of order is hashed again") {
+        ArchiveSource seeking(files);
+        std::istream seeking_in(&seeking);
+        seeking_in.seekg(static_cast<std::streamoff>(seeking.size() - 64));
+        std::vector<uint8_t> digests(std::istreambuf_iterator<char>(seeking_in), {});
+        REQUIRE(std::equal(digests.begin(), digests.end(), archive.end() - 64));
+    }
+    
+    SECTION("Extraction checks every member") {
+        fs::path dir = fs::path(TestFileHelper::test_dir) / "verified";
+        ExtractOptions options;
+        options.verify = true;
+        auto sink = extract(archive, dir, options);
+        REQUIRE(sink->finish());
+        REQUIRE(sink->verified() == 4);   // All but the shared copy
+        REQUIRE(sink->entries()[0].content_hash == hash_of("alpha"));
+        REQUIRE(TestFileHelper::read_file(dir / "same2.txt") == "same contents");
+    }
+    
+    SECTION("Checking writes nothing") {
+        fs::path dir = fs::path(TestFileHelper::test_dir) / "checked";
+        ExtractOptions options;
+        options.verify = true;
+        options.check_only = true;
+        auto sink = extract(archive, dir, options);
+        REQUIRE(sink->finish());
+        REQUIRE(sink->verified() == 4);
+        REQUIRE_FALSE(fs::exists(dir));
+    }
+    
+    SECTION("A hash that does not match fails") {
+        auto corrupt = archive;
+        corrupt.back() ^= 0x01;
+        ExtractOptions options;
+        options.verify = true;
+        options.check_only = true;
+        auto sink = extract(corrupt, {}, options);
+        REQUIRE_FALSE(sink->finish());
+        REQUIRE(sink->error() == "Member does not match its content hash: bravo.txt");
+        
+        // Unchecked extraction takes the hashes as they are
+        auto unchecked = extract(corrupt, fs::path(TestFileHelper::test_dir) / "unchecked", {});
+        REQUIRE(unchecked->finish());
+    }
+    
+    SECTION("Missing hashes truncate the archive") {
+        std::vector<uint8_t> truncated(archive.begin(), archive.end() - 1);
+        auto sink = extract(truncated, fs::path(TestFileHelper::test_dir) / "truncated", {});
+        REQUIRE_FALSE(sink->finish());
+        REQUIRE(sink->error() == "Truncated archive");
+    }
+    
+    SECTION("Tar export skips the hashes") {
+        std::ostringstream tar;
+        TarSink sink(tar);
+        std::ostream out(&sink);
+        out.write(reinterpret_cast<const char*>(archive.data()), static_cast<std::streamsize>(archive.size()));
+        REQUIRE(sink.finish());
+        REQUIRE(sink.entries().size() == files.size());
+    }
+    
+    SECTION("Planning hashes only possible duplicates") {
+        std::vector<ArchiveMember> members;
+        for (const auto& file : files) {
+            members.push_back({file, ArchiveFormat::make_entry(file, 0)});
+        }
+        REQUIRE(IncrementalPlanner::hash_candidates(members).empty());
+        REQUIRE_FALSE(members[0].entry.has_hash());
+        REQUIRE(members[2].entry.content_hash == hash_of("same contents"));
+        REQUIRE(members[3].entry.content_hash == hash_of("same contents"));
+    }
+    
+    TestFileHelper::cleanup();
+}
+
+TEST_CASE("Parallel Archive Extraction", "[archive][parallel]") {
+    TestFileHelper::setup();
+    
+    std::vector<fs::path> files;
+    for (int i = 0; i < 50; ++i) {
+        files.push_back(TestFileHelper::create_test_file(
+            "small" + std::to_string(i) + ".txt", std::string(100 + i, static_cast<char>('a' + i % 26))));
+    }
+    files.push_back(TestFileHelper::create_test_file("empty.txt", ""));
+    files.push_back(TestFileHelper::create_test_file("large.bin", std::string(3 * 1024 * 1024, 'L')));
+    
+    // Same name twice: the later member must win
+    fs::create_directories(fs::path(TestFileHelper::test_dir) / "other");
+    files.push_back(TestFileHelper::create_test_file("small0.txt", "first"));
+    files.push_back(TestFileHelper::create_test_file("other/small0.txt", "second"));
+    auto archive = ArchiveFormat::create_archive(files);
+    
+    auto check = [](const fs::path& dir) {
+        for (int i = 1; i < 50; ++i) {
+            REQUIRE(TestFileHelper::read_file(dir / ("small" + std::to_string(i) + ".txt")) ==
+                    std::string(100 + i, static_cast<char>('a' + i % 26)));
+        }
+        REQUIRE(TestFileHelper::read_file(dir / "small0.txt") == "second");
+        REQUIRE(fs::file_size(dir / "empty.txt") == 0);
+        REQUIRE(TestFileHelper::read_file(dir / "large.bin") == std::string(3 * 1024 * 1024, 'L'));
+    };
+    
+    ExtractOptions options;
+    options.threads = 4;
+    options.preallocate = true;
+    
+    SECTION("Sink writes members from a pool") {
+        fs::path extract_dir = fs::path(TestFileHelper::test_dir) / "sink";
+        ArchiveSink sink(extract_dir, options);
+        std::ostream out(&sink);
+        for (size_t i = 0; i < archive.size(); i += 4096) {
+            size_t n = std::min<size_t>(4096, archive.size() - i);
+            out.write(reinterpret_cast<const char*>(&archive[i]), static_cast<std::streamsize>(n));
+        }
+        REQUIRE(out);
+        REQUIRE(sink.finish());
+        check(extract_dir);
+    }
+    
+    SECTION("extract_archive writes members from a pool") {
+        fs::path extract_dir = fs::path(TestFileHelper::test_dir) / "buffer";
+        REQUIRE(ArchiveFormat::extract_archive(archive, extract_dir, options));
+        check(extract_dir);
+    }
+    
+    SECTION("Out-of-range members are rejected") {
+        auto truncated = archive;
+        truncated.resize(truncated.size() - 1);
+        REQUIRE_FALSE(ArchiveFormat::extract_archive(
+            truncated, fs::path(TestFileHelper::test_dir) / "bad", options));
+    }
+    
+    TestFileHelper::cleanup();
+}
+
+TEST_CASE("Directory Walker", "[archive][walk]") {
+    TestFileHelper::setup();
+    
+    fs::path root = fs::path(TestFileHelper::test_dir) / "tree";
+    fs::create_directories(root / "src" / "deep" / "er");
+    fs::create_directories(root / "build");
+    fs::create_directories(root / "empty_dir");
+    TestFileHelper::create_test_file("tree/README.md", "readme");
+    TestFileHelper::create_test_file("tree/src/main.cpp", "int main() {}");
+    TestFileHelper::create_test_file("tree/src/main.o", "object");
+    TestFileHelper::create_test_file("tree/src/deep/er/util.cpp", "// util");
+    TestFileHelper::create_test_file("tree/build/out.bin", "binary");
+    
+    auto names = [](const WalkResult& result) {
+        std::vector<std::string> out;
+        for (const auto& member : result.members) {
+            out.push_back(member.entry.filename);
+        }
+        return out;
+    };
+    
+    SECTION("Directories give relative names under the directory's own name") {
+        auto result = DirectoryWalker::walk({root});
+        REQUIRE(result.errors.empty());
+        REQUIRE(names(result) == std::vector<std::string>{
+            "tree/README.md", "tree/build/out.bin", "tree/src/deep/er/util.cpp",
+            "tree/src/main.cpp", "tree/src/main.o"});
+        
+        const auto& main = result.members[3];
+        REQUIRE(main.source == root / "src" / "main.cpp");
+        REQUIRE(main.entry.file_size == 13);
+    }
+    
+    SECTION("Excludes prune directories and includes filter files") {
+        WalkOptions options;
+        options.exclude = {"build", "*.o"};
+        REQUIRE(names(DirectoryWalker::walk({root}, options)) == std::vector<std::string>{
+            "tree/README.md", "tree/src/deep/er/util.cpp", "tree/src/main.cpp"});
+        
+        options.include = {"tree/src/**"};
+        REQUIRE(names(DirectoryWalker::walk({root}, options)) == std::vector<std::string>{
+            "tree/src/deep/er/util.cpp", "tree/src/main.cpp"});
+    }
+    
+    SECTION("Files keep their own name and missing inputs are reported") {
+        auto result = DirectoryWalker::walk({root / "src" / "main.cpp", root / "missing.txt"});
+        REQUIRE(names(result) == std::vector<std::string>{"main.cpp"});
+        REQUIRE(result.errors.size() == 1);
+    }
+    
+    SECTION("Glob matching") {
+        REQUIRE(DirectoryWalker::glob_match("*.cpp", "main.cpp"));
+        REQUIRE_FALSE(DirectoryWalker::glob_match("*.cpp", "src/main.cpp"));
+        REQUIRE(DirectoryWalker::glob_match("src/**/*.cpp", "src/main.cpp"));
+        REQUIRE(DirectoryWalker::glob_match("src/**/*.cpp", "src/a/b/main.cpp"));
+        REQUIRE(DirectoryWalker::glob_match("**", "any/thing"));
+        REQUIRE(DirectoryWalker::glob_match("file?.[ch]", "file1.h"));
+        REQUIRE_FALSE(DirectoryWalker::glob_match("file?.[!ch]", "file1.h"));
+        REQUIRE(DirectoryWalker::glob_match("[a-c]x", "bx"));
+        REQUIRE(DirectoryWalker::matches_any({"*.o"}, "src/deep/x.o"));
+        REQUIRE_FALSE(DirectoryWalker::matches_any({"src/*.o"}, "src/deep/x.o"));
+    }
+    
+    SECTION("Walked trees round-trip with their structure") {
+        ArchiveSource source(DirectoryWalker::walk({root}).members);
+        std::istream in(&source);
+        std::vector<uint8_t> archive(std::istreambuf_iterator<char>(in), {});
+        
+        fs::path extract_dir = fs::path(TestFileHelper::test_dir) / "out";
+        ArchiveSink sink(extract_dir);
+        std::ostream out(&sink);
+        out.write(reinterpret_cast<const char*>(archive.data()), static_cast<std::streamsize>(archive.size()));
+        REQUIRE(sink.finish());
+        REQUIRE(TestFileHelper::read_file(extract_dir / "tree" / "src" / "deep" / "er" / "util.cpp") == "// util");
+        REQUIRE(TestFileHelper::read_file(extract_dir / "tree" / "README.md") == "readme");
+    }
+    
+    SECTION("Unsafe member names are rejected on extraction") {
+        REQUIRE(ArchiveFormat::is_safe_name("a/b/c.txt"));
+        REQUIRE_FALSE(ArchiveFormat::is_safe_name("../escape.txt"));
+        REQUIRE_FALSE(ArchiveFormat::is_safe_name("a/../../escape.txt"));
+        REQUIRE_FALSE(ArchiveFormat::is_safe_name("/etc/passwd"));
+        
+        auto file = TestFileHelper::create_test_file("victim.txt", "data");
+        ArchiveMember member{file, ArchiveFormat::make_entry(file, 0)};
+        member.entry.filename = "../escape.txt";
+        ArchiveSource source(std::vector<ArchiveMember>{member});
+        std::istream in(&source);
+        std::vector<uint8_t> archive(std::istreambuf_iterator<char>(in), {});
+        
+        fs::path extract_dir = fs::path(TestFileHelper::test_dir) / "unsafe";
+        REQUIRE_FALSE(ArchiveFormat::extract_archive(archive, extract_dir));
+        ArchiveSink sink(extract_dir);
+        std::ostream out(&sink);
+        out.write(reinterpret_cast<const char*>(archive.data()), static_cast<std::streamsize>(archive.size()));
+        REQUIRE_FALSE(sink.finish());
+        REQUIRE_FALSE(fs::exists(fs::path(TestFileHelper::test_dir) / "escape.txt"));
+    }
+    
+    TestFileHelper::cleanup();
+}
+
+TEST_CASE("Incremental Archives", "[archive][incremental]") {
+    TestFileHelper::setup();
+    
+    fs::path root = fs::path(TestFileHelper::test_dir) / "data";
+    fs::create_directories(root);
+    TestFileHelper::create_test_file("data/same.txt", "unchanged contents");
+    TestFileHelper::create_test_file("data/touched.txt", "same bytes, new mtime");
+    TestFileHelper::create_test_file("data/edited.txt", "old");
+    TestFileHelper::create_test_file("data/deleted.txt", "going away");
+    
+    auto to_bytes = [](ArchiveSource& source) {
+        std::istream in(&source);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), {});
+    };
+    
+    // Full archive with content hashes
+    auto full_members = DirectoryWalker::walk({root}).members;
+    REQUIRE(IncrementalPlanner::hash_members(full_members).empty());
+    REQUIRE(full_members[0].entry.has_hash());
+    ArchiveSource full_source(full_members);
+    auto full = to_bytes(full_source);
+    auto base_entries = ArchiveFormat::list_files(full);
+    REQUIRE(base_entries.size() == 4);
+    REQUIRE(base_entries[0].content_hash == full_members[0].entry.content_hash);
+    
+    // Next night: one file touched, one edited, one added, one removed
+    auto touched = root / "touched.txt";
+    fs::last_write_time(touched, fs::last_write_time(touched) + std::chrono::hours(1));
+    TestFileHelper::create_test_file("data/edited.txt", "new contents");
+    TestFileHelper::create_test_file("data/added.txt", "brand new");
+    fs::remove(root / "deleted.txt");
+    
+    auto members = DirectoryWalker::walk({root}).members;
+    auto summary = IncrementalPlanner::plan(members, base_entries);
+    REQUIRE(summary.errors.empty());
+    REQUIRE(summary.unchanged == 2);
+    REQUIRE(summary.modified == 1);
+    REQUIRE(summary.added == 1);
+    REQUIRE(summary.removed == 1);
+    REQUIRE(summary.packed_bytes == std::string("new contents").size() + std::string("brand new").size());
+    
+    ArchiveSource delta_source(members, full_source.index_id());
+    auto delta = to_bytes(delta_source);
+    
+    SECTION("Delta carries only changed data and names its base") {
+        fs::path extract_dir = fs::path(TestFileHelper::test_dir) / "restored";
+        ArchiveSink sink(extract_dir);
+        std::ostream out(&sink);
+        out.write(reinterpret_cast<const char*>(delta.data()), static_cast<std::streamsize>(delta.size()));
+        REQUIRE(sink.finish());
+        REQUIRE(sink.header().is_delta());
+        REQUIRE(sink.header().base_id == full_source.index_id());
+        
+        // Unchanged members are left for the caller to copy from the base
+        REQUIRE(TestFileHelper::read_file(extract_dir / "data" / "edited.txt") == "new contents");
+        REQUIRE(TestFileHelper::read_file(extract_dir / "data" / "added.txt") == "brand new");
+        REQUIRE_FALSE(fs::exists(extract_dir / "data" / "same.txt"));
+        REQUIRE_FALSE(fs::exists(extract_dir / "data" / "touched.txt"));
+    }
+    
+    SECTION("Whole-buffer extraction cannot resolve base members") {
+        REQUIRE_FALSE(ArchiveFormat::extract_archive(delta, fs::path(TestFileHelper::test_dir) / "buffer"));
+    }
+    
+    SECTION("Version 1 tables are still read") {
+        std::vector<uint8_t> v1(ArchiveFormat::MAGIC, ArchiveFormat::MAGIC + 6);
+        v1.push_back(1);
+        uint32_t count = 1;
+        v1.insert(v1.end(), reinterpret_cast<uint8_t*>(&count), reinterpret_cast<uint8_t*>(&count) + 4);
+        FileEntry entry;
+        entry.filename = "old.txt";
+        entry.file_size = 3;
+        auto serialized = entry.serialize(1);
+        REQUIRE(serialized.size() == 4 + 7 + FileEntry::fixed_size(1));
+        v1.insert(v1.end(), serialized.begin(), serialized.end());
+        v1.insert(v1.end(), {'o', 'l', 'd'});
+        
+        auto listed = ArchiveFormat::list_files(v1);
+        REQUIRE(listed.size() == 1);
+        REQUIRE_FALSE(listed[0].has_hash());
+        fs::path extract_dir = fs::path(TestFileHelper::test_dir) / "v1";
+        REQUIRE(ArchiveFormat::extract_archive(v1, extract_dir));
+        REQUIRE(TestFileHelper::read_file(extract_dir / "old.txt") == "old");
+    }
+    
+    TestFileHelper::cleanup();
+}
+
 // ===========================================
 // FileEntry Serialization Tests
 // ===========================================
@@ -403,3 +1141,54 @@ TEST_CASE("FileEntry Serialization", "[archive][entry]") {
         REQUIRE(restored.filename == "");
     }
 }
+
+// ===========================================
+// Mount Tree Tests
+// ===========================================
+TEST_CASE("Mount tree", "[archive][mount]") {
+    auto entry = [](std::string name, uint64_t offset, uint64_t size) {
+        FileEntry e;
+        e.filename = std::move(name);
+        e.offset = offset;
+        e.file_size = size;
+        e.permissions = 0640;
+        return e;
+    };
+    std::vector<FileEntry> entries = {
+        entry("docs/a.txt", 0, 10),
+        entry("docs/sub/b.txt", 10, 20),
+        entry("c.bin", 30, 5),
+        entry("docs/a.txt", 35, 7),          // Repeated: the last one wins
+        entry("../escape", 42, 1),
+        entry("c.bin/inner", 43, 1),         // c.bin is a file
+    };
+    entries.push_back(entry("base.txt", 0, 3));
+    entries.back().in_base = true;
+
+    auto tree = MountTree::from_archive(entries, 100);
+    REQUIRE(tree.file_count() == 3);
+    REQUIRE(tree.skipped() == 3);
+
+    const auto* root = tree.lookup("/");
+    REQUIRE(root);
+    REQUIRE(root->directory);
+    REQUIRE(root->children.size() == 2);
+
+    const auto* a = tree.lookup("/docs/a.txt");
+    REQUIRE(a);
+    REQUIRE_FALSE(a->directory);
+    REQUIRE(a->data_offset == 135);
+    REQUIRE(a->size == 7);
+    REQUIRE(a->permissions == 0440);
+
+    REQUIRE(tree.lookup("/docs/sub")->directory);
+    REQUIRE(tree.lookup("/docs/sub/b.txt")->data_offset == 110);
+    REQUIRE(tree.lookup("/missing") == nullptr);
+    REQUIRE(tree.lookup("/base.txt") == nullptr);
+    REQUIRE(tree.lookup("relative") == nullptr);
+
+    auto single = MountTree::single_file("dump.sql", 1234, 0);
+    REQUIRE(single.file_count() == 1);
+    REQUIRE(single.lookup("/dump.sql")->size == 1234);
+    REQUIRE(single.lookup("/dump.sql")->data_offset == 0);
+}
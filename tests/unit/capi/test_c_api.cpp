@@ -0,0 +1,215 @@
+/**
+ * @file test_c_api.cpp
+ * @brief Unit tests for the C API of libfilevault
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/filevault.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::vector<uint8_t> random_bytes(size_t size, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> data(size);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    return data;
+}
+
+fv_options* fast_options() {
+    fv_options* options = nullptr;
+    REQUIRE(fv_options_create(&options) == FV_OK);
+    REQUIRE(fv_options_set(options, "kdf", "pbkdf2") == FV_OK);
+    REQUIRE(fv_options_set(options, "level", "weak") == FV_OK);
+    REQUIRE(fv_options_set(options, "chunk-size", "65536") == FV_OK);
+    return options;
+}
+
+/**
+ * @brief In-memory source and sink for fv_stream
+ */
+struct MemoryStream {
+    std::vector<uint8_t> input;
+    size_t position = 0;
+    std::vector<uint8_t> output;
+
+    static int64_t read(void* context, uint8_t* buffer, size_t size) {
+        auto* self = static_cast<MemoryStream*>(context);
+        size_t n = std::min(size, self->input.size() - self->position);
+        std::memcpy(buffer, self->input.data() + self->position, n);
+        self->position += n;
+        return static_cast<int64_t>(n);
+    }
+
+    static int write(void* context, const uint8_t* data, size_t size) {
+        auto* self = static_cast<MemoryStream*>(context);
+        self->output.insert(self->output.end(), data, data + size);
+        return 0;
+    }
+};
+
+std::vector<uint8_t> run_stream(bool encrypt, std::vector<uint8_t> input, const char* password,
+                                const fv_options* options, fv_status& status) {
+    MemoryStream memory;
+    memory.input = std::move(input);
+    fv_stream* stream = nullptr;
+    REQUIRE(fv_stream_create(&MemoryStream::read, &MemoryStream::write, &memory, &stream) == FV_OK);
+    status = encrypt ? fv_encrypt_stream(stream, password, options, nullptr, nullptr)
+                     : fv_decrypt_stream(stream, password, options, nullptr, nullptr);
+    fv_stream_destroy(stream);
+    return memory.output;
+}
+
+} // anonymous namespace
+
+TEST_CASE("C API basics", "[capi]") {
+    REQUIRE(fv_api_version() == FV_API_VERSION);
+    REQUIRE(std::strlen(fv_version()) > 0);
+
+    size_t key_size = 0, nonce_size = 0, tag_size = 0;
+    REQUIRE(fv_algorithm_sizes("aes-256-gcm", &key_size, &nonce_size, &tag_size) == FV_OK);
+    REQUIRE(key_size == 32);
+    REQUIRE(nonce_size == 12);
+    REQUIRE(tag_size == 16);
+
+    REQUIRE(fv_algorithm_sizes("no-such-cipher", nullptr, nullptr, nullptr) == FV_ERR_INVALID_ARGUMENT);
+    REQUIRE(std::string(fv_last_error()).find("no-such-cipher") != std::string::npos);
+
+    fv_options* options = nullptr;
+    REQUIRE(fv_options_create(&options) == FV_OK);
+    REQUIRE(fv_options_set(options, "compression", "zstd") == FV_OK);
+    REQUIRE(fv_options_set(options, "compression", "brotli") == FV_ERR_INVALID_ARGUMENT);
+    REQUIRE(fv_options_set(options, "threads", "-1") == FV_ERR_INVALID_ARGUMENT);
+    REQUIRE(fv_options_set(options, "colour", "red") == FV_ERR_INVALID_ARGUMENT);
+    fv_options_destroy(options);
+
+    REQUIRE(fv_engine_create(nullptr) == FV_ERR_INVALID_ARGUMENT);
+}
+
+TEST_CASE("C API sessions", "[capi]") {
+    fv_engine* engine = nullptr;
+    REQUIRE(fv_engine_create(&engine) == FV_OK);
+
+    std::vector<uint8_t> key(32);
+    REQUIRE(fv_random(key.data(), key.size()) == FV_OK);
+
+    fv_session* session = nullptr;
+    REQUIRE(fv_session_create(engine, "aes-256-gcm", key.data(), 16, &session) == FV_ERR_INVALID_ARGUMENT);
+    REQUIRE(fv_session_create(engine, "aes-256-cbc", key.data(), key.size(), &session) == FV_ERR_UNSUPPORTED);
+    REQUIRE(fv_session_create(engine, "aes-256-gcm", key.data(), key.size(), &session) == FV_OK);
+    REQUIRE(fv_session_overhead(session) == 28);
+
+    auto message = random_bytes(1000, 1);
+    const std::string ad = "record-7";
+    const auto* ad_bytes = reinterpret_cast<const uint8_t*>(ad.data());
+
+    SECTION("Seal and open") {
+        size_t sealed_size = 0;
+        REQUIRE(fv_session_seal(session, message.data(), message.size(), ad_bytes, ad.size(),
+                                nullptr, 0, &sealed_size) == FV_ERR_BUFFER_TOO_SMALL);
+        REQUIRE(sealed_size == message.size() + 28);
+
+        std::vector<uint8_t> sealed(sealed_size);
+        REQUIRE(fv_session_seal(session, message.data(), message.size(), ad_bytes, ad.size(),
+                                sealed.data(), sealed.size(), &sealed_size) == FV_OK);
+
+        std::vector<uint8_t> opened(message.size());
+        size_t opened_size = 0;
+        REQUIRE(fv_session_open(session, sealed.data(), sealed.size(), ad_bytes, ad.size(),
+                                opened.data(), opened.size(), &opened_size) == FV_OK);
+        REQUIRE(opened_size == message.size());
+        REQUIRE(opened == message);
+
+        // Fresh nonce per message
+        std::vector<uint8_t> again(sealed.size());
+        REQUIRE(fv_session_seal(session, message.data(), message.size(), ad_bytes, ad.size(),
+                                again.data(), again.size(), &sealed_size) == FV_OK);
+        REQUIRE(again != sealed);
+
+        REQUIRE(fv_session_open(session, sealed.data(), sealed.size(), nullptr, 0,
+                                opened.data(), opened.size(), &opened_size) == FV_ERR_AUTHENTICATION);
+        sealed[100] ^= 1;
+        REQUIRE(fv_session_open(session, sealed.data(), sealed.size(), ad_bytes, ad.size(),
+                                opened.data(), opened.size(), &opened_size) == FV_ERR_AUTHENTICATION);
+    }
+
+    SECTION("Derived keys") {
+        fv_options* options = fast_options();
+        std::vector<uint8_t> salt(16, 0x5a);
+        std::vector<uint8_t> first(32), second(32);
+        REQUIRE(fv_derive_key(engine, "pw", salt.data(), salt.size(), options, first.data(), first.size()) == FV_OK);
+        REQUIRE(fv_derive_key(engine, "pw", salt.data(), salt.size(), options, second.data(), second.size()) == FV_OK);
+        REQUIRE(first == second);
+        REQUIRE(fv_derive_key(engine, "pw", salt.data(), salt.size(), options, first.data(), 16) ==
+                FV_ERR_INVALID_ARGUMENT);
+        fv_options_destroy(options);
+    }
+
+    fv_session_destroy(session);
+    fv_engine_destroy(engine);
+}
+
+TEST_CASE("C API files and streams", "[capi][streaming]") {
+    const fs::path dir = "test_c_api_temp";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const auto data = random_bytes(300 * 1024 + 5, 2);
+    {
+        std::ofstream out(dir / "input.bin", std::ios::binary);
+        out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    }
+    const std::string input = (dir / "input.bin").string();
+    const std::string encrypted = (dir / "input.fvlt").string();
+    const std::string output = (dir / "output.bin").string();
+    fv_options* options = fast_options();
+
+    SECTION("File round trip with progress") {
+        uint64_t last = 0;
+        auto progress = [](void* user_data, uint64_t done, uint64_t) -> int {
+            *static_cast<uint64_t*>(user_data) = done;
+            return 1;
+        };
+        REQUIRE(fv_encrypt_file(input.c_str(), encrypted.c_str(), "pw", options, progress, &last) == FV_OK);
+        REQUIRE(last == data.size());
+        REQUIRE(fv_decrypt_file(encrypted.c_str(), output.c_str(), "wrong", options, nullptr, nullptr) ==
+                FV_ERR_FAILED);
+        REQUIRE(fv_decrypt_file(encrypted.c_str(), output.c_str(), "pw", options, nullptr, nullptr) == FV_OK);
+
+        std::ifstream in(output, std::ios::binary);
+        std::vector<uint8_t> back((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        REQUIRE(back == data);
+    }
+
+    SECTION("Progress callback cancels") {
+        auto stop = [](void*, uint64_t, uint64_t) -> int { return 0; };
+        REQUIRE(fv_encrypt_file(input.c_str(), encrypted.c_str(), "pw", options, stop, nullptr) == FV_ERR_CANCELLED);
+    }
+
+    SECTION("Stream round trip") {
+        fv_status status = FV_ERR_INTERNAL;
+        auto sealed = run_stream(true, data, "pw", options, status);
+        REQUIRE(status == FV_OK);
+        REQUIRE(sealed.size() > data.size());
+
+        auto opened = run_stream(false, sealed, "pw", options, status);
+        REQUIRE(status == FV_OK);
+        REQUIRE(opened == data);
+
+        sealed.resize(sealed.size() - 10);
+        run_stream(false, sealed, "pw", options, status);
+        REQUIRE(status == FV_ERR_FAILED);
+    }
+
+    fv_options_destroy(options);
+    fs::remove_all(dir);
+}
@@ -1,6 +1,12 @@
 #include <catch2/catch_test_macros.hpp>
+#include "filevault/compression/adaptive_level.hpp"
 #include "filevault/compression/compressor.hpp"
+#include "filevault/compression/dictionary.hpp"
+#include "filevault/compression/seekable.hpp"
+#include "filevault/compression/selector.hpp"
 #include "filevault/core/types.hpp"
+#include <filesystem>
+#include <fstream>
 #include <vector>
 #include <string>
 #include <random>
@@ -113,3 +119,534 @@ TEST_CASE("Large data compression", "[compression][large]") {
         REQUIRE(decompressed.data == data);
     }
 }
+
+TEST_CASE("Zstandard and LZ4 compression", "[compression][zstd][lz4]") {
+    std::string text;
+    while (text.size() < 100000) {
+        text += "{\"id\": " + std::to_string(text.size()) + ", \"status\": \"ok\", \"tags\": [\"a\", \"b\"]}\n";
+    }
+    std::vector<uint8_t> data(text.begin(), text.end());
+    
+    for (auto type : {CompressionType::ZSTD, CompressionType::LZ4}) {
+        auto compressor = CompressionService::create(type);
+        REQUIRE(CompressionService::parse_algorithm(compressor->name()) == type);
+        
+        for (int level : {1, 6, 9}) {
+            auto compressed = compressor->compress(data, level);
+            REQUIRE(compressed.success);
+            REQUIRE(compressed.data.size() < data.size() / 4);
+            REQUIRE(CompressionService::detect(compressed.data) == type);
+            
+            auto decompressed = compressor->decompress(compressed.data);
+            REQUIRE(decompressed.success);
+            REQUIRE(decompressed.data == data);
+        }
+        
+        // Empty input still makes a valid frame
+        auto empty = compressor->compress({}, 6);
+        REQUIRE(empty.success);
+        auto restored = compressor->decompress(empty.data, 0);
+        REQUIRE(restored.success);
+        REQUIRE(restored.data.empty());
+        
+        // Corruption is detected by the content checksum or the parser
+        auto compressed = compressor->compress(data, 6);
+        compressed.data[compressed.data.size() / 2] ^= 0x55;
+        REQUIRE_FALSE(compressor->decompress(compressed.data).success);
+    }
+}
+
+TEST_CASE("Compressor reuse across buffers", "[compression][reuse]") {
+    std::string pattern = "The quick brown fox jumps over the lazy dog. ";
+    
+    auto make_buffer = [&pattern](size_t size, char salt) {
+        std::vector<uint8_t> data;
+        while (data.size() < size) {
+            data.insert(data.end(), pattern.begin(), pattern.end());
+            data.push_back(static_cast<uint8_t>(salt + data.size() % 7));
+        }
+        data.resize(size);
+        return data;
+    };
+    
+    for (auto type : {CompressionType::ZLIB, CompressionType::LZMA}) {
+        auto compressor = CompressionService::create(type);
+        auto decompressor = CompressionService::create(type);
+        
+        // Same instances, varying sizes and levels: state must reset cleanly
+        for (int i = 0; i < 6; ++i) {
+            auto data = make_buffer(1000 + i * 3000, static_cast<char>('a' + i));
+            int level = (i % 2 == 0) ? 3 : 9;
+            
+            auto compressed = compressor->compress(data, level);
+            REQUIRE(compressed.success);
+            
+            auto decompressed = decompressor->decompress(compressed.data);
+            REQUIRE(decompressed.success);
+            REQUIRE(decompressed.data == data);
+        }
+        
+        // A truncated stream fails without poisoning the next call
+        auto data = make_buffer(5000, 'z');
+        auto compressed = compressor->compress(data, 6);
+        REQUIRE(compressed.success);
+        std::vector<uint8_t> truncated(compressed.data.begin(), compressed.data.begin() + compressed.data.size() / 2);
+        REQUIRE_FALSE(decompressor->decompress(truncated).success);
+        
+        auto decompressed = decompressor->decompress(compressed.data);
+        REQUIRE(decompressed.success);
+        REQUIRE(decompressed.data == data);
+    }
+}
+
+TEST_CASE("Streaming compression", "[compression][stream]") {
+    using filevault::compression::StreamMode;
+    
+    std::string pattern = "The quick brown fox jumps over the lazy dog. ";
+    std::vector<uint8_t> data;
+    std::mt19937 rng(42);
+    while (data.size() < 300000) {
+        data.insert(data.end(), pattern.begin(), pattern.end());
+        data.push_back(static_cast<uint8_t>(rng()));
+    }
+    
+    // Feed in uneven pieces so chunk edges land everywhere
+    auto run_stream = [](auto& compressor, StreamMode mode, const std::vector<uint8_t>& input,
+                         size_t piece, std::vector<uint8_t>& output) {
+        REQUIRE(compressor->begin(mode, 6, input.size()));
+        for (size_t offset = 0; offset < input.size(); offset += piece) {
+            size_t n = std::min(piece, input.size() - offset);
+            REQUIRE(compressor->update(std::span<const uint8_t>(input).subspan(offset, n), output));
+        }
+        return compressor->finish(output);
+    };
+    
+    for (auto type : {CompressionType::ZLIB, CompressionType::BZIP2, CompressionType::LZMA,
+                      CompressionType::ZSTD, CompressionType::LZ4}) {
+        auto compressor = CompressionService::create(type);
+        
+        std::vector<uint8_t> compressed;
+        REQUIRE(run_stream(compressor, StreamMode::COMPRESS, data, 7777, compressed));
+        
+        // Stream output decodes one-shot and vice versa
+        auto one_shot = compressor->decompress(compressed);
+        REQUIRE(one_shot.success);
+        REQUIRE(one_shot.data == data);
+        
+        auto whole = compressor->compress(data, 6);
+        REQUIRE(whole.success);
+        std::vector<uint8_t> restored;
+        REQUIRE(run_stream(compressor, StreamMode::DECOMPRESS, whole.data, 1001, restored));
+        REQUIRE(restored == data);
+        
+        // Output ending exactly on a multiple of the internal step (64 KB)
+        std::vector<uint8_t> aligned(data.begin(), data.begin() + 128 * 1024);
+        auto aligned_whole = compressor->compress(aligned, 6);
+        REQUIRE(aligned_whole.success);
+        std::vector<uint8_t> aligned_restored;
+        REQUIRE(run_stream(compressor, StreamMode::DECOMPRESS, aligned_whole.data, aligned_whole.data.size(),
+                           aligned_restored));
+        REQUIRE(aligned_restored == aligned);
+        
+        // Truncated input is reported by finish()
+        std::vector<uint8_t> truncated(compressed.begin(), compressed.begin() + compressed.size() / 2);
+        std::vector<uint8_t> partial;
+        REQUIRE_FALSE(run_stream(compressor, StreamMode::DECOMPRESS, truncated, 4096, partial));
+        REQUIRE_FALSE(compressor->stream_error().empty());
+    }
+}
+
+TEST_CASE("Size-hinted decompression", "[compression][hint]") {
+    std::string text;
+    while (text.size() < 200000) {
+        text += "2024-01-01 12:00:00 INFO request served in 3 ms\n";  // ~20:1 like log files
+    }
+    std::vector<uint8_t> data(text.begin(), text.end());
+    
+    for (auto type : {CompressionType::ZLIB, CompressionType::BZIP2, CompressionType::LZMA,
+                      CompressionType::ZSTD, CompressionType::LZ4}) {
+        auto compressor = CompressionService::create(type);
+        auto compressed = compressor->compress(data, 6);
+        REQUIRE(compressed.success);
+        
+        auto exact = compressor->decompress(compressed.data, data.size());
+        REQUIRE(exact.success);
+        REQUIRE(exact.data == data);
+        
+        // A wrong size is an error, not a silent truncation or padding
+        REQUIRE_FALSE(compressor->decompress(compressed.data, data.size() - 1).success);
+        REQUIRE_FALSE(compressor->decompress(compressed.data, data.size() + 1).success);
+        
+        // The instance is still usable afterwards
+        auto again = compressor->decompress(compressed.data, data.size());
+        REQUIRE(again.success);
+        REQUIRE(again.data == data);
+    }
+}
+
+TEST_CASE("Parallel compression", "[compression][threads]") {
+    using filevault::compression::StreamMode;
+    
+    // Several blocks for every algorithm at level 1 (bzip3: 1 MB, xz: 3 MB)
+    std::string pattern = "The quick brown fox jumps over the lazy dog. ";
+    std::vector<uint8_t> data;
+    std::mt19937 rng(7);
+    while (data.size() < 7 * 1024 * 1024 + 123) {
+        data.insert(data.end(), pattern.begin(), pattern.end());
+        data.push_back(static_cast<uint8_t>(rng()));
+    }
+    
+    for (auto type : {CompressionType::ZLIB, CompressionType::BZIP2, CompressionType::LZMA,
+                      CompressionType::ZSTD, CompressionType::LZ4}) {
+        auto compressor = CompressionService::create(type);
+        compressor->set_threads(4);
+        auto serial = CompressionService::create(type);
+        
+        // One-shot output is a standard stream the serial decoder reads
+        auto compressed = compressor->compress(data, 1);
+        REQUIRE(compressed.success);
+        REQUIRE(compressed.data.size() < data.size());
+        auto restored = serial->decompress(compressed.data, data.size());
+        REQUIRE(restored.success);
+        REQUIRE(restored.data == data);
+        
+        // Streamed in uneven pieces, batches straddle the piece boundaries
+        std::vector<uint8_t> streamed;
+        REQUIRE(compressor->begin(StreamMode::COMPRESS, 1, data.size()));
+        for (size_t offset = 0; offset < data.size(); offset += 300001) {
+            size_t n = std::min<size_t>(300001, data.size() - offset);
+            REQUIRE(compressor->update(std::span<const uint8_t>(data).subspan(offset, n), streamed));
+        }
+        REQUIRE(compressor->finish(streamed));
+        auto unstreamed = serial->decompress(streamed);
+        REQUIRE(unstreamed.success);
+        REQUIRE(unstreamed.data == data);
+        
+        // Multi-block input decodes in parallel (bzip3, xz) with the same result
+        auto parallel = compressor->decompress(compressed.data, data.size());
+        REQUIRE(parallel.success);
+        REQUIRE(parallel.data == data);
+        REQUIRE_FALSE(compressor->decompress(compressed.data, data.size() - 1).success);
+        
+        std::vector<uint8_t> destreamed;
+        REQUIRE(compressor->begin(StreamMode::DECOMPRESS));
+        for (size_t offset = 0; offset < streamed.size(); offset += 300001) {
+            size_t n = std::min<size_t>(300001, streamed.size() - offset);
+            REQUIRE(compressor->update(std::span<const uint8_t>(streamed).subspan(offset, n), destreamed));
+        }
+        REQUIRE(compressor->finish(destreamed));
+        REQUIRE(destreamed == data);
+        
+        std::vector<uint8_t> partial;
+        REQUIRE(compressor->begin(StreamMode::DECOMPRESS));
+        REQUIRE(compressor->update(std::span<const uint8_t>(streamed).first(streamed.size() / 2), partial));
+        REQUIRE_FALSE(compressor->finish(partial));
+    }
+}
+
+TEST_CASE("Incompressible data detection", "[compression][entropy]") {
+    std::mt19937 gen(7);
+    std::vector<uint8_t> random_data(256 * 1024);
+    for (auto& b : random_data) {
+        b = static_cast<uint8_t>(gen());
+    }
+    std::string text;
+    while (text.size() < random_data.size()) {
+        text += "The quick brown fox jumps over the lazy dog. 0123456789\n";
+    }
+    std::vector<uint8_t> text_data(text.begin(), text.end());
+    
+    SECTION("Random data is predicted incompressible") {
+        REQUIRE(CompressionService::sample_entropy(random_data) > 7.9);
+        REQUIRE(CompressionService::likely_incompressible(random_data));
+    }
+    
+    SECTION("Text and constant data are not") {
+        REQUIRE(CompressionService::sample_entropy(text_data) < 6.0);
+        REQUIRE_FALSE(CompressionService::likely_incompressible(text_data));
+        
+        std::vector<uint8_t> zeros(64 * 1024, 0);
+        REQUIRE(CompressionService::sample_entropy(zeros) == 0.0);
+        REQUIRE_FALSE(CompressionService::likely_incompressible(zeros));
+    }
+    
+    SECTION("Tiny inputs are always tried") {
+        std::span<const uint8_t> tiny(random_data.data(), 512);
+        REQUIRE_FALSE(CompressionService::likely_incompressible(tiny));
+        REQUIRE(CompressionService::sample_entropy({}) == 0.0);
+    }
+}
+
+TEST_CASE("Automatic compression selection", "[compression][auto]") {
+    using filevault::compression::CompressionSelector;
+    
+    std::mt19937 gen(11);
+    std::vector<uint8_t> random_data(512 * 1024);
+    for (auto& b : random_data) {
+        b = static_cast<uint8_t>(gen());
+    }
+    std::string text;
+    while (text.size() < random_data.size()) {
+        text += "id=" + std::to_string(gen() % 1000) + ",name=sensor,status=ok,value=42\n";
+    }
+    std::vector<uint8_t> text_data(text.begin(), text.end());
+    
+    SECTION("Sample is capped and covers small inputs whole") {
+        REQUIRE(CompressionSelector::sample(text_data).size() == 256 * 1024);
+        std::span<const uint8_t> small(text_data.data(), 1000);
+        REQUIRE(CompressionSelector::sample(small).size() == 1000);
+    }
+    
+    SECTION("Random data selects no compression") {
+        auto choice = CompressionSelector::select(CompressionSelector::sample(random_data));
+        REQUIRE(choice.type == CompressionType::NONE);
+    }
+    
+    SECTION("Text selects a compressor that saves space") {
+        auto choice = CompressionSelector::select(CompressionSelector::sample(text_data), 1.0);
+        REQUIRE(choice.type != CompressionType::NONE);
+        REQUIRE(choice.ratio > 1.0);
+        REQUIRE(choice.compress_mbps > 0.0);
+        
+        auto compressor = CompressionService::create(choice.type);
+        REQUIRE(compressor);
+        auto result = compressor->compress(text_data, choice.level);
+        REQUIRE(result.success);
+        REQUIRE(result.data.size() < text_data.size());
+    }
+    
+    SECTION("An unreachable target selects no compression") {
+        auto choice = CompressionSelector::select(CompressionSelector::sample(text_data), 1e12);
+        REQUIRE(choice.type == CompressionType::NONE);
+    }
+    
+    SECTION("Timing helpers") {
+        auto compressor = CompressionService::create(CompressionType::ZLIB);
+        filevault::compression::CompressionResult last;
+        REQUIRE(CompressionSelector::time_compression(*compressor, text_data, 1, 2, &last) > 0.0);
+        REQUIRE(last.success);
+        REQUIRE(CompressionSelector::time_decompression(*compressor, last.data, 2) > 0.0);
+    }
+}
+
+TEST_CASE("Dictionary compression of small files", "[compression][dictionary]") {
+    // Small JSON records sharing field names and structure
+    auto record = [](size_t i) {
+        std::string json = "{\"id\": " + std::to_string(i * 7919 % 100000) +
+                           ", \"name\": \"service-" + std::to_string(i % 37) +
+                           "\", \"enabled\": " + (i % 3 ? "true" : "false") +
+                           ", \"region\": \"eu-west-" + std::to_string(i % 4) +
+                           "\", \"retries\": " + std::to_string(i % 5) +
+                           ", \"timeout_ms\": " + std::to_string(1000 + i % 9 * 250) + "}";
+        return std::vector<uint8_t>(json.begin(), json.end());
+    };
+    std::vector<std::vector<uint8_t>> samples;
+    for (size_t i = 0; i < 500; ++i) {
+        samples.push_back(record(i));
+    }
+    
+    auto trained = CompressionService::train_dictionary(samples, 4096);
+    REQUIRE(trained.success);
+    const auto& dictionary = trained.value;
+    REQUIRE(!dictionary.empty());
+    REQUIRE(CompressionService::dictionary_id(dictionary) != 0);
+    
+    auto input = record(1234);
+    
+    for (auto type : {CompressionType::ZLIB, CompressionType::ZSTD}) {
+        auto plain = CompressionService::create(type);
+        auto with_dict = CompressionService::create(type);
+        REQUIRE(with_dict->set_dictionary(dictionary));
+        
+        SECTION(CompressionService::get_algorithm_name(type) + " round trip and ratio") {
+            auto baseline = plain->compress(input, 6);
+            auto compressed = with_dict->compress(input, 6);
+            REQUIRE(compressed.success);
+            REQUIRE(compressed.data.size() < baseline.data.size());
+            
+            auto restored = with_dict->decompress(compressed.data);
+            REQUIRE(restored.success);
+            REQUIRE(restored.data == input);
+            
+            auto sized = with_dict->decompress(compressed.data, input.size());
+            REQUIRE(sized.success);
+            REQUIRE(sized.data == input);
+            
+            // Streams use the dictionary too
+            std::vector<uint8_t> streamed;
+            REQUIRE(with_dict->begin(filevault::compression::StreamMode::DECOMPRESS));
+            REQUIRE(with_dict->update(compressed.data, streamed));
+            REQUIRE(with_dict->finish(streamed));
+            REQUIRE(streamed == input);
+        }
+        
+        SECTION(CompressionService::get_algorithm_name(type) + " needs the dictionary") {
+            auto compressed = with_dict->compress(input, 6);
+            REQUIRE(compressed.success);
+            auto without = plain->decompress(compressed.data);
+            REQUIRE_FALSE(without.success);
+        }
+    }
+    
+    SECTION("Unsupported algorithms refuse a dictionary") {
+        auto lzma = CompressionService::create(CompressionType::LZMA);
+        REQUIRE_FALSE(lzma->set_dictionary(dictionary));
+        REQUIRE(lzma->set_dictionary({}));
+    }
+    
+    SECTION("Too few samples fail to train") {
+        std::vector<std::vector<uint8_t>> few = {record(1)};
+        REQUIRE_FALSE(CompressionService::train_dictionary(few).success);
+    }
+    
+    SECTION("Dictionary store") {
+        namespace fs = std::filesystem;
+        auto dir = fs::temp_directory_path() / "filevault_test_dictionaries";
+        fs::remove_all(dir);
+        filevault::compression::DictionaryStore store(dir);
+        
+        auto saved = store.save(dictionary);
+        REQUIRE(saved.success);
+        REQUIRE(saved.value == CompressionService::dictionary_id(dictionary));
+        REQUIRE(store.save(dictionary).success);  // Saving twice is fine
+        REQUIRE(store.list() == std::vector<uint32_t>{saved.value});
+        
+        auto loaded = store.load(saved.value);
+        REQUIRE(loaded.success);
+        REQUIRE(loaded.value == dictionary);
+        REQUIRE_FALSE(store.load(saved.value ^ 1).success);
+        
+        auto id_text = filevault::compression::DictionaryStore::format_id(saved.value);
+        REQUIRE(filevault::compression::DictionaryStore::parse_id(id_text) == saved.value);
+        REQUIRE(filevault::compression::DictionaryStore::parse_id("0x" + id_text) == saved.value);
+        REQUIRE(filevault::compression::DictionaryStore::parse_id("not-an-id") == 0);
+        
+        std::vector<uint8_t> raw(100, 'x');
+        REQUIRE_FALSE(store.save(raw).success);
+        fs::remove_all(dir);
+    }
+}
+
+TEST_CASE("Seekable compression", "[compression][seekable]") {
+    namespace fs = std::filesystem;
+    using filevault::compression::SeekableCompression;
+    
+    auto dir = fs::temp_directory_path() / "filevault_test_seekable";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    auto input = (dir / "input.bin").string();
+    auto packed = (dir / "input.fvz").string();
+    auto output = (dir / "output.bin").string();
+    
+    std::string pattern = "2024-05-01 12:00:00 INFO request served in 12 ms\n";
+    std::vector<uint8_t> data;
+    std::mt19937 rng(7);
+    while (data.size() < 200000) {
+        data.insert(data.end(), pattern.begin(), pattern.end());
+        data.push_back(static_cast<uint8_t>(rng()));
+    }
+    std::ofstream(input, std::ios::binary).write(reinterpret_cast<const char*>(data.data()),
+                                                 static_cast<std::streamsize>(data.size()));
+    
+    auto read_back = [&]() {
+        std::ifstream in(output, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), {});
+    };
+    
+    for (auto type : {CompressionType::ZLIB, CompressionType::BZIP2, CompressionType::LZMA,
+                      CompressionType::ZSTD, CompressionType::LZ4}) {
+        auto written = SeekableCompression::compress_file(type, input, packed, 6, 16384, 4);
+        REQUIRE(written.success);
+        REQUIRE(written.value == fs::file_size(packed));
+        
+        auto index = SeekableCompression::read_index(packed);
+        REQUIRE(index.success);
+        REQUIRE(index.value.size() == (data.size() + 16383) / 16384);
+        REQUIRE(index.value[1].decompressed_offset == 16384);
+        REQUIRE(index.value.back().decompressed_size == data.size() % 16384);
+        
+        // Whole file, then a range across a frame boundary
+        REQUIRE(SeekableCompression::decompress_file(type, packed, output, 0,
+                                                     SeekableCompression::TO_END, 4).success);
+        REQUIRE(read_back() == data);
+        
+        auto range = SeekableCompression::decompress_file(type, packed, output, 50000, 20000, 3);
+        REQUIRE(range.success);
+        REQUIRE(range.value == 20000);
+        REQUIRE(read_back() == std::vector<uint8_t>(data.begin() + 50000, data.begin() + 70000));
+        
+        // Ranges running past the end are cut short; starting past it fails
+        auto tail = SeekableCompression::decompress_file(type, packed, output, data.size() - 10, 100, 1);
+        REQUIRE(tail.success);
+        REQUIRE(tail.value == 10);
+        REQUIRE_FALSE(SeekableCompression::decompress_file(type, packed, output, data.size() + 1, 1).success);
+    }
+    
+    SECTION("zstd output is plain zstd frames plus a skippable seek table") {
+        REQUIRE(SeekableCompression::compress_file(CompressionType::ZSTD, input, packed, 6, 65536, 2).success);
+        std::ifstream in(packed, std::ios::binary);
+        std::vector<uint8_t> file((std::istreambuf_iterator<char>(in)), {});
+        auto decoded = CompressionService::create(CompressionType::ZSTD)->decompress(file);
+        REQUIRE(decoded.success);
+        REQUIRE(decoded.data == data);
+    }
+    
+    SECTION("Files without a seek table") {
+        auto plain = CompressionService::create(CompressionType::ZLIB);
+        REQUIRE(CompressionService::process_file(*plain, filevault::compression::StreamMode::COMPRESS,
+                                                 input, packed).success);
+        REQUIRE_FALSE(SeekableCompression::is_seekable(packed));
+        REQUIRE_FALSE(SeekableCompression::decompress_file(CompressionType::ZLIB, packed, output).success);
+        REQUIRE_FALSE(fs::exists(output));
+    }
+    
+    SECTION("Empty input") {
+        std::ofstream(input, std::ios::trunc);
+        REQUIRE(SeekableCompression::compress_file(CompressionType::ZLIB, input, packed).success);
+        REQUIRE(SeekableCompression::read_index(packed).value.size() == 1);
+        auto restored = SeekableCompression::decompress_file(CompressionType::ZLIB, packed, output);
+        REQUIRE(restored.success);
+        REQUIRE(restored.value == 0);
+    }
+    
+    fs::remove_all(dir);
+}
+
+TEST_CASE("Adaptive compression level", "[compression][adaptive]") {
+    using filevault::compression::AdaptiveLevel;
+    constexpr size_t in_flight = 4;
+    
+    SECTION("Start level is clamped to the range") {
+        REQUIRE(AdaptiveLevel(3, 7, 9).level() == 7);
+        REQUIRE(AdaptiveLevel(3, 7, 1).level() == 3);
+        REQUIRE(AdaptiveLevel(3, 7, 5).level() == 5);
+    }
+    
+    SECTION("A full queue raises the level one step per queue of chunks") {
+        AdaptiveLevel adaptive(1, 9, 5);
+        for (size_t i = 0; i < in_flight - 1; ++i) {
+            REQUIRE(adaptive.observe(in_flight, in_flight) == 5);
+        }
+        REQUIRE(adaptive.observe(in_flight, in_flight) == 6);
+        for (int i = 0; i < 100; ++i) {
+            adaptive.observe(in_flight, in_flight);
+        }
+        REQUIRE(adaptive.level() == 9);
+    }
+    
+    SECTION("A writer waiting on compression lowers the level") {
+        AdaptiveLevel adaptive(2, 9, 6);
+        for (int i = 0; i < 100; ++i) {
+            adaptive.observe(0, in_flight);
+        }
+        REQUIRE(adaptive.level() == 2);
+    }
+    
+    SECTION("A half-full queue keeps the level") {
+        AdaptiveLevel adaptive(1, 9, 5);
+        for (int i = 0; i < 100; ++i) {
+            adaptive.observe(in_flight / 2, in_flight);
+        }
+        REQUIRE(adaptive.level() == 5);
+    }
+}
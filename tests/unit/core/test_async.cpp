@@ -0,0 +1,259 @@
+/**
+ * @file test_async.cpp
+ * @brief Unit tests for the coroutine API over the executor
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/core/async.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace filevault::core;
+namespace fs = std::filesystem;
+
+namespace {
+
+/**
+ * @brief Single-threaded job queue standing in for an application's event loop
+ */
+class EventLoop {
+public:
+    std::function<void(std::function<void()>)> dispatcher() {
+        return [this](std::function<void()> job) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs_.push_back(std::move(job));
+            cv_.notify_one();
+        };
+    }
+
+    /**
+     * @brief Run jobs on the calling thread until done() is true
+     */
+    template<typename Done>
+    void run_until(Done done) {
+        loop_thread_ = std::this_thread::get_id();
+        while (!done()) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait_for(lock, std::chrono::milliseconds(10), [this] { return !jobs_.empty(); });
+                if (jobs_.empty()) {
+                    continue;
+                }
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            job();
+        }
+    }
+
+    bool on_loop() const { return std::this_thread::get_id() == loop_thread_; }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> jobs_;
+    std::thread::id loop_thread_;
+};
+
+/**
+ * @brief Fire-and-forget coroutine
+ *
+ * Coroutine lambdas are kept in named variables: a temporary lambda's
+ * captures would be gone by the time the coroutine resumes.
+ */
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+std::vector<uint8_t> make_data(size_t size) {
+    std::vector<uint8_t> data(size);
+    std::mt19937 gen(7);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(gen());
+    }
+    return data;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Awaitable operations", "[async]") {
+    Executor executor(2);
+    EventLoop loop;
+    AsyncOptions options;
+    options.executor = &executor;
+    options.dispatch = loop.dispatcher();
+
+    SECTION("Results and exceptions come back on the event loop") {
+        int value = 0;
+        bool resumed_on_loop = false;
+        bool threw = false;
+        std::atomic<bool> done{false};
+        auto body = [&]() -> Detached {
+            value = co_await run_async([]() { return 6 * 7; }, options);
+            resumed_on_loop = loop.on_loop();
+            try {
+                co_await run_async([]() -> int { throw std::runtime_error("boom"); }, options);
+            } catch (const std::runtime_error&) {
+                threw = true;
+            }
+            done = true;
+        };
+        body();
+        loop.run_until([&] { return done.load(); });
+        REQUIRE(value == 42);
+        REQUIRE(resumed_on_loop);
+        REQUIRE(threw);
+    }
+
+    SECTION("A cancelled token skips the work") {
+        options.token = CancellationToken::create();
+        options.token.cancel();
+        std::atomic<bool> ran{false};
+        std::atomic<bool> done{false};
+        bool cancelled = false;
+        auto body = [&]() -> Detached {
+            try {
+                co_await run_async([&ran]() { ran = true; return 1; }, options);
+            } catch (const TaskCancelled&) {
+                cancelled = true;
+            }
+            done = true;
+        };
+        body();
+        loop.run_until([&] { return done.load(); });
+        REQUIRE(cancelled);
+        REQUIRE_FALSE(ran);
+    }
+
+    SECTION("Many operations share a small executor") {
+        constexpr int OPERATIONS = 1000;
+        std::atomic<int> finished{0};
+        long long sum = 0;
+        auto add = [&](int i) -> Detached {
+            sum += co_await run_async([i]() { return i; }, options);   // Resumed on the loop only
+            finished.fetch_add(1);
+        };
+        for (int i = 0; i < OPERATIONS; ++i) {
+            add(i);
+        }
+        loop.run_until([&] { return finished.load() == OPERATIONS; });
+        REQUIRE(sum == static_cast<long long>(OPERATIONS) * (OPERATIONS - 1) / 2);
+    }
+
+    SECTION("Completion handlers") {
+        std::atomic<bool> done{false};
+        std::exception_ptr error;
+        std::string text;
+        run_async([]() { return std::string("handled"); }, options)
+            .start([&](std::exception_ptr e, std::string result) {
+                error = e;
+                text = std::move(result);
+                done = true;
+            });
+        loop.run_until([&] { return done.load(); });
+        REQUIRE_FALSE(error);
+        REQUIRE(text == "handled");
+    }
+}
+
+TEST_CASE("Awaitable file encryption", "[async][streaming]") {
+    const fs::path dir = "test_async_temp";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    auto data = make_data(3 * 1024 * 1024 + 17);
+    {
+        std::ofstream out(dir / "input.bin", std::ios::binary);
+        out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    }
+
+    Executor executor(2);
+    EventLoop loop;
+    AsyncOptions options;
+    options.executor = &executor;
+    options.dispatch = loop.dispatcher();
+
+    StreamingConfig config;
+    config.chunk_size = 256 * 1024;
+    config.kdf = KDFType::PBKDF2_SHA256;
+    config.level = SecurityLevel::WEAK;
+
+    SECTION("Round trip with progress events on the loop") {
+        size_t events = 0;
+        bool events_on_loop = true;
+        options.on_progress = [&](const ChunkInfo&) {
+            ++events;
+            events_on_loop = events_on_loop && loop.on_loop();
+        };
+        StreamingResult encrypted, decrypted;
+        std::atomic<bool> done{false};
+        auto body = [&]() -> Detached {
+            encrypted = co_await AsyncCrypto::encrypt_file((dir / "input.bin").string(), (dir / "enc.fvlt").string(),
+                                                           "pw", config, options);
+            decrypted = co_await AsyncCrypto::decrypt_file((dir / "enc.fvlt").string(), (dir / "out.bin").string(),
+                                                           "pw", 1, options);
+            done = true;
+        };
+        body();
+        loop.run_until([&] { return done.load(); });
+        REQUIRE(encrypted.success);
+        REQUIRE(decrypted.success);
+        REQUIRE(events >= 2 * 13);
+        REQUIRE(events_on_loop);
+
+        auto back = AsyncCrypto::read_file((dir / "out.bin").string(), options);
+        Result<std::vector<uint8_t>> read;
+        done = false;
+        auto read_back = [&]() -> Detached {
+            read = co_await back;
+            done = true;
+        };
+        read_back();
+        loop.run_until([&] { return done.load(); });
+        REQUIRE(read.success);
+        REQUIRE(read.value == data);
+    }
+
+    SECTION("Cancelling stops between chunks") {
+        options.token = CancellationToken::create();
+        options.on_progress = [&](const ChunkInfo& info) {
+            if (info.chunk_index == 2) {
+                options.token.cancel();
+            }
+        };
+        options.dispatch = nullptr;     // Events on the worker, so the cancel lands mid-stream
+        bool cancelled = false;
+        std::atomic<bool> done{false};
+        auto body = [&]() -> Detached {
+            try {
+                co_await AsyncCrypto::encrypt_file((dir / "input.bin").string(), (dir / "enc.fvlt").string(), "pw",
+                                                   config, options);
+            } catch (const TaskCancelled&) {
+                cancelled = true;
+            }
+            done = true;
+        };
+        body();
+        while (!done) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        REQUIRE(cancelled);
+    }
+
+    fs::remove_all(dir);
+}
@@ -0,0 +1,113 @@
+/**
+ * @file test_buffer_pool.cpp
+ * @brief Unit tests for the reusable buffer pool
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/core/buffer_pool.hpp"
+#include "filevault/core/numa.hpp"
+#include <vector>
+
+using filevault::core::BufferPool;
+using filevault::core::Numa;
+
+TEST_CASE("BufferPool reuse", "[buffer_pool]") {
+    BufferPool pool(1024 * 1024);
+    
+    SECTION("Released buffer is handed out again") {
+        auto buffer = pool.acquire(64 * 1024);
+        REQUIRE(buffer.empty());
+        REQUIRE(buffer.capacity() >= 64 * 1024);
+        
+        buffer.resize(1000, 0xAA);
+        const uint8_t* storage = buffer.data();
+        pool.release(std::move(buffer));
+        REQUIRE(pool.cached_bytes() >= 64 * 1024);
+        
+        auto reused = pool.acquire(60 * 1024);
+        REQUIRE(reused.data() == storage);
+        REQUIRE(reused.empty());
+        REQUIRE(pool.cached_bytes() == 0);
+    }
+    
+    SECTION("Large buffers are not given to small requests") {
+        auto big = pool.acquire(512 * 1024);
+        pool.release(std::move(big));
+        
+        auto small = pool.acquire(16 * 1024);
+        REQUIRE(small.capacity() < 512 * 1024);
+        REQUIRE(pool.cached_bytes() >= 512 * 1024);
+    }
+    
+    SECTION("Cache stays within budget") {
+        for (int i = 0; i < 8; ++i) {
+            pool.release(std::vector<uint8_t>(256 * 1024));
+        }
+        REQUIRE(pool.cached_bytes() <= 1024 * 1024);
+        
+        pool.clear();
+        REQUIRE(pool.cached_bytes() == 0);
+    }
+    
+    SECTION("Shrinking the budget drops buffers") {
+        pool.release(std::vector<uint8_t>(512 * 1024));
+        pool.release(std::vector<uint8_t>(128 * 1024));
+        pool.set_max_cached_bytes(200 * 1024);
+        REQUIRE(pool.cached_bytes() == 128 * 1024);
+        pool.release(std::vector<uint8_t>(128 * 1024));
+        REQUIRE(pool.cached_bytes() == 128 * 1024);
+    }
+    
+    SECTION("Tiny buffers are not cached") {
+        pool.release(std::vector<uint8_t>(100));
+        REQUIRE(pool.cached_bytes() == 0);
+    }
+    
+    SECTION("Huge pages are requested for large fresh buffers") {
+        pool.set_huge_pages(true);
+        REQUIRE(pool.huge_pages());
+        auto big = pool.acquire(8 * 1024 * 1024);
+        REQUIRE(big.capacity() >= 8 * 1024 * 1024);
+        big.resize(8 * 1024 * 1024, 0x5A);
+        REQUIRE(big[big.size() - 1] == 0x5A);
+        
+        // Nothing 2MB-aligned inside a small range
+        std::vector<uint8_t> small(64 * 1024);
+        REQUIRE_FALSE(BufferPool::advise_huge_pages(small.data(), small.size()));
+        if (BufferPool::transparent_huge_page_mode() == "madvise" ||
+            BufferPool::transparent_huge_page_mode() == "always") {
+            REQUIRE(BufferPool::advise_huge_pages(big.data(), big.capacity()));
+        }
+    }
+}
+
+TEST_CASE("NUMA placement", "[buffer_pool][numa]") {
+    SECTION("Kernel CPU lists parse") {
+        REQUIRE(Numa::parse_cpu_list("0-3,8,10-11\n") == std::vector<size_t>{0, 1, 2, 3, 8, 10, 11});
+        REQUIRE(Numa::parse_cpu_list("5") == std::vector<size_t>{5});
+        REQUIRE(Numa::parse_cpu_list("").empty());
+    }
+    
+    SECTION("Every CPU belongs to a node") {
+        REQUIRE(Numa::node_count() >= 1);
+        for (size_t node = 0; node < Numa::node_count(); ++node) {
+            for (size_t cpu : Numa::node_cpus(node)) {
+                REQUIRE(Numa::node_of_cpu(cpu) == node);
+            }
+        }
+        REQUIRE(Numa::current_node() < Numa::node_count());
+    }
+    
+    SECTION("Buffers are reused with placement on") {
+        // Stay on one node, so acquire and release see the same one
+        Numa::pin_current_thread(Numa::current_node());
+        Numa::set_enabled(true);
+        BufferPool pool(1024 * 1024);
+        auto buffer = pool.acquire(64 * 1024);
+        buffer.resize(64 * 1024, 0x11);
+        const uint8_t* storage = buffer.data();
+        pool.release(std::move(buffer));
+        REQUIRE(pool.acquire(64 * 1024).data() == storage);
+        Numa::set_enabled(false);
+    }
+}
@@ -0,0 +1,228 @@
+/**
+ * @file test_envelope.cpp
+ * @brief Unit tests for public-key (envelope) streaming encryption
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/core/envelope.hpp"
+#include "filevault/algorithms/asymmetric/ecc.hpp"
+#include "filevault/algorithms/asymmetric/rsa.hpp"
+#include "filevault/algorithms/pqc/post_quantum.hpp"
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace filevault::core;
+using namespace filevault::algorithms;
+
+namespace {
+
+std::vector<uint8_t> make_data(size_t size) {
+    std::vector<uint8_t> data(size);
+    std::mt19937 gen(4321);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(gen());
+    }
+    return data;
+}
+
+std::string to_string(const std::vector<uint8_t>& data) {
+    return std::string(data.begin(), data.end());
+}
+
+StreamingConfig small_chunk_config() {
+    StreamingConfig config;
+    config.chunk_size = 4096;
+    config.worker_threads = 2;
+    return config;
+}
+
+/**
+ * @brief Encrypt to public_key, decrypt with private_key, return the plaintext
+ */
+std::string round_trip(const std::vector<uint8_t>& data,
+                       const std::vector<uint8_t>& public_key,
+                       const std::vector<uint8_t>& private_key) {
+    std::istringstream input(to_string(data));
+    std::ostringstream encrypted;
+    auto enc = EnvelopeCrypto::encrypt_stream(input, encrypted, public_key, data.size(), small_chunk_config());
+    REQUIRE(enc.success);
+    REQUIRE(enc.chunks_processed == (data.size() + 4095) / 4096);
+
+    std::istringstream sealed(encrypted.str());
+    std::ostringstream decrypted;
+    auto dec = EnvelopeCrypto::decrypt_stream(sealed, decrypted, private_key, nullptr, 2);
+    REQUIRE(dec.success);
+    return decrypted.str();
+}
+
+} // anonymous namespace
+
+TEST_CASE("Envelope encryption round trip", "[envelope]") {
+    auto data = make_data(4096 * 5 + 77);
+
+    SECTION("RSA recipient") {
+        asymmetric::RSA rsa(2048);
+        auto keys = rsa.generate_key_pair();
+        REQUIRE(EnvelopeCrypto::key_algorithm(keys.public_key) == AlgorithmType::RSA_2048);
+        REQUIRE(round_trip(data, keys.public_key, keys.private_key) == to_string(data));
+    }
+
+    SECTION("ECC recipient") {
+        asymmetric::ECCHybrid ecc(asymmetric::ECCurve::SECP384R1);
+        auto keys = ecc.generate_key_pair();
+        REQUIRE(EnvelopeCrypto::key_algorithm(keys.private_key) == AlgorithmType::ECC_P384);
+        REQUIRE(round_trip(data, keys.public_key, keys.private_key) == to_string(data));
+    }
+
+    SECTION("X25519 recipient") {
+        asymmetric::ECCHybrid ecc(asymmetric::ECCurve::X25519);
+        auto keys = ecc.generate_key_pair();
+        REQUIRE(EnvelopeCrypto::key_algorithm(keys.public_key) == AlgorithmType::ECC_X25519);
+        REQUIRE(round_trip(data, keys.public_key, keys.private_key) == to_string(data));
+    }
+
+    SECTION("Kyber recipient") {
+        pqc::Kyber kyber(pqc::Kyber::Variant::Kyber768);
+        auto keys = kyber.generate_keypair();
+        REQUIRE(EnvelopeCrypto::key_algorithm(keys.public_key) == AlgorithmType::KYBER_768_HYBRID);
+        REQUIRE(round_trip(data, keys.public_key, keys.private_key) == to_string(data));
+    }
+
+    SECTION("Input of unknown length") {
+        asymmetric::ECCHybrid ecc(asymmetric::ECCurve::SECP256R1);
+        auto keys = ecc.generate_key_pair();
+
+        std::istringstream input(to_string(data));
+        std::ostringstream encrypted;
+        REQUIRE(EnvelopeCrypto::encrypt_stream(input, encrypted, keys.public_key, std::nullopt,
+                                               small_chunk_config()).success);
+
+        std::istringstream sealed(encrypted.str());
+        std::ostringstream decrypted;
+        REQUIRE(EnvelopeCrypto::decrypt_stream(sealed, decrypted, keys.private_key).success);
+        REQUIRE(decrypted.str() == to_string(data));
+    }
+}
+
+TEST_CASE("Envelope decryption failures", "[envelope]") {
+    auto data = make_data(10000);
+    asymmetric::ECCHybrid ecc(asymmetric::ECCurve::SECP256R1);
+    auto keys = ecc.generate_key_pair();
+
+    std::istringstream input(to_string(data));
+    std::ostringstream encrypted;
+    REQUIRE(EnvelopeCrypto::encrypt_stream(input, encrypted, keys.public_key, data.size(),
+                                           small_chunk_config()).success);
+    auto sealed = encrypted.str();
+
+    SECTION("Wrong private key") {
+        auto other = ecc.generate_key_pair();
+        std::istringstream in(sealed);
+        std::ostringstream out;
+        auto result = EnvelopeCrypto::decrypt_stream(in, out, other.private_key);
+        REQUIRE_FALSE(result.success);
+        REQUIRE(out.str().empty());
+    }
+
+    SECTION("Tampered payload") {
+        sealed[sealed.size() / 2] ^= 0x01;
+        std::istringstream in(sealed);
+        std::ostringstream out;
+        REQUIRE_FALSE(EnvelopeCrypto::decrypt_stream(in, out, keys.private_key).success);
+    }
+
+    SECTION("Password streams are not envelopes") {
+        std::istringstream in("FVST not an envelope");
+        std::ostringstream out;
+        REQUIRE_FALSE(EnvelopeCrypto::decrypt_stream(in, out, keys.private_key).success);
+    }
+
+    SECTION("Signing keys cannot wrap") {
+        asymmetric::ECDSA ecdsa(asymmetric::ECCurve::SECP256R1);
+        auto signing = ecdsa.generate_key_pair();
+        REQUIRE_FALSE(EnvelopeCrypto::key_algorithm(signing.public_key).has_value());
+
+        std::istringstream in(to_string(data));
+        std::ostringstream out;
+        REQUIRE_FALSE(EnvelopeCrypto::encrypt_stream(in, out, signing.public_key, data.size()).success);
+    }
+
+    SECTION("Non-AEAD stream algorithm is rejected") {
+        auto config = small_chunk_config();
+        config.algorithm = AlgorithmType::AES_256_CBC;
+        std::istringstream in(to_string(data));
+        std::ostringstream out;
+        REQUIRE_FALSE(EnvelopeCrypto::encrypt_stream(in, out, keys.public_key, data.size(), config).success);
+    }
+}
+
+TEST_CASE("Envelope encryption for several recipients", "[envelope][recipients]") {
+    auto data = make_data(4096 * 3 + 5);
+
+    asymmetric::RSA rsa(2048);
+    asymmetric::ECCHybrid ecc(asymmetric::ECCurve::SECP256R1);
+    pqc::Kyber kyber(pqc::Kyber::Variant::Kyber512);
+    auto rsa_keys = rsa.generate_key_pair();
+    auto ecc_keys = ecc.generate_key_pair();
+    auto other_ecc_keys = ecc.generate_key_pair();
+    auto kyber_keys = kyber.generate_keypair();
+
+    std::vector<std::vector<uint8_t>> public_keys = {
+        rsa_keys.public_key, ecc_keys.public_key, other_ecc_keys.public_key, kyber_keys.public_key
+    };
+
+    std::istringstream input(to_string(data));
+    std::ostringstream encrypted;
+    auto enc = EnvelopeCrypto::encrypt_stream(input, encrypted, public_keys, data.size(), small_chunk_config());
+    REQUIRE(enc.success);
+    REQUIRE(enc.bytes_processed == data.size());
+    auto sealed = encrypted.str();
+
+    SECTION("Every recipient decrypts the one payload") {
+        for (const auto* private_key : {&rsa_keys.private_key, &ecc_keys.private_key,
+                                        &other_ecc_keys.private_key, &kyber_keys.private_key}) {
+            std::istringstream in(sealed);
+            std::ostringstream out;
+            REQUIRE(EnvelopeCrypto::decrypt_stream(in, out, *private_key).success);
+            REQUIRE(out.str() == to_string(data));
+        }
+    }
+
+    SECTION("Each recipient adds one wrapped key, not another payload") {
+        std::istringstream single_input(to_string(data));
+        std::ostringstream single;
+        REQUIRE(EnvelopeCrypto::encrypt_stream(single_input, single, ecc_keys.public_key, data.size(),
+                                               small_chunk_config()).success);
+        REQUIRE(sealed.size() < single.str().size() + 4096);
+    }
+
+    SECTION("Duplicate keys get one slot") {
+        std::istringstream once_input(to_string(data));
+        std::ostringstream once;
+        REQUIRE(EnvelopeCrypto::encrypt_stream(once_input, once, ecc_keys.public_key, data.size(),
+                                               small_chunk_config()).success);
+
+        std::istringstream twice_input(to_string(data));
+        std::ostringstream twice;
+        std::vector<std::vector<uint8_t>> duplicated = {ecc_keys.public_key, ecc_keys.public_key};
+        REQUIRE(EnvelopeCrypto::encrypt_stream(twice_input, twice, duplicated, data.size(),
+                                               small_chunk_config()).success);
+        REQUIRE(twice.str().size() == once.str().size());
+    }
+
+    SECTION("Non-recipients are rejected") {
+        auto stranger = ecc.generate_key_pair();
+        std::istringstream in(sealed);
+        std::ostringstream out;
+        REQUIRE_FALSE(EnvelopeCrypto::decrypt_stream(in, out, stranger.private_key).success);
+    }
+
+    SECTION("Empty recipient list") {
+        std::istringstream in(to_string(data));
+        std::ostringstream out;
+        REQUIRE_FALSE(EnvelopeCrypto::encrypt_stream(in, out, std::vector<std::vector<uint8_t>>{},
+                                                     data.size()).success);
+    }
+}
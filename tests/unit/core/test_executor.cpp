@@ -0,0 +1,190 @@
+/**
+ * @file test_executor.cpp
+ * @brief Unit tests for the shared executor and task groups
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/core/executor.hpp"
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <stdexcept>
+#include <vector>
+
+using filevault::core::CancellationToken;
+using filevault::core::Executor;
+using filevault::core::TaskCancelled;
+using filevault::core::TaskGroup;
+using filevault::core::TaskPriority;
+
+TEST_CASE("Executor runs tasks", "[executor]") {
+    Executor executor(4);
+    REQUIRE(executor.size() == 4);
+
+    SECTION("Results and exceptions reach the future") {
+        auto value = executor.submit([]() { return 6 * 7; });
+        auto failure = executor.submit([]() -> int { throw std::runtime_error("boom"); });
+        REQUIRE(value.get() == 42);
+        REQUIRE_THROWS_AS(failure.get(), std::runtime_error);
+    }
+
+    SECTION("Tasks spawned from workers run and can be waited on") {
+        // Waiting inside a worker would deadlock a plain pool of 4 threads
+        auto outer = executor.submit([&executor]() {
+            std::vector<std::future<int>> inner;
+            for (int i = 0; i < 64; ++i) {
+                inner.push_back(executor.submit([i]() { return i; }));
+            }
+            int sum = 0;
+            for (auto& future : inner) {
+                sum += executor.wait(future);
+            }
+            return sum;
+        });
+        REQUIRE(outer.get() == 64 * 63 / 2);
+    }
+
+    SECTION("A cancelled token skips tasks not started") {
+        auto token = CancellationToken::create();
+        token.cancel();
+        auto skipped = executor.submit([]() { return 1; }, TaskPriority::LOW, token);
+        REQUIRE_THROWS_AS(skipped.get(), TaskCancelled);
+    }
+
+    SECTION("Destructor drains queued tasks") {
+        std::atomic<int> done{0};
+        {
+            Executor local(2);
+            for (int i = 0; i < 200; ++i) {
+                local.post([&done]() { done.fetch_add(1); });
+            }
+        }
+        REQUIRE(done.load() == 200);
+    }
+}
+
+TEST_CASE("Executor priorities and backpressure", "[executor]") {
+    SECTION("Higher priorities are taken first") {
+        Executor executor(1);
+        std::promise<void> gate;
+        auto blocker = executor.submit([opened = gate.get_future().share()]() { opened.wait(); });
+
+        std::mutex order_mutex;
+        std::vector<int> order;
+        auto record = [&](int id) {
+            return [&, id]() {
+                std::lock_guard<std::mutex> lock(order_mutex);
+                order.push_back(id);
+            };
+        };
+        auto low = executor.submit(record(2), TaskPriority::LOW);
+        auto normal = executor.submit(record(1), TaskPriority::NORMAL);
+        auto high = executor.submit(record(0), TaskPriority::HIGH);
+        gate.set_value();
+        blocker.get();
+        low.get();
+        normal.get();
+        high.get();
+        REQUIRE(order == std::vector<int>{0, 1, 2});
+    }
+
+    SECTION("try_post refuses work once the queue is full") {
+        Executor executor(1, 2);
+        std::promise<void> gate;
+        auto opened = gate.get_future().share();
+        auto blocker = executor.submit([opened]() { opened.wait(); });
+        while (executor.pending() > 0) {
+            std::this_thread::yield();
+        }
+
+        REQUIRE(executor.try_post([]() {}));
+        REQUIRE(executor.try_post([]() {}));
+        REQUIRE_FALSE(executor.try_post([]() {}));
+        gate.set_value();
+        blocker.get();
+    }
+}
+
+TEST_CASE("TaskGroup caps concurrency", "[executor]") {
+    Executor executor(8);
+
+    SECTION("At most max_concurrency tasks run at once") {
+        std::atomic<int> running{0};
+        std::atomic<int> peak{0};
+        std::vector<std::future<int>> results;
+        {
+            TaskGroup group(executor, 2);
+            REQUIRE(group.size() == 2);
+            for (int i = 0; i < 32; ++i) {
+                results.push_back(group.submit([&, i]() {
+                    int now = running.fetch_add(1) + 1;
+                    int seen = peak.load();
+                    while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+                    }
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+                    running.fetch_sub(1);
+                    return i;
+                }));
+            }
+            int sum = 0;
+            for (auto& future : results) {
+                sum += group.wait(future);
+            }
+            REQUIRE(sum == 32 * 31 / 2);
+        }
+        // The waiting thread may run one inline on top of the cap
+        REQUIRE(peak.load() <= 3);
+    }
+
+    SECTION("Destructor waits for unfinished tasks") {
+        std::atomic<int> done{0};
+        {
+            TaskGroup group(executor, 3);
+            for (int i = 0; i < 50; ++i) {
+                group.submit([&done]() { done.fetch_add(1); });
+            }
+        }
+        REQUIRE(done.load() == 50);
+    }
+
+    SECTION("cancel() drops the tasks still waiting") {
+        std::promise<void> gate;
+        auto opened = gate.get_future().share();
+        std::promise<void> started;
+        TaskGroup group(executor, 1);
+        auto first = group.submit([opened, &started]() {
+            started.set_value();
+            opened.wait();
+            return 1;
+        });
+        auto second = group.submit([]() { return 2; });
+        started.get_future().wait();
+        group.cancel();
+        gate.set_value();
+        REQUIRE(first.get() == 1);
+        REQUIRE_THROWS_AS(second.get(), TaskCancelled);
+    }
+
+    SECTION("Groups nested on the same executor do not deadlock") {
+        TaskGroup outer(executor, 4);
+        std::vector<std::future<int>> totals;
+        for (int job = 0; job < 8; ++job) {
+            totals.push_back(outer.submit([&executor]() {
+                TaskGroup inner(executor, 2);
+                std::vector<std::future<int>> parts;
+                for (int i = 1; i <= 10; ++i) {
+                    parts.push_back(inner.submit([i]() { return i; }));
+                }
+                int total = 0;
+                for (auto& part : parts) {
+                    total += inner.wait(part);
+                }
+                return total;
+            }));
+        }
+        for (auto& total : totals) {
+            REQUIRE(outer.wait(total) == 55);
+        }
+    }
+}
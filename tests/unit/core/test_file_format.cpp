@@ -0,0 +1,191 @@
+/**
+ * @file test_file_format.cpp
+ * @brief Unit tests for the FVAULT01 and FVLT header codecs and algorithm traits
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/core/algorithm_traits.hpp"
+#include "filevault/core/crypto_engine.hpp"
+#include "filevault/core/file_format.hpp"
+#include "filevault/core/header_codec.hpp"
+#include "filevault/core/streaming.hpp"
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace filevault::core;
+
+namespace {
+
+FileHeader make_header() {
+    FileHeader header;
+    std::memcpy(header.magic, FILE_FORMAT_MAGIC, 8);
+    header.version_major = FILE_FORMAT_VERSION_MAJOR;
+    header.version_minor = FILE_FORMAT_VERSION_MINOR;
+    header.algorithm = AlgorithmID::AES_256_GCM;
+    header.kdf = KDFID::ARGON2ID;
+    header.compression = CompressionID::ZSTD;
+    std::memset(header.reserved, 0, 3);
+    header.salt.assign(32, 0x11);
+    header.kdf_params = Argon2Params{}.serialize();
+    header.nonce.assign(12, 0x22);
+    header.compressed = true;
+    return header;
+}
+
+} // anonymous namespace
+
+TEST_CASE("FVAULT01 header codec", "[file_format]") {
+    auto header = make_header();
+
+    SECTION("Round trip, with and without a dictionary") {
+        for (uint32_t dictionary : {0u, 0x1a2b3c4du}) {
+            header.set_dictionary_id(dictionary);
+            auto bytes = header.serialize();
+            REQUIRE(bytes.size() == header.size());
+
+            auto [parsed, consumed] = FileHeader::deserialize(bytes);
+            REQUIRE(consumed == bytes.size());
+            REQUIRE(parsed.is_valid());
+            REQUIRE(parsed.algorithm == header.algorithm);
+            REQUIRE(parsed.compression == header.compression);
+            REQUIRE(parsed.salt == header.salt);
+            REQUIRE(parsed.kdf_params == header.kdf_params);
+            REQUIRE(parsed.nonce == header.nonce);
+            REQUIRE(parsed.compressed);
+            REQUIRE(parsed.dictionary_id == dictionary);
+            REQUIRE(parsed.version_minor == header.version_minor);
+        }
+    }
+
+    SECTION("Key check value") {
+        std::vector<uint8_t> key(32, 0x5a), other(32, 0x5b);
+        REQUIRE(header.matches_key(other));   // No check value: nothing to reject on
+
+        header.set_dictionary_id(0x1a2b3c4du);
+        header.set_key_check(key);
+        REQUIRE(header.version_minor == FILE_FORMAT_VERSION_MINOR_KEY_CHECK);
+        REQUIRE(header.key_check.size() == KEY_CHECK_SIZE);
+        REQUIRE(header.key_check == FileHeader::compute_key_check(key));
+
+        auto bytes = header.serialize();
+        REQUIRE(bytes.size() == header.size());
+        auto [parsed, consumed] = FileHeader::deserialize(bytes);
+        REQUIRE(consumed == bytes.size());
+        REQUIRE(parsed.dictionary_id == 0x1a2b3c4du);
+        REQUIRE(parsed.key_check == header.key_check);
+        REQUIRE(parsed.matches_key(key));
+        REQUIRE_FALSE(parsed.matches_key(other));
+    }
+
+    SECTION("write_to emits the serialized bytes") {
+        std::ostringstream out;
+        REQUIRE(header.write_to(out));
+        auto bytes = header.serialize();
+        REQUIRE(out.str() == std::string(bytes.begin(), bytes.end()));
+    }
+
+    SECTION("Views point into the parsed buffer") {
+        auto bytes = header.serialize();
+        bytes.push_back(0xAB);  // Ciphertext after the header is left alone
+
+        auto view = FileHeaderView::parse(bytes);
+        REQUIRE(view.size == bytes.size() - 1);
+        REQUIRE(view.salt.data() == bytes.data() + 16);
+        REQUIRE(view.nonce.size() == 12);
+        REQUIRE(view.nonce.data() >= bytes.data());
+        REQUIRE(view.nonce.data() + 12 <= bytes.data() + bytes.size());
+    }
+
+    SECTION("Truncated and foreign headers are rejected") {
+        auto bytes = header.serialize();
+        for (size_t size : {size_t(10), size_t(40), bytes.size() - 1}) {
+            std::vector<uint8_t> cut(bytes.begin(), bytes.begin() + size);
+            REQUIRE_THROWS_AS(FileHeader::deserialize(cut), std::runtime_error);
+        }
+        bytes[7] = '2';
+        REQUIRE_THROWS_AS(FileHeader::deserialize(bytes), std::runtime_error);
+    }
+
+    SECTION("Oversized fields are refused") {
+        header.nonce.assign(300, 0);
+        std::ostringstream out;
+        REQUIRE_FALSE(header.write_to(out));
+        REQUIRE(out.str().empty());
+        REQUIRE_THROWS_AS(header.serialize(), std::runtime_error);
+    }
+}
+
+TEST_CASE("FVLT legacy header codec", "[file_format]") {
+    std::vector<uint8_t> salt(32, 0x01), nonce(12, 0x02), tag(16, 0x03);
+    HeaderWriter<256> out;
+    out.u32(0x544C5646);    // "FVLT"
+    out.u8(1);
+    out.u8(0);
+    out.u8(static_cast<uint8_t>(AlgorithmType::AES_256_GCM));
+    out.u8(static_cast<uint8_t>(KDFType::ARGON2ID));
+    out.u8(static_cast<uint8_t>(SecurityLevel::MEDIUM));
+    out.u16(32);
+    out.bytes(salt);
+    out.u16(12);
+    out.bytes(nonce);
+    out.u16(16);
+    out.bytes(tag);
+    out.u64(1000);
+    out.u64(1016);
+    out.u64(1700000000);
+    out.u32(LegacyHeaderView::FLAG_COMPRESSED);
+    out.zeros(16);
+    REQUIRE_FALSE(out.overflow());
+
+    SECTION("Fields and the tag are read back") {
+        auto result = LegacyHeaderView::parse(out.data());
+        REQUIRE(result.success);
+        const auto& header = result.value;
+        REQUIRE(header.size == out.size());
+        REQUIRE(header.validate());
+        REQUIRE(header.algorithm == AlgorithmType::AES_256_GCM);
+        REQUIRE(header.is_compressed());
+        REQUIRE(header.original_size == 1000);
+        REQUIRE(std::vector<uint8_t>(header.tag.begin(), header.tag.end()) == tag);
+    }
+
+    SECTION("Truncation is an error, not a crash") {
+        auto result = LegacyHeaderView::parse(out.data().first(out.size() - 1));
+        REQUIRE_FALSE(result.success);
+        REQUIRE_FALSE(LegacyHeaderView::parse(out.data().first(32)).success);
+    }
+}
+
+TEST_CASE("Algorithm traits table", "[file_format]") {
+    SECTION("IDs round trip through the handler") {
+        for (const auto& traits : all_algorithms()) {
+            auto id = FileFormatHandler::to_algorithm_id(traits.type);
+            REQUIRE(id == traits.id);
+            if (id != AlgorithmID::UNKNOWN) {
+                REQUIRE(FileFormatHandler::from_algorithm_id(id) == traits.type);
+                REQUIRE(FileFormatHandler::has_auth_tag(id) == (traits.tag_size != 0));
+            }
+        }
+        REQUIRE(FileFormatHandler::from_algorithm_id(static_cast<AlgorithmID>(0xEE)) ==
+                AlgorithmType::AES_256_GCM);
+    }
+
+    SECTION("Names parse back to their type") {
+        for (const auto& traits : all_algorithms()) {
+            REQUIRE(CryptoEngine::parse_algorithm(std::string(traits.name)) == traits.type);
+            REQUIRE(CryptoEngine::algorithm_name(traits.type) == traits.name);
+        }
+        REQUIRE(CryptoEngine::parse_algorithm("AES") == AlgorithmType::AES_256_GCM);
+        REQUIRE(CryptoEngine::parse_algorithm("secp384r1") == AlgorithmType::ECC_P384);
+        REQUIRE_FALSE(CryptoEngine::parse_algorithm("aes-").has_value());
+    }
+
+    SECTION("Only AEAD ciphers stream") {
+        for (const auto& traits : all_algorithms()) {
+            REQUIRE(StreamingCrypto::supports_algorithm(traits.type) == traits.is_aead());
+        }
+    }
+}
@@ -0,0 +1,85 @@
+/**
+ * @file test_inline_bytes.cpp
+ * @brief Unit tests for inline nonce/tag storage and message views
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/core/inline_bytes.hpp"
+#include "filevault/core/result.hpp"
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+using filevault::core::BatchRecord;
+using filevault::core::CryptoResult;
+using filevault::core::InlineBytes;
+using filevault::core::ShortBytes;
+
+TEST_CASE("InlineBytes behaves like a small vector", "[inline_bytes]") {
+    std::vector<uint8_t> nonce = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+
+    SECTION("Converts to and from std::vector") {
+        ShortBytes inline_nonce = nonce;
+        REQUIRE(inline_nonce.size() == 12);
+        REQUIRE(inline_nonce == nonce);
+
+        std::vector<uint8_t> back = inline_nonce;
+        REQUIRE(back == nonce);
+
+        inline_nonce[0] ^= 0xFF;
+        REQUIRE_FALSE(inline_nonce == nonce);
+    }
+
+    SECTION("Optional fields accept vectors and spans") {
+        std::optional<ShortBytes> field;
+        field = nonce;
+        REQUIRE(field->size() == 12);
+        field = std::span<const uint8_t>(nonce).first(4);
+        REQUIRE(field.value() == std::vector<uint8_t>{1, 2, 3, 4});
+    }
+
+    SECTION("Resizing keeps the prefix and fills the rest") {
+        ShortBytes bytes(nonce.begin(), nonce.begin() + 2);
+        bytes.resize(4, 0xAA);
+        REQUIRE(bytes == std::vector<uint8_t>{1, 2, 0xAA, 0xAA});
+        bytes.clear();
+        REQUIRE(bytes.empty());
+    }
+
+    SECTION("More than the capacity is refused") {
+        InlineBytes<4> small;
+        REQUIRE_THROWS_AS(small = nonce, std::length_error);
+        REQUIRE(small.empty());
+        REQUIRE_THROWS_AS(small.resize(5), std::length_error);
+    }
+}
+
+TEST_CASE("Message views point into existing storage", "[inline_bytes]") {
+    SECTION("CryptoResult::view() pairs inline metadata with a caller buffer") {
+        std::vector<uint8_t> ciphertext(100, 0x5A);
+        CryptoResult result;
+        result.nonce = std::vector<uint8_t>(12, 1);
+        result.tag = std::vector<uint8_t>(16, 2);
+
+        auto view = result.view(ciphertext);
+        REQUIRE(view.data.data() == ciphertext.data());
+        REQUIRE(view.data.size() == 100);
+        REQUIRE(view.nonce.data() == result.nonce->data());
+        REQUIRE(view.tag.size() == 16);
+    }
+
+    SECTION("BatchRecord::view() splits an arena record") {
+        std::vector<uint8_t> arena(4 + 12 + 8 + 16);
+        BatchRecord record;
+        record.offset = 4;
+        record.nonce_size = 12;
+        record.data_size = 8;
+        record.tag_size = 16;
+
+        auto view = record.view(arena);
+        REQUIRE(view.nonce.data() == arena.data() + 4);
+        REQUIRE(view.data.data() == arena.data() + 16);
+        REQUIRE(view.tag.data() == arena.data() + 24);
+        REQUIRE(view.tag.size() == 16);
+    }
+}
@@ -0,0 +1,175 @@
+/**
+ * @file test_kdf_scheduler.cpp
+ * @brief Unit tests for memory-budgeted parallel key derivation
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/core/kdf_scheduler.hpp"
+#include "filevault/core/key_cache.hpp"
+#include <string>
+#include <vector>
+
+using namespace filevault::core;
+
+namespace {
+
+EncryptionConfig argon2_config() {
+    EncryptionConfig config;
+    config.kdf = KDFType::ARGON2ID;
+    config.level = SecurityLevel::WEAK;     // 4 MB per derivation
+    config.apply_security_level();
+    return config;
+}
+
+std::vector<uint8_t> salt_of(size_t i) {
+    return std::vector<uint8_t>(16, static_cast<uint8_t>(i + 1));
+}
+
+bool cached_key_matches(const std::string& password, const std::vector<uint8_t>& salt,
+                        const EncryptionConfig& config, const std::vector<uint8_t>& expected) {
+    auto& cache = KeyCache::instance();
+    std::vector<uint8_t> key;
+    return cache.lookup(cache.make_id(password, salt, config, expected.size()), key) && key == expected;
+}
+
+} // anonymous namespace
+
+TEST_CASE("KDF memory cost", "[kdf]") {
+    auto config = argon2_config();
+    REQUIRE(KdfScheduler::memory_cost(config) == 4096 * 1024);
+
+    config.kdf = KDFType::SCRYPT;
+    config.level = SecurityLevel::MEDIUM;
+    REQUIRE(KdfScheduler::memory_cost(config) == 128ull * 8 * 16384);
+
+    config.kdf = KDFType::PBKDF2_SHA256;
+    REQUIRE(KdfScheduler::memory_cost(config) == 0);
+}
+
+TEST_CASE("KDF scheduler", "[kdf]") {
+    const std::string password = "correct horse";
+    const auto config = argon2_config();
+    constexpr size_t FILES = 10;
+
+    // Reference keys, derived without the cache
+    auto& cache = KeyCache::instance();
+    cache.configure(0, std::chrono::seconds(0));
+    CryptoEngine engine;
+    engine.initialize();
+    std::vector<std::vector<uint8_t>> expected;
+    for (size_t i = 0; i < FILES; ++i) {
+        expected.push_back(engine.derive_key(password, salt_of(i), config));
+    }
+    cache.configure(KeyCache::DEFAULT_CAPACITY, KeyCache::DEFAULT_TTL);
+
+    SECTION("Parallelism follows the memory budget") {
+        KdfSchedulerOptions options;
+        options.memory_budget = 8 * 1024 * 1024;    // Two derivations
+        options.max_parallel = 8;
+        KdfScheduler scheduler(password, options);
+        std::vector<size_t> tickets;
+        for (size_t i = 0; i < FILES; ++i) {
+            tickets.push_back(scheduler.submit(salt_of(i), config));
+        }
+        for (size_t i = 0; i < FILES; ++i) {
+            REQUIRE(scheduler.wait(tickets[i]));
+            REQUIRE(cached_key_matches(password, salt_of(i), config, expected[i]));
+        }
+        auto stats = scheduler.stats();
+        REQUIRE(stats.derived == FILES);
+        REQUIRE(stats.peak_parallel <= 2);
+        REQUIRE(stats.peak_memory <= options.memory_budget);
+    }
+
+    SECTION("A derivation larger than the budget runs alone") {
+        KdfSchedulerOptions options;
+        options.memory_budget = 1024 * 1024;
+        options.max_parallel = 4;
+        KdfScheduler scheduler(password, options);
+        std::vector<size_t> tickets;
+        for (size_t i = 0; i < 4; ++i) {
+            tickets.push_back(scheduler.submit(salt_of(i), config));
+        }
+        for (size_t ticket : tickets) {
+            REQUIRE(scheduler.wait(ticket));
+        }
+        REQUIRE(scheduler.stats().peak_parallel == 1);
+    }
+
+    SECTION("Waiting out of order") {
+        KdfSchedulerOptions options;
+        options.max_parallel = 1;
+        KdfScheduler scheduler(password, options);
+        std::vector<size_t> tickets;
+        for (size_t i = 0; i < FILES; ++i) {
+            tickets.push_back(scheduler.submit(salt_of(i), config));
+        }
+        // The last ticket is moved ahead of the queue instead of waiting for all
+        REQUIRE(scheduler.wait(tickets.back()));
+        REQUIRE(cached_key_matches(password, salt_of(FILES - 1), config, expected.back()));
+        REQUIRE(scheduler.stats().derived < FILES);
+        REQUIRE(scheduler.wait(tickets.front()));
+        REQUIRE(cached_key_matches(password, salt_of(0), config, expected.front()));
+    }
+
+    SECTION("Failed derivations are reported") {
+        auto bad = config;
+        bad.kdf_parallelism = 0;
+        KdfScheduler scheduler(password);
+        REQUIRE_FALSE(scheduler.wait(scheduler.submit(salt_of(0), bad)));
+        REQUIRE(scheduler.stats().failed == 1);
+        REQUIRE_FALSE(scheduler.wait(42));
+    }
+
+    cache.clear();
+}
+
+TEST_CASE("Batch key hierarchy", "[kdf][batch]") {
+    const std::string password = "correct horse";
+    const auto config = argon2_config();
+    auto& cache = KeyCache::instance();
+    cache.clear();
+    CryptoEngine engine;
+    engine.initialize();
+
+    auto batch = CryptoEngine::generate_salt(CryptoEngine::BATCH_SALT_SIZE);
+    auto a = CryptoEngine::batch_file_salt(batch);
+    auto b = CryptoEngine::batch_file_salt(batch);
+    REQUIRE(a.size() == CryptoEngine::BATCH_FILE_SALT_SIZE);
+    REQUIRE(a != b);
+    REQUIRE(CryptoEngine::is_batch_file_salt(a));
+    REQUIRE_FALSE(CryptoEngine::is_batch_file_salt(batch));
+    auto referenced = CryptoEngine::batch_salt_of(a);
+    REQUIRE(std::vector<uint8_t>(referenced.begin(), referenced.end()) == batch);
+    REQUIRE(CryptoEngine::batch_salt_of(batch).size() == batch.size());
+
+    SECTION("Files of a batch get their own keys from one KDF run") {
+        auto misses = cache.stats().misses;
+        auto key_a = engine.derive_key(password, a, config);
+        auto key_b = engine.derive_key(password, b, config);
+        REQUIRE(cache.stats().misses == misses + 1);
+        REQUIRE(key_a.size() == 32);
+        REQUIRE(key_a != key_b);
+        REQUIRE(key_a != engine.derive_key(password, batch, config));
+
+        // The same without the cache: subkeys do not depend on it
+        cache.configure(0, std::chrono::seconds(0));
+        REQUIRE(engine.derive_key(password, a, config) == key_a);
+        cache.configure(KeyCache::DEFAULT_CAPACITY, KeyCache::DEFAULT_TTL);
+    }
+
+    SECTION("The scheduler derives a batch once") {
+        KdfScheduler scheduler(password);
+        auto ticket = scheduler.submit(a, config);
+        REQUIRE(scheduler.submit(b, config) == ticket);
+        REQUIRE(scheduler.wait(ticket));
+        REQUIRE(scheduler.wait(ticket));
+        REQUIRE(scheduler.stats().derived == 1);
+
+        auto misses = cache.stats().misses;
+        engine.derive_key(password, b, config);
+        REQUIRE(cache.stats().misses == misses);
+    }
+
+    cache.clear();
+}
@@ -0,0 +1,109 @@
+/**
+ * @file test_memory_budget.cpp
+ * @brief Unit tests for the process-wide memory limit
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/core/memory_budget.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace filevault::core;
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr uint64_t MB = 1024 * 1024;
+
+} // anonymous namespace
+
+TEST_CASE("Leases wait for the budget", "[memory]") {
+    MemoryBudget budget(100 * MB);
+
+    SECTION("Leases that fit are granted together") {
+        auto a = budget.lease(40 * MB);
+        auto b = budget.lease(60 * MB);
+        REQUIRE(budget.in_use() == 100 * MB);
+        REQUIRE(budget.try_lease(1).bytes() == 0);
+        b.release();
+        REQUIRE(budget.in_use() == 40 * MB);
+        REQUIRE(budget.peak() == 100 * MB);
+    }
+
+    SECTION("A lease that does not fit waits for a release") {
+        auto held = budget.lease(80 * MB);
+        std::atomic<bool> granted{false};
+        std::thread waiter([&] {
+            auto lease = budget.lease(40 * MB);
+            granted = true;
+        });
+        std::this_thread::sleep_for(50ms);
+        REQUIRE_FALSE(granted);
+        held.release();
+        waiter.join();
+        REQUIRE(granted);
+        REQUIRE(budget.in_use() == 0);
+    }
+
+    SECTION("A lease larger than the budget runs alone") {
+        auto big = budget.lease(150 * MB);
+        REQUIRE(big.bytes() == 150 * MB);
+        REQUIRE(budget.try_lease(1).bytes() == 0);
+        big.release();
+        REQUIRE(budget.try_lease(150 * MB).bytes() == 150 * MB);
+    }
+
+    SECTION("Without a limit leases are free") {
+        budget.set_limit(0);
+        auto a = budget.lease(1000 * MB);
+        REQUIRE(budget.try_lease(1000 * MB).bytes() == 1000 * MB);
+    }
+}
+
+TEST_CASE("Streams are fitted to their share", "[memory]") {
+    MemoryBudget::StreamShape shape{16 * MB, 8, 2};
+
+    SECTION("Unlimited: unchanged") {
+        MemoryBudget budget;
+        auto fitted = budget.fit_stream(shape, false);
+        REQUIRE(fitted.chunk_size == 16 * MB);
+        REQUIRE(fitted.workers == 8);
+        REQUIRE(fitted.io_buffers == 2);
+        REQUIRE(budget.stream_bytes(7) == 7);
+    }
+
+    SECTION("Read-ahead and workers go before the chunk size") {
+        MemoryBudget budget(512 * MB);     // 256 MB for streams
+        auto fitted = budget.fit_stream(shape, false);
+        REQUIRE(fitted.chunk_size == 16 * MB);
+        REQUIRE(fitted.io_buffers == 0);
+        REQUIRE(fitted.workers == 6);
+        REQUIRE(MemoryBudget::stream_cost(fitted) <= 256 * MB);
+    }
+
+    SECTION("A small budget shrinks the chunk too, unless it is fixed") {
+        MemoryBudget budget(64 * MB);
+        auto fitted = budget.fit_stream(shape, false);
+        REQUIRE(fitted.workers == 1);
+        REQUIRE(fitted.chunk_size == 4 * MB);
+        REQUIRE(MemoryBudget::stream_cost(fitted) <= 32 * MB);
+
+        auto fixed = budget.fit_stream(shape, true);
+        REQUIRE(fixed.chunk_size == 16 * MB);
+        REQUIRE(fixed.workers == 1);
+    }
+
+    SECTION("A small file needs a buffer per chunk only") {
+        REQUIRE(MemoryBudget::stream_cost(shape, 1) == 2 * 16 * MB);
+        REQUIRE(MemoryBudget::stream_cost(shape) == 2 * 12 * 16 * MB);
+    }
+
+    SECTION("Caches and the in-memory cutover get their shares") {
+        MemoryBudget budget(1024 * MB);
+        REQUIRE(budget.pool_bytes(2048 * MB) == 128 * MB);
+        REQUIRE(budget.pool_bytes(32 * MB) == 32 * MB);
+        REQUIRE(budget.in_memory_bytes(UINT64_MAX) == 128 * MB);
+        REQUIRE(budget.kdf_bytes(0) == 256 * MB);
+    }
+}
@@ -0,0 +1,234 @@
+/**
+ * @file test_offload.cpp
+ * @brief Unit tests for keystream offload and its reference kernels
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/core/crypto_engine.hpp"
+#include "filevault/core/offload.hpp"
+#include <random>
+#include <string>
+
+using namespace filevault;
+using namespace filevault::core;
+
+namespace {
+
+std::vector<uint8_t> from_hex(const std::string& hex) {
+    std::vector<uint8_t> out;
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        out.push_back(static_cast<uint8_t>(std::stoul(hex.substr(i, 2), nullptr, 16)));
+    }
+    return out;
+}
+
+std::vector<uint8_t> random_bytes(size_t size, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::vector<uint8_t> data(size);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(gen());
+    }
+    return data;
+}
+
+/**
+ * Device that runs the reference kernels and counts its calls
+ */
+class HostDevice : public IKeystreamDevice {
+public:
+    explicit HostDevice(int* calls) : calls_(calls) {}
+
+    std::string name() const override { return "host"; }
+
+    OffloadStatus aes_ctr(std::span<const uint8_t> key, std::span<const uint8_t, 16> counter,
+                          std::span<uint8_t> data) override {
+        ++*calls_;
+        keystream::aes_ctr_xor(key, counter, data);
+        return OffloadStatus::DONE;
+    }
+
+    OffloadStatus chacha20(std::span<const uint8_t, 32> key, std::span<const uint8_t, 12> nonce,
+                           uint32_t counter, std::span<uint8_t> data) override {
+        ++*calls_;
+        keystream::chacha20_xor(key, nonce, counter, data);
+        return OffloadStatus::DONE;
+    }
+
+private:
+    int* calls_;
+};
+
+/**
+ * Device whose AES-CTR output is off by one bit in the last byte
+ */
+class BrokenDevice : public HostDevice {
+public:
+    using HostDevice::HostDevice;
+
+    OffloadStatus aes_ctr(std::span<const uint8_t> key, std::span<const uint8_t, 16> counter,
+                          std::span<uint8_t> data) override {
+        auto status = HostDevice::aes_ctr(key, counter, data);
+        data.back() ^= 1;
+        return status;
+    }
+};
+
+} // anonymous namespace
+
+TEST_CASE("AES reference kernel matches FIPS-197", "[offload]") {
+    std::array<uint32_t, keystream::AES_MAX_ROUND_WORDS> round_keys{};
+    auto plaintext = from_hex("00112233445566778899aabbccddeeff");
+    uint8_t out[16];
+
+    REQUIRE(keystream::aes_expand_key(from_hex("000102030405060708090a0b0c0d0e0f"), round_keys) == 10);
+    keystream::aes_encrypt_block(round_keys, 10, plaintext.data(), out);
+    REQUIRE(std::vector<uint8_t>(out, out + 16) == from_hex("69c4e0d86a7b0430d8cdb78070b4c55a"));
+
+    REQUIRE(keystream::aes_expand_key(from_hex("000102030405060708090a0b0c0d0e0f1011121314151617"),
+                                      round_keys) == 12);
+    keystream::aes_encrypt_block(round_keys, 12, plaintext.data(), out);
+    REQUIRE(std::vector<uint8_t>(out, out + 16) == from_hex("dda97ca4864cdfe06eaf70a0ec0d7191"));
+
+    auto key256 = from_hex("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f");
+    REQUIRE(keystream::aes_expand_key(key256, round_keys) == 14);
+    keystream::aes_encrypt_block(round_keys, 14, plaintext.data(), out);
+    REQUIRE(std::vector<uint8_t>(out, out + 16) == from_hex("8ea2b7ca516745bfeafc49904b496089"));
+
+    REQUIRE(keystream::aes_expand_key(std::vector<uint8_t>(20), round_keys) == 0);
+}
+
+TEST_CASE("AES-CTR reference kernel matches SP 800-38A", "[offload]") {
+    auto key = from_hex("2b7e151628aed2a6abf7158809cf4f3c");
+    auto counter = from_hex("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+    auto data = from_hex("6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51");
+
+    keystream::aes_ctr_xor(key, std::span<const uint8_t, 16>(counter.data(), 16), data);
+    REQUIRE(data == from_hex("874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff"));
+
+    SECTION("The counter carries across all 128 bits") {
+        std::array<uint8_t, 16> block;
+        block.fill(0xFF);
+        keystream::add_counter(block, 1);
+        REQUIRE(std::all_of(block.begin(), block.end(), [](uint8_t b) { return b == 0; }));
+
+        std::copy(counter.begin(), counter.end(), block.begin());
+        keystream::add_counter(block, 0x102);
+        REQUIRE(std::vector<uint8_t>(block.begin(), block.end()) ==
+                from_hex("f0f1f2f3f4f5f6f7f8f9fafbfcfe0001"));
+    }
+
+    SECTION("Any split point gives the same keystream") {
+        auto whole = random_bytes(1000, 1);
+        auto split = whole;
+        keystream::aes_ctr_xor(key, std::span<const uint8_t, 16>(counter.data(), 16), whole);
+
+        std::array<uint8_t, 16> later;
+        std::copy(counter.begin(), counter.end(), later.begin());
+        keystream::aes_ctr_xor(key, later, std::span<uint8_t>(split).first(480));
+        keystream::add_counter(later, 30);
+        keystream::aes_ctr_xor(key, later, std::span<uint8_t>(split).subspan(480));
+        REQUIRE(split == whole);
+    }
+}
+
+TEST_CASE("ChaCha20 reference kernel matches RFC 8439", "[offload]") {
+    auto key = from_hex("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f");
+    std::span<const uint8_t, 32> key_span(key.data(), 32);
+
+    SECTION("Block function (2.3.2)") {
+        auto nonce = from_hex("000000090000004a00000000");
+        uint8_t block[64];
+        keystream::chacha20_block(key_span, std::span<const uint8_t, 12>(nonce.data(), 12), 1, block);
+        REQUIRE(std::vector<uint8_t>(block, block + 16) == from_hex("10f1e7e4d13b5915500fdd1fa32071c4"));
+        REQUIRE(std::vector<uint8_t>(block + 48, block + 64) == from_hex("b5129cd1de164eb9cbd083e8a2503c4e"));
+    }
+
+    SECTION("Encryption (2.4.2)") {
+        auto nonce = from_hex("000000000000004a00000000");
+        std::string text = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for "
+                           "the future, sunscreen would be it.";
+        std::vector<uint8_t> data(text.begin(), text.end());
+        keystream::chacha20_xor(key_span, std::span<const uint8_t, 12>(nonce.data(), 12), 1, data);
+        REQUIRE(data.size() == 114);
+        REQUIRE(std::vector<uint8_t>(data.begin(), data.begin() + 16) ==
+                from_hex("6e2e359a2568f98041ba0728dd0d6981"));
+        REQUIRE(std::vector<uint8_t>(data.end() - 2, data.end()) == from_hex("874d"));
+    }
+}
+
+TEST_CASE("Offload selection", "[offload]") {
+    REQUIRE(Offload::parse_mode("off") == OffloadMode::OFF);
+    REQUIRE(Offload::parse_mode("auto") == OffloadMode::AUTO);
+    REQUIRE(Offload::parse_mode("opencl") == OffloadMode::OPENCL);
+    REQUIRE_FALSE(Offload::parse_mode("cuda").has_value());
+
+    Offload::configure(OffloadMode::OFF);
+    REQUIRE(Offload::device() == nullptr);
+
+    int calls = 0;
+    Offload::install(std::make_unique<HostDevice>(&calls), 1024);
+    REQUIRE(Offload::device() != nullptr);
+    REQUIRE(Offload::min_bytes() == 1024);
+
+    Offload::disable("test");
+    REQUIRE(Offload::device() == nullptr);
+    Offload::configure(OffloadMode::OFF);
+}
+
+TEST_CASE("Offload self-test", "[offload]") {
+    int calls = 0;
+    std::string detail;
+    HostDevice host(&calls);
+    REQUIRE(Offload::self_test(host, detail));
+    REQUIRE(calls == 3);
+
+    BrokenDevice broken(&calls);
+    REQUIRE_FALSE(Offload::self_test(broken, detail));
+    REQUIRE(detail.find("AES-128-CTR") != std::string::npos);
+}
+
+TEST_CASE("Offloaded sessions match the CPU sessions", "[offload][session]") {
+    CryptoEngine engine;
+    engine.initialize();
+
+    for (auto type : {AlgorithmType::AES_128_GCM, AlgorithmType::AES_256_GCM, AlgorithmType::CHACHA20_POLY1305}) {
+        auto* algorithm = engine.get_algorithm(type);
+        REQUIRE(algorithm != nullptr);
+        auto key = random_bytes(algorithm->key_size(), 2);
+
+        Offload::configure(OffloadMode::OFF);
+        auto cpu = algorithm->create_session(key);
+        int calls = 0;
+        Offload::install(std::make_unique<HostDevice>(&calls), 4096);
+        auto offload = algorithm->create_session(key);
+
+        for (size_t size : {size_t{100}, size_t{4096}, size_t{70000 + 5}}) {
+            auto plaintext = random_bytes(size, static_cast<unsigned>(size));
+            EncryptionConfig config;
+            config.nonce = ShortBytes(12, 0x42);
+            config.associated_data = std::vector<uint8_t>{'h', 'e', 'a', 'd', 'e', 'r'};
+
+            auto expected = plaintext;
+            auto cpu_result = cpu->encrypt_in_place(expected, config);
+            auto actual = plaintext;
+            int before = calls;
+            auto offload_result = offload->encrypt_in_place(actual, config);
+            REQUIRE(offload_result.success);
+            REQUIRE(calls == before + (size >= 4096 ? 1 : 0));
+            REQUIRE(actual == expected);
+            REQUIRE(offload_result.tag == cpu_result.tag);
+
+            config.tag = cpu_result.tag;
+            REQUIRE(offload->decrypt_in_place(actual, config).success);
+            REQUIRE(actual == plaintext);
+
+            if (size >= 4096) {
+                auto tampered = expected;
+                tampered[size / 2] ^= 1;
+                REQUIRE_FALSE(offload->decrypt_in_place(tampered, config).success);
+                REQUIRE(tampered.empty());
+            }
+        }
+    }
+    Offload::configure(OffloadMode::OFF);
+}
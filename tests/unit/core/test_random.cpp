@@ -0,0 +1,86 @@
+/**
+ * @file test_random.cpp
+ * @brief Unit tests for the RNG service and counter nonces
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/core/random.hpp"
+#include <set>
+#include <thread>
+#include <vector>
+
+using filevault::core::CounterNonce;
+using filevault::core::RandomService;
+
+TEST_CASE("RandomService", "[random]") {
+    SECTION("Returns the requested length") {
+        REQUIRE(RandomService::bytes(0).empty());
+        REQUIRE(RandomService::bytes(32).size() == 32);
+    }
+    
+    SECTION("Successive draws differ") {
+        REQUIRE(RandomService::bytes(16) != RandomService::bytes(16));
+    }
+    
+    SECTION("Each thread has its own generator") {
+        auto* main_rng = &RandomService::rng();
+        Botan::RandomNumberGenerator* other_rng = nullptr;
+        std::thread([&other_rng]() { other_rng = &RandomService::rng(); }).join();
+        REQUIRE(main_rng == &RandomService::rng());
+        REQUIRE(other_rng != main_rng);
+    }
+}
+
+TEST_CASE("CounterNonce", "[random][nonce]") {
+    SECTION("Consecutive nonces share the prefix and count up") {
+        CounterNonce nonces(12);
+        auto first = nonces.next();
+        auto second = nonces.next();
+        REQUIRE(first.size() == 12);
+        REQUIRE(std::equal(first.begin(), first.begin() + 4, second.begin()));
+        
+        uint64_t a = 0, b = 0;
+        for (size_t i = 4; i < 12; ++i) {
+            a = (a << 8) | first[i];
+            b = (b << 8) | second[i];
+        }
+        REQUIRE(b == a + 1);
+    }
+    
+    SECTION("next_n matches repeated next") {
+        CounterNonce nonces(12);
+        std::vector<uint8_t> range(3 * 12);
+        nonces.next_n(range, 3);
+        auto after = nonces.next();
+        REQUIRE(after[11] == static_cast<uint8_t>(range[35] + 1));
+    }
+    
+    SECTION("Unique across threads") {
+        CounterNonce nonces(12);
+        std::vector<std::vector<std::vector<uint8_t>>> drawn(4);
+        std::vector<std::thread> threads;
+        for (auto& out : drawn) {
+            threads.emplace_back([&nonces, &out]() {
+                for (int i = 0; i < 1000; ++i) {
+                    out.push_back(nonces.next());
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        
+        std::set<std::vector<uint8_t>> unique;
+        for (const auto& out : drawn) {
+            unique.insert(out.begin(), out.end());
+        }
+        REQUIRE(unique.size() == 4000);
+    }
+    
+    SECTION("Rejects nonces shorter than the counter") {
+        REQUIRE_THROWS(CounterNonce(4));
+        CounterNonce nonces(12);
+        std::vector<uint8_t> wrong(11);
+        REQUIRE_THROWS(nonces.next(wrong));
+    }
+}
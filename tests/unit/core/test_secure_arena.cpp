@@ -0,0 +1,112 @@
+/**
+ * @file test_secure_arena.cpp
+ * @brief Unit tests for the locked key-material arena
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/core/secure_arena.hpp"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace filevault::core;
+
+namespace {
+
+bool all_zero(const void* data, size_t size) {
+    auto* bytes = static_cast<const uint8_t*>(data);
+    return std::all_of(bytes, bytes + size, [](uint8_t b) { return b == 0; });
+}
+
+} // anonymous namespace
+
+TEST_CASE("Arena blocks come from the region and are reused zeroed", "[secure_arena]") {
+    SecureArena arena(16 * 1024);
+    REQUIRE(arena.stats().capacity == 16 * 1024);
+
+    void* first = arena.allocate(32);
+    REQUIRE(arena.owns(first));
+    REQUIRE(all_zero(first, 32));
+    std::memset(first, 0xAB, 32);
+    arena.deallocate(first, 32);
+
+    // Same size class, so the freed block comes back, wiped
+    void* second = arena.allocate(20);
+    REQUIRE(second == first);
+    REQUIRE(all_zero(second, 32));
+    arena.deallocate(second, 20);
+
+    REQUIRE(arena.stats().in_use == 0);
+    REQUIRE(arena.stats().fallbacks == 0);
+}
+
+TEST_CASE("Arena tracks use in size classes", "[secure_arena]") {
+    SecureArena arena(16 * 1024);
+
+    void* a = arena.allocate(32);
+    void* b = arena.allocate(33);       // 64-byte class
+    void* c = arena.allocate(4096);
+    REQUIRE(arena.stats().in_use == 32 + 64 + 4096);
+
+    arena.deallocate(c, 4096);
+    arena.deallocate(b, 33);
+    REQUIRE(arena.stats().in_use == 32);
+    REQUIRE(arena.stats().peak == 32 + 64 + 4096);
+    arena.deallocate(a, 32);
+}
+
+TEST_CASE("Large or overflowing requests fall back to the heap", "[secure_arena]") {
+    SecureArena arena(8 * 1024);
+
+    void* large = arena.allocate(SecureArena::MAX_CLASS + 1);
+    REQUIRE_FALSE(arena.owns(large));
+    REQUIRE(all_zero(large, SecureArena::MAX_CLASS + 1));
+    REQUIRE(arena.stats().fallbacks == 1);
+    arena.deallocate(large, SecureArena::MAX_CLASS + 1);
+
+    void* a = arena.allocate(4096);
+    void* b = arena.allocate(4096);
+    void* c = arena.allocate(4096);     // Region is full
+    REQUIRE(arena.owns(a));
+    REQUIRE(arena.owns(b));
+    REQUIRE_FALSE(arena.owns(c));
+    REQUIRE(arena.stats().fallbacks == 2);
+    arena.deallocate(a, 4096);
+    arena.deallocate(b, 4096);
+    arena.deallocate(c, 4096);
+}
+
+TEST_CASE("SecureBytes lives in the shared arena", "[secure_arena]") {
+    auto before = SecureArena::shared().stats();
+    {
+        SecureBytes key(32, 0x5A);
+        REQUIRE(SecureArena::shared().owns(key.data()));
+        REQUIRE(SecureArena::shared().stats().in_use >= before.in_use + 32);
+
+        SecureBytes copy = key;
+        REQUIRE(copy == key);
+        REQUIRE(copy.data() != key.data());
+    }
+    REQUIRE(SecureArena::shared().stats().in_use == before.in_use);
+}
+
+TEST_CASE("Arena is safe across threads", "[secure_arena]") {
+    SecureArena arena(64 * 1024);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&arena, t]() {
+            for (int i = 0; i < 2000; ++i) {
+                size_t size = 16 + static_cast<size_t>((i + t) % 8) * 24;
+                auto* data = static_cast<uint8_t*>(arena.allocate(size));
+                std::memset(data, t + 1, size);
+                arena.deallocate(data, size);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    REQUIRE(arena.stats().in_use == 0);
+    REQUIRE(arena.stats().fallbacks == 0);
+}
@@ -0,0 +1,1242 @@
+/**
+ * @file test_streaming.cpp
+ * @brief Unit tests for chunked streaming encryption
+ *
+ * Tests round trips through StreamingCrypto in serial and parallel mode
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/core/streaming.hpp"
+#include "filevault/core/checkpoint.hpp"
+#include "filevault/core/stream_cache.hpp"
+#include "filevault/archive/archive_format.hpp"
+#include "filevault/utils/io_backend.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace filevault::core;
+namespace fs = std::filesystem;
+
+namespace {
+
+const std::string test_dir = "test_streaming_temp";
+
+std::vector<uint8_t> make_data(size_t size) {
+    std::vector<uint8_t> data(size);
+    std::mt19937 gen(1234);
+    // Half random, half repetitive so compression has something to do
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = (i % 2048 < 1024) ? static_cast<uint8_t>(gen()) : static_cast<uint8_t>('A' + i % 4);
+    }
+    return data;
+}
+
+void write_bytes(const std::string& path, const std::vector<uint8_t>& data) {
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+std::vector<uint8_t> read_bytes(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), {});
+}
+
+StreamingConfig small_chunk_config() {
+    StreamingConfig config;
+    config.chunk_size = 4096;
+    config.kdf = KDFType::PBKDF2_SHA256;  // Fast KDF for tests
+    return config;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Streaming encryption round trip", "[streaming]") {
+    fs::create_directories(test_dir);
+    const std::string input = test_dir + "/input.bin";
+    const std::string encrypted = test_dir + "/input.fvst";
+    const std::string decrypted = test_dir + "/output.bin";
+    
+    auto data = make_data(4096 * 10 + 123);  // Partial last chunk
+    write_bytes(input, data);
+    
+    SECTION("Serial") {
+        auto config = small_chunk_config();
+        
+        auto enc = StreamingCrypto::encrypt_file(input, encrypted, "password123", config);
+        REQUIRE(enc.success);
+        REQUIRE(enc.chunks_processed == 11);
+        REQUIRE(enc.bytes_processed == data.size());
+        
+        auto dec = StreamingCrypto::decrypt_file(encrypted, decrypted, "password123");
+        REQUIRE(dec.success);
+        REQUIRE(read_bytes(decrypted) == data);
+    }
+    
+    SECTION("Supplied salt") {
+        auto config = small_chunk_config();
+        config.salt.assign(32, 0x5A);
+        const std::string second = test_dir + "/second.fvst";
+        
+        REQUIRE(StreamingCrypto::encrypt_file(input, encrypted, "password123", config).success);
+        REQUIRE(StreamingCrypto::encrypt_file(input, second, "password123", config).success);
+        REQUIRE(StreamingCrypto::read_info(second)->salt_size == 32);
+        // Same key, but each file has its own nonces
+        REQUIRE(read_bytes(encrypted) != read_bytes(second));
+        
+        REQUIRE(StreamingCrypto::decrypt_file(second, decrypted, "password123").success);
+        REQUIRE(read_bytes(decrypted) == data);
+    }
+    
+    SECTION("Synchronous I/O") {
+        auto config = small_chunk_config();
+        config.io_buffers = 0;
+        
+        auto enc = StreamingCrypto::encrypt_file(input, encrypted, "password123", config);
+        REQUIRE(enc.success);
+        REQUIRE(enc.chunks_processed == 11);
+        
+        auto dec = StreamingCrypto::decrypt_file(encrypted, decrypted, "password123");
+        REQUIRE(dec.success);
+        REQUIRE(read_bytes(decrypted) == data);
+    }
+    
+    SECTION("Bypassing the page cache") {
+        auto config = small_chunk_config();
+        config.bypass_cache = true;
+        
+        REQUIRE(StreamingCrypto::encrypt_file(input, encrypted, "password123", config).success);
+        auto dec = StreamingCrypto::decrypt_file(encrypted, decrypted, "password123", nullptr, 1, {}, true);
+        REQUIRE(dec.success);
+        REQUIRE(read_bytes(decrypted) == data);
+    }
+    
+    SECTION("Parallel workers with compression") {
+        auto config = small_chunk_config();
+        config.worker_threads = 4;
+        config.compression = CompressionType::ZLIB;
+        
+        std::vector<size_t> seen;
+        config.progress_callback = [&seen](const ChunkInfo& info) {
+            seen.push_back(info.chunk_index);
+            return true;
+        };
+        
+        auto enc = StreamingCrypto::encrypt_file(input, encrypted, "password123", config);
+        REQUIRE(enc.success);
+        REQUIRE(enc.chunks_processed == 11);
+        
+        // Progress is reported in chunk order
+        for (size_t i = 0; i < seen.size(); ++i) {
+            REQUIRE(seen[i] == i);
+        }
+        
+        auto dec = StreamingCrypto::decrypt_file(encrypted, decrypted, "password123");
+        REQUIRE(dec.success);
+        REQUIRE(read_bytes(decrypted) == data);
+    }
+    
+    SECTION("Parallel decryption") {
+        auto config = small_chunk_config();
+        config.worker_threads = 4;
+        
+        auto enc = StreamingCrypto::encrypt_file(input, encrypted, "password123", config);
+        REQUIRE(enc.success);
+        
+        auto dec = StreamingCrypto::decrypt_file(encrypted, decrypted, "password123", nullptr, 4);
+        REQUIRE(dec.success);
+        REQUIRE(dec.chunks_processed == 11);
+        REQUIRE(read_bytes(decrypted) == data);
+    }
+    
+    SECTION("Parallel decryption stops at tampered chunk") {
+        auto config = small_chunk_config();
+        
+        auto enc = StreamingCrypto::encrypt_file(input, encrypted, "password123", config);
+        REQUIRE(enc.success);
+        
+        // Header is 147 bytes (32-byte salt, 12-byte nonce, 48-byte wrapped key); frames are [4][4096][16]
+        auto bytes = read_bytes(encrypted);
+        size_t offset = 147 + 5 * (4 + 4096 + 16) + 4 + 100;
+        REQUIRE(offset < bytes.size());
+        bytes[offset] ^= 0x01;
+        write_bytes(encrypted, bytes);
+        
+        auto dec = StreamingCrypto::decrypt_file(encrypted, decrypted, "password123", nullptr, 4);
+        REQUIRE_FALSE(dec.success);
+        REQUIRE(dec.chunks_processed == 5);
+    }
+    
+    SECTION("Verification writes nothing and catches a tampered chunk") {
+        auto config = small_chunk_config();
+        config.compression = CompressionType::ZLIB;
+        REQUIRE(StreamingCrypto::encrypt_file(input, encrypted, "password123", config).success);
+        
+        {
+            std::ifstream in(encrypted, std::ios::binary);
+            filevault::utils::NullOutput sink;
+            auto verified = StreamingCrypto::decrypt_stream(in, sink, "password123", nullptr, 4);
+            REQUIRE(verified.success);
+            REQUIRE(verified.chunks_processed == 11);
+            REQUIRE(sink.bytes() == data.size());
+        }
+        
+        auto bytes = read_bytes(encrypted);
+        bytes[bytes.size() / 2] ^= 0x01;
+        write_bytes(encrypted, bytes);
+        std::ifstream in(encrypted, std::ios::binary);
+        filevault::utils::NullOutput sink;
+        REQUIRE_FALSE(StreamingCrypto::decrypt_stream(in, sink, "password123", nullptr, 4).success);
+        REQUIRE_FALSE(fs::exists(decrypted));
+    }
+    
+    SECTION("Cancel from progress callback") {
+        auto config = small_chunk_config();
+        config.worker_threads = 4;
+        config.progress_callback = [](const ChunkInfo& info) {
+            return info.chunk_index < 2;
+        };
+        
+        auto enc = StreamingCrypto::encrypt_file(input, encrypted, "password123", config);
+        REQUIRE_FALSE(enc.success);
+        REQUIRE(enc.chunks_processed == 3);
+    }
+    
+    fs::remove_all(test_dir);
+}
+
+TEST_CASE("Streaming skips incompressible chunks", "[streaming]") {
+    fs::create_directories(test_dir);
+    const std::string input = test_dir + "/mixed.bin";
+    const std::string encrypted = test_dir + "/mixed.fvst";
+    const std::string decrypted = test_dir + "/mixed.out";
+    
+    // Chunks alternate between random bytes and text
+    std::vector<uint8_t> data;
+    std::mt19937 gen(99);
+    for (size_t chunk = 0; chunk < 8; ++chunk) {
+        for (size_t i = 0; i < 4096; ++i) {
+            data.push_back(chunk % 2 == 0 ? static_cast<uint8_t>(gen())
+                                          : static_cast<uint8_t>("filevault "[i % 10]));
+        }
+    }
+    write_bytes(input, data);
+    
+    auto config = small_chunk_config();
+    config.compression = CompressionType::ZLIB;
+    
+    SECTION("Random chunks are stored raw") {
+        auto enc = StreamingCrypto::encrypt_file(input, encrypted, "password123", config);
+        REQUIRE(enc.success);
+        REQUIRE(enc.chunks_skipped == 4);
+        REQUIRE(enc.chunks_compressed == 4);
+        REQUIRE(enc.skip_rate == 0.5);
+        
+        auto dec = StreamingCrypto::decrypt_file(encrypted, decrypted, "password123");
+        REQUIRE(dec.success);
+        REQUIRE(read_bytes(decrypted) == data);
+        
+        std::vector<uint8_t> range;
+        auto partial = StreamingCrypto::decrypt_range(encrypted, "password123", 4000, 200, range);
+        REQUIRE(partial.success);
+        REQUIRE(range == std::vector<uint8_t>(data.begin() + 4000, data.begin() + 4200));
+    }
+    
+    SECTION("Skipping disabled") {
+        config.skip_incompressible = false;
+        auto enc = StreamingCrypto::encrypt_file(input, encrypted, "password123", config);
+        REQUIRE(enc.success);
+        REQUIRE(enc.chunks_skipped == 0);
+        REQUIRE(enc.chunks_compressed == 4);
+        
+        auto dec = StreamingCrypto::decrypt_file(encrypted, decrypted, "password123");
+        REQUIRE(dec.success);
+        REQUIRE(read_bytes(decrypted) == data);
+    }
+    
+    SECTION("Compressed flag is authenticated") {
+        auto enc = StreamingCrypto::encrypt_file(input, encrypted, "password123", config);
+        REQUIRE(enc.success);
+        
+        // Clear the flag on the second (text) chunk's size prefix
+        auto bytes = read_bytes(encrypted);
+        size_t offset = 147 + 4 + 4096 + 16;
+        REQUIRE((bytes[offset + 3] & 0x80) != 0);
+        bytes[offset + 3] &= 0x7F;
+        write_bytes(encrypted, bytes);
+        
+        auto dec = StreamingCrypto::decrypt_file(encrypted, decrypted, "password123");
+        REQUIRE_FALSE(dec.success);
+    }
+    
+    fs::remove_all(test_dir);
+}
+
+TEST_CASE("Streaming compresses and encrypts in one pass", "[streaming]") {
+    fs::create_directories(test_dir);
+    const std::string input = test_dir + "/fused.bin";
+    const std::string encrypted = test_dir + "/fused.fvst";
+    const std::string decrypted = test_dir + "/fused.out";
+    
+    // Chunks of several fused slices, and a last chunk of odd length
+    auto data = make_data(3 * 1024 * 1024 + 1234);
+    write_bytes(input, data);
+    
+    auto config = small_chunk_config();
+    config.chunk_size = 1024 * 1024;
+    config.skip_incompressible = false;
+    
+    for (auto type : {CompressionType::ZSTD, CompressionType::LZ4, CompressionType::ZLIB}) {
+        config.compression = type;
+        for (size_t workers : {1, 4}) {
+            config.worker_threads = workers;
+            auto enc = StreamingCrypto::encrypt_file(input, encrypted, "password123", config);
+            REQUIRE(enc.success);
+            REQUIRE(enc.chunks_compressed == 4);
+            
+            auto dec = StreamingCrypto::decrypt_file(encrypted, decrypted, "password123", nullptr, workers);
+            REQUIRE(dec.success);
+            REQUIRE(read_bytes(decrypted) == data);
+        }
+        
+        // Decompressed output of a tampered chunk is never written
+        auto bytes = read_bytes(encrypted);
+        bytes[147 + 4 + 100] ^= 0x01;
+        write_bytes(encrypted, bytes);
+        fs::remove(decrypted);
+        auto dec = StreamingCrypto::decrypt_file(encrypted, decrypted, "password123");
+        REQUIRE_FALSE(dec.success);
+        REQUIRE(dec.chunks_processed == 0);
+    }
+    
+    fs::remove_all(test_dir);
+}
+
+TEST_CASE("Streaming range decryption", "[streaming]") {
+    fs::create_directories(test_dir);
+    const std::string input = test_dir + "/input.bin";
+    const std::string encrypted = test_dir + "/input.fvst";
+    
+    auto data = make_data(4096 * 10 + 123);
+    write_bytes(input, data);
+    
+    auto slice = [&data](size_t offset, size_t length) {
+        return std::vector<uint8_t>(data.begin() + offset, data.begin() + offset + length);
+    };
+    
+    SECTION("Ranges within and across chunks") {
+        auto config = small_chunk_config();
+        config.compression = CompressionType::ZLIB;
+        REQUIRE(StreamingCrypto::encrypt_file(input, encrypted, "password123", config).success);
+        
+        std::vector<uint8_t> out;
+        auto dec = StreamingCrypto::decrypt_range(encrypted, "password123", 100, 50, out);
+        REQUIRE(dec.success);
+        REQUIRE(dec.chunks_processed == 1);
+        REQUIRE(out == slice(100, 50));
+        
+        dec = StreamingCrypto::decrypt_range(encrypted, "password123", 4096 * 3 - 10, 4096 + 20, out);
+        REQUIRE(dec.success);
+        REQUIRE(dec.chunks_processed == 3);
+        REQUIRE(out == slice(4096 * 3 - 10, 4096 + 20));
+        
+        // Length past the end is clamped
+        dec = StreamingCrypto::decrypt_range(encrypted, "password123", data.size() - 5, 1000, out);
+        REQUIRE(dec.success);
+        REQUIRE(out == slice(data.size() - 5, 5));
+    }
+    
+    SECTION("Files without a frame index are scanned") {
+        auto config = small_chunk_config();
+        REQUIRE(StreamingCrypto::encrypt_file(input, encrypted, "password123", config).success);
+        
+        // Strip the footer: 11 offsets plus the 12-byte trailer
+        auto bytes = read_bytes(encrypted);
+        bytes.resize(bytes.size() - (11 * 8 + 12));
+        write_bytes(encrypted, bytes);
+        
+        std::vector<uint8_t> out;
+        auto dec = StreamingCrypto::decrypt_range(encrypted, "password123", 4096 * 7 + 1, 300, out);
+        REQUIRE(dec.success);
+        REQUIRE(out == slice(4096 * 7 + 1, 300));
+    }
+    
+    SECTION("Invalid requests fail") {
+        auto config = small_chunk_config();
+        REQUIRE(StreamingCrypto::encrypt_file(input, encrypted, "password123", config).success);
+        
+        std::vector<uint8_t> out;
+        REQUIRE_FALSE(StreamingCrypto::decrypt_range(encrypted, "password123", data.size() + 1, 10, out).success);
+        REQUIRE_FALSE(StreamingCrypto::decrypt_range(encrypted, "wrong", 0, 10, out).success);
+        REQUIRE(out.empty());
+    }
+    
+    SECTION("Frames are located without a key") {
+        auto config = small_chunk_config();
+        REQUIRE(StreamingCrypto::encrypt_file(input, encrypted, "password123", config).success);
+        
+        auto first = StreamingCrypto::locate_frame(encrypted, 0);
+        auto last = StreamingCrypto::locate_frame(encrypted, 10);
+        REQUIRE(first);
+        REQUIRE(last);
+        REQUIRE(first->offset == StreamingCrypto::read_info(encrypted)->header_size);
+        REQUIRE(first->size == 4 + 4096 + 16);
+        REQUIRE(last->size == 4 + 123 + 16);
+        REQUIRE_FALSE(first->compressed);
+        REQUIRE_FALSE(StreamingCrypto::locate_frame(encrypted, 11));
+        REQUIRE_FALSE(StreamingCrypto::locate_frame(input, 0));
+        
+        // Walking the size prefixes finds the same frames as the footer
+        auto bytes = read_bytes(encrypted);
+        bytes.resize(bytes.size() - (11 * 8 + 12));
+        write_bytes(encrypted, bytes);
+        auto scanned = StreamingCrypto::locate_frame(encrypted, 10);
+        REQUIRE(scanned);
+        REQUIRE(scanned->offset == last->offset);
+        REQUIRE(scanned->size == last->size);
+    }
+    
+    SECTION("A reader derives the key once and reuses the last chunk") {
+        auto config = small_chunk_config();
+        config.compression = CompressionType::ZLIB;
+        REQUIRE(StreamingCrypto::encrypt_file(input, encrypted, "password123", config).success);
+        
+        StreamReader reader;
+        REQUIRE(reader.open(encrypted, "password123").success);
+        REQUIRE(reader.size() == data.size());
+        REQUIRE(reader.chunk_size() == 4096);
+        
+        std::vector<uint8_t> out;
+        for (size_t offset = 0; offset < 4000; offset += 500) {
+            REQUIRE(reader.read(offset, 100, out).success);
+            REQUIRE(out == slice(offset, 100));
+        }
+        REQUIRE(reader.chunks_decrypted() == 1);
+        
+        auto dec = reader.read(4096 * 9 + 7, 200, out);
+        REQUIRE(dec.success);
+        REQUIRE(dec.chunks_processed == 1);
+        REQUIRE(out == slice(4096 * 9 + 7, 200));
+        
+        // The header tag rejects a wrong password before any chunk is read
+        StreamReader wrong;
+        REQUIRE_FALSE(wrong.open(encrypted, "wrong").success);
+        REQUIRE_FALSE(wrong.is_open());
+    }
+    
+    SECTION("A cached reader keeps chunks and reads ahead") {
+        auto config = small_chunk_config();
+        REQUIRE(StreamingCrypto::encrypt_file(input, encrypted, "password123", config).success);
+        
+        StreamReader reader;
+        REQUIRE(reader.open(encrypted, "password123").success);
+        CachedStreamReader cached(reader, 4, 2);
+        
+        // Straddles chunks 1 and 2
+        std::vector<uint8_t> out;
+        REQUIRE(cached.read(4096 * 2 - 50, 100, out).empty());
+        REQUIRE(out == slice(4096 * 2 - 50, 100));
+        REQUIRE(cached.read(4096 + 10, 10, out).empty());
+        REQUIRE(out == slice(4096 + 10, 10));
+        REQUIRE(cached.stats().misses == 2);
+        REQUIRE(cached.stats().hits >= 1);
+        
+        // A sequential scan is fully covered, whatever was prefetched
+        for (uint64_t offset = 0; offset < data.size(); offset += 3000) {
+            REQUIRE(cached.read(offset, 3000, out).empty());
+            REQUIRE(out == slice(offset, std::min<size_t>(3000, data.size() - offset)));
+        }
+        REQUIRE(cached.read(data.size() - 5, 100, out).empty());
+        REQUIRE(out.size() == 5);
+        REQUIRE_FALSE(cached.read(data.size() + 1, 1, out).empty());
+    }
+    
+    fs::remove_all(test_dir);
+}
+
+TEST_CASE("Streaming sparse inputs", "[streaming][sparse]") {
+    fs::create_directories(test_dir);
+    const std::string input = test_dir + "/sparse.bin";
+    const std::string encrypted = test_dir + "/sparse.fvst";
+    const std::string decrypted = test_dir + "/output.bin";
+    
+    // Two chunks of data, an eight-chunk hole, then a partial chunk
+    auto head = make_data(4096 * 2);
+    auto tail = make_data(1000);
+    fs::remove(input);
+    {
+        std::ofstream file(input, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(head.data()), head.size());
+        file.seekp(4096 * 10);
+        file.write(reinterpret_cast<const char*>(tail.data()), tail.size());
+    }
+    auto data = head;
+    data.resize(4096 * 10);
+    data.insert(data.end(), tail.begin(), tail.end());
+    
+    // Filesystems without holes report the file as data; it still round-trips
+    auto extents = filevault::utils::data_extents(input);
+    size_t hole_chunks = extents && extents->size() > 1 ? 8 : 0;
+    
+    auto config = small_chunk_config();
+    config.worker_threads = 2;
+    config.compression = CompressionType::ZLIB;
+    auto enc = StreamingCrypto::encrypt_file(input, encrypted, "password123", config);
+    REQUIRE(enc.success);
+    REQUIRE(enc.chunks_processed == 11);
+    REQUIRE(enc.chunks_sparse == hole_chunks);
+    REQUIRE(enc.bytes_processed == data.size());
+    
+    SECTION("Holes come back as holes") {
+        auto dec = StreamingCrypto::decrypt_file(encrypted, decrypted, "password123", nullptr, 2);
+        REQUIRE(dec.success);
+        REQUIRE(dec.bytes_written == data.size());
+        REQUIRE(read_bytes(decrypted) == data);
+        if (hole_chunks > 0) {
+            REQUIRE(filevault::utils::data_extents(decrypted)->size() > 1);
+        }
+    }
+    
+    SECTION("Holes decrypt to zeros in streams and ranges") {
+        std::ifstream in(encrypted, std::ios::binary);
+        std::ostringstream out;
+        REQUIRE(StreamingCrypto::decrypt_stream(in, out, "password123").success);
+        auto str = out.str();
+        REQUIRE(std::vector<uint8_t>(str.begin(), str.end()) == data);
+        
+        std::vector<uint8_t> range;
+        REQUIRE(StreamingCrypto::decrypt_range(encrypted, "password123", 4096 * 2 - 10, 30, range).success);
+        REQUIRE(range == std::vector<uint8_t>(data.begin() + 4096 * 2 - 10, data.begin() + 4096 * 2 + 20));
+    }
+    
+    fs::remove_all(test_dir);
+}
+
+TEST_CASE("FVAULT02 header is authenticated", "[streaming][format]") {
+    fs::create_directories(test_dir);
+    const std::string input = test_dir + "/input.bin";
+    const std::string encrypted = test_dir + "/input.fvlt";
+    const std::string decrypted = test_dir + "/output.bin";
+    
+    auto data = make_data(4096 * 3 + 10);
+    write_bytes(input, data);
+    
+    auto config = small_chunk_config();
+    config.level = SecurityLevel::WEAK;
+    REQUIRE(StreamingCrypto::encrypt_file(input, encrypted, "password123", config).success);
+    
+    SECTION("Header fields read back without a key") {
+        REQUIRE(StreamingCrypto::is_streaming_file(encrypted));
+        
+        auto bytes = read_bytes(encrypted);
+        REQUIRE(std::string(bytes.begin(), bytes.begin() + 8) == "FVAULT02");
+        
+        auto info = StreamingCrypto::read_info(encrypted);
+        REQUIRE(info.has_value());
+        REQUIRE(info->authenticated_header);
+        REQUIRE(info->level == SecurityLevel::WEAK);
+        REQUIRE(info->chunk_size == 4096);
+        REQUIRE(info->original_size == data.size());
+        REQUIRE(info->chunk_count == 4);
+        REQUIRE(info->header_size == 147);
+        REQUIRE(info->wrapped_key);
+        REQUIRE(info->key_generation == 0);
+        REQUIRE_FALSE(info->wide_frames);
+        
+        // The recorded level is the one decryption derives the key with
+        REQUIRE(StreamingCrypto::decrypt_file(encrypted, decrypted, "password123").success);
+        REQUIRE(read_bytes(decrypted) == data);
+    }
+    
+    SECTION("Edited header fields fail before any output") {
+        // Chunk size (offset 16), chunk count (offset 32), security level (offset 11)
+        for (size_t offset : {size_t(16), size_t(32), size_t(11)}) {
+            auto bytes = read_bytes(encrypted);
+            bytes[offset] ^= 0x01;
+            write_bytes(test_dir + "/tampered.fvlt", bytes);
+            
+            auto dec = StreamingCrypto::decrypt_file(test_dir + "/tampered.fvlt", decrypted, "password123");
+            REQUIRE_FALSE(dec.success);
+            REQUIRE(dec.chunks_processed == 0);
+        }
+    }
+    
+    SECTION("Wrong password fails at the header") {
+        auto dec = StreamingCrypto::decrypt_file(encrypted, decrypted, "wrong");
+        REQUIRE_FALSE(dec.success);
+        REQUIRE(dec.chunks_processed == 0);
+    }
+    
+    SECTION("Rekeying rewrites only the header") {
+        auto before = read_bytes(encrypted);
+        auto info = StreamingCrypto::read_info(encrypted);
+        REQUIRE(info.has_value());
+        
+        RekeyOptions options;
+        options.level = SecurityLevel::MEDIUM;
+        REQUIRE_FALSE(StreamingCrypto::rekey_file(encrypted, "wrong", "new-password", options).success);
+        REQUIRE(read_bytes(encrypted) == before);
+        
+        auto rekeyed = StreamingCrypto::rekey_file(encrypted, "password123", "new-password", options);
+        REQUIRE(rekeyed.success);
+        REQUIRE(rekeyed.bytes_written == info->header_size);
+        
+        auto after = read_bytes(encrypted);
+        REQUIRE(after.size() == before.size());
+        REQUIRE(std::equal(after.begin() + info->header_size, after.end(), before.begin() + info->header_size));
+        
+        auto new_info = StreamingCrypto::read_info(encrypted);
+        REQUIRE(new_info->key_generation == 1);
+        REQUIRE(new_info->level == SecurityLevel::MEDIUM);
+        
+        REQUIRE_FALSE(StreamingCrypto::decrypt_file(encrypted, decrypted, "password123").success);
+        REQUIRE(StreamingCrypto::decrypt_file(encrypted, decrypted, "new-password").success);
+        REQUIRE(read_bytes(decrypted) == data);
+        
+        // And again: each generation tags its header under its own nonce
+        REQUIRE(StreamingCrypto::rekey_file(encrypted, "new-password", "third").success);
+        REQUIRE(StreamingCrypto::read_info(encrypted)->key_generation == 2);
+        REQUIRE(StreamingCrypto::decrypt_file(encrypted, decrypted, "third").success);
+        REQUIRE(read_bytes(decrypted) == data);
+    }
+    
+    SECTION("Files without a wrapped key are not rekeyed") {
+        // A caller's data key is used as is, as password keys were before wrapping
+        std::vector<uint8_t> data_key(32, 0x42);
+        std::ostringstream encrypted_out;
+        std::istringstream plain_in(std::string(data.begin(), data.end()));
+        REQUIRE(StreamingCrypto::encrypt_stream_with_key(plain_in, encrypted_out, data_key,
+                                                         data.size(), config).success);
+        auto bytes = encrypted_out.str();
+        write_bytes(test_dir + "/keyed.fvlt", std::vector<uint8_t>(bytes.begin(), bytes.end()));
+        REQUIRE_FALSE(StreamingCrypto::read_info(test_dir + "/keyed.fvlt")->wrapped_key);
+        
+        auto rekeyed = StreamingCrypto::rekey_file(test_dir + "/keyed.fvlt", "password123", "new-password");
+        REQUIRE_FALSE(rekeyed.success);
+        REQUIRE(rekeyed.error_message.find("not wrapped") != std::string::npos);
+    }
+    
+    fs::remove_all(test_dir);
+}
+
+TEST_CASE("FVAULT02 wide frames", "[streaming][format]") {
+    fs::create_directories(test_dir);
+    const std::string input = test_dir + "/input.bin";
+    const std::string encrypted = test_dir + "/input.fvlt";
+    const std::string decrypted = test_dir + "/output.bin";
+    
+    auto data = make_data(4096 * 5 + 321);
+    write_bytes(input, data);
+    
+    auto config = small_chunk_config();
+    config.compression = CompressionType::ZLIB;
+    config.wide_frames = true;
+    
+    SECTION("Files round trip and are located by 8-byte prefixes") {
+        config.worker_threads = 2;
+        REQUIRE(StreamingCrypto::encrypt_file(input, encrypted, "password123", config).success);
+        
+        auto info = StreamingCrypto::read_info(encrypted);
+        REQUIRE(info.has_value());
+        REQUIRE(info->wide_frames);
+        REQUIRE(info->chunk_count == 6);
+        REQUIRE(info->header_size == 151);
+        
+        REQUIRE(StreamingCrypto::decrypt_file(encrypted, decrypted, "password123", nullptr, 2).success);
+        REQUIRE(read_bytes(decrypted) == data);
+        
+        auto first = StreamingCrypto::locate_frame(encrypted, 0);
+        auto second = StreamingCrypto::locate_frame(encrypted, 1);
+        REQUIRE(first);
+        REQUIRE(second);
+        REQUIRE(first->offset == 151);
+        REQUIRE(second->offset == first->offset + first->size);
+        
+        std::vector<uint8_t> out;
+        REQUIRE(StreamingCrypto::decrypt_range(encrypted, "password123", 4000, 5000, out).success);
+        REQUIRE(out == std::vector<uint8_t>(data.begin() + 4000, data.begin() + 9000));
+        
+        // The same file rekeys, resumes and verifies like a narrow one
+        REQUIRE(StreamingCrypto::rekey_file(encrypted, "password123", "new-password").success);
+        REQUIRE(StreamingCrypto::decrypt_file(encrypted, decrypted, "new-password").success);
+        REQUIRE(read_bytes(decrypted) == data);
+    }
+    
+    SECTION("Streams of unknown length end at a wide trailer") {
+        std::istringstream in(std::string(data.begin(), data.end()));
+        std::ostringstream out;
+        REQUIRE(StreamingCrypto::encrypt_stream(in, out, "password123", config).success);
+        
+        auto sealed = out.str();
+        std::istringstream sealed_in(sealed);
+        std::ostringstream plain;
+        REQUIRE(StreamingCrypto::decrypt_stream(sealed_in, plain, "password123").success);
+        REQUIRE(plain.str() == std::string(data.begin(), data.end()));
+        
+        // Cutting the trailer is still detected
+        std::istringstream cut(sealed.substr(0, sealed.size() - 10));
+        std::ostringstream ignored;
+        REQUIRE_FALSE(StreamingCrypto::decrypt_stream(cut, ignored, "password123").success);
+    }
+    
+    SECTION("Unknown header flags are refused") {
+        REQUIRE(StreamingCrypto::encrypt_file(input, encrypted, "password123", config).success);
+        auto bytes = read_bytes(encrypted);
+        bytes[12] |= 0x80;
+        write_bytes(encrypted, bytes);
+        REQUIRE_FALSE(StreamingCrypto::read_info(encrypted).has_value());
+        REQUIRE_FALSE(StreamingCrypto::decrypt_file(encrypted, decrypted, "password123").success);
+    }
+    
+    fs::remove_all(test_dir);
+}
+
+TEST_CASE("FVAULT02 source fingerprint", "[streaming][format]") {
+    fs::create_directories(test_dir);
+    const std::string input = test_dir + "/input.bin";
+    const std::string encrypted = test_dir + "/input.fvlt";
+    const std::string decrypted = test_dir + "/output.bin";
+    
+    auto data = make_data(4096 * 2 + 100);
+    write_bytes(input, data);
+    
+    auto config = small_chunk_config();
+    config.fingerprint = std::vector<uint8_t>(20, 0x5a);
+    REQUIRE(StreamingCrypto::encrypt_file(input, encrypted, "password123", config).success);
+    
+    SECTION("Read back without a key and covered by the header tag") {
+        auto info = StreamingCrypto::read_info(encrypted);
+        REQUIRE(info.has_value());
+        REQUIRE(info->fingerprint == config.fingerprint);
+        REQUIRE(info->header_size == 147 + 1 + 20);
+        REQUIRE(StreamingCrypto::decrypt_file(encrypted, decrypted, "password123").success);
+        REQUIRE(read_bytes(decrypted) == data);
+        
+        auto bytes = read_bytes(encrypted);
+        bytes[info->header_size - 16 - 1] ^= 0x01;
+        write_bytes(encrypted, bytes);
+        REQUIRE(StreamingCrypto::read_info(encrypted)->fingerprint != config.fingerprint);
+        REQUIRE_FALSE(StreamingCrypto::decrypt_file(encrypted, decrypted, "password123").success);
+    }
+    
+    SECTION("Kept by header rewrites") {
+        REQUIRE(StreamingCrypto::rekey_file(encrypted, "password123", "new-password").success);
+        REQUIRE(StreamingCrypto::read_info(encrypted)->fingerprint == config.fingerprint);
+        
+        auto more = make_data(3000);
+        std::istringstream more_in(std::string(more.begin(), more.end()));
+        REQUIRE(StreamingCrypto::append_stream(encrypted, "new-password", more_in, more.size()).success);
+        REQUIRE(StreamingCrypto::read_info(encrypted)->fingerprint == config.fingerprint);
+        
+        REQUIRE(StreamingCrypto::decrypt_file(encrypted, decrypted, "new-password").success);
+        auto expected = data;
+        expected.insert(expected.end(), more.begin(), more.end());
+        REQUIRE(read_bytes(decrypted) == expected);
+    }
+    
+    SECTION("Files without one have no flag") {
+        REQUIRE(StreamingCrypto::encrypt_file(input, encrypted, "password123", small_chunk_config()).success);
+        REQUIRE(StreamingCrypto::read_info(encrypted)->fingerprint.empty());
+        REQUIRE(read_bytes(encrypted)[12] == 0x01);
+    }
+    
+    fs::remove_all(test_dir);
+}
+
+TEST_CASE("Streaming jobs resume from a checkpoint", "[streaming][checkpoint]") {
+    fs::create_directories(test_dir);
+    const std::string input = test_dir + "/input.bin";
+    const std::string encrypted = test_dir + "/input.fvlt";
+    const std::string decrypted = test_dir + "/output.bin";
+    
+    auto data = make_data(4096 * 12 + 77);
+    write_bytes(input, data);
+    
+    // Checkpoint every 2 chunks and stop after chunk 4, as if killed there
+    auto config = small_chunk_config();
+    config.checkpoint.interval = 2;
+    config.progress_callback = [](const ChunkInfo& info) { return info.chunk_index < 4; };
+    REQUIRE_FALSE(StreamingCrypto::encrypt_file(input, encrypted, "password123", config).success);
+    REQUIRE(fs::exists(Checkpoint::path_for(encrypted)));
+    
+    config.progress_callback = nullptr;
+    config.checkpoint.resume = true;
+    
+    SECTION("Encryption continues after the last checkpoint") {
+        auto enc = StreamingCrypto::encrypt_file(input, encrypted, "password123", config);
+        REQUIRE(enc.success);
+        REQUIRE(enc.chunks_resumed == 4);
+        REQUIRE(enc.chunks_processed == 13);
+        REQUIRE_FALSE(fs::exists(Checkpoint::path_for(encrypted)));
+        
+        REQUIRE(StreamingCrypto::decrypt_file(encrypted, decrypted, "password123").success);
+        REQUIRE(read_bytes(decrypted) == data);
+    }
+    
+    SECTION("A different password or a changed input is refused") {
+        REQUIRE_FALSE(StreamingCrypto::encrypt_file(input, encrypted, "other", config).success);
+        
+        data[0] ^= 0x01;
+        write_bytes(input, data);
+        fs::last_write_time(input, fs::last_write_time(input) + std::chrono::seconds(5));
+        REQUIRE_FALSE(StreamingCrypto::encrypt_file(input, encrypted, "password123", config).success);
+    }
+    
+    SECTION("Decryption continues after the last checkpoint") {
+        config.checkpoint.resume = false;
+        config.checkpoint.interval = 0;
+        REQUIRE(StreamingCrypto::encrypt_file(input, encrypted, "password123", config).success);
+        
+        CheckpointOptions checkpoint;
+        checkpoint.interval = 3;
+        auto stop_at_7 = [](const ChunkInfo& info) { return info.chunk_index < 7; };
+        REQUIRE_FALSE(StreamingCrypto::decrypt_file(encrypted, decrypted, "password123",
+                                                    stop_at_7, 2, checkpoint).success);
+        
+        checkpoint.resume = true;
+        auto dec = StreamingCrypto::decrypt_file(encrypted, decrypted, "password123", nullptr, 2, checkpoint);
+        REQUIRE(dec.success);
+        REQUIRE(dec.chunks_resumed == 6);
+        REQUIRE(read_bytes(decrypted) == data);
+        REQUIRE_FALSE(fs::exists(Checkpoint::path_for(decrypted)));
+    }
+    
+    fs::remove_all(test_dir);
+}
+
+TEST_CASE("Streaming adaptive chunk size", "[streaming]") {
+    fs::create_directories(test_dir);
+    const std::string input = test_dir + "/input.bin";
+    const std::string encrypted = test_dir + "/input.fvst";
+    const std::string decrypted = test_dir + "/output.bin";
+    
+    auto data = make_data(1024 * 1024 + 77);
+    write_bytes(input, data);
+    
+    SECTION("Chosen size is recorded and round trips") {
+        auto config = small_chunk_config();
+        config.adaptive_chunk_size = true;
+        
+        auto enc = StreamingCrypto::encrypt_file(input, encrypted, "password123", config);
+        REQUIRE(enc.success);
+        REQUIRE((enc.chunk_size == 64 * 1024 || enc.chunk_size == 256 * 1024));
+        REQUIRE(enc.chunks_processed == (data.size() + enc.chunk_size - 1) / enc.chunk_size);
+        
+        auto dec = StreamingCrypto::decrypt_file(encrypted, decrypted, "password123");
+        REQUIRE(dec.success);
+        REQUIRE(dec.chunk_size == enc.chunk_size);
+        REQUIRE(read_bytes(decrypted) == data);
+        
+        std::vector<uint8_t> out;
+        REQUIRE(StreamingCrypto::decrypt_range(encrypted, "password123", 300000, 1000, out).success);
+        REQUIRE(out == std::vector<uint8_t>(data.begin() + 300000, data.begin() + 301000));
+    }
+    
+    SECTION("Memory cap limits the chunk size") {
+        auto config = small_chunk_config();
+        config.adaptive_chunk_size = true;
+        config.max_chunk_memory = 100 * 1024;  // 1 worker + 2 in flight + 2 read-ahead = 5 buffers
+        
+        auto enc = StreamingCrypto::encrypt_file(input, encrypted, "password123", config);
+        REQUIRE(enc.success);
+        REQUIRE(enc.chunk_size <= 100 * 1024 / 5);
+        
+        auto dec = StreamingCrypto::decrypt_file(encrypted, decrypted, "password123");
+        REQUIRE(dec.success);
+        REQUIRE(read_bytes(decrypted) == data);
+    }
+    
+    fs::remove_all(test_dir);
+}
+
+TEST_CASE("Streaming from pipes of unknown length", "[streaming]") {
+    fs::create_directories(test_dir);
+    const std::string encrypted = test_dir + "/pipe.fvst";
+    const std::string decrypted = test_dir + "/output.bin";
+    
+    auto data = make_data(4096 * 6 + 55);
+    auto to_stream = [](const std::vector<uint8_t>& bytes) {
+        return std::istringstream(std::string(bytes.begin(), bytes.end()));
+    };
+    auto to_bytes = [](const std::ostringstream& out) {
+        auto str = out.str();
+        return std::vector<uint8_t>(str.begin(), str.end());
+    };
+    
+    SECTION("Round trip through streams and files") {
+        auto config = small_chunk_config();
+        config.worker_threads = 2;
+        config.compression = CompressionType::ZLIB;
+        
+        auto in = to_stream(data);
+        std::ostringstream out;
+        auto enc = StreamingCrypto::encrypt_stream(in, out, "password123", config);
+        REQUIRE(enc.success);
+        REQUIRE(enc.chunks_processed == 7);
+        REQUIRE(enc.bytes_processed == data.size());
+        
+        auto sealed = to_bytes(out);
+        auto sealed_in = to_stream(sealed);
+        std::ostringstream plain;
+        auto dec = StreamingCrypto::decrypt_stream(sealed_in, plain, "password123", nullptr, 2);
+        REQUIRE(dec.success);
+        REQUIRE(to_bytes(plain) == data);
+        
+        // The file API reads the same stream
+        write_bytes(encrypted, sealed);
+        REQUIRE(StreamingCrypto::decrypt_file(encrypted, decrypted, "password123").success);
+        REQUIRE(read_bytes(decrypted) == data);
+        
+        // Frames of a stream end at its trailer
+        REQUIRE(StreamingCrypto::locate_frame(encrypted, 6));
+        REQUIRE_FALSE(StreamingCrypto::locate_frame(encrypted, 7));
+        
+        // Random access needs a known length
+        std::vector<uint8_t> range;
+        REQUIRE_FALSE(StreamingCrypto::decrypt_range(encrypted, "password123", 0, 10, range).success);
+    }
+    
+    SECTION("Empty input") {
+        std::istringstream in;
+        std::ostringstream out;
+        REQUIRE(StreamingCrypto::encrypt_stream(in, out, "password123", small_chunk_config()).success);
+        
+        auto sealed_in = to_stream(to_bytes(out));
+        std::ostringstream plain;
+        REQUIRE(StreamingCrypto::decrypt_stream(sealed_in, plain, "password123").success);
+        REQUIRE(plain.str().empty());
+    }
+    
+    SECTION("Truncation is detected") {
+        auto in = to_stream(data);
+        std::ostringstream out;
+        REQUIRE(StreamingCrypto::encrypt_stream(in, out, "password123", small_chunk_config()).success);
+        auto sealed = to_bytes(out);
+        
+        // Dropping the trailer, or the trailer and the last chunk, must fail
+        const size_t trailer_size = 4 + 16 + 16;
+        const size_t last_frame_size = 4 + 55 + 16;
+        for (size_t cut : {trailer_size, trailer_size + last_frame_size}) {
+            std::vector<uint8_t> truncated(sealed.begin(), sealed.end() - cut);
+            auto truncated_in = to_stream(truncated);
+            std::ostringstream plain;
+            auto dec = StreamingCrypto::decrypt_stream(truncated_in, plain, "password123");
+            REQUIRE_FALSE(dec.success);
+        }
+        
+        // A tampered trailer fails authentication
+        sealed[sealed.size() - 20] ^= 0x01;
+        auto tampered_in = to_stream(sealed);
+        std::ostringstream plain;
+        REQUIRE_FALSE(StreamingCrypto::decrypt_stream(tampered_in, plain, "password123").success);
+    }
+    
+    fs::remove_all(test_dir);
+}
+
+TEST_CASE("Streaming an archive built on the fly", "[streaming][archive]") {
+    using filevault::archive::ArchiveSink;
+    using filevault::archive::ArchiveSource;
+    
+    fs::create_directories(test_dir + "/members");
+    const std::string encrypted = test_dir + "/archive.fva";
+    const std::string extract_dir = test_dir + "/extracted";
+    
+    // Members straddle chunk boundaries; one is empty
+    std::vector<std::pair<std::string, std::vector<uint8_t>>> members = {
+        {"a.bin", make_data(4096 * 3 + 17)},
+        {"empty.txt", {}},
+        {"b.bin", make_data(100)},
+        {"c.bin", make_data(4096 * 2)},
+    };
+    std::vector<fs::path> paths;
+    for (const auto& [name, content] : members) {
+        paths.push_back(test_dir + "/members/" + name);
+        write_bytes(paths.back().string(), content);
+    }
+    
+    auto config = small_chunk_config();
+    config.compression = CompressionType::ZLIB;
+    config.worker_threads = 2;
+    
+    ArchiveSource source(paths);
+    std::istream in(&source);
+    std::ofstream out(encrypted, std::ios::binary);
+    auto enc = StreamingCrypto::encrypt_stream(in, out, "password123", source.size(), config);
+    out.close();
+    REQUIRE(enc.success);
+    REQUIRE(enc.bytes_processed == source.size());
+    
+    SECTION("Extracts through the sink") {
+        std::ifstream sealed(encrypted, std::ios::binary);
+        ArchiveSink sink(extract_dir);
+        std::ostream plain(&sink);
+        auto dec = StreamingCrypto::decrypt_stream(sealed, plain, "password123", nullptr, 2);
+        REQUIRE(dec.success);
+        REQUIRE(sink.finish());
+        REQUIRE(sink.entries().size() == members.size());
+        for (const auto& [name, content] : members) {
+            INFO(name);
+            REQUIRE(read_bytes(extract_dir + "/" + name) == content);
+        }
+    }
+    
+    SECTION("Known length keeps random access") {
+        // Hashes of the members, computed as they were read, follow the data
+        auto digests = filevault::archive::ArchiveFormat::digest_block_size(source.entries());
+        REQUIRE(digests == 3 * 32);
+        auto table_size = source.size() - digests - (4096 * 5 + 17 + 100);
+        std::vector<uint8_t> range;
+        REQUIRE(StreamingCrypto::decrypt_range(encrypted, "password123", table_size + 4096 * 3 + 17, 100, range).success);
+        REQUIRE(range == members[2].second);
+    }
+    
+    SECTION("Members are read through the index") {
+        filevault::archive::ArchiveReader reader;
+        auto opened = reader.open(encrypted, "password123");
+        REQUIRE(opened.success);
+        REQUIRE(reader.entries().size() == members.size());
+        REQUIRE(reader.entries()[2].filename == "b.bin");
+        REQUIRE(reader.entries()[2].file_size == 100);
+        REQUIRE(reader.find("missing") == nullptr);
+        
+        // The index fits in chunk 0; listing touches nothing else
+        REQUIRE(reader.chunks_decrypted() == 1);
+        
+        // The last member lives in the last two chunks only
+        const auto* last = reader.find("c.bin");
+        REQUIRE(last != nullptr);
+        auto [first_chunk, last_chunk] = reader.chunk_range(*last);
+        REQUIRE(last_chunk == enc.chunks_processed - 1);
+        
+        std::string error;
+        REQUIRE(reader.extract(*last, extract_dir, error));
+        REQUIRE(read_bytes(extract_dir + "/c.bin") == members[3].second);
+        REQUIRE(reader.chunks_decrypted() == 1 + (last_chunk - first_chunk + 1));
+        
+        REQUIRE(reader.extract(*reader.find("empty.txt"), extract_dir, error));
+        REQUIRE(fs::exists(extract_dir + "/empty.txt"));
+        
+        // Hashes stored after the data are read on demand
+        REQUIRE_FALSE(last->has_hash());
+        REQUIRE(reader.extract(*last, extract_dir, error, true));
+        REQUIRE(last->content_hash == filevault::archive::ArchiveFormat::hash_bytes(members[3].second));
+        
+        filevault::archive::ArchiveReader wrong;
+        REQUIRE_FALSE(wrong.open(encrypted, "wrong").success);
+    }
+    
+    SECTION("The index ID read back matches the one a delta records") {
+        filevault::archive::ArchiveReader reader;
+        REQUIRE(reader.open(encrypted, "password123").success);
+        REQUIRE_FALSE(reader.header().is_delta());
+        REQUIRE(reader.index_id() == source.index_id());
+    }
+    
+    SECTION("Adaptive sizing rewinds the source") {
+        std::vector<uint8_t> big(1024 * 1024);
+        std::mt19937 gen(5);
+        for (auto& b : big) {
+            b = static_cast<uint8_t>('a' + gen() % 4);
+        }
+        write_bytes(paths[0].string(), big);
+        
+        ArchiveSource big_source(paths);
+        std::istream big_in(&big_source);
+        std::ostringstream sealed_out;
+        auto adaptive = config;
+        adaptive.adaptive_chunk_size = true;
+        REQUIRE(StreamingCrypto::encrypt_stream(big_in, sealed_out, "password123",
+                                                big_source.size(), adaptive).success);
+        
+        auto sealed_str = sealed_out.str();
+        std::istringstream sealed_in(sealed_str);
+        ArchiveSink sink(extract_dir);
+        std::ostream plain(&sink);
+        REQUIRE(StreamingCrypto::decrypt_stream(sealed_in, plain, "password123").success);
+        REQUIRE(sink.finish());
+        REQUIRE(read_bytes(extract_dir + "/a.bin") == big);
+    }
+    
+    fs::remove_all(test_dir);
+}
+
+TEST_CASE("Appending to a stream in place", "[streaming][append]") {
+    using filevault::archive::ArchiveReader;
+    using filevault::archive::ArchiveSink;
+    using filevault::archive::ArchiveSource;
+    
+    fs::create_directories(test_dir);
+    const std::string input = test_dir + "/input.bin";
+    const std::string encrypted = test_dir + "/input.fvlt";
+    const std::string decrypted = test_dir + "/output.bin";
+    
+    auto config = small_chunk_config();
+    config.compression = CompressionType::ZLIB;
+    auto data = make_data(4096 * 2);
+    auto more = make_data(5000);
+    write_bytes(input, data);
+    REQUIRE(StreamingCrypto::encrypt_file(input, encrypted, "password123", config).success);
+    auto stream_of = [](const std::vector<uint8_t>& bytes) {
+        return std::istringstream(std::string(bytes.begin(), bytes.end()));
+    };
+    
+    SECTION("New chunks follow the old ones; the header commits them") {
+        auto info = StreamingCrypto::read_info(encrypted);
+        auto before = read_bytes(encrypted);
+        size_t old_index = 2 * 8 + 12;
+        
+        auto wrong_in = stream_of(more);
+        REQUIRE_FALSE(StreamingCrypto::append_stream(encrypted, "wrong", wrong_in, more.size()).success);
+        REQUIRE(read_bytes(encrypted) == before);
+        
+        auto more_in = stream_of(more);
+        auto appended = StreamingCrypto::append_stream(encrypted, "password123", more_in, more.size(), 2);
+        REQUIRE(appended.success);
+        REQUIRE(appended.chunks_resumed == 2);
+        REQUIRE(appended.chunks_processed == 4);
+        
+        // The old frames are not rewritten
+        auto after = read_bytes(encrypted);
+        REQUIRE(std::equal(before.begin() + info->header_size, before.end() - old_index,
+                           after.begin() + info->header_size));
+        
+        auto new_info = StreamingCrypto::read_info(encrypted);
+        REQUIRE(new_info->original_size == data.size() + more.size());
+        REQUIRE(new_info->chunk_count == 4);
+        REQUIRE(new_info->key_generation == info->key_generation + 1);
+        
+        REQUIRE(StreamingCrypto::decrypt_file(encrypted, decrypted, "password123").success);
+        auto expected = data;
+        expected.insert(expected.end(), more.begin(), more.end());
+        REQUIRE(read_bytes(decrypted) == expected);
+        
+        // The last chunk is partial now, so nothing more can follow it
+        auto again = stream_of(more);
+        REQUIRE_FALSE(StreamingCrypto::append_stream(encrypted, "password123", again, more.size()).success);
+    }
+    
+    SECTION("Files that do not end in their index are refused") {
+        auto bytes = read_bytes(encrypted);
+        bytes.resize(bytes.size() + 100, 0x5A);
+        write_bytes(encrypted, bytes);
+        auto more_in = stream_of(more);
+        auto appended = StreamingCrypto::append_stream(encrypted, "password123", more_in, more.size());
+        REQUIRE_FALSE(appended.success);
+        REQUIRE(appended.error_message.find("frame index") != std::string::npos);
+    }
+    
+    SECTION("Archive segments are read as one archive") {
+        fs::create_directories(test_dir + "/first");
+        fs::create_directories(test_dir + "/second");
+        std::vector<fs::path> first = {test_dir + "/first/a.bin", test_dir + "/first/b.bin"};
+        std::vector<fs::path> second = {test_dir + "/second/c.bin", test_dir + "/second/a.bin"};
+        write_bytes(first[0].string(), make_data(4096 + 10));
+        write_bytes(first[1].string(), make_data(300));
+        write_bytes(second[0].string(), make_data(6000));
+        write_bytes(second[1].string(), more);
+        
+        const std::string archive = test_dir + "/archive.fva";
+        ArchiveSource source(first);
+        source.pad_to(config.chunk_size);
+        std::istream source_in(&source);
+        std::ofstream out(archive, std::ios::binary);
+        REQUIRE(StreamingCrypto::encrypt_stream(source_in, out, "password123", source.size(), config).success);
+        out.close();
+        
+        ArchiveSource segment(second);
+        segment.pad_to(config.chunk_size);
+        std::istream segment_in(&segment);
+        REQUIRE(StreamingCrypto::append_stream(archive, "password123", segment_in, segment.size()).success);
+        
+        ArchiveReader reader;
+        REQUIRE(reader.open(archive, "password123").success);
+        REQUIRE(reader.segments() == 2);
+        REQUIRE(reader.appendable());
+        REQUIRE(reader.entries().size() == 4);
+        REQUIRE(reader.index_id() != source.index_id());
+        
+        // The later a.bin wins
+        const auto* replaced = reader.find("a.bin");
+        REQUIRE(replaced != nullptr);
+        REQUIRE(replaced->file_size == more.size());
+        std::string error;
+        const std::string extract_dir = test_dir + "/extracted";
+        REQUIRE(reader.extract(*replaced, extract_dir, error));
+        REQUIRE(read_bytes(extract_dir + "/a.bin") == more);
+        
+        std::ifstream sealed(archive, std::ios::binary);
+        ArchiveSink sink(test_dir + "/all");
+        std::ostream plain(&sink);
+        REQUIRE(StreamingCrypto::decrypt_stream(sealed, plain, "password123").success);
+        REQUIRE(sink.finish());
+        REQUIRE(sink.entries().size() == 4);
+        REQUIRE(read_bytes(test_dir + "/all/a.bin") == more);
+        REQUIRE(read_bytes(test_dir + "/all/c.bin") == make_data(6000));
+    }
+    
+    fs::remove_all(test_dir);
+}
+
+TEST_CASE("Sharded encryption from independent ranks", "[streaming][shard]") {
+    fs::create_directories(test_dir);
+    const std::string input = test_dir + "/input.bin";
+    const std::string encrypted = test_dir + "/input.fvlt";
+    const std::string decrypted = test_dir + "/output.bin";
+    
+    auto data = make_data(4096 * 10 + 123);  // 11 chunks over 3 ranks: 3, 4 and 4
+    write_bytes(input, data);
+    
+    SECTION("Ranks in any order make an ordinary file") {
+        auto init = StreamingCrypto::init_shards(input, encrypted, "password123", small_chunk_config());
+        REQUIRE(init.success);
+        REQUIRE(fs::file_size(encrypted) == init.bytes_written);
+        
+        // Nothing decrypts, and stitching is refused, until every rank is done
+        auto last = StreamingCrypto::encrypt_shard(input, encrypted, "password123", 2, 3, 2);
+        REQUIRE(last.success);
+        REQUIRE(last.chunks_processed == 4);
+        REQUIRE(last.bytes_processed == 4096 * 3 + 123);
+        REQUIRE(StreamingCrypto::encrypt_shard(input, encrypted, "password123", 0, 3).success);
+        auto early = StreamingCrypto::stitch_shards(encrypted);
+        REQUIRE_FALSE(early.success);
+        REQUIRE(early.error_message.find("Chunk 3 ") != std::string::npos);
+        
+        REQUIRE(StreamingCrypto::encrypt_shard(input, encrypted, "password123", 1, 3).success);
+        auto stitched = StreamingCrypto::stitch_shards(encrypted);
+        REQUIRE(stitched.success);
+        REQUIRE(stitched.chunks_processed == 11);
+        REQUIRE(fs::file_size(encrypted) == init.bytes_written);
+        
+        REQUIRE(StreamingCrypto::decrypt_file(encrypted, decrypted, "password123").success);
+        REQUIRE(read_bytes(decrypted) == data);
+        
+        std::vector<uint8_t> range;
+        REQUIRE(StreamingCrypto::decrypt_range(encrypted, "password123", 4096 * 7 - 10, 20, range).success);
+        REQUIRE(std::equal(range.begin(), range.end(), data.begin() + 4096 * 7 - 10));
+    }
+    
+    SECTION("A rank with the wrong password writes nothing") {
+        REQUIRE(StreamingCrypto::init_shards(input, encrypted, "password123", small_chunk_config()).success);
+        auto before = read_bytes(encrypted);
+        REQUIRE_FALSE(StreamingCrypto::encrypt_shard(input, encrypted, "wrong", 0, 2).success);
+        REQUIRE(read_bytes(encrypted) == before);
+    }
+    
+    SECTION("Compressed or mismatched layouts are refused") {
+        auto config = small_chunk_config();
+        config.compression = CompressionType::ZLIB;
+        REQUIRE_FALSE(StreamingCrypto::init_shards(input, encrypted, "password123", config).success);
+        
+        REQUIRE(StreamingCrypto::encrypt_file(input, encrypted, "password123", config).success);
+        REQUIRE_FALSE(StreamingCrypto::encrypt_shard(input, encrypted, "password123", 0, 2).success);
+        REQUIRE_FALSE(StreamingCrypto::encrypt_shard(input, encrypted, "password123", 2, 2).success);
+    }
+    
+    fs::remove_all(test_dir);
+}
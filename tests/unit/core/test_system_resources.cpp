@@ -0,0 +1,111 @@
+/**
+ * @file test_system_resources.cpp
+ * @brief Unit tests for cgroup-aware CPU and memory limits
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/core/system_resources.hpp"
+#include <fstream>
+
+using namespace filevault::core;
+namespace fs = std::filesystem;
+
+namespace {
+
+const fs::path test_dir = "test_system_resources_temp";
+constexpr uint64_t GB = 1024ull * 1024 * 1024;
+
+void write_text(const fs::path& path, const std::string& text) {
+    fs::create_directories(path.parent_path());
+    std::ofstream(path) << text << "\n";
+}
+
+SystemResources host(size_t cpus, uint64_t memory) {
+    SystemResources resources;
+    resources.host_cpus = resources.cpus = cpus;
+    resources.physical_memory = memory;
+    return resources;
+}
+
+} // anonymous namespace
+
+TEST_CASE("cgroup limit files are parsed", "[resources]") {
+    REQUIRE(SystemResources::parse_cpu_max("200000 100000") == 2.0);
+    REQUIRE(SystemResources::parse_cpu_max("50000 100000") == 0.5);
+    REQUIRE_FALSE(SystemResources::parse_cpu_max("max 100000"));
+    REQUIRE_FALSE(SystemResources::parse_cpu_max(""));
+
+    REQUIRE(SystemResources::parse_memory_max("1073741824") == GB);
+    REQUIRE_FALSE(SystemResources::parse_memory_max("max"));
+    REQUIRE_FALSE(SystemResources::parse_memory_max("9223372036854771712"));   // v1 "no limit"
+}
+
+TEST_CASE("Limits are read from the process's cgroup", "[resources]") {
+    fs::remove_all(test_dir);
+
+    SECTION("cgroup v2: the lowest limit on the way to the root wins") {
+        write_text(test_dir / "cgroup.controllers", "cpu memory");
+        write_text(test_dir / "kubepods" / "memory.max", "2147483648");
+        write_text(test_dir / "kubepods" / "pod1" / "cpu.max", "150000 100000");
+        write_text(test_dir / "kubepods" / "pod1" / "memory.max", "max");
+        write_text(test_dir / "kubepods" / "pod1" / "memory.current", "1000");
+
+        auto resources = host(64, 256 * GB);
+        REQUIRE(resources.apply_cgroup(test_dir, "0::/kubepods/pod1\n"));
+        REQUIRE(resources.cpus == 2);
+        REQUIRE(resources.memory_limit == 2 * GB);
+        REQUIRE(resources.effective_memory() == 2 * GB);
+        REQUIRE(resources.memory_usage == test_dir / "kubepods" / "pod1" / "memory.current");
+        REQUIRE(resources.limited_by == "cgroup v2");
+        REQUIRE(resources.cpu_limited());
+    }
+
+    SECTION("cgroup v2 inside a namespace: the mount root is the cgroup") {
+        write_text(test_dir / "cgroup.controllers", "cpu memory");
+        write_text(test_dir / "cpu.max", "max 100000");
+        write_text(test_dir / "memory.max", "1073741824");
+
+        auto resources = host(8, 16 * GB);
+        REQUIRE(resources.apply_cgroup(test_dir, "0::/\n"));
+        REQUIRE(resources.cpus == 8);
+        REQUIRE(resources.memory_limit == GB);
+    }
+
+    SECTION("cgroup v1 with the host's path in /proc/self/cgroup") {
+        write_text(test_dir / "cpu,cpuacct" / "cpu.cfs_quota_us", "300000");
+        write_text(test_dir / "cpu,cpuacct" / "cpu.cfs_period_us", "100000");
+        write_text(test_dir / "memory" / "memory.limit_in_bytes", "536870912");
+        write_text(test_dir / "memory" / "memory.usage_in_bytes", "1000");
+
+        auto resources = host(32, 64 * GB);
+        REQUIRE(resources.apply_cgroup(test_dir,
+                                       "5:memory:/docker/abc\n4:cpu,cpuacct:/docker/abc\n1:name=systemd:/\n"));
+        REQUIRE(resources.cpus == 3);
+        REQUIRE(resources.memory_limit == GB / 2);
+        REQUIRE(resources.limited_by == "cgroup v1");
+    }
+
+    SECTION("No limits") {
+        write_text(test_dir / "cgroup.controllers", "cpu memory");
+        write_text(test_dir / "cpu.max", "max 100000");
+        write_text(test_dir / "memory.max", "max");
+
+        auto resources = host(4, 8 * GB);
+        REQUIRE_FALSE(resources.apply_cgroup(test_dir, "0::/\n"));
+        REQUIRE(resources.cpus == 4);
+        REQUIRE(resources.memory_limit == 0);
+        REQUIRE(resources.effective_memory() == 8 * GB);
+        REQUIRE(resources.limited_by.empty());
+    }
+
+    fs::remove_all(test_dir);
+}
+
+TEST_CASE("This process's resources", "[resources]") {
+    const auto& resources = SystemResources::detect();
+    REQUIRE(resources.cpus >= 1);
+    REQUIRE(resources.cpus <= resources.host_cpus);
+    if (resources.memory_limit > 0) {
+        REQUIRE(SystemResources::available_memory() <= resources.memory_limit);
+    }
+}
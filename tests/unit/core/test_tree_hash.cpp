@@ -0,0 +1,77 @@
+/**
+ * @file test_tree_hash.cpp
+ * @brief Unit tests for parallel Merkle-tree hashing
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/core/tree_hash.hpp"
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using filevault::core::TreeHash;
+
+namespace {
+
+std::vector<uint8_t> random_bytes(size_t size) {
+    std::mt19937 rng(42);
+    std::vector<uint8_t> data(size);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    return data;
+}
+
+} // anonymous namespace
+
+TEST_CASE("TreeHash structure", "[tree_hash]") {
+    TreeHash tree("SHA-256", 1024);
+    auto data = random_bytes(5 * 1024 + 100);
+    std::span<const uint8_t> bytes(data);
+
+    SECTION("Root is built from domain-separated leaves") {
+        auto leaves = tree.leaf_hashes(data, 1);
+        REQUIRE(leaves.size() == 6);
+        REQUIRE(leaves[5] == tree.leaf(bytes.subspan(5 * 1024)));
+
+        // 6 leaves: ((0,1),(2,3)),(4,5)
+        auto left = tree.node(tree.node(leaves[0], leaves[1]), tree.node(leaves[2], leaves[3]));
+        auto right = tree.node(leaves[4], leaves[5]);
+        REQUIRE(tree.hash(data, 1) == tree.node(left, right));
+    }
+
+    SECTION("Odd nodes are carried up") {
+        auto three = bytes.first(3 * 1024);
+        auto leaves = tree.leaf_hashes(three, 1);
+        REQUIRE(tree.hash(three, 1) == tree.node(tree.node(leaves[0], leaves[1]), leaves[2]));
+    }
+
+    SECTION("Single leaf and empty input") {
+        REQUIRE(tree.hash(bytes.first(10)) == tree.leaf(bytes.first(10)));
+        REQUIRE(tree.hash({}) == tree.leaf({}));
+    }
+
+    SECTION("Invalid parameters") {
+        REQUIRE_THROWS_AS(TreeHash("SHA-256", 0), std::invalid_argument);
+    }
+}
+
+TEST_CASE("TreeHash parallel leaves", "[tree_hash][parallel]") {
+    auto data = random_bytes(9 * 1024 * 1024 + 123);
+    TreeHash tree("SHA-256", 64 * 1024);
+
+    auto serial = tree.hash(data, 1);
+    REQUIRE(tree.hash(data, 4) == serial);
+    REQUIRE(tree.hash(data, 0) == serial);
+
+    SECTION("Any changed byte changes the root") {
+        auto edited = data;
+        edited[7 * 1024 * 1024] ^= 1;
+        REQUIRE(tree.hash(edited, 4) != serial);
+    }
+
+    SECTION("Leaf size is part of the result") {
+        TreeHash other("SHA-256", 128 * 1024);
+        REQUIRE(other.hash(data, 4) != serial);
+    }
+}
@@ -0,0 +1,91 @@
+/**
+ * @file test_tree_runner.cpp
+ * @brief Unit tests for directory tree jobs on a worker pool
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/core/tree_runner.hpp"
+#include <atomic>
+#include <fstream>
+
+using namespace filevault::core;
+namespace fs = std::filesystem;
+
+namespace {
+
+std::vector<TreeFile> sized_files(const std::vector<uint64_t>& sizes) {
+    std::vector<TreeFile> files;
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        files.push_back({"in/" + std::to_string(i), "out/" + std::to_string(i), sizes[i]});
+    }
+    return files;
+}
+
+} // anonymous namespace
+
+TEST_CASE("TreeRunner plan", "[tree_runner]") {
+    TreeRunOptions options;
+    options.small_file_bytes = 100;
+    options.group_bytes = 250;
+    options.large_file_bytes = 10000;
+
+    // Small files 0,1,2 fill one group; 4 and 6 start the next
+    auto files = sized_files({90, 90, 90, 500, 10, 20000, 10});
+    auto plan = TreeRunner::plan(files, options);
+
+    REQUIRE(plan.large == std::vector<size_t>{5});
+    REQUIRE(plan.tasks.size() == 3);
+    REQUIRE(plan.tasks[0] == std::vector<size_t>{3});
+    REQUIRE(plan.tasks[1] == std::vector<size_t>{0, 1, 2});
+    REQUIRE(plan.tasks[2] == std::vector<size_t>{4, 6});
+
+    // The smallest file first, then the pool tasks, then the large files
+    REQUIRE(TreeRunner::schedule(files, options) == std::vector<size_t>{4, 3, 0, 1, 2, 6, 5});
+
+    options.large_file_bytes = 0;
+    REQUIRE(TreeRunner::plan(files, options).large.empty());
+}
+
+TEST_CASE("TreeRunner run", "[tree_runner]") {
+    auto root = fs::temp_directory_path() / "filevault_test_tree_runner";
+    fs::remove_all(root);
+
+    TreeRunOptions options;
+    options.workers = 4;
+    options.small_file_bytes = 100;
+    options.large_file_bytes = 1000;
+
+    std::vector<TreeFile> files;
+    for (int i = 0; i < 40; ++i) {
+        files.push_back({"f" + std::to_string(i), root / "a" / std::to_string(i % 3) / std::to_string(i),
+                         static_cast<uint64_t>(i * 10)});
+    }
+    files.push_back({"big", root / "big", 5000});
+
+    std::atomic<uint64_t> advanced{0};
+    options.on_advance = [&advanced](uint64_t bytes) { advanced += bytes; };
+
+    std::atomic<size_t> big_threads{0};
+    auto result = TreeRunner::run(files, [&](const TreeFile& file, size_t threads,
+                                             const TreeRunner::Advance& advance) -> std::string {
+        if (file.source == "f7") {
+            return "refused";
+        }
+        if (file.source == "big") {
+            big_threads = threads;
+            advance(2500);
+        }
+        std::ofstream(file.target) << file.size;
+        return "";
+    }, options);
+
+    REQUIRE(result.succeeded == 40);
+    REQUIRE(result.errors == std::vector<std::string>{"f7: refused"});
+    REQUIRE(result.bytes == 200 * 39 - 70 + 5000);
+    REQUIRE(big_threads == 4);
+    REQUIRE(advanced == 200 * 39 + 5000);
+    REQUIRE(fs::exists(root / "a" / "2" / "38"));
+    REQUIRE_FALSE(fs::exists(root / "a" / "1" / "7"));
+
+    fs::remove_all(root);
+}
@@ -1,5 +1,6 @@
 #include <catch2/catch_test_macros.hpp>
 #include "filevault/algorithms/symmetric/aes_gcm.hpp"
+#include <algorithm>
 #include <vector>
 
 using namespace filevault::algorithms::symmetric;
@@ -104,6 +105,251 @@ TEST_CASE("AES-GCM encryption/decryption", "[aes][gcm]") {
     }
 }
 
+TEST_CASE("AES-GCM in-place encryption", "[aes][gcm][inplace]") {
+    AES_GCM cipher(256);
+    EncryptionConfig config;
+    config.nonce = std::vector<uint8_t>(12, 0x03);
+    
+    std::vector<uint8_t> key(32, 0x42);
+    std::vector<uint8_t> pt(1000);
+    for (size_t i = 0; i < pt.size(); ++i) {
+        pt[i] = static_cast<uint8_t>(i * 7);
+    }
+    
+    SECTION("Matches out-of-place encrypt") {
+        auto reference = cipher.encrypt(pt, key, config);
+        REQUIRE(reference.success);
+        
+        std::vector<uint8_t> buffer = pt;
+        auto result = cipher.encrypt_in_place(buffer, key, config);
+        REQUIRE(result.success);
+        REQUIRE(result.data.empty());
+        REQUIRE(buffer == reference.data);
+        REQUIRE(result.tag == reference.tag);
+        
+        config.tag = result.tag.value();
+        auto decrypted = cipher.decrypt_in_place(buffer, key, config);
+        REQUIRE(decrypted.success);
+        REQUIRE(buffer == pt);
+    }
+    
+    SECTION("Tampered buffer is rejected and cleared") {
+        std::vector<uint8_t> buffer = pt;
+        auto result = cipher.encrypt_in_place(buffer, key, config);
+        REQUIRE(result.success);
+        
+        buffer[10] ^= 0x01;
+        config.tag = result.tag.value();
+        auto decrypted = cipher.decrypt_in_place(buffer, key, config);
+        REQUIRE_FALSE(decrypted.success);
+        REQUIRE(buffer.empty());
+    }
+}
+
+TEST_CASE("AES-GCM cipher session", "[aes][gcm][session]") {
+    AES_GCM cipher(256);
+    std::vector<uint8_t> key(32, 0x5A);
+    
+    SECTION("Rejects wrong key size") {
+        std::vector<uint8_t> short_key(16, 0x5A);
+        REQUIRE(cipher.create_session(short_key) == nullptr);
+    }
+    
+    SECTION("Matches one-shot encryption across many messages") {
+        auto session = cipher.create_session(key);
+        REQUIRE(session != nullptr);
+        
+        for (uint8_t i = 0; i < 8; ++i) {
+            EncryptionConfig config;
+            config.nonce = std::vector<uint8_t>(12, i);
+            if (i % 2 == 1) {
+                config.associated_data = std::vector<uint8_t>{i, 0xAD};
+            }
+            
+            std::vector<uint8_t> pt(100 + i * 37, static_cast<uint8_t>(i * 3));
+            auto expected = cipher.encrypt(pt, key, config);
+            REQUIRE(expected.success);
+            
+            std::vector<uint8_t> buffer = pt;
+            auto result = session->encrypt_in_place(buffer, config);
+            REQUIRE(result.success);
+            REQUIRE(buffer == expected.data);
+            REQUIRE(result.tag == expected.tag);
+            
+            // Associated data must not carry over to the next message
+            config.tag = result.tag.value();
+            auto decrypted = session->decrypt_in_place(buffer, config);
+            REQUIRE(decrypted.success);
+            REQUIRE(buffer == pt);
+        }
+    }
+    
+    SECTION("Tampered message leaves the session usable") {
+        auto session = cipher.create_session(key);
+        EncryptionConfig config;
+        config.nonce = std::vector<uint8_t>(12, 0x07);
+        
+        std::vector<uint8_t> pt(64, 0x42);
+        std::vector<uint8_t> buffer = pt;
+        auto result = session->encrypt_in_place(buffer, config);
+        REQUIRE(result.success);
+        config.tag = result.tag.value();
+        
+        std::vector<uint8_t> tampered = buffer;
+        tampered[0] ^= 0x01;
+        REQUIRE_FALSE(session->decrypt_in_place(tampered, config).success);
+        REQUIRE(tampered.empty());
+        
+        REQUIRE(session->decrypt_in_place(buffer, config).success);
+        REQUIRE(buffer == pt);
+    }
+    
+    SECTION("Incremental decryption matches one-shot") {
+        auto session = cipher.create_session(key);
+        EncryptionConfig config;
+        config.nonce = std::vector<uint8_t>(12, 0x09);
+        config.associated_data = std::vector<uint8_t>{0xAD};
+        
+        std::vector<uint8_t> pt(10000);
+        for (size_t i = 0; i < pt.size(); ++i) {
+            pt[i] = static_cast<uint8_t>(i * 7);
+        }
+        auto sealed = cipher.encrypt(pt, key, config);
+        REQUIRE(sealed.success);
+        config.tag = sealed.tag.value();
+        
+        REQUIRE(session->decrypt_begin(config));
+        size_t piece = std::max<size_t>(session->decrypt_granularity(), 1024);
+        std::vector<uint8_t> out;
+        size_t offset = 0;
+        for (; sealed.data.size() - offset > piece; offset += piece) {
+            std::vector<uint8_t> buffer(sealed.data.begin() + offset, sealed.data.begin() + offset + piece);
+            size_t produced = session->decrypt_update(buffer);
+            out.insert(out.end(), buffer.begin(), buffer.begin() + produced);
+        }
+        std::vector<uint8_t> last(sealed.data.begin() + offset, sealed.data.end());
+        REQUIRE(session->decrypt_finish(last).success);
+        out.insert(out.end(), last.begin(), last.end());
+        REQUIRE(out == pt);
+        
+        // A bad tag fails at the end and clears the last piece
+        config.tag.value()[0] ^= 0x01;
+        REQUIRE(session->decrypt_begin(config));
+        std::vector<uint8_t> whole = sealed.data;
+        REQUIRE_FALSE(session->decrypt_finish(whole).success);
+        REQUIRE(whole.empty());
+        
+        config.nonce = std::vector<uint8_t>(8, 0x09);
+        REQUIRE_FALSE(session->decrypt_begin(config));
+    }
+    
+    SECTION("Incremental encryption matches one-shot") {
+        auto session = cipher.create_session(key);
+        EncryptionConfig config;
+        config.nonce = std::vector<uint8_t>(12, 0x0A);
+        config.associated_data = std::vector<uint8_t>{0xAD};
+        
+        std::vector<uint8_t> pt(10000);
+        for (size_t i = 0; i < pt.size(); ++i) {
+            pt[i] = static_cast<uint8_t>(i * 13);
+        }
+        auto sealed = cipher.encrypt(pt, key, config);
+        REQUIRE(sealed.success);
+        
+        REQUIRE(session->encrypt_begin(config));
+        size_t piece = std::max<size_t>(session->encrypt_granularity(), 1024);
+        std::vector<uint8_t> out;
+        size_t offset = 0;
+        for (; pt.size() - offset > piece; offset += piece) {
+            std::vector<uint8_t> buffer(pt.begin() + offset, pt.begin() + offset + piece);
+            size_t produced = session->encrypt_update(buffer);
+            out.insert(out.end(), buffer.begin(), buffer.begin() + produced);
+        }
+        std::vector<uint8_t> last(pt.begin() + offset, pt.end());
+        auto finished = session->encrypt_finish(last);
+        REQUIRE(finished.success);
+        out.insert(out.end(), last.begin(), last.end());
+        REQUIRE(out == sealed.data);
+        REQUIRE(finished.tag.value() == sealed.tag.value());
+        REQUIRE(finished.nonce.value() == config.nonce.value());
+        
+        // The nonce goes in the header first, so it cannot be generated here
+        config.nonce.reset();
+        REQUIRE_FALSE(session->encrypt_begin(config));
+    }
+}
+
+TEST_CASE("AES-GCM batch encryption", "[aes][gcm][batch]") {
+    AES_GCM cipher(256);
+    std::vector<uint8_t> key(32, 0x3C);
+    EncryptionConfig config;
+    config.associated_data = std::vector<uint8_t>{0x01, 0x02};
+    
+    std::vector<std::vector<uint8_t>> messages;
+    for (size_t i = 0; i < 50; ++i) {
+        messages.emplace_back(1024 + i * 61, static_cast<uint8_t>(i));
+    }
+    messages.emplace_back();  // Empty messages are allowed
+    std::vector<std::span<const uint8_t>> spans(messages.begin(), messages.end());
+    
+    std::vector<uint8_t> arena;
+    auto sealed = cipher.encrypt_batch(spans, key, config, arena);
+    REQUIRE(sealed.success);
+    REQUIRE(sealed.records.size() == messages.size());
+    
+    SECTION("Records are contiguous with unique nonces") {
+        size_t expected_offset = 0;
+        for (const auto& record : sealed.records) {
+            REQUIRE(record.offset == expected_offset);
+            REQUIRE(record.nonce_size == 12);
+            REQUIRE(record.tag_size == 16);
+            expected_offset += record.total_size();
+        }
+        REQUIRE(arena.size() == expected_offset);
+        
+        auto first = std::vector<uint8_t>(arena.begin(), arena.begin() + 12);
+        auto second = std::vector<uint8_t>(
+            arena.begin() + sealed.records[1].offset,
+            arena.begin() + sealed.records[1].offset + 12);
+        REQUIRE(first != second);
+    }
+    
+    SECTION("Each record opens with the one-shot API") {
+        const auto& record = sealed.records[7];
+        EncryptionConfig open_config = config;
+        open_config.nonce = std::vector<uint8_t>(
+            arena.begin() + record.offset, arena.begin() + record.data_offset());
+        open_config.tag = std::vector<uint8_t>(
+            arena.begin() + record.tag_offset(), arena.begin() + record.tag_offset() + record.tag_size);
+        
+        auto ciphertext = std::span<const uint8_t>(arena).subspan(record.data_offset(), record.data_size);
+        auto decrypted = cipher.decrypt(ciphertext, key, open_config);
+        REQUIRE(decrypted.success);
+        REQUIRE(decrypted.data == messages[7]);
+    }
+    
+    SECTION("Batch decryption round trip") {
+        std::vector<uint8_t> output;
+        auto opened = cipher.decrypt_batch(arena, sealed.records, key, config, output);
+        REQUIRE(opened.success);
+        for (size_t i = 0; i < messages.size(); ++i) {
+            const auto& record = opened.records[i];
+            REQUIRE(std::vector<uint8_t>(
+                output.begin() + record.offset,
+                output.begin() + record.offset + record.data_size) == messages[i]);
+        }
+    }
+    
+    SECTION("Tampered record fails the batch") {
+        arena[sealed.records[20].data_offset()] ^= 0x80;
+        std::vector<uint8_t> output;
+        auto opened = cipher.decrypt_batch(arena, sealed.records, key, config, output);
+        REQUIRE_FALSE(opened.success);
+        REQUIRE(opened.failed_index == 20);
+        REQUIRE(output.empty());
+    }
+}
+
 TEST_CASE("AES-GCM NIST test vectors", "[aes][gcm][nist]") {
     // Test Case 1 from NIST SP 800-38D
     AES_GCM cipher(128);
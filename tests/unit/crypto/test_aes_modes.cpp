@@ -9,6 +9,8 @@
 #include "filevault/algorithms/symmetric/aes_ofb.hpp"
 #include "filevault/algorithms/symmetric/aes_ecb.hpp"
 #include "filevault/algorithms/symmetric/aes_xts.hpp"
+#include "filevault/core/thread_pool.hpp"
+#include <algorithm>
 #include <vector>
 #include <string>
 
@@ -262,6 +264,57 @@ TEST_CASE("AES-XTS minimum block size", "[aes-xts]") {
     REQUIRE(result.error_message.find("16 bytes") != std::string::npos);
 }
 
+TEST_CASE("AES-XTS sector cipher", "[aes-xts][sectors]") {
+    auto key = generate_key(64);
+    XtsSectorCipher sectors(key, 512);
+    
+    std::vector<uint8_t> disk(512 * 2048);
+    for (size_t i = 0; i < disk.size(); ++i) {
+        disk[i] = static_cast<uint8_t>(i * 31 + i / 512);
+    }
+    const auto original = disk;
+    
+    SECTION("Each sector is one XTS data unit tweaked by its number") {
+        sectors.encrypt(100, disk);
+        REQUIRE(disk != original);
+        
+        AES_XTS xts(256);
+        EncryptionConfig config;
+        auto tweak = XtsSectorCipher::tweak(107);
+        config.nonce = std::vector<uint8_t>(tweak.begin(), tweak.end());
+        auto one = xts.encrypt(std::span<const uint8_t>(original).subspan(7 * 512, 512), key, config);
+        REQUIRE(one.success);
+        REQUIRE(std::equal(one.data.begin(), one.data.end(), disk.begin() + 7 * 512));
+        
+        // Any run of sectors decrypts on its own
+        std::vector<uint8_t> run(disk.begin() + 5 * 512, disk.begin() + 9 * 512);
+        sectors.decrypt(105, run);
+        REQUIRE(std::equal(run.begin(), run.end(), original.begin() + 5 * 512));
+        
+        sectors.decrypt(100, disk);
+        REQUIRE(disk == original);
+    }
+    
+    SECTION("Parallel matches serial") {
+        filevault::core::ThreadPool pool(4);
+        auto serial = original;
+        sectors.encrypt(0, serial);
+        sectors.encrypt(0, disk, &pool);
+        REQUIRE(disk == serial);
+        sectors.decrypt(0, disk, &pool);
+        REQUIRE(disk == original);
+    }
+    
+    SECTION("Invalid sizes are rejected") {
+        std::vector<uint8_t> partial(700);
+        REQUIRE_THROWS_AS(sectors.encrypt(0, partial), std::invalid_argument);
+        REQUIRE_THROWS_AS(XtsSectorCipher(generate_key(48), 512), std::invalid_argument);
+        REQUIRE_THROWS_AS(XtsSectorCipher(key, 1000), std::invalid_argument);
+        REQUIRE_THROWS_AS(XtsSectorCipher(key, 256), std::invalid_argument);
+        REQUIRE(XtsSectorCipher(generate_key(32), 4096).sector_size() == 4096);
+    }
+}
+
 // ============================================================================
 // Invalid Key Size Tests
 // ============================================================================
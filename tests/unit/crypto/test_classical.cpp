@@ -4,6 +4,12 @@
 #include "filevault/algorithms/classical/playfair.hpp"
 #include "filevault/algorithms/classical/hill.hpp"
 #include "filevault/algorithms/classical/substitution.hpp"
+#include "filevault/algorithms/classical/kernels.hpp"
+#include "filevault/algorithms/classical/cryptanalysis.hpp"
+#include <algorithm>
+#include <cctype>
+#include <random>
+#include <stdexcept>
 #include <vector>
 #include <string>
 
@@ -109,6 +115,42 @@ TEST_CASE("Playfair cipher encryption/decryption", "[classical][playfair]") {
         std::string result(decrypted.data.begin(), decrypted.data.end());
         REQUIRE(result.substr(0, 5) == "HELLO");
     }
+    
+    SECTION("Known digraphs") {
+        // Wikipedia example, doubled letters already split by X
+        std::string plaintext = "hide the gold in the trexe stump";
+        std::string keyword = "PLAYFAIREXAMPLE";
+        std::vector<uint8_t> pt(plaintext.begin(), plaintext.end());
+        std::vector<uint8_t> key(keyword.begin(), keyword.end());
+        
+        auto encrypted = cipher.encrypt(pt, key, config);
+        REQUIRE(encrypted.success);
+        REQUIRE(std::string(encrypted.data.begin(), encrypted.data.end()) == "BMODZBXDNABEKUDMUIXMMOUVIF");
+        REQUIRE(encrypted.final_size == encrypted.data.size());
+        
+        auto decrypted = cipher.decrypt(encrypted.data, key, config);
+        REQUIRE(std::string(decrypted.data.begin(), decrypted.data.end()) == "HIDETHEGOLDINTHETREXESTUMP");
+    }
+    
+    SECTION("Key changes rebuild the tables") {
+        std::string plaintext(1000, 'A');
+        for (size_t i = 0; i < plaintext.size(); ++i) {
+            plaintext[i] = static_cast<char>('A' + (i * 7) % 26);
+        }
+        std::vector<uint8_t> pt(plaintext.begin(), plaintext.end());
+        std::vector<uint8_t> key1 = {'M', 'O', 'N', 'A', 'R', 'C', 'H', 'Y'};
+        std::vector<uint8_t> key2 = {'Z', 'E', 'B', 'R', 'A', 'S'};
+        
+        auto first = cipher.encrypt(pt, key1, config);
+        auto second = cipher.encrypt(pt, key2, config);
+        REQUIRE(first.data != second.data);
+        REQUIRE(cipher.encrypt(pt, key1, config).data == first.data);
+        
+        std::string expected = plaintext;
+        std::replace(expected.begin(), expected.end(), 'J', 'I');
+        auto decrypted = cipher.decrypt(second.data, key2, config);
+        REQUIRE(std::string(decrypted.data.begin(), decrypted.data.end()) == expected);
+    }
 }
 
 TEST_CASE("Hill cipher encryption/decryption", "[classical][hill]") {
@@ -143,6 +185,26 @@ TEST_CASE("Hill cipher encryption/decryption", "[classical][hill]") {
         // Should add 'X' padding
         REQUIRE(encrypted.data.size() == 4);  // HELX
     }
+    
+    SECTION("Long text across batches and key changes") {
+        std::string plaintext(999, 'A');
+        for (size_t i = 0; i < plaintext.size(); ++i) {
+            plaintext[i] = static_cast<char>((i % 3 ? 'a' : 'A') + (i * 11) % 26);
+        }
+        std::vector<uint8_t> pt(plaintext.begin(), plaintext.end());
+        std::vector<uint8_t> key1 = {3, 3, 2, 5};
+        std::vector<uint8_t> key2 = {7, 1, 4, 9};
+        
+        std::string expected = plaintext + "X";
+        std::transform(expected.begin(), expected.end(), expected.begin(), ::toupper);
+        for (const auto* key : {&key1, &key2, &key1}) {
+            auto encrypted = cipher.encrypt(pt, *key, config);
+            REQUIRE(encrypted.success);
+            REQUIRE(encrypted.data.size() == 1000);
+            auto decrypted = cipher.decrypt(encrypted.data, *key, config);
+            REQUIRE(std::string(decrypted.data.begin(), decrypted.data.end()) == expected);
+        }
+    }
 }
 
 TEST_CASE("Substitution cipher encryption/decryption", "[classical][substitution]") {
@@ -178,3 +240,281 @@ TEST_CASE("Substitution cipher encryption/decryption", "[classical][substitution
         REQUIRE(result == plaintext);
     }
 }
+
+namespace {
+
+// Original per-character loops, kept as the reference for the kernels
+std::vector<uint8_t> reference_vigenere(const std::vector<uint8_t>& input,
+                                        const std::string& keyword, bool decrypt) {
+    std::vector<uint8_t> output;
+    size_t key_index = 0;
+    for (uint8_t byte : input) {
+        char ch = static_cast<char>(byte);
+        if (std::isalpha(ch)) {
+            char base = std::isupper(ch) ? 'A' : 'a';
+            int shift = keyword[key_index % keyword.size()] - 'A';
+            ch = decrypt ? base + (ch - base - shift + 26) % 26
+                         : base + (ch - base + shift) % 26;
+            key_index++;
+        }
+        output.push_back(static_cast<uint8_t>(ch));
+    }
+    return output;
+}
+
+std::vector<uint8_t> reference_caesar(const std::vector<uint8_t>& input, int shift) {
+    std::vector<uint8_t> output;
+    for (uint8_t byte : input) {
+        char ch = static_cast<char>(byte);
+        if (std::isalpha(ch)) {
+            char base = std::isupper(ch) ? 'A' : 'a';
+            ch = base + (ch - base + shift + 26) % 26;
+        }
+        output.push_back(static_cast<uint8_t>(ch));
+    }
+    return output;
+}
+
+std::vector<uint8_t> reference_substitute(const std::vector<uint8_t>& input,
+                                          const std::array<char, 26>& map) {
+    std::vector<uint8_t> output;
+    for (uint8_t byte : input) {
+        char c = static_cast<char>(byte);
+        if (std::isalpha(c)) {
+            char substituted = map[std::toupper(c) - 'A'];
+            c = std::isupper(c) ? substituted : static_cast<char>(std::tolower(substituted));
+        }
+        output.push_back(static_cast<uint8_t>(c));
+    }
+    return output;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Classical kernels match the scalar reference", "[classical][kernels]") {
+    std::mt19937 gen(42);
+    
+    // Lengths around the 16-byte block size, text mixed with binary bytes
+    std::vector<size_t> lengths = {0, 1, 15, 16, 17, 31, 33, 100, 4099};
+    auto make_input = [&](size_t n) {
+        static const std::string text = "The quick brown fox, JUMPS over 13 lazy dogs!\n";
+        std::vector<uint8_t> data(n);
+        for (auto& b : data) {
+            b = (gen() % 4 == 0) ? static_cast<uint8_t>(gen())
+                                 : static_cast<uint8_t>(text[gen() % text.size()]);
+        }
+        return data;
+    };
+    
+    SECTION("Caesar") {
+        for (size_t n : lengths) {
+            auto input = make_input(n);
+            for (int shift = -25; shift <= 25; shift += 7) {
+                std::vector<uint8_t> output(n);
+                kernels::caesar(input, output, shift);
+                REQUIRE(output == reference_caesar(input, shift));
+            }
+        }
+    }
+    
+    SECTION("Vigenère with letter and binary keywords") {
+        for (size_t n : lengths) {
+            auto input = make_input(n);
+            for (bool binary : {false, true}) {
+                std::string keyword(1 + gen() % 40, 'A');
+                for (auto& c : keyword) {
+                    c = binary ? static_cast<char>(gen()) : static_cast<char>('A' + gen() % 26);
+                }
+                std::transform(keyword.begin(), keyword.end(), keyword.begin(), ::toupper);
+                
+                for (bool decrypt : {false, true}) {
+                    auto schedule = kernels::ShiftSchedule::from_keyword(keyword, decrypt);
+                    std::vector<uint8_t> output(n);
+                    
+                    // Split the input to check the key position carries over
+                    size_t split = n / 3;
+                    size_t key_index = kernels::vigenere(
+                        std::span(input).first(split), std::span(output).first(split), schedule);
+                    kernels::vigenere(std::span(input).subspan(split),
+                                      std::span(output).subspan(split), schedule, key_index);
+                    REQUIRE(output == reference_vigenere(input, keyword, decrypt));
+                }
+            }
+        }
+    }
+    
+    SECTION("Substitution, including in place") {
+        std::array<char, 26> map;
+        for (size_t i = 0; i < 26; ++i) {
+            map[i] = static_cast<char>('A' + i);
+        }
+        std::shuffle(map.begin(), map.end(), gen);
+        
+        for (size_t n : lengths) {
+            auto input = make_input(n);
+            auto expected = reference_substitute(input, map);
+            
+            std::vector<uint8_t> output(n);
+            kernels::substitute(input, output, map);
+            REQUIRE(output == expected);
+            
+            kernels::substitute(input, input, map);
+            REQUIRE(input == expected);
+        }
+    }
+    
+    SECTION("Letter histogram") {
+        for (size_t n : lengths) {
+            auto input = make_input(n);
+            std::array<uint64_t, 26> expected{};
+            for (uint8_t byte : input) {
+                if (std::isalpha(byte)) {
+                    expected[std::toupper(byte) - 'A']++;
+                }
+            }
+            std::array<uint64_t, 26> counts{};
+            kernels::letter_histogram(input, counts);
+            REQUIRE(counts == expected);
+        }
+        
+        // Past the 8-bit lane counter limit
+        std::vector<uint8_t> letters(16 * 600, 'e');
+        std::array<uint64_t, 26> counts{};
+        kernels::letter_histogram(letters, counts);
+        REQUIRE(counts[4] == letters.size());
+    }
+    
+    SECTION("Vigenère rejects an empty keyword") {
+        Vigenere cipher("");
+        EncryptionConfig config;
+        std::vector<uint8_t> pt = {'A', 'B'};
+        REQUIRE_FALSE(cipher.encrypt(pt, {}, config).success);
+    }
+}
+
+TEST_CASE("Classical in-place transforms match the copying path", "[classical][inplace]") {
+    EncryptionConfig config;
+    std::string text = "Attack at dawn, retreat at DUSK! 0123456789\n";
+    std::vector<uint8_t> plaintext;
+    for (int i = 0; i < 100; ++i) {
+        plaintext.insert(plaintext.end(), text.begin(), text.end());
+    }
+    
+    // Alternating keys check that cached key state follows the key passed in
+    auto check = [&](ICryptoAlgorithm& cipher, const std::vector<std::vector<uint8_t>>& keys) {
+        for (int round = 0; round < 2; ++round) {
+            for (const auto& key : keys) {
+                auto expected = cipher.encrypt(plaintext, key, config);
+                REQUIRE(expected.success);
+                
+                std::vector<uint8_t> buffer = plaintext;
+                auto result = cipher.encrypt_in_place(buffer, key, config);
+                REQUIRE(result.success);
+                REQUIRE(result.data.empty());
+                REQUIRE(buffer == expected.data);
+                
+                REQUIRE(cipher.decrypt_in_place(buffer, key, config).success);
+                REQUIRE(buffer == plaintext);
+            }
+        }
+    };
+    
+    SECTION("Caesar") {
+        Caesar cipher;
+        check(cipher, {{3}, {25}});
+    }
+    
+    SECTION("Vigenère") {
+        Vigenere cipher;
+        check(cipher, {{'L', 'E', 'M', 'O', 'N'}, {'K', 'E', 'Y'}, {}});
+    }
+    
+    SECTION("Substitution") {
+        SubstitutionCipher cipher;
+        std::string first = "testkey";
+        std::string second = "QWERTYUIOPASDFGHJKLZXCVBNM";
+        check(cipher, {{first.begin(), first.end()}, {second.begin(), second.end()}});
+    }
+}
+
+TEST_CASE("Classical cryptanalysis recovers keys", "[classical][crack]") {
+    const std::string text =
+        "The history of secret writing is a long contest between people who hide messages and "
+        "people who read them anyway. Early ciphers replaced each letter of the alphabet with "
+        "another, and for centuries that seemed safe enough, until scholars noticed that every "
+        "language leaves fingerprints. In English the letter E appears far more often than any "
+        "other, followed by T, A and O, while letters such as Q and Z are rare. A patient reader "
+        "who counts the symbols of a long ciphertext can therefore guess which symbol stands for "
+        "which letter, and the words begin to surface one by one. The same idea defeats a shifted "
+        "alphabet in seconds, because there are only twenty six ways to shift it. A keyword "
+        "cipher that changes the shift from letter to letter looked much stronger, and it was "
+        "called unbreakable for three hundred years. Yet once the length of the keyword is known, "
+        "the message splits into columns that are each a simple shifted alphabet, and the old "
+        "counting method applies again to every column on its own. Modern ciphers are designed so "
+        "that no such statistics survive encryption, which is why students still begin with these "
+        "classical systems: they show exactly what a good cipher must avoid.";
+    std::vector<uint8_t> plaintext(text.begin(), text.end());
+    EncryptionConfig config;
+    CrackOptions options;
+    options.threads = 2;
+    
+    SECTION("Caesar") {
+        Caesar cipher;
+        std::vector<uint8_t> key = {17};
+        auto ciphertext = cipher.encrypt(plaintext, key, config).data;
+        auto result = ClassicalCracker::crack_caesar(ciphertext, options);
+        REQUIRE(result.success);
+        REQUIRE(result.key == key);
+        REQUIRE(result.plaintext == plaintext);
+        REQUIRE(result.keys_tried == 26);
+    }
+    
+    SECTION("Vigenère") {
+        for (std::string keyword : {"KEY", "LEMON", "CLASSICAL"}) {
+            Vigenere cipher;
+            std::vector<uint8_t> key(keyword.begin(), keyword.end());
+            auto ciphertext = cipher.encrypt(plaintext, key, config).data;
+            auto result = ClassicalCracker::crack_vigenere(ciphertext, options);
+            REQUIRE(result.success);
+            REQUIRE(result.key_text == keyword);
+            REQUIRE(result.plaintext == plaintext);
+            REQUIRE(result.keys_tried > 0);
+        }
+    }
+    
+    SECTION("Substitution") {
+        std::array<char, 26> map;
+        for (size_t i = 0; i < 26; ++i) {
+            map[i] = static_cast<char>('A' + i);
+        }
+        std::mt19937 gen(3);
+        std::shuffle(map.begin(), map.end(), gen);
+        std::vector<uint8_t> ciphertext(plaintext.size());
+        kernels::substitute(plaintext, ciphertext, map);
+        
+        options.restarts = 8;
+        auto result = ClassicalCracker::crack_substitution(ciphertext, options);
+        REQUIRE(result.success);
+        
+        // Rare letters may stay swapped; nearly all text must come back
+        size_t letters = 0, correct = 0;
+        for (size_t i = 0; i < plaintext.size(); ++i) {
+            if (std::isalpha(plaintext[i])) {
+                letters++;
+                correct += result.plaintext[i] == plaintext[i];
+            }
+        }
+        REQUIRE(correct >= letters * 95 / 100);
+    }
+    
+    SECTION("Trained models and bad input") {
+        auto model = NgramModel::train(plaintext, 3);
+        REQUIRE(model.order() == 3);
+        REQUIRE_THROWS_AS(NgramModel::train(plaintext, 5), std::invalid_argument);
+        REQUIRE_THROWS_AS(NgramModel::train(std::vector<uint8_t>(50, 'a'), 2), std::invalid_argument);
+        
+        std::vector<uint8_t> digits = {'1', '2', '3'};
+        REQUIRE_FALSE(ClassicalCracker::crack_caesar(digits, options).success);
+        REQUIRE_FALSE(ClassicalCracker::crack_vigenere(digits, options).success);
+    }
+}
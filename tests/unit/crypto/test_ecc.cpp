@@ -5,6 +5,11 @@
 
 #include <catch2/catch_test_macros.hpp>
 #include "filevault/algorithms/asymmetric/ecc.hpp"
+#include "filevault/algorithms/asymmetric/digest_signer.hpp"
+#include "filevault/algorithms/asymmetric/ephemeral_pool.hpp"
+#include <memory>
+#include <set>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -67,6 +72,32 @@ TEST_CASE("ECDH Key Exchange", "[ecc][ecdh]") {
         REQUIRE(alice_secret.shared_secret == bob_secret.shared_secret);
         REQUIRE(alice_secret.shared_secret.size() == 32);  // P-256 = 32 bytes
     }
+    
+    SECTION("X25519 shared secret derivation") {
+        ECDH alice(ECCurve::X25519);
+        ECDH bob(ECCurve::X25519);
+        
+        auto alice_keys = alice.generate_key_pair();
+        auto bob_keys = bob.generate_key_pair();
+        REQUIRE(alice_keys.curve_name == "x25519");
+        
+        auto alice_secret = alice.derive_shared_secret(alice_keys.private_key, bob_keys.public_key);
+        auto bob_secret = bob.derive_shared_secret(bob_keys.private_key, alice_keys.public_key);
+        REQUIRE(alice_secret.success);
+        REQUIRE(bob_secret.success);
+        REQUIRE(alice_secret.shared_secret == bob_secret.shared_secret);
+        REQUIRE(alice_secret.shared_secret.size() == 32);
+    }
+    
+    SECTION("Peer key on another curve is rejected") {
+        ECDH x25519(ECCurve::X25519);
+        ECDH p256(ECCurve::SECP256R1);
+        auto x_keys = x25519.generate_key_pair();
+        auto p_keys = p256.generate_key_pair();
+        
+        REQUIRE_FALSE(x25519.derive_shared_secret(x_keys.private_key, p_keys.public_key).success);
+        REQUIRE_FALSE(p256.derive_shared_secret(p_keys.private_key, x_keys.public_key).success);
+    }
 }
 
 // ============================================================================
@@ -142,6 +173,123 @@ TEST_CASE("ECDSA Digital Signatures", "[ecc][ecdsa]") {
     }
 }
 
+// ============================================================================
+// Ed25519 and Digest Signing Tests
+// ============================================================================
+
+TEST_CASE("Ed25519 Digital Signatures", "[ecc][ed25519]") {
+    Ed25519 ed25519;
+    auto keypair = ed25519.generate_key_pair();
+    auto private_key = LoadedKey::load(keypair.private_key);
+    auto public_key = LoadedKey::load(keypair.public_key);
+    REQUIRE(private_key.success);
+    REQUIRE(public_key.success);
+    REQUIRE(public_key.value.algorithm() == "Ed25519");
+
+    std::vector<uint8_t> data = {1, 2, 3, 4, 5, 6, 7, 8};
+
+    SECTION("Sign and verify") {
+        auto sign_result = ed25519.sign(data, private_key.value);
+        REQUIRE(sign_result.success);
+        REQUIRE(sign_result.signature.size() == ed25519.signature_size());
+        REQUIRE(ed25519.verify(data, sign_result.signature, public_key.value));
+    }
+
+    SECTION("Signature fails with modified data") {
+        auto sign_result = ed25519.sign(data, private_key.value);
+        REQUIRE(sign_result.success);
+        data[0] ^= 0xFF;
+        REQUIRE_FALSE(ed25519.verify(data, sign_result.signature, public_key.value));
+    }
+
+    SECTION("Curve cannot be used for ECDSA or ECDH") {
+        REQUIRE_THROWS(ECDSA(ECCurve::ED25519));
+        REQUIRE_THROWS(ECDH(ECCurve::ED25519));
+    }
+
+    SECTION("Batch sign and verify") {
+        std::vector<std::vector<uint8_t>> messages;
+        for (uint8_t i = 0; i < 50; ++i) {
+            messages.push_back({i, 0x10, 0x20});
+        }
+        auto signatures = ed25519.sign_batch(private_key.value, messages, 4);
+        REQUIRE(signatures.size() == messages.size());
+
+        // Same signatures as one at a time (Ed25519 is deterministic)
+        REQUIRE(signatures[7] == ed25519.sign(messages[7], private_key.value).signature);
+
+        signatures[13][5] ^= 0x01;
+        messages[31][0] ^= 0x01;
+        auto valid = ed25519.verify_batch(public_key.value, messages, signatures, 4);
+        REQUIRE(valid.size() == messages.size());
+        for (size_t i = 0; i < valid.size(); ++i) {
+            INFO("signature " << i);
+            REQUIRE(valid[i] == (i != 13 && i != 31));
+        }
+
+        signatures.pop_back();
+        REQUIRE_THROWS_AS(ed25519.verify_batch(public_key.value, messages, signatures), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Digest Signer", "[ecc][sign]") {
+    std::vector<uint8_t> data(100000, 0x5A);
+    auto digest = DigestSigner::digest(data);
+    REQUIRE(digest.size() == DigestSigner::DIGEST_SIZE);
+
+    SECTION("ECDSA digest signature matches whole-message ECDSA") {
+        ECDSA ecdsa(ECCurve::SECP256R1);
+        auto keypair = ecdsa.generate_key_pair();
+        auto private_key = LoadedKey::load(keypair.private_key);
+        auto public_key = LoadedKey::load(keypair.public_key);
+        REQUIRE(private_key.success);
+        REQUIRE(public_key.success);
+
+        DigestSigner signer(private_key.value);
+        DigestSigner verifier(public_key.value);
+        REQUIRE(signer.scheme() == SignatureScheme::ECDSA);
+
+        auto signature = signer.sign(digest);
+        REQUIRE(verifier.verify(digest, signature));
+        REQUIRE(ecdsa.verify(data, signature, public_key.value));
+
+        auto whole = ecdsa.sign(data, private_key.value);
+        REQUIRE(whole.success);
+        REQUIRE(verifier.verify(digest, whole.signature));
+
+        digest[0] ^= 0x01;
+        REQUIRE_FALSE(verifier.verify(digest, signature));
+    }
+
+    SECTION("Ed25519 digest round-trip") {
+        Ed25519 ed25519;
+        auto keypair = ed25519.generate_key_pair();
+        auto private_key = LoadedKey::load(keypair.private_key);
+        REQUIRE(private_key.success);
+
+        DigestSigner signer(private_key.value);
+        REQUIRE(signer.scheme() == SignatureScheme::ED25519);
+        auto signature = signer.sign(digest);
+        REQUIRE(signer.verify(digest, signature));
+        REQUIRE_THROWS(signer.sign(data));
+    }
+
+    SECTION("ECDH keys cannot sign") {
+        ECDH ecdh(ECCurve::SECP256R1);
+        auto keypair = ecdh.generate_key_pair();
+        auto private_key = LoadedKey::load(keypair.private_key);
+        REQUIRE(private_key.success);
+        REQUIRE_THROWS_AS(DigestSigner(private_key.value), std::invalid_argument);
+    }
+
+    SECTION("Scheme names") {
+        REQUIRE(DigestSigner::parse_scheme("rsa") == SignatureScheme::RSA_PSS);
+        REQUIRE(DigestSigner::parse_scheme("ecc") == SignatureScheme::ECDSA);
+        REQUIRE(DigestSigner::parse_scheme("ed25519") == SignatureScheme::ED25519);
+        REQUIRE_FALSE(DigestSigner::parse_scheme("dsa").has_value());
+    }
+}
+
 // ============================================================================
 // ECCHybrid Tests (ECDH + AES-GCM)
 // ============================================================================
@@ -249,21 +397,110 @@ TEST_CASE("ECCHybrid Encryption", "[ecc][hybrid]") {
         REQUIRE(decrypted.data == large_data);
     }
     
+    SECTION("X25519 encrypt/decrypt round-trip") {
+        ECCHybrid hybrid(ECCurve::X25519);
+        auto recipient_keys = hybrid.generate_key_pair();
+        
+        std::string plaintext = "Testing X25519 with hybrid encryption.";
+        std::vector<uint8_t> data(plaintext.begin(), plaintext.end());
+        EncryptionConfig config;
+        
+        auto encrypted = hybrid.encrypt(data, recipient_keys.public_key, config);
+        REQUIRE(encrypted.success);
+        REQUIRE(encrypted.algorithm_used == AlgorithmType::ECC_X25519);
+        
+        auto decrypted = hybrid.decrypt(encrypted.data, recipient_keys.private_key, config);
+        REQUIRE(decrypted.success);
+        REQUIRE(decrypted.data == data);
+        
+        auto tampered = encrypted.data;
+        tampered.back() ^= 0x01;
+        REQUIRE_FALSE(hybrid.decrypt(tampered, recipient_keys.private_key, config).success);
+        
+        // A P-256 key cannot open it
+        ECCHybrid p256(ECCurve::SECP256R1);
+        auto other_keys = p256.generate_key_pair();
+        REQUIRE_FALSE(p256.decrypt(encrypted.data, other_keys.private_key, config).success);
+    }
+    
     SECTION("Algorithm properties") {
         ECCHybrid p256(ECCurve::SECP256R1);
         ECCHybrid p384(ECCurve::SECP384R1);
         ECCHybrid p521(ECCurve::SECP521R1);
+        ECCHybrid x25519(ECCurve::X25519);
         
         REQUIRE(p256.name() == "ECC-secp256r1-AES-GCM");
         REQUIRE(p384.name() == "ECC-secp384r1-AES-GCM");
         REQUIRE(p521.name() == "ECC-secp521r1-AES-GCM");
+        REQUIRE(x25519.name() == "ECC-x25519-AES-GCM");
         
         REQUIRE(p256.type() == AlgorithmType::ECC_P256);
         REQUIRE(p384.type() == AlgorithmType::ECC_P384);
         REQUIRE(p521.type() == AlgorithmType::ECC_P521);
+        REQUIRE(x25519.type() == AlgorithmType::ECC_X25519);
         
         REQUIRE(p256.key_size() == 32);
         REQUIRE(p384.key_size() == 48);
         REQUIRE(p521.key_size() == 66);
+        REQUIRE(x25519.key_size() == 32);
+    }
+}
+
+TEST_CASE("ECCHybrid with ephemeral key pool", "[ecc][hybrid][pool]") {
+    auto pool = std::make_shared<EphemeralKeyPool>(ECCurve::SECP256R1, 4);
+    ECCHybrid pooled(ECCurve::SECP256R1);
+    pooled.set_ephemeral_pool(pool);
+
+    ECCHybrid plain(ECCurve::SECP256R1);
+    auto recipient_keys = plain.generate_key_pair();
+    std::string plaintext = "Pooled ephemeral keys";
+    std::vector<uint8_t> data(plaintext.begin(), plaintext.end());
+    EncryptionConfig config;
+
+    SECTION("Output decrypts without a pool") {
+        auto encrypted = pooled.encrypt(data, recipient_keys.public_key, config);
+        REQUIRE(encrypted.success);
+
+        auto decrypted = plain.decrypt(encrypted.data, recipient_keys.private_key, config);
+        REQUIRE(decrypted.success);
+        REQUIRE(decrypted.data == data);
+    }
+
+    SECTION("Every encryption gets a fresh ephemeral key") {
+        // More encryptions than the pool holds, so some are generated inline
+        std::set<std::vector<uint8_t>> ephemeral_keys;
+        for (int i = 0; i < 10; ++i) {
+            auto encrypted = pooled.encrypt(data, recipient_keys.public_key, config);
+            REQUIRE(encrypted.success);
+            size_t len = (size_t(encrypted.data[0]) << 8) | encrypted.data[1];
+            ephemeral_keys.emplace(encrypted.data.begin() + 2, encrypted.data.begin() + 2 + len);
+        }
+        REQUIRE(ephemeral_keys.size() == 10);
+        REQUIRE(pool->hits() + pool->misses() == 10);
+        REQUIRE(pool->available() <= pool->capacity());
+    }
+
+    SECTION("X25519 pool") {
+        auto x_pool = std::make_shared<EphemeralKeyPool>(ECCurve::X25519, 2);
+        ECCHybrid x25519(ECCurve::X25519);
+        x25519.set_ephemeral_pool(x_pool);
+        auto x_keys = x25519.generate_key_pair();
+
+        auto encrypted = x25519.encrypt(data, x_keys.public_key, config);
+        REQUIRE(encrypted.success);
+        auto decrypted = ECCHybrid(ECCurve::X25519).decrypt(encrypted.data, x_keys.private_key, config);
+        REQUIRE(decrypted.success);
+        REQUIRE(decrypted.data == data);
+    }
+
+    SECTION("Pool must match the curve") {
+        ECCHybrid p384(ECCurve::SECP384R1);
+        REQUIRE_THROWS_AS(p384.set_ephemeral_pool(pool), std::invalid_argument);
+        REQUIRE_NOTHROW(p384.set_ephemeral_pool(nullptr));
+    }
+
+    SECTION("Bad recipient key fails cleanly") {
+        std::vector<uint8_t> garbage(64, 0x42);
+        REQUIRE_FALSE(pooled.encrypt(data, garbage, config).success);
     }
 }
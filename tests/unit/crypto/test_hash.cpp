@@ -6,9 +6,16 @@
  */
 
 #include <catch2/catch_test_macros.hpp>
+#include "filevault/cli/commands/hash_cmd.hpp"
 #include <botan/hash.h>
 #include <botan/hex.h>
 #include <botan/mac.h>
+#include <CLI/CLI.hpp>
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <random>
 #include <string>
 #include <vector>
 
@@ -286,3 +293,66 @@ TEST_CASE("Legacy Hash Functions", "[hash][legacy][warning]") {
         REQUIRE(result == "a9993e364706816aba3e25717850c26c9cd0d89d");
     }
 }
+
+// ===========================================
+// hash --hmac with aliased algorithms
+// ===========================================
+TEST_CASE("HMAC digests of aliased algorithms are independent", "[hash][hmac][cli]") {
+    namespace fs = std::filesystem;
+    auto dir = fs::temp_directory_path() / "filevault_test_hash_hmac";
+    fs::create_directories(dir);
+    auto input = (dir / "input.bin").string();
+    auto output = (dir / "digests.jsonl").string();
+    
+    // Several 1 MiB slices, so every MAC is fed more than once
+    std::vector<uint8_t> data(3 * 1024 * 1024 + 123);
+    std::mt19937 rng(40);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    std::ofstream(input, std::ios::binary).write(reinterpret_cast<const char*>(data.data()),
+                                                 static_cast<std::streamsize>(data.size()));
+    
+    const std::string key = "not-a-hex-key";
+    auto reference = [&](const std::string& algorithm) {
+        auto mac = Botan::MessageAuthenticationCode::create_or_throw("HMAC(" + algorithm + ")");
+        mac->set_key(reinterpret_cast<const uint8_t*>(key.data()), key.size());
+        mac->update(data.data(), data.size());
+        return to_lower(Botan::hex_encode(mac->final()));
+    };
+    std::map<std::string, std::string> expected = {
+        {"blake2b", reference("BLAKE2b(512)")},
+        {"blake2b-512", reference("BLAKE2b(512)")},
+        {"sha256", reference("SHA-256")},
+    };
+    
+    for (bool parallel : {false, true}) {
+        INFO("parallel digests: " << parallel);
+        filevault::core::CryptoEngine engine;
+        filevault::cli::HashCommand command(engine);
+        CLI::App app;
+        command.setup(app);
+        std::vector<const char*> argv = {"filevault", "hash", input.c_str(),
+                                         "-a", "blake2b,blake2b-512,sha256",
+                                         "--hmac", key.c_str(), "--jsonl", "-o", output.c_str()};
+        if (parallel) {
+            argv.push_back("--parallel-digests");
+        }
+        app.parse(static_cast<int>(argv.size()), argv.data());
+        REQUIRE(command.execute() == 0);
+        
+        std::ifstream lines(output);
+        size_t rows = 0;
+        for (std::string line; std::getline(lines, line);) {
+            auto row = nlohmann::json::parse(line);
+            auto algorithm = row["algorithm"].get<std::string>();
+            INFO(algorithm);
+            REQUIRE(expected.count(algorithm) == 1);
+            REQUIRE(row["digest"].get<std::string>() == expected[algorithm]);
+            ++rows;
+        }
+        REQUIRE(rows == expected.size());
+    }
+    
+    fs::remove_all(dir);
+}
@@ -1,6 +1,9 @@
 #include <catch2/catch_test_macros.hpp>
 #include "filevault/core/crypto_engine.hpp"
+#include "filevault/core/key_cache.hpp"
+#include "filevault/core/kdf_calibration.hpp"
 #include <algorithm>
+#include <thread>
 #include <vector>
 #include <string>
 
@@ -119,3 +122,150 @@ TEST_CASE("KDF - Iteration count impact", "[kdf][performance][.slow]") {  // Tag
         REQUIRE(duration2 > duration1);
     }
 }
+
+TEST_CASE("KDF - Derived key cache", "[kdf][cache]") {
+    CryptoEngine engine;
+    engine.initialize();
+    auto& cache = KeyCache::instance();
+    cache.configure(KeyCache::DEFAULT_CAPACITY, KeyCache::DEFAULT_TTL);
+    cache.clear();
+    
+    std::string password = "CachedPassword";
+    std::vector<uint8_t> salt(32, 0x5A);
+    
+    EncryptionConfig config;
+    config.kdf = KDFType::PBKDF2_SHA256;
+    config.kdf_iterations = 10000;
+    
+    SECTION("Repeated derivations hit the cache") {
+        auto key1 = engine.derive_key(password, salt, config);
+        REQUIRE(cache.size() == 1);
+        auto key2 = engine.derive_key(password, salt, config);
+        REQUIRE(key1 == key2);
+        REQUIRE(cache.size() == 1);
+    }
+    
+    SECTION("Every input is part of the identifier") {
+        auto base = cache.make_id(password, salt, config, 32);
+        REQUIRE(cache.make_id(password, salt, config, 32) == base);
+        REQUIRE(cache.make_id("other", salt, config, 32) != base);
+        REQUIRE(cache.make_id(password, std::vector<uint8_t>(32, 0x5B), config, 32) != base);
+        REQUIRE(cache.make_id(password, salt, config, 16) != base);
+        
+        EncryptionConfig more_lanes = config;
+        more_lanes.kdf_parallelism = config.kdf_parallelism + 1;
+        REQUIRE(cache.make_id(password, salt, more_lanes, 32) != base);
+    }
+    
+    SECTION("Least recently used entry is evicted") {
+        cache.configure(2, KeyCache::DEFAULT_TTL);
+        std::vector<uint8_t> key(32, 0x01);
+        auto id_a = cache.make_id("a", salt, config, 32);
+        auto id_b = cache.make_id("b", salt, config, 32);
+        auto id_c = cache.make_id("c", salt, config, 32);
+        
+        cache.store(id_a, key);
+        cache.store(id_b, key);
+        std::vector<uint8_t> out;
+        REQUIRE(cache.lookup(id_a, out));  // b is now the oldest
+        cache.store(id_c, key);
+        
+        REQUIRE(cache.size() == 2);
+        REQUIRE(cache.lookup(id_a, out));
+        REQUIRE_FALSE(cache.lookup(id_b, out));
+        REQUIRE(cache.lookup(id_c, out));
+    }
+    
+    SECTION("Entries expire after the TTL") {
+        cache.configure(4, std::chrono::seconds(1));
+        auto id = cache.make_id(password, salt, config, 32);
+        cache.store(id, std::vector<uint8_t>(32, 0x02));
+        
+        std::vector<uint8_t> out;
+        REQUIRE(cache.lookup(id, out));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+        REQUIRE_FALSE(cache.lookup(id, out));
+    }
+    
+    SECTION("Disabled cache stores nothing") {
+        cache.configure(0, KeyCache::DEFAULT_TTL);
+        REQUIRE_FALSE(cache.enabled());
+        auto key1 = engine.derive_key(password, salt, config);
+        auto key2 = engine.derive_key(password, salt, config);
+        REQUIRE(key1 == key2);
+        REQUIRE(cache.size() == 0);
+    }
+    
+    cache.configure(KeyCache::DEFAULT_CAPACITY, KeyCache::DEFAULT_TTL);
+    cache.clear();
+}
+
+TEST_CASE("KDF - Argon2 parallelism", "[kdf][argon2]") {
+    CryptoEngine engine;
+    engine.initialize();
+    KeyCache::instance().clear();
+    
+    std::string password = "LanePassword";
+    std::vector<uint8_t> salt(32, 0x33);
+    
+    EncryptionConfig config;
+    config.kdf = KDFType::ARGON2ID;
+    config.kdf_iterations = 1;
+    config.kdf_memory_kb = 8192;
+    
+    SECTION("Lane count changes the key") {
+        config.kdf_parallelism = 1;
+        auto key1 = engine.derive_key(password, salt, config);
+        config.kdf_parallelism = 4;
+        auto key4 = engine.derive_key(password, salt, config);
+        REQUIRE(key1 != key4);
+    }
+    
+    SECTION("Invalid lane counts are rejected") {
+        config.kdf_parallelism = 0;
+        REQUIRE_THROWS(engine.derive_key(password, salt, config));
+        config.kdf_parallelism = 2048;  // Needs 16 MB
+        REQUIRE_THROWS(engine.derive_key(password, salt, config));
+    }
+}
+
+TEST_CASE("KDF - Calibration to a time budget", "[kdf][calibration]") {
+    CryptoEngine engine;
+    engine.initialize();
+    
+    SECTION("Argon2id stays within the memory budget") {
+        auto profile = KdfCalibrator::calibrate(engine, KDFType::ARGON2ID, 100, 16);
+        REQUIRE(profile.kdf == KDFType::ARGON2ID);
+        REQUIRE(profile.memory_kb >= 8192);
+        REQUIRE(profile.memory_kb <= 16 * 1024);
+        REQUIRE(profile.iterations >= 1);
+        REQUIRE(profile.parallelism >= 1);
+        
+        EncryptionConfig config;
+        profile.apply(config);
+        REQUIRE(config.kdf_memory_kb == profile.memory_kb);
+        REQUIRE(config.kdf_iterations == profile.iterations);
+        REQUIRE(config.kdf_parallelism == profile.parallelism);
+        REQUIRE(engine.derive_key("password", std::vector<uint8_t>(32, 0x07), config).size() == 32);
+    }
+    
+    SECTION("PBKDF2 iterations scale with the target") {
+        auto fast = KdfCalibrator::calibrate(engine, KDFType::PBKDF2_SHA256, 20, 0);
+        auto slow = KdfCalibrator::calibrate(engine, KDFType::PBKDF2_SHA256, 200, 0);
+        REQUIRE(fast.iterations >= 10000);
+        REQUIRE(slow.iterations > fast.iterations);
+    }
+    
+    SECTION("Scrypt is rejected") {
+        REQUIRE_FALSE(KdfCalibrator::supports(KDFType::SCRYPT));
+        REQUIRE_THROWS(KdfCalibrator::calibrate(engine, KDFType::SCRYPT, 100, 16));
+    }
+    
+    SECTION("Cache key depends on the budget") {
+        auto key = KdfCalibrator::cache_key(KDFType::ARGON2ID, 500, 256);
+        REQUIRE(key == KdfCalibrator::cache_key(KDFType::ARGON2ID, 500, 256));
+        REQUIRE(key != KdfCalibrator::cache_key(KDFType::ARGON2ID, 250, 256));
+        REQUIRE(key != KdfCalibrator::cache_key(KDFType::ARGON2ID, 500, 128));
+        REQUIRE(key != KdfCalibrator::cache_key(KDFType::PBKDF2_SHA256, 500, 256));
+    }
+}
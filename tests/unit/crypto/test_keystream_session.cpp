@@ -0,0 +1,129 @@
+/**
+ * @file test_keystream_session.cpp
+ * @brief Unit tests for sessions sealing from precomputed keystream
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/algorithms/symmetric/aes_ctr.hpp"
+#include "filevault/algorithms/symmetric/aes_gcm.hpp"
+#include "filevault/algorithms/symmetric/chacha20_poly1305.hpp"
+#include "filevault/algorithms/symmetric/keystream_session.hpp"
+#include <memory>
+#include <set>
+#include <vector>
+
+using namespace filevault;
+using algorithms::symmetric::KeystreamSession;
+using algorithms::symmetric::KeystreamSessionOptions;
+
+namespace {
+
+std::vector<std::unique_ptr<core::ICryptoAlgorithm>> stream_modes() {
+    std::vector<std::unique_ptr<core::ICryptoAlgorithm>> modes;
+    modes.push_back(std::make_unique<algorithms::symmetric::ChaCha20Poly1305>());
+    modes.push_back(std::make_unique<algorithms::symmetric::AES_CTR>(256));
+    modes.push_back(std::make_unique<algorithms::symmetric::AES_CTR>(128));
+    return modes;
+}
+
+std::vector<uint8_t> test_key(size_t size) {
+    std::vector<uint8_t> key(size);
+    for (size_t i = 0; i < key.size(); ++i) {
+        key[i] = static_cast<uint8_t>(i * 29 + 5);
+    }
+    return key;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Keystream sessions produce the cipher's standard output", "[keystream][chacha20][ctr]") {
+    for (const auto& cipher : stream_modes()) {
+        INFO(cipher->name());
+        auto key = test_key(cipher->key_size());
+        KeystreamSessionOptions options;
+        options.message_size = 256;
+        options.depth = 4;
+        auto session = KeystreamSession::create(*cipher, key, options);
+        REQUIRE(session);
+
+        std::vector<uint8_t> ad = {'h', 'd', 'r'};
+        core::EncryptionConfig config;
+        config.associated_data = ad;
+
+        // Sizes up to and past message_size; every third message waits for the ring
+        std::set<std::vector<uint8_t>> nonces;
+        for (size_t i = 0; i < 16; ++i) {
+            if (i % 3 == 0) {
+                session->wait_ready();
+            }
+            size_t size = (i * 53) % 400;
+            std::vector<uint8_t> message(size);
+            for (size_t j = 0; j < size; ++j) {
+                message[j] = static_cast<uint8_t>(j ^ i);
+            }
+            auto buffer = message;
+            auto sealed = session->encrypt_in_place(buffer, config);
+            REQUIRE(sealed.success);
+            REQUIRE(sealed.nonce.has_value());
+            REQUIRE(buffer.size() == size);
+
+            std::vector<uint8_t> nonce(sealed.nonce->begin(), sealed.nonce->end());
+            REQUIRE(nonces.insert(nonce).second);
+
+            core::EncryptionConfig open_config = config;
+            open_config.nonce = sealed.nonce;
+            open_config.tag = sealed.tag;
+            auto opened = cipher->decrypt(buffer, key, open_config);
+            REQUIRE(opened.success);
+            REQUIRE(opened.data == message);
+
+            // The session's own decryption goes through the regular session
+            REQUIRE(session->decrypt_in_place(buffer, open_config).success);
+            REQUIRE(buffer == message);
+        }
+
+        auto stats = session->stats();
+        REQUIRE(stats.precomputed + stats.computed_inline == 16);
+        REQUIRE(stats.precomputed > 0);
+        REQUIRE(stats.computed_inline > 0);     // At least the messages over 256 bytes
+    }
+}
+
+TEST_CASE("Keystream sessions keep nonces single-use", "[keystream]") {
+    algorithms::symmetric::AES_CTR ctr(256);
+    auto key = test_key(ctr.key_size());
+    auto session = KeystreamSession::create(ctr, key);
+    REQUIRE(session);
+
+    SECTION("CTR nonces leave the block counter at zero") {
+        std::vector<uint8_t> buffer(64, 0x11);
+        auto sealed = session->encrypt_in_place(buffer, {});
+        REQUIRE(sealed.success);
+        REQUIRE(sealed.nonce->size() == 16);
+        for (size_t i = 12; i < 16; ++i) {
+            REQUIRE((*sealed.nonce)[i] == 0);
+        }
+    }
+
+    SECTION("A caller nonce is refused") {
+        std::vector<uint8_t> buffer(64, 0x22);
+        core::EncryptionConfig config;
+        config.nonce = std::vector<uint8_t>(16, 0x01);
+        REQUIRE_FALSE(session->encrypt_in_place(buffer, config).success);
+        REQUIRE(buffer == std::vector<uint8_t>(64, 0x22));
+        REQUIRE_FALSE(session->encrypt_begin(config));
+    }
+}
+
+TEST_CASE("Keystream sessions only take stream modes", "[keystream]") {
+    algorithms::symmetric::AES_GCM gcm(256);
+    REQUIRE_FALSE(KeystreamSession::supports(gcm.type()));
+    REQUIRE(KeystreamSession::create(gcm, test_key(gcm.key_size())) == nullptr);
+
+    algorithms::symmetric::ChaCha20Poly1305 chacha;
+    REQUIRE(KeystreamSession::create(chacha, test_key(16)) == nullptr);
+
+    KeystreamSessionOptions empty_ring;
+    empty_ring.depth = 0;
+    REQUIRE(KeystreamSession::create(chacha, test_key(32), empty_ring) == nullptr);
+}
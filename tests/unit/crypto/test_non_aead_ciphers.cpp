@@ -419,6 +419,27 @@ TEST_CASE("CryptoEngine registers non-AEAD ciphers", "[crypto-engine][integratio
     REQUIRE(engine.get_algorithm(AlgorithmType::TRIPLE_DES_CBC) != nullptr);
 }
 
+TEST_CASE("CryptoEngine constructs algorithms on first use", "[crypto-engine][integration]") {
+    CryptoEngine engine;
+    
+    // No initialize() needed; the slot is filled by the first lookup
+    auto* cbc = engine.get_algorithm(AlgorithmType::AES_256_CBC);
+    REQUIRE(cbc != nullptr);
+    REQUIRE(cbc->type() == AlgorithmType::AES_256_CBC);
+    REQUIRE(engine.get_algorithm(AlgorithmType::AES_256_CBC) == cbc);
+    
+    auto* des = engine.get_algorithm(AlgorithmType::TRIPLE_DES_CBC);
+    REQUIRE(des != nullptr);
+    REQUIRE(des->type() == AlgorithmType::TRIPLE_DES_CBC);
+    
+    // Bare signatures have no file cipher
+    REQUIRE(engine.get_algorithm(AlgorithmType::DILITHIUM_3) == nullptr);
+    
+    // A registered implementation replaces the built-in one
+    engine.register_algorithm(std::make_unique<AES_CTR>(128));
+    REQUIRE(engine.get_algorithm(AlgorithmType::AES_128_CTR)->type() == AlgorithmType::AES_128_CTR);
+}
+
 TEST_CASE("CryptoEngine parse non-AEAD algorithms", "[crypto-engine][parsing]") {
     // AES-CBC
     REQUIRE(CryptoEngine::parse_algorithm("aes-128-cbc") == AlgorithmType::AES_128_CBC);
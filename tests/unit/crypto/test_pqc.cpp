@@ -6,6 +6,7 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/generators/catch_generators.hpp>
 #include "filevault/algorithms/pqc/post_quantum.hpp"
+#include <algorithm>
 #include <vector>
 #include <random>
 
@@ -387,3 +388,88 @@ TEST_CASE("Dilithium Names", "[pqc][types]") {
         REQUIRE(dil.name() == "Dilithium5");
     }
 }
+
+// ============================================================================
+// Batch Operations
+// ============================================================================
+
+TEST_CASE("Kyber Batch Encapsulation", "[pqc][kyber][batch]") {
+    auto variant = GENERATE(
+        Kyber::Variant::Kyber512,
+        Kyber::Variant::Kyber1024
+    );
+    
+    Kyber kyber(variant);
+    auto keypair = kyber.generate_keypair();
+    auto public_key = kyber.load_public_key(keypair.public_key);
+    auto private_key = kyber.load_private_key(keypair.private_key);
+    REQUIRE(public_key.success);
+    REQUIRE(private_key.success);
+    
+    auto encapsulations = kyber.encapsulate_batch(public_key.value, 40, 4);
+    REQUIRE(encapsulations.size() == 40);
+    
+    std::vector<std::vector<uint8_t>> ciphertexts;
+    for (const auto& encapsulation : encapsulations) {
+        REQUIRE(encapsulation.encapsulated_key.size() == kyber.ciphertext_size());
+        ciphertexts.push_back(encapsulation.encapsulated_key);
+    }
+    REQUIRE(ciphertexts[0] != ciphertexts[1]);  // Fresh randomness per encapsulation
+    
+    auto secrets = kyber.decapsulate_batch(private_key.value, ciphertexts, 4);
+    REQUIRE(secrets.size() == encapsulations.size());
+    for (size_t i = 0; i < secrets.size(); ++i) {
+        REQUIRE(secrets[i] == encapsulations[i].shared_key);
+    }
+    
+    // Interoperates with the one-shot API
+    EncryptionConfig config;
+    auto single = kyber.decrypt(ciphertexts[7], keypair.private_key, config);
+    REQUIRE(single.success);
+    REQUIRE(std::vector<uint8_t>(secrets[7].begin(), secrets[7].end()) == single.data);
+}
+
+TEST_CASE("Kyber Batch Rejects Bad Input", "[pqc][kyber][batch]") {
+    Kyber kyber(Kyber::Variant::Kyber768);
+    auto keypair = kyber.generate_keypair();
+    
+    REQUIRE_FALSE(kyber.load_public_key(keypair.private_key).success);
+    REQUIRE_FALSE(kyber.load_private_key(keypair.public_key).success);
+    
+    auto private_key = kyber.load_private_key(keypair.private_key);
+    REQUIRE(private_key.success);
+    std::vector<std::vector<uint8_t>> truncated = {std::vector<uint8_t>(10, 0)};
+    REQUIRE_THROWS(kyber.decapsulate_batch(private_key.value, truncated));
+    REQUIRE(kyber.decapsulate_batch(private_key.value, {}).empty());
+}
+
+TEST_CASE("Dilithium Batch Sign and Verify", "[pqc][dilithium][batch]") {
+    Dilithium dilithium(Dilithium::Variant::Dilithium2);
+    auto keypair = dilithium.generate_keypair();
+    auto private_key = dilithium.load_private_key(keypair.private_key);
+    auto public_key = dilithium.load_public_key(keypair.public_key);
+    REQUIRE(private_key.success);
+    REQUIRE(public_key.success);
+    
+    std::vector<std::vector<uint8_t>> messages;
+    for (int i = 0; i < 24; ++i) {
+        messages.push_back(std::vector<uint8_t>(100 + i, static_cast<uint8_t>(i)));
+    }
+    
+    auto signatures = dilithium.sign_batch(private_key.value, messages, 4);
+    REQUIRE(signatures.size() == messages.size());
+    REQUIRE(dilithium.verify(messages[3], signatures[3], keypair.public_key));
+    
+    auto valid = dilithium.verify_batch(public_key.value, messages, signatures, 4);
+    REQUIRE(std::all_of(valid.begin(), valid.end(), [](bool v) { return v; }));
+    
+    // One tampered message fails alone
+    messages[5][0] ^= 0xFF;
+    valid = dilithium.verify_batch(public_key.value, messages, signatures, 4);
+    for (size_t i = 0; i < valid.size(); ++i) {
+        REQUIRE(valid[i] == (i != 5));
+    }
+    
+    signatures.pop_back();
+    REQUIRE_THROWS(dilithium.verify_batch(public_key.value, messages, signatures));
+}
@@ -6,6 +6,9 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_string.hpp>
 #include "filevault/algorithms/asymmetric/rsa.hpp"
+#include <filesystem>
+#include <fstream>
+#include <future>
 #include <vector>
 #include <string>
 
@@ -172,6 +175,76 @@ TEST_CASE("RSA Sign and Verify", "[rsa][signature]") {
     }
 }
 
+TEST_CASE("RSA with a Loaded Key", "[rsa][signature][loaded-key]") {
+    RSA rsa(2048);
+    auto key_pair = rsa.generate_key_pair();
+    auto private_key = LoadedKey::load(key_pair.private_key);
+    auto public_key = LoadedKey::load(key_pair.public_key);
+    REQUIRE(private_key.success);
+    REQUIRE(public_key.success);
+    REQUIRE(private_key.value.is_private());
+    REQUIRE_FALSE(public_key.value.is_private());
+    REQUIRE(private_key.value.key_bits() == 2048);
+    
+    SECTION("Interoperates with the encoded-key overloads") {
+        auto signature = rsa.sign(TEST_DATA, private_key.value);
+        REQUIRE(rsa.verify(TEST_DATA, signature, key_pair.public_key));
+        REQUIRE(rsa.verify(TEST_DATA, rsa.sign(TEST_DATA, key_pair.private_key), public_key.value));
+        
+        auto encrypted = rsa.encrypt(TEST_DATA, public_key.value);
+        REQUIRE(encrypted.success);
+        auto decrypted = rsa.decrypt(encrypted.data, private_key.value);
+        REQUIRE(decrypted.success);
+        REQUIRE(decrypted.data == TEST_DATA);
+    }
+    
+    SECTION("One key signs from several threads") {
+        std::vector<std::future<bool>> workers;
+        for (int t = 0; t < 4; ++t) {
+            workers.push_back(std::async(std::launch::async, [&, t]() {
+                bool ok = true;
+                for (int i = 0; i < 5; ++i) {
+                    std::vector<uint8_t> message = TEST_DATA;
+                    message.push_back(static_cast<uint8_t>(t * 16 + i));
+                    ok = ok && rsa.verify(message, rsa.sign(message, private_key.value), public_key.value);
+                }
+                return ok;
+            }));
+        }
+        for (auto& worker : workers) {
+            REQUIRE(worker.get());
+        }
+    }
+    
+    SECTION("Streamed file signatures match in-memory ones") {
+        auto path = (std::filesystem::temp_directory_path() / "filevault_test_rsa_sign.bin").string();
+        std::vector<uint8_t> contents(3 * 1024 * 1024 + 17);
+        for (size_t i = 0; i < contents.size(); ++i) {
+            contents[i] = static_cast<uint8_t>(i * 31);
+        }
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(contents.data()),
+                                                     static_cast<std::streamsize>(contents.size()));
+        
+        auto signature = rsa.sign_file(path, private_key.value);
+        REQUIRE(rsa.verify(contents, signature, public_key.value));
+        REQUIRE(rsa.verify_file(path, rsa.sign(contents, private_key.value), public_key.value));
+        
+        signature[0] ^= 0x01;
+        REQUIRE_FALSE(rsa.verify_file(path, signature, public_key.value));
+        std::filesystem::remove(path);
+        REQUIRE_THROWS(rsa.sign_file(path, private_key.value));
+    }
+    
+    SECTION("A public key cannot sign") {
+        REQUIRE_THROWS(rsa.sign(TEST_DATA, public_key.value));
+    }
+    
+    SECTION("Garbage is not a key") {
+        std::vector<uint8_t> garbage(64, 0x42);
+        REQUIRE_FALSE(LoadedKey::load(garbage).success);
+    }
+}
+
 // ============================================================================
 // RSA Security Level Tests
 // ============================================================================
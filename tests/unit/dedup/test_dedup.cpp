@@ -0,0 +1,199 @@
+/**
+ * @file test_dedup.cpp
+ * @brief Unit tests for content-defined chunking and the chunk store
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/dedup/chunker.hpp"
+#include "filevault/dedup/chunk_store.hpp"
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace filevault::dedup;
+namespace fs = std::filesystem;
+
+namespace {
+
+std::vector<uint8_t> random_bytes(size_t size, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> data(size);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    return data;
+}
+
+std::set<std::string> chunk_set(const ContentChunker& chunker, const std::vector<uint8_t>& data) {
+    std::set<std::string> chunks;
+    size_t offset = 0;
+    for (size_t length : chunker.split(data)) {
+        chunks.emplace(data.begin() + offset, data.begin() + offset + length);
+        offset += length;
+    }
+    return chunks;
+}
+
+ChunkerParams small_chunks() {
+    ChunkerParams params;
+    params.min_size = 1024;
+    params.avg_size = 4096;
+    params.max_size = 16384;
+    return params;
+}
+
+StoreConfig test_config() {
+    StoreConfig config;
+    config.kdf = filevault::core::KDFType::PBKDF2_SHA256;
+    config.level = filevault::core::SecurityLevel::WEAK;
+    config.chunking = small_chunks();
+    return config;
+}
+
+// Backup through a string stream, returning the manifest
+Manifest backup_bytes(ChunkStore& store, const std::vector<uint8_t>& data, BackupStats& stats) {
+    std::istringstream input(std::string(data.begin(), data.end()));
+    auto result = store.backup(input, stats, 4);
+    REQUIRE(result.success);
+    return result.value;
+}
+
+std::vector<uint8_t> restore_bytes(ChunkStore& store, const Manifest& manifest) {
+    std::ostringstream output;
+    auto result = store.restore(manifest, output, 4);
+    REQUIRE(result.success);
+    auto text = output.str();
+    return {text.begin(), text.end()};
+}
+
+} // anonymous namespace
+
+TEST_CASE("Content-defined chunking", "[dedup][chunker]") {
+    ContentChunker chunker(small_chunks());
+    auto data = random_bytes(512 * 1024, 1);
+
+    SECTION("Chunks respect the size bounds and cover the input") {
+        auto lengths = chunker.split(data);
+        REQUIRE(std::accumulate(lengths.begin(), lengths.end(), size_t(0)) == data.size());
+        for (size_t i = 0; i + 1 < lengths.size(); ++i) {
+            REQUIRE(lengths[i] >= 1024);
+            REQUIRE(lengths[i] <= 16384);
+        }
+        // Roughly the average size on random data
+        REQUIRE(lengths.size() > data.size() / 16384);
+        REQUIRE(lengths.size() < data.size() / 1024);
+    }
+
+    SECTION("Boundaries survive an insertion") {
+        auto edited = data;
+        auto extra = random_bytes(100, 2);
+        edited.insert(edited.begin() + 1000, extra.begin(), extra.end());
+
+        auto before = chunk_set(chunker, data);
+        auto after = chunk_set(chunker, edited);
+        size_t shared = 0;
+        for (const auto& chunk : after) {
+            shared += before.count(chunk);
+        }
+        REQUIRE(shared + 3 >= before.size());
+    }
+
+    SECTION("Short input is one chunk") {
+        std::vector<uint8_t> small(100, 7);
+        REQUIRE(chunker.split(small) == std::vector<size_t>{100});
+        REQUIRE(chunker.split({}).empty());
+    }
+
+    SECTION("Parameter checks") {
+        REQUIRE(small_chunks().valid());
+        ChunkerParams bad = small_chunks();
+        bad.min_size = bad.avg_size;
+        REQUIRE_FALSE(bad.valid());
+    }
+}
+
+TEST_CASE("Chunk store", "[dedup][store]") {
+    const fs::path dir = "test_dedup_store";
+    fs::remove_all(dir);
+
+    ChunkStore store(dir);
+    REQUIRE(store.create("correct horse", test_config()).success);
+    REQUIRE(ChunkStore::exists(dir));
+
+    auto data = random_bytes(300 * 1024, 3);
+    // Repeated blocks inside one file are stored once
+    auto repeat = random_bytes(64 * 1024, 4);
+    for (int i = 0; i < 3; ++i) {
+        data.insert(data.end(), repeat.begin(), repeat.end());
+    }
+
+    BackupStats first;
+    auto manifest = backup_bytes(store, data, first);
+    REQUIRE(first.bytes == data.size());
+    REQUIRE(first.new_chunks < first.chunks);
+    REQUIRE(store.usage().chunks == first.new_chunks);
+
+    SECTION("Round trip through a serialized manifest") {
+        auto parsed = store.parse_manifest(store.serialize_manifest(manifest));
+        REQUIRE(parsed.success);
+        REQUIRE(restore_bytes(store, parsed.value) == data);
+    }
+
+    SECTION("Unchanged data adds nothing") {
+        BackupStats second;
+        backup_bytes(store, data, second);
+        REQUIRE(second.new_chunks == 0);
+        REQUIRE(second.stored_bytes == 0);
+    }
+
+    SECTION("An edit stores only the chunks around it") {
+        auto edited = data;
+        edited[150 * 1024] ^= 0xff;
+        BackupStats second;
+        auto edited_manifest = backup_bytes(store, edited, second);
+        REQUIRE(second.new_chunks >= 1);
+        REQUIRE(second.new_chunks <= 2);
+        REQUIRE(restore_bytes(store, edited_manifest) == edited);
+        REQUIRE(restore_bytes(store, manifest) == data);
+    }
+
+    SECTION("Reopening with the password") {
+        ChunkStore reopened(dir);
+        REQUIRE_FALSE(reopened.unlock("wrong").success);
+        REQUIRE_FALSE(reopened.unlocked());
+        REQUIRE(reopened.unlock("correct horse").success);
+        REQUIRE(reopened.config().chunking.avg_size == 4096);
+        REQUIRE(restore_bytes(reopened, manifest) == data);
+    }
+
+    SECTION("A store cannot be created twice") {
+        ChunkStore again(dir);
+        REQUIRE_FALSE(again.create("other", test_config()).success);
+    }
+
+    SECTION("Tampering is detected") {
+        auto bytes = store.serialize_manifest(manifest);
+        bytes[20] ^= 1;
+        REQUIRE_FALSE(store.parse_manifest(bytes).success);
+
+        auto path = store.path_for(manifest.chunks[0].id);
+        fs::resize_file(path, fs::file_size(path) - 1);
+        std::ostringstream output;
+        REQUIRE_FALSE(store.restore(manifest, output).success);
+    }
+
+    SECTION("Empty input") {
+        std::vector<uint8_t> empty;
+        BackupStats stats;
+        auto empty_manifest = backup_bytes(store, empty, stats);
+        REQUIRE(empty_manifest.chunks.empty());
+        REQUIRE(restore_bytes(store, empty_manifest).empty());
+    }
+
+    fs::remove_all(dir);
+}
@@ -7,11 +7,17 @@
 
 #include <catch2/catch_test_macros.hpp>
 #include "filevault/steganography/lsb.hpp"
+#include "filevault/steganography/lsb_kernels.hpp"
+#include "filevault/steganography/png_stream.hpp"
+#include "filevault/steganography/steganalysis.hpp"
 #include <vector>
 #include <string>
 #include <fstream>
 #include <cstdio>
 #include <filesystem>
+#include <random>
+#include <algorithm>
+#include <cmath>
 
 using namespace filevault::steganography;
 namespace fs = std::filesystem;
@@ -296,6 +302,296 @@ TEST_CASE("LSB Bits Per Channel Variations", "[steganography][bits]") {
     }
 }
 
+// ===========================================
+// SIMD Kernel Tests
+// ===========================================
+TEST_CASE("LSB kernels match the scalar path", "[steganography][kernels]") {
+    std::mt19937 gen(2024);
+    
+    for (auto isa : {kernels::Isa::SSE2, kernels::Isa::SSSE3, kernels::Isa::AVX2, kernels::Isa::NEON}) {
+        if (!kernels::is_supported(isa)) {
+            continue;
+        }
+        INFO("Kernel: " << kernels::isa_name(isa));
+        
+        for (int bits = 1; bits <= 4; ++bits) {
+            size_t per_byte = (8 + bits - 1) / bits;
+            for (size_t n : {0, 1, 15, 16, 17, 33, 100, 1000}) {
+                for (size_t offset : {0, 3}) {
+                    // Full room, and room running out part-way through a byte
+                    for (size_t room : {n * per_byte, n * per_byte / 2 + 1}) {
+                        INFO("Bits: " << bits << ", bytes: " << n << ", offset: " << offset << ", room: " << room);
+                        std::vector<uint8_t> payload(n);
+                        std::vector<uint8_t> cover(offset + room);
+                        for (auto& b : payload) b = static_cast<uint8_t>(gen());
+                        for (auto& b : cover) b = static_cast<uint8_t>(gen());
+                        
+                        auto scalar = cover;
+                        auto simd = cover;
+                        size_t end = kernels::embed(scalar, offset, payload, bits, kernels::Isa::Scalar);
+                        REQUIRE(kernels::embed(simd, offset, payload, bits, isa) == end);
+                        REQUIRE(simd == scalar);
+                        
+                        std::vector<uint8_t> expected(n);
+                        std::vector<uint8_t> extracted(n);
+                        kernels::extract(scalar, offset, expected, bits, kernels::Isa::Scalar);
+                        REQUIRE(kernels::extract(scalar, offset, extracted, bits, isa) == end);
+                        REQUIRE(extracted == expected);
+                        if (room == n * per_byte) {
+                            REQUIRE(extracted == payload);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    
+    REQUIRE(kernels::is_supported(kernels::best_isa()));
+    REQUIRE_THROWS_AS(kernels::embed(std::span<uint8_t>{}, 0, std::span<const uint8_t>{}, 5),
+                      std::invalid_argument);
+}
+
+TEST_CASE("RS kernels match the scalar path", "[steganography][kernels][scan]") {
+    std::mt19937 gen(17);
+    for (size_t size : {size_t{0}, size_t{3}, size_t{8}, size_t{17}, size_t{64}, size_t{1001}}) {
+        std::vector<uint8_t> plane(size);
+        int value = 128;
+        for (auto& b : plane) {
+            value = std::clamp(value + static_cast<int>(gen() % 5) - 2, 0, 255);
+            b = static_cast<uint8_t>(value);
+        }
+        
+        kernels::RsCounts expected;
+        kernels::rs_count(plane, expected, kernels::Isa::Scalar);
+        REQUIRE(expected.groups == size / 4);
+        for (auto isa : {kernels::Isa::SSE2, kernels::Isa::SSSE3, kernels::Isa::AVX2, kernels::Isa::NEON}) {
+            if (!kernels::is_supported(isa)) {
+                continue;
+            }
+            kernels::RsCounts actual;
+            kernels::rs_count(plane, actual, isa);
+            REQUIRE(actual.groups == expected.groups);
+            for (int i = 0; i < 4; ++i) {
+                REQUIRE(actual.regular[i] == expected.regular[i]);
+                REQUIRE(actual.singular[i] == expected.singular[i]);
+            }
+        }
+    }
+}
+
+// ===========================================
+// Streaming Tests
+// ===========================================
+namespace {
+
+std::vector<uint8_t> read_png_rows(const std::string& path) {
+    PngRowReader reader(path);
+    std::vector<uint8_t> pixels;
+    for (auto row = reader.next_row(); !row.empty(); row = reader.next_row()) {
+        pixels.insert(pixels.end(), row.begin(), row.end());
+    }
+    return pixels;
+}
+
+} // anonymous namespace
+
+TEST_CASE("LSB streaming embed and extract", "[steganography][streaming]") {
+    auto dir = fs::temp_directory_path() / "filevault_test_stego_stream";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    std::string cover_image = (dir / "cover.png").string();
+    std::string stego_image = (dir / "out.png").string();
+    std::string memory_image = (dir / "memory.png").string();
+    
+    // Odd row length so payload bytes straddle rows
+    PngInfo info{37, 41, 3};
+    std::vector<uint8_t> pixels(info.channel_count());
+    std::mt19937 gen(99);
+    for (auto& b : pixels) b = static_cast<uint8_t>(gen());
+    {
+        PngRowWriter writer(cover_image, info);
+        for (uint32_t y = 0; y < info.height; ++y) {
+            writer.write_row(std::span<const uint8_t>(pixels).subspan(y * info.row_bytes(), info.row_bytes()));
+        }
+        writer.finish();
+    }
+    REQUIRE(read_png_rows(cover_image) == pixels);
+    
+    for (int bits = 1; bits <= 4; ++bits) {
+        INFO("Bits: " << bits);
+        // Each byte takes ceil(8 / bits) whole channels
+        size_t capacity = info.channel_count() / ((8 + bits - 1) / bits) - 4;
+        REQUIRE(LSBSteganography::calculate_capacity(cover_image, bits) == capacity);
+        std::vector<uint8_t> secret(capacity);
+        for (auto& b : secret) b = static_cast<uint8_t>(gen());
+        
+        REQUIRE(LSBSteganography::embed_streaming(cover_image, secret, stego_image, bits));
+        auto extracted = LSBSteganography::extract_streaming(stego_image, bits);
+        REQUIRE(extracted == secret);
+        
+        // Same pixels as the in-memory path, readable by it
+        REQUIRE(LSBSteganography::embed(cover_image, secret, memory_image, bits));
+        REQUIRE(read_png_rows(stego_image) == read_png_rows(memory_image));
+        REQUIRE(LSBSteganography::extract(stego_image, bits) == extracted);
+        
+        std::vector<uint8_t> too_big(capacity + 1);
+        REQUIRE_FALSE(LSBSteganography::embed_streaming(cover_image, too_big, stego_image, bits));
+        REQUIRE_FALSE(LSBSteganography::embed(cover_image, too_big, memory_image, bits));
+    }
+    
+    SECTION("Output may replace the cover") {
+        std::vector<uint8_t> secret = {1, 2, 3, 4, 5};
+        REQUIRE(LSBSteganography::embed_streaming(cover_image, secret, cover_image, 2));
+        REQUIRE(LSBSteganography::extract_streaming(cover_image, 2) == secret);
+    }
+    
+    SECTION("BMP covers are not streamed") {
+        std::string bmp = TestImageHelper::create_test_bmp((dir / "cover.bmp").string());
+        REQUIRE_FALSE(PngRowReader::probe(bmp).has_value());
+        REQUIRE_FALSE(LSBSteganography::embed_streaming(bmp, std::vector<uint8_t>{1}, stego_image));
+    }
+    
+    fs::remove_all(dir);
+}
+
+TEST_CASE("Extraction stops after the payload rows", "[steganography][streaming]") {
+    std::string cover_image = "test_early_cover.png";
+    std::string stego_image = "test_early_out.png";
+    
+    // Noise does not compress, so the second half of the file is the second half of the rows
+    PngInfo info{256, 256, 3};
+    std::mt19937 gen(7);
+    {
+        PngRowWriter writer(cover_image, info);
+        std::vector<uint8_t> row(info.row_bytes());
+        for (uint32_t y = 0; y < info.height; ++y) {
+            for (auto& b : row) b = static_cast<uint8_t>(gen());
+            writer.write_row(row);
+        }
+        writer.finish();
+    }
+    
+    std::vector<uint8_t> secret = {'e', 'a', 'r', 'l', 'y'};
+    REQUIRE(LSBSteganography::embed_streaming(cover_image, secret, stego_image, 1));
+    
+    // Rows past the payload are never decoded, so losing them does not matter
+    fs::resize_file(stego_image, fs::file_size(stego_image) / 2);
+    REQUIRE(LSBSteganography::extract(stego_image, 1) == secret);
+    
+    TestImageHelper::cleanup(cover_image);
+    TestImageHelper::cleanup(stego_image);
+}
+
+TEST_CASE("Steganalysis flags LSB payloads", "[steganography][scan]") {
+    std::string cover_image = "test_scan_cover.png";
+    std::string stego_image = "test_scan_out.png";
+    
+    // Smooth picture on a comb of multiples of 3, so value pairs are uneven until LSBs are rewritten
+    PngInfo info{512, 384, 3};
+    std::mt19937 gen(23);
+    {
+        PngRowWriter writer(cover_image, info);
+        std::vector<uint8_t> row(info.row_bytes());
+        for (uint32_t y = 0; y < info.height; ++y) {
+            for (uint32_t x = 0; x < info.width; ++x) {
+                for (int c = 0; c < 3; ++c) {
+                    double v = 128 + 60 * std::sin(x / 40.0 + c) * std::cos(y / 55.0 - c) + static_cast<int>(gen() % 5) - 2;
+                    row[x * 3 + c] = static_cast<uint8_t>(3 * std::lround(std::clamp(v, 0.0, 255.0) / 3));
+                }
+            }
+            writer.write_row(row);
+        }
+        writer.finish();
+    }
+    
+    auto clean = Steganalysis::scan(cover_image);
+    REQUIRE(clean.error.empty());
+    REQUIRE(clean.width == 512);
+    REQUIRE(clean.score < Steganalysis::DEFAULT_THRESHOLD);
+    
+    size_t capacity = info.channel_count() / 8 - 4;
+    
+    SECTION("A short sequential payload shows up in the leading rows") {
+        std::vector<uint8_t> secret(capacity / 5);
+        for (auto& b : secret) b = static_cast<uint8_t>(gen());
+        REQUIRE(LSBSteganography::embed_streaming(cover_image, secret, stego_image, 1));
+        
+        auto report = Steganalysis::scan(stego_image);
+        REQUIRE(report.chi_square >= Steganalysis::DEFAULT_THRESHOLD);
+        REQUIRE(report.payload_extent > 0.1);
+        REQUIRE(report.payload_extent < 0.4);
+    }
+    
+    SECTION("A full payload drives the RS estimate up") {
+        std::vector<uint8_t> secret(capacity);
+        for (auto& b : secret) b = static_cast<uint8_t>(gen());
+        REQUIRE(LSBSteganography::embed_streaming(cover_image, secret, stego_image, 1));
+        
+        auto report = Steganalysis::scan(stego_image);
+        REQUIRE(report.rs_rate > 0.8);
+        REQUIRE(report.payload_extent == 1.0);
+    }
+    
+    SECTION("Unreadable images report an error") {
+        REQUIRE_FALSE(Steganalysis::scan("nonexistent.png").error.empty());
+    }
+    
+    TestImageHelper::cleanup(cover_image);
+    TestImageHelper::cleanup(stego_image);
+}
+
+TEST_CASE("Chi-square p-value", "[steganography][scan]") {
+    std::array<uint64_t, 256> histogram{};
+    REQUIRE(Steganalysis::chi_square_p(histogram) == 0.0);
+    
+    // Even pairs: what a rewritten LSB plane looks like
+    for (size_t i = 0; i < 256; ++i) {
+        histogram[i] = 1000;
+    }
+    REQUIRE(Steganalysis::chi_square_p(histogram) > 0.99);
+    
+    // One value of each pair missing
+    for (size_t i = 1; i < 256; i += 2) {
+        histogram[i] = 0;
+    }
+    REQUIRE(Steganalysis::chi_square_p(histogram) < 0.01);
+}
+
+TEST_CASE("PNG writer levels and filters", "[steganography][png]") {
+    std::string cover_image = "test_png_options_cover.bmp";
+    std::string stego_image = "test_png_options_out.png";
+    TestImageHelper::create_test_bmp(cover_image);
+    
+    PngInfo info{29, 17, 4};
+    std::vector<uint8_t> pixels(info.channel_count());
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        pixels[i] = static_cast<uint8_t>((i % 11) * 23 + i / 97);
+    }
+    std::vector<uint8_t> secret = {'f', 'a', 's', 't'};
+    
+    for (auto filter : {PngFilter::None, PngFilter::Sub, PngFilter::Up, PngFilter::Average,
+                        PngFilter::Paeth, PngFilter::Adaptive}) {
+        for (int level : {0, 1, 9}) {
+            INFO("Filter: " << static_cast<int>(filter) << ", level: " << level);
+            PngWriteOptions options{level, filter};
+            {
+                PngRowWriter writer(stego_image, info, options);
+                for (uint32_t y = 0; y < info.height; ++y) {
+                    writer.write_row(std::span<const uint8_t>(pixels).subspan(y * info.row_bytes(), info.row_bytes()));
+                }
+                writer.finish();
+            }
+            REQUIRE(read_png_rows(stego_image) == pixels);
+            
+            REQUIRE(LSBSteganography::embed(cover_image, secret, stego_image, 1, options));
+            REQUIRE(LSBSteganography::extract(stego_image, 1) == secret);
+        }
+    }
+    
+    TestImageHelper::cleanup(cover_image);
+    TestImageHelper::cleanup(stego_image);
+}
+
 // ===========================================
 // Mismatched Parameters Tests
 // ===========================================
@@ -0,0 +1,243 @@
+/**
+ * @file test_blob_store.cpp
+ * @brief Unit tests for the encrypted log-structured blob store
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/store/blob_store.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace filevault::store;
+namespace fs = std::filesystem;
+
+namespace {
+
+std::vector<uint8_t> random_bytes(size_t size, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> data(size);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    return data;
+}
+
+BlobStoreConfig test_config() {
+    BlobStoreConfig config;
+    config.kdf = filevault::core::KDFType::PBKDF2_SHA256;
+    config.level = filevault::core::SecurityLevel::WEAK;
+    config.segment_bytes = 64 * 1024;
+    return config;
+}
+
+std::vector<fs::path> segment_files(const fs::path& directory) {
+    std::vector<fs::path> files;
+    for (const auto& entry : fs::directory_iterator(directory)) {
+        if (entry.path().extension() == ".seg") {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+std::string file_contents(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), {});
+}
+
+std::string key_of(int i) {
+    return "key-" + std::to_string(i);
+}
+
+} // anonymous namespace
+
+TEST_CASE("Blob store", "[store]") {
+    const fs::path directory = "test_blob_store";
+    const fs::path copy = "test_blob_store_copy";
+    fs::remove_all(directory);
+    fs::remove_all(copy);
+
+    BlobStore store(directory);
+    REQUIRE(store.create("correct horse", test_config()).success);
+    REQUIRE(BlobStore::is_store(directory));
+
+    auto value = random_bytes(100, 1);
+    std::vector<uint8_t> back;
+
+    SECTION("Put, get, overwrite and delete") {
+        REQUIRE(store.put("alpha", value).success);
+        REQUIRE(store.put("empty", {}).success);
+        REQUIRE(store.contains("alpha"));
+
+        auto got = store.get("alpha", back);
+        REQUIRE(got.success);
+        REQUIRE(got.value);
+        REQUIRE(back == value);
+        REQUIRE(store.get("empty", back).value);
+        REQUIRE(back.empty());
+        got = store.get("missing", back);
+        REQUIRE(got.success);
+        REQUIRE_FALSE(got.value);
+
+        auto other = random_bytes(300, 2);
+        REQUIRE(store.put("alpha", other).success);
+        REQUIRE(store.get("alpha", back).value);
+        REQUIRE(back == other);
+
+        REQUIRE(store.remove("alpha").value);
+        REQUIRE_FALSE(store.remove("alpha").value);
+        REQUIRE_FALSE(store.get("alpha", back).value);
+        REQUIRE(store.keys() == std::vector<std::string>{"empty"});
+
+        REQUIRE_FALSE(store.put("", value).success);
+        REQUIRE_FALSE(store.put(std::string(BlobStore::MAX_KEY_SIZE + 1, 'k'), value).success);
+    }
+
+    SECTION("Values are stored encrypted") {
+        std::string secret = "plaintext that must not reach the disk";
+        REQUIRE(store.put("secret-key", {reinterpret_cast<const uint8_t*>(secret.data()), secret.size()}).success);
+        REQUIRE(store.close().success);
+        for (const auto& file : segment_files(directory)) {
+            auto contents = file_contents(file);
+            REQUIRE(contents.find(secret) == std::string::npos);
+            REQUIRE(contents.find("secret-key") == std::string::npos);
+        }
+    }
+
+    SECTION("The index is rebuilt from the segments") {
+        for (int i = 0; i < 2000; ++i) {
+            REQUIRE(store.put(key_of(i), random_bytes(100, i)).success);
+        }
+        for (int i = 0; i < 2000; i += 3) {
+            REQUIRE(store.remove(key_of(i)).value);
+        }
+        REQUIRE(store.put(key_of(1), value).success);
+        REQUIRE(store.stats().segments > 2);   // Rolled over at 64 KiB
+        auto stats = store.stats();
+        REQUIRE(store.close().success);
+
+        BlobStore reopened(directory);
+        REQUIRE_FALSE(reopened.unlock("wrong").success);
+        REQUIRE_FALSE(reopened.unlocked());
+        REQUIRE(reopened.unlock("correct horse", true).success);
+        REQUIRE(reopened.stats().keys == stats.keys);
+        REQUIRE(reopened.stats().live_bytes == stats.live_bytes);
+        for (int i = 0; i < 2000; ++i) {
+            auto got = reopened.get(key_of(i), back);
+            REQUIRE(got.success);
+            REQUIRE(got.value == (i % 3 != 0));
+            if (got.value) {
+                REQUIRE(back == (i == 1 ? value : random_bytes(100, i)));
+            }
+        }
+        REQUIRE_FALSE(reopened.put("new", value).success);
+    }
+
+    SECTION("Compaction drops overwritten and deleted records") {
+        for (int round = 0; round < 5; ++round) {
+            for (int i = 0; i < 300; ++i) {
+                REQUIRE(store.put(key_of(i), random_bytes(100, round * 1000 + i)).success);
+            }
+        }
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(store.remove(key_of(i)).value);
+        }
+        auto before = store.stats();
+        REQUIRE(store.compact().success);
+        auto after = store.stats();
+        REQUIRE(after.keys == 200);
+        REQUIRE(after.live_bytes == before.live_bytes);
+        REQUIRE(after.disk_bytes < before.disk_bytes / 3);
+        REQUIRE(segment_files(directory).size() == after.segments);
+
+        REQUIRE(store.put("after", value).success);
+        REQUIRE(store.close().success);
+        BlobStore reopened(directory);
+        REQUIRE(reopened.unlock("correct horse").success);
+        REQUIRE(reopened.stats().keys == 201);
+        REQUIRE_FALSE(reopened.get(key_of(50), back).value);
+        REQUIRE(reopened.get(key_of(250), back).value);
+        REQUIRE(back == random_bytes(100, 4000 + 250));
+    }
+
+    SECTION("An unsealed segment is recovered and its torn tail cut off") {
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(store.put(key_of(i), random_bytes(100, i)).success);
+        }
+        REQUIRE(store.flush().success);
+        fs::copy(directory, copy);        // As left by a crash after the flush
+        auto segments = segment_files(copy);
+        REQUIRE(segments.size() == 1);
+        {
+            std::ofstream tail(segments[0], std::ios::binary | std::ios::app);
+            tail << "half a record";
+        }
+
+        {
+            BlobStore recovered(copy);
+            REQUIRE(recovered.unlock("correct horse").success);
+            REQUIRE(recovered.stats().keys == 100);
+            REQUIRE(recovered.get(key_of(42), back).value);
+            REQUIRE(back == random_bytes(100, 42));
+            REQUIRE(recovered.put("more", value).success);
+        }
+        REQUIRE(segment_files(copy).size() == 2);
+
+        BlobStore reopened(copy);
+        REQUIRE(reopened.unlock("correct horse", true).success);
+        REQUIRE(reopened.stats().keys == 101);
+        REQUIRE(reopened.get("more", back).value);
+        REQUIRE(back == value);
+    }
+
+    SECTION("Tampering is detected") {
+        REQUIRE(store.put("alpha", value).success);
+        REQUIRE(store.close().success);
+        auto segment = segment_files(directory).at(0);
+        {
+            std::fstream file(segment, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(16 + 17 + 20);     // Inside the first record's ciphertext
+            file.put(static_cast<char>(0x7f));
+        }
+        BlobStore reopened(directory);
+        REQUIRE(reopened.unlock("correct horse", true).success);
+        REQUIRE_FALSE(reopened.get("alpha", back).success);
+
+        // A footer that does not authenticate fails the unlock
+        REQUIRE(reopened.close().success);
+        auto size = fs::file_size(segment);
+        {
+            std::fstream file(segment, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(static_cast<std::streamoff>(size - 20));
+            file.put(static_cast<char>(0x7f));
+        }
+        REQUIRE_FALSE(reopened.unlock("correct horse").success);
+    }
+
+    SECTION("Changing the password keeps the data") {
+        REQUIRE(store.put("alpha", value).success);
+        REQUIRE(store.change_password("battery staple").success);
+        REQUIRE(store.close().success);
+
+        BlobStore reopened(directory);
+        REQUIRE_FALSE(reopened.unlock("correct horse").success);
+        REQUIRE(reopened.unlock("battery staple").success);
+        REQUIRE(reopened.get("alpha", back).value);
+        REQUIRE(back == value);
+    }
+
+    SECTION("A store cannot be created twice") {
+        BlobStore again(directory);
+        REQUIRE_FALSE(again.create("other", test_config()).success);
+    }
+
+    REQUIRE(store.close().success);
+    fs::remove_all(directory);
+    fs::remove_all(copy);
+}
@@ -0,0 +1,100 @@
+/**
+ * @file test_alloc_stats.cpp
+ * @brief Unit tests for the heap allocation counters
+ *
+ * Built with ENABLE_ALLOC_STATS, the counting allocator is linked in and
+ * real allocations are checked; otherwise only the bookkeeping is.
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/utils/alloc_stats.hpp"
+#include "filevault/utils/bench_stats.hpp"
+#include "filevault/utils/trace.hpp"
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace filevault::utils;
+
+namespace {
+
+// Kept out of the optimizer's reach, so the allocation is not elided
+void* volatile sink = nullptr;
+
+void allocate_and_free(size_t size) {
+    auto block = std::make_unique<char[]>(size);
+    sink = block.get();
+}
+
+} // anonymous namespace
+
+TEST_CASE("Allocation bookkeeping", "[utils][alloc_stats]") {
+    auto before = AllocStats::totals();
+    auto thread_before = AllocStats::thread();
+    uint64_t live = AllocStats::live_bytes();
+
+    AllocStats::reset_peak();
+    AllocStats::on_alloc(1000, 1024);
+    AllocStats::on_alloc(10, 16);
+    REQUIRE(AllocStats::peak_bytes() >= live + 1040);
+    AllocStats::on_free(1024);
+    AllocStats::on_free(16);
+
+    REQUIRE(AllocStats::totals().allocations - before.allocations >= 2);
+    REQUIRE(AllocStats::totals().bytes - before.bytes >= 1010);
+    REQUIRE(AllocStats::thread().allocations - thread_before.allocations >= 2);
+    if (!AllocStats::enabled()) {
+        REQUIRE(AllocStats::live_bytes() == live);
+    }
+}
+
+TEST_CASE("Counting allocator", "[utils][alloc_stats]") {
+    if (!AllocStats::enabled()) {
+        SKIP("Built without ENABLE_ALLOC_STATS");
+    }
+
+    SECTION("Allocations are counted and balance") {
+        auto before = AllocStats::totals();
+        uint64_t live = AllocStats::live_bytes();
+        AllocStats::reset_peak();
+        allocate_and_free(1 << 20);
+        auto after = AllocStats::totals();
+        REQUIRE(after.allocations - before.allocations >= 1);
+        REQUIRE(after.bytes - before.bytes >= (1u << 20));
+        REQUIRE(AllocStats::peak_bytes() - live >= (1u << 20));
+        REQUIRE(AllocStats::live_bytes() == live);
+    }
+
+    SECTION("Thread counters see only their thread") {
+        auto mine = AllocStats::thread();
+        uint64_t other = 0;
+        std::thread([&other]() {
+            auto start = AllocStats::thread();
+            allocate_and_free(4096);
+            other = AllocStats::thread().allocations - start.allocations;
+        }).join();
+        REQUIRE(other >= 1);
+        // join() and the thread's own setup may allocate here, but not 4 KB
+        REQUIRE(AllocStats::thread().bytes - mine.bytes < 4096);
+    }
+
+    SECTION("Benchmark samples and trace spans") {
+        Sampler sampler({1, 3, 3, 0.5, 1.0, false});
+        auto stats = sampler.measure(0, []() { allocate_and_free(65536); });
+        REQUIRE(stats.allocations);
+        REQUIRE(stats.allocations->allocations >= 1.0);
+        REQUIRE(stats.allocations->bytes >= 65536.0);
+        REQUIRE(stats.allocations->peak_bytes >= 65536);
+
+        Tracer::instance().start();
+        {
+            ScopedSpan span("chunk", "cipher");
+            allocate_and_free(1000);
+        }
+        Tracer::instance().stop();
+        auto spans = Tracer::instance().spans();
+        REQUIRE(spans.size() == 1);
+        REQUIRE(spans[0].allocs.allocations >= 1);
+        REQUIRE(spans[0].allocs.bytes >= 1000);
+    }
+}
@@ -0,0 +1,191 @@
+/**
+ * @file test_bench_stats.cpp
+ * @brief Unit tests for benchmark sample statistics
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/utils/bench_stats.hpp"
+#include <cmath>
+#include <vector>
+
+using namespace filevault::utils;
+
+namespace {
+
+bool near(double actual, double expected, double tolerance = 1e-6) {
+    return std::abs(actual - expected) < tolerance;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Sample statistics", "[utils][bench_stats]") {
+    SECTION("Order statistics and a slow outlier") {
+        std::vector<double> times = {1.0, 1.1, 0.9, 1.0, 1.2, 0.8, 1.0, 50.0};
+        auto stats = SampleStats::summarize(times, {}, 1024 * 1024);
+
+        REQUIRE(stats.samples == 8);
+        REQUIRE(stats.min_ms == 0.8);
+        REQUIRE(stats.max_ms == 50.0);
+        REQUIRE(near(stats.median_ms, 1.0));
+        REQUIRE(stats.p99_ms == 50.0);
+
+        // The 50 ms sample is left out of the mean, stddev and interval
+        REQUIRE(stats.outliers == 1);
+        REQUIRE(near(stats.mean_ms, 1.0));
+        REQUIRE(stats.stddev_ms < 0.2);
+        REQUIRE(stats.ci95_ms > 0.0);
+        REQUIRE(stats.ci95_ms < stats.stddev_ms * 2);
+
+        // 1 MB in the median 1 ms
+        REQUIRE(near(stats.mbps(1024 * 1024), 1000.0));
+        REQUIRE(stats.cycles_per_byte == 0.0);
+        REQUIRE(stats.times_ms == times);
+    }
+
+    SECTION("Cycles per byte comes from the median sample") {
+        auto stats = SampleStats::summarize({1.0, 2.0, 3.0}, {1000.0, 3000.0, 2000.0}, 1000);
+        REQUIRE(near(stats.cycles_per_byte, 2.0));
+    }
+
+    SECTION("Empty input") {
+        auto stats = SampleStats::summarize({}, {}, 0);
+        REQUIRE(stats.samples == 0);
+        REQUIRE(stats.mbps(100) == 0.0);
+    }
+}
+
+TEST_CASE("Linear fit of cost against size", "[utils][bench_stats]") {
+    SECTION("Exact line from 64 B to 1 GB") {
+        std::vector<double> sizes, times;
+        for (double size = 64; size <= 1073741824.0; size *= 4) {
+            sizes.push_back(size);
+            times.push_back(0.002 + size * 1e-6);   // 2 us per call, 1 ms per MB
+        }
+        auto fit = LinearFit::fit(sizes, times);
+        REQUIRE(near(fit.intercept, 0.002, 1e-9));
+        REQUIRE(near(fit.slope, 1e-6, 1e-12));
+        REQUIRE(near(fit.r_squared, 1.0, 1e-9));
+    }
+
+    SECTION("Degenerate input") {
+        REQUIRE(LinearFit::fit({}, {}).slope == 0.0);
+        auto flat = LinearFit::fit({100.0, 100.0}, {2.0, 2.0});
+        REQUIRE(flat.slope == 0.0);
+        REQUIRE(near(flat.intercept, 2.0));
+    }
+}
+
+TEST_CASE("Mann-Whitney U test", "[utils][bench_stats]") {
+    SECTION("Disjoint samples") {
+        std::vector<double> fast = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        std::vector<double> slow = {11, 12, 13, 14, 15, 16, 17, 18, 19, 20};
+        auto test = MannWhitney::test(slow, fast);
+        REQUIRE(test.u == 100.0);
+        REQUIRE(test.z > 0.0);
+        REQUIRE(test.p_value < 0.001);
+        REQUIRE(MannWhitney::test(fast, slow).z < 0.0);
+    }
+
+    SECTION("Interleaved samples are not significant") {
+        std::vector<double> a = {1.0, 1.2, 1.4, 1.6, 1.8, 2.0, 2.2, 2.4};
+        std::vector<double> b = {1.1, 1.3, 1.5, 1.7, 1.9, 2.1, 2.3, 2.5};
+        REQUIRE(MannWhitney::test(a, b).p_value > 0.5);
+    }
+
+    SECTION("All values tied") {
+        auto test = MannWhitney::test({1.0, 1.0, 1.0}, {1.0, 1.0});
+        REQUIRE(test.p_value == 1.0);
+        REQUIRE(MannWhitney::test({}, {1.0}).p_value == 1.0);
+    }
+}
+
+TEST_CASE("Adaptive sampling", "[utils][bench_stats]") {
+    SamplingPolicy policy;
+    policy.warmup = 2;
+    policy.min_samples = 10;
+    policy.max_samples = 50;
+
+    int prepared = 0;
+    int ran = 0;
+    Sampler sampler(policy);
+    auto stats = sampler.measure(64, [&] { ++prepared; }, [&] {
+        volatile int sink = 0;
+        for (int i = 0; i < 1000; ++i) {
+            sink = sink + i;
+        }
+        ++ran;
+    });
+
+    REQUIRE(stats.samples >= policy.min_samples);
+    REQUIRE(stats.samples <= policy.max_samples);
+    REQUIRE(ran == prepared);
+    REQUIRE(static_cast<size_t>(ran) == stats.samples + policy.warmup);
+    REQUIRE(stats.min_ms <= stats.median_ms);
+    REQUIRE(stats.median_ms <= stats.p95_ms);
+    REQUIRE(stats.p95_ms <= stats.p99_ms);
+    if (sampler.cycles().available()) {
+        REQUIRE(stats.cycles_per_byte > 0.0);
+    }
+}
+
+TEST_CASE("Hardware counters", "[utils][bench_stats]") {
+    SamplingPolicy policy;
+    policy.warmup = 1;
+    policy.min_samples = 5;
+    policy.max_samples = 5;
+
+    SECTION("Off unless requested") {
+        Sampler sampler(policy);
+        REQUIRE_FALSE(sampler.counters_available());
+        REQUIRE_FALSE(sampler.measure(0, [] {}).counters.has_value());
+    }
+
+    SECTION("Mean per sample when the kernel allows it") {
+        policy.hardware_counters = true;
+        Sampler sampler(policy);
+        auto stats = sampler.measure(0, [] {
+            volatile int sink = 0;
+            for (int i = 0; i < 100000; ++i) {
+                sink = sink + i;
+            }
+        });
+        REQUIRE(stats.counters.has_value() == sampler.counters_available());
+        if (stats.counters) {
+            REQUIRE(stats.counters->cycles > 0);
+            if (stats.counters->instructions >= 0) {
+                REQUIRE(stats.counters->instructions > 100000);
+                REQUIRE(stats.counters->ipc() > 0);
+            }
+        }
+    }
+}
+
+TEST_CASE("Energy metering", "[utils][bench_stats]") {
+    SamplingPolicy policy;
+    policy.warmup = 1;
+    policy.min_samples = 5;
+    policy.max_samples = 5;
+
+    SECTION("Off unless requested") {
+        Sampler sampler(policy);
+        REQUIRE_FALSE(sampler.energy_available());
+        REQUIRE_FALSE(sampler.measure(0, [] {}).energy.has_value());
+    }
+
+    SECTION("Joules per call where RAPL is readable") {
+        policy.energy = true;
+        Sampler sampler(policy);
+        auto stats = sampler.measure(1 << 20, [] {
+            volatile int sink = 0;
+            for (int i = 0; i < 1000000; ++i) {
+                sink = sink + i;
+            }
+        });
+        REQUIRE(stats.energy.has_value() == sampler.energy_available());
+        if (stats.energy) {
+            REQUIRE(stats.energy->joules >= 0);
+            REQUIRE(stats.energy->watts >= 0);
+            REQUIRE(near(stats.energy->joules_per_gb(1 << 20), stats.energy->joules * 1e9 / (1 << 20)));
+        }
+    }
+}
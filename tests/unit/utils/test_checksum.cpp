@@ -0,0 +1,102 @@
+/**
+ * @file test_checksum.cpp
+ * @brief Unit tests for the CRC32C and XXH3-128 checksums
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/utils/checksum.hpp"
+#include <botan/hex.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace filevault::utils;
+
+namespace {
+
+std::vector<uint8_t> make_data(size_t size) {
+    std::vector<uint8_t> data(size);
+    std::mt19937 gen(97);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(gen());
+    }
+    return data;
+}
+
+std::span<const uint8_t> bytes(const std::string& text) {
+    return {reinterpret_cast<const uint8_t*>(text.data()), text.size()};
+}
+
+std::string digest_hex(Botan::HashFunction& hash, std::span<const uint8_t> data) {
+    hash.update(data.data(), data.size());
+    return Botan::hex_encode(hash.final(), false);
+}
+
+} // anonymous namespace
+
+TEST_CASE("CRC32C known answers", "[utils][checksum][crc32c]") {
+    REQUIRE(crc32c(bytes("")) == 0);
+    REQUIRE(crc32c(bytes("123456789")) == 0xE3069283);
+    REQUIRE(crc32c(std::vector<uint8_t>(32, 0x00)) == 0x8A9136AA);   // RFC 3720 B.4
+    REQUIRE(crc32c(std::vector<uint8_t>(32, 0xFF)) == 0x62A8AB43);
+    REQUIRE(crc32c_portable(bytes("123456789")) == 0xE3069283);
+}
+
+TEST_CASE("CRC32C kernels agree with the tables", "[utils][checksum][crc32c]") {
+    INFO("hardware: " << crc32c_hardware());
+    auto data = make_data(3 * 4096 * 2 + 100);
+
+    // Around the 8-byte words and the three-stripe blocks, at every alignment
+    for (size_t size : {0, 1, 7, 8, 9, 63, 4096, 12287, 12288, 12289, 24576 + 13}) {
+        for (size_t offset = 0; offset < 8; ++offset) {
+            auto slice = std::span<const uint8_t>(data).subspan(offset, size);
+            REQUIRE(crc32c(slice) == crc32c_portable(slice));
+        }
+    }
+
+    SECTION("Continuing a CRC equals one pass") {
+        auto all = std::span<const uint8_t>(data);
+        for (size_t split : {size_t{0}, size_t{1}, size_t{5000}, size_t{12288}, all.size()}) {
+            REQUIRE(crc32c(all.subspan(split), crc32c(all.first(split))) == crc32c(all));
+        }
+    }
+}
+
+TEST_CASE("Checksums as hash functions", "[utils][checksum]") {
+    auto data = make_data(100000);
+
+    SECTION("Known digests") {
+        Crc32c crc;
+        REQUIRE(digest_hex(crc, bytes("123456789")) == "e3069283");
+        Xxh3_128 xxh;
+        REQUIRE(digest_hex(xxh, bytes("")) == "99aa06d3014798d86001c324468d497f");
+    }
+
+    SECTION("Streaming matches one update, and final() resets") {
+        for (const auto* name : {"CRC32C", "XXH3-128"}) {
+            INFO(name);
+            auto hash = create_hash(name);
+            REQUIRE(hash);
+            REQUIRE(is_checksum(name));
+            auto whole = digest_hex(*hash, data);
+            for (size_t start = 0; start < data.size(); start += 777) {
+                size_t length = std::min<size_t>(777, data.size() - start);
+                hash->update(data.data() + start, length);
+            }
+            REQUIRE(Botan::hex_encode(hash->final(), false) == whole);
+            REQUIRE(digest_hex(*hash, data) == whole);
+
+            hash->update(data.data(), 1000);
+            auto copy = hash->copy_state();
+            copy->update(data.data() + 1000, data.size() - 1000);
+            REQUIRE(Botan::hex_encode(copy->final(), false) == whole);
+        }
+    }
+
+    SECTION("Other names go to Botan") {
+        REQUIRE_FALSE(is_checksum("SHA-256"));
+        REQUIRE(create_hash("SHA-256"));
+        REQUIRE_FALSE(create_hash("No-Such-Hash"));
+        REQUIRE_THROWS(create_hash_or_throw("No-Such-Hash"));
+    }
+}
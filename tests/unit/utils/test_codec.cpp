@@ -0,0 +1,170 @@
+/**
+ * @file test_codec.cpp
+ * @brief Unit tests for the hex/base64 kernels and ASCII armor
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/utils/armor.hpp"
+#include "filevault/utils/codec_kernels.hpp"
+#include "filevault/utils/crypto_utils.hpp"
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+using namespace filevault::utils;
+
+namespace {
+
+std::vector<codec::Isa> supported_isas() {
+    std::vector<codec::Isa> isas;
+    for (auto isa : {codec::Isa::Scalar, codec::Isa::SSSE3, codec::Isa::AVX2, codec::Isa::NEON}) {
+        if (codec::is_supported(isa)) {
+            isas.push_back(isa);
+        }
+    }
+    return isas;
+}
+
+std::vector<uint8_t> pattern(size_t size) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<uint8_t>(i * 131 + 7);
+    }
+    return data;
+}
+
+std::string as_string(const std::vector<uint8_t>& data) {
+    return std::string(data.begin(), data.end());
+}
+
+} // anonymous namespace
+
+TEST_CASE("Codec RFC 4648 vectors", "[utils][codec]") {
+    const std::pair<std::string, std::string> vectors[] = {
+        {"", ""}, {"f", "Zg=="}, {"fo", "Zm8="}, {"foo", "Zm9v"},
+        {"foob", "Zm9vYg=="}, {"fooba", "Zm9vYmE="}, {"foobar", "Zm9vYmFy"},
+    };
+    for (const auto& [plain, encoded] : vectors) {
+        std::vector<uint8_t> bytes(plain.begin(), plain.end());
+        REQUIRE(CryptoUtils::base64_encode(bytes) == encoded);
+        REQUIRE(as_string(CryptoUtils::base64_decode(encoded)) == plain);
+    }
+
+    std::vector<uint8_t> bytes = {0x00, 0xab, 0xff};
+    REQUIRE(CryptoUtils::hex_encode(bytes) == "00ABFF");
+    REQUIRE(CryptoUtils::hex_encode(bytes, false) == "00abff");
+    REQUIRE(CryptoUtils::hex_decode("00 ab\nFF") == bytes);
+}
+
+TEST_CASE("Codec kernels agree with scalar", "[utils][codec]") {
+    for (auto isa : supported_isas()) {
+        INFO("isa " << codec::isa_name(isa));
+        for (size_t size : {0, 1, 2, 3, 11, 12, 13, 31, 32, 47, 48, 49, 95, 96, 97, 1000, 4099}) {
+            auto data = pattern(size);
+
+            std::string hex(codec::hex_encoded_size(size), '\0');
+            std::string expected_hex(hex.size(), '\0');
+            codec::hex_encode(data, hex, false, isa);
+            codec::hex_encode(data, expected_hex, false, codec::Isa::Scalar);
+            REQUIRE(hex == expected_hex);
+
+            std::vector<uint8_t> back(size);
+            REQUIRE(codec::hex_decode(hex, back, isa));
+            REQUIRE(back == data);
+
+            std::string text(codec::base64_encoded_size(size), '\0');
+            std::string expected_text(text.size(), '\0');
+            REQUIRE(codec::base64_encode(data, text, isa) == text.size());
+            codec::base64_encode(data, expected_text, codec::Isa::Scalar);
+            REQUIRE(text == expected_text);
+
+            back.assign(codec::base64_decoded_capacity(text.size()), 0);
+            auto written = codec::base64_decode(text, back, isa);
+            REQUIRE(written.has_value());
+            back.resize(*written);
+            REQUIRE(back == data);
+        }
+    }
+}
+
+TEST_CASE("Codec rejects malformed input", "[utils][codec]") {
+    for (auto isa : supported_isas()) {
+        INFO("isa " << codec::isa_name(isa));
+        std::vector<uint8_t> out(256);
+
+        std::string hex(128, 'a');
+        REQUIRE_FALSE(codec::hex_decode(hex.substr(0, 127), out, isa));
+        hex[70] = 'g';
+        REQUIRE_FALSE(codec::hex_decode(hex, out, isa));
+
+        std::string text(128, 'A');
+        REQUIRE_FALSE(codec::base64_decode(text.substr(0, 127), out, isa).has_value());
+        text[90] = '*';
+        REQUIRE_FALSE(codec::base64_decode(text, out, isa).has_value());
+        text[90] = '=';
+        REQUIRE_FALSE(codec::base64_decode(text, out, isa).has_value());
+    }
+
+    REQUIRE_THROWS_AS(CryptoUtils::hex_decode("abc"), std::invalid_argument);
+    REQUIRE_THROWS_AS(CryptoUtils::base64_decode("Zm9v!"), std::invalid_argument);
+}
+
+TEST_CASE("Armor round trip", "[utils][codec][armor]") {
+    for (size_t size : {0, 1, 47, 48, 49, 48 * 1024 + 5, 200000}) {
+        auto data = pattern(size);
+
+        std::stringstream armored;
+        {
+            ArmorOutput out(armored);
+            out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(size));
+            REQUIRE(static_cast<size_t>(out.tellp()) == size);
+            REQUIRE(out.finish());
+        }
+
+        std::string text = armored.str();
+        REQUIRE(text.starts_with(ARMOR_BEGIN));
+        REQUIRE(text.find(ARMOR_END) != std::string::npos);
+
+        // CRLF line endings decode the same
+        std::string crlf;
+        for (char c : text) {
+            if (c == '\n') {
+                crlf += '\r';
+            }
+            crlf += c;
+        }
+
+        for (const auto& variant : {text, crlf}) {
+            std::istringstream source(variant);
+            ArmorInput in(source);
+            std::vector<uint8_t> back((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            REQUIRE(in.error().empty());
+            REQUIRE(back == data);
+        }
+    }
+}
+
+TEST_CASE("Armor rejects damaged input", "[utils][codec][armor]") {
+    auto data = pattern(1000);
+    std::stringstream armored;
+    {
+        ArmorOutput out(armored);
+        out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        out.finish();
+    }
+    std::string text = armored.str();
+
+    auto read_all = [](const std::string& input) {
+        std::istringstream source(input);
+        ArmorInput in(source);
+        std::string ignored((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        return in.error();
+    };
+
+    REQUIRE_FALSE(read_all(text.substr(0, text.find(ARMOR_END))).empty());
+    REQUIRE_FALSE(read_all(text.substr(ARMOR_BEGIN.size() + 1)).empty());
+
+    std::string damaged = text;
+    damaged[ARMOR_BEGIN.size() + 10] = '#';
+    REQUIRE_FALSE(read_all(damaged).empty());
+}
@@ -0,0 +1,79 @@
+/**
+ * @file test_config.cpp
+ * @brief Unit tests for config performance profiles
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/utils/config.hpp"
+#include <algorithm>
+
+using namespace filevault::utils;
+
+TEST_CASE("Performance profiles overlay the plain settings", "[utils][config]") {
+    auto config = Config::get_default();
+    config.set_streaming_chunk_mb(8);
+    REQUIRE(config.get_profile().empty());
+    REQUIRE(config.get_streaming_chunk_mb() == 8);
+    REQUIRE(config.get_threads() == 0);
+    REQUIRE(config.get_buffer_pool_mb() == 1024);
+    REQUIRE_FALSE(config.get_huge_pages());
+    REQUIRE(config.get_streaming_io_buffers() == 2);
+    REQUIRE(config.get_max_memory_mb() == 0);
+
+    SECTION("Built-in profile") {
+        REQUIRE(config.set("profile", "low-memory"));
+        REQUIRE(config.get_profile() == "low-memory");
+        REQUIRE(config.get_streaming_chunk_mb() == 1);
+        REQUIRE(config.get_threads() == 1);
+        REQUIRE(config.get_buffer_pool_mb() == 32);
+        REQUIRE(config.get_max_memory_mb() == 512);
+        // Knobs the profile leaves open keep the plain setting
+        REQUIRE(config.get_io_backend() == "auto");
+
+        REQUIRE(config.set("profile", "none"));
+        REQUIRE(config.get_streaming_chunk_mb() == 8);
+    }
+
+    SECTION("User profiles and customized built-ins") {
+        REQUIRE(config.set("profiles.nightly.threads", "6"));
+        REQUIRE(config.set("profiles.nightly.io.direct", "yes"));
+        REQUIRE(config.set("profiles.nightly.memory.huge_pages", "true"));
+        REQUIRE(config.set("profiles.nightly.streaming.io_buffers", "8"));
+        REQUIRE_FALSE(config.set("profiles.nightly.streaming.io_buffers", "65"));
+        REQUIRE_FALSE(config.set("profiles.nightly.memory.huge_pages", "2mb"));
+        REQUIRE(config.set("profiles.laptop.compression.target_mbps", "50"));
+        REQUIRE_FALSE(config.set("profiles.nightly.no_such_knob", "1"));
+        REQUIRE_FALSE(config.set("profiles.nightly.streaming.chunk_mb", "0"));
+        REQUIRE_FALSE(config.set("profile", "no-such-profile"));
+
+        auto names = config.profile_names();
+        REQUIRE(std::count(names.begin(), names.end(), "nightly") == 1);
+        REQUIRE(std::count(names.begin(), names.end(), "laptop") == 1);
+
+        auto laptop = config.find_profile("laptop");
+        REQUIRE(laptop);
+        REQUIRE(*laptop->compression_target_mbps == 50.0);
+        REQUIRE(*laptop->threads == 2);
+
+        // Saved and reloaded through the JSON form
+        REQUIRE(config.set("profile", "nightly"));
+        auto reloaded = Config::from_json(config.to_json());
+        REQUIRE(reloaded.get_profile() == "nightly");
+        REQUIRE(reloaded.get_threads() == 6);
+        REQUIRE(reloaded.get_direct_io());
+        REQUIRE(reloaded.get_huge_pages());
+        REQUIRE(reloaded.get_streaming_io_buffers() == 8);
+        REQUIRE(reloaded.get_streaming_chunk_mb() == 8);
+        REQUIRE(*reloaded.find_profile("laptop")->compression_target_mbps == 50.0);
+    }
+
+    SECTION("Malformed knobs are skipped") {
+        auto json = config.to_json();
+        json["profile"] = "custom";
+        json["profiles"]["custom"] = {{"threads", "many"}, {"streaming", {{"chunk_mb", 2}}}};
+        auto loaded = Config::from_json(json);
+        REQUIRE(loaded.get_profile() == "custom");
+        REQUIRE(loaded.get_threads() == 0);
+        REQUIRE(loaded.get_streaming_chunk_mb() == 2);
+    }
+}
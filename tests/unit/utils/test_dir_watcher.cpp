@@ -0,0 +1,118 @@
+/**
+ * @file test_dir_watcher.cpp
+ * @brief Unit tests for change coalescing and directory watching
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/utils/dir_watcher.hpp"
+#include <algorithm>
+#include <fstream>
+
+using namespace filevault::utils;
+namespace fs = std::filesystem;
+using namespace std::chrono_literals;
+
+namespace {
+
+const fs::path test_dir = "test_dir_watcher_temp";
+
+void write_text(const fs::path& path, const std::string& text) {
+    std::ofstream(path, std::ios::binary) << text;
+}
+
+bool saw(const WatchEvents& events, const fs::path& path) {
+    return std::find(events.changed.begin(), events.changed.end(), path) != events.changed.end();
+}
+
+/**
+ * @brief Wait until the watcher reports path (a polling watcher needs a few rounds)
+ */
+bool wait_for(DirectoryWatcher& watcher, const fs::path& path) {
+    std::atomic<bool> stop{false};
+    for (int round = 0; round < 20; round++) {
+        if (saw(watcher.wait(500ms, stop), path)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Change bursts are coalesced", "[utils][watch]") {
+    using Clock = ChangeDebouncer::Clock;
+    ChangeDebouncer debouncer(2s, 10s);
+    auto t0 = Clock::time_point{} + 1h;
+
+    SECTION("A path is ready after a quiet period") {
+        debouncer.touch("a", t0);
+        debouncer.touch("a", t0 + 1s);
+        debouncer.touch("b", t0 + 500ms);
+        REQUIRE(debouncer.pending() == 2);
+        REQUIRE(debouncer.next_deadline() == t0 + 2500ms);
+
+        REQUIRE(debouncer.take_ready(t0 + 2s).empty());
+        REQUIRE(debouncer.take_ready(t0 + 2500ms) == std::vector<fs::path>{"b"});
+        REQUIRE(debouncer.take_ready(t0 + 3s) == std::vector<fs::path>{"a"});
+        REQUIRE_FALSE(debouncer.next_deadline());
+    }
+
+    SECTION("A path written continuously is taken after the maximum delay") {
+        for (int i = 0; i <= 12; i++) {
+            debouncer.touch("log", t0 + std::chrono::seconds(i));
+            if (i < 10) {
+                REQUIRE(debouncer.take_ready(t0 + std::chrono::seconds(i)).empty());
+            }
+        }
+        REQUIRE(debouncer.take_ready(t0 + 10s) == std::vector<fs::path>{"log"});
+
+        // The next write starts a new burst
+        debouncer.touch("log", t0 + 13s);
+        REQUIRE(debouncer.next_deadline() == t0 + 15s);
+    }
+
+    SECTION("Shutdown takes everything pending") {
+        debouncer.touch("b", t0);
+        debouncer.touch("a", t0);
+        REQUIRE(debouncer.take_all() == std::vector<fs::path>{"a", "b"});
+        REQUIRE(debouncer.pending() == 0);
+    }
+}
+
+TEST_CASE("Directory watcher reports changed files", "[utils][watch]") {
+    fs::remove_all(test_dir);
+    fs::create_directories(test_dir / "sub");
+    write_text(test_dir / "old.txt", "before");
+
+    DirectoryWatcher watcher(test_dir, 100ms);
+    REQUIRE(watcher.start());
+
+    SECTION("Written and new files") {
+        write_text(test_dir / "old.txt", "after the watch started");
+        REQUIRE(wait_for(watcher, test_dir / "old.txt"));
+        write_text(test_dir / "sub" / "new.txt", "new");
+        REQUIRE(wait_for(watcher, test_dir / "sub" / "new.txt"));
+    }
+
+    SECTION("Files in directories created later") {
+        fs::create_directories(test_dir / "later" / "deeper");
+        write_text(test_dir / "later" / "deeper" / "file.txt", "x");
+        REQUIRE(wait_for(watcher, test_dir / "later" / "deeper" / "file.txt"));
+
+        // The new directory is watched from then on
+        write_text(test_dir / "later" / "deeper" / "second.txt", "y");
+        REQUIRE(wait_for(watcher, test_dir / "later" / "deeper" / "second.txt"));
+    }
+
+    SECTION("Nothing changed: the wait times out, or ends when stopped") {
+        std::atomic<bool> stop{false};
+        auto start = std::chrono::steady_clock::now();
+        REQUIRE(watcher.wait(200ms, stop).changed.empty());
+        REQUIRE(std::chrono::steady_clock::now() - start >= 200ms);
+
+        stop = true;
+        REQUIRE(watcher.wait(-1ms, stop).changed.empty());
+    }
+
+    fs::remove_all(test_dir);
+}
@@ -0,0 +1,174 @@
+/**
+ * @file test_file_io.cpp
+ * @brief Unit tests for memory-mapped file input
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/utils/file_io.hpp"
+#include <filesystem>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+using filevault::utils::FileIO;
+using filevault::utils::MappedFile;
+
+namespace {
+
+// Pages of the file in the page cache (0 where mincore is unavailable)
+size_t resident_pages(const std::string& path) {
+    size_t count = 0;
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    struct stat st {};
+    if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0) {
+        auto size = static_cast<size_t>(st.st_size);
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapped != MAP_FAILED) {
+            auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#ifdef __APPLE__
+            std::vector<char> resident((size + page - 1) / page);
+#else
+            std::vector<unsigned char> resident((size + page - 1) / page);
+#endif
+            if (mincore(mapped, size, resident.data()) == 0) {
+                for (auto r : resident) {
+                    count += r & 1;
+                }
+            }
+            munmap(mapped, size);
+        }
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+#else
+    (void)path;
+#endif
+    return count;
+}
+
+} // anonymous namespace
+
+TEST_CASE("FileIO::map_file", "[file_io]") {
+    auto path = (fs::temp_directory_path() / "filevault_test_map.bin").string();
+    
+    SECTION("Mapped contents match the file") {
+        std::vector<uint8_t> data(100000);
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = static_cast<uint8_t>(i * 31);
+        }
+        REQUIRE(FileIO::write_file(path, data));
+        
+        auto result = FileIO::map_file(path);
+        REQUIRE(result.success);
+        REQUIRE(result.value.size() == data.size());
+        auto view = result.value.span();
+        REQUIRE(std::vector<uint8_t>(view.begin(), view.end()) == data);
+        
+        // Moving keeps the same view and empties the source
+        MappedFile moved = std::move(result.value);
+        REQUIRE(moved.data() == view.data());
+        REQUIRE(result.value.empty());
+    }
+    
+    SECTION("Empty file maps to an empty span") {
+        REQUIRE(FileIO::write_file(path, std::vector<uint8_t>{}));
+        
+        auto result = FileIO::map_file(path);
+        REQUIRE(result.success);
+        REQUIRE(result.value.empty());
+        REQUIRE(result.value.span().empty());
+    }
+    
+    SECTION("Missing file is an error") {
+        auto result = FileIO::map_file(path + ".missing");
+        REQUIRE_FALSE(result.success);
+    }
+    
+    fs::remove(path);
+}
+
+TEST_CASE("FileIO::read_range", "[file_io]") {
+    auto path = (fs::temp_directory_path() / "filevault_test_range.bin").string();
+    std::vector<uint8_t> data(5000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i * 7);
+    }
+    REQUIRE(FileIO::write_file(path, data));
+    
+    SECTION("Reads the requested bytes") {
+        auto result = FileIO::read_range(path, 1000, 256);
+        REQUIRE(result.success);
+        REQUIRE(result.value == std::vector<uint8_t>(data.begin() + 1000, data.begin() + 1256));
+    }
+    
+    SECTION("Stops at end of file") {
+        auto result = FileIO::read_range(path, 4900, 512);
+        REQUIRE(result.success);
+        REQUIRE(result.value == std::vector<uint8_t>(data.begin() + 4900, data.end()));
+        
+        auto past_end = FileIO::read_range(path, 6000, 16);
+        REQUIRE(past_end.success);
+        REQUIRE(past_end.value.empty());
+    }
+    
+    SECTION("Missing file is an error") {
+        REQUIRE_FALSE(FileIO::read_range(path + ".missing", 0, 16).success);
+    }
+    
+    fs::remove(path);
+}
+
+TEST_CASE("FileIO::prefetch", "[file_io]") {
+    auto path = (fs::temp_directory_path() / "filevault_test_prefetch.bin").string();
+    REQUIRE(FileIO::write_file(path, std::vector<uint8_t>(3 * 1024 * 1024 + 5, 0x5A)));
+    
+    SECTION("Reads up to the requested length") {
+        REQUIRE(FileIO::prefetch(path, 1024 * 1024 + 1) == 1024 * 1024 + 1);
+    }
+    
+    SECTION("Stops at end of file") {
+        REQUIRE(FileIO::prefetch(path) == 3 * 1024 * 1024 + 5);
+    }
+    
+    SECTION("Missing file reads nothing") {
+        REQUIRE(FileIO::prefetch(path + ".missing") == 0);
+    }
+    
+    SECTION("Direct I/O reads nothing into the cache") {
+        // Where the cache can be emptied (not tmpfs), it stays empty
+        bool emptied = FileIO::drop_cache(path) && resident_pages(path) == 0;
+        REQUIRE(FileIO::prefetch(path, FileIO::PREFETCH_SIZE, true) == 0);
+        if (emptied) {
+            REQUIRE(resident_pages(path) == 0);
+        }
+    }
+    
+    fs::remove(path);
+}
+
+TEST_CASE("FileIO::write_file replaces files atomically", "[file_io]") {
+    auto dir = fs::temp_directory_path() / "filevault_test_write";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    auto path = (dir / "out.bin").string();
+    
+    REQUIRE(FileIO::write_file(path, std::vector<uint8_t>(5000, 1)));
+    REQUIRE(FileIO::write_file(path, std::vector<uint8_t>(10, 2)));
+    
+    auto result = FileIO::read_file(path);
+    REQUIRE(result.success);
+    REQUIRE(result.value == std::vector<uint8_t>(10, 2));
+    // No temp file is left beside the output
+    REQUIRE(std::distance(fs::directory_iterator(dir), fs::directory_iterator()) == 1);
+    
+    REQUIRE_FALSE(FileIO::write_file((dir / "missing" / "out.bin").string(), std::vector<uint8_t>(1)));
+    fs::remove_all(dir);
+}
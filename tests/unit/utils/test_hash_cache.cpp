@@ -0,0 +1,106 @@
+/**
+ * @file test_hash_cache.cpp
+ * @brief Unit tests for the persistent hash result cache
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/utils/hash_cache.hpp"
+#include <filesystem>
+#include <fstream>
+
+using namespace filevault::utils;
+namespace fs = std::filesystem;
+
+namespace {
+
+// An identity old enough to be cached
+FileIdentity old_file(uint64_t inode) {
+    FileIdentity identity;
+    identity.device = 1;
+    identity.inode = inode;
+    identity.size = 4096;
+    identity.mtime_ns = 1'600'000'000'000'000'000;
+    identity.ctime_ns = identity.mtime_ns;
+    return identity;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Hash cache lookups", "[utils][hash_cache]") {
+    const fs::path path = "test_hash_cache.bin";
+    fs::remove(path);
+
+    HashCache cache(path);
+    REQUIRE_FALSE(cache.load());
+    auto file = old_file(42);
+    cache.store(file, "sha256", "digest-a");
+
+    SECTION("Unchanged file hits") {
+        REQUIRE(cache.lookup(file, "sha256") == "digest-a");
+        REQUIRE(cache.hits() == 1);
+    }
+
+    SECTION("Any change in size, mtime or algorithm misses") {
+        auto grown = file;
+        grown.size++;
+        auto touched = file;
+        touched.mtime_ns++;
+        REQUIRE_FALSE(cache.lookup(grown, "sha256"));
+        REQUIRE_FALSE(cache.lookup(touched, "sha256"));
+        REQUIRE_FALSE(cache.lookup(file, "sha512"));
+        REQUIRE(cache.misses() == 3);
+    }
+
+    SECTION("Stale entries need the same size") {
+        auto touched = file;
+        touched.mtime_ns += 1'000'000'000;
+        auto grown = file;
+        grown.size++;
+        REQUIRE(cache.stale(touched, "sha256") == "digest-a");
+        REQUIRE_FALSE(cache.stale(grown, "sha256"));
+        REQUIRE_FALSE(cache.stale(touched, "sha512"));
+        REQUIRE(cache.misses() == 0);
+
+        cache.store(touched, "sha256", *cache.stale(touched, "sha256"));
+        REQUIRE(cache.lookup(touched, "sha256") == "digest-a");
+        REQUIRE_FALSE(cache.lookup(file, "sha256"));
+    }
+
+    SECTION("Recently modified files are not stored") {
+        const fs::path fresh = "test_hash_cache_fresh.txt";
+        std::ofstream(fresh) << "just written";
+        auto identity = HashCache::identify(fresh);
+        REQUIRE(identity);
+        REQUIRE(identity->size == 12);
+        cache.store(*identity, "sha256", "digest-b");
+        REQUIRE_FALSE(cache.lookup(*identity, "sha256"));
+        fs::remove(fresh);
+    }
+
+    SECTION("Entries survive a save and load") {
+        cache.store(old_file(7), "blake2b-512-tree-1024k", std::string(64, '\xab'));
+        REQUIRE(cache.save().success);
+
+        HashCache reloaded(path);
+        REQUIRE(reloaded.load());
+        REQUIRE(reloaded.size() == 2);
+        REQUIRE(reloaded.lookup(file, "sha256") == "digest-a");
+        REQUIRE(reloaded.lookup(old_file(7), "blake2b-512-tree-1024k") == std::string(64, '\xab'));
+    }
+
+    SECTION("A damaged file keeps the entries before the damage") {
+        cache.store(old_file(7), "sha256", "digest-c");
+        REQUIRE(cache.save().success);
+        fs::resize_file(path, fs::file_size(path) - 1);
+
+        HashCache reloaded(path);
+        REQUIRE(reloaded.load());
+        REQUIRE(reloaded.size() == 1);
+
+        std::ofstream(path, std::ios::trunc) << "garbage";
+        REQUIRE_FALSE(reloaded.load());
+        REQUIRE(reloaded.size() == 0);
+    }
+
+    fs::remove(path);
+}
@@ -0,0 +1,282 @@
+/**
+ * @file test_io_backend.cpp
+ * @brief Unit tests for the read backends, InputFile, OutputFile and hole detection
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include "filevault/utils/io_backend.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+
+using namespace filevault::utils;
+namespace fs = std::filesystem;
+
+TEST_CASE("InputFile reads ahead through each backend", "[utils][io]") {
+    auto path = (fs::temp_directory_path() / "filevault_test_input_file.bin").string();
+    std::vector<uint8_t> data(100000 + 321);
+    std::mt19937 rng(7);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(data.data()),
+                                                static_cast<std::streamsize>(data.size()));
+
+    auto type = GENERATE(IoBackendType::PORTABLE, IoBackendType::AUTO);
+    InputFileOptions options;
+    options.backend = type;
+    options.depth = 3;
+    options.block_size = 8192;
+    InputFile input(path, options);
+    REQUIRE(input.is_open());
+    REQUIRE(input.size() == data.size());
+    if (type == IoBackendType::PORTABLE) {
+        REQUIRE(std::string(input.backend_name()) == "portable");
+    }
+
+    SECTION("Sequential reads across block boundaries") {
+        std::vector<uint8_t> out(data.size());
+        size_t pos = 0;
+        for (size_t piece : {1u, 8191u, 20000u, 5u}) {
+            input.read(reinterpret_cast<char*>(out.data() + pos), static_cast<std::streamsize>(piece));
+            pos += piece;
+            REQUIRE(static_cast<size_t>(input.tellg()) == pos);
+        }
+        input.read(reinterpret_cast<char*>(out.data() + pos), static_cast<std::streamsize>(data.size() - pos));
+        REQUIRE(input);
+        REQUIRE(out == data);
+
+        char extra;
+        REQUIRE_FALSE(input.read(&extra, 1));
+        REQUIRE(input.eof());
+        REQUIRE_FALSE(input.bad());
+    }
+
+    SECTION("Seeking restarts the queue") {
+        input.seekg(0, std::ios::end);
+        REQUIRE(static_cast<size_t>(input.tellg()) == data.size());
+
+        input.seekg(12345);
+        std::vector<uint8_t> out(30000);
+        input.read(reinterpret_cast<char*>(out.data()), static_cast<std::streamsize>(out.size()));
+        REQUIRE(input);
+        REQUIRE(std::equal(out.begin(), out.end(), data.begin() + 12345));
+
+        input.seekg(-10, std::ios::end);
+        std::vector<uint8_t> tail(10);
+        input.read(reinterpret_cast<char*>(tail.data()), 10);
+        REQUIRE(std::equal(tail.begin(), tail.end(), data.end() - 10));
+    }
+
+    SECTION("Missing file") {
+        InputFile missing((fs::temp_directory_path() / "filevault_test_no_such_file").string(), options);
+        REQUIRE_FALSE(missing.is_open());
+        REQUIRE(missing.fail());
+    }
+
+    fs::remove(path);
+}
+
+TEST_CASE("I/O backend names", "[utils][io]") {
+    REQUIRE(IoBackend::parse("auto") == IoBackendType::AUTO);
+    REQUIRE(IoBackend::parse("io_uring") == IoBackendType::URING);
+    REQUIRE(IoBackend::parse("iocp") == IoBackendType::IOCP);
+    REQUIRE(IoBackend::parse("dispatch_io") == IoBackendType::DISPATCH);
+    REQUIRE(IoBackend::parse("portable") == IoBackendType::PORTABLE);
+    REQUIRE_FALSE(IoBackend::parse("aio"));
+    REQUIRE(IoBackend::resolve(IoBackendType::PORTABLE) == IoBackendType::PORTABLE);
+    REQUIRE(IoBackend::resolve(IoBackendType::URING) ==
+            (IoBackend::uring_available() ? IoBackendType::URING : IoBackendType::PORTABLE));
+
+    // Another platform's backend falls back to portable reads
+#if defined(_WIN32)
+    REQUIRE(IoBackend::resolve(IoBackendType::IOCP) == IoBackendType::IOCP);
+    REQUIRE(IoBackend::resolve(IoBackendType::DISPATCH) == IoBackendType::PORTABLE);
+#elif defined(__APPLE__)
+    REQUIRE(IoBackend::resolve(IoBackendType::IOCP) == IoBackendType::PORTABLE);
+    REQUIRE(IoBackend::resolve(IoBackendType::DISPATCH) == IoBackendType::DISPATCH);
+#else
+    REQUIRE(IoBackend::resolve(IoBackendType::IOCP) == IoBackendType::PORTABLE);
+    REQUIRE(IoBackend::resolve(IoBackendType::DISPATCH) == IoBackendType::PORTABLE);
+#endif
+}
+
+TEST_CASE("OutputFile writes through its own buffer", "[utils][io]") {
+    auto path = (fs::temp_directory_path() / "filevault_test_output_file.bin").string();
+    std::vector<uint8_t> data(3 * 4096 + 17);
+    std::mt19937 rng(11);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    auto read_back = [&path]() {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), {});
+    };
+
+    OutputFileOptions options;
+    options.buffer_size = 4096;
+    options.bypass_cache = GENERATE(false, true);
+
+    {
+        OutputFile output(path, options);
+        REQUIRE(output.is_open());
+        // Small pieces go through the buffer, a large one straight to the file
+        output.write(reinterpret_cast<const char*>(data.data()), 100);
+        output.put(static_cast<char>(data[100]));
+        output.write(reinterpret_cast<const char*>(data.data() + 101), 8000);
+        REQUIRE(static_cast<size_t>(output.tellp()) == 8101);
+        output.write(reinterpret_cast<const char*>(data.data() + 8101),
+                     static_cast<std::streamsize>(data.size() - 8101));
+        REQUIRE(output.close());
+        REQUIRE(output);
+    }
+    REQUIRE(read_back() == data);
+
+    SECTION("Reopening without truncation keeps the contents") {
+        options.truncate = false;
+        OutputFile output(path, options);
+        output.seekp(5);
+        output.write("xyz", 3);
+        REQUIRE(static_cast<size_t>(output.tellp()) == 8);
+        REQUIRE(output.close());
+        std::copy_n("xyz", 3, data.begin() + 5);
+        REQUIRE(read_back() == data);
+    }
+
+    SECTION("Reopening truncates by default") {
+        OutputFile output(path, options);
+        output.write("abc", 3);
+        REQUIRE(output.close());
+        REQUIRE(read_back() == std::vector<uint8_t>{'a', 'b', 'c'});
+    }
+
+    SECTION("Directory as output") {
+        OutputFile output(fs::temp_directory_path().string(), options);
+        REQUIRE_FALSE(output.is_open());
+        REQUIRE(output.fail());
+    }
+
+    fs::remove(path);
+}
+
+TEST_CASE("Atomic OutputFile replaces the file only on commit", "[utils][io]") {
+    auto dir = fs::temp_directory_path() / "filevault_test_atomic";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    auto path = (dir / "out.bin").string();
+    std::ofstream(path, std::ios::binary) << "old";
+
+    auto read_back = [](const std::string& file_path) {
+        std::ifstream file(file_path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), {});
+    };
+    auto entries = [&dir]() {
+        return static_cast<size_t>(std::distance(fs::directory_iterator(dir), fs::directory_iterator()));
+    };
+
+    OutputFileOptions options;
+    options.atomic = true;
+    options.preallocate = 1024 * 1024;
+
+    SECTION("Commit") {
+        OutputFile output(path, options);
+        REQUIRE(output.is_open());
+        output << "new contents";
+        REQUIRE(read_back(path) == "old");
+        REQUIRE(output.commit());
+        REQUIRE(read_back(path) == "new contents");
+        // The unused reservation is given back
+        REQUIRE(fs::file_size(path) == 12);
+        REQUIRE(entries() == 1);
+    }
+
+    SECTION("Closing without commit keeps the old file") {
+        {
+            OutputFile output(path, options);
+            output << "partial";
+        }
+        REQUIRE(read_back(path) == "old");
+        REQUIRE(entries() == 1);
+    }
+
+    SECTION("Group commit") {
+        CommitGroup group(3);
+        for (int i = 0; i < 4; ++i) {
+            OutputFile output((dir / ("g" + std::to_string(i))).string(), options);
+            output << i;
+            REQUIRE(output.commit(&group));
+        }
+        // The first three were committed when the group filled up
+        REQUIRE(read_back((dir / "g2").string()) == "2");
+        REQUIRE_FALSE(fs::exists(dir / "g3"));
+        REQUIRE(group.flush());
+        REQUIRE(read_back((dir / "g3").string()) == "3");
+        REQUIRE(group.failed() == 0);
+        REQUIRE(entries() == 5);
+    }
+
+    fs::remove_all(dir);
+}
+
+TEST_CASE("OutputFile leaves holes that data_extents finds", "[utils][io]") {
+    auto path = (fs::temp_directory_path() / "filevault_test_sparse.bin").string();
+    constexpr uint64_t HOLE = 1024 * 1024;
+    std::string data(4096, 'x');
+    auto read_back = [&path]() {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), {});
+    };
+
+    OutputFileOptions options;
+    options.atomic = GENERATE(false, true);
+    options.preallocate = 4 * HOLE;
+    {
+        OutputFile output(path, options);
+        output << data;
+        REQUIRE(output.write_zeros(HOLE));
+        output << data;
+        // A trailing hole still extends the file
+        REQUIRE(output.write_zeros(HOLE));
+        REQUIRE(static_cast<uint64_t>(output.tellp()) == 2 * HOLE + 2 * data.size());
+        REQUIRE(output.commit());
+    }
+    auto contents = read_back();
+    REQUIRE(contents.size() == 2 * HOLE + 2 * data.size());
+    REQUIRE(contents.substr(0, data.size()) == data);
+    REQUIRE(contents.substr(data.size(), HOLE) == std::string(HOLE, '\0'));
+    REQUIRE(contents.substr(data.size() + HOLE, data.size()) == data);
+    REQUIRE(contents.substr(2 * data.size() + HOLE) == std::string(HOLE, '\0'));
+
+    // Where holes are supported the data is all that is reported; it is
+    // always covered
+    if (auto extents = data_extents(path)) {
+        uint64_t covered_first = 0, covered_second = 0, total = 0;
+        for (const auto& extent : *extents) {
+            total += extent.length;
+            covered_first += extent.offset == 0 ? 1 : 0;
+            covered_second += extent.offset <= data.size() + HOLE &&
+                              extent.offset + extent.length >= 2 * data.size() + HOLE ? 1 : 0;
+        }
+        REQUIRE(covered_first == 1);
+        REQUIRE(covered_second == 1);
+        REQUIRE(total <= contents.size());
+    }
+
+    SECTION("Zeroing existing contents") {
+        OutputFileOptions reopen;
+        reopen.truncate = false;
+        OutputFile output(path, reopen);
+        REQUIRE(output.write_zeros(data.size()));
+        REQUIRE(output.close());
+        contents = read_back();
+        REQUIRE(contents.size() == 2 * HOLE + 2 * data.size());
+        REQUIRE(contents.substr(0, data.size()) == std::string(data.size(), '\0'));
+        REQUIRE(contents.substr(data.size() + HOLE, data.size()) == data);
+    }
+
+    REQUIRE_FALSE(data_extents((fs::temp_directory_path() / "filevault_test_no_such_file").string()));
+    fs::remove(path);
+}
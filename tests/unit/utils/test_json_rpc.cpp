@@ -0,0 +1,59 @@
+/**
+ * @file test_json_rpc.cpp
+ * @brief Unit tests for JSON-RPC request dispatch
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/utils/json_rpc.hpp"
+#include <vector>
+
+using namespace filevault::utils;
+using nlohmann::json;
+
+TEST_CASE("JSON-RPC dispatch", "[utils][rpc]") {
+    JsonRpcDispatcher dispatcher;
+    dispatcher.add("add", [](const json& params, const JsonRpcDispatcher::Notify& notify) {
+        notify("progress", {{"step", 1}});
+        return json(params.at("a").get<int>() + params.at("b").get<int>());
+    });
+    dispatcher.add("fail", [](const json&, const JsonRpcDispatcher::Notify&) -> json {
+        throw RpcError(42, "no");
+    });
+
+    std::vector<std::string> sent;
+    JsonRpcDispatcher::Notify notify = [&sent](const std::string& method, const json& params) {
+        sent.push_back(JsonRpcDispatcher::notification(method, params));
+    };
+
+    SECTION("Result and tagged notifications") {
+        auto response = json::parse(dispatcher.handle(
+            R"({"jsonrpc":"2.0","id":7,"method":"add","params":{"a":2,"b":3}})", notify));
+        REQUIRE(response["id"] == 7);
+        REQUIRE(response["result"] == 5);
+
+        REQUIRE(sent.size() == 1);
+        auto event = json::parse(sent[0]);
+        REQUIRE(event["method"] == "progress");
+        REQUIRE(event["params"]["id"] == 7);
+        REQUIRE(event["params"]["step"] == 1);
+        REQUIRE_FALSE(event.contains("id"));
+    }
+
+    SECTION("Error codes") {
+        auto code = [&](const std::string& line) {
+            return json::parse(dispatcher.handle(line, notify))["error"]["code"].get<int>();
+        };
+        REQUIRE(code("{not json") == JsonRpcDispatcher::PARSE_ERROR);
+        REQUIRE(code(R"({"id":1,"method":"add"})") == JsonRpcDispatcher::INVALID_REQUEST);
+        REQUIRE(code(R"([{"jsonrpc":"2.0","id":1,"method":"add"}])") == JsonRpcDispatcher::INVALID_REQUEST);
+        REQUIRE(code(R"({"jsonrpc":"2.0","id":1,"method":"nope"})") == JsonRpcDispatcher::METHOD_NOT_FOUND);
+        REQUIRE(code(R"({"jsonrpc":"2.0","id":1,"method":"add","params":{"a":"x","b":1}})") ==
+                JsonRpcDispatcher::INVALID_PARAMS);
+        REQUIRE(code(R"({"jsonrpc":"2.0","id":1,"method":"fail"})") == 42);
+    }
+
+    SECTION("Notifications get no response") {
+        REQUIRE(dispatcher.handle(R"({"jsonrpc":"2.0","method":"add","params":{"a":1,"b":1}})", notify).empty());
+        REQUIRE(dispatcher.handle(R"({"jsonrpc":"2.0","method":"nope"})", notify).empty());
+    }
+}
@@ -0,0 +1,134 @@
+/**
+ * @file test_metrics.cpp
+ * @brief Unit tests for the serve-mode counters and latency histograms
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/utils/metrics.hpp"
+#include <thread>
+#include <vector>
+
+using namespace filevault::utils;
+
+namespace {
+
+const Metrics::HistogramValue* find_histogram(const std::vector<Metrics::HistogramValue>& values,
+                                              const std::string& name) {
+    for (const auto& value : values) {
+        if (value.name == name) {
+            return &value;
+        }
+    }
+    return nullptr;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Histogram buckets", "[utils][metrics]") {
+    SECTION("Small values are exact") {
+        for (uint64_t v = 0; v < 64; v++) {
+            REQUIRE(LatencyHistogram::bucket_of(v) == v);
+            REQUIRE(LatencyHistogram::bucket_limit(v) == v);
+        }
+    }
+
+    SECTION("Buckets are contiguous and within 1/32") {
+        for (size_t b = 64; b < LatencyHistogram::BUCKETS; b++) {
+            uint64_t low = LatencyHistogram::bucket_limit(b - 1) + 1;
+            uint64_t high = LatencyHistogram::bucket_limit(b);
+            REQUIRE(LatencyHistogram::bucket_of(low) == b);
+            REQUIRE(LatencyHistogram::bucket_of(high) == b);
+            REQUIRE((high - low + 1) * 32 <= low);
+        }
+        REQUIRE(LatencyHistogram::bucket_limit(LatencyHistogram::BUCKETS - 1) == LatencyHistogram::MAX_VALUE);
+    }
+
+    SECTION("Large values are clamped") {
+        REQUIRE(LatencyHistogram::bucket_of(UINT64_MAX) == LatencyHistogram::BUCKETS - 1);
+    }
+}
+
+TEST_CASE("Histogram quantiles", "[utils][metrics]") {
+    LatencyHistogram histogram;
+    for (uint64_t v = 1; v <= 10000; v++) {
+        histogram.record(v);
+    }
+    HistogramSnapshot snapshot;
+    REQUIRE(snapshot.quantile(0.5) == 0);
+    snapshot.merge(histogram);
+
+    REQUIRE(snapshot.count == 10000);
+    REQUIRE(snapshot.sum == 10000ull * 10001 / 2);
+    REQUIRE(snapshot.max == 10000);
+    for (double q : {0.5, 0.99, 0.999}) {
+        auto exact = static_cast<double>(q * 10000);
+        auto reported = static_cast<double>(snapshot.quantile(q));
+        REQUIRE(reported >= exact);
+        REQUIRE(reported <= exact * (1.0 + 1.0 / 32));
+    }
+    REQUIRE(snapshot.quantile(1.0) == 10000);
+}
+
+TEST_CASE("Series are recorded per thread and merged", "[utils][metrics]") {
+    auto& metrics = Metrics::instance();
+    metrics.describe("test_merge_seconds", "Merged latencies", 1e-6);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&metrics]() {
+            auto histogram = metrics.histogram("test_merge_seconds", {{"kind", "a"}});
+            auto counter = metrics.counter("test_merge_total", {{"kind", "a"}});
+            for (uint64_t v = 1; v <= 1000; v++) {
+                metrics.observe(histogram, v);
+                metrics.add(counter, 2);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // A thread started after the others exited reuses one of their shards
+    std::thread([&metrics]() {
+        metrics.add(metrics.counter("test_merge_total", {{"kind", "a"}}), 1);
+    }).join();
+
+    auto histograms = metrics.histograms();
+    auto* merged = find_histogram(histograms, "test_merge_seconds");
+    REQUIRE(merged);
+    REQUIRE(merged->snapshot.count == 4000);
+    REQUIRE(merged->snapshot.max == 1000);
+    REQUIRE(merged->scale == 1e-6);
+
+    uint64_t total = 0;
+    for (const auto& value : metrics.counters()) {
+        if (value.name == "test_merge_total") {
+            total = value.value;
+        }
+    }
+    REQUIRE(total == 8001);
+
+    REQUIRE(metrics.histogram("test_merge_seconds", {{"kind", "a"}}) ==
+            metrics.histogram("test_merge_seconds", {{"kind", "a"}}));
+    REQUIRE(metrics.histogram("test_merge_seconds", {{"kind", "b"}}) !=
+            metrics.histogram("test_merge_seconds", {{"kind", "a"}}));
+}
+
+TEST_CASE("Prometheus text format", "[utils][metrics]") {
+    auto& metrics = Metrics::instance();
+    metrics.describe("test_prom_seconds", "Test latencies", 1e-6);
+    metrics.observe(metrics.histogram("test_prom_seconds", {{"op", "say \"hi\""}}), 2000);
+    metrics.add(metrics.counter("test_prom_total"), 5);
+
+    std::string text;
+    metrics.write_prometheus(text);
+    REQUIRE(text.find("# HELP test_prom_seconds Test latencies\n") != std::string::npos);
+    REQUIRE(text.find("# TYPE test_prom_seconds summary\n") != std::string::npos);
+    REQUIRE(text.find("test_prom_seconds{op=\"say \\\"hi\\\"\",quantile=\"0.99\"} 0.002\n") != std::string::npos);
+    REQUIRE(text.find("test_prom_seconds_count{op=\"say \\\"hi\\\"\"} 1\n") != std::string::npos);
+    REQUIRE(text.find("# TYPE test_prom_total counter\ntest_prom_total 5\n") != std::string::npos);
+
+    std::string sample;
+    Metrics::write_sample(sample, "test_gauge", "A gauge", "gauge", 3);
+    REQUIRE(sample == "# HELP test_gauge A gauge\n# TYPE test_gauge gauge\ntest_gauge 3\n");
+}
@@ -0,0 +1,94 @@
+/**
+ * @file test_multi_hash.cpp
+ * @brief Unit tests for the multi-buffer SHA-256 and BLAKE2s kernels
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/utils/checksum.hpp"
+#include "filevault/utils/crypto_utils.hpp"
+#include "filevault/utils/multi_hash.hpp"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace filevault::utils;
+
+namespace {
+
+std::vector<multihash::Isa> supported_isas() {
+    std::vector<multihash::Isa> isas;
+    for (auto isa : {multihash::Isa::Scalar, multihash::Isa::SSE2, multihash::Isa::AVX2, multihash::Isa::AVX512}) {
+        if (multihash::is_supported(isa)) {
+            isas.push_back(isa);
+        }
+    }
+    return isas;
+}
+
+std::vector<std::string> hash_all(multihash::Algorithm algorithm,
+                                  const std::vector<std::vector<uint8_t>>& data, multihash::Isa isa) {
+    std::vector<std::span<const uint8_t>> messages(data.begin(), data.end());
+    std::vector<uint8_t> digests(messages.size() * multihash::DIGEST_SIZE);
+    multihash::hash(algorithm, messages, digests, isa);
+    std::vector<std::string> hex;
+    for (size_t i = 0; i < messages.size(); ++i) {
+        hex.push_back(CryptoUtils::hex_encode(
+            std::span(digests).subspan(i * multihash::DIGEST_SIZE, multihash::DIGEST_SIZE), false));
+    }
+    return hex;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Multi-buffer known answers", "[utils][multi_hash]") {
+    std::vector<std::vector<uint8_t>> data = {{}, {'a', 'b', 'c'}};
+    for (auto isa : supported_isas()) {
+        auto sha = hash_all(multihash::Algorithm::SHA256, data, isa);
+        REQUIRE(sha[0] == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+        REQUIRE(sha[1] == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+        auto blake = hash_all(multihash::Algorithm::BLAKE2S_256, data, isa);
+        REQUIRE(blake[0] == "69217a3079908094e11121d042354a7c1f55b6482ca1a51e1b250dfd1ed0eef9");
+        REQUIRE(blake[1] == "508c5e8c327c14e2e1a72ba34eeb452f37458b209ed63a294d999b4c86675982");
+    }
+}
+
+TEST_CASE("Multi-buffer digests match one-at-a-time hashing", "[utils][multi_hash]") {
+    // Every tail length, both sides of the padding boundary, and lanes
+    // that finish at different times
+    std::vector<std::vector<uint8_t>> data;
+    for (size_t size = 0; size < 300; ++size) {
+        std::vector<uint8_t> message(size);
+        for (size_t i = 0; i < size; ++i) {
+            message[i] = static_cast<uint8_t>(i * 131 + 7 + size);
+        }
+        data.push_back(std::move(message));
+    }
+    data.push_back(std::vector<uint8_t>(20000, 0x5A));
+
+    for (const auto& [algorithm, name] : {std::pair{multihash::Algorithm::SHA256, "SHA-256"},
+                                          std::pair{multihash::Algorithm::BLAKE2S_256, "Blake2s(256)"}}) {
+        REQUIRE(multihash::algorithm_for(name) == algorithm);
+        auto reference = create_hash_or_throw(name);
+        std::vector<std::string> expected;
+        for (const auto& message : data) {
+            reference->update(message.data(), message.size());
+            expected.push_back(CryptoUtils::hex_encode(reference->final(), false));
+        }
+        for (auto isa : supported_isas()) {
+            INFO(multihash::isa_name(isa));
+            REQUIRE(hash_all(algorithm, data, isa) == expected);
+        }
+    }
+}
+
+TEST_CASE("Multi-buffer argument checks", "[utils][multi_hash]") {
+    REQUIRE_FALSE(multihash::algorithm_for("SHA-512").has_value());
+    REQUIRE(multihash::lanes(multihash::Isa::AVX2) == 8);
+    REQUIRE(multihash::is_supported(multihash::best_isa()));
+
+    std::vector<uint8_t> message(10);
+    std::vector<std::span<const uint8_t>> messages = {message, message};
+    std::vector<uint8_t> digests(multihash::DIGEST_SIZE);
+    REQUIRE_THROWS_AS(multihash::hash(multihash::Algorithm::SHA256, messages, digests), std::invalid_argument);
+    REQUIRE_NOTHROW(multihash::hash(multihash::Algorithm::SHA256, {}, {}));
+}
@@ -0,0 +1,175 @@
+/**
+ * @file test_part_files.cpp
+ * @brief Unit tests for streams split into part files
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/core/streaming.hpp"
+#include "filevault/utils/part_files.hpp"
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+using namespace filevault;
+using namespace filevault::utils;
+namespace fs = std::filesystem;
+
+namespace {
+
+std::vector<uint8_t> random_bytes(size_t size, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::vector<uint8_t> data(size);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(gen());
+    }
+    return data;
+}
+
+std::vector<uint8_t> read_all(std::istream& in) {
+    std::vector<uint8_t> out;
+    char buffer[7000];
+    while (in.read(buffer, sizeof(buffer)) || in.gcount() > 0) {
+        out.insert(out.end(), buffer, buffer + in.gcount());
+    }
+    return out;
+}
+
+struct TempDir {
+    fs::path path = fs::temp_directory_path() / "filevault_test_parts";
+    TempDir() { fs::remove_all(path); fs::create_directories(path); }
+    ~TempDir() { fs::remove_all(path); }
+};
+
+} // anonymous namespace
+
+TEST_CASE("PartOutput cuts a stream into fixed-size parts", "[utils][parts]") {
+    TempDir dir;
+    auto base = (dir.path / "data.fvlt").string();
+    auto data = random_bytes(250000, 1);
+    {
+        PartOutput output(base, 100000);
+        output.write(reinterpret_cast<const char*>(data.data()), 123);
+        REQUIRE(static_cast<size_t>(output.tellp()) == 123);
+        output.write(reinterpret_cast<const char*>(data.data() + 123), static_cast<std::streamsize>(data.size() - 123));
+        REQUIRE(output.finish());
+        REQUIRE(output.parts().parts.size() == 3);
+    }
+
+    REQUIRE(fs::file_size(PartSet::part_path(base, 1)) == PART_HEADER_SIZE + 100000);
+    REQUIRE(fs::file_size(PartSet::part_path(base, 2)) == PART_HEADER_SIZE + 100000);
+    REQUIRE(fs::file_size(PartSet::part_path(base, 3)) == PART_HEADER_SIZE + 50000);
+    REQUIRE_FALSE(fs::exists(PartSet::part_path(base, 4)));
+    REQUIRE(PartSet::is_part_set(PartSet::manifest_path(base)));
+    REQUIRE(PartSet::is_part_set(PartSet::part_path(base, 2)));
+    REQUIRE_FALSE(PartSet::is_part_set(base));
+
+    SECTION("Read back through the manifest") {
+        auto set = PartSet::load(PartSet::manifest_path(base));
+        REQUIRE(set.success);
+        REQUIRE(set.value.total_size == data.size());
+        PartInput input(set.value);
+        REQUIRE(read_all(input) == data);
+        REQUIRE(input.error().empty());
+    }
+
+    SECTION("Read back from the first part alone") {
+        fs::remove(PartSet::manifest_path(base));
+        auto set = PartSet::load(PartSet::part_path(base, 1));
+        REQUIRE(set.success);
+        REQUIRE(set.value.parts.size() == 3);
+        PartInput input(set.value);
+        REQUIRE(read_all(input) == data);
+
+        REQUIRE_FALSE(PartSet::load(PartSet::part_path(base, 2)).success);
+    }
+
+    SECTION("Seeks cross part boundaries") {
+        PartInput input(PartSet::load(PartSet::manifest_path(base)).value);
+        input.seekg(199990);
+        REQUIRE(static_cast<size_t>(input.tellg()) == 199990);
+        std::vector<uint8_t> span(20);
+        input.read(reinterpret_cast<char*>(span.data()), 20);
+        REQUIRE(std::equal(span.begin(), span.end(), data.begin() + 199990));
+
+        input.seekg(-5, std::ios::end);
+        input.read(reinterpret_cast<char*>(span.data()), 5);
+        REQUIRE(std::equal(span.begin(), span.begin() + 5, data.end() - 5));
+
+        input.seekg(7);
+        input.read(reinterpret_cast<char*>(span.data()), 3);
+        REQUIRE(std::equal(span.begin(), span.begin() + 3, data.begin() + 7));
+    }
+
+    SECTION("A truncated part ends the stream with an error") {
+        fs::resize_file(PartSet::part_path(base, 2), 5000);
+        PartInput input(PartSet::load(PartSet::manifest_path(base)).value);
+        auto out = read_all(input);
+        REQUIRE(out.size() == 100000);
+        REQUIRE_FALSE(input.error().empty());
+    }
+
+    SECTION("A part from another stream is rejected") {
+        auto other = (dir.path / "other.fvlt").string();
+        PartOutput output(other, 100000);
+        output.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        REQUIRE(output.finish());
+        fs::copy_file(PartSet::part_path(other, 3), PartSet::part_path(base, 3),
+                      fs::copy_options::overwrite_existing);
+
+        PartInput input(PartSet::load(PartSet::manifest_path(base)).value);
+        read_all(input);
+        REQUIRE_FALSE(input.error().empty());
+    }
+}
+
+TEST_CASE("A stream that fills its last part exactly", "[utils][parts]") {
+    TempDir dir;
+    auto base = (dir.path / "exact.fvlt").string();
+    auto data = random_bytes(2000, 2);
+    PartOutput output(base, 1000);
+    output.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    REQUIRE(output.finish());
+    REQUIRE(output.parts().parts.size() == 2);
+
+    auto set = PartSet::load(PartSet::part_path(base, 1));
+    REQUIRE(set.success);
+    PartInput input(set.value);
+    REQUIRE(read_all(input) == data);
+}
+
+TEST_CASE("Streams encrypt to and decrypt from part files", "[utils][parts][streaming]") {
+    TempDir dir;
+    auto base = (dir.path / "data.fvlt").string();
+    auto data = random_bytes(200 * 1024 + 77, 3);
+    core::StreamingConfig config;
+    config.chunk_size = 16 * 1024;
+    {
+        std::string text(data.begin(), data.end());
+        std::istringstream input(text);
+        PartOutput output(base, 64 * 1024);
+        auto result = core::StreamingCrypto::encrypt_stream(input, output, "password", data.size(), config);
+        REQUIRE(result.success);
+        REQUIRE(output.finish());
+        REQUIRE(output.parts().parts.size() == 4);
+    }
+
+    SECTION("Sequential decryption") {
+        PartInput input(PartSet::load(PartSet::manifest_path(base)).value);
+        std::ostringstream output;
+        auto result = core::StreamingCrypto::decrypt_stream(input, output, "password");
+        REQUIRE(result.success);
+        REQUIRE(input.error().empty());
+        auto text = output.str();
+        REQUIRE(std::vector<uint8_t>(text.begin(), text.end()) == data);
+    }
+
+    SECTION("Range reads seek across the parts") {
+        auto input = std::make_unique<PartInput>(PartSet::load(PartSet::manifest_path(base)).value);
+        core::StreamReader reader;
+        REQUIRE(reader.open(std::move(input), "password").success);
+        std::vector<uint8_t> range;
+        REQUIRE(reader.read(130 * 1024, 5000, range).success);
+        REQUIRE(std::equal(range.begin(), range.end(), data.begin() + 130 * 1024));
+    }
+}
@@ -0,0 +1,62 @@
+/**
+ * @file test_password.cpp
+ * @brief Unit tests for password strength scoring
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/core/thread_pool.hpp"
+#include "filevault/utils/password.hpp"
+#include <string>
+#include <vector>
+
+using namespace filevault;
+using namespace filevault::utils;
+
+TEST_CASE("Password scores", "[utils][password]") {
+    SECTION("Score agrees with the full analysis") {
+        for (std::string password : {"", "abc", "password", "PassWord", "Tr0ub4dor&3", "aaaa1111",
+                                     "correct horse battery staple", "\xc3\xa9t\xc3\xa9-2024!"}) {
+            auto scored = Password::score(password);
+            auto analysis = Password::analyze_strength(password);
+            REQUIRE(scored.score == analysis.score);
+            REQUIRE(scored.strength == analysis.strength);
+            REQUIRE(scored.length == analysis.length);
+            REQUIRE(scored.has_special == analysis.has_special);
+            REQUIRE(scored.has_repeated_chars == analysis.has_repeated_chars);
+            REQUIRE(scored.is_common_password == analysis.is_common_password);
+        }
+    }
+
+    SECTION("Common passwords ignore case") {
+        REQUIRE(Password::score("Password").is_common_password);
+        REQUIRE(Password::score("QWERTY123").is_common_password);
+        REQUIRE(Password::score("qwerty123").score == 0);
+        REQUIRE_FALSE(Password::score("qwerty1234").is_common_password);
+    }
+
+    SECTION("Entropy and classes") {
+        auto scored = Password::score("Ab1!");
+        REQUIRE(scored.has_lowercase);
+        REQUIRE(scored.has_uppercase);
+        REQUIRE(scored.has_digits);
+        REQUIRE(scored.has_special);
+        REQUIRE(scored.entropy_bits > 26.2);
+        REQUIRE(scored.entropy_bits < 26.3);
+        REQUIRE(Password::score(std::string(300, 'x')).has_repeated_chars);
+    }
+
+    SECTION("Batch scoring matches one at a time") {
+        std::vector<std::string> passwords;
+        for (int i = 0; i < 5000; ++i) {
+            passwords.push_back(std::string(static_cast<size_t>(i % 23), 'a' + i % 26) + std::to_string(i));
+        }
+        passwords.push_back("letmein");
+        std::vector<PasswordScore> results(passwords.size());
+        core::ThreadPool pool(4);
+        Password::score_batch(passwords, results, pool);
+        for (size_t i = 0; i < passwords.size(); ++i) {
+            REQUIRE(results[i].score == Password::score(passwords[i]).score);
+        }
+        REQUIRE(results.back().is_common_password);
+    }
+}
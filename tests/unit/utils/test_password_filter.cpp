@@ -0,0 +1,75 @@
+/**
+ * @file test_password_filter.cpp
+ * @brief Unit tests for the breached-password Bloom filter
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/utils/password_filter.hpp"
+#include <filesystem>
+#include <fmt/core.h>
+#include <fstream>
+
+using namespace filevault::utils;
+namespace fs = std::filesystem;
+
+TEST_CASE("Password filter build and lookup", "[utils][password_filter]") {
+    const fs::path corpus = "test_password_corpus.txt";
+    const fs::path filter_path = "test_password_filter.bloom";
+    constexpr int ENTRIES = 20000;
+
+    // HIBP lines carry upper-case hex digests and a count
+    std::string hibp;
+    for (uint8_t byte : PasswordFilter::digest("hibp-secret")) {
+        hibp += fmt::format("{:02X}", byte);
+    }
+    {
+        std::ofstream out(corpus, std::ios::binary);
+        for (int i = 0; i < ENTRIES; ++i) {
+            out << "pw-" << i << "\n";
+        }
+        out << hibp << ":1234\r\n\n";
+    }
+
+    auto built = PasswordFilter::build(corpus.string(), filter_path.string(), 0.001);
+    REQUIRE(built);
+    REQUIRE(built.value == ENTRIES + 1);
+
+    auto opened = PasswordFilter::open(filter_path.string());
+    REQUIRE(opened);
+    const auto& filter = opened.value;
+    REQUIRE(filter.entry_count() == ENTRIES + 1);
+    REQUIRE(filter.hash_count() == 10);
+
+    SECTION("No false negatives") {
+        for (int i = 0; i < ENTRIES; ++i) {
+            REQUIRE(filter.contains("pw-" + std::to_string(i)));
+        }
+        REQUIRE(filter.contains("hibp-secret"));
+    }
+
+    SECTION("False positives near the requested rate") {
+        int false_positives = 0;
+        for (int i = 0; i < ENTRIES; ++i) {
+            false_positives += filter.contains("other-" + std::to_string(i));
+        }
+        REQUIRE(false_positives < ENTRIES / 200);
+        REQUIRE_FALSE(filter.contains("PW-1"));
+    }
+
+    SECTION("Corrupt files are rejected") {
+        fs::resize_file(filter_path, fs::file_size(filter_path) - 1);
+        REQUIRE_FALSE(PasswordFilter::open(filter_path.string()));
+        std::ofstream(filter_path, std::ios::binary) << "not a filter at all, just some text that is long enough";
+        REQUIRE_FALSE(PasswordFilter::open(filter_path.string()));
+    }
+
+    SECTION("Bad inputs") {
+        std::ofstream(corpus, std::ios::binary) << "\n\n";
+        REQUIRE_FALSE(PasswordFilter::build(corpus.string(), filter_path.string()));
+        REQUIRE_FALSE(PasswordFilter::build("no_such_corpus.txt", filter_path.string()));
+        REQUIRE_FALSE(PasswordFilter::build(corpus.string(), filter_path.string(), 1.5));
+    }
+
+    fs::remove(corpus);
+    fs::remove(filter_path);
+}
@@ -0,0 +1,55 @@
+/**
+ * @file test_progress.cpp
+ * @brief Unit tests for aggregated progress reporting
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/utils/progress.hpp"
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace filevault::utils;
+
+TEST_CASE("Progress rate and ETA", "[utils][progress]") {
+    constexpr uint64_t MB = 1024 * 1024;
+    REQUIRE(ProgressAggregator::format_rate(0, 0, 0.0) == "0.0 MB/s");
+    REQUIRE(ProgressAggregator::format_rate(10 * MB, 40 * MB, 2.0) == "5.0 MB/s, ETA 0:06");
+    REQUIRE(ProgressAggregator::format_rate(MB, 201 * MB, 1.0) == "1.0 MB/s, ETA 3:20");
+    REQUIRE(ProgressAggregator::format_rate(40 * MB, 40 * MB, 4.0) == "10.0 MB/s");
+    REQUIRE(ProgressAggregator::format_rate(8 * MB, 0, 4.0) == "2.0 MB/s");
+}
+
+TEST_CASE("Progress from concurrent workers", "[utils][progress]") {
+    std::mutex mutex;
+    std::vector<size_t> seen;
+    ProgressBar::set_observer([&](const std::string&, size_t progress, size_t) {
+        std::lock_guard<std::mutex> lock(mutex);
+        seen.push_back(progress);
+    });
+
+    {
+        ProgressAggregator progress("Working", 4000, std::chrono::milliseconds(5));
+        std::vector<std::thread> workers;
+        for (int t = 0; t < 4; ++t) {
+            workers.emplace_back([&progress]() {
+                for (int i = 0; i < 1000; ++i) {
+                    progress.add(1);
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        REQUIRE(progress.done() == 4000);
+        progress.finish();
+    }
+    ProgressBar::set_observer(nullptr);
+
+    // Renders only report changes and never go backwards
+    REQUIRE_FALSE(seen.empty());
+    REQUIRE(seen.back() == 100);
+    for (size_t i = 1; i < seen.size(); ++i) {
+        REQUIRE(seen[i] > seen[i - 1]);
+    }
+}
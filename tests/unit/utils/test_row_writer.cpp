@@ -0,0 +1,119 @@
+/**
+ * @file test_row_writer.cpp
+ * @brief Unit tests for the streaming row renderer
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/utils/row_writer.hpp"
+#include <nlohmann/json.hpp>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace filevault::utils;
+
+namespace {
+
+std::vector<RowColumn> columns() {
+    return {{"name", 8, false, false}, {"size", 6, true, true}, {"note", 0, false, false}};
+}
+
+std::string contents(std::FILE* file) {
+    std::fflush(file);
+    std::rewind(file);
+    std::string text;
+    char buffer[4096];
+    size_t n = 0;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        text.append(buffer, n);
+    }
+    std::fseek(file, 0, SEEK_END);     // Writing may follow
+    return text;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Row formats", "[utils][row_writer]") {
+    std::FILE* file = std::tmpfile();
+    REQUIRE(file != nullptr);
+
+    SECTION("Table") {
+        RowWriter writer(columns(), RowFormat::TABLE, file);
+        writer.header();
+        writer.row({"a.txt", "42", ""});
+        writer.row({"long-name.txt", "1234567", "(base)"});
+        REQUIRE(writer.flush());
+        REQUIRE(contents(file) ==
+                "  name        size  note\n"
+                "  a.txt         42\n"
+                "  long-name.txt  1234567  (base)\n");
+        REQUIRE(writer.rows() == 2);
+    }
+
+    SECTION("TSV escapes separators") {
+        RowWriter writer(columns(), RowFormat::TSV, file);
+        writer.header();
+        writer.row({"tab\there", "1", "line\nbreak\\"});
+        writer.row({"short"});
+        writer.flush();
+        REQUIRE(contents(file) ==
+                "name\tsize\tnote\n"
+                "tab\\there\t1\tline\\nbreak\\\\\n"
+                "short\t\t\n");
+    }
+
+    SECTION("JSON lines") {
+        RowWriter writer(columns(), RowFormat::JSONL, file);
+        writer.header();    // No header in JSON lines
+        writer.row({"quote\"d\x01", "7", "x"});
+        writer.row({"empty", "", ""});
+        writer.flush();
+
+        std::istringstream lines(contents(file));
+        std::string line;
+        REQUIRE(std::getline(lines, line));
+        auto first = nlohmann::json::parse(line);
+        REQUIRE(first["name"] == "quote\"d\x01");
+        REQUIRE(first["size"] == 7);
+        REQUIRE(first["note"] == "x");
+        REQUIRE(std::getline(lines, line));
+        REQUIRE(nlohmann::json::parse(line)["size"].is_null());
+        REQUIRE_FALSE(std::getline(lines, line));
+    }
+
+    std::fclose(file);
+}
+
+TEST_CASE("Rows are written in blocks", "[utils][row_writer]") {
+    std::FILE* file = std::tmpfile();
+    REQUIRE(file != nullptr);
+    {
+        RowWriter writer({{"n", 0, false, false}}, RowFormat::TSV, file, 100);
+        for (int i = 0; i < 250; ++i) {
+            writer.row({std::to_string(i)});
+        }
+        // Two blocks of 100 are out, the last 50 wait in the buffer
+        size_t written = contents(file).size();
+        REQUIRE(written == 10 * 2 + 90 * 3 + 100 * 4);
+
+        writer.line("done");
+        REQUIRE(writer.rows() == 251);
+    }
+    // Flushed by the destructor
+    auto text = contents(file);
+    REQUIRE(text.size() == 10 * 2 + 90 * 3 + 150 * 4 + 5);
+    REQUIRE(text.substr(text.size() - 5) == "done\n");
+    std::fclose(file);
+}
+
+TEST_CASE("Format names", "[utils][row_writer]") {
+    std::FILE* file = std::tmpfile();
+    RowFormat format = RowFormat::JSONL;
+    REQUIRE(RowWriter::parse_format("auto", file, format));
+    REQUIRE(format == RowFormat::TSV);      // Not a terminal
+    REQUIRE(RowWriter::parse_format("jsonl", file, format));
+    REQUIRE(format == RowFormat::JSONL);
+    REQUIRE_FALSE(RowWriter::parse_format("csv", file, format));
+    std::fclose(file);
+}
@@ -0,0 +1,44 @@
+/**
+ * @file test_run_stats.cpp
+ * @brief Unit tests for the --stats json run metrics
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/utils/run_stats.hpp"
+#include "filevault/utils/trace.hpp"
+#include <nlohmann/json.hpp>
+
+using namespace filevault::utils;
+
+TEST_CASE("Run metrics", "[utils][run_stats]") {
+    auto& stats = RunStats::instance();
+    stats.reset();
+    Tracer::instance().start();
+
+    stats.add_bytes(4096, 1024);
+    stats.add_bytes(4096, 1024);
+    stats.add_files(2);
+    stats.add_chunks(3);
+    {
+        ScopedSpan kdf("derive", "kdf");
+        ScopedSpan outer("seal chunk", "streaming");   // Encloses stages, not counted
+    }
+    Tracer::instance().stop();
+
+    auto json = nlohmann::json::parse(stats.to_json("encrypt", 0, 1000.0));
+    REQUIRE(json["command"] == "encrypt");
+    REQUIRE(json["exit_code"] == 0);
+    REQUIRE(json["bytes_in"] == 8192);
+    REQUIRE(json["bytes_out"] == 2048);
+    REQUIRE(json["compression_ratio"].get<double>() == 4.0);
+    REQUIRE(json["files"] == 2);
+    REQUIRE(json["chunks"] == 3);
+    REQUIRE(json["throughput_mbps"].get<double>() > 0.0);
+    REQUIRE(json["stages"].contains("kdf_ms"));
+    REQUIRE(json["stages"].contains("cipher_ms"));
+    REQUIRE_FALSE(json["stages"].contains("streaming"));
+    REQUIRE(json.contains("peak_rss_bytes"));
+
+    stats.reset();
+    REQUIRE(stats.bytes_in() == 0);
+}
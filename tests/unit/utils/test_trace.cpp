@@ -0,0 +1,72 @@
+/**
+ * @file test_trace.cpp
+ * @brief Unit tests for tracing spans and the trace-event output
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/utils/trace.hpp"
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+using namespace filevault::utils;
+
+TEST_CASE("Tracing spans", "[utils][trace]") {
+    auto& tracer = Tracer::instance();
+
+    SECTION("Nothing recorded while off") {
+        tracer.start();
+        tracer.stop();
+        {
+            ScopedSpan span("off", "test");
+        }
+        REQUIRE(tracer.spans().empty());
+    }
+
+    SECTION("Nested spans and threads") {
+        tracer.start();
+        {
+            ScopedSpan outer("outer", "test", 4096);
+            {
+                ScopedSpan inner("inner", "test");
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+        }
+        std::thread([] { ScopedSpan worker("worker", "test"); }).join();
+        tracer.stop();
+
+        auto spans = tracer.spans();
+        REQUIRE(spans.size() == 3);
+        // Recorded as they close: inner, outer, worker
+        REQUIRE(std::string(spans[0].name) == "inner");
+        REQUIRE(std::string(spans[1].name) == "outer");
+        REQUIRE(spans[1].bytes == 4096);
+        REQUIRE(spans[1].start_us <= spans[0].start_us);
+        REQUIRE(spans[1].duration_us >= spans[0].duration_us);
+        REQUIRE(spans[0].duration_us >= 2000);
+        REQUIRE(spans[2].thread != spans[0].thread);
+    }
+
+    SECTION("Chrome trace-event file") {
+        tracer.start();
+        {
+            ScopedSpan span("write", "io", 10);
+        }
+        tracer.stop();
+
+        auto path = std::filesystem::temp_directory_path() / "filevault_test_trace.json";
+        REQUIRE(tracer.write(path.string()));
+
+        std::ifstream in(path);
+        auto trace = nlohmann::json::parse(in);
+        REQUIRE(trace["traceEvents"].size() == 1);
+        const auto& event = trace["traceEvents"][0];
+        REQUIRE(event["name"] == "write");
+        REQUIRE(event["cat"] == "io");
+        REQUIRE(event["ph"] == "X");
+        REQUIRE(event["args"]["bytes"] == 10);
+        in.close();
+        std::filesystem::remove(path);
+    }
+}
@@ -0,0 +1,173 @@
+/**
+ * @file test_volume.cpp
+ * @brief Unit tests for encrypted XTS volumes
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include "filevault/volume/volume.hpp"
+#include "filevault/utils/file_io.hpp"
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <vector>
+
+using namespace filevault::volume;
+namespace fs = std::filesystem;
+
+namespace {
+
+std::vector<uint8_t> random_bytes(size_t size, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> data(size);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(rng());
+    }
+    return data;
+}
+
+VolumeConfig test_config() {
+    VolumeConfig config;
+    config.kdf = filevault::core::KDFType::PBKDF2_SHA256;
+    config.level = filevault::core::SecurityLevel::WEAK;
+    config.sector_size = 512;
+    return config;
+}
+
+std::vector<uint8_t> raw_bytes(const fs::path& path, uint64_t offset, size_t size) {
+    auto read = filevault::utils::FileIO::read_range(path.string(), offset, size);
+    REQUIRE(read.success);
+    return read.value;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Encrypted volume", "[volume]") {
+    const fs::path path = "test_volume.fvv";
+    fs::remove(path);
+
+    // 1000 bytes round up to two sectors
+    {
+        Volume small(path);
+        REQUIRE(small.create("pw", 1000, test_config()).success);
+        REQUIRE(small.sector_count() == 2);
+        REQUIRE(small.size() == 1024);
+    }
+    fs::remove(path);
+
+    constexpr uint64_t SIZE = 1024 * 1024;
+    Volume volume(path);
+    REQUIRE(volume.create("correct horse", SIZE, test_config()).success);
+    REQUIRE(Volume::is_volume(path));
+    REQUIRE(volume.data_offset() == Volume::HEADER_SIZE);
+    REQUIRE(fs::file_size(path) == Volume::HEADER_SIZE + SIZE);
+
+    auto data = random_bytes(64 * 1024, 1);
+
+    SECTION("Sectors round trip and are stored encrypted") {
+        REQUIRE(volume.write_sectors(10, data).success);
+        REQUIRE(volume.flush().success);
+        std::vector<uint8_t> back(data.size());
+        REQUIRE(volume.read_sectors(10, back).success);
+        REQUIRE(back == data);
+        REQUIRE(raw_bytes(path, volume.data_offset() + 10 * 512, data.size()) != data);
+    }
+
+    SECTION("Unaligned byte ranges") {
+        REQUIRE(volume.write(777, data).success);
+        auto patch = random_bytes(100, 2);
+        REQUIRE(volume.write(1000, patch).success);
+        std::copy(patch.begin(), patch.end(), data.begin() + (1000 - 777));
+
+        std::vector<uint8_t> back(data.size());
+        REQUIRE(volume.read(777, back).success);
+        REQUIRE(back == data);
+        REQUIRE(volume.flush().success);
+    }
+
+    SECTION("Small writes are cached until flushed") {
+        volume.set_cache_bytes(64 * 512);
+        auto sector = random_bytes(512, 3);
+        for (uint64_t s = 0; s < 8; ++s) {
+            REQUIRE(volume.write_sectors(100 + s, sector).success);
+        }
+        REQUIRE(volume.cache_stats().sectors_written == 0);
+        REQUIRE(volume.flush().success);
+        REQUIRE(volume.cache_stats().sectors_written == 8);
+
+        std::vector<uint8_t> back(512);
+        REQUIRE(volume.read_sectors(103, back).success);
+        REQUIRE(back == sector);
+        REQUIRE(volume.cache_stats().hits >= 1);
+    }
+
+    SECTION("Eviction writes dirty sectors back") {
+        volume.set_cache_bytes(4 * 512);
+        auto sector = random_bytes(512, 4);
+        for (uint64_t s = 0; s < 16; ++s) {
+            sector[0] = static_cast<uint8_t>(s);
+            REQUIRE(volume.write_sectors(s * 3, sector).success);
+        }
+        REQUIRE(volume.cache_stats().sectors_written >= 12);
+        std::vector<uint8_t> back(512);
+        for (uint64_t s = 0; s < 16; ++s) {
+            REQUIRE(volume.read_sectors(s * 3, back).success);
+            REQUIRE(back[0] == s);
+        }
+    }
+
+    SECTION("Reopening with the password") {
+        REQUIRE(volume.write(5000, data).success);
+        REQUIRE(volume.flush().success);
+
+        Volume reopened(path);
+        REQUIRE(reopened.open().success);
+        REQUIRE(reopened.sector_size() == 512);
+        REQUIRE_FALSE(reopened.unlock("wrong").success);
+        REQUIRE_FALSE(reopened.unlocked());
+        REQUIRE(reopened.unlock("correct horse", true).success);
+
+        std::vector<uint8_t> back(data.size());
+        REQUIRE(reopened.read(5000, back).success);
+        REQUIRE(back == data);
+        REQUIRE_FALSE(reopened.write(0, data).success);
+    }
+
+    SECTION("Changing the password keeps the data") {
+        REQUIRE(volume.write(0, data).success);
+        REQUIRE(volume.change_password("battery staple").success);
+        REQUIRE(volume.flush().success);
+
+        Volume reopened(path);
+        REQUIRE_FALSE(reopened.unlock("correct horse").success);
+        REQUIRE(reopened.unlock("battery staple").success);
+        std::vector<uint8_t> back(data.size());
+        REQUIRE(reopened.read(0, back).success);
+        REQUIRE(back == data);
+    }
+
+    SECTION("Range checks") {
+        std::vector<uint8_t> sector(512);
+        REQUIRE_FALSE(volume.read(SIZE - 10, sector).success);
+        REQUIRE_FALSE(volume.write_sectors(SIZE / 512, sector).success);
+        std::vector<uint8_t> odd(100);
+        REQUIRE_FALSE(volume.read_sectors(0, odd).success);
+        REQUIRE(volume.read(SIZE - 100, odd).success);
+    }
+
+    SECTION("A volume cannot be created twice") {
+        Volume again(path);
+        REQUIRE_FALSE(again.create("other", SIZE, test_config()).success);
+    }
+
+    SECTION("An edited header is rejected") {
+        {
+            std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(40);
+            file.put(static_cast<char>(0x7f));
+        }
+        Volume reopened(path);
+        REQUIRE_FALSE(reopened.unlock("correct horse").success);
+    }
+
+    fs::remove(path);
+}
@@ -2,8 +2,10 @@ import * as vscode from 'vscode';
 import * as path from 'path';
 import * as child_process from 'child_process';
 import * as fs from 'fs';
+import * as readline from 'readline';
 
 let outputChannel: vscode.OutputChannel;
+let daemon: FileVaultDaemon | undefined;
 
 export function activate(context: vscode.ExtensionContext) {
     outputChannel = vscode.window.createOutputChannel('FileVault');
@@ -34,6 +36,7 @@ export function activate(context: vscode.ExtensionContext) {
 }
 
 export function deactivate() {
+    daemon?.dispose();
     outputChannel.dispose();
 }
 
@@ -142,8 +145,113 @@ function stripAnsiCodes(text: string): string {
     return text.replace(/\x1b\[[0-9;]*[a-zA-Z]/g, '');
 }
 
-// Run FileVault command
-function runFileVault(args: string[]): Promise<{ stdout: string; stderr: string }> {
+interface RunResult {
+    exit_code: number;
+    stdout: string;
+    stderr: string;
+}
+
+// `filevault serve --stdio` child kept alive between commands, so each
+// action skips process start and engine setup
+class FileVaultDaemon {
+    private readonly child: child_process.ChildProcessWithoutNullStreams;
+    private readonly pending = new Map<number, { resolve: (r: RunResult) => void; reject: (e: Error) => void }>();
+    private nextId = 1;
+    alive = true;
+
+    constructor(readonly executable: string) {
+        this.child = child_process.spawn(executable, ['serve', '--stdio'], {
+            shell: false,
+            windowsHide: true,
+            env: process.env
+        });
+
+        readline.createInterface({ input: this.child.stdout }).on('line', (line) => this.onLine(line));
+        this.child.stderr.on('data', (data: Buffer) => outputChannel.append(stripAnsiCodes(data.toString())));
+        this.child.on('exit', () => this.fail(new Error('FileVault daemon exited')));
+        this.child.on('error', (error: Error) => this.fail(error));
+        this.child.stdin.on('error', (error: Error) => this.fail(error));
+    }
+
+    run(args: string[]): Promise<RunResult> {
+        const id = this.nextId++;
+        return new Promise((resolve, reject) => {
+            this.pending.set(id, { resolve, reject });
+            this.child.stdin.write(JSON.stringify({ jsonrpc: '2.0', id, method: 'run', params: { args } }) + '\n');
+        });
+    }
+
+    dispose() {
+        if (this.alive) {
+            this.child.stdin.end(JSON.stringify({ jsonrpc: '2.0', id: 0, method: 'shutdown' }) + '\n');
+        }
+        this.alive = false;
+    }
+
+    private onLine(line: string) {
+        let message: any;
+        try {
+            message = JSON.parse(line);
+        } catch {
+            return;
+        }
+        if (message.method === 'progress') {
+            const { label, progress, total } = message.params;
+            outputChannel.appendLine(`${label}: ${Math.round((progress * 100) / Math.max(total, 1))}%`);
+            return;
+        }
+        const request = this.pending.get(message.id);
+        if (!request) {
+            return;
+        }
+        this.pending.delete(message.id);
+        if (message.error) {
+            request.reject(new Error(message.error.message));
+        } else {
+            request.resolve(message.result as RunResult);
+        }
+    }
+
+    private fail(error: Error) {
+        this.alive = false;
+        for (const request of this.pending.values()) {
+            request.reject(error);
+        }
+        this.pending.clear();
+    }
+}
+
+// Run FileVault command through the daemon, or in a new process if the
+// daemon cannot be used
+async function runFileVault(args: string[]): Promise<{ stdout: string; stderr: string }> {
+    const executable = getExecutablePath();
+    if (!daemon || !daemon.alive || daemon.executable !== executable) {
+        daemon?.dispose();
+        daemon = new FileVaultDaemon(executable);
+    }
+
+    let result: RunResult;
+    try {
+        outputChannel.appendLine(`> filevault ${args.map(a => a.includes(' ') ? `"${a}"` : a).join(' ')}`);
+        result = await daemon.run(args);
+    } catch (error) {
+        outputChannel.appendLine(`Daemon unavailable (${error}), running command directly`);
+        daemon.dispose();
+        return runFileVaultProcess(args);
+    }
+
+    const stdout = stripAnsiCodes(result.stdout);
+    const stderr = stripAnsiCodes(result.stderr);
+    outputChannel.append(stdout);
+    outputChannel.append(stderr);
+    if (result.exit_code !== 0) {
+        throw new Error(stderr || `Process exited with code ${result.exit_code}`);
+    }
+    return { stdout, stderr };
+}
+
+// Run FileVault command in a new process
+function runFileVaultProcess(args: string[]): Promise<{ stdout: string; stderr: string }> {
     return new Promise((resolve, reject) => {
         const executable = getExecutablePath();
         outputChannel.appendLine(`> "${executable}" ${args.map(a => a.includes(' ') ? `"${a}"` : a).join(' ')}`);